@@ -29,14 +29,21 @@ public class Glmark2Activity extends Activity {
         mWakeLock = pm.newWakeLock(PowerManager.SCREEN_DIM_WAKE_LOCK, TAG);
         mWakeLock.acquire();
 
-        mGLView = new Glmark2SurfaceView(this);
-        setContentView(mGLView);
+        /* --android-native-loop needs a plain SurfaceView */
+        if (useNativeLoop()) {
+            setContentView(new Glmark2NativeSurfaceView(this));
+        }
+        else {
+            mGLView = new Glmark2SurfaceView(this);
+            setContentView(mGLView);
+        }
     }
 
     @Override
     protected void onPause() {
         super.onPause();
-        mGLView.onPause();
+        if (mGLView != null)
+            mGLView.onPause();
         Glmark2Activity.this.finish();
         android.os.Process.killProcess(android.os.Process.myPid());
     }
@@ -44,7 +51,22 @@ public class Glmark2Activity extends Activity {
     @Override
     protected void onResume() {
         super.onResume();
-        mGLView.onResume();
+        if (mGLView != null)
+            mGLView.onResume();
+    }
+
+    private boolean useNativeLoop() {
+        String args = getIntent().getStringExtra("args");
+
+        if (args == null)
+            return false;
+
+        for (String arg : args.split(" ")) {
+            if (arg.equals("--android-native-loop"))
+                return true;
+        }
+
+        return false;
     }
 
     @Override
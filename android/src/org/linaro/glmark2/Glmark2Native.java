@@ -22,12 +22,16 @@
 package org.linaro.glmark2;
 
 import android.content.res.AssetManager;
+import android.view.Surface;
 
 class Glmark2Native {
     public static native void init(AssetManager assetManager, String args,
                                    String logFilePath);
     public static native void resize(int w, int h);
     public static native boolean render();
+    public static native void runNativeLoop(Surface surface, AssetManager assetManager,
+                                            String args, String logFilePath);
+    public static native void stopNativeLoop();
     public static native void done();
     public static native int scoreConfig(GLVisualConfig vc, GLVisualConfig target);
     public static native SceneInfo[] getSceneInfo(AssetManager assetManager);
@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+package org.linaro.glmark2;
+
+import java.io.File;
+
+import android.app.Activity;
+import android.view.SurfaceHolder;
+import android.view.SurfaceView;
+
+/**
+ * SurfaceView that runs the benchmarks from a native loop on its window
+ * (--android-native-loop), instead of from the render callbacks of
+ * GLSurfaceView.
+ */
+class Glmark2NativeSurfaceView extends SurfaceView implements SurfaceHolder.Callback {
+
+    public Glmark2NativeSurfaceView(Activity activity) {
+        super(activity);
+        mActivity = activity;
+
+        getHolder().addCallback(this);
+    }
+
+    public void surfaceCreated(final SurfaceHolder holder) {
+        final String args = mActivity.getIntent().getStringExtra("args");
+        final File f = new File(mActivity.getFilesDir(), "last_run.log");
+
+        /* The loop creates its own EGL context for the surface */
+        mThread = new Thread(new Runnable() {
+            public void run() {
+                Glmark2Native.runNativeLoop(holder.getSurface(), mActivity.getAssets(),
+                                            args, f.getAbsolutePath());
+                mActivity.finish();
+            }
+        }, "glmark2");
+        mThread.start();
+    }
+
+    public void surfaceChanged(SurfaceHolder holder, int format, int width, int height) {
+        /* The native loop follows the size of the surface */
+    }
+
+    public void surfaceDestroyed(SurfaceHolder holder) {
+        /* The surface must stay valid until the loop has released it */
+        Glmark2Native.stopNativeLoop();
+        try {
+            mThread.join();
+        }
+        catch (InterruptedException e) {
+        }
+        mThread = null;
+    }
+
+    private Activity mActivity;
+    private Thread mThread;
+}
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+#
+# Copyright © 2026 glmark2 contributors
+#
+# This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+#
+# glmark2 is free software: you can redistribute it and/or modify it under the
+# terms of the GNU General Public License as published by the Free Software
+# Foundation, either version 3 of the License, or (at your option) any later
+# version.
+#
+# glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+# FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+# details.
+#
+# You should have received a copy of the GNU General Public License along with
+# glmark2.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Packs the models, shaders and textures of a data directory into a single
+# indexed file, which glmark2 maps into memory at startup instead of opening
+# each file (see Util::open_resource_pack()).
+#
+# Usage: pack-data.py OUTPUT DATA_DIR
+#
+# The format is, in little endian:
+#
+#   "GLM2PACK", the version (u32) and the number of files (u32)
+#   for each file: the offset and size of its path relative to DATA_DIR
+#                  (u32, u32), and the offset and size of its contents
+#                  (u64, u64), from the start of the pack
+#   the paths
+#   the contents, each aligned to 16 bytes
+#
+import os
+import struct
+import sys
+
+MAGIC = b'GLM2PACK'
+VERSION = 1
+DIRS = ['models', 'shaders', 'textures']
+ALIGNMENT = 16
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('Usage: %s OUTPUT DATA_DIR' % sys.argv[0])
+
+    output, data_dir = sys.argv[1:]
+
+    names = []
+    for d in DIRS:
+        for f in sorted(os.listdir(os.path.join(data_dir, d))):
+            if os.path.isfile(os.path.join(data_dir, d, f)):
+                names.append('%s/%s' % (d, f))
+
+    encoded = [n.encode('utf-8') for n in names]
+    header_size = 16 + 24 * len(names)
+    names_size = sum(len(n) for n in encoded)
+
+    offset = header_size + names_size
+    entries = []
+    contents = []
+    name_offset = header_size
+
+    for name, enc in zip(names, encoded):
+        with open(os.path.join(data_dir, name), 'rb') as f:
+            data = f.read()
+        offset += -offset % ALIGNMENT
+        entries.append(struct.pack('<IIQQ', name_offset, len(enc), offset, len(data)))
+        contents.append((offset, data))
+        name_offset += len(enc)
+        offset += len(data)
+
+    with open(output, 'wb') as out:
+        out.write(MAGIC + struct.pack('<II', VERSION, len(names)))
+        out.write(b''.join(entries))
+        out.write(b''.join(encoded))
+        for data_offset, data in contents:
+            out.write(b'\0' * (data_offset - out.tell()))
+            out.write(data)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,21 @@
+uniform vec4 Scale;
+uniform vec4 Bias;
+uniform MEDIUMP_OR_DEFAULT vec4 MediumpScale;
+uniform MEDIUMP_OR_DEFAULT vec4 MediumpBias;
+uniform ivec4 IntScale;
+uniform ivec4 IntBias;
+
+void main(void)
+{
+    vec4 seed = vec4(fract(gl_FragCoord.xy * 0.01), 0.25, 0.5);
+    vec4 multiply_add = seed;
+    MEDIUMP_OR_DEFAULT vec4 mediump_multiply_add = seed;
+    vec4 transcendental = seed;
+    ivec4 integer = ivec4(seed * 100.0);
+
+    // Each operation depends on the previous one of its kind, and the
+    // uniforms keep the compiler from folding them
+$OPERATIONS$
+
+    gl_FragColor = multiply_add + mediump_multiply_add + transcendental + vec4(integer) * 0.01;
+}
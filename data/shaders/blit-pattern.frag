@@ -0,0 +1,10 @@
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    // A gradient under a checkerboard of 16 x 16 cells, so that scaling
+    // and filtering show
+    vec2 cell = floor(TextureCoord * 16.0);
+    float check = mod(cell.x + cell.y, 2.0);
+    gl_FragColor = vec4(TextureCoord, 0.25 + 0.5 * check, 1.0);
+}
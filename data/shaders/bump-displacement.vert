@@ -0,0 +1,19 @@
+in vec3 position;
+in vec2 texcoord;
+in vec3 normal;
+in vec3 tangent;
+
+out vec3 ControlPosition;
+out vec2 ControlTexCoord;
+out vec3 ControlNormal;
+out vec3 ControlTangent;
+
+void main(void)
+{
+    // The tessellation evaluation shader transforms the vertices, after
+    // displacing them
+    ControlPosition = position;
+    ControlTexCoord = texcoord;
+    ControlNormal = normal;
+    ControlTangent = tangent;
+}
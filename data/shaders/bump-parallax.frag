@@ -0,0 +1,84 @@
+uniform sampler2D HeightMap;
+
+varying HIGHP_OR_DEFAULT vec2 TextureCoord;
+
+varying vec3 PositionEye;
+varying vec3 NormalEye;
+varying vec3 TangentEye;
+varying vec3 BitangentEye;
+
+const int ParallaxSteps = $PARALLAX_STEPS$;
+
+void main(void)
+{
+    const vec4 LightSourceAmbient = vec4(0.1, 0.1, 0.1, 1.0);
+    const vec4 LightSourceDiffuse = vec4(0.8, 0.8, 0.8, 1.0);
+    const vec4 LightSourceSpecular = vec4(0.8, 0.8, 0.8, 1.0);
+    const vec4 MaterialAmbient = vec4(1.0, 1.0, 1.0, 1.0);
+    const vec4 MaterialDiffuse = vec4(1.0, 1.0, 1.0, 1.0);
+    const vec4 MaterialSpecular = vec4(0.2, 0.2, 0.2, 1.0);
+    const float MaterialShininess = 100.0;
+    const float height_factor = 13.0;
+    const float parallax_scale = 0.04;
+
+    vec3 T = normalize(TangentEye);
+    vec3 B = normalize(BitangentEye);
+    vec3 V = normalize(-PositionEye);
+
+    // The view direction in tangent space
+    vec3 view = vec3(dot(V, T), dot(V, B), dot(V, normalize(NormalEye)));
+
+    // Steep parallax mapping: step along the view ray through the layers
+    // of the height field (depth 0 at the top, 1 at the bottom) until it is
+    // below the surface. Each step depends on the previous height read.
+    float layer_depth = 1.0 / float(ParallaxSteps);
+    HIGHP_OR_DEFAULT vec2 delta = view.xy / max(view.z, 0.1) * parallax_scale * layer_depth;
+    HIGHP_OR_DEFAULT vec2 uv = TextureCoord;
+    float depth = 0.0;
+    float surface_depth = 1.0 - texture2D(HeightMap, uv).x;
+
+    for (int i = 0; i < ParallaxSteps; i++) {
+        if (depth >= surface_depth)
+            break;
+        uv -= delta;
+        depth += layer_depth;
+        surface_depth = 1.0 - texture2D(HeightMap, uv).x;
+    }
+
+    // Parallax occlusion mapping: intersect the ray with the surface
+    // between the last two steps
+    HIGHP_OR_DEFAULT vec2 prev_uv = uv + delta;
+    float after = surface_depth - depth;
+    float before = (1.0 - texture2D(HeightMap, prev_uv).x) - (depth - layer_depth);
+    float weight = after / min(after - before, -0.0001);
+    uv = mix(uv, prev_uv, weight);
+
+    // Get the normal from the height map at the intersection, like
+    // bump-height.frag does
+    float height0 = texture2D(HeightMap, uv).x;
+    float heightX = texture2D(HeightMap, uv + vec2(TextureStepX, 0.0)).x;
+    float heightY = texture2D(HeightMap, uv + vec2(0.0, TextureStepY)).x;
+    vec2 dh = vec2(heightX - height0, heightY - height0);
+
+    vec3 N = NormalEye - height_factor * dh.x * TangentEye -
+                         height_factor * dh.y * BitangentEye;
+    N = normalize(N);
+
+    // The light is at infinity, but the viewer isn't, so the half vector
+    // varies across the surface
+    vec3 L = normalize(LightSourcePosition.xyz);
+    vec3 H = normalize(L + V);
+
+    // Calculate the diffuse color according to Lambertian reflectance
+    vec4 diffuse = MaterialDiffuse * LightSourceDiffuse * max(dot(N, L), 0.0);
+
+    // Calculate the ambient color
+    vec4 ambient = MaterialAmbient * LightSourceAmbient;
+
+    // Calculate the specular color according to the Blinn-Phong model
+    vec4 specular = MaterialSpecular * LightSourceSpecular *
+                    pow(max(dot(N,H), 0.0), MaterialShininess);
+
+    // Calculate the final color
+    gl_FragColor = ambient + specular + diffuse;
+}
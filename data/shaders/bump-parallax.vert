@@ -0,0 +1,32 @@
+attribute vec3 position;
+attribute vec2 texcoord;
+attribute vec3 normal;
+attribute vec3 tangent;
+
+uniform mat4 ModelViewProjectionMatrix;
+uniform mat4 ModelViewMatrix;
+uniform mat4 NormalMatrix;
+
+varying vec2 TextureCoord;
+varying vec3 PositionEye;
+varying vec3 NormalEye;
+varying vec3 TangentEye;
+varying vec3 BitangentEye;
+
+void main(void)
+{
+    TextureCoord = texcoord;
+
+    // The view direction isn't constant across the surface, so the
+    // position in eye space is needed to get it per fragment
+    PositionEye = vec3(ModelViewMatrix * vec4(position, 1.0));
+
+    // Transform normal, tangent and bitangent to eye space, like
+    // bump-height.vert does
+    NormalEye = normalize(vec3(NormalMatrix * vec4(normal, 1.0)));
+    TangentEye = normalize(vec3(NormalMatrix * vec4(tangent, 1.0)));
+    BitangentEye = normalize(vec3(NormalMatrix * vec4(cross(normal, tangent), 1.0)));
+
+    // Transform the position to clip coordinates
+    gl_Position = ModelViewProjectionMatrix * vec4(position, 1.0);
+}
@@ -0,0 +1,14 @@
+attribute vec4 position;
+attribute vec4 velocity;
+
+varying vec4 Color;
+
+void main(void)
+{
+    gl_Position = vec4(position.xyz, 1.0);
+    gl_PointSize = 2.0;
+
+    // Slow particles are blue, fast ones turn white
+    float speed = clamp(length(velocity.xyz), 0.0, 1.0);
+    Color = vec4(mix(vec3(0.1, 0.3, 1.0), vec3(1.0), speed), 0.5);
+}
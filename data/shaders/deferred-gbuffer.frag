@@ -0,0 +1,11 @@
+uniform vec4 MaterialDiffuse;
+
+varying vec3 vertex_normal;
+varying vec4 vertex_position;
+
+void main(void)
+{
+    // The albedo and the eye space normal, mapped to [0, 1]
+    gl_FragData[0] = MaterialDiffuse;
+    gl_FragData[1] = vec4(normalize(vertex_normal) * 0.5 + 0.5, 1.0);
+}
@@ -0,0 +1,46 @@
+uniform sampler2D AlbedoTexture;
+uniform sampler2D NormalTexture;
+uniform sampler2D DepthTexture;
+uniform mat4 InverseProjectionMatrix;
+// The eye space position of each light, with its radius in w
+uniform vec4 LightPosition[LIGHT_ARRAY_SIZE];
+uniform vec4 LightColor[LIGHT_ARRAY_SIZE];
+uniform float Ambient;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    const vec4 lightSpecular = vec4(0.8, 0.8, 0.8, 1.0);
+    const float matShininess = 100.0;
+
+    float depth = texture2D(DepthTexture, TextureCoord).x;
+    if (depth == 1.0)
+        discard;
+
+    // Get the eye space position back from the depth
+    vec4 position = InverseProjectionMatrix *
+                    vec4(vec3(TextureCoord, depth) * 2.0 - 1.0, 1.0);
+    position /= position.w;
+
+    vec3 normal = normalize(texture2D(NormalTexture, TextureCoord).xyz * 2.0 - 1.0);
+    vec4 albedo = texture2D(AlbedoTexture, TextureCoord);
+    vec3 eye_direction = normalize(-position.xyz);
+
+    vec4 result = Ambient * albedo;
+
+    for (int i = 0; i < LIGHT_COUNT; i++) {
+        vec3 to_light = LightPosition[i].xyz - position.xyz;
+        float distance = length(to_light);
+        float attenuation = max(0.0, 1.0 - distance / LightPosition[i].w);
+        vec3 light_direction = to_light / max(distance, 0.0001);
+        vec3 reflection = reflect(-light_direction, normal);
+        float specularTerm = pow(max(0.0, dot(reflection, eye_direction)), matShininess);
+        float diffuseTerm = max(0.0, dot(normal, light_direction));
+
+        result += attenuation * attenuation * LightColor[i] *
+                  (albedo * diffuseTerm + lightSpecular * specularTerm);
+    }
+
+    gl_FragColor = vec4(result.rgb, 1.0);
+}
@@ -0,0 +1,14 @@
+attribute vec2 position;
+
+// The rectangle to shade, in normalized device coordinates
+uniform vec4 Rect;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    vec2 ndc = mix(Rect.xy, Rect.zw, position * 0.5 + 0.5);
+
+    TextureCoord = ndc * 0.5 + 0.5;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
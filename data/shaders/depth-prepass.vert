@@ -0,0 +1,8 @@
+attribute vec3 position;
+
+uniform mat4 ModelViewProjectionMatrix;
+
+void main(void)
+{
+    gl_Position = ModelViewProjectionMatrix * vec4(position, 1.0);
+}
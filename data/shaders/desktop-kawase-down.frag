@@ -0,0 +1,16 @@
+uniform sampler2D Texture0;
+// Half a texel of the output, in the texture coordinates of Texture0
+uniform vec2 HalfPixel;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    vec4 sum = texture2D(Texture0, TextureCoord) * 4.0;
+    sum += texture2D(Texture0, TextureCoord - HalfPixel);
+    sum += texture2D(Texture0, TextureCoord + HalfPixel);
+    sum += texture2D(Texture0, TextureCoord + vec2(HalfPixel.x, -HalfPixel.y));
+    sum += texture2D(Texture0, TextureCoord - vec2(HalfPixel.x, -HalfPixel.y));
+
+    gl_FragColor = vec4(sum.xyz / 8.0, 1.0);
+}
@@ -0,0 +1,19 @@
+uniform sampler2D Texture0;
+// Half a texel of the output, in the texture coordinates of Texture0
+uniform vec2 HalfPixel;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    vec4 sum = texture2D(Texture0, TextureCoord + vec2(-HalfPixel.x * 2.0, 0.0));
+    sum += texture2D(Texture0, TextureCoord + vec2(-HalfPixel.x, HalfPixel.y)) * 2.0;
+    sum += texture2D(Texture0, TextureCoord + vec2(0.0, HalfPixel.y * 2.0));
+    sum += texture2D(Texture0, TextureCoord + vec2(HalfPixel.x, HalfPixel.y)) * 2.0;
+    sum += texture2D(Texture0, TextureCoord + vec2(HalfPixel.x * 2.0, 0.0));
+    sum += texture2D(Texture0, TextureCoord + vec2(HalfPixel.x, -HalfPixel.y)) * 2.0;
+    sum += texture2D(Texture0, TextureCoord + vec2(0.0, -HalfPixel.y * 2.0));
+    sum += texture2D(Texture0, TextureCoord + vec2(-HalfPixel.x, -HalfPixel.y)) * 2.0;
+
+    gl_FragColor = vec4(sum.xyz / 12.0, 1.0);
+}
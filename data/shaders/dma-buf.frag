@@ -0,0 +1,18 @@
+uniform SAMPLER Texture0;
+uniform sampler2D Texture1;
+
+varying vec2 TexCoord;
+
+// BT.601 limited range, the default of EGL_EXT_image_dma_buf_import
+vec4 nv12_to_rgba(float y, vec2 uv)
+{
+    y = 1.164 * (y - 0.0625);
+    uv -= 0.5;
+    return vec4(y + 1.596 * uv.y, y - 0.391 * uv.x - 0.813 * uv.y,
+                y + 2.018 * uv.x, 1.0);
+}
+
+void main(void)
+{
+    gl_FragColor = SAMPLE;
+}
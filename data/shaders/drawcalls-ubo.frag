@@ -0,0 +1,10 @@
+uniform sampler2D MaterialTexture0;
+
+in vec2 TextureCoord;
+
+out vec4 FragColor;
+
+void main(void)
+{
+    FragColor = DrawColor * texture(MaterialTexture0, TextureCoord);
+}
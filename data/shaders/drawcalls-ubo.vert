@@ -0,0 +1,14 @@
+in vec3 position;
+
+layout(std140) uniform DrawParams {
+    vec4 Offset;
+};
+
+out vec2 TextureCoord;
+
+void main(void)
+{
+    gl_Position = vec4(position.xy + Offset.xy, 0.0, 1.0);
+
+    TextureCoord = position.xy * 0.5 + 0.5;
+}
@@ -0,0 +1,12 @@
+attribute vec3 position;
+
+uniform vec2 Offset;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    gl_Position = vec4(position.xy + Offset, 0.0, 1.0);
+
+    TextureCoord = position.xy * 0.5 + 0.5;
+}
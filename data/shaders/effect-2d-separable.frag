@@ -0,0 +1,10 @@
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    vec4 result = vec4(0.0);
+
+    $CONVOLUTION$
+
+    gl_FragColor = vec4(result.xyz, 1.0);
+}
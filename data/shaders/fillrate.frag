@@ -0,0 +1,6 @@
+uniform vec4 LayerColor;
+
+void main(void)
+{
+    gl_FragColor = LayerColor;
+}
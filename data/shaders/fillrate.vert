@@ -0,0 +1,8 @@
+attribute vec2 position;
+
+uniform float Depth;
+
+void main(void)
+{
+    gl_Position = vec4(position, Depth, 1.0);
+}
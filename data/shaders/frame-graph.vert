@@ -0,0 +1,10 @@
+attribute vec2 position;
+attribute vec4 color;
+
+varying vec4 Color;
+
+void main(void)
+{
+    Color = color;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
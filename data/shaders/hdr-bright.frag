@@ -0,0 +1,14 @@
+uniform sampler2D Texture0;
+uniform float Threshold;
+
+varying vec2 vUv;
+
+void main()
+{
+    // Keep the part of the color above the threshold luminance
+    vec3 color = texture2D(Texture0, vUv).rgb;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    float bright = max(luminance - Threshold, 0.0) / max(luminance, 0.0001);
+
+    gl_FragColor = vec4(color * bright, 1.0);
+}
@@ -0,0 +1,18 @@
+uniform sampler2D Texture0;
+uniform sampler2D BloomTexture;
+
+varying vec2 vUv;
+
+vec3 tone_map(vec3 color)
+{
+    $TONE_MAP$
+}
+
+void main()
+{
+    vec3 color = texture2D(Texture0, vUv).rgb;
+
+    $BLOOM$
+
+    gl_FragColor = vec4(tone_map(color), 1.0);
+}
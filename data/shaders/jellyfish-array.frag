@@ -0,0 +1,20 @@
+uniform sampler2D uSampler;
+uniform mediump sampler2DArray uCaustics;
+uniform float uCausticLayer;
+uniform float uCurrentTime;
+  
+in vec2 vTextureCoord;
+in vec4 vWorld;
+in vec3 vDiffuse;
+in vec3 vAmbient;
+in vec3 vFresnel;
+
+out vec4 FragColor;
+
+void main(void)
+{
+    vec4 caustics = texture(uCaustics, vec3(vWorld.x / 24.0 + uCurrentTime / 20.0, (vWorld.z - vWorld.y)/48.0 + uCurrentTime / 40.0, uCausticLayer));
+    vec4 colorMap = texture(uSampler, vTextureCoord);
+    float transparency = colorMap.a + pow(vFresnel.r, 2.0) - 0.3;
+    FragColor = vec4(((vAmbient + vDiffuse + caustics.rgb) * colorMap.rgb), transparency);
+}
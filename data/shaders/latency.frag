@@ -0,0 +1,4 @@
+void main(void)
+{
+    gl_FragColor = vec4(1.0, 1.0, 1.0, 1.0);
+}
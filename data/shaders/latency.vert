@@ -0,0 +1,9 @@
+attribute vec2 position;
+
+uniform vec2 Center;
+uniform vec2 Scale;
+
+void main(void)
+{
+    gl_Position = vec4(Center + position * Scale, 0.0, 1.0);
+}
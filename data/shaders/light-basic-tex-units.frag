@@ -0,0 +1,10 @@
+$SAMPLERS$
+varying vec4 Color;
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    vec4 texel = vec4(0.0);
+$SAMPLES$
+    gl_FragColor = texel * Color;
+}
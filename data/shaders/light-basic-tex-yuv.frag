@@ -0,0 +1,19 @@
+$SAMPLERS$
+varying vec4 Color;
+varying vec2 TextureCoord;
+
+// BT.601 limited range
+vec4 yuv_to_rgba(float y, vec2 uv)
+{
+    y = 1.164 * (y - 0.0625);
+    uv -= 0.5;
+    return vec4(y + 1.596 * uv.y, y - 0.391 * uv.x - 0.813 * uv.y,
+                y + 2.018 * uv.x, 1.0);
+}
+
+void main(void)
+{
+    float y = texture2D(MaterialTexture0, TextureCoord).r;
+    vec2 uv = $CHROMA$;
+    gl_FragColor = yuv_to_rgba(y, uv) * Color;
+}
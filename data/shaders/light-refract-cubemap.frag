@@ -0,0 +1,52 @@
+uniform sampler2D DistanceMap;
+uniform sampler2D NormalMap;
+uniform samplerCube EnvironmentMap;
+
+varying vec3 vertex_normal;
+varying vec4 vertex_position;
+varying vec4 MapCoord;
+
+void main()
+{
+    const vec4 lightSpecular = vec4(0.8, 0.8, 0.8, 1.0);
+    const vec4 matSpecular = vec4(1.0, 1.0, 1.0, 1.0);
+    const float matShininess = 100.0;
+    const vec2 point_five = vec2(0.5);
+    // Need the normalized eye direction and surface normal vectors to
+    // compute the transmitted vector through the "front" surface of the object.
+    vec3 eye_direction = normalize(-vertex_position.xyz);
+    vec3 normalized_normal = normalize(vertex_normal);
+    vec3 front_refraction = refract(eye_direction, normalized_normal, RefractiveIndex);
+    // Find our best distance approximation through the object so we can
+    // project the transmitted vector to the back of the object to find
+    // the exit point.
+    vec3 mc_perspective = (MapCoord.xyz / MapCoord.w) + front_refraction;
+    vec2 dcoord = mc_perspective.st * point_five + point_five;
+    float distance_value = DepthSampleOffset +
+                           DepthSampleScale * texture2D(DistanceMap, dcoord).x;
+    vec3 back_position = vertex_position.xyz + front_refraction * distance_value;
+    // Use the exit point to index the map of back-side normals, and use the
+    // back-side position and normal to find the transmitted vector out of the
+    // object.
+    vec2 normcoord = back_position.st * point_five + point_five;
+    vec3 back_normal = texture2D(NormalMap, normcoord).xyz;
+    vec3 back_refraction = refract(back_position, back_normal, 1.0/RefractiveIndex);
+    // The transmitted vector points back towards the viewer, as in
+    // light-refract.frag, so mirror it to look up the environment behind
+    // the object. The reflected view vector looks up the environment in
+    // front of it, and the Fresnel term (Schlick's approximation) mixes both.
+    vec3 behind = vec3(back_refraction.xy, -back_refraction.z);
+    vec4 transmitted = textureCube(EnvironmentMap, behind);
+    vec4 reflected = textureCube(EnvironmentMap, reflect(-eye_direction, normalized_normal));
+    float r0 = (RefractiveIndex - 1.0) / (RefractiveIndex + 1.0);
+    r0 *= r0;
+    float fresnel = r0 + (1.0 - r0) * pow(1.0 - max(dot(eye_direction, normalized_normal), 0.0), 5.0);
+    vec4 texel = mix(transmitted, reflected, fresnel);
+    // Add in specular reflection, and we have our fragment value.
+    vec3 light_direction = normalize(vertex_position.xyz/vertex_position.w -
+                                     LightSourcePosition.xyz/LightSourcePosition.w);
+    vec3 reflection = reflect(light_direction, normalized_normal);
+    float specularTerm = pow(max(0.0, dot(reflection, eye_direction)), matShininess);
+    vec4 specular = (lightSpecular * matSpecular);
+    gl_FragColor = (specular * specularTerm) + texel;
+}
@@ -0,0 +1,8 @@
+uniform sampler2D MaterialTexture0;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    gl_FragColor = texture2D(MaterialTexture0, TextureCoord);
+}
@@ -0,0 +1,16 @@
+attribute vec3 position;
+
+uniform float Angle;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    float c = cos(Angle);
+    float s = sin(Angle);
+
+    gl_Position = vec4(c * position.x - s * position.y,
+                       s * position.x + c * position.y, 0.0, 1.0);
+
+    TextureCoord = position.xy * 0.5 + 0.5;
+}
@@ -0,0 +1,14 @@
+uniform mediump sampler2DArray Views;
+
+in vec2 TextureCoord;
+
+out vec4 FragColor;
+
+void main(void)
+{
+    // The views are shown side by side, the first one on the left
+    float view = TextureCoord.x < 0.5 ? 0.0 : 1.0;
+    vec2 coord = vec2(TextureCoord.x * 2.0 - view, TextureCoord.y);
+
+    FragColor = texture(Views, vec3(coord, view));
+}
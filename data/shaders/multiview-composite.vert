@@ -0,0 +1,9 @@
+in vec2 position;
+
+out vec2 TextureCoord;
+
+void main(void)
+{
+    TextureCoord = position * 0.5 + 0.5;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,13 @@
+uniform vec4 MaterialColor;
+
+in vec3 Normal;
+
+out vec4 FragColor;
+
+void main(void)
+{
+    const vec3 light_direction = vec3(0.27, 0.53, 0.80);
+    float diffuse = max(dot(normalize(Normal), light_direction), 0.0);
+
+    FragColor = vec4(MaterialColor.rgb * (0.2 + 0.8 * diffuse), 1.0);
+}
@@ -0,0 +1,25 @@
+// With multiview, a single draw renders both views, and gl_ViewID_OVR is
+// the view of the vertex. Otherwise each view is drawn on its own.
+#ifdef MULTIVIEW
+layout(num_views = 2) in;
+#define VIEW_INDEX gl_ViewID_OVR
+#else
+uniform int ViewIndex;
+#define VIEW_INDEX ViewIndex
+#endif
+
+in vec3 position;
+in vec3 normal;
+
+uniform mat4 ViewProjectionMatrix[2];
+uniform mat4 ModelMatrix;
+uniform mat4 NormalMatrix;
+
+out vec3 Normal;
+
+void main(void)
+{
+    // Only the position depends on the view, as GL_OVR_multiview requires
+    Normal = vec3(NormalMatrix * vec4(normal, 0.0));
+    gl_Position = ViewProjectionMatrix[VIEW_INDEX] * ModelMatrix * vec4(position, 1.0);
+}
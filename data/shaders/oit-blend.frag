@@ -0,0 +1,7 @@
+varying vec4 Color;
+varying float ViewDepth;
+
+void main(void)
+{
+    gl_FragColor = Color;
+}
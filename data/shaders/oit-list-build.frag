@@ -0,0 +1,28 @@
+// The head of the list of each pixel, with 0 ending a list
+layout(std430, binding = 0) buffer Heads {
+    uint NodeCount;
+    uint heads[];
+};
+
+// The color, the depth and the next node of each stored fragment
+layout(std430, binding = 1) writeonly buffer Nodes {
+    uvec4 nodes[];
+};
+
+uniform int Width;
+uniform int MaxNodes;
+
+in vec4 Color;
+in float ViewDepth;
+
+void main(void)
+{
+    uint node = atomicAdd(NodeCount, 1u) + 1u;
+
+    // Fragments are dropped once the node buffer is full
+    if (node < uint(MaxNodes)) {
+        ivec2 pixel = ivec2(gl_FragCoord.xy);
+        uint next = atomicExchange(heads[pixel.y * Width + pixel.x], node);
+        nodes[node] = uvec4(packUnorm4x8(Color), floatBitsToUint(ViewDepth), next, 0u);
+    }
+}
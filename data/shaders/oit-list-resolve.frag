@@ -0,0 +1,60 @@
+layout(std430, binding = 0) buffer Heads {
+    uint NodeCount;
+    uint heads[];
+};
+
+layout(std430, binding = 1) readonly buffer Nodes {
+    uvec4 nodes[];
+};
+
+uniform int Width;
+
+out vec4 FragColor;
+
+void main(void)
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    int index = pixel.y * Width + pixel.x;
+    uint node = heads[index];
+
+    // Empty the lists for the next frame, as they are read
+    heads[index] = 0u;
+    if (index == 0)
+        NodeCount = 0u;
+
+    // Gather the color and the depth of the last fragments drawn to the pixel
+    uvec2 fragments[MAX_FRAGMENTS];
+    int count = 0;
+
+    while (node != 0u && count < MAX_FRAGMENTS) {
+        uvec4 n = nodes[node];
+        fragments[count] = n.xy;
+        node = n.z;
+        count++;
+    }
+
+    // Sort them back to front
+    for (int i = 1; i < count; i++) {
+        uvec2 fragment = fragments[i];
+        float depth = uintBitsToFloat(fragment.y);
+        int j = i - 1;
+
+        while (j >= 0 && uintBitsToFloat(fragments[j].y) < depth) {
+            fragments[j + 1] = fragments[j];
+            j--;
+        }
+        fragments[j + 1] = fragment;
+    }
+
+    // Blend them, keeping how much of the background shows through
+    vec3 color = vec3(0.0);
+    float transmittance = 1.0;
+
+    for (int i = 0; i < count; i++) {
+        vec4 c = unpackUnorm4x8(fragments[i].x);
+        color = mix(color, c.rgb, c.a);
+        transmittance *= 1.0 - c.a;
+    }
+
+    FragColor = vec4(color, transmittance);
+}
@@ -0,0 +1,24 @@
+in vec3 position;
+in vec3 normal;
+
+uniform mat4 ModelViewProjectionMatrix;
+uniform mat4 ModelViewMatrix;
+uniform mat4 NormalMatrix;
+uniform vec4 InstanceColor;
+
+out vec4 Color;
+out float ViewDepth;
+
+void main(void)
+{
+    vec4 current_position = vec4(position, 1.0);
+
+    // Both sides of the surface are seen through the model, so both are lit
+    const vec3 light_direction = vec3(0.27, 0.53, 0.80);
+    vec3 N = normalize(vec3(NormalMatrix * vec4(normal, 1.0)));
+    float diffuse = 0.4 + 0.6 * abs(dot(N, light_direction));
+
+    Color = vec4(InstanceColor.rgb * diffuse, InstanceColor.a);
+    ViewDepth = -(ModelViewMatrix * current_position).z;
+    gl_Position = ModelViewProjectionMatrix * current_position;
+}
@@ -0,0 +1,13 @@
+uniform sampler2D AccumTexture;
+uniform sampler2D WeightTexture;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    vec4 accum = texture2D(AccumTexture, TextureCoord);
+    float weight = texture2D(WeightTexture, TextureCoord).r;
+
+    // The weighted average color, covering what the revealage doesn't show
+    gl_FragColor = vec4(accum.rgb / max(weight, 1e-4), 1.0 - accum.a);
+}
@@ -0,0 +1,12 @@
+varying vec4 Color;
+varying float ViewDepth;
+
+void main(void)
+{
+    // The depth weight of weighted blended OIT, favoring near fragments
+    float weight = Color.a * clamp(0.03 / (1e-5 + pow(ViewDepth / 200.0, 4.0)), 1e-2, 3e3);
+
+    // The weighted color and the revealage, then the sum of the weights
+    gl_FragData[0] = vec4(Color.rgb * weight, Color.a);
+    gl_FragData[1] = vec4(weight, 0.0, 0.0, 0.0);
+}
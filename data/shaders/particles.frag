@@ -0,0 +1,11 @@
+varying vec4 Color;
+varying vec2 SpriteCoord;
+
+void main(void)
+{
+    // A round sprite with a soft edge
+    vec2 d = 2.0 * SPRITE_COORD - 1.0;
+    float falloff = max(1.0 - dot(d, d), 0.0);
+
+    gl_FragColor = vec4(Color.rgb, Color.a * falloff);
+}
@@ -0,0 +1,34 @@
+attribute vec4 particle;
+attribute vec3 velocity;
+attribute vec2 corner;
+
+uniform float Time;
+uniform float Lifetime;
+uniform vec2 SpriteSize;
+uniform float PointSize;
+
+varying vec4 Color;
+varying vec2 SpriteCoord;
+
+const vec3 Gravity = vec3(0.0, -1.5, 0.0);
+
+// The position and age of a particle emitted from particle.xyz with
+// velocity at time particle.w, re-emitted at the end of each lifetime
+vec4 update(vec4 particle, vec3 velocity)
+{
+    float age = mod(Time - particle.w, Lifetime);
+    return vec4(particle.xyz + velocity * age + 0.5 * Gravity * age * age, age);
+}
+
+void main(void)
+{
+    vec4 state = UPDATE;
+
+    gl_Position = vec4(state.xyz + vec3(CORNER * SpriteSize, 0.0), 1.0);
+    gl_PointSize = PointSize;
+
+    // Hot young particles turn red and fade out as they age
+    float life = state.w / Lifetime;
+    Color = vec4(mix(vec3(1.0, 0.9, 0.5), vec3(0.8, 0.1, 0.0), life), 0.3 * (1.0 - life));
+    SpriteCoord = CORNER * 0.5 + 0.5;
+}
@@ -0,0 +1,6 @@
+uniform vec4 PathColor;
+
+void main(void)
+{
+    gl_FragColor = PathColor;
+}
@@ -0,0 +1,8 @@
+attribute vec2 position;
+
+uniform mat4 ModelViewProjectionMatrix;
+
+void main(void)
+{
+    gl_Position = ModelViewProjectionMatrix * vec4(position, 0.0, 1.0);
+}
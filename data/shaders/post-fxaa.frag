@@ -0,0 +1,47 @@
+uniform sampler2D Texture0;
+
+varying vec2 vUv;
+
+// The FXAA of Timothy Lottes, in its simple form with 9 texture reads
+void main()
+{
+    const float reduce_min = 1.0 / 128.0;
+    const float reduce_mul = 1.0 / 8.0;
+    const float span_max = 8.0;
+    const vec3 luma = vec3(0.299, 0.587, 0.114);
+    vec2 texel = vec2(TextureStepX, TextureStepY);
+
+    vec3 rgb_nw = texture2D(Texture0, vUv + vec2(-1.0, -1.0) * texel).rgb;
+    vec3 rgb_ne = texture2D(Texture0, vUv + vec2(1.0, -1.0) * texel).rgb;
+    vec3 rgb_sw = texture2D(Texture0, vUv + vec2(-1.0, 1.0) * texel).rgb;
+    vec3 rgb_se = texture2D(Texture0, vUv + vec2(1.0, 1.0) * texel).rgb;
+    vec3 rgb_m = texture2D(Texture0, vUv).rgb;
+
+    float luma_nw = dot(rgb_nw, luma);
+    float luma_ne = dot(rgb_ne, luma);
+    float luma_sw = dot(rgb_sw, luma);
+    float luma_se = dot(rgb_se, luma);
+    float luma_m = dot(rgb_m, luma);
+    float luma_min = min(luma_m, min(min(luma_nw, luma_ne), min(luma_sw, luma_se)));
+    float luma_max = max(luma_m, max(max(luma_nw, luma_ne), max(luma_sw, luma_se)));
+
+    // Blur along the edge, across the gradient of the luminance
+    vec2 dir = vec2(-((luma_nw + luma_ne) - (luma_sw + luma_se)),
+                    (luma_nw + luma_sw) - (luma_ne + luma_se));
+    float dir_reduce = max((luma_nw + luma_ne + luma_sw + luma_se) * (0.25 * reduce_mul),
+                           reduce_min);
+    float rcp_dir_min = 1.0 / (min(abs(dir.x), abs(dir.y)) + dir_reduce);
+    dir = clamp(dir * rcp_dir_min, vec2(-span_max), vec2(span_max)) * texel;
+
+    vec3 rgb_a = 0.5 * (texture2D(Texture0, vUv + dir * (1.0 / 3.0 - 0.5)).rgb +
+                        texture2D(Texture0, vUv + dir * (2.0 / 3.0 - 0.5)).rgb);
+    vec3 rgb_b = rgb_a * 0.5 + 0.25 * (texture2D(Texture0, vUv - dir * 0.5).rgb +
+                                       texture2D(Texture0, vUv + dir * 0.5).rgb);
+    float luma_b = dot(rgb_b, luma);
+
+    // Fall back to the narrower blur if the wider one went past the edge
+    if (luma_b < luma_min || luma_b > luma_max)
+        gl_FragColor = vec4(rgb_a, 1.0);
+    else
+        gl_FragColor = vec4(rgb_b, 1.0);
+}
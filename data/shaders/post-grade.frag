@@ -0,0 +1,16 @@
+uniform sampler2D Texture0;
+
+varying vec2 vUv;
+
+void main()
+{
+    vec3 color = texture2D(Texture0, vUv).rgb;
+
+    // Raise the contrast and the saturation, and warm up the colors
+    color = (color - 0.5) * 1.1 + 0.5;
+    float luminance = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    color = mix(vec3(luminance), color, 1.2);
+    color *= vec3(1.05, 1.0, 0.92);
+
+    gl_FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
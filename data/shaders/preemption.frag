@@ -0,0 +1,15 @@
+uniform float Time;
+
+varying vec2 Coord;
+
+void main(void)
+{
+    // A long chain of dependent operations per fragment, so that a single
+    // draw keeps the GPU busy for a long time
+    vec2 z = Coord;
+
+    for (int i = 0; i < $STEPS$; i++)
+        z = fract(vec2(z.x * z.x - z.y * z.y, 2.0 * z.x * z.y) + Coord + Time);
+
+    gl_FragColor = vec4(z, 0.5, 1.0);
+}
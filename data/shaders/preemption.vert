@@ -0,0 +1,9 @@
+attribute vec2 position;
+
+varying vec2 Coord;
+
+void main(void)
+{
+    gl_Position = vec4(position, 0.0, 1.0);
+    Coord = position * 0.5 + 0.5;
+}
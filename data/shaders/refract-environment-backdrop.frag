@@ -0,0 +1,10 @@
+uniform sampler2D ImageMap;
+
+varying vec3 Direction;
+
+void main(void)
+{
+    // Index the image like light-refract.frag does with the transmitted vector
+    vec3 direction = normalize(Direction);
+    gl_FragColor = texture2D(ImageMap, direction.st * 0.5 + 0.5);
+}
@@ -0,0 +1,15 @@
+attribute vec3 position;
+
+uniform mat4 FaceMatrix;
+
+varying vec3 Direction;
+
+void main(void)
+{
+    // The direction of the pixel from the center of the cubemap, FaceMatrix
+    // being the inverse of the view rotation of the face
+    Direction = vec3(FaceMatrix * vec4(position.xy, -1.0, 0.0));
+
+    // Drawn first without depth testing, covering the face
+    gl_Position = vec4(position.xy, 0.0, 1.0);
+}
@@ -0,0 +1,20 @@
+attribute vec3 position;
+attribute vec3 normal;
+
+uniform mat4 ModelViewProjectionMatrix;
+uniform mat4 NormalMatrix;
+uniform vec4 MaterialDiffuse;
+
+varying vec4 Color;
+
+void main(void)
+{
+    // The normal and the light direction are both in environment space
+    vec3 N = normalize(vec3(NormalMatrix * vec4(normal, 1.0)));
+    vec3 L = normalize(LightSourcePosition.xyz);
+
+    float diffuse = max(dot(N, L), 0.0);
+    Color = vec4((0.2 + 0.8 * diffuse) * MaterialDiffuse.rgb, MaterialDiffuse.a);
+
+    gl_Position = ModelViewProjectionMatrix * vec4(position, 1.0);
+}
@@ -0,0 +1,52 @@
+uniform sampler2D ShadowMap;
+uniform vec2 CascadeTexelSize;
+
+varying vec4 Color;
+varying vec4 ShadowCoord;
+
+// The cascades are side by side in the shadow map. Cascade c covers the
+// center of the light view zoomed in 2^(Cascades - 1 - c) times, so the
+// last one covers the whole light view.
+const int Cascades = $CASCADES$;
+const int PcfRadius = $PCF_RADIUS$;
+
+void main()
+{
+    vec4 sc_perspective = ShadowCoord / ShadowCoord.w;
+    sc_perspective.z += 0.1505;
+
+    // Use the finest cascade that covers the fragment
+    vec2 uv = sc_perspective.st;
+    float cascade = float(Cascades - 1);
+    float zoom = 1.0;
+    for (int c = Cascades - 1; c >= 0; c--) {
+        vec2 cascade_uv = (sc_perspective.st - 0.5) * zoom + 0.5;
+        if (all(greaterThanEqual(cascade_uv, vec2(0.0))) &&
+            all(lessThanEqual(cascade_uv, vec2(1.0)))) {
+            uv = cascade_uv;
+            cascade = float(c);
+        }
+        zoom *= 2.0;
+    }
+
+    // Percentage-closer filtering of the depth tests in a square kernel,
+    // without sampling the neighboring cascades
+    float lit = 0.0;
+    for (int i = -PcfRadius; i <= PcfRadius; i++) {
+        for (int j = -PcfRadius; j <= PcfRadius; j++) {
+            vec2 texel_uv = clamp(uv + vec2(float(i), float(j)) * CascadeTexelSize,
+                                  0.5 * CascadeTexelSize, vec2(1.0) - 0.5 * CascadeTexelSize);
+            texel_uv.s = (texel_uv.s + cascade) / float(Cascades);
+            float light_distance = DepthSampleOffset +
+                                   DepthSampleScale * texture2D(ShadowMap, texel_uv).x;
+            lit += light_distance < sc_perspective.z ? 0.0 : 1.0;
+        }
+    }
+    lit /= float((2 * PcfRadius + 1) * (2 * PcfRadius + 1));
+
+    float shadow = 1.0;
+    if (ShadowCoord.w > 0.0) {
+        shadow = 0.5 + 0.5 * lit;
+    }
+    gl_FragColor = vec4(shadow * Color.rgb, 1.0);
+}
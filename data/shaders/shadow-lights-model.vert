@@ -0,0 +1,24 @@
+attribute vec3 position;
+attribute vec3 normal;
+
+const int Lights = $LIGHTS$;
+
+uniform mat4 LightMatrix[Lights];
+uniform mat4 ModelViewProjectionMatrix;
+uniform mat4 NormalMatrix;
+
+varying vec4 Color;
+varying vec3 Normal;
+varying vec4 ShadowCoord[Lights];
+
+void main()
+{
+    Color = MaterialDiffuse;
+    // Transform the normal to eye coordinates
+    Normal = vec3(NormalMatrix * vec4(normal, 1.0));
+
+    vec4 pos4 = vec4(position, 1.0);
+    for (int l = 0; l < Lights; l++)
+        ShadowCoord[l] = LightMatrix[l] * pos4;
+    gl_Position = ModelViewProjectionMatrix * pos4;
+}
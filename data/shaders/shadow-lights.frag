@@ -0,0 +1,80 @@
+const int Lights = $LIGHTS$;
+const int Cascades = $CASCADES$;
+const int PcfRadius = $PCF_RADIUS$;
+
+uniform sampler2D ShadowMap;
+uniform vec2 CascadeTexelSize;
+// The direction of each light in eye coordinates
+uniform vec3 LightDirection[Lights];
+// Whether each light is weighted by its diffuse term (1.0) or not (0.0)
+uniform float DiffuseLighting;
+uniform float DepthBias;
+
+varying vec4 Color;
+varying vec3 Normal;
+varying vec4 ShadowCoord[Lights];
+
+// The shadow maps of the lights are stacked in the texture, one row of
+// cascades per light, laid out as in shadow-cascades.frag.
+float lit(vec4 shadow_coord, float light)
+{
+    vec4 sc_perspective = shadow_coord / shadow_coord.w;
+    sc_perspective.z += DepthBias;
+
+    // Use the finest cascade that covers the fragment
+    vec2 uv = sc_perspective.st;
+    float cascade = float(Cascades - 1);
+    float zoom = 1.0;
+    for (int c = Cascades - 1; c >= 0; c--) {
+        vec2 cascade_uv = (sc_perspective.st - 0.5) * zoom + 0.5;
+        if (all(greaterThanEqual(cascade_uv, vec2(0.0))) &&
+            all(lessThanEqual(cascade_uv, vec2(1.0)))) {
+            uv = cascade_uv;
+            cascade = float(c);
+        }
+        zoom *= 2.0;
+    }
+
+    // Percentage-closer filtering of the depth tests in a square kernel,
+    // without sampling the neighboring cascades or lights
+    float result = 0.0;
+    for (int i = -PcfRadius; i <= PcfRadius; i++) {
+        for (int j = -PcfRadius; j <= PcfRadius; j++) {
+            vec2 texel_uv = clamp(uv + vec2(float(i), float(j)) * CascadeTexelSize,
+                                  0.5 * CascadeTexelSize, vec2(1.0) - 0.5 * CascadeTexelSize);
+            texel_uv.s = (texel_uv.s + cascade) / float(Cascades);
+            texel_uv.t = (texel_uv.t + light) / float(Lights);
+            float light_distance = DepthSampleOffset +
+                                   DepthSampleScale * texture2D(ShadowMap, texel_uv).x;
+            result += light_distance < sc_perspective.z ? 0.0 : 1.0;
+        }
+    }
+
+    return result / float((2 * PcfRadius + 1) * (2 * PcfRadius + 1));
+}
+
+void main()
+{
+    // Each light contributes, halved where it is shadowed
+    float light = 0.0;
+    for (int l = 0; l < Lights; l++) {
+        float weight = 1.0;
+        if (DiffuseLighting > 0.0)
+            weight = max(dot(normalize(Normal), LightDirection[l]), 0.0);
+
+        float shadow = 1.0;
+        if (ShadowCoord[l].w > 0.0)
+            shadow = 0.5 + 0.5 * lit(ShadowCoord[l], float(l));
+
+        light += weight * shadow;
+    }
+
+    // The ground is darkened by the average of the shadows, the model is
+    // lit by the sum of the lights
+    if (DiffuseLighting > 0.0)
+        light = min(light, 1.0);
+    else
+        light /= float(Lights);
+
+    gl_FragColor = vec4(light * Color.rgb, 1.0);
+}
@@ -0,0 +1,22 @@
+attribute vec2 position;
+
+const int Lights = $LIGHTS$;
+
+uniform mat4 LightMatrix[Lights];
+uniform mat4 ModelViewProjectionMatrix;
+
+varying vec4 Color;
+varying vec3 Normal;
+varying vec4 ShadowCoord[Lights];
+
+void main()
+{
+    Color = MaterialDiffuse;
+    // The ground isn't lit by the diffuse term, see shadow-lights.frag
+    Normal = vec3(0.0);
+
+    vec4 pos4 = vec4(position, 0.0, 1.0);
+    for (int l = 0; l < Lights; l++)
+        ShadowCoord[l] = LightMatrix[l] * pos4;
+    gl_Position = ModelViewProjectionMatrix * pos4;
+}
@@ -0,0 +1,16 @@
+attribute vec2 corner;
+
+// The rectangle of the sprite on the screen and in its atlas page, as
+// (x, y, width, height). Uniforms when drawing one sprite at a time,
+// instanced attributes otherwise.
+SPRITE_STORAGE vec4 rect;
+SPRITE_STORAGE vec4 uv_rect;
+
+varying vec2 TextureCoord;
+
+void main(void)
+{
+    gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
+
+    TextureCoord = uv_rect.xy + corner * uv_rect.zw;
+}
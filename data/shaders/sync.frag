@@ -0,0 +1,10 @@
+void main(void)
+{
+    // Arithmetic that can't be folded, to keep the GPU busy for a while
+    vec2 v = gl_FragCoord.xy * 0.001;
+
+    for (int i = 0; i < ITERATIONS; i++)
+        v = fract(v * 1.7 + v.yx * 0.3 + 0.1);
+
+    gl_FragColor = vec4(v, 0.5, 1.0);
+}
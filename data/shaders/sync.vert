@@ -0,0 +1,8 @@
+attribute vec2 position;
+
+uniform float Scale;
+
+void main(void)
+{
+    gl_Position = vec4(position * Scale, 0.0, 1.0);
+}
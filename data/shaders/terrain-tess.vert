@@ -0,0 +1,20 @@
+// Vertex attributes
+in vec3 position;
+in vec3 normal;
+in vec3 tangent;
+in vec2 uv;
+
+out vec3 cPosition;
+out vec3 cNormal;
+out vec3 cTangent;
+out vec2 cUv;
+
+void main()
+{
+    // The tessellation evaluation shader transforms and displaces the
+    // vertices
+    cPosition = position;
+    cNormal = normal;
+    cTangent = tangent;
+    cUv = uv;
+}
@@ -1,10 +1,13 @@
-attribute vec2 position;
+attribute vec2 corner;
+attribute vec4 rect;
 attribute vec2 texcoord;
 
+uniform vec2 GlyphSize;
+
 varying vec2 TextureCoord;
 
 void main(void)
 {
-    TextureCoord = texcoord;
-    gl_Position = vec4(position, 0.0, 1.0);
+    TextureCoord = texcoord + corner * GlyphSize;
+    gl_Position = vec4(rect.xy + corner * rect.zw, 0.0, 1.0);
 }
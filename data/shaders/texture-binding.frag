@@ -0,0 +1,21 @@
+#if defined(TEXTURE_ARRAY)
+uniform mediump sampler2DArray Textures;
+uniform int Layer;
+#elif defined(BINDLESS)
+layout(bindless_sampler) uniform sampler2D Texture;
+#else
+uniform sampler2D Texture;
+#endif
+
+in vec2 TextureCoord;
+
+out vec4 FragColor;
+
+void main(void)
+{
+#if defined(TEXTURE_ARRAY)
+    FragColor = texture(Textures, vec3(TextureCoord, float(Layer)));
+#else
+    FragColor = texture(Texture, TextureCoord);
+#endif
+}
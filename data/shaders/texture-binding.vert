@@ -0,0 +1,12 @@
+in vec3 position;
+
+uniform vec2 Offset;
+
+out vec2 TextureCoord;
+
+void main(void)
+{
+    gl_Position = vec4(position.xy + Offset, 0.0, 1.0);
+
+    TextureCoord = position.xy / CellSize + 0.5;
+}
@@ -0,0 +1,16 @@
+uniform sampler2D Texture0;
+
+void main(void)
+{
+    HIGHP_OR_DEFAULT vec2 coord = gl_FragCoord.xy / TextureSize;
+    HIGHP_OR_DEFAULT vec4 texel = vec4(0.0);
+
+    // Each texel holds the coordinates of the next texel to read, as two
+    // 16-bit values, so every read depends on the previous one
+    for (int i = 0; i < $SAMPLES$; i++) {
+        texel = texture2D(Texture0, coord);
+        coord = (texel.rb * 65280.0 + texel.ga * 255.0 + 0.5) / TextureSize;
+    }
+
+    gl_FragColor = texel;
+}
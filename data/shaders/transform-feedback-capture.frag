@@ -0,0 +1,6 @@
+out vec4 FragColor;
+
+void main(void)
+{
+    FragColor = vec4(1.0);
+}
@@ -0,0 +1,22 @@
+in vec3 position;
+
+uniform mat4 ModelViewProjectionMatrix;
+uniform float Time;
+uniform float WaveNumber;
+uniform float WaveVelocity;
+
+out vec3 Position;
+out vec3 Normal;
+
+void main(void)
+{
+    // The wave of the buffer scene, travelling along the length of the grid
+    float phase = WaveNumber * (position.x - WaveVelocity * Time);
+    float slope = 0.2 * WaveNumber * cos(phase);
+
+    Position = vec3(position.xy, 0.2 * sin(phase));
+    Normal = normalize(vec3(-slope, 0.0, 1.0));
+
+    // Only used if the captured vertices are also rasterized, as points
+    gl_Position = ModelViewProjectionMatrix * vec4(Position, 1.0);
+}
@@ -0,0 +1,13 @@
+in vec3 Normal;
+
+out vec4 FragColor;
+
+const vec3 LightDirection = vec3(0.0, 0.6, 0.8);
+const vec4 MaterialColor = vec4(0.0, 0.5, 0.8, 1.0);
+
+void main(void)
+{
+    float diffuse = max(dot(normalize(Normal), LightDirection), 0.0);
+
+    FragColor = vec4(MaterialColor.rgb * (0.3 + 0.7 * diffuse), MaterialColor.a);
+}
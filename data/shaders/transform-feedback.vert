@@ -0,0 +1,12 @@
+in vec3 position;
+in vec3 normal;
+
+uniform mat4 ModelViewProjectionMatrix;
+
+out vec3 Normal;
+
+void main(void)
+{
+    gl_Position = ModelViewProjectionMatrix * vec4(position, 1.0);
+    Normal = normal;
+}
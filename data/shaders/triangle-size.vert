@@ -0,0 +1,9 @@
+attribute vec2 position;
+
+uniform float PointSize;
+
+void main(void)
+{
+    gl_PointSize = PointSize;
+    gl_Position = vec4(position, 0.0, 1.0);
+}
@@ -0,0 +1,50 @@
+in vec3 position;
+
+#if defined(INSTANCED_UBO)
+struct ObjectParams {
+    mat4 Transform;
+    vec4 MaterialColor;
+    vec4 MaterialParams;
+};
+
+layout(std140) uniform Objects {
+    ObjectParams objects[ObjectCount];
+};
+#elif defined(INSTANCED_SSBO)
+struct ObjectParams {
+    mat4 Transform;
+    vec4 MaterialColor;
+    vec4 MaterialParams;
+};
+
+layout(std430, binding = 0) readonly buffer Objects {
+    ObjectParams objects[];
+};
+#elif defined(UBO)
+layout(std140) uniform ObjectParams {
+    mat4 Transform;
+    vec4 MaterialColor;
+    vec4 MaterialParams;
+};
+#else
+uniform mat4 Transform;
+uniform vec4 MaterialColor;
+uniform vec4 MaterialParams;
+#endif
+
+out vec4 Color;
+
+void main(void)
+{
+#if defined(INSTANCED_UBO) || defined(INSTANCED_SSBO)
+    mat4 Transform = objects[gl_InstanceID].Transform;
+    vec4 MaterialColor = objects[gl_InstanceID].MaterialColor;
+    vec4 MaterialParams = objects[gl_InstanceID].MaterialParams;
+#endif
+
+    gl_Position = Transform * vec4(position, 1.0);
+
+    /* Shade the quad from its center to its edges by the material */
+    float edge = max(abs(position.x), abs(position.y));
+    Color = MaterialColor * mix(MaterialParams.x, MaterialParams.y, edge);
+}
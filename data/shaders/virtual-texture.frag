@@ -0,0 +1,25 @@
+uniform sampler2D PageTable;
+uniform sampler2D Tiles;
+
+in highp vec2 VirtualCoord;
+
+out vec4 FragColor;
+
+void main(void)
+{
+    // The page table has a texel per tile, its alpha telling whether the
+    // tile is resident and its red and green the slot in the tile cache
+    vec4 page = texture(PageTable, VirtualCoord);
+    if (page.a < 0.5) {
+        FragColor = vec4(0.25, 0.25, 0.25, 1.0);
+        return;
+    }
+
+#ifdef SPARSE
+    FragColor = texture(Tiles, VirtualCoord);
+#else
+    vec2 slot = floor(page.rg * 255.0 + 0.5);
+    vec2 tile_coord = fract(VirtualCoord * PageTableSize);
+    FragColor = texture(Tiles, (slot + tile_coord) / CacheSize);
+#endif
+}
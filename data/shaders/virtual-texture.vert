@@ -0,0 +1,15 @@
+in vec2 position;
+
+uniform vec2 ViewOrigin;
+uniform vec2 ViewSize;
+
+// Highp, as mediump can't address every texel of a large virtual texture
+out highp vec2 VirtualCoord;
+
+void main(void)
+{
+    gl_Position = vec4(position, 0.0, 1.0);
+
+    // The coordinates of the visible part of the virtual texture
+    VirtualCoord = ViewOrigin + (position * 0.5 + 0.5) * ViewSize;
+}
@@ -0,0 +1,13 @@
+attribute vec2 position;
+
+uniform vec2 Offset;
+uniform vec2 Scale;
+
+varying vec2 TexCoord;
+
+void main(void)
+{
+    // Each texture is drawn to its own cell of the screen, and read whole
+    TexCoord = position * 0.5 + 0.5;
+    gl_Position = vec4(position * Scale + Offset, 0.0, 1.0);
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "alloc-counter.h"
+
+#ifdef GLMARK2_ALLOC_COUNTER
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+/*
+ * Set once before the benchmarks start, but read by the allocations of
+ * every thread, so it must still be atomic.
+ */
+std::atomic<bool> counter_active(false);
+
+/*
+ * A plain counter, which needs no construction, so that it can be used by
+ * the allocations made while the thread starts and exits.
+ */
+thread_local uint64_t thread_allocations = 0;
+
+void *
+allocate(std::size_t size)
+{
+    if (counter_active.load(std::memory_order_relaxed))
+        thread_allocations++;
+
+    /* Zero-sized allocations must still return a unique pointer */
+    void *ptr = std::malloc(size > 0 ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void *
+allocate(std::size_t size, const std::nothrow_t &)
+{
+    if (counter_active.load(std::memory_order_relaxed))
+        thread_allocations++;
+
+    return std::malloc(size > 0 ? size : 1);
+}
+
+}
+
+void *
+operator new(std::size_t size)
+{
+    return allocate(size);
+}
+
+void *
+operator new[](std::size_t size)
+{
+    return allocate(size);
+}
+
+void *
+operator new(std::size_t size, const std::nothrow_t &nothrow) noexcept
+{
+    return allocate(size, nothrow);
+}
+
+void *
+operator new[](std::size_t size, const std::nothrow_t &nothrow) noexcept
+{
+    return allocate(size, nothrow);
+}
+
+void
+operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void
+operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void
+operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void
+operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void
+operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void
+operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+bool
+AllocCounter::install(bool enable)
+{
+    counter_active = enable;
+    return true;
+}
+
+bool
+AllocCounter::active()
+{
+    return counter_active.load(std::memory_order_relaxed);
+}
+
+uint64_t
+AllocCounter::allocations()
+{
+    return thread_allocations;
+}
+
+#else
+
+bool
+AllocCounter::install(bool enable)
+{
+    return !enable;
+}
+
+bool
+AllocCounter::active()
+{
+    return false;
+}
+
+uint64_t
+AllocCounter::allocations()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_ALLOC_COUNTER_H_
+#define GLMARK2_ALLOC_COUNTER_H_
+
+#include <stdint.h>
+
+/**
+ * Counts the allocations made by glmark2 itself (--count-allocations), to
+ * find the per-frame allocations that make CPU-bound benchmarks measure
+ * the allocator rather than the driver.
+ *
+ * The global operator new is replaced to count its calls once enabled,
+ * so the allocations of the standard containers and strings are counted
+ * too. Those that the GL driver makes with malloc aren't, but drivers
+ * written in C++ (e.g. the LLVM of llvmpipe) use operator new as well and
+ * are counted with the GL calls that make them. The counters are per
+ * thread.
+ *
+ * Replacing operator new affects every allocation of the process, so it is
+ * only built in when glmark2 is configured with the allocation counter
+ * (--enable-alloc-counter with waf, -Dalloc-counter=true with meson).
+ * Otherwise the C++ library's allocator is used and nothing is counted.
+ */
+class AllocCounter
+{
+public:
+    /**
+     * Starts counting the allocations, if enabled.
+     *
+     * @return whether the allocations can be counted as requested, false if
+     *         counting is enabled but the counter isn't built in
+     */
+    static bool install(bool enable);
+
+    /**
+     * Whether the allocations are counted.
+     */
+    static bool active();
+
+    /**
+     * The number of allocations made by the current thread.
+     */
+    static uint64_t allocations();
+};
+
+#endif /* GLMARK2_ALLOC_COUNTER_H_ */
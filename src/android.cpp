@@ -23,6 +23,14 @@
  */
 #include <assert.h>
 #include <jni.h>
+#include <unistd.h>
+#include <android/looper.h>
+#include <android/native_window_jni.h>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
 #include <vector>
 #include <string>
 #include <fstream>
@@ -34,12 +42,102 @@
 #include "main-loop.h"
 #include "benchmark-collection.h"
 #include "scene-collection.h"
+#include "shared-library.h"
 
-static Canvas *g_canvas;
+/*
+ * The NDK functions newer than the platform the library is built for,
+ * loaded from libandroid.so when the device has them.
+ */
+struct AChoreographer;
+struct APerformanceHintManager;
+struct APerformanceHintSession;
+struct AThermalManager;
+
+typedef void (*AChoreographerFrameCallback64)(int64_t frame_time_nanos, void *data);
+
+class NdkFunctions
+{
+public:
+    NdkFunctions() :
+        AChoreographer_getInstance(0), AChoreographer_postFrameCallback64(0),
+        APerformanceHint_getManager(0), APerformanceHint_createSession(0),
+        APerformanceHint_reportActualWorkDuration(0), APerformanceHint_closeSession(0),
+        AThermal_acquireManager(0), AThermal_releaseManager(0),
+        AThermal_getThermalHeadroom(0) {}
+
+    void load()
+    {
+        if (!lib_.open("libandroid.so"))
+            return;
+
+        load(AChoreographer_getInstance, "AChoreographer_getInstance");
+        load(AChoreographer_postFrameCallback64, "AChoreographer_postFrameCallback64");
+        load(APerformanceHint_getManager, "APerformanceHint_getManager");
+        load(APerformanceHint_createSession, "APerformanceHint_createSession");
+        load(APerformanceHint_reportActualWorkDuration,
+             "APerformanceHint_reportActualWorkDuration");
+        load(APerformanceHint_closeSession, "APerformanceHint_closeSession");
+        load(AThermal_acquireManager, "AThermal_acquireManager");
+        load(AThermal_releaseManager, "AThermal_releaseManager");
+        load(AThermal_getThermalHeadroom, "AThermal_getThermalHeadroom");
+    }
+
+    /* API level 29 */
+    AChoreographer *(*AChoreographer_getInstance)();
+    void (*AChoreographer_postFrameCallback64)(AChoreographer *choreographer,
+                                               AChoreographerFrameCallback64 callback,
+                                               void *data);
+    /* API level 33 */
+    APerformanceHintManager *(*APerformanceHint_getManager)();
+    APerformanceHintSession *(*APerformanceHint_createSession)(APerformanceHintManager *manager,
+                                                               const int32_t *thread_ids,
+                                                               size_t size,
+                                                               int64_t target_duration_nanos);
+    int (*APerformanceHint_reportActualWorkDuration)(APerformanceHintSession *session,
+                                                     int64_t actual_duration_nanos);
+    void (*APerformanceHint_closeSession)(APerformanceHintSession *session);
+    /* API level 30, AThermal_getThermalHeadroom() 31 */
+    AThermalManager *(*AThermal_acquireManager)();
+    void (*AThermal_releaseManager)(AThermalManager *manager);
+    float (*AThermal_getThermalHeadroom)(AThermalManager *manager, int forecast_seconds);
+
+private:
+    template<typename T> void load(T &func, const char *name)
+    {
+        func = reinterpret_cast<T>(lib_.load(name));
+    }
+
+    SharedLibrary lib_;
+};
+
+static CanvasAndroid *g_canvas;
 static MainLoop *g_loop;
 static BenchmarkCollection *g_benchmark_collection;
 static SceneCollection *g_scene_collection;
 static std::ostream *g_log_extra;
+static NdkFunctions g_ndk;
+static AThermalManager *g_thermal_manager;
+
+/**
+ * Gets the thermal headroom of the device, as a suffix for the results.
+ *
+ * @return " ThermalHeadroom: H", or an empty string if unknown
+ */
+static std::string
+thermal_headroom_info()
+{
+    if (!g_thermal_manager || !g_ndk.AThermal_getThermalHeadroom)
+        return std::string();
+
+    /* NaN if unsupported or polled more than once per second */
+    float headroom = g_ndk.AThermal_getThermalHeadroom(g_thermal_manager, 0);
+    if (std::isnan(headroom))
+        return std::string();
+
+    std::stringstream ss;
+    ss << " ThermalHeadroom: " << std::fixed << std::setprecision(2) << headroom;
+    return ss.str();
+}
 
 class MainLoopAndroid : public MainLoop
 {
@@ -52,10 +150,11 @@ public:
     virtual void log_scene_result()
     {
         if (scene_setup_status_ == SceneSetupStatusSuccess) {
-            Log::info("%s FPS: %u FrameTime: %.3f ms\n",
+            Log::info("%s FPS: %u FrameTime: %.3f ms%s\n",
                       scene_->info_string().c_str(),
                       scene_->average_fps(),
-                      1000.0 / scene_->average_fps());
+                      1000.0 / scene_->average_fps(),
+                      thermal_headroom_info().c_str());
         }
         else if (scene_setup_status_ == SceneSetupStatusUnsupported) {
             Log::info("%s Unsupported\n",
@@ -79,10 +178,11 @@ public:
     virtual void log_scene_result()
     {
         if (scene_setup_status_ == SceneSetupStatusSuccess) {
-            Log::info("%s FPS: %u FrameTime: %.3f ms\n",
+            Log::info("%s FPS: %u FrameTime: %.3f ms%s\n",
                       scene_->info_string().c_str(),
                       scene_->average_fps(),
-                      1000.0 / scene_->average_fps());
+                      1000.0 / scene_->average_fps(),
+                      thermal_headroom_info().c_str());
         }
         else if (scene_setup_status_ == SceneSetupStatusUnsupported) {
             Log::info("%s Unsupported\n",
@@ -253,13 +353,184 @@ public:
     DummyCanvas() : Canvas(0, 0) {}
 };
 
+/**
+ * Runs the benchmarks from the thread of the caller, instead of from the
+ * render callbacks of GLSurfaceView.
+ *
+ * With the fifo and relaxed swap modes, each frame is rendered from an
+ * AChoreographer frame callback, otherwise the frames are rendered back
+ * to back as in the other flavors.
+ */
+class NativeLoop
+{
+public:
+    NativeLoop() :
+        looper_(0), choreographer_(0), hint_session_(0), stop_(false), done_(false) {}
+
+    void run();
+    void stop();
+
+private:
+    static void frame_callback(int64_t frame_time_nanos, void *data);
+    bool step();
+    void init_performance_hint();
+
+    std::mutex mutex_;
+    ALooper *looper_;
+    AChoreographer *choreographer_;
+    APerformanceHintSession *hint_session_;
+    std::atomic<bool> stop_;
+    bool done_;
+};
+
+static std::mutex g_native_loop_mutex;
+static NativeLoop *g_native_loop;
+
+/**
+ * Renders a frame of the benchmarks.
+ *
+ * @return whether there are more frames to render
+ */
+static bool
+render_frame()
+{
+    if (!g_loop->step()) {
+        Log::info("glmark2 Score: %u\n", g_loop->score());
+        return false;
+    }
+
+    return true;
+}
+
 void
-Java_org_linaro_glmark2_native_init(JNIEnv* env, jclass clazz,
-                                    jobject asset_manager,
-                                    jstring args,
-                                    jstring log_file)
+NativeLoop::run()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        looper_ = ALooper_prepare(0);
+        ALooper_acquire(looper_);
+    }
+
+    bool paced = Options::swap_mode == Options::SwapModeFIFO ||
+                 Options::swap_mode == Options::SwapModeRelaxed;
+
+    if (paced && g_ndk.AChoreographer_getInstance && g_ndk.AChoreographer_postFrameCallback64)
+        choreographer_ = g_ndk.AChoreographer_getInstance();
+
+    if (paced && !choreographer_) {
+        Log::info("Warning: AChoreographer_postFrameCallback64() is not supported,"
+                  " the frames are only paced by eglSwapBuffers()\n");
+    }
+
+    if (Options::android_performance_hint)
+        init_performance_hint();
+
+    if (choreographer_)
+        g_ndk.AChoreographer_postFrameCallback64(choreographer_, frame_callback, this);
+
+    while (!done_) {
+        if (choreographer_) {
+            ALooper_pollOnce(-1, 0, 0, 0);
+            done_ = done_ || stop_;
+        }
+        else {
+            done_ = !step();
+        }
+    }
+
+    if (hint_session_)
+        g_ndk.APerformanceHint_closeSession(hint_session_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    ALooper_release(looper_);
+    looper_ = 0;
+}
+
+/* Called from another thread */
+void
+NativeLoop::stop()
+{
+    stop_ = true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (looper_)
+        ALooper_wake(looper_);
+}
+
+void
+NativeLoop::frame_callback(int64_t frame_time_nanos, void *data)
+{
+    static_cast<void>(frame_time_nanos);
+    NativeLoop *loop = static_cast<NativeLoop *>(data);
+
+    if (loop->step()) {
+        g_ndk.AChoreographer_postFrameCallback64(loop->choreographer_,
+                                                 frame_callback, loop);
+    }
+    else {
+        loop->done_ = true;
+    }
+}
+
+bool
+NativeLoop::step()
+{
+    if (stop_)
+        return false;
+
+    uint64_t start = Util::get_timestamp_us();
+    bool running = render_frame();
+
+    /* The CPU time of the frame, including the swap */
+    if (hint_session_) {
+        int64_t duration = (Util::get_timestamp_us() - start) * 1000;
+        g_ndk.APerformanceHint_reportActualWorkDuration(hint_session_, duration);
+    }
+
+    return running;
+}
+
+void
+NativeLoop::init_performance_hint()
+{
+    if (!g_ndk.APerformanceHint_getManager || !g_ndk.APerformanceHint_createSession ||
+        !g_ndk.APerformanceHint_reportActualWorkDuration ||
+        !g_ndk.APerformanceHint_closeSession)
+    {
+        Log::info("Warning: APerformanceHint is not supported\n");
+        return;
+    }
+
+    APerformanceHintManager *manager = g_ndk.APerformanceHint_getManager();
+    int32_t tid = gettid();
+    /* A frame per refresh period, 60Hz if unknown */
+    int64_t target = g_canvas->refresh() ? g_canvas->refresh() * 1000 : 16666667;
+
+    if (manager)
+        hint_session_ = g_ndk.APerformanceHint_createSession(manager, &tid, 1, target);
+
+    if (!hint_session_)
+        Log::info("Warning: Failed to create an APerformanceHint session\n");
+    else
+        Log::debug("Using APerformanceHint with a target of %.3f ms\n", target / 1000000.0);
+}
+
+/**
+ * Sets up the benchmarks.
+ *
+ * @param env the JNIEnv
+ * @param asset_manager the Java AssetManager of the data
+ * @param args the command line arguments, or 0 to read them from a file
+ * @param log_file the path of the file to also log to
+ * @param window the native window to render to, or 0 to render to the
+ *               current context and surface of GLSurfaceView
+ *
+ * @return whether the canvas was initialized successfully
+ */
+static bool
+init_benchmarks(JNIEnv* env, jobject asset_manager, jstring args, jstring log_file,
+                ANativeWindow *window)
 {
-    static_cast<void>(clazz);
     static const std::string arguments_file("/data/glmark2/args");
     int argc = 0;
     char **argv = 0;
@@ -294,8 +565,15 @@ Java_org_linaro_glmark2_native_init(JNIEnv* env, jclass clazz,
     Log::init("glmark2", Options::show_debug, g_log_extra);
     Util::android_set_asset_manager(AAssetManager_fromJava(env, asset_manager));
 
-    g_canvas = new CanvasAndroid(100, 100);
-    g_canvas->init();
+    g_ndk.load();
+    if (g_ndk.AThermal_acquireManager)
+        g_thermal_manager = g_ndk.AThermal_acquireManager();
+
+    g_canvas = new CanvasAndroid(100, 100, window);
+    if (!g_canvas->init() && window) {
+        Log::error("Failed to initialize the canvas for the native window\n");
+        return false;
+    }
 
     Log::info("glmark2 %s\n", GLMARK_VERSION);
     g_canvas->print_info();
@@ -315,6 +593,19 @@ Java_org_linaro_glmark2_native_init(JNIEnv* env, jclass clazz,
         g_loop = new MainLoopAndroid(*g_canvas,
                                      g_benchmark_collection->benchmarks());
     }
+
+    return true;
+}
+
+void
+Java_org_linaro_glmark2_native_init(JNIEnv* env, jclass clazz,
+                                    jobject asset_manager,
+                                    jstring args,
+                                    jstring log_file)
+{
+    static_cast<void>(clazz);
+
+    init_benchmarks(env, asset_manager, args, log_file, 0);
 }
 
 void
@@ -340,6 +631,11 @@ Java_org_linaro_glmark2_native_done(JNIEnv* env)
     delete g_scene_collection;
     delete g_canvas;
     delete g_log_extra;
+
+    if (g_thermal_manager) {
+        g_ndk.AThermal_releaseManager(g_thermal_manager);
+        g_thermal_manager = 0;
+    }
 }
 
 jboolean
@@ -347,12 +643,49 @@ Java_org_linaro_glmark2_native_render(JNIEnv* env)
 {
     static_cast<void>(env);
 
-    if (!g_loop->step()) {
-        Log::info("glmark2 Score: %u\n", g_loop->score());
-        return false;
+    return render_frame();
+}
+
+void
+Java_org_linaro_glmark2_native_runNativeLoop(JNIEnv* env, jclass clazz,
+                                             jobject surface,
+                                             jobject asset_manager,
+                                             jstring args,
+                                             jstring log_file)
+{
+    static_cast<void>(clazz);
+
+    ANativeWindow *window = ANativeWindow_fromSurface(env, surface);
+    if (!window)
+        return;
+
+    NativeLoop loop;
+
+    if (init_benchmarks(env, asset_manager, args, log_file, window)) {
+        {
+            std::lock_guard<std::mutex> lock(g_native_loop_mutex);
+            g_native_loop = &loop;
+        }
+
+        loop.run();
+
+        std::lock_guard<std::mutex> lock(g_native_loop_mutex);
+        g_native_loop = 0;
     }
 
-    return true;
+    Java_org_linaro_glmark2_native_done(env);
+    ANativeWindow_release(window);
+}
+
+void
+Java_org_linaro_glmark2_native_stopNativeLoop(JNIEnv* env, jclass clazz)
+{
+    static_cast<void>(env);
+    static_cast<void>(clazz);
+
+    std::lock_guard<std::mutex> lock(g_native_loop_mutex);
+    if (g_native_loop)
+        g_native_loop->stop();
 }
 
 jint
@@ -424,6 +757,16 @@ static JNINativeMethod glmark2_native_methods[] = {
         "()Z",
         reinterpret_cast<void*>(Java_org_linaro_glmark2_native_render)
     },
+    {
+        "runNativeLoop",
+        "(Landroid/view/Surface;Landroid/content/res/AssetManager;Ljava/lang/String;Ljava/lang/String;)V",
+        reinterpret_cast<void*>(Java_org_linaro_glmark2_native_runNativeLoop)
+    },
+    {
+        "stopNativeLoop",
+        "()V",
+        reinterpret_cast<void*>(Java_org_linaro_glmark2_native_stopNativeLoop)
+    },
     {
         "scoreConfig",
         "(Lorg/linaro/glmark2/GLVisualConfig;Lorg/linaro/glmark2/GLVisualConfig;)I",
@@ -26,6 +26,84 @@
 #include "log.h"
 #include "util.h"
 
+namespace
+{
+
+/* How deeply benchmark files can include each other */
+const unsigned int max_include_depth = 16;
+
+std::string
+trim(const std::string &str)
+{
+    static const char *space = " \t\r";
+    size_t start = str.find_first_not_of(space);
+
+    if (start == std::string::npos)
+        return "";
+
+    return str.substr(start, str.find_last_not_of(space) - start + 1);
+}
+
+/*
+ * Expands a matrix line like "shading:shading=gouraud,phong x model=horse,bunny"
+ * into the descriptions of all the combinations of the values of its
+ * options.
+ */
+std::vector<std::string>
+expand_matrix(const std::string &line)
+{
+    std::vector<std::string> groups;
+    std::string scene;
+    std::vector<std::pair<std::string, std::vector<std::string> > > options;
+    size_t start = 0;
+    size_t end;
+
+    while ((end = line.find(" x ", start)) != std::string::npos) {
+        groups.push_back(trim(line.substr(start, end - start)));
+        start = end + 3;
+    }
+    groups.push_back(trim(line.substr(start)));
+
+    for (size_t g = 0; g < groups.size(); g++) {
+        std::vector<std::string> elems;
+        Util::split(groups[g], ':', elems, Util::SplitModeNormal);
+
+        for (size_t i = 0; i < elems.size(); i++) {
+            size_t eq = elems[i].find('=');
+            /* The first element of the first group is the scene */
+            if (g == 0 && i == 0 && eq == std::string::npos) {
+                scene = elems[i];
+                continue;
+            }
+            if (eq == std::string::npos || eq == 0) {
+                Log::info("Warning: ignoring invalid option string '%s' "
+                          "in benchmark description\n", elems[i].c_str());
+                continue;
+            }
+
+            std::vector<std::string> values;
+            Util::split(elems[i].substr(eq + 1), ',', values, Util::SplitModeNormal);
+            options.push_back(std::make_pair(elems[i].substr(0, eq), values));
+        }
+    }
+
+    std::vector<std::string> descriptions(1, scene);
+    for (size_t i = 0; i < options.size(); i++) {
+        std::vector<std::string> expanded;
+        for (size_t d = 0; d < descriptions.size(); d++) {
+            for (size_t v = 0; v < options[i].second.size(); v++) {
+                expanded.push_back(descriptions[d] + ":" + options[i].first + "=" +
+                                   options[i].second[v]);
+            }
+        }
+        descriptions.swap(expanded);
+    }
+
+    return descriptions;
+}
+
+}
+
 BenchmarkCollection::~BenchmarkCollection()
 {
     Util::dispose_pointer_vector(benchmarks_);
@@ -38,8 +116,50 @@ BenchmarkCollection::add(const std::vector<std::string> &benchmarks)
          iter != benchmarks.end();
          iter++)
     {
-        benchmarks_.push_back(new Benchmark(*iter));
+        add_swept(new Benchmark(*iter));
+    }
+}
+
+/*
+ * Adds a benchmark, or one benchmark for each value of the first option
+ * it sets to "sweep", if the scene has sweep values for that option.
+ * Further swept options are expanded recursively.
+ */
+void
+BenchmarkCollection::add_swept(Benchmark *bench)
+{
+    const std::vector<Benchmark::OptionPair> &options(bench->options());
+    const std::map<std::string, Scene::Option> &scene_options(bench->scene().options());
+
+    for (std::vector<Benchmark::OptionPair>::const_iterator iter = options.begin();
+         iter != options.end();
+         iter++)
+    {
+        if (iter->second != "sweep")
+            continue;
+
+        std::map<std::string, Scene::Option>::const_iterator opt_iter =
+            scene_options.find(iter->first);
+        if (opt_iter == scene_options.end() || opt_iter->second.sweep_values.empty())
+            continue;
+
+        const std::vector<std::string> &values(opt_iter->second.sweep_values);
+        for (std::vector<std::string>::const_iterator value_iter = values.begin();
+             value_iter != values.end();
+             value_iter++)
+        {
+            std::vector<Benchmark::OptionPair> swept(options);
+            swept[iter - options.begin()].second = *value_iter;
+            Benchmark *swept_bench = new Benchmark(bench->scene(), swept);
+            swept_bench->repeat(bench->repeat());
+            add_swept(swept_bench);
+        }
+
+        delete bench;
+        return;
     }
+
+    benchmarks_.push_back(bench);
 }
 
 void
@@ -76,6 +196,38 @@ BenchmarkCollection::needs_decoration()
     return false;
 }
 
+std::vector<std::string>
+BenchmarkCollection::textures()
+{
+    std::vector<std::string> names;
+
+    for (std::vector<Benchmark *>::const_iterator bench_iter = benchmarks_.begin();
+         bench_iter != benchmarks_.end();
+         bench_iter++)
+    {
+        std::vector<std::string> bench_names((*bench_iter)->textures());
+        names.insert(names.end(), bench_names.begin(), bench_names.end());
+    }
+
+    return names;
+}
+
+std::vector<Scene::ProgramVariant>
+BenchmarkCollection::programs()
+{
+    std::vector<Scene::ProgramVariant> variants;
+
+    for (std::vector<Benchmark *>::const_iterator bench_iter = benchmarks_.begin();
+         bench_iter != benchmarks_.end();
+         bench_iter++)
+    {
+        std::vector<Scene::ProgramVariant> bench_variants((*bench_iter)->programs());
+        variants.insert(variants.end(), bench_variants.begin(), bench_variants.end());
+    }
+
+    return variants;
+}
+
 
 void
 BenchmarkCollection::add_benchmarks_from_files()
@@ -84,22 +236,109 @@ BenchmarkCollection::add_benchmarks_from_files()
          iter != Options::benchmark_files.end();
          iter++)
     {
-        std::ifstream ifs(iter->c_str());
+        add_benchmarks_from_file(*iter, 0);
+    }
+}
 
-        if (!ifs.fail()) {
-            std::string line;
+/*
+ * Adds the benchmarks of a file, which has one benchmark description per
+ * line, and may also have:
+ *
+ *   # comments
+ *   include other-file          (relative to the directory of this file)
+ *   [section]                   (starts a section, resetting the settings below)
+ *   set opt1=val1:opt2=val2     (options of the next benchmarks of the section)
+ *   repeat N                    (runs of the next benchmarks of the section)
+ *   scene:opt1=a,b x opt2=c,d   (a benchmark for each combination of values)
+ */
+bool
+BenchmarkCollection::add_benchmarks_from_file(const std::string &filename,
+                                              unsigned int depth)
+{
+    std::ifstream ifs(filename.c_str());
+
+    if (ifs.fail()) {
+        Log::error("Cannot open benchmark file %s\n", filename.c_str());
+        return false;
+    }
+
+    std::string dir;
+    size_t slash = filename.rfind('/');
+    if (slash != std::string::npos)
+        dir = filename.substr(0, slash + 1);
+
+    std::string section_options;
+    unsigned int section_repeat = 0;
+    std::string line;
+    unsigned int line_number = 0;
+
+    while (getline(ifs, line)) {
+        line_number++;
+        line = trim(line);
+
+        /* A '#' only starts a comment at the start of a line, e.g. title=#info# */
+        if (line.empty() || line[0] == '#')
+            continue;
 
-            while (getline(ifs, line)) {
-                if (!line.empty())
-                    benchmarks_.push_back(new Benchmark(line));
+        if (line[0] == '[') {
+            if (line[line.size() - 1] != ']') {
+                Log::info("Warning: ignoring invalid section '%s' in %s:%u\n",
+                          line.c_str(), filename.c_str(), line_number);
             }
+            section_options.clear();
+            section_repeat = 0;
+            continue;
         }
-        else {
-            Log::error("Cannot open benchmark file %s\n",
-                       iter->c_str());
+
+        std::string keyword(line.substr(0, line.find_first_of(" \t")));
+        std::string arg(trim(line.substr(keyword.size())));
+
+        if (keyword == "include" && !arg.empty()) {
+            if (depth + 1 >= max_include_depth) {
+                Log::error("Too many nested includes of benchmark files in %s:%u\n",
+                           filename.c_str(), line_number);
+                return false;
+            }
+            std::string path(arg[0] == '/' ? arg : dir + arg);
+            if (!add_benchmarks_from_file(path, depth + 1))
+                return false;
+            continue;
+        }
+        else if (keyword == "set" && !arg.empty()) {
+            section_options = arg;
+            continue;
+        }
+        else if (keyword == "repeat" && !arg.empty()) {
+            section_repeat = Util::fromString<unsigned int>(arg);
+            continue;
         }
 
+        std::vector<std::string> descriptions;
+        if (line.find(" x ") != std::string::npos)
+            descriptions = expand_matrix(line);
+        else
+            descriptions.push_back(line);
+
+        for (std::vector<std::string>::const_iterator iter = descriptions.begin();
+             iter != descriptions.end();
+             iter++)
+        {
+            /* The options of the benchmark override those of the section */
+            std::string description(*iter);
+            if (!section_options.empty()) {
+                size_t colon = description.find(':');
+                std::string scene(description.substr(0, colon));
+                description = scene + ":" + section_options +
+                              (colon != std::string::npos ? description.substr(colon) : "");
+            }
+
+            Benchmark *bench = new Benchmark(description);
+            bench->repeat(section_repeat);
+            add_swept(bench);
+        }
     }
+
+    return true;
 }
 
 bool
@@ -47,10 +47,24 @@ public:
      */
     bool needs_decoration();
 
+    /*
+     * Gets the textures the benchmarks in this collection will load, in
+     * the order they will be loaded.
+     */
+    std::vector<std::string> textures();
+
+    /*
+     * Gets the program variants the benchmarks in this collection will
+     * build.
+     */
+    std::vector<Scene::ProgramVariant> programs();
+
     const std::vector<Benchmark *>& benchmarks() { return benchmarks_; }
 
 private:
+    void add_swept(Benchmark *bench);
     void add_benchmarks_from_files();
+    bool add_benchmarks_from_file(const std::string &filename, unsigned int depth);
     bool benchmarks_contain_normal_scenes();
 
     std::vector<Benchmark *> benchmarks_;
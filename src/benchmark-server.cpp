@@ -0,0 +1,259 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "benchmark-server.h"
+#include "benchmark-collection.h"
+#include "main-loop.h"
+#include "results-file.h"
+#include "texture.h"
+#include "log.h"
+#include "util.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#if !defined(_WIN32)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+BenchmarkServer::BenchmarkServer(Canvas &canvas) :
+    canvas_(canvas), socket_(-1)
+{
+}
+
+BenchmarkServer::~BenchmarkServer()
+{
+#if !defined(_WIN32)
+    if (socket_ >= 0)
+        close(socket_);
+    if (!unix_path_.empty())
+        unlink(unix_path_.c_str());
+#endif
+}
+
+bool
+BenchmarkServer::run(const std::string &address)
+{
+#if !defined(_WIN32)
+    if (!listen(address))
+        return false;
+
+    /* A client going away must not kill the server */
+    signal(SIGPIPE, SIG_IGN);
+
+    Log::info("Serving benchmarks on %s\n", address.c_str());
+
+    bool quit = false;
+    while (!quit && !canvas_.should_quit()) {
+        int fd = accept(socket_, 0, 0);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+            Log::error("Failed to accept a client: %s\n", strerror(errno));
+            return false;
+        }
+
+        quit = !serve_client(fd);
+        close(fd);
+    }
+
+    return true;
+#else
+    static_cast<void>(address);
+    Log::error("--serve is not supported on this platform\n");
+    return false;
+#endif
+}
+
+#if !defined(_WIN32)
+
+bool
+BenchmarkServer::listen(const std::string &address)
+{
+    socket_ = listen_socket(address, unix_path_);
+
+    return socket_ >= 0;
+}
+
+int
+BenchmarkServer::listen_socket(const std::string &address, std::string &unix_path)
+{
+    static const std::string tcp_prefix("tcp:");
+    int fd = -1;
+
+    if (address.compare(0, tcp_prefix.size(), tcp_prefix) == 0) {
+        std::string host("127.0.0.1");
+        std::string port(address.substr(tcp_prefix.size()));
+        size_t colon = port.rfind(':');
+        if (colon != std::string::npos) {
+            host = port.substr(0, colon);
+            port = port.substr(colon + 1);
+        }
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(Util::fromString<unsigned short>(port));
+        if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+            Log::error("Invalid socket address %s\n", address.c_str());
+            return -1;
+        }
+
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (fd >= 0)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (fd < 0 ||
+            bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            Log::error("Failed to listen on %s: %s\n", address.c_str(), strerror(errno));
+            if (fd >= 0)
+                close(fd);
+            return -1;
+        }
+    }
+    else {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (address.empty() || address.size() >= sizeof(addr.sun_path)) {
+            Log::error("Invalid socket path %s\n", address.c_str());
+            return -1;
+        }
+        strncpy(addr.sun_path, address.c_str(), sizeof(addr.sun_path) - 1);
+
+        /* Replace the socket of a previous server */
+        unlink(address.c_str());
+
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 ||
+            bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            Log::error("Failed to listen on %s: %s\n", address.c_str(), strerror(errno));
+            if (fd >= 0)
+                close(fd);
+            return -1;
+        }
+        unix_path = address;
+    }
+
+    if (::listen(fd, 1) != 0) {
+        Log::error("Failed to listen on %s: %s\n", address.c_str(), strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+ * Runs the benchmarks a client sends, until it disconnects.
+ *
+ * @return false if the client asked the server to quit
+ */
+bool
+BenchmarkServer::serve_client(int fd)
+{
+    std::string pending;
+    char buf[4096];
+    ssize_t n;
+
+    while ((n = read(fd, buf, sizeof(buf))) != 0) {
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        pending.append(buf, n);
+
+        size_t newline;
+        while ((newline = pending.find('\n')) != std::string::npos) {
+            std::string line(pending.substr(0, newline));
+            pending.erase(0, newline + 1);
+
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.erase(line.size() - 1);
+            if (line.empty() || line[0] == '#')
+                continue;
+
+            if (line == "quit") {
+                send(fd, "{\"done\": \"quit\"}\n");
+                return false;
+            }
+
+            run_benchmark(fd, line);
+        }
+    }
+
+    return true;
+}
+
+bool
+BenchmarkServer::send(int fd, const std::string &data)
+{
+    size_t written = 0;
+
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.c_str() + written, data.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        written += n;
+    }
+
+    return true;
+}
+
+void
+BenchmarkServer::run_benchmark(int fd, const std::string &description)
+{
+    BenchmarkCollection benchmark_collection;
+
+    benchmark_collection.add(std::vector<std::string>(1, description));
+
+    Texture::prefetch(benchmark_collection.textures());
+
+    MainLoop loop(canvas_, benchmark_collection.benchmarks());
+    size_t sent = 0;
+
+    /* Stream the result of each run as soon as it ends */
+    while (loop.step()) {
+        for (; sent < loop.results().size(); sent++) {
+            std::stringstream ss;
+            ResultsFile::write_json_line(ss, loop.results()[sent]);
+            send(fd, ss.str());
+        }
+    }
+
+    std::stringstream ss;
+    for (; sent < loop.results().size(); sent++)
+        ResultsFile::write_json_line(ss, loop.results()[sent]);
+    ss << "{\"done\": " << (loop.results().empty() ? "\"no benchmarks\"" : "\"ok\"")
+       << ", \"score\": " << loop.score() << "}" << std::endl;
+    send(fd, ss.str());
+}
+
+#endif
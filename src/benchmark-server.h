@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_BENCHMARK_SERVER_H_
+#define GLMARK2_BENCHMARK_SERVER_H_
+
+#include "canvas.h"
+
+#include <string>
+
+/**
+ * Runs the benchmarks requested by clients over a socket (--serve), keeping
+ * the canvas, the GL context and the caches alive between the requests.
+ *
+ * The clients connect one at a time and send benchmark descriptions, one
+ * per line, in the syntax of --benchmark. Each line is run as soon as it is
+ * received, and the result of each benchmark run is sent back as a JSON
+ * object on a single line, followed by a {"done": ...} line with the score
+ * of the request. A "quit" line stops the server.
+ */
+class BenchmarkServer
+{
+public:
+    BenchmarkServer(Canvas &canvas);
+    ~BenchmarkServer();
+
+    /**
+     * Serves the clients until one of them asks to quit.
+     *
+     * @param address the path of a Unix socket, or "tcp:[ADDRESS:]PORT"
+     *        for a TCP socket, listening on 127.0.0.1 by default
+     *
+     * @return whether the server could listen on the address
+     */
+    bool run(const std::string &address);
+
+    /**
+     * Creates a socket listening on an address, in the syntax of --serve.
+     *
+     * @param address the path of a Unix socket, or "tcp:[ADDRESS:]PORT"
+     * @param unix_path set to the path of the Unix socket, to unlink it
+     *        when done
+     *
+     * @return the socket, or -1 on failure
+     */
+    static int listen_socket(const std::string &address, std::string &unix_path);
+
+private:
+    bool listen(const std::string &address);
+    bool serve_client(int fd);
+    bool send(int fd, const std::string &data);
+    void run_benchmark(int fd, const std::string &description);
+
+    Canvas &canvas_;
+    int socket_;
+    std::string unix_path_;
+};
+
+#endif
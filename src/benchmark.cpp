@@ -23,12 +23,15 @@
 #include "benchmark.h"
 #include "log.h"
 #include "util.h"
+#include "startup-report.h"
+#include "trace.h"
 
 using std::string;
 using std::vector;
 using std::map;
 
 std::map<string, Scene *> Benchmark::sceneMap_;
+std::map<string, Benchmark::SceneFactory> Benchmark::sceneFactories_;
 
 static Scene &
 get_scene_from_description(const string &s)
@@ -74,6 +77,12 @@ Benchmark::register_scene(Scene &scene)
     sceneMap_[scene.name()] = &scene;
 }
 
+void
+Benchmark::register_scene_factory(const string &name, const SceneFactory &factory)
+{
+    sceneFactories_[name] = factory;
+}
+
 Scene &
 Benchmark::get_scene_by_name(const string &name)
 {
@@ -81,34 +90,48 @@ Benchmark::get_scene_by_name(const string &name)
 
     if ((iter = sceneMap_.find(name)) != sceneMap_.end())
         return *(iter->second);
+
+    /* Create the scene the first time it is used */
+    map<string, SceneFactory>::const_iterator factory_iter = sceneFactories_.find(name);
+    if (factory_iter != sceneFactories_.end())
+        return *(factory_iter->second());
     else
         return Scene::dummy();
 }
 
 Benchmark::Benchmark(Scene &scene, const vector<OptionPair> &options) :
-    scene_(scene), options_(options)
+    scene_(scene), options_(options), repeat_(0)
 {
 }
 
 Benchmark::Benchmark(const string &name, const vector<OptionPair> &options) :
-    scene_(Benchmark::get_scene_by_name(name)), options_(options)
+    scene_(Benchmark::get_scene_by_name(name)), options_(options), repeat_(0)
 {
 }
 
 Benchmark::Benchmark(const string &s) :
     scene_(get_scene_from_description(s)),
-    options_(get_options_from_description(s))
+    options_(get_options_from_description(s)), repeat_(0)
 {
 }
 
 Scene &
 Benchmark::setup_scene()
 {
+    Trace::Scope trace("benchmark-setup", scene_.name() + ":" + options_string());
+
     scene_.reset_options();
     load_options();
 
-    scene_.load();
-    scene_.setup();
+    {
+        StartupReport::Phase phase("scene-load");
+        scene_.load();
+    }
+
+    {
+        StartupReport::Phase phase("scene-setup");
+        scene_.setup();
+    }
 
     return scene_;
 }
@@ -116,10 +139,72 @@ Benchmark::setup_scene()
 void
 Benchmark::teardown_scene()
 {
+    Trace::Scope trace("benchmark-teardown", scene_.name());
+
     scene_.teardown();
     scene_.unload();
 }
 
+std::string
+Benchmark::options_string() const
+{
+    std::string str;
+
+    for (vector<OptionPair>::const_iterator iter = options_.begin();
+         iter != options_.end();
+         iter++)
+    {
+        if (!str.empty())
+            str += ":";
+        str += iter->first + "=" + iter->second;
+    }
+
+    return str;
+}
+
+vector<string>
+Benchmark::textures()
+{
+    /*
+     * The special default options scene records the options it is given
+     * and has no textures, so leave it alone.
+     */
+    if (scene_.name().empty())
+        return vector<string>();
+
+    scene_.reset_options();
+
+    /* Invalid options are reported when the benchmark is actually run */
+    for (vector<OptionPair>::iterator iter = options_.begin();
+         iter != options_.end();
+         iter++)
+    {
+        scene_.set_option(iter->first, iter->second);
+    }
+
+    return scene_.textures();
+}
+
+vector<Scene::ProgramVariant>
+Benchmark::programs()
+{
+    if (scene_.name().empty())
+        return vector<Scene::ProgramVariant>();
+
+    scene_.reset_options();
+
+    for (vector<OptionPair>::iterator iter = options_.begin();
+         iter != options_.end();
+         iter++)
+    {
+        scene_.set_option(iter->first, iter->second);
+    }
+
+    scene_.set_default_precisions();
+
+    return scene_.programs();
+}
+
 bool
 Benchmark::needs_decoration() const
 {
@@ -128,6 +213,7 @@ Benchmark::needs_decoration() const
          iter++)
     {
         if ((iter->first == "show-fps" && iter->second == "true") ||
+            (iter->first == "show-graph" && iter->second == "true") ||
             (iter->first == "title" && !iter->second.empty()))
         {
             return true;
@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <functional>
 
 #include "scene.h"
 
@@ -37,6 +38,7 @@ class Benchmark
 {
 public:
     typedef std::pair<std::string, std::string> OptionPair;
+    typedef std::function<Scene *()> SceneFactory;
 
     /**
      * Creates a benchmark using a scene object reference.
@@ -78,6 +80,28 @@ public:
      */
     Scene &scene() const { return scene_; }
 
+    /**
+     * Gets the options of the benchmark, in the order they are set.
+     *
+     * @return the options
+     */
+    const std::vector<OptionPair> &options() const { return options_; }
+
+    /**
+     * Gets how many times the benchmark is run.
+     *
+     * @return the number of runs, 0 to use --repeat
+     */
+    unsigned int repeat() const { return repeat_; }
+
+    /**
+     * Sets how many times the benchmark is run, e.g. from the repeat
+     * setting of a benchmark file section.
+     *
+     * @param repeat the number of runs, 0 to use --repeat
+     */
+    void repeat(unsigned int repeat) { repeat_ = repeat; }
+
     /**
      * Sets up the Scene associated with the benchmark.
      *
@@ -90,6 +114,33 @@ public:
      */
     void teardown_scene();
 
+    /**
+     * Gets the options of the benchmark as a description string.
+     *
+     * @return the options in the form opt1=val1:opt2=val2...
+     */
+    std::string options_string() const;
+
+    /**
+     * Gets the textures the benchmark will load.
+     *
+     * This changes the options of the Scene, which are reset when the
+     * scene is set up for a run.
+     *
+     * @return the texture names (see Scene::textures())
+     */
+    std::vector<std::string> textures();
+
+    /**
+     * Gets the program variants the benchmark will build.
+     *
+     * Like ::textures(), this changes the options of the Scene, and also
+     * the default shader precisions.
+     *
+     * @return the program variants (see Scene::programs())
+     */
+    std::vector<Scene::ProgramVariant> programs();
+
     /**
      * Whether the benchmark needs extra decoration.
      */
@@ -100,6 +151,19 @@ public:
      */
     static void register_scene(Scene &scene);
 
+    /**
+     * Registers a function creating a Scene, so that the scene is created
+     * when it is first looked up by name.
+     *
+     * The factory must register the scene it creates using
+     * ::register_scene().
+     *
+     * @param name the name of the scene
+     * @param factory the function creating the scene
+     */
+    static void register_scene_factory(const std::string &name,
+                                       const SceneFactory &factory);
+
     /**
      * Gets a registered scene by its name.
      *
@@ -108,7 +172,7 @@ public:
     static Scene &get_scene_by_name(const std::string &name);
 
     /**
-     * Gets the registered scenes.
+     * Gets the registered scenes that have been created.
      *
      * @return the Scene
      */
@@ -117,10 +181,12 @@ public:
 private:
     Scene &scene_;
     std::vector<OptionPair> options_;
+    unsigned int repeat_;
 
     void load_options();
 
     static std::map<std::string, Scene *> sceneMap_;
+    static std::map<std::string, SceneFactory> sceneFactories_;
 };
 
 #endif
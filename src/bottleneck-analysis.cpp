@@ -0,0 +1,213 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bottleneck-analysis.h"
+#include "main-loop.h"
+#include "options.h"
+#include "log.h"
+#include "util.h"
+
+#include <cstdio>
+
+namespace
+{
+
+/* The duration of each probe run, in seconds */
+const char *probe_duration = "2.0";
+
+/*
+ * How much faster a probe must be to show a bottleneck. Halving both sides
+ * of the frame is a 4x drop in pixels, so only a large speedup means the
+ * benchmark is limited by its pixels.
+ */
+const double pixel_speedup = 1.6;
+const double precision_speedup = 1.15;
+const double present_speedup = 1.25;
+/* The fraction of the frame time the GPU must be busy to be the bottleneck */
+const double gpu_busy = 0.6;
+
+std::string
+ratio_str(const char *name, double base, double probe)
+{
+    char buf[64];
+
+    if (base <= 0.0 || probe <= 0.0)
+        snprintf(buf, sizeof(buf), "%s: -", name);
+    else
+        snprintf(buf, sizeof(buf), "%s: %.2fx", name, base / probe);
+
+    return buf;
+}
+
+}
+
+BottleneckAnalysis::BottleneckAnalysis(Canvas &canvas,
+                                       const std::vector<Benchmark *> &benchmarks) :
+    canvas_(canvas), benchmarks_(benchmarks)
+{
+}
+
+void
+BottleneckAnalysis::run()
+{
+    std::vector<std::string> lines;
+    bool saved_gpu_timing = Options::gpu_timing;
+
+    /* The GPU time tells the GPU-bound benchmarks from the CPU-bound ones */
+    Options::gpu_timing = true;
+
+    for (std::vector<Benchmark *>::const_iterator iter = benchmarks_.begin();
+         iter != benchmarks_.end() && !canvas_.should_quit();
+         iter++)
+    {
+        Benchmark &bench(**iter);
+        Probe unused;
+
+        /* The benchmarks setting the default options are run once, to set them */
+        if (bench.scene().name().empty()) {
+            probe(bench, std::vector<Benchmark::OptionPair>(), Options::frame_end, false, unused);
+            continue;
+        }
+
+        std::string options(bench.options_string());
+        lines.push_back("[" + bench.scene().name() + "] " +
+                        (options.empty() ? "<default>" : options) + ": " +
+                        classify(bench));
+    }
+
+    Options::gpu_timing = saved_gpu_timing;
+
+    Log::info("=======================================================\n");
+    Log::info("    Bottleneck analysis (speedup of the probes)\n");
+    for (size_t i = 0; i < lines.size(); i++)
+        Log::info("%s\n", lines[i].c_str());
+    Log::info("=======================================================\n");
+}
+
+/*
+ * Runs a benchmark for a short time with extra options, a frame end
+ * method and optionally a quarter of the pixels.
+ */
+bool
+BottleneckAnalysis::probe(Benchmark &bench,
+                          const std::vector<Benchmark::OptionPair> &options,
+                          Options::FrameEnd frame_end, bool quarter_size, Probe &result)
+{
+    std::vector<Benchmark::OptionPair> probe_options(bench.options());
+    if (!bench.scene().name().empty())
+        probe_options.push_back(Benchmark::OptionPair("duration", probe_duration));
+    probe_options.insert(probe_options.end(), options.begin(), options.end());
+
+    Benchmark probe_bench(bench.scene(), probe_options);
+    std::vector<Benchmark *> probe_benchmarks(1, &probe_bench);
+
+    int width = canvas_.width();
+    int height = canvas_.height();
+    Options::FrameEnd saved_frame_end = Options::frame_end;
+    unsigned int saved_repeat = Options::repeat;
+
+    Options::frame_end = frame_end;
+    Options::repeat = 1;
+    if (quarter_size)
+        canvas_.resize(width / 2, height / 2);
+
+    MainLoop loop(canvas_, probe_benchmarks);
+    while (loop.step());
+
+    if (quarter_size)
+        canvas_.resize(width, height);
+    Options::frame_end = saved_frame_end;
+    Options::repeat = saved_repeat;
+
+    if (loop.results().empty() ||
+        loop.results().front().status != BenchmarkResult::StatusSuccess)
+    {
+        return false;
+    }
+
+    const BenchmarkResult &r(loop.results().front());
+    result.frame_time = r.frame_time.mean;
+    result.gpu_time = r.gpu_time.count > 0 ? r.gpu_time.mean : 0.0;
+
+    return result.frame_time > 0.0;
+}
+
+std::string
+BottleneckAnalysis::classify(Benchmark &bench)
+{
+    std::vector<Benchmark::OptionPair> none;
+    Probe base;
+    Probe finish;
+    Probe no_sync;
+    Probe small;
+    Probe lowp;
+
+    if (!probe(bench, none, Options::frame_end, false, base) ||
+        !probe(bench, none, Options::FrameEndFinish, false, finish))
+    {
+        return "failed to run";
+    }
+
+    probe(bench, none, Options::FrameEndNone, false, no_sync);
+
+    /*
+     * Off-screen, the canvas is resized to a quarter of the pixels.
+     * On-screen, where resizing would recreate the window, only the
+     * center quarter of the frame is redrawn instead.
+     */
+    if (Options::offscreen) {
+        probe(bench, none, Options::FrameEndFinish, true, small);
+    }
+    else {
+        std::vector<Benchmark::OptionPair> damage(
+            1, Benchmark::OptionPair("damage-fraction", "0.25"));
+        probe(bench, damage, Options::FrameEndFinish, false, small);
+    }
+
+    std::vector<Benchmark::OptionPair> precision(
+        1, Benchmark::OptionPair("fragment-precision", "low,low,low,low"));
+    probe(bench, precision, Options::FrameEndFinish, false, lowp);
+
+    std::string bottleneck;
+    double pixels = small.frame_time > 0.0 ? finish.frame_time / small.frame_time : 1.0;
+    double precision_ratio = lowp.frame_time > 0.0 ? finish.frame_time / lowp.frame_time : 1.0;
+
+    if (base.frame_time > present_speedup * finish.frame_time)
+        bottleneck = "present-bound";
+    else if (finish.gpu_time > 0.0 && finish.gpu_time < gpu_busy * finish.frame_time)
+        bottleneck = "CPU/driver-bound";
+    else if (pixels >= pixel_speedup)
+        bottleneck = precision_ratio >= precision_speedup ? "fragment-bound" : "fill-bound";
+    else if (finish.gpu_time > 0.0)
+        bottleneck = "vertex-bound";
+    else
+        bottleneck = "vertex or CPU/driver-bound (use --gpu-timing to tell them apart)";
+
+    std::string details(ratio_str("finish", base.frame_time, finish.frame_time) + ", " +
+                        ratio_str("no-sync", finish.frame_time, no_sync.frame_time) + ", " +
+                        ratio_str("quarter-pixels", finish.frame_time, small.frame_time) + ", " +
+                        ratio_str("lowp", finish.frame_time, lowp.frame_time));
+    if (finish.gpu_time > 0.0) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), ", gpu-busy: %.0f%%",
+                 100.0 * finish.gpu_time / finish.frame_time);
+        details += buf;
+    }
+
+    return bottleneck + " (" + details + ")";
+}
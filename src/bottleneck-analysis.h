@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_BOTTLENECK_ANALYSIS_H_
+#define GLMARK2_BOTTLENECK_ANALYSIS_H_
+
+#include "canvas.h"
+#include "benchmark.h"
+#include "options.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Classifies what limits each benchmark (--bottleneck-analysis), from how
+ * its FPS responds to short probe runs with perturbations: a quarter of the
+ * pixels, low fragment precision, no frame synchronization and finishing
+ * each frame instead of presenting it.
+ */
+class BottleneckAnalysis
+{
+public:
+    BottleneckAnalysis(Canvas &canvas, const std::vector<Benchmark *> &benchmarks);
+
+    /**
+     * Runs the probes of all the benchmarks and logs their classification.
+     */
+    void run();
+
+private:
+    struct Probe
+    {
+        Probe() : frame_time(0.0), gpu_time(0.0) {}
+
+        /* The mean times of a frame in milliseconds, 0 if not measured */
+        double frame_time;
+        double gpu_time;
+    };
+
+    bool probe(Benchmark &bench, const std::vector<Benchmark::OptionPair> &options,
+               Options::FrameEnd frame_end, bool quarter_size, Probe &result);
+    std::string classify(Benchmark &bench);
+
+    Canvas &canvas_;
+    const std::vector<Benchmark *> &benchmarks_;
+};
+
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "burst-cycle.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+
+/* How much slower than the steady frame time a settled frame may be */
+const double settled_tolerance = 0.1;
+/* The frames in a row that must be settled */
+const unsigned int settled_frames = 3;
+
+}
+
+BurstCycle::BurstCycle() :
+    started_(false), in_burst_(false), burst_start_(0), last_frame_(0),
+    steady_ms_(0.0), ramp_frames_(0), unsettled_(0)
+{
+}
+
+bool
+BurstCycle::parse(const std::string &spec, Config &config)
+{
+    std::vector<std::string> elems;
+    Util::split(spec, ',', elems, Util::SplitModeNormal);
+
+    config = Config();
+
+    for (std::vector<std::string>::const_iterator iter = elems.begin();
+         iter != elems.end();
+         iter++)
+    {
+        std::vector<std::string> kv;
+        Util::split(*iter, ':', kv, Util::SplitModeNormal);
+
+        if (kv.size() != 2)
+            return false;
+
+        double ms = Util::fromString<double>(kv[1]);
+
+        if (kv[0] == "idle")
+            config.idle_ms = ms;
+        else if (kv[0] == "burst")
+            config.burst_ms = ms;
+        else
+            return false;
+    }
+
+    return config.idle_ms > 0.0 && config.burst_ms > 0.0;
+}
+
+void
+BurstCycle::start(const Config &config)
+{
+    config_ = config;
+    started_ = true;
+    in_burst_ = false;
+    frames_.clear();
+    bursts_.clear();
+    steady_ms_ = 0.0;
+    first_frame_.reset();
+    ramp_time_.reset();
+    ramp_frames_ = 0;
+    unsettled_ = 0;
+}
+
+bool
+BurstCycle::frame()
+{
+    if (!started())
+        return false;
+
+    /* The first burst waits for an idle period too */
+    if (!in_burst_)
+        return true;
+
+    uint64_t now = Util::get_timestamp_us();
+
+    frames_.push_back(now - last_frame_);
+    last_frame_ = now;
+
+    if (now - burst_start_ >= config_.burst_ms * 1000.0)
+        in_burst_ = false;
+
+    return !in_burst_;
+}
+
+void
+BurstCycle::idle()
+{
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(config_.idle_ms));
+
+    in_burst_ = true;
+    burst_start_ = Util::get_timestamp_us();
+    last_frame_ = burst_start_;
+    bursts_.push_back(frames_.size());
+}
+
+void
+BurstCycle::finish()
+{
+    if (!started())
+        return;
+
+    started_ = false;
+
+    /* Drop a burst without frames, if the scene ended right after its idle period */
+    if (!bursts_.empty() && bursts_.back() == frames_.size())
+        bursts_.pop_back();
+    if (bursts_.empty())
+        return;
+
+    std::vector<uint64_t> steady;
+
+    for (size_t i = 0; i < bursts_.size(); i++) {
+        size_t begin = bursts_[i];
+        size_t end = i + 1 < bursts_.size() ? bursts_[i + 1] : frames_.size();
+        steady.insert(steady.end(), frames_.begin() + (begin + end) / 2, frames_.begin() + end);
+    }
+
+    std::nth_element(steady.begin(), steady.begin() + steady.size() / 2, steady.end());
+    uint64_t steady_us = steady[steady.size() / 2];
+    uint64_t settled_us = static_cast<uint64_t>(steady_us * (1.0 + settled_tolerance));
+
+    steady_ms_ = steady_us / 1000.0;
+
+    for (size_t i = 0; i < bursts_.size(); i++) {
+        size_t begin = bursts_[i];
+        size_t end = i + 1 < bursts_.size() ? bursts_[i + 1] : frames_.size();
+        /* The frames settled in a row, and the time before them */
+        unsigned int run = 0;
+        uint64_t ramp_us = 0;
+        size_t frame = begin;
+
+        first_frame_.add(frames_[begin]);
+
+        for (; frame < end && run < settled_frames; frame++) {
+            if (frames_[frame] <= settled_us) {
+                run++;
+            }
+            else {
+                for (size_t j = frame - run; j <= frame; j++)
+                    ramp_us += frames_[j];
+                run = 0;
+            }
+        }
+
+        /* A burst ending while settling has settled, unless none of it has */
+        if (run == 0)
+            unsettled_++;
+
+        ramp_time_.add(ramp_us);
+        ramp_frames_ += frame - run - begin;
+    }
+}
+
+double
+BurstCycle::duty_cycle() const
+{
+    if (config_.burst_ms <= 0.0)
+        return 0.0;
+
+    return config_.burst_ms / (config_.idle_ms + config_.burst_ms);
+}
+
+double
+BurstCycle::ramp_frames() const
+{
+    return bursts() > 0 ? static_cast<double>(ramp_frames_) / bursts() : 0.0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_BURST_CYCLE_H_
+#define GLMARK2_BURST_CYCLE_H_
+
+#include "frame-stats.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Alternates idle periods and bursts of frames while a scene runs
+ * (--bursts), and measures how long the frames of each burst take to reach
+ * the steady state, which shows how quickly the clock governors of the GPU
+ * and CPU respond to a load starting after an idle period.
+ *
+ * The steady frame time is the median of the frames in the second halves
+ * of the bursts, and a burst has settled at the first frame from which a
+ * few frames in a row are no slower than it by more than a tolerance.
+ */
+class BurstCycle
+{
+public:
+    /**
+     * The durations of the idle periods and of the bursts, in ms.
+     */
+    struct Config {
+        Config() : idle_ms(0.0), burst_ms(0.0) {}
+
+        double idle_ms;
+        double burst_ms;
+    };
+
+    BurstCycle();
+
+    /**
+     * Parses a --bursts specification, e.g. 'idle:500,burst:250'.
+     *
+     * @return whether the specification is valid
+     */
+    static bool parse(const std::string &spec, Config &config);
+
+    /**
+     * Starts the bursts of a scene, with an idle period first.
+     */
+    void start(const Config &config);
+
+    /**
+     * Whether the bursts have been started.
+     */
+    bool started() const { return started_; }
+
+    /**
+     * Records the end of a frame.
+     *
+     * @return whether an idle period is due, before the next burst
+     */
+    bool frame();
+
+    /**
+     * Idles until the next burst starts.
+     */
+    void idle();
+
+    /**
+     * Stops the bursts and measures the ramps of the finished ones.
+     */
+    void finish();
+
+    /**
+     * Gets the number of bursts measured.
+     */
+    unsigned int bursts() const { return ramp_time_.count(); }
+
+    /**
+     * Gets the fraction of the time spent in bursts.
+     */
+    double duty_cycle() const;
+
+    /**
+     * Gets the steady frame time of the bursts, in ms.
+     */
+    double steady_ms() const { return steady_ms_; }
+
+    /**
+     * Gets the times of the first frames of the bursts.
+     */
+    const FrameStats &first_frame() const { return first_frame_; }
+
+    /**
+     * Gets the times from the start of the bursts to their first settled
+     * frame, or to their end if they didn't settle.
+     */
+    const FrameStats &ramp_time() const { return ramp_time_; }
+
+    /**
+     * Gets the mean number of frames before the bursts settled.
+     */
+    double ramp_frames() const;
+
+    /**
+     * Gets the number of bursts that never settled.
+     */
+    unsigned int unsettled() const { return unsettled_; }
+
+private:
+    Config config_;
+    bool started_;
+    bool in_burst_;
+    uint64_t burst_start_;
+    uint64_t last_frame_;
+    /* The frame times of the bursts, the first frame of each in bursts_ */
+    std::vector<uint64_t> frames_;
+    std::vector<size_t> bursts_;
+
+    double steady_ms_;
+    FrameStats first_frame_;
+    FrameStats ramp_time_;
+    uint64_t ramp_frames_;
+    unsigned int unsettled_;
+};
+
+#endif /* GLMARK2_BURST_CYCLE_H_ */
@@ -0,0 +1,214 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "call-profiler.h"
+#include "gl-headers.h"
+
+#include <chrono>
+
+namespace
+{
+
+const unsigned int max_entry_points = 64;
+
+struct ThreadCounters
+{
+    ThreadCounters()
+    {
+        for (unsigned int i = 0; i < max_entry_points; i++) {
+            calls[i] = 0;
+            nanoseconds[i] = 0;
+        }
+    }
+
+    uint64_t calls[max_entry_points];
+    uint64_t nanoseconds[max_entry_points];
+};
+
+/* Contexts are current on a single thread, so each thread has its counters */
+thread_local ThreadCounters counters;
+
+/* The names of the profiled entry points, by index */
+std::vector<std::string> names;
+
+bool profiler_active = false;
+
+/* Times a call, from its construction to its destruction */
+class CallTimer
+{
+public:
+    CallTimer(unsigned int index) :
+        index_(index), start_(std::chrono::steady_clock::now()) {}
+
+    ~CallTimer()
+    {
+        std::chrono::steady_clock::duration elapsed =
+            std::chrono::steady_clock::now() - start_;
+
+        counters.calls[index_]++;
+        counters.nanoseconds[index_] +=
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+
+private:
+    unsigned int index_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/*
+ * The profiled version of an entry point, with one instance for each
+ * wrapped entry point, told apart by the line they are wrapped on.
+ */
+template <unsigned int Line, typename T> struct Profiled;
+
+template <unsigned int Line, typename R, typename... Args>
+struct Profiled<Line, R (GLAD_API_PTR *)(Args...)>
+{
+    static R GLAD_API_PTR call(Args... args)
+    {
+        CallTimer timer(index);
+        return real(args...);
+    }
+
+    static R (GLAD_API_PTR *real)(Args...);
+    static unsigned int index;
+};
+
+template <unsigned int Line, typename R, typename... Args>
+R (GLAD_API_PTR *Profiled<Line, R (GLAD_API_PTR *)(Args...)>::real)(Args...) = 0;
+
+template <unsigned int Line, typename R, typename... Args>
+unsigned int Profiled<Line, R (GLAD_API_PTR *)(Args...)>::index = ~0U;
+
+/* Replaces an entry point by its profiled version, unless already done */
+template <unsigned int Line, typename T> void
+wrap(T &entry_point, const char *name)
+{
+    typedef Profiled<Line, T> P;
+
+    if (P::index == ~0U && names.size() < max_entry_points) {
+        P::index = names.size();
+        names.push_back(name);
+    }
+
+    if (P::index != ~0U && entry_point && entry_point != &P::call) {
+        P::real = entry_point;
+        entry_point = &P::call;
+    }
+}
+
+}
+
+#define PROFILE(entry_point) wrap<__LINE__>(glad_##entry_point, #entry_point)
+#define PROFILE_EXTENSION(entry_point) \
+    wrap<__LINE__>(GLExtensions::entry_point, "gl" #entry_point)
+
+void
+CallProfiler::install(bool enable)
+{
+    profiler_active = enable;
+    if (!enable)
+        return;
+
+    /* Draws */
+    PROFILE(glDrawArrays);
+    PROFILE(glDrawElements);
+    PROFILE_EXTENSION(DrawArraysInstanced);
+    PROFILE_EXTENSION(DrawElementsInstanced);
+    PROFILE(glClear);
+
+    /* Uniforms and vertex attributes */
+    PROFILE(glUniform1f);
+    PROFILE(glUniform1i);
+    PROFILE(glUniform2f);
+    PROFILE(glUniform2fv);
+    PROFILE(glUniform3f);
+    PROFILE(glUniform3fv);
+    PROFILE(glUniform4f);
+    PROFILE(glUniform4fv);
+    PROFILE(glUniform4i);
+    PROFILE(glUniformMatrix3fv);
+    PROFILE(glUniformMatrix4fv);
+    PROFILE(glGetUniformLocation);
+    PROFILE(glGetAttribLocation);
+    PROFILE(glVertexAttribPointer);
+    PROFILE(glEnableVertexAttribArray);
+    PROFILE(glDisableVertexAttribArray);
+
+    /* Bindings */
+    PROFILE(glUseProgram);
+    PROFILE(glActiveTexture);
+    PROFILE(glBindTexture);
+    PROFILE(glBindBuffer);
+    PROFILE_EXTENSION(BindFramebuffer);
+    PROFILE_EXTENSION(BindVertexArray);
+
+    /* Uploads */
+    PROFILE(glBufferData);
+    PROFILE(glBufferSubData);
+    PROFILE_EXTENSION(MapBufferRange);
+    PROFILE_EXTENSION(UnmapBuffer);
+    PROFILE(glTexImage2D);
+    PROFILE(glTexSubImage2D);
+    PROFILE(glTexParameteri);
+    PROFILE(glReadPixels);
+
+    /* State */
+    PROFILE(glEnable);
+    PROFILE(glDisable);
+    PROFILE(glBlendFunc);
+    PROFILE(glDepthFunc);
+    PROFILE(glDepthMask);
+    PROFILE(glCullFace);
+    PROFILE(glViewport);
+    PROFILE(glScissor);
+    PROFILE(glClearColor);
+    PROFILE(glFlush);
+    PROFILE(glFinish);
+}
+
+bool
+CallProfiler::active()
+{
+    return profiler_active;
+}
+
+const std::string &
+CallProfiler::name(unsigned int index)
+{
+    return names[index];
+}
+
+void
+CallProfiler::read(CallCounters &c)
+{
+    c.calls.assign(counters.calls, counters.calls + names.size());
+    c.nanoseconds.assign(counters.nanoseconds, counters.nanoseconds + names.size());
+}
+
+void
+CallProfiler::add_since(const CallCounters &start, CallCounters &total)
+{
+    total.calls.resize(names.size(), 0);
+    total.nanoseconds.resize(names.size(), 0);
+
+    for (size_t i = 0; i < names.size() && i < start.calls.size(); i++) {
+        total.calls[i] += counters.calls[i] - start.calls[i];
+        total.nanoseconds[i] += counters.nanoseconds[i] - start.nanoseconds[i];
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_CALL_PROFILER_H_
+#define GLMARK2_CALL_PROFILER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * The number of calls of each profiled GL entry point, and the CPU time
+ * spent in them.
+ */
+struct CallCounters
+{
+    void clear() { calls.clear(); nanoseconds.clear(); }
+
+    std::vector<uint64_t> calls;
+    std::vector<uint64_t> nanoseconds;
+};
+
+/**
+ * Counts the calls of the GL entry points that the scenes use the most
+ * (draws, uniforms, bindings, uploads and common state) and measures the
+ * CPU time spent in the driver for each of them (--profile-gl-calls).
+ *
+ * Like the StateTracker, the profiler wraps the loaded GL entry points,
+ * so all the calls are profiled without changing their callers. It is
+ * installed first, so the calls that the tracker skips are not counted.
+ * The counters are per thread.
+ */
+class CallProfiler
+{
+public:
+    /**
+     * Wraps the loaded GL entry points, if enabled. Must be called each
+     * time the entry points are loaded, before StateTracker::install().
+     */
+    static void install(bool enable);
+
+    /**
+     * Whether the profiler is installed.
+     */
+    static bool active();
+
+    /**
+     * The name of a profiled entry point, by its index in the counters.
+     */
+    static const std::string &name(unsigned int index);
+
+    /**
+     * Gets the counters of the current thread.
+     */
+    static void read(CallCounters &counters);
+
+    /**
+     * Adds the calls made by the current thread since start to total.
+     */
+    static void add_since(const CallCounters &start, CallCounters &total);
+};
+
+#endif /* GLMARK2_CALL_PROFILER_H_ */
@@ -0,0 +1,1494 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "call-recorder.h"
+#include "canvas.h"
+#include "gl-headers.h"
+#include "log.h"
+#include "options.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+const char magic[] = "GLMREC01";
+
+/* The id of the frame markers in the recorded stream */
+const uint16_t frame_marker = 0xFFFF;
+
+/* Data is aligned in recordings, so replays can pass it to GL in place */
+const size_t data_alignment = 8;
+
+/* Not defined by the GL (ES) 2.0 headers */
+const GLbitfield map_write_bit = 0x0002;
+
+/* Appends values and data to a recording */
+class Writer
+{
+public:
+    template <typename T> void put(const T &value)
+    {
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        bytes_.insert(bytes_.end(), bytes, bytes + sizeof(T));
+    }
+
+    void put_data(const void *data, size_t size)
+    {
+        put<uint32_t>(size);
+        bytes_.resize((bytes_.size() + data_alignment - 1) & ~(data_alignment - 1), 0);
+        const char *bytes = static_cast<const char *>(data);
+        bytes_.insert(bytes_.end(), bytes, bytes + size);
+    }
+
+    /* Data that may be null, like the pixels of glTexImage2D */
+    void put_optional_data(const void *data, size_t size)
+    {
+        put<uint8_t>(data != 0);
+        if (data)
+            put_data(data, size);
+    }
+
+    void put_string(const std::string &str) { put_data(str.data(), str.size()); }
+
+    const std::vector<char> &bytes() const { return bytes_; }
+    void clear() { std::vector<char>().swap(bytes_); }
+
+private:
+    std::vector<char> bytes_;
+};
+
+/* Reads back what a Writer appended, with the data left in place */
+class Reader
+{
+public:
+    Reader(const char *data, size_t size) : data_(data), size_(size), pos_(0) {}
+
+    template <typename T> T get()
+    {
+        T value = T();
+        if (pos_ + sizeof(T) <= size_)
+            std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    const void *data(size_t &size)
+    {
+        size = get<uint32_t>();
+        pos_ = (pos_ + data_alignment - 1) & ~(data_alignment - 1);
+        const char *data = data_ + pos_;
+        pos_ += size;
+        return pos_ <= size_ ? data : 0;
+    }
+
+    const void *data() { size_t size; return data(size); }
+
+    const void *optional_data() { return get<uint8_t>() ? data() : 0; }
+
+    std::string string()
+    {
+        size_t size;
+        const char *str = static_cast<const char *>(data(size));
+        return str ? std::string(str, size) : std::string();
+    }
+
+    bool ok() const { return pos_ <= size_; }
+    bool at_end() const { return pos_ >= size_; }
+    size_t pos() const { return pos_; }
+    void seek(size_t pos) { pos_ = pos; }
+
+private:
+    const char *data_;
+    size_t size_;
+    size_t pos_;
+};
+
+/* Uniform locations and attribute indices not mapped in a replay */
+const GLint unmapped = -2;
+
+/*
+ * Translates the object names, uniform locations and attribute indices of
+ * a recording to those of its replay.
+ *
+ * The kinds of handles are: b buffer, t texture, f framebuffer,
+ * r renderbuffer, v vertex array, p shader or program, P the program that
+ * is made current, u uniform location of the current program and
+ * a attribute index. Other arguments (-) are passed unchanged.
+ */
+class Player
+{
+public:
+    Player(GLuint recorded_fbo, GLuint live_fbo) :
+        recorded_fbo_(recorded_fbo), live_fbo_(live_fbo), program_(0) {}
+
+    long long translate(char kind, long long value)
+    {
+        switch (kind) {
+            case '-':
+                return value;
+            case 'P':
+                program_ = value;
+                return lookup('p', value);
+            case 'f':
+                if (value == recorded_fbo_)
+                    return live_fbo_;
+                return lookup(kind, value);
+            case 'u':
+                if (value < 0 || program_ >= uniforms_.size())
+                    return value;
+                return lookup(uniforms_[program_], value);
+            case 'a':
+                if (value < 0)
+                    return value;
+                return lookup(attribs_, value);
+            default:
+                return lookup(kind, value);
+        }
+    }
+
+    void map(char kind, GLuint recorded, GLuint live)
+    {
+        std::vector<GLuint> &names(names_[table(kind)]);
+        if (recorded >= names.size())
+            names.resize(recorded + 1, 0);
+        names[recorded] = live;
+    }
+
+    void map_uniform(GLuint program, GLint recorded, GLint live)
+    {
+        if (recorded < 0)
+            return;
+        if (program >= uniforms_.size())
+            uniforms_.resize(program + 1);
+        map(uniforms_[program], recorded, live);
+    }
+
+    void map_attrib(GLint recorded, GLint live)
+    {
+        if (recorded >= 0)
+            map(attribs_, recorded, live);
+    }
+
+    /* Reused storage for translated arrays of names */
+    std::vector<GLuint> &scratch() { return scratch_; }
+
+private:
+    static unsigned int table(char kind)
+    {
+        switch (kind) {
+            case 'b': return 0;
+            case 't': return 1;
+            case 'f': return 2;
+            case 'r': return 3;
+            case 'v': return 4;
+            default: return 5;
+        }
+    }
+
+    long long lookup(char kind, long long value)
+    {
+        const std::vector<GLuint> &names(names_[table(kind)]);
+        if (value >= 0 && static_cast<size_t>(value) < names.size() && names[value])
+            return names[value];
+        return value;
+    }
+
+    long long lookup(const std::vector<GLint> &locations, long long value)
+    {
+        if (static_cast<size_t>(value) < locations.size() && locations[value] != unmapped)
+            return locations[value];
+        return value;
+    }
+
+    void map(std::vector<GLint> &locations, GLint recorded, GLint live)
+    {
+        if (static_cast<size_t>(recorded) >= locations.size())
+            locations.resize(recorded + 1, unmapped);
+        locations[recorded] = live;
+    }
+
+    GLuint recorded_fbo_;
+    GLuint live_fbo_;
+    GLuint program_;
+    std::vector<GLuint> names_[6];
+    std::vector<std::vector<GLint> > uniforms_;
+    std::vector<GLint> attribs_;
+    std::vector<GLuint> scratch_;
+};
+
+template <typename T> inline T
+translated(Player &player, char kind, T value)
+{
+    if (kind == '-')
+        return value;
+    return static_cast<T>(player.translate(kind, static_cast<long long>(value)));
+}
+
+struct Recording
+{
+    Recording() : active(false), done(false), frames(0) {}
+
+    bool active;
+    bool done;
+    unsigned int frames;
+    std::vector<bool> used;
+    std::string scene;
+    GLuint canvas_fbo;
+    int width;
+    int height;
+    Writer stream;
+};
+
+Recording recording;
+
+bool recorder_installed = false;
+
+/* Only the thread that started the recording is recorded, inside scopes */
+thread_local bool recording_thread = false;
+thread_local unsigned int scope_depth = 0;
+
+inline bool
+capturing()
+{
+    return recording.active && recording_thread && scope_depth > 0;
+}
+
+/* Starts recording a call, by the id of its entry point */
+void
+put_call(uint16_t id)
+{
+    if (id >= recording.used.size())
+        recording.used.resize(id + 1, false);
+    recording.used[id] = true;
+    recording.stream.put(id);
+}
+
+void
+abort_recording(const char *reason)
+{
+    Log::info("Warning: not recording %s: %s\n", recording.scene.c_str(), reason);
+    recording.active = false;
+    recording.done = true;
+    recording.stream.clear();
+    recording_thread = false;
+}
+
+typedef void (*PlayFunc)(Reader &reader, Player &player);
+typedef bool (*LoadedFunc)();
+
+/* The names, players and availability of the recorded entry points, by id */
+std::vector<std::string> names;
+std::vector<PlayFunc> players;
+std::vector<LoadedFunc> loaded;
+
+/*
+ * The state of a recorded entry point, with one instance for each wrapped
+ * entry point, told apart by the line they are wrapped on.
+ */
+template <unsigned int Line, typename T>
+struct EntryPoint
+{
+    static bool is_loaded() { return slot && *slot; }
+
+    static T real;
+    static T *slot;
+    static uint16_t id;
+    static const char *kinds;
+};
+
+template <unsigned int Line, typename T> T EntryPoint<Line, T>::real = 0;
+template <unsigned int Line, typename T> T *EntryPoint<Line, T>::slot = 0;
+template <unsigned int Line, typename T> uint16_t EntryPoint<Line, T>::id = frame_marker;
+template <unsigned int Line, typename T> const char *EntryPoint<Line, T>::kinds = "";
+
+/*
+ * Entry points whose arguments are all values, recorded as they are, and
+ * translated according to the kinds of the entry point when replayed.
+ */
+template <unsigned int Line, typename T> struct Recorded;
+
+template <unsigned int Line, typename R, typename... Args>
+struct Recorded<Line, R (GLAD_API_PTR *)(Args...)> :
+    EntryPoint<Line, R (GLAD_API_PTR *)(Args...)>
+{
+    typedef EntryPoint<Line, R (GLAD_API_PTR *)(Args...)> Base;
+
+    static R GLAD_API_PTR call(Args... args)
+    {
+        if (capturing()) {
+            put_call(Base::id);
+            int unused[] = { 0, (recording.stream.put(args), 0)... };
+            (void)unused;
+        }
+        return Base::real(args...);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        /* Braced initialization reads the arguments in order */
+        std::tuple<Args...> args{reader.get<Args>()...};
+        play(args, player, std::index_sequence_for<Args...>());
+    }
+
+    template <size_t... I>
+    static void play(std::tuple<Args...> &args, Player &player, std::index_sequence<I...>)
+    {
+        (void)args;
+        (void)player;
+        (*Base::slot)(translated(player, Base::kinds[I], std::get<I>(args))...);
+    }
+};
+
+typedef void (GLAD_API_PTR *GenFunc)(GLsizei n, GLuint *names);
+typedef void (GLAD_API_PTR *DeleteFunc)(GLsizei n, const GLuint *names);
+
+template <unsigned int Line, char Kind>
+struct GenNames : EntryPoint<Line, GenFunc>
+{
+    typedef EntryPoint<Line, GenFunc> Base;
+
+    static void GLAD_API_PTR call(GLsizei n, GLuint *names)
+    {
+        Base::real(n, names);
+        if (capturing() && n > 0) {
+            put_call(Base::id);
+            recording.stream.put_data(names, n * sizeof(GLuint));
+        }
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        size_t size;
+        const GLuint *recorded = static_cast<const GLuint *>(reader.data(size));
+        GLsizei n = size / sizeof(GLuint);
+        if (!recorded)
+            return;
+
+        std::vector<GLuint> &live(player.scratch());
+        live.resize(n);
+        (*Base::slot)(n, live.data());
+        for (GLsizei i = 0; i < n; i++)
+            player.map(Kind, recorded[i], live[i]);
+    }
+};
+
+template <unsigned int Line, char Kind>
+struct DeleteNames : EntryPoint<Line, DeleteFunc>
+{
+    typedef EntryPoint<Line, DeleteFunc> Base;
+
+    static void GLAD_API_PTR call(GLsizei n, const GLuint *names)
+    {
+        if (capturing() && n > 0) {
+            put_call(Base::id);
+            recording.stream.put_data(names, n * sizeof(GLuint));
+        }
+        Base::real(n, names);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        size_t size;
+        const GLuint *recorded = static_cast<const GLuint *>(reader.data(size));
+        GLsizei n = size / sizeof(GLuint);
+        if (!recorded)
+            return;
+
+        std::vector<GLuint> &live(player.scratch());
+        live.resize(n);
+        for (GLsizei i = 0; i < n; i++)
+            live[i] = player.translate(Kind, recorded[i]);
+        (*Base::slot)(n, live.data());
+    }
+};
+
+struct CreateShader : EntryPoint<__LINE__, PFNGLCREATESHADERPROC>
+{
+    static GLuint GLAD_API_PTR call(GLenum type)
+    {
+        GLuint shader = real(type);
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(type);
+            recording.stream.put(shader);
+        }
+        return shader;
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLenum type = reader.get<GLenum>();
+        GLuint recorded = reader.get<GLuint>();
+        player.map('p', recorded, (*slot)(type));
+    }
+};
+
+struct CreateProgram : EntryPoint<__LINE__, PFNGLCREATEPROGRAMPROC>
+{
+    static GLuint GLAD_API_PTR call()
+    {
+        GLuint program = real();
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(program);
+        }
+        return program;
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLuint recorded = reader.get<GLuint>();
+        player.map('p', recorded, (*slot)());
+    }
+};
+
+struct ShaderSource : EntryPoint<__LINE__, PFNGLSHADERSOURCEPROC>
+{
+    static void GLAD_API_PTR call(GLuint shader, GLsizei count,
+                                  const GLchar *const *strings, const GLint *lengths)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(shader);
+            recording.stream.put<uint32_t>(count);
+            for (GLsizei i = 0; i < count; i++) {
+                size_t length = lengths && lengths[i] >= 0 ? lengths[i] : std::strlen(strings[i]);
+                recording.stream.put_data(strings[i], length);
+            }
+        }
+        real(shader, count, strings, lengths);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLuint shader = player.translate('p', reader.get<GLuint>());
+        GLsizei count = reader.get<uint32_t>();
+        std::vector<const GLchar *> strings;
+        std::vector<GLint> lengths;
+        for (GLsizei i = 0; i < count; i++) {
+            size_t length;
+            strings.push_back(static_cast<const GLchar *>(reader.data(length)));
+            lengths.push_back(length);
+        }
+        (*slot)(shader, count, strings.data(), lengths.data());
+    }
+};
+
+struct BindAttribLocation : EntryPoint<__LINE__, PFNGLBINDATTRIBLOCATIONPROC>
+{
+    static void GLAD_API_PTR call(GLuint program, GLuint index, const GLchar *name)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(program);
+            recording.stream.put(index);
+            recording.stream.put_data(name, std::strlen(name) + 1);
+        }
+        real(program, index, name);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLuint program = player.translate('p', reader.get<GLuint>());
+        GLuint index = reader.get<GLuint>();
+        (*slot)(program, index, static_cast<const GLchar *>(reader.data()));
+    }
+};
+
+struct TransformFeedbackVaryings :
+    EntryPoint<__LINE__, void (GLAD_API_PTR *)(GLuint, GLsizei, const GLchar *const *, GLenum)>
+{
+    static void GLAD_API_PTR call(GLuint program, GLsizei count,
+                                  const GLchar *const *varyings, GLenum mode)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(program);
+            recording.stream.put(mode);
+            recording.stream.put<uint32_t>(count);
+            for (GLsizei i = 0; i < count; i++)
+                recording.stream.put_data(varyings[i], std::strlen(varyings[i]) + 1);
+        }
+        real(program, count, varyings, mode);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLuint program = player.translate('p', reader.get<GLuint>());
+        GLenum mode = reader.get<GLenum>();
+        GLsizei count = reader.get<uint32_t>();
+        std::vector<const GLchar *> varyings;
+        for (GLsizei i = 0; i < count; i++)
+            varyings.push_back(static_cast<const GLchar *>(reader.data()));
+        (*slot)(program, count, varyings.data(), mode);
+    }
+};
+
+typedef GLint (GLAD_API_PTR *GetLocationFunc)(GLuint program, const GLchar *name);
+
+template <unsigned int Line, bool Uniform>
+struct GetLocation : EntryPoint<Line, GetLocationFunc>
+{
+    typedef EntryPoint<Line, GetLocationFunc> Base;
+
+    static GLint GLAD_API_PTR call(GLuint program, const GLchar *name)
+    {
+        GLint location = Base::real(program, name);
+        if (capturing()) {
+            put_call(Base::id);
+            recording.stream.put(program);
+            recording.stream.put_data(name, std::strlen(name) + 1);
+            recording.stream.put(location);
+        }
+        return location;
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLuint program = reader.get<GLuint>();
+        const GLchar *name = static_cast<const GLchar *>(reader.data());
+        GLint recorded = reader.get<GLint>();
+        GLint live = (*Base::slot)(player.translate('p', program), name);
+        if (Uniform)
+            player.map_uniform(program, recorded, live);
+        else
+            player.map_attrib(recorded, live);
+    }
+};
+
+/* glBufferData and glBufferStorage */
+typedef void (GLAD_API_PTR *BufferDataFunc)(GLenum target, GLsizeiptr size,
+                                            const void *data, GLenum usage);
+
+template <unsigned int Line>
+struct BufferData : EntryPoint<Line, BufferDataFunc>
+{
+    typedef EntryPoint<Line, BufferDataFunc> Base;
+
+    static void GLAD_API_PTR call(GLenum target, GLsizeiptr size,
+                                  const void *data, GLenum usage)
+    {
+        if (capturing()) {
+            put_call(Base::id);
+            recording.stream.put(target);
+            recording.stream.put(size);
+            recording.stream.put(usage);
+            recording.stream.put_optional_data(data, size);
+        }
+        Base::real(target, size, data, usage);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum target = reader.get<GLenum>();
+        GLsizeiptr size = reader.get<GLsizeiptr>();
+        GLenum usage = reader.get<GLenum>();
+        (*Base::slot)(target, size, reader.optional_data(), usage);
+    }
+};
+
+struct BufferSubData : EntryPoint<__LINE__, PFNGLBUFFERSUBDATAPROC>
+{
+    static void record(GLenum target, GLintptr offset, GLsizeiptr size, const void *data)
+    {
+        put_call(id);
+        recording.stream.put(target);
+        recording.stream.put(offset);
+        recording.stream.put_data(data, size);
+    }
+
+    static void GLAD_API_PTR call(GLenum target, GLintptr offset,
+                                  GLsizeiptr size, const void *data)
+    {
+        if (capturing())
+            record(target, offset, size, data);
+        real(target, offset, size, data);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum target = reader.get<GLenum>();
+        GLintptr offset = reader.get<GLintptr>();
+        size_t size;
+        const void *data = reader.data(size);
+        (*slot)(target, offset, size, data);
+    }
+};
+
+/*
+ * The writes to mapped buffers are recorded when they are unmapped, as
+ * glBufferSubData calls. Buffers that stay mapped are not supported.
+ */
+struct Mapping
+{
+    GLenum target;
+    GLintptr offset;
+    GLsizeiptr length;
+    const void *data;
+};
+
+std::vector<Mapping> mappings;
+
+void
+add_mapping(GLenum target, GLintptr offset, GLsizeiptr length, const void *data)
+{
+    Mapping mapping = { target, offset, length, data };
+    mappings.push_back(mapping);
+}
+
+struct MapBufferRange : EntryPoint<__LINE__, void *(GLAD_API_PTR *)(GLenum, GLintptr, GLsizeiptr, GLbitfield)>
+{
+    static void *GLAD_API_PTR call(GLenum target, GLintptr offset,
+                                   GLsizeiptr length, GLbitfield access)
+    {
+        void *data = real(target, offset, length, access);
+        if (capturing() && data && (access & map_write_bit))
+            add_mapping(target, offset, length, data);
+        return data;
+    }
+
+    /* Mappings are recorded as the glBufferSubData calls of their unmaps */
+    static void play(Reader &, Player &) {}
+};
+
+struct MapBuffer : EntryPoint<__LINE__, void *(GLAD_API_PTR *)(GLenum, GLenum)>
+{
+    static void *GLAD_API_PTR call(GLenum target, GLenum access)
+    {
+        void *data = real(target, access);
+        if (capturing() && data) {
+            GLint size = 0;
+            glad_glGetBufferParameteriv(target, GL_BUFFER_SIZE, &size);
+            add_mapping(target, 0, size, data);
+        }
+        return data;
+    }
+
+    static void play(Reader &, Player &) {}
+};
+
+struct UnmapBuffer : EntryPoint<__LINE__, GLboolean (GLAD_API_PTR *)(GLenum)>
+{
+    static GLboolean GLAD_API_PTR call(GLenum target)
+    {
+        for (std::vector<Mapping>::iterator iter = mappings.begin();
+             iter != mappings.end();
+             iter++)
+        {
+            if (iter->target != target)
+                continue;
+            if (capturing())
+                BufferSubData::record(target, iter->offset, iter->length, iter->data);
+            mappings.erase(iter);
+            break;
+        }
+        return real(target);
+    }
+
+    static void play(Reader &, Player &) {}
+};
+
+/* The size of the pixels of glTexImage2D and glTexSubImage2D */
+size_t
+image_size(GLsizei width, GLsizei height, GLenum format, GLenum type)
+{
+    size_t components;
+    switch (format) {
+        case GL_ALPHA:
+        case GL_LUMINANCE:
+        case GL_DEPTH_COMPONENT:
+        case 0x1903: /* GL_RED */
+            components = 1;
+            break;
+        case GL_LUMINANCE_ALPHA:
+        case 0x8227: /* GL_RG */
+            components = 2;
+            break;
+        case GL_RGB:
+            components = 3;
+            break;
+        default:
+            components = 4;
+            break;
+    }
+
+    size_t pixel;
+    switch (type) {
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            pixel = 2;
+            break;
+        case 0x8368: /* GL_UNSIGNED_INT_2_10_10_10_REV */
+        case 0x84FA: /* GL_UNSIGNED_INT_24_8 */
+        case 0x8C3B: /* GL_UNSIGNED_INT_10F_11F_11F_REV */
+            pixel = 4;
+            break;
+        case GL_UNSIGNED_SHORT:
+        case 0x140B: /* GL_HALF_FLOAT */
+        case 0x8D61: /* GL_HALF_FLOAT_OES */
+            pixel = 2 * components;
+            break;
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:
+            pixel = 4 * components;
+            break;
+        default:
+            pixel = components;
+            break;
+    }
+
+    if (width <= 0 || height <= 0)
+        return 0;
+
+    GLint alignment = 4;
+    glad_glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+
+    size_t row = width * pixel;
+    size_t stride = (row + alignment - 1) / alignment * alignment;
+
+    return stride * (height - 1) + row;
+}
+
+struct TexImage2D : EntryPoint<__LINE__, PFNGLTEXIMAGE2DPROC>
+{
+    static void GLAD_API_PTR call(GLenum target, GLint level, GLint internalformat,
+                                  GLsizei width, GLsizei height, GLint border,
+                                  GLenum format, GLenum type, const void *pixels)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(target);
+            recording.stream.put(level);
+            recording.stream.put(internalformat);
+            recording.stream.put(width);
+            recording.stream.put(height);
+            recording.stream.put(border);
+            recording.stream.put(format);
+            recording.stream.put(type);
+            recording.stream.put_optional_data(pixels, image_size(width, height, format, type));
+        }
+        real(target, level, internalformat, width, height, border, format, type, pixels);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum target = reader.get<GLenum>();
+        GLint level = reader.get<GLint>();
+        GLint internalformat = reader.get<GLint>();
+        GLsizei width = reader.get<GLsizei>();
+        GLsizei height = reader.get<GLsizei>();
+        GLint border = reader.get<GLint>();
+        GLenum format = reader.get<GLenum>();
+        GLenum type = reader.get<GLenum>();
+        (*slot)(target, level, internalformat, width, height, border, format, type,
+                reader.optional_data());
+    }
+};
+
+struct TexSubImage2D : EntryPoint<__LINE__, PFNGLTEXSUBIMAGE2DPROC>
+{
+    static void GLAD_API_PTR call(GLenum target, GLint level, GLint xoffset,
+                                  GLint yoffset, GLsizei width, GLsizei height,
+                                  GLenum format, GLenum type, const void *pixels)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(target);
+            recording.stream.put(level);
+            recording.stream.put(xoffset);
+            recording.stream.put(yoffset);
+            recording.stream.put(width);
+            recording.stream.put(height);
+            recording.stream.put(format);
+            recording.stream.put(type);
+            recording.stream.put_optional_data(pixels, image_size(width, height, format, type));
+        }
+        real(target, level, xoffset, yoffset, width, height, format, type, pixels);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum target = reader.get<GLenum>();
+        GLint level = reader.get<GLint>();
+        GLint xoffset = reader.get<GLint>();
+        GLint yoffset = reader.get<GLint>();
+        GLsizei width = reader.get<GLsizei>();
+        GLsizei height = reader.get<GLsizei>();
+        GLenum format = reader.get<GLenum>();
+        GLenum type = reader.get<GLenum>();
+        (*slot)(target, level, xoffset, yoffset, width, height, format, type,
+                reader.optional_data());
+    }
+};
+
+struct CompressedTexImage2D : EntryPoint<__LINE__, PFNGLCOMPRESSEDTEXIMAGE2DPROC>
+{
+    static void GLAD_API_PTR call(GLenum target, GLint level, GLenum internalformat,
+                                  GLsizei width, GLsizei height, GLint border,
+                                  GLsizei size, const void *data)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(target);
+            recording.stream.put(level);
+            recording.stream.put(internalformat);
+            recording.stream.put(width);
+            recording.stream.put(height);
+            recording.stream.put(border);
+            recording.stream.put(size);
+            recording.stream.put_optional_data(data, size);
+        }
+        real(target, level, internalformat, width, height, border, size, data);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum target = reader.get<GLenum>();
+        GLint level = reader.get<GLint>();
+        GLenum internalformat = reader.get<GLenum>();
+        GLsizei width = reader.get<GLsizei>();
+        GLsizei height = reader.get<GLsizei>();
+        GLint border = reader.get<GLint>();
+        GLsizei size = reader.get<GLsizei>();
+        (*slot)(target, level, internalformat, width, height, border, size,
+                reader.optional_data());
+    }
+};
+
+typedef void (GLAD_API_PTR *UniformVectorFunc)(GLint location, GLsizei count,
+                                               const GLfloat *value);
+typedef void (GLAD_API_PTR *UniformMatrixFunc)(GLint location, GLsizei count,
+                                               GLboolean transpose, const GLfloat *value);
+
+/* glUniform{N}fv */
+template <unsigned int Line, unsigned int N>
+struct UniformVector : EntryPoint<Line, UniformVectorFunc>
+{
+    typedef EntryPoint<Line, UniformVectorFunc> Base;
+
+    static void GLAD_API_PTR call(GLint location, GLsizei count, const GLfloat *value)
+    {
+        if (capturing()) {
+            put_call(Base::id);
+            recording.stream.put(location);
+            recording.stream.put_data(value, count * N * sizeof(GLfloat));
+        }
+        Base::real(location, count, value);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLint location = player.translate('u', reader.get<GLint>());
+        size_t size;
+        const GLfloat *value = static_cast<const GLfloat *>(reader.data(size));
+        (*Base::slot)(location, size / (N * sizeof(GLfloat)), value);
+    }
+};
+
+/* glUniformMatrix{N}fv */
+template <unsigned int Line, unsigned int N>
+struct UniformMatrix : EntryPoint<Line, UniformMatrixFunc>
+{
+    typedef EntryPoint<Line, UniformMatrixFunc> Base;
+
+    static void GLAD_API_PTR call(GLint location, GLsizei count,
+                                  GLboolean transpose, const GLfloat *value)
+    {
+        if (capturing()) {
+            put_call(Base::id);
+            recording.stream.put(location);
+            recording.stream.put(transpose);
+            recording.stream.put_data(value, count * N * N * sizeof(GLfloat));
+        }
+        Base::real(location, count, transpose, value);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLint location = player.translate('u', reader.get<GLint>());
+        GLboolean transpose = reader.get<GLboolean>();
+        size_t size;
+        const GLfloat *value = static_cast<const GLfloat *>(reader.data(size));
+        (*Base::slot)(location, size / (N * N * sizeof(GLfloat)), transpose, value);
+    }
+};
+
+struct VertexAttribPointer : EntryPoint<__LINE__, PFNGLVERTEXATTRIBPOINTERPROC>
+{
+    static void GLAD_API_PTR call(GLuint index, GLint size, GLenum type,
+                                  GLboolean normalized, GLsizei stride,
+                                  const void *pointer)
+    {
+        if (capturing()) {
+            GLint buffer = 0;
+            glad_glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &buffer);
+            if (!buffer && pointer) {
+                abort_recording("client-side vertex arrays are not supported");
+            }
+            else {
+                put_call(id);
+                recording.stream.put(index);
+                recording.stream.put(size);
+                recording.stream.put(type);
+                recording.stream.put(normalized);
+                recording.stream.put(stride);
+                recording.stream.put<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+            }
+        }
+        real(index, size, type, normalized, stride, pointer);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLuint index = player.translate('a', reader.get<GLuint>());
+        GLint size = reader.get<GLint>();
+        GLenum type = reader.get<GLenum>();
+        GLboolean normalized = reader.get<GLboolean>();
+        GLsizei stride = reader.get<GLsizei>();
+        uintptr_t offset = reader.get<uint64_t>();
+        (*slot)(index, size, type, normalized, stride, reinterpret_cast<const void *>(offset));
+    }
+};
+
+/*
+ * The indices of glDrawElements calls are recorded when they come from
+ * client memory, and only their offset when they come from a buffer.
+ */
+void
+put_indices(GLsizei count, GLenum type, const void *indices)
+{
+    GLint buffer = 0;
+    glad_glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &buffer);
+
+    recording.stream.put<uint8_t>(buffer == 0);
+    if (buffer) {
+        recording.stream.put<uint64_t>(reinterpret_cast<uintptr_t>(indices));
+    }
+    else {
+        size_t index_size = type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+        recording.stream.put_data(indices, count * index_size);
+    }
+}
+
+const void *
+get_indices(Reader &reader)
+{
+    if (reader.get<uint8_t>())
+        return reader.data();
+    return reinterpret_cast<const void *>(static_cast<uintptr_t>(reader.get<uint64_t>()));
+}
+
+struct DrawElements : EntryPoint<__LINE__, PFNGLDRAWELEMENTSPROC>
+{
+    static void GLAD_API_PTR call(GLenum mode, GLsizei count, GLenum type,
+                                  const void *indices)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(mode);
+            recording.stream.put(count);
+            recording.stream.put(type);
+            put_indices(count, type, indices);
+        }
+        real(mode, count, type, indices);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum mode = reader.get<GLenum>();
+        GLsizei count = reader.get<GLsizei>();
+        GLenum type = reader.get<GLenum>();
+        (*slot)(mode, count, type, get_indices(reader));
+    }
+};
+
+struct DrawElementsInstanced :
+    EntryPoint<__LINE__, void (GLAD_API_PTR *)(GLenum, GLsizei, GLenum, const void *, GLsizei)>
+{
+    static void GLAD_API_PTR call(GLenum mode, GLsizei count, GLenum type,
+                                  const void *indices, GLsizei instances)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(mode);
+            recording.stream.put(count);
+            recording.stream.put(type);
+            recording.stream.put(instances);
+            put_indices(count, type, indices);
+        }
+        real(mode, count, type, indices, instances);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum mode = reader.get<GLenum>();
+        GLsizei count = reader.get<GLsizei>();
+        GLenum type = reader.get<GLenum>();
+        GLsizei instances = reader.get<GLsizei>();
+        (*slot)(mode, count, type, get_indices(reader), instances);
+    }
+};
+
+struct ProgramBinary :
+    EntryPoint<__LINE__, void (GLAD_API_PTR *)(GLuint, GLenum, const void *, GLsizei)>
+{
+    static void GLAD_API_PTR call(GLuint program, GLenum format,
+                                  const void *binary, GLsizei length)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(program);
+            recording.stream.put(format);
+            recording.stream.put_data(binary, length);
+        }
+        real(program, format, binary, length);
+    }
+
+    static void play(Reader &reader, Player &player)
+    {
+        GLuint program = player.translate('p', reader.get<GLuint>());
+        GLenum format = reader.get<GLenum>();
+        size_t length;
+        const void *binary = reader.data(length);
+        (*slot)(program, format, binary, length);
+    }
+};
+
+struct DrawBuffers : EntryPoint<__LINE__, void (GLAD_API_PTR *)(GLsizei, const GLenum *)>
+{
+    static void GLAD_API_PTR call(GLsizei n, const GLenum *buffers)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put_data(buffers, n * sizeof(GLenum));
+        }
+        real(n, buffers);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        size_t size;
+        const GLenum *buffers = static_cast<const GLenum *>(reader.data(size));
+        (*slot)(size / sizeof(GLenum), buffers);
+    }
+};
+
+struct InvalidateFramebuffer :
+    EntryPoint<__LINE__, void (GLAD_API_PTR *)(GLenum, GLsizei, const GLenum *)>
+{
+    static void GLAD_API_PTR call(GLenum target, GLsizei n, const GLenum *attachments)
+    {
+        if (capturing()) {
+            put_call(id);
+            recording.stream.put(target);
+            recording.stream.put_data(attachments, n * sizeof(GLenum));
+        }
+        real(target, n, attachments);
+    }
+
+    static void play(Reader &reader, Player &)
+    {
+        GLenum target = reader.get<GLenum>();
+        size_t size;
+        const GLenum *attachments = static_cast<const GLenum *>(reader.data(size));
+        (*slot)(target, size / sizeof(GLenum), attachments);
+    }
+};
+
+/*
+ * Registers an entry point, so it can be found by name when replaying,
+ * and replaces it by its recorded version if installed, unless already done.
+ */
+template <typename W, typename T> void
+wrap(T &entry_point, const char *name, const char *kinds)
+{
+    if (W::id == frame_marker) {
+        W::id = names.size();
+        names.push_back(name);
+        players.push_back(&W::play);
+        loaded.push_back(&W::is_loaded);
+    }
+
+    W::slot = &entry_point;
+    W::kinds = kinds;
+
+    if (recorder_installed && entry_point && entry_point != &W::call) {
+        W::real = entry_point;
+        entry_point = &W::call;
+    }
+}
+
+/* Runs the recorded calls up to the next frame marker, or the end */
+bool
+play_until_frame(Reader &reader, const std::vector<PlayFunc> &recorded_players,
+                 Player &player)
+{
+    while (!reader.at_end()) {
+        uint16_t id = reader.get<uint16_t>();
+        if (id == frame_marker)
+            return true;
+        if (id >= recorded_players.size() || !recorded_players[id])
+            return false;
+        recorded_players[id](reader, player);
+    }
+
+    return false;
+}
+
+bool
+write_recording()
+{
+    Writer writer;
+
+    writer.put_data(magic, sizeof(magic) - 1);
+    writer.put_string(recording.scene);
+    writer.put<int32_t>(recording.width);
+    writer.put<int32_t>(recording.height);
+    writer.put<uint32_t>(recording.canvas_fbo);
+    writer.put<uint32_t>(recording.frames);
+    writer.put<uint32_t>(names.size());
+    for (size_t i = 0; i < names.size(); i++) {
+        writer.put_string(names[i]);
+        writer.put<uint8_t>(i < recording.used.size() && recording.used[i]);
+    }
+    writer.put_data(recording.stream.bytes().data(), recording.stream.bytes().size());
+
+    std::ofstream file(Options::record.c_str(), std::ios::binary);
+    file.write(writer.bytes().data(), writer.bytes().size());
+
+    return file.good();
+}
+
+}
+
+#define RECORD(entry_point, kinds) \
+    wrap<Recorded<__LINE__, decltype(glad_##entry_point)> >( \
+        glad_##entry_point, #entry_point, kinds)
+#define RECORD_EXTENSION(entry_point, kinds) \
+    wrap<Recorded<__LINE__, decltype(GLExtensions::entry_point)> >( \
+        GLExtensions::entry_point, "gl" #entry_point, kinds)
+#define RECORD_AS(entry_point, ...) \
+    wrap<__VA_ARGS__>(glad_##entry_point, #entry_point, "")
+#define RECORD_EXTENSION_AS(entry_point, ...) \
+    wrap<__VA_ARGS__>(GLExtensions::entry_point, "gl" #entry_point, "")
+
+void
+CallRecorder::install(bool enable)
+{
+    recorder_installed = enable;
+
+    /*
+     * The entry points are registered even when not recording, so they
+     * can be replayed. The kinds of the arguments of the entry points
+     * recorded as they are are described in Player.
+     */
+
+    /* Objects */
+    RECORD_AS(glGenBuffers, GenNames<__LINE__, 'b'>);
+    RECORD_AS(glDeleteBuffers, DeleteNames<__LINE__, 'b'>);
+    RECORD_AS(glGenTextures, GenNames<__LINE__, 't'>);
+    RECORD_AS(glDeleteTextures, DeleteNames<__LINE__, 't'>);
+    RECORD_EXTENSION_AS(GenFramebuffers, GenNames<__LINE__, 'f'>);
+    RECORD_EXTENSION_AS(DeleteFramebuffers, DeleteNames<__LINE__, 'f'>);
+    RECORD_EXTENSION_AS(GenRenderbuffers, GenNames<__LINE__, 'r'>);
+    RECORD_EXTENSION_AS(DeleteRenderbuffers, DeleteNames<__LINE__, 'r'>);
+    RECORD_EXTENSION_AS(GenVertexArrays, GenNames<__LINE__, 'v'>);
+    RECORD_EXTENSION_AS(DeleteVertexArrays, DeleteNames<__LINE__, 'v'>);
+
+    /* Shaders and programs */
+    RECORD_AS(glCreateShader, CreateShader);
+    RECORD_AS(glShaderSource, ShaderSource);
+    RECORD(glCompileShader, "p");
+    RECORD(glDeleteShader, "p");
+    RECORD_AS(glCreateProgram, CreateProgram);
+    RECORD(glAttachShader, "pp");
+    RECORD_AS(glBindAttribLocation, BindAttribLocation);
+    RECORD(glLinkProgram, "p");
+    RECORD_EXTENSION_AS(ProgramBinary, ProgramBinary);
+    RECORD(glDeleteProgram, "p");
+    RECORD(glUseProgram, "P");
+    RECORD_AS(glGetUniformLocation, GetLocation<__LINE__, true>);
+    RECORD_AS(glGetAttribLocation, GetLocation<__LINE__, false>);
+    RECORD_EXTENSION(UniformBlockBinding, "p--");
+    RECORD_EXTENSION_AS(TransformFeedbackVaryings, TransformFeedbackVaryings);
+
+    /* Uniforms and vertex attributes */
+    RECORD(glUniform1f, "u-");
+    RECORD(glUniform1i, "u-");
+    RECORD(glUniform2f, "u--");
+    RECORD(glUniform3f, "u---");
+    RECORD(glUniform4f, "u----");
+    RECORD(glUniform4i, "u----");
+    RECORD_AS(glUniform2fv, UniformVector<__LINE__, 2>);
+    RECORD_AS(glUniform3fv, UniformVector<__LINE__, 3>);
+    RECORD_AS(glUniform4fv, UniformVector<__LINE__, 4>);
+    RECORD_AS(glUniformMatrix3fv, UniformMatrix<__LINE__, 3>);
+    RECORD_AS(glUniformMatrix4fv, UniformMatrix<__LINE__, 4>);
+    RECORD_AS(glVertexAttribPointer, VertexAttribPointer);
+    RECORD(glEnableVertexAttribArray, "a");
+    RECORD(glDisableVertexAttribArray, "a");
+    RECORD_EXTENSION(VertexAttribDivisor, "a-");
+
+    /* Bindings */
+    RECORD(glActiveTexture, "-");
+    RECORD(glBindTexture, "-t");
+    RECORD(glBindBuffer, "-b");
+    RECORD_EXTENSION(BindBufferBase, "--b");
+    RECORD_EXTENSION(BindBufferRange, "--b--");
+    RECORD_EXTENSION(BindFramebuffer, "-f");
+    RECORD_EXTENSION(BindRenderbuffer, "-r");
+    RECORD_EXTENSION(BindVertexArray, "v");
+    RECORD_EXTENSION(FramebufferTexture2D, "---t-");
+    RECORD_EXTENSION(FramebufferTexture2DMultisample, "---t--");
+    RECORD_EXTENSION(FramebufferRenderbuffer, "---r");
+    RECORD_EXTENSION_AS(DrawBuffers, DrawBuffers);
+
+    /* Uploads */
+    RECORD_AS(glBufferData, BufferData<__LINE__>);
+    RECORD_EXTENSION_AS(BufferStorage, BufferData<__LINE__>);
+    RECORD_AS(glBufferSubData, BufferSubData);
+    RECORD_EXTENSION_AS(MapBufferRange, MapBufferRange);
+    RECORD_EXTENSION_AS(MapBuffer, MapBuffer);
+    RECORD_EXTENSION_AS(UnmapBuffer, UnmapBuffer);
+    RECORD(glPixelStorei, "--");
+    RECORD_AS(glTexImage2D, TexImage2D);
+    RECORD_AS(glTexSubImage2D, TexSubImage2D);
+    RECORD_AS(glCompressedTexImage2D, CompressedTexImage2D);
+    RECORD_EXTENSION(TexStorage2D, "-----");
+    RECORD(glTexParameteri, "---");
+    RECORD(glTexParameterf, "---");
+    RECORD_EXTENSION(GenerateMipmap, "-");
+    RECORD_EXTENSION(RenderbufferStorage, "----");
+    RECORD_EXTENSION(RenderbufferStorageMultisample, "-----");
+
+    /* Draws */
+    RECORD(glDrawArrays, "---");
+    RECORD_AS(glDrawElements, DrawElements);
+    RECORD_EXTENSION(DrawArraysInstanced, "----");
+    RECORD_EXTENSION_AS(DrawElementsInstanced, DrawElementsInstanced);
+    RECORD_EXTENSION(BeginTransformFeedback, "-");
+    RECORD_EXTENSION(EndTransformFeedback, "");
+    RECORD(glClear, "-");
+    RECORD_EXTENSION(BlitFramebuffer, "----------");
+    RECORD_EXTENSION_AS(InvalidateFramebuffer, InvalidateFramebuffer);
+
+    /* State */
+    RECORD(glEnable, "-");
+    RECORD(glDisable, "-");
+    RECORD(glBlendFunc, "--");
+    RECORD(glBlendFuncSeparate, "----");
+    RECORD(glColorMask, "----");
+    RECORD(glDepthFunc, "-");
+    RECORD(glDepthMask, "-");
+    RECORD(glCullFace, "-");
+    RECORD(glFrontFace, "-");
+    RECORD(glViewport, "----");
+    RECORD(glScissor, "----");
+    RECORD(glClearColor, "----");
+#if GLMARK2_USE_GL
+    RECORD(glClearDepth, "-");
+#elif GLMARK2_USE_GLESv2
+    RECORD(glClearDepthf, "-");
+#endif
+    RECORD(glLineWidth, "-");
+    RECORD(glPolygonOffset, "--");
+    RECORD_EXTENSION(MinSampleShading, "-");
+    RECORD(glFlush, "");
+    RECORD(glFinish, "");
+}
+
+void
+CallRecorder::begin(const std::string &scene, unsigned int canvas_fbo,
+                    int width, int height)
+{
+    if (!recorder_installed || recording.done || recording.active)
+        return;
+
+    recording.active = true;
+    recording.frames = 0;
+    recording.scene = scene;
+    recording.canvas_fbo = canvas_fbo;
+    recording.width = width;
+    recording.height = height;
+    recording.stream.clear();
+    recording.used.clear();
+    recording_thread = true;
+    mappings.clear();
+}
+
+void
+CallRecorder::begin_frame(bool clear)
+{
+    if (!recording.active || !recording_thread)
+        return;
+
+    recording.stream.put<uint16_t>(frame_marker);
+    recording.stream.put<uint8_t>(clear);
+}
+
+void
+CallRecorder::end_frame()
+{
+    if (!recording.active || !recording_thread)
+        return;
+
+    /* The recording is written at the end of the scene */
+    if (++recording.frames >= Options::record_frames)
+        recording.active = false;
+}
+
+void
+CallRecorder::end()
+{
+    if (!recording_thread)
+        return;
+
+    recording.active = false;
+    recording_thread = false;
+
+    /* Scenes that failed to set up are not recorded, the next one is */
+    if (recording.frames == 0) {
+        recording.stream.clear();
+        return;
+    }
+
+    recording.done = true;
+
+    if (write_recording()) {
+        Log::info("Recorded %u frames of %s to %s\n", recording.frames,
+                  recording.scene.c_str(), Options::record.c_str());
+    }
+    else {
+        Log::error("Could not write recording to %s\n", Options::record.c_str());
+    }
+
+    recording.stream.clear();
+}
+
+bool
+CallRecorder::replay(Canvas &canvas, const std::string &filename, double duration)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) {
+        Log::error("Could not open recording %s\n", filename.c_str());
+        return false;
+    }
+
+    /* The data of the calls are passed to GL from here, in place */
+    std::vector<char> contents((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+    Reader header(contents.data(), contents.size());
+
+    if (header.string() != std::string(magic, sizeof(magic) - 1)) {
+        Log::error("%s is not a glmark2 recording\n", filename.c_str());
+        return false;
+    }
+
+    std::string scene = header.string();
+    int width = header.get<int32_t>();
+    int height = header.get<int32_t>();
+    GLuint canvas_fbo = header.get<uint32_t>();
+    unsigned int frames = header.get<uint32_t>();
+
+    /* Recorded ids are mapped to the entry points by name */
+    std::vector<PlayFunc> recorded_players;
+    unsigned int count = header.get<uint32_t>();
+    for (unsigned int i = 0; i < count && header.ok(); i++) {
+        std::string name = header.string();
+        bool used = header.get<uint8_t>();
+        std::vector<std::string>::const_iterator iter =
+            std::find(names.begin(), names.end(), name);
+        size_t index = iter - names.begin();
+
+        if (!used) {
+            recorded_players.push_back(0);
+        }
+        else if (iter != names.end() && loaded[index]()) {
+            recorded_players.push_back(players[index]);
+        }
+        else {
+            Log::error("Cannot replay %s: %s is not available\n",
+                       filename.c_str(), name.c_str());
+            return false;
+        }
+    }
+
+    size_t size;
+    const char *stream = static_cast<const char *>(header.data(size));
+    if (!stream || !header.ok()) {
+        Log::error("Recording %s is truncated\n", filename.c_str());
+        return false;
+    }
+
+    if (width != canvas.width() || height != canvas.height()) {
+        Log::info("Warning: %s was recorded at %dx%d, replaying at %dx%d\n",
+                  filename.c_str(), width, height, canvas.width(), canvas.height());
+    }
+
+    Player player(canvas_fbo, canvas.fbo());
+    Reader reader(stream, size);
+
+    /* Set up, then loop over the frames */
+    if (!play_until_frame(reader, recorded_players, player)) {
+        Log::error("Recording %s has no frames\n", filename.c_str());
+        return false;
+    }
+
+    size_t first_frame = reader.pos();
+    unsigned int frames_drawn = 0;
+    uint64_t start = Util::get_timestamp_us();
+    uint64_t now = start;
+
+    do {
+        if (reader.get<uint8_t>())
+            canvas.clear();
+        if (!play_until_frame(reader, recorded_players, player))
+            reader.seek(first_frame);
+        canvas.update();
+        frames_drawn++;
+        now = Util::get_timestamp_us();
+    } while (now - start < duration * 1000000.0 && !canvas.should_quit());
+
+    double elapsed = (now - start) / 1000000.0;
+
+    Log::info("[replay] %s (%u frames from %s): FPS: %u FrameTime: %.3f ms\n",
+              scene.c_str(), frames, filename.c_str(),
+              static_cast<unsigned int>(frames_drawn / elapsed + 0.5),
+              1000.0 * elapsed / frames_drawn);
+
+    return true;
+}
+
+CallRecorder::Scope::Scope()
+{
+    scope_depth++;
+}
+
+CallRecorder::Scope::~Scope()
+{
+    scope_depth--;
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_CALL_RECORDER_H_
+#define GLMARK2_CALL_RECORDER_H_
+
+#include <string>
+
+class Canvas;
+
+/**
+ * Records the GL calls of the setup and the first frames of a scene,
+ * with the data they upload, to a file (--record), and replays them
+ * with as little CPU work as possible (--replay).
+ *
+ * Comparing the FPS of a scene with those of its replay tells the CPU
+ * cost of glmark2 and the scene apart from that of the driver and GPU.
+ *
+ * Like the CallProfiler, the recorder wraps the loaded GL entry points.
+ * It is installed first, so the calls that the StateTracker skips are not
+ * recorded. Only the calls made by the thread that started the recording,
+ * inside a Scope, are recorded. Client-side vertex arrays, and the entry
+ * points that the scenes don't use, are not supported.
+ */
+class CallRecorder
+{
+public:
+    /**
+     * Wraps the loaded GL entry points, if enabled. Must be called each
+     * time the entry points are loaded, before CallProfiler::install().
+     */
+    static void install(bool enable);
+
+    /**
+     * Starts recording a scene, unless one has already been recorded.
+     *
+     * @param scene the name of the scene
+     * @param canvas_fbo the FBO the canvas draws to, which is replaced by
+     *                   that of the canvas in replays
+     * @param width the width of the canvas
+     * @param height the height of the canvas
+     */
+    static void begin(const std::string &scene, unsigned int canvas_fbo,
+                      int width, int height);
+
+    /**
+     * Marks the start of a frame.
+     *
+     * @param clear whether the canvas is cleared before the frame
+     */
+    static void begin_frame(bool clear);
+
+    /**
+     * Marks the end of a frame, and writes the recording once it has all
+     * the requested frames.
+     */
+    static void end_frame();
+
+    /**
+     * Stops recording at the end of the scene, writing the recording if it
+     * has any frames.
+     */
+    static void end();
+
+    /**
+     * Replays a recording, looping over its frames.
+     *
+     * @param canvas the canvas to replay on
+     * @param filename the recording to replay
+     * @param duration how long to replay for, in seconds
+     *
+     * @return whether the recording could be replayed
+     */
+    static bool replay(Canvas &canvas, const std::string &filename,
+                       double duration);
+
+    /**
+     * Records the calls made by the current thread during its lifetime.
+     */
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+    };
+};
+
+#endif /* GLMARK2_CALL_RECORDER_H_ */
@@ -23,15 +23,42 @@
 #include "canvas-android.h"
 #include "log.h"
 #include "options.h"
+#include "call-profiler.h"
+#include "flush-points.h"
+#include "call-recorder.h"
 #include "gl-headers.h"
+#include "util.h"
 
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <vector>
+
+#ifndef EGL_ANDROID_get_frame_timestamps
+#define EGL_TIMESTAMPS_ANDROID 0x3430
+#define EGL_COMPOSITE_INTERVAL_ANDROID 0x3432
+#define EGL_DISPLAY_PRESENT_TIME_ANDROID 0x343A
+#define EGL_TIMESTAMP_PENDING_ANDROID -2
+#define EGL_TIMESTAMP_INVALID_ANDROID -1
+#endif
 
 /******************
  * Public methods *
  ******************/
 
+CanvasAndroid::~CanvasAndroid()
+{
+    if (!window_ || egl_display_ == EGL_NO_DISPLAY)
+        return;
+
+    eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (egl_surface_ != EGL_NO_SURFACE)
+        eglDestroySurface(egl_display_, egl_surface_);
+    if (egl_context_ != EGL_NO_CONTEXT)
+        eglDestroyContext(egl_display_, egl_context_);
+    eglTerminate(egl_display_);
+}
+
 bool
 CanvasAndroid::init()
 {
@@ -51,22 +78,35 @@ CanvasAndroid::init()
         return false;
     }
 
-    /* Get the current EGL config */
-    EGLDisplay egl_display(eglGetCurrentDisplay());
+    EGLDisplay egl_display;
+    EGLConfig egl_config(0);
 
-    /* Reinitialize GLAD with a known display */
-    if (gladLoadEGLUserPtr(egl_display, load_proc, &egl_lib_) == 0) {
-        Log::error("Loading EGL entry points with display failed\n");
-        return false;
+    if (window_) {
+        /* Create our own context and surface for the window */
+        if (!init_window_surface(egl_config))
+            return false;
+        egl_display = egl_display_;
     }
+    else {
+        /* Get the current EGL config */
+        egl_display = eglGetCurrentDisplay();
+
+        /* Reinitialize GLAD with a known display */
+        if (gladLoadEGLUserPtr(egl_display, load_proc, &egl_lib_) == 0) {
+            Log::error("Loading EGL entry points with display failed\n");
+            return false;
+        }
 
-    EGLContext egl_context(eglGetCurrentContext());
-    EGLConfig egl_config(0);
-    EGLint num_configs;
+        EGLContext egl_context(eglGetCurrentContext());
+        EGLint num_configs;
+
+        eglQueryContext(egl_display, egl_context, EGL_CONFIG_ID, &(attribs[1]));
 
-    eglQueryContext(egl_display, egl_context, EGL_CONFIG_ID, &(attribs[1]));
+        eglChooseConfig(egl_display, attribs, &egl_config, 1, &num_configs);
 
-    eglChooseConfig(egl_display, attribs, &egl_config, 1, &num_configs);
+        egl_display_ = egl_display;
+        egl_surface_ = eglGetCurrentSurface(EGL_DRAW);
+    }
 
     /* Before calling GLES functions, init GLAD GLES */
     if (!gles_lib_.open("libGLESv2.so")) {
@@ -81,9 +121,14 @@ CanvasAndroid::init()
 
     resize(width_, height_);
 
-    if (!eglSwapInterval(egl_display, 0))
+    /* The native loop follows --swap-mode, GLSurfaceView never waits */
+    EGLint interval = window_ && (Options::swap_mode == Options::SwapModeFIFO ||
+                                  Options::swap_mode == Options::SwapModeRelaxed) ? 1 : 0;
+    if (!eglSwapInterval(egl_display, interval))
         Log::info("** Failed to set swap interval. Results may be bounded above by refresh rate.\n");
 
+    init_frame_timestamps();
+
     init_gl_extensions();
 
     glEnable(GL_DEPTH_TEST);
@@ -139,6 +184,36 @@ CanvasAndroid::clear()
 void
 CanvasAndroid::update()
 {
+    /*
+     * With GLSurfaceView, the frame is swapped by the Java code right
+     * after this, so its submit time is slightly early.
+     */
+    EGLuint64KHR frame_id = 0;
+    bool have_frame_id = get_next_frame_id_ &&
+                         get_next_frame_id_(egl_display_, egl_surface_, &frame_id);
+    uint64_t submit_time = Util::get_timestamp_us();
+
+    if (window_) {
+        eglSwapBuffers(egl_display_, egl_surface_);
+
+        /* Follows the size of the window, as GLSurfaceView does */
+        EGLint width = width_;
+        EGLint height = height_;
+        eglQuerySurface(egl_display_, egl_surface_, EGL_WIDTH, &width);
+        eglQuerySurface(egl_display_, egl_surface_, EGL_HEIGHT, &height);
+        if (width != width_ || height != height_) {
+            Log::debug("Resizing to %d x %d\n", width, height);
+            resize(width, height);
+        }
+    }
+
+    if (get_frame_timestamps_) {
+        if (have_frame_id) {
+            PendingFrame frame = { frame_id, submit_time };
+            pending_frames_.push_back(frame);
+        }
+        collect_frame_timestamps();
+    }
 }
 
 void
@@ -203,10 +278,188 @@ CanvasAndroid::resize(int width, int height)
                                                1.0, 1024.0);
 }
 
+void
+CanvasAndroid::take_presentations(PresentationList &list)
+{
+    list.insert(list.end(), presentations_.begin(), presentations_.end());
+    presentations_.clear();
+}
+
 /*******************
  * Private methods *
  *******************/
 
+/*
+ * Creates a GLES2.0 context and a surface for the native window, with the
+ * config that best matches --visual-config.
+ */
+bool
+CanvasAndroid::init_window_surface(EGLConfig &egl_config)
+{
+    static const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+    static const EGLint context_attribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 2,
+        EGL_NONE
+    };
+
+    egl_display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (egl_display_ == EGL_NO_DISPLAY || !eglInitialize(egl_display_, 0, 0)) {
+        Log::error("eglInitialize() failed with error: 0x%x\n", eglGetError());
+        return false;
+    }
+
+    if (gladLoadEGLUserPtr(egl_display_, load_proc, &egl_lib_) == 0) {
+        Log::error("Loading EGL entry points with display failed\n");
+        return false;
+    }
+
+    EGLint num_configs = 0;
+    if (!eglChooseConfig(egl_display_, config_attribs, 0, 0, &num_configs) ||
+        num_configs == 0)
+    {
+        Log::error("No suitable EGLConfig for GLES2.0 found\n");
+        return false;
+    }
+
+    std::vector<EGLConfig> configs(num_configs);
+    eglChooseConfig(egl_display_, config_attribs, &configs[0], num_configs, &num_configs);
+
+    int best_score = 0;
+    for (int i = 0; i < num_configs; i++) {
+        GLVisualConfig vc;
+        eglGetConfigAttrib(egl_display_, configs[i], EGL_BUFFER_SIZE, &vc.buffer);
+        eglGetConfigAttrib(egl_display_, configs[i], EGL_RED_SIZE, &vc.red);
+        eglGetConfigAttrib(egl_display_, configs[i], EGL_GREEN_SIZE, &vc.green);
+        eglGetConfigAttrib(egl_display_, configs[i], EGL_BLUE_SIZE, &vc.blue);
+        eglGetConfigAttrib(egl_display_, configs[i], EGL_ALPHA_SIZE, &vc.alpha);
+        eglGetConfigAttrib(egl_display_, configs[i], EGL_DEPTH_SIZE, &vc.depth);
+        eglGetConfigAttrib(egl_display_, configs[i], EGL_STENCIL_SIZE, &vc.stencil);
+
+        int score = vc.match_score(Options::visual_config);
+        if (i == 0 || score > best_score) {
+            best_score = score;
+            egl_config = configs[i];
+        }
+    }
+
+    egl_context_ = eglCreateContext(egl_display_, egl_config, EGL_NO_CONTEXT,
+                                    context_attribs);
+    if (egl_context_ == EGL_NO_CONTEXT) {
+        Log::error("eglCreateContext() failed with error: 0x%x\n", eglGetError());
+        return false;
+    }
+
+    egl_surface_ = eglCreateWindowSurface(egl_display_, egl_config,
+                                          reinterpret_cast<EGLNativeWindowType>(window_), 0);
+    if (egl_surface_ == EGL_NO_SURFACE) {
+        Log::error("eglCreateWindowSurface() failed with error: 0x%x\n", eglGetError());
+        return false;
+    }
+
+    if (!eglMakeCurrent(egl_display_, egl_surface_, egl_surface_, egl_context_)) {
+        Log::error("eglMakeCurrent() failed with error: 0x%x\n", eglGetError());
+        return false;
+    }
+
+    eglQuerySurface(egl_display_, egl_surface_, EGL_WIDTH, &width_);
+    eglQuerySurface(egl_display_, egl_surface_, EGL_HEIGHT, &height_);
+
+    return true;
+}
+
+void
+CanvasAndroid::init_frame_timestamps()
+{
+    get_next_frame_id_ = 0;
+    get_frame_timestamps_ = 0;
+    refresh_ = 0;
+    pending_frames_.clear();
+
+    const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+    if (egl_surface_ == EGL_NO_SURFACE || !extensions ||
+        !strstr(extensions, "EGL_ANDROID_get_frame_timestamps"))
+    {
+        return;
+    }
+
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC get_next_frame_id =
+        reinterpret_cast<PFNEGLGETNEXTFRAMEIDANDROIDPROC>(
+            eglGetProcAddress("eglGetNextFrameIdANDROID"));
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC get_frame_timestamps =
+        reinterpret_cast<PFNEGLGETFRAMETIMESTAMPSANDROIDPROC>(
+            eglGetProcAddress("eglGetFrameTimestampsANDROID"));
+    PFNEGLGETCOMPOSITORTIMINGANDROIDPROC get_compositor_timing =
+        reinterpret_cast<PFNEGLGETCOMPOSITORTIMINGANDROIDPROC>(
+            eglGetProcAddress("eglGetCompositorTimingANDROID"));
+
+    /* The refresh period is also the target of the performance hints */
+    static const EGLint interval_name = EGL_COMPOSITE_INTERVAL_ANDROID;
+    EGLnsecsANDROID interval = 0;
+    if (get_compositor_timing &&
+        get_compositor_timing(egl_display_, egl_surface_, 1, &interval_name, &interval) &&
+        interval > 0)
+    {
+        refresh_ = interval / 1000;
+    }
+
+    if (!Options::present_timing)
+        return;
+
+    if (!get_next_frame_id || !get_frame_timestamps ||
+        !eglSurfaceAttrib(egl_display_, egl_surface_, EGL_TIMESTAMPS_ANDROID, EGL_TRUE))
+    {
+        Log::debug("Failed to enable EGL frame timestamps\n");
+        return;
+    }
+
+    get_next_frame_id_ = get_next_frame_id;
+    get_frame_timestamps_ = get_frame_timestamps;
+
+    Log::debug("Using EGL_ANDROID_get_frame_timestamps for presentation feedback\n");
+}
+
+/*
+ * Gets the present times of the swapped frames, in order, stopping at the
+ * first frame that is not presented yet.
+ */
+void
+CanvasAndroid::collect_frame_timestamps()
+{
+    /* Only a few frames of history are kept by EGL */
+    static const size_t max_pending_frames = 16;
+    static const EGLint present_name = EGL_DISPLAY_PRESENT_TIME_ANDROID;
+
+    while (pending_frames_.size() > max_pending_frames)
+        pending_frames_.pop_front();
+
+    while (!pending_frames_.empty()) {
+        const PendingFrame& frame(pending_frames_.front());
+        EGLnsecsANDROID present_time = EGL_TIMESTAMP_INVALID_ANDROID;
+
+        if (get_frame_timestamps_(egl_display_, egl_surface_, frame.id,
+                                  1, &present_name, &present_time) &&
+            present_time == EGL_TIMESTAMP_PENDING_ANDROID)
+        {
+            break;
+        }
+
+        /* The timestamps are in CLOCK_MONOTONIC, like Util::get_timestamp_us() */
+        if (present_time >= 0) {
+            Presentation presentation;
+            presentation.submit_time = frame.submit_time;
+            presentation.present_time = present_time / 1000;
+            presentation.refresh = refresh_;
+            presentations_.push_back(presentation);
+        }
+
+        pending_frames_.pop_front();
+    }
+}
+
 GLADapiproc
 CanvasAndroid::load_proc(void *userdata, const char *name)
 {
@@ -240,4 +493,10 @@ CanvasAndroid::init_gl_extensions()
     GLExtensions::RenderbufferStorage = glRenderbufferStorage;
 
     GLExtensions::GenerateMipmap = glGenerateMipmap;
+
+    GLExtensions::load_optional(load_proc, &gles_lib_);
+    CallRecorder::install(!Options::record.empty());
+    CallProfiler::install(Options::profile_gl_calls);
+    StateTracker::install(Options::state_tracking);
+    FlushPoints::install(Options::flush_points);
 }
@@ -26,19 +26,31 @@
 #include "shared-library.h"
 #include "glad/egl.h"
 
+#include <android/native_window.h>
+#include <deque>
+
+/* EGL_ANDROID_get_frame_timestamps */
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLGETNEXTFRAMEIDANDROIDPROC)(EGLDisplay dpy, EGLSurface surface, EGLuint64KHR *frameId);
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLGETCOMPOSITORTIMINGANDROIDPROC)(EGLDisplay dpy, EGLSurface surface, EGLint numTimestamps, const EGLint *names, EGLnsecsANDROID *values);
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLGETFRAMETIMESTAMPSANDROIDPROC)(EGLDisplay dpy, EGLSurface surface, EGLuint64KHR frameId, EGLint numTimestamps, const EGLint *timestamps, EGLnsecsANDROID *values);
+
 /**
  * Canvas for rendering to Android surfaces.
  *
- * This class doesn't perform any GLES2.0 surface and context management
- * (contrary to the CanvasX11* classes); these are handled in the Java
- * Android code.
+ * Without a native window, this class doesn't perform any GLES2.0 surface
+ * and context management (contrary to the CanvasX11* classes); these are
+ * handled by the GLSurfaceView of the Java Android code. With a native
+ * window (--android-native-loop), it creates its own context and surface
+ * for the window and swaps the buffers in update().
  */
 class CanvasAndroid : public Canvas
 {
 public:
-    CanvasAndroid(int width, int height) :
-        Canvas(width, height) {}
-    ~CanvasAndroid() {}
+    CanvasAndroid(int width, int height, ANativeWindow *window = 0) :
+        Canvas(width, height), window_(window), egl_display_(EGL_NO_DISPLAY),
+        egl_surface_(EGL_NO_SURFACE), egl_context_(EGL_NO_CONTEXT),
+        get_next_frame_id_(0), get_frame_timestamps_(0), refresh_(0) {}
+    ~CanvasAndroid();
 
     bool init();
     void visible(bool visible);
@@ -49,14 +61,41 @@ public:
     void write_to_file(std::string &filename);
     bool should_quit();
     void resize(int width, int height);
+    void take_presentations(PresentationList &list);
+
+    /**
+     * Gets the refresh period of the display.
+     *
+     * @return the period in microseconds, or 0 if unknown
+     */
+    uint64_t refresh() { return refresh_; }
 
 private:
+    struct PendingFrame
+    {
+        EGLuint64KHR id;
+        uint64_t submit_time;
+    };
+
+    ANativeWindow *window_;
+    EGLDisplay egl_display_;
+    EGLSurface egl_surface_;
+    EGLContext egl_context_;
     SharedLibrary egl_lib_;
     SharedLibrary gles_lib_;
     GLVisualConfig chosen_config_;
+    // Presentation feedback with --present-timing
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC get_next_frame_id_;
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC get_frame_timestamps_;
+    uint64_t refresh_;
+    std::deque<PendingFrame> pending_frames_;
+    PresentationList presentations_;
 
     static GLADapiproc load_proc(void *userdata, const char *name);
     void init_gl_extensions();
+    bool init_window_surface(EGLConfig &egl_config);
+    void init_frame_timestamps();
+    void collect_frame_timestamps();
 };
 
 #endif
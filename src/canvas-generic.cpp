@@ -26,9 +26,14 @@
 #include "log.h"
 #include "options.h"
 #include "util.h"
+#include "startup-report.h"
+#include "trace.h"
+#include "debug-markers.h"
 
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <algorithm>
 
 /******************
  * Public methods *
@@ -37,18 +42,39 @@
 bool
 CanvasGeneric::init()
 {
-    if (!native_state_.init_display())
-        return false;
+    StartupReport::Phase phase("canvas-init");
 
-    if (!gl_state_.init_display(native_state_.display(), visual_config_))
-        return false;
+    {
+        StartupReport::Phase phase("native-display");
+        if (!native_state_.init_display())
+            return false;
+    }
+
+    {
+        StartupReport::Phase phase("gl-display");
+        if (!gl_state_.init_display(native_state_.display(), visual_config_))
+            return false;
+    }
+
+    {
+        StartupReport::Phase phase("gl-context");
+        if (!reset())
+            return false;
+    }
 
-    return reset();
+    use_fences_ = native_state_.supports_fences() &&
+                  gl_state_.supports_native_fences();
+    if (use_fences_)
+        Log::debug("Flipping frames with explicit fences\n");
+
+    return true;
 }
 
 bool
 CanvasGeneric::reset()
 {
+    release_readback();
+    release_frame_fences();
     release_fbo();
 
     if (!gl_state_.reset())
@@ -96,11 +122,16 @@ CanvasGeneric::clear()
     glClearDepthf(1.0f);
 #endif
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    msaa_resolved_ = false;
+    post_processed_ = false;
+    scaled_up_ = false;
 }
 
 void
 CanvasGeneric::update()
 {
+    Trace::Scope trace("frame-end");
     Options::FrameEnd m = Options::frame_end;
 
     if (m == Options::FrameEndDefault) {
@@ -110,10 +141,57 @@ CanvasGeneric::update()
             m = Options::FrameEndSwap;
     }
 
+    resolve_post_process();
+    resolve_msaa();
+    resolve_render_scale();
+
+    /* The damage is in the scaled frame, but the whole frame is scaled up */
+    if (scaled_fbo_)
+        damage_.clear();
+
+    /*
+     * The depth and stencil contents aren't needed after the frame, so
+     * tile-based GPUs don't have to write them back to memory. Neither are
+     * the color samples, once they have been resolved by a blit, unless only
+     * part of the frame changed and the rest is kept for the next.
+     */
+    if (Options::invalidate && GLExtensions::InvalidateFramebuffer) {
+        static const GLenum default_attachments[] = { GL_DEPTH, GL_STENCIL };
+        static const GLenum fbo_attachments[] = {
+            GL_DEPTH_ATTACHMENT, GL_STENCIL_ATTACHMENT, GL_COLOR_ATTACHMENT0
+        };
+
+        /* The post-processed frame may only be partially redrawn, but not its depth */
+        if (post_process_.fbo()) {
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, post_process_.fbo());
+            GLExtensions::InvalidateFramebuffer(GL_FRAMEBUFFER, 1, fbo_attachments);
+        }
+        if (scaled_fbo_) {
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, scaled_fbo_);
+            GLExtensions::InvalidateFramebuffer(GL_FRAMEBUFFER, 1, fbo_attachments);
+        }
+
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        GLExtensions::InvalidateFramebuffer(GL_FRAMEBUFFER,
+                                            resolve_fbo_ && damage_.empty() ? 3 : 2,
+                                            fbo_ ? fbo_attachments : default_attachments);
+    }
+
     switch(m) {
         case Options::FrameEndSwap:
-            gl_state_.swap();
-            native_state_.flip();
+            if (use_fences_) {
+                int render_fence = gl_state_.swap_with_fence();
+                int flip_fence = native_state_.flip_with_fence(render_fence);
+                /* Don't render to the buffer on screen before it is flipped out */
+                gl_state_.wait_native_fence(flip_fence);
+            }
+            else {
+                if (damage_.empty())
+                    gl_state_.swap();
+                else
+                    gl_state_.swap_with_damage(damage_);
+                native_state_.flip();
+            }
             break;
         case Options::FrameEndFinish:
             glFinish();
@@ -121,36 +199,148 @@ CanvasGeneric::update()
         case Options::FrameEndReadPixels:
             read_pixel(width_ / 2, height_ / 2);
             break;
+        case Options::FrameEndReadPixelsAsync:
+            read_pixels_async();
+            break;
+        case Options::FrameEndFence:
+            limit_frames_in_flight();
+            break;
         case Options::FrameEndNone:
         default:
             break;
     }
+
+    if (fbo_)
+        next_offscreen_buffer();
+
+    /* The next frame isn't always cleared first, see Scene::needs_clear() */
+    msaa_resolved_ = false;
+    post_processed_ = false;
+    scaled_up_ = false;
+    damage_.clear();
+
+    if (post_process_.fbo())
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, post_process_.fbo());
+    else if (scaled_fbo_)
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, scaled_fbo_);
+}
+
+unsigned int
+CanvasGeneric::buffer_age()
+{
+    /*
+     * The frames rendered to a FBO are never swapped out, but with a ring
+     * of buffers the current one was last drawn to a full turn ago. The
+     * scaled frames don't line up with the previous ones once the scale
+     * changes, so they are always redrawn in full.
+     */
+    if (scaled_fbo_)
+        return 0;
+
+    if (fbo_) {
+        unsigned int count = offscreen_buffers_.size();
+
+        if (post_process_.fbo() || count < 2)
+            return 1;
+
+        return offscreen_frames_ >= count ? count : 0;
+    }
+
+    return gl_state_.buffer_age();
+}
+
+void
+CanvasGeneric::damage_region(const std::vector<int> &rects)
+{
+    /* The FBO of off-screen rendering keeps all its contents anyway */
+    if (!fbo_ && !scaled_fbo_)
+        gl_state_.set_damage_region(rects);
+}
+
+void
+CanvasGeneric::take_presentations(PresentationList &list)
+{
+    /* At most one of them reports presentations for a given setup */
+    gl_state_.take_presentations(list);
+    native_state_.take_presentations(list);
+}
+
+uint64_t
+CanvasGeneric::take_flip_wait_us()
+{
+    return native_state_.take_flip_wait_us();
 }
 
 void
 CanvasGeneric::print_info()
+{
+    InfoList canvas_info(info());
+    std::stringstream ss;
+
+    ss << "    OpenGL Information" << std::endl;
+    for (InfoList::const_iterator iter = canvas_info.begin();
+         iter != canvas_info.end();
+         iter++)
+    {
+        ss << "    " << std::left << std::setw(16) << (iter->first + ":")
+           << iter->second << std::endl;
+    }
+
+    Log::info("%s", ss.str().c_str());
+}
+
+Canvas::InfoList
+CanvasGeneric::info()
 {
     do_make_current();
 
-    std::stringstream ss;
+    InfoList canvas_info;
+    std::stringstream config_ss;
+    std::stringstream size_ss;
     GLVisualConfig config;
     NativeState::WindowProperties win_props;
 
     gl_state_.getVisualConfig(config);
     native_state_.window(win_props);
 
-    ss << "    OpenGL Information" << std::endl;
-    ss << "    GL_VENDOR:      " << glGetString(GL_VENDOR) << std::endl;
-    ss << "    GL_RENDERER:    " << glGetString(GL_RENDERER) << std::endl;
-    ss << "    GL_VERSION:     " << glGetString(GL_VERSION) << std::endl;
-    ss << "    Surface Config: " << "buf=" << config.buffer
-       << " r=" << config.red << " g=" << config.green << " b=" << config.blue
-       << " a=" << config.alpha << " depth=" << config.depth
-       << " stencil=" << config.stencil << std::endl;
-    ss << "    Surface Size:   " << win_props.width << "x" << win_props.height
-       << (win_props.fullscreen ? " fullscreen" : " windowed") << std::endl;
+    config_ss << "buf=" << config.buffer
+              << " r=" << config.red << " g=" << config.green << " b=" << config.blue
+              << " a=" << config.alpha << " depth=" << config.depth
+              << " stencil=" << config.stencil;
+    if (config.fp)
+        config_ss << " fp";
+    if (config.srgb)
+        config_ss << " srgb";
+    size_ss << win_props.width << "x" << win_props.height
+            << (win_props.fullscreen ? " fullscreen" : " windowed");
+    if (msaa_samples_) {
+        size_ss << " " << msaa_samples_ << "x MSAA ("
+                << (msaa_implicit_ ? "implicit" : "blit") << " resolve)";
+    }
+    if (post_process_.fbo())
+        size_ss << " post-processed (" << post_process_.description() << ")";
+    if (scaled_fbo_)
+        size_ss << " dynamic resolution";
+
+    canvas_info.push_back(std::make_pair("GL_VENDOR", gl_string(GL_VENDOR)));
+    canvas_info.push_back(std::make_pair("GL_RENDERER", gl_string(GL_RENDERER)));
+    canvas_info.push_back(std::make_pair("GL_VERSION", gl_string(GL_VERSION)));
+    std::string platform_version(gl_state_.platform_version());
+    if (!platform_version.empty())
+        canvas_info.push_back(std::make_pair("Platform", platform_version));
+    canvas_info.push_back(std::make_pair("Surface Config", config_ss.str()));
+    canvas_info.push_back(std::make_pair("Surface Size", size_ss.str()));
+
+    /* Frames rendered off-screen are never swapped */
+    if (!offscreen_) {
+        std::string swap_mode(native_state_.swap_mode());
+        if (swap_mode.empty())
+            swap_mode = gl_state_.swap_mode();
+        canvas_info.push_back(std::make_pair("Swap Mode",
+                                             swap_mode.empty() ? "unknown" : swap_mode));
+    }
 
-    Log::info("%s", ss.str().c_str());
+    return canvas_info;
 }
 
 Canvas::Pixel
@@ -158,27 +348,105 @@ CanvasGeneric::read_pixel(int x, int y)
 {
     uint8_t pixel[4];
 
-    glReadPixels(x, y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    read_rgba8(x, y, 1, 1, pixel);
 
     return Canvas::Pixel(pixel[0], pixel[1], pixel[2], pixel[3]);
 }
 
+/*
+ * GLES only guarantees RGBA/UNSIGNED_BYTE reads from fixed point buffers,
+ * floating point buffers are read as floats and converted here.
+ */
+bool
+CanvasGeneric::reads_float()
+{
+#if GLMARK2_USE_GLESv2
+    GLVisualConfig vc;
+    gl_state_.getVisualConfig(vc);
+    return vc.fp;
+#else
+    return false;
+#endif
+}
+
+void
+CanvasGeneric::read_rgba8(int x, int y, int width, int height, void *pixels)
+{
+    if (!reads_float()) {
+        begin_read_pixels();
+        glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        end_read_pixels();
+        return;
+    }
+
+    std::vector<float> data(static_cast<size_t>(width) * height * 4);
+
+    begin_read_pixels();
+    glReadPixels(x, y, width, height, GL_RGBA, GL_FLOAT, &data[0]);
+    end_read_pixels();
+
+    uint8_t *out = static_cast<uint8_t *>(pixels);
+    for (size_t i = 0; i < data.size(); i++) {
+        float c = std::min(std::max(data[i], 0.0f), 1.0f);
+        out[i] = static_cast<uint8_t>(c * 255.0f + 0.5f);
+    }
+}
+
 void
 CanvasGeneric::write_to_file(std::string &filename)
 {
     char *pixels = new char[width_ * height_ * 4];
+    int stride = width_ * 4;
 
-    for (int i = 0; i < height_; i++) {
-        glReadPixels(0, i, width_, 1, GL_RGBA, GL_UNSIGNED_BYTE,
-                     &pixels[(height_ - i - 1) * width_ * 4]);
-    }
+    /* Read the whole frame at once, and flip it while writing */
+    read_rgba8(0, 0, width_, height_, pixels);
 
     std::ofstream output (filename.c_str(), std::ios::out | std::ios::binary);
-    output.write(pixels, 4 * width_ * height_);
+    for (int i = height_ - 1; i >= 0; i--)
+        output.write(&pixels[i * stride], stride);
 
     delete [] pixels;
 }
 
+/*
+ * Reads the frame with a single glReadPixels, into a pixel pack buffer when
+ * possible so the driver copies it out in one go instead of row by row.
+ */
+bool
+CanvasGeneric::read_frame(std::vector<uint8_t> &pixels)
+{
+    size_t size = static_cast<size_t>(width_) * height_ * 4;
+
+    pixels.resize(size);
+
+    if (!supports_async_readback() || reads_float()) {
+        read_rgba8(0, 0, width_, height_, &pixels[0]);
+        return true;
+    }
+
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, 0, GL_STREAM_READ);
+
+    begin_read_pixels();
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    end_read_pixels();
+
+    void *data = GLExtensions::MapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size,
+                                              GL_MAP_READ_BIT);
+    if (data) {
+        std::copy(static_cast<uint8_t *>(data),
+                  static_cast<uint8_t *>(data) + size, pixels.begin());
+        GLExtensions::UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteBuffers(1, &buffer);
+
+    return data != 0;
+}
+
 bool
 CanvasGeneric::should_quit()
 {
@@ -192,10 +460,77 @@ CanvasGeneric::resize(int width, int height)
     glViewport(0, 0, width_, height_);
 }
 
+/*
+ * Renders to the lower left part of the full size scaled_fbo_, so changing
+ * the scale doesn't reallocate anything.
+ */
+void
+CanvasGeneric::render_scale(double scale)
+{
+    if (!scaled_fbo_)
+        return;
+
+    int width = std::max(static_cast<int>(width_ * scale + 0.5), 1);
+    int height = std::max(static_cast<int>(height_ * scale + 0.5), 1);
+
+    if (width >= width_ && height >= height_) {
+        render_width_ = 0;
+        render_height_ = 0;
+    }
+    else {
+        render_width_ = std::min(width, width_);
+        render_height_ = std::min(height, height_);
+    }
+
+    glViewport(0, 0, this->width(), this->height());
+}
+
 unsigned int
 CanvasGeneric::fbo()
 {
-    return fbo_;
+    if (scaled_fbo_)
+        return scaled_fbo_;
+
+    GLuint post_process_fbo = post_process_.fbo();
+
+    return post_process_fbo ? post_process_fbo : fbo_;
+}
+
+int
+CanvasGeneric::create_native_fence()
+{
+    return gl_state_.create_native_fence();
+}
+
+bool
+CanvasGeneric::create_dma_buf(unsigned int width, unsigned int height,
+                              unsigned int cpp, const void *data, DmaBuf &buf)
+{
+    return native_state_.create_dma_buf(width, height, cpp, data, buf);
+}
+
+void
+CanvasGeneric::destroy_dma_buf(DmaBuf &buf)
+{
+    native_state_.destroy_dma_buf(buf);
+}
+
+void *
+CanvasGeneric::create_dma_buf_image(const DmaBufImage &image)
+{
+    return gl_state_.create_dma_buf_image(image);
+}
+
+void
+CanvasGeneric::destroy_dma_buf_image(void *image)
+{
+    gl_state_.destroy_dma_buf_image(image);
+}
+
+GLWorkerContext *
+CanvasGeneric::create_worker_context(bool shared, Options::ContextPriority priority)
+{
+    return gl_state_.create_worker_context(shared, priority);
 }
 
 
@@ -234,6 +569,26 @@ CanvasGeneric::resize_no_viewport(int width, int height)
 {
     bool request_fullscreen = (width == -1 && height == -1);
 
+    /*
+     * Off-screen rendering only uses the window to create the GL surface,
+     * so the FBO can be resized without recreating the window.
+     */
+    if (offscreen_ && window_initialized_ && !request_fullscreen) {
+        width_ = width;
+        height_ = height;
+
+        if (fbo_)
+            allocate_fbo_storage();
+        if (post_process_.fbo() && !post_process_.init(width_, height_, gl_depth_format_, fbo_))
+            return false;
+        if (scaled_fbo_)
+            allocate_scaled_storage();
+
+        projection_ = LibMatrix::Mat4::perspective(60.0, width_ / static_cast<float>(height_),
+                                                   1.0, 1024.0);
+        return true;
+    }
+
     intptr_t vid;
     if (!gl_state_.gotNativeConfig(vid))
     {
@@ -267,17 +622,12 @@ CanvasGeneric::resize_no_viewport(int width, int height)
     width_ = cur_properties.width;
     height_ = cur_properties.height;
 
-    if (color_renderbuffer_) {
-        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer_);
-        GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, gl_color_format_,
-                                          width_, height_);
-    }
-
-    if (depth_renderbuffer_) {
-        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_);
-        GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, gl_depth_format_,
-                                          width_, height_);
-    }
+    if (fbo_)
+        allocate_fbo_storage();
+    if (post_process_.fbo() && !post_process_.init(width_, height_, gl_depth_format_, fbo_))
+        return false;
+    if (scaled_fbo_)
+        allocate_scaled_storage();
 
     projection_ = LibMatrix::Mat4::perspective(60.0, width_ / static_cast<float>(height_),
                                                1.0, 1024.0);
@@ -316,6 +666,33 @@ CanvasGeneric::do_make_current()
         GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
     }
 
+    if (PostProcess::enabled()) {
+        if (!ensure_post_process())
+            return false;
+
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, post_process_.fbo());
+    }
+
+    if (Options::dynamic_resolution > 0.0) {
+        if (!ensure_scaled_fbo())
+            return false;
+
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, scaled_fbo_);
+    }
+
+#if GLMARK2_USE_GL
+    /* Desktop GL only encodes into sRGB framebuffers when asked to */
+    GLVisualConfig vc;
+    gl_state_.getVisualConfig(vc);
+    if (vc.srgb)
+        glEnable(GL_FRAMEBUFFER_SRGB);
+#endif
+
+    if (Options::sample_shading > 0.0f && GLExtensions::MinSampleShading) {
+        glEnable(GL_SAMPLE_SHADING);
+        GLExtensions::MinSampleShading(Options::sample_shading);
+    }
+
     return true;
 }
 
@@ -357,7 +734,32 @@ CanvasGeneric::ensure_gl_formats()
     supports_depth32 = true;
 #endif
 
-    if (vc.buffer == 32) {
+    /*
+     * The wide gamut and high bit depth formats are color-renderable in
+     * GL 3.0 and GLES 3.0, except FP16 which needs an extension on GLES.
+     */
+    bool gl3 = GLExtensions::version_supported(3, 0);
+#if GLMARK2_USE_GLESv2
+    bool supports_rgba16f = gl3 &&
+                            (GLExtensions::support("GL_EXT_color_buffer_half_float") ||
+                             GLExtensions::support("GL_EXT_color_buffer_float"));
+#elif GLMARK2_USE_GL
+    bool supports_rgba16f = gl3;
+#endif
+
+    if (vc.fp) {
+        if (vc.red == 16 && supports_rgba16f)
+            gl_color_format_ = GL_RGBA16F;
+    }
+    else if (vc.red == 10 && vc.green == 10 && vc.blue == 10) {
+        if (gl3)
+            gl_color_format_ = GL_RGB10_A2;
+    }
+    else if (vc.srgb) {
+        if (gl3)
+            gl_color_format_ = GL_SRGB8_ALPHA8;
+    }
+    else if (vc.buffer == 32) {
         if (supports_rgba8)
             gl_color_format_ = GL_RGBA8;
         else
@@ -394,6 +796,11 @@ CanvasGeneric::ensure_gl_formats()
     else if (vc.depth == 16)
         gl_depth_format_ = GL_DEPTH_COMPONENT16;
 
+    if (!gl_color_format_) {
+        Log::error("The color format of the visual config is not renderable"
+                   " off-screen in this GL implementation\n");
+    }
+
     Log::debug("Selected Renderbuffer ColorFormat: %s DepthFormat: %s\n",
                get_gl_format_str(gl_color_format_),
                get_gl_format_str(gl_depth_format_));
@@ -405,51 +812,658 @@ bool
 CanvasGeneric::ensure_fbo()
 {
     if (!fbo_) {
-        if (!ensure_gl_formats())
+        if (!ensure_gl_formats() || !ensure_msaa_config())
             return false;
 
-        /* Create a texture for the color attachment  */
-        GLExtensions::GenRenderbuffers(1, &color_renderbuffer_);
-        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer_);
-        GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, gl_color_format_,
-                                          width_, height_);
+        /*
+         * Create the color and depth attachments of each buffer of the ring.
+         * Implicitly resolved MSAA renders to a texture, and blit resolved
+         * MSAA needs a single-sampled renderbuffer to resolve into. The
+         * validation only draws one frame, and reads it after it ends.
+         */
+        unsigned int count = Options::validate ? 1 : std::max(Options::offscreen_buffers, 1U);
+
+        offscreen_buffers_.resize(count);
+        for (unsigned int i = 0; i < count; i++) {
+            OffscreenBuffer &buffer(offscreen_buffers_[i]);
+
+            if (msaa_implicit_)
+                glGenTextures(1, &buffer.color_texture);
+            else
+                GLExtensions::GenRenderbuffers(1, &buffer.color_renderbuffer);
+            GLExtensions::GenRenderbuffers(1, &buffer.depth_renderbuffer);
+            if (msaa_samples_ && !msaa_implicit_)
+                GLExtensions::GenRenderbuffers(1, &buffer.resolve_renderbuffer);
+        }
+        offscreen_index_ = 0;
 
-        /* Create a renderbuffer for the depth attachment */
-        GLExtensions::GenRenderbuffers(1, &depth_renderbuffer_);
-        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_);
-        GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, gl_depth_format_,
-                                          width_, height_);
+        allocate_fbo_storage();
 
-        /* Create a FBO and set it up */
+        /* Create a FBO, and the FBO the samples are resolved into, and set them up */
         GLExtensions::GenFramebuffers(1, &fbo_);
-        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
-        GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-                                              GL_RENDERBUFFER, color_renderbuffer_);
-        GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
-                                              GL_RENDERBUFFER, depth_renderbuffer_);
+        if (offscreen_buffers_[0].resolve_renderbuffer)
+            GLExtensions::GenFramebuffers(1, &resolve_fbo_);
+
+        attach_offscreen_buffer();
+        DebugMarkers::label(GL_FRAMEBUFFER, fbo_, "canvas");
+
+        GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+
+        if (status == GL_FRAMEBUFFER_COMPLETE && resolve_fbo_) {
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, resolve_fbo_);
+            status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        }
+
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            Log::error("Failed to create the off-screen framebuffer (status 0x%x)\n",
+                       status);
+            return false;
+        }
     }
 
     return true;
 }
 
+bool
+CanvasGeneric::ensure_post_process()
+{
+    if (post_process_.fbo())
+        return true;
+
+    if (Options::msaa_samples) {
+        Log::error("--hdr and --post-process can't be combined with --msaa\n");
+        return false;
+    }
+
+    /* The frames keep the depth format of the visual */
+    if (!ensure_gl_formats())
+        return false;
+
+    return post_process_.init(width_, height_, gl_depth_format_, fbo_);
+}
+
+bool
+CanvasGeneric::ensure_msaa_config()
+{
+    msaa_samples_ = 0;
+    msaa_implicit_ = false;
+
+    if (Options::msaa_samples == 0)
+        return true;
+
+    bool implicit_supported = GLExtensions::FramebufferTexture2DMultisample &&
+                              GLExtensions::RenderbufferStorageMultisampleImplicit;
+    bool blit_supported = GLExtensions::RenderbufferStorageMultisample &&
+                          GLExtensions::BlitFramebuffer;
+    bool implicit = Options::msaa_resolve == Options::MsaaResolveImplicit ||
+                    (Options::msaa_resolve == Options::MsaaResolveAuto &&
+                     implicit_supported);
+
+    if (implicit && !implicit_supported) {
+        Log::error("Implicitly resolved MSAA requires"
+                   " GL_EXT_multisampled_render_to_texture\n");
+        return false;
+    }
+
+    if (!implicit && !blit_supported) {
+        Log::error("MSAA requires multisampled renderbuffers and framebuffer blits\n");
+        return false;
+    }
+
+    /* GL_MAX_SAMPLES_EXT has the same value, for the implicit resolve */
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+
+    if (Options::msaa_samples > static_cast<unsigned int>(max_samples)) {
+        Log::error("Requested %u MSAA samples but at most %d are supported\n",
+                   Options::msaa_samples, max_samples);
+        return false;
+    }
+
+    msaa_samples_ = Options::msaa_samples;
+    msaa_implicit_ = implicit;
+
+    Log::debug("Selected MSAA: %u samples, %s resolve\n", msaa_samples_,
+               msaa_implicit_ ? "implicit" : "blit");
+
+    return true;
+}
+
+void
+CanvasGeneric::renderbuffer_storage(GLuint renderbuffer, GLenum format,
+                                    unsigned int samples)
+{
+    if (!renderbuffer)
+        return;
+
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+
+    if (samples == 0) {
+        GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, format,
+                                          width_, height_);
+    }
+    else if (msaa_implicit_) {
+        GLExtensions::RenderbufferStorageMultisampleImplicit(GL_RENDERBUFFER, samples,
+                                                             format, width_, height_);
+    }
+    else {
+        GLExtensions::RenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                                     format, width_, height_);
+    }
+}
+
+/*
+ * (Re)allocates the storage of the FBO attachments for the current size.
+ */
+void
+CanvasGeneric::allocate_fbo_storage()
+{
+    for (unsigned int i = 0; i < offscreen_buffers_.size(); i++) {
+        OffscreenBuffer &buffer(offscreen_buffers_[i]);
+
+        if (buffer.color_texture) {
+            GLenum format = GL_RGBA;
+            GLenum type = GL_UNSIGNED_BYTE;
+            /* The formats beyond GLES 2.0 are only renderable when sized */
+            GLint internal_format = GL_RGBA;
+
+            switch (gl_color_format_) {
+                case GL_RGB8: format = GL_RGB; break;
+                case GL_RGB565: format = GL_RGB; type = GL_UNSIGNED_SHORT_5_6_5; break;
+                case GL_RGBA4: type = GL_UNSIGNED_SHORT_4_4_4_4; break;
+                case GL_RGB5_A1: type = GL_UNSIGNED_SHORT_5_5_5_1; break;
+                case GL_RGB10_A2: type = GL_UNSIGNED_INT_2_10_10_10_REV; break;
+                case GL_RGBA16F: type = GL_HALF_FLOAT; break;
+                default: break;
+            }
+            if (gl_color_format_ == GL_RGB10_A2 || gl_color_format_ == GL_RGBA16F ||
+                gl_color_format_ == GL_SRGB8_ALPHA8)
+            {
+                internal_format = gl_color_format_;
+            }
+            else {
+                internal_format = format;
+            }
+
+            glBindTexture(GL_TEXTURE_2D, buffer.color_texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width_, height_, 0,
+                         format, type, 0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+
+        renderbuffer_storage(buffer.color_renderbuffer, gl_color_format_, msaa_samples_);
+        renderbuffer_storage(buffer.depth_renderbuffer, gl_depth_format_, msaa_samples_);
+        renderbuffer_storage(buffer.resolve_renderbuffer, gl_color_format_, 0);
+    }
+
+    /* The contents of the buffers are undefined again */
+    offscreen_frames_ = 0;
+}
+
+/*
+ * Attaches the current buffer of the ring to the FBOs, leaving fbo_ bound.
+ * The FBOs themselves are kept, as scenes may keep the canvas FBO name.
+ */
+void
+CanvasGeneric::attach_offscreen_buffer()
+{
+    const OffscreenBuffer &buffer(offscreen_buffers_[offscreen_index_]);
+
+    if (resolve_fbo_) {
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, resolve_fbo_);
+        GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                              GL_RENDERBUFFER, buffer.resolve_renderbuffer);
+    }
+
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    if (buffer.color_texture) {
+        GLExtensions::FramebufferTexture2DMultisample(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                                      GL_TEXTURE_2D, buffer.color_texture, 0,
+                                                      msaa_samples_);
+    }
+    else {
+        GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                              GL_RENDERBUFFER, buffer.color_renderbuffer);
+    }
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                          GL_RENDERBUFFER, buffer.depth_renderbuffer);
+}
+
+/*
+ * Moves on to the next buffer of the ring at the end of a frame, so that the
+ * next frame doesn't have to wait for the GPU to be done with this one.
+ */
+void
+CanvasGeneric::next_offscreen_buffer()
+{
+    offscreen_frames_++;
+
+    if (offscreen_buffers_.size() < 2)
+        return;
+
+    offscreen_index_ = (offscreen_index_ + 1) % offscreen_buffers_.size();
+    attach_offscreen_buffer();
+}
+
 void
 CanvasGeneric::release_fbo()
 {
+    if (resolve_fbo_) {
+        GLExtensions::DeleteFramebuffers(1, &resolve_fbo_);
+        resolve_fbo_ = 0;
+    }
     if (fbo_) {
         GLExtensions::DeleteFramebuffers(1, &fbo_);
         fbo_ = 0;
     }
-    if (color_renderbuffer_) {
-        GLExtensions::DeleteRenderbuffers(1, &color_renderbuffer_);
-        color_renderbuffer_ = 0;
-    }
-    if (depth_renderbuffer_) {
-        GLExtensions::DeleteRenderbuffers(1, &depth_renderbuffer_);
-        depth_renderbuffer_ = 0;
+
+    for (unsigned int i = 0; i < offscreen_buffers_.size(); i++) {
+        OffscreenBuffer &buffer(offscreen_buffers_[i]);
+
+        if (buffer.resolve_renderbuffer)
+            GLExtensions::DeleteRenderbuffers(1, &buffer.resolve_renderbuffer);
+        if (buffer.color_texture)
+            glDeleteTextures(1, &buffer.color_texture);
+        if (buffer.color_renderbuffer)
+            GLExtensions::DeleteRenderbuffers(1, &buffer.color_renderbuffer);
+        if (buffer.depth_renderbuffer)
+            GLExtensions::DeleteRenderbuffers(1, &buffer.depth_renderbuffer);
     }
 
+    offscreen_buffers_.clear();
+    offscreen_index_ = 0;
+
+    post_process_.release();
+    release_scaled_fbo();
+
     gl_color_format_ = 0;
     gl_depth_format_ = 0;
+    msaa_samples_ = 0;
+    msaa_implicit_ = false;
+}
+
+/*
+ * Resolves the samples of the frame with a blit, once per frame, so that the
+ * cost of the resolve is included in the frame time.
+ */
+void
+CanvasGeneric::resolve_msaa()
+{
+    if (!resolve_fbo_ || msaa_resolved_)
+        return;
+
+    DebugMarkers::Group group("msaa-resolve");
+
+    GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    GLExtensions::BindFramebuffer(GL_DRAW_FRAMEBUFFER, resolve_fbo_);
+    GLExtensions::BlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_,
+                                  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+    msaa_resolved_ = true;
+}
+
+/*
+ * Post-processes the frame (--hdr, --post-process) to the output, once per
+ * frame, like the MSAA resolve.
+ */
+void
+CanvasGeneric::resolve_post_process()
+{
+    if (!post_process_.fbo() || post_processed_)
+        return;
+
+    DebugMarkers::Group group("post-process");
+
+    post_process_.render();
+
+    post_processed_ = true;
+}
+
+/*
+ * Creates the target of --dynamic-resolution, with the attachments of the
+ * size of the canvas.
+ */
+bool
+CanvasGeneric::ensure_scaled_fbo()
+{
+    if (scaled_fbo_)
+        return true;
+
+    if (Options::msaa_samples || PostProcess::enabled()) {
+        Log::error("--dynamic-resolution can't be combined with --msaa, --hdr"
+                   " or --post-process\n");
+        return false;
+    }
+
+    if (!GLExtensions::GenFramebuffers || !GLExtensions::BlitFramebuffer) {
+        Log::error("--dynamic-resolution requires GL framebuffer blit support\n");
+        return false;
+    }
+
+    if (!ensure_gl_formats())
+        return false;
+
+    GLExtensions::GenRenderbuffers(1, &scaled_color_renderbuffer_);
+    GLExtensions::GenRenderbuffers(1, &scaled_depth_renderbuffer_);
+    allocate_scaled_storage();
+
+    GLExtensions::GenFramebuffers(1, &scaled_fbo_);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, scaled_fbo_);
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          GL_RENDERBUFFER, scaled_color_renderbuffer_);
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                          GL_RENDERBUFFER, scaled_depth_renderbuffer_);
+    DebugMarkers::label(GL_FRAMEBUFFER, scaled_fbo_, "canvas-scaled");
+
+    GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::error("Failed to create the dynamic resolution framebuffer (status 0x%x)\n",
+                   status);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * (Re)allocates the attachments of scaled_fbo_ for the current size, which
+ * renders unscaled until the next render_scale().
+ */
+void
+CanvasGeneric::allocate_scaled_storage()
+{
+    renderbuffer_storage(scaled_color_renderbuffer_, gl_color_format_, 0);
+    renderbuffer_storage(scaled_depth_renderbuffer_, gl_depth_format_, 0);
+
+    render_width_ = 0;
+    render_height_ = 0;
+}
+
+void
+CanvasGeneric::release_scaled_fbo()
+{
+    if (scaled_fbo_) {
+        GLExtensions::DeleteFramebuffers(1, &scaled_fbo_);
+        scaled_fbo_ = 0;
+    }
+    if (scaled_color_renderbuffer_) {
+        GLExtensions::DeleteRenderbuffers(1, &scaled_color_renderbuffer_);
+        scaled_color_renderbuffer_ = 0;
+    }
+    if (scaled_depth_renderbuffer_) {
+        GLExtensions::DeleteRenderbuffers(1, &scaled_depth_renderbuffer_);
+        scaled_depth_renderbuffer_ = 0;
+    }
+
+    render_width_ = 0;
+    render_height_ = 0;
+}
+
+/*
+ * Scales the frame up to the size of the canvas (--dynamic-resolution), once
+ * per frame, like the MSAA resolve.
+ */
+void
+CanvasGeneric::resolve_render_scale()
+{
+    if (!scaled_fbo_ || scaled_up_)
+        return;
+
+    DebugMarkers::Group group("render-scale");
+
+    /* The blit is scissored too, e.g. by the damage of the frame */
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    if (scissor)
+        glDisable(GL_SCISSOR_TEST);
+
+    int width = this->width();
+    int height = this->height();
+
+    GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, scaled_fbo_);
+    GLExtensions::BindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo_);
+    GLExtensions::BlitFramebuffer(0, 0, width, height, 0, 0, width_, height_,
+                                  GL_COLOR_BUFFER_BIT,
+                                  width == width_ && height == height_ ? GL_NEAREST : GL_LINEAR);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+    if (scissor)
+        glEnable(GL_SCISSOR_TEST);
+
+    scaled_up_ = true;
+}
+
+/*
+ * Makes glReadPixels read the resolved frame, if the samples are resolved
+ * with a blit, or the post-processed frame. The frames of
+ * --dynamic-resolution are read as rendered, at their scaled size, until
+ * they end.
+ */
+void
+CanvasGeneric::begin_read_pixels()
+{
+    if (resolve_fbo_) {
+        resolve_msaa();
+        GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, resolve_fbo_);
+    }
+    else if (post_process_.fbo()) {
+        /* GL_READ_FRAMEBUFFER isn't available in GLES2 */
+        resolve_post_process();
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    }
+}
+
+void
+CanvasGeneric::end_read_pixels()
+{
+    if (resolve_fbo_)
+        GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+    else if (post_process_.fbo())
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, post_process_.fbo());
+}
+
+bool
+CanvasGeneric::supports_async_readback()
+{
+#if GLMARK2_USE_GLESv2
+    /* Pixel pack buffers are only available in GLES 3.0 */
+    if (!GLExtensions::version_supported(3, 0))
+        return false;
+#endif
+
+    return GLExtensions::MapBufferRange && GLExtensions::UnmapBuffer &&
+           GLExtensions::FenceSync && GLExtensions::DeleteSync &&
+           GLExtensions::ClientWaitSync;
+}
+
+bool
+CanvasGeneric::ensure_readback()
+{
+    if (readback_buffers_[0] &&
+        readback_width_ == width_ && readback_height_ == height_)
+    {
+        return true;
+    }
+
+    release_readback();
+
+    if (!supports_async_readback())
+        return false;
+
+    GLsizeiptr size = static_cast<GLsizeiptr>(width_) * height_ * 4;
+
+    glGenBuffers(readback_count, readback_buffers_);
+    for (unsigned int i = 0; i < readback_count; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_buffers_[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, 0, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback_data_.resize(size);
+    readback_index_ = 0;
+    readback_width_ = width_;
+    readback_height_ = height_;
+
+    return true;
+}
+
+void
+CanvasGeneric::release_readback()
+{
+    if (!readback_buffers_[0])
+        return;
+
+    for (unsigned int i = 0; i < readback_count; i++) {
+        if (readback_fences_[i]) {
+            GLExtensions::DeleteSync(readback_fences_[i]);
+            readback_fences_[i] = 0;
+        }
+    }
+
+    glDeleteBuffers(readback_count, readback_buffers_);
+    for (unsigned int i = 0; i < readback_count; i++)
+        readback_buffers_[i] = 0;
+
+    readback_data_.clear();
+    readback_width_ = 0;
+    readback_height_ = 0;
+}
+
+/*
+ * Waits for the read back started readback_count frames ago to complete
+ * and copies the pixels out, like a consumer (e.g. a video encoder) would.
+ */
+void
+CanvasGeneric::consume_readback(unsigned int index)
+{
+    static const GLuint64 timeout_ns = 1000000000;
+    GLsync fence = readback_fences_[index];
+    GLenum status;
+
+    do {
+        status = GLExtensions::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                              timeout_ns);
+    } while (status == GL_TIMEOUT_EXPIRED);
+
+    GLExtensions::DeleteSync(fence);
+    readback_fences_[index] = 0;
+
+    if (status == GL_WAIT_FAILED)
+        return;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_buffers_[index]);
+
+    void *pixels = GLExtensions::MapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                readback_data_.size(),
+                                                GL_MAP_READ_BIT);
+    if (pixels) {
+        std::copy(static_cast<uint8_t *>(pixels),
+                  static_cast<uint8_t *>(pixels) + readback_data_.size(),
+                  readback_data_.begin());
+        GLExtensions::UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void
+CanvasGeneric::read_pixels_async()
+{
+    if (reads_float()) {
+        read_pixel(width_ / 2, height_ / 2);
+        return;
+    }
+
+    if (!ensure_readback()) {
+        static bool warned = false;
+        if (!warned) {
+            Log::info("Asynchronous read back requires pixel buffer objects and"
+                      " sync objects, falling back to synchronous glReadPixels\n");
+            warned = true;
+        }
+        read_pixel(width_ / 2, height_ / 2);
+        return;
+    }
+
+    unsigned int index = readback_index_;
+
+    /* Free the slot used readback_count frames ago */
+    if (readback_fences_[index])
+        consume_readback(index);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback_buffers_[index]);
+    begin_read_pixels();
+    glReadPixels(0, 0, readback_width_, readback_height_,
+                 GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    end_read_pixels();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback_fences_[index] =
+        GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback_index_ = (index + 1) % readback_count;
+}
+
+/*
+ * Ends the frame with a fence and waits for the frame --frames-in-flight
+ * frames before it, so the CPU prepares the next frames while the GPU
+ * renders, like with a swapchain, but is throttled to the GPU.
+ */
+void
+CanvasGeneric::limit_frames_in_flight()
+{
+    static const GLuint64 timeout_ns = 1000000000;
+
+    if (!GLExtensions::FenceSync || !GLExtensions::ClientWaitSync ||
+        !GLExtensions::DeleteSync)
+    {
+        static bool warned = false;
+        if (!warned) {
+            Log::info("Limiting the frames in flight requires sync objects,"
+                      " falling back to glFinish()\n");
+            warned = true;
+        }
+        glFinish();
+        return;
+    }
+
+    frame_fences_.push_back(GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    /* Submit the frame now, rather than when waiting for it */
+    glFlush();
+
+    while (frame_fences_.size() > std::max(Options::frames_in_flight, 1U)) {
+        GLsync fence = frame_fences_.front();
+        GLenum status;
+
+        do {
+            status = GLExtensions::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                  timeout_ns);
+        } while (status == GL_TIMEOUT_EXPIRED);
+
+        GLExtensions::DeleteSync(fence);
+        frame_fences_.pop_front();
+    }
+}
+
+void
+CanvasGeneric::release_frame_fences()
+{
+    for (std::deque<GLsync>::iterator iter = frame_fences_.begin();
+         iter != frame_fences_.end(); ++iter)
+    {
+        GLExtensions::DeleteSync(*iter);
+    }
+
+    frame_fences_.clear();
+}
+
+std::string
+CanvasGeneric::gl_string(GLenum name)
+{
+    const char *str = reinterpret_cast<const char*>(glGetString(name));
+    return str ? str : "";
 }
 
 const char *
@@ -463,6 +1477,9 @@ CanvasGeneric::get_gl_format_str(GLenum f)
         case GL_RGBA4: str = "GL_RGBA4"; break;
         case GL_RGB5_A1: str = "GL_RGB5_A1"; break;
         case GL_RGB565: str = "GL_RGB565"; break;
+        case GL_RGB10_A2: str = "GL_RGB10_A2"; break;
+        case GL_RGBA16F: str = "GL_RGBA16F"; break;
+        case GL_SRGB8_ALPHA8: str = "GL_SRGB8_ALPHA8"; break;
         case GL_DEPTH_COMPONENT16: str = "GL_DEPTH_COMPONENT16"; break;
         case GL_DEPTH_COMPONENT24: str = "GL_DEPTH_COMPONENT24"; break;
         case GL_DEPTH_COMPONENT32: str = "GL_DEPTH_COMPONENT32"; break;
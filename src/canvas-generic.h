@@ -24,6 +24,9 @@
 #define GLMARK2_CANVAS_GENERIC_H_
 
 #include "canvas.h"
+#include "post-process.h"
+
+#include <deque>
 
 class GLState;
 class NativeState;
@@ -38,21 +41,50 @@ public:
                   int width, int height)
         : Canvas(width, height),
           native_state_(native_state), gl_state_(gl_state), native_window_(0),
-          gl_color_format_(0), gl_depth_format_(0),
-          color_renderbuffer_(0), depth_renderbuffer_(0), fbo_(0),
-          window_initialized_(false) {}
+          gl_color_format_(0), gl_depth_format_(0), fbo_(0),
+          offscreen_index_(0), offscreen_frames_(0), resolve_fbo_(0),
+          msaa_samples_(0), msaa_implicit_(false), msaa_resolved_(false),
+          post_processed_(false), scaled_fbo_(0), scaled_color_renderbuffer_(0),
+          scaled_depth_renderbuffer_(0), scaled_up_(false),
+          window_initialized_(false), use_fences_(false), readback_index_(0),
+          readback_width_(0), readback_height_(0)
+    {
+        for (unsigned int i = 0; i < readback_count; i++) {
+            readback_buffers_[i] = 0;
+            readback_fences_[i] = 0;
+        }
+    }
 
     bool init();
     bool reset();
     void visible(bool visible);
     void clear();
     void update();
+    unsigned int buffer_age();
+    void damage(const std::vector<int> &rects) { damage_ = rects; }
+    void damage_region(const std::vector<int> &rects);
+    void take_presentations(PresentationList &list);
+    uint64_t take_flip_wait_us();
     void print_info();
+    InfoList info();
     Pixel read_pixel(int x, int y);
+    bool read_frame(std::vector<uint8_t> &pixels);
     void write_to_file(std::string &filename);
+    void begin_read_pixels();
+    void end_read_pixels();
     bool should_quit();
     void resize(int width, int height);
+    void render_scale(double scale);
     unsigned int fbo();
+    int create_native_fence();
+    bool create_dma_buf(unsigned int width, unsigned int height,
+                        unsigned int cpp, const void *data, DmaBuf &buf);
+    void destroy_dma_buf(DmaBuf &buf);
+    void *create_dma_buf_image(const DmaBufImage &image);
+    void destroy_dma_buf_image(void *image);
+    GLWorkerContext *create_worker_context(bool shared,
+                                           Options::ContextPriority priority =
+                                               Options::ContextPriorityDefault);
 
 private:
     bool supports_gl2();
@@ -60,18 +92,94 @@ private:
     bool do_make_current();
     bool ensure_gl_formats();
     bool ensure_fbo();
+    bool ensure_msaa_config();
+    void renderbuffer_storage(GLuint renderbuffer, GLenum format, unsigned int samples);
+    void allocate_fbo_storage();
+    void attach_offscreen_buffer();
+    void next_offscreen_buffer();
     void release_fbo();
+    void resolve_msaa();
+    bool ensure_post_process();
+    void resolve_post_process();
+    bool ensure_scaled_fbo();
+    void allocate_scaled_storage();
+    void release_scaled_fbo();
+    void resolve_render_scale();
+    bool reads_float();
+    void read_rgba8(int x, int y, int width, int height, void *pixels);
+    bool supports_async_readback();
+    bool ensure_readback();
+    void release_readback();
+    void consume_readback(unsigned int index);
+    void read_pixels_async();
+    void limit_frames_in_flight();
+    void release_frame_fences();
     const char *get_gl_format_str(GLenum f);
+    std::string gl_string(GLenum name);
 
     NativeState& native_state_;
     GLState& gl_state_;
     void* native_window_;
     GLenum gl_color_format_;
     GLenum gl_depth_format_;
-    GLuint color_renderbuffer_;
-    GLuint depth_renderbuffer_;
     GLuint fbo_;
+
+    /* The attachments of fbo_ for one frame, see --off-screen-buffers */
+    struct OffscreenBuffer {
+        OffscreenBuffer() :
+            color_renderbuffer(0), depth_renderbuffer(0), color_texture(0),
+            resolve_renderbuffer(0) {}
+
+        GLuint color_renderbuffer;
+        GLuint depth_renderbuffer;
+        /* The color texture used with implicitly resolved MSAA */
+        GLuint color_texture;
+        /* The single-sampled buffer that blit resolved MSAA is resolved into */
+        GLuint resolve_renderbuffer;
+    };
+
+    /* The ring of buffers attached in turn, the current one at offscreen_index_ */
+    std::vector<OffscreenBuffer> offscreen_buffers_;
+    unsigned int offscreen_index_;
+    /* The number of frames rendered since the buffers were allocated */
+    unsigned int offscreen_frames_;
+    GLuint resolve_fbo_;
+    unsigned int msaa_samples_;
+    bool msaa_implicit_;
+    /* Whether the samples of the current frame have been resolved */
+    bool msaa_resolved_;
+
+    /* The target of --hdr and --post-process, post-processed to fbo_ */
+    PostProcess post_process_;
+    /* Whether the current frame has been post-processed */
+    bool post_processed_;
+
+    /*
+     * The target of --dynamic-resolution, rendered to at the size of the
+     * canvas or less, and scaled up to fbo_ at the end of each frame
+     */
+    GLuint scaled_fbo_;
+    GLuint scaled_color_renderbuffer_;
+    GLuint scaled_depth_renderbuffer_;
+    /* Whether the current frame has been scaled up */
+    bool scaled_up_;
+
     bool window_initialized_;
+    /* Whether frames are flipped with explicit fences */
+    bool use_fences_;
+    std::vector<int> damage_;
+
+    /* Number of frames in flight for FrameEndReadPixelsAsync */
+    static const unsigned int readback_count = 3;
+    GLuint readback_buffers_[readback_count];
+    GLsync readback_fences_[readback_count];
+    unsigned int readback_index_;
+    int readback_width_;
+    int readback_height_;
+    std::vector<uint8_t> readback_data_;
+
+    /* The fences of the frames in flight for FrameEndFence, oldest first */
+    std::deque<GLsync> frame_fences_;
 };
 
 #endif /* GLMARK2_CANVAS_GENERIC_H_ */
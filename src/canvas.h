@@ -28,12 +28,19 @@
 #include "gl-headers.h"
 #include "mat.h"
 #include "gl-visual-config.h"
+#include "dma-buf.h"
+#include "presentation.h"
+#include "options.h"
 
 #include <stdint.h>
 #include <string>
+#include <vector>
+#include <utility>
 #include <stdio.h>
 #include <cmath>
 
+class GLWorkerContext;
+
 /**
  * Abstraction for a GL rendering target.
  */
@@ -132,6 +139,59 @@ public:
      */
     virtual void update() {}
 
+    /**
+     * Gets the age of the buffer the next frame is drawn to: the number of
+     * frames since its contents were drawn, or 0 if they are undefined.
+     *
+     * @return the age of the buffer
+     */
+    virtual unsigned int buffer_age() { return 0; }
+
+    /**
+     * Sets the rectangles that changed in the current frame, which
+     * ::update() reports to the GL system. Without a call, the whole frame
+     * is reported as changed.
+     *
+     * @param rects x, y, width, height quadruplets, with (0, 0) at the
+     *              lower left corner
+     */
+    virtual void damage(const std::vector<int> &rects) { static_cast<void>(rects); }
+
+    /**
+     * Sets the rectangles of the current frame's buffer that are going to
+     * be drawn to, so the GL system only needs to keep the rest of the
+     * contents of the buffer. Must be called before drawing the frame.
+     *
+     * @param rects x, y, width, height quadruplets, with (0, 0) at the
+     *              lower left corner
+     */
+    virtual void damage_region(const std::vector<int> &rects) { static_cast<void>(rects); }
+
+    /**
+     * Moves the timings of the frames presented since the last call to
+     * a list.
+     *
+     * Frames are only reported with --present-timing, and only when the
+     * native or GL system provides presentation feedback.
+     *
+     * @param list the list to append the presentations to
+     */
+    virtual void take_presentations(PresentationList &list) { static_cast<void>(list); }
+
+    /**
+     * Gets the time spent waiting for page flips while presenting the
+     * frames since the last call, in microseconds.
+     *
+     * Only the display systems that wait for the flips themselves, rather
+     * than in the GL system, report it.
+     */
+    virtual uint64_t take_flip_wait_us() { return 0; }
+
+    /**
+     * A list of (name, value) pairs describing the canvas.
+     */
+    typedef std::vector<std::pair<std::string, std::string> > InfoList;
+
     /**
      * Prints information about the canvas.
      *
@@ -139,6 +199,18 @@ public:
      */
     virtual void print_info() {}
 
+    /**
+     * Gets information about the canvas (GL vendor, surface config etc).
+     *
+     * This is the same information shown by ::print_info(), in a form
+     * suitable for machine-readable output.
+     *
+     * This method should be implemented in derived classes.
+     *
+     * @return the information as a list of (name, value) pairs
+     */
+    virtual InfoList info() { return InfoList(); }
+
     /**
      * Reads a pixel from the canvas.
      *
@@ -171,6 +243,28 @@ public:
      */
     virtual void write_to_file(std::string &filename) { static_cast<void>(filename); }
 
+    /**
+     * Reads the whole current frame.
+     *
+     * This method should be implemented in derived classes.
+     *
+     * @param pixels the RGBA rows of the frame, bottom row first
+     *
+     * @return whether the frame could be read
+     */
+    virtual bool read_frame(std::vector<uint8_t> &pixels) { static_cast<void>(pixels); return false; }
+
+    /**
+     * Makes glReadPixels() read the current frame as it will be presented,
+     * e.g. with its samples resolved, until end_read_pixels() is called.
+     */
+    virtual void begin_read_pixels() {}
+
+    /**
+     * Makes glReadPixels() read the framebuffer being rendered to again.
+     */
+    virtual void end_read_pixels() {}
+
     /**
      * Whether we should quit the application.
      *
@@ -192,6 +286,17 @@ public:
      */
     virtual void resize(int width, int height) { static_cast<void>(width); static_cast<void>(height); }
 
+    /**
+     * Renders the next frames at a fraction of the size of the canvas, and
+     * scales them up to it when they end (--dynamic-resolution). While
+     * they are scaled, width() and height() are the size rendered at.
+     *
+     * This method should be implemented in derived classes.
+     *
+     * @param scale the fraction of the width and height, in (0, 1]
+     */
+    virtual void render_scale(double scale) { static_cast<void>(scale); }
+
     /**
      * Gets the FBO associated with the canvas.
      *
@@ -199,6 +304,87 @@ public:
      */
     virtual unsigned int fbo() { return 0; }
 
+    /**
+     * Creates a native fence (e.g. an EGL_ANDROID_native_fence_sync fd)
+     * that signals once the GL commands issued so far have completed,
+     * flushing them.
+     *
+     * @return the fence fd, owned by the caller, or -1 if native fences
+     *         are not supported
+     */
+    virtual int create_native_fence() { return -1; }
+
+    /**
+     * Allocates a linear buffer that can be shared with other devices
+     * through a dma-buf fd, e.g. like a video decoder output.
+     *
+     * @param width the width in pixels
+     * @param height the height in pixels
+     * @param cpp the bytes per pixel, 1 or 4
+     * @param data the tightly packed rows to fill the buffer with
+     * @param buf the buffer
+     *
+     * @return whether the buffer was allocated
+     */
+    virtual bool create_dma_buf(unsigned int width, unsigned int height,
+                                unsigned int cpp, const void *data, DmaBuf &buf)
+    {
+        static_cast<void>(width);
+        static_cast<void>(height);
+        static_cast<void>(cpp);
+        static_cast<void>(data);
+        static_cast<void>(buf);
+        return false;
+    }
+
+    /**
+     * Frees a buffer allocated by create_dma_buf().
+     *
+     * @param buf the buffer
+     */
+    virtual void destroy_dma_buf(DmaBuf &buf) { static_cast<void>(buf); }
+
+    /**
+     * Imports planes of dma-bufs as an EGLImage, without copying them.
+     *
+     * @param image the description of the image
+     *
+     * @return the image, for glEGLImageTargetTexture2DOES(), or 0 if
+     *         dma-buf import is not supported
+     */
+    virtual void *create_dma_buf_image(const DmaBufImage &image)
+    {
+        static_cast<void>(image);
+        return 0;
+    }
+
+    /**
+     * Destroys an image created by create_dma_buf_image().
+     *
+     * @param image the image
+     */
+    virtual void destroy_dma_buf_image(void *image) { static_cast<void>(image); }
+
+    /**
+     * Creates a GL context for rendering from another thread.
+     *
+     * This method should be implemented in derived classes.
+     *
+     * @param shared whether the context shares its objects with the
+     *               context of the canvas
+     * @param priority the priority of the context on the GPU, if supported
+     *
+     * @return the context, or 0 if it is not supported
+     */
+    virtual GLWorkerContext *create_worker_context(bool shared,
+                                                   Options::ContextPriority priority =
+                                                       Options::ContextPriorityDefault)
+    {
+        static_cast<void>(shared);
+        static_cast<void>(priority);
+        return 0;
+    }
+
     /**
      * Gets a dummy canvas object.
      *
@@ -211,18 +397,20 @@ public:
     }
 
     /**
-     * Gets the width of the canvas.
+     * Gets the width of the canvas, or of the frames rendered to it at a
+     * smaller scale.
      *
      * @return the width in pixels
      */
-    int width() { return width_; }
+    int width() { return render_width_ ? render_width_ : width_; }
 
     /**
-     * Gets the height of the canvas.
+     * Gets the height of the canvas, or of the frames rendered to it at a
+     * smaller scale.
      *
      * @return the height in pixels
      */
-    int height() { return height_; }
+    int height() { return render_height_ ? render_height_ : height_; }
 
     /**
      * Gets the projection matrix recommended for use with the canvas.
@@ -249,10 +437,14 @@ public:
 
 protected:
     Canvas(int width, int height) :
-        width_(width), height_(height), offscreen_(false) {}
+        width_(width), height_(height), render_width_(0), render_height_(0),
+        offscreen_(false) {}
 
     int width_;
     int height_;
+    /* The size the frames are rendered at with render_scale(), 0 if unscaled */
+    int render_width_;
+    int render_height_;
     LibMatrix::mat4 projection_;
     bool offscreen_;
     GLVisualConfig visual_config_;
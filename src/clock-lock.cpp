@@ -0,0 +1,318 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "clock-lock.h"
+#include "log.h"
+#include "util.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#ifdef __linux__
+
+/* A sysfs file set for the run, in the order it was set */
+struct Setting {
+    Setting(const std::string &p, const std::string &o, const std::string &v) :
+        path(p), old_value(o), value(v) {}
+
+    std::string path;
+    std::string old_value;
+    std::string value;
+};
+
+/* A device in a performance mode, and where its current clock is read */
+struct LockedDevice {
+    std::string name;
+    std::string mode;
+    std::string clock_path;
+    /* The factor converting the clock to MHz, or 0 for a pp_dpm_* table */
+    double clock_scale;
+};
+
+std::vector<Setting> settings;
+std::vector<LockedDevice> devices;
+pid_t locking_pid = 0;
+
+bool
+write_value(const std::string &path, const std::string &value)
+{
+    std::ofstream file(path.c_str());
+
+    file << value << std::endl;
+
+    return file.good();
+}
+
+/* Whether a space separated list, like available_governors, has a word */
+bool
+has_word(const std::string &list, const std::string &word)
+{
+    std::stringstream ss(list);
+    std::string w;
+
+    while (ss >> w) {
+        if (w == word)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Sets a sysfs file for the run, remembering its value to restore it.
+ * Nothing is remembered if it already has the value.
+ */
+bool
+set(const std::string &path, const std::string &value)
+{
+    std::string old_value(Util::read_first_line(path));
+
+    /* Some files, like the amdgpu ones, have a trailing space or more */
+    std::string current(old_value);
+    current.erase(current.find_last_not_of(" \t") + 1);
+
+    if (current == value)
+        return true;
+
+    if (!write_value(path, value)) {
+        Log::info("Warning: failed to set %s to '%s' (hint: --lock-clocks usually "
+                  "needs root)\n", path.c_str(), value.c_str());
+        return false;
+    }
+
+    settings.push_back(Setting(path, current, value));
+
+    return true;
+}
+
+void
+lock_cpufreq()
+{
+    static const std::string cpufreq_dir("/sys/devices/system/cpu/cpufreq");
+
+    std::vector<std::string> policies(Util::list_dir(cpufreq_dir, "policy"));
+    for (size_t i = 0; i < policies.size(); i++) {
+        std::string path(cpufreq_dir + "/" + policies[i]);
+
+        if (!has_word(Util::read_first_line(path + "/scaling_available_governors"),
+                      "performance") ||
+            !set(path + "/scaling_governor", "performance"))
+        {
+            continue;
+        }
+
+        LockedDevice device;
+        device.name = "cpufreq " + policies[i];
+        device.mode = "performance";
+        device.clock_path = path + "/scaling_cur_freq";
+        device.clock_scale = 0.001;
+        devices.push_back(device);
+    }
+}
+
+/*
+ * The devfreq devices without the performance governor are held at their
+ * highest frequency by the userspace governor.
+ */
+void
+lock_devfreq()
+{
+    static const std::string devfreq_dir("/sys/class/devfreq");
+
+    std::vector<std::string> names(Util::list_dir(devfreq_dir, ""));
+    for (size_t i = 0; i < names.size(); i++) {
+        std::string path(devfreq_dir + "/" + names[i]);
+        std::string governors(Util::read_first_line(path + "/available_governors"));
+        LockedDevice device;
+
+        if (has_word(governors, "performance")) {
+            if (!set(path + "/governor", "performance"))
+                continue;
+            device.mode = "performance";
+        }
+        else if (has_word(governors, "userspace")) {
+            std::string max_freq(Util::read_first_line(path + "/max_freq"));
+            if (max_freq.empty() || !set(path + "/governor", "userspace") ||
+                !set(path + "/userspace/set_freq", max_freq))
+            {
+                continue;
+            }
+            device.mode = "userspace:" + max_freq;
+        }
+        else {
+            continue;
+        }
+
+        device.name = "devfreq " + names[i];
+        device.clock_path = path + "/cur_freq";
+        device.clock_scale = 0.000001;
+        devices.push_back(device);
+    }
+}
+
+void
+lock_amdgpu()
+{
+    static const std::string drm_dir("/sys/class/drm");
+
+    std::vector<std::string> cards(Util::list_dir(drm_dir, "card"));
+    for (size_t i = 0; i < cards.size(); i++) {
+        /* Skip the connectors, like card0-DP-1 */
+        if (cards[i].find('-') != std::string::npos)
+            continue;
+
+        std::string path(drm_dir + "/" + cards[i] + "/device");
+        std::string level_path(path + "/power_dpm_force_performance_level");
+
+        if (Util::read_first_line(level_path).empty() || !set(level_path, "high"))
+            continue;
+
+        LockedDevice device;
+        device.name = "amdgpu " + cards[i];
+        device.mode = "high";
+        device.clock_path = path + "/pp_dpm_sclk";
+        device.clock_scale = 0.0;
+        devices.push_back(device);
+    }
+}
+
+/*
+ * Reads the current clock of a device, in MHz. The pp_dpm_sclk table of
+ * amdgpu has a line per level, like "1: 1800Mhz *", the current one marked.
+ */
+double
+read_clock(const LockedDevice &device)
+{
+    if (device.clock_scale > 0.0)
+        return Util::fromString<double>(Util::read_first_line(device.clock_path)) * device.clock_scale;
+
+    std::ifstream file(device.clock_path.c_str());
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (line.find('*') == std::string::npos)
+            continue;
+
+        size_t colon = line.find(':');
+        if (colon != std::string::npos)
+            return Util::fromString<double>(line.substr(colon + 1));
+    }
+
+    return 0.0;
+}
+
+void
+restore_at_exit()
+{
+    ClockLock::restore();
+}
+
+#endif
+
+}
+
+bool
+ClockLock::apply()
+{
+#ifdef __linux__
+    lock_cpufreq();
+    lock_devfreq();
+    lock_amdgpu();
+
+    if (!settings.empty() && locking_pid == 0) {
+        locking_pid = getpid();
+        std::atexit(restore_at_exit);
+    }
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        Log::info("Locked the clocks of %s (%s, %.0f MHz)\n", devices[i].name.c_str(),
+                  devices[i].mode.c_str(), read_clock(devices[i]));
+    }
+
+    if (devices.empty())
+        Log::info("Warning: found no clock governors to lock\n");
+
+    return !devices.empty();
+#else
+    Log::info("Warning: --lock-clocks is only supported on Linux\n");
+    return false;
+#endif
+}
+
+void
+ClockLock::restore()
+{
+#ifdef __linux__
+    if (locking_pid != getpid())
+        return;
+
+    /* In reverse, so a device gets its old governor back last */
+    for (std::vector<Setting>::reverse_iterator iter = settings.rbegin();
+         iter != settings.rend();
+         iter++)
+    {
+        /* The frequency set for the userspace governor goes away with it */
+        static const std::string set_freq("/userspace/set_freq");
+        if (iter->old_value.empty() ||
+            (iter->path.size() > set_freq.size() &&
+             iter->path.compare(iter->path.size() - set_freq.size(), set_freq.size(), set_freq) == 0))
+        {
+            continue;
+        }
+
+        if (!write_value(iter->path, iter->old_value)) {
+            Log::info("Warning: failed to restore %s to '%s'\n",
+                      iter->path.c_str(), iter->old_value.c_str());
+        }
+    }
+
+    if (!settings.empty())
+        Log::debug("Restored the clock governors\n");
+
+    settings.clear();
+    devices.clear();
+#endif
+}
+
+void
+ClockLock::info(std::vector<std::pair<std::string, std::string> > &info)
+{
+#ifdef __linux__
+    if (devices.empty())
+        return;
+
+    std::stringstream ss;
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        ss << (i > 0 ? ", " : "") << devices[i].name << ": " << devices[i].mode
+           << " (" << static_cast<unsigned int>(read_clock(devices[i]) + 0.5) << " MHz)";
+    }
+
+    info.push_back(std::make_pair("Clock Lock", ss.str()));
+#else
+    static_cast<void>(info);
+#endif
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_CLOCK_LOCK_H_
+#define GLMARK2_CLOCK_LOCK_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Puts the clock governors of the CPUs and GPUs in a fixed performance mode
+ * for the run (--lock-clocks), so that the clocks don't vary between runs,
+ * and restores them when the process exits.
+ *
+ * On Linux, the cpufreq policies and devfreq devices get the 'performance'
+ * governor (or the 'userspace' governor at their highest frequency, for the
+ * devfreq devices without it), and the amdgpu devices the 'high' forced
+ * performance level. Changing them usually needs root.
+ */
+class ClockLock
+{
+public:
+    /**
+     * Applies the performance modes the system exposes, warning about those
+     * that can't be applied, and restores them at exit.
+     *
+     * @return whether any mode was applied
+     */
+    static bool apply();
+
+    /**
+     * Restores the modes in effect before apply(). Only the process that
+     * applied them restores them, not its forked children.
+     */
+    static void restore();
+
+    /**
+     * Adds the applied modes and the current clocks to the information
+     * recorded with the results.
+     */
+    static void info(std::vector<std::pair<std::string, std::string> > &info);
+};
+
+#endif /* GLMARK2_CLOCK_LOCK_H_ */
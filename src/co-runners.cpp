@@ -0,0 +1,232 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "co-runners.h"
+#include "canvas.h"
+#include "gl-state.h"
+#include "gl-headers.h"
+#include "isolation.h"
+#include "log.h"
+#include "util.h"
+
+#include <chrono>
+#include <cstring>
+
+CoRunners::CoRunners() :
+    load_(false), quit_(false)
+{
+}
+
+CoRunners::~CoRunners()
+{
+    stop();
+}
+
+bool
+CoRunners::parse(const std::string &spec, Config &config)
+{
+    std::vector<std::string> elems;
+    Util::split(spec, ',', elems, Util::SplitModeNormal);
+
+    config = Config();
+
+    for (std::vector<std::string>::const_iterator iter = elems.begin();
+         iter != elems.end();
+         iter++)
+    {
+        std::vector<std::string> kv;
+        Util::split(*iter, ':', kv, Util::SplitModeNormal);
+
+        unsigned int count = kv.size() > 1 ? Util::fromString<unsigned int>(kv[1]) : 1;
+
+        if (kv.size() > 2 || count == 0)
+            return false;
+
+        if (kv[0] == "cpu")
+            config.cpu += count;
+        else if (kv[0] == "memory")
+            config.memory += count;
+        else if (kv[0] == "gpu")
+            config.gpu += count;
+        else
+            return false;
+    }
+
+    return config.cpu + config.memory + config.gpu > 0;
+}
+
+bool
+CoRunners::start(Canvas &canvas, const Config &config)
+{
+    stop();
+
+    load_ = false;
+    quit_ = false;
+
+    /* The contexts are created here, since only the render thread may do it */
+    for (unsigned int i = 0; i < config.gpu; i++) {
+        GLWorkerContext *context = canvas.create_worker_context(false);
+        if (!context) {
+            Log::error("GPU co-runners require rendering from multiple contexts,"
+                       " which is not supported by this flavor\n");
+            stop();
+            return false;
+        }
+        contexts_.push_back(context);
+        threads_.push_back(std::thread(&CoRunners::run_gpu, this, context));
+    }
+
+    for (unsigned int i = 0; i < config.cpu; i++)
+        threads_.push_back(std::thread(&CoRunners::run_cpu, this));
+
+    for (unsigned int i = 0; i < config.memory; i++)
+        threads_.push_back(std::thread(&CoRunners::run_memory, this));
+
+    return true;
+}
+
+void
+CoRunners::stop()
+{
+    quit_ = true;
+
+    for (std::vector<std::thread>::iterator iter = threads_.begin();
+         iter != threads_.end();
+         iter++)
+    {
+        iter->join();
+    }
+    threads_.clear();
+
+    for (std::vector<GLWorkerContext *>::iterator iter = contexts_.begin();
+         iter != contexts_.end();
+         iter++)
+    {
+        delete *iter;
+    }
+    contexts_.clear();
+
+    load_ = false;
+}
+
+/* Idles until the load is switched on, or the co-runners stop */
+void
+CoRunners::wait_for_load()
+{
+    while (!load_ && !quit_)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+/*
+ * Spins on dependent floating point operations, which keep a CPU core busy
+ * without touching memory.
+ */
+void
+CoRunners::run_cpu()
+{
+    Isolation::worker_thread();
+
+    volatile float sink = 0.0f;
+    float x = 1.0f;
+
+    while (!quit_) {
+        wait_for_load();
+
+        for (unsigned int i = 0; i < 1000000 && load_; i++)
+            x = x * 0.999999f + 0.000001f;
+        sink = x;
+    }
+
+    (void)sink;
+}
+
+/*
+ * Copies a buffer much larger than the CPU caches, so every copy goes to
+ * the memory shared with the GPU.
+ */
+void
+CoRunners::run_memory()
+{
+    static const size_t buffer_size = 32 * 1024 * 1024;
+    static const size_t chunk_size = 1024 * 1024;
+
+    Isolation::worker_thread();
+
+    std::vector<char> src(buffer_size, 1);
+    std::vector<char> dst(buffer_size);
+
+    while (!quit_) {
+        wait_for_load();
+
+        for (size_t offset = 0; offset < buffer_size && load_; offset += chunk_size)
+            memcpy(&dst[offset], &src[offset], chunk_size);
+    }
+}
+
+/*
+ * Clears a framebuffer of its own over and over, which loads the GPU (and
+ * its memory bandwidth) without needing any shaders or data files.
+ */
+void
+CoRunners::run_gpu(GLWorkerContext *context)
+{
+    static const GLsizei size = 1024;
+    /* Submit several clears at a time, but don't let them queue up */
+    static const unsigned int clears_per_finish = 8;
+
+    Isolation::worker_thread();
+
+    if (!context->make_current()) {
+        Log::error("Failed to make the context of a GPU co-runner current\n");
+        return;
+    }
+
+    GLuint texture;
+    GLuint fbo;
+
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+    GLExtensions::GenFramebuffers(1, &fbo);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, texture, 0);
+    glViewport(0, 0, size, size);
+
+    unsigned int frame = 0;
+
+    while (!quit_) {
+        wait_for_load();
+
+        for (unsigned int i = 0; i < clears_per_finish && load_; i++) {
+            float c = (frame++ % 256) / 255.0f;
+            glClearColor(c, 1.0f - c, c, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        glFinish();
+    }
+
+    GLExtensions::DeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &texture);
+
+    context->release();
+}
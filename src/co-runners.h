@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_CO_RUNNERS_H_
+#define GLMARK2_CO_RUNNERS_H_
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class Canvas;
+class GLWorkerContext;
+
+/**
+ * Runs background load next to the benchmark (--co-runners): threads that
+ * spin on the CPU, stream through memory, or fill a framebuffer from a
+ * second GL context. The load is switched on and off while a scene runs,
+ * so the frames rendered with and without it can be compared.
+ */
+class CoRunners
+{
+public:
+    /**
+     * The number of threads of each kind of co-runner.
+     */
+    struct Config {
+        Config() : cpu(0), memory(0), gpu(0) {}
+
+        unsigned int cpu;
+        unsigned int memory;
+        unsigned int gpu;
+    };
+
+    CoRunners();
+    ~CoRunners();
+
+    /**
+     * Parses a --co-runners specification, e.g. 'cpu:2,memory:1,gpu:1'.
+     *
+     * @return whether the specification is valid
+     */
+    static bool parse(const std::string &spec, Config &config);
+
+    /**
+     * Starts the co-runner threads, idle. The GPU co-runners get their own
+     * contexts from the canvas, so this must be called from the render
+     * thread.
+     *
+     * @return whether all the co-runners were started
+     */
+    bool start(Canvas &canvas, const Config &config);
+
+    /**
+     * Stops and joins the co-runner threads.
+     */
+    void stop();
+
+    /**
+     * Whether the co-runner threads have been started.
+     */
+    bool started() const { return !threads_.empty(); }
+
+    /**
+     * Switches the load of the co-runners on or off.
+     */
+    void load(bool on) { load_ = on; }
+
+    /**
+     * Whether the co-runners are loading the system.
+     */
+    bool loaded() const { return load_; }
+
+private:
+    void wait_for_load();
+    void run_cpu();
+    void run_memory();
+    void run_gpu(GLWorkerContext *context);
+
+    std::vector<std::thread> threads_;
+    std::vector<GLWorkerContext *> contexts_;
+    std::atomic<bool> load_;
+    std::atomic<bool> quit_;
+};
+
+#endif /* GLMARK2_CO_RUNNERS_H_ */
@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "debug-markers.h"
+#include "options.h"
+
+DebugMarkers::Group::Group(const char *name) :
+    pushed_(active())
+{
+    if (pushed_)
+        push(name);
+}
+
+DebugMarkers::Group::Group(const std::string &name) :
+    pushed_(active())
+{
+    if (pushed_)
+        push(name);
+}
+
+DebugMarkers::Group::~Group()
+{
+    if (pushed_)
+        pop();
+}
+
+bool
+DebugMarkers::active()
+{
+    return Options::debug_markers && GLExtensions::PushDebugGroup &&
+           GLExtensions::PopDebugGroup;
+}
+
+void
+DebugMarkers::push(const std::string &name)
+{
+    if (!active())
+        return;
+
+    GLExtensions::PushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name.c_str());
+}
+
+void
+DebugMarkers::pop()
+{
+    if (!active())
+        return;
+
+    GLExtensions::PopDebugGroup();
+}
+
+void
+DebugMarkers::label(GLenum identifier, GLuint name, const std::string &label)
+{
+    if (!Options::debug_markers || !GLExtensions::ObjectLabel || !name)
+        return;
+
+    GLExtensions::ObjectLabel(identifier, name, -1, label.c_str());
+}
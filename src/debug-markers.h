@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_DEBUG_MARKERS_H_
+#define GLMARK2_DEBUG_MARKERS_H_
+
+#include "gl-headers.h"
+
+#include <string>
+
+/**
+ * Annotates the GL command stream for GPU debuggers and profilers
+ * (RenderDoc, vendor profilers...) with KHR_debug groups around the
+ * passes of the frames and labels on the GL objects (--debug-markers).
+ *
+ * Without --debug-markers, or without KHR_debug support, nothing is sent
+ * to GL.
+ */
+class DebugMarkers
+{
+public:
+    /**
+     * Wraps the GL commands issued during the lifetime of the object in a
+     * debug group.
+     */
+    class Group
+    {
+    public:
+        Group(const char *name);
+        Group(const std::string &name);
+        ~Group();
+
+    private:
+        bool pushed_;
+    };
+
+    /**
+     * Whether the markers are sent to GL.
+     */
+    static bool active();
+
+    /**
+     * Starts a debug group, if active.
+     */
+    static void push(const std::string &name);
+
+    /**
+     * Ends the debug group started by the last push(), if active.
+     */
+    static void pop();
+
+    /**
+     * Labels a GL object, if active.
+     *
+     * @param identifier the type of the object, e.g. GL_TEXTURE
+     * @param name the name of the object
+     * @param label the label
+     */
+    static void label(GLenum identifier, GLuint name, const std::string &label);
+};
+
+#endif
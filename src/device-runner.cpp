@@ -0,0 +1,216 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "device-runner.h"
+#include "results-file.h"
+#include "options.h"
+#include "log.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#if !defined(WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#if !defined(WIN32)
+
+/*
+ * Gets the results file of the run on a device. The JSON files are only
+ * used to merge the results, while the CSV files are kept.
+ */
+static std::string
+device_results_file(unsigned int index)
+{
+    static const std::string csv_ext(".csv");
+    const std::string &filename(Options::results_file);
+    std::stringstream ss;
+
+    if (filename.empty()) {
+        const char *tmpdir = getenv("TMPDIR");
+        ss << (tmpdir ? tmpdir : "/tmp") << "/glmark2-" << getpid()
+           << "-device" << index << ".json";
+    }
+    else if (ResultsFile::format_from_filename(filename) == ResultsFile::FormatCSV) {
+        ss << filename.substr(0, filename.size() - csv_ext.size())
+           << "-device" << index << csv_ext;
+    }
+    else {
+        ss << filename << ".device" << index;
+    }
+
+    return ss.str();
+}
+
+/* Gets the arguments of a run on a device, from the arguments of this one */
+static std::vector<std::string>
+device_args(char *argv[], const std::string &device, const std::string &results_file)
+{
+    std::vector<std::string> args;
+
+    args.push_back(argv[0]);
+
+    for (int i = 1; argv[i]; i++) {
+        std::string arg(argv[i]);
+
+        if (arg == "--all-devices" ||
+            arg.compare(0, 9, "--device=") == 0 ||
+            arg.compare(0, 15, "--results-file=") == 0)
+        {
+            continue;
+        }
+
+        if (arg == "--device" || arg == "--results-file") {
+            if (argv[i + 1])
+                i++;
+            continue;
+        }
+
+        args.push_back(arg);
+    }
+
+    args.push_back("--device");
+    args.push_back(device);
+    args.push_back("--results-file");
+    args.push_back(results_file);
+
+    return args;
+}
+
+/* Runs a command and returns its exit status, or -1 */
+static int
+run_process(const std::vector<std::string> &args)
+{
+    std::vector<char *> cargs;
+    for (size_t i = 0; i < args.size(); i++)
+        cargs.push_back(const_cast<char *>(args[i].c_str()));
+    cargs.push_back(0);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        Log::error("Failed to start a run: %s\n", strerror(errno));
+        return -1;
+    }
+
+    if (pid == 0) {
+        signal(SIGINT, SIG_DFL);
+        execvp(cargs[0], &cargs[0]);
+        fprintf(stderr, "Failed to run %s: %s\n", cargs[0], strerror(errno));
+        _exit(127);
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR)
+            return -1;
+    }
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static std::string
+read_file(const std::string &filename)
+{
+    std::ifstream in(filename.c_str());
+    std::stringstream ss;
+
+    if (in)
+        ss << in.rdbuf();
+
+    return ss.str();
+}
+
+#endif
+
+int
+DeviceRunner::run(char *argv[], const std::vector<std::string> &devices)
+{
+#if defined(WIN32)
+    static_cast<void>(argv);
+    static_cast<void>(devices);
+    Log::error("--all-devices is not supported on this platform\n");
+    return 1;
+#else
+    bool csv = !Options::results_file.empty() &&
+               ResultsFile::format_from_filename(Options::results_file) ==
+               ResultsFile::FormatCSV;
+    std::vector<DeviceResults> results;
+    int ret = 0;
+
+    /* Let the runs handle Ctrl-C, and report the devices run so far */
+    signal(SIGINT, SIG_IGN);
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        std::string results_file(device_results_file(i));
+        DeviceResults result;
+
+        Log::info("Running on device %u: %s\n",
+                  static_cast<unsigned int>(i), devices[i].c_str());
+
+        result.device = devices[i];
+        result.exit_status = run_process(device_args(argv, devices[i], results_file));
+
+        if (csv) {
+            Log::info("The results of device %u are in %s\n",
+                      static_cast<unsigned int>(i), results_file.c_str());
+        }
+        else {
+            result.json = read_file(results_file);
+            remove(results_file.c_str());
+
+            /* The overall score is the last entry of the results */
+            size_t pos = result.json.rfind("\"score\": ");
+            if (pos != std::string::npos)
+                result.score = strtoul(result.json.c_str() + pos + 9, 0, 10);
+        }
+
+        if (result.exit_status != 0)
+            ret = 1;
+
+        results.push_back(result);
+    }
+
+    signal(SIGINT, SIG_DFL);
+
+    Log::info("=======================================================\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const DeviceResults &r(results[i]);
+
+        if (r.exit_status != 0)
+            Log::info("    %s: Failed (exit status %d)\n", r.device.c_str(), r.exit_status);
+        else if (csv)
+            Log::info("    %s: Done\n", r.device.c_str());
+        else
+            Log::info("    %s: glmark2 Score: %u\n", r.device.c_str(), r.score);
+    }
+    Log::info("=======================================================\n");
+
+    if (!Options::results_file.empty() && !csv &&
+        !ResultsFile::write_devices(Options::results_file, results))
+    {
+        ret = 1;
+    }
+
+    return ret;
+#endif
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_DEVICE_RUNNER_H_
+#define GLMARK2_DEVICE_RUNNER_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * Runs the benchmarks on several devices (--all-devices).
+ */
+class DeviceRunner
+{
+public:
+    /**
+     * Runs glmark2 with the same options on each device in turn, each in
+     * its own process, and merges the results.
+     *
+     * @param argv the command line arguments
+     * @param devices the names of the devices, as listed by the native state
+     *
+     * @return the exit status, 0 if the runs on all the devices succeeded
+     */
+    static int run(char *argv[], const std::vector<std::string> &devices);
+};
+
+#endif /* GLMARK2_DEVICE_RUNNER_H_ */
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "device-selection.h"
+#include "options.h"
+#include "log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#if !defined(WIN32)
+#include <dirent.h>
+#endif
+
+bool
+DeviceSelection::find(const std::vector<std::string> &devices,
+                      const std::string &device, size_t &index)
+{
+    if (!device.empty() &&
+        device.find_first_not_of("0123456789") == std::string::npos)
+    {
+        index = strtoul(device.c_str(), 0, 10);
+        return index < devices.size();
+    }
+
+    std::vector<std::string>::const_iterator iter =
+        std::find(devices.begin(), devices.end(), device);
+    index = iter - devices.begin();
+
+    return iter != devices.end();
+}
+
+bool
+DeviceSelection::list_dri_prime_devices(std::vector<std::string> &devices)
+{
+#if defined(WIN32)
+    static_cast<void>(devices);
+    return false;
+#else
+    static const std::string render_suffix("-render");
+
+    DIR *dir = opendir("/dev/dri/by-path");
+    if (!dir)
+        return false;
+
+    std::vector<std::string> tags;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        std::string name(entry->d_name);
+        if (name.size() <= render_suffix.size() ||
+            name.compare(name.size() - render_suffix.size(),
+                         render_suffix.size(), render_suffix) != 0)
+        {
+            continue;
+        }
+
+        /* DRI_PRIME uses the udev ID_PATH_TAG form of the path */
+        std::string tag(name, 0, name.size() - render_suffix.size());
+        std::replace(tag.begin(), tag.end(), ':', '_');
+        std::replace(tag.begin(), tag.end(), '.', '_');
+        tags.push_back(tag);
+    }
+    closedir(dir);
+
+    std::sort(tags.begin(), tags.end());
+    devices.insert(devices.end(), tags.begin(), tags.end());
+
+    return true;
+#endif
+}
+
+bool
+DeviceSelection::select_dri_prime_device()
+{
+#if !defined(WIN32)
+    if (Options::device.empty())
+        return true;
+
+    std::vector<std::string> devices;
+    std::string dri_prime(Options::device);
+    size_t index;
+
+    list_dri_prime_devices(devices);
+
+    if (find(devices, Options::device, index)) {
+        dri_prime = devices[index];
+    }
+    else if (Options::device.find_first_not_of("0123456789") == std::string::npos) {
+        Log::error("Invalid --device %s, there are %u devices\n",
+                   Options::device.c_str(), static_cast<unsigned int>(devices.size()));
+        return false;
+    }
+
+    /* Names that aren't listed may still be understood by DRI_PRIME */
+    Log::debug("Selecting the device with DRI_PRIME=%s\n", dri_prime.c_str());
+    setenv("DRI_PRIME", dri_prime.c_str(), 1);
+#endif
+    return true;
+}
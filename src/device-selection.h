@@ -0,0 +1,63 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_DEVICE_SELECTION_H_
+#define GLMARK2_DEVICE_SELECTION_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * Helpers for selecting the GPU to render on with --device.
+ */
+struct DeviceSelection
+{
+    /**
+     * Finds a device given as an index or a name in a list of devices.
+     *
+     * @param devices the names of the devices
+     * @param device the index or the name of the device
+     * @param index the index of the device found
+     *
+     * @return whether the device was found
+     */
+    static bool find(const std::vector<std::string> &devices,
+                     const std::string &device, size_t &index);
+
+    /**
+     * Lists the GPUs that can be selected with the Mesa DRI_PRIME
+     * environment variable, by the path tags of their render nodes
+     * (e.g. pci-0000_01_00_0).
+     *
+     * @param devices the list to append the devices to
+     *
+     * @return whether the render nodes could be listed
+     */
+    static bool list_dri_prime_devices(std::vector<std::string> &devices);
+
+    /**
+     * Selects the --device GPU by setting DRI_PRIME, for the flavors whose
+     * GL library picks the GPU itself. Must be called before the GL library
+     * is loaded.
+     *
+     * @return false if the device is an index that is out of range
+     */
+    static bool select_dri_prime_device();
+};
+
+#endif /* GLMARK2_DEVICE_SELECTION_H_ */
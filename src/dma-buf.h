@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_DMA_BUF_H_
+#define GLMARK2_DMA_BUF_H_
+
+#include <stdint.h>
+
+/* The DRM fourcc codes of the formats used with DmaBufImage (drm_fourcc.h) */
+const uint32_t DmaBufFormatABGR8888 = 0x34324241;
+const uint32_t DmaBufFormatNV12 = 0x3231564e;
+const uint32_t DmaBufFormatYUV420 = 0x32315559;
+
+/**
+ * A linear buffer that can be shared with other devices through a dma-buf fd.
+ */
+struct DmaBuf
+{
+    DmaBuf() : fd(-1), stride(0), handle(0) {}
+
+    /* The dma-buf fd, owned by the buffer */
+    int fd;
+    /* The bytes per row */
+    unsigned int stride;
+    /* The allocation, for the native state that created the buffer */
+    void *handle;
+};
+
+/**
+ * An image made of planes in dma-bufs (EGL_EXT_image_dma_buf_import).
+ */
+struct DmaBufImage
+{
+    static const unsigned int max_planes = 3;
+
+    DmaBufImage() : fourcc(0), width(0), height(0), num_planes(0)
+    {
+        for (unsigned int i = 0; i < max_planes; i++) {
+            fds[i] = -1;
+            offsets[i] = 0;
+            strides[i] = 0;
+        }
+    }
+
+    uint32_t fourcc;
+    unsigned int width;
+    unsigned int height;
+    unsigned int num_planes;
+    /* The fds stay owned by their buffers */
+    int fds[max_planes];
+    unsigned int offsets[max_planes];
+    unsigned int strides[max_planes];
+};
+
+#endif /* GLMARK2_DMA_BUF_H_ */
@@ -0,0 +1,284 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "energy-meter.h"
+#include "log.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+namespace
+{
+
+/* The minimum interval between readings, as reading sysfs isn't free */
+const uint64_t sample_interval_us = 100000;
+
+/* The range of the hwmon energy inputs, which are 64-bit */
+const double hwmon_energy_range = 18446744073709551616.0;
+
+#ifdef __linux__
+
+bool
+has_suffix(const std::string &str, const std::string &suffix)
+{
+    return str.size() > suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+#endif
+
+/* Reads a number from a sysfs file */
+bool
+read_value(const std::string &path, double &value)
+{
+    std::ifstream file(path.c_str());
+    return static_cast<bool>(file >> value);
+}
+
+/* Reads a number from a sysfs file, or -1 if it can't be read */
+double
+read_value(const std::string &path)
+{
+    double value;
+    return read_value(path, value) ? value : -1.0;
+}
+
+}
+
+EnergyMeter::EnergyMeter() :
+    running_(false), last_sample_(0), start_(0), joules_(0.0), seconds_(0.0)
+{
+}
+
+bool
+EnergyMeter::init()
+{
+    sources_.clear();
+    source_.clear();
+
+#ifdef __linux__
+    static const std::string powercap_dir("/sys/class/powercap");
+    static const std::string hwmon_dir("/sys/class/hwmon");
+    static const std::string power_supply_dir("/sys/class/power_supply");
+
+    /*
+     * The top-level RAPL domains (e.g. intel-rapl:0), whose counters
+     * include those of their subdomains (e.g. intel-rapl:0:0), in µJ.
+     * They are often only readable by root.
+     */
+    std::vector<std::string> domains(Util::list_dir(powercap_dir, "intel-rapl:"));
+    for (size_t i = 0; i < domains.size(); i++) {
+        if (std::count(domains[i].begin(), domains[i].end(), ':') != 1)
+            continue;
+
+        std::string path(powercap_dir + "/" + domains[i]);
+        Source source;
+        source.path = path + "/energy_uj";
+        source.counter = true;
+        source.range = read_value(path + "/max_energy_range_uj");
+        if (read_value(source.path) >= 0.0 && source.range > 0.0)
+            sources_.push_back(source);
+    }
+    if (!sources_.empty())
+        source_ = "rapl";
+
+    /* The hwmon energy inputs, in µJ */
+    std::vector<std::string> hwmons(Util::list_dir(hwmon_dir, "hwmon"));
+    if (sources_.empty()) {
+        for (size_t i = 0; i < hwmons.size(); i++) {
+            std::string path(hwmon_dir + "/" + hwmons[i]);
+            std::vector<std::string> inputs(Util::list_dir(path, "energy"));
+
+            for (size_t j = 0; j < inputs.size(); j++) {
+                Source source;
+                source.path = path + "/" + inputs[j];
+                source.counter = true;
+                source.range = hwmon_energy_range;
+                if (has_suffix(inputs[j], "_input") && read_value(source.path) >= 0.0)
+                    sources_.push_back(source);
+            }
+        }
+        if (!sources_.empty())
+            source_ = "hwmon";
+    }
+
+    /* Without counters, the hwmon power inputs, in µW */
+    if (sources_.empty()) {
+        for (size_t i = 0; i < hwmons.size(); i++) {
+            std::string path(hwmon_dir + "/" + hwmons[i]);
+            std::vector<std::string> inputs(Util::list_dir(path, "power"));
+
+            for (size_t j = 0; j < inputs.size(); j++) {
+                const std::string &input(inputs[j]);
+                std::string sensor(input.substr(0, input.find('_')));
+
+                /* Only the average of the sensors without an input */
+                if (!has_suffix(input, "_input") &&
+                    !(has_suffix(input, "_average") &&
+                      std::find(inputs.begin(), inputs.end(), sensor + "_input") == inputs.end()))
+                {
+                    continue;
+                }
+
+                Source source;
+                source.path = path + "/" + input;
+                source.counter = false;
+                source.range = 0.0;
+                if (read_value(source.path) >= 0.0)
+                    sources_.push_back(source);
+            }
+        }
+        if (!sources_.empty())
+            source_ = "hwmon";
+    }
+
+    /*
+     * Without counters, the power drawn from the discharging batteries, in µW,
+     * or from their current (in µA) and voltage (in µV).
+     */
+    if (sources_.empty()) {
+        std::vector<std::string> supplies(Util::list_dir(power_supply_dir, ""));
+        for (size_t i = 0; i < supplies.size(); i++) {
+            std::string path(power_supply_dir + "/" + supplies[i]);
+            if (Util::read_first_line(path + "/type") != "Battery" ||
+                Util::read_first_line(path + "/status") != "Discharging")
+            {
+                continue;
+            }
+
+            Source source;
+            double value;
+            source.counter = false;
+            source.range = 0.0;
+            if (read_value(path + "/power_now", value)) {
+                source.path = path + "/power_now";
+            }
+            else if (read_value(path + "/current_now", value) &&
+                     read_value(path + "/voltage_now", value))
+            {
+                source.path = path + "/current_now";
+                source.voltage_path = path + "/voltage_now";
+            }
+            else {
+                continue;
+            }
+            sources_.push_back(source);
+        }
+        if (!sources_.empty())
+            source_ = "power_supply";
+    }
+#endif
+
+    Log::debug("EnergyMeter: Found %u %s sources\n",
+               static_cast<unsigned int>(sources_.size()),
+               source_.empty() ? "energy" : source_.c_str());
+
+    return !sources_.empty();
+}
+
+void
+EnergyMeter::start()
+{
+    joules_ = 0.0;
+    seconds_ = 0.0;
+
+    for (std::vector<Source>::iterator iter = sources_.begin();
+         iter != sources_.end();
+         iter++)
+    {
+        iter->last = reading(*iter);
+    }
+
+    start_ = Util::get_timestamp_us();
+    last_sample_ = start_;
+    running_ = true;
+}
+
+void
+EnergyMeter::sample()
+{
+    if (running_)
+        read(false);
+}
+
+void
+EnergyMeter::stop()
+{
+    if (running_)
+        read(true);
+    running_ = false;
+}
+
+double
+EnergyMeter::reading(const Source &source)
+{
+    double value;
+
+    if (!read_value(source.path, value))
+        return -1.0;
+
+    /* Some batteries report their discharge as negative */
+    value = std::fabs(value);
+
+    /* µA * µV is 10^-6 µW */
+    if (!source.voltage_path.empty()) {
+        double voltage;
+        if (!read_value(source.voltage_path, voltage))
+            return -1.0;
+        value *= voltage / 1000000.0;
+    }
+
+    return value;
+}
+
+void
+EnergyMeter::read(bool force)
+{
+    uint64_t now = Util::get_timestamp_us();
+
+    if (!force && now - last_sample_ < sample_interval_us)
+        return;
+
+    double interval = (now - last_sample_) / 1000000.0;
+
+    for (std::vector<Source>::iterator iter = sources_.begin();
+         iter != sources_.end();
+         iter++)
+    {
+        double value = reading(*iter);
+        if (value < 0.0)
+            continue;
+
+        if (iter->counter) {
+            double delta = value - iter->last;
+            if (delta < 0.0)
+                delta += iter->range;
+            joules_ += delta / 1000000.0;
+        }
+        else {
+            /* Power inputs are integrated with the trapezoidal rule */
+            joules_ += (iter->last + value) / 2.0 / 1000000.0 * interval;
+        }
+        iter->last = value;
+    }
+
+    last_sample_ = now;
+    seconds_ = (now - start_) / 1000000.0;
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_ENERGY_METER_H_
+#define GLMARK2_ENERGY_METER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Measures the energy used by the system over the frames of a benchmark
+ * (--energy).
+ *
+ * On Linux, the energy counters are preferred: the top-level RAPL domains
+ * in powercap and the hwmon energy inputs. Without them, the hwmon power
+ * inputs and the power of the discharging batteries in power_supply are
+ * sampled and integrated over time. On other systems there are no sources.
+ */
+class EnergyMeter
+{
+public:
+    EnergyMeter();
+
+    /**
+     * Discovers the energy or power sources.
+     *
+     * @return whether any source was found
+     */
+    bool init();
+
+    /**
+     * Starts measuring, from zero.
+     */
+    void start();
+
+    /**
+     * Reads the sources, if enough time has passed since the last reading.
+     * Should be called at least once per second, so the counters can't wrap
+     * around more than once between readings.
+     */
+    void sample();
+
+    /**
+     * Reads the sources a last time and stops measuring.
+     */
+    void stop();
+
+    /**
+     * The energy used since start(), in joules.
+     */
+    double joules() const { return joules_; }
+
+    /**
+     * The time measured since start(), in seconds.
+     */
+    double seconds() const { return seconds_; }
+
+    /**
+     * A description of the sources, e.g. "rapl" or "power_supply".
+     */
+    const std::string &source() const { return source_; }
+
+private:
+    struct Source {
+        std::string path;
+        /* The voltage of current inputs, in µV, or empty */
+        std::string voltage_path;
+        /* Whether the source is an energy counter, or a power input */
+        bool counter;
+        /* The range of energy counters, in µJ */
+        double range;
+        /* The last reading, in µJ for counters and µW for power inputs */
+        double last;
+    };
+
+    static double reading(const Source &source);
+    void read(bool force);
+
+    std::vector<Source> sources_;
+    std::string source_;
+    bool running_;
+    uint64_t last_sample_;
+    uint64_t start_;
+    double joules_;
+    double seconds_;
+};
+
+#endif /* GLMARK2_ENERGY_METER_H_ */
@@ -0,0 +1,190 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "flush-points.h"
+#include "gl-headers.h"
+#include "util.h"
+
+#include <vector>
+
+namespace
+{
+
+struct ThreadState
+{
+    ThreadState() : draw_framebuffer(~0U), draws(0), flushes(0) {}
+
+    /* The last draw framebuffer bound, or ~0U if not known */
+    GLuint draw_framebuffer;
+    /* The draws since the last flush */
+    unsigned int draws;
+    uint64_t flushes;
+};
+
+/* Contexts are current on a single thread, so each thread has its state */
+thread_local ThreadState state;
+
+FlushPoints::Config config;
+bool flush_points_active = false;
+
+PFNGLDRAWARRAYSPROC real_DrawArrays;
+PFNGLDRAWELEMENTSPROC real_DrawElements;
+void (GLAD_API_PTR *real_DrawArraysInstanced)(GLenum mode, GLint first, GLsizei count,
+                                              GLsizei instancecount);
+void (GLAD_API_PTR *real_DrawElementsInstanced)(GLenum mode, GLsizei count, GLenum type,
+                                                const void *indices, GLsizei instancecount);
+void (GLAD_API_PTR *real_BindFramebuffer)(GLenum target, GLuint framebuffer);
+
+void
+flush()
+{
+    glFlush();
+    state.draws = 0;
+    state.flushes++;
+}
+
+/* Counts a draw that was just issued, flushing if it is the Nth */
+void
+drawn()
+{
+    state.draws++;
+
+    if (config.draws > 0 && state.draws >= config.draws)
+        flush();
+}
+
+void GLAD_API_PTR
+flushing_DrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    real_DrawArrays(mode, first, count);
+    drawn();
+}
+
+void GLAD_API_PTR
+flushing_DrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices)
+{
+    real_DrawElements(mode, count, type, indices);
+    drawn();
+}
+
+void GLAD_API_PTR
+flushing_DrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+{
+    real_DrawArraysInstanced(mode, first, count, instancecount);
+    drawn();
+}
+
+void GLAD_API_PTR
+flushing_DrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                               const void *indices, GLsizei instancecount)
+{
+    real_DrawElementsInstanced(mode, count, type, indices, instancecount);
+    drawn();
+}
+
+/*
+ * Binding another draw framebuffer after drawing ends a pass, which is
+ * flushed before the next one starts.
+ */
+void GLAD_API_PTR
+flushing_BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    if (target != GL_READ_FRAMEBUFFER && framebuffer != state.draw_framebuffer) {
+        if (config.passes && state.draws > 0)
+            flush();
+        state.draw_framebuffer = framebuffer;
+    }
+
+    real_BindFramebuffer(target, framebuffer);
+}
+
+/* Replaces an entry point by its flushing version, unless already done */
+template <typename T> void
+wrap(T &entry_point, T &real, T flushing)
+{
+    if (entry_point && entry_point != flushing) {
+        real = entry_point;
+        entry_point = flushing;
+    }
+}
+
+}
+
+bool
+FlushPoints::parse(const std::string &spec, Config &c)
+{
+    std::vector<std::string> elems;
+    Util::split(spec, ',', elems, Util::SplitModeNormal);
+
+    c = Config();
+
+    for (std::vector<std::string>::const_iterator iter = elems.begin();
+         iter != elems.end();
+         iter++)
+    {
+        std::vector<std::string> kv;
+        Util::split(*iter, ':', kv, Util::SplitModeNormal);
+
+        if (kv.size() == 1 && kv[0] == "passes") {
+            c.passes = true;
+        }
+        else if (kv.size() == 2 && kv[0] == "draws") {
+            int draws = Util::fromString<int>(kv[1]);
+            if (draws <= 0)
+                return false;
+            c.draws = draws;
+        }
+        else {
+            return false;
+        }
+    }
+
+    return c.passes || c.draws > 0;
+}
+
+void
+FlushPoints::install(const std::string &spec)
+{
+    flush_points_active = !spec.empty() && parse(spec, config);
+    if (!flush_points_active)
+        return;
+
+    wrap(glad_glDrawArrays, real_DrawArrays, flushing_DrawArrays);
+    wrap(glad_glDrawElements, real_DrawElements, flushing_DrawElements);
+    wrap(GLExtensions::DrawArraysInstanced, real_DrawArraysInstanced,
+         flushing_DrawArraysInstanced);
+    wrap(GLExtensions::DrawElementsInstanced, real_DrawElementsInstanced,
+         flushing_DrawElementsInstanced);
+    wrap(GLExtensions::BindFramebuffer, real_BindFramebuffer, flushing_BindFramebuffer);
+
+    /* The entry points are loaded for a new context */
+    state.draw_framebuffer = ~0U;
+    state.draws = 0;
+}
+
+bool
+FlushPoints::active()
+{
+    return flush_points_active;
+}
+
+uint64_t
+FlushPoints::flushes()
+{
+    return state.flushes;
+}
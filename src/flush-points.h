@@ -0,0 +1,77 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FLUSH_POINTS_H_
+#define GLMARK2_FLUSH_POINTS_H_
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Flushes the submitted commands at explicit points of the frames
+ * (--flush-points): at the pass boundaries, when a draw framebuffer is
+ * bound after drawing to another one, and/or every N draws. Flushing early
+ * lets the GPU start on a pass sooner, at the cost of smaller batches,
+ * which some drivers (tilers in particular) handle much better than others.
+ *
+ * Like the StateTracker, it wraps the loaded GL entry points, so the passes
+ * of the scenes and renderers are found without changing them. The draws
+ * since the last flush are counted per thread.
+ */
+class FlushPoints
+{
+public:
+    /**
+     * Where to flush.
+     */
+    struct Config {
+        Config() : passes(false), draws(0) {}
+
+        /* Flush at the pass boundaries */
+        bool passes;
+        /* Flush every N draws, or never if 0 */
+        unsigned int draws;
+    };
+
+    /**
+     * Parses a --flush-points specification, e.g. 'passes' or
+     * 'passes,draws:16'.
+     *
+     * @return whether the specification is valid
+     */
+    static bool parse(const std::string &spec, Config &config);
+
+    /**
+     * Wraps the loaded GL entry points to flush as specified, unless the
+     * specification is empty. Must be called each time the entry points are
+     * loaded.
+     */
+    static void install(const std::string &spec);
+
+    /**
+     * Whether flush points are installed.
+     */
+    static bool active();
+
+    /**
+     * The number of flushes issued by the current thread.
+     */
+    static uint64_t flushes();
+};
+
+#endif /* GLMARK2_FLUSH_POINTS_H_ */
@@ -0,0 +1,382 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "fork-server.h"
+#include "benchmark.h"
+#include "main-loop.h"
+#include "options.h"
+#include "scene.h"
+#include "log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#if !defined(WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/*
+ * The results of a benchmark process are sent back through a pipe as text:
+ * the canvas information (if asked for), the benchmark results and the
+ * score entries, each list preceded by its size, then "end". Strings are
+ * preceded by their length, so that they may contain any character.
+ */
+
+static void
+write_string(std::ostream &out, const std::string &str)
+{
+    out << str.size() << ' ' << str << '\n';
+}
+
+static bool
+read_string(std::istream &in, std::string &str)
+{
+    size_t size = 0;
+
+    if (!(in >> size) || in.get() != ' ')
+        return false;
+
+    str.resize(size);
+    if (size > 0)
+        in.read(&str[0], size);
+
+    return in.good();
+}
+
+static void
+write_summary(std::ostream &out, const FrameStats::Summary &summary)
+{
+    out << summary.count << ' ' << summary.mean << ' ' << summary.min << ' '
+        << summary.p50 << ' ' << summary.p90 << ' ' << summary.p99 << ' '
+        << summary.p999 << ' ' << summary.max << ' ' << summary.stddev << '\n';
+}
+
+static bool
+read_summary(std::istream &in, FrameStats::Summary &summary)
+{
+    in >> summary.count >> summary.mean >> summary.min >> summary.p50
+       >> summary.p90 >> summary.p99 >> summary.p999 >> summary.max
+       >> summary.stddev;
+
+    return in.good();
+}
+
+static void
+write_result(std::ostream &out, const BenchmarkResult &result)
+{
+    write_string(out, result.scene);
+    write_string(out, result.options);
+    out << result.status << ' ' << result.width << ' ' << result.height << ' '
+        << result.repetition << ' ' << result.frames << ' '
+        << result.elapsed_time << ' ' << result.fps << '\n';
+    write_summary(out, result.frame_time);
+    write_summary(out, result.gpu_time);
+
+    out << result.measurements.size() << '\n';
+    for (size_t i = 0; i < result.measurements.size(); i++) {
+        write_string(out, result.measurements[i].first);
+        write_summary(out, result.measurements[i].second);
+    }
+
+    out << result.rates.size() << '\n';
+    for (size_t i = 0; i < result.rates.size(); i++) {
+        write_string(out, result.rates[i].first);
+        out << result.rates[i].second << '\n';
+    }
+}
+
+static bool
+read_result(std::istream &in, BenchmarkResult &result)
+{
+    int status = 0;
+    size_t count = 0;
+
+    if (!read_string(in, result.scene) || !read_string(in, result.options))
+        return false;
+
+    in >> status >> result.width >> result.height >> result.repetition
+       >> result.frames >> result.elapsed_time >> result.fps;
+    result.status = static_cast<BenchmarkResult::Status>(status);
+
+    if (!read_summary(in, result.frame_time) || !read_summary(in, result.gpu_time))
+        return false;
+
+    if (!(in >> count))
+        return false;
+    for (size_t i = 0; i < count; i++) {
+        std::pair<std::string, FrameStats::Summary> measurement;
+        if (!read_string(in, measurement.first) || !read_summary(in, measurement.second))
+            return false;
+        result.measurements.push_back(measurement);
+    }
+
+    if (!(in >> count))
+        return false;
+    for (size_t i = 0; i < count; i++) {
+        std::pair<std::string, double> rate;
+        if (!read_string(in, rate.first) || !(in >> rate.second))
+            return false;
+        result.rates.push_back(rate);
+    }
+
+    return true;
+}
+
+#if !defined(WIN32)
+
+/*
+ * Runs the benchmarks in the forked process, and writes their results to
+ * the pipe. Returns the exit status of the process.
+ */
+int
+ForkServer::run_child(const std::vector<Benchmark *> &benchmarks, bool print_info, int fd)
+{
+    if (!canvas_.init()) {
+        Log::error("%s: Could not initialize canvas\n", __FUNCTION__);
+        return 1;
+    }
+
+    if (print_info) {
+        canvas_.print_info();
+        Log::info("=======================================================\n");
+    }
+
+    canvas_.visible(true);
+
+    MainLoop *loop;
+    if (decorated_)
+        loop = new MainLoopDecoration(canvas_, benchmarks);
+    else
+        loop = new MainLoop(canvas_, benchmarks);
+
+    while (loop->step());
+
+    std::stringstream ss;
+    ss << std::setprecision(17);
+
+    Canvas::InfoList info;
+    if (print_info)
+        info = canvas_.info();
+
+    ss << info.size() << '\n';
+    for (size_t i = 0; i < info.size(); i++) {
+        write_string(ss, info[i].first);
+        write_string(ss, info[i].second);
+    }
+
+    const std::vector<BenchmarkResult> &results(loop->results());
+    ss << results.size() << '\n';
+    for (size_t i = 0; i < results.size(); i++)
+        write_result(ss, results[i]);
+
+    const std::vector<Score::Entry> &scores(loop->score_entries());
+    ss << scores.size() << '\n';
+    for (size_t i = 0; i < scores.size(); i++) {
+        write_string(ss, scores[i].scene);
+        write_string(ss, scores[i].options);
+        write_string(ss, scores[i].category);
+        ss << scores[i].weight << ' ' << scores[i].fps << '\n';
+    }
+
+    ss << "end\n";
+
+    delete loop;
+
+    std::string data(ss.str());
+    size_t written = 0;
+
+    while (written < data.size()) {
+        ssize_t ret = write(fd, data.data() + written, data.size() - written);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+            return 1;
+        written += ret;
+    }
+
+    return 0;
+}
+
+/*
+ * Reads what a benchmark process has sent. Returns false if it is
+ * incomplete, i.e. the process didn't run to completion.
+ */
+bool
+ForkServer::read_child(const std::string &data)
+{
+    std::istringstream in(data);
+    Canvas::InfoList info;
+    std::vector<BenchmarkResult> results;
+    std::vector<Score::Entry> scores;
+    size_t count = 0;
+    std::string end;
+
+    if (!(in >> count))
+        return false;
+    for (size_t i = 0; i < count; i++) {
+        std::pair<std::string, std::string> item;
+        if (!read_string(in, item.first) || !read_string(in, item.second))
+            return false;
+        info.push_back(item);
+    }
+
+    if (!(in >> count))
+        return false;
+    for (size_t i = 0; i < count; i++) {
+        BenchmarkResult result;
+        if (!read_result(in, result))
+            return false;
+        results.push_back(result);
+    }
+
+    if (!(in >> count))
+        return false;
+    for (size_t i = 0; i < count; i++) {
+        Score::Entry entry;
+        if (!read_string(in, entry.scene) || !read_string(in, entry.options) ||
+            !read_string(in, entry.category) || !(in >> entry.weight >> entry.fps))
+        {
+            return false;
+        }
+        scores.push_back(entry);
+    }
+
+    if (!(in >> end) || end != "end")
+        return false;
+
+    if (canvas_info_.empty())
+        canvas_info_ = info;
+    results_.insert(results_.end(), results.begin(), results.end());
+    scores_.insert(scores_.end(), scores.begin(), scores.end());
+
+    return true;
+}
+
+#endif
+
+bool
+ForkServer::run()
+{
+#if defined(WIN32)
+    Log::error("--fork-benchmarks is not supported on this platform\n");
+    return false;
+#else
+    std::vector<Benchmark *> option_benchmarks;
+    bool passed = true;
+
+    for (std::vector<Benchmark *>::const_iterator iter = benchmarks_.begin();
+         iter != benchmarks_.end();
+         iter++)
+    {
+        Benchmark *bench = *iter;
+
+        /* Each process sets the default options of the benchmarks so far */
+        if (bench->scene().name().empty()) {
+            option_benchmarks.push_back(bench);
+            continue;
+        }
+
+        std::vector<Benchmark *> run(option_benchmarks);
+        run.push_back(bench);
+
+        int fds[2];
+        if (pipe(fds) < 0) {
+            Log::error("Failed to create a pipe: %s\n", strerror(errno));
+            return false;
+        }
+
+        /* Don't let the process print what is still buffered */
+        Log::flush();
+
+        bool print_info = canvas_info_.empty();
+        pid_t pid = fork();
+
+        if (pid < 0) {
+            Log::error("Failed to start a benchmark process: %s\n", strerror(errno));
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+
+        if (pid == 0) {
+            close(fds[0]);
+            int status = run_child(run, print_info, fds[1]);
+            Log::flush();
+            /* Skip the destructors of the state shared with the parent */
+            _exit(status);
+        }
+
+        close(fds[1]);
+
+        std::string data;
+        char buf[4096];
+        ssize_t ret;
+
+        while ((ret = read(fds[0], buf, sizeof(buf))) != 0) {
+            if (ret < 0) {
+                if (errno == EINTR)
+                    continue;
+                break;
+            }
+            data.append(buf, ret);
+        }
+        close(fds[0]);
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR)
+                break;
+        }
+
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && read_child(data))
+            continue;
+
+        std::string options(bench->options_string());
+        std::stringstream reason;
+
+        if (WIFSIGNALED(status))
+            reason << "killed by signal " << WTERMSIG(status);
+        else
+            reason << "exit status " << WEXITSTATUS(status);
+
+        Log::info("[%s] %s: Failed (%s)\n", bench->scene().name().c_str(),
+                  options.empty() ? "<default>" : options.c_str(),
+                  reason.str().c_str());
+
+        BenchmarkResult result;
+        result.scene = bench->scene().name();
+        result.options = options;
+        result.status = BenchmarkResult::StatusFailure;
+        result.width = Options::size.first;
+        result.height = Options::size.second;
+        results_.push_back(result);
+
+        passed = false;
+    }
+
+    return passed;
+#endif
+}
+
+unsigned int
+ForkServer::score()
+{
+    return static_cast<unsigned int>(Score::compute(scores_, Options::score_model));
+}
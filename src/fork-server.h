@@ -0,0 +1,93 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FORK_SERVER_H_
+#define GLMARK2_FORK_SERVER_H_
+
+#include "canvas.h"
+#include "results-file.h"
+#include "score.h"
+
+#include <string>
+#include <vector>
+
+class Benchmark;
+
+/**
+ * Runs each benchmark in its own process (--fork-benchmarks).
+ *
+ * The processes are forked from this one once it has done the work that
+ * doesn't need a GL context (parsing the options and the benchmarks,
+ * mapping the data and decoding the textures), so they only have to
+ * create their context. A benchmark that crashes only fails itself.
+ */
+class ForkServer
+{
+public:
+    /**
+     * @param canvas the canvas, which must not be initialized yet
+     * @param benchmarks the benchmarks to run, including those setting
+     *                   the default options of the later ones
+     * @param decorated whether to run the benchmarks with decorations
+     */
+    ForkServer(Canvas &canvas, const std::vector<Benchmark *> &benchmarks,
+               bool decorated) :
+        canvas_(canvas), benchmarks_(benchmarks), decorated_(decorated) {}
+
+    /**
+     * Runs the benchmarks, one process after the other.
+     *
+     * @return whether all the processes ran their benchmark to completion
+     */
+    bool run();
+
+    /**
+     * Gets the information about the canvas, as reported by the first
+     * process that initialized it.
+     */
+    const Canvas::InfoList &canvas_info() { return canvas_info_; }
+
+    /**
+     * Gets the results of all the benchmarks, with the failed ones for the
+     * processes that crashed.
+     */
+    const std::vector<BenchmarkResult> &results() { return results_; }
+
+    /**
+     * Gets the entries of the score of all the benchmarks.
+     */
+    const std::vector<Score::Entry> &score_entries() { return scores_; }
+
+    /**
+     * Gets the total score of the benchmarks.
+     */
+    unsigned int score();
+
+private:
+    int run_child(const std::vector<Benchmark *> &benchmarks, bool print_info, int fd);
+    bool read_child(const std::string &data);
+
+    Canvas &canvas_;
+    const std::vector<Benchmark *> &benchmarks_;
+    bool decorated_;
+    Canvas::InfoList canvas_info_;
+    std::vector<BenchmarkResult> results_;
+    std::vector<Score::Entry> scores_;
+};
+
+#endif /* GLMARK2_FORK_SERVER_H_ */
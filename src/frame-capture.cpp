@@ -0,0 +1,307 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "frame-capture.h"
+#include "log.h"
+
+#include <png.h>
+#include <cstdio>
+#include <fstream>
+#include <algorithm>
+
+FrameCapture::FrameCapture() :
+    format_(FormatPNG), initialized_(false), use_buffers_(false),
+    readback_head_(0), readback_pending_(0), dropped_(0), quit_(false)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+    if (dropped_ > 0)
+        Log::info("Frame capture dropped %u frames\n", dropped_);
+}
+
+void
+FrameCapture::init(Format format)
+{
+    release();
+
+    format_ = format;
+
+#if GLMARK2_USE_GLESv2
+    /* Pixel pack buffers are only available in GLES 3.0 */
+    use_buffers_ = GLExtensions::version_supported(3, 0);
+#else
+    use_buffers_ = true;
+#endif
+    use_buffers_ = use_buffers_ &&
+                   GLExtensions::MapBufferRange && GLExtensions::UnmapBuffer &&
+                   GLExtensions::FenceSync && GLExtensions::DeleteSync &&
+                   GLExtensions::ClientWaitSync;
+
+    if (use_buffers_) {
+        for (unsigned int i = 0; i < readback_count; i++)
+            glGenBuffers(1, &readbacks_[i].buffer);
+    }
+    else {
+        Log::debug("Pixel buffer objects or sync objects are not supported,"
+                   " capturing frames synchronously\n");
+    }
+
+    readback_head_ = 0;
+    readback_pending_ = 0;
+    initialized_ = true;
+
+    if (!thread_.joinable())
+        thread_ = std::thread(&FrameCapture::writer_main, this);
+}
+
+void
+FrameCapture::release()
+{
+    if (!initialized_)
+        return;
+
+    complete_readbacks(true);
+
+    if (use_buffers_) {
+        for (unsigned int i = 0; i < readback_count; i++) {
+            glDeleteBuffers(1, &readbacks_[i].buffer);
+            readbacks_[i] = Readback();
+        }
+    }
+
+    initialized_ = false;
+}
+
+void
+FrameCapture::capture(int width, int height, const std::string &basename)
+{
+    if (!initialized_)
+        return;
+
+    std::string filename(basename + (format_ == FormatRaw ? ".raw" : ".png"));
+
+    if (!use_buffers_) {
+        Job *job = new Job();
+        job->filename = filename;
+        job->format = format_;
+        job->width = width;
+        job->height = height;
+        job->pixels.resize(static_cast<size_t>(width) * height * 4);
+        glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                     &job->pixels[0]);
+        queue_job(job);
+        return;
+    }
+
+    complete_readbacks(false);
+
+    /* All buffers are busy, we have to wait for the oldest one */
+    if (readback_pending_ == readback_count) {
+        Readback &oldest(readbacks_[readback_head_]);
+        GLExtensions::ClientWaitSync(oldest.fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                     1000000000);
+        complete_readbacks(false);
+    }
+    if (readback_pending_ == readback_count) {
+        dropped_++;
+        return;
+    }
+
+    Readback &rb(readbacks_[(readback_head_ + readback_pending_) % readback_count]);
+    GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer);
+    if (width != rb.width || height != rb.height)
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, 0, GL_STREAM_READ);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    rb.fence = GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    rb.width = width;
+    rb.height = height;
+    rb.filename = filename;
+    readback_pending_++;
+}
+
+FrameCapture::Format
+FrameCapture::format_from_str(const std::string &str)
+{
+    return str == "raw" ? FormatRaw : FormatPNG;
+}
+
+/*
+ * Hands the read backs the GPU has finished to the writer thread, in order.
+ * If wait is true, all pending read backs are completed.
+ */
+void
+FrameCapture::complete_readbacks(bool wait)
+{
+    while (readback_pending_ > 0) {
+        Readback &rb(readbacks_[readback_head_]);
+        GLenum status;
+
+        if (wait) {
+            do {
+                status = GLExtensions::ClientWaitSync(rb.fence,
+                                                      GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                      1000000000);
+            } while (status == GL_TIMEOUT_EXPIRED);
+        }
+        else {
+            status = GLExtensions::ClientWaitSync(rb.fence, 0, 0);
+            if (status == GL_TIMEOUT_EXPIRED)
+                break;
+        }
+
+        GLExtensions::DeleteSync(rb.fence);
+        rb.fence = 0;
+
+        if (status != GL_WAIT_FAILED) {
+            Job *job = new Job();
+            job->filename = rb.filename;
+            job->format = format_;
+            job->width = rb.width;
+            job->height = rb.height;
+            job->pixels.resize(static_cast<size_t>(rb.width) * rb.height * 4);
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, rb.buffer);
+            void *pixels = GLExtensions::MapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                        job->pixels.size(),
+                                                        GL_MAP_READ_BIT);
+            if (pixels) {
+                std::copy(static_cast<uint8_t *>(pixels),
+                          static_cast<uint8_t *>(pixels) + job->pixels.size(),
+                          job->pixels.begin());
+                GLExtensions::UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                queue_job(job);
+            }
+            else {
+                delete job;
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+
+        readback_head_ = (readback_head_ + 1) % readback_count;
+        readback_pending_--;
+    }
+}
+
+void
+FrameCapture::queue_job(Job *job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        /* Don't let a slow disk make us use unbounded amounts of memory */
+        if (jobs_.size() >= max_queued_jobs) {
+            dropped_++;
+            delete job;
+            return;
+        }
+
+        jobs_.push_back(job);
+    }
+
+    cond_.notify_one();
+}
+
+void
+FrameCapture::writer_main()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        cond_.wait(lock, [this] { return quit_ || !jobs_.empty(); });
+
+        if (jobs_.empty())
+            break;
+
+        Job *job = jobs_.front();
+        jobs_.pop_front();
+
+        lock.unlock();
+
+        bool ok = job->format == FormatRaw ? write_raw(*job) : write_png(job->filename, job->width, job->height, job->pixels);
+        if (!ok)
+            Log::error("Failed to write captured frame %s\n", job->filename.c_str());
+        delete job;
+
+        lock.lock();
+    }
+}
+
+bool
+FrameCapture::write_png(const std::string &filename, int width, int height,
+                        const std::vector<uint8_t> &pixels)
+{
+    FILE *fp = fopen(filename.c_str(), "wb");
+    if (!fp)
+        return false;
+
+    png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+    png_infop info = png ? png_create_info_struct(png) : 0;
+    std::vector<png_bytep> rows(height);
+
+    if (!png || !info || setjmp(png_jmpbuf(png))) {
+        png_destroy_write_struct(&png, &info);
+        fclose(fp);
+        return false;
+    }
+
+    /* The pixels are stored bottom row first */
+    for (int i = 0; i < height; i++) {
+        rows[i] = const_cast<png_bytep>(
+            &pixels[static_cast<size_t>(height - i - 1) * width * 4]);
+    }
+
+    png_init_io(png, fp);
+    png_set_IHDR(png, info, width, height, 8, PNG_COLOR_TYPE_RGB_ALPHA,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                 PNG_FILTER_TYPE_DEFAULT);
+    png_set_compression_level(png, 1);
+    png_set_rows(png, info, &rows[0]);
+    png_write_png(png, info, PNG_TRANSFORM_IDENTITY, 0);
+
+    png_destroy_write_struct(&png, &info);
+
+    return fclose(fp) == 0;
+}
+
+/* Same layout as Canvas::write_to_file(): upper left to lower right, RGBA */
+bool
+FrameCapture::write_raw(const Job &job)
+{
+    std::ofstream output(job.filename.c_str(), std::ios::out | std::ios::binary);
+    size_t stride = static_cast<size_t>(job.width) * 4;
+
+    for (int i = job.height - 1; i >= 0; i--)
+        output.write(reinterpret_cast<const char *>(&job.pixels[i * stride]), stride);
+
+    return static_cast<bool>(output);
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FRAME_CAPTURE_H_
+#define GLMARK2_FRAME_CAPTURE_H_
+
+#include "gl-headers.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * Captures rendered frames to image files with minimal impact on rendering.
+ *
+ * Each frame is read back with a single glReadPixels into a pixel pack
+ * buffer, and is only mapped a few frames later when the GPU is done with
+ * it. Encoding and writing the files happens in a background thread.
+ */
+class FrameCapture
+{
+public:
+    enum Format {
+        FormatPNG,
+        FormatRaw
+    };
+
+    FrameCapture();
+    ~FrameCapture();
+
+    /**
+     * Sets up the GL resources. Must be called with a current context.
+     *
+     * @param format the format of the written files
+     */
+    void init(Format format);
+
+    /**
+     * Completes all pending read backs and releases the GL resources.
+     * Must be called while the context that was current during init()
+     * is still alive.
+     */
+    void release();
+
+    /**
+     * Captures the contents of the current framebuffer.
+     *
+     * @param width the width of the framebuffer
+     * @param height the height of the framebuffer
+     * @param basename the file to write the frame to, without an extension
+     */
+    void capture(int width, int height, const std::string &basename);
+
+    /**
+     * Parses a format name ("png" or "raw"), defaulting to PNG.
+     */
+    static Format format_from_str(const std::string &str);
+
+    /**
+     * Writes RGBA pixels to a PNG file.
+     *
+     * @param filename the file to write to
+     * @param width the width of the image
+     * @param height the height of the image
+     * @param pixels the RGBA rows, bottom row first as returned by glReadPixels
+     *
+     * @return whether the file was written
+     */
+    static bool write_png(const std::string &filename, int width, int height,
+                          const std::vector<uint8_t> &pixels);
+
+private:
+    struct Job {
+        std::string filename;
+        Format format;
+        int width;
+        int height;
+        /* RGBA rows, bottom row first as returned by glReadPixels */
+        std::vector<uint8_t> pixels;
+    };
+
+    struct Readback {
+        Readback() : buffer(0), fence(0), width(0), height(0) {}
+        GLuint buffer;
+        GLsync fence;
+        int width;
+        int height;
+        std::string filename;
+    };
+
+    void complete_readbacks(bool wait);
+    void queue_job(Job *job);
+    void writer_main();
+    static bool write_raw(const Job &job);
+
+    /* Read backs in flight, and frames waiting to be written */
+    static const unsigned int readback_count = 3;
+    static const unsigned int max_queued_jobs = 16;
+
+    Format format_;
+    bool initialized_;
+    bool use_buffers_;
+    Readback readbacks_[readback_count];
+    /* Ring of in-flight read backs: [readback_head_, readback_head_ + readback_pending_) */
+    unsigned int readback_head_;
+    unsigned int readback_pending_;
+    unsigned int dropped_;
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::deque<Job *> jobs_;
+    bool quit_;
+};
+
+#endif /* GLMARK2_FRAME_CAPTURE_H_ */
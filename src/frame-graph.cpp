@@ -0,0 +1,204 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "frame-graph.h"
+#include "options.h"
+#include "scene.h"
+#include "shader-source.h"
+#include "debug-markers.h"
+
+#include <algorithm>
+
+using LibMatrix::vec2;
+
+/* Each vertex is a position and a color */
+static const unsigned int vertex_floats = 6;
+
+static const float border_color[] = { 0.5f, 0.5f, 0.5f, 0.8f };
+static const float budget_color[] = { 1.0f, 0.8f, 0.0f, 0.8f };
+static const float frame_color[] = { 0.2f, 1.0f, 0.2f, 1.0f };
+static const float gpu_color[] = { 0.2f, 0.6f, 1.0f, 1.0f };
+
+FrameGraph::FrameGraph() :
+    position_(-0.98, 0.55), size_(0.6, 0.4), budget_ms_(1000.0 / 60.0),
+    frame_ms_(sample_count, 0.0f), gpu_ms_(sample_count, -1.0f),
+    head_(0), count_(0), vbo_(0)
+{
+    ShaderSource vtx_source(Options::data_path + "/shaders/frame-graph.vert");
+    ShaderSource frg_source(Options::data_path + "/shaders/frame-graph.frag");
+
+    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return;
+    }
+
+    GLint prev_array_buffer = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prev_array_buffer);
+
+    glGenBuffers(1, &vbo_);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, max_vertices * vertex_floats * sizeof(float),
+                 0, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, prev_array_buffer);
+
+    vertices_.reserve(max_vertices * vertex_floats);
+}
+
+FrameGraph::~FrameGraph()
+{
+    if (vbo_)
+        glDeleteBuffers(1, &vbo_);
+}
+
+void
+FrameGraph::add(double frame_ms, double gpu_ms)
+{
+    unsigned int index = (head_ + count_) % sample_count;
+
+    frame_ms_[index] = frame_ms;
+    gpu_ms_[index] = gpu_ms;
+
+    if (count_ < sample_count)
+        count_++;
+    else
+        head_ = (head_ + 1) % sample_count;
+}
+
+/**
+ * Renders the graph.
+ */
+void
+FrameGraph::render()
+{
+    if (!vbo_)
+        return;
+
+    DebugMarkers::Group group("frame-graph");
+
+    /* Save state */
+    GLint prev_program = 0;
+    GLint prev_array_buffer = 0;
+    GLint prev_blend_src_rgb = 0;
+    GLint prev_blend_dst_rgb = 0;
+    GLint prev_blend_src_alpha = 0;
+    GLint prev_blend_dst_alpha = 0;
+    GLboolean prev_blend = GL_FALSE;
+    GLboolean prev_depth_test = GL_FALSE;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prev_program);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prev_array_buffer);
+    glGetIntegerv(GL_BLEND_SRC_RGB, &prev_blend_src_rgb);
+    glGetIntegerv(GL_BLEND_DST_RGB, &prev_blend_dst_rgb);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &prev_blend_src_alpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &prev_blend_dst_alpha);
+    glGetBooleanv(GL_BLEND, &prev_blend);
+    glGetBooleanv(GL_DEPTH_TEST, &prev_depth_test);
+
+    /* Set new state */
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+
+    create_geometry();
+
+    /* Orphan the storage of the previous frame instead of waiting for it */
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+    glBufferData(GL_ARRAY_BUFFER, max_vertices * vertex_floats * sizeof(float),
+                 0, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, vertices_.size() * sizeof(float), &vertices_[0]);
+
+    program_.start();
+    GLint position_loc = program_["position"].location();
+    GLint color_loc = program_["color"].location();
+
+    glEnableVertexAttribArray(position_loc);
+    glEnableVertexAttribArray(color_loc);
+    glVertexAttribPointer(position_loc, 2, GL_FLOAT, GL_FALSE,
+                          vertex_floats * sizeof(float), 0);
+    glVertexAttribPointer(color_loc, 4, GL_FLOAT, GL_FALSE,
+                          vertex_floats * sizeof(float),
+                          reinterpret_cast<const GLvoid *>(2 * sizeof(float)));
+
+    glDrawArrays(GL_LINES, 0, vertices_.size() / vertex_floats);
+
+    glDisableVertexAttribArray(color_loc);
+    glDisableVertexAttribArray(position_loc);
+
+    /* Restore state */
+    if (prev_depth_test == GL_TRUE)
+        glEnable(GL_DEPTH_TEST);
+    if (prev_blend == GL_FALSE)
+        glDisable(GL_BLEND);
+    glBlendFuncSeparate(prev_blend_src_rgb, prev_blend_dst_rgb,
+                        prev_blend_src_alpha, prev_blend_dst_alpha);
+    glBindBuffer(GL_ARRAY_BUFFER, prev_array_buffer);
+    glUseProgram(prev_program);
+}
+
+/**
+ * Creates the line segments of the graph, which spans twice the budget
+ * vertically, so the budget is in the middle.
+ */
+void
+FrameGraph::create_geometry()
+{
+    const float x0 = position_.x();
+    const float y0 = position_.y();
+    const float x1 = x0 + size_.x();
+    const float y1 = y0 + size_.y();
+    const float y_budget = y0 + size_.y() / 2;
+    const float dx = size_.x() / (sample_count - 1);
+    const float scale = size_.y() / (2 * budget_ms_);
+
+    vertices_.clear();
+
+    add_line(x0, y0, x1, y0, border_color);
+    add_line(x1, y0, x1, y1, border_color);
+    add_line(x1, y1, x0, y1, border_color);
+    add_line(x0, y1, x0, y0, border_color);
+    add_line(x0, y_budget, x1, y_budget, budget_color);
+
+    /* The newest frame is at the right edge */
+    float x = x1 - dx * (static_cast<int>(count_) - 1);
+
+    for (unsigned int i = 1; i < count_; i++, x += dx) {
+        unsigned int prev = (head_ + i - 1) % sample_count;
+        unsigned int cur = (head_ + i) % sample_count;
+
+        add_line(x, y0 + std::min(frame_ms_[prev] * scale, size_.y()),
+                 x + dx, y0 + std::min(frame_ms_[cur] * scale, size_.y()),
+                 frame_color);
+
+        if (gpu_ms_[prev] >= 0.0f && gpu_ms_[cur] >= 0.0f) {
+            add_line(x, y0 + std::min(gpu_ms_[prev] * scale, size_.y()),
+                     x + dx, y0 + std::min(gpu_ms_[cur] * scale, size_.y()),
+                     gpu_color);
+        }
+    }
+}
+
+void
+FrameGraph::add_line(float x0, float y0, float x1, float y1, const float *color)
+{
+    vertices_.push_back(x0);
+    vertices_.push_back(y0);
+    vertices_.insert(vertices_.end(), color, color + 4);
+    vertices_.push_back(x1);
+    vertices_.push_back(y1);
+    vertices_.insert(vertices_.end(), color, color + 4);
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FRAME_GRAPH_H_
+#define GLMARK2_FRAME_GRAPH_H_
+
+#include <vector>
+#include "gl-headers.h"
+#include "vec.h"
+#include "program.h"
+
+/**
+ * Draws a live graph of the time of the last frames (show-graph).
+ *
+ * The frame time and, when known, the GPU time of each frame are drawn as
+ * two lines over the frame budget, which is at the middle of the graph.
+ * Everything is streamed to a single vertex buffer each frame and drawn
+ * with one call.
+ */
+class FrameGraph
+{
+public:
+    FrameGraph();
+    ~FrameGraph();
+
+    /**
+     * Sets the lower left corner of the graph, in normalized screen
+     * coordinates.
+     */
+    void position(const LibMatrix::vec2 &p) { position_ = p; }
+
+    /**
+     * Sets the size of the graph, in normalized screen coordinates.
+     */
+    void size(const LibMatrix::vec2 &s) { size_ = s; }
+
+    /**
+     * Sets the frame budget, e.g. the vsync interval, in milliseconds.
+     */
+    void budget(double ms) { budget_ms_ = ms; }
+
+    /**
+     * Adds the times of a frame.
+     *
+     * @param frame_ms the time of the frame
+     * @param gpu_ms the GPU time of the frame, or a negative value if unknown
+     */
+    void add(double frame_ms, double gpu_ms);
+
+    void render();
+
+private:
+    void create_geometry();
+    void add_line(float x0, float y0, float x1, float y1, const float *color);
+
+    /* The number of frames shown */
+    static const unsigned int sample_count = 300;
+    /* The border, the budget and the two lines of frames, as line segments */
+    static const unsigned int max_vertices = 2 * (5 + 2 * sample_count);
+
+    LibMatrix::vec2 position_;
+    LibMatrix::vec2 size_;
+    double budget_ms_;
+    /* Rings of the last frames, the oldest at head_ once full */
+    std::vector<float> frame_ms_;
+    std::vector<float> gpu_ms_;
+    unsigned int head_;
+    unsigned int count_;
+    /* Reused every frame, to avoid reallocating */
+    std::vector<float> vertices_;
+    Program program_;
+    GLuint vbo_;
+};
+
+#endif /* GLMARK2_FRAME_GRAPH_H_ */
@@ -0,0 +1,233 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "frame-phases.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdio>
+
+FramePhases::FramePhases()
+{
+    reset(0.0);
+}
+
+void
+FramePhases::reset(double threshold_ms)
+{
+    threshold_us_ = static_cast<uint64_t>(threshold_ms * 1000.0);
+    frames_ = 0;
+    current_ = Frame();
+    phase_start_ = 0;
+    frame_end_ = Util::get_timestamp_us();
+    pending_.clear();
+    last_reported_ = 0;
+    report_count_ = 0;
+    reports_.clear();
+
+    for (unsigned int i = 0; i < ring_size; i++)
+        ring_[i] = Frame();
+    for (unsigned int i = 0; i < PhaseCount; i++)
+        spikes_[i] = 0;
+}
+
+void
+FramePhases::begin()
+{
+    if (active())
+        phase_start_ = Util::get_timestamp_us();
+}
+
+void
+FramePhases::end(Phase phase)
+{
+    if (active())
+        current_.phase_us[phase] += Util::get_timestamp_us() - phase_start_;
+}
+
+void
+FramePhases::add(Phase phase, uint64_t time_us)
+{
+    if (active())
+        current_.phase_us[phase] += time_us;
+}
+
+void
+FramePhases::end_frame(bool measured)
+{
+    if (!active())
+        return;
+
+    uint64_t now = Util::get_timestamp_us();
+    Frame &frame(ring_[frames_ % ring_size]);
+
+    frame = current_;
+    frame.number = ++frames_;
+    frame.total_us = now - frame_end_;
+    frame.measured = measured;
+    frame_end_ = now;
+    current_ = Frame();
+
+    /* The flip waits happen while presenting, so they are taken out of it */
+    uint64_t &swap(frame.phase_us[PhaseSwap]);
+    swap -= std::min(swap, frame.phase_us[PhaseFlipWait]);
+
+    uint64_t timed = 0;
+    for (unsigned int i = 0; i < PhaseOther; i++)
+        timed += frame.phase_us[i];
+    frame.phase_us[PhaseOther] = frame.total_us - std::min(frame.total_us, timed);
+
+    if (measured && frame.total_us > threshold_us_) {
+        frame.spike = true;
+        frame.cause = cause(frame);
+        spikes_[frame.cause]++;
+
+        if (frame.number > last_reported_ && report_count_ < max_reports) {
+            pending_.push_back(frame.number);
+            last_reported_ = frame.number + context_frames;
+            report_count_++;
+        }
+    }
+
+    while (!pending_.empty() && pending_.front() + report_delay <= frames_) {
+        report(pending_.front());
+        pending_.erase(pending_.begin());
+    }
+}
+
+void
+FramePhases::add_gpu_time(uint64_t frame, uint64_t time_us)
+{
+    Frame *f = find(frame);
+    if (f)
+        f->gpu_us = time_us;
+}
+
+void
+FramePhases::finish()
+{
+    for (size_t i = 0; i < pending_.size(); i++)
+        report(pending_[i]);
+    pending_.clear();
+}
+
+unsigned int
+FramePhases::spikes() const
+{
+    unsigned int count = 0;
+
+    for (unsigned int i = 0; i < PhaseCount; i++)
+        count += spikes_[i];
+
+    return count;
+}
+
+const char *
+FramePhases::phase_name(Phase phase)
+{
+    static const char *names[PhaseCount] = {
+        "update", "draw", "swap", "flip-wait", "other"
+    };
+
+    return names[phase];
+}
+
+FramePhases::Frame *
+FramePhases::find(uint64_t number)
+{
+    if (number == 0 || number > frames_ || frames_ - number >= ring_size)
+        return 0;
+
+    return &ring_[(number - 1) % ring_size];
+}
+
+/*
+ * The phase of a spike that grew the most over its mean in the frames
+ * before it that weren't spikes themselves.
+ */
+FramePhases::Phase
+FramePhases::cause(const Frame &spike)
+{
+    double mean[PhaseCount] = {};
+    unsigned int count = 0;
+
+    for (uint64_t n = spike.number - 1; n > 0; n--) {
+        const Frame *f = find(n);
+        if (!f)
+            break;
+        if (f->spike || !f->measured)
+            continue;
+
+        for (unsigned int i = 0; i < PhaseCount; i++)
+            mean[i] += f->phase_us[i];
+        count++;
+    }
+
+    Phase result = PhaseOther;
+    double largest = 0.0;
+
+    for (unsigned int i = 0; i < PhaseCount; i++) {
+        double growth = spike.phase_us[i] - (count > 0 ? mean[i] / count : 0.0);
+        if (growth > largest) {
+            largest = growth;
+            result = static_cast<Phase>(i);
+        }
+    }
+
+    return result;
+}
+
+void
+FramePhases::report(uint64_t number)
+{
+    const Frame *spike = find(number);
+    if (!spike)
+        return;
+
+    char line[256];
+
+    snprintf(line, sizeof(line),
+             "Spike: frame %llu took %.3f ms (threshold %.3f ms), mostly %s",
+             static_cast<unsigned long long>(number), spike->total_us / 1000.0,
+             threshold_us_ / 1000.0, phase_name(spike->cause));
+    reports_.push_back(line);
+
+    snprintf(line, sizeof(line), "  %8s %9s %9s %9s %9s %9s %9s %9s",
+             "frame", "total", "update", "draw", "swap", "flip-wait", "other", "gpu");
+    reports_.push_back(line);
+
+    uint64_t first = number > context_frames ? number - context_frames : 1;
+
+    for (uint64_t n = first; n <= number + context_frames; n++) {
+        const Frame *f = find(n);
+        if (!f)
+            continue;
+
+        char gpu[16] = "-";
+        if (f->gpu_us > 0)
+            snprintf(gpu, sizeof(gpu), "%.3f", f->gpu_us / 1000.0);
+
+        snprintf(line, sizeof(line), "%s %8llu %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %9s",
+                 f->spike ? "*" : " ", static_cast<unsigned long long>(n),
+                 f->total_us / 1000.0,
+                 f->phase_us[PhaseUpdate] / 1000.0, f->phase_us[PhaseDraw] / 1000.0,
+                 f->phase_us[PhaseSwap] / 1000.0, f->phase_us[PhaseFlipWait] / 1000.0,
+                 f->phase_us[PhaseOther] / 1000.0, gpu);
+        reports_.push_back(line);
+    }
+}
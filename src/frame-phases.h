@@ -0,0 +1,164 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FRAME_PHASES_H_
+#define GLMARK2_FRAME_PHASES_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Attributes the frame time spikes of a scene to the phases of their
+ * frames (--spike-threshold).
+ *
+ * The time each frame spends in each phase is kept in a fixed ring of the
+ * last frames. When a measured frame takes longer than the threshold, it is
+ * attributed to the phase that grew the most over the frames before it, and
+ * once the frames after it are in, the breakdown of the frames around it is
+ * kept as a report, with the GPU times that have arrived by then.
+ */
+class FramePhases
+{
+public:
+    enum Phase {
+        /* Preparing the next frame, in Scene::update() */
+        PhaseUpdate,
+        /* Submitting the frame, in Scene::draw() */
+        PhaseDraw,
+        /* Presenting the frame, apart from waiting for the page flips */
+        PhaseSwap,
+        /* Waiting for the page flips of the DRM flavor */
+        PhaseFlipWait,
+        /* Anything else between the ends of two frames, e.g. the pacing */
+        PhaseOther,
+        PhaseCount
+    };
+
+    FramePhases();
+
+    /**
+     * Starts the frames of a scene.
+     *
+     * @param threshold_ms the frame time over which a frame is a spike, or
+     *        0 to record nothing
+     */
+    void reset(double threshold_ms);
+
+    /**
+     * Whether the phases are recorded.
+     */
+    bool active() const { return threshold_us_ > 0; }
+
+    /**
+     * Gets the number of the current frame, starting at 1.
+     */
+    uint64_t frame() const { return frames_ + 1; }
+
+    /**
+     * Starts timing a phase of the current frame.
+     */
+    void begin();
+
+    /**
+     * Adds the time since begin() to a phase of the current frame.
+     */
+    void end(Phase phase);
+
+    /**
+     * Adds time to a phase of the current frame.
+     */
+    void add(Phase phase, uint64_t time_us);
+
+    /**
+     * Ends the current frame, the time since the end of the previous one
+     * not spent in the other phases being PhaseOther.
+     *
+     * @param measured whether the frame is measured, spikes being only
+     *        looked for in those
+     */
+    void end_frame(bool measured);
+
+    /**
+     * Records the GPU time of a frame, which arrives a few frames late.
+     */
+    void add_gpu_time(uint64_t frame, uint64_t time_us);
+
+    /**
+     * Keeps the reports of the spikes whose following frames have not all
+     * been drawn, at the end of the scene.
+     */
+    void finish();
+
+    /**
+     * Gets the number of spikes attributed to a phase.
+     */
+    unsigned int spikes(Phase phase) const { return spikes_[phase]; }
+
+    /**
+     * Gets the number of spikes.
+     */
+    unsigned int spikes() const;
+
+    /**
+     * Gets the reports of the spikes, a line per string. Spikes among the
+     * frames of a previous report, or past the first few, get none.
+     */
+    const std::vector<std::string> &reports() const { return reports_; }
+
+    static const char *phase_name(Phase phase);
+
+private:
+    struct Frame {
+        uint64_t number;
+        uint64_t total_us;
+        uint64_t phase_us[PhaseCount];
+        /* 0 if unknown */
+        uint64_t gpu_us;
+        bool measured;
+        bool spike;
+        Phase cause;
+    };
+
+    static const unsigned int ring_size = 32;
+    /* The frames shown before and after a spike */
+    static const unsigned int context_frames = 4;
+    /* How many frames after a spike its report waits for, for the GPU times */
+    static const unsigned int report_delay = 12;
+    static const unsigned int max_reports = 10;
+
+    Frame *find(uint64_t number);
+    Phase cause(const Frame &spike);
+    void report(uint64_t number);
+
+    uint64_t threshold_us_;
+    Frame ring_[ring_size];
+    uint64_t frames_;
+    Frame current_;
+    uint64_t phase_start_;
+    uint64_t frame_end_;
+    unsigned int spikes_[PhaseCount];
+    /* The spikes waiting for their following frames */
+    std::vector<uint64_t> pending_;
+    /* The last frame shown in a report */
+    uint64_t last_reported_;
+    unsigned int report_count_;
+    std::vector<std::string> reports_;
+};
+
+#endif /* GLMARK2_FRAME_PHASES_H_ */
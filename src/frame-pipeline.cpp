@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "frame-pipeline.h"
+#include "scene.h"
+#include "util.h"
+#include "isolation.h"
+
+FramePipeline::FramePipeline() :
+    scene_(0), measure_(false), quit_(false)
+{
+}
+
+FramePipeline::~FramePipeline()
+{
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+}
+
+void
+FramePipeline::start(Scene &scene, bool measure)
+{
+    /* The worker is only started by the first pipelined scene */
+    if (!thread_.joinable())
+        thread_ = std::thread(&FramePipeline::run, this);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        scene_ = &scene;
+        measure_ = measure;
+    }
+    cond_.notify_all();
+}
+
+void
+FramePipeline::wait()
+{
+    uint64_t start = Util::get_timestamp_us();
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool measure = scene_ && measure_;
+
+    cond_.wait(lock, [this] { return scene_ == 0; });
+
+    if (measure)
+        wait_stats_.add(Util::get_timestamp_us() - start);
+}
+
+void
+FramePipeline::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    prepare_stats_.reset();
+    wait_stats_.reset();
+}
+
+void
+FramePipeline::run()
+{
+    Isolation::worker_thread();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        cond_.wait(lock, [this] { return quit_ || scene_ != 0; });
+        if (quit_)
+            break;
+
+        Scene *scene = scene_;
+        bool measure = measure_;
+
+        lock.unlock();
+        uint64_t start = Util::get_timestamp_us();
+        scene->prepare();
+        uint64_t elapsed = Util::get_timestamp_us() - start;
+        lock.lock();
+
+        if (measure)
+            prepare_stats_.add(elapsed);
+        scene_ = 0;
+        cond_.notify_all();
+    }
+}
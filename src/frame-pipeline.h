@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FRAME_PIPELINE_H_
+#define GLMARK2_FRAME_PIPELINE_H_
+
+#include "frame-stats.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+class Scene;
+
+/**
+ * Runs Scene::prepare() on a worker thread, so that the CPU update of the
+ * next frame overlaps with the submission of the current one (--pipelined).
+ */
+class FramePipeline
+{
+public:
+    FramePipeline();
+    ~FramePipeline();
+
+    /**
+     * Starts preparing the next frame of a scene on the worker thread.
+     *
+     * @param scene the scene to prepare
+     * @param measure whether the frame is included in the statistics
+     */
+    void start(Scene &scene, bool measure);
+
+    /**
+     * Waits until the frame being prepared, if any, is ready.
+     */
+    void wait();
+
+    /**
+     * Resets the statistics.
+     */
+    void reset();
+
+    /**
+     * Gets the time spent in Scene::prepare() by the worker thread.
+     */
+    const FrameStats &prepare_stats() const { return prepare_stats_; }
+
+    /**
+     * Gets the time the main thread spent waiting for prepared frames,
+     * which is the part of the CPU update that wasn't hidden.
+     */
+    const FrameStats &wait_stats() const { return wait_stats_; }
+
+private:
+    void run();
+
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    /* The scene to prepare, or 0 when the worker is idle */
+    Scene *scene_;
+    bool measure_;
+    bool quit_;
+    FrameStats prepare_stats_;
+    FrameStats wait_stats_;
+};
+
+#endif /* GLMARK2_FRAME_PIPELINE_H_ */
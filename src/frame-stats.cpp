@@ -0,0 +1,169 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "frame-stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void
+FrameStats::reset()
+{
+    std::memset(buckets_, 0, sizeof(buckets_));
+    count_ = 0;
+    min_ = 0;
+    max_ = 0;
+    sum_ = 0.0;
+    sum_squares_ = 0.0;
+}
+
+void
+FrameStats::add(uint64_t frame_time_us)
+{
+    static const uint64_t max_value((static_cast<uint64_t>(1) << max_value_bits) - 1);
+    uint64_t v(std::min(frame_time_us, max_value));
+
+    buckets_[bucket_index(v)]++;
+
+    if (count_ == 0 || v < min_)
+        min_ = v;
+    if (v > max_)
+        max_ = v;
+
+    count_++;
+    sum_ += v;
+    sum_squares_ += static_cast<double>(v) * v;
+}
+
+double
+FrameStats::mean_ms() const
+{
+    if (count_ == 0)
+        return 0.0;
+
+    return sum_ / count_ / 1000.0;
+}
+
+double
+FrameStats::stddev_ms() const
+{
+    if (count_ < 2)
+        return 0.0;
+
+    double mean(sum_ / count_);
+    double variance((sum_squares_ - mean * sum_) / (count_ - 1));
+
+    /* Guard against small negative values from rounding errors */
+    return std::sqrt(std::max(variance, 0.0)) / 1000.0;
+}
+
+double
+FrameStats::percentile_ms(double p) const
+{
+    if (count_ == 0)
+        return 0.0;
+
+    p = std::min(std::max(p, 0.0), 100.0);
+
+    uint64_t rank(static_cast<uint64_t>(std::ceil(p / 100.0 * count_)));
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen(0);
+
+    for (unsigned int i = 0; i < bucket_count; i++) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            /*
+             * Report the middle of the bucket, but never go outside the
+             * actually observed range.
+             */
+            uint64_t lo(bucket_lowest_value(i));
+            uint64_t hi(bucket_highest_value(i));
+            double v((lo + hi) / 2.0);
+            v = std::min(std::max(v, static_cast<double>(min_)),
+                         static_cast<double>(max_));
+            return v / 1000.0;
+        }
+    }
+
+    return max_ms();
+}
+
+FrameStats::Summary
+FrameStats::summary() const
+{
+    Summary s;
+
+    s.count = count_;
+    s.mean = mean_ms();
+    s.min = min_ms();
+    s.p50 = percentile_ms(50.0);
+    s.p90 = percentile_ms(90.0);
+    s.p99 = percentile_ms(99.0);
+    s.p999 = percentile_ms(99.9);
+    s.max = max_ms();
+    s.stddev = stddev_ms();
+
+    return s;
+}
+
+/*
+ * Values below 2 * sub_bucket_count map directly to buckets. Larger values
+ * are split by their most significant bit into power-of-two ranges, each
+ * of which is divided into sub_bucket_count linear sub-buckets.
+ */
+unsigned int
+FrameStats::bucket_index(uint64_t value)
+{
+    if (value < 2 * sub_bucket_count)
+        return static_cast<unsigned int>(value);
+
+    unsigned int msb(0);
+    for (uint64_t v = value; v > 1; v >>= 1)
+        msb++;
+
+    unsigned int shift(msb - sub_bucket_bits);
+
+    return shift * sub_bucket_count + static_cast<unsigned int>(value >> shift);
+}
+
+uint64_t
+FrameStats::bucket_lowest_value(unsigned int index)
+{
+    if (index < 2 * sub_bucket_count)
+        return index;
+
+    unsigned int shift(index / sub_bucket_count - 1);
+    uint64_t sub(index - shift * sub_bucket_count);
+
+    return sub << shift;
+}
+
+uint64_t
+FrameStats::bucket_highest_value(unsigned int index)
+{
+    if (index < 2 * sub_bucket_count)
+        return index;
+
+    unsigned int shift(index / sub_bucket_count - 1);
+    uint64_t sub(index - shift * sub_bucket_count);
+
+    return ((sub + 1) << shift) - 1;
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FRAME_STATS_H_
+#define GLMARK2_FRAME_STATS_H_
+
+#include <stdint.h>
+
+/**
+ * Collects per-frame timing samples.
+ *
+ * Samples are stored in a fixed-size, log-linear histogram (similar to
+ * HdrHistogram) so that recording a frame never allocates memory,
+ * regardless of how many frames a benchmark renders. Values are kept with
+ * a relative precision better than 1/64 (~1.6%) over a range of several
+ * days, which is plenty for frame times.
+ */
+class FrameStats
+{
+public:
+    /**
+     * A snapshot of the commonly reported statistics, in milliseconds.
+     */
+    struct Summary {
+        Summary() :
+            count(0), mean(0.0), min(0.0), p50(0.0), p90(0.0), p99(0.0),
+            p999(0.0), max(0.0), stddev(0.0) {}
+
+        uint64_t count;
+        double mean;
+        double min;
+        double p50;
+        double p90;
+        double p99;
+        double p999;
+        double max;
+        double stddev;
+    };
+
+    FrameStats() { reset(); }
+
+    /**
+     * Clears all recorded samples.
+     */
+    void reset();
+
+    /**
+     * Records the duration of a single frame.
+     *
+     * @param frame_time_us the frame duration in microseconds
+     */
+    void add(uint64_t frame_time_us);
+
+    /**
+     * Gets the number of recorded frames.
+     */
+    uint64_t count() const { return count_; }
+
+    /**
+     * Gets the minimum recorded frame time in milliseconds.
+     */
+    double min_ms() const { return count_ ? min_ / 1000.0 : 0.0; }
+
+    /**
+     * Gets the maximum recorded frame time in milliseconds.
+     */
+    double max_ms() const { return max_ / 1000.0; }
+
+    /**
+     * Gets the mean frame time in milliseconds.
+     */
+    double mean_ms() const;
+
+    /**
+     * Gets the standard deviation of the frame time in milliseconds.
+     */
+    double stddev_ms() const;
+
+    /**
+     * Gets a frame time percentile in milliseconds.
+     *
+     * @param p the percentile to get (0.0 - 100.0)
+     *
+     * @return the frame time below which p percent of the frames fall
+     */
+    double percentile_ms(double p) const;
+
+    /**
+     * Gets a summary of the recorded samples.
+     */
+    Summary summary() const;
+
+private:
+    /* 2^sub_bucket_bits linear sub-buckets per power of two */
+    static const unsigned int sub_bucket_bits = 6;
+    static const unsigned int sub_bucket_count = 1 << sub_bucket_bits;
+    /* Values above 2^max_value_bits us (~12 days) are clamped */
+    static const unsigned int max_value_bits = 40;
+    static const unsigned int bucket_count =
+        (max_value_bits - sub_bucket_bits + 1) * sub_bucket_count;
+
+    static unsigned int bucket_index(uint64_t value);
+    static uint64_t bucket_lowest_value(unsigned int index);
+    static uint64_t bucket_highest_value(unsigned int index);
+
+    uint32_t buckets_[bucket_count];
+    uint64_t count_;
+    uint64_t min_;
+    uint64_t max_;
+    double sum_;
+    double sum_squares_;
+};
+
+#endif /* GLMARK2_FRAME_STATS_H_ */
@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_FULLSCREEN_QUAD_H_
+#define GLMARK2_FULLSCREEN_QUAD_H_
+
+#include "gl-headers.h"
+
+/**
+ * The quad that covers the whole viewport, for the scenes that shade every
+ * pixel with a single draw.
+ */
+class FullscreenQuad
+{
+public:
+    /**
+     * The four vec2 positions of the quad in clip space, in strip order.
+     */
+    static const GLfloat positions[8];
+
+    /**
+     * The positions, each followed by its vec2 texture coordinate.
+     */
+    static const GLfloat positions_texcoords[16];
+
+    /**
+     * Creates a buffer object holding the quad as a triangle strip of four
+     * vertices, each a vec2 position in clip space. With texture
+     * coordinates, each position is followed by a vec2 in [0, 1].
+     *
+     * @param texcoords whether to add the texture coordinates
+     *
+     * @return the buffer object, which the caller deletes
+     */
+    static GLuint create(bool texcoords = false);
+};
+
+#endif /* GLMARK2_FULLSCREEN_QUAD_H_ */
@@ -38,6 +38,107 @@ void (GLAD_API_PTR *GLExtensions::RenderbufferStorage)(GLenum target, GLenum int
 
 void (GLAD_API_PTR *GLExtensions::GenerateMipmap)(GLenum target) = 0;
 
+void (GLAD_API_PTR *GLExtensions::GenQueries)(GLsizei n, GLuint *ids) = 0;
+void (GLAD_API_PTR *GLExtensions::DeleteQueries)(GLsizei n, const GLuint *ids) = 0;
+void (GLAD_API_PTR *GLExtensions::BeginQuery)(GLenum target, GLuint id) = 0;
+void (GLAD_API_PTR *GLExtensions::EndQuery)(GLenum target) = 0;
+void (GLAD_API_PTR *GLExtensions::GetQueryObjectuiv)(GLuint id, GLenum pname, GLuint *params) = 0;
+
+void (GLAD_API_PTR *GLExtensions::GetQueryObjectui64v)(GLuint id, GLenum pname, GLuint64 *params) = 0;
+void (GLAD_API_PTR *GLExtensions::QueryCounter)(GLuint id, GLenum target) = 0;
+
+void* (GLAD_API_PTR *GLExtensions::MapBufferRange)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) = 0;
+
+GLsync (GLAD_API_PTR *GLExtensions::FenceSync)(GLenum condition, GLbitfield flags) = 0;
+void (GLAD_API_PTR *GLExtensions::DeleteSync)(GLsync sync) = 0;
+GLenum (GLAD_API_PTR *GLExtensions::ClientWaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout) = 0;
+void (GLAD_API_PTR *GLExtensions::WaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout) = 0;
+
+void (GLAD_API_PTR *GLExtensions::GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary) = 0;
+void (GLAD_API_PTR *GLExtensions::ProgramBinary)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length) = 0;
+
+void (GLAD_API_PTR *GLExtensions::BufferStorage)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) = 0;
+void (GLAD_API_PTR *GLExtensions::GenVertexArrays)(GLsizei n, GLuint *arrays) = 0;
+void (GLAD_API_PTR *GLExtensions::BindVertexArray)(GLuint array) = 0;
+void (GLAD_API_PTR *GLExtensions::DeleteVertexArrays)(GLsizei n, const GLuint *arrays) = 0;
+void (GLAD_API_PTR *GLExtensions::DrawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei instancecount) = 0;
+void (GLAD_API_PTR *GLExtensions::DrawElementsInstanced)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount) = 0;
+void (GLAD_API_PTR *GLExtensions::VertexAttribDivisor)(GLuint index, GLuint divisor) = 0;
+void (GLAD_API_PTR *GLExtensions::DrawArraysIndirect)(GLenum mode, const void *indirect) = 0;
+void (GLAD_API_PTR *GLExtensions::DrawElementsIndirect)(GLenum mode, GLenum type, const void *indirect) = 0;
+void (GLAD_API_PTR *GLExtensions::MultiDrawArraysIndirect)(GLenum mode, const void *indirect, GLsizei drawcount, GLsizei stride) = 0;
+void (GLAD_API_PTR *GLExtensions::MultiDrawElementsIndirect)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride) = 0;
+void (GLAD_API_PTR *GLExtensions::DispatchCompute)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z) = 0;
+void (GLAD_API_PTR *GLExtensions::MemoryBarrierGL)(GLbitfield barriers) = 0;
+void (GLAD_API_PTR *GLExtensions::BindBufferBase)(GLenum target, GLuint index, GLuint buffer) = 0;
+GLuint (GLAD_API_PTR *GLExtensions::GetUniformBlockIndex)(GLuint program, const GLchar *uniformBlockName) = 0;
+void (GLAD_API_PTR *GLExtensions::UniformBlockBinding)(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding) = 0;
+void (GLAD_API_PTR *GLExtensions::BindBufferRange)(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) = 0;
+void (GLAD_API_PTR *GLExtensions::TransformFeedbackVaryings)(GLuint program, GLsizei count, const GLchar *const *varyings, GLenum bufferMode) = 0;
+void (GLAD_API_PTR *GLExtensions::BeginTransformFeedback)(GLenum primitiveMode) = 0;
+void (GLAD_API_PTR *GLExtensions::EndTransformFeedback)() = 0;
+void (GLAD_API_PTR *GLExtensions::TexStorage2D)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height) = 0;
+void (GLAD_API_PTR *GLExtensions::TexImage3D)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels) = 0;
+void (GLAD_API_PTR *GLExtensions::TexSubImage3D)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels) = 0;
+void (GLAD_API_PTR *GLExtensions::FramebufferTextureLayer)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) = 0;
+void (GLAD_API_PTR *GLExtensions::FramebufferTextureMultiviewOVR)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint baseViewIndex, GLsizei numViews) = 0;
+GLuint64 (GLAD_API_PTR *GLExtensions::GetTextureHandle)(GLuint texture) = 0;
+void (GLAD_API_PTR *GLExtensions::MakeTextureHandleResident)(GLuint64 handle) = 0;
+void (GLAD_API_PTR *GLExtensions::MakeTextureHandleNonResident)(GLuint64 handle) = 0;
+void (GLAD_API_PTR *GLExtensions::UniformHandleui64)(GLint location, GLuint64 value) = 0;
+void (GLAD_API_PTR *GLExtensions::TexPageCommitment)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLboolean commit) = 0;
+void (GLAD_API_PTR *GLExtensions::GetInternalformativ)(GLenum target, GLenum internalformat, GLenum pname, GLsizei count, GLint *params) = 0;
+void (GLAD_API_PTR *GLExtensions::BindImageTexture)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format) = 0;
+void (GLAD_API_PTR *GLExtensions::ClipControl)(GLenum origin, GLenum depth) = 0;
+void (GLAD_API_PTR *GLExtensions::BlitFramebuffer)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) = 0;
+void (GLAD_API_PTR *GLExtensions::RenderbufferStorageMultisample)(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) = 0;
+void (GLAD_API_PTR *GLExtensions::FramebufferTexture2DMultisample)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLsizei samples) = 0;
+void (GLAD_API_PTR *GLExtensions::RenderbufferStorageMultisampleImplicit)(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) = 0;
+void (GLAD_API_PTR *GLExtensions::PatchParameteri)(GLenum pname, GLint value) = 0;
+void (GLAD_API_PTR *GLExtensions::MinSampleShading)(GLfloat value) = 0;
+void (GLAD_API_PTR *GLExtensions::InvalidateFramebuffer)(GLenum target, GLsizei numAttachments, const GLenum *attachments) = 0;
+void (GLAD_API_PTR *GLExtensions::DrawBuffers)(GLsizei n, const GLenum *bufs) = 0;
+void (GLAD_API_PTR *GLExtensions::MaxShaderCompilerThreads)(GLuint count) = 0;
+void (GLAD_API_PTR *GLExtensions::PushDebugGroup)(GLenum source, GLuint id, GLsizei length, const GLchar *message) = 0;
+void (GLAD_API_PTR *GLExtensions::PopDebugGroup)() = 0;
+void (GLAD_API_PTR *GLExtensions::ObjectLabel)(GLenum identifier, GLuint name, GLsizei length, const GLchar *label) = 0;
+void (GLAD_API_PTR *GLExtensions::EGLImageTargetTexture2DOES)(GLenum target, GLeglImageOES image) = 0;
+void (GLAD_API_PTR *GLExtensions::GetPerfMonitorGroupsAMD)(GLint *numGroups, GLsizei groupsSize, GLuint *groups) = 0;
+void (GLAD_API_PTR *GLExtensions::GetPerfMonitorCountersAMD)(GLuint group, GLint *numCounters, GLint *maxActiveCounters, GLsizei counterSize, GLuint *counters) = 0;
+void (GLAD_API_PTR *GLExtensions::GetPerfMonitorGroupStringAMD)(GLuint group, GLsizei bufSize, GLsizei *length, GLchar *groupString) = 0;
+void (GLAD_API_PTR *GLExtensions::GetPerfMonitorCounterStringAMD)(GLuint group, GLuint counter, GLsizei bufSize, GLsizei *length, GLchar *counterString) = 0;
+void (GLAD_API_PTR *GLExtensions::GetPerfMonitorCounterInfoAMD)(GLuint group, GLuint counter, GLenum pname, void *data) = 0;
+void (GLAD_API_PTR *GLExtensions::GenPerfMonitorsAMD)(GLsizei n, GLuint *monitors) = 0;
+void (GLAD_API_PTR *GLExtensions::DeletePerfMonitorsAMD)(GLsizei n, GLuint *monitors) = 0;
+void (GLAD_API_PTR *GLExtensions::SelectPerfMonitorCountersAMD)(GLuint monitor, GLboolean enable, GLuint group, GLint numCounters, GLuint *counterList) = 0;
+void (GLAD_API_PTR *GLExtensions::BeginPerfMonitorAMD)(GLuint monitor) = 0;
+void (GLAD_API_PTR *GLExtensions::EndPerfMonitorAMD)(GLuint monitor) = 0;
+void (GLAD_API_PTR *GLExtensions::GetPerfMonitorCounterDataAMD)(GLuint monitor, GLenum pname, GLsizei dataSize, GLuint *data, GLint *bytesWritten) = 0;
+
+namespace
+{
+
+/*
+ * Looks up an entry point trying a list of alternative names (e.g. the core
+ * name and the extension names) in order.
+ */
+template<typename T> void
+load_proc(T &proc, GLADuserptrloadfunc load, void *userptr,
+          const char *name, const char *alt1 = 0, const char *alt2 = 0)
+{
+    const char *names[] = {name, alt1, alt2};
+    GLADapiproc sym = 0;
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(*names) && !sym; i++) {
+        if (names[i])
+            sym = load(userptr, names[i]);
+    }
+
+    proc = reinterpret_cast<T>(sym);
+}
+
+}
+
 bool
 GLExtensions::support(const std::string &ext)
 {
@@ -52,9 +153,379 @@ GLExtensions::support(const std::string &ext)
 
     while ((pos = ext_string.find(ext, pos)) != std::string::npos) {
         char c = ext_string[pos + ext_size];
-        if (c == ' ' || c == '\0')
+        if ((c == ' ' || c == '\0') && (pos == 0 || ext_string[pos - 1] == ' '))
             break;
+        pos++;
     }
 
     return pos != std::string::npos;
 }
+
+bool
+GLExtensions::version_supported(int major, int minor)
+{
+    const char *version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (!version)
+        return false;
+
+    /*
+     * The version string is "<major>.<minor>..." for GL and
+     * "OpenGL ES <major>.<minor>..." for GLES, so skip to the first digit.
+     */
+    const char *p = version;
+    while (*p && (*p < '0' || *p > '9'))
+        p++;
+
+    int gl_major = 0;
+    int gl_minor = 0;
+    while (*p >= '0' && *p <= '9')
+        gl_major = gl_major * 10 + (*p++ - '0');
+    if (*p == '.')
+        p++;
+    while (*p >= '0' && *p <= '9')
+        gl_minor = gl_minor * 10 + (*p++ - '0');
+
+    return gl_major > major || (gl_major == major && gl_minor >= minor);
+}
+
+void
+GLExtensions::load_optional(GLADuserptrloadfunc load, void *userptr)
+{
+#if GLMARK2_USE_GLESv2
+    bool es3 = version_supported(3, 0);
+    bool timer_query = support("GL_EXT_disjoint_timer_query");
+    bool timestamp_query = timer_query;
+    bool query = es3 || timer_query || support("GL_EXT_occlusion_query_boolean");
+    bool map_buffer_range = es3 || support("GL_EXT_map_buffer_range");
+    bool sync = es3 || support("GL_APPLE_sync");
+    bool program_binary = es3 || support("GL_OES_get_program_binary");
+    bool buffer_storage = support("GL_EXT_buffer_storage");
+    bool vertex_array_object = es3 || support("GL_OES_vertex_array_object");
+    bool instanced_arrays = es3 || support("GL_EXT_instanced_arrays") ||
+                            support("GL_ANGLE_instanced_arrays");
+    bool es31 = version_supported(3, 1);
+    bool draw_indirect = es31;
+    bool multi_draw_indirect = es31 && support("GL_EXT_multi_draw_indirect");
+    bool compute_shader = es31;
+    bool uniform_buffer_object = es3;
+    bool transform_feedback = es3;
+    bool texture_storage = es3 || support("GL_EXT_texture_storage");
+    bool texture_array = es3;
+    bool image_load_store = es31;
+    bool invalidate_framebuffer = es3 || support("GL_EXT_discard_framebuffer");
+    bool draw_buffers = es3 || support("GL_EXT_draw_buffers");
+    bool framebuffer_blit = es3;
+    bool framebuffer_multisample = es3;
+    bool tessellation_shader = version_supported(3, 2) ||
+                               (es31 && support("GL_EXT_tessellation_shader"));
+    bool sample_shading = version_supported(3, 2) || support("GL_OES_sample_shading");
+    bool debug = version_supported(3, 2) || support("GL_KHR_debug");
+    bool clip_control = support("GL_EXT_clip_control");
+#else
+    bool timestamp_query = version_supported(3, 3) || support("GL_ARB_timer_query");
+    bool timer_query = timestamp_query || support("GL_EXT_timer_query");
+    bool query = version_supported(1, 5);
+    bool map_buffer_range = version_supported(3, 0) || support("GL_ARB_map_buffer_range");
+    bool sync = version_supported(3, 2) || support("GL_ARB_sync");
+    bool program_binary = version_supported(4, 1) || support("GL_ARB_get_program_binary");
+    bool buffer_storage = version_supported(4, 4) || support("GL_ARB_buffer_storage");
+    bool vertex_array_object = version_supported(3, 0) || support("GL_ARB_vertex_array_object");
+    bool instanced_arrays = version_supported(3, 3) ||
+                            (support("GL_ARB_instanced_arrays") &&
+                             (version_supported(3, 1) || support("GL_ARB_draw_instanced")));
+    bool draw_indirect = version_supported(4, 0) || support("GL_ARB_draw_indirect");
+    bool multi_draw_indirect = version_supported(4, 3) ||
+                               (draw_indirect && support("GL_ARB_multi_draw_indirect"));
+    bool compute_shader = version_supported(4, 3) ||
+                          (support("GL_ARB_compute_shader") &&
+                           support("GL_ARB_shader_storage_buffer_object"));
+    bool uniform_buffer_object = version_supported(3, 1) || support("GL_ARB_uniform_buffer_object");
+    bool transform_feedback = version_supported(3, 0) || support("GL_EXT_transform_feedback");
+    bool texture_storage = version_supported(4, 2) || support("GL_ARB_texture_storage");
+    bool texture_array = version_supported(3, 0) || support("GL_EXT_texture_array");
+    bool image_load_store = version_supported(4, 2) || support("GL_ARB_shader_image_load_store");
+    bool invalidate_framebuffer = version_supported(4, 3) || support("GL_ARB_invalidate_subdata");
+    bool draw_buffers = version_supported(2, 0);
+    bool framebuffer_blit = version_supported(3, 0) || support("GL_EXT_framebuffer_blit");
+    bool framebuffer_multisample = version_supported(3, 0) ||
+                                   (framebuffer_blit && support("GL_EXT_framebuffer_multisample"));
+    bool tessellation_shader = version_supported(4, 0);
+    bool sample_shading = version_supported(4, 0) || support("GL_ARB_sample_shading");
+    bool debug = version_supported(4, 3) || support("GL_KHR_debug");
+    bool clip_control = version_supported(4, 5) || support("GL_ARB_clip_control");
+#endif
+    bool multisampled_render_to_texture = support("GL_EXT_multisampled_render_to_texture") ||
+                                          support("GL_IMG_multisampled_render_to_texture");
+
+    GenQueries = 0;
+    DeleteQueries = 0;
+    BeginQuery = 0;
+    EndQuery = 0;
+    GetQueryObjectuiv = 0;
+    if (query) {
+        load_proc(GenQueries, load, userptr, "glGenQueries", "glGenQueriesEXT");
+        load_proc(DeleteQueries, load, userptr, "glDeleteQueries", "glDeleteQueriesEXT");
+        load_proc(BeginQuery, load, userptr, "glBeginQuery", "glBeginQueryEXT");
+        load_proc(EndQuery, load, userptr, "glEndQuery", "glEndQueryEXT");
+        load_proc(GetQueryObjectuiv, load, userptr, "glGetQueryObjectuiv", "glGetQueryObjectuivEXT");
+    }
+
+    GetQueryObjectui64v = 0;
+    QueryCounter = 0;
+    if (query && timer_query) {
+        load_proc(GetQueryObjectui64v, load, userptr,
+                  "glGetQueryObjectui64v", "glGetQueryObjectui64vEXT");
+    }
+    if (query && timestamp_query)
+        load_proc(QueryCounter, load, userptr, "glQueryCounter", "glQueryCounterEXT");
+
+    MapBufferRange = 0;
+    if (map_buffer_range) {
+        load_proc(MapBufferRange, load, userptr, "glMapBufferRange", "glMapBufferRangeEXT");
+        /* GLES 3.0 has glUnmapBuffer even without GL_OES_mapbuffer */
+        if (!UnmapBuffer)
+            load_proc(UnmapBuffer, load, userptr, "glUnmapBuffer", "glUnmapBufferOES");
+    }
+
+    FenceSync = 0;
+    DeleteSync = 0;
+    ClientWaitSync = 0;
+    WaitSync = 0;
+    if (sync) {
+        load_proc(FenceSync, load, userptr, "glFenceSync", "glFenceSyncAPPLE");
+        load_proc(DeleteSync, load, userptr, "glDeleteSync", "glDeleteSyncAPPLE");
+        load_proc(ClientWaitSync, load, userptr, "glClientWaitSync", "glClientWaitSyncAPPLE");
+        load_proc(WaitSync, load, userptr, "glWaitSync", "glWaitSyncAPPLE");
+    }
+
+    GetProgramBinary = 0;
+    ProgramBinary = 0;
+    if (program_binary) {
+        load_proc(GetProgramBinary, load, userptr, "glGetProgramBinary", "glGetProgramBinaryOES");
+        load_proc(ProgramBinary, load, userptr, "glProgramBinary", "glProgramBinaryOES");
+    }
+
+    BufferStorage = 0;
+    if (buffer_storage)
+        load_proc(BufferStorage, load, userptr, "glBufferStorage", "glBufferStorageEXT");
+
+    GenVertexArrays = 0;
+    BindVertexArray = 0;
+    DeleteVertexArrays = 0;
+    if (vertex_array_object) {
+        load_proc(GenVertexArrays, load, userptr, "glGenVertexArrays", "glGenVertexArraysOES");
+        load_proc(BindVertexArray, load, userptr, "glBindVertexArray", "glBindVertexArrayOES");
+        load_proc(DeleteVertexArrays, load, userptr, "glDeleteVertexArrays", "glDeleteVertexArraysOES");
+    }
+
+    DrawArraysInstanced = 0;
+    DrawElementsInstanced = 0;
+    VertexAttribDivisor = 0;
+    if (instanced_arrays) {
+#if GLMARK2_USE_GLESv2
+        load_proc(DrawArraysInstanced, load, userptr, "glDrawArraysInstanced",
+                  "glDrawArraysInstancedEXT", "glDrawArraysInstancedANGLE");
+        load_proc(DrawElementsInstanced, load, userptr, "glDrawElementsInstanced",
+                  "glDrawElementsInstancedEXT", "glDrawElementsInstancedANGLE");
+        load_proc(VertexAttribDivisor, load, userptr, "glVertexAttribDivisor",
+                  "glVertexAttribDivisorEXT", "glVertexAttribDivisorANGLE");
+#else
+        load_proc(DrawArraysInstanced, load, userptr, "glDrawArraysInstanced",
+                  "glDrawArraysInstancedARB");
+        load_proc(DrawElementsInstanced, load, userptr, "glDrawElementsInstanced",
+                  "glDrawElementsInstancedARB");
+        load_proc(VertexAttribDivisor, load, userptr, "glVertexAttribDivisor",
+                  "glVertexAttribDivisorARB");
+#endif
+    }
+
+    DrawArraysIndirect = 0;
+    DrawElementsIndirect = 0;
+    if (draw_indirect) {
+        load_proc(DrawArraysIndirect, load, userptr, "glDrawArraysIndirect");
+        load_proc(DrawElementsIndirect, load, userptr, "glDrawElementsIndirect");
+    }
+
+    MultiDrawArraysIndirect = 0;
+    MultiDrawElementsIndirect = 0;
+    if (multi_draw_indirect) {
+        load_proc(MultiDrawArraysIndirect, load, userptr,
+                  "glMultiDrawArraysIndirect", "glMultiDrawArraysIndirectEXT");
+        load_proc(MultiDrawElementsIndirect, load, userptr,
+                  "glMultiDrawElementsIndirect", "glMultiDrawElementsIndirectEXT");
+    }
+
+    DispatchCompute = 0;
+    MemoryBarrierGL = 0;
+    BindBufferBase = 0;
+    if (compute_shader) {
+        load_proc(DispatchCompute, load, userptr, "glDispatchCompute");
+        load_proc(MemoryBarrierGL, load, userptr, "glMemoryBarrier");
+        load_proc(BindBufferBase, load, userptr, "glBindBufferBase");
+    }
+
+    GetUniformBlockIndex = 0;
+    UniformBlockBinding = 0;
+    BindBufferRange = 0;
+    if (uniform_buffer_object) {
+        load_proc(GetUniformBlockIndex, load, userptr, "glGetUniformBlockIndex");
+        load_proc(UniformBlockBinding, load, userptr, "glUniformBlockBinding");
+        load_proc(BindBufferRange, load, userptr, "glBindBufferRange");
+        if (!BindBufferBase)
+            load_proc(BindBufferBase, load, userptr, "glBindBufferBase");
+    }
+
+    TransformFeedbackVaryings = 0;
+    BeginTransformFeedback = 0;
+    EndTransformFeedback = 0;
+    if (transform_feedback) {
+        load_proc(TransformFeedbackVaryings, load, userptr,
+                  "glTransformFeedbackVaryings", "glTransformFeedbackVaryingsEXT");
+        load_proc(BeginTransformFeedback, load, userptr,
+                  "glBeginTransformFeedback", "glBeginTransformFeedbackEXT");
+        load_proc(EndTransformFeedback, load, userptr,
+                  "glEndTransformFeedback", "glEndTransformFeedbackEXT");
+        if (!BindBufferBase)
+            load_proc(BindBufferBase, load, userptr, "glBindBufferBase", "glBindBufferBaseEXT");
+    }
+
+    TexStorage2D = 0;
+    if (texture_storage)
+        load_proc(TexStorage2D, load, userptr, "glTexStorage2D", "glTexStorage2DEXT");
+
+    TexImage3D = 0;
+    TexSubImage3D = 0;
+    FramebufferTextureLayer = 0;
+    if (texture_array) {
+        load_proc(TexImage3D, load, userptr, "glTexImage3D", "glTexImage3DEXT");
+        load_proc(TexSubImage3D, load, userptr, "glTexSubImage3D", "glTexSubImage3DEXT");
+        load_proc(FramebufferTextureLayer, load, userptr,
+                  "glFramebufferTextureLayer", "glFramebufferTextureLayerEXT");
+    }
+
+    FramebufferTextureMultiviewOVR = 0;
+    if (FramebufferTextureLayer && support("GL_OVR_multiview")) {
+        load_proc(FramebufferTextureMultiviewOVR, load, userptr,
+                  "glFramebufferTextureMultiviewOVR");
+    }
+
+    GetTextureHandle = 0;
+    MakeTextureHandleResident = 0;
+    MakeTextureHandleNonResident = 0;
+    UniformHandleui64 = 0;
+    if (support("GL_ARB_bindless_texture") || support("GL_NV_bindless_texture")) {
+        load_proc(GetTextureHandle, load, userptr,
+                  "glGetTextureHandleARB", "glGetTextureHandleNV");
+        load_proc(MakeTextureHandleResident, load, userptr,
+                  "glMakeTextureHandleResidentARB", "glMakeTextureHandleResidentNV");
+        load_proc(MakeTextureHandleNonResident, load, userptr,
+                  "glMakeTextureHandleNonResidentARB", "glMakeTextureHandleNonResidentNV");
+        load_proc(UniformHandleui64, load, userptr,
+                  "glUniformHandleui64ARB", "glUniformHandleui64NV");
+    }
+
+    TexPageCommitment = 0;
+    GetInternalformativ = 0;
+    if (TexStorage2D &&
+        (support("GL_ARB_sparse_texture") || support("GL_EXT_sparse_texture")))
+    {
+        load_proc(TexPageCommitment, load, userptr,
+                  "glTexPageCommitmentARB", "glTexPageCommitmentEXT");
+        load_proc(GetInternalformativ, load, userptr, "glGetInternalformativ");
+    }
+
+    BindImageTexture = 0;
+    if (image_load_store)
+        load_proc(BindImageTexture, load, userptr, "glBindImageTexture", "glBindImageTextureEXT");
+
+    ClipControl = 0;
+    if (clip_control)
+        load_proc(ClipControl, load, userptr, "glClipControl", "glClipControlEXT");
+
+    BlitFramebuffer = 0;
+    if (framebuffer_blit)
+        load_proc(BlitFramebuffer, load, userptr, "glBlitFramebuffer", "glBlitFramebufferEXT");
+
+    RenderbufferStorageMultisample = 0;
+    if (framebuffer_multisample) {
+        load_proc(RenderbufferStorageMultisample, load, userptr,
+                  "glRenderbufferStorageMultisample", "glRenderbufferStorageMultisampleEXT");
+    }
+
+    FramebufferTexture2DMultisample = 0;
+    RenderbufferStorageMultisampleImplicit = 0;
+    if (multisampled_render_to_texture) {
+        load_proc(FramebufferTexture2DMultisample, load, userptr,
+                  "glFramebufferTexture2DMultisampleEXT", "glFramebufferTexture2DMultisampleIMG");
+        load_proc(RenderbufferStorageMultisampleImplicit, load, userptr,
+                  "glRenderbufferStorageMultisampleEXT", "glRenderbufferStorageMultisampleIMG");
+    }
+
+    PatchParameteri = 0;
+    if (tessellation_shader) {
+        load_proc(PatchParameteri, load, userptr,
+                  "glPatchParameteri", "glPatchParameteriEXT");
+    }
+
+    MinSampleShading = 0;
+    if (sample_shading) {
+        load_proc(MinSampleShading, load, userptr,
+                  "glMinSampleShading", "glMinSampleShadingARB", "glMinSampleShadingOES");
+    }
+
+    InvalidateFramebuffer = 0;
+    if (invalidate_framebuffer) {
+        load_proc(InvalidateFramebuffer, load, userptr,
+                  "glInvalidateFramebuffer", "glDiscardFramebufferEXT");
+    }
+
+    DrawBuffers = 0;
+    if (draw_buffers)
+        load_proc(DrawBuffers, load, userptr, "glDrawBuffers", "glDrawBuffersEXT");
+
+    MaxShaderCompilerThreads = 0;
+    if (support("GL_KHR_parallel_shader_compile") ||
+        support("GL_ARB_parallel_shader_compile"))
+    {
+        load_proc(MaxShaderCompilerThreads, load, userptr,
+                  "glMaxShaderCompilerThreadsKHR", "glMaxShaderCompilerThreadsARB");
+    }
+
+    PushDebugGroup = 0;
+    PopDebugGroup = 0;
+    ObjectLabel = 0;
+    if (debug) {
+        load_proc(PushDebugGroup, load, userptr, "glPushDebugGroup", "glPushDebugGroupKHR");
+        load_proc(PopDebugGroup, load, userptr, "glPopDebugGroup", "glPopDebugGroupKHR");
+        load_proc(ObjectLabel, load, userptr, "glObjectLabel", "glObjectLabelKHR");
+    }
+
+    EGLImageTargetTexture2DOES = 0;
+    if (support("GL_OES_EGL_image"))
+        load_proc(EGLImageTargetTexture2DOES, load, userptr, "glEGLImageTargetTexture2DOES");
+
+    GetPerfMonitorGroupsAMD = 0;
+    GetPerfMonitorCountersAMD = 0;
+    GetPerfMonitorGroupStringAMD = 0;
+    GetPerfMonitorCounterStringAMD = 0;
+    GetPerfMonitorCounterInfoAMD = 0;
+    GenPerfMonitorsAMD = 0;
+    DeletePerfMonitorsAMD = 0;
+    SelectPerfMonitorCountersAMD = 0;
+    BeginPerfMonitorAMD = 0;
+    EndPerfMonitorAMD = 0;
+    GetPerfMonitorCounterDataAMD = 0;
+    if (support("GL_AMD_performance_monitor")) {
+        load_proc(GetPerfMonitorGroupsAMD, load, userptr, "glGetPerfMonitorGroupsAMD");
+        load_proc(GetPerfMonitorCountersAMD, load, userptr, "glGetPerfMonitorCountersAMD");
+        load_proc(GetPerfMonitorGroupStringAMD, load, userptr, "glGetPerfMonitorGroupStringAMD");
+        load_proc(GetPerfMonitorCounterStringAMD, load, userptr, "glGetPerfMonitorCounterStringAMD");
+        load_proc(GetPerfMonitorCounterInfoAMD, load, userptr, "glGetPerfMonitorCounterInfoAMD");
+        load_proc(GenPerfMonitorsAMD, load, userptr, "glGenPerfMonitorsAMD");
+        load_proc(DeletePerfMonitorsAMD, load, userptr, "glDeletePerfMonitorsAMD");
+        load_proc(SelectPerfMonitorCountersAMD, load, userptr, "glSelectPerfMonitorCountersAMD");
+        load_proc(BeginPerfMonitorAMD, load, userptr, "glBeginPerfMonitorAMD");
+        load_proc(EndPerfMonitorAMD, load, userptr, "glEndPerfMonitorAMD");
+        load_proc(GetPerfMonitorCounterDataAMD, load, userptr, "glGetPerfMonitorCounterDataAMD");
+    }
+}
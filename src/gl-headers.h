@@ -69,6 +69,377 @@
 #endif
 #endif
 
+/* Tokens for functionality beyond GL 2.1 / GLES 2.0, see GLExtensions */
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_SAMPLES_PASSED
+#define GL_SAMPLES_PASSED 0x8914
+#endif
+#ifndef GL_ANY_SAMPLES_PASSED
+#define GL_ANY_SAMPLES_PASSED 0x8C2F
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+#ifndef GL_PRIMITIVES_GENERATED
+#define GL_PRIMITIVES_GENERATED 0x8C87
+#endif
+#ifndef GL_VERTICES_SUBMITTED
+#define GL_VERTICES_SUBMITTED 0x82EE
+#endif
+#ifndef GL_VERTEX_SHADER_INVOCATIONS
+#define GL_VERTEX_SHADER_INVOCATIONS 0x82F0
+#endif
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS
+#define GL_FRAGMENT_SHADER_INVOCATIONS 0x82F4
+#endif
+#ifndef GL_GPU_DISJOINT
+#define GL_GPU_DISJOINT 0x8FBB
+#endif
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED 0x911D
+#endif
+#ifndef GL_TIMEOUT_IGNORED
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+#endif
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+#ifndef GL_HALF_FLOAT_OES
+#define GL_HALF_FLOAT_OES 0x8D61
+#endif
+#ifndef GL_INT_2_10_10_10_REV
+#define GL_INT_2_10_10_10_REV 0x8D9F
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+#ifndef GL_TEXTURE_MAX_LEVEL
+#define GL_TEXTURE_MAX_LEVEL 0x813D
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_RANGE_BIT
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#endif
+#ifndef GL_MAP_UNSYNCHRONIZED_BIT
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER 0x8A11
+#endif
+#ifndef GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT 0x8A34
+#endif
+#ifndef GL_MAX_UNIFORM_BLOCK_SIZE
+#define GL_MAX_UNIFORM_BLOCK_SIZE 0x8A30
+#endif
+#ifndef GL_INVALID_INDEX
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT
+#define GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT 0x00000001
+#endif
+#ifndef GL_TEXTURE_FETCH_BARRIER_BIT
+#define GL_TEXTURE_FETCH_BARRIER_BIT 0x00000008
+#endif
+#ifndef GL_SHADER_IMAGE_ACCESS_BARRIER_BIT
+#define GL_SHADER_IMAGE_ACCESS_BARRIER_BIT 0x00000020
+#endif
+#ifndef GL_TEXTURE_UPDATE_BARRIER_BIT
+#define GL_TEXTURE_UPDATE_BARRIER_BIT 0x00000100
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS
+#define GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS 0x90D6
+#endif
+#ifndef GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS
+#define GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS 0x90DA
+#endif
+#ifndef GL_MAX_SHADER_STORAGE_BLOCK_SIZE
+#define GL_MAX_SHADER_STORAGE_BLOCK_SIZE 0x90DE
+#endif
+#ifndef GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS
+#define GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS 0x90EB
+#endif
+#ifndef GL_PATCHES
+#define GL_PATCHES 0x000E
+#endif
+#ifndef GL_PRIMITIVE_RESTART_FIXED_INDEX
+#define GL_PRIMITIVE_RESTART_FIXED_INDEX 0x8D69
+#endif
+#ifndef GL_PATCH_VERTICES
+#define GL_PATCH_VERTICES 0x8E72
+#endif
+#ifndef GL_TESS_CONTROL_SHADER
+#define GL_TESS_CONTROL_SHADER 0x8E88
+#endif
+#ifndef GL_TESS_EVALUATION_SHADER
+#define GL_TESS_EVALUATION_SHADER 0x8E87
+#endif
+#ifndef GL_MAX_TESS_GEN_LEVEL
+#define GL_MAX_TESS_GEN_LEVEL 0x8E7E
+#endif
+#ifndef GL_GEOMETRY_SHADER
+#define GL_GEOMETRY_SHADER 0x8DD9
+#endif
+#ifndef GL_MAX_VIEWS_OVR
+#define GL_MAX_VIEWS_OVR 0x9631
+#endif
+#ifndef GL_TEXTURE_SPARSE_ARB
+#define GL_TEXTURE_SPARSE_ARB 0x91A6
+#endif
+#ifndef GL_NUM_VIRTUAL_PAGE_SIZES_ARB
+#define GL_NUM_VIRTUAL_PAGE_SIZES_ARB 0x91A8
+#endif
+#ifndef GL_VIRTUAL_PAGE_SIZE_X_ARB
+#define GL_VIRTUAL_PAGE_SIZE_X_ARB 0x9195
+#endif
+#ifndef GL_VIRTUAL_PAGE_SIZE_Y_ARB
+#define GL_VIRTUAL_PAGE_SIZE_Y_ARB 0x9196
+#endif
+#ifndef GL_MAX_SPARSE_TEXTURE_SIZE_ARB
+#define GL_MAX_SPARSE_TEXTURE_SIZE_ARB 0x9198
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+#ifndef GL_PROGRAM_POINT_SIZE
+#define GL_PROGRAM_POINT_SIZE 0x8642
+#endif
+#ifndef GL_RASTERIZER_DISCARD
+#define GL_RASTERIZER_DISCARD 0x8C89
+#endif
+#ifndef GL_INTERLEAVED_ATTRIBS
+#define GL_INTERLEAVED_ATTRIBS 0x8C8C
+#endif
+#ifndef GL_TRANSFORM_FEEDBACK_BUFFER
+#define GL_TRANSFORM_FEEDBACK_BUFFER 0x8C8E
+#endif
+#ifndef GL_DEPTH
+#define GL_DEPTH 0x1801
+#endif
+#ifndef GL_STENCIL
+#define GL_STENCIL 0x1802
+#endif
+#ifndef GL_STENCIL_ATTACHMENT
+#define GL_STENCIL_ATTACHMENT 0x8D20
+#endif
+#ifndef GL_STENCIL_INDEX8
+#define GL_STENCIL_INDEX8 0x8D48
+#endif
+#ifndef GL_READ_FRAMEBUFFER
+#define GL_READ_FRAMEBUFFER 0x8CA8
+#endif
+#ifndef GL_DRAW_FRAMEBUFFER
+#define GL_DRAW_FRAMEBUFFER 0x8CA9
+#endif
+#ifndef GL_MAX_SAMPLES
+#define GL_MAX_SAMPLES 0x8D57
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_RGB10_A2
+#define GL_RGB10_A2 0x8059
+#endif
+#ifndef GL_RGBA16F
+#define GL_RGBA16F 0x881A
+#endif
+#ifndef GL_R11F_G11F_B10F
+#define GL_R11F_G11F_B10F 0x8C3A
+#endif
+#ifndef GL_UNSIGNED_INT_10F_11F_11F_REV
+#define GL_UNSIGNED_INT_10F_11F_11F_REV 0x8C3B
+#endif
+#ifndef GL_UNSIGNED_INT_2_10_10_10_REV
+#define GL_UNSIGNED_INT_2_10_10_10_REV 0x8368
+#endif
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24 0x81A6
+#endif
+#ifndef GL_SAMPLE_SHADING
+#define GL_SAMPLE_SHADING 0x8C36
+#endif
+#ifndef GL_TEXTURE_2D_ARRAY
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#endif
+#ifndef GL_MAX_ARRAY_TEXTURE_LAYERS
+#define GL_MAX_ARRAY_TEXTURE_LAYERS 0x88FF
+#endif
+#ifndef GL_DEPTH_COMPONENT32F
+#define GL_DEPTH_COMPONENT32F 0x8CAC
+#endif
+#ifndef GL_DEPTH_STENCIL
+#define GL_DEPTH_STENCIL 0x84F9
+#endif
+#ifndef GL_DEPTH_STENCIL_ATTACHMENT
+#define GL_DEPTH_STENCIL_ATTACHMENT 0x821A
+#endif
+#ifndef GL_DEPTH24_STENCIL8
+#define GL_DEPTH24_STENCIL8 0x88F0
+#endif
+#ifndef GL_DEPTH32F_STENCIL8
+#define GL_DEPTH32F_STENCIL8 0x8CAD
+#endif
+#ifndef GL_UNSIGNED_INT_24_8
+#define GL_UNSIGNED_INT_24_8 0x84FA
+#endif
+#ifndef GL_FLOAT_32_UNSIGNED_INT_24_8_REV
+#define GL_FLOAT_32_UNSIGNED_INT_24_8_REV 0x8DAD
+#endif
+#ifndef GL_LOWER_LEFT
+#define GL_LOWER_LEFT 0x8CA1
+#endif
+#ifndef GL_NEGATIVE_ONE_TO_ONE
+#define GL_NEGATIVE_ONE_TO_ONE 0x935E
+#endif
+#ifndef GL_ZERO_TO_ONE
+#define GL_ZERO_TO_ONE 0x935F
+#endif
+#ifndef GL_MAX_DRAW_BUFFERS
+#define GL_MAX_DRAW_BUFFERS 0x8824
+#endif
+#ifndef GL_COLOR_ATTACHMENT1
+#define GL_COLOR_ATTACHMENT1 0x8CE1
+#endif
+#ifndef GL_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_TEXTURE_MAX_ANISOTROPY_EXT 0x84FE
+#endif
+#ifndef GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT 0x84FF
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_R
+#define GL_TEXTURE_SWIZZLE_R 0x8E42
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_G
+#define GL_TEXTURE_SWIZZLE_G 0x8E43
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_B
+#define GL_TEXTURE_SWIZZLE_B 0x8E44
+#endif
+#ifndef GL_TEXTURE_SWIZZLE_A
+#define GL_TEXTURE_SWIZZLE_A 0x8E45
+#endif
+#ifndef GL_SRGB8_ALPHA8
+#define GL_SRGB8_ALPHA8 0x8C43
+#endif
+#ifndef GL_FRAMEBUFFER_SRGB
+#define GL_FRAMEBUFFER_SRGB 0x8DB9
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_GREEN
+#define GL_GREEN 0x1904
+#endif
+#ifndef GL_BLUE
+#define GL_BLUE 0x1905
+#endif
+#ifndef GL_DEBUG_SOURCE_APPLICATION
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#endif
+#ifndef GL_BUFFER
+#define GL_BUFFER 0x82E0
+#endif
+#ifndef GL_PROGRAM
+#define GL_PROGRAM 0x82E2
+#endif
+#ifndef GL_COUNTER_TYPE_AMD
+#define GL_COUNTER_TYPE_AMD 0x8BC0
+#endif
+#ifndef GL_UNSIGNED_INT64_AMD
+#define GL_UNSIGNED_INT64_AMD 0x8BC2
+#endif
+#ifndef GL_PERCENTAGE_AMD
+#define GL_PERCENTAGE_AMD 0x8BC3
+#endif
+#ifndef GL_PERFMON_RESULT_AVAILABLE_AMD
+#define GL_PERFMON_RESULT_AVAILABLE_AMD 0x8BC4
+#endif
+#ifndef GL_PERFMON_RESULT_SIZE_AMD
+#define GL_PERFMON_RESULT_SIZE_AMD 0x8BC5
+#endif
+#ifndef GL_PERFMON_RESULT_AMD
+#define GL_PERFMON_RESULT_AMD 0x8BC6
+#endif
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
 #include <string>
 
 /**
@@ -83,6 +454,28 @@ struct GLExtensions {
      */
     static bool support(const std::string &ext);
 
+    /**
+     * Whether the current context is at least of the specified GL version.
+     *
+     * For GLESv2 builds the version refers to the OpenGL ES version.
+     *
+     * @return true if the version is supported
+     */
+    static bool version_supported(int major, int minor);
+
+    /**
+     * Loads entry points for optional functionality which is not covered
+     * by the glad loaders (i.e. beyond GL 2.1 / GLES 2.0).
+     *
+     * Entry points are only loaded if the current context advertises
+     * support for them, so users can just check the function pointers
+     * for NULL. This must be called with a current context.
+     *
+     * @param load the function to use to look up entry points
+     * @param userptr user data to pass to the load function
+     */
+    static void load_optional(GLADuserptrloadfunc load, void *userptr);
+
     static void* (GLAD_API_PTR *MapBuffer) (GLenum target, GLenum access);
     static GLboolean (GLAD_API_PTR *UnmapBuffer) (GLenum target);
 
@@ -99,6 +492,138 @@ struct GLExtensions {
     static void (GLAD_API_PTR *RenderbufferStorage)(GLenum target, GLenum internalformat, GLsizei width, GLsizei height);
 
     static void (GLAD_API_PTR *GenerateMipmap)(GLenum target);
+
+    /* Queries (GL 1.5 / GLES 3.0 / GL_EXT_disjoint_timer_query) */
+    static void (GLAD_API_PTR *GenQueries)(GLsizei n, GLuint *ids);
+    static void (GLAD_API_PTR *DeleteQueries)(GLsizei n, const GLuint *ids);
+    static void (GLAD_API_PTR *BeginQuery)(GLenum target, GLuint id);
+    static void (GLAD_API_PTR *EndQuery)(GLenum target);
+    static void (GLAD_API_PTR *GetQueryObjectuiv)(GLuint id, GLenum pname, GLuint *params);
+
+    /* Timer queries (GL_ARB_timer_query / GL_EXT_disjoint_timer_query) */
+    static void (GLAD_API_PTR *GetQueryObjectui64v)(GLuint id, GLenum pname, GLuint64 *params);
+    static void (GLAD_API_PTR *QueryCounter)(GLuint id, GLenum target);
+
+    /* Buffer range mapping (GL 3.0 / GLES 3.0 / GL_EXT_map_buffer_range) */
+    static void* (GLAD_API_PTR *MapBufferRange)(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+
+    /* Sync objects (GL 3.2 / GLES 3.0 / GL_ARB_sync / GL_APPLE_sync) */
+    static GLsync (GLAD_API_PTR *FenceSync)(GLenum condition, GLbitfield flags);
+    static void (GLAD_API_PTR *DeleteSync)(GLsync sync);
+    static GLenum (GLAD_API_PTR *ClientWaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+    static void (GLAD_API_PTR *WaitSync)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+
+    /* Program binaries (GL 4.1 / GLES 3.0 / GL_ARB_get_program_binary / GL_OES_get_program_binary) */
+    static void (GLAD_API_PTR *GetProgramBinary)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+    static void (GLAD_API_PTR *ProgramBinary)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+
+    /* Immutable buffer storage (GL 4.4 / GL_ARB_buffer_storage / GL_EXT_buffer_storage) */
+    static void (GLAD_API_PTR *BufferStorage)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+    /* Vertex array objects (GL 3.0 / GLES 3.0 / GL_ARB_vertex_array_object / GL_OES_vertex_array_object) */
+    static void (GLAD_API_PTR *GenVertexArrays)(GLsizei n, GLuint *arrays);
+    static void (GLAD_API_PTR *BindVertexArray)(GLuint array);
+    static void (GLAD_API_PTR *DeleteVertexArrays)(GLsizei n, const GLuint *arrays);
+
+    /* Instanced rendering (GL 3.3 / GLES 3.0 / GL_ARB_instanced_arrays / GL_EXT_instanced_arrays / GL_ANGLE_instanced_arrays) */
+    static void (GLAD_API_PTR *DrawArraysInstanced)(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+    static void (GLAD_API_PTR *DrawElementsInstanced)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instancecount);
+    static void (GLAD_API_PTR *VertexAttribDivisor)(GLuint index, GLuint divisor);
+
+    /* Indirect drawing (GL 4.0 / GLES 3.1 / GL_ARB_draw_indirect) */
+    static void (GLAD_API_PTR *DrawArraysIndirect)(GLenum mode, const void *indirect);
+    static void (GLAD_API_PTR *DrawElementsIndirect)(GLenum mode, GLenum type, const void *indirect);
+
+    /* Multi draw indirect (GL 4.3 / GL_ARB_multi_draw_indirect / GL_EXT_multi_draw_indirect) */
+    static void (GLAD_API_PTR *MultiDrawArraysIndirect)(GLenum mode, const void *indirect, GLsizei drawcount, GLsizei stride);
+    static void (GLAD_API_PTR *MultiDrawElementsIndirect)(GLenum mode, GLenum type, const void *indirect, GLsizei drawcount, GLsizei stride);
+
+    /* Compute shaders (GL 4.3 / GLES 3.1 / GL_ARB_compute_shader) */
+    static void (GLAD_API_PTR *DispatchCompute)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+    /* Not named MemoryBarrier, which is a macro on Windows */
+    static void (GLAD_API_PTR *MemoryBarrierGL)(GLbitfield barriers);
+    static void (GLAD_API_PTR *BindBufferBase)(GLenum target, GLuint index, GLuint buffer);
+
+    /* Uniform buffer objects (GL 3.1 / GLES 3.0 / GL_ARB_uniform_buffer_object), also using BindBufferBase */
+    static GLuint (GLAD_API_PTR *GetUniformBlockIndex)(GLuint program, const GLchar *uniformBlockName);
+    static void (GLAD_API_PTR *UniformBlockBinding)(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+    static void (GLAD_API_PTR *BindBufferRange)(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    /* Transform feedback (GL 3.0 / GLES 3.0 / GL_EXT_transform_feedback), also using BindBufferBase */
+    static void (GLAD_API_PTR *TransformFeedbackVaryings)(GLuint program, GLsizei count, const GLchar *const *varyings, GLenum bufferMode);
+    static void (GLAD_API_PTR *BeginTransformFeedback)(GLenum primitiveMode);
+    static void (GLAD_API_PTR *EndTransformFeedback)();
+
+    /* Immutable texture storage (GL 4.2 / GLES 3.0 / GL_ARB_texture_storage / GL_EXT_texture_storage) */
+    static void (GLAD_API_PTR *TexStorage2D)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+
+    /* 2D array textures (GL 3.0 / GLES 3.0 / GL_EXT_texture_array) */
+    static void (GLAD_API_PTR *TexImage3D)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels);
+    static void (GLAD_API_PTR *TexSubImage3D)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels);
+    static void (GLAD_API_PTR *FramebufferTextureLayer)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer);
+
+    /* Rendering to several layers of an array texture in one pass (GL_OVR_multiview) */
+    static void (GLAD_API_PTR *FramebufferTextureMultiviewOVR)(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint baseViewIndex, GLsizei numViews);
+
+    /* Bindless textures (GL_ARB_bindless_texture / GL_NV_bindless_texture) */
+    static GLuint64 (GLAD_API_PTR *GetTextureHandle)(GLuint texture);
+    static void (GLAD_API_PTR *MakeTextureHandleResident)(GLuint64 handle);
+    static void (GLAD_API_PTR *MakeTextureHandleNonResident)(GLuint64 handle);
+    static void (GLAD_API_PTR *UniformHandleui64)(GLint location, GLuint64 value);
+
+    /* Sparse textures (GL_ARB_sparse_texture / GL_EXT_sparse_texture), with the page sizes queried by GetInternalformativ */
+    static void (GLAD_API_PTR *TexPageCommitment)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLboolean commit);
+    static void (GLAD_API_PTR *GetInternalformativ)(GLenum target, GLenum internalformat, GLenum pname, GLsizei count, GLint *params);
+
+    /* Clip space depth range (GL 4.5 / GL_ARB_clip_control / GL_EXT_clip_control) */
+    static void (GLAD_API_PTR *ClipControl)(GLenum origin, GLenum depth);
+
+    /* Image load/store (GL 4.2 / GLES 3.1 / GL_ARB_shader_image_load_store) */
+    static void (GLAD_API_PTR *BindImageTexture)(GLuint unit, GLuint texture, GLint level, GLboolean layered, GLint layer, GLenum access, GLenum format);
+
+    /* Framebuffer blits and multisampled renderbuffers (GL 3.0 / GLES 3.0 / GL_EXT_framebuffer_blit / GL_EXT_framebuffer_multisample) */
+    static void (GLAD_API_PTR *BlitFramebuffer)(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter);
+    static void (GLAD_API_PTR *RenderbufferStorageMultisample)(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height);
+
+    /* Implicitly resolved multisampling (GL_EXT_multisampled_render_to_texture / GL_IMG_multisampled_render_to_texture) */
+    static void (GLAD_API_PTR *FramebufferTexture2DMultisample)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level, GLsizei samples);
+    static void (GLAD_API_PTR *RenderbufferStorageMultisampleImplicit)(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height);
+
+    /* Tessellation shaders (GL 4.0 / GLES 3.2 / GLES 3.1 with GL_EXT_tessellation_shader) */
+    static void (GLAD_API_PTR *PatchParameteri)(GLenum pname, GLint value);
+
+    /* Sample shading (GL 4.0 / GLES 3.2 / GL_ARB_sample_shading / GL_OES_sample_shading) */
+    static void (GLAD_API_PTR *MinSampleShading)(GLfloat value);
+
+    /* Framebuffer invalidation (GL 4.3 / GLES 3.0 / GL_ARB_invalidate_subdata / GL_EXT_discard_framebuffer) */
+    static void (GLAD_API_PTR *InvalidateFramebuffer)(GLenum target, GLsizei numAttachments, const GLenum *attachments);
+
+    /* Multiple render targets (GL 2.0 / GLES 3.0 / GL_EXT_draw_buffers) */
+    static void (GLAD_API_PTR *DrawBuffers)(GLsizei n, const GLenum *bufs);
+
+    /* Parallel shader compilation (GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile) */
+    static void (GLAD_API_PTR *MaxShaderCompilerThreads)(GLuint count);
+
+    /* Debug groups and object labels (GL 4.3 / GLES 3.2 / GL_KHR_debug) */
+    static void (GLAD_API_PTR *PushDebugGroup)(GLenum source, GLuint id, GLsizei length, const GLchar *message);
+    static void (GLAD_API_PTR *PopDebugGroup)();
+    static void (GLAD_API_PTR *ObjectLabel)(GLenum identifier, GLuint name, GLsizei length, const GLchar *label);
+
+    /* Textures from EGLImages (GL_OES_EGL_image, GL_OES_EGL_image_external for GL_TEXTURE_EXTERNAL_OES) */
+    static void (GLAD_API_PTR *EGLImageTargetTexture2DOES)(GLenum target, GLeglImageOES image);
+
+    /* GPU performance counters (GL_AMD_performance_monitor) */
+    static void (GLAD_API_PTR *GetPerfMonitorGroupsAMD)(GLint *numGroups, GLsizei groupsSize, GLuint *groups);
+    static void (GLAD_API_PTR *GetPerfMonitorCountersAMD)(GLuint group, GLint *numCounters, GLint *maxActiveCounters, GLsizei counterSize, GLuint *counters);
+    static void (GLAD_API_PTR *GetPerfMonitorGroupStringAMD)(GLuint group, GLsizei bufSize, GLsizei *length, GLchar *groupString);
+    static void (GLAD_API_PTR *GetPerfMonitorCounterStringAMD)(GLuint group, GLuint counter, GLsizei bufSize, GLsizei *length, GLchar *counterString);
+    static void (GLAD_API_PTR *GetPerfMonitorCounterInfoAMD)(GLuint group, GLuint counter, GLenum pname, void *data);
+    static void (GLAD_API_PTR *GenPerfMonitorsAMD)(GLsizei n, GLuint *monitors);
+    static void (GLAD_API_PTR *DeletePerfMonitorsAMD)(GLsizei n, GLuint *monitors);
+    static void (GLAD_API_PTR *SelectPerfMonitorCountersAMD)(GLuint monitor, GLboolean enable, GLuint group, GLint numCounters, GLuint *counterList);
+    static void (GLAD_API_PTR *BeginPerfMonitorAMD)(GLuint monitor);
+    static void (GLAD_API_PTR *EndPerfMonitorAMD)(GLuint monitor);
+    static void (GLAD_API_PTR *GetPerfMonitorCounterDataAMD)(GLuint monitor, GLenum pname, GLsizei dataSize, GLuint *data, GLint *bytesWritten);
 };
 
 #endif
@@ -22,16 +22,119 @@
 #include "gl-state-egl.h"
 #include "log.h"
 #include "options.h"
+#include "call-profiler.h"
+#include "flush-points.h"
+#include "call-recorder.h"
+#include "startup-report.h"
 #include "gl-headers.h"
 #include "limits.h"
+#include "util.h"
 #include "gl-headers.h"
 #include <iomanip>
 #include <sstream>
 #include <cstring>
+#if !defined(WIN32)
+#include <unistd.h>
+#endif
+
+#ifndef EGL_ANDROID_native_fence_sync
+#define EGL_SYNC_NATIVE_FENCE_ANDROID 0x3144
+#define EGL_SYNC_NATIVE_FENCE_FD_ANDROID 0x3145
+#define EGL_NO_NATIVE_FENCE_FD_ANDROID -1
+#endif
+
+#ifndef EGL_ANDROID_get_frame_timestamps
+#define EGL_TIMESTAMPS_ANDROID 0x3430
+#define EGL_COMPOSITE_INTERVAL_ANDROID 0x3432
+#define EGL_DISPLAY_PRESENT_TIME_ANDROID 0x343A
+#define EGL_TIMESTAMP_PENDING_ANDROID -2
+#define EGL_TIMESTAMP_INVALID_ANDROID -1
+#endif
+
+#ifndef EGL_EXT_buffer_age
+#define EGL_BUFFER_AGE_EXT 0x313D
+#endif
+
+#ifndef EGL_EXT_platform_device
+#define EGL_PLATFORM_DEVICE_EXT 0x313F
+#endif
+
+#ifndef EGL_MESA_platform_surfaceless
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
 
 using std::vector;
 using std::string;
 
+/* Gets the EGL_IMG_context_priority level of a priority */
+static EGLint
+context_priority_level(Options::ContextPriority priority)
+{
+    switch (priority) {
+        case Options::ContextPriorityLow: return EGL_CONTEXT_PRIORITY_LOW_IMG;
+        case Options::ContextPriorityHigh: return EGL_CONTEXT_PRIORITY_HIGH_IMG;
+        default: return EGL_CONTEXT_PRIORITY_MEDIUM_IMG;
+    }
+}
+
+static const char *
+context_priority_name(EGLint level)
+{
+    switch (level) {
+        case EGL_CONTEXT_PRIORITY_LOW_IMG: return "low";
+        case EGL_CONTEXT_PRIORITY_HIGH_IMG: return "high";
+        default: return "medium";
+    }
+}
+
+/*
+ * A context for rendering from another thread, current without a surface
+ * (EGL_KHR_surfaceless_context) or with a small pbuffer.
+ */
+class GLWorkerContextEGL : public GLWorkerContext
+{
+public:
+    GLWorkerContextEGL(EGLDisplay display, EGLContext context,
+                       EGLSurface surface, EGLenum api) :
+        display_(display), context_(context), surface_(surface), api_(api) {}
+
+    ~GLWorkerContextEGL()
+    {
+        if (surface_)
+            eglDestroySurface(display_, surface_);
+        eglDestroyContext(display_, context_);
+    }
+
+    bool make_current()
+    {
+        /* The bound API is per thread */
+        if (eglBindAPI && !eglBindAPI(api_))
+            return false;
+
+        if (!eglMakeCurrent(display_, surface_, surface_, context_)) {
+            Log::error("eglMakeCurrent failed with error: 0x%x\n", eglGetError());
+            return false;
+        }
+
+        StateTracker::invalidate();
+
+        return true;
+    }
+
+    void release()
+    {
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (eglReleaseThread)
+            eglReleaseThread();
+    }
+
+private:
+    EGLDisplay display_;
+    EGLContext context_;
+    EGLSurface surface_;
+    EGLenum api_;
+};
+
 GLADapiproc load_egl_func(void *userdata, const char *name)
 {
     SharedLibrary *lib = reinterpret_cast<SharedLibrary *>(userdata);
@@ -296,6 +399,8 @@ EglConfig::print() const
 
 GLStateEGL::~GLStateEGL()
 {
+    stop_context_pool();
+
     if(egl_display_ != nullptr){
         if(!eglTerminate(egl_display_))
             Log::error("eglTerminate failed\n");
@@ -308,13 +413,16 @@ GLStateEGL::~GLStateEGL()
 bool
 GLStateEGL::init_display(void* native_display, GLVisualConfig& visual_config)
 {
+    {
+        StartupReport::Phase phase("egl-library");
 #if defined(WIN32)
-    if (!egl_lib_.open("libEGL.dll")) {
+        if (!egl_lib_.open("libEGL.dll")) {
 #else
-    if (!egl_lib_.open_from_alternatives({"libEGL.so", "libEGL.so.1" })) {
+        if (!egl_lib_.open_from_alternatives({"libEGL.so", "libEGL.so.1" })) {
 #endif
-        Log::error("Error loading EGL library\n");
-        return false;
+            Log::error("Error loading EGL library\n");
+            return false;
+        }
     }
 
     native_display_ = reinterpret_cast<EGLNativeDisplayType>(native_display);
@@ -334,6 +442,8 @@ GLStateEGL::init_surface(void* native_window)
 bool
 GLStateEGL::init_gl_extensions()
 {
+    StartupReport::Phase phase("gl-entry-points");
+
 #if GLMARK2_USE_GLESv2
     if (!gladLoadGLES2UserPtr(load_proc, this)) {
         Log::error("Loading GLESv2 entry points failed.");
@@ -378,6 +488,12 @@ GLStateEGL::init_gl_extensions()
 
     GLExtensions::GenerateMipmap = glGenerateMipmapEXT;
 #endif
+    GLExtensions::load_optional(load_proc, this);
+    CallRecorder::install(!Options::record.empty());
+    CallProfiler::install(Options::profile_gl_calls);
+    StateTracker::install(Options::state_tracking);
+    FlushPoints::install(Options::flush_points);
+
     return true;
 }
 
@@ -404,8 +520,24 @@ GLStateEGL::valid()
         return false;
     }
 
-    if (Options::swap_mode != Options::SwapModeFIFO &&
-        (!eglSwapInterval || !eglSwapInterval(egl_display_, 0))) {
+    /* EGL can't make only the late swaps tear */
+    if (egl_surface_ && Options::swap_mode == Options::SwapModeRelaxed) {
+        Log::info("Warning: EGL doesn't support the 'relaxed' swap mode, using"
+                  " 'fifo'\n");
+    }
+
+    if (!egl_surface_) {
+        swap_mode_.clear();
+    }
+    else if (Options::swap_mode == Options::SwapModeFIFO ||
+             Options::swap_mode == Options::SwapModeRelaxed) {
+        swap_mode_ = "fifo";
+    }
+    else if (eglSwapInterval && eglSwapInterval(egl_display_, 0)) {
+        swap_mode_ = "immediate";
+    }
+    else {
+        swap_mode_ = "fifo";
         Log::info("** Failed to set swap interval. Results may be bounded above by refresh rate.\n");
     }
 
@@ -427,7 +559,16 @@ GLStateEGL::reset()
         return true;
     }
 
-    if (EGL_FALSE == eglDestroyContext(egl_display_, egl_context_)) {
+    if (pool_thread_.joinable()) {
+        /* The context is destroyed in the background, once it's released */
+        eglMakeCurrent(egl_display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            retired_contexts_.push_back(egl_context_);
+        }
+        pool_cond_.notify_one();
+    }
+    else if (EGL_FALSE == eglDestroyContext(egl_display_, egl_context_)) {
         Log::debug("eglDestroyContext failed with error: 0x%x\n", eglGetError());
     }
 
@@ -439,7 +580,164 @@ GLStateEGL::reset()
 void
 GLStateEGL::swap()
 {
-    eglSwapBuffers(egl_display_, egl_surface_);
+    swap_with_damage(std::vector<int>());
+}
+
+void
+GLStateEGL::swap_with_damage(const std::vector<int>& rects)
+{
+    /* Without a surface, the frames are only rendered off-screen */
+    if (!egl_surface_)
+        return;
+
+    EGLuint64KHR frame_id = 0;
+    bool have_frame_id = get_next_frame_id_ &&
+                         get_next_frame_id_(egl_display_, egl_surface_, &frame_id);
+
+    if (!rects.empty() && swap_buffers_with_damage_) {
+        std::vector<EGLint> egl_rects(rects.begin(), rects.end());
+        swap_buffers_with_damage_(egl_display_, egl_surface_, egl_rects.data(),
+                                  egl_rects.size() / 4);
+    }
+    else {
+        eglSwapBuffers(egl_display_, egl_surface_);
+    }
+
+    if (get_frame_timestamps_) {
+        if (have_frame_id) {
+            PendingFrame frame = { frame_id, Util::get_timestamp_us() };
+            pending_frames_.push_back(frame);
+        }
+        collect_frame_timestamps();
+    }
+}
+
+int
+GLStateEGL::swap_with_fence()
+{
+    static const EGLint attribs[] = {
+        EGL_SYNC_NATIVE_FENCE_FD_ANDROID, EGL_NO_NATIVE_FENCE_FD_ANDROID,
+        EGL_NONE
+    };
+
+    /* The fence signals once the commands before it have completed */
+    EGLSync sync = create_sync_(egl_display_, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+
+    /* The swap flushes the fence, which is required to get its fd */
+    swap();
+
+    if (sync == EGL_NO_SYNC)
+        return -1;
+
+    int fence_fd = dup_native_fence_fd_(egl_display_, sync);
+    destroy_sync_(egl_display_, sync);
+
+    return fence_fd;
+}
+
+void
+GLStateEGL::wait_native_fence(int fence_fd)
+{
+    if (fence_fd < 0)
+        return;
+
+    const EGLint attribs[] = {
+        EGL_SYNC_NATIVE_FENCE_FD_ANDROID, fence_fd,
+        EGL_NONE
+    };
+
+    /* The sync takes ownership of the fd when it is created */
+    EGLSync sync = create_sync_(egl_display_, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+    if (sync == EGL_NO_SYNC) {
+        Log::debug("Failed to import a native fence: 0x%x\n", eglGetError());
+#if !defined(WIN32)
+        close(fence_fd);
+#endif
+        return;
+    }
+
+    wait_sync_(egl_display_, sync, 0);
+    destroy_sync_(egl_display_, sync);
+}
+
+int
+GLStateEGL::create_native_fence()
+{
+    static const EGLint attribs[] = {
+        EGL_SYNC_NATIVE_FENCE_FD_ANDROID, EGL_NO_NATIVE_FENCE_FD_ANDROID,
+        EGL_NONE
+    };
+
+    if (!dup_native_fence_fd_)
+        return -1;
+
+    EGLSync sync = create_sync_(egl_display_, EGL_SYNC_NATIVE_FENCE_ANDROID, attribs);
+    if (sync == EGL_NO_SYNC)
+        return -1;
+
+    /* The fence has to be flushed before its fd can be duplicated */
+    glFlush();
+
+    int fence_fd = dup_native_fence_fd_(egl_display_, sync);
+    destroy_sync_(egl_display_, sync);
+
+    return fence_fd;
+}
+
+void*
+GLStateEGL::create_dma_buf_image(const DmaBufImage& image)
+{
+    static const EGLint plane_attribs[DmaBufImage::max_planes][3] = {
+        { EGL_DMA_BUF_PLANE0_FD_EXT, EGL_DMA_BUF_PLANE0_OFFSET_EXT, EGL_DMA_BUF_PLANE0_PITCH_EXT },
+        { EGL_DMA_BUF_PLANE1_FD_EXT, EGL_DMA_BUF_PLANE1_OFFSET_EXT, EGL_DMA_BUF_PLANE1_PITCH_EXT },
+        { EGL_DMA_BUF_PLANE2_FD_EXT, EGL_DMA_BUF_PLANE2_OFFSET_EXT, EGL_DMA_BUF_PLANE2_PITCH_EXT }
+    };
+
+    if (!create_image_ || image.num_planes > DmaBufImage::max_planes)
+        return 0;
+
+    std::vector<EGLint> attribs;
+    attribs.push_back(EGL_WIDTH);
+    attribs.push_back(image.width);
+    attribs.push_back(EGL_HEIGHT);
+    attribs.push_back(image.height);
+    attribs.push_back(EGL_LINUX_DRM_FOURCC_EXT);
+    attribs.push_back(image.fourcc);
+
+    for (unsigned int i = 0; i < image.num_planes; i++) {
+        attribs.push_back(plane_attribs[i][0]);
+        attribs.push_back(image.fds[i]);
+        attribs.push_back(plane_attribs[i][1]);
+        attribs.push_back(image.offsets[i]);
+        attribs.push_back(plane_attribs[i][2]);
+        attribs.push_back(image.strides[i]);
+    }
+
+    attribs.push_back(EGL_NONE);
+
+    /* The fds are not consumed, they can be imported again */
+    EGLImageKHR egl_image = create_image_(egl_display_, EGL_NO_CONTEXT,
+                                          EGL_LINUX_DMA_BUF_EXT, 0, &attribs.front());
+    if (!egl_image) {
+        Log::debug("Failed to import a dma-buf image: 0x%x\n", eglGetError());
+        return 0;
+    }
+
+    return egl_image;
+}
+
+void
+GLStateEGL::destroy_dma_buf_image(void* image)
+{
+    if (destroy_image_ && image)
+        destroy_image_(egl_display_, static_cast<EGLImageKHR>(image));
+}
+
+void
+GLStateEGL::take_presentations(PresentationList& list)
+{
+    list.insert(list.end(), presentations_.begin(), presentations_.end());
+    presentations_.clear();
 }
 
 bool
@@ -467,6 +765,30 @@ GLStateEGL::getVisualConfig(GLVisualConfig& vc)
         return;
 
     get_glvisualconfig(egl_config_, vc);
+    /* The surface is created in the requested color space, or not at all */
+    vc.srgb = requested_visual_config_.srgb;
+    /* Off-screen frames are rendered in the requested format by the canvas */
+    if (Options::offscreen && requested_visual_config_.fp) {
+        vc.fp = requested_visual_config_.fp;
+        vc.red = requested_visual_config_.red;
+        vc.green = requested_visual_config_.green;
+        vc.blue = requested_visual_config_.blue;
+        vc.alpha = requested_visual_config_.alpha;
+        vc.buffer = vc.red + vc.green + vc.blue + vc.alpha;
+    }
+}
+
+std::string
+GLStateEGL::platform_version()
+{
+    if (!egl_display_)
+        return std::string();
+
+    const char* vendor = eglQueryString(egl_display_, EGL_VENDOR);
+    const char* version = eglQueryString(egl_display_, EGL_VERSION);
+
+    return std::string("EGL ") + (version ? version : "unknown") +
+           " (" + (vendor ? vendor : "unknown") + ")";
 }
 
 /******************************
@@ -481,6 +803,10 @@ GLStateEGL::getVisualConfig(GLVisualConfig& vc)
 #define GLMARK2_NATIVE_EGL_DISPLAY_ENUM EGL_PLATFORM_GBM_KHR
 #elif  GLMARK2_USE_MIR
 #define GLMARK2_NATIVE_EGL_DISPLAY_ENUM EGL_PLATFORM_MIR_KHR
+#elif  GLMARK2_USE_HEADLESS
+// The native display is the EGL device, if the devices can be enumerated
+#define GLMARK2_NATIVE_EGL_DISPLAY_ENUM \
+    (native_display_ ? EGL_PLATFORM_DEVICE_EXT : EGL_PLATFORM_SURFACELESS_MESA)
 #else
 // Platforms not in the above platform enums fall back to eglGetDisplay.
 #define GLMARK2_NATIVE_EGL_DISPLAY_ENUM 0
@@ -492,6 +818,8 @@ GLStateEGL::gotValidDisplay()
     if (egl_display_)
         return true;
 
+    StartupReport::Phase phase("egl-display");
+
     /* Until we initialize glad EGL, load and use our own function pointers. */
     PFNEGLQUERYSTRINGPROC egl_query_string =
         reinterpret_cast<PFNEGLQUERYSTRINGPROC>(egl_lib_.load("eglQueryString"));
@@ -538,6 +866,14 @@ GLStateEGL::gotValidDisplay()
         Log::debug("eglGetPlatformDisplayEXT() seems unsupported\n");
     }
 
+#if GLMARK2_USE_HEADLESS
+    /* eglGetDisplay() can't use an EGL device */
+    if (!egl_display_ && native_display_) {
+        Log::error("Failed to get the display of the EGL device\n");
+        return false;
+    }
+#endif
+
     /* Just in case get_platform_display failed... */
     if (!egl_display_) {
         Log::debug("Falling back to eglGetDisplay()\n");
@@ -592,9 +928,119 @@ GLStateEGL::gotValidDisplay()
         return false;
     }
 
+    init_native_fences();
+    init_dma_buf_import();
+
     return true;
 }
 
+void
+GLStateEGL::init_native_fences()
+{
+    const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_ANDROID_native_fence_sync") ||
+        !strstr(extensions, "EGL_KHR_wait_sync"))
+    {
+        return;
+    }
+
+    create_sync_ = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+        eglGetProcAddress("eglCreateSyncKHR"));
+    destroy_sync_ = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+        eglGetProcAddress("eglDestroySyncKHR"));
+    wait_sync_ = reinterpret_cast<PFNEGLWAITSYNCKHRPROC>(
+        eglGetProcAddress("eglWaitSyncKHR"));
+    dup_native_fence_fd_ = reinterpret_cast<PFNEGLDUPNATIVEFENCEFDANDROIDPROC>(
+        eglGetProcAddress("eglDupNativeFenceFDANDROID"));
+
+    /* supports_native_fences() checks the last one */
+    if (!create_sync_ || !destroy_sync_ || !wait_sync_)
+        dup_native_fence_fd_ = 0;
+}
+
+void
+GLStateEGL::init_dma_buf_import()
+{
+    const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_EXT_image_dma_buf_import") ||
+        !strstr(extensions, "EGL_KHR_image_base"))
+    {
+        return;
+    }
+
+    create_image_ = reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(
+        eglGetProcAddress("eglCreateImageKHR"));
+    destroy_image_ = reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(
+        eglGetProcAddress("eglDestroyImageKHR"));
+
+    if (!destroy_image_)
+        create_image_ = 0;
+}
+
+unsigned int
+GLStateEGL::buffer_age()
+{
+    EGLint age = 0;
+
+    if (!egl_surface_ || !buffer_age_supported_ ||
+        !eglQuerySurface(egl_display_, egl_surface_, EGL_BUFFER_AGE_EXT, &age) ||
+        age < 0)
+    {
+        return 0;
+    }
+
+    return age;
+}
+
+void
+GLStateEGL::set_damage_region(const std::vector<int>& rects)
+{
+    if (!egl_surface_ || !set_damage_region_ || rects.empty())
+        return;
+
+    /* The damage region is rejected unless the buffer age was queried */
+    EGLint age = 0;
+    eglQuerySurface(egl_display_, egl_surface_, EGL_BUFFER_AGE_EXT, &age);
+
+    std::vector<EGLint> egl_rects(rects.begin(), rects.end());
+    if (!set_damage_region_(egl_display_, egl_surface_, egl_rects.data(),
+                            egl_rects.size() / 4))
+    {
+        Log::debug("eglSetDamageRegionKHR failed with error: 0x%x\n",
+                   eglGetError());
+    }
+}
+
+void
+GLStateEGL::init_partial_updates()
+{
+    swap_buffers_with_damage_ = 0;
+    set_damage_region_ = 0;
+    buffer_age_supported_ = false;
+
+    const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+    if (!extensions)
+        return;
+
+    /* EGL_KHR_partial_update also defines the buffer age query */
+    buffer_age_supported_ = strstr(extensions, "EGL_EXT_buffer_age") != 0 ||
+                            strstr(extensions, "EGL_KHR_partial_update") != 0;
+
+    if (strstr(extensions, "EGL_KHR_partial_update")) {
+        set_damage_region_ = reinterpret_cast<PFNEGLSETDAMAGEREGIONKHRPROC>(
+            eglGetProcAddress("eglSetDamageRegionKHR"));
+    }
+
+    if (strstr(extensions, "EGL_KHR_swap_buffers_with_damage")) {
+        swap_buffers_with_damage_ = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+    }
+    else if (strstr(extensions, "EGL_EXT_swap_buffers_with_damage")) {
+        swap_buffers_with_damage_ = reinterpret_cast<PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC>(
+            eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+    }
+}
+
 void
 GLStateEGL::get_glvisualconfig(EGLConfig config, GLVisualConfig& visual_config)
 {
@@ -605,6 +1051,12 @@ GLStateEGL::get_glvisualconfig(EGLConfig config, GLVisualConfig& visual_config)
     eglGetConfigAttrib(egl_display_, config, EGL_ALPHA_SIZE, &visual_config.alpha);
     eglGetConfigAttrib(egl_display_, config, EGL_DEPTH_SIZE, &visual_config.depth);
     eglGetConfigAttrib(egl_display_, config, EGL_STENCIL_SIZE, &visual_config.stencil);
+
+    /* Without EGL_EXT_pixel_format_float all configs are fixed point */
+    EGLint component_type(0);
+    visual_config.fp = eglGetConfigAttrib(egl_display_, config, EGL_COLOR_COMPONENT_TYPE_EXT,
+                                          &component_type) &&
+                       component_type == EGL_COLOR_COMPONENT_TYPE_FLOAT_EXT;
 }
 
 EGLConfig
@@ -644,14 +1096,36 @@ GLStateEGL::gotValidConfig()
     if (egl_config_)
         return true;
 
+    StartupReport::Phase phase("egl-config");
+
     if (!gotValidDisplay())
         return false;
 
-    const EGLint config_attribs[] = {
-        EGL_RED_SIZE, requested_visual_config_.red,
-        EGL_GREEN_SIZE, requested_visual_config_.green,
-        EGL_BLUE_SIZE, requested_visual_config_.blue,
-        EGL_ALPHA_SIZE, requested_visual_config_.alpha,
+    /* Switching a surface to front buffer rendering needs a config for it */
+    const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+    mutable_render_buffer_ = Options::single_buffer && extensions &&
+                             strstr(extensions, "EGL_KHR_mutable_render_buffer");
+
+    /*
+     * Floating point configs are only chosen when asked for explicitly, and
+     * are not needed when the canvas renders into its own framebuffers.
+     */
+    bool want_float = requested_visual_config_.fp && !Options::offscreen;
+    bool pixel_format_float = extensions &&
+                              strstr(extensions, "EGL_EXT_pixel_format_float");
+    if (want_float && !pixel_format_float) {
+        Log::error("Floating point configs require EGL_EXT_pixel_format_float\n");
+        return false;
+    }
+
+    /* Any fixed point config does for an off-screen floating point canvas */
+    bool any_color = requested_visual_config_.fp && !want_float;
+
+    std::vector<EGLint> config_attribs = {
+        EGL_RED_SIZE, any_color ? 1 : requested_visual_config_.red,
+        EGL_GREEN_SIZE, any_color ? 1 : requested_visual_config_.green,
+        EGL_BLUE_SIZE, any_color ? 1 : requested_visual_config_.blue,
+        EGL_ALPHA_SIZE, any_color ? 0 : requested_visual_config_.alpha,
         EGL_DEPTH_SIZE, requested_visual_config_.depth,
         EGL_STENCIL_SIZE, requested_visual_config_.stencil,
 #if GLMARK2_USE_GLESv2
@@ -659,12 +1133,23 @@ GLStateEGL::gotValidConfig()
 #elif GLMARK2_USE_GL
         EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
 #endif
-        EGL_NONE
+#if GLMARK2_USE_HEADLESS
+        /* No surface is created, so any config will do */
+        EGL_SURFACE_TYPE, 0,
+#else
+        EGL_SURFACE_TYPE, mutable_render_buffer_ ?
+            EGL_WINDOW_BIT | EGL_MUTABLE_RENDER_BUFFER_BIT_KHR : EGL_WINDOW_BIT,
+#endif
     };
+    if (want_float) {
+        config_attribs.push_back(EGL_COLOR_COMPONENT_TYPE_EXT);
+        config_attribs.push_back(EGL_COLOR_COMPONENT_TYPE_FLOAT_EXT);
+    }
+    config_attribs.push_back(EGL_NONE);
 
     // Find out how many configs match the attributes.
     EGLint num_configs(0);
-    if (!eglChooseConfig(egl_display_, config_attribs, 0, 0, &num_configs)) {
+    if (!eglChooseConfig(egl_display_, &config_attribs[0], 0, 0, &num_configs)) {
         Log::error("eglChooseConfig() (count query) failed with error: %d\n",
                    eglGetError());
         return false;
@@ -677,7 +1162,7 @@ GLStateEGL::gotValidConfig()
 
     // Get all the matching configs
     vector<EGLConfig> configs(num_configs);
-    if (!eglChooseConfig(egl_display_, config_attribs, &configs.front(),
+    if (!eglChooseConfig(egl_display_, &config_attribs[0], &configs.front(),
                          num_configs, &num_configs))
     {
         Log::error("eglChooseConfig() failed with error: %d\n",
@@ -688,6 +1173,11 @@ GLStateEGL::gotValidConfig()
     // Select the best matching config
     egl_config_ = select_best_config(configs);
 
+    // Describing a config takes many attribute queries, which add up on
+    // drivers with hundreds of configs, so only do it to print them.
+    if (!Options::show_debug)
+        return true;
+
     vector<EglConfig> configVec;
     for (vector<EGLConfig>::const_iterator configIt = configs.begin();
          configIt != configs.end();
@@ -726,51 +1216,391 @@ GLStateEGL::gotValidSurface()
     if (egl_surface_)
         return true;
 
+    StartupReport::Phase phase("egl-surface");
+
     if (!gotValidDisplay())
         return false;
 
     if (!gotValidConfig())
         return false;
 
-    egl_surface_ = eglCreateWindowSurface(egl_display_, egl_config_, native_window_, 0);
+#if GLMARK2_USE_HEADLESS
+    /* The context is made current without a surface */
+    const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        Log::error("Rendering without a surface requires EGL_KHR_surfaceless_context\n");
+        return false;
+    }
+    return true;
+#endif
+
+    /*
+     * Without EGL_KHR_mutable_render_buffer the front buffer can only be
+     * requested when creating the surface, which is often ignored.
+     */
+    std::vector<EGLint> surface_attribs;
+    if (Options::single_buffer && !mutable_render_buffer_) {
+        surface_attribs.push_back(EGL_RENDER_BUFFER);
+        surface_attribs.push_back(EGL_SINGLE_BUFFER);
+    }
+
+    /* The display encodes the output of the shaders in sRGB */
+    if (requested_visual_config_.srgb && !Options::offscreen) {
+        const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+        if (!extensions || !strstr(extensions, "EGL_KHR_gl_colorspace")) {
+            Log::error("sRGB surfaces require EGL_KHR_gl_colorspace\n");
+            return false;
+        }
+        surface_attribs.push_back(EGL_GL_COLORSPACE);
+        surface_attribs.push_back(EGL_GL_COLORSPACE_SRGB);
+    }
+    surface_attribs.push_back(EGL_NONE);
+
+    egl_surface_ = eglCreateWindowSurface(egl_display_, egl_config_, native_window_,
+                                          &surface_attribs[0]);
     if (!egl_surface_) {
         Log::error("eglCreateWindowSurface failed with error: 0x%x\n", eglGetError());
         return false;
     }
 
+    init_frame_timestamps();
+    init_partial_updates();
+    init_single_buffer();
+
     return true;
 }
 
+void
+GLStateEGL::init_single_buffer()
+{
+    if (!Options::single_buffer)
+        return;
+
+    if (!mutable_render_buffer_) {
+        Log::info("Warning: EGL_KHR_mutable_render_buffer is not supported, "
+                  "rendering to the front buffer may not be honored\n");
+        return;
+    }
+
+    /* Takes effect on the next eglSwapBuffers() */
+    if (!eglSurfaceAttrib(egl_display_, egl_surface_, EGL_RENDER_BUFFER, EGL_SINGLE_BUFFER)) {
+        Log::info("Warning: Failed to switch the surface to the front buffer (0x%x)\n",
+                  eglGetError());
+    }
+}
+
+void
+GLStateEGL::init_frame_timestamps()
+{
+    get_next_frame_id_ = 0;
+    get_frame_timestamps_ = 0;
+    refresh_ = 0;
+    pending_frames_.clear();
+
+    if (!Options::present_timing)
+        return;
+
+    const char* extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+    if (!extensions || !strstr(extensions, "EGL_ANDROID_get_frame_timestamps"))
+        return;
+
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC get_next_frame_id =
+        reinterpret_cast<PFNEGLGETNEXTFRAMEIDANDROIDPROC>(
+            eglGetProcAddress("eglGetNextFrameIdANDROID"));
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC get_frame_timestamps =
+        reinterpret_cast<PFNEGLGETFRAMETIMESTAMPSANDROIDPROC>(
+            eglGetProcAddress("eglGetFrameTimestampsANDROID"));
+    PFNEGLGETCOMPOSITORTIMINGANDROIDPROC get_compositor_timing =
+        reinterpret_cast<PFNEGLGETCOMPOSITORTIMINGANDROIDPROC>(
+            eglGetProcAddress("eglGetCompositorTimingANDROID"));
+
+    if (!get_next_frame_id || !get_frame_timestamps ||
+        !eglSurfaceAttrib(egl_display_, egl_surface_, EGL_TIMESTAMPS_ANDROID, EGL_TRUE))
+    {
+        Log::debug("Failed to enable EGL frame timestamps\n");
+        return;
+    }
+
+    /* The refresh period, to count the missed vblanks */
+    static const EGLint interval_name = EGL_COMPOSITE_INTERVAL_ANDROID;
+    EGLnsecsANDROID interval = 0;
+    if (get_compositor_timing &&
+        get_compositor_timing(egl_display_, egl_surface_, 1, &interval_name, &interval) &&
+        interval > 0)
+    {
+        refresh_ = interval / 1000;
+    }
+
+    get_next_frame_id_ = get_next_frame_id;
+    get_frame_timestamps_ = get_frame_timestamps;
+
+    Log::debug("Using EGL_ANDROID_get_frame_timestamps for presentation feedback\n");
+}
+
+/*
+ * Gets the present times of the swapped frames, in order, stopping at the
+ * first frame that is not presented yet.
+ */
+void
+GLStateEGL::collect_frame_timestamps()
+{
+    /* Only a few frames of history are kept by EGL */
+    static const size_t max_pending_frames = 16;
+    static const EGLint present_name = EGL_DISPLAY_PRESENT_TIME_ANDROID;
+
+    while (pending_frames_.size() > max_pending_frames)
+        pending_frames_.pop_front();
+
+    while (!pending_frames_.empty()) {
+        const PendingFrame& frame(pending_frames_.front());
+        EGLnsecsANDROID present_time = EGL_TIMESTAMP_INVALID_ANDROID;
+
+        if (get_frame_timestamps_(egl_display_, egl_surface_, frame.id,
+                                  1, &present_name, &present_time) &&
+            present_time == EGL_TIMESTAMP_PENDING_ANDROID)
+        {
+            break;
+        }
+
+        /* The timestamps are in CLOCK_MONOTONIC, like Util::get_timestamp_us() */
+        if (present_time >= 0) {
+            Presentation presentation;
+            presentation.submit_time = frame.submit_time;
+            presentation.present_time = present_time / 1000;
+            presentation.refresh = refresh_;
+            presentations_.push_back(presentation);
+        }
+
+        pending_frames_.pop_front();
+    }
+}
+
 bool
 GLStateEGL::gotValidContext()
 {
     if (egl_context_)
         return true;
 
+    StartupReport::Phase phase("egl-context");
+
     if (!gotValidDisplay())
         return false;
 
     if (!gotValidConfig())
         return false;
 
-    static const EGLint context_attribs[] = {
-#ifdef GLMARK2_USE_GLESv2
-        EGL_CONTEXT_CLIENT_VERSION, 2,
-#endif
-        EGL_NONE
-    };
+    /* Take a context created in advance, if one is ready */
+    if (Options::context_pool > 0 && !Options::reuse_context) {
+        if (!pool_thread_.joinable()) {
+            pool_quit_ = false;
+            pool_thread_ = std::thread(&GLStateEGL::run_context_pool, this,
+                                       eglQueryAPI ? eglQueryAPI() : EGL_OPENGL_ES_API);
+        }
+        else {
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            if (!context_pool_.empty()) {
+                egl_context_ = context_pool_.front();
+                context_pool_.pop_front();
+            }
+        }
+        pool_cond_.notify_one();
+
+        if (egl_context_)
+            return true;
+    }
 
+    std::vector<EGLint> attribs(context_attribs(Options::context_priority));
     egl_context_ = eglCreateContext(egl_display_, egl_config_,
-                                    EGL_NO_CONTEXT, context_attribs);
+                                    EGL_NO_CONTEXT, &attribs[0]);
     if (!egl_context_) {
         Log::error("eglCreateContext() failed with error: 0x%x\n",
                    eglGetError());
         return false;
     }
 
+    check_context_priority(egl_context_, attribs);
+
     return true;
 }
 
+/*
+ * Keeps --context-pool contexts ready for the next scenes, and destroys the
+ * contexts of the previous scenes, on a background thread, so that the main
+ * thread doesn't wait for either.
+ */
+void
+GLStateEGL::run_context_pool(EGLenum api)
+{
+    /* The API is bound per thread */
+    if (eglBindAPI)
+        eglBindAPI(api);
+
+    std::vector<EGLint> attribs(context_attribs(Options::context_priority));
+    std::unique_lock<std::mutex> lock(pool_mutex_);
+    bool can_create = true;
+
+    while (!pool_quit_) {
+        if (!retired_contexts_.empty()) {
+            std::vector<EGLContext> retired;
+            retired.swap(retired_contexts_);
+
+            lock.unlock();
+            for (size_t i = 0; i < retired.size(); i++)
+                eglDestroyContext(egl_display_, retired[i]);
+            lock.lock();
+        }
+        else if (can_create && context_pool_.size() < Options::context_pool) {
+            lock.unlock();
+            EGLContext context = eglCreateContext(egl_display_, egl_config_,
+                                                  EGL_NO_CONTEXT, &attribs[0]);
+            lock.lock();
+
+            if (context)
+                context_pool_.push_back(context);
+            else
+                can_create = false;
+        }
+        else {
+            pool_cond_.wait(lock);
+        }
+    }
+
+    lock.unlock();
+
+    if (eglReleaseThread)
+        eglReleaseThread();
+}
+
+void
+GLStateEGL::stop_context_pool()
+{
+    if (!pool_thread_.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        pool_quit_ = true;
+    }
+    pool_cond_.notify_one();
+    pool_thread_.join();
+
+    for (size_t i = 0; i < context_pool_.size(); i++)
+        eglDestroyContext(egl_display_, context_pool_[i]);
+    for (size_t i = 0; i < retired_contexts_.size(); i++)
+        eglDestroyContext(egl_display_, retired_contexts_[i]);
+
+    context_pool_.clear();
+    retired_contexts_.clear();
+}
+
+/*
+ * Gets the attributes of new contexts, including their priority on the GPU
+ * with EGL_IMG_context_priority.
+ */
+std::vector<EGLint>
+GLStateEGL::context_attribs(Options::ContextPriority priority)
+{
+    std::vector<EGLint> attribs;
+
+#ifdef GLMARK2_USE_GLESv2
+    attribs.push_back(EGL_CONTEXT_CLIENT_VERSION);
+    attribs.push_back(2);
+#endif
+
+    if (priority != Options::ContextPriorityDefault) {
+        const char *extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+        if (extensions && strstr(extensions, "EGL_IMG_context_priority")) {
+            attribs.push_back(EGL_CONTEXT_PRIORITY_LEVEL_IMG);
+            attribs.push_back(context_priority_level(priority));
+        }
+        else {
+            static bool warned = false;
+            if (!warned) {
+                Log::info("Warning: Context priorities require EGL_IMG_context_priority,"
+                          " using the default priority\n");
+                warned = true;
+            }
+        }
+    }
+
+    attribs.push_back(EGL_NONE);
+
+    return attribs;
+}
+
+/*
+ * The priority is only a hint, and e.g. high priorities usually need
+ * privileges, so check which one the context actually got.
+ */
+void
+GLStateEGL::check_context_priority(EGLContext context, const std::vector<EGLint>& attribs)
+{
+    EGLint requested(0);
+    EGLint level(0);
+
+    for (size_t i = 0; i + 1 < attribs.size(); i += 2) {
+        if (attribs[i] == EGL_CONTEXT_PRIORITY_LEVEL_IMG)
+            requested = attribs[i + 1];
+    }
+
+    if (!requested || !eglQueryContext ||
+        !eglQueryContext(egl_display_, context, EGL_CONTEXT_PRIORITY_LEVEL_IMG, &level))
+    {
+        return;
+    }
+
+    if (level != requested) {
+        Log::info("Warning: The context got the %s priority instead of the %s one\n",
+                  context_priority_name(level), context_priority_name(requested));
+    }
+    else {
+        Log::debug("Created a context with the %s priority\n",
+                   context_priority_name(level));
+    }
+}
+
+GLWorkerContext*
+GLStateEGL::create_worker_context(bool shared, Options::ContextPriority priority)
+{
+    if (!gotValidContext())
+        return 0;
+
+    std::vector<EGLint> attribs(context_attribs(priority));
+    EGLContext context = eglCreateContext(egl_display_, egl_config_,
+                                          shared ? egl_context_ : EGL_NO_CONTEXT,
+                                          &attribs[0]);
+    if (!context) {
+        Log::error("eglCreateContext() failed with error: 0x%x\n",
+                   eglGetError());
+        return 0;
+    }
+
+    check_context_priority(context, attribs);
+
+    EGLSurface surface = EGL_NO_SURFACE;
+    const char *extensions = eglQueryString(egl_display_, EGL_EXTENSIONS);
+
+    if (!extensions || !strstr(extensions, "EGL_KHR_surfaceless_context")) {
+        static const EGLint pbuffer_attribs[] = {
+            EGL_WIDTH, 1,
+            EGL_HEIGHT, 1,
+            EGL_NONE
+        };
+
+        surface = eglCreatePbufferSurface(egl_display_, egl_config_, pbuffer_attribs);
+        if (!surface) {
+            Log::debug("Rendering from another context requires"
+                       " EGL_KHR_surfaceless_context or a pbuffer config\n");
+            eglDestroyContext(egl_display_, context);
+            return 0;
+        }
+    }
+
+    EGLenum api = eglQueryAPI ? eglQueryAPI() : EGL_OPENGL_ES_API;
+
+    return new GLWorkerContextEGL(egl_display_, context, surface, api);
+}
+
 GLADapiproc
 GLStateEGL::load_proc(void *userptr, const char* name)
 {
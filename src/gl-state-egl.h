@@ -23,6 +23,10 @@
 #define GLMARK2_GL_STATE_EGL_H_
 
 #include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include <glad/egl.h>
 #include "gl-state.h"
 #include "gl-visual-config.h"
@@ -115,8 +119,68 @@ public:
     EGLint configID() const { return configID_; }
 };
 
+/* EGL_ANDROID_get_frame_timestamps */
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLGETNEXTFRAMEIDANDROIDPROC)(EGLDisplay dpy, EGLSurface surface, EGLuint64KHR *frameId);
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLGETCOMPOSITORTIMINGANDROIDPROC)(EGLDisplay dpy, EGLSurface surface, EGLint numTimestamps, const EGLint *names, EGLnsecsANDROID *values);
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLGETFRAMETIMESTAMPSANDROIDPROC)(EGLDisplay dpy, EGLSurface surface, EGLuint64KHR frameId, EGLint numTimestamps, const EGLint *timestamps, EGLnsecsANDROID *values);
+
+/* EGL_KHR_fence_sync, EGL_KHR_wait_sync and EGL_ANDROID_native_fence_sync */
+typedef EGLSync (GLAD_API_PTR *PFNEGLCREATESYNCKHRPROC)(EGLDisplay dpy, EGLenum type, const EGLint *attrib_list);
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLDESTROYSYNCKHRPROC)(EGLDisplay dpy, EGLSync sync);
+typedef EGLint (GLAD_API_PTR *PFNEGLWAITSYNCKHRPROC)(EGLDisplay dpy, EGLSync sync, EGLint flags);
+typedef EGLint (GLAD_API_PTR *PFNEGLDUPNATIVEFENCEFDANDROIDPROC)(EGLDisplay dpy, EGLSync sync);
+
+/* EGL_KHR_swap_buffers_with_damage and EGL_EXT_swap_buffers_with_damage */
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)(EGLDisplay dpy, EGLSurface surface, const EGLint *rects, EGLint n_rects);
+/* EGL_KHR_partial_update */
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLSETDAMAGEREGIONKHRPROC)(EGLDisplay dpy, EGLSurface surface, EGLint *rects, EGLint n_rects);
+
+/* EGL_KHR_image_base and EGL_EXT_image_dma_buf_import */
+typedef EGLImageKHR (GLAD_API_PTR *PFNEGLCREATEIMAGEKHRPROC)(EGLDisplay dpy, EGLContext ctx, EGLenum target, EGLClientBuffer buffer, const EGLint *attrib_list);
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLDESTROYIMAGEKHRPROC)(EGLDisplay dpy, EGLImageKHR image);
+#ifndef EGL_LINUX_DMA_BUF_EXT
+#define EGL_LINUX_DMA_BUF_EXT 0x3270
+#define EGL_LINUX_DRM_FOURCC_EXT 0x3271
+#define EGL_DMA_BUF_PLANE0_FD_EXT 0x3272
+#define EGL_DMA_BUF_PLANE0_OFFSET_EXT 0x3273
+#define EGL_DMA_BUF_PLANE0_PITCH_EXT 0x3274
+#define EGL_DMA_BUF_PLANE1_FD_EXT 0x3275
+#define EGL_DMA_BUF_PLANE1_OFFSET_EXT 0x3276
+#define EGL_DMA_BUF_PLANE1_PITCH_EXT 0x3277
+#define EGL_DMA_BUF_PLANE2_FD_EXT 0x3278
+#define EGL_DMA_BUF_PLANE2_OFFSET_EXT 0x3279
+#define EGL_DMA_BUF_PLANE2_PITCH_EXT 0x327A
+#endif
+
+/* EGL_EXT_pixel_format_float */
+#ifndef EGL_COLOR_COMPONENT_TYPE_EXT
+#define EGL_COLOR_COMPONENT_TYPE_EXT 0x3339
+#define EGL_COLOR_COMPONENT_TYPE_FIXED_EXT 0x333A
+#define EGL_COLOR_COMPONENT_TYPE_FLOAT_EXT 0x333B
+#endif
+
+/* EGL_IMG_context_priority */
+#ifndef EGL_CONTEXT_PRIORITY_LEVEL_IMG
+#define EGL_CONTEXT_PRIORITY_LEVEL_IMG 0x3100
+#define EGL_CONTEXT_PRIORITY_HIGH_IMG 0x3101
+#define EGL_CONTEXT_PRIORITY_MEDIUM_IMG 0x3102
+#define EGL_CONTEXT_PRIORITY_LOW_IMG 0x3103
+#endif
+
+/* EGL_KHR_mutable_render_buffer */
+#ifndef EGL_MUTABLE_RENDER_BUFFER_BIT_KHR
+#define EGL_MUTABLE_RENDER_BUFFER_BIT_KHR 0x1000
+#endif
+
 class GLStateEGL : public GLState
 {
+    // A swapped frame whose present time is not known yet
+    struct PendingFrame
+    {
+        EGLuint64KHR id;
+        uint64_t submit_time;
+    };
+
     EGLNativeDisplayType native_display_;
     EGLNativeWindowType native_window_;
     EGLDisplay egl_display_;
@@ -127,12 +191,51 @@ class GLStateEGL : public GLState
     EglConfig best_config_;
     SharedLibrary egl_lib_;
     SharedLibrary gl_lib_;
+    // Presentation feedback with --present-timing
+    PFNEGLGETNEXTFRAMEIDANDROIDPROC get_next_frame_id_;
+    PFNEGLGETFRAMETIMESTAMPSANDROIDPROC get_frame_timestamps_;
+    uint64_t refresh_;
+    std::deque<PendingFrame> pending_frames_;
+    PresentationList presentations_;
+    // Native fences for explicit synchronization with the display
+    PFNEGLCREATESYNCKHRPROC create_sync_;
+    PFNEGLDESTROYSYNCKHRPROC destroy_sync_;
+    PFNEGLWAITSYNCKHRPROC wait_sync_;
+    PFNEGLDUPNATIVEFENCEFDANDROIDPROC dup_native_fence_fd_;
+    // Zero-copy import of dma-bufs
+    PFNEGLCREATEIMAGEKHRPROC create_image_;
+    PFNEGLDESTROYIMAGEKHRPROC destroy_image_;
+    // Partial updates
+    PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC swap_buffers_with_damage_;
+    PFNEGLSETDAMAGEREGIONKHRPROC set_damage_region_;
+    bool buffer_age_supported_;
+    // Front buffer rendering with --single-buffer
+    bool mutable_render_buffer_;
+    // The swap mode set by the swap interval
+    std::string swap_mode_;
+    // The contexts created, and those left to destroy, with --context-pool
+    std::thread pool_thread_;
+    std::mutex pool_mutex_;
+    std::condition_variable pool_cond_;
+    std::deque<EGLContext> context_pool_;
+    std::vector<EGLContext> retired_contexts_;
+    bool pool_quit_;
     bool gotValidDisplay();
     bool gotValidConfig();
     bool gotValidSurface();
     bool gotValidContext();
     void get_glvisualconfig(EGLConfig config, GLVisualConfig& visual_config);
     EGLConfig select_best_config(std::vector<EGLConfig>& configs);
+    void init_frame_timestamps();
+    void init_native_fences();
+    void init_dma_buf_import();
+    void init_partial_updates();
+    void init_single_buffer();
+    void collect_frame_timestamps();
+    std::vector<EGLint> context_attribs(Options::ContextPriority priority);
+    void check_context_priority(EGLContext context, const std::vector<EGLint>& attribs);
+    void run_context_pool(EGLenum api);
+    void stop_context_pool();
 
     static GLADapiproc load_proc(void *userptr, const char* name);
 
@@ -143,7 +246,21 @@ public:
         egl_display_(0),
         egl_config_(0),
         egl_context_(0),
-        egl_surface_(0) {}
+        egl_surface_(0),
+        get_next_frame_id_(0),
+        get_frame_timestamps_(0),
+        refresh_(0),
+        create_sync_(0),
+        destroy_sync_(0),
+        wait_sync_(0),
+        dup_native_fence_fd_(0),
+        create_image_(0),
+        destroy_image_(0),
+        swap_buffers_with_damage_(0),
+        set_damage_region_(0),
+        buffer_age_supported_(false),
+        mutable_render_buffer_(false),
+        pool_quit_(false) {}
     ~GLStateEGL();
 
     bool init_display(void* native_display, GLVisualConfig& config_pref);
@@ -152,9 +269,24 @@ public:
     bool valid();
     bool reset();
     void swap();
+    bool supports_native_fences() { return dup_native_fence_fd_ != 0; }
+    int swap_with_fence();
+    void wait_native_fence(int fence_fd);
+    int create_native_fence();
+    void* create_dma_buf_image(const DmaBufImage& image);
+    void destroy_dma_buf_image(void* image);
+    unsigned int buffer_age();
+    void swap_with_damage(const std::vector<int>& rects);
+    void set_damage_region(const std::vector<int>& rects);
     // Performs a config search, returning a native visual ID on success
     bool gotNativeConfig(intptr_t& vid);
     void getVisualConfig(GLVisualConfig& vc);
+    GLWorkerContext* create_worker_context(bool shared,
+                                           Options::ContextPriority priority =
+                                               Options::ContextPriorityDefault);
+    void take_presentations(PresentationList& list);
+    std::string swap_mode() { return swap_mode_; }
+    std::string platform_version();
 };
 
 #endif // GLMARK2_GL_STATE_EGL_H_
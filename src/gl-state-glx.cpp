@@ -23,6 +23,10 @@
 #include "gl-state-glx.h"
 #include "log.h"
 #include "options.h"
+#include "call-profiler.h"
+#include "flush-points.h"
+#include "call-recorder.h"
+#include "startup-report.h"
 
 #include <climits>
 
@@ -36,6 +40,8 @@ GLStateGLX::init_display(void* native_display, GLVisualConfig& visual_config)
     xdpy_ = reinterpret_cast<Display*>(native_display);
     requested_visual_config_ = visual_config;
 
+    StartupReport::Phase phase("glx-library");
+
     if (!lib_.open_from_alternatives({"libGL.so", "libGL.so.1"})) {
         Log::error("Failed to load libGL\n");
         return false;
@@ -73,6 +79,12 @@ GLStateGLX::init_gl_extensions()
 
     GLExtensions::GenerateMipmap = glGenerateMipmapEXT;
 
+    GLExtensions::load_optional(load_proc, this);
+    CallRecorder::install(!Options::record.empty());
+    CallProfiler::install(Options::profile_gl_calls);
+    StateTracker::install(Options::state_tracking);
+    FlushPoints::install(Options::flush_points);
+
     return true;
 }
 
@@ -95,30 +107,60 @@ GLStateGLX::valid()
         return false;
     }
 
-    if (gladLoadGLUserPtr(load_proc, this) == 0) {
-        Log::error("Failed to load GL entry points\n");
-        return false;
+    {
+        StartupReport::Phase phase("gl-entry-points");
+
+        if (gladLoadGLUserPtr(load_proc, this) == 0) {
+            Log::error("Failed to load GL entry points\n");
+            return false;
+        }
+
+        if (!init_gl_extensions())
+            return false;
     }
 
-    if (!init_gl_extensions())
-        return false;
+    /* A negative interval makes late swaps tear instead of waiting */
+    int desired_swap(0);
+    if (Options::swap_mode == Options::SwapModeFIFO) {
+        desired_swap = 1;
+    }
+    else if (Options::swap_mode == Options::SwapModeRelaxed) {
+        desired_swap = swap_control_tear_ ? -1 : 1;
+        if (!swap_control_tear_) {
+            Log::info("Warning: GLX_EXT_swap_control_tear not supported, using"
+                      " the 'fifo' swap mode instead of 'relaxed'\n");
+        }
+    }
+    else if (Options::swap_mode == Options::SwapModeMailbox) {
+        Log::info("Warning: GLX doesn't support the 'mailbox' swap mode, using"
+                  " 'immediate'\n");
+    }
 
-    unsigned int desired_swap(Options::swap_mode == Options::SwapModeFIFO ? 1 : 0);
+    static const char* const interval_modes[] = { "relaxed", "immediate", "fifo" };
+    unsigned int abs_swap(desired_swap < 0 ? -desired_swap : desired_swap);
     unsigned int actual_swap(-1);
     if (glXSwapIntervalEXT) {
+        unsigned int late_swaps_tear(0);
         glXSwapIntervalEXT(xdpy_, xwin_, desired_swap);
         glXQueryDrawable(xdpy_, xwin_, GLX_SWAP_INTERVAL_EXT, &actual_swap);
-        if (actual_swap == desired_swap)
+        if (swap_control_tear_)
+            glXQueryDrawable(xdpy_, xwin_, GLX_LATE_SWAPS_TEAR_EXT, &late_swaps_tear);
+        if (actual_swap == abs_swap && (late_swaps_tear != 0) == (desired_swap < 0)) {
+            swap_mode_ = interval_modes[desired_swap + 1];
             return true;
+        }
     }
 
-    if (glXSwapIntervalMESA) {
+    if (glXSwapIntervalMESA && desired_swap >= 0) {
         glXSwapIntervalMESA(desired_swap);
         actual_swap = glXGetSwapIntervalMESA();
-        if (actual_swap == desired_swap)
+        if (actual_swap == abs_swap) {
+            swap_mode_ = interval_modes[desired_swap + 1];
             return true;
+        }
     }
 
+    swap_mode_.clear();
     Log::info("** Failed to set swap interval. Results may be bounded above by refresh rate.\n");
 
     return true;
@@ -210,6 +252,9 @@ GLStateGLX::init_extensions()
     if (!glXSwapIntervalEXT && !glXSwapIntervalMESA) {
         Log::info("** GLX does not support GLX_EXT_swap_control or GLX_MESA_swap_control!\n");
     }
+
+    swap_control_tear_ = glXSwapIntervalEXT &&
+                         extString.find("GLX_EXT_swap_control_tear") != std::string::npos;
 }
 
 bool
@@ -235,6 +280,8 @@ GLStateGLX::ensure_glx_fbconfig()
     if (glx_fbconfig_)
         return true;
 
+    StartupReport::Phase phase("glx-config");
+
     if (!check_glx_version())
         return false;
 
@@ -287,6 +334,8 @@ GLStateGLX::ensure_glx_context()
     if (glx_context_)
         return true;
 
+    StartupReport::Phase phase("glx-context");
+
     if (!ensure_glx_fbconfig())
         return false;
 
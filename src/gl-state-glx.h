@@ -32,11 +32,16 @@
 
 #include <glad/glx.h>
 
+#ifndef GLX_LATE_SWAPS_TEAR_EXT
+#define GLX_LATE_SWAPS_TEAR_EXT 0x20F3
+#endif
+
 class GLStateGLX : public GLState
 {
 public:
     GLStateGLX()
-        : xdpy_(0), xwin_(0), glx_fbconfig_(0), glx_context_(0) {}
+        : xdpy_(0), xwin_(0), glx_fbconfig_(0), glx_context_(0),
+          swap_control_tear_(false) {}
 
     bool valid();
     bool init_display(void* native_display, GLVisualConfig& config_pref);
@@ -46,6 +51,7 @@ public:
     void swap();
     bool gotNativeConfig(intptr_t& vid);
     void getVisualConfig(GLVisualConfig& vc);
+    std::string swap_mode() { return swap_mode_; }
 
 private:
     bool check_glx_version();
@@ -63,6 +69,9 @@ private:
     GLXContext glx_context_;
     GLVisualConfig requested_visual_config_;
     SharedLibrary lib_;
+    /* GLX_EXT_swap_control_tear, for the 'relaxed' swap mode */
+    bool swap_control_tear_;
+    std::string swap_mode_;
 };
 
 #endif /* GLMARK2_GL_STATE_GLX_H_ */
@@ -25,15 +25,75 @@
 #include "gl-headers.h"
 #include "log.h"
 #include "options.h"
+#include "call-profiler.h"
+#include "flush-points.h"
+#include "call-recorder.h"
+#include "util.h"
+
+#include <d3d11.h>
+#include <dxgi1_3.h>
+#include <dwmapi.h>
+#include <cstring>
+
+/* WGL_NV_DX_interop(2), which glad doesn't load */
+#define WGL_ACCESS_WRITE_DISCARD_NV 0x0002
+
+typedef HANDLE (WINAPI *PFNWGLDXOPENDEVICENVPROC)(void *dxDevice);
+typedef BOOL (WINAPI *PFNWGLDXCLOSEDEVICENVPROC)(HANDLE hDevice);
+typedef HANDLE (WINAPI *PFNWGLDXREGISTEROBJECTNVPROC)(HANDLE hDevice, void *dxObject,
+                                                      GLuint name, GLenum type,
+                                                      GLenum access);
+typedef BOOL (WINAPI *PFNWGLDXUNREGISTEROBJECTNVPROC)(HANDLE hDevice, HANDLE hObject);
+typedef BOOL (WINAPI *PFNWGLDXLOCKOBJECTSNVPROC)(HANDLE hDevice, GLint count,
+                                                 HANDLE *hObjects);
+typedef BOOL (WINAPI *PFNWGLDXUNLOCKOBJECTSNVPROC)(HANDLE hDevice, GLint count,
+                                                   HANDLE *hObjects);
+
+namespace
+{
+
+PFNWGLDXOPENDEVICENVPROC DXOpenDeviceNV = nullptr;
+PFNWGLDXCLOSEDEVICENVPROC DXCloseDeviceNV = nullptr;
+PFNWGLDXREGISTEROBJECTNVPROC DXRegisterObjectNV = nullptr;
+PFNWGLDXUNREGISTEROBJECTNVPROC DXUnregisterObjectNV = nullptr;
+PFNWGLDXLOCKOBJECTSNVPROC DXLockObjectsNV = nullptr;
+PFNWGLDXUNLOCKOBJECTSNVPROC DXUnlockObjectsNV = nullptr;
+
+/* The number of presents waiting for their statistics that are kept */
+const size_t max_pending_presents = 16;
+
+template<typename T> void
+release_com(T*& object)
+{
+    if (object) {
+        object->Release();
+        object = nullptr;
+    }
+}
+
+}
 
 /******************
  * Public methods *
  ******************/
 
-GLStateWGL::GLStateWGL() : hdc_(nullptr), wgl_context_(nullptr), get_proc_addr_(nullptr) {}
+GLStateWGL::GLStateWGL() :
+    hdc_(nullptr), wgl_context_(nullptr), get_proc_addr_(nullptr), hwnd_(nullptr),
+    d3d_device_(nullptr), d3d_context_(nullptr), swap_chain_(nullptr),
+    swap_chain_media_(nullptr), interop_texture_(nullptr), interop_device_(nullptr),
+    interop_object_(nullptr), interop_fbo_(0), interop_renderbuffer_(0),
+    width_(0), height_(0), sync_interval_(0), qpc_frequency_(0),
+    last_present_count_(0), last_present_qpc_(0)
+{
+    LARGE_INTEGER frequency;
+    if (QueryPerformanceFrequency(&frequency))
+        qpc_frequency_ = frequency.QuadPart;
+}
 
 GLStateWGL::~GLStateWGL()
 {
+    release_flip_model();
+
     if (wgl_context_) {
         wglDeleteContext(wgl_context_);
         wgl_context_ = nullptr;
@@ -104,8 +164,9 @@ GLStateWGL::init_display(void* native_display, GLVisualConfig& /*visual_config*/
 }
 
 bool
-GLStateWGL::init_surface(void* /*native_window*/)
+GLStateWGL::init_surface(void* native_window)
 {
+    hwnd_ = reinterpret_cast<HWND>(native_window);
     return true;
 }
 
@@ -129,15 +190,66 @@ GLStateWGL::init_gl_extensions()
 
     GLExtensions::GenerateMipmap = glGenerateMipmapEXT;
 
+    GLExtensions::load_optional(load_proc, this);
+    CallRecorder::install(!Options::record.empty());
+    CallProfiler::install(Options::profile_gl_calls);
+    StateTracker::install(Options::state_tracking);
+    FlushPoints::install(Options::flush_points);
+
     return true;
 }
 
 bool
 GLStateWGL::valid()
 {
-    if (!wglSwapIntervalEXT || wglSwapIntervalEXT(0) == FALSE) {
+    /* A negative interval makes late swaps tear (WGL_EXT_swap_control_tear) */
+    const char* exts = wglGetExtensionsStringEXT ? wglGetExtensionsStringEXT() : nullptr;
+    bool swap_control_tear = exts && strstr(exts, "WGL_EXT_swap_control_tear");
+    int interval = 0;
+
+    if (Options::win32_flip_model && !swap_chain_ && init_flip_model()) {
+        /*
+         * A flip-model swapchain never tears without
+         * DXGI_PRESENT_ALLOW_TEARING, so an interval of 0 replaces the
+         * queued frame at each vblank.
+         */
+        if (Options::swap_mode == Options::SwapModeRelaxed) {
+            Log::info("Warning: the DXGI flip model doesn't support the 'relaxed'"
+                      " swap mode, using 'fifo'\n");
+        }
+        else if (Options::swap_mode == Options::SwapModeImmediate) {
+            Log::info("Warning: the DXGI flip model doesn't support the 'immediate'"
+                      " swap mode, using 'mailbox'\n");
+        }
+
+        sync_interval_ = Options::swap_mode == Options::SwapModeImmediate ||
+                         Options::swap_mode == Options::SwapModeMailbox ? 0 : 1;
+        swap_mode_ = sync_interval_ ? "fifo" : "mailbox";
+        return true;
+    }
+
+    if (Options::swap_mode == Options::SwapModeFIFO) {
+        interval = 1;
+    }
+    else if (Options::swap_mode == Options::SwapModeRelaxed) {
+        interval = swap_control_tear ? -1 : 1;
+        if (!swap_control_tear) {
+            Log::info("Warning: WGL_EXT_swap_control_tear not supported, using"
+                      " the 'fifo' swap mode instead of 'relaxed'\n");
+        }
+    }
+    else if (Options::swap_mode == Options::SwapModeMailbox) {
+        Log::info("Warning: WGL doesn't support the 'mailbox' swap mode, using"
+                  " 'immediate'\n");
+    }
+
+    if (!wglSwapIntervalEXT || wglSwapIntervalEXT(interval) == FALSE) {
+        swap_mode_.clear();
         Log::info("** Failed to set swap interval. Results may be bounded above by refresh rate.\n");
     }
+    else {
+        swap_mode_ = interval < 0 ? "relaxed" : interval > 0 ? "fifo" : "immediate";
+    }
 
     return wgl_context_ != nullptr;
 }
@@ -152,9 +264,32 @@ GLStateWGL::reset()
 void
 GLStateWGL::swap()
 {
+    if (swap_chain_) {
+        swap_flip_model();
+        return;
+    }
+
+    uint64_t submit_time = Util::get_timestamp_us();
+
     if (SwapBuffers(hdc_) == FALSE) {
         Log::error("Error during SwapBuffers\n");
     }
+
+    if (Options::present_timing) {
+        PendingPresent pending = { 0, submit_time };
+        pending_presents_.push_back(pending);
+        if (pending_presents_.size() > max_pending_presents)
+            pending_presents_.pop_front();
+
+        collect_dwm_statistics();
+    }
+}
+
+void
+GLStateWGL::take_presentations(PresentationList& list)
+{
+    list.insert(list.end(), presentations_.begin(), presentations_.end());
+    presentations_.clear();
 }
 
 bool
@@ -180,6 +315,338 @@ GLStateWGL::getVisualConfig(GLVisualConfig& vc)
  * Private methods *
  *******************/
 
+/*
+ * Creates a DXGI flip-model swapchain for the window, and a Direct3D 11
+ * texture shared with GL through WGL_NV_DX_interop2, which each frame is
+ * blitted to before being copied to the back buffer of the swapchain.
+ */
+bool
+GLStateWGL::init_flip_model()
+{
+    const char* exts = wglGetExtensionsStringEXT ? wglGetExtensionsStringEXT() : nullptr;
+
+    if (!exts || !strstr(exts, "WGL_NV_DX_interop2") || !GLExtensions::BlitFramebuffer) {
+        Log::info("Warning: WGL_NV_DX_interop2 not supported, presenting with"
+                  " SwapBuffers()\n");
+        return false;
+    }
+
+    DXOpenDeviceNV = reinterpret_cast<PFNWGLDXOPENDEVICENVPROC>(load_proc(this, "wglDXOpenDeviceNV"));
+    DXCloseDeviceNV = reinterpret_cast<PFNWGLDXCLOSEDEVICENVPROC>(load_proc(this, "wglDXCloseDeviceNV"));
+    DXRegisterObjectNV = reinterpret_cast<PFNWGLDXREGISTEROBJECTNVPROC>(load_proc(this, "wglDXRegisterObjectNV"));
+    DXUnregisterObjectNV = reinterpret_cast<PFNWGLDXUNREGISTEROBJECTNVPROC>(load_proc(this, "wglDXUnregisterObjectNV"));
+    DXLockObjectsNV = reinterpret_cast<PFNWGLDXLOCKOBJECTSNVPROC>(load_proc(this, "wglDXLockObjectsNV"));
+    DXUnlockObjectsNV = reinterpret_cast<PFNWGLDXUNLOCKOBJECTSNVPROC>(load_proc(this, "wglDXUnlockObjectsNV"));
+
+    if (!DXOpenDeviceNV || !DXCloseDeviceNV || !DXRegisterObjectNV ||
+        !DXUnregisterObjectNV || !DXLockObjectsNV || !DXUnlockObjectsNV)
+    {
+        Log::info("Warning: Failed to load the WGL_NV_DX_interop2 functions,"
+                  " presenting with SwapBuffers()\n");
+        return false;
+    }
+
+    RECT rect;
+    if (!hwnd_ || !GetClientRect(hwnd_, &rect)) {
+        Log::error("Failed to get the size of the window\n");
+        return false;
+    }
+    width_ = rect.right - rect.left;
+    height_ = rect.bottom - rect.top;
+
+    if (FAILED(D3D11CreateDevice(nullptr, D3D_DRIVER_TYPE_HARDWARE, nullptr, 0,
+                                 nullptr, 0, D3D11_SDK_VERSION, &d3d_device_,
+                                 nullptr, &d3d_context_)))
+    {
+        Log::error("Failed to create a Direct3D 11 device\n");
+        release_flip_model();
+        return false;
+    }
+
+    /* The swapchain must come from the factory of the device's adapter */
+    IDXGIDevice* dxgi_device = nullptr;
+    IDXGIAdapter* adapter = nullptr;
+    IDXGIFactory2* factory = nullptr;
+
+    if (SUCCEEDED(d3d_device_->QueryInterface(__uuidof(IDXGIDevice),
+                                              reinterpret_cast<void**>(&dxgi_device))) &&
+        SUCCEEDED(dxgi_device->GetAdapter(&adapter)))
+    {
+        adapter->GetParent(__uuidof(IDXGIFactory2), reinterpret_cast<void**>(&factory));
+    }
+
+    release_com(adapter);
+    release_com(dxgi_device);
+
+    if (!factory) {
+        Log::error("Failed to get the DXGI factory of the device\n");
+        release_flip_model();
+        return false;
+    }
+
+    DXGI_SWAP_CHAIN_DESC1 desc = {};
+    desc.Width = width_;
+    desc.Height = height_;
+    desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+    desc.BufferCount = 2;
+    desc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+    desc.AlphaMode = DXGI_ALPHA_MODE_IGNORE;
+
+    HRESULT hr = factory->CreateSwapChainForHwnd(d3d_device_, hwnd_, &desc, nullptr,
+                                                 nullptr, &swap_chain_);
+    release_com(factory);
+
+    if (FAILED(hr)) {
+        Log::error("Failed to create a flip-model swapchain (0x%lx)\n",
+                   static_cast<unsigned long>(hr));
+        release_flip_model();
+        return false;
+    }
+
+    /* Only needed for the composition mode of the frames */
+    if (FAILED(swap_chain_->QueryInterface(__uuidof(IDXGISwapChainMedia),
+                                           reinterpret_cast<void**>(&swap_chain_media_))))
+    {
+        swap_chain_media_ = nullptr;
+    }
+
+    D3D11_TEXTURE2D_DESC texture_desc = {};
+    texture_desc.Width = width_;
+    texture_desc.Height = height_;
+    texture_desc.MipLevels = 1;
+    texture_desc.ArraySize = 1;
+    texture_desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+    texture_desc.SampleDesc.Count = 1;
+    texture_desc.Usage = D3D11_USAGE_DEFAULT;
+    texture_desc.BindFlags = D3D11_BIND_RENDER_TARGET | D3D11_BIND_SHADER_RESOURCE;
+
+    if (FAILED(d3d_device_->CreateTexture2D(&texture_desc, nullptr, &interop_texture_))) {
+        Log::error("Failed to create the Direct3D 11 texture shared with GL\n");
+        release_flip_model();
+        return false;
+    }
+
+    interop_device_ = DXOpenDeviceNV(d3d_device_);
+    if (!interop_device_) {
+        Log::error("Error during wglDXOpenDeviceNV\n");
+        release_flip_model();
+        return false;
+    }
+
+    GLExtensions::GenRenderbuffers(1, &interop_renderbuffer_);
+    interop_object_ = DXRegisterObjectNV(interop_device_, interop_texture_,
+                                         interop_renderbuffer_, GL_RENDERBUFFER,
+                                         WGL_ACCESS_WRITE_DISCARD_NV);
+    if (!interop_object_) {
+        Log::error("Error during wglDXRegisterObjectNV\n");
+        release_flip_model();
+        return false;
+    }
+
+    GLExtensions::GenFramebuffers(1, &interop_fbo_);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, interop_fbo_);
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          GL_RENDERBUFFER, interop_renderbuffer_);
+    GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::error("The framebuffer of the shared texture is incomplete (0x%x)\n",
+                   status);
+        release_flip_model();
+        return false;
+    }
+
+    return true;
+}
+
+void
+GLStateWGL::release_flip_model()
+{
+    if (interop_object_) {
+        DXUnregisterObjectNV(interop_device_, interop_object_);
+        interop_object_ = nullptr;
+    }
+
+    if (interop_device_) {
+        DXCloseDeviceNV(interop_device_);
+        interop_device_ = nullptr;
+    }
+
+    if (interop_fbo_) {
+        GLExtensions::DeleteFramebuffers(1, &interop_fbo_);
+        interop_fbo_ = 0;
+    }
+
+    if (interop_renderbuffer_) {
+        GLExtensions::DeleteRenderbuffers(1, &interop_renderbuffer_);
+        interop_renderbuffer_ = 0;
+    }
+
+    release_com(interop_texture_);
+    release_com(swap_chain_media_);
+    release_com(swap_chain_);
+    release_com(d3d_context_);
+    release_com(d3d_device_);
+}
+
+void
+GLStateWGL::swap_flip_model()
+{
+    /* The origin of D3D textures is at the top left */
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    if (scissor)
+        glDisable(GL_SCISSOR_TEST);
+
+    DXLockObjectsNV(interop_device_, 1, &interop_object_);
+    GLExtensions::BindFramebuffer(GL_DRAW_FRAMEBUFFER, interop_fbo_);
+    GLExtensions::BlitFramebuffer(0, 0, width_, height_, 0, height_, width_, 0,
+                                  GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, 0);
+    DXUnlockObjectsNV(interop_device_, 1, &interop_object_);
+
+    if (scissor)
+        glEnable(GL_SCISSOR_TEST);
+
+    ID3D11Texture2D* back_buffer = nullptr;
+    if (SUCCEEDED(swap_chain_->GetBuffer(0, __uuidof(ID3D11Texture2D),
+                                         reinterpret_cast<void**>(&back_buffer))))
+    {
+        d3d_context_->CopyResource(back_buffer, interop_texture_);
+        release_com(back_buffer);
+    }
+
+    uint64_t submit_time = Util::get_timestamp_us();
+
+    HRESULT hr = swap_chain_->Present(sync_interval_, 0);
+    if (FAILED(hr)) {
+        Log::error("Error during IDXGISwapChain::Present (0x%lx)\n",
+                   static_cast<unsigned long>(hr));
+        return;
+    }
+
+    if (Options::present_timing) {
+        UINT id = 0;
+        if (SUCCEEDED(swap_chain_->GetLastPresentCount(&id))) {
+            PendingPresent pending = { id, submit_time };
+            pending_presents_.push_back(pending);
+            if (pending_presents_.size() > max_pending_presents)
+                pending_presents_.pop_front();
+        }
+
+        collect_flip_model_statistics();
+    }
+}
+
+/* Converts a QueryPerformanceCounter() time to Util::get_timestamp_us() */
+uint64_t
+GLStateWGL::qpc_to_us(uint64_t qpc)
+{
+    LARGE_INTEGER now_qpc;
+    QueryPerformanceCounter(&now_qpc);
+    uint64_t now_us = Util::get_timestamp_us();
+
+    if (!qpc_frequency_)
+        return 0;
+
+    int64_t delta = static_cast<int64_t>(now_qpc.QuadPart) - static_cast<int64_t>(qpc);
+    return now_us - delta * 1000000 / static_cast<int64_t>(qpc_frequency_);
+}
+
+/*
+ * Gets the statistics of the latest present of the swapchain, which only
+ * change once it has been shown, as the frames presented in between
+ * aren't reported.
+ */
+void
+GLStateWGL::collect_flip_model_statistics()
+{
+    DXGI_FRAME_STATISTICS_MEDIA stats = {};
+    Presentation::Mode mode = Presentation::ModeUnknown;
+
+    if (swap_chain_media_ &&
+        SUCCEEDED(swap_chain_media_->GetFrameStatisticsMedia(&stats)))
+    {
+        mode = stats.CompositionMode == DXGI_FRAME_PRESENTATION_MODE_COMPOSED ?
+               Presentation::ModeCopy : Presentation::ModeFlip;
+    }
+    else if (FAILED(swap_chain_->GetFrameStatistics(
+                        reinterpret_cast<DXGI_FRAME_STATISTICS*>(&stats))))
+    {
+        /* Also while the statistics are disjoint, e.g. after a mode change */
+        return;
+    }
+
+    if (stats.PresentCount == 0 || stats.PresentCount == last_present_count_)
+        return;
+    last_present_count_ = stats.PresentCount;
+
+    /* Drops the frames that were replaced before being shown */
+    while (!pending_presents_.empty() &&
+           static_cast<int>(pending_presents_.front().id - stats.PresentCount) < 0)
+    {
+        pending_presents_.pop_front();
+    }
+
+    DWM_TIMING_INFO info = {};
+    info.cbSize = sizeof(info);
+    uint64_t refresh = 0;
+    if (SUCCEEDED(DwmGetCompositionTimingInfo(nullptr, &info)) && qpc_frequency_)
+        refresh = info.qpcRefreshPeriod * 1000000 / qpc_frequency_;
+
+    Presentation presentation;
+    presentation.present_time = qpc_to_us(stats.SyncQPCTime.QuadPart);
+    presentation.sequence = stats.SyncRefreshCount;
+    presentation.refresh = refresh;
+    presentation.mode = mode;
+
+    if (!pending_presents_.empty() &&
+        pending_presents_.front().id == stats.PresentCount)
+    {
+        presentation.submit_time = pending_presents_.front().submit_time;
+        pending_presents_.pop_front();
+    }
+
+    presentations_.push_back(presentation);
+}
+
+/*
+ * Gets the latest composition of DWM, which shows the frames swapped
+ * with SwapBuffers() by copying them.
+ */
+void
+GLStateWGL::collect_dwm_statistics()
+{
+    DWM_TIMING_INFO info = {};
+    info.cbSize = sizeof(info);
+
+    if (FAILED(DwmGetCompositionTimingInfo(nullptr, &info)) || !qpc_frequency_)
+        return;
+
+    if (info.qpcVBlank == last_present_qpc_)
+        return;
+    last_present_qpc_ = info.qpcVBlank;
+
+    Presentation presentation;
+    presentation.present_time = qpc_to_us(info.qpcVBlank);
+    presentation.sequence = info.cRefresh;
+    presentation.refresh = info.qpcRefreshPeriod * 1000000 / qpc_frequency_;
+    presentation.mode = Presentation::ModeCopy;
+
+    /* The latest frame swapped before the vblank */
+    while (!pending_presents_.empty() &&
+           pending_presents_.front().submit_time <= presentation.present_time)
+    {
+        presentation.submit_time = pending_presents_.front().submit_time;
+        pending_presents_.pop_front();
+    }
+
+    if (presentation.submit_time)
+        presentations_.push_back(presentation);
+}
+
 GLStateWGL::api_proc GLStateWGL::load_proc(void *userptr, const char *name)
 {
     GLStateWGL* state = reinterpret_cast<GLStateWGL*>(userptr);
@@ -25,6 +25,13 @@
 #include "gl-state.h"
 #include "shared-library.h"
 #include <windows.h>
+#include <deque>
+
+struct ID3D11Device;
+struct ID3D11DeviceContext;
+struct ID3D11Texture2D;
+struct IDXGISwapChain1;
+struct IDXGISwapChainMedia;
 
 class GLStateWGL : public GLState
 {
@@ -40,15 +47,53 @@ public:
     void swap();
     bool gotNativeConfig(intptr_t& vid);
     void getVisualConfig(GLVisualConfig& vc);
+    std::string swap_mode() { return swap_mode_; }
+    void take_presentations(PresentationList& list);
 
 private:
     using api_proc = void (*)();
     static api_proc load_proc(void *userptr, const char *name);
 
+    bool init_flip_model();
+    void release_flip_model();
+    void swap_flip_model();
+    uint64_t qpc_to_us(uint64_t qpc);
+    void collect_flip_model_statistics();
+    void collect_dwm_statistics();
+
     SharedLibrary wgl_library_;
     HDC hdc_;
     HGLRC wgl_context_;
     void* get_proc_addr_;
+    std::string swap_mode_;
+    HWND hwnd_;
+
+    // The DXGI flip-model swapchain with --win32-flip-model, which gets
+    // each frame through a texture shared with WGL_NV_DX_interop2
+    ID3D11Device* d3d_device_;
+    ID3D11DeviceContext* d3d_context_;
+    IDXGISwapChain1* swap_chain_;
+    IDXGISwapChainMedia* swap_chain_media_;
+    ID3D11Texture2D* interop_texture_;
+    HANDLE interop_device_;
+    HANDLE interop_object_;
+    unsigned int interop_fbo_;
+    unsigned int interop_renderbuffer_;
+    int width_;
+    int height_;
+    unsigned int sync_interval_;
+
+    // Present timing with --present-timing
+    struct PendingPresent
+    {
+        unsigned int id;
+        uint64_t submit_time;
+    };
+    std::deque<PendingPresent> pending_presents_;
+    uint64_t qpc_frequency_;
+    unsigned int last_present_count_;
+    uint64_t last_present_qpc_;
+    PresentationList presentations_;
 };
 
 #endif // GLMARK2_GL_STATE_WGL_H_
@@ -23,9 +23,26 @@
 #define GLMARK2_GL_STATE_H_
 
 #include <stdint.h>
+#include <string>
+#include <vector>
+#include "dma-buf.h"
+#include "presentation.h"
+#include "options.h"
 
 class GLVisualConfig;
 
+// An extra GL context for rendering from another thread
+class GLWorkerContext
+{
+public:
+    virtual ~GLWorkerContext() {}
+
+    // Makes the context current in the calling thread
+    virtual bool make_current() = 0;
+    // Releases the context from the calling thread
+    virtual void release() = 0;
+};
+
 class GLState
 {
 public:
@@ -37,8 +54,53 @@ public:
     virtual bool valid() = 0;
     virtual bool reset() = 0;
     virtual void swap() = 0;
+    // Whether swap_with_fence() and wait_native_fence() are supported
+    virtual bool supports_native_fences() { return false; }
+    // Swaps the buffers, returning a native fence fd that signals once the
+    // frame has been rendered, or -1
+    virtual int swap_with_fence() { swap(); return -1; }
+    // Makes the GPU wait for a native fence fd before any further
+    // rendering, taking ownership of the fd
+    virtual void wait_native_fence(int /* fence_fd */) {}
+    // Creates a native fence fd that signals once the commands issued so
+    // far have completed, flushing them, or -1
+    virtual int create_native_fence() { return -1; }
+    // Imports a dma-buf image as an EGLImage for glEGLImageTargetTexture2DOES(),
+    // or returns 0 if dma-buf import is not supported
+    virtual void* create_dma_buf_image(const DmaBufImage& /* image */) { return 0; }
+    // Destroys an image created by create_dma_buf_image()
+    virtual void destroy_dma_buf_image(void* /* image */) {}
+    // The age of the back buffer in frames (EGL_EXT_buffer_age), or 0 if
+    // its contents are undefined
+    virtual unsigned int buffer_age() { return 0; }
+    // Swaps the buffers, telling the GL system that only the rectangles
+    // changed (EGL_KHR_swap_buffers_with_damage). The rectangles are
+    // x, y, width, height quadruplets, with (0, 0) at the lower left.
+    virtual void swap_with_damage(const std::vector<int>& /* rects */) { swap(); }
+    // Tells the GL system that the current frame only draws to the
+    // rectangles of the back buffer (EGL_KHR_partial_update), before
+    // any drawing. The rectangles are as for swap_with_damage().
+    virtual void set_damage_region(const std::vector<int>& /* rects */) {}
     virtual bool gotNativeConfig(intptr_t& vid) = 0;
     virtual void getVisualConfig(GLVisualConfig& vc) = 0;
+    // Moves the timings of the frames presented since the last call to the
+    // list, with --present-timing, if the GL system reports them.
+    virtual void take_presentations(PresentationList& /* list */) {}
+    // Creates a context for rendering from another thread, which shares its
+    // objects with the main context if shared is true, or returns 0 if
+    // the GL system doesn't support it.
+    virtual GLWorkerContext* create_worker_context(bool /* shared */,
+                                                   Options::ContextPriority /* priority */ =
+                                                       Options::ContextPriorityDefault)
+    {
+        return 0;
+    }
+    // The --swap-mode in effect after falling back to what the GL system
+    // supports, or an empty string if unknown
+    virtual std::string swap_mode() { return std::string(); }
+    // The vendor and version of the window system binding (e.g. EGL), or an
+    // empty string if unknown
+    virtual std::string platform_version() { return std::string(); }
 };
 
 #endif /* GLMARK2_GL_STATE_H_ */
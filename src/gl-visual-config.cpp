@@ -26,7 +26,8 @@
 #include <vector>
 
 GLVisualConfig::GLVisualConfig(const std::string &s) :
-    red(1), green(1), blue(1), alpha(1), depth(1), stencil(0), buffer(1)
+    red(1), green(1), blue(1), alpha(1), depth(1), stencil(0), buffer(1),
+    fp(0), srgb(0)
 {
     std::vector<std::string> elems;
 
@@ -54,6 +55,10 @@ GLVisualConfig::GLVisualConfig(const std::string &s) :
                 stencil = Util::fromString<int>(opt[1]);
             else if (opt[0] == "buf" || opt[0] == "buffer")
                 buffer = Util::fromString<int>(opt[1]);
+            else if (opt[0] == "fp" || opt[0] == "float")
+                fp = Util::fromString<int>(opt[1]);
+            else if (opt[0] == "srgb")
+                srgb = Util::fromString<int>(opt[1]);
         }
         else
             Log::info("Warning: ignoring invalid option string '%s' "
@@ -78,6 +83,8 @@ GLVisualConfig::match_score(const GLVisualConfig &target) const
     score += score_component(depth, target.depth, 1);
     score += score_component(stencil, target.stencil, 0);
     score += score_component(buffer, target.buffer, 1);
+    /* Fixed and floating point components are never interchangeable */
+    score += score_component(fp, target.fp, 0);
 
     return score;
 }
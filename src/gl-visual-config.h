@@ -31,9 +31,11 @@ class GLVisualConfig
 {
 public:
     GLVisualConfig():
-        red(1), green(1), blue(1), alpha(1), depth(1), stencil(0), buffer(1) {}
+        red(1), green(1), blue(1), alpha(1), depth(1), stencil(0), buffer(1),
+        fp(0), srgb(0) {}
     GLVisualConfig(int r, int g, int b, int a, int d, int s, int buf):
-        red(r), green(g), blue(b), alpha(a), depth(d), stencil(s), buffer(buf) {}
+        red(r), green(g), blue(b), alpha(a), depth(d), stencil(s), buffer(buf),
+        fp(0), srgb(0) {}
     GLVisualConfig(const std::string &s);
 
     /**
@@ -57,6 +59,10 @@ public:
     int depth;
     int stencil;
     int buffer;
+    /* Whether the color components are floating point (e.g. FP16) */
+    int fp;
+    /* Whether the color is encoded in the sRGB color space */
+    int srgb;
 
 private:
     int score_component(int component, int target, int scale) const;
@@ -0,0 +1,173 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "gpu-timer.h"
+#include "trace.h"
+#include "util.h"
+
+GPUTimer::GPUTimer() :
+    head_(0), pending_(0), active_(false), initialized_(false), last_us_(0)
+{
+}
+
+GPUTimer::~GPUTimer()
+{
+    /*
+     * The queries belong to a GL context which may already be gone,
+     * so they are only released explicitly through release().
+     */
+}
+
+bool
+GPUTimer::supported()
+{
+    return GLExtensions::GenQueries && GLExtensions::DeleteQueries &&
+           GLExtensions::BeginQuery && GLExtensions::EndQuery &&
+           GLExtensions::GetQueryObjectuiv && GLExtensions::GetQueryObjectui64v;
+}
+
+bool
+GPUTimer::init()
+{
+    release();
+    stats_.reset();
+    last_us_ = 0;
+    frame_times_.clear();
+
+    if (!supported())
+        return false;
+
+    GLExtensions::GenQueries(query_count, queries_);
+    head_ = 0;
+    pending_ = 0;
+    active_ = false;
+    initialized_ = true;
+
+#if GLMARK2_USE_GLESv2
+    /* Reading the disjoint state clears it */
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT, &disjoint);
+#endif
+
+    return true;
+}
+
+void
+GPUTimer::release()
+{
+    if (!initialized_)
+        return;
+
+    if (active_)
+        GLExtensions::EndQuery(GL_TIME_ELAPSED);
+
+    GLExtensions::DeleteQueries(query_count, queries_);
+    head_ = 0;
+    pending_ = 0;
+    active_ = false;
+    initialized_ = false;
+}
+
+void
+GPUTimer::begin(uint64_t frame)
+{
+    if (!initialized_ || active_)
+        return;
+
+    /* Skip measuring this frame rather than waiting for a free query */
+    if (pending_ == query_count)
+        collect(false);
+    if (pending_ == query_count)
+        return;
+
+    unsigned int index = (head_ + pending_) % query_count;
+
+    GLExtensions::BeginQuery(GL_TIME_ELAPSED, queries_[index]);
+    begin_times_[index] = Trace::active() ? Util::get_timestamp_us() : 0;
+    frames_[index] = frame;
+    active_ = true;
+}
+
+void
+GPUTimer::end()
+{
+    if (!active_)
+        return;
+
+    GLExtensions::EndQuery(GL_TIME_ELAPSED);
+    active_ = false;
+    pending_++;
+
+    collect(false);
+}
+
+void
+GPUTimer::collect(bool wait)
+{
+    if (!initialized_)
+        return;
+
+    while (pending_ > 0) {
+        GLuint query = queries_[head_];
+
+        if (!wait) {
+            GLuint available = 0;
+            GLExtensions::GetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE,
+                                            &available);
+            if (!available)
+                break;
+        }
+
+        GLuint64 elapsed_ns = 0;
+        GLExtensions::GetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+
+#if GLMARK2_USE_GLESv2
+        /*
+         * A disjoint event (e.g. a frequency change) makes the results of
+         * all queries that were active while it happened meaningless.
+         */
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT, &disjoint);
+        if (!disjoint)
+            add_result(elapsed_ns / 1000);
+#else
+        add_result(elapsed_ns / 1000);
+#endif
+
+        head_ = (head_ + 1) % query_count;
+        pending_--;
+    }
+}
+
+void
+GPUTimer::take_frame_times(FrameTimes &list)
+{
+    list.insert(list.end(), frame_times_.begin(), frame_times_.end());
+    frame_times_.clear();
+}
+
+void
+GPUTimer::add_result(uint64_t time_us)
+{
+    stats_.add(time_us);
+    Trace::gpu_frame(begin_times_[head_], time_us);
+    last_us_ = time_us;
+
+    if (frames_[head_] > 0)
+        frame_times_.push_back(std::make_pair(frames_[head_], time_us));
+}
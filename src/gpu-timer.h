@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_GPU_TIMER_H_
+#define GLMARK2_GPU_TIMER_H_
+
+#include "gl-headers.h"
+#include "frame-stats.h"
+
+#include <utility>
+#include <vector>
+
+/**
+ * Measures the GPU time spent on rendering using timer queries.
+ *
+ * A small ring of GL_TIME_ELAPSED queries is used so that results can be
+ * collected a few frames later without stalling the pipeline. If all the
+ * queries in the ring are still pending, the frame is not measured.
+ */
+class GPUTimer
+{
+public:
+    GPUTimer();
+    ~GPUTimer();
+
+    /**
+     * Whether the current context supports timer queries.
+     */
+    static bool supported();
+
+    /**
+     * Creates the queries. Must be called with a current context.
+     *
+     * @return whether initialization succeeded
+     */
+    bool init();
+
+    /**
+     * Releases the queries. Must be called while the context that was
+     * current during init() is still alive.
+     */
+    void release();
+
+    /**
+     * The GPU times of numbered frames, in microseconds.
+     */
+    typedef std::vector<std::pair<uint64_t, uint64_t> > FrameTimes;
+
+    /**
+     * Starts measuring a frame.
+     *
+     * @param frame a number for the frame, to get its GPU time back from
+     *        take_frame_times(), or 0
+     */
+    void begin(uint64_t frame = 0);
+
+    /**
+     * Stops measuring a frame and collects any available results.
+     */
+    void end();
+
+    /**
+     * Collects the results of all pending queries.
+     *
+     * @param wait whether to wait for results that are not available yet
+     */
+    void collect(bool wait);
+
+    /**
+     * Gets the statistics of the measured frames.
+     */
+    const FrameStats &stats() const { return stats_; }
+
+    /**
+     * Gets the GPU time of the most recently collected frame, in
+     * microseconds, or 0 if none has been collected yet.
+     */
+    uint64_t last_us() const { return last_us_; }
+
+    /**
+     * Moves the GPU times of the numbered frames collected since the last
+     * call to a list.
+     */
+    void take_frame_times(FrameTimes &list);
+
+private:
+    static const unsigned int query_count = 8;
+
+    void add_result(uint64_t time_us);
+
+    GLuint queries_[query_count];
+    /* When each query began, for --trace */
+    uint64_t begin_times_[query_count];
+    /* The number given to begin() for each query */
+    uint64_t frames_[query_count];
+    /* Ring of pending queries: [head_, head_ + pending_) */
+    unsigned int head_;
+    unsigned int pending_;
+    bool active_;
+    bool initialized_;
+    FrameStats stats_;
+    uint64_t last_us_;
+    FrameTimes frame_times_;
+};
+
+#endif /* GLMARK2_GPU_TIMER_H_ */
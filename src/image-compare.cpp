@@ -0,0 +1,349 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "image-compare.h"
+#include "image-reader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_COMPARE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define IMAGE_COMPARE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+/* The sums of a band of rows, reduced once all the threads are done */
+struct DiffSums {
+    DiffSums() : squares(0), max_difference(0), over_tolerance(0) {}
+
+    uint64_t squares;
+    unsigned int max_difference;
+    uint64_t over_tolerance;
+};
+
+/*
+ * The vector loops accumulate the squares in 32-bit lanes, each getting at
+ * most 4 * 255^2 per iteration, so they are flushed every this many
+ * iterations.
+ */
+const unsigned int flush_iterations = 4096;
+
+void
+diff_pixels_generic(const uint8_t *a, const uint8_t *b, unsigned int count,
+                    unsigned int tolerance, DiffSums &sums)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        bool over = false;
+
+        for (unsigned int c = 0; c < 3; c++) {
+            unsigned int d = a[c] > b[c] ? a[c] - b[c] : b[c] - a[c];
+            sums.squares += d * d;
+            sums.max_difference = std::max(sums.max_difference, d);
+            over = over || d > tolerance;
+        }
+
+        if (over)
+            sums.over_tolerance++;
+
+        a += 4;
+        b += 4;
+    }
+}
+
+#if defined(IMAGE_COMPARE_SSE2)
+
+void
+diff_row(const uint8_t *a, const uint8_t *b, unsigned int width,
+         unsigned int tolerance, DiffSums &sums)
+{
+    /* The number of pixels within the tolerance for each 4-bit mask */
+    static const unsigned int within[16] = {
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+    };
+    const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+    const __m128i tol = _mm_set1_epi8(static_cast<char>(std::min(tolerance, 255U)));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmax = zero;
+    __m128i squares = zero;
+    unsigned int iterations = 0;
+    unsigned int x = 0;
+
+    for (; x + 4 <= width; x += 4) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + 4 * x));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + 4 * x));
+        __m128i d = _mm_and_si128(_mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va)),
+                                  rgb_mask);
+        __m128i lo = _mm_unpacklo_epi8(d, zero);
+        __m128i hi = _mm_unpackhi_epi8(d, zero);
+
+        vmax = _mm_max_epu8(vmax, d);
+        squares = _mm_add_epi32(squares, _mm_add_epi32(_mm_madd_epi16(lo, lo),
+                                                       _mm_madd_epi16(hi, hi)));
+
+        /* A pixel is within the tolerance if none of its channels exceeds it */
+        __m128i ok = _mm_cmpeq_epi32(_mm_subs_epu8(d, tol), zero);
+        sums.over_tolerance += 4 - within[_mm_movemask_ps(_mm_castsi128_ps(ok))];
+
+        if (++iterations == flush_iterations || x + 8 > width) {
+            uint32_t lanes[4];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), squares);
+            sums.squares += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+            squares = zero;
+            iterations = 0;
+        }
+    }
+
+    uint8_t max_bytes[16];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(max_bytes), vmax);
+    for (unsigned int i = 0; i < 16; i++)
+        sums.max_difference = std::max<unsigned int>(sums.max_difference, max_bytes[i]);
+
+    diff_pixels_generic(a + 4 * x, b + 4 * x, width - x, tolerance, sums);
+}
+
+#elif defined(IMAGE_COMPARE_NEON)
+
+void
+diff_row(const uint8_t *a, const uint8_t *b, unsigned int width,
+         unsigned int tolerance, DiffSums &sums)
+{
+    const uint8x16_t rgb_mask = vreinterpretq_u8_u32(vdupq_n_u32(0x00ffffff));
+    const uint8x16_t tol = vdupq_n_u8(static_cast<uint8_t>(std::min(tolerance, 255U)));
+    uint8x16_t vmax = vdupq_n_u8(0);
+    uint32x4_t squares = vdupq_n_u32(0);
+    uint32x4_t over = vdupq_n_u32(0);
+    unsigned int iterations = 0;
+    unsigned int x = 0;
+
+    for (; x + 4 <= width; x += 4) {
+        uint8x16_t d = vandq_u8(vabdq_u8(vld1q_u8(a + 4 * x), vld1q_u8(b + 4 * x)),
+                                rgb_mask);
+
+        vmax = vmaxq_u8(vmax, d);
+        squares = vpadalq_u16(squares, vmull_u8(vget_low_u8(d), vget_low_u8(d)));
+        squares = vpadalq_u16(squares, vmull_u8(vget_high_u8(d), vget_high_u8(d)));
+
+        /* All ones in the pixels with a channel exceeding the tolerance */
+        uint32x4_t exceeds = vreinterpretq_u32_u8(vcgtq_u8(d, tol));
+        over = vsubq_u32(over, vtstq_u32(exceeds, exceeds));
+
+        if (++iterations == flush_iterations || x + 8 > width) {
+            uint32_t lanes[4];
+            vst1q_u32(lanes, squares);
+            sums.squares += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+            squares = vdupq_n_u32(0);
+            iterations = 0;
+        }
+    }
+
+    uint32_t over_lanes[4];
+    vst1q_u32(over_lanes, over);
+    sums.over_tolerance += static_cast<uint64_t>(over_lanes[0]) + over_lanes[1] +
+                           over_lanes[2] + over_lanes[3];
+
+    uint8_t max_bytes[16];
+    vst1q_u8(max_bytes, vmax);
+    for (unsigned int i = 0; i < 16; i++)
+        sums.max_difference = std::max<unsigned int>(sums.max_difference, max_bytes[i]);
+
+    diff_pixels_generic(a + 4 * x, b + 4 * x, width - x, tolerance, sums);
+}
+
+#else
+
+void
+diff_row(const uint8_t *a, const uint8_t *b, unsigned int width,
+         unsigned int tolerance, DiffSums &sums)
+{
+    diff_pixels_generic(a, b, width, tolerance, sums);
+}
+
+#endif
+
+inline unsigned int
+luma(const uint8_t *p)
+{
+    return (77 * p[0] + 150 * p[1] + 29 * p[2]) >> 8;
+}
+
+/*
+ * Sums the SSIM of the luma of the 8x8 blocks in [start_block, end_block)
+ * rows of blocks.
+ */
+double
+ssim_blocks(const uint8_t *a, const uint8_t *b, unsigned int width,
+            unsigned int start_block, unsigned int end_block)
+{
+    static const unsigned int block = 8;
+    static const double c1 = (0.01 * 255) * (0.01 * 255);
+    static const double c2 = (0.03 * 255) * (0.03 * 255);
+    static const double n = block * block;
+    size_t stride = static_cast<size_t>(width) * 4;
+    double total = 0.0;
+
+    for (unsigned int by = start_block; by < end_block; by++) {
+        for (unsigned int bx = 0; bx + block <= width; bx += block) {
+            uint64_t sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+
+            for (unsigned int y = by * block; y < (by + 1) * block; y++) {
+                const uint8_t *pa = a + y * stride + bx * 4;
+                const uint8_t *pb = b + y * stride + bx * 4;
+
+                for (unsigned int x = 0; x < block; x++) {
+                    unsigned int la = luma(pa + 4 * x);
+                    unsigned int lb = luma(pb + 4 * x);
+                    sa += la;
+                    sb += lb;
+                    saa += la * la;
+                    sbb += lb * lb;
+                    sab += la * lb;
+                }
+            }
+
+            double ma = sa / n;
+            double mb = sb / n;
+            double va = saa / n - ma * ma;
+            double vb = sbb / n - mb * mb;
+            double cov = sab / n - ma * mb;
+
+            total += ((2 * ma * mb + c1) * (2 * cov + c2)) /
+                     ((ma * ma + mb * mb + c1) * (va + vb + c2));
+        }
+    }
+
+    return total;
+}
+
+/* Below this many rows per thread, starting the threads isn't worth it */
+const unsigned int min_rows_per_thread = 64;
+
+unsigned int
+thread_count(unsigned int rows)
+{
+    unsigned int max_threads = std::thread::hardware_concurrency();
+    if (max_threads > 8)
+        max_threads = 8;
+
+    return std::max(1U, std::min(max_threads, rows / min_rows_per_thread));
+}
+
+}
+
+ImageCompare::Result
+ImageCompare::compare(const uint8_t *a, const uint8_t *b, int width, int height,
+                      unsigned int tolerance, bool ssim)
+{
+    Result result;
+
+    if (width <= 0 || height <= 0)
+        return result;
+
+    const size_t stride = static_cast<size_t>(width) * 4;
+    const unsigned int nthreads = thread_count(height);
+    std::vector<DiffSums> sums(nthreads);
+    std::vector<double> ssim_sums(nthreads, 0.0);
+    const unsigned int blocks_x = width / 8;
+    const unsigned int blocks_y = height / 8;
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        threads.push_back(std::thread([&, i]() {
+            unsigned int start = static_cast<uint64_t>(height) * i / nthreads;
+            unsigned int end = static_cast<uint64_t>(height) * (i + 1) / nthreads;
+
+            for (unsigned int y = start; y < end; y++)
+                diff_row(a + y * stride, b + y * stride, width, tolerance, sums[i]);
+
+            if (ssim) {
+                ssim_sums[i] = ssim_blocks(a, b, width,
+                                           static_cast<uint64_t>(blocks_y) * i / nthreads,
+                                           static_cast<uint64_t>(blocks_y) * (i + 1) / nthreads);
+            }
+        }));
+    }
+
+    for (std::vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); iter++)
+        iter->join();
+
+    uint64_t squares = 0;
+    double ssim_total = 0.0;
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        squares += sums[i].squares;
+        result.max_difference = std::max(result.max_difference, sums[i].max_difference);
+        result.pixels_over_tolerance += sums[i].over_tolerance;
+        ssim_total += ssim_sums[i];
+    }
+
+    result.pixels = static_cast<uint64_t>(width) * height;
+    result.rmse = std::sqrt(static_cast<double>(squares) / (result.pixels * 3));
+    result.psnr = result.rmse > 0.0 ? 20.0 * std::log10(255.0 / result.rmse) :
+                                      std::numeric_limits<double>::infinity();
+
+    if (ssim) {
+        uint64_t blocks = static_cast<uint64_t>(blocks_x) * blocks_y;
+        result.ssim = blocks > 0 ? ssim_total / blocks : 1.0;
+    }
+
+    return result;
+}
+
+bool
+ImageCompare::load_reference(const std::string &filename, int width, int height,
+                             std::vector<uint8_t> &pixels)
+{
+    PNGReader reader(filename);
+
+    if (reader.error())
+        return false;
+
+    if (static_cast<int>(reader.width()) != width ||
+        static_cast<int>(reader.height()) != height)
+    {
+        return false;
+    }
+
+    unsigned int bpp = reader.pixelBytes();
+    std::vector<uint8_t> row(static_cast<size_t>(width) * bpp);
+
+    pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    /* The file is stored top row first */
+    for (int y = height - 1; y >= 0; y--) {
+        if (!reader.nextRow(&row[0]))
+            return false;
+
+        uint8_t *dst = &pixels[static_cast<size_t>(y) * width * 4];
+        for (int x = 0; x < width; x++) {
+            dst[4 * x] = row[x * bpp];
+            dst[4 * x + 1] = row[x * bpp + 1];
+            dst[4 * x + 2] = row[x * bpp + 2];
+            dst[4 * x + 3] = bpp == 4 ? row[x * bpp + 3] : 255;
+        }
+    }
+
+    return true;
+}
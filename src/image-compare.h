@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_IMAGE_COMPARE_H_
+#define GLMARK2_IMAGE_COMPARE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Compares rendered frames with reference images (--reference-dir).
+ *
+ * Only the RGB channels are compared, like Canvas::Pixel::distance_rgb().
+ * The per-pixel work is vectorized (SSE2 or NEON) and split across
+ * threads, so that full frames can be compared at any resolution.
+ */
+class ImageCompare
+{
+public:
+    struct Result {
+        Result() :
+            rmse(0.0), psnr(0.0), max_difference(0), pixels_over_tolerance(0),
+            pixels(0), ssim(-1.0) {}
+
+        /* Over all the RGB channels, in 0-255 units */
+        double rmse;
+        /* In dB, infinite for identical images */
+        double psnr;
+        /* The largest difference of a channel */
+        unsigned int max_difference;
+        /* The pixels with a channel differing by more than the tolerance */
+        uint64_t pixels_over_tolerance;
+        uint64_t pixels;
+        /* The mean SSIM of the luma over 8x8 blocks, negative if not computed */
+        double ssim;
+    };
+
+    /**
+     * Compares two images of the same size.
+     *
+     * @param a the first image, as RGBA rows
+     * @param b the second image, as RGBA rows
+     * @param width the width of the images
+     * @param height the height of the images
+     * @param tolerance the difference a channel may have before its pixel
+     *                  is counted as different
+     * @param ssim whether to compute the SSIM too
+     */
+    static Result compare(const uint8_t *a, const uint8_t *b, int width, int height,
+                          unsigned int tolerance, bool ssim);
+
+    /**
+     * Loads a PNG reference image.
+     *
+     * @param filename the file to load
+     * @param width the expected width of the image
+     * @param height the expected height of the image
+     * @param pixels the RGBA rows of the image, bottom row first like
+     *               glReadPixels()
+     *
+     * @return whether the image was loaded and has the expected size
+     */
+    static bool load_reference(const std::string &filename, int width, int height,
+                               std::vector<uint8_t> &pixels);
+};
+
+#endif /* GLMARK2_IMAGE_COMPARE_H_ */
@@ -23,6 +23,9 @@
 #include <jpeglib.h>
 #include <cstring>
 #include <memory>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
 
 #include "image-reader.h"
 #include "log.h"
@@ -38,10 +41,21 @@ struct PNGReaderPrivate
         png(0), info(0), rows(0), png_error(0),
         current_row(0), row_stride(0) {}
 
+    /* Reads the file from its mapping */
+    struct Source
+    {
+        const char *cur;
+        const char *end;
+    };
+
     static void png_read_fn(png_structp png_ptr, png_bytep data, png_size_t length)
     {
-        std::istream *is = reinterpret_cast<std::istream*>(png_get_io_ptr(png_ptr));
-        is->read(reinterpret_cast<char *>(data), length);
+        Source *source = reinterpret_cast<Source*>(png_get_io_ptr(png_ptr));
+        if (length > static_cast<size_t>(source->end - source->cur))
+            ::png_error(png_ptr, "Unexpected end of file");
+
+        memcpy(data, source->cur, length);
+        source->cur += length;
     }
 
     png_structp png;
@@ -120,12 +134,16 @@ PNGReader::init(const std::string& filename)
 
     Log::debug("Reading PNG file %s\n", filename.c_str());
 
-    const std::unique_ptr<std::istream> is_ptr(Util::get_resource(filename));
-    if (!(*is_ptr)) {
+    const std::unique_ptr<Util::MappedResource> resource(Util::map_resource(filename));
+    if (!resource->valid()) {
         Log::error("Cannot open file %s!\n", filename.c_str());
         return false;
     }
 
+    PNGReaderPrivate::Source source = {
+        resource->data(), resource->data() + resource->size()
+    };
+
     /* Set up all the libpng structs we need */
     priv_->png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
     if (!priv_->png) {
@@ -146,7 +164,7 @@ PNGReader::init(const std::string& filename)
     }
 
     /* Read the image information and data */
-    png_set_read_fn(priv_->png, reinterpret_cast<void*>(is_ptr.get()),
+    png_set_read_fn(priv_->png, reinterpret_cast<void*>(&source),
                     PNGReaderPrivate::png_read_fn);
 
     png_read_png(priv_->png, priv_->info, png_transforms, 0);
@@ -293,10 +311,10 @@ struct JPEGReaderPrivate
 };
 
 
-JPEGReader::JPEGReader(const std::string& filename) :
+JPEGReader::JPEGReader(const std::string& filename, unsigned int min_size) :
     priv_(new JPEGReaderPrivate(filename))
 {
-    priv_->jpeg_error = !init(filename);
+    priv_->jpeg_error = !init(filename, min_size);
 }
 
 JPEGReader::~JPEGReader()
@@ -354,7 +372,7 @@ JPEGReader::pixelBytes() const
 }
 
 bool
-JPEGReader::init(const std::string& filename)
+JPEGReader::init(const std::string& filename, unsigned int min_size)
 {
     Log::debug("Reading JPEG file %s\n", filename.c_str());
 
@@ -371,6 +389,27 @@ JPEGReader::init(const std::string& filename)
     /* Read header */
     jpeg_read_header(&priv_->cinfo, TRUE);
 
+    /*
+     * Use the smallest scale that still gives min_size, the decoded size
+     * being rounded up. Every libjpeg version supports 1/2, 1/4 and 1/8.
+     */
+    if (min_size > 0) {
+        unsigned int denom = 1;
+
+        while (denom < 8 &&
+               (priv_->cinfo.image_width + 2 * denom - 1) / (2 * denom) >= min_size &&
+               (priv_->cinfo.image_height + 2 * denom - 1) / (2 * denom) >= min_size)
+        {
+            denom *= 2;
+        }
+
+        if (denom > 1) {
+            Log::debug("    Decoding at 1/%u scale for size %u\n", denom, min_size);
+            priv_->cinfo.scale_num = 1;
+            priv_->cinfo.scale_denom = denom;
+        }
+    }
+
     jpeg_start_decompress(&priv_->cinfo);
 
     return true;
@@ -382,5 +421,293 @@ JPEGReader::finish()
     jpeg_destroy_decompress(&priv_->cinfo);
 }
 
+/*******
+ * KTX *
+ *******/
+
+struct KTXReaderPrivate
+{
+    KTXReaderPrivate() :
+        ktx_error(false), data(0), size(0), width(0), height(0), internal_format(0) {}
+
+    bool ktx_error;
+    /* The file, whose levels are uploaded straight from the mapping */
+    std::unique_ptr<Util::MappedResource> resource;
+    const unsigned char *data;
+    size_t size;
+    unsigned int width;
+    unsigned int height;
+    unsigned int internal_format;
+    /* The offset and size of each mipmap level in data */
+    std::vector<std::pair<size_t, size_t> > levels;
+
+    uint32_t u32(size_t offset) const
+    {
+        uint32_t v;
+        std::memcpy(&v, &data[offset], sizeof(v));
+        return v;
+    }
+
+    uint64_t u64(size_t offset) const
+    {
+        uint64_t v;
+        std::memcpy(&v, &data[offset], sizeof(v));
+        return v;
+    }
+};
+
+namespace
+{
+
+const unsigned char ktx1_identifier[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+const unsigned char ktx2_identifier[12] = {
+    0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'
+};
+
+/*
+ * Gets the GL internal format for a KTX2 VkFormat. Only the compressed
+ * formats we can upload with glCompressedTexImage2D() are handled.
+ */
+unsigned int
+vk_format_to_gl(uint32_t vk_format)
+{
+    /* VK_FORMAT_BC1_RGB_UNORM_BLOCK ... VK_FORMAT_BC3_SRGB_BLOCK */
+    static const unsigned int bc[] = {
+        0x83F0, 0x8C4C, 0x83F1, 0x8C4D, 0x83F2, 0x8C4E, 0x83F3, 0x8C4F
+    };
+    /* VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK ... VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK */
+    static const unsigned int etc2[] = {
+        0x9274, 0x9275, 0x9276, 0x9277, 0x9278, 0x9279
+    };
+
+    if (vk_format >= 131 && vk_format <= 138)
+        return bc[vk_format - 131];
+    /* VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK */
+    if (vk_format == 145 || vk_format == 146)
+        return 0x8E8C + (vk_format - 145);
+    if (vk_format >= 147 && vk_format <= 152)
+        return etc2[vk_format - 147];
+    /* VK_FORMAT_ASTC_4x4_UNORM_BLOCK ... VK_FORMAT_ASTC_12x12_SRGB_BLOCK */
+    if (vk_format >= 157 && vk_format <= 184) {
+        unsigned int block = (vk_format - 157) / 2;
+        bool srgb = (vk_format - 157) % 2;
+        return (srgb ? 0x93D0 : 0x93B0) + block;
+    }
+
+    return 0;
+}
+
+}
 
+KTXReader::KTXReader(const std::string& filename) :
+    priv_(new KTXReaderPrivate())
+{
+    priv_->ktx_error = !init(filename);
+}
+
+KTXReader::~KTXReader()
+{
+    delete priv_;
+}
+
+bool
+KTXReader::error()
+{
+    return priv_->ktx_error;
+}
+
+bool
+KTXReader::nextRow(unsigned char *dst)
+{
+    static_cast<void>(dst);
+    return false;
+}
+
+unsigned int
+KTXReader::width() const
+{
+    return priv_->width;
+}
+
+unsigned int
+KTXReader::height() const
+{
+    return priv_->height;
+}
+
+unsigned int
+KTXReader::pixelBytes() const
+{
+    return 0;
+}
+
+unsigned int
+KTXReader::internalFormat() const
+{
+    return priv_->internal_format;
+}
+
+unsigned int
+KTXReader::levels() const
+{
+    return priv_->levels.size();
+}
+
+const unsigned char *
+KTXReader::levelData(unsigned int level) const
+{
+    return &priv_->data[priv_->levels[level].first];
+}
 
+unsigned int
+KTXReader::levelSize(unsigned int level) const
+{
+    return priv_->levels[level].second;
+}
+
+bool
+KTXReader::init(const std::string& filename)
+{
+    Log::debug("Reading KTX file %s\n", filename.c_str());
+
+    priv_->resource.reset(Util::map_resource(filename));
+    if (!priv_->resource->valid()) {
+        Log::error("Cannot open file %s!\n", filename.c_str());
+        return false;
+    }
+
+    priv_->data = reinterpret_cast<const unsigned char *>(priv_->resource->data());
+    priv_->size = priv_->resource->size();
+
+    bool ret(false);
+
+    if (priv_->size >= sizeof(ktx1_identifier) &&
+        std::memcmp(&priv_->data[0], ktx1_identifier, sizeof(ktx1_identifier)) == 0)
+    {
+        ret = init_ktx1();
+    }
+    else if (priv_->size >= sizeof(ktx2_identifier) &&
+             std::memcmp(&priv_->data[0], ktx2_identifier, sizeof(ktx2_identifier)) == 0)
+    {
+        ret = init_ktx2();
+    }
+    else {
+        Log::error("%s is not a KTX file\n", filename.c_str());
+        return false;
+    }
+
+    if (!ret) {
+        Log::error("Unsupported or invalid KTX file %s\n", filename.c_str());
+        return false;
+    }
+
+    Log::debug("    Height: %d Width: %d Format: 0x%x Levels: %u\n",
+               priv_->height, priv_->width, priv_->internal_format,
+               static_cast<unsigned int>(priv_->levels.size()));
+
+    return true;
+}
+
+bool
+KTXReader::init_ktx1()
+{
+    static const size_t header_size = 64;
+    const KTXReaderPrivate &p(*priv_);
+
+    if (p.size < header_size)
+        return false;
+
+    /* Only files in our own endianness are supported */
+    if (p.u32(12) != 0x04030201)
+        return false;
+
+    uint32_t gl_type = p.u32(16);
+    uint32_t gl_internal_format = p.u32(28);
+    uint32_t pixel_height = p.u32(40);
+    uint32_t pixel_depth = p.u32(44);
+    uint32_t array_elements = p.u32(48);
+    uint32_t faces = p.u32(52);
+    uint32_t levels = p.u32(56);
+    uint32_t kv_bytes = p.u32(60);
+
+    /* Compressed data has a glType of 0 */
+    if (gl_type != 0 || pixel_height == 0 || pixel_depth > 1 ||
+        array_elements > 0 || faces != 1)
+    {
+        return false;
+    }
+
+    priv_->width = p.u32(36);
+    priv_->height = pixel_height;
+    priv_->internal_format = gl_internal_format;
+
+    if (kv_bytes > p.size - header_size)
+        return false;
+
+    size_t offset = header_size + kv_bytes;
+
+    for (uint32_t i = 0; i < std::max(levels, 1U); i++) {
+        if (offset > p.size || 4 > p.size - offset)
+            return false;
+
+        size_t size = p.u32(offset);
+        offset += 4;
+        if (size > p.size - offset)
+            return false;
+
+        priv_->levels.push_back(std::make_pair(offset, size));
+        /* Each level is padded to 4 bytes */
+        offset += (size + 3) & ~static_cast<size_t>(3);
+    }
+
+    return true;
+}
+
+bool
+KTXReader::init_ktx2()
+{
+    static const size_t header_size = 80;
+    const KTXReaderPrivate &p(*priv_);
+
+    if (p.size < header_size)
+        return false;
+
+    uint32_t vk_format = p.u32(12);
+    uint32_t pixel_height = p.u32(24);
+    uint32_t pixel_depth = p.u32(28);
+    uint32_t layers = p.u32(32);
+    uint32_t faces = p.u32(36);
+    uint32_t levels = std::max(p.u32(40), 1U);
+    uint32_t supercompression = p.u32(44);
+
+    if (pixel_height == 0 || pixel_depth > 0 || layers > 0 || faces != 1 ||
+        supercompression != 0)
+    {
+        return false;
+    }
+
+    priv_->width = p.u32(20);
+    priv_->height = pixel_height;
+    priv_->internal_format = vk_format_to_gl(vk_format);
+    if (priv_->internal_format == 0)
+        return false;
+
+    if (levels > (p.size - header_size) / 24)
+        return false;
+
+    /* The level index follows the header, starting with the base level */
+    for (uint32_t i = 0; i < levels; i++) {
+        uint64_t offset = p.u64(header_size + i * 24);
+        uint64_t size = p.u64(header_size + i * 24 + 8);
+
+        /* Corrupt offsets and sizes must not overflow the check */
+        if (offset > p.size || size > p.size - offset)
+            return false;
+
+        priv_->levels.push_back(std::make_pair(offset, size));
+    }
+
+    return true;
+}
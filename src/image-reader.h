@@ -59,7 +59,14 @@ struct JPEGReaderPrivate;
 class JPEGReader : public ImageReader
 {
 public:
-    JPEGReader(const std::string& filename);
+    /**
+     * @filename: the JPEG file
+     * @min_size: the width and height the image needs at least, 0 for its
+     *            full size. Larger images are decoded at 1/2, 1/4 or 1/8
+     *            of their size by scaling the IDCT, which is much cheaper
+     *            than decoding them fully.
+     */
+    JPEGReader(const std::string& filename, unsigned int min_size = 0);
 
     virtual ~JPEGReader();
     bool error();
@@ -69,9 +76,46 @@ public:
     unsigned int pixelBytes() const;
 
 private:
-    bool init(const std::string& filename);
+    bool init(const std::string& filename, unsigned int min_size);
     void finish();
 
     JPEGReaderPrivate *priv_;
 };
 
+struct KTXReaderPrivate;
+
+/**
+ * Reads compressed images from KTX (version 1) and KTX2 files.
+ *
+ * Compressed images can't be read by rows, so nextRow() always fails and
+ * the data of each mipmap level must be accessed with levelData() instead.
+ * Only 2D textures without supercompression are supported.
+ */
+class KTXReader : public ImageReader
+{
+public:
+    KTXReader(const std::string& filename);
+
+    virtual ~KTXReader();
+    bool error();
+    bool nextRow(unsigned char *dst);
+    unsigned int width() const;
+    unsigned int height() const;
+    unsigned int pixelBytes() const;
+
+    /** The GL internal format of the compressed data */
+    unsigned int internalFormat() const;
+    /** The number of mipmap levels in the file, at least 1 */
+    unsigned int levels() const;
+    /** The compressed data of a mipmap level */
+    const unsigned char *levelData(unsigned int level) const;
+    /** The size in bytes of the compressed data of a mipmap level */
+    unsigned int levelSize(unsigned int level) const;
+
+private:
+    bool init(const std::string& filename);
+    bool init_ktx1();
+    bool init_ktx2();
+
+    KTXReaderPrivate *priv_;
+};
@@ -0,0 +1,239 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "isolation.h"
+#include "options.h"
+#include "log.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+
+/* The CPUs of the render thread and of the worker threads */
+std::vector<int> render_cpus;
+std::vector<int> worker_cpus;
+
+/*
+ * Parses a list of CPUs like "0,2-3".
+ */
+bool
+parse_cpus(const std::string &str, std::vector<int> &cpus)
+{
+    std::vector<std::string> ranges;
+    Util::split(str, ',', ranges, Util::SplitModeNormal);
+
+    for (std::vector<std::string>::const_iterator iter = ranges.begin();
+         iter != ranges.end();
+         iter++)
+    {
+        std::vector<std::string> bounds;
+        Util::split(*iter, '-', bounds, Util::SplitModeNormal);
+
+        if (bounds.empty() || bounds.size() > 2 ||
+            bounds.front().empty() || bounds.back().empty() ||
+            bounds.front().find_first_not_of("0123456789") != std::string::npos ||
+            bounds.back().find_first_not_of("0123456789") != std::string::npos)
+        {
+            return false;
+        }
+
+        int first = Util::fromString<int>(bounds.front());
+        int last = Util::fromString<int>(bounds.back());
+        if (first > last)
+            return false;
+
+        for (int cpu = first; cpu <= last; cpu++)
+            cpus.push_back(cpu);
+    }
+
+    return !cpus.empty();
+}
+
+std::string
+cpus_str(const std::vector<int> &cpus)
+{
+    std::string str;
+
+    for (size_t i = 0; i < cpus.size(); i++)
+        str += (i > 0 ? "," : "") + Util::toString(cpus[i]);
+
+    return str;
+}
+
+#if defined(__linux__)
+bool
+set_affinity(const std::vector<int> &cpus)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if (cpus[i] < CPU_SETSIZE)
+            CPU_SET(cpus[i], &set);
+    }
+
+    /* Only applies to the calling thread, the new threads inherit it */
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+#endif
+
+/*
+ * Gets the frequency governors of the CPUs, e.g. "performance".
+ */
+std::string
+governors(const std::vector<int> &cpus)
+{
+    std::vector<std::string> names;
+
+    for (size_t i = 0; i < cpus.size(); i++) {
+        std::ifstream file(("/sys/devices/system/cpu/cpu" + Util::toString(cpus[i]) +
+                            "/cpufreq/scaling_governor").c_str());
+        std::string name;
+        if (file >> name && std::find(names.begin(), names.end(), name) == names.end())
+            names.push_back(name);
+    }
+
+    std::string str;
+    for (size_t i = 0; i < names.size(); i++)
+        str += (i > 0 ? "," : "") + names[i];
+
+    return str;
+}
+
+bool
+isolated()
+{
+    return !Options::cpu_affinity.empty() || !Options::worker_affinity.empty() ||
+           Options::realtime_priority > 0 || Options::nice != 0 ||
+           Options::lock_memory;
+}
+
+}
+
+bool
+Isolation::apply()
+{
+    if (!isolated())
+        return true;
+
+    if (!Options::cpu_affinity.empty() &&
+        !parse_cpus(Options::cpu_affinity, render_cpus))
+    {
+        Log::error("Invalid --cpu-affinity '%s'\n", Options::cpu_affinity.c_str());
+        return false;
+    }
+
+    if (!Options::worker_affinity.empty() &&
+        !parse_cpus(Options::worker_affinity, worker_cpus))
+    {
+        Log::error("Invalid --worker-affinity '%s'\n", Options::worker_affinity.c_str());
+        return false;
+    }
+
+#if defined(__linux__)
+    if (!render_cpus.empty() && !set_affinity(render_cpus)) {
+        Log::error("Failed to set the CPU affinity to %s: %s\n",
+                   cpus_str(render_cpus).c_str(), strerror(errno));
+        return false;
+    }
+
+    if (Options::nice != 0 && setpriority(PRIO_PROCESS, 0, Options::nice) != 0) {
+        Log::error("Failed to set the nice value to %d: %s\n",
+                   Options::nice, strerror(errno));
+        return false;
+    }
+
+    if (Options::realtime_priority > 0) {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = Options::realtime_priority;
+        if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+            Log::error("Failed to use SCHED_FIFO with priority %d: %s\n",
+                       Options::realtime_priority, strerror(errno));
+            return false;
+        }
+    }
+
+    if (Options::lock_memory && mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        Log::error("Failed to lock the memory: %s\n", strerror(errno));
+        return false;
+    }
+
+    /* An on-demand governor changes the frequency during the run */
+    std::vector<int> cpus(render_cpus);
+    cpus.insert(cpus.end(), worker_cpus.begin(), worker_cpus.end());
+    if (cpus.empty())
+        cpus.push_back(0);
+    std::string governor(governors(cpus));
+    if (!governor.empty() && governor != "performance") {
+        Log::info("Warning: the CPU frequency governor is '%s', use 'performance' "
+                  "for stable results\n", governor.c_str());
+    }
+
+    return true;
+#else
+    Log::error("The CPU affinity, scheduling and memory locking options are only "
+               "supported on Linux\n");
+    return false;
+#endif
+}
+
+void
+Isolation::worker_thread()
+{
+#if defined(__linux__)
+    if (!worker_cpus.empty() && !set_affinity(worker_cpus)) {
+        Log::debug("Failed to set the worker CPU affinity to %s: %s\n",
+                   cpus_str(worker_cpus).c_str(), strerror(errno));
+    }
+#endif
+}
+
+void
+Isolation::info(std::vector<std::pair<std::string, std::string> > &info)
+{
+    if (!isolated())
+        return;
+
+    info.push_back(std::make_pair("CPU Affinity",
+                                  render_cpus.empty() ? "all" : cpus_str(render_cpus)));
+    info.push_back(std::make_pair("Worker Affinity",
+                                  worker_cpus.empty() ? "inherited" : cpus_str(worker_cpus)));
+    info.push_back(std::make_pair("Scheduling",
+                                  Options::realtime_priority > 0 ?
+                                  "fifo:" + Util::toString(Options::realtime_priority) :
+                                  "other"));
+    info.push_back(std::make_pair("Nice", Util::toString(Options::nice)));
+    info.push_back(std::make_pair("Memory Locked", Options::lock_memory ? "yes" : "no"));
+
+    std::vector<int> cpus(render_cpus);
+    if (cpus.empty())
+        cpus.push_back(0);
+    info.push_back(std::make_pair("CPU Governor", governors(cpus)));
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_ISOLATION_H_
+#define GLMARK2_ISOLATION_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Isolates the benchmark from the rest of the system to reduce the noise
+ * between runs: pins the render thread and the worker threads to CPUs
+ * (--cpu-affinity, --worker-affinity), raises their scheduling priority
+ * (--realtime-priority, --nice) and locks the memory of the process
+ * (--lock-memory).
+ */
+class Isolation
+{
+public:
+    /**
+     * Applies the isolation options to the process. Must be called from
+     * the render thread, before any other thread is started, so that the
+     * threads started later (including those of the driver) inherit the
+     * settings.
+     *
+     * @return whether all the settings could be applied
+     */
+    static bool apply();
+
+    /**
+     * Applies the worker affinity to the calling thread. Called by the
+     * worker threads when they start.
+     */
+    static void worker_thread();
+
+    /**
+     * Adds the applied settings and the frequency governors of the used
+     * CPUs to the information recorded with the results.
+     */
+    static void info(std::vector<std::pair<std::string, std::string> > &info);
+};
+
+#endif
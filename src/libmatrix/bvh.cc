@@ -0,0 +1,328 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#include <algorithm>
+#include "bvh.h"
+
+namespace LibMatrix
+{
+
+namespace
+{
+
+// The objects in a leaf of the hierarchy, at most
+const unsigned int leaf_size(4);
+
+struct CenterCompare
+{
+    CenterCompare(const std::vector<vec3>& centers, unsigned int axis) :
+        centers(centers), axis(axis) {}
+
+    bool operator()(unsigned int a, unsigned int b) const
+    {
+        return centers[a][axis] < centers[b][axis];
+    }
+
+    const std::vector<vec3>& centers;
+    unsigned int axis;
+};
+
+}
+
+Frustum::Frustum()
+{
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        a_[i] = 0.0f;
+        b_[i] = 0.0f;
+        c_[i] = 0.0f;
+        d_[i] = 1.0f;
+    }
+}
+
+Frustum::Frustum(const mat4& m)
+{
+    // A point p is in the clip volume if -w <= x, y, z <= w, where
+    // (x, y, z, w) = m * p, which gives the planes (row 3 +/- row i) * p >= 0
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        for (unsigned int s = 0; s < 2; s++)
+        {
+            float sign(s ? -1.0f : 1.0f);
+            unsigned int p(2 * i + s);
+            a_[p] = m[3][0] + sign * m[i][0];
+            b_[p] = m[3][1] + sign * m[i][1];
+            c_[p] = m[3][2] + sign * m[i][2];
+            d_[p] = m[3][3] + sign * m[i][3];
+        }
+    }
+
+    for (unsigned int p = 6; p < 8; p++)
+    {
+        a_[p] = 0.0f;
+        b_[p] = 0.0f;
+        c_[p] = 0.0f;
+        d_[p] = 1.0f;
+    }
+}
+
+Frustum::Result
+Frustum::classify_generic(const vec3& min, const vec3& max) const
+{
+    Result result(Inside);
+
+    for (unsigned int p = 0; p < 6; p++)
+    {
+        // The corners of the box furthest along and against the plane
+        float far(a_[p] * (a_[p] > 0.0f ? max.x() : min.x()) +
+                  b_[p] * (b_[p] > 0.0f ? max.y() : min.y()) +
+                  c_[p] * (c_[p] > 0.0f ? max.z() : min.z()) + d_[p]);
+        float near(a_[p] * (a_[p] > 0.0f ? min.x() : max.x()) +
+                   b_[p] * (b_[p] > 0.0f ? min.y() : max.y()) +
+                   c_[p] * (c_[p] > 0.0f ? min.z() : max.z()) + d_[p]);
+
+        if (far < 0.0f)
+            return Outside;
+        if (near < 0.0f)
+            result = Intersects;
+    }
+
+    return result;
+}
+
+#if defined(LIBMATRIX_SIMD_SSE)
+
+Frustum::Result
+Frustum::classify(const vec3& min, const vec3& max) const
+{
+    if (!Simd::enabled())
+        return classify_generic(min, max);
+
+    __m128 min_x(_mm_set1_ps(min.x()));
+    __m128 min_y(_mm_set1_ps(min.y()));
+    __m128 min_z(_mm_set1_ps(min.z()));
+    __m128 max_x(_mm_set1_ps(max.x()));
+    __m128 max_y(_mm_set1_ps(max.y()));
+    __m128 max_z(_mm_set1_ps(max.z()));
+    __m128 zero(_mm_setzero_ps());
+    int outside(0);
+    int intersects(0);
+
+    for (unsigned int i = 0; i < 8; i += 4)
+    {
+        __m128 a(_mm_loadu_ps(a_ + i));
+        __m128 b(_mm_loadu_ps(b_ + i));
+        __m128 c(_mm_loadu_ps(c_ + i));
+        __m128 d(_mm_loadu_ps(d_ + i));
+        __m128 ax0(_mm_mul_ps(a, min_x));
+        __m128 ax1(_mm_mul_ps(a, max_x));
+        __m128 by0(_mm_mul_ps(b, min_y));
+        __m128 by1(_mm_mul_ps(b, max_y));
+        __m128 cz0(_mm_mul_ps(c, min_z));
+        __m128 cz1(_mm_mul_ps(c, max_z));
+        __m128 far(_mm_add_ps(_mm_add_ps(_mm_max_ps(ax0, ax1), _mm_max_ps(by0, by1)),
+                              _mm_add_ps(_mm_max_ps(cz0, cz1), d)));
+        __m128 near(_mm_add_ps(_mm_add_ps(_mm_min_ps(ax0, ax1), _mm_min_ps(by0, by1)),
+                               _mm_add_ps(_mm_min_ps(cz0, cz1), d)));
+
+        outside |= _mm_movemask_ps(_mm_cmplt_ps(far, zero));
+        intersects |= _mm_movemask_ps(_mm_cmplt_ps(near, zero));
+    }
+
+    if (outside)
+        return Outside;
+    return intersects ? Intersects : Inside;
+}
+
+#elif defined(LIBMATRIX_SIMD_NEON)
+
+Frustum::Result
+Frustum::classify(const vec3& min, const vec3& max) const
+{
+    if (!Simd::enabled())
+        return classify_generic(min, max);
+
+    float32x4_t min_x(vdupq_n_f32(min.x()));
+    float32x4_t min_y(vdupq_n_f32(min.y()));
+    float32x4_t min_z(vdupq_n_f32(min.z()));
+    float32x4_t max_x(vdupq_n_f32(max.x()));
+    float32x4_t max_y(vdupq_n_f32(max.y()));
+    float32x4_t max_z(vdupq_n_f32(max.z()));
+    float32x4_t zero(vdupq_n_f32(0.0f));
+    uint32x4_t outside(vdupq_n_u32(0));
+    uint32x4_t intersects(vdupq_n_u32(0));
+
+    for (unsigned int i = 0; i < 8; i += 4)
+    {
+        float32x4_t a(vld1q_f32(a_ + i));
+        float32x4_t b(vld1q_f32(b_ + i));
+        float32x4_t c(vld1q_f32(c_ + i));
+        float32x4_t d(vld1q_f32(d_ + i));
+        float32x4_t ax0(vmulq_f32(a, min_x));
+        float32x4_t ax1(vmulq_f32(a, max_x));
+        float32x4_t by0(vmulq_f32(b, min_y));
+        float32x4_t by1(vmulq_f32(b, max_y));
+        float32x4_t cz0(vmulq_f32(c, min_z));
+        float32x4_t cz1(vmulq_f32(c, max_z));
+        float32x4_t far(vaddq_f32(vaddq_f32(vmaxq_f32(ax0, ax1), vmaxq_f32(by0, by1)),
+                                  vaddq_f32(vmaxq_f32(cz0, cz1), d)));
+        float32x4_t near(vaddq_f32(vaddq_f32(vminq_f32(ax0, ax1), vminq_f32(by0, by1)),
+                                   vaddq_f32(vminq_f32(cz0, cz1), d)));
+
+        outside = vorrq_u32(outside, vcltq_f32(far, zero));
+        intersects = vorrq_u32(intersects, vcltq_f32(near, zero));
+    }
+
+    uint32x2_t o(vorr_u32(vget_low_u32(outside), vget_high_u32(outside)));
+    uint32x2_t n(vorr_u32(vget_low_u32(intersects), vget_high_u32(intersects)));
+
+    if (vget_lane_u32(o, 0) | vget_lane_u32(o, 1))
+        return Outside;
+    return (vget_lane_u32(n, 0) | vget_lane_u32(n, 1)) ? Intersects : Inside;
+}
+
+#else
+
+Frustum::Result
+Frustum::classify(const vec3& min, const vec3& max) const
+{
+    return classify_generic(min, max);
+}
+
+#endif
+
+void
+BVH::clear()
+{
+    boxes_.clear();
+    order_.clear();
+    nodes_.clear();
+    tests_ = 0;
+}
+
+void
+BVH::add(const vec3& min, const vec3& max)
+{
+    Box box;
+    box.min = min;
+    box.max = max;
+    boxes_.push_back(box);
+}
+
+void
+BVH::build()
+{
+    order_.resize(boxes_.size());
+    for (unsigned int i = 0; i < order_.size(); i++)
+        order_[i] = i;
+
+    // The centers are doubled, which doesn't change their order
+    std::vector<vec3> centers;
+    centers.reserve(boxes_.size());
+    for (unsigned int i = 0; i < boxes_.size(); i++)
+        centers.push_back(boxes_[i].min + boxes_[i].max);
+
+    nodes_.clear();
+    tests_ = 0;
+    if (!boxes_.empty())
+        build_node(0, boxes_.size(), centers);
+}
+
+// Builds the node of the objects from first in order_, splitting them in
+// halves along the longest axis of their centers.  Returns the index of
+// the node.
+unsigned int
+BVH::build_node(unsigned int first, unsigned int count,
+                const std::vector<vec3>& centers)
+{
+    unsigned int index(nodes_.size());
+    const Box& first_box(boxes_[order_[first]]);
+    float box_min[3] = { first_box.min.x(), first_box.min.y(), first_box.min.z() };
+    float box_max[3] = { first_box.max.x(), first_box.max.y(), first_box.max.z() };
+    float center_min[3] = { box_min[0] + box_max[0], box_min[1] + box_max[1],
+                            box_min[2] + box_max[2] };
+    float center_max[3] = { center_min[0], center_min[1], center_min[2] };
+
+    for (unsigned int i = first; i < first + count; i++)
+    {
+        const float* min(boxes_[order_[i]].min);
+        const float* max(boxes_[order_[i]].max);
+        for (unsigned int axis = 0; axis < 3; axis++)
+        {
+            float center(centers[order_[i]][axis]);
+            box_min[axis] = std::min(box_min[axis], min[axis]);
+            box_max[axis] = std::max(box_max[axis], max[axis]);
+            center_min[axis] = std::min(center_min[axis], center);
+            center_max[axis] = std::max(center_max[axis], center);
+        }
+    }
+
+    Node node;
+    node.box.min = vec3(box_min[0], box_min[1], box_min[2]);
+    node.box.max = vec3(box_max[0], box_max[1], box_max[2]);
+    node.first = first;
+    node.count = count;
+    node.second = 0;
+    nodes_.push_back(node);
+
+    if (count <= leaf_size)
+        return index;
+
+    unsigned int axis(0);
+    for (unsigned int a = 1; a < 3; a++)
+    {
+        if (center_max[a] - center_min[a] > center_max[axis] - center_min[axis])
+            axis = a;
+    }
+
+    unsigned int half(count / 2);
+    std::nth_element(order_.begin() + first, order_.begin() + first + half,
+                     order_.begin() + first + count, CenterCompare(centers, axis));
+
+    build_node(first, half, centers);
+    unsigned int second(build_node(first + half, count - half, centers));
+    nodes_[index].second = second;
+
+    return index;
+}
+
+void
+BVH::cull(const Frustum& frustum, std::vector<unsigned int>& visible) const
+{
+    std::vector<unsigned int> stack;
+
+    tests_ = 0;
+    if (nodes_.empty())
+        return;
+
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const Node& node(nodes_[stack.back()]);
+        unsigned int index(stack.back());
+        stack.pop_back();
+
+        tests_++;
+        Frustum::Result result(frustum.classify(node.box.min, node.box.max));
+        if (result == Frustum::Outside)
+            continue;
+
+        // Everything below a node inside the frustum is visible
+        if (result == Frustum::Inside || !node.second)
+        {
+            visible.insert(visible.end(), order_.begin() + node.first,
+                           order_.begin() + node.first + node.count);
+            continue;
+        }
+
+        stack.push_back(node.second);
+        stack.push_back(index + 1);
+    }
+}
+
+} // namespace LibMatrix
@@ -0,0 +1,104 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#ifndef BVH_H_
+#define BVH_H_
+
+#include <vector>
+#include "vec.h"
+#include "mat.h"
+
+namespace LibMatrix
+{
+
+// The view frustum of a transformation to clip space, for testing
+// axis-aligned boxes against it.  The planes are kept as structures of
+// arrays, so that the SIMD version tests four of them at once.
+class Frustum
+{
+public:
+    enum Result
+    {
+        Outside,
+        Intersects,
+        Inside
+    };
+
+    Frustum();
+    // The frustum of the boxes that m transforms into the clip volume
+    explicit Frustum(const mat4& m);
+
+    // Whether the box from min to max is outside, partly inside or
+    // inside the frustum.  Boxes close to the frustum may be found to
+    // intersect it while they are outside, never the other way round.
+    Result classify(const vec3& min, const vec3& max) const;
+
+private:
+    Result classify_generic(const vec3& min, const vec3& max) const;
+
+    // The a, b, c and d coefficients of the 6 planes, padded to 8 with
+    // planes that contain everything.  A point is inside a plane if
+    // a * x + b * y + c * z + d >= 0.
+    float a_[8];
+    float b_[8];
+    float c_[8];
+    float d_[8];
+};
+
+// A bounding volume hierarchy of axis-aligned boxes, to find the objects
+// in a frustum without testing each of them.  The boxes are added in the
+// order of the objects, then the hierarchy is built once.
+class BVH
+{
+public:
+    BVH() : tests_(0) {}
+
+    void clear();
+    // Adds the box of the next object, which gets the next index
+    void add(const vec3& min, const vec3& max);
+    // Builds the hierarchy of the boxes added so far
+    void build();
+    // Gets the indices of the objects whose boxes may be in the frustum,
+    // in no particular order
+    void cull(const Frustum& frustum, std::vector<unsigned int>& visible) const;
+
+    unsigned int size() const { return boxes_.size(); }
+    // The number of boxes of nodes tested by the last ::cull()
+    unsigned int tests() const { return tests_; }
+
+private:
+    struct Box
+    {
+        vec3 min;
+        vec3 max;
+    };
+
+    // The objects of a node are contiguous in order_.  The first child of
+    // an inner node follows it, the second one is at `second`, which is 0
+    // for a leaf.
+    struct Node
+    {
+        Box box;
+        unsigned int first;
+        unsigned int count;
+        unsigned int second;
+    };
+
+    unsigned int build_node(unsigned int first, unsigned int count,
+                            const std::vector<vec3>& centers);
+
+    std::vector<Box> boxes_;
+    // The objects, ordered so that each leaf's are contiguous
+    std::vector<unsigned int> order_;
+    std::vector<Node> nodes_;
+    mutable unsigned int tests_;
+};
+
+} // namespace LibMatrix
+
+#endif // BVH_H_
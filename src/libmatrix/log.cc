@@ -15,6 +15,12 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include "log.h"
 
 #ifdef ANDROID
@@ -40,26 +46,149 @@ static const string terminal_color_red("\033[1;31m");
 static const string terminal_color_cyan("\033[36m");
 static const string terminal_color_yellow("\033[33m");
 static const string empty;
+/* Not function statics, which would be destroyed before the ring at exit */
+static const string infoprefix("Info");
+static const string dbgprefix("Debug");
+static const string errprefix("Error");
 
-static void
-print_prefixed_message(std::ostream& stream, const string& color, const string& prefix,
-                       const string& fmt, va_list ap)
+/*
+ * The ring of messages waiting to be written, with asynchronous logging.
+ *
+ * This is a bounded multi-producer queue where each slot carries a sequence
+ * number (as described by Dmitry Vyukov): a producer claims a slot with a
+ * compare-and-swap and publishes it by bumping its sequence, and the writer
+ * thread consumes the slots in order. Producers never take a lock; they
+ * only yield if the ring is full.
+ */
+struct LogRing
 {
-    va_list aq;
+    static const size_t slot_count = 1024;
+    /* Longer messages are written synchronously */
+    static const size_t message_size = 512;
 
-    /* Estimate message size */
-    va_copy(aq, ap);
-    int msg_size = vsnprintf(NULL, 0, fmt.c_str(), aq);
-    va_end(aq);
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        Log::Level level;
+        char message[message_size];
+    };
 
-    /* Create the buffer to hold the message */
-    char *buf = new char[msg_size + 1];
+    LogRing() :
+        slots(new Slot[slot_count]), enqueue_pos(0), written(0), quit(false)
+    {
+        for (size_t i = 0; i < slot_count; i++)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        thread = std::thread(&LogRing::run, this);
+    }
 
-    /* Store the message in the buffer */
-    va_copy(aq, ap);
-    vsnprintf(buf, msg_size + 1, fmt.c_str(), aq);
-    va_end(aq);
+    ~LogRing()
+    {
+        quit.store(true, std::memory_order_release);
+        cond.notify_one();
+        thread.join();
+        delete[] slots;
+    }
+
+    void push(Log::Level level, const char *msg, size_t size)
+    {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Slot *slot;
+
+        while (true)
+        {
+            slot = &slots[pos & (slot_count - 1)];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+
+            if (diff == 0)
+            {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed))
+                    break;
+            }
+            else
+            {
+                /* The ring is full, let the writer catch up */
+                if (diff < 0)
+                {
+                    cond.notify_one();
+                    std::this_thread::yield();
+                }
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->level = level;
+        memcpy(slot->message, msg, size);
+        slot->message[size] = '\0';
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        /* Doesn't enter the kernel unless the writer is waiting */
+        cond.notify_one();
+    }
+
+    // Wait for all the messages queued so far to be written
+    void drain()
+    {
+        size_t target = enqueue_pos.load(std::memory_order_acquire);
+
+        while (written.load(std::memory_order_acquire) < target)
+        {
+            cond.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+    void run()
+    {
+        size_t pos = 0;
+
+        while (true)
+        {
+            Slot &slot = slots[pos & (slot_count - 1)];
+
+            if (slot.sequence.load(std::memory_order_acquire) == pos + 1)
+            {
+                Log::emit(slot.level, slot.message);
+                slot.sequence.store(pos + slot_count, std::memory_order_release);
+                pos++;
+                written.store(pos, std::memory_order_release);
+                continue;
+            }
+
+            if (quit.load(std::memory_order_acquire) &&
+                enqueue_pos.load(std::memory_order_acquire) == pos)
+            {
+                break;
+            }
+
+            /* A missed notification only delays the writer by the timeout */
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
+
+    Slot *slots;
+    std::atomic<size_t> enqueue_pos;
+    std::atomic<size_t> written;
+    std::atomic<bool> quit;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable cond;
+};
+
+static LogRing *log_ring(0);
 
+/* Write the pending messages at exit */
+static struct LogRingCleanup
+{
+    ~LogRingCleanup() { Log::async(false); }
+} log_ring_cleanup;
+
+static void
+print_prefixed_message(std::ostream& stream, const string& color, const string& prefix,
+                       const char *buf)
+{
     /*
      * Print the message lines prefixed with the supplied prefix.
      * If the target stream is a terminal make the prefix colored.
@@ -98,78 +227,135 @@ print_prefixed_message(std::ostream& stream, const string& color, const string&
         if (!(ss.rdstate() & std::stringstream::eofbit))
             stream << std::endl;
     }
-
-    delete[] buf;
 }
 
-
 void
-Log::info(const char *fmt, ...)
+Log::emit(Level level, const char *msg)
 {
-    static const string infoprefix("Info");
-    const string& prefix(do_debug_ ? infoprefix : empty);
-    va_list ap;
-    va_start(ap, fmt);
-
+    switch (level)
+    {
+    case LevelInfo:
+    {
+        const string& prefix(do_debug_ ? infoprefix : empty);
+#ifndef ANDROID
+        static const string& infocolor(isatty(fileno(stdout)) ? terminal_color_cyan : empty);
+        const string& color(do_debug_ ? infocolor : empty);
+        print_prefixed_message(std::cout, color, prefix, msg);
+#else
+        __android_log_write(ANDROID_LOG_INFO, appname_.c_str(), msg);
+#endif
+        if (extra_out_)
+            print_prefixed_message(*extra_out_, empty, prefix, msg);
+        break;
+    }
+    case LevelDebug:
+    {
+#ifndef ANDROID
+        static const string& dbgcolor(isatty(fileno(stdout)) ? terminal_color_yellow : empty);
+        print_prefixed_message(std::cout, dbgcolor, dbgprefix, msg);
+#else
+        __android_log_write(ANDROID_LOG_DEBUG, appname_.c_str(), msg);
+#endif
+        if (extra_out_)
+            print_prefixed_message(*extra_out_, empty, dbgprefix, msg);
+        break;
+    }
+    case LevelError:
+    {
 #ifndef ANDROID
-    static const string& infocolor(isatty(fileno(stdout)) ? terminal_color_cyan : empty);
-    const string& color(do_debug_ ? infocolor : empty);
-    print_prefixed_message(std::cout, color, prefix, fmt, ap);
+        static const string& errcolor(isatty(fileno(stderr)) ? terminal_color_red : empty);
+        print_prefixed_message(std::cerr, errcolor, errprefix, msg);
 #else
-    __android_log_vprint(ANDROID_LOG_INFO, appname_.c_str(), fmt, ap);
+        __android_log_write(ANDROID_LOG_ERROR, appname_.c_str(), msg);
 #endif
+        if (extra_out_)
+            print_prefixed_message(*extra_out_, empty, errprefix, msg);
+        break;
+    }
+    }
+}
 
-    if (extra_out_)
-        print_prefixed_message(*extra_out_, empty, prefix, fmt, ap);
+void
+Log::write(Level level, const char *msg, size_t size)
+{
+    if (log_ring && size < LogRing::message_size)
+    {
+        log_ring->push(level, msg, size);
+        return;
+    }
+
+    /* Keep the messages in order */
+    if (log_ring)
+        log_ring->drain();
+
+    emit(level, msg);
+}
+
+void
+Log::vwrite(Level level, const char *fmt, va_list ap)
+{
+    /* Most messages fit in this buffer, which avoids an allocation */
+    char buf[LogRing::message_size];
+    va_list aq;
+
+    va_copy(aq, ap);
+    int msg_size = vsnprintf(buf, sizeof(buf), fmt, aq);
+    va_end(aq);
+
+    if (msg_size < 0)
+        return;
+
+    if (static_cast<size_t>(msg_size) < sizeof(buf))
+    {
+        write(level, buf, msg_size);
+        return;
+    }
+
+    char *big = new char[msg_size + 1];
+
+    va_copy(aq, ap);
+    vsnprintf(big, msg_size + 1, fmt, aq);
+    va_end(aq);
 
+    write(level, big, msg_size);
+
+    delete[] big;
+}
+
+void
+Log::info(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vwrite(LevelInfo, fmt, ap);
     va_end(ap);
 }
 
 void
 Log::debug(const char *fmt, ...)
 {
-    static const string dbgprefix("Debug");
     if (!do_debug_)
         return;
     va_list ap;
     va_start(ap, fmt);
-
-#ifndef ANDROID
-    static const string& dbgcolor(isatty(fileno(stdout)) ? terminal_color_yellow : empty);
-    print_prefixed_message(std::cout, dbgcolor, dbgprefix, fmt, ap);
-#else
-    __android_log_vprint(ANDROID_LOG_DEBUG, appname_.c_str(), fmt, ap);
-#endif
-
-    if (extra_out_)
-        print_prefixed_message(*extra_out_, empty, dbgprefix, fmt, ap);
-
+    vwrite(LevelDebug, fmt, ap);
     va_end(ap);
 }
 
 void
 Log::error(const char *fmt, ...)
 {
-    static const string errprefix("Error");
     va_list ap;
     va_start(ap, fmt);
-
-#ifndef ANDROID
-    static const string& errcolor(isatty(fileno(stderr)) ? terminal_color_red : empty);
-    print_prefixed_message(std::cerr, errcolor, errprefix, fmt, ap);
-#else
-    __android_log_vprint(ANDROID_LOG_ERROR, appname_.c_str(), fmt, ap);
-#endif
-
-    if (extra_out_)
-        print_prefixed_message(*extra_out_, empty, errprefix, fmt, ap);
-
+    vwrite(LevelError, fmt, ap);
     va_end(ap);
 }
 
 void
 Log::flush()
 {
+    if (log_ring)
+        log_ring->drain();
 #ifndef ANDROID
     std::cout.flush();
     std::cerr.flush();
@@ -177,3 +363,17 @@ Log::flush()
     if (extra_out_)
         extra_out_->flush();
 }
+
+void
+Log::async(bool enable)
+{
+    if (enable && !log_ring)
+    {
+        log_ring = new LogRing();
+    }
+    else if (!enable && log_ring)
+    {
+        delete log_ring;
+        log_ring = 0;
+    }
+}
@@ -15,6 +15,8 @@
 
 #include <string>
 #include <iostream>
+#include <cstdarg>
+#include <cstddef>
 
 class Log
 {
@@ -32,13 +34,32 @@ public:
     static void debug(const char *fmt, ...);
     // Emit an error message
     static void error(const char *fmt, ...);
-    // Explicit flush of the log buffer
+    // Explicit flush of the log buffer.  With asynchronous logging, this
+    // also waits for the pending messages to be written.
     static void flush();
+    // Enable or disable asynchronous logging.  When enabled, messages are
+    // formatted by the caller but queued in a lock-free ring and written by
+    // a background thread, so that logging doesn't block on the output.
+    // Disabling it writes the pending messages and stops the thread.
+    static void async(bool enable);
     // A prefix constant that informs the logging infrastructure that the log
     // message is a continuation of a previous log message to be put on the
     // same line.
     static const std::string continuation_prefix;
 private:
+    enum Level
+    {
+        LevelInfo,
+        LevelDebug,
+        LevelError
+    };
+    // Format a message and write it
+    static void vwrite(Level level, const char *fmt, va_list ap);
+    // Write a formatted message, synchronously or through the ring
+    static void write(Level level, const char *msg, size_t size);
+    // Write a formatted message to the outputs
+    static void emit(Level level, const char *msg);
+    friend struct LogRing;
     // A constant for identifying the log messages as originating from a
     // particular application.
     static std::string appname_;
@@ -0,0 +1,320 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#ifndef MAT_SIMD_H_
+#define MAT_SIMD_H_
+
+// The SIMD version is chosen at compile time, SSE on x86 and NEON on ARM.
+// Define LIBMATRIX_NO_SIMD to only use the generic code.
+#if !defined(LIBMATRIX_NO_SIMD)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define LIBMATRIX_SIMD_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LIBMATRIX_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace LibMatrix
+{
+// SIMD versions of the 4x4 matrix operations on floats, used by tmat4<float>
+// and the matrix-vector products.  Matrices are 16 column-major floats.
+//
+// Each function returns false if it can't handle its arguments, in which
+// case the generic code is used.  The generic overloads always do, so only
+// float matrices are accelerated.
+namespace Simd
+{
+
+// Whether the SIMD versions are used.  They can be disabled at run time,
+// e.g. to compare them with the generic code.
+inline bool& enabled()
+{
+    static bool simd_enabled(true);
+    return simd_enabled;
+}
+
+template<typename T>
+inline bool multiply4(T*, const T*, const T*) { return false; }
+template<typename T>
+inline bool transform4(T*, const T*, const T*) { return false; }
+template<typename T>
+inline bool transform4_transposed(T*, const T*, const T*) { return false; }
+template<typename T>
+inline bool transpose4(T*) { return false; }
+template<typename T>
+inline bool inverse4(T*) { return false; }
+
+#if defined(LIBMATRIX_SIMD_SSE)
+
+// dst = a * b.  dst may be a or b.
+inline bool multiply4(float* dst, const float* a, const float* b)
+{
+    if (!enabled())
+        return false;
+
+    __m128 a0(_mm_loadu_ps(a));
+    __m128 a1(_mm_loadu_ps(a + 4));
+    __m128 a2(_mm_loadu_ps(a + 8));
+    __m128 a3(_mm_loadu_ps(a + 12));
+    __m128 col[4];
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        const float* bcol(b + 4 * i);
+        col[i] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bcol[0])),
+                       _mm_mul_ps(a1, _mm_set1_ps(bcol[1]))),
+            _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bcol[2])),
+                       _mm_mul_ps(a3, _mm_set1_ps(bcol[3]))));
+    }
+
+    for (unsigned int i = 0; i < 4; i++)
+        _mm_storeu_ps(dst + 4 * i, col[i]);
+
+    return true;
+}
+
+// dst = m * v
+inline bool transform4(float* dst, const float* m, const float* v)
+{
+    if (!enabled())
+        return false;
+
+    __m128 r(_mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m), _mm_set1_ps(v[0])),
+                   _mm_mul_ps(_mm_loadu_ps(m + 4), _mm_set1_ps(v[1]))),
+        _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(m + 8), _mm_set1_ps(v[2])),
+                   _mm_mul_ps(_mm_loadu_ps(m + 12), _mm_set1_ps(v[3])))));
+    _mm_storeu_ps(dst, r);
+
+    return true;
+}
+
+// dst = v * m, i.e. transpose(m) * v
+inline bool transform4_transposed(float* dst, const float* m, const float* v)
+{
+    if (!enabled())
+        return false;
+
+    __m128 r0(_mm_loadu_ps(m));
+    __m128 r1(_mm_loadu_ps(m + 4));
+    __m128 r2(_mm_loadu_ps(m + 8));
+    __m128 r3(_mm_loadu_ps(m + 12));
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    __m128 r(_mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(r0, _mm_set1_ps(v[0])),
+                   _mm_mul_ps(r1, _mm_set1_ps(v[1]))),
+        _mm_add_ps(_mm_mul_ps(r2, _mm_set1_ps(v[2])),
+                   _mm_mul_ps(r3, _mm_set1_ps(v[3])))));
+    _mm_storeu_ps(dst, r);
+
+    return true;
+}
+
+inline bool transpose4(float* m)
+{
+    if (!enabled())
+        return false;
+
+    __m128 c0(_mm_loadu_ps(m));
+    __m128 c1(_mm_loadu_ps(m + 4));
+    __m128 c2(_mm_loadu_ps(m + 8));
+    __m128 c3(_mm_loadu_ps(m + 12));
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    _mm_storeu_ps(m, c0);
+    _mm_storeu_ps(m + 4, c1);
+    _mm_storeu_ps(m + 8, c2);
+    _mm_storeu_ps(m + 12, c3);
+
+    return true;
+}
+
+#define LIBMATRIX_SHUFFLE(a, b, x, y, z, w) \
+    _mm_shuffle_ps((a), (b), _MM_SHUFFLE((w), (z), (y), (x)))
+
+// The 2x2 block products of inverse4(), on 2x2 matrices stored as
+// (m00, m01, m10, m11).
+
+// a * b
+inline __m128 mat2_mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, LIBMATRIX_SHUFFLE(b, b, 0, 3, 0, 3)),
+                      _mm_mul_ps(LIBMATRIX_SHUFFLE(a, a, 1, 0, 3, 2),
+                                 LIBMATRIX_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+// adjugate(a) * b
+inline __m128 mat2_adj_mul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(LIBMATRIX_SHUFFLE(a, a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(LIBMATRIX_SHUFFLE(a, a, 1, 1, 2, 2),
+                                 LIBMATRIX_SHUFFLE(b, b, 2, 3, 0, 1)));
+}
+
+// a * adjugate(b)
+inline __m128 mat2_mul_adj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, LIBMATRIX_SHUFFLE(b, b, 3, 0, 3, 0)),
+                      _mm_mul_ps(LIBMATRIX_SHUFFLE(a, a, 1, 0, 3, 2),
+                                 LIBMATRIX_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+// Inverts m with the 2x2 block decomposition
+//
+//     M = | A B |    inverse(M) = 1 / |M| * | X Y |
+//         | C D |                           | Z W |
+//
+// computing the adjugates of X, Y, Z and W from the adjugates and
+// determinants of A, B, C and D.  As inverse(transpose(M)) is
+// transpose(inverse(M)), the columns are treated as rows.  A singular m
+// is left to the generic code, which reports it.
+inline bool inverse4(float* m)
+{
+    if (!enabled())
+        return false;
+
+    __m128 r0(_mm_loadu_ps(m));
+    __m128 r1(_mm_loadu_ps(m + 4));
+    __m128 r2(_mm_loadu_ps(m + 8));
+    __m128 r3(_mm_loadu_ps(m + 12));
+
+    __m128 a(_mm_movelh_ps(r0, r1));
+    __m128 b(_mm_movehl_ps(r1, r0));
+    __m128 c(_mm_movelh_ps(r2, r3));
+    __m128 d(_mm_movehl_ps(r3, r2));
+
+    // (|A|, |B|, |C|, |D|)
+    __m128 det_sub(_mm_sub_ps(
+        _mm_mul_ps(LIBMATRIX_SHUFFLE(r0, r2, 0, 2, 0, 2), LIBMATRIX_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+        _mm_mul_ps(LIBMATRIX_SHUFFLE(r0, r2, 1, 3, 1, 3), LIBMATRIX_SHUFFLE(r1, r3, 0, 2, 0, 2))));
+    __m128 det_a(LIBMATRIX_SHUFFLE(det_sub, det_sub, 0, 0, 0, 0));
+    __m128 det_b(LIBMATRIX_SHUFFLE(det_sub, det_sub, 1, 1, 1, 1));
+    __m128 det_c(LIBMATRIX_SHUFFLE(det_sub, det_sub, 2, 2, 2, 2));
+    __m128 det_d(LIBMATRIX_SHUFFLE(det_sub, det_sub, 3, 3, 3, 3));
+
+    __m128 d_c(mat2_adj_mul(d, c));
+    __m128 a_b(mat2_adj_mul(a, b));
+
+    __m128 x(_mm_sub_ps(_mm_mul_ps(det_d, a), mat2_mul(b, d_c)));
+    __m128 w(_mm_sub_ps(_mm_mul_ps(det_a, d), mat2_mul(c, a_b)));
+    __m128 y(_mm_sub_ps(_mm_mul_ps(det_b, c), mat2_mul_adj(d, a_b)));
+    __m128 z(_mm_sub_ps(_mm_mul_ps(det_c, b), mat2_mul_adj(a, d_c)));
+
+    // |M| = |A| |D| + |B| |C| - tr(adj(A) B adj(D) C)
+    __m128 tr(_mm_mul_ps(a_b, LIBMATRIX_SHUFFLE(d_c, d_c, 0, 2, 1, 3)));
+    tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+    tr = _mm_add_ss(tr, LIBMATRIX_SHUFFLE(tr, tr, 1, 1, 1, 1));
+
+    __m128 det(_mm_sub_ss(_mm_add_ss(_mm_mul_ss(det_a, det_d),
+                                     _mm_mul_ss(det_b, det_c)),
+                          tr));
+    if (_mm_cvtss_f32(det) == 0.0f)
+        return false;
+
+    __m128 rdet(_mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f),
+                           LIBMATRIX_SHUFFLE(det, det, 0, 0, 0, 0)));
+    x = _mm_mul_ps(x, rdet);
+    y = _mm_mul_ps(y, rdet);
+    z = _mm_mul_ps(z, rdet);
+    w = _mm_mul_ps(w, rdet);
+
+    // Take the adjugates while storing
+    _mm_storeu_ps(m, LIBMATRIX_SHUFFLE(x, y, 3, 1, 3, 1));
+    _mm_storeu_ps(m + 4, LIBMATRIX_SHUFFLE(x, y, 2, 0, 2, 0));
+    _mm_storeu_ps(m + 8, LIBMATRIX_SHUFFLE(z, w, 3, 1, 3, 1));
+    _mm_storeu_ps(m + 12, LIBMATRIX_SHUFFLE(z, w, 2, 0, 2, 0));
+
+    return true;
+}
+
+#undef LIBMATRIX_SHUFFLE
+
+#elif defined(LIBMATRIX_SIMD_NEON)
+
+// dst = a * b.  dst may be a or b.
+inline bool multiply4(float* dst, const float* a, const float* b)
+{
+    if (!enabled())
+        return false;
+
+    float32x4_t a0(vld1q_f32(a));
+    float32x4_t a1(vld1q_f32(a + 4));
+    float32x4_t a2(vld1q_f32(a + 8));
+    float32x4_t a3(vld1q_f32(a + 12));
+    float32x4_t col[4];
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        const float* bcol(b + 4 * i);
+        float32x4_t r(vmulq_n_f32(a0, bcol[0]));
+        r = vmlaq_n_f32(r, a1, bcol[1]);
+        r = vmlaq_n_f32(r, a2, bcol[2]);
+        col[i] = vmlaq_n_f32(r, a3, bcol[3]);
+    }
+
+    for (unsigned int i = 0; i < 4; i++)
+        vst1q_f32(dst + 4 * i, col[i]);
+
+    return true;
+}
+
+// dst = m * v
+inline bool transform4(float* dst, const float* m, const float* v)
+{
+    if (!enabled())
+        return false;
+
+    float32x4_t r(vmulq_n_f32(vld1q_f32(m), v[0]));
+    r = vmlaq_n_f32(r, vld1q_f32(m + 4), v[1]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 8), v[2]);
+    r = vmlaq_n_f32(r, vld1q_f32(m + 12), v[3]);
+    vst1q_f32(dst, r);
+
+    return true;
+}
+
+// dst = v * m, i.e. transpose(m) * v
+inline bool transform4_transposed(float* dst, const float* m, const float* v)
+{
+    if (!enabled())
+        return false;
+
+    // The de-interleaving load transposes m
+    float32x4x4_t rows(vld4q_f32(m));
+    float32x4_t r(vmulq_n_f32(rows.val[0], v[0]));
+    r = vmlaq_n_f32(r, rows.val[1], v[1]);
+    r = vmlaq_n_f32(r, rows.val[2], v[2]);
+    r = vmlaq_n_f32(r, rows.val[3], v[3]);
+    vst1q_f32(dst, r);
+
+    return true;
+}
+
+inline bool transpose4(float* m)
+{
+    if (!enabled())
+        return false;
+
+    float32x4x4_t rows(vld4q_f32(m));
+    vst1q_f32(m, rows.val[0]);
+    vst1q_f32(m + 4, rows.val[1]);
+    vst1q_f32(m + 8, rows.val[2]);
+    vst1q_f32(m + 12, rows.val[3]);
+
+    return true;
+}
+
+#endif
+
+} // namespace Simd
+} // namespace LibMatrix
+
+#endif // MAT_SIMD_H_
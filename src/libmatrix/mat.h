@@ -15,6 +15,7 @@
 #include <iostream>
 #include <iomanip>
 #include "vec.h"
+#include "mat-simd.h"
 #ifndef USE_EXCEPTIONS
 // If we're not throwing exceptions, we'll need the logger to make sure the
 // caller is informed of errors.
@@ -748,6 +749,9 @@ public:
     // Transpose this.  Return a reference to this.
     tmat4& transpose()
     {
+        if (Simd::transpose4(m_))
+            return *this;
+
         T tmp_val = m_[1];
         m_[1] = m_[4];
         m_[4] = tmp_val;
@@ -788,6 +792,9 @@ public:
     //       throw to avoid undefined behavior.
     tmat4& inverse()
     {
+        if (Simd::inverse4(m_))
+            return *this;
+
         T d(determinant());
         if (d == static_cast<T>(0))
         {
@@ -999,6 +1006,9 @@ public:
     // Multiply this by another matrix.  Return a reference to this.
     tmat4& operator*=(const tmat4& rhs)
     {
+        if (Simd::multiply4(m_, m_, rhs.m_))
+            return *this;
+
         T c0r0((m_[0] * rhs.m_[0]) + (m_[4] * rhs.m_[1]) + (m_[8] * rhs.m_[2]) + (m_[12] * rhs.m_[3]));
         T c0r1((m_[1] * rhs.m_[0]) + (m_[5] * rhs.m_[1]) + (m_[9] * rhs.m_[2]) + (m_[13] * rhs.m_[3]));
         T c0r2((m_[2] * rhs.m_[0]) + (m_[6] * rhs.m_[1]) + (m_[10] * rhs.m_[2]) + (m_[14] * rhs.m_[3]));
@@ -1125,6 +1135,11 @@ const tmat4<T> operator*(const T& lhs, const tmat4<T>& rhs)
 template<typename T>
 const tvec4<T> operator*(const tvec4<T>& lhs, const tmat4<T>& rhs)
 {
+    const T v[4] = { lhs.x(), lhs.y(), lhs.z(), lhs.w() };
+    T r[4];
+    if (Simd::transform4_transposed(r, static_cast<const T*>(rhs), v))
+        return tvec4<T>(r[0], r[1], r[2], r[3]);
+
     T x((lhs.x() * rhs[0][0]) + (lhs.y() * rhs[1][0]) + (lhs.z() * rhs[2][0]) + (lhs.w() * rhs[3][0]));
     T y((lhs.x() * rhs[0][1]) + (lhs.y() * rhs[1][1]) + (lhs.z() * rhs[2][1]) + (lhs.w() * rhs[3][1]));
     T z((lhs.x() * rhs[0][2]) + (lhs.y() * rhs[1][2]) + (lhs.z() * rhs[2][2]) + (lhs.w() * rhs[3][2]));
@@ -1137,6 +1152,11 @@ const tvec4<T> operator*(const tvec4<T>& lhs, const tmat4<T>& rhs)
 template<typename T>
 const tvec4<T> operator*(const tmat4<T>& lhs, const tvec4<T>& rhs)
 {
+    const T v[4] = { rhs.x(), rhs.y(), rhs.z(), rhs.w() };
+    T r[4];
+    if (Simd::transform4(r, static_cast<const T*>(lhs), v))
+        return tvec4<T>(r[0], r[1], r[2], r[3]);
+
     T x((lhs[0][0] * rhs.x()) + (lhs[0][1] * rhs.y()) + (lhs[0][2] * rhs.z()) + (lhs[0][3] * rhs.w()));
     T y((lhs[1][0] * rhs.x()) + (lhs[1][1] * rhs.y()) + (lhs[1][2] * rhs.z()) + (lhs[1][3] * rhs.w()));
     T z((lhs[2][0] * rhs.x()) + (lhs[2][1] * rhs.y()) + (lhs[2][2] * rhs.z()) + (lhs[2][3] * rhs.w()));
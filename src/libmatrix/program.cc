@@ -61,7 +61,7 @@ Shader::~Shader()
 }
 
 void
-Shader::compile()
+Shader::compile(bool wait)
 {
     // Make sure we have a good shader and haven't already compiled it.
     if (!valid_ || ready_)
@@ -69,6 +69,22 @@ Shader::compile()
         return;
     }
     glCompileShader(handle_);
+    if (!wait)
+    {
+        ready_ = true;
+        return;
+    }
+    checkStatus();
+}
+
+bool
+Shader::checkStatus()
+{
+    if (!valid_)
+    {
+        return false;
+    }
+    ready_ = false;
     GLint param = 0;
     glGetShaderiv(handle_, GL_COMPILE_STATUS, &param);
     if (param == GL_FALSE)
@@ -78,9 +94,10 @@ Shader::compile()
         glGetShaderInfoLog(handle_, param + 1, NULL, infoLog);
         message_ = infoLog;
         delete [] infoLog;
-        return;
+        return false;
     }
     ready_ = true;
+    return true;
 }
 
 void
@@ -110,7 +127,8 @@ Shader::release()
 Program::Program() :
     handle_(0),
     ready_(false),
-    valid_(false)
+    valid_(false),
+    pending_(false)
 {
 }
 
@@ -150,7 +168,7 @@ Program::release()
     message_.clear();
 
     // Release all of the symbol map resources.
-    for (std::map<string, Symbol*>::iterator symbolIt = symbols_.begin(); symbolIt != symbols_.end(); symbolIt++)
+    for (std::unordered_map<string, Symbol*>::iterator symbolIt = symbols_.begin(); symbolIt != symbols_.end(); symbolIt++)
     {
         delete (*symbolIt).second;
     }
@@ -163,9 +181,10 @@ Program::release()
     handle_ = 0;
     ready_ = false;
     valid_ = false;
+    pending_ = false;
 }
 void
-Program::addShader(unsigned int type, const string& source)
+Program::addShader(unsigned int type, const string& source, bool wait)
 {
     if (!valid_)
     {
@@ -180,7 +199,7 @@ Program::addShader(unsigned int type, const string& source)
         return;
     }
 
-    shader.compile();
+    shader.compile(wait);
 
     if (!shader.ready())
     {
@@ -195,9 +214,9 @@ Program::addShader(unsigned int type, const string& source)
 }
 
 void
-Program::build()
+Program::build(bool wait)
 {
-    if (!valid_ || ready_)
+    if (!valid_ || ready_ || pending_)
     {
         return;
     }
@@ -209,10 +228,49 @@ Program::build()
     }
 
     glLinkProgram(handle_);
+    pending_ = true;
+    if (wait)
+    {
+        finish();
+    }
+}
+
+bool
+Program::complete()
+{
+    if (!pending_ || !GLExtensions::MaxShaderCompilerThreads)
+    {
+        return true;
+    }
+
+    GLint param = GL_FALSE;
+    glGetProgramiv(handle_, GL_COMPLETION_STATUS_KHR, &param);
+    return param != GL_FALSE;
+}
+
+void
+Program::finish()
+{
+    if (!pending_)
+    {
+        return;
+    }
+    pending_ = false;
+
     GLint param = 1;
     glGetProgramiv(handle_, GL_LINK_STATUS, &param);
     if (param == GL_FALSE)
     {
+        // Prefer reporting the compilation errors of deferred compiles,
+        // since the link failure is just a consequence of them.
+        for (std::vector<Shader>::iterator shaderIt = shaders_.begin(); shaderIt != shaders_.end(); shaderIt++)
+        {
+            if (!shaderIt->checkStatus())
+            {
+                message_ = shaderIt->errorMessage();
+                return;
+            }
+        }
         glGetProgramiv(handle_, GL_INFO_LOG_LENGTH, &param);
         GLchar* infoLog = new GLchar[param + 1];
         glGetProgramInfoLog(handle_, param + 1, NULL, infoLog);
@@ -221,6 +279,56 @@ Program::build()
         return;
     }
     ready_ = true;
+    cacheSymbols();
+}
+
+void
+Program::loadBinary(unsigned int format, const std::vector<unsigned char>& binary)
+{
+    if (!valid_ || ready_ || binary.empty() || !GLExtensions::ProgramBinary)
+    {
+        return;
+    }
+
+    GLExtensions::ProgramBinary(handle_, format, &binary[0], binary.size());
+    GLint param = 0;
+    glGetProgramiv(handle_, GL_LINK_STATUS, &param);
+    if (param == GL_FALSE)
+    {
+        return;
+    }
+    ready_ = true;
+    cacheSymbols();
+}
+
+bool
+Program::getBinary(unsigned int& format, std::vector<unsigned char>& binary)
+{
+    if (!valid_ || !ready_ || !GLExtensions::GetProgramBinary)
+    {
+        return false;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(handle_, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return false;
+    }
+
+    binary.resize(length);
+    GLenum binaryFormat = 0;
+    GLsizei written = 0;
+    GLExtensions::GetProgramBinary(handle_, length, &written, &binaryFormat,
+                                   &binary[0]);
+    if (written <= 0)
+    {
+        binary.clear();
+        return false;
+    }
+    binary.resize(written);
+    format = binaryFormat;
+    return true;
 }
 
 void
@@ -336,10 +444,93 @@ Program::Symbol::operator=(const int& i)
     return *this;
 }
 
+// Looks up the locations of all the active attributes and uniforms of a
+// linked program.  Array uniforms can be referred to both as "name" and
+// "name[0]", and symbols that aren't found here (e.g. other array elements)
+// are still looked up on demand.
+void
+Program::cacheSymbols()
+{
+    GLint count = 0;
+    GLint maxLength = 0;
+    GLint size;
+    GLenum type;
+    GLsizei length;
+
+    glGetProgramiv(handle_, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(handle_, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> buffer(maxLength + 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        length = 0;
+        glGetActiveAttrib(handle_, i, buffer.size(), &length, &size, &type, &buffer[0]);
+        string name(&buffer[0], length);
+        GLint location = glGetAttribLocation(handle_, name.c_str());
+        // Built-in attributes (e.g. gl_VertexID) have no location
+        if (location >= 0 && symbols_.find(name) == symbols_.end())
+        {
+            symbols_[name] = new Symbol(name, location, Symbol::Attribute);
+        }
+    }
+
+    count = 0;
+    maxLength = 0;
+    glGetProgramiv(handle_, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(handle_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    buffer.resize(maxLength + 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        length = 0;
+        glGetActiveUniform(handle_, i, buffer.size(), &length, &size, &type, &buffer[0]);
+        string name(&buffer[0], length);
+        GLint location = glGetUniformLocation(handle_, name.c_str());
+        // Uniforms in uniform blocks have no location
+        if (location < 0)
+        {
+            continue;
+        }
+
+        std::vector<string> names(1, name);
+        string::size_type bracket = name.rfind("[0]");
+        if (bracket != string::npos && bracket + 3 == name.size())
+        {
+            names.push_back(name.substr(0, bracket));
+        }
+
+        for (std::vector<string>::const_iterator nameIt = names.begin(); nameIt != names.end(); nameIt++)
+        {
+            if (symbols_.find(*nameIt) == symbols_.end())
+            {
+                symbols_[*nameIt] = new Symbol(*nameIt, location, Symbol::Uniform);
+            }
+        }
+    }
+}
+
+bool
+Program::bindUniformBlock(const std::string& name, unsigned int binding)
+{
+    if (!ready_ || !GLExtensions::GetUniformBlockIndex || !GLExtensions::UniformBlockBinding)
+    {
+        return false;
+    }
+
+    GLuint index = GLExtensions::GetUniformBlockIndex(handle_, name.c_str());
+    if (index == GL_INVALID_INDEX)
+    {
+        message_ = string("Failed to get uniform block index for \"") + name +
+            string("\"");
+        return false;
+    }
+
+    GLExtensions::UniformBlockBinding(handle_, index, binding);
+    return true;
+}
+
 Program::Symbol&
 Program::operator[](const std::string& name)
 {
-    std::map<std::string, Symbol*>::iterator mapIt = symbols_.find(name);
+    std::unordered_map<std::string, Symbol*>::iterator mapIt = symbols_.find(name);
     if (mapIt == symbols_.end())
     {
         Program::Symbol::SymbolType type(Program::Symbol::Attribute);
@@ -358,3 +549,10 @@ Program::operator[](const std::string& name)
     }
     return *(*mapIt).second;
 }
+
+Program::Symbol&
+Program::operator[](const char* name)
+{
+    lookupKey_.assign(name);
+    return (*this)[lookupKey_];
+}
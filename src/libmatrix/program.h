@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <utility>
 #include "mat.h"
 
@@ -49,8 +50,16 @@ public:
     // Compiles the shader source so that it can be linked into a
     // program.
     //
+    // If "wait" is false, the compilation status is not checked (which
+    // would wait for the compilation to finish), the shader is considered
+    // "ready" and the status has to be checked later with checkStatus().
+    //
     // Make sure the shader is "valid" before calling this one.
-    void compile();
+    void compile(bool wait = true);
+
+    // Checks the status of a compilation started with compile(false).
+    // Returns whether the shader is still "ready".
+    bool checkStatus();
 
     // Attaches a compiled shader to a program in preparation for
     // linking.
@@ -95,17 +104,54 @@ public:
     void release();
 
     // Create a new shader of the given type and source, compile it and
-    // attach it to the program.
+    // attach it to the program. Any stage may be added, e.g. the
+    // tessellation and geometry stages between the vertex and fragment
+    // shaders.
+    //
+    // If "wait" is false, compilation errors are only reported after
+    // build(false) and finish().
     //
     // Make sure the program is "valid" before calling this one.
-    void addShader(unsigned int type, const std::string& source);
+    void addShader(unsigned int type, const std::string& source, bool wait = true);
 
     // Link all of the attached shaders into a runnable program for use
     // in a rendering operation.
     //
+    // If "wait" is false, the program is left "pending" and the link
+    // status is only checked by finish(), so that the implementation can
+    // compile and link several programs in parallel.
+    //
     // Make sure the program is "valid" and that at least one shader
     // has been successfully added before calling this one.
-    void build();
+    void build(bool wait = true);
+
+    // Whether a pending build has completed, so that finish() will not
+    // block.  This can only be determined if GL_KHR_parallel_shader_compile
+    // is supported, otherwise a pending program is always reported as
+    // complete.
+    bool complete();
+
+    // Wait for a pending build to finish and check its status, after
+    // which the program is either "ready" or has an error message.
+    void finish();
+
+    // If "pending" the program was built with build(false), and finish()
+    // has not been called yet.
+    bool pending() const { return pending_; }
+
+    // Load a program binary previously obtained through getBinary(),
+    // instead of adding shaders and building the program.  Binaries may
+    // be rejected by the implementation (e.g. after a driver update), in
+    // which case the program stays "valid" but not "ready", and the shaders
+    // can be added and built as usual.
+    //
+    // Make sure the program is "valid" before calling this one.
+    void loadBinary(unsigned int format, const std::vector<unsigned char>& binary);
+
+    // Retrieve the binary representation of the program, if supported.
+    //
+    // Make sure the program is "ready" before calling this one.
+    bool getBinary(unsigned int& format, std::vector<unsigned char>& binary);
 
     // Bind the program for use by the rendering context (i.e. actually
     // run it).
@@ -149,7 +195,20 @@ private:
     // Get the handle to a named program input (the location in OpenGL
     // vernacular).  Typically used in conjunction with various VertexAttrib
     // interfaces.  Equality operators are used to load uniform data.
+    //
+    // The active attributes and uniforms are looked up once the program is
+    // built, so that this doesn't need to query OpenGL during rendering.
     Symbol& operator[](const std::string& name);
+    // The same, for the names given as literals, which are looked up through
+    // a reused key so that the lookups made for each frame don't allocate
+    // a string for the longer names.
+    Symbol& operator[](const char* name);
+
+    // Bind a named uniform block to a uniform buffer binding point, from
+    // which glBindBufferBase()/glBindBufferRange() can then source it.
+    // Returns whether the block exists; uniform buffer objects require
+    // GL 3.1 or GLES 3.0.
+    bool bindUniformBlock(const std::string& name, unsigned int binding);
 
     // If "valid" then the program has successfully been created.
     // If "ready" then the program has successfully been built.
@@ -159,15 +218,21 @@ private:
     bool ready() const { return ready_; }
     const std::string& errorMessage() const { return message_; }
 
+    // The name of the program object, e.g. to label it for debuggers.
+    unsigned int handle() const { return handle_; }
+
 private:
     int getAttribIndex(const std::string& name);
     int getUniformLocation(const std::string& name);
+    void cacheSymbols();
     unsigned int handle_;
-    std::map<std::string, Symbol*> symbols_;
+    std::unordered_map<std::string, Symbol*> symbols_;
+    std::string lookupKey_;
     std::vector<Shader> shaders_;
     std::string message_;
     bool ready_;
     bool valid_;
+    bool pending_;
 };
 
 #endif // PROGRAM_H_
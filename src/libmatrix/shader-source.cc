@@ -10,6 +10,7 @@
 //     Alexandros Frantzis <alexandros.frantzis@linaro.org>
 //     Jesse Barker <jesse.barker@linaro.org>
 //
+#include <algorithm>
 #include <istream>
 #include <memory>
 
@@ -39,6 +40,10 @@ bool is_valid_shader_type(ShaderSource::ShaderType shader_type)
     switch(shader_type) {
         case ShaderSource::ShaderTypeVertex:
         case ShaderSource::ShaderTypeFragment:
+        case ShaderSource::ShaderTypeCompute:
+        case ShaderSource::ShaderTypeTessControl:
+        case ShaderSource::ShaderTypeTessEvaluation:
+        case ShaderSource::ShaderTypeGeometry:
         case ShaderSource::ShaderTypeUnknown:
             return true;
         default:
@@ -55,6 +60,10 @@ bool is_valid_shader_type(ShaderSource::ShaderType shader_type)
 std::vector<ShaderSource::Precision>
 ShaderSource::default_precision_(ShaderSource::ShaderTypeUnknown + 1);
 
+std::map<std::string, ShaderSource::File> ShaderSource::files_;
+std::map<std::string, std::string> ShaderSource::generated_;
+std::mutex ShaderSource::cache_mutex_;
+
 /**
  * Loads the contents of a file into a string.
  *
@@ -64,25 +73,165 @@ ShaderSource::default_precision_(ShaderSource::ShaderTypeUnknown + 1);
 bool
 ShaderSource::load_file(const std::string& filename, std::string& str)
 {
-    std::unique_ptr<std::istream> is_ptr(Util::get_resource(filename));
-    std::istream& inputFile(*is_ptr);
+    const File *file = find_file(filename, 0);
+
+    if (!file)
+        return false;
+
+    str.append(file->data(), file->size());
+
+    return true;
+}
+
+/**
+ * Gets a loaded file, loading it first if needed.
+ *
+ * Each file is only mapped once, as scenes append the same step files many
+ * times to build their shaders, and the files without #include directives
+ * are appended straight from their mapping.
+ *
+ * @param filename the name of the file
+ * @param depth how many files include the file
+ *
+ * @return the file, or 0 if it couldn't be loaded
+ */
+const ShaderSource::File *
+ShaderSource::find_file(const std::string& filename, unsigned int depth)
+{
+    static const unsigned int max_include_depth = 16;
 
-    if (!inputFile)
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        std::map<std::string, File>::const_iterator iter = files_.find(filename);
+        if (iter != files_.end())
+            return &iter->second;
+    }
+
+    if (depth > max_include_depth) {
+        Log::error("Too many nested includes of \"%s\"\n", filename.c_str());
+        return 0;
+    }
+
+    File file;
+    file.resource.reset(Util::map_resource(filename));
+
+    if (!file.resource->valid())
     {
         Log::error("Failed to open \"%s\"\n", filename.c_str());
-        return false;
+        return 0;
     }
 
-    std::string curLine;
-    while (getline(inputFile, curLine))
+    const char *data = file.resource->data();
+    size_t size = file.resource->size();
+    static const std::string directive("#include");
+
+    /* Every line ends with a newline, including the last one */
+    if (std::search(data, data + size, directive.begin(), directive.end()) == data + size &&
+        (size == 0 || data[size - 1] == '\n'))
     {
-        str += curLine;
-        str += '\n';
+        file.mapped = true;
+    }
+    else if (!expand_includes(filename, data, size, depth, file.contents)) {
+        return 0;
+    }
+    else {
+        file.resource.reset();
+    }
+
+    /* Another thread may have loaded the file meanwhile */
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return &files_.insert(std::make_pair(filename, file)).first->second;
+}
+
+/**
+ * Copies the contents of a file, replacing its #include "name" directives
+ * with the contents of the files they name, relative to its directory.
+ *
+ * @param filename the name of the file
+ * @param data the contents of the file
+ * @param size the size of the contents
+ * @param depth how many files include the file
+ * @param str the string to put the expanded contents into
+ *
+ * @return whether all the included files could be loaded
+ */
+bool
+ShaderSource::expand_includes(const std::string& filename, const char *data,
+                              size_t size, unsigned int depth, std::string& str)
+{
+    std::string::size_type slash = filename.rfind('/');
+    std::string dir(slash == std::string::npos ? "" : filename.substr(0, slash + 1));
+    const char *end = data + size;
+
+    str.reserve(size + 1);
+
+    for (const char *line = data; line < end; ) {
+        const char *line_end = std::find(line, end, '\n');
+        const char *cur = line;
+
+        while (cur < line_end && (*cur == ' ' || *cur == '\t'))
+            cur++;
+
+        std::string rest(cur, line_end);
+        std::string::size_type open = rest.find('"');
+        std::string::size_type close = rest.rfind('"');
+
+        if (rest.compare(0, 8, "#include") == 0 &&
+            open != std::string::npos && close > open + 1)
+        {
+            std::string name(rest.substr(open + 1, close - open - 1));
+            const File *file = find_file(name[0] == '/' ? name : dir + name, depth + 1);
+            if (!file)
+                return false;
+            str.append(file->data(), file->size());
+        }
+        else {
+            str.append(line, line_end);
+            str += '\n';
+        }
+
+        line = line_end + 1;
     }
 
     return true;
 }
 
+/**
+ * Gets a source stored with store_generated().
+ *
+ * @param key the key the source was stored with
+ * @param str the string to put the source into
+ *
+ * @return whether a source was stored with the key
+ */
+bool
+ShaderSource::find_generated(const std::string &key, std::string &str)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    std::map<std::string, std::string>::const_iterator iter = generated_.find(key);
+
+    if (iter == generated_.end())
+        return false;
+
+    str = iter->second;
+    return true;
+}
+
+/**
+ * Stores a generated source, to be found with find_generated().
+ *
+ * The key must identify everything the source was generated from.
+ *
+ * @param key the key to store the source with
+ * @param str the source
+ */
+void
+ShaderSource::store_generated(const std::string &key, const std::string &str)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    generated_[key] = str;
+}
+
 
 /**
  * Appends a string to the shader source.
@@ -92,7 +241,7 @@ ShaderSource::load_file(const std::string& filename, std::string& str)
 void
 ShaderSource::append(const std::string &str)
 {
-    source_ << str;
+    source_ += str;
 }
 
 /**
@@ -103,30 +252,49 @@ ShaderSource::append(const std::string &str)
 void
 ShaderSource::append_file(const std::string &filename)
 {
-    std::string source;
-    if (load_file(filename, source))
-        source_ << source;
+    load_file(filename, source_);
 }
 
 /**
  * Replaces a string in the source with another string.
  *
+ * The source is rebuilt in a single pass, and the inserted string is not
+ * searched for further occurrences.
+ *
  * @param remove the string to replace
  * @param insert the string to replace with
  */
 void
 ShaderSource::replace(const std::string &remove, const std::string &insert)
 {
-    std::string::size_type pos = 0;
-    std::string str(source_.str());
+    if (remove.empty())
+        return;
 
-    while ((pos = str.find(remove, pos)) != std::string::npos) {
-        str.replace(pos, remove.size(), insert);
-        pos++;
+    /* Count the occurrences first, to allocate the result once */
+    size_t count = 0;
+    for (std::string::size_type pos = source_.find(remove);
+         pos != std::string::npos;
+         pos = source_.find(remove, pos + remove.size()))
+    {
+        count++;
     }
 
-    source_.clear();
-    source_.str(str);
+    if (count == 0)
+        return;
+
+    std::string str;
+    str.reserve(source_.size() + count * insert.size() - count * remove.size());
+
+    std::string::size_type start = 0;
+    std::string::size_type pos;
+    while ((pos = source_.find(remove, start)) != std::string::npos) {
+        str.append(source_, start, pos - start);
+        str += insert;
+        start = pos + remove.size();
+    }
+    str.append(source_, start, std::string::npos);
+
+    source_.swap(str);
 }
 
 /**
@@ -155,7 +323,7 @@ void
 ShaderSource::add_global(const std::string &str)
 {
     std::string::size_type pos = 0;
-    std::string source(source_.str());
+    std::string& source(source_);
 
     /* Find the last precision qualifier */
     pos = source.rfind("precision");
@@ -176,13 +344,24 @@ ShaderSource::add_global(const std::string &str)
         if (pos != std::string::npos)
             pos++;
     }
+    else if (source.compare(0, 8, "#version") == 0) {
+        /*
+         * Nothing may come before the #version directive and the
+         * #extension directives after it
+         */
+        pos = 0;
+        while (pos < source.size() &&
+               (source.compare(pos, 8, "#version") == 0 ||
+                source.compare(pos, 10, "#extension") == 0))
+        {
+            pos = source.find("\n", pos);
+            pos = pos == std::string::npos ? source.size() : pos + 1;
+        }
+    }
     else
         pos = 0;
 
     source.insert(pos, str);
-
-    source_.clear();
-    source_.str(source);
 }
 
 /**
@@ -198,7 +377,7 @@ void
 ShaderSource::add_local(const std::string &str, const std::string &function)
 {
     std::string::size_type pos = 0;
-    std::string source(source_.str());
+    std::string& source(source_);
 
     /* Find the function */
     pos = source.find(function);
@@ -210,9 +389,6 @@ ShaderSource::add_local(const std::string &str, const std::string &function)
         pos++;
 
     source.insert(pos, str);
-
-    source_.clear();
-    source_.str(source);
 }
 
 /**
@@ -411,11 +587,17 @@ ShaderSource::type()
 {
     /* Try to infer the type from the source contents */
     if (type_ == ShaderSource::ShaderTypeUnknown) {
-        std::string source(source_.str());
-
-        if (source.find("gl_FragColor") != std::string::npos)
+        if (source_.find("local_size_x") != std::string::npos)
+            type_ = ShaderSource::ShaderTypeCompute;
+        else if (source_.find("layout(vertices") != std::string::npos)
+            type_ = ShaderSource::ShaderTypeTessControl;
+        else if (source_.find("gl_TessCoord") != std::string::npos)
+            type_ = ShaderSource::ShaderTypeTessEvaluation;
+        else if (source_.find("EmitVertex") != std::string::npos)
+            type_ = ShaderSource::ShaderTypeGeometry;
+        else if (source_.find("gl_FragColor") != std::string::npos)
             type_ = ShaderSource::ShaderTypeFragment;
-        else if (source.find("gl_Position") != std::string::npos)
+        else if (source_.find("gl_Position") != std::string::npos)
             type_ = ShaderSource::ShaderTypeVertex;
         else
             Log::debug("Cannot infer shader type from contents. Leaving it Unknown.\n");
@@ -427,12 +609,12 @@ ShaderSource::type()
 /**
  * Helper function that emits a precision statement.
  *
- * @param ss the stringstream to add the statement to
+ * @param str the string to add the statement to
  * @param val the precision value
  * @param type_str the variable type to apply the precision value to
  */
 void
-ShaderSource::emit_precision(std::stringstream& ss, ShaderSource::PrecisionValue val,
+ShaderSource::emit_precision(std::string& str, ShaderSource::PrecisionValue val,
                              const std::string& type_str)
 {
     static const char *precision_map[] = {
@@ -441,35 +623,37 @@ ShaderSource::emit_precision(std::stringstream& ss, ShaderSource::PrecisionValue
 
     if (val == ShaderSource::PrecisionValueHigh) {
         if (type_ == ShaderSource::ShaderTypeFragment)
-            ss << "#ifdef GL_FRAGMENT_PRECISION_HIGH" << std::endl;
+            str += "#ifdef GL_FRAGMENT_PRECISION_HIGH\n";
 
-        ss << "precision highp " << type_str << ";" << std::endl;
+        str += "precision highp " + type_str + ";\n";
 
         if (type_ == ShaderSource::ShaderTypeFragment) {
-            ss << "#else" << std::endl;
-            ss << "precision mediump " << type_str << ";" << std::endl;
-            ss << "#endif" << std::endl;
+            str += "#else\n";
+            str += "precision mediump " + type_str + ";\n";
+            str += "#endif\n";
         }
     }
     else if (is_valid_precision_value(val) &&
              val != ShaderSource::PrecisionValueDefault)
     {
-        ss << "precision " << precision_map[val] << " ";
-        ss << type_str << ";" << std::endl;
+        str += std::string("precision ") + precision_map[val] + " ";
+        str += type_str + ";\n";
     }
 
     /* There is no default precision in the fragment shader, so set it to mediump */
     if (val == ShaderSource::PrecisionValueDefault
         && type_str == "float" && type_ == ShaderSource::ShaderTypeFragment)
     {
-        ss << "precision mediump float;" << std::endl;
+        str += "precision mediump float;\n";
     }
 }
 
 /**
  * Gets a string containing the complete shader source.
  *
- * Precision statements are applied at this point.
+ * Precision statements are applied at this point. If the source starts
+ * with a #version directive, it is kept as the first line, since nothing
+ * but comments may precede it.
  *
  * @return the shader source
  */
@@ -488,36 +672,59 @@ ShaderSource::str()
         precision = default_precision(type_);
 
     /* Create the precision statements */
-    std::stringstream precision_macros_ss;
+    std::string precision_str;
+
+    emit_precision(precision_str, precision.int_precision, "int");
+    emit_precision(precision_str, precision.float_precision, "float");
+    emit_precision(precision_str, precision.sampler2d_precision, "sampler2D");
+    emit_precision(precision_str, precision.samplercube_precision, "samplerCube");
+
+    /*
+     * The #version line and the #extension lines after it, if any, are
+     * kept first, as they must come before any statement.
+     */
+    std::string::size_type version_len = 0;
+    bool version_eol = true;
+    while (version_eol &&
+           (source_.compare(version_len, 8, "#version") == 0 ||
+            source_.compare(version_len, 10, "#extension") == 0))
+    {
+        std::string::size_type eol = source_.find('\n', version_len);
+        version_len = eol == std::string::npos ? source_.size() : eol + 1;
+        version_eol = eol != std::string::npos;
+    }
 
-    precision_macros_ss << "#if defined(GL_ES)";
-    if (type_ == ShaderSource::ShaderTypeFragment)
-        precision_macros_ss << " && defined(GL_FRAGMENT_PRECISION_HIGH)";
-    precision_macros_ss << std::endl;
-    precision_macros_ss << "#define HIGHP_OR_DEFAULT highp" << std::endl;
-    precision_macros_ss << "#else" << std::endl;
-    precision_macros_ss << "#define HIGHP_OR_DEFAULT" << std::endl;
-    precision_macros_ss << "#endif" << std::endl;
-    precision_macros_ss << "#if defined(GL_ES)"  << std::endl;
-    precision_macros_ss << "#define MEDIUMP_OR_DEFAULT mediump" << std::endl;
-    precision_macros_ss << "#else" << std::endl;
-    precision_macros_ss << "#define MEDIUMP_OR_DEFAULT" << std::endl;
-    precision_macros_ss << "#endif" << std::endl;
+    /* Build the complete source in a single buffer */
+    std::string str;
+    str.reserve(source_.size() + precision_str.size() + 512);
 
-    std::stringstream ss;
+    str.append(source_, 0, version_len);
+    if (!version_eol)
+        str += '\n';
 
-    emit_precision(ss, precision.int_precision, "int");
-    emit_precision(ss, precision.float_precision, "float");
-    emit_precision(ss, precision.sampler2d_precision, "sampler2D");
-    emit_precision(ss, precision.samplercube_precision, "samplerCube");
+    str += "#if defined(GL_ES)";
+    if (type_ == ShaderSource::ShaderTypeFragment)
+        str += " && defined(GL_FRAGMENT_PRECISION_HIGH)";
+    str += "\n"
+           "#define HIGHP_OR_DEFAULT highp\n"
+           "#else\n"
+           "#define HIGHP_OR_DEFAULT\n"
+           "#endif\n"
+           "#if defined(GL_ES)\n"
+           "#define MEDIUMP_OR_DEFAULT mediump\n"
+           "#else\n"
+           "#define MEDIUMP_OR_DEFAULT\n"
+           "#endif\n";
 
-    std::string precision_str(ss.str());
     if (!precision_str.empty()) {
-        precision_str.insert(0, "#ifdef GL_ES\n");
-        precision_str.insert(precision_str.size(), "#endif\n");
+        str += "#ifdef GL_ES\n";
+        str += precision_str;
+        str += "#endif\n";
     }
 
-    return precision_macros_ss.str() + precision_str + source_.str();
+    str.append(source_, version_len, std::string::npos);
+
+    return str;
 }
 
 /**
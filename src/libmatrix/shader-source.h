@@ -13,8 +13,12 @@
 #include <string>
 #include <sstream>
 #include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "vec.h"
 #include "mat.h"
+#include "util.h"
 
 /**
  * Helper class for loading and manipulating shader sources.
@@ -25,6 +29,10 @@ public:
     enum ShaderType {
         ShaderTypeVertex,
         ShaderTypeFragment,
+        ShaderTypeCompute,
+        ShaderTypeTessControl,
+        ShaderTypeTessEvaluation,
+        ShaderTypeGeometry,
         ShaderTypeUnknown
     };
 
@@ -61,6 +69,13 @@ public:
     ShaderType type();
     std::string str();
 
+    /*
+     * Memoizes generated sources, e.g. the shaders that scenes build from
+     * their options, so that each variant is only generated once.
+     */
+    static bool find_generated(const std::string &key, std::string &str);
+    static void store_generated(const std::string &key, const std::string &str);
+
     enum PrecisionValue {
         PrecisionValueLow,
         PrecisionValueMedium,
@@ -91,13 +106,37 @@ private:
     void add_global(const std::string &str);
     void add_local(const std::string &str, const std::string &function);
     bool load_file(const std::string& filename, std::string& str);
-    void emit_precision(std::stringstream& ss, ShaderSource::PrecisionValue val,
+
+    /*
+     * A loaded file: a view of its mapping, or its contents with its
+     * #include directives expanded
+     */
+    struct File {
+        File() : mapped(false) {}
+
+        const char *data() const { return mapped ? resource->data() : contents.data(); }
+        size_t size() const { return mapped ? resource->size() : contents.size(); }
+
+        std::shared_ptr<Util::MappedResource> resource;
+        bool mapped;
+        std::string contents;
+    };
+
+    static const File *find_file(const std::string& filename, unsigned int depth);
+    static bool expand_includes(const std::string& filename, const char *data,
+                                size_t size, unsigned int depth, std::string& str);
+    void emit_precision(std::string& str, ShaderSource::PrecisionValue val,
                         const std::string& type_str);
 
-    std::stringstream source_;
+    std::string source_;
     Precision precision_;
     bool precision_has_been_set_;
     ShaderType type_;
 
     static std::vector<Precision> default_precision_;
+
+    /* The loaded files, never removed, and the generated sources */
+    static std::map<std::string, File> files_;
+    static std::map<std::string, std::string> generated_;
+    static std::mutex cache_mutex_;
 };
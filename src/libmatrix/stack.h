@@ -22,48 +22,65 @@ namespace LibMatrix
 // state.  Default construction puts an identity matrix on the top of the 
 // stack.
 //
+// The first InlineDepth levels are stored in the stack object itself, so
+// that the stacks that scenes build for each frame don't allocate; only
+// the deeper levels go to the heap.
+//
 template<typename T>
 class MatrixStack
 {
 public:
-    MatrixStack()
-    {
-        theStack_.push_back(T());
-    }
-    MatrixStack(const T& matrix)
+    MatrixStack() : depth_(1) {}
+    MatrixStack(const T& matrix) : depth_(1)
     {
-        theStack_.push_back(matrix);
+        inline_[0] = matrix;
     }
     ~MatrixStack() {}
 
-    const T& getCurrent() const { return theStack_.back(); }
+    const T& getCurrent() const { return level(depth_ - 1); }
 
     void push()
     {
-        theStack_.push_back(theStack_.back());
+        if (depth_ < InlineDepth)
+            inline_[depth_] = inline_[depth_ - 1];
+        else
+            overflow_.push_back(level(depth_ - 1));
+        depth_++;
     }
     void pop()
     {
-        theStack_.pop_back();
+        depth_--;
+        if (depth_ >= InlineDepth)
+            overflow_.pop_back();
     }
     void loadIdentity()
     {
-        theStack_.back().setIdentity();
+        top().setIdentity();
     }
     T& operator*=(const T& rhs)
     {
-        T& curMatrix = theStack_.back();
+        T& curMatrix = top();
         curMatrix *= rhs;
         return curMatrix;
     }
     void print() const
     {
-        const T& curMatrix = theStack_.back();
+        const T& curMatrix = getCurrent();
         curMatrix.print();
     }
-    unsigned int getDepth() const { return theStack_.size(); }
+    unsigned int getDepth() const { return depth_; }
 private:
-    std::vector<T> theStack_;
+    static const unsigned int InlineDepth = 4;
+
+    T& top() { return const_cast<T&>(level(depth_ - 1)); }
+    const T& level(unsigned int i) const
+    {
+        return i < InlineDepth ? inline_[i] : overflow_[i - InlineDepth];
+    }
+
+    T inline_[InlineDepth];
+    std::vector<T> overflow_;
+    unsigned int depth_;
 };
 
 class Stack4 : public MatrixStack<mat4> 
@@ -0,0 +1,222 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "libmatrix_test.h"
+#include "bvh_test.h"
+#include "../bvh.h"
+#include "../mat.h"
+#include "../mat-simd.h"
+
+using LibMatrix::BVH;
+using LibMatrix::Frustum;
+using LibMatrix::mat4;
+using LibMatrix::vec3;
+using LibMatrix::vec4;
+using std::cout;
+using std::endl;
+using std::vector;
+
+namespace
+{
+
+// A repeatable pseudo-random value in [-1, 1)
+float
+next_value(unsigned int& seed)
+{
+    seed = seed * 1103515245u + 12345u;
+    return ((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+}
+
+// A camera somewhere around the origin, looking at a point near it
+mat4
+make_camera(unsigned int& seed)
+{
+    mat4 projection(LibMatrix::Mat4::perspective(40.0 + 30.0 * next_value(seed),
+                                                 1.5, 1.0, 60.0));
+    mat4 view(LibMatrix::Mat4::lookAt(30.0 * next_value(seed),
+                                      30.0 * next_value(seed),
+                                      30.0 * next_value(seed),
+                                      5.0 * next_value(seed),
+                                      5.0 * next_value(seed),
+                                      5.0 * next_value(seed),
+                                      0.0, 1.0, 0.0));
+    return projection * view;
+}
+
+void
+make_box(unsigned int& seed, vec3& min, vec3& max)
+{
+    vec3 center(20.0 * next_value(seed), 20.0 * next_value(seed),
+                20.0 * next_value(seed));
+    vec3 half(1.0 + next_value(seed), 1.0 + next_value(seed),
+              1.0 + next_value(seed));
+    min = center - half;
+    max = center + half;
+}
+
+// Classifies a box from the clip space positions of its corners, or
+// returns false if a corner is too close to a plane to tell
+bool
+classify_corners(const mat4& m, const vec3& min, const vec3& max,
+                 Frustum::Result& result)
+{
+    static const float margin(1e-3f);
+    unsigned int outside[6] = { 0, 0, 0, 0, 0, 0 };
+    bool inside(true);
+
+    for (unsigned int corner = 0; corner < 8; corner++)
+    {
+        vec4 p(corner & 1 ? max.x() : min.x(),
+               corner & 2 ? max.y() : min.y(),
+               corner & 4 ? max.z() : min.z(), 1.0);
+        vec4 clip(m * p);
+        float distances[6] = {
+            clip.w() + clip.x(), clip.w() - clip.x(),
+            clip.w() + clip.y(), clip.w() - clip.y(),
+            clip.w() + clip.z(), clip.w() - clip.z()
+        };
+
+        for (unsigned int plane = 0; plane < 6; plane++)
+        {
+            float d(distances[plane] / std::max(std::fabs(clip.w()), 1.0f));
+            if (std::fabs(d) < margin)
+                return false;
+            if (d < 0.0f)
+            {
+                outside[plane]++;
+                inside = false;
+            }
+        }
+    }
+
+    result = inside ? Frustum::Inside : Frustum::Intersects;
+    for (unsigned int plane = 0; plane < 6; plane++)
+    {
+        if (outside[plane] == 8)
+            result = Frustum::Outside;
+    }
+
+    return true;
+}
+
+}
+
+void
+BVHTestFrustum::run(const Options& options)
+{
+    bool& simd(LibMatrix::Simd::enabled());
+    unsigned int seed(1);
+    unsigned int counts[3] = { 0, 0, 0 };
+
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        mat4 m(make_camera(seed));
+        Frustum frustum(m);
+
+        for (unsigned int j = 0; j < 100; j++)
+        {
+            vec3 min;
+            vec3 max;
+            make_box(seed, min, max);
+
+            Frustum::Result expected;
+            if (!classify_corners(m, min, max, expected))
+                continue;
+
+            simd = false;
+            Frustum::Result generic(frustum.classify(min, max));
+            simd = true;
+            Frustum::Result accelerated(frustum.classify(min, max));
+
+            // A box across the frustum's edge can be outside all the planes
+            bool conservative(expected == Frustum::Outside &&
+                              generic == Frustum::Intersects);
+            if ((generic != expected && !conservative) || accelerated != generic)
+            {
+                if (options.beVerbose())
+                {
+                    cout << "Box " << min.x() << "," << min.y() << "," << min.z()
+                         << " - " << max.x() << "," << max.y() << "," << max.z()
+                         << " expected " << expected << " generic " << generic
+                         << " SIMD " << accelerated << endl;
+                }
+                return;
+            }
+            counts[expected]++;
+        }
+    }
+
+    // The boxes must exercise all the cases
+    if (!counts[Frustum::Outside] || !counts[Frustum::Intersects] ||
+        !counts[Frustum::Inside])
+    {
+        return;
+    }
+
+    pass_ = true;
+}
+
+void
+BVHTestCull::run(const Options& options)
+{
+    unsigned int seed(2);
+    BVH bvh;
+    vector<vec3> mins;
+    vector<vec3> maxs;
+
+    for (unsigned int i = 0; i < 500; i++)
+    {
+        vec3 min;
+        vec3 max;
+        make_box(seed, min, max);
+        mins.push_back(min);
+        maxs.push_back(max);
+        bvh.add(min, max);
+    }
+    bvh.build();
+
+    for (unsigned int i = 0; i < 50; i++)
+    {
+        Frustum frustum(make_camera(seed));
+        vector<unsigned int> visible;
+        vector<unsigned int> expected;
+
+        bvh.cull(frustum, visible);
+        for (unsigned int j = 0; j < mins.size(); j++)
+        {
+            if (frustum.classify(mins[j], maxs[j]) != Frustum::Outside)
+                expected.push_back(j);
+        }
+
+        // The hierarchy finds each object once, and at least the ones
+        // whose own boxes aren't outside
+        std::sort(visible.begin(), visible.end());
+        if (std::adjacent_find(visible.begin(), visible.end()) != visible.end() ||
+            (!visible.empty() && visible.back() >= mins.size()) ||
+            !std::includes(visible.begin(), visible.end(),
+                           expected.begin(), expected.end()))
+        {
+            if (options.beVerbose())
+            {
+                cout << "Found " << visible.size() << " objects, expected "
+                     << expected.size() << endl;
+            }
+            return;
+        }
+
+        // Only the objects in the leaves across the frustum may be extra
+        if (visible.size() > expected.size() + 4 * bvh.tests())
+            return;
+    }
+
+    pass_ = true;
+}
@@ -0,0 +1,32 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#ifndef BVH_TEST_H_
+#define BVH_TEST_H_
+
+class MatrixTest;
+class Options;
+
+// Compares the frustum tests, SIMD and generic, with the clip space
+// positions of the corners of boxes.
+class BVHTestFrustum : public MatrixTest
+{
+public:
+    BVHTestFrustum() : MatrixTest("bvh::frustum") {}
+    virtual void run(const Options& options);
+};
+
+// Compares the objects the hierarchy finds in frustums with the ones
+// found by testing each object.
+class BVHTestCull : public MatrixTest
+{
+public:
+    BVHTestCull() : MatrixTest("bvh::cull") {}
+    virtual void run(const Options& options);
+};
+#endif // BVH_TEST_H_
@@ -0,0 +1,4 @@
+attribute vec3 position;
+
+uniform mat4 modelview;
+uniform mat4 projection;
@@ -0,0 +1,11 @@
+#include "include-uniforms.glsl"
+
+varying vec4 color;
+
+void
+main(void)
+{
+    vec4 curVertex = vec4(position, 1.0);
+    gl_Position = projection * modelview * curVertex;
+    color = ConstantColor;
+}
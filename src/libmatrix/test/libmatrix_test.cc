@@ -16,9 +16,14 @@
 #include "libmatrix_test.h"
 #include "inverse_test.h"
 #include "transpose_test.h"
+#include "mat4_simd_test.h"
+#include "bvh_test.h"
 #include "const_vec_test.h"
 #include "shader_source_test.h"
 #include "util_split_test.h"
+#include "util_parse_test.h"
+#include "log_async_test.h"
+#include "stack_test.h"
 
 using std::cerr;
 using std::cout;
@@ -43,9 +48,23 @@ main(int argc, char** argv)
     testVec.push_back(new MatrixTest2x2Transpose());
     testVec.push_back(new MatrixTest3x3Transpose());
     testVec.push_back(new MatrixTest4x4Transpose());
+    testVec.push_back(new MatrixTest4x4Simd());
+    testVec.push_back(new BVHTestFrustum());
+    testVec.push_back(new BVHTestCull());
     testVec.push_back(new ShaderSourceBasic());
+    testVec.push_back(new ShaderSourceVersion());
+    testVec.push_back(new ShaderSourceExtension());
+    testVec.push_back(new ShaderSourceComputeType());
+    testVec.push_back(new ShaderSourceStageType());
+    testVec.push_back(new ShaderSourceReplace());
+    testVec.push_back(new ShaderSourceInclude());
     testVec.push_back(new UtilSplitTestNormal());
     testVec.push_back(new UtilSplitTestQuoted());
+    testVec.push_back(new UtilParseTestFloat());
+    testVec.push_back(new UtilParseTestUint());
+    testVec.push_back(new UtilParseTestSplit());
+    testVec.push_back(new LogAsyncTest());
+    testVec.push_back(new StackTestDepth());
 
     for (vector<MatrixTest*>::iterator testIt = testVec.begin();
          testIt != testVec.end();
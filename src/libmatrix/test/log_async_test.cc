@@ -0,0 +1,103 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "libmatrix_test.h"
+#include "log_async_test.h"
+#include "../log.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+namespace
+{
+
+const unsigned int threads = 4;
+// More than the ring holds, so that the producers wait for the writer
+const unsigned int messages = 1000;
+
+void
+log_messages(unsigned int thread)
+{
+    for (unsigned int i = 0; i < messages; i++)
+        Log::info("%u %u\n", thread, i);
+}
+
+}
+
+void
+LogAsyncTest::run(const Options& options)
+{
+    std::stringstream out;
+    std::stringstream discard;
+
+    // Keep the messages off the test output
+    std::streambuf *cout_buf = cout.rdbuf(discard.rdbuf());
+
+    Log::init("log_async_test", false, &out);
+    Log::async(true);
+
+    vector<std::thread> producers;
+    for (unsigned int t = 0; t < threads; t++)
+        producers.push_back(std::thread(log_messages, t));
+    for (unsigned int t = 0; t < threads; t++)
+        producers[t].join();
+
+    // A message longer than a slot is written synchronously, after the
+    // queued ones
+    Log::info("%s\n", string(2000, 'x').c_str());
+    Log::flush();
+
+    // Written once the ring is stopped
+    Log::async(false);
+    Log::info("done\n");
+
+    cout.rdbuf(cout_buf);
+    Log::init("log_async_test", false, 0);
+
+    vector<unsigned int> next(threads, 0);
+    unsigned int count = 0;
+    string line;
+
+    while (std::getline(out, line))
+    {
+        if (count == threads * messages)
+            break;
+
+        std::istringstream ss(line);
+        unsigned int thread = threads;
+        unsigned int i = 0;
+
+        if (!(ss >> thread >> i) || thread >= threads || i != next[thread])
+        {
+            if (options.beVerbose())
+                cout << "Unexpected message \"" << line << "\"" << endl;
+            return;
+        }
+
+        next[thread]++;
+        count++;
+    }
+
+    if (count != threads * messages || line != string(2000, 'x') ||
+        !std::getline(out, line) || line != "done")
+    {
+        if (options.beVerbose())
+            cout << "Got " << count << " numbered messages, then \"" <<
+                line.substr(0, 10) << "\"" << endl;
+        return;
+    }
+
+    pass_ = true;
+}
@@ -0,0 +1,23 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#ifndef LOG_ASYNC_TEST_H_
+#define LOG_ASYNC_TEST_H_
+
+class MatrixTest;
+class Options;
+
+// Logs from several threads through the asynchronous ring, and checks
+// that every message is written once, in order for each thread.
+class LogAsyncTest : public MatrixTest
+{
+public:
+    LogAsyncTest() : MatrixTest("Log::async") {}
+    virtual void run(const Options& options);
+};
+#endif // LOG_ASYNC_TEST_H_
@@ -0,0 +1,132 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#include <iostream>
+#include <cmath>
+#include "libmatrix_test.h"
+#include "mat4_simd_test.h"
+#include "../mat.h"
+
+using LibMatrix::mat4;
+using LibMatrix::vec4;
+using std::cout;
+using std::endl;
+
+namespace
+{
+
+// A repeatable pseudo-random value in [-1, 1)
+float
+next_value(unsigned int& seed)
+{
+    seed = seed * 1103515245u + 12345u;
+    return ((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+}
+
+// A pseudo-random matrix, diagonally dominant so that it is invertible
+mat4
+make_matrix(unsigned int& seed)
+{
+    mat4 m;
+    for (unsigned int c = 0; c < 4; c++)
+    {
+        for (unsigned int r = 0; r < 4; r++)
+        {
+            m[r][c] = next_value(seed) + (r == c ? 4.0f : 0.0f);
+        }
+    }
+    return m;
+}
+
+bool
+equal(const mat4& a, const mat4& b, float tolerance)
+{
+    const float* pa(a);
+    const float* pb(b);
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        if (std::fabs(pa[i] - pb[i]) > tolerance)
+            return false;
+    }
+    return true;
+}
+
+bool
+equal(const vec4& a, const vec4& b, float tolerance)
+{
+    return std::fabs(a.x() - b.x()) <= tolerance &&
+           std::fabs(a.y() - b.y()) <= tolerance &&
+           std::fabs(a.z() - b.z()) <= tolerance &&
+           std::fabs(a.w() - b.w()) <= tolerance;
+}
+
+}
+
+void
+MatrixTest4x4Simd::run(const Options& options)
+{
+    static const float tolerance(1e-5f);
+    bool& simd(LibMatrix::Simd::enabled());
+    unsigned int seed(1);
+
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        mat4 a(make_matrix(seed));
+        mat4 b(make_matrix(seed));
+        vec4 v(next_value(seed), next_value(seed), next_value(seed), next_value(seed));
+
+        simd = false;
+        mat4 product(a);
+        product *= b;
+        mat4 transposed(a);
+        transposed.transpose();
+        mat4 inverse(a);
+        inverse.inverse();
+        vec4 mv(a * v);
+        vec4 vm(v * a);
+
+        simd = true;
+        mat4 simd_product(a);
+        simd_product *= b;
+        mat4 simd_transposed(a);
+        simd_transposed.transpose();
+        mat4 simd_inverse(a);
+        simd_inverse.inverse();
+        vec4 simd_mv(a * v);
+        vec4 simd_vm(v * a);
+
+        // Multiplying a matrix by itself must not use partial results
+        mat4 squared(a);
+        squared *= squared;
+        simd = false;
+        mat4 generic_squared(a);
+        generic_squared *= generic_squared;
+        simd = true;
+
+        if (!equal(product, simd_product, 16 * tolerance) ||
+            !equal(transposed, simd_transposed, 0.0f) ||
+            !equal(inverse, simd_inverse, tolerance) ||
+            !equal(mv, simd_mv, tolerance) ||
+            !equal(vm, simd_vm, tolerance) ||
+            !equal(squared, generic_squared, 16 * tolerance))
+        {
+            if (options.beVerbose())
+            {
+                cout << "Mismatch for matrix" << endl;
+                a.print();
+                cout << "SIMD inverse" << endl;
+                simd_inverse.print();
+                cout << "Generic inverse" << endl;
+                inverse.print();
+            }
+            return;
+        }
+    }
+
+    pass_ = true;
+}
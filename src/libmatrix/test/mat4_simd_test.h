@@ -0,0 +1,22 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#ifndef MAT4_SIMD_TEST_H_
+#define MAT4_SIMD_TEST_H_
+
+class MatrixTest;
+class Options;
+
+// Compares the SIMD mat4 operations against the generic code.
+class MatrixTest4x4Simd : public MatrixTest
+{
+public:
+    MatrixTest4x4Simd() : MatrixTest("mat4::simd") {}
+    virtual void run(const Options& options);
+};
+#endif // MAT4_SIMD_TEST_H_
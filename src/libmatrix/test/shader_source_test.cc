@@ -47,3 +47,108 @@ ShaderSourceAddConstGlobal::run(const Options& options)
     // Compare the output strings to confirm the results.
     pass_ = (src_shader.str() == result_shader.str());
 }
+
+void
+ShaderSourceVersion::run(const Options& options)
+{
+    static const string version("#version 310 es\n");
+    static const string body("void main(void)\n{\n    gl_Position = vec4(0.0);\n}\n");
+
+    ShaderSource source;
+    source.append(version + body);
+    string str(source.str());
+
+    // The #version directive must stay first, followed by the precision
+    // setup and the rest of the source.
+    pass_ = str.compare(0, version.size(), version) == 0 &&
+            str.find("#version", version.size()) == string::npos &&
+            str.size() > body.size() &&
+            str.compare(str.size() - body.size(), body.size(), body) == 0;
+}
+
+void
+ShaderSourceExtension::run(const Options& options)
+{
+    static const string directives("#version 100\n#extension GL_EXT_draw_buffers : require\n");
+    static const string body("void main(void)\n{\n    gl_FragData[1] = vec4(0.0);\n}\n");
+
+    ShaderSource source;
+    source.append(directives + body);
+    source.add_const("Scale", 2.0f);
+    string str(source.str());
+
+    // The #extension directive must stay before the precision statements
+    // and the global constants.
+    string::size_type const_pos = str.find("Scale");
+    pass_ = str.compare(0, directives.size(), directives) == 0 &&
+            str.find("#extension", directives.size()) == string::npos &&
+            const_pos != string::npos && const_pos > directives.size() &&
+            str.compare(str.size() - body.size(), body.size(), body) == 0;
+}
+
+void
+ShaderSourceComputeType::run(const Options& options)
+{
+    ShaderSource source;
+    source.append("layout(local_size_x = 64) in;\nvoid main(void)\n{\n}\n");
+
+    pass_ = source.type() == ShaderSource::ShaderTypeCompute;
+}
+
+void
+ShaderSourceStageType::run(const Options& options)
+{
+    // The tessellation and geometry stages also write gl_Position, so they
+    // must not be taken for vertex shaders.
+    ShaderSource tcs;
+    tcs.append("layout(vertices = 3) out;\nvoid main(void)\n{\n"
+               "    gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;\n}\n");
+    ShaderSource tes;
+    tes.append("layout(triangles) in;\nvoid main(void)\n{\n"
+               "    gl_Position = vec4(gl_TessCoord, 1.0);\n}\n");
+    ShaderSource geom;
+    geom.append("layout(triangles) in;\nlayout(triangle_strip, max_vertices = 3) out;\n"
+                "void main(void)\n{\n    gl_Position = gl_in[0].gl_Position;\n    EmitVertex();\n}\n");
+    ShaderSource vtx;
+    vtx.append("void main(void)\n{\n    gl_Position = vec4(0.0);\n}\n");
+
+    pass_ = tcs.type() == ShaderSource::ShaderTypeTessControl &&
+            tes.type() == ShaderSource::ShaderTypeTessEvaluation &&
+            geom.type() == ShaderSource::ShaderTypeGeometry &&
+            vtx.type() == ShaderSource::ShaderTypeVertex;
+}
+
+void
+ShaderSourceReplace::run(const Options& options)
+{
+    ShaderSource source;
+    source.append("a $X$ b $X$$X$ c");
+
+    // The inserted string is not searched again, so it may contain the
+    // string it replaces.
+    source.replace("$X$", "<$X$>");
+    source.replace("", "never");
+
+    ShaderSource expected;
+    expected.append("a <$X$> b <$X$><$X$> c");
+
+    std::string str;
+    bool found_before = ShaderSource::find_generated("test:replace", str);
+    ShaderSource::store_generated("test:replace", source.str());
+    bool found_after = ShaderSource::find_generated("test:replace", str);
+
+    pass_ = source.str() == expected.str() &&
+            !found_before && found_after && str == expected.str();
+}
+
+void
+ShaderSourceInclude::run(const Options& options)
+{
+    // The included file is found relative to the including one, and the
+    // expanded source is the same as the one written in a single file.
+    ShaderSource included("test/include.vert");
+    ShaderSource included2("test/include.vert");
+    ShaderSource whole("test/basic.vert");
+
+    pass_ = included.str() == whole.str() && included2.str() == whole.str();
+}
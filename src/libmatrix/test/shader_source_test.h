@@ -29,4 +29,46 @@ public:
     virtual void run(const Options& options);
 };
 
+class ShaderSourceVersion : public MatrixTest
+{
+public:
+    ShaderSourceVersion() : MatrixTest("ShaderSource::Version") {}
+    virtual void run(const Options& options);
+};
+
+class ShaderSourceExtension : public MatrixTest
+{
+public:
+    ShaderSourceExtension() : MatrixTest("ShaderSource::Extension") {}
+    virtual void run(const Options& options);
+};
+
+class ShaderSourceComputeType : public MatrixTest
+{
+public:
+    ShaderSourceComputeType() : MatrixTest("ShaderSource::ComputeType") {}
+    virtual void run(const Options& options);
+};
+
+class ShaderSourceStageType : public MatrixTest
+{
+public:
+    ShaderSourceStageType() : MatrixTest("ShaderSource::StageType") {}
+    virtual void run(const Options& options);
+};
+
+class ShaderSourceReplace : public MatrixTest
+{
+public:
+    ShaderSourceReplace() : MatrixTest("ShaderSource::Replace") {}
+    virtual void run(const Options& options);
+};
+
+class ShaderSourceInclude : public MatrixTest
+{
+public:
+    ShaderSourceInclude() : MatrixTest("ShaderSource::Include") {}
+    virtual void run(const Options& options);
+};
+
 #endif // SHADER_SOURCE_TEST_H
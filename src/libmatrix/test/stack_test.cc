@@ -0,0 +1,69 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#include <iostream>
+#include "libmatrix_test.h"
+#include "stack_test.h"
+#include "../stack.h"
+
+using LibMatrix::mat4;
+using LibMatrix::Stack4;
+using std::cout;
+using std::endl;
+
+namespace
+{
+
+// Deeper than the levels stored inline
+const unsigned int levels = 10;
+
+}
+
+void
+StackTestDepth::run(const Options& options)
+{
+    Stack4 stack;
+
+    // Translate each level by its depth, on top of the previous ones
+    for (unsigned int i = 1; i < levels; i++)
+    {
+        stack.push();
+        stack.translate(1.0f, 0.0f, 0.0f);
+    }
+
+    if (stack.getDepth() != levels)
+    {
+        if (options.beVerbose())
+            cout << "Depth is " << stack.getDepth() << " after pushing" << endl;
+        return;
+    }
+
+    for (unsigned int i = levels - 1; i > 0; i--)
+    {
+        mat4 expected(LibMatrix::Mat4::translate(static_cast<float>(i), 0.0f, 0.0f));
+        if (stack.getCurrent() != expected)
+        {
+            if (options.beVerbose())
+            {
+                cout << "Unexpected matrix at level " << i << ":" << endl;
+                stack.print();
+            }
+            return;
+        }
+        stack.pop();
+    }
+
+    if (stack.getDepth() != 1 || stack.getCurrent() != mat4())
+    {
+        if (options.beVerbose())
+            cout << "The bottom level isn't the identity" << endl;
+        return;
+    }
+
+    pass_ = true;
+}
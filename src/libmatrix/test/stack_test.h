@@ -0,0 +1,23 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#ifndef STACK_TEST_H_
+#define STACK_TEST_H_
+
+class MatrixTest;
+class Options;
+
+// Pushes and pops past the levels stored inline in the stack, and checks
+// that each level keeps its matrix.
+class StackTestDepth : public MatrixTest
+{
+public:
+    StackTestDepth() : MatrixTest("Stack4::push") {}
+    virtual void run(const Options& options);
+};
+#endif // STACK_TEST_H_
@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include "libmatrix_test.h"
+#include "util_parse_test.h"
+#include "../util.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+
+void
+UtilParseTestFloat::run(const Options& options)
+{
+    const string test("  1.5\t-2e3 0.125\r\n7 abc");
+    const char *cur(test.c_str());
+    const char *end(cur + test.size());
+    const float expected[] = {1.5f, -2e3f, 0.125f, 0.0f};
+    float value;
+
+    for (unsigned int i = 0; i < sizeof(expected) / sizeof(*expected); i++)
+    {
+        cur = Util::parse_float(cur, end, value);
+
+        if (options.beVerbose())
+        {
+            cout << "Parsed " << value << ", expected " << expected[i] << endl;
+        }
+
+        if (value != expected[i])
+        {
+            return;
+        }
+    }
+
+    // Parsing must stop at the end of the line...
+    if (*cur != '\n')
+    {
+        return;
+    }
+
+    // ... and at anything that isn't a number.
+    cur = Util::parse_float(cur + 1, end, value);
+    if (value != 7.0f)
+    {
+        return;
+    }
+    const char *prev(cur);
+    cur = Util::parse_float(cur, end, value);
+    if (value != 0.0f || std::strcmp(Util::skip_blanks(prev, end), cur) != 0)
+    {
+        return;
+    }
+
+    pass_ = true;
+}
+
+void
+UtilParseTestUint::run(const Options& options)
+{
+    const string test("12/345//6 x");
+    const char *cur(test.c_str());
+    const char *end(cur + test.size());
+    unsigned int a, b, c, d;
+
+    cur = Util::parse_uint(cur, end, a);
+    cur = Util::parse_uint(cur + 1, end, b);
+    cur = Util::parse_uint(cur + 1, end, c);
+    cur = Util::parse_uint(cur + 1, end, d);
+
+    if (options.beVerbose())
+    {
+        cout << "Parsed " << a << ", " << b << ", " << c << ", " << d
+             << ", expected 12, 345, 0, 6" << endl;
+    }
+
+    if (a != 12 || b != 345 || c != 0 || d != 6 || *cur != ' ')
+    {
+        return;
+    }
+
+    pass_ = true;
+}
+
+void
+UtilParseTestSplit::run(const Options& options)
+{
+    // Like the vertex section of an OBJ model
+    static const unsigned int num_lines(100);
+    std::stringstream ss;
+    for (unsigned int i = 0; i < num_lines; i++)
+    {
+        ss << "v " << i * 0.001f << " " << -0.5f * i << " " << 1.0f / (i + 1) << "\n";
+    }
+    const string buffer(ss.str());
+
+    vector<float> split_values;
+    vector<float> parse_values;
+    split_values.reserve(3 * num_lines);
+    parse_values.reserve(3 * num_lines);
+
+    // Line by line, with Util::split() and Util::fromString()
+    std::stringstream in(buffer);
+    string line;
+    while (getline(in, line))
+    {
+        vector<string> elements;
+        Util::split(line.substr(2), ' ', elements, Util::SplitModeFuzzy);
+        for (vector<string>::const_iterator iter = elements.begin();
+             iter != elements.end();
+             iter++)
+        {
+            split_values.push_back(Util::fromString<float>(*iter));
+        }
+    }
+
+    // In place, with Util::parse_float()
+    const char *cur(buffer.c_str());
+    const char *end(cur + buffer.size());
+    while (cur < end)
+    {
+        float value;
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            cur = Util::parse_float(cur + (i == 0 ? 2 : 0), end, value);
+            parse_values.push_back(value);
+        }
+        cur = Util::skip_blanks(cur, end) + 1;
+    }
+
+    if (options.beVerbose())
+    {
+        cout << "Parsed " << parse_values.size() << " floats, split/fromString gave "
+             << split_values.size() << endl;
+    }
+
+    if (split_values != parse_values)
+    {
+        return;
+    }
+
+    pass_ = true;
+}
@@ -0,0 +1,38 @@
+//
+// Copyright (c) 2026 glmark2 contributors
+//
+// All rights reserved. This program and the accompanying materials
+// are made available under the terms of the MIT License which accompanies
+// this distribution, and is available at
+// http://www.opensource.org/licenses/mit-license.php
+//
+#ifndef UTIL_PARSE_TEST_H_
+#define UTIL_PARSE_TEST_H_
+
+class MatrixTest;
+class Options;
+
+class UtilParseTestFloat : public MatrixTest
+{
+public:
+    UtilParseTestFloat() : MatrixTest("Util::parse_float") {}
+    virtual void run(const Options& options);
+};
+
+class UtilParseTestUint : public MatrixTest
+{
+public:
+    UtilParseTestUint() : MatrixTest("Util::parse_uint") {}
+    virtual void run(const Options& options);
+};
+
+// Checks that parsing a buffer with Util::parse_float() gives the same
+// values as Util::split() and Util::fromString().  The two are timed
+// against each other by glmark2-microbench.
+class UtilParseTestSplit : public MatrixTest
+{
+public:
+    UtilParseTestSplit() : MatrixTest("Util::parse::split") {}
+    virtual void run(const Options& options);
+};
+#endif // UTIL_PARSE_TEST_H_
@@ -11,12 +11,22 @@
 //     Jesse Barker <jesse.barker@linaro.org>
 //
 #include <sstream>
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
+#include <map>
+#include <memory>
 #include <sys/time.h>
+#include <algorithm>
+#include <dirent.h>
 #ifdef ANDROID
 #include <android/asset_manager.h>
-#else
-#include <dirent.h>
+#endif
+#if !defined(ANDROID) && !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 #include "log.h"
@@ -218,6 +228,61 @@ Util::split(const string& src, char delim, vector<string>& elementVec,
     }
 }
 
+const char *
+Util::skip_blanks(const char *cur, const char *end)
+{
+    while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\r'))
+        cur++;
+
+    return cur;
+}
+
+const char *
+Util::parse_float(const char *cur, const char *end, float &value)
+{
+    value = 0.0f;
+    cur = skip_blanks(cur, end);
+
+    // strtof() skips all whitespace, including newlines, so don't let it
+    // start at the end of a line.
+    if (cur == end || *cur == '\n')
+        return cur;
+
+    // The buffer may not be terminated, so let strtof() parse a terminated
+    // copy of the token.
+    char token[64];
+    size_t len = 0;
+    while (cur + len < end && len < sizeof(token) - 1 &&
+           cur[len] != ' ' && cur[len] != '\t' && cur[len] != '\r' && cur[len] != '\n')
+    {
+        token[len] = cur[len];
+        len++;
+    }
+    token[len] = '\0';
+
+    char *next;
+    float v = strtof(token, &next);
+    if (next == token)
+        return cur;
+
+    value = v;
+    return cur + (next - token);
+}
+
+const char *
+Util::parse_uint(const char *cur, const char *end, unsigned int &value)
+{
+    value = 0;
+
+    while (cur < end && *cur >= '0' && *cur <= '9')
+    {
+        value = value * 10 + (*cur - '0');
+        cur++;
+    }
+
+    return cur;
+}
+
 uint64_t
 Util::get_timestamp_us()
 {
@@ -228,6 +293,52 @@ Util::get_timestamp_us()
     return now;
 }
 
+uint64_t
+Util::hash64(const std::string &str)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (std::string::const_iterator iter = str.begin(); iter != str.end(); iter++) {
+        h ^= static_cast<unsigned char>(*iter);
+        h *= 0x100000001b3ULL;
+    }
+
+    return h;
+}
+
+std::vector<std::string>
+Util::list_dir(const std::string &path, const std::string &prefix)
+{
+    std::vector<std::string> entries;
+    DIR *dir = opendir(path.c_str());
+
+    if (!dir)
+        return entries;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != 0) {
+        std::string name(entry->d_name);
+        if (name[0] != '.' && name.compare(0, prefix.size(), prefix) == 0)
+            entries.push_back(name);
+    }
+    closedir(dir);
+
+    std::sort(entries.begin(), entries.end());
+
+    return entries;
+}
+
+std::string
+Util::read_first_line(const std::string &path)
+{
+    std::ifstream file(path.c_str());
+    std::string line;
+
+    std::getline(file, line);
+
+    return line;
+}
+
 std::string
 Util::appname_from_path(const std::string& path)
 {
@@ -240,19 +351,305 @@ Util::appname_from_path(const std::string& path)
     return std::string(path, startPos, std::string::npos);
 }
 
+namespace
+{
+
+/*
+ * A read-only stream buffer over the contents of a MappedResource, which
+ * it owns.
+ */
+class MappedResourceBuf : public std::streambuf
+{
+public:
+    MappedResourceBuf(Util::MappedResource *resource) : resource_(resource)
+    {
+        char *begin = const_cast<char *>(resource_->data());
+        setg(begin, begin, begin + resource_->size());
+    }
+
+    ~MappedResourceBuf()
+    {
+        delete resource_;
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which)
+    {
+        if (!(which & std::ios_base::in))
+            return pos_type(off_type(-1));
+
+        off_type size = egptr() - eback();
+        off_type pos = off;
+        if (dir == std::ios_base::cur)
+            pos += gptr() - eback();
+        else if (dir == std::ios_base::end)
+            pos += size;
+
+        if (pos < 0)
+            return pos_type(off_type(-1));
+
+        // Like a file, seeking past the end only fails the next read
+        if (pos > size)
+            pos = size;
+
+        setg(eback(), eback() + pos, egptr());
+        return pos_type(pos);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which)
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+
+private:
+    Util::MappedResource *resource_;
+};
+
+class MappedResourceStream : public std::istream
+{
+public:
+    MappedResourceStream(Util::MappedResource *resource) :
+        std::istream(0), buf_(resource)
+    {
+        rdbuf(&buf_);
+        if (!resource->valid())
+            setstate(std::ios::failbit);
+    }
+
+private:
+    MappedResourceBuf buf_;
+};
+
 #ifndef ANDROID
 
+/*
+ * Reads the whole contents of a file, for when it can't be mapped.
+ */
+bool
+read_file(const std::string &path, std::string &contents)
+{
+    std::ifstream ifs(path.c_str(), std::ios::binary);
+    if (!ifs)
+        return false;
+
+    contents.assign(std::istreambuf_iterator<char>(ifs),
+                    std::istreambuf_iterator<char>());
+    return true;
+}
+
+/*
+ * Collapses the repeated slashes of a path, e.g. of the data path joined
+ * with "/models".
+ */
+std::string
+normalize_path(const std::string &path)
+{
+    std::string normalized;
+
+    for (std::string::const_iterator iter = path.begin(); iter != path.end(); iter++) {
+        if (*iter != '/' || normalized.empty() || normalized[normalized.size() - 1] != '/')
+            normalized += *iter;
+    }
+
+    if (normalized.size() > 1 && normalized[normalized.size() - 1] == '/')
+        normalized.erase(normalized.size() - 1);
+
+    return normalized;
+}
+
+/*
+ * The files of a data directory packed by data/pack-data.py, by their path
+ * relative to the directory.
+ */
+struct ResourcePack
+{
+    ResourcePack() : resource(0) {}
+
+    /*
+     * Gets the path of a file relative to the root of the pack, or an empty
+     * string if it's not under the root.
+     */
+    std::string relative_path(const std::string &path) const
+    {
+        std::string normalized(normalize_path(path));
+
+        if (!resource || normalized.size() <= root.size() + 1 ||
+            normalized.compare(0, root.size(), root) != 0 ||
+            normalized[root.size()] != '/')
+        {
+            return std::string();
+        }
+
+        return normalized.substr(root.size() + 1);
+    }
+
+    Util::MappedResource *resource;
+    std::string root;
+    std::map<std::string, std::pair<const char *, size_t> > files;
+};
+
+ResourcePack resource_pack;
+
+template<typename T> T
+read_le(const char *data)
+{
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); i++)
+        value |= static_cast<T>(static_cast<unsigned char>(data[i])) << (8 * i);
+    return value;
+}
+
+#endif
+
+}
+
+Util::MappedResource::MappedResource() :
+    valid_(false), data_(""), size_(0), mapping_(0)
+{
+}
+
 std::istream *
 Util::get_resource(const std::string &path)
 {
-    std::ifstream *ifs = new std::ifstream(path.c_str(), std::ios::binary);
+    return new MappedResourceStream(map_resource(path));
+}
+
+#ifndef ANDROID
 
-    return static_cast<std::istream *>(ifs);
+Util::MappedResource::~MappedResource()
+{
+#ifndef _WIN32
+    if (mapping_)
+        munmap(mapping_, size_);
+#endif
+}
+
+Util::MappedResource *
+Util::map_resource(const std::string &path)
+{
+    MappedResource *resource = new MappedResource();
+
+    /* The files in the pack point into its mapping */
+    std::map<std::string, std::pair<const char *, size_t> >::const_iterator packed =
+        resource_pack.files.find(resource_pack.relative_path(path));
+    if (packed != resource_pack.files.end()) {
+        resource->data_ = packed->second.first;
+        resource->size_ = packed->second.second;
+        resource->valid_ = true;
+        return resource;
+    }
+
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+
+    if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *mapping = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            resource->mapping_ = mapping;
+            resource->data_ = static_cast<const char *>(mapping);
+            resource->size_ = st.st_size;
+            resource->valid_ = true;
+        }
+    }
+
+    if (fd >= 0)
+        close(fd);
+
+    if (resource->valid_)
+        return resource;
+#endif
+
+    // Empty files, and files that can't be mapped
+    if (read_file(path, resource->copy_)) {
+        resource->data_ = resource->copy_.data();
+        resource->size_ = resource->copy_.size();
+        resource->valid_ = true;
+    }
+
+    return resource;
+}
+
+bool
+Util::open_resource_pack(const std::string &path, const std::string &root)
+{
+    static const size_t header_size = 16;
+    static const size_t entry_size = 24;
+
+    std::unique_ptr<MappedResource> pack(map_resource(path));
+    if (!pack->valid())
+        return false;
+
+    const char *data = pack->data();
+    size_t size = pack->size();
+
+    if (size < header_size || memcmp(data, "GLM2PACK", 8) != 0 ||
+        read_le<uint32_t>(data + 8) != 1)
+    {
+        Log::error("%s is not a glmark2 data pack\n", path.c_str());
+        return false;
+    }
+
+    uint32_t count = read_le<uint32_t>(data + 12);
+    if (count > (size - header_size) / entry_size) {
+        Log::error("The data pack %s is truncated\n", path.c_str());
+        return false;
+    }
+
+    std::map<std::string, std::pair<const char *, size_t> > files;
+
+    for (uint32_t i = 0; i < count; i++) {
+        const char *entry = data + header_size + i * entry_size;
+        uint64_t name_offset = read_le<uint32_t>(entry);
+        uint64_t name_size = read_le<uint32_t>(entry + 4);
+        uint64_t file_offset = read_le<uint64_t>(entry + 8);
+        uint64_t file_size = read_le<uint64_t>(entry + 16);
+
+        if (name_offset + name_size > size || file_offset > size ||
+            file_size > size - file_offset)
+        {
+            Log::error("The data pack %s is truncated\n", path.c_str());
+            return false;
+        }
+
+        files[std::string(data + name_offset, name_size)] =
+            std::make_pair(data + file_offset, static_cast<size_t>(file_size));
+    }
+
+    delete resource_pack.resource;
+    resource_pack.resource = pack.release();
+    resource_pack.root = normalize_path(root);
+    resource_pack.files.swap(files);
+
+    return true;
 }
 
 void
 Util::list_files(const std::string& dirName, std::vector<std::string>& fileVec)
 {
+    /* The directories in the pack are listed from it only */
+    std::string packed_dir(resource_pack.relative_path(dirName + "/."));
+    if (!packed_dir.empty()) {
+        packed_dir.erase(packed_dir.size() - 1);
+        bool found = false;
+
+        for (std::map<std::string, std::pair<const char *, size_t> >::const_iterator iter =
+                 resource_pack.files.lower_bound(packed_dir);
+             iter != resource_pack.files.end() &&
+             iter->first.compare(0, packed_dir.size(), packed_dir) == 0;
+             iter++)
+        {
+            if (iter->first.find('/', packed_dir.size()) == std::string::npos) {
+                fileVec.push_back(dirName + "/" + iter->first.substr(packed_dir.size()));
+                found = true;
+            }
+        }
+
+        if (found)
+            return;
+    }
+
     DIR* dir = opendir(dirName.c_str());
     if (!dir)
     {
@@ -291,28 +688,50 @@ Util::android_get_asset_manager()
     return Util::android_asset_manager;
 }
 
-std::istream *
-Util::get_resource(const std::string &path)
+Util::MappedResource::~MappedResource()
+{
+    if (mapping_)
+        AAsset_close(static_cast<AAsset *>(mapping_));
+}
+
+Util::MappedResource *
+Util::map_resource(const std::string &path)
 {
     std::string path2(path);
     /* Remove leading '/' from path name, it confuses the AssetManager */
     if (path2.size() > 0 && path2[0] == '/')
         path2.erase(0, 1);
 
-    std::stringstream *ss = new std::stringstream;
+    MappedResource *resource = new MappedResource();
     AAsset *asset = AAssetManager_open(Util::android_asset_manager,
-                                       path2.c_str(), AASSET_MODE_RANDOM);
-    if (asset) {
-        ss->write(reinterpret_cast<const char *>(AAsset_getBuffer(asset)),
-                  AAsset_getLength(asset));
+                                       path2.c_str(), AASSET_MODE_BUFFER);
+    /* Uncompressed assets are mapped from the APK, others decompressed once */
+    const void *buffer = asset ? AAsset_getBuffer(asset) : 0;
+
+    if (buffer) {
+        resource->mapping_ = asset;
+        resource->data_ = static_cast<const char *>(buffer);
+        resource->size_ = AAsset_getLength(asset);
+        resource->valid_ = true;
         Log::debug("Load asset %s\n", path2.c_str());
-        AAsset_close(asset);
     }
     else {
+        if (asset)
+            AAsset_close(asset);
         Log::error("Couldn't load asset %s\n", path2.c_str());
     }
 
-    return static_cast<std::istream *>(ss);
+    return resource;
+}
+
+/* The APK already packs the assets */
+bool
+Util::open_resource_pack(const std::string &path, const std::string &root)
+{
+    static_cast<void>(path);
+    static_cast<void>(root);
+
+    return false;
 }
 
 void
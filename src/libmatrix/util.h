@@ -24,6 +24,39 @@
 #endif
 
 struct Util {
+    /**
+     * The read-only contents of a resource, mapped into memory where
+     * possible (mmap(), or the buffer of an AAsset on Android), so that it
+     * can be parsed in place without copies or piecemeal reads.  The
+     * contents are not NUL-terminated.
+     */
+    class MappedResource
+    {
+    public:
+        MappedResource();
+        ~MappedResource();
+
+        /** Whether the resource was opened */
+        bool valid() const { return valid_; }
+        /** The contents of the resource */
+        const char *data() const { return data_; }
+        /** The size of the contents in bytes */
+        size_t size() const { return size_; }
+
+    private:
+        friend struct Util;
+        MappedResource(const MappedResource &);
+        MappedResource &operator=(const MappedResource &);
+
+        bool valid_;
+        const char *data_;
+        size_t size_;
+        /* The mapping, if any, to unmap or close */
+        void *mapping_;
+        /* The contents, if they couldn't be mapped */
+        std::string copy_;
+    };
+
     /**
      * How to perform the split() operation
      */
@@ -52,19 +85,107 @@ struct Util {
     static void split(const std::string& src, char delim,
                       std::vector<std::string>& elems,
                       Util::SplitMode mode);
+    /**
+     * skip_blanks() - Skips spaces, tabs and carriage returns in a buffer
+     *
+     * @cur:        the current position in the buffer
+     * @end:        the end of the buffer
+     *
+     * Returns the position of the first character in [@cur, @end) that is
+     * not a blank.  Newlines are not blanks, so this never moves past the
+     * end of the current line.
+     */
+    static const char *skip_blanks(const char *cur, const char *end);
+    /**
+     * parse_float() - Parses a float from a buffer without allocating
+     *
+     * @cur:        the current position in the buffer
+     * @end:        the end of the buffer
+     * @value:      the float to populate
+     *
+     * Skips leading blanks and parses a floating point number, like
+     * strtof().  Parsing never moves past the end of the current line or
+     * @end, and @value is set to 0 if there is no number there.  The buffer
+     * doesn't need to be terminated (e.g. a MappedResource).
+     *
+     * Returns the position after the parsed number.
+     */
+    static const char *parse_float(const char *cur, const char *end, float &value);
+    /**
+     * parse_uint() - Parses an unsigned integer from a buffer without allocating
+     *
+     * @cur:        the current position in the buffer
+     * @end:        the end of the buffer
+     * @value:      the unsigned integer to populate
+     *
+     * Parses a decimal unsigned integer starting exactly at @cur.  @value is
+     * set to 0 if there is no number there.
+     *
+     * Returns the position after the parsed number.
+     */
+    static const char *parse_uint(const char *cur, const char *end, unsigned int &value);
     /**
      * get_timestamp_us() - Returns the current time in microseconds
      */
     static uint64_t get_timestamp_us();
+    /**
+     * hash64() - Hashes a string with the 64-bit FNV-1a, e.g. to name the
+     *            files of a cache.
+     *
+     * @str:        the string to hash
+     */
+    static uint64_t hash64(const std::string &str);
+    /**
+     * list_dir() - Lists the entries of a directory that start with a prefix.
+     *
+     * @path:       the directory path to be listed
+     * @prefix:     the prefix of the names of the entries to list
+     *
+     * Returns the names of the entries, sorted and without those starting
+     * with '.', or none if the directory can't be read.  Unlike
+     * list_files(), this reads the file system directly, e.g. sysfs.
+     */
+    static std::vector<std::string> list_dir(const std::string &path,
+                                             const std::string &prefix);
+    /**
+     * read_first_line() - Reads the first line of a file, e.g. a sysfs attribute.
+     *
+     * @path:       the path to the file
+     *
+     * Returns the line, which is empty if the file can't be read.
+     */
+    static std::string read_first_line(const std::string &path);
     /**
      * get_resource() - Gets an input filestream for a given file.
      *
      * @path:       the path to the file
      *
      * Returns a pointer to an input stream, which must be deleted when no
-     * longer in use.
+     * longer in use.  The stream reads from a MappedResource of the file.
      */
     static std::istream *get_resource(const std::string &path);
+    /**
+     * map_resource() - Maps the contents of a given file into memory.
+     *
+     * @path:       the path to the file
+     *
+     * Returns a pointer to the MappedResource, which must be deleted when no
+     * longer in use, and is not valid() if the file couldn't be opened.
+     */
+    static MappedResource *map_resource(const std::string &path);
+    /**
+     * open_resource_pack() - Serves the files of a directory from a pack.
+     *
+     * @path:       the path to the pack, made by data/pack-data.py
+     * @root:       the directory whose files are in the pack
+     *
+     * Maps the whole pack into memory, after which map_resource(),
+     * get_resource() and list_files() serve the files under @root from it,
+     * falling back to the filesystem for the files that are not in it.
+     *
+     * Returns whether the pack was opened.
+     */
+    static bool open_resource_pack(const std::string &path, const std::string &root);
     /**
      * list_files() - Get a list of the files in a given directory.
      *
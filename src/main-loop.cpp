@@ -23,17 +23,44 @@
 #include "main-loop.h"
 #include "util.h"
 #include "log.h"
+#include "call-recorder.h"
+#include "startup-report.h"
+#include "trace.h"
+#include "debug-markers.h"
+#include "image-compare.h"
+#include "gl-headers.h"
 
 #include <string>
+#include <fstream>
+#include <cctype>
 #include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
 
 /************
  * MainLoop *
  ************/
 
 MainLoop::MainLoop(Canvas &canvas, const std::vector<Benchmark *> &benchmarks) :
-    canvas_(canvas), benchmarks_(benchmarks)
+    canvas_(canvas), benchmarks_(benchmarks), context_reset_(canvas),
+    render_scale_(canvas), co_runners_(canvas), pipelined_(false)
 {
+    collectors_.push_back(&context_reset_);
+    collectors_.push_back(&memory_);
+    collectors_.push_back(&render_scale_);
+    collectors_.push_back(&co_runners_);
+    collectors_.push_back(&gl_calls_);
+    collectors_.push_back(&perf_counters_);
+    collectors_.push_back(&state_calls_);
+    collectors_.push_back(&flushes_);
+    collectors_.push_back(&pipeline_stats_);
+    collectors_.push_back(&energy_);
+    collectors_.push_back(&metrics_);
+    collectors_.push_back(&allocations_);
+
     reset();
 }
 
@@ -43,27 +70,38 @@ MainLoop::reset()
 {
     scene_ = 0;
     scene_setup_status_ = SceneSetupStatusUnknown;
-    score_ = 0;
-    benchmarks_run_ = 0;
-    bench_iter_ = benchmarks_.begin();
+    scores_.clear();
+    results_.clear();
+    build_runs();
+    bench_iter_ = runs_.begin();
+    size_index_ = 0;
+    apply_sweep_size();
+
+    soak_samples_.clear();
+    if (Options::soak_duration > 0.0)
+        system_monitor_.init();
+    soak_start_ = Util::get_timestamp_us();
+    soak_window_start_ = soak_start_;
+    soak_window_frames_ = 0;
+
+    energy_.init();
 }
 
 unsigned int
 MainLoop::score()
 {
-    if (benchmarks_run_)
-        return score_ / benchmarks_run_;
-    else
-        return score_;
+    return static_cast<unsigned int>(Score::compute(scores_, Options::score_model));
 }
 
 bool
 MainLoop::step()
 {
+    Trace::Scope trace("step");
+
     /* Find the next normal scene */
     if (!scene_) {
         /* Find a normal scene */
-        while (bench_iter_ != benchmarks_.end()) {
+        while (bench_iter_ != runs_.end()) {
             scene_ = &(*bench_iter_)->scene();
 
             /* 
@@ -79,11 +117,17 @@ MainLoop::step()
         }
 
         /* If we have found a valid scene, set it up */
-        if (bench_iter_ != benchmarks_.end()) {
+        if (bench_iter_ != runs_.end()) {
             before_scene_setup();
-            if (!Options::reuse_context)
-                canvas_.reset();
-            scene_ = &(*bench_iter_)->setup_scene();
+            for (auto collector : collectors_)
+                collector->reset();
+            overlay_time_.reset();
+            CallRecorder::begin(scene_->name(), canvas_.fbo(),
+                                canvas_.width(), canvas_.height());
+            {
+                CallRecorder::Scope record;
+                scene_ = &(*bench_iter_)->setup_scene();
+            }
             if (!scene_->running()) {
                 if (!scene_->supported(false))
                     scene_setup_status_ = SceneSetupStatusUnsupported;
@@ -92,6 +136,37 @@ MainLoop::step()
             }
             else {
                 scene_setup_status_ = SceneSetupStatusSuccess;
+                if (Options::gpu_timing && !gpu_timer_.init())
+                    Log::debug("GPU timing is not supported, ignoring --gpu-timing\n");
+                if (Options::present_timing) {
+                    /* Drop the presents of the previous scene's frames */
+                    PresentationList stale;
+                    canvas_.take_presentations(stale);
+                    present_stats_.reset();
+                }
+                if (Options::spike_threshold > 0.0) {
+                    /* Drop the flip waits of the previous scene's frames */
+                    canvas_.take_flip_wait_us();
+                }
+                frame_phases_.reset(Options::spike_threshold);
+                if (Options::capture_interval > 0) {
+                    frame_capture_.init(
+                        FrameCapture::format_from_str(Options::capture_format));
+                }
+                pipelined_ = Options::pipelined && scene_->supports_pipelining();
+                scene_->pipelined(pipelined_);
+                frame_pipeline_.reset();
+                if (!Options::bursts.empty()) {
+                    BurstCycle::Config config;
+                    BurstCycle::parse(Options::bursts, config);
+                    burst_cycle_.start(config);
+                }
+                frame_deadline_ = std::chrono::steady_clock::now();
+                for (auto collector : collectors_)
+                    collector->start(*scene_);
+                /* The first update applies the state prepared here */
+                if (pipelined_)
+                    frame_pipeline_.start(*scene_, false);
             }
             after_scene_setup();
             log_scene_info();
@@ -104,8 +179,19 @@ MainLoop::step()
 
     bool should_quit = canvas_.should_quit();
 
-    if (scene_ ->running() && !should_quit)
+    if (scene_ ->running() && !should_quit) {
+        for (auto collector : collectors_)
+            collector->begin_frame(*scene_);
         draw();
+        for (auto iter = collectors_.rbegin(); iter != collectors_.rend(); iter++)
+            (*iter)->end_frame(*scene_);
+        update_frame_phases(false);
+        pace_frame();
+        StartupReport::frame_presented();
+        update_present_stats();
+        update_soak();
+        update_bursts();
+    }
 
     /*
      * Need to recheck whether the scene is still running, because code
@@ -113,11 +199,38 @@ MainLoop::step()
      */
     if (!scene_->running() || should_quit) {
         if (scene_setup_status_ == SceneSetupStatusSuccess) {
-            score_ += scene_->average_fps();
-            benchmarks_run_++;
+            const std::map<std::string, Scene::Option> &options(scene_->options());
+            Score::Entry entry;
+            entry.scene = scene_->name();
+            entry.options = (*bench_iter_)->options_string();
+            entry.category = options.find("score-category")->second.value;
+            if (entry.category.empty())
+                entry.category = Score::default_category(entry.scene, entry.options);
+            entry.weight = Util::fromString<double>(options.find("score-weight")->second.value);
+            entry.fps = scene_->average_fps();
+            scores_.push_back(entry);
+        }
+        gpu_timer_.collect(true);
+        overlay_gpu_timer_.collect(true);
+        update_frame_phases(true);
+        if (pipelined_) {
+            frame_pipeline_.wait();
+            pipelined_ = false;
         }
+        burst_cycle_.finish();
+        for (auto collector : collectors_)
+            collector->finish();
+        record_scene_result();
         log_scene_result();
+        gpu_timer_.release();
+        overlay_gpu_timer_.release();
+        for (auto collector : collectors_)
+            collector->release();
+        frame_capture_.release();
+        CallRecorder::end();
         (*bench_iter_)->teardown_scene();
+        for (auto collector : collectors_)
+            collector->after_teardown(results_.back());
         scene_ = 0;
         next_benchmark();
     }
@@ -128,12 +241,211 @@ MainLoop::step()
 void
 MainLoop::draw()
 {
-    canvas_.clear();
+    begin_damage();
+
+    CallRecorder::begin_frame(scene_->needs_clear());
+    if (scene_->needs_clear())
+        canvas_.clear();
+
+    draw_and_update_scene();
+
+    end_damage();
+    capture_frame();
+    present();
+    CallRecorder::end_frame();
+}
+
+/*
+ * With a damage-fraction below 1, only a rectangle in the center of the
+ * frame is redrawn, scissored, and reported as damaged, so the GL system
+ * can keep the rest from the previous frames.
+ */
+void
+MainLoop::begin_damage()
+{
+    double fraction = scene_->damage_fraction();
+
+    damage_rect_.clear();
+    if (fraction >= 1.0)
+        return;
+
+    /* The rectangle has the aspect ratio of the frame */
+    int width = std::max(static_cast<int>(canvas_.width() * std::sqrt(fraction)), 1);
+    int height = std::max(static_cast<int>(canvas_.height() * std::sqrt(fraction)), 1);
+
+    damage_rect_.push_back((canvas_.width() - width) / 2);
+    damage_rect_.push_back((canvas_.height() - height) / 2);
+    damage_rect_.push_back(width);
+    damage_rect_.push_back(height);
+
+    canvas_.damage_region(damage_rect_);
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(damage_rect_[0], damage_rect_[1], width, height);
+}
+
+void
+MainLoop::end_damage()
+{
+    if (damage_rect_.empty())
+        return;
+
+    glDisable(GL_SCISSOR_TEST);
+    canvas_.damage(damage_rect_);
+}
+
+/*
+ * The part of the frame that is the scene's own work, recorded with
+ * --record and measured by the collectors apart from the rest.
+ */
+void
+MainLoop::draw_and_update_scene()
+{
+    CallRecorder::Scope record;
+
+    for (auto collector : collectors_)
+        collector->begin_scene_frame(*scene_);
+
+    draw_scene();
+    update_scene();
+
+    for (auto iter = collectors_.rbegin(); iter != collectors_.rend(); iter++)
+        (*iter)->end_scene_frame(*scene_);
+}
+
+void
+MainLoop::draw_scene()
+{
+    Trace::Scope trace("draw");
+    /* Warm-up frames are not included in the GPU time either */
+    bool measure = !scene_->warming_up();
+
+    if (measure)
+        gpu_timer_.begin(frame_phases_.active() ? frame_phases_.frame() : 0);
+    frame_phases_.begin();
+    {
+        DebugMarkers::Group group(scene_->name());
+        scene_->draw();
+    }
+    frame_phases_.end(FramePhases::PhaseDraw);
+    if (measure)
+        gpu_timer_.end();
+}
+
+/*
+ * With --pipelined, the next frame is prepared on the worker thread while
+ * this one is finished and the next one is submitted.
+ */
+void
+MainLoop::update_scene()
+{
+    Trace::Scope trace("update");
+
+    frame_phases_.begin();
+
+    if (pipelined_)
+        frame_pipeline_.wait();
 
-    scene_->draw();
     scene_->update();
 
-    canvas_.update();
+    if (pipelined_ && scene_->running())
+        frame_pipeline_.start(*scene_, !scene_->warming_up());
+
+    frame_phases_.end(FramePhases::PhaseUpdate);
+}
+
+/*
+ * With --bursts, idles once each burst of frames is over, after the GPU has
+ * finished them, so both the CPU and the GPU go idle. The idle periods are
+ * left out of the scene's run, whose duration then only counts the bursts.
+ * The bursts start once the scene has warmed up.
+ */
+void
+MainLoop::update_bursts()
+{
+    if (!burst_cycle_.started() || scene_->warming_up() || !scene_->running())
+        return;
+
+    if (!burst_cycle_.frame())
+        return;
+
+    uint64_t start = Util::get_timestamp_us();
+
+    glFinish();
+    burst_cycle_.idle();
+
+    scene_->skip_time((Util::get_timestamp_us() - start) / 1000000.0);
+}
+
+/*
+ * With --spike-threshold, hands the GPU times that have arrived in, and
+ * ends the phases of the frame just drawn, or those of the scene once its
+ * last GPU times have been collected.
+ */
+void
+MainLoop::update_frame_phases(bool scene_done)
+{
+    if (!frame_phases_.active())
+        return;
+
+    GPUTimer::FrameTimes gpu_times;
+    gpu_timer_.take_frame_times(gpu_times);
+    for (size_t i = 0; i < gpu_times.size(); i++)
+        frame_phases_.add_gpu_time(gpu_times[i].first, gpu_times[i].second);
+
+    if (scene_done) {
+        frame_phases_.finish();
+        return;
+    }
+
+    frame_phases_.add(FramePhases::PhaseFlipWait, canvas_.take_flip_wait_us());
+    frame_phases_.end_frame(!scene_->warming_up());
+}
+
+/*
+ * Presents the frame, timing it with --present-timing so the cost of
+ * presenting e.g. deep color or floating point surfaces shows.
+ */
+void
+MainLoop::present()
+{
+    frame_phases_.begin();
+
+    if (!Options::present_timing || scene_->warming_up()) {
+        canvas_.update();
+    }
+    else {
+        uint64_t start = Util::get_timestamp_us();
+        canvas_.update();
+        present_stats_.add_present_time(Util::get_timestamp_us() - start);
+    }
+
+    frame_phases_.end(FramePhases::PhaseSwap);
+}
+
+void
+MainLoop::capture_frame()
+{
+    if (Options::capture_interval == 0 ||
+        scene_setup_status_ != SceneSetupStatusSuccess ||
+        scene_->warming_up() || scene_->frame_count() == 0)
+    {
+        return;
+    }
+
+    /* The frame count has already been updated for the current frame */
+    unsigned int frame = scene_->frame_count() - 1;
+    if (frame % Options::capture_interval != 0)
+        return;
+
+    std::stringstream ss;
+    ss << Options::capture_dir << "/"
+       << std::setw(3) << std::setfill('0') << results_.size() + 1 << "-"
+       << scene_->name() << "-"
+       << std::setw(6) << std::setfill('0') << frame;
+
+    canvas_.begin_read_pixels();
+    frame_capture_.capture(canvas_.width(), canvas_.height(), ss.str());
+    canvas_.end_read_pixels();
 }
 
 void
@@ -152,10 +464,89 @@ MainLoop::log_scene_result()
                                                 " Unsupported\n");
     static const std::string format_fail(Log::continuation_prefix +
                                          " Set up failed\n");
+    static const char *format_frame_stats =
+        "    FrameTime (ms): min: %.3f p50: %.3f p90: %.3f p99: %.3f "
+        "p99.9: %.3f max: %.3f stddev: %.3f\n";
+    static const char *format_rate = "    %s: %.0f\n";
 
     if (scene_setup_status_ == SceneSetupStatusSuccess) {
+        const FrameStats &stats(scene_->frame_stats());
+        const FrameStats &gpu_stats(gpu_timer_.stats());
+
         Log::info(format_fps.c_str(), scene_->average_fps(),
                                       1000.0 / scene_->average_fps());
+        Log::info(format_frame_stats,
+                  stats.min_ms(), stats.percentile_ms(50.0),
+                  stats.percentile_ms(90.0), stats.percentile_ms(99.0),
+                  stats.percentile_ms(99.9), stats.max_ms(),
+                  stats.stddev_ms());
+        if (gpu_stats.count() > 0)
+            log_measurement("GPUTime", gpu_stats);
+        if (overlay_time_.count() > 0) {
+            log_measurement("OverlayTime", overlay_time_);
+            if (overlay_gpu_timer_.stats().count() > 0)
+                log_measurement("OverlayGPUTime", overlay_gpu_timer_.stats());
+        }
+        if (frame_pipeline_.prepare_stats().count() > 0) {
+            log_measurement("PrepareTime", frame_pipeline_.prepare_stats());
+            log_measurement("PrepareWait", frame_pipeline_.wait_stats());
+        }
+        if (present_stats_.present_time().count() > 0)
+            log_measurement("PresentTime", present_stats_.present_time());
+        if (present_stats_.intervals().count() > 0) {
+            log_measurement("PresentInterval", present_stats_.intervals());
+            if (present_stats_.latency().count() > 0)
+                log_measurement("PresentLatency", present_stats_.latency());
+            Log::info("    MissedVblanks: %llu\n",
+                      static_cast<unsigned long long>(present_stats_.missed_vblanks()));
+            if (present_stats_.flips() + present_stats_.copies() > 0) {
+                Log::info("    PresentModes: flip: %llu copy: %llu\n",
+                          static_cast<unsigned long long>(present_stats_.flips()),
+                          static_cast<unsigned long long>(present_stats_.copies()));
+            }
+        }
+        if (burst_cycle_.bursts() > 0) {
+            Log::info("    Bursts: %u duty cycle: %.0f%% steady: %.3f ms ramp: %.1f frames"
+                      " unsettled: %u\n",
+                      burst_cycle_.bursts(), 100.0 * burst_cycle_.duty_cycle(),
+                      burst_cycle_.steady_ms(), burst_cycle_.ramp_frames(),
+                      burst_cycle_.unsettled());
+            log_measurement("BurstFirstFrame", burst_cycle_.first_frame());
+            log_measurement("BurstRampTime", burst_cycle_.ramp_time());
+        }
+        if (frame_phases_.active()) {
+            std::stringstream ss;
+            ss << "    Spikes: " << frame_phases_.spikes() << " (";
+            for (int i = 0; i < FramePhases::PhaseCount; i++) {
+                FramePhases::Phase phase(static_cast<FramePhases::Phase>(i));
+                ss << (i > 0 ? " " : "") << FramePhases::phase_name(phase)
+                   << ": " << frame_phases_.spikes(phase);
+            }
+            ss << ")\n";
+            Log::info("%s", ss.str().c_str());
+
+            const std::vector<std::string> &reports(frame_phases_.reports());
+            for (size_t i = 0; i < reports.size(); i++)
+                Log::info("      %s\n", reports[i].c_str());
+        }
+        for (auto collector : collectors_)
+            collector->log(*scene_);
+
+        std::vector<Scene::Measurement> measurements(scene_->measurements());
+        for (std::vector<Scene::Measurement>::const_iterator iter = measurements.begin();
+             iter != measurements.end();
+             iter++)
+        {
+            log_measurement(iter->name, *iter->stats);
+        }
+
+        std::vector<Scene::Rate> rates(scene_->rates());
+        for (std::vector<Scene::Rate>::const_iterator iter = rates.begin();
+             iter != rates.end();
+             iter++)
+        {
+            Log::info(format_rate, iter->name.c_str(), iter->value);
+        }
     }
     else if (scene_setup_status_ == SceneSetupStatusUnsupported) {
         Log::info(format_unsupported.c_str());
@@ -165,12 +556,317 @@ MainLoop::log_scene_result()
     }
 }
 
+void
+MainLoop::log_measurement(const std::string &name, const FrameStats &stats)
+{
+    RunCollector::log_measurement(name, stats);
+}
+
+void
+MainLoop::record_scene_result()
+{
+    BenchmarkResult result;
+
+    result.scene = scene_->name();
+    result.options = (*bench_iter_)->options_string();
+    result.width = canvas_.width();
+    result.height = canvas_.height();
+    result.repetition = repetitions_[bench_iter_ - runs_.begin()];
+
+    if (scene_setup_status_ == SceneSetupStatusSuccess) {
+        result.status = BenchmarkResult::StatusSuccess;
+        result.frames = scene_->frame_count();
+        result.elapsed_time = scene_->elapsed_time();
+        result.fps = scene_->average_fps();
+        result.frame_time = scene_->frame_stats().summary();
+        result.gpu_time = gpu_timer_.stats().summary();
+
+        if (overlay_time_.count() > 0) {
+            result.measurements.push_back(
+                std::make_pair("overlay_time", overlay_time_.summary()));
+            if (overlay_gpu_timer_.stats().count() > 0) {
+                result.measurements.push_back(
+                    std::make_pair("overlay_gpu_time", overlay_gpu_timer_.stats().summary()));
+            }
+        }
+
+        if (frame_pipeline_.prepare_stats().count() > 0) {
+            result.measurements.push_back(
+                std::make_pair("prepare_time", frame_pipeline_.prepare_stats().summary()));
+            result.measurements.push_back(
+                std::make_pair("prepare_wait", frame_pipeline_.wait_stats().summary()));
+        }
+
+        if (burst_cycle_.bursts() > 0) {
+            result.measurements.push_back(
+                std::make_pair("burst_first_frame", burst_cycle_.first_frame().summary()));
+            result.measurements.push_back(
+                std::make_pair("burst_ramp_time", burst_cycle_.ramp_time().summary()));
+            result.rates.push_back(std::make_pair("burst_steady_frame_time",
+                                                  burst_cycle_.steady_ms()));
+            result.rates.push_back(std::make_pair("burst_ramp_frames",
+                                                  burst_cycle_.ramp_frames()));
+            result.rates.push_back(
+                std::make_pair("bursts_unsettled",
+                               static_cast<double>(burst_cycle_.unsettled())));
+        }
+
+        if (present_stats_.present_time().count() > 0) {
+            result.measurements.push_back(
+                std::make_pair("present_time", present_stats_.present_time().summary()));
+        }
+
+        if (present_stats_.intervals().count() > 0) {
+            result.measurements.push_back(
+                std::make_pair("present_interval", present_stats_.intervals().summary()));
+            if (present_stats_.latency().count() > 0) {
+                result.measurements.push_back(
+                    std::make_pair("present_latency", present_stats_.latency().summary()));
+            }
+            result.rates.push_back(
+                std::make_pair("missed_vblanks",
+                               static_cast<double>(present_stats_.missed_vblanks())));
+            if (present_stats_.flips() + present_stats_.copies() > 0) {
+                result.rates.push_back(
+                    std::make_pair("present_flips",
+                                   static_cast<double>(present_stats_.flips())));
+                result.rates.push_back(
+                    std::make_pair("present_copies",
+                                   static_cast<double>(present_stats_.copies())));
+            }
+        }
+
+        for (auto collector : collectors_)
+            collector->record(*scene_, result);
+
+        std::vector<Scene::Measurement> measurements(scene_->measurements());
+        for (std::vector<Scene::Measurement>::const_iterator iter = measurements.begin();
+             iter != measurements.end();
+             iter++)
+        {
+            result.measurements.push_back(
+                std::make_pair(iter->key, iter->stats->summary()));
+        }
+
+        std::vector<Scene::Rate> rates(scene_->rates());
+        for (std::vector<Scene::Rate>::const_iterator iter = rates.begin();
+             iter != rates.end();
+             iter++)
+        {
+            result.rates.push_back(std::make_pair(iter->key, iter->value));
+        }
+    }
+    else if (scene_setup_status_ == SceneSetupStatusUnsupported) {
+        result.status = BenchmarkResult::StatusUnsupported;
+    }
+    else {
+        result.status = BenchmarkResult::StatusFailure;
+    }
+
+    results_.push_back(result);
+}
+
 void
 MainLoop::next_benchmark()
 {
     bench_iter_++;
-    if (bench_iter_ == benchmarks_.end() && Options::run_forever)
-        bench_iter_ = benchmarks_.begin();
+
+    /* Run all the benchmarks again at the next size of the sweep */
+    if (bench_iter_ == runs_.end() &&
+        size_index_ + 1 < Options::size_sweep.size())
+    {
+        size_index_++;
+        apply_sweep_size();
+        bench_iter_ = runs_.begin();
+    }
+
+    if (bench_iter_ == runs_.end() && loop_benchmarks()) {
+        bench_iter_ = runs_.begin();
+        if (size_index_ > 0) {
+            size_index_ = 0;
+            apply_sweep_size();
+        }
+    }
+}
+
+/*
+ * Whether to loop back to the first benchmark after the last one, with
+ * --run-forever, or with --soak until its duration has elapsed.
+ */
+bool
+MainLoop::loop_benchmarks()
+{
+    if (Options::run_forever)
+        return true;
+
+    double elapsed = (Util::get_timestamp_us() - soak_start_) / 1000000.0;
+
+    return Options::soak_duration > 0.0 && elapsed < Options::soak_duration;
+}
+
+/*
+ * Collects the presentation feedback of the frames presented so far. The
+ * feedback arrives a few frames late, so frames presented shortly after the
+ * warm-up are measured, while the last frames of a scene are not.
+ */
+void
+MainLoop::update_present_stats()
+{
+    if (!Options::present_timing)
+        return;
+
+    PresentationList presentations;
+    canvas_.take_presentations(presentations);
+
+    if (scene_->warming_up())
+        return;
+
+    for (PresentationList::const_iterator iter = presentations.begin();
+         iter != presentations.end();
+         iter++)
+    {
+        present_stats_.add(*iter);
+        scene_->presented(*iter);
+    }
+}
+
+/*
+ * Samples the average FPS and the system sensors at the end of each soak
+ * interval.
+ */
+/*
+ * With --target-fps, each frame is presented no earlier than one frame
+ * interval after the previous one, sleeping until then. Late frames push
+ * the deadline back, rather than making the next frames catch up.
+ */
+void
+MainLoop::pace_frame()
+{
+    if (Options::target_fps <= 0.0)
+        return;
+
+    std::chrono::steady_clock::duration interval(
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(1.0 / Options::target_fps)));
+    std::chrono::steady_clock::time_point now(std::chrono::steady_clock::now());
+
+    frame_deadline_ += interval;
+
+    if (frame_deadline_ > now)
+        std::this_thread::sleep_until(frame_deadline_);
+    else if (now - frame_deadline_ > interval)
+        frame_deadline_ = now;
+}
+
+void
+MainLoop::update_soak()
+{
+    if (Options::soak_duration <= 0.0)
+        return;
+
+    soak_window_frames_++;
+
+    uint64_t now = Util::get_timestamp_us();
+    double window = (now - soak_window_start_) / 1000000.0;
+
+    if (window < Options::soak_interval)
+        return;
+
+    SoakSample sample;
+    sample.time = (now - soak_start_) / 1000000.0;
+    sample.fps = soak_window_frames_ / window;
+    sample.scene = scene_->name();
+    sample.options = (*bench_iter_)->options_string();
+    sample.sensors = system_monitor_.read();
+    soak_samples_.push_back(sample);
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1)
+       << "Soak: " << sample.time << "s " << sample.scene << " FPS: " << sample.fps;
+    for (size_t i = 0; i < sample.sensors.size(); i++)
+        ss << " " << sample.sensors[i].first << ": " << sample.sensors[i].second;
+    Log::debug("%s\n", ss.str().c_str());
+
+    soak_window_start_ = now;
+    soak_window_frames_ = 0;
+}
+
+/*
+ * Lists the benchmark runs in the order of --repeat-order. Benchmarks that
+ * only set options are not repeated with the sequential order, and are run
+ * first with the shuffled order, since their position can't be kept.
+ */
+void
+MainLoop::build_runs()
+{
+    unsigned int repeat = std::max(Options::repeat, 1u);
+
+    runs_.clear();
+    repetitions_.clear();
+
+    /* A benchmark file can set the number of runs of its benchmarks */
+    unsigned int max_repeat = repeat;
+    for (size_t i = 0; i < benchmarks_.size(); i++)
+        max_repeat = std::max(max_repeat, benchmarks_[i]->repeat());
+
+    if (Options::repeat_order == Options::RepeatOrderInterleaved) {
+        for (unsigned int r = 1; r <= max_repeat; r++) {
+            for (size_t i = 0; i < benchmarks_.size(); i++) {
+                Benchmark *bench = benchmarks_[i];
+                unsigned int bench_repeat = bench->repeat() ? bench->repeat() : repeat;
+                /* The benchmarks setting options are run every time */
+                if (r <= bench_repeat || bench->scene().name().empty()) {
+                    runs_.push_back(bench);
+                    repetitions_.push_back(r);
+                }
+            }
+        }
+        return;
+    }
+
+    std::vector<std::pair<Benchmark *, unsigned int> > repeated;
+
+    for (std::vector<Benchmark *>::const_iterator iter = benchmarks_.begin();
+         iter != benchmarks_.end();
+         iter++)
+    {
+        bool sets_options = (*iter)->scene().name().empty();
+        unsigned int bench_repeat = (*iter)->repeat() ? (*iter)->repeat() : repeat;
+
+        for (unsigned int r = 1; r <= (sets_options ? 1 : bench_repeat); r++) {
+            if (Options::repeat_order == Options::RepeatOrderShuffled && !sets_options) {
+                repeated.push_back(std::make_pair(*iter, r));
+            }
+            else {
+                runs_.push_back(*iter);
+                repetitions_.push_back(r);
+            }
+        }
+    }
+
+    /* Use a fixed seed, so that the order is the same for every run */
+    std::mt19937 random(1);
+    std::shuffle(repeated.begin(), repeated.end(), random);
+
+    for (size_t i = 0; i < repeated.size(); i++) {
+        runs_.push_back(repeated[i].first);
+        repetitions_.push_back(repeated[i].second);
+    }
+}
+
+void
+MainLoop::apply_sweep_size()
+{
+    if (size_index_ >= Options::size_sweep.size())
+        return;
+
+    const std::pair<int,int> &size(Options::size_sweep[size_index_]);
+
+    canvas_.resize(size.first, size.second);
+
+    Log::info("=======================================================\n");
+    Log::info("    Size: %dx%d\n", canvas_.width(), canvas_.height());
+    Log::info("=======================================================\n");
 }
 
 /**********************
@@ -179,17 +875,18 @@ MainLoop::next_benchmark()
 
 MainLoopDecoration::MainLoopDecoration(Canvas &canvas, const std::vector<Benchmark *> &benchmarks) :
     MainLoop(canvas, benchmarks), show_fps_(false), show_title_(false),
-    fps_renderer_(0), title_renderer_(0), last_fps_(0)
+    show_graph_(false), text_renderer_(0), fps_text_(0), title_text_(0),
+    frame_graph_(0), graph_timestamp_(0), last_fps_(0)
 {
 
 }
 
 MainLoopDecoration::~MainLoopDecoration()
 {
-    delete fps_renderer_;
-    fps_renderer_ = 0;
-    delete title_renderer_;
-    title_renderer_ = 0;
+    delete text_renderer_;
+    text_renderer_ = 0;
+    delete frame_graph_;
+    frame_graph_ = 0;
 }
 
 void
@@ -197,34 +894,64 @@ MainLoopDecoration::draw()
 {
     static const unsigned int fps_interval = 500000;
 
-    canvas_.clear();
-
-    scene_->draw();
-    scene_->update();
-
-    if (show_fps_) {
+    if (frame_graph_) {
         uint64_t now = Util::get_timestamp_us();
-        if (now - fps_timestamp_ >= fps_interval) {
-            last_fps_ = scene_->average_fps();
-            fps_renderer_update_text(last_fps_);
-            fps_timestamp_ = now;
+        if (graph_timestamp_ > 0) {
+            uint64_t gpu_us = gpu_timer_.last_us();
+            frame_graph_->add((now - graph_timestamp_) / 1000.0,
+                              gpu_us > 0 ? gpu_us / 1000.0 : -1.0);
         }
-        fps_renderer_->render();
+        graph_timestamp_ = now;
     }
 
-    if (show_title_)
-        title_renderer_->render();
+    begin_damage();
 
-    canvas_.update();
+    CallRecorder::begin_frame(scene_->needs_clear());
+    if (scene_->needs_clear())
+        canvas_.clear();
+
+    draw_and_update_scene();
+
+    if (text_renderer_ || frame_graph_) {
+        /* Measure the decorations apart, they aren't part of the scene */
+        bool measure = !scene_->warming_up();
+        uint64_t start = Util::get_timestamp_us();
+
+        if (measure)
+            overlay_gpu_timer_.begin();
+
+        if (show_fps_) {
+            if (start - fps_timestamp_ >= fps_interval) {
+                last_fps_ = scene_->average_fps();
+                fps_renderer_update_text(last_fps_);
+                fps_timestamp_ = start;
+            }
+        }
+
+        if (frame_graph_)
+            frame_graph_->render();
+        if (text_renderer_)
+            text_renderer_->render();
+
+        if (measure) {
+            overlay_gpu_timer_.end();
+            overlay_time_.add(Util::get_timestamp_us() - start);
+        }
+    }
+
+    end_damage();
+    capture_frame();
+    present();
+    CallRecorder::end_frame();
 }
 
 void
 MainLoopDecoration::before_scene_setup()
 {
-    delete fps_renderer_;
-    fps_renderer_ = 0;
-    delete title_renderer_;
-    title_renderer_ = 0;
+    delete text_renderer_;
+    text_renderer_ = 0;
+    delete frame_graph_;
+    frame_graph_ = 0;
 }
 
 void
@@ -234,13 +961,36 @@ MainLoopDecoration::after_scene_setup()
     const Scene::Option &title_option(scene_->options().find("title")->second);
     show_fps_ = show_fps_option.value == "true";
     show_title_ = !title_option.value.empty();
+    show_graph_ = scene_->options().find("show-graph")->second.value == "true";
+
+    if (!show_fps_ && !show_title_ && !show_graph_)
+        return;
+
+    if (Options::gpu_timing && scene_setup_status_ == SceneSetupStatusSuccess)
+        overlay_gpu_timer_.init();
+
+    if (show_graph_) {
+        const Scene::Option &graph_pos_option(scene_->options().find("graph-pos")->second);
+        const Scene::Option &graph_size_option(scene_->options().find("graph-size")->second);
+        frame_graph_ = new FrameGraph();
+        frame_graph_->position(vec2_from_pos_string(graph_pos_option.value));
+        frame_graph_->size(vec2_from_pos_string(graph_size_option.value));
+        /* Without a target, assume a 60 Hz display */
+        frame_graph_->budget(1000.0 / (Options::target_fps > 0.0 ? Options::target_fps : 60.0));
+        graph_timestamp_ = 0;
+    }
+
+    if (!show_fps_ && !show_title_)
+        return;
+
+    text_renderer_ = new TextRenderer(canvas_);
 
     if (show_fps_) {
         const Scene::Option &fps_pos_option(scene_->options().find("fps-pos")->second);
         const Scene::Option &fps_size_option(scene_->options().find("fps-size")->second);
-        fps_renderer_ = new TextRenderer(canvas_);
-        fps_renderer_->position(vec2_from_pos_string(fps_pos_option.value));
-        fps_renderer_->size(Util::fromString<float>(fps_size_option.value));
+        fps_text_ = text_renderer_->add();
+        text_renderer_->position(fps_text_, vec2_from_pos_string(fps_pos_option.value));
+        text_renderer_->size(fps_text_, Util::fromString<float>(fps_size_option.value));
         fps_renderer_update_text(last_fps_);
         fps_timestamp_ = Util::get_timestamp_us();
     }
@@ -248,18 +998,18 @@ MainLoopDecoration::after_scene_setup()
     if (show_title_) {
         const Scene::Option &title_pos_option(scene_->options().find("title-pos")->second);
         const Scene::Option &title_size_option(scene_->options().find("title-size")->second);
-        title_renderer_ = new TextRenderer(canvas_);
-        title_renderer_->position(vec2_from_pos_string(title_pos_option.value));
-        title_renderer_->size(Util::fromString<float>(title_size_option.value));
+        title_text_ = text_renderer_->add();
+        text_renderer_->position(title_text_, vec2_from_pos_string(title_pos_option.value));
+        text_renderer_->size(title_text_, Util::fromString<float>(title_size_option.value));
 
         if (title_option.value == "#info#")
-            title_renderer_->text(scene_->info_string());
+            text_renderer_->text(title_text_, scene_->info_string());
         else if (title_option.value == "#name#")
-            title_renderer_->text(scene_->name());
+            text_renderer_->text(title_text_, scene_->name());
         else if (title_option.value == "#r2d2#")
-            title_renderer_->text("Help me, Obi-Wan Kenobi. You're my only hope.");
+            text_renderer_->text(title_text_, "Help me, Obi-Wan Kenobi. You're my only hope.");
         else
-            title_renderer_->text(title_option.value);
+            text_renderer_->text(title_text_, title_option.value);
     }
 }
 
@@ -268,7 +1018,7 @@ MainLoopDecoration::fps_renderer_update_text(unsigned int fps)
 {
     std::stringstream ss;
     ss << "FPS: " << fps;
-    fps_renderer_->text(ss.str());
+    text_renderer_->text(fps_text_, ss.str());
 }
 
 LibMatrix::vec2
@@ -309,13 +1059,111 @@ MainLoopValidation::draw()
     scene_->running(false);
 }
 
+/*
+ * Compares the frame with its reference image in --reference-dir, or
+ * records it as the reference if there is none yet.
+ */
+Scene::ValidationResult
+MainLoopValidation::validate_reference(std::string &details)
+{
+    /* A frame matches if at most this fraction of its pixels differ */
+    static const double max_pixels_over_tolerance = 0.01;
+    std::string name(scene_->name() + "-" + (*bench_iter_)->options_string());
+
+    if (name[name.size() - 1] == '-')
+        name += "default";
+
+    /* Keep the file names portable */
+    for (std::string::iterator iter = name.begin(); iter != name.end(); iter++) {
+        if (!isalnum(static_cast<unsigned char>(*iter)) && *iter != '-' &&
+            *iter != '.' && *iter != '=')
+        {
+            *iter = '_';
+        }
+    }
+
+    std::stringstream ss;
+    ss << Options::reference_dir << "/" << name << "-"
+       << canvas_.width() << "x" << canvas_.height() << ".png";
+    std::string filename(ss.str());
+
+    std::vector<uint8_t> frame;
+    if (!canvas_.read_frame(frame)) {
+        details = "Failed to read the frame";
+        return Scene::ValidationUnknown;
+    }
+
+    if (!std::ifstream(filename.c_str())) {
+        if (!FrameCapture::write_png(filename, canvas_.width(), canvas_.height(), frame)) {
+            Log::error("Failed to write the reference image %s\n", filename.c_str());
+            return Scene::ValidationUnknown;
+        }
+        details = "Recorded " + filename;
+        return Scene::ValidationUnknown;
+    }
+
+    std::vector<uint8_t> reference;
+    if (!ImageCompare::load_reference(filename, canvas_.width(), canvas_.height(),
+                                      reference))
+    {
+        details = filename + " can't be loaded or has another size";
+        return Scene::ValidationFailure;
+    }
+
+    uint64_t start = Util::get_timestamp_us();
+    ImageCompare::Result cmp(ImageCompare::compare(&frame[0], &reference[0],
+                                                   canvas_.width(), canvas_.height(),
+                                                   Options::reference_tolerance,
+                                                   Options::reference_ssim > 0.0));
+    double elapsed_ms = (Util::get_timestamp_us() - start) / 1000.0;
+    double over_fraction = static_cast<double>(cmp.pixels_over_tolerance) / cmp.pixels;
+
+    std::stringstream ds;
+    ds << std::fixed << "RMSE: " << std::setprecision(3) << cmp.rmse
+       << " PSNR: " << std::setprecision(2) << cmp.psnr << " dB"
+       << " MaxDiff: " << cmp.max_difference
+       << " OverTolerance: " << std::setprecision(3) << 100.0 * over_fraction << "%";
+    if (cmp.ssim >= 0.0)
+        ds << " SSIM: " << std::setprecision(4) << cmp.ssim;
+    ds << " (" << std::setprecision(1) << elapsed_ms << " ms)";
+    details = ds.str();
+
+    if (cmp.psnr < Options::reference_psnr ||
+        over_fraction > max_pixels_over_tolerance ||
+        (cmp.ssim >= 0.0 && cmp.ssim < Options::reference_ssim))
+    {
+        return Scene::ValidationFailure;
+    }
+
+    return Scene::ValidationSuccess;
+}
+
 void
 MainLoopValidation::log_scene_result()
 {
     static const std::string format(Log::continuation_prefix + " Validation: %s\n");
     std::string result;
+    Scene::ValidationResult validation = Scene::ValidationUnknown;
+    std::string details;
+
+    /* The probe pixels of the scenes are only valid at 800x600 */
+    if (canvas_.width() == 800 && canvas_.height() == 600)
+        validation = scene_->validate();
+
+    if (!Options::reference_dir.empty()) {
+        Scene::ValidationResult reference = validate_reference(details);
+
+        if (validation == Scene::ValidationFailure ||
+            reference == Scene::ValidationFailure)
+        {
+            validation = Scene::ValidationFailure;
+        }
+        else if (reference == Scene::ValidationSuccess) {
+            validation = Scene::ValidationSuccess;
+        }
+    }
 
-    switch(scene_->validate()) {
+    switch(validation) {
         case Scene::ValidationSuccess:
             result = "Success";
             break;
@@ -330,4 +1178,7 @@ MainLoopValidation::log_scene_result()
     }
 
     Log::info(format.c_str(), result.c_str());
+
+    if (!details.empty())
+        Log::info("    Reference: %s\n", details.c_str());
 }
@@ -25,8 +25,20 @@
 #include "canvas.h"
 #include "benchmark.h"
 #include "text-renderer.h"
+#include "frame-graph.h"
+#include "results-file.h"
+#include "gpu-timer.h"
+#include "present-stats.h"
+#include "frame-capture.h"
+#include "frame-pipeline.h"
+#include "frame-phases.h"
+#include "burst-cycle.h"
+#include "run-collector.h"
+#include "system-monitor.h"
+#include "score.h"
 #include "vec.h"
 #include <vector>
+#include <chrono>
 
 /**
  * Main loop for benchmarking.
@@ -51,6 +63,21 @@ public:
      */
     unsigned int score();
 
+    /**
+     * Gets the results of the benchmarks run so far.
+     */
+    const std::vector<BenchmarkResult> &results() { return results_; }
+
+    /**
+     * Gets the entries of the score of the benchmarks run so far.
+     */
+    const std::vector<Score::Entry> &score_entries() { return scores_; }
+
+    /**
+     * Gets the samples taken so far by a soak run (--soak).
+     */
+    const std::vector<SoakSample> &soak_samples() { return soak_samples_; }
+
     /**
      * Perform the next main loop step.
      *
@@ -91,14 +118,79 @@ protected:
         SceneSetupStatusUnsupported
     };
     void next_benchmark();
+    void build_runs();
+    void apply_sweep_size();
+    bool loop_benchmarks();
+    void update_soak();
+    void update_present_stats();
+    void update_bursts();
+    void update_frame_phases(bool scene_done);
+    void pace_frame();
+    void record_scene_result();
+    void log_measurement(const std::string &name, const FrameStats &stats);
+    void draw_and_update_scene();
+    void draw_scene();
+    void update_scene();
+    void capture_frame();
+    void present();
+    void begin_damage();
+    void end_damage();
     Canvas &canvas_;
     Scene *scene_;
     const std::vector<Benchmark *> &benchmarks_;
-    unsigned int score_;
-    unsigned int benchmarks_run_;
+    /* The benchmarks run successfully, for the score */
+    std::vector<Score::Entry> scores_;
     SceneSetupStatus scene_setup_status_;
-
+    std::vector<BenchmarkResult> results_;
+    GPUTimer gpu_timer_;
+    /*
+     * The measurements collected over the run of each scene, and the
+     * collectors registered for them, in the order they are reported
+     */
+    ContextResetCollector context_reset_;
+    MemoryCollector memory_;
+    RenderScaleCollector render_scale_;
+    CoRunnerCollector co_runners_;
+    GLCallCollector gl_calls_;
+    PerfCounterCollector perf_counters_;
+    StateCallCollector state_calls_;
+    FlushCollector flushes_;
+    PipelineStatsCollector pipeline_stats_;
+    EnergyCollector energy_;
+    MetricsCollector metrics_;
+    AllocationCollector allocations_;
+    std::vector<RunCollector *> collectors_;
+    PresentStats present_stats_;
+    FrameCapture frame_capture_;
+    /* Prepares the frames of the current scene, with --pipelined */
+    FramePipeline frame_pipeline_;
+    bool pipelined_;
+    /* The idle periods and bursts of frames of --bursts */
+    BurstCycle burst_cycle_;
+    /* The phases of the last frames, with --spike-threshold */
+    FramePhases frame_phases_;
+    /* The CPU and GPU time of the decorations of the measured frames */
+    FrameStats overlay_time_;
+    GPUTimer overlay_gpu_timer_;
+    /* When the next frame may be presented, with --target-fps */
+    std::chrono::steady_clock::time_point frame_deadline_;
+    /* The rectangle redrawn in the current frame, with damage-fraction */
+    std::vector<int> damage_rect_;
+
+    /* The benchmarks in the order they are run, with --repeat */
+    std::vector<Benchmark *> runs_;
+    /* Which repetition of its benchmark each run is, starting at 1 */
+    std::vector<unsigned int> repetitions_;
     std::vector<Benchmark *>::const_iterator bench_iter_;
+    /* The current size of --size-sweep */
+    unsigned int size_index_;
+
+    /* The state of a soak run, with --soak */
+    SystemMonitor system_monitor_;
+    std::vector<SoakSample> soak_samples_;
+    uint64_t soak_start_;
+    uint64_t soak_window_start_;
+    unsigned int soak_window_frames_;
 };
 
 /**
@@ -120,8 +212,14 @@ protected:
 
     bool show_fps_;
     bool show_title_;
-    TextRenderer *fps_renderer_;
-    TextRenderer *title_renderer_;
+    bool show_graph_;
+    /* Renders the FPS and the title in one batch */
+    TextRenderer *text_renderer_;
+    unsigned int fps_text_;
+    unsigned int title_text_;
+    FrameGraph *frame_graph_;
+    /* When the previous frame was drawn, for the graph */
+    uint64_t graph_timestamp_;
     unsigned int last_fps_;
     uint64_t fps_timestamp_;
 };
@@ -136,6 +234,9 @@ public:
 
     virtual void draw();
     virtual void log_scene_result();
+
+private:
+    Scene::ValidationResult validate_reference(std::string &details);
 };
 
 #endif /* GLMARK2_MAIN_LOOP_H_ */
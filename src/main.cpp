@@ -31,6 +31,23 @@
 #include "main-loop.h"
 #include "benchmark-collection.h"
 #include "scene-collection.h"
+#include "results-file.h"
+#include "device-runner.h"
+#include "texture.h"
+#include "startup-report.h"
+#include "trace.h"
+#include "isolation.h"
+#include "clock-lock.h"
+#include "flush-points.h"
+#include "alloc-counter.h"
+#include "bottleneck-analysis.h"
+#include "parameter-explorer.h"
+#include "benchmark-server.h"
+#include "call-recorder.h"
+#include "fork-server.h"
+#include "metrics-server.h"
+#include "co-runners.h"
+#include "burst-cycle.h"
 
 #include "canvas-generic.h"
 
@@ -46,6 +63,8 @@
 #include "native-state-dispmanx.h"
 #elif GLMARK2_USE_WIN32
 #include "native-state-win32.h"
+#elif GLMARK2_USE_HEADLESS
+#include "native-state-headless.h"
 #endif
 
 #if GLMARK2_USE_EGL
@@ -56,6 +75,12 @@
 #include "gl-state-wgl.h"
 #endif
 
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+
 using std::vector;
 using std::map;
 using std::string;
@@ -103,17 +128,409 @@ list_scenes()
                     Log::info(format_value.c_str(), val_iter->c_str());
                 }
             }
+
+            /* Display the values of a sweep (if defined) */
+            if (!opt.sweep_values.empty()) {
+                Log::info("    Sweep Values: ");
+                for (vector<string>::const_iterator val_iter = opt.sweep_values.begin();
+                     val_iter != opt.sweep_values.end();
+                     val_iter++)
+                {
+                    std::string format_value(Log::continuation_prefix + "%s");
+                    if (val_iter + 1 != opt.sweep_values.end())
+                        format_value += ",";
+                    else
+                        format_value += "\n";
+                    Log::info(format_value.c_str(), val_iter->c_str());
+                }
+            }
         }
     }
 }
 
-void
+static void
+log_repeat_summaries(const std::vector<BenchmarkResult> &results)
+{
+    std::vector<BenchmarkSummary> summaries(BenchmarkSummary::from_results(results));
+    RepeatSummary score(BenchmarkSummary::score(results));
+
+    Log::info("    FPS over %u runs: mean median (95%% confidence interval)\n",
+              Options::repeat);
+    for (std::vector<BenchmarkSummary>::const_iterator iter = summaries.begin();
+         iter != summaries.end();
+         iter++)
+    {
+        Log::info("[%s] %s: %.1f %.1f (+/- %.1f)\n",
+                  iter->scene.c_str(),
+                  iter->options.empty() ? "<default>" : iter->options.c_str(),
+                  iter->fps.mean, iter->fps.median, iter->fps.ci95);
+    }
+    Log::info("    Score: %.1f %.1f (+/- %.1f)\n",
+              score.mean, score.median, score.ci95);
+    Log::info("=======================================================\n");
+}
+
+/*
+ * Compares the FPS of the benchmarks to a baseline run (--compare-to).
+ *
+ * A difference is significant if it is larger than the 95% confidence
+ * interval of the difference of the means. Without repeated runs on both
+ * sides, every drop beyond the threshold is reported as a regression.
+ *
+ * @return whether no benchmark regressed
+ */
+static bool
+compare_to_baseline(const std::vector<BenchmarkResult> &results)
+{
+    std::vector<BenchmarkResult> baseline_results;
+
+    if (!ResultsFile::read(Options::compare_to, baseline_results))
+        return false;
+
+    std::vector<BenchmarkSummary> summaries(BenchmarkSummary::from_results(results));
+    std::vector<BenchmarkSummary> baselines(BenchmarkSummary::from_results(baseline_results));
+    unsigned int regressions = 0;
+
+    Log::info("    FPS compared to %s: baseline current (change)\n",
+              Options::compare_to.c_str());
+    for (std::vector<BenchmarkSummary>::const_iterator iter = summaries.begin();
+         iter != summaries.end();
+         iter++)
+    {
+        const char *options = iter->options.empty() ? "<default>" : iter->options.c_str();
+        std::vector<BenchmarkSummary>::const_iterator baseline = baselines.begin();
+
+        while (baseline != baselines.end() &&
+               (baseline->scene != iter->scene || baseline->options != iter->options ||
+                baseline->width != iter->width || baseline->height != iter->height))
+        {
+            baseline++;
+        }
+
+        if (baseline == baselines.end() || baseline->fps.count == 0 || iter->fps.count == 0) {
+            Log::info("[%s] %s: not comparable\n", iter->scene.c_str(), options);
+            continue;
+        }
+
+        double change = 100.0 * (iter->fps.mean - baseline->fps.mean) / baseline->fps.mean;
+        bool repeated = iter->fps.count > 1 && baseline->fps.count > 1;
+        bool significant = !repeated ||
+            std::fabs(iter->fps.mean - baseline->fps.mean) >
+            std::sqrt(iter->fps.ci95 * iter->fps.ci95 +
+                      baseline->fps.ci95 * baseline->fps.ci95);
+        bool regressed = significant && change < -Options::regression_threshold;
+
+        Log::info("[%s] %s: %.1f %.1f (%+.1f%%)%s%s\n",
+                  iter->scene.c_str(), options,
+                  baseline->fps.mean, iter->fps.mean, change,
+                  repeated && !significant ? " not significant" : "",
+                  regressed ? " REGRESSION" : "");
+
+        if (regressed)
+            regressions++;
+    }
+
+    if (regressions > 0) {
+        Log::info("%u benchmark(s) regressed by more than %.1f%%\n",
+                  regressions, Options::regression_threshold);
+    }
+    Log::info("=======================================================\n");
+
+    return regressions == 0;
+}
+
+/* Gets a value of the canvas information of a recorded run */
+static string
+history_info(const HistoryRun &run, const string &key)
+{
+    for (size_t i = 0; i < run.canvas.size(); i++) {
+        if (run.canvas[i].first == key)
+            return run.canvas[i].second;
+    }
+
+    return string();
+}
+
+static string
+history_date(int64_t t)
+{
+    time_t time = static_cast<time_t>(t);
+    struct tm *tm = localtime(&time);
+    char buf[32];
+
+    if (!tm || !strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", tm))
+        return "unknown";
+
+    return buf;
+}
+
+/*
+ * Shows the trends of the runs of a results history file (--history). The
+ * runs are grouped by device (GL vendor and renderer), and the benchmarks
+ * are matched by scene, options and size. The latest run of a benchmark is
+ * compared to the median of its previous runs, which a single outlier
+ * doesn't move.
+ *
+ * @return whether no benchmark regressed in its latest run
+ */
+static bool
+report_history()
+{
+    /* The number of runs shown for each benchmark */
+    static const size_t shown_runs = 8;
+
+    vector<HistoryRun> runs;
+
+    if (!ResultsFile::read_history(Options::history, runs))
+        return false;
+
+    vector<string> devices;
+    for (size_t i = 0; i < runs.size(); i++) {
+        string device(history_info(runs[i], "gl_renderer") + " (" +
+                      history_info(runs[i], "gl_vendor") + ")");
+        if (std::find(devices.begin(), devices.end(), device) == devices.end())
+            devices.push_back(device);
+    }
+
+    unsigned int regressions = 0;
+
+    for (size_t d = 0; d < devices.size(); d++) {
+        vector<const HistoryRun *> device_runs;
+        vector<string> drivers;
+
+        for (size_t i = 0; i < runs.size(); i++) {
+            if (history_info(runs[i], "gl_renderer") + " (" +
+                history_info(runs[i], "gl_vendor") + ")" != devices[d])
+            {
+                continue;
+            }
+            device_runs.push_back(&runs[i]);
+
+            string driver(history_info(runs[i], "gl_version"));
+            string platform(history_info(runs[i], "platform"));
+            if (!platform.empty())
+                driver += ", " + platform;
+            drivers.push_back(driver);
+        }
+
+        Log::info("=======================================================\n");
+        Log::info("    %s: %u run(s), %s to %s\n", devices[d].c_str(),
+                  static_cast<unsigned int>(device_runs.size()),
+                  history_date(device_runs.front()->time).c_str(),
+                  history_date(device_runs.back()->time).c_str());
+
+        for (size_t i = 0; i < drivers.size(); i++) {
+            if (i == 0 || drivers[i] != drivers[i - 1]) {
+                Log::info("    Driver: %s since %s\n", drivers[i].c_str(),
+                          history_date(device_runs[i]->time).c_str());
+            }
+        }
+
+        std::stringstream scores;
+        for (size_t i = device_runs.size() - std::min(device_runs.size(), shown_runs);
+             i < device_runs.size();
+             i++)
+        {
+            scores << " " << device_runs[i]->score;
+        }
+        Log::info("    Score:%s\n", scores.str().c_str());
+        Log::info("=======================================================\n");
+
+        /* The mean FPS of each benchmark in each run, negative if not run */
+        vector<BenchmarkSummary> benchmarks;
+        vector<vector<double> > fps;
+
+        for (size_t i = 0; i < device_runs.size(); i++) {
+            vector<BenchmarkSummary> summaries(
+                BenchmarkSummary::from_results(device_runs[i]->results));
+
+            for (size_t s = 0; s < summaries.size(); s++) {
+                const BenchmarkSummary &summary(summaries[s]);
+                size_t b = 0;
+
+                while (b < benchmarks.size() &&
+                       (benchmarks[b].scene != summary.scene ||
+                        benchmarks[b].options != summary.options ||
+                        benchmarks[b].width != summary.width ||
+                        benchmarks[b].height != summary.height))
+                {
+                    b++;
+                }
+
+                if (b == benchmarks.size()) {
+                    benchmarks.push_back(summary);
+                    fps.push_back(vector<double>(device_runs.size(), -1.0));
+                }
+
+                if (summary.fps.count > 0)
+                    fps[b][i] = summary.fps.mean;
+            }
+        }
+
+        bool new_driver = drivers.size() > 1 &&
+                          drivers[drivers.size() - 1] != drivers[drivers.size() - 2];
+
+        for (size_t b = 0; b < benchmarks.size(); b++) {
+            const char *options = benchmarks[b].options.empty() ?
+                                  "<default>" : benchmarks[b].options.c_str();
+            vector<double> previous;
+            std::stringstream shown;
+
+            shown.precision(1);
+            shown << std::fixed;
+
+            for (size_t i = 0; i < fps[b].size(); i++) {
+                if (fps[b][i] < 0.0)
+                    continue;
+                if (i + 1 < fps[b].size())
+                    previous.push_back(fps[b][i]);
+                if (i + shown_runs >= fps[b].size())
+                    shown << fps[b][i] << " ";
+            }
+
+            double latest = fps[b].back();
+
+            if (latest < 0.0) {
+                Log::info("[%s] %s %dx%d: not in the latest run\n",
+                          benchmarks[b].scene.c_str(), options,
+                          benchmarks[b].width, benchmarks[b].height);
+                continue;
+            }
+
+            if (previous.empty()) {
+                Log::info("[%s] %s %dx%d: FPS: %.1f (first run)\n",
+                          benchmarks[b].scene.c_str(), options,
+                          benchmarks[b].width, benchmarks[b].height, latest);
+                continue;
+            }
+
+            double median = RepeatSummary::from_values(previous).median;
+            double change = 100.0 * (latest - median) / median;
+            bool regressed = change < -Options::regression_threshold;
+
+            Log::info("[%s] %s %dx%d: FPS: %s(median %.1f, %+.1f%%)%s%s\n",
+                      benchmarks[b].scene.c_str(), options,
+                      benchmarks[b].width, benchmarks[b].height,
+                      shown.str().c_str(), median, change,
+                      regressed ? " REGRESSION" : "",
+                      regressed && new_driver ? " with a new driver" : "");
+
+            if (regressed)
+                regressions++;
+        }
+    }
+
+    if (runs.empty())
+        Log::info("No runs recorded in %s\n", Options::history.c_str());
+
+    if (regressions > 0) {
+        Log::info("%u benchmark(s) regressed by more than %.1f%% in the latest run\n",
+                  regressions, Options::regression_threshold);
+    }
+    Log::info("=======================================================\n");
+
+    return regressions == 0;
+}
+
+/*
+ * Logs the sub-score of each category of benchmarks, relative to a reference
+ * device with --score-reference.
+ */
+static void
+log_subscores(const std::vector<Score::Entry> &score_entries)
+{
+    std::vector<BenchmarkResult> reference;
+
+    if (!Options::score_reference.empty() &&
+        !ResultsFile::read(Options::score_reference, reference))
+    {
+        Log::error("Failed to read the score reference %s\n",
+                   Options::score_reference.c_str());
+        return;
+    }
+
+    std::vector<Score::SubScore> subscores(Score::subscores(score_entries, reference));
+    if (subscores.empty())
+        return;
+
+    if (reference.empty())
+        Log::info("    Sub-scores (geometric mean FPS):\n");
+    else
+        Log::info("    Sub-scores (%s = 1000):\n", Options::score_reference.c_str());
+
+    for (std::vector<Score::SubScore>::const_iterator iter = subscores.begin();
+         iter != subscores.end();
+         iter++)
+    {
+        std::string name(Score::category_name(iter->category) + ":");
+        Log::info("      %-14s %8.1f (%u benchmark%s)\n", name.c_str(), iter->score,
+                  iter->benchmarks, iter->benchmarks == 1 ? "" : "s");
+    }
+
+    if (!reference.empty())
+        Log::info("    Reference Score: %.0f\n", Score::combine(subscores));
+    Log::info("=======================================================\n");
+}
+
+/**
+ * Reports the score and the results of the benchmarks, and compares them
+ * to the baseline, if any.
+ *
+ * @return whether there was no regression
+ */
+static bool
+report_results(const Canvas::InfoList &canvas_info,
+               const std::vector<BenchmarkResult> &results,
+               const std::vector<SoakSample> &soak_samples,
+               const std::vector<Score::Entry> &score_entries,
+               unsigned int score)
+{
+    Log::info("=======================================================\n");
+    Log::info("                                  glmark2 Score: %u \n", score);
+    Log::info("=======================================================\n");
+
+    log_subscores(score_entries);
+
+    if (Options::repeat > 1)
+        log_repeat_summaries(results);
+
+    StartupReport::print();
+
+    if (!Options::results_file.empty()) {
+        ResultsFile::write(Options::results_file, canvas_info,
+                           results, soak_samples, score);
+    }
+
+    if (!Options::history_file.empty())
+        ResultsFile::append_history(Options::history_file, canvas_info, results, score);
+
+    return Options::compare_to.empty() || compare_to_baseline(results);
+}
+
+bool
 do_benchmark(Canvas &canvas)
 {
     BenchmarkCollection benchmark_collection;
     MainLoop *loop;
+    Canvas::InfoList canvas_info;
 
-    benchmark_collection.populate_from_options();
+    {
+        StartupReport::Phase phase("benchmark-list");
+        benchmark_collection.populate_from_options();
+    }
+
+    /* Decode the textures in the background while the benchmarks run */
+    Texture::prefetch(benchmark_collection.textures());
+
+    /* Build the program variants of all the benchmarks, for their setups to load */
+    if (Options::precompile_shaders)
+        Scene::precompile_programs(benchmark_collection.programs());
+
+    if (!Options::results_file.empty() || !Options::history_file.empty()) {
+        canvas_info = canvas.info();
+        Isolation::info(canvas_info);
+        ClockLock::info(canvas_info);
+    }
     
     if (benchmark_collection.needs_decoration())
         loop = new MainLoopDecoration(canvas, benchmark_collection.benchmarks());
@@ -122,11 +539,92 @@ do_benchmark(Canvas &canvas)
 
     while (loop->step());
 
-    Log::info("=======================================================\n");
-    Log::info("                                  glmark2 Score: %u \n", loop->score());
-    Log::info("=======================================================\n");
+    bool passed = report_results(canvas_info, loop->results(),
+                                 loop->soak_samples(), loop->score_entries(),
+                                 loop->score());
 
     delete loop;
+
+    return passed;
+}
+
+/*
+ * Runs the benchmarks with --fork-benchmarks. The canvas isn't initialized,
+ * each benchmark process initializes its own.
+ */
+static bool
+do_forked_benchmark(Canvas &canvas)
+{
+    BenchmarkCollection benchmark_collection;
+
+    {
+        StartupReport::Phase phase("benchmark-list");
+        benchmark_collection.populate_from_options();
+    }
+
+    /* Decode the textures once, for all the processes to inherit */
+    Texture::prefetch(benchmark_collection.textures());
+    Texture::wait_for_prefetch();
+
+    ForkServer server(canvas, benchmark_collection.benchmarks(),
+                      benchmark_collection.needs_decoration());
+
+    bool passed = server.run();
+
+    Canvas::InfoList canvas_info(server.canvas_info());
+    if (!Options::results_file.empty() || !Options::history_file.empty()) {
+        Isolation::info(canvas_info);
+        ClockLock::info(canvas_info);
+    }
+
+    return report_results(canvas_info, server.results(),
+                          std::vector<SoakSample>(), server.score_entries(),
+                          server.score()) && passed;
+}
+
+void
+do_bottleneck_analysis(Canvas &canvas)
+{
+    BenchmarkCollection benchmark_collection;
+
+    benchmark_collection.populate_from_options();
+
+    Texture::prefetch(benchmark_collection.textures());
+
+    BottleneckAnalysis analysis(canvas, benchmark_collection.benchmarks());
+
+    analysis.run();
+}
+
+/*
+ * Explores the FPS of the benchmarks over ranges of their options
+ * (--explore).
+ */
+static bool
+do_explore(Canvas &canvas)
+{
+    BenchmarkCollection benchmark_collection;
+    std::vector<ParameterExplorer::Range> ranges;
+
+    ParameterExplorer::parse(Options::explore, ranges);
+
+    benchmark_collection.populate_from_options();
+
+    Texture::prefetch(benchmark_collection.textures());
+
+    ParameterExplorer explorer(canvas, benchmark_collection.benchmarks());
+
+    explorer.run(ranges);
+
+    if (!Options::results_file.empty()) {
+        Canvas::InfoList canvas_info(canvas.info());
+        Isolation::info(canvas_info);
+        ClockLock::info(canvas_info);
+        return ResultsFile::write(Options::results_file, canvas_info, explorer.results(),
+                                  std::vector<SoakSample>(), 0);
+    }
+
+    return true;
 }
 
 void
@@ -136,9 +634,13 @@ do_validation(Canvas &canvas)
 
     benchmark_collection.populate_from_options();
 
+    Texture::prefetch(benchmark_collection.textures());
+
     MainLoopValidation loop(canvas, benchmark_collection.benchmarks());
 
     while (loop.step());
+
+    StartupReport::print();
 }
 
 int
@@ -147,9 +649,18 @@ main(int argc, char *argv[])
     if (!Options::parse_args(argc, argv))
         return 1;
 
+    StartupReport::start(Options::startup_report);
+    Trace::start(Options::trace_file);
+
     /* Initialize Log class */
     Log::init(Util::appname_from_path(argv[0]), Options::show_debug);
 
+    /* The writer thread wouldn't exist in the forked processes */
+    if (Options::async_log && !Options::fork_benchmarks)
+        Log::async(true);
+    else if (Options::async_log)
+        Log::debug("Ignoring --async-log with --fork-benchmarks\n");
+
     if (Options::show_help) {
         Options::print_help();
         return 0;
@@ -160,8 +671,11 @@ main(int argc, char *argv[])
         return 0;
     }
 
-    /* Force 800x600 output for validation */
-    if (Options::validate &&
+    /*
+     * Force 800x600 output for validation, which the probe pixels of the
+     * scenes assume. References are compared at any size.
+     */
+    if (Options::validate && Options::reference_dir.empty() &&
         Options::size != std::pair<int,int>(800, 600))
     {
         Log::info("Ignoring custom size %dx%d for validation. Using 800x600.\n",
@@ -169,6 +683,121 @@ main(int argc, char *argv[])
         Options::size = std::pair<int,int>(800, 600);
     }
 
+#if GLMARK2_USE_HEADLESS
+    /* There is no window to render to */
+    Options::offscreen = true;
+#endif
+
+    /* Serve the data files from the pack, if any */
+    if (Options::data_pack.empty()) {
+        std::string default_pack(Options::data_path + "/glmark2-data.pack");
+        std::ifstream pack_file(default_pack.c_str());
+        if (pack_file && Util::open_resource_pack(default_pack, Options::data_path))
+            Log::debug("Using the data pack %s\n", default_pack.c_str());
+    }
+    else if (Options::data_pack != "none") {
+        if (!Util::open_resource_pack(Options::data_pack, Options::data_path)) {
+            Log::error("Failed to open the data pack %s\n", Options::data_pack.c_str());
+            return 1;
+        }
+    }
+
+    if (Options::render_scale <= 0.0 || Options::render_scale > 1.0) {
+        Log::error("Invalid --render-scale %g, it must be in (0, 1]\n",
+                   Options::render_scale);
+        return 1;
+    }
+
+    if (Options::dynamic_resolution < 0.0) {
+        Log::error("Invalid --dynamic-resolution %g, it must be a frame time in ms\n",
+                   Options::dynamic_resolution);
+        return 1;
+    }
+    else if (Options::dynamic_resolution > 0.0 && Options::validate) {
+        Log::info("Ignoring --dynamic-resolution for validation.\n");
+        Options::dynamic_resolution = 0.0;
+    }
+
+    if (Options::spike_threshold < 0.0) {
+        Log::error("Invalid --spike-threshold %g, it must be a frame time in ms\n",
+                   Options::spike_threshold);
+        return 1;
+    }
+
+    if (!Options::co_runners.empty()) {
+        CoRunners::Config config;
+        if (Options::validate) {
+            Log::info("Ignoring --co-runners for validation.\n");
+            Options::co_runners.clear();
+        }
+        else if (!CoRunners::parse(Options::co_runners, config)) {
+            Log::error("Invalid --co-runners '%s'\n", Options::co_runners.c_str());
+            return 1;
+        }
+    }
+
+    if (!Options::bursts.empty()) {
+        BurstCycle::Config config;
+        if (Options::validate) {
+            Log::info("Ignoring --bursts for validation.\n");
+            Options::bursts.clear();
+        }
+        else if (!BurstCycle::parse(Options::bursts, config)) {
+            Log::error("Invalid --bursts '%s', expected idle:MS,burst:MS\n",
+                       Options::bursts.c_str());
+            return 1;
+        }
+    }
+
+    if (!Options::flush_points.empty()) {
+        FlushPoints::Config config;
+        if (!FlushPoints::parse(Options::flush_points, config)) {
+            Log::error("Invalid --flush-points '%s', expected passes and/or draws:N\n",
+                       Options::flush_points.c_str());
+            return 1;
+        }
+    }
+
+    if (!AllocCounter::install(Options::count_allocations)) {
+        Log::error("--count-allocations needs glmark2 to be built with the"
+                   " allocation counter (--enable-alloc-counter)\n");
+        return 1;
+    }
+
+    if (!Options::explore.empty()) {
+        std::vector<ParameterExplorer::Range> ranges;
+        if (!ParameterExplorer::parse(Options::explore, ranges)) {
+            Log::error("Invalid --explore '%s', expected OPTION=MIN..MAX[,...]\n",
+                       Options::explore.c_str());
+            return 1;
+        }
+    }
+
+    if (!Options::size_sweep.empty()) {
+        if (Options::validate) {
+            Log::info("Ignoring --size-sweep for validation.\n");
+            Options::size_sweep.clear();
+        }
+        else if (!Options::offscreen) {
+            Log::error("--size-sweep requires --off-screen\n");
+            return 1;
+        }
+        else {
+            for (std::vector<std::pair<int,int> >::const_iterator iter = Options::size_sweep.begin();
+                 iter != Options::size_sweep.end();
+                 iter++)
+            {
+                if (iter->first <= 0 || iter->second <= 0) {
+                    Log::error("Invalid size %dx%d in --size-sweep\n",
+                               iter->first, iter->second);
+                    return 1;
+                }
+            }
+
+            Options::size = Options::size_sweep.front();
+        }
+    }
+
     // Create the canvas
 #if GLMARK2_USE_X11
     NativeStateX11 native_state;
@@ -182,8 +811,27 @@ main(int argc, char *argv[])
     NativeStateDispmanx native_state;
 #elif GLMARK2_USE_WIN32
     NativeStateWin32 native_state;
+#elif GLMARK2_USE_HEADLESS
+    NativeStateHeadless native_state;
 #endif
 
+    if (Options::all_devices) {
+        std::vector<std::string> devices;
+
+        if (!native_state.list_devices(devices) || devices.empty()) {
+            Log::error("Failed to find the devices for --all-devices\n");
+            return 1;
+        }
+
+        return DeviceRunner::run(argv, devices);
+    }
+
+    if (!Isolation::apply())
+        return 1;
+
+    if (Options::lock_clocks)
+        ClockLock::apply();
+
 #if GLMARK2_USE_EGL
     GLStateEGL gl_state;
 #elif GLMARK2_USE_GLX
@@ -203,10 +851,35 @@ main(int argc, char *argv[])
     scenes.register_scenes();
 
     if (Options::list_scenes) {
+        scenes.get();
         list_scenes();
         return 0;
     }
 
+    if (!Options::history.empty())
+        return report_history() ? 0 : 1;
+
+    if (Options::fork_benchmarks) {
+        if (Options::validate || Options::bottleneck_analysis || !Options::explore.empty() ||
+            !Options::serve.empty() || !Options::replay.empty() ||
+            Options::soak_duration > 0.0 || !Options::metrics.empty())
+        {
+            Log::error("--fork-benchmarks can't be used with --validate, --bottleneck-analysis, --explore, --serve, --replay, --soak or --metrics\n");
+            return 1;
+        }
+
+        Log::info("=======================================================\n");
+        Log::info("    glmark2 %s\n", GLMARK_VERSION);
+        Log::info("=======================================================\n");
+
+        bool passed = do_forked_benchmark(canvas);
+
+        if (!Trace::write())
+            return 1;
+
+        return passed ? 0 : 1;
+    }
+
     if (!canvas.init()) {
         Log::error("%s: Could not initialize canvas\n", __FUNCTION__);
         return 1;
@@ -220,10 +893,28 @@ main(int argc, char *argv[])
 
     canvas.visible(true);
 
+    if (!Options::metrics.empty() && !MetricsServer::start(Options::metrics))
+        return 1;
+
+    bool passed = true;
+
     if (Options::validate)
         do_validation(canvas);
+    else if (Options::bottleneck_analysis)
+        do_bottleneck_analysis(canvas);
+    else if (!Options::explore.empty())
+        passed = do_explore(canvas);
+    else if (!Options::serve.empty())
+        passed = BenchmarkServer(canvas).run(Options::serve);
+    else if (!Options::replay.empty())
+        passed = CallRecorder::replay(canvas, Options::replay, Options::replay_duration);
     else
-        do_benchmark(canvas);
+        passed = do_benchmark(canvas);
+
+    MetricsServer::stop();
+
+    if (!Trace::write())
+        return 1;
 
-    return 0;
+    return passed ? 0 : 1;
 }
@@ -0,0 +1,268 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "memory-monitor.h"
+#include "gl-headers.h"
+#include "log.h"
+#include "util.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#endif
+
+namespace
+{
+
+/* The minimum interval between the samples taken while running */
+const uint64_t sample_interval_us = 1000000;
+
+/* Not defined by the GL (ES) headers */
+const GLenum gpu_memory_info_total_available_memory_nvx = 0x9048;
+const GLenum gpu_memory_info_current_available_vidmem_nvx = 0x9049;
+const GLenum texture_free_memory_ati = 0x87FC;
+
+#ifdef __linux__
+
+/*
+ * Gets the memory of the DRM clients of the process, from the
+ * drm-total-<region> (or older drm-memory-<region>) keys of their fdinfo,
+ * in MiB, or a negative value if there are none.
+ */
+double
+read_fdinfo_mib()
+{
+    static const std::string fdinfo_dir("/proc/self/fdinfo");
+    DIR *dir = opendir(fdinfo_dir.c_str());
+
+    if (!dir)
+        return -1.0;
+
+    std::vector<std::string> fds;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != 0) {
+        if (entry->d_name[0] != '.')
+            fds.push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    /* Clients can have several fds */
+    std::set<std::string> clients;
+    double total_mib = -1.0;
+
+    for (std::vector<std::string>::const_iterator iter = fds.begin();
+         iter != fds.end();
+         iter++)
+    {
+        std::ifstream file((fdinfo_dir + "/" + *iter).c_str());
+        std::string line;
+        std::string client;
+        double total = 0.0;
+        double memory = 0.0;
+        bool has_total = false;
+        bool has_memory = false;
+
+        while (std::getline(file, line)) {
+            std::string::size_type colon = line.find(':');
+            if (colon == std::string::npos)
+                continue;
+
+            std::string key(line.substr(0, colon));
+            std::stringstream value(line.substr(colon + 1));
+
+            if (key == "drm-client-id") {
+                value >> client;
+                continue;
+            }
+
+            bool is_total = key.compare(0, 10, "drm-total-") == 0;
+            bool is_memory = key.compare(0, 11, "drm-memory-") == 0;
+            if (!is_total && !is_memory)
+                continue;
+
+            double amount = 0.0;
+            std::string unit;
+            value >> amount >> unit;
+            if (unit == "KiB")
+                amount /= 1024.0;
+            else if (unit == "GiB")
+                amount *= 1024.0;
+            else if (unit != "MiB")
+                amount /= 1024.0 * 1024.0;
+
+            if (is_total) {
+                total += amount;
+                has_total = true;
+            }
+            else {
+                memory += amount;
+                has_memory = true;
+            }
+        }
+
+        if (client.empty() || (!has_total && !has_memory) || !clients.insert(client).second)
+            continue;
+
+        total_mib = std::max(total_mib, 0.0) + (has_total ? total : memory);
+    }
+
+    return total_mib;
+}
+
+#else
+
+double
+read_fdinfo_mib()
+{
+    return -1.0;
+}
+
+#endif
+
+}
+
+MemoryMonitor::MemoryMonitor() :
+    source_(GPUSourceNone), sampled_(false), last_sample_(0),
+    ati_initial_free_mib_(-1.0), begin_rss_mib_(0.0), begin_gpu_mib_(-1.0),
+    rss_mib_(0.0), peak_rss_mib_(0.0), gpu_mib_(-1.0), peak_gpu_mib_(-1.0),
+    retained_rss_mib_(0.0), retained_gpu_mib_(0.0)
+{
+}
+
+void
+MemoryMonitor::begin()
+{
+    /* The context may have changed since the last benchmark */
+    if (read_fdinfo_mib() >= 0.0) {
+        source_ = GPUSourceFdinfo;
+        gpu_source_ = "fdinfo";
+    }
+    else if (GLExtensions::support("GL_NVX_gpu_memory_info")) {
+        source_ = GPUSourceNVX;
+        gpu_source_ = "GL_NVX_gpu_memory_info";
+    }
+    else if (GLExtensions::support("GL_ATI_meminfo")) {
+        source_ = GPUSourceATI;
+        gpu_source_ = "GL_ATI_meminfo";
+    }
+    else {
+        source_ = GPUSourceNone;
+        gpu_source_.clear();
+    }
+
+#ifdef __linux__
+    /* Resets the peak resident memory (VmHWM) */
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+#endif
+
+    sampled_ = false;
+    begin_rss_mib_ = read_rss_mib(false);
+    begin_gpu_mib_ = read_gpu_mib();
+    rss_mib_ = begin_rss_mib_;
+    peak_rss_mib_ = begin_rss_mib_;
+    gpu_mib_ = begin_gpu_mib_;
+    peak_gpu_mib_ = begin_gpu_mib_;
+    retained_rss_mib_ = 0.0;
+    retained_gpu_mib_ = 0.0;
+    last_sample_ = Util::get_timestamp_us();
+}
+
+void
+MemoryMonitor::sample(bool force)
+{
+    uint64_t now = Util::get_timestamp_us();
+
+    if (!force && now - last_sample_ < sample_interval_us)
+        return;
+
+    rss_mib_ = read_rss_mib(false);
+    peak_rss_mib_ = std::max(peak_rss_mib_, std::max(rss_mib_, read_rss_mib(true)));
+    gpu_mib_ = read_gpu_mib();
+    peak_gpu_mib_ = std::max(peak_gpu_mib_, gpu_mib_);
+    sampled_ = true;
+    last_sample_ = now;
+}
+
+void
+MemoryMonitor::end()
+{
+    sample(true);
+}
+
+void
+MemoryMonitor::after_teardown()
+{
+    if (!sampled_)
+        return;
+
+    retained_rss_mib_ = read_rss_mib(false) - begin_rss_mib_;
+    if (begin_gpu_mib_ >= 0.0)
+        retained_gpu_mib_ = read_gpu_mib() - begin_gpu_mib_;
+}
+
+/* Gets the current (VmRSS) or peak (VmHWM) resident memory */
+double
+MemoryMonitor::read_rss_mib(bool peak)
+{
+    std::ifstream file("/proc/self/status");
+    std::string key(peak ? "VmHWM:" : "VmRSS:");
+    std::string line;
+
+    while (std::getline(file, line)) {
+        if (line.compare(0, key.size(), key) != 0)
+            continue;
+
+        std::stringstream ss(line.substr(key.size()));
+        double kib = 0.0;
+        ss >> kib;
+        return kib / 1024.0;
+    }
+
+    return 0.0;
+}
+
+double
+MemoryMonitor::read_gpu_mib()
+{
+    GLint kib[4] = { 0, 0, 0, 0 };
+
+    switch (source_) {
+        case GPUSourceFdinfo:
+            return read_fdinfo_mib();
+        case GPUSourceNVX: {
+            GLint total = 0;
+            glGetIntegerv(gpu_memory_info_total_available_memory_nvx, &total);
+            glGetIntegerv(gpu_memory_info_current_available_vidmem_nvx, kib);
+            return (total - kib[0]) / 1024.0;
+        }
+        case GPUSourceATI:
+            /* The first value is the total free memory in the pool */
+            glGetIntegerv(texture_free_memory_ati, kib);
+            if (ati_initial_free_mib_ < 0.0)
+                ati_initial_free_mib_ = kib[0] / 1024.0;
+            return ati_initial_free_mib_ - kib[0] / 1024.0;
+        default:
+            return -1.0;
+    }
+}
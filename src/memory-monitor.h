@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_MEMORY_MONITOR_H_
+#define GLMARK2_MEMORY_MONITOR_H_
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Samples the memory used by the process and the GPU over a benchmark
+ * (--memory-usage): before its setup, after it, about once per second
+ * while it runs, at its end and after its teardown.
+ *
+ * The resident memory of the process is read from /proc/self/status, with
+ * its peak reset for each benchmark. The GPU memory is read, in order of
+ * preference, from the DRM fdinfo of the process (the memory of its
+ * clients), GL_NVX_gpu_memory_info (the memory used on the GPU, by all
+ * processes) or GL_ATI_meminfo (the texture memory that isn't free
+ * anymore since the first sample).
+ *
+ * The memory retained after the teardown, compared to before the setup,
+ * shows leaks, e.g. when looping with --run-forever.
+ */
+class MemoryMonitor
+{
+public:
+    MemoryMonitor();
+
+    /**
+     * Starts monitoring a benchmark, before its setup. Needs a current
+     * context.
+     */
+    void begin();
+
+    /**
+     * Samples the memory, if forced or enough time has passed since the
+     * last sample.
+     */
+    void sample(bool force = false);
+
+    /**
+     * Samples the memory at the end of the benchmark.
+     */
+    void end();
+
+    /**
+     * Samples the memory after the teardown of the benchmark.
+     */
+    void after_teardown();
+
+    /** Whether the benchmark has been sampled */
+    bool sampled() const { return sampled_; }
+
+    /** The resident memory of the process at the end, in MiB */
+    double rss_mib() const { return rss_mib_; }
+
+    /** The peak resident memory of the process, in MiB */
+    double peak_rss_mib() const { return peak_rss_mib_; }
+
+    /** The GPU memory at the end, in MiB, or a negative value if unknown */
+    double gpu_mib() const { return gpu_mib_; }
+
+    /** The peak of the GPU memory samples, in MiB */
+    double peak_gpu_mib() const { return peak_gpu_mib_; }
+
+    /** The resident memory retained after the teardown, in MiB */
+    double retained_rss_mib() const { return retained_rss_mib_; }
+
+    /** The GPU memory retained after the teardown, in MiB */
+    double retained_gpu_mib() const { return retained_gpu_mib_; }
+
+    /** The source of the GPU memory, e.g. "fdinfo", or empty if unknown */
+    const std::string &gpu_source() const { return gpu_source_; }
+
+    /**
+     * Reads the current or peak resident memory of the process, in MiB.
+     * Doesn't need a context.
+     */
+    static double read_rss_mib(bool peak);
+
+private:
+    enum GPUSource {
+        GPUSourceNone,
+        GPUSourceFdinfo,
+        GPUSourceNVX,
+        GPUSourceATI
+    };
+
+    double read_gpu_mib();
+
+    GPUSource source_;
+    std::string gpu_source_;
+    bool sampled_;
+    uint64_t last_sample_;
+    /* The free texture memory at the first sample, for GL_ATI_meminfo */
+    double ati_initial_free_mib_;
+    double begin_rss_mib_;
+    double begin_gpu_mib_;
+    double rss_mib_;
+    double peak_rss_mib_;
+    double gpu_mib_;
+    double peak_gpu_mib_;
+    double retained_rss_mib_;
+    double retained_gpu_mib_;
+};
+
+#endif /* GLMARK2_MEMORY_MONITOR_H_ */
@@ -25,11 +25,139 @@
 #include "log.h"
 #include "gl-headers.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <queue>
+#include <thread>
+
+namespace
+{
+
+/* The size of the simulated post-transform vertex cache */
+const int vertex_cache_size = 32;
+
+/*
+ * Scores a vertex for vertex cache optimization, as described in
+ * Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+ */
+float
+vertex_cache_score(int cache_pos, unsigned int remaining_tris)
+{
+    if (remaining_tris == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (cache_pos >= 0) {
+        /* The vertices of the last triangle get a fixed score */
+        if (cache_pos < 3) {
+            score = 0.75f;
+        }
+        else {
+            float s = 1.0f - static_cast<float>(cache_pos - 3) / (vertex_cache_size - 3);
+            score = std::pow(s, 1.5f);
+        }
+    }
+
+    /* Boost vertices with few triangles left, to avoid leaving them behind */
+    score += 2.0f / std::sqrt(static_cast<float>(remaining_tris));
+
+    return score;
+}
+
+/*
+ * A group of consecutive triangles, used for overdraw optimization.
+ */
+struct TriangleCluster
+{
+    size_t start;
+    size_t count;
+    float sort_key;
+
+    bool operator<(const TriangleCluster &other) const
+    {
+        return sort_key > other.sort_key;
+    }
+};
+
+/*
+ * A quadric error metric: the symmetric 4x4 matrix whose quadratic form
+ * is the weighted sum of the squared distances to a set of planes. Only
+ * the upper triangle is stored.
+ */
+struct Quadric
+{
+    Quadric() { std::fill(q, q + 10, 0.0); }
+
+    void add_plane(const LibMatrix::vec3 &n, double d, double weight)
+    {
+        double a = n.x();
+        double b = n.y();
+        double c = n.z();
+
+        q[0] += weight * a * a; q[1] += weight * a * b; q[2] += weight * a * c; q[3] += weight * a * d;
+        q[4] += weight * b * b; q[5] += weight * b * c; q[6] += weight * b * d;
+        q[7] += weight * c * c; q[8] += weight * c * d;
+        q[9] += weight * d * d;
+    }
+
+    Quadric &operator+=(const Quadric &other)
+    {
+        for (int i = 0; i < 10; i++)
+            q[i] += other.q[i];
+        return *this;
+    }
+
+    double error(const LibMatrix::vec3 &p) const
+    {
+        double x = p.x();
+        double y = p.y();
+        double z = p.z();
+
+        return q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z + 2.0 * q[3] * x +
+               q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y +
+               q[7] * z * z + 2.0 * q[8] * z +
+               q[9];
+    }
+
+    double q[10];
+};
+
+/*
+ * A candidate collapse of the vertex from into the vertex to. Its cost is
+ * out of date once the stamp of either vertex has changed, which happens
+ * when a collapse into the vertex changes its quadric.
+ */
+struct EdgeCollapse
+{
+    double cost;
+    unsigned int from;
+    unsigned int to;
+    unsigned int from_stamp;
+    unsigned int to_stamp;
+
+    /* The cheapest collapse comes first in a std::priority_queue */
+    bool operator<(const EdgeCollapse &other) const
+    {
+        return cost > other.cost;
+    }
+};
+
+}
+
 
 Mesh::Mesh() :
-    vertex_size_(0), interleave_(false), vbo_update_method_(VBOUpdateMethodMap),
-    vbo_usage_(VBOUsageStatic)
+    vertex_size_(0), primitive_(GL_TRIANGLES), primitive_restart_(false), lod_(0), index_type_(GL_UNSIGNED_SHORT), index_buffer_(0),
+    vertex_arrays_shared_(false), interleave_(false), vbo_update_method_(VBOUpdateMethodMap),
+    vbo_usage_(VBOUsageStatic), vbo_orphan_(false), vbo_coalesce_(false),
+    vbo_coalesce_gap_(0), vbo_update_calls_(0), vbo_update_bytes_(0), use_vao_(false),
+    vao_(0), vao_dirty_(false), vbo_buffering_(1),
+    vbo_copy_(0), persistent_segment_(0)
 {
+    for (unsigned int i = 0; i < persistent_segments; i++)
+        persistent_fences_[i] = 0;
 }
 
 Mesh::~Mesh()
@@ -64,18 +192,69 @@ Mesh::set_vertex_format(const std::vector<int> &format)
     vertex_size_ = pos;
 }
 
+/*
+ * Sets the formats the vertex attributes are stored in in VBOs.
+ *
+ * Vertex arrays always store floats. The formats take effect in the next
+ * call to ::build_vbo(), and attributes without a format are stored as
+ * floats.
+ */
+void
+Mesh::set_attrib_formats(const std::vector<AttribFormat> &formats)
+{
+    attrib_formats_.clear();
+
+    for (size_t i = 0; i < formats.size(); i++) {
+        if (formats[i] != AttribFormatFloat) {
+            attrib_formats_ = formats;
+            break;
+        }
+    }
+}
+
+/*
+ * Checks whether VBOs can store attributes in a format.
+ */
+bool
+Mesh::attrib_format_supported(AttribFormat format)
+{
+#if GLMARK2_USE_GLESv2
+    bool es3 = GLExtensions::version_supported(3, 0);
+
+    if (format == AttribFormatHalfFloat)
+        return es3 || GLExtensions::support("GL_OES_vertex_half_float");
+    else if (format == AttribFormatInt2101010Rev)
+        return es3;
+#else
+    if (format == AttribFormatHalfFloat) {
+        return GLExtensions::version_supported(3, 0) ||
+               GLExtensions::support("GL_ARB_half_float_vertex");
+    }
+    else if (format == AttribFormatInt2101010Rev) {
+        return GLExtensions::version_supported(3, 3) ||
+               GLExtensions::support("GL_ARB_vertex_type_2_10_10_10_rev");
+    }
+#endif
+
+    return true;
+}
+
 /*
  * Sets the attribute locations.
  *
  * These are the locations used in glEnableVertexAttribArray()
- * and other related functions.
+ * and other related functions. Scenes set them before each draw, so the
+ * vertex array object is only specified again when they change.
  */
 void
 Mesh::set_attrib_locations(const std::vector<int> &locations)
 {
     if (locations.size() != vertex_format_.size())
         Log::error("Trying to set attribute locations using wrong size\n");
+    if (locations == attrib_locations_)
+        return;
     attrib_locations_ = locations;
+    vao_dirty_ = true;
 }
 
 
@@ -109,13 +288,13 @@ Mesh::check_attrib(unsigned int pos, int dim)
  *
  * @return the vertex to process
  */
-std::vector<float> &
+float *
 Mesh::ensure_vertex()
 {
-    if (vertices_.empty())
+    if (vertex_data_.empty())
         next_vertex();
 
-    return vertices_.back();
+    return &vertex_data_[vertex_data_.size() - vertex_size_];
 }
 
 /*
@@ -127,12 +306,12 @@ Mesh::ensure_vertex()
  * etc
  */
 void
-Mesh::set_attrib(unsigned int pos, const LibMatrix::vec2 &v, std::vector<float> *vertex)
+Mesh::set_attrib(unsigned int pos, const LibMatrix::vec2 &v, float *vertex)
 {
     if (!check_attrib(pos, 2))
         return;
 
-    std::vector<float> &vtx = !vertex ? ensure_vertex() : *vertex;
+    float *vtx = !vertex ? ensure_vertex() : vertex;
 
     int offset = vertex_format_[pos].second;
 
@@ -141,12 +320,12 @@ Mesh::set_attrib(unsigned int pos, const LibMatrix::vec2 &v, std::vector<float>
 }
 
 void
-Mesh::set_attrib(unsigned int pos, const LibMatrix::vec3 &v, std::vector<float> *vertex)
+Mesh::set_attrib(unsigned int pos, const LibMatrix::vec3 &v, float *vertex)
 {
     if (!check_attrib(pos, 3))
         return;
 
-    std::vector<float> &vtx = !vertex ? ensure_vertex() : *vertex;
+    float *vtx = !vertex ? ensure_vertex() : vertex;
 
     int offset = vertex_format_[pos].second;
 
@@ -156,12 +335,12 @@ Mesh::set_attrib(unsigned int pos, const LibMatrix::vec3 &v, std::vector<float>
 }
 
 void
-Mesh::set_attrib(unsigned int pos, const LibMatrix::vec4 &v, std::vector<float> *vertex)
+Mesh::set_attrib(unsigned int pos, const LibMatrix::vec4 &v, float *vertex)
 {
     if (!check_attrib(pos, 4))
         return;
 
-    std::vector<float> &vtx = !vertex ? ensure_vertex() : *vertex;
+    float *vtx = !vertex ? ensure_vertex() : vertex;
 
     int offset = vertex_format_[pos].second;
 
@@ -177,27 +356,74 @@ Mesh::set_attrib(unsigned int pos, const LibMatrix::vec4 &v, std::vector<float>
 void
 Mesh::next_vertex()
 {
-    vertices_.push_back(std::vector<float>(vertex_size_));
+    vertex_data_.resize(vertex_data_.size() + vertex_size_);
+}
+
+/*
+ * Allocates the vertex data for a number of vertices up front, so that
+ * adding them doesn't reallocate and copy the data as it grows.
+ */
+void
+Mesh::reserve_vertices(size_t count)
+{
+    vertex_data_.reserve(count * vertex_size_);
+}
+
+/*
+ * Removes the last vertex.
+ */
+void
+Mesh::pop_vertex()
+{
+    if (!vertex_data_.empty())
+        vertex_data_.resize(vertex_data_.size() - vertex_size_);
+}
+
+/**
+ * Gets the number of vertices in the mesh.
+ *
+ * The data of each vertex can be accessed with ::vertex(), which returns
+ * ::vertex_size() floats in the layout set by ::set_vertex_format(). You
+ * should normally use the ::set_attrib() method to manipulate the vertex
+ * data.
+ */
+size_t
+Mesh::vertex_count() const
+{
+    return vertex_size_ ? vertex_data_.size() / vertex_size_ : 0;
 }
 
 /**
- * Gets the mesh vertices.
+ * Adds an index to the mesh index list.
  *
- * You should use the ::set_attrib() method to manipulate
- * the vertex data.
+ * If the index list is not empty, the mesh is rendered as indexed
+ * triangles, i.e., each consecutive triple of indices forms a triangle.
  *
- * You shouldn't resize the vector (change the number of vertices)
- * manually. Use ::next_vertex() instead.
+ * @param index the index of the vertex to add
+ */
+void
+Mesh::add_index(unsigned int index)
+{
+    indices_.push_back(index);
+}
+
+/**
+ * Gets the mesh indices.
  */
-std::vector<std::vector<float> >&
-Mesh::vertices()
+std::vector<unsigned int>&
+Mesh::indices()
 {
-    return vertices_;
+    return indices_;
 }
 
 /**
  * Sets the VBO update method.
  *
+ * VBOUpdateMethodMapRange maps each updated range with glMapBufferRange
+ * without synchronizing with pending draws. VBOUpdateMethodPersistent
+ * keeps the VBOs persistently mapped and triple buffered. It takes effect
+ * in the next call to ::build_vbo().
+ *
  * The default value is VBOUpdateMethodMap.
  */
 void
@@ -219,6 +445,89 @@ Mesh::vbo_usage(Mesh::VBOUsage usage)
     vbo_usage_ = usage;
 }
 
+/**
+ * Sets the number of copies of the VBOs to rotate through.
+ *
+ * Each update goes to the copy that was least recently used for rendering,
+ * so that it doesn't have to wait for the GPU to finish with it. The
+ * setting takes effect in the next call to ::build_vbo() and doesn't apply
+ * to VBOUpdateMethodPersistent, which is always triple buffered.
+ *
+ * The default value is 1.
+ *
+ * @param copies the number of copies
+ */
+void
+Mesh::vbo_buffering(unsigned int copies)
+{
+    vbo_buffering_ = copies > 0 ? copies : 1;
+}
+
+/**
+ * Sets whether to orphan the VBO storage before updating it.
+ *
+ * Orphaning allocates new storage with glBufferData(NULL), which lets the
+ * driver rename the buffer instead of waiting for pending draws. The whole
+ * VBO is rewritten after orphaning it.
+ *
+ * The default value is false.
+ *
+ * @param orphan whether to orphan
+ */
+void
+Mesh::vbo_orphan(bool orphan)
+{
+    vbo_orphan_ = orphan;
+}
+
+/**
+ * Sets whether to coalesce the updated ranges of each VBO.
+ *
+ * Coalesced ranges are sorted, and the ranges separated by at most
+ * max_gap bytes are merged and uploaded with the vertices between them,
+ * which trades extra bytes for fewer upload calls. With
+ * VBOUpdateMethodMap only the range covering the updates is mapped, with
+ * glMapBufferRange if it is supported, and written in increasing order,
+ * which suits write-combined memory.
+ *
+ * The default value is false, which uploads each range with its own call.
+ *
+ * @param coalesce whether to coalesce the ranges
+ * @param max_gap the largest gap between ranges to merge, in bytes
+ */
+void
+Mesh::vbo_coalesce(bool coalesce, size_t max_gap)
+{
+    vbo_coalesce_ = coalesce;
+    vbo_coalesce_gap_ = max_gap;
+}
+
+/**
+ * Resets the counts of the VBO upload calls and bytes.
+ */
+void
+Mesh::reset_vbo_update_stats()
+{
+    vbo_update_calls_ = 0;
+    vbo_update_bytes_ = 0;
+}
+
+/**
+ * Sets whether to render VBOs through a vertex array object.
+ *
+ * This takes effect in the next call to ::build_vbo(), and is ignored if
+ * vertex array objects are not supported.
+ *
+ * The default value is false.
+ *
+ * @param use_vao whether to use a vertex array object
+ */
+void
+Mesh::vbo_vao(bool use_vao)
+{
+    use_vao_ = use_vao;
+}
+
 /**
  * Sets the vertex attribute interleaving mode.
  *
@@ -237,153 +546,1086 @@ Mesh::interleave(bool interleave)
     interleave_ = interleave;
 }
 
+/*
+ * Checks whether indexed primitives can be restarted at the largest index
+ * of their type, as indexed grid strips need.
+ */
+bool
+Mesh::primitive_restart_supported()
+{
+#if GLMARK2_USE_GLESv2
+    return GLExtensions::version_supported(3, 0);
+#else
+    return GLExtensions::version_supported(4, 3) ||
+           GLExtensions::support("GL_ARB_ES3_compatibility");
+#endif
+}
+
 /**
- * Resets a Mesh object to its initial, empty state.
+ * Sets the primitive mode the mesh is rendered with.
+ *
+ * The default, which ::reset() restores, is GL_TRIANGLES. With GL_PATCHES
+ * each consecutive triple of vertices (or indices) forms a patch for the
+ * tessellation shaders, so the patch size must be set to 3 with
+ * glPatchParameteri().
+ *
+ * @param mode the primitive mode
  */
 void
-Mesh::reset()
+Mesh::primitive(GLenum mode)
 {
-    delete_array();
-    delete_vbo();
+    primitive_ = mode;
+}
 
-    vertices_.clear();
-    vertex_format_.clear();
-    attrib_locations_.clear();
-    attrib_data_ptr_.clear();
-    vertex_size_ = 0;
-    vertex_stride_ = 0;
+/**
+ * Gets the optimization mode for a "model-optimize" option value.
+ *
+ * @param str "none", "vcache" or "overdraw"
+ */
+Mesh::OptimizeMode
+Mesh::optimize_mode_from_str(const std::string &str)
+{
+    if (str == "vcache")
+        return OptimizeVertexCache;
+    else if (str == "overdraw")
+        return OptimizeOverdraw;
+
+    return OptimizeNone;
 }
 
 /**
- * Builds a vertex array containing the mesh vertex data.
+ * Reorders the mesh triangles and vertices to improve rendering efficiency.
  *
- * The way the vertex array is constructed is affected by the current
- * interleave value, which can set using ::interleave().
+ * This works only on indexed meshes and should be called before building
+ * the vertex arrays or VBOs.
+ *
+ * OptimizeVertexCache reorders triangles to improve the post-transform
+ * vertex cache hit rate. OptimizeOverdraw additionally reorders groups of
+ * triangles so that outward facing ones are drawn first, which reduces
+ * overdraw for convex-ish objects. In both cases the vertices are then
+ * reordered in the order they are first used.
+ *
+ * @param mode the optimizations to perform
+ * @param position_pos the attribute position of the vec3 vertex position,
+ *                     used for overdraw optimization
  */
 void
-Mesh::build_array()
+Mesh::optimize(OptimizeMode mode, unsigned int position_pos)
 {
-    int nvertices = vertices_.size();
+    if (mode == OptimizeNone)
+        return;
 
-    if (!interleave_) {
-        /* Create an array for each attribute */
-        for (std::vector<std::pair<int, int> >::const_iterator ai = vertex_format_.begin();
-             ai != vertex_format_.end();
-             ai++)
-        {
-            float *array = new float[nvertices * ai->first];
-            float *cur = array;
+    if (indices_.empty() || primitive_restart_) {
+        Log::debug("Mesh optimization requires an indexed mesh without primitive restarts, skipping\n");
+        return;
+    }
 
-            /* Fill in the array */
-            for (std::vector<std::vector<float> >::const_iterator vi = vertices_.begin();
-                    vi != vertices_.end();
-                    vi++)
+    optimize_vertex_cache();
+
+    if (mode == OptimizeOverdraw && check_attrib(position_pos, 3))
+        optimize_overdraw(position_pos);
+
+    optimize_vertex_fetch();
+}
+
+/**
+ * Reorders triangles for the post-transform vertex cache.
+ *
+ * This is a (simplified) implementation of Tom Forsyth's "Linear-Speed Vertex
+ * Cache Optimisation" algorithm. Triangles are emitted greedily, always
+ * picking the highest scoring triangle among those using vertices in the
+ * simulated cache.
+ */
+void
+Mesh::optimize_vertex_cache()
+{
+    size_t nvertices = vertex_count();
+    size_t ntris = indices_.size() / 3;
+
+    /* Build the vertex to triangle adjacency lists */
+    std::vector<unsigned int> remaining(nvertices, 0);
+    for (size_t i = 0; i < ntris * 3; i++)
+        remaining[indices_[i]]++;
+
+    std::vector<unsigned int> offsets(nvertices + 1, 0);
+    for (size_t v = 0; v < nvertices; v++)
+        offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<unsigned int> adjacency(ntris * 3);
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < ntris * 3; i++)
+        adjacency[fill[indices_[i]]++] = i / 3;
+
+    std::vector<int> cache_pos(nvertices, -1);
+    std::vector<float> vertex_score(nvertices);
+    for (size_t v = 0; v < nvertices; v++)
+        vertex_score[v] = vertex_cache_score(-1, remaining[v]);
+
+    std::vector<float> tri_score(ntris);
+    for (size_t t = 0; t < ntris; t++) {
+        tri_score[t] = vertex_score[indices_[3 * t]] +
+                       vertex_score[indices_[3 * t + 1]] +
+                       vertex_score[indices_[3 * t + 2]];
+    }
+
+    std::vector<bool> emitted(ntris, false);
+    std::vector<unsigned int> new_indices;
+    new_indices.reserve(ntris * 3);
+
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> new_cache;
+    size_t next_unemitted = 0;
+    long best_tri = -1;
+
+    for (size_t n = 0; n < ntris; n++) {
+        /*
+         * If no triangle is connected to the cache, continue with the
+         * first one that hasn't been emitted yet.
+         */
+        if (best_tri < 0) {
+            while (emitted[next_unemitted])
+                next_unemitted++;
+            best_tri = next_unemitted;
+        }
+
+        emitted[best_tri] = true;
+
+        new_cache.clear();
+
+        for (int i = 0; i < 3; i++) {
+            unsigned int v = indices_[3 * best_tri + i];
+            new_indices.push_back(v);
+            new_cache.push_back(v);
+
+            /* Remove the triangle from the active list of the vertex */
+            unsigned int *begin = &adjacency[offsets[v]];
+            unsigned int *end = begin + remaining[v];
+            unsigned int *tri = std::find(begin, end, static_cast<unsigned int>(best_tri));
+            std::swap(*tri, *(end - 1));
+            remaining[v]--;
+        }
+
+        for (std::vector<unsigned int>::const_iterator ci = cache.begin();
+             ci != cache.end();
+             ci++)
+        {
+            if (std::find(new_cache.begin(), new_cache.begin() + 3, *ci) ==
+                new_cache.begin() + 3)
             {
-                for (int i = 0; i < ai->first; i++)
-                    *cur++ = (*vi)[ai->second + i];
+                new_cache.push_back(*ci);
             }
+        }
 
-            vertex_arrays_.push_back(array);
-            attrib_data_ptr_.push_back(array);
+        /* Update the scores of the vertices in the cache, or evicted from it */
+        for (size_t i = 0; i < new_cache.size(); i++) {
+            unsigned int v = new_cache[i];
+            cache_pos[v] = i < static_cast<size_t>(vertex_cache_size) ? i : -1;
+            vertex_score[v] = vertex_cache_score(cache_pos[v], remaining[v]);
         }
-        vertex_stride_ = 0;
-    }
-    else {
-        float *array = new float[nvertices * vertex_size_];
-        float *cur = array;
 
-        for (std::vector<std::vector<float> >::const_iterator vi = vertices_.begin();
-             vi != vertices_.end();
-             vi++)
+        /* Update the affected triangles and find the next best one */
+        best_tri = -1;
+        float best_score = -1.0f;
+
+        for (std::vector<unsigned int>::const_iterator ci = new_cache.begin();
+             ci != new_cache.end();
+             ci++)
         {
-            /* Fill in the array */
-            for (int i = 0; i < vertex_size_; i++)
-                *cur++ = (*vi)[i];
+            unsigned int v = *ci;
+
+            for (unsigned int i = 0; i < remaining[v]; i++) {
+                unsigned int t = adjacency[offsets[v] + i];
+                tri_score[t] = vertex_score[indices_[3 * t]] +
+                               vertex_score[indices_[3 * t + 1]] +
+                               vertex_score[indices_[3 * t + 2]];
+                if (tri_score[t] > best_score) {
+                    best_score = tri_score[t];
+                    best_tri = t;
+                }
+            }
         }
 
-        for (size_t i = 0; i < vertex_format_.size(); i++)
-            attrib_data_ptr_.push_back(array + vertex_format_[i].second);
+        if (new_cache.size() > static_cast<size_t>(vertex_cache_size))
+            new_cache.resize(vertex_cache_size);
 
-        vertex_arrays_.push_back(array);
-        vertex_stride_ = vertex_size_ * sizeof(float);
+        cache.swap(new_cache);
     }
+
+    indices_.swap(new_indices);
 }
 
 /**
- * Builds a vertex buffer object containing the mesh vertex data.
+ * Reorders clusters of triangles to reduce overdraw.
  *
- * The way the VBO is constructed is affected by the current interleave
- * value (::interleave()) and the vbo usage hint (::vbo_usage()).
+ * This is a simplified version of the approach in Sander, Nehab and
+ * Barczak's "Fast Triangle Reordering for Vertex Locality and Reduced
+ * Overdraw". The (vertex cache optimized) triangle list is split into
+ * clusters at the points where doing so costs little in vertex cache
+ * efficiency, and the clusters are sorted so that the ones facing away
+ * from the mesh center are drawn first.
+ *
+ * @param position_pos the attribute position of the vertex position
  */
 void
-Mesh::build_vbo()
+Mesh::optimize_overdraw(unsigned int position_pos)
 {
-    delete_array();
-    build_array();
+    size_t ntris = indices_.size() / 3;
+    int offset = vertex_format_[position_pos].second;
+
+    /* Simulate a FIFO cache to find the cache misses for each triangle */
+    std::vector<unsigned int> misses(ntris, 0);
+    std::vector<size_t> cache_time(vertex_count(), 0);
+    size_t time = vertex_cache_size + 1;
+    size_t total_misses = 0;
+
+    for (size_t t = 0; t < ntris; t++) {
+        for (int i = 0; i < 3; i++) {
+            unsigned int v = indices_[3 * t + i];
+            if (time - cache_time[v] > static_cast<size_t>(vertex_cache_size)) {
+                cache_time[v] = time++;
+                misses[t]++;
+            }
+        }
+        total_misses += misses[t];
+    }
 
-    int nvertices = vertices_.size();
+    /*
+     * Split at hard boundaries (the cache restarts from scratch) and at
+     * soft boundaries where the cluster so far is at least as cache
+     * friendly as the mesh on average.
+     */
+    static const size_t min_cluster_tris = 64;
+    float threshold = 1.05f * total_misses / ntris;
+
+    std::vector<TriangleCluster> clusters;
+    TriangleCluster cluster = {0, 0, 0.0f};
+    size_t cluster_misses = 0;
+
+    for (size_t t = 0; t < ntris; t++) {
+        bool hard = (misses[t] == 3);
+        bool soft = (cluster.count >= min_cluster_tris &&
+                     static_cast<float>(cluster_misses) / cluster.count <= threshold);
+
+        if (cluster.count > 0 && (hard || soft)) {
+            clusters.push_back(cluster);
+            cluster.start = t;
+            cluster.count = 0;
+            cluster_misses = 0;
+        }
 
-    attrib_data_ptr_.clear();
+        cluster.count++;
+        cluster_misses += misses[t];
+    }
+    clusters.push_back(cluster);
 
-    GLenum buffer_usage;
-    if (vbo_usage_ == Mesh::VBOUsageStream)
-        buffer_usage = GL_STREAM_DRAW;
-    else if (vbo_usage_ == Mesh::VBOUsageDynamic)
-        buffer_usage = GL_DYNAMIC_DRAW;
-    else /* if (vbo_usage_ == Mesh::VBOUsageStatic) */
-        buffer_usage = GL_STATIC_DRAW;
+    /* Find the mesh centroid */
+    LibMatrix::vec3 mesh_center;
+    for (size_t v = 0; v < vertex_count(); v++) {
+        const float *p = vertex(v) + offset;
+        mesh_center += LibMatrix::vec3(p[0], p[1], p[2]);
+    }
+    mesh_center /= vertex_count();
+
+    /*
+     * Sort the clusters by how much they face away from the mesh center,
+     * using their area weighted normal and centroid.
+     */
+    for (std::vector<TriangleCluster>::iterator ci = clusters.begin();
+         ci != clusters.end();
+         ci++)
+    {
+        LibMatrix::vec3 normal;
+        LibMatrix::vec3 center;
+        float area = 0.0f;
+
+        for (size_t t = ci->start; t < ci->start + ci->count; t++) {
+            const float *a = vertex(indices_[3 * t]);
+            const float *b = vertex(indices_[3 * t + 1]);
+            const float *c = vertex(indices_[3 * t + 2]);
+            LibMatrix::vec3 pa(a[offset], a[offset + 1], a[offset + 2]);
+            LibMatrix::vec3 pb(b[offset], b[offset + 1], b[offset + 2]);
+            LibMatrix::vec3 pc(c[offset], c[offset + 1], c[offset + 2]);
+
+            LibMatrix::vec3 n = LibMatrix::vec3::cross(pb - pa, pc - pa);
+            float tri_area = n.length();
+
+            normal += n;
+            center += (pa + pb + pc) * (tri_area / 3.0f);
+            area += tri_area;
+        }
 
-    if (!interleave_) {
-        /* Create a vbo for each attribute */
-        for (std::vector<std::pair<int, int> >::const_iterator ai = vertex_format_.begin();
-             ai != vertex_format_.end();
-             ai++)
-        {
-            float *data = vertex_arrays_[ai - vertex_format_.begin()];
-            GLuint vbo;
+        if (area > 0.0f)
+            center /= area;
 
-            glGenBuffers(1, &vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, nvertices * ai->first * sizeof(float),
-                         data, buffer_usage);
+        float normal_length = normal.length();
+        if (normal_length > 0.0f)
+            normal /= normal_length;
 
-            vbos_.push_back(vbo);
-            attrib_data_ptr_.push_back(0);
-        }
+        ci->sort_key = LibMatrix::vec3::dot(center - mesh_center, normal);
+    }
 
-        vertex_stride_ = 0;
+    std::stable_sort(clusters.begin(), clusters.end());
+
+    std::vector<unsigned int> new_indices;
+    new_indices.reserve(indices_.size());
+
+    for (std::vector<TriangleCluster>::const_iterator ci = clusters.begin();
+         ci != clusters.end();
+         ci++)
+    {
+        new_indices.insert(new_indices.end(),
+                           indices_.begin() + 3 * ci->start,
+                           indices_.begin() + 3 * (ci->start + ci->count));
     }
-    else {
-        GLuint vbo;
-        /* Create a single vbo to store all attribute data */
-        glGenBuffers(1, &vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
 
-        glBufferData(GL_ARRAY_BUFFER, nvertices * vertex_size_ * sizeof(float),
-                     vertex_arrays_[0], GL_STATIC_DRAW);
+    indices_.swap(new_indices);
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    Log::debug("Overdraw optimization: %u clusters\n",
+               static_cast<unsigned int>(clusters.size()));
+}
 
-        for (size_t i = 0; i < vertex_format_.size(); i++) {
-            attrib_data_ptr_.push_back(reinterpret_cast<float *>(sizeof(float) * vertex_format_[i].second));
-            vbos_.push_back(vbo);
+/**
+ * Reorders the vertices in the order they are first used by the indices.
+ */
+void
+Mesh::optimize_vertex_fetch()
+{
+    static const unsigned int unused = ~0U;
+    std::vector<unsigned int> remap(vertex_count(), unused);
+    std::vector<float> vertex_data;
+    vertex_data.reserve(vertex_data_.size());
+
+    for (std::vector<unsigned int>::iterator ii = indices_.begin();
+         ii != indices_.end();
+         ii++)
+    {
+        if (remap[*ii] == unused) {
+            remap[*ii] = vertex_data.size() / vertex_size_;
+            vertex_data.insert(vertex_data.end(), vertex(*ii), vertex(*ii) + vertex_size_);
         }
-        vertex_stride_ = vertex_size_ * sizeof(float);
+        *ii = remap[*ii];
     }
 
-    delete_array();
+    vertex_data_.swap(vertex_data);
 }
 
 /**
- * Updates ranges of a single vertex array.
+ * Generates a chain of levels of detail by simplifying the mesh.
  *
- * @param ranges the ranges of vertices to update
- * @param n the index of the vertex array to update
- * @param nfloats how many floats to update for each vertex
- * @param offset the offset (in floats) in the vertex data to start reading from
+ * Each level is simplified from the previous one by collapsing edges in
+ * the order of the quadric error metrics of Garland and Heckbert, until
+ * it has ratio times its triangles. An edge collapses into one of its
+ * vertices, so all the levels share the vertices of the mesh. The
+ * vertices on borders and attribute seams (those sharing their position
+ * with other vertices) stay in place, which keeps the levels free of
+ * holes. Fewer levels are generated if the mesh can't be simplified
+ * further.
+ *
+ * This works only on indexed triangle meshes and should be called after
+ * ::optimize() and before building the vertex arrays or VBOs. Level 0 is
+ * drawn until another one is selected with ::lod().
+ *
+ * @param levels the number of levels, including the full detail mesh
+ * @param ratio the ratio of the triangles of a level to those of the
+ *              previous one
+ * @param position_pos the attribute position of the vec3 vertex position
  */
 void
-Mesh::update_single_array(const std::vector<std::pair<size_t, size_t> >& ranges,
+Mesh::generate_lods(unsigned int levels, float ratio, unsigned int position_pos)
+{
+    lod_ranges_.clear();
+    lod_ = 0;
+
+    if (levels <= 1)
+        return;
+
+    if (indices_.empty() || primitive_ != GL_TRIANGLES || !check_attrib(position_pos, 3)) {
+        Log::debug("LOD generation requires an indexed triangle mesh, skipping\n");
+        return;
+    }
+
+    size_t nvertices = vertex_count();
+    size_t ntris = indices_.size() / 3;
+    int offset = vertex_format_[position_pos].second;
+
+    std::vector<LibMatrix::vec3> positions(nvertices);
+    for (size_t v = 0; v < nvertices; v++) {
+        const float *p = vertex(v) + offset;
+        positions[v] = LibMatrix::vec3(p[0], p[1], p[2]);
+    }
+
+    /* Lock the vertices on attribute seams, found by sorting by position */
+    std::vector<bool> locked(nvertices, false);
+    std::vector<unsigned int> order(nvertices);
+    for (size_t v = 0; v < nvertices; v++)
+        order[v] = v;
+
+    std::sort(order.begin(), order.end(),
+              [&positions](unsigned int a, unsigned int b) {
+                  const LibMatrix::vec3 &pa(positions[a]);
+                  const LibMatrix::vec3 &pb(positions[b]);
+                  if (pa.x() != pb.x())
+                      return pa.x() < pb.x();
+                  if (pa.y() != pb.y())
+                      return pa.y() < pb.y();
+                  return pa.z() < pb.z();
+              });
+
+    for (size_t i = 1; i < nvertices; i++) {
+        const LibMatrix::vec3 &pa(positions[order[i - 1]]);
+        const LibMatrix::vec3 &pb(positions[order[i]]);
+        if (pa.x() == pb.x() && pa.y() == pb.y() && pa.z() == pb.z()) {
+            locked[order[i - 1]] = true;
+            locked[order[i]] = true;
+        }
+    }
+
+    /* Lock the vertices on borders, the edges used by a single triangle */
+    std::vector<uint64_t> edges;
+    edges.reserve(3 * ntris);
+    for (size_t t = 0; t < ntris; t++) {
+        for (int i = 0; i < 3; i++) {
+            uint64_t a = indices_[3 * t + i];
+            uint64_t b = indices_[3 * t + (i + 1) % 3];
+            edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i + 1;
+        while (j < edges.size() && edges[j] == edges[i])
+            j++;
+        if (j - i == 1) {
+            locked[edges[i] >> 32] = true;
+            locked[edges[i] & 0xffffffff] = true;
+        }
+        i = j;
+    }
+
+    /* Accumulate the area weighted plane quadrics of the triangles of each vertex */
+    std::vector<unsigned int> tris(indices_);
+    std::vector<bool> tri_alive(ntris, true);
+    std::vector<std::vector<unsigned int> > vertex_tris(nvertices);
+    std::vector<Quadric> quadrics(nvertices);
+
+    for (size_t t = 0; t < ntris; t++) {
+        const LibMatrix::vec3 &pa(positions[tris[3 * t]]);
+        const LibMatrix::vec3 &pb(positions[tris[3 * t + 1]]);
+        const LibMatrix::vec3 &pc(positions[tris[3 * t + 2]]);
+        LibMatrix::vec3 n = LibMatrix::vec3::cross(pb - pa, pc - pa);
+        float area = n.length();
+
+        for (int i = 0; i < 3; i++)
+            vertex_tris[tris[3 * t + i]].push_back(t);
+
+        if (area > 0.0f) {
+            n /= area;
+            Quadric q;
+            q.add_plane(n, -LibMatrix::vec3::dot(n, pa), area / 2.0);
+            for (int i = 0; i < 3; i++)
+                quadrics[tris[3 * t + i]] += q;
+        }
+    }
+
+    /* Queue the collapses of both directions of every edge */
+    std::vector<bool> removed(nvertices, false);
+    std::vector<unsigned int> stamps(nvertices, 0);
+    std::priority_queue<EdgeCollapse> collapses;
+
+    auto queue_collapse = [&](unsigned int from, unsigned int to) {
+        if (locked[from])
+            return;
+
+        Quadric q(quadrics[from]);
+        q += quadrics[to];
+        EdgeCollapse c = { q.error(positions[to]), from, to, stamps[from], stamps[to] };
+        collapses.push(c);
+    };
+
+    auto queue_vertex_collapses = [&](unsigned int v) {
+        for (std::vector<unsigned int>::const_iterator ti = vertex_tris[v].begin();
+             ti != vertex_tris[v].end();
+             ti++)
+        {
+            for (int i = 0; i < 3; i++) {
+                unsigned int w = tris[3 * *ti + i];
+                if (w != v) {
+                    queue_collapse(v, w);
+                    queue_collapse(w, v);
+                }
+            }
+        }
+    };
+
+    for (size_t v = 0; v < nvertices; v++)
+        queue_vertex_collapses(v);
+
+    /*
+     * Checks that collapsing from into to keeps the mesh manifold (the
+     * vertices adjacent to both are only the ones opposite the edge) and
+     * flips no triangle.
+     */
+    auto collapse_allowed = [&](unsigned int from, unsigned int to) {
+        std::vector<unsigned int> from_adjacent;
+        std::vector<unsigned int> to_adjacent;
+        unsigned int shared_tris = 0;
+
+        for (std::vector<unsigned int>::const_iterator ti = vertex_tris[to].begin();
+             ti != vertex_tris[to].end();
+             ti++)
+        {
+            for (int i = 0; i < 3; i++)
+                to_adjacent.push_back(tris[3 * *ti + i]);
+        }
+
+        for (std::vector<unsigned int>::const_iterator ti = vertex_tris[from].begin();
+             ti != vertex_tris[from].end();
+             ti++)
+        {
+            const unsigned int *tri = &tris[3 * *ti];
+            bool shared = tri[0] == to || tri[1] == to || tri[2] == to;
+
+            for (int i = 0; i < 3; i++)
+                from_adjacent.push_back(tri[i]);
+
+            if (shared) {
+                shared_tris++;
+                continue;
+            }
+
+            LibMatrix::vec3 p[3];
+            LibMatrix::vec3 q[3];
+            for (int i = 0; i < 3; i++) {
+                p[i] = positions[tri[i]];
+                q[i] = tri[i] == from ? positions[to] : p[i];
+            }
+
+            LibMatrix::vec3 n_before = LibMatrix::vec3::cross(p[1] - p[0], p[2] - p[0]);
+            LibMatrix::vec3 n_after = LibMatrix::vec3::cross(q[1] - q[0], q[2] - q[0]);
+            if (LibMatrix::vec3::dot(n_before, n_after) <= 0.0f)
+                return false;
+        }
+
+        std::sort(from_adjacent.begin(), from_adjacent.end());
+        from_adjacent.erase(std::unique(from_adjacent.begin(), from_adjacent.end()),
+                            from_adjacent.end());
+        std::sort(to_adjacent.begin(), to_adjacent.end());
+        to_adjacent.erase(std::unique(to_adjacent.begin(), to_adjacent.end()),
+                          to_adjacent.end());
+
+        std::vector<unsigned int> common;
+        std::set_intersection(from_adjacent.begin(), from_adjacent.end(),
+                              to_adjacent.begin(), to_adjacent.end(),
+                              std::back_inserter(common));
+
+        /* The common vertices include from and to themselves */
+        return common.size() == shared_tris + 2;
+    };
+
+    std::vector<unsigned int> lod_indices(indices_);
+    lod_ranges_.push_back(std::pair<size_t, size_t>(0, indices_.size()));
+    size_t live_tris = ntris;
+
+    for (unsigned int level = 1; level < levels; level++) {
+        size_t target = static_cast<size_t>(ntris * std::pow(ratio, static_cast<float>(level)));
+        size_t level_tris = live_tris;
+
+        while (live_tris > std::max<size_t>(target, 1) && !collapses.empty()) {
+            EdgeCollapse c(collapses.top());
+            collapses.pop();
+
+            if (removed[c.from] || removed[c.to] ||
+                stamps[c.from] != c.from_stamp || stamps[c.to] != c.to_stamp ||
+                !collapse_allowed(c.from, c.to))
+            {
+                continue;
+            }
+
+            /* Remove the triangles of the edge and move the others to the kept vertex */
+            for (std::vector<unsigned int>::const_iterator ti = vertex_tris[c.from].begin();
+                 ti != vertex_tris[c.from].end();
+                 ti++)
+            {
+                unsigned int *tri = &tris[3 * *ti];
+
+                if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to) {
+                    tri_alive[*ti] = false;
+                    live_tris--;
+                    for (int i = 0; i < 3; i++) {
+                        if (tri[i] == c.from || tri[i] == c.to)
+                            continue;
+                        std::vector<unsigned int> &other(vertex_tris[tri[i]]);
+                        other.erase(std::remove(other.begin(), other.end(), *ti), other.end());
+                    }
+                }
+                else {
+                    for (int i = 0; i < 3; i++) {
+                        if (tri[i] == c.from)
+                            tri[i] = c.to;
+                    }
+                    vertex_tris[c.to].push_back(*ti);
+                }
+            }
+
+            std::vector<unsigned int> &to_tris(vertex_tris[c.to]);
+            to_tris.erase(std::remove_if(to_tris.begin(), to_tris.end(),
+                                         [&tri_alive](unsigned int t) { return !tri_alive[t]; }),
+                          to_tris.end());
+            vertex_tris[c.from].clear();
+            removed[c.from] = true;
+
+            quadrics[c.to] += quadrics[c.from];
+            stamps[c.to]++;
+            queue_vertex_collapses(c.to);
+        }
+
+        if (live_tris == level_tris)
+            break;
+
+        size_t first = lod_indices.size();
+        for (size_t t = 0; t < ntris; t++) {
+            if (tri_alive[t])
+                lod_indices.insert(lod_indices.end(), &tris[3 * t], &tris[3 * t] + 3);
+        }
+        lod_ranges_.push_back(std::pair<size_t, size_t>(first, lod_indices.size() - first));
+    }
+
+    indices_.swap(lod_indices);
+
+    Log::debug("LOD generation: %u levels, %u to %u triangles\n",
+               static_cast<unsigned int>(lod_ranges_.size()),
+               static_cast<unsigned int>(ntris),
+               static_cast<unsigned int>(lod_ranges_.back().second / 3));
+}
+
+/**
+ * Gets the number of triangles of a level of detail.
+ *
+ * @param level the level, 0 being the full detail mesh
+ */
+size_t
+Mesh::lod_triangles(unsigned int level) const
+{
+    if (lod_ranges_.empty())
+        return (indices_.empty() ? vertex_count() : indices_.size()) / 3;
+
+    return lod_ranges_[std::min<size_t>(level, lod_ranges_.size() - 1)].second / 3;
+}
+
+/**
+ * Selects the level of detail that is drawn.
+ *
+ * Levels beyond those generated by ::generate_lods() select the last one.
+ *
+ * @param level the level, 0 being the full detail mesh
+ */
+void
+Mesh::lod(unsigned int level)
+{
+    lod_ = lod_ranges_.empty() ? 0 : std::min<size_t>(level, lod_ranges_.size() - 1);
+}
+
+/**
+ * Gets the size of each index of the built index array, in bytes.
+ */
+size_t
+Mesh::index_size() const
+{
+    return index_type_ == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+}
+
+/**
+ * Gets the range of indices (or vertices, for meshes without indices) drawn.
+ */
+void
+Mesh::draw_range(size_t &first, size_t &count) const
+{
+    if (!lod_ranges_.empty()) {
+        first = lod_ranges_[lod_].first;
+        count = lod_ranges_[lod_].second;
+    }
+    else {
+        first = 0;
+        count = indices_.empty() ? vertex_count() : indices_.size();
+    }
+}
+
+/**
+ * Resets a Mesh object to its initial, empty state.
+ */
+void
+Mesh::reset()
+{
+    delete_array();
+    delete_vbo();
+
+    vertex_data_.clear();
+    indices_.clear();
+    vertex_format_.clear();
+    attrib_locations_.clear();
+    attrib_formats_.clear();
+    attrib_data_ptr_.clear();
+    vertex_size_ = 0;
+    vertex_stride_ = 0;
+    primitive_ = GL_TRIANGLES;
+    primitive_restart_ = false;
+    lod_ranges_.clear();
+    lod_ = 0;
+}
+
+/**
+ * Builds a vertex array containing the mesh vertex data.
+ *
+ * The way the vertex array is constructed is affected by the current
+ * interleave value, which can set using ::interleave().
+ */
+void
+Mesh::build_array()
+{
+    if (!indices_.empty())
+        build_index_array();
+
+    int nvertices = vertex_count();
+
+    if (!interleave_) {
+        /* Create an array for each attribute */
+        for (std::vector<std::pair<int, int> >::const_iterator ai = vertex_format_.begin();
+             ai != vertex_format_.end();
+             ai++)
+        {
+            float *array = new float[nvertices * ai->first];
+            float *cur = array;
+
+            /* Fill in the array */
+            for (int v = 0; v < nvertices; v++) {
+                const float *src = vertex(v) + ai->second;
+                for (int i = 0; i < ai->first; i++)
+                    *cur++ = src[i];
+            }
+
+            vertex_arrays_.push_back(array);
+            attrib_data_ptr_.push_back(array);
+        }
+        vertex_arrays_shared_ = false;
+        vertex_stride_ = 0;
+    }
+    else {
+        /* The vertex data is already interleaved, so use it in place */
+        float *array = vertex_data_.empty() ? 0 : &vertex_data_[0];
+
+        for (size_t i = 0; i < vertex_format_.size(); i++)
+            attrib_data_ptr_.push_back(array + vertex_format_[i].second);
+
+        vertex_arrays_.push_back(array);
+        vertex_arrays_shared_ = true;
+        vertex_stride_ = vertex_size_ * sizeof(float);
+    }
+}
+
+/**
+ * Builds the index array containing the mesh index data.
+ *
+ * 16-bit indices are used if they can address all vertices, 32-bit
+ * indices otherwise. If 32-bit indices are needed but not supported
+ * (GLES 2.0 without GL_OES_element_index_uint), the indices are expanded
+ * and the mesh is rendered without them. With primitive restart, the
+ * largest index of the type is the restart index, so it can't address a
+ * vertex.
+ */
+void
+Mesh::build_index_array()
+{
+    index_array_.clear();
+
+    if (vertex_count() <= (primitive_restart_ ? 65535U : 65536U)) {
+        index_type_ = GL_UNSIGNED_SHORT;
+        index_array_.resize(indices_.size() * sizeof(GLushort));
+        GLushort *cur = reinterpret_cast<GLushort *>(&index_array_[0]);
+
+        for (std::vector<unsigned int>::const_iterator ii = indices_.begin();
+             ii != indices_.end();
+             ii++)
+        {
+            *cur++ = *ii == restart_index ? 0xffff : static_cast<GLushort>(*ii);
+        }
+        return;
+    }
+
+#if GLMARK2_USE_GLESv2
+    if (!GLExtensions::support("GL_OES_element_index_uint")) {
+        Log::debug("32-bit indices are not supported, expanding %u indices\n",
+                   static_cast<unsigned int>(indices_.size()));
+        expand_indices();
+        return;
+    }
+#endif
+
+    index_type_ = GL_UNSIGNED_INT;
+    index_array_.resize(indices_.size() * sizeof(GLuint));
+    std::copy(indices_.begin(), indices_.end(),
+              reinterpret_cast<GLuint *>(&index_array_[0]));
+}
+
+/**
+ * Converts an indexed mesh to a non-indexed one.
+ *
+ * The index ranges of the levels of detail become ranges of vertices.
+ */
+void
+Mesh::expand_indices()
+{
+    std::vector<float> vertex_data;
+    vertex_data.reserve(indices_.size() * vertex_size_);
+
+    for (std::vector<unsigned int>::const_iterator ii = indices_.begin();
+         ii != indices_.end();
+         ii++)
+    {
+        vertex_data.insert(vertex_data.end(), vertex(*ii), vertex(*ii) + vertex_size_);
+    }
+
+    vertex_data_.swap(vertex_data);
+    indices_.clear();
+}
+
+/*
+ * Converts a float to a half float, rounding to nearest even.
+ */
+static uint16_t
+float_to_half(float f)
+{
+    uint32_t x;
+    std::memcpy(&x, &f, sizeof(x));
+
+    uint32_t sign((x >> 16) & 0x8000);
+    uint32_t mant(x & 0x7fffff);
+    int exp(static_cast<int>((x >> 23) & 0xff) - 127 + 15);
+
+    /* Infinity and NaN */
+    if (((x >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    /* Too large, round to infinity */
+    if (exp >= 0x1f)
+        return sign | 0x7c00;
+    /* Denormals and zero */
+    if (exp <= 0) {
+        if (exp < -10)
+            return sign;
+        mant |= 0x800000;
+        unsigned int shift(14 - exp);
+        uint32_t h(mant >> shift);
+        uint32_t rem(mant & ((1u << shift) - 1));
+        uint32_t halfway(1u << (shift - 1));
+        if (rem > halfway || (rem == halfway && (h & 1)))
+            h++;
+        return sign | h;
+    }
+
+    /* A carry out of the mantissa correctly bumps the exponent */
+    uint32_t h(sign | (exp << 10) | (mant >> 13));
+    uint32_t rem(mant & 0x1fff);
+    if (rem > 0x1000 || (rem == 0x1000 && (h & 1)))
+        h++;
+    return h;
+}
+
+/*
+ * Converts a single attribute value from floats to a storage format.
+ */
+static void
+pack_attrib(Mesh::AttribFormat format, int dim, const float *src,
+            unsigned char *dest)
+{
+    if (format == Mesh::AttribFormatHalfFloat) {
+        uint16_t h[4] = {0, 0, 0, 0};
+        for (int i = 0; i < dim; i++)
+            h[i] = float_to_half(src[i]);
+        std::memcpy(dest, h, (dim * sizeof(uint16_t) + 3) & ~3);
+    }
+    else if (format == Mesh::AttribFormatInt2101010Rev) {
+        uint32_t packed(0);
+        for (int i = 0; i < dim && i < 3; i++) {
+            float v(std::min(std::max(src[i], -1.0f), 1.0f));
+            int32_t c(static_cast<int32_t>(std::floor(v * 511.0f + 0.5f)));
+            packed |= (static_cast<uint32_t>(c) & 0x3ff) << (10 * i);
+        }
+        std::memcpy(dest, &packed, sizeof(packed));
+    }
+    else if (format == Mesh::AttribFormatUnsignedShortNorm) {
+        uint16_t u[4] = {0, 0, 0, 0};
+        for (int i = 0; i < dim; i++) {
+            float v(std::min(std::max(src[i], 0.0f), 1.0f));
+            u[i] = static_cast<uint16_t>(v * 65535.0f + 0.5f);
+        }
+        std::memcpy(dest, u, (dim * sizeof(uint16_t) + 3) & ~3);
+    }
+    else {
+        std::memcpy(dest, src, dim * sizeof(float));
+    }
+}
+
+/*
+ * Creates persistently mapped storage for the bound VBO, with all segments
+ * initialized to the supplied data.
+ *
+ * @return the mapping of the VBO, or 0 on failure
+ */
+static unsigned char *
+create_persistent_vbo(const unsigned char *data, size_t size, unsigned int segments)
+{
+    static const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                    GL_MAP_COHERENT_BIT;
+
+    GLExtensions::BufferStorage(GL_ARRAY_BUFFER, size * segments, 0, flags);
+
+    unsigned char *ptr = static_cast<unsigned char *>(
+        GLExtensions::MapBufferRange(GL_ARRAY_BUFFER, 0, size * segments, flags));
+    if (!ptr) {
+        Log::error("Failed to map persistent vertex buffer\n");
+        return 0;
+    }
+
+    for (unsigned int i = 0; i < segments; i++)
+        std::copy(data, data + size, ptr + i * size);
+
+    return ptr;
+}
+
+/**
+ * Builds a vertex buffer object containing the mesh vertex data.
+ *
+ * The way the VBO is constructed is affected by the current interleave
+ * value (::interleave()) and the vbo usage hint (::vbo_usage()).
+ */
+void
+Mesh::build_vbo()
+{
+    delete_array();
+
+    /* The vertex arrays aren't needed, the VBOs are packed from the vertex data */
+    if (!indices_.empty())
+        build_index_array();
+
+    int nvertices = vertex_count();
+
+    attrib_data_ptr_.clear();
+    attrib_offsets_.clear();
+
+    /* Lay out the attributes in the VBO vertex data */
+    size_t offset(0);
+    for (size_t i = 0; i < vertex_format_.size(); i++) {
+        attrib_offsets_.push_back(interleave_ ? offset : 0);
+        attrib_data_ptr_.push_back(reinterpret_cast<float *>(attrib_offsets_[i]));
+        offset += attrib_packed_size(i);
+    }
+    vertex_stride_ = interleave_ ? offset : 0;
+
+    /* Interleaved VBOs have always used GL_STATIC_DRAW */
+    GLenum buffer_usage = interleave_ ? GL_STATIC_DRAW : vbo_buffer_usage();
+
+    /*
+     * Create a vbo for each attribute, or a single vbo to store all
+     * attribute data, and the extra copies of multi-buffered VBOs.
+     */
+    unsigned int copies =
+        vbo_update_method_ == VBOUpdateMethodPersistent ? 1 : vbo_buffering_;
+    size_t nvbos = interleave_ ? 1 : vertex_format_.size();
+
+    vbo_copies_.assign(copies, std::vector<GLuint>());
+
+    /*
+     * Interleaved float data are uploaded in place. Otherwise a single VBO
+     * is packed straight into its mapping, and multiple copies from a
+     * staging buffer shared by all the VBOs.
+     */
+    std::vector<unsigned char> staging;
+    bool can_map = (GLExtensions::MapBufferRange || GLExtensions::MapBuffer) &&
+                   GLExtensions::UnmapBuffer;
+
+    for (size_t n = 0; n < nvbos; n++) {
+        size_t size(vbo_size(n));
+        const unsigned char *data(0);
+        bool mapped(false);
+
+        if (interleave_ && attrib_formats_.empty() && nvertices > 0) {
+            data = reinterpret_cast<const unsigned char *>(&vertex_data_[0]);
+        }
+        else if (can_map && copies == 1 && size > 0 &&
+                 vbo_update_method_ != VBOUpdateMethodPersistent)
+        {
+            mapped = true;
+        }
+        else if (size > 0) {
+            staging.resize(size);
+            pack_vertex_data(n, &staging[0]);
+            data = &staging[0];
+        }
+
+        for (unsigned int c = 0; c < copies; c++) {
+            GLuint vbo;
+
+            glGenBuffers(1, &vbo);
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            if (vbo_update_method_ == VBOUpdateMethodPersistent) {
+                persistent_data_.push_back(
+                    create_persistent_vbo(data, size, persistent_segments));
+            }
+            else if (!mapped || !upload_mapped_vbo(n, buffer_usage)) {
+                if (mapped) {
+                    staging.resize(size);
+                    pack_vertex_data(n, &staging[0]);
+                    data = &staging[0];
+                }
+                glBufferData(GL_ARRAY_BUFFER, size, data, buffer_usage);
+            }
+
+            vbo_copies_[c].push_back(vbo);
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    /* All attributes use the single interleaved vbo */
+    if (interleave_ && !vertex_format_.empty()) {
+        for (unsigned int c = 0; c < copies; c++)
+            vbo_copies_[c].resize(vertex_format_.size(), vbo_copies_[c][0]);
+        if (!persistent_data_.empty())
+            persistent_data_.resize(vertex_format_.size(), persistent_data_[0]);
+    }
+
+    vbos_ = vbo_copies_[0];
+
+    vbo_copy_ = 0;
+    persistent_segment_ = 0;
+    update_history_.clear();
+
+    if (use_vao_ && GLExtensions::GenVertexArrays) {
+        GLExtensions::GenVertexArrays(1, &vao_);
+        vao_dirty_ = true;
+    }
+
+    if (!index_array_.empty()) {
+        glGenBuffers(1, &index_buffer_);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_array_.size(),
+                     &index_array_[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    delete_array();
+}
+
+/**
+ * Updates ranges of a single vertex array.
+ *
+ * @param ranges the ranges of vertices to update
+ * @param n the index of the vertex array to update
+ * @param nfloats how many floats to update for each vertex
+ * @param offset the offset (in floats) in the vertex data to start reading from
+ */
+void
+Mesh::update_single_array(const std::vector<std::pair<size_t, size_t> >& ranges,
                           size_t n, size_t nfloats, size_t offset)
 {
     float *array(vertex_arrays_[n]);
@@ -396,7 +1638,7 @@ Mesh::update_single_array(const std::vector<std::pair<size_t, size_t> >& ranges,
         /* Update the current range from the vertex data */
         float *dest(array + nfloats * ri->first);
         for (size_t n = ri->first; n <= ri->second; n++) {
-            float *src(vertices_[n].data() + offset);
+            const float *src(vertex(n) + offset);
             std::copy(src, src + nfloats, dest);
             dest += nfloats;
         }
@@ -418,14 +1660,13 @@ Mesh::update_array(const std::vector<std::pair<size_t, size_t> >& ranges)
         return;
     }
 
-    if (!interleave_) {
-        for (size_t i = 0; i < vertex_arrays_.size(); i++) {
-            update_single_array(ranges, i, vertex_format_[i].first,
-                                vertex_format_[i].second);
-        }
-    }
-    else {
-        update_single_array(ranges, 0, vertex_size_, 0);
+    /* Shared arrays are the vertex data itself and are always up to date */
+    if (vertex_arrays_shared_)
+        return;
+
+    for (size_t i = 0; i < vertex_arrays_.size(); i++) {
+        update_single_array(ranges, i, vertex_format_[i].first,
+                            vertex_format_[i].second);
     }
 
 }
@@ -434,26 +1675,54 @@ Mesh::update_array(const std::vector<std::pair<size_t, size_t> >& ranges)
 /**
  * Updates ranges of a single VBO.
  *
- * This method use either glMapBuffer or glBufferSubData to perform
- * the update. The used method can be set with ::vbo_update_method().
+ * This method use either glMapBuffer, glBufferSubData or glMapBufferRange
+ * to perform the update. The used method can be set with
+ * ::vbo_update_method().
  *
  * @param ranges the ranges of vertices to update
  * @param n the index of the vbo to update
- * @param nfloats how many floats to update for each vertex
  */
 void
-Mesh::update_single_vbo(const std::vector<std::pair<size_t, size_t> >& ranges,
-                        size_t n, size_t nfloats)
+Mesh::update_single_vbo(const std::vector<std::pair<size_t, size_t> >& supplied_ranges,
+                        size_t n)
 {
-    float *src_start(vertex_arrays_[n]);
-    float *dest_start(0);
+    size_t vertex_size(vbo_vertex_size(n));
+    unsigned char *dest_start(0);
+    /* The offset in the VBO of dest_start */
+    size_t map_offset(0);
+
+    if (vbo_coalesce_) {
+        coalesce_ranges(supplied_ranges, vertex_size, coalesced_ranges_);
+        if (coalesced_ranges_.empty())
+            return;
+    }
+
+    const std::vector<std::pair<size_t, size_t> >& ranges(vbo_coalesce_ ? coalesced_ranges_ :
+                                                          supplied_ranges);
 
     glBindBuffer(GL_ARRAY_BUFFER, vbos_[n]);
 
+    if (vbo_orphan_)
+        glBufferData(GL_ARRAY_BUFFER, vbo_size(n), 0, vbo_buffer_usage());
+
     if (vbo_update_method_ == VBOUpdateMethodMap) {
-        dest_start = reinterpret_cast<float *>(
-                GLExtensions::MapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY)
-                );
+        if (vbo_coalesce_ && GLExtensions::MapBufferRange) {
+            /* The vertices between the ranges keep their contents */
+            map_offset = vertex_size * ranges.front().first;
+            dest_start = reinterpret_cast<unsigned char *>(
+                GLExtensions::MapBufferRange(GL_ARRAY_BUFFER, map_offset,
+                                             vertex_size * (ranges.back().second + 1) - map_offset,
+                                             GL_MAP_WRITE_BIT));
+        }
+        else {
+            dest_start = reinterpret_cast<unsigned char *>(
+                    GLExtensions::MapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY)
+                    );
+        }
+        vbo_update_calls_++;
+
+        if (!dest_start)
+            return;
     }
 
     /* Update supplied ranges */
@@ -461,16 +1730,46 @@ Mesh::update_single_vbo(const std::vector<std::pair<size_t, size_t> >& ranges,
          iter != ranges.end();
          iter++)
     {
-        float *src(src_start + nfloats * iter->first);
-        float *src_end(src_start + nfloats * (iter->second + 1));
+        size_t offset(vertex_size * iter->first);
+        size_t size(vertex_size * (iter->second - iter->first + 1));
+
+        vbo_update_bytes_ += size;
+        if (vbo_update_method_ != VBOUpdateMethodMap)
+            vbo_update_calls_++;
 
         if (vbo_update_method_ == VBOUpdateMethodMap) {
-            float *dest(dest_start + nfloats * iter->first);
-            std::copy(src, src_end, dest);
+            pack_vertices(n, iter->first, iter->second, dest_start + offset - map_offset);
         }
         else if (vbo_update_method_ == VBOUpdateMethodSubData) {
-            glBufferSubData(GL_ARRAY_BUFFER, nfloats * iter->first * sizeof(float),
-                            (src_end - src) * sizeof(float), src);
+            const void *src;
+
+            /* Float data can be uploaded straight from the vertex array */
+            if (attrib_formats_.empty()) {
+                src = reinterpret_cast<const unsigned char *>(vertex_arrays_[n]) + offset;
+            }
+            else {
+                packed_vertices_.resize(size);
+                pack_vertices(n, iter->first, iter->second, &packed_vertices_[0]);
+                src = &packed_vertices_[0];
+            }
+
+            glBufferSubData(GL_ARRAY_BUFFER, offset, size, src);
+        }
+        else if (vbo_update_method_ == VBOUpdateMethodMapRange) {
+            /*
+             * Don't wait for pending draws that use the buffer, like
+             * streaming applications do. The GPU may still see part of
+             * the update in the previous frame.
+             */
+            unsigned char *dest = reinterpret_cast<unsigned char *>(
+                GLExtensions::MapBufferRange(GL_ARRAY_BUFFER, offset, size,
+                                             GL_MAP_WRITE_BIT |
+                                             GL_MAP_INVALIDATE_RANGE_BIT |
+                                             GL_MAP_UNSYNCHRONIZED_BIT));
+            if (dest) {
+                pack_vertices(n, iter->first, iter->second, dest);
+                GLExtensions::UnmapBuffer(GL_ARRAY_BUFFER);
+            }
         }
     }
 
@@ -478,6 +1777,311 @@ Mesh::update_single_vbo(const std::vector<std::pair<size_t, size_t> >& ranges,
         GLExtensions::UnmapBuffer(GL_ARRAY_BUFFER);
 }
 
+/**
+ * Sorts the ranges of a VBO update and merges those that overlap or are
+ * separated by at most vbo_coalesce_gap_ bytes.
+ *
+ * @param ranges the ranges of vertices to update
+ * @param vertex_size the size in bytes of a vertex in the VBO
+ * @param merged the vector to put the merged ranges in
+ */
+void
+Mesh::coalesce_ranges(const std::vector<std::pair<size_t, size_t> >& ranges,
+                      size_t vertex_size,
+                      std::vector<std::pair<size_t, size_t> >& merged) const
+{
+    size_t max_gap(vbo_coalesce_gap_ / vertex_size);
+
+    /* Sort the ranges, then merge them in place */
+    merged.assign(ranges.begin(), ranges.end());
+    std::sort(merged.begin(), merged.end());
+
+    size_t last(0);
+    for (size_t i = 1; i < merged.size(); i++) {
+        if (merged[i].first <= merged[last].second + 1 ||
+            merged[i].first - merged[last].second - 1 <= max_gap)
+        {
+            merged[last].second = std::max(merged[last].second, merged[i].second);
+        }
+        else {
+            merged[++last] = merged[i];
+        }
+    }
+
+    if (!merged.empty())
+        merged.resize(last + 1);
+}
+
+/**
+ * Gets the size in bytes of the vertex data of a VBO (or of a single
+ * segment of a persistent VBO).
+ *
+ * @param n the index of the vbo
+ */
+size_t
+Mesh::vbo_size(size_t n) const
+{
+    return vertex_count() * vbo_vertex_size(n);
+}
+
+/**
+ * Gets the size in bytes of a single vertex in a VBO.
+ *
+ * @param n the index of the vbo
+ */
+size_t
+Mesh::vbo_vertex_size(size_t n) const
+{
+    if (!interleave_)
+        return attrib_packed_size(n);
+
+    size_t size(0);
+    for (size_t i = 0; i < vertex_format_.size(); i++)
+        size += attrib_packed_size(i);
+
+    return size;
+}
+
+/**
+ * Gets the storage format of an attribute in VBOs.
+ */
+Mesh::AttribFormat
+Mesh::attrib_format(size_t i) const
+{
+    return i < attrib_formats_.size() ? attrib_formats_[i] : AttribFormatFloat;
+}
+
+/**
+ * Gets the size in bytes of an attribute in VBOs.
+ *
+ * Packed attributes are padded to a multiple of 4 bytes, which some GPUs
+ * require for efficient (or any) vertex fetching.
+ */
+size_t
+Mesh::attrib_packed_size(size_t i) const
+{
+    int dim(vertex_format_[i].first);
+
+    switch (attrib_format(i)) {
+        case AttribFormatHalfFloat:
+        case AttribFormatUnsignedShortNorm:
+            return (dim * sizeof(uint16_t) + 3) & ~3;
+        case AttribFormatInt2101010Rev:
+            return sizeof(uint32_t);
+        case AttribFormatFloat:
+        default:
+            return dim * sizeof(float);
+    }
+}
+
+/**
+ * Converts a range of vertices from a vertex array to the VBO storage
+ * formats.
+ *
+ * @param n the index of the vbo (and vertex array)
+ * @param first the first vertex to convert
+ * @param last the last vertex to convert
+ * @param dest where to store the vertex data of the first vertex
+ */
+void
+Mesh::pack_vertices(size_t n, size_t first, size_t last, unsigned char *dest) const
+{
+    size_t nfloats = interleave_ ? vertex_size_ : vertex_format_[n].first;
+    const float *src(vertex_arrays_[n] + nfloats * first);
+
+    if (attrib_formats_.empty()) {
+        std::memcpy(dest, src, (last - first + 1) * nfloats * sizeof(float));
+        return;
+    }
+
+    size_t first_attrib(interleave_ ? 0 : n);
+    size_t last_attrib(interleave_ ? vertex_format_.size() - 1 : n);
+    size_t vertex_size(vbo_vertex_size(n));
+
+    for (size_t v = first; v <= last; v++) {
+        for (size_t i = first_attrib; i <= last_attrib; i++) {
+            size_t src_offset(interleave_ ? vertex_format_[i].second : 0);
+            pack_attrib(attrib_format(i), vertex_format_[i].first,
+                        src + src_offset, dest + attrib_offsets_[i]);
+        }
+        src += nfloats;
+        dest += vertex_size;
+    }
+}
+
+/**
+ * Packs all the vertices of a VBO straight from the vertex data, without
+ * going through the vertex arrays.
+ *
+ * @param n the index of the vbo
+ * @param dest where to write the packed vertices
+ */
+void
+Mesh::pack_vertex_data(size_t n, unsigned char *dest) const
+{
+    size_t nvertices(vertex_count());
+
+    if (nvertices == 0)
+        return;
+
+    const float *src(&vertex_data_[0]);
+
+    if (interleave_ && attrib_formats_.empty()) {
+        std::memcpy(dest, src, vertex_data_.size() * sizeof(float));
+        return;
+    }
+
+    size_t first_attrib(interleave_ ? 0 : n);
+    size_t last_attrib(interleave_ ? vertex_format_.size() - 1 : n);
+    size_t vertex_size(vbo_vertex_size(n));
+
+    for (size_t v = 0; v < nvertices; v++) {
+        for (size_t i = first_attrib; i <= last_attrib; i++) {
+            const float *attrib(src + vertex_format_[i].second);
+
+            if (attrib_formats_.empty()) {
+                std::memcpy(dest + attrib_offsets_[i], attrib,
+                            vertex_format_[i].first * sizeof(float));
+            }
+            else {
+                pack_attrib(attrib_format(i), vertex_format_[i].first,
+                            attrib, dest + attrib_offsets_[i]);
+            }
+        }
+        src += vertex_size_;
+        dest += vertex_size;
+    }
+}
+
+/**
+ * Allocates the storage of the bound VBO and packs the vertices straight
+ * into its mapping, which avoids a copy of the vertex data in memory.
+ *
+ * @param n the index of the vbo
+ * @param usage the usage hint of the storage
+ *
+ * @return whether the vertices were uploaded
+ */
+bool
+Mesh::upload_mapped_vbo(size_t n, GLenum usage)
+{
+    size_t size(vbo_size(n));
+    unsigned char *dest;
+
+    glBufferData(GL_ARRAY_BUFFER, size, 0, usage);
+
+    if (GLExtensions::MapBufferRange) {
+        dest = static_cast<unsigned char *>(
+            GLExtensions::MapBufferRange(GL_ARRAY_BUFFER, 0, size,
+                                         GL_MAP_WRITE_BIT |
+                                         GL_MAP_INVALIDATE_BUFFER_BIT));
+    }
+    else {
+        dest = static_cast<unsigned char *>(
+            GLExtensions::MapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY));
+    }
+
+    if (!dest)
+        return false;
+
+    pack_vertex_data(n, dest);
+
+    /* The contents are undefined if the mapping was lost */
+    return GLExtensions::UnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+}
+
+/**
+ * Gets the GL usage hint for the VBOs.
+ */
+GLenum
+Mesh::vbo_buffer_usage() const
+{
+    if (vbo_usage_ == Mesh::VBOUsageStream)
+        return GL_STREAM_DRAW;
+    else if (vbo_usage_ == Mesh::VBOUsageDynamic)
+        return GL_DYNAMIC_DRAW;
+    else /* if (vbo_usage_ == Mesh::VBOUsageStatic) */
+        return GL_STATIC_DRAW;
+}
+
+/**
+ * Records the ranges of an update for VBOs with multiple copies.
+ *
+ * @param ranges the ranges of vertices to update
+ * @param depth the number of VBO copies
+ * @param all_ranges the vector to put the ranges that need updating in the
+ *        copy that was last written depth updates ago, i.e. the ranges of
+ *        the last depth updates
+ */
+void
+Mesh::record_update(const std::vector<std::pair<size_t, size_t> >& ranges,
+                    size_t depth,
+                    std::vector<std::pair<size_t, size_t> >& all_ranges)
+{
+    /* Reuse the storage of the oldest update for the new one */
+    if (update_history_.size() >= depth) {
+        std::rotate(update_history_.begin(),
+                    update_history_.begin() + (update_history_.size() - depth + 1),
+                    update_history_.end());
+        update_history_.resize(depth);
+        update_history_.back().assign(ranges.begin(), ranges.end());
+    }
+    else {
+        update_history_.push_back(ranges);
+    }
+
+    all_ranges.clear();
+    for (size_t h = 0; h < update_history_.size(); h++) {
+        all_ranges.insert(all_ranges.end(), update_history_[h].begin(),
+                          update_history_[h].end());
+    }
+}
+
+/**
+ * Updates ranges of the persistently mapped VBOs.
+ *
+ * The update goes to the next segment, after waiting for the GPU to finish
+ * the draws that use it. That segment was last written persistent_segments
+ * updates ago, so the ranges of the updates since then are copied too.
+ *
+ * @param ranges the ranges of vertices to update
+ */
+void
+Mesh::update_persistent_vbos(const std::vector<std::pair<size_t, size_t> >& ranges)
+{
+    persistent_segment_ = (persistent_segment_ + 1) % persistent_segments;
+    vao_dirty_ = true;
+
+    GLsync &fence(persistent_fences_[persistent_segment_]);
+    if (fence) {
+        GLExtensions::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        GLExtensions::DeleteSync(fence);
+        fence = 0;
+    }
+
+    record_update(ranges, persistent_segments, vbo_ranges_);
+
+    size_t nvbos = interleave_ ? 1 : vbos_.size();
+
+    for (size_t n = 0; n < nvbos; n++) {
+        if (!persistent_data_[n])
+            continue;
+
+        size_t vertex_size(vbo_vertex_size(n));
+        unsigned char *dest_start(persistent_data_[n] +
+                                  persistent_segment_ * vbo_size(n));
+
+        for (std::vector<std::pair<size_t, size_t> >::const_iterator iter = vbo_ranges_.begin();
+             iter != vbo_ranges_.end();
+             iter++)
+        {
+            pack_vertices(n, iter->first, iter->second,
+                          dest_start + vertex_size * iter->first);
+            vbo_update_bytes_ += vertex_size * (iter->second - iter->first + 1);
+        }
+    }
+}
+
 /**
  * Updates ranges of the VBOs.
  *
@@ -494,12 +2098,35 @@ Mesh::update_vbo(const std::vector<std::pair<size_t, size_t> >& ranges)
 
     update_array(ranges);
 
+    if (vbo_update_method_ == VBOUpdateMethodPersistent) {
+        update_persistent_vbos(ranges);
+        return;
+    }
+
+    /*
+     * Orphaned VBOs lose their contents so they are rewritten completely,
+     * while multi-buffered VBOs also need the updates made to the other
+     * copies since they were last used.
+     */
+    if (vbo_orphan_)
+        vbo_ranges_.assign(1, std::pair<size_t, size_t>(0, vertex_count() - 1));
+    else if (vbo_copies_.size() > 1)
+        record_update(ranges, vbo_copies_.size(), vbo_ranges_);
+    else
+        vbo_ranges_.assign(ranges.begin(), ranges.end());
+
+    if (vbo_copies_.size() > 1) {
+        vbo_copy_ = (vbo_copy_ + 1) % vbo_copies_.size();
+        vbos_ = vbo_copies_[vbo_copy_];
+        vao_dirty_ = true;
+    }
+
     if (!interleave_) {
         for (size_t i = 0; i < vbos_.size(); i++)
-            update_single_vbo(ranges, i, vertex_format_[i].first);
+            update_single_vbo(vbo_ranges_, i);
     }
     else {
-        update_single_vbo(ranges, 0, vertex_size_);
+        update_single_vbo(vbo_ranges_, 0);
     }
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -512,11 +2139,14 @@ Mesh::update_vbo(const std::vector<std::pair<size_t, size_t> >& ranges)
 void
 Mesh::delete_array()
 {
-    for (size_t i = 0; i < vertex_arrays_.size(); i++) {
-        delete [] vertex_arrays_[i];
+    if (!vertex_arrays_shared_) {
+        for (size_t i = 0; i < vertex_arrays_.size(); i++)
+            delete [] vertex_arrays_[i];
     }
 
     vertex_arrays_.clear();
+    vertex_arrays_shared_ = false;
+    index_array_.clear();
 }
 
 /**
@@ -525,12 +2155,41 @@ Mesh::delete_array()
 void
 Mesh::delete_vbo()
 {
-    for (size_t i = 0; i < vbos_.size(); i++) {
-        GLuint vbo = vbos_[i];
-        glDeleteBuffers(1, &vbo);
+    for (size_t i = 0; i < persistent_data_.size(); i++) {
+        if (persistent_data_[i] && (i == 0 || !interleave_)) {
+            glBindBuffer(GL_ARRAY_BUFFER, vbos_[i]);
+            GLExtensions::UnmapBuffer(GL_ARRAY_BUFFER);
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    persistent_data_.clear();
+
+    for (unsigned int i = 0; i < persistent_segments; i++) {
+        if (persistent_fences_[i]) {
+            GLExtensions::DeleteSync(persistent_fences_[i]);
+            persistent_fences_[i] = 0;
+        }
+    }
+
+    for (size_t c = 0; c < vbo_copies_.size(); c++) {
+        for (size_t i = 0; i < vbo_copies_[c].size(); i++) {
+            GLuint vbo = vbo_copies_[c][i];
+            glDeleteBuffers(1, &vbo);
+        }
     }
 
+    vbo_copies_.clear();
     vbos_.clear();
+
+    if (vao_) {
+        GLExtensions::DeleteVertexArrays(1, &vao_);
+        vao_ = 0;
+    }
+
+    if (index_buffer_) {
+        glDeleteBuffers(1, &index_buffer_);
+        index_buffer_ = 0;
+    }
 }
 
 
@@ -552,7 +2211,20 @@ Mesh::render_array()
                               attrib_data_ptr_[i]);
     }
 
-    glDrawArrays(GL_TRIANGLES, 0, vertices_.size());
+    size_t first;
+    size_t count;
+    draw_range(first, count);
+
+    if (!indices_.empty()) {
+        if (primitive_restart_)
+            glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+        glDrawElements(primitive_, count, index_type_, &index_array_[first * index_size()]);
+        if (primitive_restart_)
+            glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+    }
+    else {
+        glDrawArrays(primitive_, first, count);
+    }
 
     for (size_t i = 0; i < vertex_format_.size(); i++) {
         if (attrib_locations_[i] < 0)
@@ -561,6 +2233,59 @@ Mesh::render_array()
     }
 }
 
+/*
+ * Specifies the attribute state for the current VBOs.
+ */
+void
+Mesh::setup_vbo_attribs()
+{
+#if GLMARK2_USE_GLESv2
+    static const GLenum half_float_type =
+        GLExtensions::version_supported(3, 0) ? GL_HALF_FLOAT : GL_HALF_FLOAT_OES;
+#else
+    static const GLenum half_float_type = GL_HALF_FLOAT;
+#endif
+
+    for (size_t i = 0; i < vertex_format_.size(); i++) {
+        if (attrib_locations_[i] < 0)
+            continue;
+        /* Persistent VBOs are drawn from the last updated segment */
+        const char *data_ptr = reinterpret_cast<const char *>(attrib_data_ptr_[i]);
+        if (!persistent_data_.empty())
+            data_ptr += persistent_segment_ * vbo_size(i);
+
+        GLint size(vertex_format_[i].first);
+        GLenum type(GL_FLOAT);
+        GLboolean normalized(GL_FALSE);
+
+        switch (attrib_format(i)) {
+            case AttribFormatHalfFloat:
+                type = half_float_type;
+                break;
+            case AttribFormatInt2101010Rev:
+                size = 4;
+                type = GL_INT_2_10_10_10_REV;
+                normalized = GL_TRUE;
+                break;
+            case AttribFormatUnsignedShortNorm:
+                type = GL_UNSIGNED_SHORT;
+                normalized = GL_TRUE;
+                break;
+            case AttribFormatFloat:
+            default:
+                break;
+        }
+
+        /* Packed attributes may be padded, so always give their stride */
+        GLsizei stride(interleave_ ? vertex_stride_ : attrib_packed_size(i));
+
+        glEnableVertexAttribArray(attrib_locations_[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, vbos_[i]);
+        glVertexAttribPointer(attrib_locations_[i], size, type, normalized,
+                              stride, data_ptr);
+    }
+}
+
 /**
  * Renders a mesh using vertex buffer objects.
  *
@@ -570,17 +2295,77 @@ Mesh::render_array()
 void
 Mesh::render_vbo()
 {
-    for (size_t i = 0; i < vertex_format_.size(); i++) {
-        if (attrib_locations_[i] < 0)
-            continue;
-        glEnableVertexAttribArray(attrib_locations_[i]);
-        glBindBuffer(GL_ARRAY_BUFFER, vbos_[i]);
-        glVertexAttribPointer(attrib_locations_[i], vertex_format_[i].first,
-                              GL_FLOAT, GL_FALSE, vertex_stride_,
-                              attrib_data_ptr_[i]);
+    render_vbo_instanced(0);
+}
+
+/**
+ * Renders multiple instances of a mesh using vertex buffer objects.
+ *
+ * The caller is responsible for setting up any per-instance attributes,
+ * which is not supported together with ::vbo_vao(). An instance count of
+ * 0 renders the mesh once without instancing.
+ *
+ * @param instances the number of instances to render
+ */
+void
+Mesh::render_vbo_instanced(unsigned int instances)
+{
+    if (vao_) {
+        GLExtensions::BindVertexArray(vao_);
+        if (vao_dirty_) {
+            setup_vbo_attribs();
+            /* The element array binding is part of the VAO state */
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+            vao_dirty_ = false;
+        }
+    }
+    else {
+        setup_vbo_attribs();
+        if (!indices_.empty())
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+    }
+
+    size_t first;
+    size_t count;
+    draw_range(first, count);
+
+    const void *index_offset = reinterpret_cast<const void *>(first * index_size());
+
+    if (primitive_restart_)
+        glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
+    if (instances > 0 && !indices_.empty()) {
+        GLExtensions::DrawElementsInstanced(primitive_, count,
+                                            index_type_, index_offset, instances);
+    }
+    else if (instances > 0) {
+        GLExtensions::DrawArraysInstanced(primitive_, first, count,
+                                          instances);
+    }
+    else if (!indices_.empty()) {
+        glDrawElements(primitive_, count, index_type_, index_offset);
+    }
+    else {
+        glDrawArrays(primitive_, first, count);
+    }
+
+    if (primitive_restart_)
+        glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
+    if (!persistent_data_.empty()) {
+        GLsync &fence(persistent_fences_[persistent_segment_]);
+        if (fence)
+            GLExtensions::DeleteSync(fence);
+        fence = GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    if (vao_) {
+        GLExtensions::BindVertexArray(0);
+        return;
     }
 
-    glDrawArrays(GL_TRIANGLES, 0, vertices_.size());
+    if (!indices_.empty())
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     for (size_t i = 0; i < vertex_format_.size(); i++) {
         if (attrib_locations_[i] < 0)
@@ -589,52 +2374,195 @@ Mesh::render_vbo()
     }
 }
 
+/**
+ * Gets the grid topology for a "topology" option value.
+ *
+ * @param str "triangles", "indexed" or "strips"
+ */
+Mesh::GridTopology
+Mesh::grid_topology_from_str(const std::string &str)
+{
+    if (str == "indexed")
+        return GridIndexedTriangles;
+    else if (str == "strips")
+        return GridIndexedStrips;
+
+    return GridTriangles;
+}
+
 /**
  * Creates a grid mesh.
  *
+ * The vertex data of all the cells is allocated at once and filled in
+ * parallel for large grids, so the fill function may only write to the
+ * vertices of its cell. The cells are in column order, like their vertices
+ * and indices.
+ *
+ * With the indexed topologies, the cells have 4 vertices, their corners.
+ * If there is no spacing between the cells, the corners are shared with
+ * the neighbouring cells: the fill function then fills the corners of each
+ * cell in a scratch buffer, and only those the cell owns are kept, so it
+ * must give a shared corner the same attributes in every cell. The strips
+ * run along each row of cells, or over each cell if they are spaced, and
+ * are separated by primitive restarts (see ::primitive_restart_supported()).
+ * The cells are always split along their ll-ur diagonal.
+ *
  * @param n_x the number of grid cells on the X axis
  * @param n_y the number of grid cells on the Y axis
  * @param width the width X of the grid (normalized)
  * @param height the height Y of the grid (normalized)
  * @param spacing the spacing between cells (normalized)
- * @param conf_func a function to call to configure the grid (or NULL)
+ * @param fill_func a function to fill the vertices of each cell (or NULL to
+ *        only set their positions)
+ * @param topology how the cells are drawn
  */
 void
 Mesh::make_grid(int n_x, int n_y, double width, double height,
-                double spacing, grid_configuration_func conf_func)
+                double spacing, grid_fill_func fill_func, GridTopology topology)
 {
+    /* Below this many cells per thread, starting the threads isn't worth it */
+    static const size_t min_cells_per_thread = 4096;
+
+    if (n_x <= 0 || n_y <= 0)
+        return;
+
     double side_width = (width - (n_x - 1) * spacing) / n_x;
     double side_height = (height - (n_y - 1) * spacing) / n_y;
+    const size_t cells = static_cast<size_t>(n_x) * n_y;
+    const bool indexed = topology != GridTriangles;
+    const bool strips = topology == GridIndexedStrips;
+    const bool shared = indexed && spacing == 0.0;
+    const size_t cell_vertices = indexed ? 4 : 6;
+    /* The indices of each row strip: 2 per column of corners, and a restart */
+    const size_t row_indices = 2 * (n_x + 1) + 1;
+    const size_t first_vertex = vertex_count();
+    const size_t first_index = indices_.size();
+    size_t nindices = 0;
+
+    if (shared)
+        vertex_data_.resize((first_vertex + (n_x + 1) * (n_y + 1)) * vertex_size_);
+    else
+        vertex_data_.resize((first_vertex + cells * cell_vertices) * vertex_size_);
+
+    /* The last strip isn't followed by a restart */
+    if (strips && shared)
+        nindices = n_y * row_indices - 1;
+    else if (strips)
+        nindices = cells * 5 - 1;
+    else if (indexed)
+        nindices = cells * 6;
+    indices_.resize(first_index + nindices);
+
+    if (strips) {
+        primitive_ = GL_TRIANGLE_STRIP;
+        primitive_restart_ = true;
+    }
 
-    for (int i = 0; i < n_x; i++) {
-        for (int j = 0; j < n_y; j++) {
-            LibMatrix::vec3 a(-width / 2 + i * (side_width + spacing),
-                              height / 2 - j * (side_height + spacing), 0);
-            LibMatrix::vec3 b(a.x(), a.y() - side_height, 0);
-            LibMatrix::vec3 c(a.x() + side_width, a.y(), 0);
-            LibMatrix::vec3 d(a.x() + side_width, a.y() - side_height, 0);
-
-            if (!conf_func) {
-                std::vector<float> ul(vertex_size_);
-                std::vector<float> ur(vertex_size_);
-                std::vector<float> ll(vertex_size_);
-                std::vector<float> lr(vertex_size_);
-
-                set_attrib(0, a, &ul);
-                set_attrib(0, c, &ur);
-                set_attrib(0, b, &ll);
-                set_attrib(0, d, &lr);
-
-                next_vertex(); vertices_.back() = ul;
-                next_vertex(); vertices_.back() = ll;
-                next_vertex(); vertices_.back() = ur;
-                next_vertex(); vertices_.back() = ll;
-                next_vertex(); vertices_.back() = lr;
-                next_vertex(); vertices_.back() = ur;
-            }
-            else {
-                conf_func(*this, i, j, n_x, n_y, a, b, c, d);
+    /* The columns of cells filled by each thread */
+    auto fill_columns = [&](int start, int end) {
+        std::vector<float> scratch(shared ? cell_vertices * vertex_size_ : 0);
+
+        for (int i = start; i < end; i++) {
+            for (int j = 0; j < n_y; j++) {
+                const size_t cell = static_cast<size_t>(i) * n_y + j;
+                const bool right = i == n_x - 1;
+                const bool bottom = j == n_y - 1;
+                /* The vertices of the ul, ll, ur and lr corners */
+                size_t corners[4];
+                float *dest;
+
+                if (shared) {
+                    corners[0] = first_vertex + static_cast<size_t>(i) * (n_y + 1) + j;
+                    corners[1] = corners[0] + 1;
+                    corners[2] = corners[0] + n_y + 1;
+                    corners[3] = corners[2] + 1;
+                    dest = &scratch[0];
+                }
+                else {
+                    for (int k = 0; k < 4; k++)
+                        corners[k] = first_vertex + cell * cell_vertices + k;
+                    dest = &vertex_data_[corners[0] * vertex_size_];
+                }
+
+                LibMatrix::vec3 a(-width / 2 + i * (side_width + spacing),
+                                  height / 2 - j * (side_height + spacing), 0);
+                LibMatrix::vec3 b(a.x(), a.y() - side_height, 0);
+                LibMatrix::vec3 c(a.x() + side_width, a.y(), 0);
+                LibMatrix::vec3 d(a.x() + side_width, a.y() - side_height, 0);
+
+                if (fill_func) {
+                    fill_func(*this, dest, i, j, n_x, n_y, a, b, c, d);
+                }
+                else if (indexed) {
+                    const LibMatrix::vec3 *positions[] = {&a, &b, &c, &d};
+                    for (int k = 0; k < 4; k++)
+                        set_attrib(0, *positions[k], dest + k * vertex_size_);
+                }
+                else {
+                    /* ul, ll, ur, ll, lr, ur */
+                    const LibMatrix::vec3 *positions[] = {&a, &b, &c, &b, &d, &c};
+                    for (int k = 0; k < 6; k++)
+                        set_attrib(0, *positions[k], dest + k * vertex_size_);
+                }
+
+                if (shared) {
+                    /* A cell owns its ul corner, and those on the right and bottom edges */
+                    const bool owned[] = {true, bottom, right, right && bottom};
+                    for (int k = 0; k < 4; k++) {
+                        if (owned[k]) {
+                            std::copy(dest + k * vertex_size_, dest + (k + 1) * vertex_size_,
+                                      &vertex_data_[corners[k] * vertex_size_]);
+                        }
+                    }
+                }
+
+                if (strips && shared) {
+                    /* The ul and ll corners of each column, then the ur and lr ones */
+                    unsigned int *index = &indices_[first_index + j * row_indices + 2 * i];
+                    index[0] = static_cast<unsigned int>(corners[0]);
+                    index[1] = static_cast<unsigned int>(corners[1]);
+                    if (right) {
+                        index[2] = static_cast<unsigned int>(corners[2]);
+                        index[3] = static_cast<unsigned int>(corners[3]);
+                        if (!bottom)
+                            index[4] = restart_index;
+                    }
+                }
+                else if (strips) {
+                    /* ul, ll, ur, lr */
+                    unsigned int *index = &indices_[first_index + cell * 5];
+                    for (int k = 0; k < 4; k++)
+                        index[k] = static_cast<unsigned int>(corners[k]);
+                    if (cell + 1 < cells)
+                        index[4] = restart_index;
+                }
+                else if (indexed) {
+                    /* ul, ll, ur, ll, lr, ur */
+                    static const unsigned int order[] = {0, 1, 2, 1, 3, 2};
+                    unsigned int *index = &indices_[first_index + cell * 6];
+                    for (int k = 0; k < 6; k++)
+                        index[k] = static_cast<unsigned int>(corners[order[k]]);
+                }
             }
         }
+    };
+
+    unsigned int nthreads = std::min<size_t>(std::thread::hardware_concurrency(), 8);
+    nthreads = std::max<size_t>(1, std::min<size_t>(nthreads, cells / min_cells_per_thread));
+    nthreads = std::min<unsigned int>(nthreads, n_x);
+
+    if (nthreads <= 1) {
+        fill_columns(0, n_x);
+        return;
     }
+
+    std::vector<std::thread> threads;
+    for (unsigned int t = 0; t < nthreads; t++) {
+        threads.push_back(std::thread(fill_columns,
+                                      static_cast<int>(static_cast<int64_t>(n_x) * t / nthreads),
+                                      static_cast<int>(static_cast<int64_t>(n_x) * (t + 1) / nthreads)));
+    }
+
+    for (std::vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); iter++)
+        iter->join();
 }
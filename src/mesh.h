@@ -25,7 +25,9 @@
 #ifndef GLMARK2_MESH_H_
 #define GLMARK2_MESH_H_
 
+#include <string>
 #include <vector>
+#include <stdint.h>
 #include "vec.h"
 #include "gl-headers.h"
 
@@ -40,16 +42,25 @@ public:
 
     void set_vertex_format(const std::vector<int> &format);
     void set_attrib_locations(const std::vector<int> &locations);
+    const std::vector<int> &attrib_locations() const { return attrib_locations_; }
 
-    void set_attrib(unsigned int pos, const LibMatrix::vec2 &v, std::vector<float> *vertex = 0);
-    void set_attrib(unsigned int pos, const LibMatrix::vec3 &v, std::vector<float> *vertex = 0);
-    void set_attrib(unsigned int pos, const LibMatrix::vec4 &v, std::vector<float> *vertex = 0);
+    void set_attrib(unsigned int pos, const LibMatrix::vec2 &v, float *vertex = 0);
+    void set_attrib(unsigned int pos, const LibMatrix::vec3 &v, float *vertex = 0);
+    void set_attrib(unsigned int pos, const LibMatrix::vec4 &v, float *vertex = 0);
     void next_vertex();
-    std::vector<std::vector<float> >& vertices();
+    void pop_vertex();
+    void reserve_vertices(size_t count);
+    size_t vertex_count() const;
+    int vertex_size() const { return vertex_size_; }
+    float *vertex(size_t n) { return &vertex_data_[n * vertex_size_]; }
+    void add_index(unsigned int index);
+    std::vector<unsigned int>& indices();
 
     enum VBOUpdateMethod {
         VBOUpdateMethodMap,
         VBOUpdateMethodSubData,
+        VBOUpdateMethodMapRange,
+        VBOUpdateMethodPersistent,
     };
     enum VBOUsage {
         VBOUsageStatic,
@@ -57,9 +68,61 @@ public:
         VBOUsageDynamic,
     };
 
+    //
+    // The formats vertex attributes can be stored in in VBOs. The
+    // attribute data is always supplied as floats and converted when it
+    // is uploaded.
+    //
+    enum AttribFormat {
+        AttribFormatFloat,
+        AttribFormatHalfFloat,            // e.g. for positions
+        AttribFormatInt2101010Rev,        // normalized, for vec3 normals
+        AttribFormatUnsignedShortNorm,    // normalized, for [0, 1] texcoords
+    };
+
+    //
+    // The ways the cells of a grid are drawn: as two triangles of their own
+    // 6 vertices each, or from their 4 corners (shared with the neighbouring
+    // cells when there is no spacing between them) as indexed triangles, or
+    // as indexed triangle strips separated by primitive restarts.
+    //
+    enum GridTopology {
+        GridTriangles,
+        GridIndexedTriangles,
+        GridIndexedStrips,
+    };
+
+    // The index that restarts the primitive, whatever the index type
+    static const unsigned int restart_index = 0xffffffff;
+
+    enum OptimizeMode {
+        OptimizeNone,
+        OptimizeVertexCache,
+        OptimizeOverdraw,
+    };
+
+    void set_attrib_formats(const std::vector<AttribFormat> &formats);
+    static bool attrib_format_supported(AttribFormat format);
+    static bool primitive_restart_supported();
+
     void vbo_update_method(VBOUpdateMethod method);
     void vbo_usage(VBOUsage usage);
+    void vbo_buffering(unsigned int copies);
+    void vbo_orphan(bool orphan);
+    void vbo_coalesce(bool coalesce, size_t max_gap = SIZE_MAX);
+    void vbo_vao(bool use_vao);
     void interleave(bool interleave);
+    void primitive(GLenum mode);
+
+    void optimize(OptimizeMode mode, unsigned int position_pos = 0);
+    static OptimizeMode optimize_mode_from_str(const std::string &str);
+
+    void generate_lods(unsigned int levels, float ratio, unsigned int position_pos = 0);
+    unsigned int lod_count() const { return lod_ranges_.empty() ? 1 : lod_ranges_.size(); }
+    size_t lod_triangles(unsigned int level) const;
+    size_t index_count() const { return indices_.size(); }
+    size_t index_size() const;
+    void lod(unsigned int level);
 
     void reset();
     void build_array();
@@ -71,23 +134,59 @@ public:
 
     void render_array();
     void render_vbo();
+    void render_vbo_instanced(unsigned int instances);
 
-    typedef void (*grid_configuration_func)(Mesh &mesh, int x, int y, int n_x, int n_y,
-                                            LibMatrix::vec3 &ul,
-                                            LibMatrix::vec3 &ll,
-                                            LibMatrix::vec3 &ur,
-                                            LibMatrix::vec3 &lr);
+    // The upload calls and bytes of the VBO updates since the last reset
+    uint64_t vbo_update_calls() const { return vbo_update_calls_; }
+    uint64_t vbo_update_bytes() const { return vbo_update_bytes_; }
+    void reset_vbo_update_stats();
+
+    //
+    // Fills the vertices of the cell (x, y) of a grid at dest, 6 of them,
+    // or the 4 corners ul, ll, ur and lr of the cell with indexed grids, e.g. with
+    // set_attrib(pos, v, dest + k * vertex_size()). The cells are filled
+    // in parallel, so it must not change the mesh otherwise.
+    //
+    typedef void (*grid_fill_func)(Mesh &mesh, float *dest, int x, int y, int n_x, int n_y,
+                                   const LibMatrix::vec3 &ul,
+                                   const LibMatrix::vec3 &ll,
+                                   const LibMatrix::vec3 &ur,
+                                   const LibMatrix::vec3 &lr);
 
     void make_grid(int n_x, int n_y, double width, double height,
-                   double spacing, grid_configuration_func conf_func = 0);
+                   double spacing, grid_fill_func fill_func = 0,
+                   GridTopology topology = GridTriangles);
+    static GridTopology grid_topology_from_str(const std::string &str);
 
 private:
     bool check_attrib(unsigned int pos, int dim);
-    std::vector<float> &ensure_vertex();
+    void build_index_array();
+    void expand_indices();
+    void optimize_vertex_cache();
+    void optimize_overdraw(unsigned int position_pos);
+    void optimize_vertex_fetch();
+    void draw_range(size_t &first, size_t &count) const;
+    float *ensure_vertex();
     void update_single_array(const std::vector<std::pair<size_t, size_t> >& ranges,
                              size_t n, size_t nfloats, size_t offset);
     void update_single_vbo(const std::vector<std::pair<size_t, size_t> >& ranges,
-                           size_t n, size_t nfloats);
+                           size_t n);
+    void coalesce_ranges(const std::vector<std::pair<size_t, size_t> >& ranges,
+                         size_t vertex_size,
+                         std::vector<std::pair<size_t, size_t> >& merged) const;
+    void update_persistent_vbos(const std::vector<std::pair<size_t, size_t> >& ranges);
+    void record_update(const std::vector<std::pair<size_t, size_t> >& ranges,
+                       size_t depth,
+                       std::vector<std::pair<size_t, size_t> >& all_ranges);
+    size_t vbo_size(size_t n) const;
+    size_t vbo_vertex_size(size_t n) const;
+    size_t attrib_packed_size(size_t i) const;
+    AttribFormat attrib_format(size_t i) const;
+    void pack_vertices(size_t n, size_t first, size_t last, unsigned char *dest) const;
+    void pack_vertex_data(size_t n, unsigned char *dest) const;
+    bool upload_mapped_vbo(size_t n, GLenum usage);
+    void setup_vbo_attribs();
+    GLenum vbo_buffer_usage() const;
 
     //
     // vertex_format_ is a vector of pairs describing the attribute data.
@@ -103,15 +202,100 @@ private:
     std::vector<int> attrib_locations_;
     int vertex_size_;
 
-    std::vector<std::vector<float> > vertices_;
+    // Empty if all attributes are stored as floats
+    std::vector<AttribFormat> attrib_formats_;
+    // The byte offsets of the attributes in the VBO vertex data
+    std::vector<size_t> attrib_offsets_;
+
+    //
+    // The vertex data is stored contiguously, vertex_size_ floats per
+    // vertex, in the interleaved vertex_format_ layout. Pointers into it
+    // (see ::vertex()) are invalidated when vertices are added or removed.
+    //
+    std::vector<float> vertex_data_;
+
+    //
+    // indices_ is optional. If it is not empty, the mesh is rendered with
+    // glDrawElements() and each consecutive triple of indices into
+    // the vertices forms a triangle. Otherwise each consecutive triple of
+    // vertices forms a triangle.
+    //
+    std::vector<unsigned int> indices_;
+    std::vector<unsigned char> index_array_;
+    // The primitive mode the mesh is drawn with, e.g. GL_PATCHES
+    GLenum primitive_;
+    // Whether indices_ holds restart_index, to be drawn with primitive restart
+    bool primitive_restart_;
+
+    //
+    // With levels of detail, indices_ holds the triangles of every level
+    // one after the other, lod_ranges_ the (first index, index count) of
+    // each level, and only the triangles of level lod_ are drawn.
+    //
+    std::vector<std::pair<size_t, size_t> > lod_ranges_;
+    unsigned int lod_;
+    GLenum index_type_;
+    GLuint index_buffer_;
 
     std::vector<float *> vertex_arrays_;
+    // Whether vertex_arrays_ points into vertex_data_ instead of owning copies
+    bool vertex_arrays_shared_;
     std::vector<GLuint> vbos_;
     std::vector<float *> attrib_data_ptr_;
     int vertex_stride_;
     bool interleave_;
     VBOUpdateMethod vbo_update_method_;
     VBOUsage vbo_usage_;
+    bool vbo_orphan_;
+
+    //
+    // With coalescing, the updated ranges of a VBO separated by at most
+    // vbo_coalesce_gap_ bytes are uploaded as one, in increasing order.
+    //
+    bool vbo_coalesce_;
+    size_t vbo_coalesce_gap_;
+    uint64_t vbo_update_calls_;
+    uint64_t vbo_update_bytes_;
+
+    //
+    // With a vertex array object the attribute state is recorded on the
+    // first draw and only specified again when it changes (vao_dirty_),
+    // e.g. when rendering switches to another copy of the VBOs.
+    //
+    bool use_vao_;
+    GLuint vao_;
+    bool vao_dirty_;
+
+    //
+    // The VBOs can be multi-buffered, in which case every update goes to
+    // the next copy in vbo_copies_ and vbos_ is the copy used for
+    // rendering.
+    //
+    unsigned int vbo_buffering_;
+    std::vector<std::vector<GLuint> > vbo_copies_;
+    unsigned int vbo_copy_;
+
+    //
+    // With VBOUpdateMethodPersistent each VBO holds persistent_segments
+    // copies of the vertex data and stays mapped. Updates go to the next
+    // segment once the GPU is done with it, and rendering uses the most
+    // recently updated segment.
+    //
+    static const unsigned int persistent_segments = 3;
+    std::vector<unsigned char *> persistent_data_;
+    GLsync persistent_fences_[persistent_segments];
+    unsigned int persistent_segment_;
+
+    // The ranges of the last updates, which older VBO copies are missing
+    std::vector<std::vector<std::pair<size_t, size_t> > > update_history_;
+
+    //
+    // Scratch storage for the updates, kept across frames so that updating
+    // the VBOs doesn't allocate once their capacity has grown.
+    //
+    std::vector<std::pair<size_t, size_t> > vbo_ranges_;
+    std::vector<std::pair<size_t, size_t> > coalesced_ranges_;
+    std::vector<unsigned char> packed_vertices_;
 };
 
 #endif
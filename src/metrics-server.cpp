@@ -0,0 +1,344 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "metrics-server.h"
+#include "benchmark-server.h"
+#include "frame-stats.h"
+#include "memory-monitor.h"
+#include "system-monitor.h"
+#include "log.h"
+#include "util.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+/* What the render thread hands to the server thread */
+struct Snapshot
+{
+    Snapshot() : valid(false), fps(0.0), frames(0) {}
+
+    bool valid;
+    std::string scene;
+    /* The FPS and frame times over the last interval */
+    double fps;
+    FrameStats::Summary frame_time;
+    /* The frames presented since the start */
+    uint64_t frames;
+};
+
+/* The interval over which the render thread summarizes its frames, in us */
+const uint64_t publish_interval = 1000000;
+
+bool started = false;
+std::thread server_thread;
+std::atomic<bool> quit(false);
+int server_socket = -1;
+std::string unix_path;
+uint64_t start_time = 0;
+/* Only used by the server thread */
+SystemMonitor system_monitor;
+
+/* Guards the published snapshot, which the render thread only try_lock()s */
+std::mutex snapshot_mutex;
+Snapshot published;
+
+/* Only used by the render thread */
+FrameStats window_stats;
+uint64_t window_start = 0;
+uint64_t last_frame = 0;
+Snapshot pending;
+bool has_pending = false;
+
+void
+add_metric(std::stringstream &ss, const std::string &name,
+           const std::string &type, const std::string &help)
+{
+    ss << "# HELP glmark2_" << name << " " << help << "\n"
+       << "# TYPE glmark2_" << name << " " << type << "\n";
+}
+
+/* Makes a string safe to use as the value of a label */
+std::string
+label_value(const std::string &s)
+{
+    std::string result;
+
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '"' || s[i] == '\\')
+            result += '\\';
+        if (s[i] == '\n')
+            result += "\\n";
+        else
+            result += s[i];
+    }
+
+    return result;
+}
+
+std::string
+format_metrics()
+{
+    Snapshot snapshot;
+    {
+        std::lock_guard<std::mutex> lock(snapshot_mutex);
+        snapshot = published;
+    }
+
+    std::stringstream ss;
+
+    add_metric(ss, "uptime_seconds", "gauge", "Time since glmark2 started serving metrics.");
+    ss << "glmark2_uptime_seconds "
+       << (Util::get_timestamp_us() - start_time) / 1000000.0 << "\n";
+
+    add_metric(ss, "frames_total", "counter", "Frames presented by the benchmarks.");
+    ss << "glmark2_frames_total " << snapshot.frames << "\n";
+
+    if (snapshot.valid) {
+        std::string scene("{scene=\"" + label_value(snapshot.scene) + "\"");
+
+        add_metric(ss, "fps", "gauge", "Frames per second over the last interval.");
+        ss << "glmark2_fps" << scene << "} " << snapshot.fps << "\n";
+
+        add_metric(ss, "frame_time_ms", "gauge",
+                   "Frame time percentiles over the last interval, in milliseconds.");
+        const FrameStats::Summary &t(snapshot.frame_time);
+        ss << "glmark2_frame_time_ms" << scene << ",quantile=\"0.5\"} " << t.p50 << "\n"
+           << "glmark2_frame_time_ms" << scene << ",quantile=\"0.9\"} " << t.p90 << "\n"
+           << "glmark2_frame_time_ms" << scene << ",quantile=\"0.99\"} " << t.p99 << "\n"
+           << "glmark2_frame_time_ms" << scene << ",quantile=\"0.999\"} " << t.p999 << "\n"
+           << "glmark2_frame_time_ms" << scene << ",quantile=\"1\"} " << t.max << "\n";
+    }
+
+    add_metric(ss, "rss_mib", "gauge", "Resident memory of the process, in MiB.");
+    ss << "glmark2_rss_mib " << MemoryMonitor::read_rss_mib(false) << "\n";
+
+    SystemMonitor::Readings sensors(system_monitor.read());
+    bool temperatures = false;
+    bool clocks = false;
+
+    /* The sensor names start with temp_, or end with _mhz for the clocks */
+    for (size_t i = 0; i < sensors.size(); i++) {
+        const std::string &name(sensors[i].first);
+        bool temperature = name.compare(0, 5, "temp_") == 0;
+
+        if (temperature && !temperatures) {
+            add_metric(ss, "temperature_celsius", "gauge", "Temperature sensors.");
+            temperatures = true;
+        }
+        else if (!temperature && !clocks) {
+            add_metric(ss, "clock_mhz", "gauge", "CPU and device clock frequencies.");
+            clocks = true;
+        }
+
+        ss << (temperature ? "glmark2_temperature_celsius" : "glmark2_clock_mhz")
+           << "{sensor=\"" << label_value(name) << "\"} " << sensors[i].second << "\n";
+    }
+
+    return ss.str();
+}
+
+#if !defined(_WIN32)
+
+bool
+write_all(int fd, const std::string &data)
+{
+    size_t written = 0;
+
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.c_str() + written, data.size() - written);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        written += n;
+    }
+
+    return true;
+}
+
+/*
+ * Answers one HTTP request. Whatever the path, the metrics are sent: the
+ * request is only read so that the client doesn't see a reset connection.
+ */
+void
+serve_client(int fd)
+{
+    /* Don't let a client that never sends its request stall the server */
+    struct timeval timeout = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buf[1024];
+
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.find("\n\n") == std::string::npos &&
+           request.size() < 16384)
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        request.append(buf, n);
+    }
+
+    std::string body(format_metrics());
+    std::stringstream response;
+
+    response << "HTTP/1.0 200 OK\r\n"
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n"
+             << "\r\n"
+             << body;
+
+    write_all(fd, response.str());
+}
+
+void
+run_server()
+{
+    while (!quit) {
+        struct pollfd pfd = { server_socket, POLLIN, 0 };
+
+        /* Wake up regularly to see whether to quit */
+        int ret = poll(&pfd, 1, 200);
+        if (ret <= 0)
+            continue;
+
+        int fd = accept(server_socket, 0, 0);
+        if (fd < 0)
+            continue;
+
+        serve_client(fd);
+        close(fd);
+    }
+}
+
+#endif
+
+}
+
+bool
+MetricsServer::start(const std::string &address)
+{
+#if !defined(_WIN32)
+    stop();
+
+    server_socket = BenchmarkServer::listen_socket(address, unix_path);
+    if (server_socket < 0)
+        return false;
+
+    /* A client going away must not kill glmark2 */
+    signal(SIGPIPE, SIG_IGN);
+
+    system_monitor.init();
+    start_time = Util::get_timestamp_us();
+    published = Snapshot();
+    has_pending = false;
+    last_frame = 0;
+    quit = false;
+    server_thread = std::thread(run_server);
+    started = true;
+
+    Log::info("Serving metrics on %s\n", address.c_str());
+
+    return true;
+#else
+    static_cast<void>(address);
+    Log::error("--metrics is not supported on this platform\n");
+    return false;
+#endif
+}
+
+void
+MetricsServer::stop()
+{
+#if !defined(_WIN32)
+    if (!started)
+        return;
+
+    quit = true;
+    server_thread.join();
+
+    close(server_socket);
+    server_socket = -1;
+    if (!unix_path.empty())
+        unlink(unix_path.c_str());
+    unix_path.clear();
+
+    started = false;
+#endif
+}
+
+void
+MetricsServer::scene_started(const std::string &name)
+{
+    if (!started)
+        return;
+
+    pending.scene = name;
+    window_stats.reset();
+    window_start = Util::get_timestamp_us();
+    last_frame = window_start;
+}
+
+void
+MetricsServer::frame_presented()
+{
+    if (!started)
+        return;
+
+    uint64_t now = Util::get_timestamp_us();
+
+    window_stats.add(now - last_frame);
+    last_frame = now;
+    pending.frames++;
+
+    if (now - window_start >= publish_interval) {
+        pending.valid = true;
+        pending.fps = window_stats.count() * 1000000.0 / (now - window_start);
+        pending.frame_time = window_stats.summary();
+        has_pending = true;
+
+        window_stats.reset();
+        window_start = now;
+    }
+
+    /* If the server is reading the last snapshot, try again next frame */
+    if (has_pending && snapshot_mutex.try_lock()) {
+        published = pending;
+        snapshot_mutex.unlock();
+        has_pending = false;
+    }
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_METRICS_SERVER_H_
+#define GLMARK2_METRICS_SERVER_H_
+
+#include <string>
+
+/**
+ * Serves live metrics over HTTP, in the Prometheus text format (--metrics),
+ * so that long runs (e.g. with --run-forever or --soak) can be scraped
+ * while they run.
+ *
+ * The render thread records its frames in a histogram of its own, and hands
+ * a summary of it to the server thread about once per second, only if the
+ * server isn't reading the previous one at that moment: it never waits for
+ * the server. The temperatures and the memory are read by the server thread
+ * when it is scraped.
+ */
+class MetricsServer
+{
+public:
+    /**
+     * Starts serving the metrics from a background thread.
+     *
+     * @param address the path of a Unix socket, or "tcp:[ADDRESS:]PORT"
+     *        for a TCP socket, listening on 127.0.0.1 by default
+     *
+     * @return whether the server could listen on the address
+     */
+    static bool start(const std::string &address);
+
+    /**
+     * Stops the server thread.
+     */
+    static void stop();
+
+    /**
+     * Records that a scene has started. Called from the render thread.
+     */
+    static void scene_started(const std::string &name);
+
+    /**
+     * Records that a frame has been presented. Called from the render
+     * thread.
+     */
+    static void frame_presented();
+};
+
+#endif /* GLMARK2_METRICS_SERVER_H_ */
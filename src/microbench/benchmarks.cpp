@@ -0,0 +1,394 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "microbench.h"
+#include "options.h"
+#include "model.h"
+#include "image-reader.h"
+#include "log.h"
+#include "util.h"
+#include "mat.h"
+#include "stack.h"
+#include "shader-source.h"
+
+#include <memory>
+#include <sstream>
+
+using LibMatrix::mat4;
+using LibMatrix::vec3;
+using LibMatrix::vec4;
+
+/* Keeps the compiler from optimizing out the timed work */
+static volatile float sink;
+
+/*************
+ * libmatrix *
+ *************/
+
+/*
+ * Runs with the SIMD paths of libmatrix either enabled or disabled, to
+ * compare them with the generic code.
+ */
+class MatrixSimdBenchmark : public MicroBenchmark
+{
+public:
+    MatrixSimdBenchmark(const std::string& name, bool simd) :
+        MicroBenchmark(name + (simd ? "" : "-generic"), 1000000),
+        simd_(simd), saved_simd_(true) {}
+
+    bool setup()
+    {
+        saved_simd_ = LibMatrix::Simd::enabled();
+        LibMatrix::Simd::enabled() = simd_;
+        return true;
+    }
+
+    void teardown()
+    {
+        LibMatrix::Simd::enabled() = saved_simd_;
+    }
+
+private:
+    bool simd_;
+    bool saved_simd_;
+};
+
+class MatrixMultiplyBenchmark : public MatrixSimdBenchmark
+{
+public:
+    MatrixMultiplyBenchmark(bool simd) :
+        MatrixSimdBenchmark("libmatrix:mat4-multiply", simd),
+        rotation_(LibMatrix::Mat4::rotate(1.0f, 0.0f, 0.6f, 0.8f)) {}
+
+    bool run()
+    {
+        /* A rotation keeps the repeated products bounded */
+        product_ *= rotation_;
+        sink = product_[0][0];
+        return true;
+    }
+
+private:
+    mat4 rotation_;
+    mat4 product_;
+};
+
+class MatrixTransformBenchmark : public MatrixSimdBenchmark
+{
+public:
+    MatrixTransformBenchmark(bool simd) :
+        MatrixSimdBenchmark("libmatrix:mat4-transform", simd),
+        rotation_(LibMatrix::Mat4::rotate(1.0f, 0.0f, 0.6f, 0.8f)),
+        vector_(1.0f, 0.5f, 0.25f, 1.0f) {}
+
+    bool run()
+    {
+        vector_ = rotation_ * vector_;
+        sink = vector_.x();
+        return true;
+    }
+
+private:
+    mat4 rotation_;
+    vec4 vector_;
+};
+
+class MatrixInverseBenchmark : public MatrixSimdBenchmark
+{
+public:
+    MatrixInverseBenchmark(bool simd) :
+        MatrixSimdBenchmark("libmatrix:mat4-inverse", simd),
+        matrix_(LibMatrix::Mat4::perspective(60.0f, 1.5f, 1.0f, 100.0f) *
+                LibMatrix::Mat4::translate(1.0f, 2.0f, -10.0f)) {}
+
+    bool run()
+    {
+        /* Alternates between the matrix and its inverse */
+        matrix_.inverse();
+        sink = matrix_[0][0];
+        return true;
+    }
+
+private:
+    mat4 matrix_;
+};
+
+class MatrixStackBenchmark : public MicroBenchmark
+{
+public:
+    MatrixStackBenchmark() : MicroBenchmark("libmatrix:stack4", 100000) {}
+
+    bool run()
+    {
+        /* The per-frame transformations of a typical scene */
+        LibMatrix::Stack4 model_view;
+        model_view.translate(0.0f, 0.0f, -5.0f);
+        model_view.rotate(30.0f, 1.0f, 0.0f, 0.0f);
+        model_view.push();
+        model_view.rotate(45.0f, 0.0f, 1.0f, 0.0f);
+        model_view.scale(2.0f, 2.0f, 2.0f);
+
+        mat4 normal_matrix(model_view.getCurrent());
+        normal_matrix.inverse().transpose();
+        vec4 v(normal_matrix * vec4(1.0f, 1.0f, 1.0f, 1.0f));
+        model_view.pop();
+
+        sink = v.x();
+        return true;
+    }
+};
+
+/*****************
+ * Shader source *
+ *****************/
+
+class ShaderSourceBenchmark : public MicroBenchmark
+{
+public:
+    ShaderSourceBenchmark() :
+        MicroBenchmark("shader-source:light-advanced", 200) {}
+
+    bool setup()
+    {
+        vtx_filename_ = Options::data_path + "/shaders/light-advanced.vert";
+        frg_filename_ = Options::data_path + "/shaders/light-advanced.frag";
+        std::unique_ptr<std::istream> vtx(Util::get_resource(vtx_filename_));
+        std::unique_ptr<std::istream> frg(Util::get_resource(frg_filename_));
+        return vtx && vtx->good() && frg && frg->good();
+    }
+
+    bool run()
+    {
+        /* As the scenes build their shaders */
+        ShaderSource vtx_source(vtx_filename_);
+        ShaderSource frg_source(frg_filename_);
+
+        vtx_source.add_const("LightSourcePosition", vec4(20.0f, 20.0f, 10.0f, 1.0f));
+        frg_source.add_const("LightSourcePosition", vec4(20.0f, 20.0f, 10.0f, 1.0f));
+        frg_source.add_const("LightSourceHalfVector", vec3(0.408248f, -0.408248f, 0.816497f));
+        frg_source.add_const("MaterialDiffuse", vec4(1.0f, 1.0f, 1.0f, 1.0f));
+        frg_source.precision(ShaderSource::Precision("medium,medium,medium,medium"));
+
+        size_t size(vtx_source.str().size() + frg_source.str().size());
+        sink = static_cast<float>(size);
+        return size > 0;
+    }
+
+private:
+    std::string vtx_filename_;
+    std::string frg_filename_;
+};
+
+/********
+ * Util *
+ ********/
+
+class UtilSplitBenchmark : public MicroBenchmark
+{
+public:
+    UtilSplitBenchmark(const std::string& name, Util::SplitMode mode) :
+        MicroBenchmark(name, 100), mode_(mode) {}
+
+    bool setup()
+    {
+        /* Roughly a long --benchmark list */
+        std::stringstream ss;
+        for (unsigned int i = 0; i < 2000; i++)
+        {
+            ss << (i == 0 ? "" : ":") << "scene" << i << "=";
+            if (mode_ == Util::SplitModeQuoted)
+                ss << "'value:" << i << "'";
+            else
+                ss << i * 0.5f;
+        }
+        src_ = ss.str();
+        return true;
+    }
+
+    bool run()
+    {
+        std::vector<std::string> elements;
+        Util::split(src_, ':', elements, mode_);
+        sink = static_cast<float>(elements.size());
+        return elements.size() == 2000;
+    }
+
+private:
+    Util::SplitMode mode_;
+    std::string src_;
+};
+
+/*
+ * Parses the vertex lines of an OBJ model, either line by line with
+ * Util::split() and Util::fromString(), or in place with Util::parse_float().
+ */
+class UtilParseBenchmark : public MicroBenchmark
+{
+public:
+    UtilParseBenchmark(const std::string& name, bool in_place) :
+        MicroBenchmark(name, 20), in_place_(in_place) {}
+
+    bool setup()
+    {
+        std::stringstream ss;
+        for (unsigned int i = 0; i < num_lines; i++)
+            ss << "v " << i * 0.001f << " " << -0.5f * i << " " << 1.0f / (i + 1) << "\n";
+        src_ = ss.str();
+        values_.reserve(3 * num_lines);
+        return true;
+    }
+
+    bool run()
+    {
+        values_.clear();
+
+        if (in_place_) {
+            const char *cur(src_.c_str());
+            const char *end(cur + src_.size());
+            while (cur < end) {
+                float value;
+                for (unsigned int i = 0; i < 3; i++) {
+                    cur = Util::parse_float(cur + (i == 0 ? 2 : 0), end, value);
+                    values_.push_back(value);
+                }
+                cur = Util::skip_blanks(cur, end) + 1;
+            }
+        }
+        else {
+            std::stringstream in(src_);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::vector<std::string> elements;
+                Util::split(line.substr(2), ' ', elements, Util::SplitModeFuzzy);
+                for (size_t i = 0; i < elements.size(); i++)
+                    values_.push_back(Util::fromString<float>(elements[i]));
+            }
+        }
+
+        sink = values_.back();
+        return values_.size() == 3 * num_lines;
+    }
+
+private:
+    /* Roughly the vertex section of a typical OBJ model */
+    static const unsigned int num_lines = 100000;
+
+    bool in_place_;
+    std::string src_;
+    std::vector<float> values_;
+};
+
+/**********
+ * Models *
+ **********/
+
+class ModelLoadBenchmark : public MicroBenchmark
+{
+public:
+    ModelLoadBenchmark(const std::string& name, const std::string& model) :
+        MicroBenchmark(name, 5), model_(model) {}
+
+    bool setup()
+    {
+        const ModelMap& models(Model::find_models());
+        if (models.find(model_) == models.end())
+        {
+            Log::error("Model %s not found\n", model_.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool run()
+    {
+        /* As the scenes load their models, without uploading a mesh */
+        Model model;
+        if (!model.load(model_))
+            return false;
+        if (model.needNormals())
+            model.calculate_normals();
+
+        sink = model.maxVec().x();
+        return true;
+    }
+
+private:
+    std::string model_;
+};
+
+/**********
+ * Images *
+ **********/
+
+template<typename Reader>
+class ImageDecodeBenchmark : public MicroBenchmark
+{
+public:
+    ImageDecodeBenchmark(const std::string& name, const std::string& texture,
+                         unsigned int iterations) :
+        MicroBenchmark(name, iterations), texture_(texture) {}
+
+    bool setup()
+    {
+        filename_ = Options::data_path + "/textures/" + texture_;
+        Reader reader(filename_);
+        return !reader.error();
+    }
+
+    bool run()
+    {
+        Reader reader(filename_);
+        if (reader.error())
+            return false;
+
+        std::vector<unsigned char> row(reader.width() * reader.pixelBytes());
+        for (unsigned int i = 0; i < reader.height(); i++)
+        {
+            if (!reader.nextRow(&row[0]))
+                return false;
+        }
+
+        sink = row[0];
+        return true;
+    }
+
+private:
+    std::string texture_;
+    std::string filename_;
+};
+
+void
+microbench_create_all(std::vector<MicroBenchmark*>& benchmarks)
+{
+    benchmarks.push_back(new MatrixMultiplyBenchmark(true));
+    benchmarks.push_back(new MatrixMultiplyBenchmark(false));
+    benchmarks.push_back(new MatrixTransformBenchmark(true));
+    benchmarks.push_back(new MatrixTransformBenchmark(false));
+    benchmarks.push_back(new MatrixInverseBenchmark(true));
+    benchmarks.push_back(new MatrixInverseBenchmark(false));
+    benchmarks.push_back(new MatrixStackBenchmark());
+    benchmarks.push_back(new ShaderSourceBenchmark());
+    benchmarks.push_back(new UtilSplitBenchmark("util:split-fuzzy", Util::SplitModeFuzzy));
+    benchmarks.push_back(new UtilSplitBenchmark("util:split-quoted", Util::SplitModeQuoted));
+    benchmarks.push_back(new UtilParseBenchmark("util:parse-split", false));
+    benchmarks.push_back(new UtilParseBenchmark("util:parse-in-place", true));
+    benchmarks.push_back(new ModelLoadBenchmark("model:load-3ds", "horse"));
+    benchmarks.push_back(new ModelLoadBenchmark("model:load-obj", "bunny"));
+    benchmarks.push_back(new ImageDecodeBenchmark<PNGReader>("image:png-decode", "nasa1.png", 10));
+    benchmarks.push_back(new ImageDecodeBenchmark<JPEGReader>("image:jpeg-decode", "terrain-grasslight-512.jpg", 20));
+}
@@ -0,0 +1,240 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "microbench.h"
+#include "options.h"
+#include "log.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <getopt.h>
+
+/*
+ * Runs microbenchmarks of the CPU-side code that the scenes rely on:
+ * libmatrix, shader preprocessing, model loading and image decoding.
+ * A previous run saved with --output can be compared with --compare, so that
+ * regressions are caught before they show up as slow scene setup.
+ */
+
+static struct option long_options[] = {
+    {"data-path", 1, 0, 0},
+    {"repeat", 1, 0, 0},
+    {"output", 1, 0, 0},
+    {"compare", 1, 0, 0},
+    {"threshold", 1, 0, 0},
+    {"list", 0, 0, 0},
+    {"help", 0, 0, 0},
+    {0, 0, 0, 0}
+};
+
+static void
+print_help()
+{
+    printf("Usage: glmark2-microbench [OPTION]... [BENCHMARK]...\n"
+           "Time the CPU-side code of glmark2. Only the benchmarks whose names\n"
+           "start with one of the BENCHMARK arguments are run (default: all).\n"
+           "\n"
+           "Options:\n"
+           "      --data-path PATH   Path to the glmark2 models, shaders and textures\n"
+           "      --repeat N         Time each benchmark N times and keep the fastest\n"
+           "                         run (default: 5)\n"
+           "      --output FILE      Save the timings to FILE\n"
+           "      --compare FILE     Compare the timings with those saved in FILE and\n"
+           "                         fail if a benchmark is slower by more than the\n"
+           "                         threshold\n"
+           "      --threshold PCT    The slowdown --compare allows, in percent\n"
+           "                         (default: 10)\n"
+           "      --list             List the benchmarks\n"
+           "      --help             Display help\n");
+}
+
+static bool
+selected(const std::string& name, const std::vector<std::string>& filters)
+{
+    if (filters.empty())
+        return true;
+
+    for (std::vector<std::string>::const_iterator iter = filters.begin();
+         iter != filters.end();
+         iter++)
+    {
+        if (name.compare(0, iter->size(), *iter) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Reads the timings saved with --output, one "name time" line per benchmark.
+ */
+static bool
+load_timings(const std::string& filename, std::map<std::string, double>& timings)
+{
+    std::ifstream in(filename.c_str());
+    if (!in) {
+        Log::error("Cannot open %s\n", filename.c_str());
+        return false;
+    }
+
+    std::string name;
+    double time;
+    while (in >> name >> time)
+        timings[name] = time;
+
+    return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+    unsigned int repeat(5);
+    std::string output;
+    std::string compare;
+    double threshold(10.0);
+    bool list(false);
+
+    Log::init("glmark2-microbench");
+
+    while (1) {
+        int option_index = -1;
+        int c = getopt_long(argc, argv, "", long_options, &option_index);
+        if (c == -1)
+            break;
+        if (c == '?' || option_index == -1)
+            return 1;
+
+        const char *optname = long_options[option_index].name;
+
+        if (!strcmp(optname, "data-path"))
+            Options::data_path = std::string(optarg);
+        else if (!strcmp(optname, "repeat"))
+            repeat = Util::fromString<unsigned int>(optarg);
+        else if (!strcmp(optname, "output"))
+            output = optarg;
+        else if (!strcmp(optname, "compare"))
+            compare = optarg;
+        else if (!strcmp(optname, "threshold"))
+            threshold = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "list"))
+            list = true;
+        else if (!strcmp(optname, "help")) {
+            print_help();
+            return 0;
+        }
+    }
+
+    if (repeat == 0) {
+        Log::error("--repeat must be at least 1\n");
+        return 1;
+    }
+
+    std::vector<std::string> filters(argv + optind, argv + argc);
+    std::vector<MicroBenchmark*> benchmarks;
+    microbench_create_all(benchmarks);
+
+    std::map<std::string, double> baseline;
+    if (!compare.empty() && !load_timings(compare, baseline))
+        return 1;
+
+    std::ofstream out;
+    if (!output.empty()) {
+        out.open(output.c_str());
+        if (!out) {
+            Log::error("Cannot open %s\n", output.c_str());
+            return 1;
+        }
+    }
+
+    int status = 0;
+
+    for (std::vector<MicroBenchmark*>::const_iterator iter = benchmarks.begin();
+         iter != benchmarks.end();
+         iter++)
+    {
+        MicroBenchmark& bench(**iter);
+
+        if (!selected(bench.name(), filters))
+            continue;
+
+        if (list) {
+            printf("%s\n", bench.name().c_str());
+            continue;
+        }
+
+        if (!bench.setup()) {
+            Log::error("%s: setup failed\n", bench.name().c_str());
+            status = 1;
+            continue;
+        }
+
+        /* The fastest of the runs is the least disturbed by the system */
+        std::vector<double> times;
+        bool ok = true;
+
+        for (unsigned int r = 0; r < repeat && ok; r++) {
+            uint64_t start = Util::get_timestamp_us();
+            for (unsigned int i = 0; i < bench.iterations() && ok; i++)
+                ok = bench.run();
+            uint64_t elapsed = Util::get_timestamp_us() - start;
+            times.push_back(static_cast<double>(elapsed) / bench.iterations());
+        }
+
+        bench.teardown();
+
+        if (!ok) {
+            Log::error("%s: run failed\n", bench.name().c_str());
+            status = 1;
+            continue;
+        }
+
+        std::sort(times.begin(), times.end());
+        double best = times.front();
+        double median = times[times.size() / 2];
+
+        printf("%-32s %12.3f us %12.3f us (median)", bench.name().c_str(),
+               best, median);
+
+        std::map<std::string, double>::const_iterator base = baseline.find(bench.name());
+        if (base != baseline.end() && base->second > 0.0) {
+            double change = 100.0 * (best - base->second) / base->second;
+            printf(" %+7.1f%%", change);
+            if (change > threshold) {
+                printf(" REGRESSION");
+                status = 1;
+            }
+        }
+        printf("\n");
+
+        if (out.is_open())
+            out << bench.name() << " " << best << std::endl;
+    }
+
+    for (std::vector<MicroBenchmark*>::iterator iter = benchmarks.begin();
+         iter != benchmarks.end();
+         iter++)
+    {
+        delete *iter;
+    }
+
+    return status;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_MICROBENCH_H_
+#define GLMARK2_MICROBENCH_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * A benchmark of CPU-side code, timed over a fixed number of iterations.
+ *
+ * The inputs come from the data directory so that the timings are
+ * repeatable across runs and machines.
+ */
+class MicroBenchmark
+{
+public:
+    MicroBenchmark(const std::string& name, unsigned int iterations) :
+        name_(name), iterations_(iterations) {}
+    virtual ~MicroBenchmark() {}
+
+    const std::string& name() const { return name_; }
+    unsigned int iterations() const { return iterations_; }
+
+    /**
+     * Prepares the inputs of the benchmark, which isn't timed.
+     *
+     * @return whether the benchmark can run
+     */
+    virtual bool setup() { return true; }
+
+    /**
+     * Runs one iteration of the benchmark.
+     *
+     * @return whether the iteration succeeded
+     */
+    virtual bool run() = 0;
+
+    /**
+     * Undoes what setup() changed outside of the benchmark, after the runs.
+     */
+    virtual void teardown() {}
+
+private:
+    std::string name_;
+    unsigned int iterations_;
+};
+
+/**
+ * Creates all the microbenchmarks, in the order they run.
+ */
+void microbench_create_all(std::vector<MicroBenchmark*>& benchmarks);
+
+#endif /* GLMARK2_MICROBENCH_H_ */
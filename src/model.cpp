@@ -27,12 +27,24 @@
 #include "log.h"
 #include "options.h"
 #include "util.h"
+#include "trace.h"
 #include "float.h"
 #include "math.h"
 #include <algorithm>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
+#include <iterator>
 #include <memory>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 using std::string;
 using std::vector;
@@ -111,6 +123,31 @@ Model::compute_bounding_box(const Object& object)
     minVec_ = vec3(minX, minY, minZ);
 }
 
+/**
+ * Replaces the last vertex of a mesh with an index.
+ *
+ * If an identical vertex has already been added to the mesh, the last
+ * vertex is dropped and the index of the existing vertex is used instead.
+ *
+ * @param mesh the mesh to update
+ * @param vertex_index_map the vertices already in the mesh and their indices
+ */
+static void
+index_last_vertex(Mesh &mesh, std::map<std::vector<float>, unsigned int> &vertex_index_map)
+{
+    size_t last = mesh.vertex_count() - 1;
+    const float *vertex = mesh.vertex(last);
+
+    std::pair<std::map<std::vector<float>, unsigned int>::iterator, bool> res =
+        vertex_index_map.insert(std::make_pair(
+            std::vector<float>(vertex, vertex + mesh.vertex_size()), last));
+
+    if (!res.second)
+        mesh.pop_vertex();
+
+    mesh.add_index(res.first->second);
+}
+
 /**
  * Appends the vertices of a Model::Object to a Mesh.
  *
@@ -119,11 +156,14 @@ Model::compute_bounding_box(const Object& object)
  * @param p_pos the attribute position to use for the 'position' attribute
  * @param n_pos the attribute position to use for the 'normal' attribute
  * @param t_pos the attribute position to use for the 'texcoord' attribute
+ * @param vertex_index_map if not NULL, identical vertices are merged and
+ *                         the mesh is built with indices
  */
 void
 Model::append_object_to_mesh(const Object &object, Mesh &mesh,
                              int p_pos, int n_pos, int t_pos,
-                             int nt_pos, int nb_pos)
+                             int nt_pos, int nb_pos,
+                             VertexIndexMap *vertex_index_map)
 {
     for (vector<Face>::const_iterator faceIt = object.faces.begin();
          faceIt != object.faces.end();
@@ -160,6 +200,8 @@ Model::append_object_to_mesh(const Object &object, Mesh &mesh,
             mesh.set_attrib(nt_pos, v1.nt);
         if (nb_pos >= 0)
             mesh.set_attrib(nb_pos, v1.nb);
+        if (vertex_index_map)
+            index_last_vertex(mesh, *vertex_index_map);
 
         mesh.next_vertex();
         if (p_pos >= 0)
@@ -172,6 +214,8 @@ Model::append_object_to_mesh(const Object &object, Mesh &mesh,
             mesh.set_attrib(nt_pos, v2.nt);
         if (nb_pos >= 0)
             mesh.set_attrib(nb_pos, v2.nb);
+        if (vertex_index_map)
+            index_last_vertex(mesh, *vertex_index_map);
 
         mesh.next_vertex();
         if (p_pos >= 0)
@@ -184,6 +228,8 @@ Model::append_object_to_mesh(const Object &object, Mesh &mesh,
             mesh.set_attrib(nt_pos, v3.nt);
         if (nb_pos >= 0)
             mesh.set_attrib(nb_pos, v3.nb);
+        if (vertex_index_map)
+            index_last_vertex(mesh, *vertex_index_map);
     }
 }
 
@@ -213,11 +259,15 @@ Model::convert_to_mesh(Mesh &mesh)
  *
  * @param mesh the mesh to populate
  * @param attribs the attribute bindings to use
+ * @param use_index whether to merge identical vertices and build an
+ *                  indexed mesh
  */
 void
 Model::convert_to_mesh(Mesh &mesh,
-                       const std::vector<std::pair<AttribType, int> > &attribs)
+                       const std::vector<std::pair<AttribType, int> > &attribs,
+                       bool use_index)
 {
+    VertexIndexMap vertex_index_map;
     std::vector<int> format;
     int p_pos = -1;
     int n_pos = -1;
@@ -246,11 +296,32 @@ Model::convert_to_mesh(Mesh &mesh,
 
     mesh.set_vertex_format(format);
 
+    /* Allocate the vertex data (or the indices) at once, as they are large */
+    size_t nfaces = 0;
+    for (std::vector<Object>::const_iterator iter = objects_.begin();
+         iter != objects_.end();
+         iter++)
+    {
+        nfaces += iter->faces.size();
+    }
+
+    if (use_index)
+        mesh.indices().reserve(3 * nfaces);
+    else
+        mesh.reserve_vertices(3 * nfaces);
+
     for (std::vector<Object>::const_iterator iter = objects_.begin();
          iter != objects_.end();
          iter++)
     {
-        append_object_to_mesh(*iter, mesh, p_pos, n_pos, t_pos, nt_pos, nb_pos);
+        append_object_to_mesh(*iter, mesh, p_pos, n_pos, t_pos, nt_pos, nb_pos,
+                              use_index ? &vertex_index_map : 0);
+    }
+
+    if (use_index) {
+        Log::debug("Indexed mesh: %u vertices, %u indices\n",
+                   static_cast<unsigned int>(mesh.vertex_count()),
+                   static_cast<unsigned int>(mesh.indices().size()));
     }
 }
 
@@ -260,6 +331,25 @@ Model::calculate_texcoords()
     if (gotTexcoords_)
         return;
 
+    // Normals calculated for the model cache depend on the texcoords (for the
+    // tangents), so they have to be calculated again.
+    if (cachedNormals_) {
+        for (std::vector<Object>::iterator iter = objects_.begin();
+             iter != objects_.end();
+             iter++)
+        {
+            for (vector<Vertex>::iterator vertexIt = iter->vertices.begin();
+                 vertexIt != iter->vertices.end();
+                 vertexIt++)
+            {
+                vertexIt->n = vec3();
+                vertexIt->nt = vec3();
+                vertexIt->nb = vec3();
+            }
+        }
+        cachedNormals_ = false;
+    }
+
     // Since the model didn't come with texcoords, and we don't actually know
     // if it came with normals, either, we'll use positional spherical mapping
     // to generate texcoords for the model.  See:
@@ -287,8 +377,131 @@ Model::calculate_texcoords()
     gotTexcoords_ = true;
 }
 
+/**
+ * Calculates the normal, tangent and bitangent of a face.
+ *
+ * The vectors are normalized, so that each face contributes equally to the
+ * vertex vectors, regardless of its size.
+ */
+void
+Model::calculate_face_normals(const Vertex &a, const Vertex &b, const Vertex &c,
+                              vec3 &n, vec3 &nt, vec3 &nb)
+{
+    /* Calculate normal */
+    n = LibMatrix::vec3::cross(b.v - a.v, c.v - a.v);
+    n.normalize();
+
+    LibMatrix::vec3 q1(b.v - a.v);
+    LibMatrix::vec3 q2(c.v - a.v);
+    LibMatrix::vec2 u1(b.t - a.t);
+    LibMatrix::vec2 u2(c.t - a.t);
+    float det = (u1.x() * u2.y() - u2.x() * u1.y());
+
+    /* Calculate tangent */
+    nt.x(det * (u2.y() * q1.x() - u1.y() * q2.x()));
+    nt.y(det * (u2.y() * q1.y() - u1.y() * q2.y()));
+    nt.z(det * (u2.y() * q1.z() - u1.y() * q2.z()));
+    nt.normalize();
+
+    /* Calculate bitangent */
+    nb.x(det * (u1.x() * q2.x() - u2.x() * q1.x()));
+    nb.y(det * (u1.x() * q2.y() - u2.x() * q1.y()));
+    nb.z(det * (u1.x() * q2.z() - u2.x() * q1.z()));
+    nb.normalize();
+}
+
+/**
+ * Orthogonalizes and normalizes the accumulated vectors of a vertex.
+ */
+void
+Model::finish_vertex_normals(Vertex &v)
+{
+    v.nt = (v.nt - v.n * LibMatrix::vec3::dot(v.nt, v.n));
+    v.n.normalize();
+    v.nt.normalize();
+    v.nb.normalize();
+}
+
+/**
+ * Calculates the normal vectors of an object's vertices using multiple threads.
+ *
+ * Each thread accumulates the face vectors of a chunk of the faces into its
+ * own buffer, so no synchronization is needed. The buffers are then reduced
+ * into the vertices, again in parallel, with each thread handling a range of
+ * vertices.
+ *
+ * @param object the object to process
+ * @param nthreads the number of threads to use
+ */
+void
+Model::calculate_normals_parallel(Object &object, unsigned int nthreads)
+{
+    struct NormalSums {
+        vec3 n;
+        vec3 nt;
+        vec3 nb;
+    };
+
+    const size_t nfaces = object.faces.size();
+    const size_t nvertices = object.vertices.size();
+    vector<vector<NormalSums> > sums(nthreads);
+    vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        threads.push_back(std::thread([&object, &sums, i, nthreads, nfaces, nvertices]() {
+            vector<NormalSums> &dst(sums[i]);
+            dst.resize(nvertices);
+
+            size_t start = nfaces * i / nthreads;
+            size_t end = nfaces * (i + 1) / nthreads;
+            vec3 n, nt, nb;
+
+            for (size_t f = start; f < end; f++) {
+                const Face &face = object.faces[f];
+                unsigned int ia(face.v.x());
+                unsigned int ib(face.v.y());
+                unsigned int ic(face.v.z());
+
+                calculate_face_normals(object.vertices[ia], object.vertices[ib],
+                                       object.vertices[ic], n, nt, nb);
+                dst[ia].n += n; dst[ia].nt += nt; dst[ia].nb += nb;
+                dst[ib].n += n; dst[ib].nt += nt; dst[ib].nb += nb;
+                dst[ic].n += n; dst[ic].nt += nt; dst[ic].nb += nb;
+            }
+        }));
+    }
+
+    for (vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); iter++)
+        iter->join();
+    threads.clear();
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        threads.push_back(std::thread([&object, &sums, i, nthreads, nvertices]() {
+            size_t start = nvertices * i / nthreads;
+            size_t end = nvertices * (i + 1) / nthreads;
+
+            for (size_t v = start; v < end; v++) {
+                Vertex &vertex = object.vertices[v];
+
+                for (unsigned int c = 0; c < nthreads; c++) {
+                    vertex.n += sums[c][v].n;
+                    vertex.nt += sums[c][v].nt;
+                    vertex.nb += sums[c][v].nb;
+                }
+
+                finish_vertex_normals(vertex);
+            }
+        }));
+    }
+
+    for (vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); iter++)
+        iter->join();
+}
+
 /**
  * Calculates the normal vectors of the model vertices.
+ *
+ * Objects with many faces are processed using multiple threads.
  */
 void
 Model::calculate_normals()
@@ -296,7 +509,23 @@ Model::calculate_normals()
     if (gotNormals_)
         return;
 
+    if (cachedNormals_) {
+        gotNormals_ = true;
+        return;
+    }
+
+    /*
+     * Below this many faces per thread, the cost of starting threads and
+     * reducing the per-thread buffers outweighs the gain.
+     */
+    static const size_t min_faces_per_thread = 65536;
+    unsigned int max_threads = std::thread::hardware_concurrency();
+    if (max_threads > 8)
+        max_threads = 8;
+
     LibMatrix::vec3 n;
+    LibMatrix::vec3 nt;
+    LibMatrix::vec3 nb;
 
     for (std::vector<Object>::iterator iter = objects_.begin();
          iter != objects_.end();
@@ -304,6 +533,16 @@ Model::calculate_normals()
     {
         Object &object = *iter;
 
+        size_t nthreads = std::min<size_t>(max_threads,
+                                           object.faces.size() / min_faces_per_thread);
+        if (nthreads > 1) {
+            Log::debug("Calculating normals for %u faces using %u threads\n",
+                       static_cast<unsigned int>(object.faces.size()),
+                       static_cast<unsigned int>(nthreads));
+            calculate_normals_parallel(object, nthreads);
+            continue;
+        }
+
         for (vector<Face>::const_iterator f_iter = object.faces.begin();
              f_iter != object.faces.end();
              f_iter++)
@@ -313,35 +552,13 @@ Model::calculate_normals()
             Vertex &b = object.vertices[face.v.y()];
             Vertex &c = object.vertices[face.v.z()];
 
-            /* Calculate normal */
-            n = LibMatrix::vec3::cross(b.v - a.v, c.v - a.v);
-            n.normalize();
+            calculate_face_normals(a, b, c, n, nt, nb);
             a.n += n;
             b.n += n;
             c.n += n;
-
-            LibMatrix::vec3 q1(b.v - a.v);
-            LibMatrix::vec3 q2(c.v - a.v);
-            LibMatrix::vec2 u1(b.t - a.t);
-            LibMatrix::vec2 u2(c.t - a.t);
-            float det = (u1.x() * u2.y() - u2.x() * u1.y());
-
-            /* Calculate tangent */
-            LibMatrix::vec3 nt;
-            nt.x(det * (u2.y() * q1.x() - u1.y() * q2.x()));
-            nt.y(det * (u2.y() * q1.y() - u1.y() * q2.y()));
-            nt.z(det * (u2.y() * q1.z() - u1.y() * q2.z()));
-            nt.normalize();
             a.nt += nt;
             b.nt += nt;
             c.nt += nt;
-
-            /* Calculate bitangent */
-            LibMatrix::vec3 nb;
-            nb.x(det * (u1.x() * q2.x() - u2.x() * q1.x()));
-            nb.y(det * (u1.x() * q2.y() - u2.x() * q1.y()));
-            nb.z(det * (u1.x() * q2.z() - u2.x() * q1.z()));
-            nb.normalize();
             a.nb += nb;
             b.nb += nb;
             c.nb += nb;
@@ -351,12 +568,7 @@ Model::calculate_normals()
              v_iter != object.vertices.end();
              v_iter++)
         {
-            Vertex &v = *v_iter;
-            /* Orthogonalize */
-            v.nt = (v.nt - v.n * LibMatrix::vec3::dot(v.nt, v.n));
-            v.n.normalize();
-            v.nt.normalize();
-            v.nb.normalize();
+            finish_vertex_normals(*v_iter);
         }
     }
 
@@ -553,82 +765,104 @@ const unsigned int Model::Face::OBJ_FACE_N = 0x4;
 /**
  * Parse 2-element vertex attribute from an OBJ file.
  *
- * @param source the source line to parse
+ * @param cur the start of the attribute data in the line
+ * @param end the end of the file buffer
  * @param v the vec2 to populate
+ *
+ * @return the position after the parsed data
  */
-void
-Model::obj_get_attrib(const string& source, vec2& v)
+const char *
+Model::obj_get_attrib(const char *cur, const char *end, vec2& v)
 {
-    // Our attribs are whitespace separated, so use a fuzzy split.
-    vector<string> elements;
-    Util::split(source, ' ', elements, Util::SplitModeFuzzy);
+    float x, y;
 
     // Find the first value...
-    float x = Util::fromString<float>(elements[0]);
+    cur = Util::parse_float(cur, end, x);
     // And the second value (there might be a third, but we don't care)...
-    float y = Util::fromString<float>(elements[1]);
+    cur = Util::parse_float(cur, end, y);
     v.x(x);
     v.y(y);
+
+    return cur;
 }
 
 /**
  * Parse 3-element vertex attribute from an OBJ file.
  *
- * @param source the source line to parse
+ * @param cur the start of the attribute data in the line
+ * @param end the end of the file buffer
  * @param v the vec3 to populate
+ *
+ * @return the position after the parsed data
  */
-void
-Model::obj_get_attrib(const string& source, vec3& v)
+const char *
+Model::obj_get_attrib(const char *cur, const char *end, vec3& v)
 {
-    // Our attribs are whitespace separated, so use a fuzzy split.
-    vector<string> elements;
-    Util::split(source, ' ', elements, Util::SplitModeFuzzy);
+    float x, y, z;
 
     // Find the first value...
-    float x = Util::fromString<float>(elements[0]);
+    cur = Util::parse_float(cur, end, x);
     // Then the second value...
-    float y = Util::fromString<float>(elements[1]);
+    cur = Util::parse_float(cur, end, y);
     // And the third value (there might be a fourth, but we don't care)...
-    float z = Util::fromString<float>(elements[2]);
+    cur = Util::parse_float(cur, end, z);
     v.x(x);
     v.y(y);
     v.z(z);
-}
 
+    return cur;
+}
 
-void
-Model::obj_face_get_index(const string& tuple, unsigned int& which,
+/**
+ * Parse a single v[/[t][/n]] tuple of a face description from an OBJ file.
+ *
+ * @param cur the start of the tuple, or of the blanks before it
+ * @param end the end of the file buffer
+ *
+ * @return the position after the parsed tuple
+ */
+const char *
+Model::obj_face_get_index(const char *cur, const char *end, unsigned int& which,
     unsigned int& v, unsigned int& t, unsigned int& n)
 {
-    // We can use a normal split here as syntax requires no spaces around
-    // the '/' delimiter for a face description.
-    vector<string> elements;
-    Util::split(tuple, '/', elements, Util::SplitModeNormal);
+    cur = Util::skip_blanks(cur, end);
 
-    if (elements.empty())
+    if (cur == end || *cur == '\n')
     {
         which = 0;
-        return;
+        return cur;
     }
 
+    // The syntax requires no spaces around the '/' delimiter for a face
+    // description.
     which = Face::OBJ_FACE_V;
-    v = Util::fromString<unsigned int>(elements[0]);
+    cur = Util::parse_uint(cur, end, v);
 
-    unsigned int num_elements = elements.size();
-
-    if (num_elements > 1 && !elements[1].empty())
+    if (cur < end && *cur == '/')
     {
-        which |= Face::OBJ_FACE_T;
-        t = Util::fromString<unsigned int>(elements[1]);
+        cur++;
+        if (cur < end && *cur >= '0' && *cur <= '9')
+        {
+            which |= Face::OBJ_FACE_T;
+            cur = Util::parse_uint(cur, end, t);
+        }
     }
 
-    if (num_elements > 2 && !elements[2].empty())
+    if (cur < end && *cur == '/')
     {
-        which |= Face::OBJ_FACE_N;
-        n = Util::fromString<unsigned int>(elements[2]);
+        cur++;
+        if (cur < end && *cur >= '0' && *cur <= '9')
+        {
+            which |= Face::OBJ_FACE_N;
+            cur = Util::parse_uint(cur, end, n);
+        }
     }
 
-    return;
+    // Skip anything we don't understand in this tuple
+    while (cur < end && *cur != ' ' && *cur != '\t' && *cur != '\r' && *cur != '\n')
+        cur++;
+
+    return cur;
 }
 
 /**
@@ -636,34 +870,33 @@ Model::obj_face_get_index(const string& tuple, unsigned int& which,
  * Faces always specify position, but optionally can also contain separate
  * indices for texcoords and normals.
  *
- * @param source the source line to parse
- * @param v the uvec3 to populate
+ * @param cur the start of the face data in the line
+ * @param end the end of the file buffer
+ * @param f the face to populate
+ *
+ * @return the position after the parsed data
  */
-void
-Model::obj_get_face(const string& source, Face& f)
+const char *
+Model::obj_get_face(const char *cur, const char *end, Face& f)
 {
-    // Our indices are whitespace separated, so use a fuzzy split.
-    vector<string> elements;
-    Util::split(source, ' ', elements, Util::SplitModeFuzzy);
-
     // Find the first value...
     unsigned int which(0);
     unsigned int vx(0);
     unsigned int tx(0);
     unsigned int nx(0);
-    obj_face_get_index(elements[0], which, vx, tx, nx);
+    cur = obj_face_get_index(cur, end, which, vx, tx, nx);
 
     // Then the second value...
     unsigned int vy(0);
     unsigned int ty(0);
     unsigned int ny(0);
-    obj_face_get_index(elements[1], which, vy, ty, ny);
+    cur = obj_face_get_index(cur, end, which, vy, ty, ny);
 
     // And the third value (there might be a fourth, but we don't care)...
     unsigned int vz(0);
     unsigned int tz(0);
     unsigned int nz(0);
-    obj_face_get_index(elements[2], which, vz, tz, nz);
+    cur = obj_face_get_index(cur, end, which, vz, tz, nz);
 
     // OBJ models start absoluted indices at '1', so subtract to re-base to
     // '0'.  We do not handle relative indexing (negative indices).  
@@ -683,11 +916,56 @@ Model::obj_get_face(const string& source, Face& f)
         f.n.y(ny - 1);
         f.n.z(nz - 1);
     }
+
+    return cur;
+}
+
+/**
+ * Gets the type of an OBJ line (e.g. "v", "vn", "f").
+ *
+ * @param cur the start of the line
+ * @param end the end of the file buffer
+ * @param type_end set to the end of the type
+ *
+ * @return the type as a small integer: the first character, plus the second
+ *         character shifted left by 8 bits (if any), or 0 for types longer
+ *         than two characters
+ */
+static unsigned int
+obj_line_type(const char *cur, const char *end, const char *&type_end)
+{
+    unsigned int type(0);
+    unsigned int len(0);
+
+    type_end = cur;
+    while (type_end < end && *type_end != ' ' && *type_end != '\t' &&
+           *type_end != '\r' && *type_end != '\n')
+    {
+        if (len < 2)
+            type |= static_cast<unsigned char>(*type_end) << (8 * len);
+        len++;
+        type_end++;
+    }
+
+    // Types must be followed by whitespace to have any data
+    if (len > 2 || type_end == end || *type_end == '\n')
+        return 0;
+
+    return type;
 }
 
+static const unsigned int obj_type_object('o');
+static const unsigned int obj_type_vertex('v');
+static const unsigned int obj_type_normal('v' | ('n' << 8));
+static const unsigned int obj_type_texcoord('v' | ('t' << 8));
+static const unsigned int obj_type_face('f');
+
 /**
  * Load a model from an OBJ file.
  *
+ * The whole file is mapped into memory and scanned in place, so that parsing
+ * doesn't copy the file or allocate memory for each line.
+ *
  * @param filename the name of the file
  *
  * @return whether loading succeeded
@@ -697,83 +975,100 @@ Model::load_obj(const std::string &filename)
 {
     Log::debug("Loading model from obj file '%s'\n", filename.c_str());
 
-    const std::unique_ptr<std::istream> input_file_ptr(Util::get_resource(filename));
-    std::istream& inputFile(*input_file_ptr);
-    if (!inputFile)
+    const std::unique_ptr<Util::MappedResource> resource(Util::map_resource(filename));
+    if (!resource->valid())
     {
         Log::error("Failed to open '%s'\n", filename.c_str());
         return false;
     }
 
-    vector<string> sourceVec;
-    string curLine;
-    while (getline(inputFile, curLine))
+    const char *start(resource->data());
+    const char *end(start + resource->size());
+
+    // Count the elements first, so that we can reserve enough storage.
+    size_t num_positions(0);
+    size_t num_normals(0);
+    size_t num_texcoords(0);
+    size_t num_faces(0);
+    for (const char *cur = start; cur < end; cur++)
     {
-        sourceVec.push_back(curLine);
+        const char *type_end;
+        unsigned int type = obj_line_type(cur, end, type_end);
+
+        if (type == obj_type_vertex)
+            num_positions++;
+        else if (type == obj_type_normal)
+            num_normals++;
+        else if (type == obj_type_texcoord)
+            num_texcoords++;
+        else if (type == obj_type_face)
+            num_faces++;
+
+        cur = static_cast<const char *>(memchr(type_end, '\n', end - type_end));
+        if (!cur)
+            break;
     }
 
     // Give ourselves an object to populate.
     objects_.push_back(Object(string()));
     Object& object(objects_.back());
 
-    static const string object_definition("o");
-    static const string vertex_definition("v");
-    static const string normal_definition("vn");
-    static const string texcoord_definition("vt");
-    static const string face_definition("f");
     vector<vec3> positions;
     vector<vec3> normals;
     vector<vec2> texcoords;
-    for (vector<string>::const_iterator lineIt = sourceVec.begin();
-         lineIt != sourceVec.end();
-         lineIt++)
+    positions.reserve(num_positions);
+    normals.reserve(num_normals);
+    texcoords.reserve(num_texcoords);
+    object.faces.reserve(num_faces);
+
+    for (const char *cur = start; cur < end; cur++)
     {
-        const string& curSrc = *lineIt;
         // Is it a vertex attribute, a face description, comment or other?
         // We only care about the first two, we ignore comments, group names,
         // smoothing groups, etc.
-        string::size_type startPos(0);
-        string::size_type spacePos = curSrc.find(" ", startPos);
-        string::size_type num_chars(string::npos);
-        string definition;
-        if (spacePos != string::npos)
-        {
-            // Could be arbitrary whitespace between description type and
-            // the data
-            string::size_type defPos = curSrc.find_first_not_of(' ', spacePos);
-            definition = string(curSrc, defPos);
-            num_chars = spacePos - startPos;
-        }
-        string definitionType(curSrc, startPos, num_chars);
+        const char *data;
+        unsigned int type = obj_line_type(cur, end, data);
 
-        if (definitionType == vertex_definition)
+        if (type == obj_type_vertex)
         {
             vec3 p;
-            obj_get_attrib(definition, p);
+            data = obj_get_attrib(data, end, p);
             positions.push_back(p);
         }
-        else if (definitionType == normal_definition)
+        else if (type == obj_type_normal)
         {
             vec3 n;
-            obj_get_attrib(definition, n);
+            data = obj_get_attrib(data, end, n);
             normals.push_back(n);
         }
-        else if (definitionType == texcoord_definition)
+        else if (type == obj_type_texcoord)
         {
             vec2 t;
-            obj_get_attrib(definition, t);
+            data = obj_get_attrib(data, end, t);
             texcoords.push_back(t);
         }
-        else if (definitionType == face_definition)
+        else if (type == obj_type_face)
         {
             Face f;
-            obj_get_face(definition, f);
+            data = obj_get_face(data, end, f);
             object.faces.push_back(f);
         }
-        else if (definitionType == object_definition)
+        else if (type == obj_type_object)
         {
-            object.name = definition;
+            const char *name_start = Util::skip_blanks(data, end);
+            const char *name_end = static_cast<const char *>(
+                memchr(name_start, '\n', end - name_start));
+            if (!name_end)
+                name_end = end;
+            while (name_end > name_start && (name_end[-1] == '\r' || name_end[-1] == ' '))
+                name_end--;
+            object.name.assign(name_start, name_end);
         }
+
+        // Move on to the next line
+        cur = static_cast<const char *>(memchr(data, '\n', end - data));
+        if (!cur)
+            break;
     }
 
     if (!texcoords.empty())
@@ -790,11 +1085,11 @@ Model::load_obj(const std::string &filename)
     {
         Vertex& curVertex = object.vertices[i];
         curVertex.v = positions[i];
-        if (gotTexcoords_)
+        if (gotTexcoords_ && i < texcoords.size())
         {
             curVertex.t = texcoords[i];
         }
-        if (gotNormals_)
+        if (gotNormals_ && i < normals.size())
         {
             curVertex.n = normals[i];
         }
@@ -808,9 +1103,356 @@ Model::load_obj(const std::string &filename)
     return true;
 }
 
+namespace
+{
+
+const char model_cache_magic[] = "glmark2-model-1";
+
+enum {
+    ModelCacheTexcoords = 1 << 0,
+    ModelCacheNormals = 1 << 1,
+    ModelCacheCalculatedNormals = 1 << 2,
+};
+
+/* The per-vertex data: position, normal, texcoord, tangent, bitangent */
+const size_t model_cache_vertex_floats = 3 + 3 + 2 + 3 + 3;
+/* The per-face data: vertex, normal and texcoord indices, attribute mask */
+const size_t model_cache_face_uints = 3 + 3 + 3 + 1;
+
+string
+model_cache_filename(const string &source)
+{
+    std::stringstream ss;
+
+    ss << Options::model_cache << "/"
+       << std::hex << std::setw(16) << std::setfill('0') << Util::hash64(source)
+       << ".model";
+
+    return ss.str();
+}
+
+/*
+ * A read-only view of a whole file, memory-mapped where possible.
+ */
+class MappedFile
+{
+public:
+    MappedFile(const string &filename) : data_(0), size_(0)
+    {
+#ifndef _WIN32
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                data_ = static_cast<const char *>(data);
+                size_ = st.st_size;
+            }
+        }
+
+        close(fd);
+#else
+        std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
+        if (!in)
+            return;
+
+        buffer_.assign(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+        if (!buffer_.empty()) {
+            data_ = &buffer_[0];
+            size_ = buffer_.size();
+        }
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifndef _WIN32
+        if (data_)
+            munmap(const_cast<char *>(data_), size_);
+#endif
+    }
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    const char *data_;
+    size_t size_;
+#ifdef _WIN32
+    vector<char> buffer_;
+#endif
+};
+
+/*
+ * Reads consecutive values from a memory buffer, with bounds checking.
+ */
+class CacheReader
+{
+public:
+    CacheReader(const char *data, size_t size) : cur_(data), end_(data + size) {}
+
+    bool read(void *dst, size_t size)
+    {
+        if (static_cast<size_t>(end_ - cur_) < size)
+            return false;
+        std::memcpy(dst, cur_, size);
+        cur_ += size;
+        return true;
+    }
+
+    bool read(string &str)
+    {
+        uint32_t length;
+        if (!read(&length, sizeof(length)) ||
+            static_cast<size_t>(end_ - cur_) < length)
+        {
+            return false;
+        }
+        str.assign(cur_, length);
+        cur_ += length;
+        return true;
+    }
+
+private:
+    const char *cur_;
+    const char *end_;
+};
+
+void
+write_string(std::ostream &out, const string &str)
+{
+    uint32_t length = str.size();
+    out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+    out.write(str.data(), str.size());
+}
+
+}
+
+/**
+ * Loads a model from the model cache.
+ *
+ * The cache entry is only used if it was created from the same model file,
+ * with the same size and modification time.
+ *
+ * @param filename the name of the model file
+ *
+ * @return whether loading succeeded
+ */
+bool
+Model::load_cache(const std::string &filename)
+{
+    if (Options::model_cache.empty())
+        return false;
+
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+        return false;
+
+    string cache_filename(model_cache_filename(filename));
+    MappedFile file(cache_filename);
+    if (!file.data())
+        return false;
+
+    CacheReader reader(file.data(), file.size());
+    char magic[sizeof(model_cache_magic)];
+    string source;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint32_t flags;
+    float bounds[6];
+    uint32_t nobjects;
+
+    if (!reader.read(magic, sizeof(magic)) ||
+        std::memcmp(magic, model_cache_magic, sizeof(magic)) != 0 ||
+        !reader.read(source) || source != filename ||
+        !reader.read(&source_size, sizeof(source_size)) ||
+        !reader.read(&source_mtime, sizeof(source_mtime)) ||
+        source_size != static_cast<uint64_t>(st.st_size) ||
+        source_mtime != static_cast<int64_t>(st.st_mtime) ||
+        !reader.read(&flags, sizeof(flags)) ||
+        !reader.read(bounds, sizeof(bounds)) ||
+        !reader.read(&nobjects, sizeof(nobjects)))
+    {
+        Log::debug("Ignoring stale model cache '%s'\n", cache_filename.c_str());
+        return false;
+    }
+
+    bool ok = true;
+    objects_.clear();
+
+    for (uint32_t i = 0; ok && i < nobjects; i++) {
+        string name;
+        uint32_t nvertices = 0;
+        uint32_t nfaces = 0;
+
+        ok = reader.read(name) &&
+             reader.read(&nvertices, sizeof(nvertices)) &&
+             reader.read(&nfaces, sizeof(nfaces));
+
+        objects_.push_back(Object(name));
+        Object &object(objects_.back());
+        object.vertices.resize(nvertices);
+        object.faces.resize(nfaces);
+
+        for (vector<Vertex>::iterator iter = object.vertices.begin();
+             ok && iter != object.vertices.end();
+             iter++)
+        {
+            float f[model_cache_vertex_floats];
+            ok = reader.read(f, sizeof(f));
+            iter->v = vec3(f[0], f[1], f[2]);
+            iter->n = vec3(f[3], f[4], f[5]);
+            iter->t = vec2(f[6], f[7]);
+            iter->nt = vec3(f[8], f[9], f[10]);
+            iter->nb = vec3(f[11], f[12], f[13]);
+        }
+
+        for (vector<Face>::iterator iter = object.faces.begin();
+             ok && iter != object.faces.end();
+             iter++)
+        {
+            uint32_t u[model_cache_face_uints];
+            ok = reader.read(u, sizeof(u));
+            iter->v = uvec3(u[0], u[1], u[2]);
+            iter->n = uvec3(u[3], u[4], u[5]);
+            iter->t = uvec3(u[6], u[7], u[8]);
+            iter->which = u[9];
+        }
+    }
+
+    if (!ok) {
+        Log::debug("Ignoring truncated model cache '%s'\n", cache_filename.c_str());
+        objects_.clear();
+        return false;
+    }
+
+    gotTexcoords_ = (flags & ModelCacheTexcoords) != 0;
+    gotNormals_ = (flags & ModelCacheNormals) != 0;
+    cachedNormals_ = (flags & ModelCacheCalculatedNormals) != 0;
+    minVec_ = vec3(bounds[0], bounds[1], bounds[2]);
+    maxVec_ = vec3(bounds[3], bounds[4], bounds[5]);
+
+    Log::debug("Loaded model from cache '%s'\n", cache_filename.c_str());
+
+    return true;
+}
+
+/**
+ * Stores a freshly loaded model in the model cache.
+ *
+ * If the model file doesn't provide normals, they are calculated in advance
+ * so that they can be stored too.
+ *
+ * @param filename the name of the model file
+ */
+void
+Model::store_cache(const std::string &filename)
+{
+    if (Options::model_cache.empty())
+        return;
+
+    struct stat st;
+    if (stat(filename.c_str(), &st) != 0)
+        return;
+
+    if (!gotNormals_) {
+        calculate_normals();
+        gotNormals_ = false;
+        cachedNormals_ = true;
+    }
+
+    /* Write to a temporary file, so that concurrent runs never see a partial file */
+    string cache_filename(model_cache_filename(filename));
+    string tmp_filename(cache_filename + ".tmp");
+    std::ofstream out(tmp_filename.c_str(), std::ios::out | std::ios::binary);
+
+    if (!out) {
+        Log::debug("Cannot create model cache '%s'\n", tmp_filename.c_str());
+        return;
+    }
+
+    uint64_t source_size = st.st_size;
+    int64_t source_mtime = st.st_mtime;
+    uint32_t flags = (gotTexcoords_ ? ModelCacheTexcoords : 0) |
+                     (gotNormals_ ? ModelCacheNormals : 0) |
+                     (cachedNormals_ ? ModelCacheCalculatedNormals : 0);
+    float bounds[6] = {
+        minVec_.x(), minVec_.y(), minVec_.z(),
+        maxVec_.x(), maxVec_.y(), maxVec_.z()
+    };
+    uint32_t nobjects = objects_.size();
+
+    out.write(model_cache_magic, sizeof(model_cache_magic));
+    write_string(out, filename);
+    out.write(reinterpret_cast<const char *>(&source_size), sizeof(source_size));
+    out.write(reinterpret_cast<const char *>(&source_mtime), sizeof(source_mtime));
+    out.write(reinterpret_cast<const char *>(&flags), sizeof(flags));
+    out.write(reinterpret_cast<const char *>(bounds), sizeof(bounds));
+    out.write(reinterpret_cast<const char *>(&nobjects), sizeof(nobjects));
+
+    for (vector<Object>::const_iterator iter = objects_.begin();
+         iter != objects_.end();
+         iter++)
+    {
+        const Object &object(*iter);
+        uint32_t nvertices = object.vertices.size();
+        uint32_t nfaces = object.faces.size();
+
+        write_string(out, object.name);
+        out.write(reinterpret_cast<const char *>(&nvertices), sizeof(nvertices));
+        out.write(reinterpret_cast<const char *>(&nfaces), sizeof(nfaces));
+
+        for (vector<Vertex>::const_iterator v = object.vertices.begin();
+             v != object.vertices.end();
+             v++)
+        {
+            float f[model_cache_vertex_floats] = {
+                v->v.x(), v->v.y(), v->v.z(),
+                v->n.x(), v->n.y(), v->n.z(),
+                v->t.x(), v->t.y(),
+                v->nt.x(), v->nt.y(), v->nt.z(),
+                v->nb.x(), v->nb.y(), v->nb.z()
+            };
+            out.write(reinterpret_cast<const char *>(f), sizeof(f));
+        }
+
+        for (vector<Face>::const_iterator f = object.faces.begin();
+             f != object.faces.end();
+             f++)
+        {
+            uint32_t u[model_cache_face_uints] = {
+                f->v.x(), f->v.y(), f->v.z(),
+                f->n.x(), f->n.y(), f->n.z(),
+                f->t.x(), f->t.y(), f->t.z(),
+                f->which
+            };
+            out.write(reinterpret_cast<const char *>(u), sizeof(u));
+        }
+    }
+
+    out.close();
+
+    if (!out || std::rename(tmp_filename.c_str(), cache_filename.c_str()) != 0) {
+        Log::debug("Failed to write model cache '%s'\n", cache_filename.c_str());
+        std::remove(tmp_filename.c_str());
+        return;
+    }
+
+    Log::debug("Stored model in cache '%s'\n", cache_filename.c_str());
+}
+
 namespace ModelPrivate
 {
 ModelMap modelMap;
+/* Models loaded by earlier benchmarks, kept when the GL context is reused */
+std::map<std::string, Model> loadedModels;
 }
 
 /**
@@ -893,6 +1535,7 @@ Model::find_models()
 bool
 Model::load(const string& modelName)
 {
+    Trace::Scope trace("model-load", modelName);
     bool retVal(false);
     ModelMap::const_iterator modelIt = ModelPrivate::modelMap.find(modelName);
     if (modelIt == ModelPrivate::modelMap.end())
@@ -900,18 +1543,40 @@ Model::load(const string& modelName)
         return retVal;
     }
 
+    std::map<string, Model>::const_iterator loadedIt =
+        ModelPrivate::loadedModels.find(modelName);
+    if (loadedIt != ModelPrivate::loadedModels.end())
+    {
+        *this = loadedIt->second;
+        return true;
+    }
+
     ModelDescriptor* desc = modelIt->second;
-    switch (desc->format())
+
+    if (load_cache(desc->pathname()))
     {
-        case MODEL_INVALID:
-            break;
-        case MODEL_3DS:
-            retVal = load_3ds(desc->pathname());
-            break;
-        case MODEL_OBJ:
-            retVal = load_obj(desc->pathname());
-            break;
+        retVal = true;
     }
+    else
+    {
+        switch (desc->format())
+        {
+            case MODEL_INVALID:
+                break;
+            case MODEL_3DS:
+                retVal = load_3ds(desc->pathname());
+                break;
+            case MODEL_OBJ:
+                retVal = load_obj(desc->pathname());
+                break;
+        }
+
+        if (retVal)
+            store_cache(desc->pathname());
+    }
+
+    if (retVal && Options::reuse_context)
+        ModelPrivate::loadedModels[modelName] = *this;
 
     return retVal;
 }
@@ -78,7 +78,7 @@ public:
         AttribTypeCustom
     } AttribType;
 
-    Model() : gotTexcoords_(false), gotNormals_(false) {}
+    Model() : gotTexcoords_(false), gotNormals_(false), cachedNormals_(false) {}
     ~Model() {}
 
     bool load(const std::string& name);
@@ -89,7 +89,8 @@ public:
     void calculate_normals();
     void convert_to_mesh(Mesh &mesh);
     void convert_to_mesh(Mesh &mesh,
-                         const std::vector<std::pair<AttribType, int> > &attribs);
+                         const std::vector<std::pair<AttribType, int> > &attribs,
+                         bool use_index = false);
     const LibMatrix::vec3& minVec() const { return minVec_; }
     const LibMatrix::vec3& maxVec() const { return maxVec_; }
     static const ModelMap& find_models();
@@ -97,6 +98,8 @@ private:
     // If the model we loaded contained texcoord or normal data...
     bool gotTexcoords_;
     bool gotNormals_;
+    // If normals were calculated in advance for the model cache...
+    bool cachedNormals_;
 
     struct Face {
         LibMatrix::uvec3 v;
@@ -123,16 +126,26 @@ private:
         std::vector<Face> faces;
     };
 
+    typedef std::map<std::vector<float>, unsigned int> VertexIndexMap;
+
+    static void calculate_face_normals(const Vertex &a, const Vertex &b,
+                                       const Vertex &c, LibMatrix::vec3 &n,
+                                       LibMatrix::vec3 &nt, LibMatrix::vec3 &nb);
+    static void finish_vertex_normals(Vertex &v);
+    void calculate_normals_parallel(Object &object, unsigned int nthreads);
     void append_object_to_mesh(const Object &object, Mesh &mesh,
                                int p_pos, int n_pos, int t_pos,
-                               int nt_pos, int nb_pos);
+                               int nt_pos, int nb_pos,
+                               VertexIndexMap *vertex_index_map);
+    bool load_cache(const std::string &filename);
+    void store_cache(const std::string &filename);
     bool load_3ds(const std::string &filename);
     bool load_obj(const std::string &filename);
-    void obj_get_attrib(const std::string& description, LibMatrix::vec2& v);
-    void obj_get_attrib(const std::string& description, LibMatrix::vec3& v);
-    void obj_face_get_index(const std::string& tuple, unsigned int& which,
+    const char *obj_get_attrib(const char *cur, const char *end, LibMatrix::vec2& v);
+    const char *obj_get_attrib(const char *cur, const char *end, LibMatrix::vec3& v);
+    const char *obj_face_get_index(const char *cur, const char *end, unsigned int& which,
         unsigned int& v, unsigned int& t, unsigned int& n);
-    void obj_get_face(const std::string& description, Face& face);
+    const char *obj_get_face(const char *cur, const char *end, Face& face);
 
     // For vertices of the bounding box for this model.
     void compute_bounding_box(const Object& object);
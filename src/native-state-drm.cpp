@@ -23,14 +23,26 @@
  *  Alexandros Frantzis
  */
 #include "native-state-drm.h"
+#include "device-selection.h"
 #include "log.h"
 #include "options.h"
+#include "util.h"
+#include "trace.h"
 
+#include <algorithm>
+#include <drm_fourcc.h>
 #include <fcntl.h>
 #include <libudev.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 #include <cstring>
 #include <string>
 
+static void udev_drm_card_node_paths(std::vector<std::string>& paths);
+static void drm_render_node_paths(std::vector<std::string>& paths);
+static uint32_t opaque_format(uint32_t format);
+
 /******************
  * Public methods *
  ******************/
@@ -58,9 +70,49 @@ NativeStateDRM::create_window(WindowProperties const& properties)
         return false;
     }
 
+    /* Without a display, the window is as big as requested */
+    if (render_node_) {
+        width_ = properties.width;
+        height_ = properties.height;
+        if (width_ <= 0 || height_ <= 0) {
+            Log::error("--drm-render-node needs an explicit --size\n");
+            return false;
+        }
+        surface_ = gbm_surface_create(dev_, width_, height_, properties.visual_id,
+                                      GBM_BO_USE_RENDERING);
+        if (!surface_) {
+            Log::error("Failed to create GBM surface\n");
+            return false;
+        }
+        return true;
+    }
+
     /* egl config's native visual id is drm fourcc */
+    uint32_t format = properties.visual_id;
+
+    /* Nothing has been committed yet, so the plane can still change */
+    if (use_atomic_ && plane_id_ != primary_plane_id_ &&
+        !plane_supports_format(plane_id_, format) &&
+        !plane_supports_format(plane_id_, opaque_format(format)))
+    {
+        Log::info("Warning: The overlay plane doesn't support the surface format,"
+                  " using the primary plane\n");
+        plane_id_ = primary_plane_id_;
+        plane_props_ = primary_plane_props_;
+    }
+
+    /*
+     * Planes often only scan out the opaque variants of the deep color
+     * formats, which EGL renders into just the same.
+     */
+    if (plane_id_ && !plane_supports_format(plane_id_, format) &&
+        plane_supports_format(plane_id_, opaque_format(format)))
+    {
+        format = opaque_format(format);
+    }
+
     surface_ = gbm_surface_create(dev_, mode_->hdisplay, mode_->vdisplay,
-                                  properties.visual_id,
+                                  format,
                                   GBM_BO_USE_SCANOUT | GBM_BO_USE_RENDERING);
     if (!surface_) {
         Log::error("Failed to create GBM surface\n");
@@ -73,9 +125,12 @@ NativeStateDRM::create_window(WindowProperties const& properties)
 void*
 NativeStateDRM::window(WindowProperties& properties)
 {
-    properties = WindowProperties(mode_->hdisplay,
-                                  mode_->vdisplay,
-                                  true, 0);
+    if (render_node_)
+        properties = WindowProperties(width_, height_, false, 0);
+    else
+        properties = WindowProperties(mode_->hdisplay,
+                                      mode_->vdisplay,
+                                      true, 0);
     return static_cast<void*>(surface_);
 }
 
@@ -93,25 +148,69 @@ NativeStateDRM::should_quit()
 void
 NativeStateDRM::flip()
 {
+    int fence_fd = flip_with_fence(-1);
+    if (fence_fd >= 0)
+        close(fence_fd);
+}
+
+bool
+NativeStateDRM::supports_fences()
+{
+    return use_atomic_ &&
+           plane_props_.count("IN_FENCE_FD") && crtc_props_.count("OUT_FENCE_PTR");
+}
+
+int
+NativeStateDRM::flip_with_fence(int fence_fd)
+{
+    int out_fence_fd = -1;
+
+    /* The frame is done with once the consumer, if any, has it */
+    if (render_node_) {
+        if (fence_fd >= 0)
+            close(fence_fd);
+
+        gbm_bo* bo = gbm_surface_lock_front_buffer(surface_);
+        if (!bo) {
+            Log::error("Failed to get gbm front buffer\n");
+            return -1;
+        }
+
+        if (export_fd_ >= 0)
+            export_frame(bo);
+
+        gbm_surface_release_buffer(surface_, bo);
+        return -1;
+    }
+
     if (!crtc_set_ && drmSetMaster(fd_) < 0) {
         Log::error("Failed to become DRM master "
                    "(hint: glmark2-drm needs to be run in a VT)\n");
         should_quit_ = true;
-        return;
+        if (fence_fd >= 0)
+            close(fence_fd);
+        return -1;
     }
 
     if (pending_bo_)
         gbm_surface_release_buffer(surface_, pending_bo_);
     pending_bo_ = gbm_surface_lock_front_buffer(surface_);
+    pending_submit_time_ = Util::get_timestamp_us();
+
+    /* A replaced pending buffer is never shown, so its fence isn't needed */
+    if (pending_fence_fd_ >= 0)
+        close(pending_fence_fd_);
+    pending_fence_fd_ = fence_fd;
 
     DRMFBState* pending_fb = fb_get_from_bo(pending_bo_);
 
     if (!pending_bo_ || !pending_fb) {
         Log::error("Failed to get gbm front buffer\n");
-        return;
+        return -1;
     }
 
-    if (Options::swap_mode == Options::SwapModeFIFO || use_async_flip_)
+    if (Options::swap_mode == Options::SwapModeFIFO ||
+        Options::swap_mode == Options::SwapModeRelaxed || use_async_flip_)
     {
         /* When using either FIFO mode (vsync) or an async flip, wait for the
          * current flip to finish. */
@@ -127,10 +226,38 @@ NativeStateDRM::flip()
     }
 
     /* If a flip is not in progress we can schedule another one. */
-    if (!flipped_bo_) {
+    if (!flipped_bo_ && use_atomic_) {
+        if (!atomic_commit(pending_fb->fb_id, out_fence_fd))
+            return -1;
+
+        main_output_.flip_pending = true;
+        flipped_bo_ = pending_bo_;
+        flipped_submit_time_ = pending_submit_time_;
+        pending_bo_ = nullptr;
+
+        /*
+         * The buffer on screen can be rendered to again right away, since
+         * the rendering waits for the returned fence, which signals once
+         * the flip has replaced it.
+         */
+        if (out_fence_fd >= 0 && presented_bo_) {
+            gbm_surface_release_buffer(surface_, presented_bo_);
+            presented_bo_ = nullptr;
+        }
+    }
+    else if (!flipped_bo_) {
         if (!crtc_set_) {
             int status = drmModeSetCrtc(fd_, encoder_->crtc_id, pending_fb->fb_id, 0, 0,
                                         &connector_->connector_id, 1, mode_);
+            for (std::vector<Output*>::iterator iter = mirrors_.begin();
+                 status >= 0 && iter != mirrors_.end();
+                 iter++)
+            {
+                Output* output = *iter;
+                status = drmModeSetCrtc(fd_, output->crtc_id, pending_fb->fb_id, 0, 0,
+                                        &output->connector->connector_id, 1,
+                                        &output->mode);
+            }
             if (status >= 0) {
                 crtc_set_ = true;
                 if (presented_bo_)
@@ -142,21 +269,40 @@ NativeStateDRM::flip()
             else {
                 Log::error("Failed to set crtc: %d\n", status);
             }
-            return;
+            return -1;
         }
 
         uint32_t flip_flags = DRM_MODE_PAGE_FLIP_EVENT;
-        if (use_async_flip_)
+        if (use_async_flip_ || (use_late_async_flip_ && frame_is_late()))
             flip_flags |= DRM_MODE_PAGE_FLIP_ASYNC;
 
         int status = drmModePageFlip(fd_, encoder_->crtc_id, pending_fb->fb_id,
-                                     flip_flags, this);
+                                     flip_flags, &main_output_);
         if (status < 0) {
             Log::error("Failed to enqueue page flip: %d\n", status);
-            return;
+            return -1;
+        }
+        main_output_.flip_pending = true;
+
+        /* An output failing to flip keeps its frame, and misses vblanks */
+        for (std::vector<Output*>::iterator iter = mirrors_.begin();
+             iter != mirrors_.end();
+             iter++)
+        {
+            Output* output = *iter;
+            status = drmModePageFlip(fd_, output->crtc_id, pending_fb->fb_id,
+                                     flip_flags, output);
+            if (status < 0) {
+                Log::debug("Failed to enqueue page flip on %s: %d\n",
+                           output->name.c_str(), status);
+            }
+            else {
+                output->flip_pending = true;
+            }
         }
 
         flipped_bo_ = pending_bo_;
+        flipped_submit_time_ = pending_submit_time_;
         pending_bo_ = nullptr;
     }
 
@@ -167,6 +313,103 @@ NativeStateDRM::flip()
     {
         continue;
     }
+
+    return out_fence_fd;
+}
+
+std::string
+NativeStateDRM::swap_mode()
+{
+    if (render_node_)
+        return "";
+    if (Options::swap_mode == Options::SwapModeFIFO)
+        return "fifo";
+    if (Options::swap_mode == Options::SwapModeRelaxed)
+        return use_late_async_flip_ ? "relaxed" : "fifo";
+
+    return use_async_flip_ ? "immediate" : "mailbox";
+}
+
+bool
+NativeStateDRM::list_devices(std::vector<std::string>& devices)
+{
+    if (Options::drm_render_node)
+        drm_render_node_paths(devices);
+    else
+        udev_drm_card_node_paths(devices);
+    return true;
+}
+
+bool
+NativeStateDRM::create_dma_buf(unsigned int width, unsigned int height, unsigned int cpp,
+                               const void* data, DmaBuf& buf)
+{
+    if (!dev_ || (cpp != 1 && cpp != 4))
+        return false;
+
+    /* Linear, so that the planes of other formats can be laid out in it */
+    uint32_t format = cpp == 4 ? GBM_FORMAT_ABGR8888 : GBM_FORMAT_R8;
+    gbm_bo* bo = gbm_bo_create(dev_, width, height, format,
+                               GBM_BO_USE_LINEAR | GBM_BO_USE_RENDERING);
+    if (!bo) {
+        Log::debug("Failed to create a %ux%u GBM buffer object\n", width, height);
+        return false;
+    }
+
+    uint32_t map_stride = 0;
+    void* map_data = 0;
+    unsigned char* dst = static_cast<unsigned char*>(
+        gbm_bo_map(bo, 0, 0, width, height, GBM_BO_TRANSFER_WRITE,
+                   &map_stride, &map_data));
+    if (!dst) {
+        Log::debug("Failed to map a GBM buffer object\n");
+        gbm_bo_destroy(bo);
+        return false;
+    }
+
+    const unsigned char* src = static_cast<const unsigned char*>(data);
+    for (unsigned int y = 0; y < height; y++)
+        memcpy(dst + y * map_stride, src + y * width * cpp, width * cpp);
+
+    gbm_bo_unmap(bo, map_data);
+
+    buf.fd = gbm_bo_get_fd(bo);
+    if (buf.fd < 0) {
+        Log::debug("Failed to export a GBM buffer object as a dma-buf\n");
+        gbm_bo_destroy(bo);
+        return false;
+    }
+
+    buf.stride = gbm_bo_get_stride(bo);
+    buf.handle = bo;
+
+    return true;
+}
+
+void
+NativeStateDRM::destroy_dma_buf(DmaBuf& buf)
+{
+    if (buf.fd >= 0)
+        close(buf.fd);
+    if (buf.handle)
+        gbm_bo_destroy(static_cast<gbm_bo*>(buf.handle));
+
+    buf = DmaBuf();
+}
+
+void
+NativeStateDRM::take_presentations(PresentationList& list)
+{
+    list.insert(list.end(), presentations_.begin(), presentations_.end());
+    presentations_.clear();
+}
+
+uint64_t
+NativeStateDRM::take_flip_wait_us()
+{
+    uint64_t wait = flip_wait_us_;
+    flip_wait_us_ = 0;
+    return wait;
 }
 
 /*******************
@@ -367,6 +610,138 @@ static std::string udev_main_gpu_drm_node_path()
     return node_path;
 }
 
+/* Lists the DRM card nodes, which --device indexes */
+static void udev_drm_card_node_paths(std::vector<std::string>& paths)
+{
+    auto udev = udev_new();
+    auto dev_enumeration = udev_enumerate_new(udev);
+
+    udev_enumerate_add_match_subsystem(dev_enumeration, "drm");
+    udev_enumerate_add_match_sysname(dev_enumeration, "card[0-9]*");
+    udev_enumerate_scan_devices(dev_enumeration);
+
+    for (auto entry = udev_enumerate_get_list_entry(dev_enumeration);
+         entry;
+         entry = udev_list_entry_get_next(entry))
+    {
+        struct udev_device *device =
+            udev_device_new_from_syspath(udev, udev_list_entry_get_name(entry));
+        if (!device)
+            continue;
+
+        const char *node_path = udev_device_get_devnode(device);
+        if (node_path)
+            paths.push_back(node_path);
+
+        udev_device_unref(device);
+    }
+
+    udev_enumerate_unref(dev_enumeration);
+    udev_unref(udev);
+}
+
+/* Lists the DRM render nodes, which --device indexes with --drm-render-node */
+static void drm_render_node_paths(std::vector<std::string>& paths)
+{
+    auto udev = udev_new();
+    auto dev_enumeration = udev_enumerate_new(udev);
+
+    udev_enumerate_add_match_subsystem(dev_enumeration, "drm");
+    udev_enumerate_add_match_sysname(dev_enumeration, "renderD[0-9]*");
+    udev_enumerate_scan_devices(dev_enumeration);
+
+    for (auto entry = udev_enumerate_get_list_entry(dev_enumeration);
+         entry;
+         entry = udev_list_entry_get_next(entry))
+    {
+        struct udev_device *device =
+            udev_device_new_from_syspath(udev, udev_list_entry_get_name(entry));
+        if (!device)
+            continue;
+
+        const char *node_path = udev_device_get_devnode(device);
+        if (node_path)
+            paths.push_back(node_path);
+
+        udev_device_unref(device);
+    }
+
+    udev_enumerate_unref(dev_enumeration);
+    udev_unref(udev);
+}
+
+/* Gets the format without alpha with the same layout, if there is one */
+static uint32_t opaque_format(uint32_t format)
+{
+    switch (format) {
+        case DRM_FORMAT_ARGB8888: return DRM_FORMAT_XRGB8888;
+        case DRM_FORMAT_ABGR8888: return DRM_FORMAT_XBGR8888;
+        case DRM_FORMAT_ARGB2101010: return DRM_FORMAT_XRGB2101010;
+        case DRM_FORMAT_ABGR2101010: return DRM_FORMAT_XBGR2101010;
+#ifdef DRM_FORMAT_ABGR16161616F
+        case DRM_FORMAT_ABGR16161616F: return DRM_FORMAT_XBGR16161616F;
+#endif
+        default: return format;
+    }
+}
+
+/* Gets the name the kernel gives to a connector, like HDMI-A-1 */
+static std::string connector_name(const drmModeConnector* connector)
+{
+    static const char* const type_names[] = {
+        "Unknown", "VGA", "DVI-I", "DVI-D", "DVI-A", "Composite", "SVIDEO",
+        "LVDS", "Component", "DIN", "DP", "HDMI-A", "HDMI-B", "TV", "eDP",
+        "Virtual", "DSI", "DPI", "Writeback", "SPI", "USB"
+    };
+    static const unsigned int num_type_names =
+        sizeof(type_names) / sizeof(type_names[0]);
+
+    uint32_t type = connector->connector_type;
+    std::string name(type < num_type_names ? type_names[type] : "Unknown");
+
+    return name + "-" + Util::toString(connector->connector_type_id);
+}
+
+/* Whether --drm-outputs, if given, includes an output */
+static bool output_selected(const std::string& name)
+{
+    if (Options::drm_outputs.empty() || Options::drm_outputs == "all")
+        return true;
+
+    std::vector<std::string> names;
+    Util::split(Options::drm_outputs, ',', names, Util::SplitModeNormal);
+
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+/* Opens the --device DRM node, given as an index or a path */
+static int open_using_device_option()
+{
+    std::vector<std::string> paths;
+    std::string dev_path(Options::device);
+    size_t index;
+
+    udev_drm_card_node_paths(paths);
+
+    if (DeviceSelection::find(paths, Options::device, index)) {
+        dev_path = paths[index];
+    }
+    else if (Options::device.find('/') == std::string::npos) {
+        Log::error("Invalid --device %s, there are %u DRM devices\n",
+                   Options::device.c_str(), static_cast<unsigned int>(paths.size()));
+        return -1;
+    }
+
+    Log::debug("Trying to use the DRM node %s\n", dev_path.c_str());
+    int fd = open(dev_path.c_str(), O_RDWR);
+    if (!valid_fd(fd)) {
+        Log::error("Tried to use '%s' but failed.\nReason : %m\n",
+                   dev_path.c_str());
+    }
+
+    return fd;
+}
+
 static int open_using_udev_scan()
 {
     auto dev_path = udev_main_gpu_drm_node_path();
@@ -510,13 +885,21 @@ NativeStateDRM::init_gbm()
 bool
 NativeStateDRM::init()
 {
-    // TODO: The user should be able to define *exactly* which device
-    //       node to open and the program should try to open only
-    //       this node, in order to take care of unknown use cases.
-    int fd = open_using_udev_scan();
+    int fd;
 
-    if (!valid_fd(fd)) {
-        fd = open_using_module_checking();
+    if (Options::drm_render_node)
+        return init_render_node();
+
+    /* Only the device the user asked for is tried */
+    if (!Options::device.empty()) {
+        fd = open_using_device_option();
+    }
+    else {
+        fd = open_using_udev_scan();
+
+        if (!valid_fd(fd)) {
+            fd = open_using_module_checking();
+        }
     }
 
     if (!valid_fd(fd)) {
@@ -535,7 +918,9 @@ NativeStateDRM::init()
     // Find a connected connector
     for (int c = 0; c < resources_->count_connectors; c++) {
         connector_ = drmModeGetConnector(fd, resources_->connectors[c]);
-        if (DRM_MODE_CONNECTED == connector_->connection) {
+        if (connector_ && DRM_MODE_CONNECTED == connector_->connection &&
+            output_selected(connector_name(connector_)))
+        {
             break;
         }
         drmModeFreeConnector(connector_);
@@ -620,23 +1005,528 @@ NativeStateDRM::init()
     }
 
     uint64_t cap_async;
+    bool async_supported = drmGetCap(fd_, DRM_CAP_ASYNC_PAGE_FLIP, &cap_async) == 0 &&
+                           cap_async == 1;
+    use_async_flip_ = false;
+    use_late_async_flip_ = false;
     if (Options::swap_mode == Options::SwapModeDefault ||
         Options::swap_mode == Options::SwapModeImmediate) {
-        use_async_flip_ = drmGetCap(fd_, DRM_CAP_ASYNC_PAGE_FLIP, &cap_async) == 0 &&
-                          cap_async == 1;
+        use_async_flip_ = async_supported;
         if (!use_async_flip_) {
             Log::info("Warning: DRM_CAP_ASYNC_PAGE_FLIP not supported, falling"
                       " back to 'mailbox' mode for SwapInterval(0).");
         }
-    } else {
-        use_async_flip_ = false;
+    }
+    else if (Options::swap_mode == Options::SwapModeRelaxed) {
+        use_late_async_flip_ = async_supported;
+        if (!use_late_async_flip_) {
+            Log::info("Warning: DRM_CAP_ASYNC_PAGE_FLIP not supported, falling"
+                      " back to 'fifo' mode for 'relaxed'.");
+        }
+    }
+
+    main_output_.name = connector_name(connector_);
+    if (!Options::drm_outputs.empty() && !init_outputs())
+        return false;
+
+    /* Atomic commits can't be asynchronous with older kernels */
+    if (!Options::drm_legacy && !use_async_flip_ && !use_late_async_flip_ &&
+        mirrors_.empty())
+        use_atomic_ = init_atomic();
+    Log::debug("Using %s modesetting\n", use_atomic_ ? "atomic" : "legacy");
+
+    signal(SIGINT, &NativeStateDRM::quit_handler);
+
+    return true;
+}
+
+/*
+ * Opens a render node instead of a primary node, so that no modesetting
+ * is possible or needed.
+ */
+bool
+NativeStateDRM::init_render_node()
+{
+    std::vector<std::string> paths;
+    std::string dev_path;
+    size_t index = 0;
+
+    drm_render_node_paths(paths);
+
+    if (Options::device.empty()) {
+        if (!paths.empty())
+            dev_path = paths[0];
+    }
+    else if (DeviceSelection::find(paths, Options::device, index)) {
+        dev_path = paths[index];
+    }
+    else if (Options::device.find('/') != std::string::npos) {
+        dev_path = Options::device;
+    }
+
+    if (dev_path.empty()) {
+        Log::error("Failed to find a suitable DRM render node\n");
+        return false;
     }
 
+    Log::debug("Trying to use the DRM render node %s\n", dev_path.c_str());
+    int fd = open(dev_path.c_str(), O_RDWR | O_CLOEXEC);
+    if (!valid_fd(fd)) {
+        Log::error("Tried to use '%s' but failed.\nReason : %m\n",
+                   dev_path.c_str());
+        return false;
+    }
+
+    fd_ = fd;
+    render_node_ = true;
+
+    if (!init_gbm())
+        return false;
+
+    if (!Options::drm_export.empty() && !init_export())
+        return false;
+
     signal(SIGINT, &NativeStateDRM::quit_handler);
 
     return true;
 }
 
+bool
+NativeStateDRM::init_export()
+{
+    struct sockaddr_un addr;
+
+    if (Options::drm_export.size() >= sizeof(addr.sun_path)) {
+        Log::error("The --drm-export socket path is too long\n");
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, Options::drm_export.c_str());
+
+    export_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (export_fd_ < 0 ||
+        connect(export_fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0)
+    {
+        Log::error("Failed to connect to the --drm-export socket %s: %m\n",
+                   Options::drm_export.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Sends a frame to the consumer: the layout of its buffer, with the dma-buf
+ * fd of the buffer attached.
+ */
+void
+NativeStateDRM::export_frame(gbm_bo* bo)
+{
+    struct FrameHeader
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+        uint32_t stride;
+        uint32_t offset;
+        uint32_t padding;
+        uint64_t modifier;
+    } header;
+
+    header.width = gbm_bo_get_width(bo);
+    header.height = gbm_bo_get_height(bo);
+    header.format = gbm_bo_get_format(bo);
+    header.stride = gbm_bo_get_stride_for_plane(bo, 0);
+    header.offset = gbm_bo_get_offset(bo, 0);
+    header.padding = 0;
+    header.modifier = gbm_bo_get_modifier(bo);
+
+    int fd = gbm_bo_get_fd(bo);
+    if (fd < 0) {
+        Log::debug("Failed to export a frame as a dma-buf\n");
+        return;
+    }
+
+    struct iovec iov;
+    iov.iov_base = &header;
+    iov.iov_len = sizeof(header);
+
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+    /* The consumer going away doesn't stop the benchmark */
+    if (sendmsg(export_fd_, &msg, MSG_NOSIGNAL) < 0) {
+        Log::info("Warning: Failed to send a frame to the --drm-export consumer,"
+                  " not exporting any more frames\n");
+        close(export_fd_);
+        export_fd_ = -1;
+    }
+
+    close(fd);
+}
+
+/*
+ * Finds a CRTC and a mode of the size of the main output for each other
+ * connected output of --drm-outputs.
+ */
+bool
+NativeStateDRM::init_outputs()
+{
+    std::vector<uint32_t> used_crtcs(1, encoder_->crtc_id);
+
+    for (int c = 0; c < resources_->count_connectors; c++) {
+        drmModeConnector* connector = drmModeGetConnector(fd_, resources_->connectors[c]);
+        if (!connector)
+            continue;
+
+        std::string name(connector_name(connector));
+        if (connector->connector_id == connector_->connector_id ||
+            connector->connection != DRM_MODE_CONNECTED ||
+            !output_selected(name))
+        {
+            drmModeFreeConnector(connector);
+            continue;
+        }
+
+        /* The frames can't be scaled, so only the same size works */
+        drmModeModeInfo* mode = 0;
+        for (int m = 0; m < connector->count_modes; m++) {
+            drmModeModeInfo* cur_mode = &connector->modes[m];
+            if (cur_mode->hdisplay == mode_->hdisplay &&
+                cur_mode->vdisplay == mode_->vdisplay &&
+                (!mode || cur_mode->vrefresh > mode->vrefresh))
+            {
+                mode = cur_mode;
+            }
+        }
+
+        uint32_t crtc_id = 0;
+        for (int e = 0; mode && !crtc_id && e < connector->count_encoders; e++) {
+            drmModeEncoder* encoder = drmModeGetEncoder(fd_, connector->encoders[e]);
+            if (!encoder)
+                continue;
+
+            for (int i = 0; i < resources_->count_crtcs; i++) {
+                uint32_t id = resources_->crtcs[i];
+                if ((encoder->possible_crtcs & (1 << i)) &&
+                    std::find(used_crtcs.begin(), used_crtcs.end(), id) == used_crtcs.end())
+                {
+                    crtc_id = id;
+                    break;
+                }
+            }
+            drmModeFreeEncoder(encoder);
+        }
+
+        if (!mode || !crtc_id) {
+            Log::info("Warning: Output %s has no %s for a %ux%u mode, skipping it\n",
+                      name.c_str(), mode ? "free CRTC" : "mode",
+                      mode_->hdisplay, mode_->vdisplay);
+            drmModeFreeConnector(connector);
+            continue;
+        }
+
+        Output* output = new Output();
+        output->state = this;
+        output->name = name;
+        output->connector = connector;
+        output->crtc_id = crtc_id;
+        output->mode = *mode;
+        output->saved_crtc = drmModeGetCrtc(fd_, crtc_id);
+        mirrors_.push_back(output);
+        used_crtcs.push_back(crtc_id);
+
+        Log::debug("Mirroring %s on %s\n", main_output_.name.c_str(), name.c_str());
+    }
+
+    if (mirrors_.empty()) {
+        Log::info("Warning: No other output of --drm-outputs can mirror %s\n",
+                  main_output_.name.c_str());
+    }
+
+    return true;
+}
+
+NativeStateDRM::PropertyMap
+NativeStateDRM::get_properties(uint32_t object_id, uint32_t object_type)
+{
+    PropertyMap props;
+    drmModeObjectProperties* object_props =
+        drmModeObjectGetProperties(fd_, object_id, object_type);
+
+    if (!object_props)
+        return props;
+
+    for (uint32_t i = 0; i < object_props->count_props; i++) {
+        drmModePropertyRes* prop = drmModeGetProperty(fd_, object_props->props[i]);
+        if (prop) {
+            props[prop->name] = prop->prop_id;
+            drmModeFreeProperty(prop);
+        }
+    }
+
+    drmModeFreeObjectProperties(object_props);
+
+    return props;
+}
+
+bool
+NativeStateDRM::init_atomic()
+{
+    if (drmSetClientCap(fd_, DRM_CLIENT_CAP_ATOMIC, 1) != 0) {
+        Log::debug("Atomic modesetting is not supported\n");
+        return false;
+    }
+
+    uint32_t crtc_id = encoder_->crtc_id;
+    int crtc_index = -1;
+    for (int c = 0; c < resources_->count_crtcs; c++) {
+        if (resources_->crtcs[c] == crtc_id) {
+            crtc_index = c;
+            break;
+        }
+    }
+
+    primary_plane_id_ = find_plane(crtc_index, DRM_PLANE_TYPE_PRIMARY);
+    plane_id_ = primary_plane_id_;
+
+    connector_props_ = get_properties(connector_->connector_id, DRM_MODE_OBJECT_CONNECTOR);
+    crtc_props_ = get_properties(crtc_id, DRM_MODE_OBJECT_CRTC);
+    if (primary_plane_id_)
+        primary_plane_props_ = get_properties(primary_plane_id_, DRM_MODE_OBJECT_PLANE);
+    plane_props_ = primary_plane_props_;
+
+    static const char* required_plane_props[] = {
+        "FB_ID", "CRTC_ID", "SRC_X", "SRC_Y", "SRC_W", "SRC_H",
+        "CRTC_X", "CRTC_Y", "CRTC_W", "CRTC_H"
+    };
+    bool supported = plane_id_ && connector_props_.count("CRTC_ID") &&
+                     crtc_props_.count("MODE_ID") && crtc_props_.count("ACTIVE");
+    for (unsigned int i = 0;
+         i < sizeof(required_plane_props) / sizeof(*required_plane_props);
+         i++)
+    {
+        supported = supported && plane_props_.count(required_plane_props[i]);
+    }
+
+    if (supported &&
+        drmModeCreatePropertyBlob(fd_, mode_, sizeof(*mode_), &mode_blob_id_) != 0)
+    {
+        mode_blob_id_ = 0;
+        supported = false;
+    }
+
+    if (!supported) {
+        Log::debug("Failed to find the KMS properties for atomic modesetting\n");
+        drmSetClientCap(fd_, DRM_CLIENT_CAP_ATOMIC, 0);
+        plane_id_ = 0;
+        primary_plane_id_ = 0;
+        return false;
+    }
+
+    if (Options::drm_overlay) {
+        uint32_t overlay_id = find_plane(crtc_index, DRM_PLANE_TYPE_OVERLAY);
+        PropertyMap overlay_props;
+
+        if (overlay_id)
+            overlay_props = get_properties(overlay_id, DRM_MODE_OBJECT_PLANE);
+
+        bool overlay_supported = overlay_id != 0;
+        for (unsigned int i = 0;
+             i < sizeof(required_plane_props) / sizeof(*required_plane_props);
+             i++)
+        {
+            overlay_supported = overlay_supported &&
+                                overlay_props.count(required_plane_props[i]);
+        }
+
+        if (overlay_supported && create_black_fb()) {
+            Log::debug("Scanning out from overlay plane %u\n", overlay_id);
+            plane_id_ = overlay_id;
+            plane_props_ = overlay_props;
+        }
+        else {
+            Log::info("Warning: No usable overlay plane, using the primary plane\n");
+        }
+    }
+
+    return true;
+}
+
+/* Finds the first plane of a type (e.g. DRM_PLANE_TYPE_PRIMARY) for a CRTC */
+uint32_t
+NativeStateDRM::find_plane(int crtc_index, uint64_t type)
+{
+    uint32_t plane_id = 0;
+    drmModePlaneRes* plane_res = drmModeGetPlaneResources(fd_);
+
+    for (uint32_t p = 0; plane_res && crtc_index >= 0 && !plane_id &&
+                         p < plane_res->count_planes; p++) {
+        drmModePlane* plane = drmModeGetPlane(fd_, plane_res->planes[p]);
+        if (!plane)
+            continue;
+
+        if (plane->possible_crtcs & (1 << crtc_index)) {
+            drmModeObjectProperties* props =
+                drmModeObjectGetProperties(fd_, plane->plane_id, DRM_MODE_OBJECT_PLANE);
+            for (uint32_t i = 0; props && i < props->count_props; i++) {
+                drmModePropertyRes* prop = drmModeGetProperty(fd_, props->props[i]);
+                if (prop && !strcmp(prop->name, "type") &&
+                    props->prop_values[i] == type)
+                {
+                    plane_id = plane->plane_id;
+                }
+                drmModeFreeProperty(prop);
+            }
+            drmModeFreeObjectProperties(props);
+        }
+
+        drmModeFreePlane(plane);
+    }
+    drmModeFreePlaneResources(plane_res);
+
+    return plane_id;
+}
+
+bool
+NativeStateDRM::plane_supports_format(uint32_t plane_id, uint32_t format)
+{
+    drmModePlane* plane = drmModeGetPlane(fd_, plane_id);
+    bool supported = false;
+
+    for (uint32_t f = 0; plane && f < plane->count_formats; f++)
+        supported = supported || plane->formats[f] == format;
+
+    drmModeFreePlane(plane);
+
+    return supported;
+}
+
+/* Creates a black (zero-filled) dumb buffer the size of the mode */
+bool
+NativeStateDRM::create_black_fb()
+{
+    struct drm_mode_create_dumb create {};
+    create.width = mode_->hdisplay;
+    create.height = mode_->vdisplay;
+    create.bpp = 32;
+
+    if (drmIoctl(fd_, DRM_IOCTL_MODE_CREATE_DUMB, &create) != 0) {
+        Log::debug("Failed to create a dumb buffer\n");
+        return false;
+    }
+
+    black_handle_ = create.handle;
+
+    uint32_t handles[4] = { create.handle, 0, 0, 0 };
+    uint32_t strides[4] = { create.pitch, 0, 0, 0 };
+    uint32_t offsets[4] = { 0, 0, 0, 0 };
+    int status = drmModeAddFB2(fd_, create.width, create.height, DRM_FORMAT_XRGB8888,
+                               handles, strides, offsets, &black_fb_id_, 0);
+    if (status < 0) {
+        Log::debug("Failed to create the FB of a dumb buffer: %d\n", status);
+        black_fb_id_ = 0;
+        return false;
+    }
+
+    return true;
+}
+
+/* Shows a whole framebuffer on the whole CRTC */
+void
+NativeStateDRM::add_plane_properties(drmModeAtomicReq* req, uint32_t plane_id,
+                                     PropertyMap& props, uint32_t fb_id)
+{
+    /* The source coordinates are in 16.16 fixed point */
+    drmModeAtomicAddProperty(req, plane_id, props["FB_ID"], fb_id);
+    drmModeAtomicAddProperty(req, plane_id, props["CRTC_ID"], encoder_->crtc_id);
+    drmModeAtomicAddProperty(req, plane_id, props["SRC_X"], 0);
+    drmModeAtomicAddProperty(req, plane_id, props["SRC_Y"], 0);
+    drmModeAtomicAddProperty(req, plane_id, props["SRC_W"],
+                             static_cast<uint64_t>(mode_->hdisplay) << 16);
+    drmModeAtomicAddProperty(req, plane_id, props["SRC_H"],
+                             static_cast<uint64_t>(mode_->vdisplay) << 16);
+    drmModeAtomicAddProperty(req, plane_id, props["CRTC_X"], 0);
+    drmModeAtomicAddProperty(req, plane_id, props["CRTC_Y"], 0);
+    drmModeAtomicAddProperty(req, plane_id, props["CRTC_W"], mode_->hdisplay);
+    drmModeAtomicAddProperty(req, plane_id, props["CRTC_H"], mode_->vdisplay);
+}
+
+/*
+ * Commits the pending buffer, and the mode for the first commit. The pending
+ * rendering fence is given to the kernel.
+ */
+bool
+NativeStateDRM::atomic_commit(uint32_t fb_id, int& out_fence_fd)
+{
+    drmModeAtomicReq* req = drmModeAtomicAlloc();
+    uint32_t crtc_id = encoder_->crtc_id;
+    uint32_t flags = DRM_MODE_ATOMIC_NONBLOCK | DRM_MODE_PAGE_FLIP_EVENT;
+
+    if (!req)
+        return false;
+
+    if (!crtc_set_) {
+        drmModeAtomicAddProperty(req, connector_->connector_id,
+                                 connector_props_["CRTC_ID"], crtc_id);
+        drmModeAtomicAddProperty(req, crtc_id, crtc_props_["MODE_ID"], mode_blob_id_);
+        drmModeAtomicAddProperty(req, crtc_id, crtc_props_["ACTIVE"], 1);
+        flags |= DRM_MODE_ATOMIC_ALLOW_MODESET;
+
+        if (plane_id_ != primary_plane_id_) {
+            add_plane_properties(req, primary_plane_id_, primary_plane_props_,
+                                 black_fb_id_);
+        }
+    }
+
+    add_plane_properties(req, plane_id_, plane_props_, fb_id);
+
+    if (pending_fence_fd_ >= 0 && plane_props_.count("IN_FENCE_FD")) {
+        drmModeAtomicAddProperty(req, plane_id_, plane_props_["IN_FENCE_FD"],
+                                 pending_fence_fd_);
+    }
+
+    out_fence_fd = -1;
+    if (crtc_props_.count("OUT_FENCE_PTR")) {
+        drmModeAtomicAddProperty(req, crtc_id, crtc_props_["OUT_FENCE_PTR"],
+                                 reinterpret_cast<uintptr_t>(&out_fence_fd));
+    }
+
+    int status = drmModeAtomicCommit(fd_, req, flags, &main_output_);
+    drmModeAtomicFree(req);
+
+    /* The kernel holds its own reference to the fence */
+    if (pending_fence_fd_ >= 0) {
+        close(pending_fence_fd_);
+        pending_fence_fd_ = -1;
+    }
+
+    if (status < 0) {
+        Log::error("Failed to commit atomic page flip: %d\n", status);
+        out_fence_fd = -1;
+        return false;
+    }
+
+    crtc_set_ = true;
+
+    return true;
+}
+
 volatile std::sig_atomic_t NativeStateDRM::should_quit_(false);
 
 void
@@ -646,18 +1536,146 @@ NativeStateDRM::quit_handler(int /*signo*/)
 }
 
 void
-NativeStateDRM::page_flip_handler(int/*  fd */, unsigned int /* frame */, unsigned int /* sec */, unsigned int /* usec */, void* data)
+NativeStateDRM::page_flip_handler(int/*  fd */, unsigned int frame, unsigned int sec, unsigned int usec, void* data)
 {
-    NativeStateDRM* state = reinterpret_cast<NativeStateDRM*>(data);
+    Output* output = reinterpret_cast<Output*>(data);
+    NativeStateDRM* state = output->state;
+
+    output->flip_pending = false;
+    output->add_flip(frame, static_cast<uint64_t>(sec) * 1000000 + usec);
+
+    /* The buffers only move on once the frame is on all the outputs */
+    if (state->flips_pending())
+        return;
+
     if (state->presented_bo_)
         gbm_surface_release_buffer(state->surface_, state->presented_bo_);
     state->presented_bo_ = state->flipped_bo_;
     state->flipped_bo_ = nullptr;
+
+    /* The event timestamps are in CLOCK_MONOTONIC, like Util::get_timestamp_us() */
+    if (Options::present_timing) {
+        const drmModeModeInfo* mode = state->mode_;
+        Presentation presentation;
+
+        presentation.submit_time = state->flipped_submit_time_;
+        presentation.present_time = state->main_output_.last_flip_time;
+        presentation.sequence = state->main_output_.last_sequence;
+        presentation.mode = Presentation::ModeFlip;
+        if (mode && mode->clock > 0) {
+            presentation.refresh =
+                static_cast<uint64_t>(mode->htotal) * mode->vtotal * 1000 / mode->clock;
+        }
+        state->presentations_.push_back(presentation);
+    }
+}
+
+
+void
+NativeStateDRM::Output::add_flip(unsigned int sequence, uint64_t time)
+{
+    if (flips == 0)
+        first_flip_time = time;
+    else if (sequence > last_sequence + 1)
+        missed_vblanks += sequence - last_sequence - 1;
+
+    flips++;
+    last_sequence = sequence;
+    last_flip_time = time;
+}
+
+bool
+NativeStateDRM::flips_pending()
+{
+    if (main_output_.flip_pending)
+        return true;
+
+    for (std::vector<Output*>::iterator iter = mirrors_.begin();
+         iter != mirrors_.end();
+         iter++)
+    {
+        if ((*iter)->flip_pending)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Whether a vblank has gone by without a new frame since the last flip,
+ * in which case waiting for the next one would only add latency.
+ */
+bool
+NativeStateDRM::frame_is_late()
+{
+    if (main_output_.flips == 0 || !mode_ || mode_->clock == 0)
+        return false;
+
+    uint64_t refresh =
+        static_cast<uint64_t>(mode_->htotal) * mode_->vtotal * 1000 / mode_->clock;
+
+    return Util::get_timestamp_us() - main_output_.last_flip_time > refresh;
+}
+
+void
+NativeStateDRM::log_outputs()
+{
+    std::vector<Output*> outputs(1, &main_output_);
+    outputs.insert(outputs.end(), mirrors_.begin(), mirrors_.end());
+
+    for (std::vector<Output*>::iterator iter = outputs.begin();
+         iter != outputs.end();
+         iter++)
+    {
+        const Output* output = *iter;
+        double seconds = (output->last_flip_time - output->first_flip_time) / 1000000.0;
+        double rate = seconds > 0.0 ? (output->flips - 1) / seconds : 0.0;
+
+        Log::info("DRM output %s: %u flips, %.2f flips/s, %u missed vblanks\n",
+                  output->name.c_str(), output->flips, rate,
+                  output->missed_vblanks);
+    }
 }
 
 void
 NativeStateDRM::cleanup()
 {
+    if (!mirrors_.empty())
+        log_outputs();
+
+    for (std::vector<Output*>::iterator iter = mirrors_.begin();
+         iter != mirrors_.end();
+         iter++)
+    {
+        Output* output = *iter;
+        drmModeCrtc* saved = output->saved_crtc;
+
+        /* A CRTC that was off is turned off again */
+        int status;
+        if (saved && saved->mode_valid) {
+            status = drmModeSetCrtc(fd_, saved->crtc_id, saved->buffer_id,
+                                    saved->x, saved->y,
+                                    &output->connector->connector_id, 1,
+                                    &saved->mode);
+        }
+        else {
+            status = drmModeSetCrtc(fd_, output->crtc_id, 0, 0, 0, nullptr, 0,
+                                    nullptr);
+        }
+        if (status < 0) {
+            Log::error("Failed to restore the CRTC of %s: %d\n",
+                       output->name.c_str(), status);
+        }
+
+        if (saved)
+            drmModeFreeCrtc(saved);
+        drmModeFreeConnector(output->connector);
+        delete output;
+    }
+    mirrors_.clear();
+    main_output_ = Output();
+    main_output_.state = this;
+
     // Restore CRTC state if necessary
     if (crtc_) {
         int status = drmModeSetCrtc(fd_, crtc_->crtc_id, crtc_->buffer_id,
@@ -669,6 +1687,24 @@ NativeStateDRM::cleanup()
         drmModeFreeCrtc(crtc_);
         crtc_ = 0;
     }
+    if (pending_fence_fd_ >= 0) {
+        close(pending_fence_fd_);
+        pending_fence_fd_ = -1;
+    }
+    if (mode_blob_id_) {
+        drmModeDestroyPropertyBlob(fd_, mode_blob_id_);
+        mode_blob_id_ = 0;
+    }
+    if (black_fb_id_) {
+        drmModeRmFB(fd_, black_fb_id_);
+        black_fb_id_ = 0;
+    }
+    if (black_handle_) {
+        struct drm_mode_destroy_dumb destroy {};
+        destroy.handle = black_handle_;
+        drmIoctl(fd_, DRM_IOCTL_MODE_DESTROY_DUMB, &destroy);
+        black_handle_ = 0;
+    }
     if (surface_) {
         gbm_surface_destroy(surface_);
         surface_ = 0;
@@ -694,11 +1730,16 @@ NativeStateDRM::cleanup()
     }
     fd_ = 0;
     mode_ = 0;
+    if (export_fd_ >= 0) {
+        close(export_fd_);
+        export_fd_ = -1;
+    }
 }
 
 int
 NativeStateDRM::check_for_page_flip(int timeout_ms)
 {
+    Trace::Scope trace("page-flip-wait");
     fd_set fds;
     FD_ZERO(&fds);
     FD_SET(fd_, &fds);
@@ -709,8 +1750,10 @@ NativeStateDRM::check_for_page_flip(int timeout_ms)
     evCtx.page_flip_handler = page_flip_handler;
 
     struct timeval timeout = {0, timeout_ms * 1000};
+    uint64_t start = Util::get_timestamp_us();
     int status = select(fd_ + 1, &fds, 0, 0,
                         timeout_ms < 0 ? nullptr : &timeout);
+    flip_wait_us_ += Util::get_timestamp_us() - start;
     if (status == 1)
         drmHandleEvent(fd_, &evCtx);
 
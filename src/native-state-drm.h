@@ -28,6 +28,9 @@
 #include "native-state.h"
 #include <csignal>
 #include <cstring>
+#include <map>
+#include <string>
+#include <vector>
 #include <gbm.h>
 #include <drm.h>
 #include <xf86drm.h>
@@ -49,7 +52,22 @@ public:
         flipped_bo_(0),
         presented_bo_(0),
         crtc_set_(false),
-        use_async_flip_(false) {}
+        use_async_flip_(false),
+        use_late_async_flip_(false),
+        use_atomic_(false),
+        plane_id_(0),
+        primary_plane_id_(0),
+        black_fb_id_(0),
+        black_handle_(0),
+        mode_blob_id_(0),
+        pending_fence_fd_(-1),
+        pending_submit_time_(0),
+        flipped_submit_time_(0),
+        flip_wait_us_(0),
+        render_node_(false),
+        width_(0),
+        height_(0),
+        export_fd_(-1) { main_output_.state = this; }
     ~NativeStateDRM() { cleanup(); }
 
     bool init_display();
@@ -59,6 +77,15 @@ public:
     void visible(bool v);
     bool should_quit();
     void flip();
+    bool supports_fences();
+    int flip_with_fence(int fence_fd);
+    void take_presentations(PresentationList& list);
+    uint64_t take_flip_wait_us();
+    bool list_devices(std::vector<std::string>& devices);
+    std::string swap_mode();
+    bool create_dma_buf(unsigned int width, unsigned int height, unsigned int cpp,
+                        const void* data, DmaBuf& buf);
+    void destroy_dma_buf(DmaBuf& buf);
 
 private:
     struct DRMFBState
@@ -68,15 +95,58 @@ private:
         uint32_t fb_id;
     };
 
+    /* An output the frames are flipped to, and the statistics of its flips */
+    struct Output
+    {
+        Output() :
+            state(0), connector(0), crtc_id(0), saved_crtc(0), flip_pending(false),
+            flips(0), missed_vblanks(0), last_sequence(0), first_flip_time(0),
+            last_flip_time(0) {}
+
+        void add_flip(unsigned int sequence, uint64_t time);
+
+        NativeStateDRM* state;
+        std::string name;
+        /* Only set for the outputs mirroring the main one */
+        drmModeConnector* connector;
+        uint32_t crtc_id;
+        drmModeModeInfo mode;
+        drmModeCrtc* saved_crtc;
+        bool flip_pending;
+        unsigned int flips;
+        unsigned int missed_vblanks;
+        unsigned int last_sequence;
+        uint64_t first_flip_time;
+        uint64_t last_flip_time;
+    };
+
     static void page_flip_handler(int fd, unsigned int frame, unsigned int sec,
                                   unsigned int usec, void* data);
     static void fb_destroy_callback(gbm_bo* bo, void* data);
     static void quit_handler(int signum);
     static volatile std::sig_atomic_t should_quit_;
 
+    /* The property ids of a KMS object, by name */
+    typedef std::map<std::string, uint32_t> PropertyMap;
+
     DRMFBState* fb_get_from_bo(gbm_bo* bo);
     bool init_gbm();
     bool init();
+    bool init_render_node();
+    bool init_export();
+    void export_frame(gbm_bo* bo);
+    bool init_outputs();
+    bool flips_pending();
+    bool frame_is_late();
+    void log_outputs();
+    bool init_atomic();
+    uint32_t find_plane(int crtc_index, uint64_t type);
+    bool plane_supports_format(uint32_t plane_id, uint32_t format);
+    bool create_black_fb();
+    PropertyMap get_properties(uint32_t object_id, uint32_t object_type);
+    void add_plane_properties(drmModeAtomicReq* req, uint32_t plane_id,
+                              PropertyMap& props, uint32_t fb_id);
+    bool atomic_commit(uint32_t fb_id, int& out_fence_fd);
     void cleanup();
     int check_for_page_flip(int timeout_ms);
 
@@ -93,6 +163,38 @@ private:
     gbm_bo* presented_bo_;
     bool crtc_set_;
     bool use_async_flip_;
+    /* With --swap-mode=relaxed, the frames that missed a vblank flip async */
+    bool use_late_async_flip_;
+    /* Atomic modesetting state */
+    bool use_atomic_;
+    /* The plane the frames are scanned out from */
+    uint32_t plane_id_;
+    /* With --drm-overlay, the primary plane shows a black buffer */
+    uint32_t primary_plane_id_;
+    uint32_t black_fb_id_;
+    uint32_t black_handle_;
+    uint32_t mode_blob_id_;
+    PropertyMap connector_props_;
+    PropertyMap crtc_props_;
+    PropertyMap plane_props_;
+    PropertyMap primary_plane_props_;
+    /* The rendering fence of the pending buffer */
+    int pending_fence_fd_;
+    /* When the pending and flipped buffers were swapped, for --present-timing */
+    uint64_t pending_submit_time_;
+    uint64_t flipped_submit_time_;
+    PresentationList presentations_;
+    /* The time spent waiting in check_for_page_flip(), for --spike-threshold */
+    uint64_t flip_wait_us_;
+    /* With --drm-render-node, the frames are rendered but not shown */
+    bool render_node_;
+    int width_;
+    int height_;
+    /* The socket of the consumer of the frames, with --drm-export */
+    int export_fd_;
+    /* The output of connector_, and the ones mirroring it with --drm-outputs */
+    Output main_output_;
+    std::vector<Output*> mirrors_;
 };
 
 #endif /* GLMARK2_NATIVE_STATE_DRM_H_ */
@@ -0,0 +1,210 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "native-state-headless.h"
+#include "device-selection.h"
+#include "options.h"
+#include "log.h"
+
+#include <cstring>
+#include <sstream>
+#include <glad/egl.h>
+
+#ifndef EGL_EXT_device_drm
+#define EGL_DRM_DEVICE_FILE_EXT 0x3233
+#endif
+
+#ifndef EGL_EXT_device_drm_render_node
+#define EGL_DRM_RENDER_NODE_FILE_EXT 0x3377
+#endif
+
+/* EGL_EXT_device_enumeration and EGL_EXT_device_query */
+typedef EGLBoolean (GLAD_API_PTR *PFNEGLQUERYDEVICESEXTPROC)(EGLint max_devices, EGLDeviceEXT *devices, EGLint *num_devices);
+typedef const char *(GLAD_API_PTR *PFNEGLQUERYDEVICESTRINGEXTPROC)(EGLDeviceEXT device, EGLint name);
+
+volatile std::sig_atomic_t NativeStateHeadless::should_quit_(false);
+
+bool
+NativeStateHeadless::init_display()
+{
+    signal(SIGINT, &NativeStateHeadless::quit_handler);
+    signal(SIGTERM, &NativeStateHeadless::quit_handler);
+
+    std::vector<void*> devices;
+    std::vector<std::string> names;
+
+    if (!query_devices(devices, names)) {
+        if (!Options::device.empty())
+            Log::info("EGL devices can't be enumerated, ignoring --device\n");
+        Log::debug("Using the surfaceless platform\n");
+        return true;
+    }
+
+    size_t index = 0;
+    if (!Options::device.empty() &&
+        !DeviceSelection::find(names, Options::device, index))
+    {
+        Log::error("Invalid --device %s, there are %u EGL devices\n",
+                   Options::device.c_str(), static_cast<unsigned int>(devices.size()));
+        return false;
+    }
+
+    Log::debug("Using EGL device %u (%s)\n",
+               static_cast<unsigned int>(index), names[index].c_str());
+    device_ = devices[index];
+
+    return true;
+}
+
+void*
+NativeStateHeadless::display()
+{
+    /* GLStateEGL gets the display of the EGL device */
+    return device_;
+}
+
+bool
+NativeStateHeadless::create_window(WindowProperties const& properties)
+{
+    properties_ = properties;
+
+    /* There is no screen to fill, so use the default size */
+    if (properties_.fullscreen) {
+        Log::info("Ignoring --fullscreen without a display, using 800x600\n");
+        properties_.width = 800;
+        properties_.height = 600;
+    }
+
+    return true;
+}
+
+void*
+NativeStateHeadless::window(WindowProperties& properties)
+{
+    properties = properties_;
+    return 0;
+}
+
+void
+NativeStateHeadless::visible(bool /*v*/)
+{
+}
+
+bool
+NativeStateHeadless::should_quit()
+{
+    return should_quit_;
+}
+
+void
+NativeStateHeadless::flip()
+{
+}
+
+bool
+NativeStateHeadless::list_devices(std::vector<std::string>& devices)
+{
+    std::vector<void*> egl_devices;
+
+    return query_devices(egl_devices, devices);
+}
+
+void
+NativeStateHeadless::quit_handler(int /*signum*/)
+{
+    should_quit_ = true;
+}
+
+/*
+ * Enumerates the EGL devices, naming them after their DRM nodes, if they
+ * have any.
+ */
+bool
+NativeStateHeadless::query_devices(std::vector<void*>& devices,
+                                   std::vector<std::string>& names)
+{
+    if (!egl_lib_.handle() &&
+        !egl_lib_.open_from_alternatives({"libEGL.so", "libEGL.so.1"}))
+    {
+        return false;
+    }
+
+    PFNEGLQUERYSTRINGPROC egl_query_string =
+        reinterpret_cast<PFNEGLQUERYSTRINGPROC>(egl_lib_.load("eglQueryString"));
+    PFNEGLGETPROCADDRESSPROC egl_get_proc_address =
+        reinterpret_cast<PFNEGLGETPROCADDRESSPROC>(egl_lib_.load("eglGetProcAddress"));
+    if (!egl_query_string || !egl_get_proc_address)
+        return false;
+
+    const char *client_extensions = egl_query_string(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (!client_extensions ||
+        !strstr(client_extensions, "EGL_EXT_platform_device") ||
+        (!strstr(client_extensions, "EGL_EXT_device_enumeration") &&
+         !strstr(client_extensions, "EGL_EXT_device_base")))
+    {
+        return false;
+    }
+
+    PFNEGLQUERYDEVICESEXTPROC egl_query_devices =
+        reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(
+            egl_get_proc_address("eglQueryDevicesEXT"));
+    PFNEGLQUERYDEVICESTRINGEXTPROC egl_query_device_string =
+        reinterpret_cast<PFNEGLQUERYDEVICESTRINGEXTPROC>(
+            egl_get_proc_address("eglQueryDeviceStringEXT"));
+
+    EGLint num_devices = 0;
+    if (!egl_query_devices || !egl_query_devices(0, nullptr, &num_devices) ||
+        num_devices <= 0)
+    {
+        return false;
+    }
+
+    std::vector<EGLDeviceEXT> egl_devices(num_devices);
+    if (!egl_query_devices(num_devices, &egl_devices[0], &num_devices))
+        return false;
+    egl_devices.resize(num_devices);
+
+    for (size_t i = 0; i < egl_devices.size(); i++) {
+        const char *extensions = egl_query_device_string ?
+            egl_query_device_string(egl_devices[i], EGL_EXTENSIONS) : 0;
+        const char *node = 0;
+        std::string name;
+
+        if (extensions && strstr(extensions, "EGL_EXT_device_drm_render_node"))
+            node = egl_query_device_string(egl_devices[i], EGL_DRM_RENDER_NODE_FILE_EXT);
+        if (!node && extensions && strstr(extensions, "EGL_EXT_device_drm"))
+            node = egl_query_device_string(egl_devices[i], EGL_DRM_DEVICE_FILE_EXT);
+
+        if (node) {
+            name = node;
+        }
+        else if (extensions && strstr(extensions, "EGL_MESA_device_software")) {
+            name = "software";
+        }
+        else {
+            std::stringstream ss;
+            ss << "egl-device-" << i;
+            name = ss.str();
+        }
+
+        devices.push_back(egl_devices[i]);
+        names.push_back(name);
+    }
+
+    return true;
+}
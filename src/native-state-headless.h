@@ -0,0 +1,60 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_NATIVE_STATE_HEADLESS_H_
+#define GLMARK2_NATIVE_STATE_HEADLESS_H_
+
+#include <csignal>
+#include <string>
+#include <vector>
+
+#include "native-state.h"
+#include "shared-library.h"
+
+/*
+ * A native state without a display or a window, for rendering off-screen
+ * on an EGL device or the surfaceless platform.
+ */
+class NativeStateHeadless : public NativeState
+{
+public:
+    NativeStateHeadless() : device_(0) {}
+    ~NativeStateHeadless() {}
+
+    bool init_display();
+    void* display();
+    bool create_window(WindowProperties const& properties);
+    void* window(WindowProperties& properties);
+    void visible(bool v);
+    bool should_quit();
+    void flip();
+    bool list_devices(std::vector<std::string>& devices);
+
+private:
+    static void quit_handler(int signum);
+    static volatile std::sig_atomic_t should_quit_;
+
+    bool query_devices(std::vector<void*>& devices, std::vector<std::string>& names);
+
+    SharedLibrary egl_lib_;
+    /* The EGLDeviceEXT to render on, or 0 for the surfaceless platform */
+    void* device_;
+    WindowProperties properties_;
+};
+
+#endif /* GLMARK2_NATIVE_STATE_HEADLESS_H_ */
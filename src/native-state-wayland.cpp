@@ -21,9 +21,14 @@
  */
 
 #include "native-state-wayland.h"
+#include "device-selection.h"
 #include "log.h"
+#include "options.h"
+#include "util.h"
 
 #include <linux/input.h>
+#include <algorithm>
+#include <ctime>
 #include <cstring>
 #include <csignal>
 #include <unistd.h>
@@ -73,19 +78,47 @@ const struct wl_keyboard_listener NativeStateWayland::keyboard_listener_ = {
     NativeStateWayland::keyboard_handle_modifiers,
 };
 
+const struct wp_presentation_listener NativeStateWayland::presentation_listener_ = {
+    NativeStateWayland::presentation_handle_clock_id
+};
+
+const struct wp_presentation_feedback_listener NativeStateWayland::presentation_feedback_listener_ = {
+    NativeStateWayland::presentation_feedback_handle_sync_output,
+    NativeStateWayland::presentation_feedback_handle_presented,
+    NativeStateWayland::presentation_feedback_handle_discarded
+};
+
+const struct wl_callback_listener NativeStateWayland::frame_listener_ = {
+    NativeStateWayland::frame_handle_done
+};
+
 volatile bool NativeStateWayland::should_quit_ = false;
 
-NativeStateWayland::NativeStateWayland() : cursor_(0), display_(0), window_(0)
+NativeStateWayland::NativeStateWayland() : cursor_(0), display_(0), window_(0),
+    pending_feedback_(0)
 {
 }
 
 NativeStateWayland::~NativeStateWayland()
 {
+    for (FeedbacksVector::iterator it = feedbacks_.begin();
+         it != feedbacks_.end(); ++it) {
+        if ((*it)->feedback)
+            wp_presentation_feedback_destroy((*it)->feedback);
+        if ((*it)->callback)
+            wl_callback_destroy((*it)->callback);
+        delete *it;
+    }
+
     if (window_) {
         if (window_->xdg_toplevel)
             xdg_toplevel_destroy(window_->xdg_toplevel);
         if (window_->xdg_surface)
             xdg_surface_destroy(window_->xdg_surface);
+        if (window_->viewport)
+            wp_viewport_destroy(window_->viewport);
+        if (window_->tearing_control)
+            wp_tearing_control_v1_destroy(window_->tearing_control);
         if (window_->native)
             wl_egl_window_destroy(window_->native);
         if (window_->surface)
@@ -105,6 +138,12 @@ NativeStateWayland::~NativeStateWayland()
     if (display_) {
         if (display_->xdg_wm_base)
             xdg_wm_base_destroy(display_->xdg_wm_base);
+        if (display_->presentation)
+            wp_presentation_destroy(display_->presentation);
+        if (display_->viewporter)
+            wp_viewporter_destroy(display_->viewporter);
+        if (display_->tearing_control_manager)
+            wp_tearing_control_manager_v1_destroy(display_->tearing_control_manager);
 
         for (OutputsVector::iterator it = display_->outputs.begin();
              it != display_->outputs.end(); ++it) {
@@ -162,6 +201,21 @@ NativeStateWayland::registry_handle_global(void *data, struct wl_registry *regis
         that->display_->shm =
             static_cast<struct wl_shm *>(
                 wl_registry_bind(registry, id, &wl_shm_interface, 1));
+    } else if (strcmp(interface, "wp_presentation") == 0 && Options::present_timing) {
+        that->display_->presentation =
+            static_cast<struct wp_presentation *>(
+                wl_registry_bind(registry, id, &wp_presentation_interface, 1));
+        wp_presentation_add_listener(that->display_->presentation,
+                                     &presentation_listener_, that);
+    } else if (strcmp(interface, "wp_viewporter") == 0 && Options::render_scale < 1.0) {
+        that->display_->viewporter =
+            static_cast<struct wp_viewporter *>(
+                wl_registry_bind(registry, id, &wp_viewporter_interface, 1));
+    } else if (strcmp(interface, "wp_tearing_control_manager_v1") == 0 &&
+               Options::swap_mode == Options::SwapModeImmediate) {
+        that->display_->tearing_control_manager =
+            static_cast<struct wp_tearing_control_manager_v1 *>(
+                wl_registry_bind(registry, id, &wp_tearing_control_manager_v1_interface, 1));
     }
 }
 
@@ -262,11 +316,26 @@ NativeStateWayland::xdg_toplevel_handle_configure(void *data, struct xdg_topleve
     width = that->window_->properties.width;
     height = that->window_->properties.height;
 
+    /* Render to smaller buffers, which the compositor scales to the window */
+    int32_t buffer_width = width;
+    int32_t buffer_height = height;
+
+    if (that->window_->viewport) {
+        buffer_width = std::max(1, static_cast<int32_t>(width * Options::render_scale + 0.5));
+        buffer_height = std::max(1, static_cast<int32_t>(height * Options::render_scale + 0.5));
+        wp_viewport_set_destination(that->window_->viewport,
+                                    std::max(1, width / static_cast<int32_t>(scale)),
+                                    std::max(1, height / static_cast<int32_t>(scale)));
+    }
+
+    that->window_->buffer_width = buffer_width;
+    that->window_->buffer_height = buffer_height;
+
     if (!that->window_->native) {
         that->window_->native =
-            wl_egl_window_create(that->window_->surface, width, height);
+            wl_egl_window_create(that->window_->surface, buffer_width, buffer_height);
     } else {
-        wl_egl_window_resize(that->window_->native, width, height, 0, 0);
+        wl_egl_window_resize(that->window_->native, buffer_width, buffer_height, 0, 0);
     }
 
     struct wl_region *opaque_reqion = wl_compositor_create_region(that->display_->compositor);
@@ -274,7 +343,9 @@ NativeStateWayland::xdg_toplevel_handle_configure(void *data, struct xdg_topleve
     wl_surface_set_opaque_region(that->window_->surface, opaque_reqion);
     wl_region_destroy(opaque_reqion);
 
-    if (wl_surface_get_version(that->window_->surface) >=
+    /* The viewport destination sets the surface size instead */
+    if (!that->window_->viewport &&
+        wl_surface_get_version(that->window_->surface) >=
             WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION) {
         wl_surface_set_buffer_scale(that->window_->surface, scale);
     }
@@ -308,6 +379,9 @@ NativeStateWayland::init_display()
     sigaction(SIGINT, &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
 
+    if (!DeviceSelection::select_dri_prime_device())
+        return false;
+
     display_ = new struct my_display();
 
     if (!display_) {
@@ -352,6 +426,24 @@ NativeStateWayland::create_window(WindowProperties const& properties)
     window_->xdg_toplevel = xdg_surface_get_toplevel(window_->xdg_surface);
     xdg_toplevel_add_listener(window_->xdg_toplevel, &xdg_toplevel_listener_, this);
 
+    if (display_->viewporter) {
+        window_->viewport = wp_viewporter_get_viewport(display_->viewporter,
+                                                       window_->surface);
+    } else if (Options::render_scale < 1.0) {
+        Log::info("The compositor doesn't support wp_viewporter, ignoring --render-scale\n");
+    }
+
+    if (display_->tearing_control_manager) {
+        window_->tearing_control =
+            wp_tearing_control_manager_v1_get_tearing_control(display_->tearing_control_manager,
+                                                              window_->surface);
+        wp_tearing_control_v1_set_presentation_hint(window_->tearing_control,
+                                                    WP_TEARING_CONTROL_V1_PRESENTATION_HINT_ASYNC);
+    } else if (Options::swap_mode == Options::SwapModeImmediate) {
+        Log::info("Warning: The compositor doesn't support wp_tearing_control_v1,"
+                  " using the 'mailbox' swap mode instead of 'immediate'\n");
+    }
+
     xdg_toplevel_set_app_id(window_->xdg_toplevel, "com.github.glmark2.glmark2");
     xdg_toplevel_set_title(window_->xdg_toplevel, "glmark2");
     if (window_->properties.fullscreen && output)
@@ -372,12 +464,29 @@ NativeStateWayland::window(WindowProperties &properties)
 {
     if (window_) {
         properties = window_->properties;
+        properties.width = window_->buffer_width;
+        properties.height = window_->buffer_height;
         return window_->native;
     }
 
     return 0;
 }
 
+/*
+ * The compositor latches the latest frame at each vblank, unless the frames
+ * are allowed to tear, while the EGL swap interval decides whether the
+ * swaps wait for the frame callbacks.
+ */
+std::string
+NativeStateWayland::swap_mode()
+{
+    if (Options::swap_mode == Options::SwapModeFIFO ||
+        Options::swap_mode == Options::SwapModeRelaxed)
+        return "fifo";
+
+    return window_ && window_->tearing_control ? "immediate" : "mailbox";
+}
+
 void
 NativeStateWayland::visible(bool /*v*/)
 {
@@ -392,16 +501,148 @@ NativeStateWayland::should_quit()
 void
 NativeStateWayland::flip()
 {
+    /*
+     * A feedback applies to the next commit, so the one requested on the
+     * previous flip is for the frame that has just been swapped.
+     */
+    if (pending_feedback_) {
+        pending_feedback_->submit_time = Util::get_timestamp_us();
+        pending_feedback_ = 0;
+    }
+
+    if (Options::present_timing) {
+        struct my_feedback *feedback = new struct my_feedback();
+        feedback->state = this;
+        feedback->feedback = 0;
+        feedback->callback = 0;
+        feedback->submit_time = 0;
+
+        if (display_->presentation) {
+            feedback->feedback = wp_presentation_feedback(display_->presentation,
+                                                          window_->surface);
+            wp_presentation_feedback_add_listener(feedback->feedback,
+                                                  &presentation_feedback_listener_,
+                                                  feedback);
+        } else {
+            feedback->callback = wl_surface_frame(window_->surface);
+            wl_callback_add_listener(feedback->callback, &frame_listener_, feedback);
+        }
+
+        feedbacks_.push_back(feedback);
+        pending_feedback_ = feedback;
+    }
+
     int ret = wl_display_roundtrip(display_->display);
     should_quit_ = (ret == -1) || should_quit_;
 }
 
+void
+NativeStateWayland::take_presentations(PresentationList& list)
+{
+    list.insert(list.end(), presentations_.begin(), presentations_.end());
+    presentations_.clear();
+}
+
+bool
+NativeStateWayland::list_devices(std::vector<std::string>& devices)
+{
+    return DeviceSelection::list_dri_prime_devices(devices);
+}
+
 void
 NativeStateWayland::quit_handler(int /*signum*/)
 {
     should_quit_ = true;
 }
 
+void
+NativeStateWayland::presentation_handle_clock_id(void *data,
+                                                 struct wp_presentation * /*presentation*/,
+                                                 uint32_t clk_id)
+{
+    NativeStateWayland *that = static_cast<NativeStateWayland *>(data);
+    that->display_->presentation_clock_monotonic = (clk_id == CLOCK_MONOTONIC);
+}
+
+void
+NativeStateWayland::presentation_feedback_handle_sync_output(void * /*data*/,
+                                                             struct wp_presentation_feedback * /*feedback*/,
+                                                             struct wl_output * /*output*/)
+{
+}
+
+void
+NativeStateWayland::presentation_feedback_handle_presented(void *data,
+                                                           struct wp_presentation_feedback * /*feedback*/,
+                                                           uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                                           uint32_t tv_nsec, uint32_t refresh,
+                                                           uint32_t seq_hi, uint32_t seq_lo,
+                                                           uint32_t flags)
+{
+    struct my_feedback *feedback = static_cast<struct my_feedback *>(data);
+    NativeStateWayland *that = feedback->state;
+    uint64_t sec = (static_cast<uint64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+    Presentation presentation;
+
+    /* The latency can only be measured in the clock of Util::get_timestamp_us() */
+    if (that->display_->presentation_clock_monotonic)
+        presentation.submit_time = feedback->submit_time;
+    presentation.present_time = sec * 1000000 + tv_nsec / 1000;
+    presentation.sequence = (static_cast<uint64_t>(seq_hi) << 32) | seq_lo;
+    presentation.refresh = refresh / 1000;
+    presentation.mode = (flags & WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY) ?
+                        Presentation::ModeFlip : Presentation::ModeCopy;
+    that->presentations_.push_back(presentation);
+
+    that->finish_feedback(feedback);
+}
+
+void
+NativeStateWayland::presentation_feedback_handle_discarded(void *data,
+                                                           struct wp_presentation_feedback * /*feedback*/)
+{
+    struct my_feedback *feedback = static_cast<struct my_feedback *>(data);
+    feedback->state->finish_feedback(feedback);
+}
+
+/*
+ * The compositor sends the frame callback when it's a good time to draw the
+ * next frame, usually right after presenting the frame. The time it is
+ * received approximates the present time, after the dispatching delay.
+ */
+void
+NativeStateWayland::frame_handle_done(void *data, struct wl_callback * /*callback*/,
+                                      uint32_t /*time*/)
+{
+    struct my_feedback *feedback = static_cast<struct my_feedback *>(data);
+    NativeStateWayland *that = feedback->state;
+    Presentation presentation;
+
+    presentation.submit_time = feedback->submit_time;
+    presentation.present_time = Util::get_timestamp_us();
+    if (!that->display_->outputs.empty() && that->display_->outputs.at(0)->refresh > 0)
+        presentation.refresh = 1000000000ULL / that->display_->outputs.at(0)->refresh;
+    that->presentations_.push_back(presentation);
+
+    that->finish_feedback(feedback);
+}
+
+void
+NativeStateWayland::finish_feedback(struct my_feedback *feedback)
+{
+    FeedbacksVector::iterator it = std::find(feedbacks_.begin(), feedbacks_.end(), feedback);
+    if (it != feedbacks_.end())
+        feedbacks_.erase(it);
+    if (pending_feedback_ == feedback)
+        pending_feedback_ = 0;
+
+    if (feedback->feedback)
+        wp_presentation_feedback_destroy(feedback->feedback);
+    if (feedback->callback)
+        wl_callback_destroy(feedback->callback);
+    delete feedback;
+}
+
 void
 NativeStateWayland::seat_handle_capabilities(void *data, struct wl_seat *seat, uint32_t caps)
 {
@@ -28,6 +28,9 @@
 #include <wayland-egl.h>
 #include <wayland-cursor.h>
 #include "xdg-shell-client-protocol.h"
+#include "presentation-time-client-protocol.h"
+#include "viewporter-client-protocol.h"
+#include "tearing-control-client-protocol.h"
 
 #include "native-state.h"
 
@@ -44,6 +47,9 @@ public:
     void visible(bool v);
     bool should_quit();
     void flip();
+    void take_presentations(PresentationList& list);
+    bool list_devices(std::vector<std::string>& devices);
+    std::string swap_mode();
 
 private:
     static void quit_handler(int signum);
@@ -56,6 +62,9 @@ private:
     static const struct wl_seat_listener seat_listener_;
     static const struct wl_pointer_listener pointer_listener_;
     static const struct wl_keyboard_listener keyboard_listener_;
+    static const struct wp_presentation_listener presentation_listener_;
+    static const struct wp_presentation_feedback_listener presentation_feedback_listener_;
+    static const struct wl_callback_listener frame_listener_;
 
     static void
     registry_handle_global(void *data, struct wl_registry *registry,
@@ -130,6 +139,22 @@ private:
                                           uint32_t serial, uint32_t mods_depressed,
                                           uint32_t mods_latched, uint32_t mods_locked,
                                           uint32_t group);
+    static void presentation_handle_clock_id(void *data,
+                                             struct wp_presentation *presentation,
+                                             uint32_t clk_id);
+    static void presentation_feedback_handle_sync_output(void *data,
+                                                         struct wp_presentation_feedback *feedback,
+                                                         struct wl_output *output);
+    static void presentation_feedback_handle_presented(void *data,
+                                                       struct wp_presentation_feedback *feedback,
+                                                       uint32_t tv_sec_hi, uint32_t tv_sec_lo,
+                                                       uint32_t tv_nsec, uint32_t refresh,
+                                                       uint32_t seq_hi, uint32_t seq_lo,
+                                                       uint32_t flags);
+    static void presentation_feedback_handle_discarded(void *data,
+                                                       struct wp_presentation_feedback *feedback);
+    static void frame_handle_done(void *data, struct wl_callback *callback,
+                                  uint32_t time);
     void setup_cursor();
 
     struct my_output {
@@ -156,6 +181,10 @@ private:
         wl_pointer *pointer;
         wl_keyboard *keyboard;
         struct xdg_wm_base *xdg_wm_base;
+        struct wp_presentation *presentation;
+        bool presentation_clock_monotonic;
+        struct wp_viewporter *viewporter;
+        struct wp_tearing_control_manager_v1 *tearing_control_manager;
         OutputsVector outputs;
     } *display_;
 
@@ -166,8 +195,30 @@ private:
         struct wl_egl_window *native;
         struct xdg_surface *xdg_surface;
         struct xdg_toplevel *xdg_toplevel;
+        /* With --render-scale, the buffers are scaled to the window size */
+        struct wp_viewport *viewport;
+        /* With --swap-mode=immediate, the compositor may let the frames tear */
+        struct wp_tearing_control_v1 *tearing_control;
+        int32_t buffer_width, buffer_height;
     } *window_;
 
+    struct my_feedback {
+        NativeStateWayland *state;
+        /* A frame callback is used without wp_presentation */
+        struct wp_presentation_feedback *feedback;
+        struct wl_callback *callback;
+        uint64_t submit_time;
+    };
+
+    typedef std::vector<struct my_feedback *> FeedbacksVector;
+
+    void finish_feedback(struct my_feedback *feedback);
+
+    /* The feedback for the next commit, whose submit time is not set yet */
+    struct my_feedback *pending_feedback_;
+    FeedbacksVector feedbacks_;
+    PresentationList presentations_;
+
     static volatile bool should_quit_;
 };
 
@@ -21,11 +21,50 @@
  *  Alexandros Frantzis
  */
 #include "native-state-x11.h"
+#include "device-selection.h"
 #include "log.h"
+#include "options.h"
+#include "util.h"
 
+#include <X11/Xlibint.h>
 #include <X11/Xutil.h>
 #include <X11/keysym.h>
 #include <X11/Xatom.h>
+#include <X11/extensions/presentproto.h>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * The frames swapped before the Present events arrive, which are never
+ * more than a few unless the swaps don't go through Present at all.
+ */
+static const size_t max_pending_presents = 16;
+
+/*
+ * Keeps a copy of the Present events, so that XGetEventData() can return
+ * them. There is no libXpresent dependency, so the wire format is used
+ * as is.
+ */
+static Bool
+present_wire_to_cookie(Display* dpy, XGenericEventCookie* cookie, xEvent* event)
+{
+    xGenericEvent* ge = reinterpret_cast<xGenericEvent*>(event);
+    size_t size = sizeof(xEvent) + ge->length * 4;
+
+    cookie->type = ge->type & 0x7f;
+    cookie->serial = _XSetLastRequestRead(dpy, reinterpret_cast<xGenericReply*>(event));
+    cookie->send_event = (ge->type & 0x80) != 0;
+    cookie->display = dpy;
+    cookie->extension = ge->extension;
+    cookie->evtype = ge->evtype;
+    cookie->data = malloc(size);
+    if (!cookie->data)
+        return False;
+
+    memcpy(cookie->data, event, size);
+
+    return True;
+}
 
 /******************
  * Public methods *
@@ -45,12 +84,21 @@ NativeStateX11::~NativeStateX11()
 bool
 NativeStateX11::init_display()
 {
+    if (!DeviceSelection::select_dri_prime_device())
+        return false;
+
     if (!xdpy_)
         xdpy_ = XOpenDisplay(NULL);
 
     return (xdpy_ != 0);
 }
 
+bool
+NativeStateX11::list_devices(std::vector<std::string>& devices)
+{
+    return DeviceSelection::list_dri_prime_devices(devices);
+}
+
 void*
 NativeStateX11::display()
 {
@@ -170,6 +218,11 @@ NativeStateX11::create_window(WindowProperties const& properties)
     Atom wmDelete = XInternAtom(xdpy_, "WM_DELETE_WINDOW", True);
     XSetWMProtocols(xdpy_, xwin_, &wmDelete, 1);
 
+    if (Options::present_timing) {
+        init_present();
+        select_present_input();
+    }
+
     return true;
 }
 
@@ -192,19 +245,156 @@ NativeStateX11::should_quit()
 {
     XEvent event;
 
-    if (!XPending(xdpy_))
-        return false;
-
-    XNextEvent(xdpy_, &event);
+    /* There is a Present event for every frame with --present-timing */
+    while (XPending(xdpy_)) {
+        XNextEvent(xdpy_, &event);
 
-    if (event.type == KeyPress) {
-        if (XLookupKeysym(&event.xkey, 0) == XK_Escape)
+        if (event.type == KeyPress) {
+            if (XLookupKeysym(&event.xkey, 0) == XK_Escape)
+                return true;
+        }
+        else if (event.type == ClientMessage) {
+            /* Window Delete event from window manager */
             return true;
-    }
-    else if (event.type == ClientMessage) {
-        /* Window Delete event from window manager */
-        return true;
+        }
+        else if (event.type == GenericEvent &&
+                 event.xcookie.extension == present_opcode_ &&
+                 XGetEventData(xdpy_, &event.xcookie))
+        {
+            handle_present_event(event.xcookie);
+            XFreeEventData(xdpy_, &event.xcookie);
+        }
     }
 
     return false;
 }
+
+void
+NativeStateX11::flip()
+{
+    if (present_opcode_ < 0)
+        return;
+
+    submit_times_.push_back(Util::get_timestamp_us());
+    if (submit_times_.size() > max_pending_presents)
+        submit_times_.pop_front();
+}
+
+void
+NativeStateX11::take_presentations(PresentationList& list)
+{
+    list.insert(list.end(), presentations_.begin(), presentations_.end());
+    presentations_.clear();
+}
+
+/********************
+ * Private methods *
+ ********************/
+
+/*
+ * Sets up the reception of the Present events, through which the X server
+ * reports when and how the frames swapped with DRI3 are presented.
+ */
+void
+NativeStateX11::init_present()
+{
+    if (present_opcode_ >= 0)
+        return;
+
+    int opcode;
+    int event_base;
+    int error_base;
+
+    if (!XQueryExtension(xdpy_, "Present", &opcode, &event_base, &error_base)) {
+        Log::info("Warning: The X server doesn't support the Present extension,"
+                  " the present times are not available\n");
+        return;
+    }
+
+    /* The Xlib request macros use dpy */
+    Display* dpy = xdpy_;
+    xPresentQueryVersionReq* req;
+    xPresentQueryVersionReply rep;
+
+    LockDisplay(dpy);
+    GetReq(PresentQueryVersion, req);
+    req->reqType = opcode;
+    req->presentReqType = X_PresentQueryVersion;
+    req->majorVersion = 1;
+    req->minorVersion = 0;
+    Status status = _XReply(dpy, reinterpret_cast<xReply*>(&rep), 0, xTrue);
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    if (!status) {
+        Log::info("Warning: Failed to query the version of the Present extension,"
+                  " the present times are not available\n");
+        return;
+    }
+
+    Log::debug("Using the Present extension %u.%u for presentation feedback\n",
+               rep.majorVersion, rep.minorVersion);
+
+    XESetWireToEventCookie(xdpy_, opcode, present_wire_to_cookie);
+    present_opcode_ = opcode;
+}
+
+void
+NativeStateX11::select_present_input()
+{
+    if (present_opcode_ < 0)
+        return;
+
+    Display* dpy = xdpy_;
+    xPresentSelectInputReq* req;
+    XID eid = XAllocID(dpy);
+
+    LockDisplay(dpy);
+    GetReq(PresentSelectInput, req);
+    req->reqType = present_opcode_;
+    req->presentReqType = X_PresentSelectInput;
+    req->eid = eid;
+    req->window = xwin_;
+    req->eventMask = PresentCompleteNotifyMask;
+    UnlockDisplay(dpy);
+    SyncHandle();
+
+    submit_times_.clear();
+}
+
+/*
+ * The UST of the X server is CLOCK_MONOTONIC in microseconds, like
+ * Util::get_timestamp_us(). The mode tells whether the frame was flipped
+ * to the display or copied, e.g. into the window pixmap of a compositor.
+ */
+void
+NativeStateX11::handle_present_event(XGenericEventCookie& cookie)
+{
+    const xPresentCompleteNotify* event =
+        static_cast<const xPresentCompleteNotify*>(cookie.data);
+
+    /* Only the swaps of the GL driver are of interest, not its MSC waits */
+    if (cookie.evtype != PresentCompleteNotify ||
+        event->kind != PresentCompleteKindPixmap)
+    {
+        return;
+    }
+
+    uint64_t submit_time = 0;
+    if (!submit_times_.empty()) {
+        submit_time = submit_times_.front();
+        submit_times_.pop_front();
+    }
+
+    /* A skipped frame was replaced by a later one before being shown */
+    if (event->mode == PresentCompleteModeSkip)
+        return;
+
+    Presentation presentation;
+    presentation.submit_time = submit_time;
+    presentation.present_time = event->ust;
+    presentation.sequence = event->msc;
+    presentation.mode = event->mode == PresentCompleteModeFlip ?
+                        Presentation::ModeFlip : Presentation::ModeCopy;
+    presentations_.push_back(presentation);
+}
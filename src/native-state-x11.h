@@ -25,11 +25,12 @@
 
 #include "native-state.h"
 #include <X11/Xlib.h>
+#include <deque>
 
 class NativeStateX11 : public NativeState
 {
 public:
-    NativeStateX11() : xdpy_(0), xwin_(0), properties_() {}
+    NativeStateX11() : xdpy_(0), xwin_(0), properties_(), present_opcode_(-1) {}
     ~NativeStateX11();
 
     bool init_display();
@@ -38,14 +39,25 @@ public:
     void* window(WindowProperties& properties);
     void visible(bool v);
     bool should_quit();
-    void flip() { }
+    void flip();
+    void take_presentations(PresentationList& list);
+    bool list_devices(std::vector<std::string>& devices);
 
 private:
+    void init_present();
+    void select_present_input();
+    void handle_present_event(XGenericEventCookie& cookie);
+
     /** The X display associated with this canvas. */
     Display* xdpy_;
     /** The X window associated with this canvas. */
     Window xwin_;
     WindowProperties properties_;
+    /** The major opcode of the Present extension, -1 if not used. */
+    int present_opcode_;
+    /** When the frames still waiting for their presents were swapped. */
+    std::deque<uint64_t> submit_times_;
+    PresentationList presentations_;
 };
 
 #endif /* GLMARK2_NATIVE_STATE_X11_H_ */
@@ -23,6 +23,10 @@
 #define GLMARK2_NATIVE_STATE_H_
 
 #include <stdint.h>
+#include <string>
+#include <vector>
+#include "dma-buf.h"
+#include "presentation.h"
 
 class NativeState
 {
@@ -65,6 +69,55 @@ public:
 
     /* Flips the display */
     virtual void flip() = 0;
+
+    /* Whether flip_with_fence() is supported */
+    virtual bool supports_fences() { return false; }
+
+    /*
+     * Flips the display once a native fence fd signals, taking ownership
+     * of the fd. Returns a native fence fd that signals once the flip has
+     * been applied, or -1.
+     */
+    virtual int flip_with_fence(int /* fence_fd */) { flip(); return -1; }
+
+    /*
+     * Moves the timings of the frames presented since the last call to the
+     * list, with --present-timing, if the native system reports them.
+     */
+    virtual void take_presentations(PresentationList& /* list */) {}
+
+    /*
+     * Gets the time spent waiting for page flips since the last call, in
+     * microseconds, if the native system waits for them itself.
+     */
+    virtual uint64_t take_flip_wait_us() { return 0; }
+
+    /*
+     * Gets the names of the devices that --device can select, in the order
+     * of their indices. Returns false if the devices can't be listed.
+     */
+    virtual bool list_devices(std::vector<std::string>& /* devices */) { return false; }
+
+    /*
+     * Gets the --swap-mode in effect, if the native system rather than the
+     * GL system decides it, or an empty string.
+     */
+    virtual std::string swap_mode() { return std::string(); }
+
+    /*
+     * Allocates a linear buffer of 1 or 4 bytes per pixel that can be
+     * shared through a dma-buf fd, filled with the tightly packed rows of
+     * data. Returns false if dma-bufs can't be allocated.
+     */
+    virtual bool create_dma_buf(unsigned int /* width */, unsigned int /* height */,
+                                unsigned int /* cpp */, const void* /* data */,
+                                DmaBuf& /* buf */)
+    {
+        return false;
+    }
+
+    /* Frees a buffer allocated by create_dma_buf() */
+    virtual void destroy_dma_buf(DmaBuf& /* buf */) {}
 };
 
 #endif /* GLMARK2_NATIVE_STATE_H_ */
@@ -31,38 +31,206 @@
 std::vector<std::string> Options::benchmarks;
 std::vector<std::string> Options::benchmark_files;
 bool Options::validate = false;
+std::string Options::reference_dir;
+unsigned int Options::reference_tolerance = 8;
+double Options::reference_psnr = 30.0;
+double Options::reference_ssim = 0.0;
 std::string Options::data_path = std::string(GLMARK_DATA_PATH);
+std::string Options::data_pack;
 Options::FrameEnd Options::frame_end = Options::FrameEndDefault;
+unsigned int Options::frames_in_flight = 2;
 Options::SwapMode Options::swap_mode = Options::SwapModeDefault;
+bool Options::drm_legacy = false;
+bool Options::drm_overlay = false;
+bool Options::drm_render_node = false;
+std::string Options::drm_export;
+std::string Options::drm_outputs;
+double Options::render_scale = 1.0;
+double Options::dynamic_resolution = 0.0;
+bool Options::win32_flip_model = false;
+bool Options::android_native_loop = false;
+bool Options::android_performance_hint = false;
+std::string Options::device;
+bool Options::all_devices = false;
 std::pair<int,int> Options::size(800, 600);
+std::vector<std::pair<int,int> > Options::size_sweep;
 bool Options::list_scenes = false;
 bool Options::show_all_options = false;
 bool Options::show_debug = false;
 bool Options::show_version = false;
 bool Options::show_help = false;
+bool Options::async_log = false;
 bool Options::reuse_context = false;
+unsigned int Options::context_pool = 0;
+bool Options::fork_benchmarks = false;
 bool Options::run_forever = false;
+unsigned int Options::repeat = 1;
+Options::RepeatOrder Options::repeat_order = Options::RepeatOrderSequential;
+double Options::soak_duration = 0.0;
+double Options::soak_interval = 5.0;
+std::string Options::metrics;
 bool Options::annotate = false;
 bool Options::offscreen = false;
+unsigned int Options::offscreen_buffers = 1;
 GLVisualConfig Options::visual_config;
+std::string Options::results_file;
+bool Options::gpu_timing = false;
+bool Options::pipeline_stats = false;
+bool Options::present_timing = false;
+double Options::spike_threshold = 0.0;
+bool Options::pipelined = false;
+std::string Options::co_runners;
+std::string Options::bursts;
+Options::ContextPriority Options::context_priority = Options::ContextPriorityDefault;
+bool Options::invalidate = false;
+unsigned int Options::msaa_samples = 0;
+Options::MsaaResolve Options::msaa_resolve = Options::MsaaResolveAuto;
+float Options::sample_shading = 0.0f;
+Options::HdrFormat Options::hdr_format = Options::HdrFormatNone;
+bool Options::hdr_bloom = false;
+Options::ToneMap Options::tone_map = Options::ToneMapACES;
+std::string Options::post_process;
+StateTracker::Mode Options::state_tracking = StateTracker::ModeOff;
+bool Options::profile_gl_calls = false;
+std::string Options::flush_points;
+bool Options::count_allocations = false;
+bool Options::startup_report = false;
+std::string Options::trace_file;
+bool Options::debug_markers = false;
+bool Options::perf_counters = false;
+std::string Options::gpu_counters;
+std::string Options::cpu_affinity;
+std::string Options::worker_affinity;
+int Options::realtime_priority = 0;
+int Options::nice = 0;
+bool Options::lock_memory = false;
+bool Options::lock_clocks = false;
+std::string Options::compare_to;
+double Options::regression_threshold = 5.0;
+std::string Options::history_file;
+std::string Options::history;
+Options::ScoreModel Options::score_model = Options::ScoreModelArithmetic;
+std::string Options::score_reference;
+bool Options::bottleneck_analysis = false;
+std::string Options::explore;
+std::string Options::serve;
+std::string Options::record;
+unsigned int Options::record_frames = 100;
+std::string Options::replay;
+double Options::replay_duration = 10.0;
+double Options::target_fps = 0.0;
+double Options::fixed_timestep = 0.0;
+bool Options::energy = false;
+bool Options::memory_usage = false;
+bool Options::single_buffer = false;
+unsigned int Options::capture_interval = 0;
+std::string Options::capture_dir(".");
+std::string Options::capture_format("png");
+std::string Options::shader_cache;
+bool Options::precompile_shaders = false;
+std::string Options::model_cache;
 
 static struct option long_options[] = {
     {"annotate", 0, 0, 0},
     {"benchmark", 1, 0, 0},
     {"benchmark-file", 1, 0, 0},
     {"validate", 0, 0, 0},
+    {"reference-dir", 1, 0, 0},
+    {"reference-tolerance", 1, 0, 0},
+    {"reference-psnr", 1, 0, 0},
+    {"reference-ssim", 1, 0, 0},
     {"data-path", 1, 0, 0},
+    {"data-pack", 1, 0, 0},
     {"frame-end", 1, 0, 0},
+    {"frames-in-flight", 1, 0, 0},
     {"swap-mode", 1, 0, 0},
+    {"drm-legacy", 0, 0, 0},
+    {"drm-overlay", 0, 0, 0},
+    {"drm-render-node", 0, 0, 0},
+    {"drm-export", 1, 0, 0},
+    {"drm-outputs", 1, 0, 0},
+    {"render-scale", 1, 0, 0},
+    {"dynamic-resolution", 1, 0, 0},
+    {"win32-flip-model", 0, 0, 0},
+    {"android-native-loop", 0, 0, 0},
+    {"android-performance-hint", 0, 0, 0},
+    {"device", 1, 0, 0},
+    {"all-devices", 0, 0, 0},
     {"off-screen", 0, 0, 0},
+    {"off-screen-buffers", 1, 0, 0},
     {"visual-config", 1, 0, 0},
     {"reuse-context", 0, 0, 0},
+    {"context-pool", 1, 0, 0},
+    {"fork-benchmarks", 0, 0, 0},
     {"run-forever", 0, 0, 0},
+    {"repeat", 1, 0, 0},
+    {"repeat-order", 1, 0, 0},
+    {"soak", 1, 0, 0},
+    {"soak-interval", 1, 0, 0},
+    {"metrics", 1, 0, 0},
+    {"results-file", 1, 0, 0},
+    {"gpu-timing", 0, 0, 0},
+    {"pipeline-stats", 0, 0, 0},
+    {"present-timing", 0, 0, 0},
+    {"spike-threshold", 1, 0, 0},
+    {"pipelined", 0, 0, 0},
+    {"co-runners", 1, 0, 0},
+    {"bursts", 1, 0, 0},
+    {"context-priority", 1, 0, 0},
+    {"invalidate", 0, 0, 0},
+    {"msaa", 1, 0, 0},
+    {"msaa-resolve", 1, 0, 0},
+    {"sample-shading", 1, 0, 0},
+    {"hdr", 1, 0, 0},
+    {"hdr-bloom", 0, 0, 0},
+    {"tone-map", 1, 0, 0},
+    {"post-process", 1, 0, 0},
+    {"state-tracking", 1, 0, 0},
+    {"profile-gl-calls", 0, 0, 0},
+    {"flush-points", 1, 0, 0},
+    {"count-allocations", 0, 0, 0},
+    {"startup-report", 0, 0, 0},
+    {"trace", 1, 0, 0},
+    {"debug-markers", 0, 0, 0},
+    {"perf-counters", 0, 0, 0},
+    {"gpu-counters", 1, 0, 0},
+    {"cpu-affinity", 1, 0, 0},
+    {"worker-affinity", 1, 0, 0},
+    {"realtime-priority", 1, 0, 0},
+    {"nice", 1, 0, 0},
+    {"lock-memory", 0, 0, 0},
+    {"lock-clocks", 0, 0, 0},
+    {"compare-to", 1, 0, 0},
+    {"regression-threshold", 1, 0, 0},
+    {"history-file", 1, 0, 0},
+    {"history", 1, 0, 0},
+    {"score-model", 1, 0, 0},
+    {"score-reference", 1, 0, 0},
+    {"bottleneck-analysis", 0, 0, 0},
+    {"explore", 1, 0, 0},
+    {"serve", 1, 0, 0},
+    {"record", 1, 0, 0},
+    {"record-frames", 1, 0, 0},
+    {"replay", 1, 0, 0},
+    {"replay-duration", 1, 0, 0},
+    {"target-fps", 1, 0, 0},
+    {"fixed-timestep", 1, 0, 0},
+    {"energy", 0, 0, 0},
+    {"memory-usage", 0, 0, 0},
+    {"single-buffer", 0, 0, 0},
+    {"capture-interval", 1, 0, 0},
+    {"capture-dir", 1, 0, 0},
+    {"capture-format", 1, 0, 0},
+    {"shader-cache", 1, 0, 0},
+    {"precompile-shaders", 0, 0, 0},
+    {"model-cache", 1, 0, 0},
     {"size", 1, 0, 0},
+    {"size-sweep", 1, 0, 0},
     {"fullscreen", 0, 0, 0},
     {"list-scenes", 0, 0, 0},
     {"show-all-options", 0, 0, 0},
     {"debug", 0, 0, 0},
+    {"async-log", 0, 0, 0},
     {"version", 0, 0, 0},
     {"help", 0, 0, 0},
     {0, 0, 0, 0}
@@ -92,6 +260,29 @@ parse_size(const std::string &str, std::pair<int,int> &size)
         size.second = size.first;
 }
 
+/**
+ * Parses a comma separated list of size strings of the form WxH
+ *
+ * @param str the string to parse
+ * @param sizes the parsed sizes
+ */
+static void
+parse_size_list(const std::string &str, std::vector<std::pair<int,int> > &sizes)
+{
+    std::vector<std::string> elems;
+    Util::split(str, ',', elems, Util::SplitModeNormal);
+
+    sizes.clear();
+    for (std::vector<std::string>::const_iterator iter = elems.begin();
+         iter != elems.end();
+         iter++)
+    {
+        std::pair<int,int> size;
+        parse_size(*iter, size);
+        sizes.push_back(size);
+    }
+}
+
 /**
  * Parses a frame-end method string
  *
@@ -110,6 +301,10 @@ frame_end_from_str(const std::string &str)
         m = Options::FrameEndFinish;
     else if (str == "readpixels")
         m = Options::FrameEndReadPixels;
+    else if (str == "readpixels-async")
+        m = Options::FrameEndReadPixelsAsync;
+    else if (str == "fence")
+        m = Options::FrameEndFence;
     else if (str == "none")
         m = Options::FrameEndNone;
 
@@ -134,6 +329,150 @@ swap_mode_from_str(const std::string &str)
         m = Options::SwapModeMailbox;
     else if (str == "fifo")
         m = Options::SwapModeFIFO;
+    else if (str == "relaxed")
+        m = Options::SwapModeRelaxed;
+
+    return m;
+}
+
+/**
+ * Parses a repeat order string
+ *
+ * @param str the string to parse
+ *
+ * @return the parsed repeat order
+ */
+static Options::RepeatOrder
+repeat_order_from_str(const std::string &str)
+{
+    Options::RepeatOrder o = Options::RepeatOrderSequential;
+
+    if (str == "interleaved")
+        o = Options::RepeatOrderInterleaved;
+    else if (str == "shuffled")
+        o = Options::RepeatOrderShuffled;
+
+    return o;
+}
+
+/**
+ * Parses a score model string
+ *
+ * @param str the string to parse
+ *
+ * @return the parsed score model
+ */
+static Options::ScoreModel
+score_model_from_str(const std::string &str)
+{
+    Options::ScoreModel m = Options::ScoreModelArithmetic;
+
+    if (str == "geometric")
+        m = Options::ScoreModelGeometric;
+    else if (str == "frame-time")
+        m = Options::ScoreModelFrameTime;
+    else if (str == "category")
+        m = Options::ScoreModelCategory;
+
+    return m;
+}
+
+/**
+ * Parses an MSAA resolve method string
+ *
+ * @param str the string to parse
+ *
+ * @return the parsed MSAA resolve method
+ */
+static Options::MsaaResolve
+msaa_resolve_from_str(const std::string &str)
+{
+    Options::MsaaResolve m = Options::MsaaResolveAuto;
+
+    if (str == "blit")
+        m = Options::MsaaResolveBlit;
+    else if (str == "implicit")
+        m = Options::MsaaResolveImplicit;
+
+    return m;
+}
+
+/**
+ * Parses a context priority string
+ *
+ * @param str the string to parse
+ *
+ * @return the parsed context priority
+ */
+static Options::ContextPriority
+context_priority_from_str(const std::string &str)
+{
+    Options::ContextPriority p = Options::ContextPriorityDefault;
+
+    if (str == "low")
+        p = Options::ContextPriorityLow;
+    else if (str == "medium")
+        p = Options::ContextPriorityMedium;
+    else if (str == "high")
+        p = Options::ContextPriorityHigh;
+
+    return p;
+}
+
+/**
+ * Parses an HDR render target format string
+ *
+ * @param str the string to parse
+ *
+ * @return the parsed HDR render target format
+ */
+static Options::HdrFormat
+hdr_format_from_str(const std::string &str)
+{
+    Options::HdrFormat f = Options::HdrFormatNone;
+
+    if (str == "rgba16f")
+        f = Options::HdrFormatRGBA16F;
+    else if (str == "r11g11b10f")
+        f = Options::HdrFormatR11G11B10F;
+
+    return f;
+}
+
+/**
+ * Parses a tone mapping operator string
+ *
+ * @param str the string to parse
+ *
+ * @return the parsed tone mapping operator
+ */
+static Options::ToneMap
+tone_map_from_str(const std::string &str)
+{
+    Options::ToneMap t = Options::ToneMapACES;
+
+    if (str == "reinhard")
+        t = Options::ToneMapReinhard;
+
+    return t;
+}
+
+/**
+ * Parses a state tracking mode string
+ *
+ * @param str the string to parse
+ *
+ * @return the parsed state tracking mode
+ */
+static StateTracker::Mode
+state_tracking_from_str(const std::string &str)
+{
+    StateTracker::Mode m = StateTracker::ModeOff;
+
+    if (str == "count")
+        m = StateTracker::ModeCount;
+    else if (str == "filter")
+        m = StateTracker::ModeFilter;
 
     return m;
 }
@@ -151,30 +490,264 @@ Options::print_help()
            "                         (the option can be used multiple times)\n"
            "      --validate         Run a quick output validation test instead of \n"
            "                         running the benchmarks\n"
+           "      --reference-dir DIR\n"
+           "                         With --validate, compare each frame with the\n"
+           "                         reference image in DIR, recording it if missing\n"
+           "      --reference-tolerance N\n"
+           "                         The difference a channel may have before its\n"
+           "                         pixel counts as different (default: 8)\n"
+           "      --reference-psnr DB\n"
+           "                         The minimum PSNR to match a reference (default: 30)\n"
+           "      --reference-ssim MIN\n"
+           "                         The minimum SSIM to match a reference\n"
+           "                         (default: 0, not computed)\n"
            "      --data-path PATH   Path to glmark2 models, shaders and textures\n"
            "                         Default: " GLMARK_DATA_PATH "\n"
-           "      --frame-end METHOD How to end a frame [default,none,swap,finish,readpixels]\n"
-           "      --swap-mode MODE   How to swap a frame, all modes supported only in the DRM\n"
-           "                         flavor, 'fifo' available in all flavors to force vsync\n"
-           "                         [default,immediate,mailbox,fifo]\n"
+           "      --data-pack FILE   The data of --data-path packed in a single file,\n"
+           "                         or 'none' to open each file (default:\n"
+           "                         glmark2-data.pack in the data path, if present)\n"
+           "      --frame-end METHOD How to end a frame [default,none,swap,finish,\n"
+           "                         readpixels,readpixels-async,fence]\n"
+           "      --frames-in-flight N\n"
+           "                         The number of frames the GPU may lag behind with\n"
+           "                         --frame-end fence (default: 2)\n"
+           "      --swap-mode MODE   How to swap a frame, falling back to the closest mode\n"
+           "                         the flavor supports, 'fifo' available in all flavors\n"
+           "                         to force vsync [default,immediate,mailbox,fifo,relaxed]\n"
+           "      --drm-legacy       Use legacy instead of atomic modesetting in the DRM\n"
+           "                         flavor\n"
+           "      --drm-overlay      Scan out the rendering from an overlay plane instead of\n"
+           "                         the primary plane in the DRM flavor (needs atomic\n"
+           "                         modesetting)\n"
+           "      --drm-render-node  Render to GBM buffers of a render node without KMS in\n"
+           "                         the DRM flavor, needing neither DRM master nor a display\n"
+           "      --drm-export PATH  With --drm-render-node, send the frames as dma-bufs to\n"
+           "                         the consumer listening on the Unix socket PATH\n"
+           "      --drm-outputs O    Mirror the rendering on the connected outputs O in the\n"
+           "                         DRM flavor, 'all' or a list of connector names like\n"
+           "                         'HDMI-A-1,DP-2', and report the flips of each output\n"
+           "      --render-scale F   Render at the fraction F of the window size and let\n"
+           "                         the compositor scale the frames up in the Wayland\n"
+           "                         flavor (default: 1)\n"
+           "      --dynamic-resolution MS\n"
+           "                         Scale the resolution the frames are rendered at to\n"
+           "                         keep their frame time at MS milliseconds, scaling\n"
+           "                         them up to the canvas, and report the resolution\n"
+           "                         each scene sustains\n"
+           "      --win32-flip-model Present through a DXGI flip-model swapchain with\n"
+           "                         WGL_NV_DX_interop2 in the WGL flavor\n"
+           "      --android-native-loop\n"
+           "                         Render from a native loop on an ANativeWindow,\n"
+           "                         paced by AChoreographer with the fifo and relaxed\n"
+           "                         swap modes, instead of from GLSurfaceView (Android)\n"
+           "      --android-performance-hint\n"
+           "                         Report the work duration of the frames of the\n"
+           "                         native loop to APerformanceHint (Android)\n"
+           "      --device D         Render on the GPU D, given as an index or a name\n"
+           "                         listed by --all-devices --debug (default: the\n"
+           "                         primary GPU)\n"
+           "      --all-devices      Run the benchmarks on each GPU in turn, in a\n"
+           "                         separate process, and merge the results\n"
            "      --off-screen       Render to an off-screen surface\n"
+           "      --off-screen-buffers N\n"
+           "                         Render the frames off-screen to a ring of N\n"
+           "                         buffers, like a swapchain (default: 1)\n"
            "      --visual-config C  The visual configuration to use for the rendering\n"
            "                         target: 'red=R:green=G:blue=B:alpha=A:buffer=BUF'.\n"
            "                         The parameters may be defined in any order, and any\n"
-           "                         omitted parameters assume a default value of '1'\n"
-           "      --reuse-context    Use a single context for all scenes\n"
+           "                         omitted parameters assume a default value of '1'.\n"
+           "                         Add 'fp=1' for a floating point (e.g. FP16) target\n"
+           "                         and 'srgb=1' for an sRGB encoded one\n"
+           "      --reuse-context    Use a single context for all scenes and keep loaded\n"
+           "                         textures and models for later scenes\n"
            "                         (by default, each scene gets its own context)\n"
+           "      --context-pool N   Create up to N contexts for the next scenes, and\n"
+           "                         destroy those of the previous ones, in the\n"
+           "                         background (EGL only, default: 0)\n"
+           "      --fork-benchmarks  Run each benchmark in its own process, so that a\n"
+           "                         crash only fails that benchmark\n"
            "  -s, --size WxH         Size of the output window (default: 800x600)\n"
            "      --fullscreen       Run in fullscreen mode (equivalent to --size -1x-1)\n"
+           "      --size-sweep WxH,WxH...\n"
+           "                         Run all the benchmarks once at each of the sizes\n"
+           "                         (requires --off-screen)\n"
            "  -l, --list-scenes      Display information about the available scenes\n"
            "                         and their options\n"
            "      --show-all-options Show all scene option values used for benchmarks\n"
            "                         (only explicitly set options are shown by default)\n"
            "      --run-forever      Run indefinitely, looping from the last benchmark\n"
            "                         back to the first\n"
+           "      --repeat N         Run each benchmark N times and report the mean,\n"
+           "                         median and 95%% confidence interval of the results\n"
+           "      --repeat-order ORDER\n"
+           "                         The order of the repeated runs [sequential,\n"
+           "                         interleaved,shuffled]\n"
+           "      --soak SECONDS     Loop over the benchmarks for at least SECONDS,\n"
+           "                         sampling the FPS, temperatures and clocks\n"
+           "      --soak-interval SECONDS\n"
+           "                         The interval between soak samples (default: 5)\n"
+           "      --metrics ADDRESS  Serve the live FPS, frame times, temperatures and\n"
+           "                         memory in the Prometheus format over HTTP, on a\n"
+           "                         Unix socket path or \"tcp:[ADDRESS:]PORT\"\n"
            "      --annotate         Annotate the benchmarks with on-screen information\n"
            "                         (same as -b :show-fps=true:title=#info#)\n"
+           "      --results-file F   Write the benchmark results to a file in JSON\n"
+           "                         format (or CSV format if F ends in '.csv')\n"
+           "      --gpu-timing       Measure the GPU time of each frame using timer\n"
+           "                         queries, if supported\n"
+           "      --pipeline-stats   Count the vertices, primitives and fragment shader\n"
+           "                         invocations of each frame using queries, if\n"
+           "                         supported\n"
+           "      --present-timing   Measure the present intervals, missed vblanks and\n"
+           "                         swap-to-present latency of the frames, if the\n"
+           "                         display system reports them, and the CPU time\n"
+           "                         spent presenting each frame\n"
+           "      --spike-threshold MS\n"
+           "                         Break down the frames taking longer than MS\n"
+           "                         milliseconds and the frames around them into\n"
+           "                         update, draw, swap and page flip wait times, and\n"
+           "                         report which of them caused the spikes\n"
+           "      --pipelined        Prepare the next frame on a worker thread while\n"
+           "                         the current one is submitted, in the scenes that\n"
+           "                         support it\n"
+           "      --co-runners SPEC  Load the system with background threads while the\n"
+           "                         scenes run, and report how much slower the frames\n"
+           "                         get: 'cpu:N,memory:N,gpu:N' spinning CPU threads,\n"
+           "                         memory streaming threads and GPU contexts\n"
+           "      --bursts SPEC      Alternate idle periods and bursts of frames while\n"
+           "                         the scenes run, and report how many frames each\n"
+           "                         burst takes to reach the steady frame time:\n"
+           "                         'idle:MS,burst:MS'\n"
+           "      --context-priority P\n"
+           "                         The priority of the GL context on the GPU, if\n"
+           "                         supported [low,medium,high] (default: the\n"
+           "                         driver's default)\n"
+           "      --invalidate       Invalidate depth/stencil buffers at the end of each\n"
+           "                         frame, and offscreen attachments once they are no\n"
+           "                         longer needed, if supported\n"
+           "      --msaa SAMPLES     Render to multisampled buffers with SAMPLES\n"
+           "                         samples, resolved every frame, when rendering\n"
+           "                         off-screen (default: 0, disabled)\n"
+           "      --msaa-resolve METHOD\n"
+           "                         How to resolve the --msaa buffers [auto,blit,\n"
+           "                         implicit]\n"
+           "      --sample-shading F Shade at least the fraction F of the samples of\n"
+           "                         each pixel independently (default: 0, disabled)\n"
+           "      --hdr FORMAT       Render to a floating point target, tone mapped to\n"
+           "                         the output at the end of each frame [none,rgba16f,\n"
+           "                         r11g11b10f] (default: none)\n"
+           "      --hdr-bloom        Add bloom to the --hdr frames before tone mapping\n"
+           "      --tone-map OP      The tone mapping operator of --hdr [reinhard,aces]\n"
+           "                         (default: aces)\n"
+           "      --post-process EFFECTS\n"
+           "                         Post-process every frame with the effects, separated\n"
+           "                         by ':' e.g. blur=4:fxaa [blur[=RADIUS],fxaa,grade,\n"
+           "                         convolution=KERNEL]\n"
+           "      --state-tracking MODE\n"
+           "                         Count the GL state changes that don't change the\n"
+           "                         state, or skip them [off,count,filter]\n"
+           "      --profile-gl-calls Count the calls of the common GL functions and the\n"
+           "                         CPU time spent in them per frame\n"
+           "      --flush-points SPEC\n"
+           "                         Flush the GL commands at the pass boundaries and/or\n"
+           "                         every N draws, e.g. passes,draws:16\n"
+           "      --count-allocations\n"
+           "                         Count the memory allocations of glmark2 per frame\n"
+           "                         (needs a build with --enable-alloc-counter)\n"
+           "      --startup-report   Report the time of the startup phases and the time\n"
+           "                         to the first presented frame\n"
+           "      --trace FILE       Write a timeline of the main loop, frame ends and\n"
+           "                         resource loads of each thread to FILE, in the\n"
+           "                         Chrome Trace Event format\n"
+           "      --debug-markers    Wrap the passes of the frames in KHR_debug groups\n"
+           "                         and label the GL objects, for GPU debuggers\n"
+           "      --perf-counters    Count the CPU cycles, instructions, cache misses and\n"
+           "                         context switches of the measured frames (Linux)\n"
+           "      --gpu-counters NAMES\n"
+           "                         Sample the comma separated GPU counters of the\n"
+           "                         driver over the measured frames, as \"counter\" or\n"
+           "                         \"group/counter\" (needs GL_AMD_performance_monitor)\n"
+           "      --cpu-affinity CPUS\n"
+           "                         Pin the render thread to the CPUs, e.g. \"2,4-5\" (Linux)\n"
+           "      --worker-affinity CPUS\n"
+           "                         Pin the worker threads to the CPUs (default: the\n"
+           "                         CPUs of the render thread)\n"
+           "      --realtime-priority N\n"
+           "                         Run with the SCHED_FIFO policy and priority N\n"
+           "                         (1-99, default: 0, disabled)\n"
+           "      --nice N           Run with the nice value N (default: 0)\n"
+           "      --lock-memory      Lock the memory of the process, so it isn't paged out\n"
+           "      --lock-clocks      Put the CPU and GPU clock governors in a fixed\n"
+           "                         performance mode for the run (usually needs root)\n"
+           "      --compare-to FILE  Compare the FPS of the benchmarks to those of a JSON\n"
+           "                         results file and fail if any of them regressed\n"
+           "      --regression-threshold PERCENT\n"
+           "                         The FPS drop, in percent, that is a regression with\n"
+           "                         --compare-to and --history (default: 5)\n"
+           "      --history-file FILE\n"
+           "                         Append the results and the GL and EGL information\n"
+           "                         of the run to a results history file\n"
+           "      --history FILE     Instead of benchmarking, show the FPS trends of the\n"
+           "                         runs in a results history file, per device, and\n"
+           "                         fail if the latest run of any benchmark regressed\n"
+           "      --score-model MODEL\n"
+           "                         How the FPS of the benchmarks are combined into the\n"
+           "                         score, using their score-weight option [arithmetic,\n"
+           "                         geometric,frame-time,category] (default: arithmetic)\n"
+           "      --score-reference FILE\n"
+           "                         Normalize the sub-score of each category of\n"
+           "                         benchmarks to the JSON results file of a reference\n"
+           "                         device, which scores 1000 (by default, the\n"
+           "                         sub-scores are the geometric mean FPS)\n"
+           "      --bottleneck-analysis\n"
+           "                         Instead of benchmarking, classify what limits each\n"
+           "                         benchmark from short probe runs with perturbations\n"
+           "      --explore RANGES   Instead of benchmarking, show how the FPS of each\n"
+           "                         benchmark changes over ranges of its options, e.g.\n"
+           "                         'fragment-steps=1..64,grid-size=8..256', sampling\n"
+           "                         more where the FPS changes quickly\n"
+           "      --serve ADDRESS    Instead of benchmarking, run the benchmarks sent to\n"
+           "                         a Unix socket path or \"tcp:[ADDRESS:]PORT\", one\n"
+           "                         per line, and send back their results as JSON\n"
+           "      --record FILE      Record the GL calls of the setup and first frames of\n"
+           "                         the first benchmark, with their data, to FILE\n"
+           "      --record-frames N  The number of frames to record (default: 100)\n"
+           "      --replay FILE      Instead of benchmarking, replay the frames recorded\n"
+           "                         in FILE in a loop and report their FPS\n"
+           "      --replay-duration SECONDS\n"
+           "                         How long to replay for (default: 10)\n"
+           "      --target-fps FPS   Pace the frames of each benchmark to at most FPS\n"
+           "                         (default: 0, unlimited)\n"
+           "      --fixed-timestep SECONDS\n"
+           "                         Advance the animations by SECONDS every frame\n"
+           "                         instead of by the time elapsed (default: 0,\n"
+           "                         elapsed time)\n"
+           "      --energy           Report the energy used per frame and the average\n"
+           "                         power, from RAPL, hwmon or the battery\n"
+           "      --memory-usage     Report the memory used by the process and the GPU\n"
+           "                         for each benchmark, and what its teardown retains\n"
+           "      --single-buffer    Render to the front buffer, for the lowest latency\n"
+           "                         (EGL only)\n"
+           "      --capture-interval N\n"
+           "                         Capture every Nth frame of each benchmark to an\n"
+           "                         image file (default: 0, disabled)\n"
+           "      --capture-dir DIR  The directory to write captured frames to\n"
+           "                         (default: .)\n"
+           "      --capture-format FORMAT\n"
+           "                         The format of captured frames [png,raw]\n"
+           "      --shader-cache DIR Cache program binaries in the existing directory\n"
+           "                         DIR, to avoid recompiling shaders across scenes\n"
+           "                         and runs\n"
+           "      --precompile-shaders\n"
+           "                         Build the programs of all the benchmarks before\n"
+           "                         running them, and keep their binaries for their\n"
+           "                         scenes to load\n"
+           "      --model-cache DIR  Cache preprocessed models in the existing\n"
+           "                         directory DIR, to avoid parsing model files\n"
+           "                         and calculating normals on every run\n"
            "  -d, --debug            Display debug messages\n"
+           "      --async-log        Write the messages from a background thread, so\n"
+           "                         that logging doesn't block the benchmarks\n"
            "      --version          Display program version\n"
            "  -h, --help             Display help\n");
 }
@@ -205,20 +778,64 @@ Options::parse_args(int argc, char **argv)
             Options::benchmark_files.push_back(optarg);
         else if (!strcmp(optname, "validate"))
             Options::validate = true;
+        else if (!strcmp(optname, "reference-dir"))
+            Options::reference_dir = optarg;
+        else if (!strcmp(optname, "reference-tolerance"))
+            Options::reference_tolerance = Util::fromString<unsigned int>(optarg);
+        else if (!strcmp(optname, "reference-psnr"))
+            Options::reference_psnr = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "reference-ssim"))
+            Options::reference_ssim = Util::fromString<double>(optarg);
         else if (!strcmp(optname, "data-path"))
             Options::data_path = std::string(optarg);
+        else if (!strcmp(optname, "data-pack"))
+            Options::data_pack = std::string(optarg);
         else if (!strcmp(optname, "frame-end"))
             Options::frame_end = frame_end_from_str(optarg);
+        else if (!strcmp(optname, "frames-in-flight"))
+            Options::frames_in_flight = Util::fromString<unsigned int>(optarg);
         else if (!strcmp(optname, "swap-mode"))
             Options::swap_mode = swap_mode_from_str(optarg);
+        else if (!strcmp(optname, "drm-legacy"))
+            Options::drm_legacy = true;
+        else if (!strcmp(optname, "drm-overlay"))
+            Options::drm_overlay = true;
+        else if (!strcmp(optname, "drm-render-node"))
+            Options::drm_render_node = true;
+        else if (!strcmp(optname, "drm-export"))
+            Options::drm_export = optarg;
+        else if (!strcmp(optname, "drm-outputs"))
+            Options::drm_outputs = optarg;
+        else if (!strcmp(optname, "render-scale"))
+            Options::render_scale = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "dynamic-resolution"))
+            Options::dynamic_resolution = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "win32-flip-model"))
+            Options::win32_flip_model = true;
+        else if (!strcmp(optname, "android-native-loop"))
+            Options::android_native_loop = true;
+        else if (!strcmp(optname, "android-performance-hint"))
+            Options::android_performance_hint = true;
+        else if (!strcmp(optname, "device"))
+            Options::device = optarg;
+        else if (!strcmp(optname, "all-devices"))
+            Options::all_devices = true;
         else if (!strcmp(optname, "off-screen"))
             Options::offscreen = true;
+        else if (!strcmp(optname, "off-screen-buffers"))
+            Options::offscreen_buffers = Util::fromString<unsigned int>(optarg);
         else if (!strcmp(optname, "visual-config"))
             Options::visual_config = GLVisualConfig(optarg);
         else if (!strcmp(optname, "reuse-context"))
             Options::reuse_context = true;
+        else if (!strcmp(optname, "context-pool"))
+            Options::context_pool = Util::fromString<unsigned int>(optarg);
+        else if (!strcmp(optname, "fork-benchmarks"))
+            Options::fork_benchmarks = true;
         else if (c == 's' || !strcmp(optname, "size"))
             parse_size(optarg, Options::size);
+        else if (!strcmp(optname, "size-sweep"))
+            parse_size_list(optarg, Options::size_sweep);
         else if (!strcmp(optname, "fullscreen"))
             Options::size = std::pair<int,int>(-1, -1);
         else if (c == 'l' || !strcmp(optname, "list-scenes"))
@@ -227,8 +844,132 @@ Options::parse_args(int argc, char **argv)
             Options::show_all_options = true;
         else if (!strcmp(optname, "run-forever"))
             Options::run_forever = true;
+        else if (!strcmp(optname, "repeat"))
+            Options::repeat = Util::fromString<unsigned int>(optarg);
+        else if (!strcmp(optname, "repeat-order"))
+            Options::repeat_order = repeat_order_from_str(optarg);
+        else if (!strcmp(optname, "soak"))
+            Options::soak_duration = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "soak-interval"))
+            Options::soak_interval = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "metrics"))
+            Options::metrics = optarg;
+        else if (!strcmp(optname, "results-file"))
+            Options::results_file = optarg;
+        else if (!strcmp(optname, "gpu-timing"))
+            Options::gpu_timing = true;
+        else if (!strcmp(optname, "pipeline-stats"))
+            Options::pipeline_stats = true;
+        else if (!strcmp(optname, "present-timing"))
+            Options::present_timing = true;
+        else if (!strcmp(optname, "spike-threshold"))
+            Options::spike_threshold = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "pipelined"))
+            Options::pipelined = true;
+        else if (!strcmp(optname, "co-runners"))
+            Options::co_runners = optarg;
+        else if (!strcmp(optname, "bursts"))
+            Options::bursts = optarg;
+        else if (!strcmp(optname, "context-priority"))
+            Options::context_priority = context_priority_from_str(optarg);
+        else if (!strcmp(optname, "invalidate"))
+            Options::invalidate = true;
+        else if (!strcmp(optname, "msaa"))
+            Options::msaa_samples = Util::fromString<unsigned int>(optarg);
+        else if (!strcmp(optname, "msaa-resolve"))
+            Options::msaa_resolve = msaa_resolve_from_str(optarg);
+        else if (!strcmp(optname, "sample-shading"))
+            Options::sample_shading = Util::fromString<float>(optarg);
+        else if (!strcmp(optname, "hdr"))
+            Options::hdr_format = hdr_format_from_str(optarg);
+        else if (!strcmp(optname, "hdr-bloom"))
+            Options::hdr_bloom = true;
+        else if (!strcmp(optname, "tone-map"))
+            Options::tone_map = tone_map_from_str(optarg);
+        else if (!strcmp(optname, "post-process"))
+            Options::post_process = optarg;
+        else if (!strcmp(optname, "state-tracking"))
+            Options::state_tracking = state_tracking_from_str(optarg);
+        else if (!strcmp(optname, "profile-gl-calls"))
+            Options::profile_gl_calls = true;
+        else if (!strcmp(optname, "flush-points"))
+            Options::flush_points = optarg;
+        else if (!strcmp(optname, "count-allocations"))
+            Options::count_allocations = true;
+        else if (!strcmp(optname, "startup-report"))
+            Options::startup_report = true;
+        else if (!strcmp(optname, "trace"))
+            Options::trace_file = optarg;
+        else if (!strcmp(optname, "debug-markers"))
+            Options::debug_markers = true;
+        else if (!strcmp(optname, "perf-counters"))
+            Options::perf_counters = true;
+        else if (!strcmp(optname, "gpu-counters"))
+            Options::gpu_counters = optarg;
+        else if (!strcmp(optname, "cpu-affinity"))
+            Options::cpu_affinity = optarg;
+        else if (!strcmp(optname, "worker-affinity"))
+            Options::worker_affinity = optarg;
+        else if (!strcmp(optname, "realtime-priority"))
+            Options::realtime_priority = Util::fromString<int>(optarg);
+        else if (!strcmp(optname, "nice"))
+            Options::nice = Util::fromString<int>(optarg);
+        else if (!strcmp(optname, "lock-memory"))
+            Options::lock_memory = true;
+        else if (!strcmp(optname, "lock-clocks"))
+            Options::lock_clocks = true;
+        else if (!strcmp(optname, "compare-to"))
+            Options::compare_to = optarg;
+        else if (!strcmp(optname, "regression-threshold"))
+            Options::regression_threshold = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "history-file"))
+            Options::history_file = optarg;
+        else if (!strcmp(optname, "history"))
+            Options::history = optarg;
+        else if (!strcmp(optname, "score-model"))
+            Options::score_model = score_model_from_str(optarg);
+        else if (!strcmp(optname, "score-reference"))
+            Options::score_reference = optarg;
+        else if (!strcmp(optname, "bottleneck-analysis"))
+            Options::bottleneck_analysis = true;
+        else if (!strcmp(optname, "explore"))
+            Options::explore = optarg;
+        else if (!strcmp(optname, "serve"))
+            Options::serve = optarg;
+        else if (!strcmp(optname, "record"))
+            Options::record = optarg;
+        else if (!strcmp(optname, "record-frames"))
+            Options::record_frames = Util::fromString<unsigned int>(optarg);
+        else if (!strcmp(optname, "replay"))
+            Options::replay = optarg;
+        else if (!strcmp(optname, "replay-duration"))
+            Options::replay_duration = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "target-fps"))
+            Options::target_fps = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "fixed-timestep"))
+            Options::fixed_timestep = Util::fromString<double>(optarg);
+        else if (!strcmp(optname, "energy"))
+            Options::energy = true;
+        else if (!strcmp(optname, "memory-usage"))
+            Options::memory_usage = true;
+        else if (!strcmp(optname, "single-buffer"))
+            Options::single_buffer = true;
+        else if (!strcmp(optname, "capture-interval"))
+            Options::capture_interval = Util::fromString<unsigned int>(optarg);
+        else if (!strcmp(optname, "capture-dir"))
+            Options::capture_dir = optarg;
+        else if (!strcmp(optname, "capture-format"))
+            Options::capture_format = optarg;
+        else if (!strcmp(optname, "shader-cache"))
+            Options::shader_cache = optarg;
+        else if (!strcmp(optname, "precompile-shaders"))
+            Options::precompile_shaders = true;
+        else if (!strcmp(optname, "model-cache"))
+            Options::model_cache = optarg;
         else if (c == 'd' || !strcmp(optname, "debug"))
             Options::show_debug = true;
+        else if (!strcmp(optname, "async-log"))
+            Options::async_log = true;
         else if (!strcmp(optname, "version"))
             Options::show_version = true;
         else if (c == 'h' || !strcmp(optname, "help"))
@@ -27,6 +27,7 @@
 #include <string>
 #include <vector>
 #include "gl-visual-config.h"
+#include "state-tracker.h"
 
 struct Options {
     enum FrameEnd {
@@ -34,7 +35,9 @@ struct Options {
         FrameEndNone,
         FrameEndSwap,
         FrameEndFinish,
-        FrameEndReadPixels
+        FrameEndReadPixels,
+        FrameEndReadPixelsAsync,
+        FrameEndFence
     };
 
     enum SwapMode {
@@ -42,6 +45,44 @@ struct Options {
         SwapModeImmediate,
         SwapModeMailbox,
         SwapModeFIFO,
+        SwapModeRelaxed,
+    };
+
+    enum RepeatOrder {
+        RepeatOrderSequential,
+        RepeatOrderInterleaved,
+        RepeatOrderShuffled
+    };
+
+    enum ContextPriority {
+        ContextPriorityDefault,
+        ContextPriorityLow,
+        ContextPriorityMedium,
+        ContextPriorityHigh
+    };
+
+    enum MsaaResolve {
+        MsaaResolveAuto,
+        MsaaResolveBlit,
+        MsaaResolveImplicit
+    };
+
+    enum HdrFormat {
+        HdrFormatNone,
+        HdrFormatRGBA16F,
+        HdrFormatR11G11B10F
+    };
+
+    enum ToneMap {
+        ToneMapReinhard,
+        ToneMapACES
+    };
+
+    enum ScoreModel {
+        ScoreModelArithmetic,
+        ScoreModelGeometric,
+        ScoreModelFrameTime,
+        ScoreModelCategory
     };
 
     static bool parse_args(int argc, char **argv);
@@ -50,20 +91,104 @@ struct Options {
     static std::vector<std::string> benchmarks;
     static std::vector<std::string> benchmark_files;
     static bool validate;
+    static std::string reference_dir;
+    static unsigned int reference_tolerance;
+    static double reference_psnr;
+    static double reference_ssim;
     static std::string data_path;
+    static std::string data_pack;
     static FrameEnd frame_end;
+    static unsigned int frames_in_flight;
     static SwapMode swap_mode;
+    static bool drm_legacy;
+    static bool drm_overlay;
+    static bool drm_render_node;
+    static std::string drm_export;
+    static std::string drm_outputs;
+    static double render_scale;
+    static double dynamic_resolution;
+    static bool win32_flip_model;
+    static bool android_native_loop;
+    static bool android_performance_hint;
+    static std::string device;
+    static bool all_devices;
     static std::pair<int,int> size;
+    static std::vector<std::pair<int,int> > size_sweep;
     static bool list_scenes;
     static bool show_all_options;
     static bool show_debug;
+    static bool async_log;
     static bool show_version;
     static bool show_help;
     static bool reuse_context;
+    static unsigned int context_pool;
+    static bool fork_benchmarks;
     static bool run_forever;
+    static unsigned int repeat;
+    static RepeatOrder repeat_order;
+    static double soak_duration;
+    static double soak_interval;
+    static std::string metrics;
     static bool annotate;
     static bool offscreen;
+    static unsigned int offscreen_buffers;
     static GLVisualConfig visual_config;
+    static std::string results_file;
+    static bool gpu_timing;
+    static bool pipeline_stats;
+    static bool present_timing;
+    static double spike_threshold;
+    static bool pipelined;
+    static std::string co_runners;
+    static std::string bursts;
+    static ContextPriority context_priority;
+    static bool invalidate;
+    static unsigned int msaa_samples;
+    static MsaaResolve msaa_resolve;
+    static float sample_shading;
+    static HdrFormat hdr_format;
+    static bool hdr_bloom;
+    static ToneMap tone_map;
+    static std::string post_process;
+    static StateTracker::Mode state_tracking;
+    static bool profile_gl_calls;
+    static std::string flush_points;
+    static bool count_allocations;
+    static bool startup_report;
+    static std::string trace_file;
+    static bool debug_markers;
+    static bool perf_counters;
+    static std::string gpu_counters;
+    static std::string cpu_affinity;
+    static std::string worker_affinity;
+    static int realtime_priority;
+    static int nice;
+    static bool lock_memory;
+    static bool lock_clocks;
+    static std::string compare_to;
+    static double regression_threshold;
+    static std::string history_file;
+    static std::string history;
+    static ScoreModel score_model;
+    static std::string score_reference;
+    static bool bottleneck_analysis;
+    static std::string explore;
+    static std::string serve;
+    static std::string record;
+    static unsigned int record_frames;
+    static std::string replay;
+    static double replay_duration;
+    static double target_fps;
+    static double fixed_timestep;
+    static bool energy;
+    static bool memory_usage;
+    static bool single_buffer;
+    static unsigned int capture_interval;
+    static std::string capture_dir;
+    static std::string capture_format;
+    static std::string shader_cache;
+    static bool precompile_shaders;
+    static std::string model_cache;
 };
 
 #endif /* OPTIONS_H_ */
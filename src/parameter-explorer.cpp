@@ -0,0 +1,283 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "parameter-explorer.h"
+#include "main-loop.h"
+#include "options.h"
+#include "log.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+
+/* The duration of each sample run, unless the benchmark sets one, in seconds */
+const char *sample_duration = "1.0";
+
+/* The evenly spaced values sampled first, including both ends */
+const unsigned int initial_samples = 5;
+/* The most samples of a range, including the initial ones */
+const unsigned int max_samples = 20;
+/*
+ * The FPS change between two neighbouring samples, as a fraction, above
+ * which their interval is bisected and the drop is shown as a knee.
+ */
+const double knee_change = 0.1;
+/* The narrowest interval bisected, as a fraction of a non-integer range */
+const double min_interval = 1.0 / 256.0;
+
+bool
+parse_number(const std::string &str, double &value, bool &integer)
+{
+    const char *start = str.c_str();
+    char *end;
+
+    value = strtod(start, &end);
+    integer = str.find_first_of(".eE") == std::string::npos;
+
+    return !str.empty() && *end == '\0';
+}
+
+/* How much the FPS changes between two samples, whichever way */
+double
+fps_change(double a, double b)
+{
+    return std::max(a, b) / std::min(a, b) - 1.0;
+}
+
+}
+
+ParameterExplorer::ParameterExplorer(Canvas &canvas,
+                                     const std::vector<Benchmark *> &benchmarks) :
+    canvas_(canvas), benchmarks_(benchmarks)
+{
+}
+
+bool
+ParameterExplorer::parse(const std::string &spec, std::vector<Range> &ranges)
+{
+    std::vector<std::string> elems;
+    Util::split(spec, ',', elems, Util::SplitModeNormal);
+
+    ranges.clear();
+
+    for (std::vector<std::string>::const_iterator iter = elems.begin();
+         iter != elems.end();
+         iter++)
+    {
+        size_t equals = iter->find('=');
+        size_t dots = iter->find("..");
+        if (equals == std::string::npos || dots == std::string::npos || dots < equals)
+            return false;
+
+        Range range;
+        bool min_integer;
+        bool max_integer;
+
+        range.option = iter->substr(0, equals);
+        if (range.option.empty() ||
+            !parse_number(iter->substr(equals + 1, dots - equals - 1), range.min, min_integer) ||
+            !parse_number(iter->substr(dots + 2), range.max, max_integer) ||
+            range.max <= range.min)
+        {
+            return false;
+        }
+        range.integer = min_integer && max_integer;
+
+        ranges.push_back(range);
+    }
+
+    return !ranges.empty();
+}
+
+void
+ParameterExplorer::run(const std::vector<Range> &ranges)
+{
+    unsigned int saved_repeat = Options::repeat;
+
+    Options::repeat = 1;
+    results_.clear();
+
+    for (std::vector<Benchmark *>::const_iterator iter = benchmarks_.begin();
+         iter != benchmarks_.end() && !canvas_.should_quit();
+         iter++)
+    {
+        Benchmark &bench(**iter);
+
+        /* The benchmarks setting the default options are run once, to set them */
+        if (bench.scene().name().empty()) {
+            std::vector<Benchmark *> defaults(1, &bench);
+            MainLoop loop(canvas_, defaults);
+            while (loop.step());
+            continue;
+        }
+
+        const std::map<std::string, Scene::Option> &options(bench.scene().options());
+
+        for (std::vector<Range>::const_iterator range = ranges.begin();
+             range != ranges.end() && !canvas_.should_quit();
+             range++)
+        {
+            if (options.find(range->option) != options.end())
+                explore(bench, *range);
+        }
+    }
+
+    Options::repeat = saved_repeat;
+}
+
+/*
+ * Samples the range evenly, then bisects the interval with the largest FPS
+ * change until no interval changes by more than knee_change, or is too
+ * narrow to split, or the samples run out.
+ */
+void
+ParameterExplorer::explore(Benchmark &bench, const Range &range)
+{
+    std::vector<Sample> samples;
+
+    for (unsigned int i = 0; i < initial_samples && !canvas_.should_quit(); i++) {
+        double value = range.min + (range.max - range.min) * i / (initial_samples - 1);
+        if (range.integer)
+            value = std::floor(value + 0.5);
+
+        Sample s;
+        if ((samples.empty() || samples.back().value != value) &&
+            sample(bench, range, value, s))
+        {
+            samples.push_back(s);
+        }
+    }
+
+    while (samples.size() < max_samples && !canvas_.should_quit()) {
+        double widest = 0.0;
+        size_t split = 0;
+
+        for (size_t i = 1; i < samples.size(); i++) {
+            const Sample &a(samples[i - 1]);
+            const Sample &b(samples[i]);
+            double narrowest = range.integer ? 2.0 : (range.max - range.min) * min_interval;
+
+            if (a.fps <= 0.0 || b.fps <= 0.0 || b.value - a.value < narrowest)
+                continue;
+
+            double change = fps_change(a.fps, b.fps);
+            if (change > knee_change && change > widest) {
+                widest = change;
+                split = i;
+            }
+        }
+
+        if (split == 0)
+            break;
+
+        double value = (samples[split - 1].value + samples[split].value) / 2.0;
+        if (range.integer)
+            value = std::floor(value);
+
+        Sample s;
+        sample(bench, range, value, s);
+        samples.insert(samples.begin() + split, s);
+    }
+
+    std::string bench_options(bench.options_string());
+
+    Log::info("=======================================================\n");
+    Log::info("    [%s] %s: FPS over %s\n", bench.scene().name().c_str(),
+              bench_options.empty() ? "<default>" : bench_options.c_str(),
+              range.option.c_str());
+    Log::info("=======================================================\n");
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        const Sample &s(samples[i]);
+        std::string value(value_str(range, s.value));
+
+        if (s.fps <= 0.0) {
+            Log::info("    %s=%s: failed\n", range.option.c_str(), value.c_str());
+            continue;
+        }
+
+        /* Mark the knees, where the FPS changes quickly */
+        char knee[64] = "";
+        if (i > 0 && samples[i - 1].fps > 0.0 &&
+            fps_change(samples[i - 1].fps, s.fps) > knee_change)
+        {
+            snprintf(knee, sizeof(knee), " (%+.1f%%)",
+                     100.0 * (s.fps - samples[i - 1].fps) / samples[i - 1].fps);
+        }
+
+        Log::info("    %s=%s: %.1f%s\n", range.option.c_str(), value.c_str(), s.fps, knee);
+    }
+}
+
+/*
+ * Runs a benchmark with an option set to a value, for a short time unless
+ * the benchmark sets its own duration.
+ */
+bool
+ParameterExplorer::sample(Benchmark &bench, const Range &range, double value, Sample &result)
+{
+    std::vector<Benchmark::OptionPair> sample_options(bench.options());
+    bool has_duration = false;
+
+    for (size_t i = 0; i < sample_options.size(); i++)
+        has_duration = has_duration || sample_options[i].first == "duration";
+
+    if (!has_duration)
+        sample_options.push_back(Benchmark::OptionPair("duration", sample_duration));
+    sample_options.push_back(Benchmark::OptionPair(range.option, value_str(range, value)));
+
+    Benchmark sample_bench(bench.scene(), sample_options);
+    std::vector<Benchmark *> sample_benchmarks(1, &sample_bench);
+
+    MainLoop loop(canvas_, sample_benchmarks);
+    while (loop.step());
+
+    result.value = value;
+    result.fps = 0.0;
+
+    if (loop.results().empty())
+        return false;
+
+    const BenchmarkResult &r(loop.results().front());
+    results_.push_back(r);
+
+    if (r.status != BenchmarkResult::StatusSuccess || r.elapsed_time <= 0.0)
+        return true;
+
+    result.fps = r.frames / r.elapsed_time;
+
+    return true;
+}
+
+std::string
+ParameterExplorer::value_str(const Range &range, double value)
+{
+    char buf[32];
+
+    if (range.integer)
+        snprintf(buf, sizeof(buf), "%.0f", value);
+    else
+        snprintf(buf, sizeof(buf), "%g", value);
+
+    return buf;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_PARAMETER_EXPLORER_H_
+#define GLMARK2_PARAMETER_EXPLORER_H_
+
+#include "canvas.h"
+#include "benchmark.h"
+#include "results-file.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Explores how the FPS of each benchmark changes over ranges of numeric
+ * scene options (--explore), e.g. fragment-steps=1..64.
+ *
+ * Each option is explored on its own, with the others at their benchmark
+ * values. The range is first sampled at a few evenly spaced values, then
+ * the intervals over which the FPS changes the most are bisected, so the
+ * samples gather around the knees of the curve (e.g. cache cliffs) rather
+ * than being spread evenly.
+ */
+class ParameterExplorer
+{
+public:
+    /**
+     * The range of values of a scene option.
+     */
+    struct Range
+    {
+        Range() : min(0.0), max(0.0), integer(true) {}
+
+        std::string option;
+        double min;
+        double max;
+        /* Whether only integer values are sampled */
+        bool integer;
+    };
+
+    ParameterExplorer(Canvas &canvas, const std::vector<Benchmark *> &benchmarks);
+
+    /**
+     * Parses an --explore specification, e.g.
+     * 'fragment-steps=1..64,blur-radius=0..8'. A range is sampled at
+     * integer values if both of its ends are integers.
+     *
+     * @return whether the specification is valid
+     */
+    static bool parse(const std::string &spec, std::vector<Range> &ranges);
+
+    /**
+     * Explores the ranges of the options each benchmark has, and logs a
+     * curve per benchmark and option.
+     */
+    void run(const std::vector<Range> &ranges);
+
+    /**
+     * Gets the results of all the sampled runs, with the sampled option
+     * values in their options.
+     */
+    const std::vector<BenchmarkResult> &results() { return results_; }
+
+private:
+    struct Sample
+    {
+        Sample() : value(0.0), fps(0.0) {}
+
+        double value;
+        /* 0 if the run failed */
+        double fps;
+    };
+
+    void explore(Benchmark &bench, const Range &range);
+    bool sample(Benchmark &bench, const Range &range, double value, Sample &result);
+    static std::string value_str(const Range &range, double value);
+
+    Canvas &canvas_;
+    const std::vector<Benchmark *> &benchmarks_;
+    std::vector<BenchmarkResult> results_;
+};
+
+#endif
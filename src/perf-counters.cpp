@@ -0,0 +1,446 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "perf-counters.h"
+#include "log.h"
+#include "util.h"
+
+#include <cctype>
+#include <cstring>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+#if defined(__linux__)
+struct CPUEvent
+{
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+const CPUEvent cpu_events[] = {
+    { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "context_switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+/*
+ * Opens a counter for a thread of the process. The threads it creates
+ * later are counted too.
+ */
+int
+open_cpu_event(const CPUEvent &event, pid_t tid)
+{
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    /* Counting the user space only works with the default perf_event_paranoid */
+    if (event.type == PERF_TYPE_HARDWARE) {
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+    }
+
+    return syscall(__NR_perf_event_open, &attr, tid, -1, -1, 0);
+}
+
+/*
+ * Gets the threads of the process, e.g. the threads of the driver.
+ */
+std::vector<pid_t>
+process_threads()
+{
+    std::vector<pid_t> tids;
+    DIR *dir = opendir("/proc/self/task");
+
+    if (!dir) {
+        tids.push_back(0);
+        return tids;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != 0) {
+        if (isdigit(static_cast<unsigned char>(entry->d_name[0])))
+            tids.push_back(Util::fromString<pid_t>(entry->d_name));
+    }
+
+    closedir(dir);
+
+    return tids;
+}
+#endif
+
+std::string
+value_name(const std::string &name)
+{
+    std::string str(name);
+
+    for (std::string::iterator iter = str.begin(); iter != str.end(); iter++) {
+        if (!isalnum(static_cast<unsigned char>(*iter)))
+            *iter = '_';
+    }
+
+    return str;
+}
+
+}
+
+PerfCounters::PerfCounters() :
+    monitor_(0), counting_(false), frames_(0)
+{
+}
+
+PerfCounters::~PerfCounters()
+{
+    /*
+     * The GPU monitor belongs to a GL context which may already be gone,
+     * so it is only released explicitly through release().
+     */
+}
+
+bool
+PerfCounters::init(bool cpu, const std::string &gpu_counters)
+{
+    release();
+    values_.clear();
+
+    bool cpu_ok = cpu && init_cpu();
+    bool gpu_ok = !gpu_counters.empty() && init_gpu(gpu_counters);
+
+    return cpu_ok || gpu_ok;
+}
+
+bool
+PerfCounters::init_cpu()
+{
+#if defined(__linux__)
+    std::vector<pid_t> tids(process_threads());
+
+    for (size_t i = 0; i < sizeof(cpu_events) / sizeof(*cpu_events); i++) {
+        CPUCounter counter;
+        counter.name = cpu_events[i].name;
+
+        for (size_t t = 0; t < tids.size(); t++) {
+            int fd = open_cpu_event(cpu_events[i], tids[t]);
+            if (fd >= 0)
+                counter.fds.push_back(fd);
+        }
+
+        if (counter.fds.empty()) {
+            Log::debug("Failed to open the %s perf event: %s\n",
+                       counter.name, strerror(errno));
+            continue;
+        }
+
+        cpu_counters_.push_back(counter);
+    }
+
+    if (cpu_counters_.empty()) {
+        static bool warned = false;
+        if (!warned) {
+            Log::info("Warning: the CPU perf events can't be opened, "
+                      "check /proc/sys/kernel/perf_event_paranoid\n");
+            warned = true;
+        }
+        return false;
+    }
+
+    return true;
+#else
+    static bool warned = false;
+    if (!warned) {
+        Log::info("Warning: CPU counters are only supported on Linux\n");
+        warned = true;
+    }
+    return false;
+#endif
+}
+
+bool
+PerfCounters::init_gpu(const std::string &names)
+{
+    static bool warned = false;
+
+    if (!GLExtensions::GetPerfMonitorGroupsAMD || !GLExtensions::GenPerfMonitorsAMD) {
+        if (!warned) {
+            Log::info("Warning: GPU counters need GL_AMD_performance_monitor\n");
+            warned = true;
+        }
+        return false;
+    }
+
+    /* Find the available counters */
+    std::vector<GPUCounter> available;
+    GLint num_groups = 0;
+    GLExtensions::GetPerfMonitorGroupsAMD(&num_groups, 0, 0);
+    std::vector<GLuint> groups(num_groups);
+    if (num_groups > 0)
+        GLExtensions::GetPerfMonitorGroupsAMD(&num_groups, num_groups, &groups[0]);
+
+    for (size_t g = 0; g < groups.size(); g++) {
+        char group_name[256] = "";
+        GLint num_counters = 0;
+        GLint max_active = 0;
+
+        GLExtensions::GetPerfMonitorGroupStringAMD(groups[g], sizeof(group_name), 0, group_name);
+        GLExtensions::GetPerfMonitorCountersAMD(groups[g], &num_counters, &max_active, 0, 0);
+        if (num_counters <= 0)
+            continue;
+
+        std::vector<GLuint> counters(num_counters);
+        GLExtensions::GetPerfMonitorCountersAMD(groups[g], &num_counters, &max_active,
+                                                num_counters, &counters[0]);
+
+        for (size_t c = 0; c < counters.size(); c++) {
+            char counter_name[256] = "";
+            GPUCounter counter;
+
+            GLExtensions::GetPerfMonitorCounterStringAMD(groups[g], counters[c],
+                                                         sizeof(counter_name), 0,
+                                                         counter_name);
+            GLExtensions::GetPerfMonitorCounterInfoAMD(groups[g], counters[c],
+                                                       GL_COUNTER_TYPE_AMD, &counter.type);
+            counter.name = std::string(group_name) + "/" + counter_name;
+            counter.group = groups[g];
+            counter.counter = counters[c];
+            available.push_back(counter);
+        }
+    }
+
+    /* Select the requested ones, by full name or by counter name */
+    std::vector<std::string> requested;
+    Util::split(names, ',', requested, Util::SplitModeNormal);
+
+    for (std::vector<std::string>::const_iterator iter = requested.begin();
+         iter != requested.end();
+         iter++)
+    {
+        bool found = false;
+
+        for (size_t i = 0; i < available.size() && !found; i++) {
+            const std::string &name(available[i].name);
+            if (name == *iter ||
+                name.substr(name.find('/') + 1) == *iter)
+            {
+                gpu_counters_.push_back(available[i]);
+                found = true;
+            }
+        }
+
+        if (!found && !warned) {
+            Log::info("Warning: GPU counter '%s' not found, the available counters are:\n",
+                      iter->c_str());
+            for (size_t i = 0; i < available.size(); i++)
+                Log::info("    %s\n", available[i].name.c_str());
+            warned = true;
+        }
+    }
+
+    if (gpu_counters_.empty())
+        return false;
+
+    GLExtensions::GenPerfMonitorsAMD(1, &monitor_);
+    for (size_t i = 0; i < gpu_counters_.size(); i++) {
+        GLExtensions::SelectPerfMonitorCountersAMD(monitor_, GL_TRUE, gpu_counters_[i].group,
+                                                   1, &gpu_counters_[i].counter);
+    }
+
+    return true;
+}
+
+void
+PerfCounters::release()
+{
+#if defined(__linux__)
+    for (size_t i = 0; i < cpu_counters_.size(); i++) {
+        for (size_t t = 0; t < cpu_counters_[i].fds.size(); t++)
+            close(cpu_counters_[i].fds[t]);
+    }
+#endif
+    cpu_counters_.clear();
+
+    if (monitor_) {
+        if (counting_)
+            GLExtensions::EndPerfMonitorAMD(monitor_);
+        GLExtensions::DeletePerfMonitorsAMD(1, &monitor_);
+        monitor_ = 0;
+    }
+    gpu_counters_.clear();
+
+    counting_ = false;
+    frames_ = 0;
+}
+
+void
+PerfCounters::frame()
+{
+    if (cpu_counters_.empty() && !monitor_)
+        return;
+
+    if (!counting_) {
+#if defined(__linux__)
+        for (size_t i = 0; i < cpu_counters_.size(); i++) {
+            for (size_t t = 0; t < cpu_counters_[i].fds.size(); t++) {
+                ioctl(cpu_counters_[i].fds[t], PERF_EVENT_IOC_RESET, 0);
+                ioctl(cpu_counters_[i].fds[t], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+        if (monitor_)
+            GLExtensions::BeginPerfMonitorAMD(monitor_);
+        counting_ = true;
+    }
+
+    frames_++;
+}
+
+void
+PerfCounters::finish()
+{
+    if (!counting_)
+        return;
+
+    counting_ = false;
+
+    if (monitor_)
+        GLExtensions::EndPerfMonitorAMD(monitor_);
+
+    read_cpu();
+    read_gpu();
+}
+
+void
+PerfCounters::read_cpu()
+{
+#if defined(__linux__)
+    double cycles = 0.0;
+    double instructions = 0.0;
+
+    for (size_t i = 0; i < cpu_counters_.size(); i++) {
+        const CPUCounter &counter(cpu_counters_[i]);
+        double total = 0.0;
+
+        for (size_t t = 0; t < counter.fds.size(); t++) {
+            /* The value, and the times the counter was enabled and running */
+            uint64_t data[3] = { 0, 0, 0 };
+
+            ioctl(counter.fds[t], PERF_EVENT_IOC_DISABLE, 0);
+            if (read(counter.fds[t], data, sizeof(data)) != sizeof(data))
+                continue;
+
+            /* Scale the counts of the counters multiplexed on the hardware */
+            double value = static_cast<double>(data[0]);
+            if (data[2] > 0 && data[2] < data[1])
+                value *= static_cast<double>(data[1]) / data[2];
+            total += value;
+        }
+
+        if (!strcmp(counter.name, "cycles"))
+            cycles = total;
+        else if (!strcmp(counter.name, "instructions"))
+            instructions = total;
+
+        values_.push_back(Value(std::string("cpu_") + counter.name + "_per_frame",
+                                total / frames_));
+    }
+
+    if (cycles > 0.0 && instructions > 0.0)
+        values_.push_back(Value("cpu_instructions_per_cycle", instructions / cycles));
+#endif
+}
+
+void
+PerfCounters::read_gpu()
+{
+    if (!monitor_)
+        return;
+
+    /* The monitor ends with the last frame, which may still be rendering */
+    GLuint available = 0;
+    while (!available) {
+        GLExtensions::GetPerfMonitorCounterDataAMD(monitor_, GL_PERFMON_RESULT_AVAILABLE_AMD,
+                                                   sizeof(available), &available, 0);
+    }
+
+    GLuint size = 0;
+    GLExtensions::GetPerfMonitorCounterDataAMD(monitor_, GL_PERFMON_RESULT_SIZE_AMD,
+                                               sizeof(size), &size, 0);
+    if (size == 0)
+        return;
+
+    std::vector<GLuint> data(size / sizeof(GLuint));
+    GLint written = 0;
+    GLExtensions::GetPerfMonitorCounterDataAMD(monitor_, GL_PERFMON_RESULT_AMD,
+                                               size, &data[0], &written);
+
+    /* Each result is the group, the counter and a value of the counter type */
+    size_t words = written / sizeof(GLuint);
+    size_t pos = 0;
+
+    while (pos + 3 <= words) {
+        GLuint group = data[pos];
+        GLuint counter = data[pos + 1];
+        const GPUCounter *gpu_counter = 0;
+
+        for (size_t i = 0; i < gpu_counters_.size(); i++) {
+            if (gpu_counters_[i].group == group && gpu_counters_[i].counter == counter)
+                gpu_counter = &gpu_counters_[i];
+        }
+        if (!gpu_counter)
+            break;
+
+        std::string name("gpu_" + value_name(gpu_counter->name));
+
+        if (gpu_counter->type == GL_UNSIGNED_INT64_AMD) {
+            if (pos + 4 > words)
+                break;
+            uint64_t value;
+            memcpy(&value, &data[pos + 2], sizeof(value));
+            values_.push_back(Value(name + "_per_frame",
+                                    static_cast<double>(value) / frames_));
+            pos += 4;
+        }
+        else if (gpu_counter->type == GL_UNSIGNED_INT) {
+            values_.push_back(Value(name + "_per_frame",
+                                    static_cast<double>(data[pos + 2]) / frames_));
+            pos += 3;
+        }
+        else {
+            /* GL_FLOAT and GL_PERCENTAGE_AMD values aren't counts */
+            float value;
+            memcpy(&value, &data[pos + 2], sizeof(value));
+            values_.push_back(Value(name, value));
+            pos += 3;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_PERF_COUNTERS_H_
+#define GLMARK2_PERF_COUNTERS_H_
+
+#include "gl-headers.h"
+
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Samples hardware performance counters over the measured frames of a
+ * benchmark: the CPU counters of the process through Linux perf events
+ * (--perf-counters) and the GPU counters of the driver through
+ * GL_AMD_performance_monitor (--gpu-counters).
+ */
+class PerfCounters
+{
+public:
+    typedef std::pair<std::string, double> Value;
+
+    PerfCounters();
+    ~PerfCounters();
+
+    /**
+     * Opens the counters. The GPU counters need a current context.
+     *
+     * @param cpu whether to open the CPU counters
+     * @param gpu_counters the names of the GPU counters, separated by
+     *        commas, optionally prefixed by their group as "group/counter"
+     *
+     * @return whether any counter could be opened
+     */
+    bool init(bool cpu, const std::string &gpu_counters);
+
+    /**
+     * Closes the counters. Must be called while the context that was
+     * current during init() is still alive.
+     */
+    void release();
+
+    /**
+     * Counts a measured frame. The counters start with the first one.
+     */
+    void frame();
+
+    /**
+     * Stops the counters and reads their values.
+     */
+    void finish();
+
+    /**
+     * Gets the values read by finish(). The values that are counts are
+     * given per frame.
+     */
+    const std::vector<Value> &values() const { return values_; }
+
+private:
+    struct CPUCounter
+    {
+        const char *name;
+        /* The counter of each thread */
+        std::vector<int> fds;
+    };
+
+    struct GPUCounter
+    {
+        std::string name;
+        GLuint group;
+        GLuint counter;
+        GLenum type;
+    };
+
+    bool init_cpu();
+    bool init_gpu(const std::string &names);
+    void read_cpu();
+    void read_gpu();
+
+    std::vector<CPUCounter> cpu_counters_;
+    std::vector<GPUCounter> gpu_counters_;
+    GLuint monitor_;
+    bool counting_;
+    unsigned int frames_;
+    std::vector<Value> values_;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "pipeline-stats.h"
+
+PipelineStats::PipelineStats() :
+    head_(0), pending_(0), active_(false), initialized_(false), frames_(0)
+{
+    for (int s = 0; s < StatisticCount; s++) {
+        targets_[s] = 0;
+        sums_[s] = 0;
+    }
+}
+
+PipelineStats::~PipelineStats()
+{
+    /*
+     * The queries belong to a GL context which may already be gone,
+     * so they are only released explicitly through release().
+     */
+}
+
+bool
+PipelineStats::init()
+{
+    release();
+    frames_ = 0;
+
+    for (int s = 0; s < StatisticCount; s++) {
+        targets_[s] = 0;
+        sums_[s] = 0;
+    }
+
+    if (!GLExtensions::GenQueries || !GLExtensions::DeleteQueries ||
+        !GLExtensions::BeginQuery || !GLExtensions::EndQuery ||
+        !GLExtensions::GetQueryObjectuiv)
+    {
+        return false;
+    }
+
+#if GLMARK2_USE_GLESv2
+    bool primitives_generated = GLExtensions::version_supported(3, 2) ||
+                                GLExtensions::support("GL_EXT_geometry_shader") ||
+                                GLExtensions::support("GL_OES_geometry_shader");
+    bool pipeline_statistics = false;
+#else
+    bool primitives_generated = GLExtensions::version_supported(3, 0) ||
+                                GLExtensions::support("GL_EXT_transform_feedback");
+    bool pipeline_statistics = GLExtensions::version_supported(4, 6) ||
+                               GLExtensions::support("GL_ARB_pipeline_statistics_query");
+#endif
+
+    if (pipeline_statistics) {
+        targets_[StatisticVertices] = GL_VERTICES_SUBMITTED;
+        targets_[StatisticVertexShaderInvocations] = GL_VERTEX_SHADER_INVOCATIONS;
+        targets_[StatisticFragmentShaderInvocations] = GL_FRAGMENT_SHADER_INVOCATIONS;
+    }
+    if (primitives_generated)
+        targets_[StatisticPrimitives] = GL_PRIMITIVES_GENERATED;
+
+    if (!pipeline_statistics && !primitives_generated)
+        return false;
+
+    for (unsigned int i = 0; i < query_count; i++)
+        GLExtensions::GenQueries(StatisticCount, queries_[i]);
+    head_ = 0;
+    pending_ = 0;
+    active_ = false;
+    initialized_ = true;
+
+    return true;
+}
+
+void
+PipelineStats::release()
+{
+    if (!initialized_)
+        return;
+
+    if (active_) {
+        for (int s = 0; s < StatisticCount; s++) {
+            if (targets_[s])
+                GLExtensions::EndQuery(targets_[s]);
+        }
+    }
+
+    for (unsigned int i = 0; i < query_count; i++)
+        GLExtensions::DeleteQueries(StatisticCount, queries_[i]);
+    head_ = 0;
+    pending_ = 0;
+    active_ = false;
+    initialized_ = false;
+}
+
+void
+PipelineStats::begin()
+{
+    if (!initialized_ || active_)
+        return;
+
+    /* Skip counting this frame rather than waiting for free queries */
+    if (pending_ == query_count)
+        collect(false);
+    if (pending_ == query_count)
+        return;
+
+    unsigned int index = (head_ + pending_) % query_count;
+
+    for (int s = 0; s < StatisticCount; s++) {
+        if (targets_[s])
+            GLExtensions::BeginQuery(targets_[s], queries_[index][s]);
+    }
+    active_ = true;
+}
+
+void
+PipelineStats::end()
+{
+    if (!active_)
+        return;
+
+    for (int s = 0; s < StatisticCount; s++) {
+        if (targets_[s])
+            GLExtensions::EndQuery(targets_[s]);
+    }
+    active_ = false;
+    pending_++;
+
+    collect(false);
+}
+
+void
+PipelineStats::collect(bool wait)
+{
+    if (!initialized_)
+        return;
+
+    while (pending_ > 0) {
+        GLuint *queries = queries_[head_];
+
+        if (!wait) {
+            GLuint available = 1;
+            for (int s = 0; s < StatisticCount && available; s++) {
+                if (targets_[s]) {
+                    GLExtensions::GetQueryObjectuiv(queries[s], GL_QUERY_RESULT_AVAILABLE,
+                                                    &available);
+                }
+            }
+            if (!available)
+                break;
+        }
+
+        for (int s = 0; s < StatisticCount; s++) {
+            if (!targets_[s])
+                continue;
+            GLuint count = 0;
+            GLExtensions::GetQueryObjectuiv(queries[s], GL_QUERY_RESULT, &count);
+            sums_[s] += count;
+        }
+        frames_++;
+
+        head_ = (head_ + 1) % query_count;
+        pending_--;
+    }
+}
+
+double
+PipelineStats::per_frame(Statistic statistic) const
+{
+    return frames_ > 0 ? static_cast<double>(sums_[statistic]) / frames_ : 0.0;
+}
+
+const char *
+PipelineStats::name(Statistic statistic)
+{
+    static const char *names[StatisticCount] = {
+        "Vertices", "VertexShaderInvocations", "Primitives", "FragmentShaderInvocations"
+    };
+
+    return names[statistic];
+}
+
+const char *
+PipelineStats::key(Statistic statistic)
+{
+    static const char *keys[StatisticCount] = {
+        "vertices", "vertex_shader_invocations", "primitives", "fragment_shader_invocations"
+    };
+
+    return keys[statistic];
+}
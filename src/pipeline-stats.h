@@ -0,0 +1,124 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_PIPELINE_STATS_H_
+#define GLMARK2_PIPELINE_STATS_H_
+
+#include "gl-headers.h"
+
+#include <stdint.h>
+
+/**
+ * Counts the work the GPU does for the frames (--pipeline-stats): the
+ * vertices submitted, the vertex shader invocations, the primitives
+ * generated and the fragment shader invocations. Normalizing the frame
+ * rate by them (e.g. triangles/s) shows whether indexing or culling
+ * actually reduce the work.
+ *
+ * The primitives use GL_PRIMITIVES_GENERATED (GL 3.0, GLES 3.2), the others
+ * GL_ARB_pipeline_statistics_query, so only the primitives are counted on
+ * GLES. Like the GPUTimer, a small ring of queries is read back a few
+ * frames later, and the frames for which no queries are free are not
+ * counted.
+ */
+class PipelineStats
+{
+public:
+    enum Statistic {
+        StatisticVertices,
+        StatisticVertexShaderInvocations,
+        StatisticPrimitives,
+        StatisticFragmentShaderInvocations,
+        StatisticCount
+    };
+
+    PipelineStats();
+    ~PipelineStats();
+
+    /**
+     * Creates the queries of the supported statistics. Must be called with
+     * a current context.
+     *
+     * @return whether any statistic is supported
+     */
+    bool init();
+
+    /**
+     * Releases the queries. Must be called while the context that was
+     * current during init() is still alive.
+     */
+    void release();
+
+    /**
+     * Starts counting a frame.
+     */
+    void begin();
+
+    /**
+     * Stops counting a frame and collects any available results.
+     */
+    void end();
+
+    /**
+     * Collects the results of all pending queries.
+     *
+     * @param wait whether to wait for results that are not available yet
+     */
+    void collect(bool wait);
+
+    /**
+     * Whether a statistic is counted.
+     */
+    bool counted(Statistic statistic) const { return targets_[statistic] != 0; }
+
+    /**
+     * The number of frames counted.
+     */
+    unsigned int frames() const { return frames_; }
+
+    /**
+     * The mean of a statistic per counted frame.
+     */
+    double per_frame(Statistic statistic) const;
+
+    /**
+     * The name of a statistic in the log, e.g. "Primitives".
+     */
+    static const char *name(Statistic statistic);
+
+    /**
+     * The name of a statistic in the results file, e.g. "primitives".
+     */
+    static const char *key(Statistic statistic);
+
+private:
+    static const unsigned int query_count = 8;
+
+    /* The query target of each statistic, or 0 if it isn't supported */
+    GLenum targets_[StatisticCount];
+    GLuint queries_[query_count][StatisticCount];
+    /* Ring of pending frames: [head_, head_ + pending_) */
+    unsigned int head_;
+    unsigned int pending_;
+    bool active_;
+    bool initialized_;
+    uint64_t sums_[StatisticCount];
+    unsigned int frames_;
+};
+
+#endif /* GLMARK2_PIPELINE_STATS_H_ */
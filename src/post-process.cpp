@@ -0,0 +1,519 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "post-process.h"
+#include "renderer.h"
+#include "scene.h"
+#include "shader-source.h"
+#include "log.h"
+#include "util.h"
+
+#include <algorithm>
+
+namespace
+{
+
+/* The luminance above which the frame contributes to the bloom */
+const float bloom_threshold = 0.7f;
+
+/* The radius of a blur effect without one */
+const unsigned int default_blur_radius = 2;
+
+/**
+ * A renderer whose target is drawn outside the graph, i.e. the frame.
+ */
+class FrameRenderer : public BaseRenderer
+{
+public:
+    virtual void render() {}
+};
+
+/**
+ * A texture renderer that owns its program.
+ */
+class ProgramRenderer : public TextureRenderer
+{
+public:
+    ProgramRenderer(Program *program) :
+        TextureRenderer(*program), owned_program_(program) {}
+    virtual ~ProgramRenderer() { delete owned_program_; }
+
+private:
+    Program *owned_program_;
+};
+
+/**
+ * Tone maps the frame, with the bloom added to it.
+ */
+class ToneMapRenderer : public ProgramRenderer
+{
+public:
+    ToneMapRenderer(Program *program) :
+        ProgramRenderer(program), bloom_texture_(0) {}
+
+    void bloom_texture(GLuint t) { bloom_texture_ = t; }
+
+    virtual void render()
+    {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, bloom_texture_);
+
+        TextureRenderer::render();
+
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    GLuint bloom_texture_;
+};
+
+Program *
+create_program(const std::string &vtx_filename, const std::string &frg_source)
+{
+    Program *program = new Program();
+    ShaderSource vtx_source(Options::data_path + "/shaders/" + vtx_filename);
+
+    if (!Scene::load_shaders_from_strings(*program, vtx_source.str(), frg_source)) {
+        delete program;
+        return 0;
+    }
+
+    program->start();
+    (*program)["Texture0"] = 0;
+    (*program)["uvOffset"] = LibMatrix::vec2(0.0f, 0.0f);
+    (*program)["uvScale"] = LibMatrix::vec2(1.0f, 1.0f);
+    program->stop();
+
+    return program;
+}
+
+Program *
+create_program(const std::string &frg_filename, const std::string &tone_map,
+               const std::string &bloom)
+{
+    ShaderSource frg_source(Options::data_path + "/shaders/" + frg_filename);
+
+    frg_source.replace("$TONE_MAP$", tone_map);
+    frg_source.replace("$BLOOM$", bloom);
+
+    return create_program("terrain-texture.vert", frg_source.str());
+}
+
+}
+
+class PostProcessPrivate
+{
+public:
+    PostProcessPrivate() :
+        bright(0), bloom_h(0), bloom_v(0), tone_map(0) {}
+
+    ~PostProcessPrivate()
+    {
+        delete bright;
+        delete bloom_h;
+        delete bloom_v;
+        for (std::vector<BaseRenderer *>::iterator iter = chain.begin();
+             iter != chain.end();
+             iter++)
+        {
+            delete *iter;
+        }
+    }
+
+    RenderGraph graph;
+    FrameRenderer frame;
+    LibMatrix::vec2 size;
+    ProgramRenderer *bright;
+    BlurRenderer *bloom_h;
+    BlurRenderer *bloom_v;
+    ToneMapRenderer *tone_map;
+    /* The passes from the frame to the output, in order */
+    std::vector<BaseRenderer *> chain;
+    std::string effects;
+};
+
+PostProcess::PostProcess() : priv_(0)
+{
+}
+
+PostProcess::~PostProcess()
+{
+    release();
+}
+
+bool
+PostProcess::enabled()
+{
+    return Options::hdr_format != Options::HdrFormatNone ||
+           !Options::post_process.empty();
+}
+
+bool
+PostProcess::supported(Options::HdrFormat format, bool show_errors)
+{
+    const char *error = 0;
+
+#if GLMARK2_USE_GLESv2
+    bool es3 = GLExtensions::version_supported(3, 0);
+    bool color_buffer_float = es3 && GLExtensions::support("GL_EXT_color_buffer_float");
+
+    if (format == Options::HdrFormatRGBA16F) {
+        if (!color_buffer_float && !GLExtensions::support("GL_EXT_color_buffer_half_float"))
+            error = "--hdr rgba16f requires GL_EXT_color_buffer_half_float";
+        else if (!es3 && !GLExtensions::support("GL_OES_texture_half_float"))
+            error = "--hdr rgba16f requires GL_OES_texture_half_float";
+    }
+    else if (format == Options::HdrFormatR11G11B10F && !color_buffer_float) {
+        error = "--hdr r11g11b10f requires GLES 3.0 and GL_EXT_color_buffer_float";
+    }
+#else
+    /* Both formats are color-renderable in OpenGL 3.0 */
+    if (format != Options::HdrFormatNone && !GLExtensions::version_supported(3, 0))
+        error = "--hdr requires OpenGL 3.0";
+#endif
+
+    if (!error && !GLExtensions::GenFramebuffers)
+        error = "--hdr and --post-process require GL framebuffer support";
+
+    if (error && show_errors)
+        Log::error("%s\n", error);
+
+    return !error;
+}
+
+bool
+PostProcess::init(int width, int height, GLenum depth_format, GLuint output_fbo)
+{
+    release();
+
+    if (!supported(Options::hdr_format, true))
+        return false;
+
+    priv_ = new PostProcessPrivate();
+    PostProcessPrivate &p(*priv_);
+
+    bool hdr = Options::hdr_format != Options::HdrFormatNone;
+    GLenum format = GL_RGBA8;
+    if (Options::hdr_format == Options::HdrFormatRGBA16F)
+        format = GL_RGBA16F;
+    else if (Options::hdr_format == Options::HdrFormatR11G11B10F)
+        format = GL_R11F_G11F_B10F;
+
+    p.size = LibMatrix::vec2(width, height);
+    LibMatrix::vec2 bloom_size(std::max(width / 2, 1), std::max(height / 2, 1));
+
+    /* Half float textures can't always be filtered in GLES2 */
+    GLint filter = GL_LINEAR;
+#if GLMARK2_USE_GLESv2
+    if (hdr && !GLExtensions::version_supported(3, 0) &&
+        !GLExtensions::support("GL_OES_texture_half_float_linear"))
+    {
+        filter = GL_NEAREST;
+    }
+#endif
+
+    /* The frame is rendered outside the graph, so it's kept for the whole frame */
+    p.frame.texture_format(format);
+    p.frame.depth_format(depth_format);
+    p.graph.add_target(p.frame, p.size, true);
+    p.graph.keep(p.frame);
+
+    if (hdr && Options::hdr_bloom) {
+        LibMatrix::vec2 step(1.0f / bloom_size.x(), 1.0f / bloom_size.y());
+
+        Program *bright_program = create_program("hdr-bright.frag", "", "");
+        if (!bright_program) {
+            release();
+            return false;
+        }
+        bright_program->start();
+        (*bright_program)["Threshold"] = bloom_threshold;
+        bright_program->stop();
+
+        p.bright = new ProgramRenderer(bright_program);
+        p.bloom_h = new BlurRenderer(4, 3.0f, BlurRenderer::BlurDirectionHorizontal,
+                                     step, 1.0f);
+        p.bloom_v = new BlurRenderer(4, 3.0f, BlurRenderer::BlurDirectionVertical,
+                                     step, 1.0f);
+
+        BaseRenderer *bloom_targets[] = { p.bright, p.bloom_h, p.bloom_v };
+        for (unsigned int i = 0; i < 3; i++) {
+            bloom_targets[i]->texture_format(format);
+            p.graph.add_target(*bloom_targets[i], bloom_size, false);
+        }
+
+        p.graph.add_pass(*p.bright, std::vector<IRenderer *>(1, &p.frame));
+        p.graph.add_pass(*p.bloom_h, std::vector<IRenderer *>(1, p.bright));
+        p.graph.add_pass(*p.bloom_v, std::vector<IRenderer *>(1, p.bloom_h));
+    }
+
+    if (hdr) {
+        static const char *tone_maps[] = {
+            "return color / (1.0 + color);",
+            "return clamp((color * (2.51 * color + 0.03)) /"
+            " (color * (2.43 * color + 0.59) + 0.14), 0.0, 1.0);"
+        };
+        std::string tone_map(tone_maps[Options::tone_map == Options::ToneMapReinhard ? 0 : 1]);
+        std::string bloom;
+
+        if (Options::hdr_bloom)
+            bloom = "color += 0.6 * texture2D(BloomTexture, vUv).rgb;";
+
+        Program *tone_map_program = create_program("hdr-tone-map.frag", tone_map, bloom);
+        if (!tone_map_program) {
+            release();
+            return false;
+        }
+        if (Options::hdr_bloom) {
+            tone_map_program->start();
+            (*tone_map_program)["BloomTexture"] = 1;
+            tone_map_program->stop();
+        }
+
+        p.tone_map = new ToneMapRenderer(tone_map_program);
+        p.chain.push_back(p.tone_map);
+    }
+
+    /* The effects are separated by ':', e.g. "blur=4:grade" */
+    std::vector<std::string> effects;
+    Util::split(Options::post_process, ':', effects, Util::SplitModeNormal);
+
+    for (std::vector<std::string>::const_iterator iter = effects.begin();
+         iter != effects.end();
+         iter++)
+    {
+        if (!add_effect(*iter)) {
+            release();
+            return false;
+        }
+    }
+
+    /*
+     * Every pass but the last writes an LDR target, which the graph shares
+     * between the passes that are not adjacent, and the last pass writes
+     * the output.
+     */
+    if (p.chain.empty()) {
+        Log::error("--post-process requires at least one effect\n");
+        release();
+        return false;
+    }
+
+    for (size_t i = 0; i + 1 < p.chain.size(); i++)
+        p.graph.add_target(*p.chain[i], p.size, false);
+
+    IRenderer *input = &p.frame;
+    for (std::vector<BaseRenderer *>::iterator iter = p.chain.begin();
+         iter != p.chain.end();
+         iter++)
+    {
+        p.graph.add_pass(**iter, std::vector<IRenderer *>(1, input));
+        input = *iter;
+    }
+
+    p.graph.invalidate(Options::invalidate);
+    p.graph.compile();
+
+    p.frame.setup_texture(filter, GL_NEAREST, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    if (p.bright) {
+        p.bright->setup_texture(filter, filter, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        p.bloom_h->setup_texture(filter, filter, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        p.bloom_v->setup_texture(filter, filter, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        p.tone_map->bloom_texture(p.bloom_v->texture());
+    }
+    for (size_t i = 0; i + 1 < p.chain.size(); i++)
+        p.chain[i]->setup_texture(GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+    p.chain.back()->setup_framebuffer(output_fbo, p.size);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.frame.fbo());
+    GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::error("Failed to create the post-processing framebuffer (status 0x%x)\n",
+                   status);
+        release();
+        return false;
+    }
+
+    Log::debug("Rendering to a %s target, with %u textures for the post-processing\n",
+               description().c_str(), p.graph.texture_count());
+
+    return true;
+}
+
+bool
+PostProcess::add_effect(const std::string &effect)
+{
+    PostProcessPrivate &p(*priv_);
+    LibMatrix::vec2 step(1.0f / p.size.x(), 1.0f / p.size.y());
+
+    /* An effect is NAME or NAME=VALUE */
+    std::string name(effect.substr(0, effect.find('=')));
+    std::string value;
+    if (name.size() < effect.size())
+        value = effect.substr(name.size() + 1);
+
+    if (name == "blur") {
+        unsigned int radius = value.empty() ? default_blur_radius :
+                              Util::fromString<unsigned int>(value);
+        if (radius == 0) {
+            Log::error("Invalid --post-process blur radius '%s'\n", value.c_str());
+            return false;
+        }
+
+        p.chain.push_back(new BlurRenderer(radius, radius, BlurRenderer::BlurDirectionHorizontal,
+                                           step, 1.0f));
+        p.chain.push_back(new BlurRenderer(radius, radius, BlurRenderer::BlurDirectionVertical,
+                                           step, 1.0f));
+        p.effects += ", blur";
+        return true;
+    }
+
+    std::string vtx_filename("terrain-texture.vert");
+    ShaderSource frg_source;
+
+    if (name == "convolution") {
+        std::vector<float> kernel;
+        unsigned int kernel_width = 0;
+        unsigned int kernel_height = 0;
+
+        if (!SceneEffect2D::parse_matrix(value, kernel, kernel_width, kernel_height)) {
+            Log::error("Invalid --post-process convolution kernel '%s'\n", value.c_str());
+            return false;
+        }
+
+        SceneEffect2D::normalize(kernel);
+
+        vtx_filename = "effect-2d.vert";
+        frg_source.append(SceneEffect2D::create_convolution_fragment_shader(step, kernel,
+                                                                            kernel_width,
+                                                                            kernel_height));
+        if (frg_source.str().empty())
+            return false;
+    }
+    else if (name == "grade" || name == "fxaa") {
+        frg_source.append_file(Options::data_path + "/shaders/post-" + name + ".frag");
+        frg_source.add_const("TextureStepX", step.x());
+        frg_source.add_const("TextureStepY", step.y());
+    }
+    else {
+        Log::error("Unknown --post-process effect '%s'\n", name.c_str());
+        return false;
+    }
+
+    if (!value.empty() && name != "convolution") {
+        Log::error("The --post-process effect '%s' takes no value\n", name.c_str());
+        return false;
+    }
+
+    Program *program = create_program(vtx_filename, frg_source.str());
+    if (!program)
+        return false;
+
+    p.chain.push_back(new ProgramRenderer(program));
+    p.effects += ", " + name;
+
+    return true;
+}
+
+void
+PostProcess::release()
+{
+    delete priv_;
+    priv_ = 0;
+}
+
+GLuint
+PostProcess::fbo()
+{
+    return priv_ ? priv_->frame.fbo() : 0;
+}
+
+void
+PostProcess::render()
+{
+    if (!priv_)
+        return;
+
+    PostProcessPrivate &p(*priv_);
+
+    /* Save the state that scenes may set once for all their frames */
+    GLint prev_program = 0;
+    GLint prev_array_buffer = 0;
+    GLint prev_active_texture = 0;
+    GLint prev_texture = 0;
+    GLint prev_viewport[4] = { 0, 0, 0, 0 };
+    GLboolean prev_blend = GL_FALSE;
+    GLboolean prev_depth_test = GL_FALSE;
+    GLboolean prev_depth_mask = GL_TRUE;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prev_program);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prev_array_buffer);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &prev_active_texture);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &prev_texture);
+    glGetIntegerv(GL_VIEWPORT, prev_viewport);
+    glGetBooleanv(GL_BLEND, &prev_blend);
+    glGetBooleanv(GL_DEPTH_TEST, &prev_depth_test);
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &prev_depth_mask);
+
+    /* The passes replace the contents of their targets */
+    glDisable(GL_BLEND);
+
+    p.graph.render();
+
+    /* Restore state */
+    p.frame.make_current();
+    glViewport(prev_viewport[0], prev_viewport[1], prev_viewport[2], prev_viewport[3]);
+    if (prev_blend)
+        glEnable(GL_BLEND);
+    if (!prev_depth_test)
+        glDisable(GL_DEPTH_TEST);
+    glDepthMask(prev_depth_mask);
+    glBindTexture(GL_TEXTURE_2D, prev_texture);
+    glActiveTexture(prev_active_texture);
+    glBindBuffer(GL_ARRAY_BUFFER, prev_array_buffer);
+    glUseProgram(prev_program);
+}
+
+std::string
+PostProcess::description()
+{
+    std::string desc;
+
+    if (Options::hdr_format == Options::HdrFormatR11G11B10F)
+        desc = "R11F_G11F_B10F";
+    else if (Options::hdr_format == Options::HdrFormatRGBA16F)
+        desc = "RGBA16F";
+    else
+        desc = "RGBA8";
+
+    if (Options::hdr_format != Options::HdrFormatNone) {
+        if (Options::hdr_bloom)
+            desc += ", bloom";
+
+        desc += Options::tone_map == Options::ToneMapReinhard ?
+                ", Reinhard tone mapping" : ", ACES tone mapping";
+    }
+
+    if (priv_)
+        desc += priv_->effects;
+
+    return desc;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_POST_PROCESS_H_
+#define GLMARK2_POST_PROCESS_H_
+
+#include <string>
+
+#include "gl-headers.h"
+#include "options.h"
+
+class PostProcessPrivate;
+
+/**
+ * Renders the frames of the scenes to an offscreen target and
+ * post-processes them into the output (--hdr, --post-process).
+ *
+ * The post-processing passes are a RenderGraph of the terrain renderers.
+ * With --hdr, the frame has a floating point format and is tone mapped,
+ * optionally with bloom: a bright pass and a separable blur at half the
+ * size of the frame. The effects of --post-process run next, in order,
+ * and the last pass writes the output.
+ */
+class PostProcess
+{
+public:
+    PostProcess();
+    ~PostProcess();
+
+    /**
+     * Whether the options ask for post-processing.
+     */
+    static bool enabled();
+
+    /**
+     * Whether the current context can render to the HDR format.
+     *
+     * @param format the format of the floating point target
+     * @param show_errors whether to log why the format is not supported
+     */
+    static bool supported(Options::HdrFormat format, bool show_errors);
+
+    /**
+     * Creates the targets and the programs, releasing any previous ones.
+     * Must be called with a current context.
+     *
+     * @param width the width of the frames
+     * @param height the height of the frames
+     * @param depth_format the format of the depth buffer of the frames
+     * @param output_fbo the framebuffer to write the post-processed frames to
+     *
+     * @return whether initialization succeeded
+     */
+    bool init(int width, int height, GLenum depth_format, GLuint output_fbo);
+
+    /**
+     * Releases the targets and the programs.
+     */
+    void release();
+
+    /**
+     * Gets the FBO that the frames are rendered to.
+     */
+    GLuint fbo();
+
+    /**
+     * Post-processes the current frame into the output framebuffer, and
+     * makes the FBO of the frames current again.
+     */
+    void render();
+
+    /**
+     * Describes the passes e.g. "RGBA16F, ACES tone mapping, fxaa".
+     */
+    std::string description();
+
+private:
+    bool add_effect(const std::string &effect);
+
+    PostProcessPrivate *priv_;
+};
+
+#endif /* GLMARK2_POST_PROCESS_H_ */
@@ -0,0 +1,67 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "present-stats.h"
+
+void
+PresentStats::reset()
+{
+    intervals_.reset();
+    latency_.reset();
+    present_time_.reset();
+    missed_vblanks_ = 0;
+    flips_ = 0;
+    copies_ = 0;
+    last_ = Presentation();
+}
+
+void
+PresentStats::add(const Presentation &presentation)
+{
+    const Presentation &p(presentation);
+
+    if (p.mode == Presentation::ModeFlip)
+        flips_++;
+    else if (p.mode == Presentation::ModeCopy)
+        copies_++;
+
+    if (p.submit_time > 0 && p.present_time >= p.submit_time)
+        latency_.add(p.present_time - p.submit_time);
+
+    if (last_.present_time > 0 && p.present_time > last_.present_time) {
+        uint64_t interval = p.present_time - last_.present_time;
+
+        intervals_.add(interval);
+
+        /*
+         * Prefer the vblank counter of the display, and fall back to
+         * rounding the interval to a number of refresh periods.
+         */
+        if (p.sequence > 0 && last_.sequence > 0) {
+            if (p.sequence > last_.sequence + 1)
+                missed_vblanks_ += p.sequence - last_.sequence - 1;
+        }
+        else if (p.refresh > 0) {
+            uint64_t periods = (interval + p.refresh / 2) / p.refresh;
+            if (periods > 1)
+                missed_vblanks_ += periods - 1;
+        }
+    }
+
+    last_ = p;
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_PRESENT_STATS_H_
+#define GLMARK2_PRESENT_STATS_H_
+
+#include "presentation.h"
+#include "frame-stats.h"
+
+/**
+ * Collects the frame pacing statistics of presented frames: the intervals
+ * between presents, the number of missed vblanks and the latency from
+ * swapping a frame to presenting it.
+ */
+class PresentStats
+{
+public:
+    PresentStats() { reset(); }
+
+    /**
+     * Clears all recorded presentations.
+     */
+    void reset();
+
+    /**
+     * Records a presented frame. Frames must be added in present order.
+     */
+    void add(const Presentation &presentation);
+
+    /**
+     * Gets the statistics of the intervals between consecutive presents.
+     */
+    const FrameStats &intervals() const { return intervals_; }
+
+    /**
+     * Gets the statistics of the swap-to-present latency.
+     */
+    const FrameStats &latency() const { return latency_; }
+
+    /**
+     * Records the CPU time spent presenting a frame, e.g. in eglSwapBuffers.
+     */
+    void add_present_time(uint64_t time_us) { present_time_.add(time_us); }
+
+    /**
+     * Gets the statistics of the CPU time spent presenting frames, which
+     * includes any conversion of the frame for the display.
+     */
+    const FrameStats &present_time() const { return present_time_; }
+
+    /**
+     * Gets the number of vblanks in which no new frame was presented.
+     *
+     * With mailbox-like presentation (e.g. --swap-mode=mailbox) frames may
+     * also be replaced before being presented, which is not counted here.
+     */
+    uint64_t missed_vblanks() const { return missed_vblanks_; }
+
+    /**
+     * Gets the number of frames known to have been flipped to the display.
+     */
+    uint64_t flips() const { return flips_; }
+
+    /**
+     * Gets the number of frames known to have been copied to the display,
+     * e.g. by a compositor.
+     */
+    uint64_t copies() const { return copies_; }
+
+private:
+    FrameStats intervals_;
+    FrameStats latency_;
+    FrameStats present_time_;
+    uint64_t missed_vblanks_;
+    uint64_t flips_;
+    uint64_t copies_;
+    Presentation last_;
+};
+
+#endif /* GLMARK2_PRESENT_STATS_H_ */
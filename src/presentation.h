@@ -0,0 +1,58 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_PRESENTATION_H_
+#define GLMARK2_PRESENTATION_H_
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * The timing of a frame that was shown on the display.
+ *
+ * Times are in microseconds, in the clock of Util::get_timestamp_us()
+ * (CLOCK_MONOTONIC).
+ */
+struct Presentation
+{
+    enum Mode {
+        ModeUnknown,
+        /* The frame was scanned out directly */
+        ModeFlip,
+        /* The frame was copied, e.g. by a compositor */
+        ModeCopy
+    };
+
+    Presentation() :
+        submit_time(0), present_time(0), sequence(0), refresh(0), mode(ModeUnknown) {}
+
+    /* When the frame was swapped, 0 if unknown */
+    uint64_t submit_time;
+    /* When the frame started to be scanned out */
+    uint64_t present_time;
+    /* The vblank counter of the display at present_time, 0 if unknown */
+    uint64_t sequence;
+    /* The refresh period of the display in microseconds, 0 if unknown */
+    uint64_t refresh;
+    /* How the frame got to the display */
+    Mode mode;
+};
+
+typedef std::vector<Presentation> PresentationList;
+
+#endif /* GLMARK2_PRESENTATION_H_ */
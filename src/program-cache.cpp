@@ -0,0 +1,223 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "program-cache.h"
+#include "gl-headers.h"
+#include "program.h"
+#include "options.h"
+#include "log.h"
+#include "util.h"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+
+namespace
+{
+
+const char cache_magic[] = "glmark2-program-binary-1";
+
+std::string
+gl_string(GLenum name)
+{
+    const char *str = reinterpret_cast<const char*>(glGetString(name));
+    return str ? str : "";
+}
+
+/* The binaries kept in memory with --precompile-shaders, by key */
+struct MemoryBinary
+{
+    MemoryBinary() : format(0) {}
+
+    unsigned int format;
+    std::vector<unsigned char> binary;
+};
+
+std::map<std::string, MemoryBinary> memory_binaries;
+
+void
+write_u32(std::ostream &out, uint32_t v)
+{
+    out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+}
+
+bool
+read_u32(std::istream &in, uint32_t &v)
+{
+    return static_cast<bool>(in.read(reinterpret_cast<char *>(&v), sizeof(v)));
+}
+
+}
+
+bool
+ProgramCache::enabled()
+{
+    if ((Options::shader_cache.empty() && !Options::precompile_shaders) ||
+        !GLExtensions::GetProgramBinary || !GLExtensions::ProgramBinary)
+    {
+        return false;
+    }
+
+    /* Some implementations expose the functions but no binary formats */
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+    return num_formats > 0;
+}
+
+std::string
+ProgramCache::key(const std::string &vtx_shader, const std::string &frg_shader)
+{
+    std::stringstream ss;
+
+    ss << GLMARK_VERSION << '\n'
+       << gl_string(GL_RENDERER) << '\n'
+       << gl_string(GL_VERSION) << '\n'
+       << vtx_shader.size() << '\n' << vtx_shader
+       << frg_shader.size() << '\n' << frg_shader;
+
+    return ss.str();
+}
+
+std::string
+ProgramCache::filename(const std::string &key)
+{
+    std::stringstream ss;
+
+    ss << Options::shader_cache << "/"
+       << std::hex << std::setw(16) << std::setfill('0') << Util::hash64(key)
+       << ".bin";
+
+    return ss.str();
+}
+
+bool
+ProgramCache::load(Program &program,
+                   const std::string &vtx_shader,
+                   const std::string &frg_shader)
+{
+    if (!enabled())
+        return false;
+
+    std::string k(key(vtx_shader, frg_shader));
+
+    std::map<std::string, MemoryBinary>::const_iterator mem = memory_binaries.find(k);
+    if (mem != memory_binaries.end()) {
+        program.loadBinary(mem->second.format, mem->second.binary);
+        if (program.ready()) {
+            Log::debug("Loaded precompiled program binary\n");
+            return true;
+        }
+    }
+
+    if (Options::shader_cache.empty())
+        return false;
+
+    std::string fname(filename(k));
+    std::ifstream in(fname.c_str(), std::ios::in | std::ios::binary);
+
+    if (!in)
+        return false;
+
+    /*
+     * The file contains the full key, so that hash collisions are detected
+     * instead of feeding the wrong binary to the driver.
+     */
+    std::vector<char> magic(sizeof(cache_magic));
+    uint32_t key_size = 0;
+    uint32_t format = 0;
+    uint32_t binary_size = 0;
+
+    if (!in.read(&magic[0], magic.size()) ||
+        std::string(&magic[0]) != cache_magic ||
+        !read_u32(in, key_size) || key_size != k.size())
+    {
+        return false;
+    }
+
+    std::string file_key(key_size, '\0');
+    if (!in.read(&file_key[0], key_size) || file_key != k ||
+        !read_u32(in, format) || !read_u32(in, binary_size))
+    {
+        return false;
+    }
+
+    std::vector<unsigned char> binary(binary_size);
+    if (binary_size == 0 ||
+        !in.read(reinterpret_cast<char *>(&binary[0]), binary_size))
+    {
+        return false;
+    }
+
+    program.loadBinary(format, binary);
+
+    if (!program.ready()) {
+        Log::debug("Cached program binary %s was rejected\n", fname.c_str());
+        return false;
+    }
+
+    Log::debug("Loaded program binary from %s\n", fname.c_str());
+
+    return true;
+}
+
+void
+ProgramCache::store(Program &program,
+                    const std::string &vtx_shader,
+                    const std::string &frg_shader)
+{
+    if (!enabled())
+        return;
+
+    unsigned int format = 0;
+    std::vector<unsigned char> binary;
+
+    if (!program.getBinary(format, binary))
+        return;
+
+    std::string k(key(vtx_shader, frg_shader));
+
+    if (Options::precompile_shaders) {
+        MemoryBinary &mem(memory_binaries[k]);
+        mem.format = format;
+        mem.binary = binary;
+    }
+
+    if (Options::shader_cache.empty())
+        return;
+
+    std::string fname(filename(k));
+    std::ofstream out(fname.c_str(), std::ios::out | std::ios::binary);
+
+    if (!out) {
+        Log::debug("Cannot open program binary cache file %s\n", fname.c_str());
+        return;
+    }
+
+    out.write(cache_magic, sizeof(cache_magic));
+    write_u32(out, k.size());
+    out.write(k.data(), k.size());
+    write_u32(out, format);
+    write_u32(out, binary.size());
+    out.write(reinterpret_cast<const char *>(&binary[0]), binary.size());
+
+    if (!out)
+        Log::debug("Failed to write program binary cache file %s\n", fname.c_str());
+}
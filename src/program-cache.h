@@ -0,0 +1,70 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_PROGRAM_CACHE_H_
+#define GLMARK2_PROGRAM_CACHE_H_
+
+#include <string>
+
+class Program;
+
+/**
+ * An on-disk cache of program binaries.
+ *
+ * Binaries are keyed on the shader sources and the GL renderer and version
+ * strings, so a driver update or a different GPU just causes cache misses.
+ * The cache is only used if a cache directory has been set with
+ * --shader-cache and the context supports program binaries. With
+ * --precompile-shaders, the binaries are also kept in memory, so that the
+ * scenes load the programs built before the benchmarks run.
+ */
+class ProgramCache
+{
+public:
+    /**
+     * Tries to build a program from a cached binary.
+     *
+     * @param program the program to load the binary into, which must be valid
+     * @param vtx_shader the vertex shader source
+     * @param frg_shader the fragment shader source
+     *
+     * @return whether the program was loaded from the cache and is ready
+     */
+    static bool load(Program &program,
+                     const std::string &vtx_shader,
+                     const std::string &frg_shader);
+
+    /**
+     * Stores the binary of a built program in the cache.
+     *
+     * @param program the program to store, which must be ready
+     * @param vtx_shader the vertex shader source
+     * @param frg_shader the fragment shader source
+     */
+    static void store(Program &program,
+                      const std::string &vtx_shader,
+                      const std::string &frg_shader);
+
+private:
+    static bool enabled();
+    static std::string key(const std::string &vtx_shader,
+                           const std::string &frg_shader);
+    static std::string filename(const std::string &key);
+};
+
+#endif /* GLMARK2_PROGRAM_CACHE_H_ */
@@ -0,0 +1,1035 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "results-file.h"
+#include "log.h"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+
+const char *
+status_str(BenchmarkResult::Status status)
+{
+    switch (status) {
+        case BenchmarkResult::StatusSuccess: return "success";
+        case BenchmarkResult::StatusUnsupported: return "unsupported";
+        case BenchmarkResult::StatusFailure:
+        default:
+            return "failure";
+    }
+}
+
+std::string
+json_string(const std::string &str)
+{
+    std::stringstream ss;
+
+    ss << '"';
+    for (std::string::const_iterator iter = str.begin(); iter != str.end(); iter++) {
+        unsigned char c = *iter;
+        switch (c) {
+            case '"': ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\r': ss << "\\r"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    ss << buf;
+                }
+                else {
+                    ss << c;
+                }
+                break;
+        }
+    }
+    ss << '"';
+
+    return ss.str();
+}
+
+/*
+ * A minimal reader of the JSON written by write_json(), enough to read back
+ * the benchmark results of a previous run.
+ */
+class JsonReader
+{
+public:
+    JsonReader(const std::string &text) : text_(text), pos_(0) {}
+
+    bool peek(char c)
+    {
+        skip_space();
+        return pos_ < text_.size() && text_[pos_] == c;
+    }
+
+    bool expect(char c)
+    {
+        if (!peek(c))
+            return false;
+        pos_++;
+        return true;
+    }
+
+    bool read_string(std::string &str)
+    {
+        if (!expect('"'))
+            return false;
+
+        str.clear();
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c != '\\') {
+                str += c;
+                continue;
+            }
+            if (pos_ >= text_.size())
+                return false;
+            c = text_[pos_++];
+            switch (c) {
+                case 'b': str += '\b'; break;
+                case 'f': str += '\f'; break;
+                case 'n': str += '\n'; break;
+                case 'r': str += '\r'; break;
+                case 't': str += '\t'; break;
+                case 'u': {
+                    if (pos_ + 4 > text_.size())
+                        return false;
+                    unsigned int code = strtoul(text_.substr(pos_, 4).c_str(), 0, 16);
+                    pos_ += 4;
+                    /* Only the control characters are escaped by write_json() */
+                    str += code < 0x80 ? static_cast<char>(code) : '?';
+                    break;
+                }
+                default: str += c; break;
+            }
+        }
+
+        return expect('"');
+    }
+
+    bool read_number(double &value)
+    {
+        skip_space();
+        const char *start = text_.c_str() + pos_;
+        char *end;
+        value = strtod(start, &end);
+        if (end == start)
+            return false;
+        pos_ += end - start;
+        return true;
+    }
+
+    /*
+     * Skips a value of any type.
+     */
+    bool skip_value()
+    {
+        std::string str;
+        double number;
+
+        if (peek('"'))
+            return read_string(str);
+
+        if (expect('{')) {
+            if (expect('}'))
+                return true;
+            do {
+                if (!read_string(str) || !expect(':') || !skip_value())
+                    return false;
+            } while (expect(','));
+            return expect('}');
+        }
+
+        if (expect('[')) {
+            if (expect(']'))
+                return true;
+            do {
+                if (!skip_value())
+                    return false;
+            } while (expect(','));
+            return expect(']');
+        }
+
+        static const char *words[] = { "true", "false", "null" };
+        for (size_t i = 0; i < sizeof(words) / sizeof(*words); i++) {
+            if (text_.compare(pos_, strlen(words[i]), words[i]) == 0) {
+                pos_ += strlen(words[i]);
+                return true;
+            }
+        }
+
+        return read_number(number);
+    }
+
+private:
+    void skip_space()
+    {
+        while (pos_ < text_.size() && isspace(static_cast<unsigned char>(text_[pos_])))
+            pos_++;
+    }
+
+    const std::string &text_;
+    size_t pos_;
+};
+
+BenchmarkResult::Status
+status_from_str(const std::string &str)
+{
+    if (str == "success")
+        return BenchmarkResult::StatusSuccess;
+    else if (str == "unsupported")
+        return BenchmarkResult::StatusUnsupported;
+    else
+        return BenchmarkResult::StatusFailure;
+}
+
+/*
+ * Reads a benchmark object of the "benchmarks" array. Only the fields
+ * identifying the run and its FPS are read.
+ */
+bool
+read_json_result(JsonReader &reader, BenchmarkResult &result)
+{
+    if (!reader.expect('{'))
+        return false;
+    if (reader.expect('}'))
+        return true;
+
+    do {
+        std::string key;
+        std::string str;
+        double number;
+
+        if (!reader.read_string(key) || !reader.expect(':'))
+            return false;
+
+        if (key == "scene" || key == "options" || key == "status") {
+            if (!reader.read_string(str))
+                return false;
+            if (key == "scene")
+                result.scene = str;
+            else if (key == "options")
+                result.options = str;
+            else
+                result.status = status_from_str(str);
+        }
+        else if (key == "width" || key == "height" || key == "repetition" ||
+                 key == "frames" || key == "fps")
+        {
+            if (!reader.read_number(number))
+                return false;
+            if (key == "width")
+                result.width = number;
+            else if (key == "height")
+                result.height = number;
+            else if (key == "repetition")
+                result.repetition = number;
+            else if (key == "frames")
+                result.frames = number;
+            else
+                result.fps = number;
+        }
+        else if (!reader.skip_value()) {
+            return false;
+        }
+    } while (reader.expect(','));
+
+    return reader.expect('}');
+}
+
+std::string
+csv_string(const std::string &str)
+{
+    if (str.find_first_of(",\"\n\r") == std::string::npos)
+        return str;
+
+    std::string quoted("\"");
+    for (std::string::const_iterator iter = str.begin(); iter != str.end(); iter++) {
+        if (*iter == '"')
+            quoted += '"';
+        quoted += *iter;
+    }
+    quoted += '"';
+
+    return quoted;
+}
+
+/* Converts a canvas info name (e.g. "Surface Config") to a key (surface_config) */
+std::string
+info_key(const std::string &name)
+{
+    std::string key;
+
+    for (std::string::const_iterator iter = name.begin(); iter != name.end(); iter++) {
+        char c = *iter;
+        if (c >= 'A' && c <= 'Z')
+            key += c - 'A' + 'a';
+        else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+            key += c;
+        else
+            key += '_';
+    }
+
+    return key;
+}
+
+void
+write_json_summary(std::ostream &out, const char *name,
+                   const FrameStats::Summary &summary)
+{
+    out << "      " << json_string(name) << ": {" << std::endl
+        << "        \"mean\": " << summary.mean << "," << std::endl
+        << "        \"min\": " << summary.min << "," << std::endl
+        << "        \"p50\": " << summary.p50 << "," << std::endl
+        << "        \"p90\": " << summary.p90 << "," << std::endl
+        << "        \"p99\": " << summary.p99 << "," << std::endl
+        << "        \"p99.9\": " << summary.p999 << "," << std::endl
+        << "        \"max\": " << summary.max << "," << std::endl
+        << "        \"stddev\": " << summary.stddev << std::endl
+        << "      }";
+}
+
+void
+write_json_repeat_summary(std::ostream &out, const std::string &indent,
+                          const char *name, const RepeatSummary &summary)
+{
+    out << indent << json_string(name) << ": {" << std::endl
+        << indent << "  \"runs\": " << summary.count << "," << std::endl
+        << indent << "  \"mean\": " << summary.mean << "," << std::endl
+        << indent << "  \"median\": " << summary.median << "," << std::endl
+        << indent << "  \"ci95\": " << summary.ci95 << std::endl
+        << indent << "}";
+}
+
+void
+write_csv_header(std::ostream &out, const char *prefix)
+{
+    static const char *fields[] = {
+        "mean", "min", "p50", "p90", "p99", "p99.9", "max", "stddev"
+    };
+
+    for (size_t i = 0; i < sizeof(fields) / sizeof(*fields); i++)
+        out << "," << prefix << "_" << fields[i] << "_ms";
+}
+
+/* Empty summaries are written as empty fields */
+void
+write_csv_summary(std::ostream &out, const FrameStats::Summary &summary)
+{
+    if (summary.count == 0) {
+        out << ",,,,,,,,";
+        return;
+    }
+
+    out << "," << summary.mean
+        << "," << summary.min
+        << "," << summary.p50
+        << "," << summary.p90
+        << "," << summary.p99
+        << "," << summary.p999
+        << "," << summary.max
+        << "," << summary.stddev;
+}
+
+/* The number of pixels rendered per second, to compare runs at different sizes */
+double
+pixels_per_second(const BenchmarkResult &result)
+{
+    if (result.elapsed_time <= 0.0)
+        return 0.0;
+
+    return static_cast<double>(result.frames) * result.width * result.height /
+           result.elapsed_time;
+}
+
+const FrameStats::Summary &
+find_measurement(const BenchmarkResult &result, const std::string &key)
+{
+    static const FrameStats::Summary empty;
+
+    for (size_t i = 0; i < result.measurements.size(); i++) {
+        if (result.measurements[i].first == key)
+            return result.measurements[i].second;
+    }
+
+    return empty;
+}
+
+/* Rates that a result doesn't report are written as empty fields */
+void
+write_csv_rate(std::ostream &out, const BenchmarkResult &result,
+               const std::string &key)
+{
+    out << ",";
+
+    for (size_t i = 0; i < result.rates.size(); i++) {
+        if (result.rates[i].first == key) {
+            out << result.rates[i].second;
+            return;
+        }
+    }
+}
+
+/*
+ * Writes JSON laid out on several lines on a single one. The strings are
+ * escaped, so only the layout has newlines.
+ */
+void
+write_single_line(std::ostream &out, std::stringstream &ss)
+{
+    std::string line;
+
+    for (bool first = true; std::getline(ss, line); first = false) {
+        size_t start = line.find_first_not_of(' ');
+        if (start != std::string::npos)
+            out << (first ? "" : " ") << line.substr(start);
+    }
+    out << std::endl;
+}
+
+/*
+ * Reads a run of a results history file, written on a single line by
+ * ResultsFile::append_history().
+ */
+bool
+read_history_run(JsonReader &reader, HistoryRun &run)
+{
+    if (!reader.expect('{'))
+        return false;
+    if (reader.expect('}'))
+        return true;
+
+    do {
+        std::string key;
+        std::string str;
+        double number;
+
+        if (!reader.read_string(key) || !reader.expect(':'))
+            return false;
+
+        if (key == "time" || key == "score") {
+            if (!reader.read_number(number))
+                return false;
+            if (key == "time")
+                run.time = static_cast<int64_t>(number);
+            else
+                run.score = number;
+        }
+        else if (key == "version") {
+            if (!reader.read_string(run.version))
+                return false;
+        }
+        else if (key == "canvas") {
+            if (!reader.expect('{'))
+                return false;
+            while (!reader.expect('}')) {
+                std::string value;
+                if (!reader.read_string(str) || !reader.expect(':') ||
+                    !reader.read_string(value))
+                {
+                    return false;
+                }
+                run.canvas.push_back(std::make_pair(str, value));
+                reader.expect(',');
+            }
+        }
+        else if (key == "benchmarks") {
+            if (!reader.expect('['))
+                return false;
+            while (!reader.expect(']')) {
+                BenchmarkResult result;
+                if (!read_json_result(reader, result))
+                    return false;
+                run.results.push_back(result);
+                reader.expect(',');
+            }
+        }
+        else if (!reader.skip_value()) {
+            return false;
+        }
+    } while (reader.expect(','));
+
+    return reader.expect('}');
+}
+
+void
+write_json_benchmark(std::ostream &out, const BenchmarkResult &r)
+{
+    out << "    {" << std::endl
+        << "      \"scene\": " << json_string(r.scene) << "," << std::endl
+        << "      \"options\": " << json_string(r.options) << "," << std::endl
+        << "      \"width\": " << r.width << "," << std::endl
+        << "      \"height\": " << r.height << "," << std::endl
+        << "      \"repetition\": " << r.repetition << "," << std::endl
+        << "      \"status\": " << json_string(status_str(r.status)) << "," << std::endl
+        << "      \"frames\": " << r.frames << "," << std::endl
+        << "      \"elapsed_time_s\": " << r.elapsed_time << "," << std::endl
+        << "      \"fps\": " << r.fps << "," << std::endl
+        << "      \"pixels_per_second\": " << pixels_per_second(r);
+    if (r.status == BenchmarkResult::StatusSuccess) {
+        out << "," << std::endl;
+        write_json_summary(out, "frame_time_ms", r.frame_time);
+    }
+    if (r.gpu_time.count > 0) {
+        out << "," << std::endl;
+        write_json_summary(out, "gpu_time_ms", r.gpu_time);
+    }
+    for (size_t i = 0; i < r.measurements.size(); i++) {
+        out << "," << std::endl;
+        write_json_summary(out, (r.measurements[i].first + "_ms").c_str(),
+                           r.measurements[i].second);
+    }
+    for (size_t i = 0; i < r.rates.size(); i++) {
+        out << "," << std::endl
+            << "      " << json_string(r.rates[i].first) << ": "
+            << r.rates[i].second;
+    }
+    out << std::endl << "    }";
+}
+
+}
+
+RepeatSummary
+RepeatSummary::from_values(const std::vector<double> &values)
+{
+    /* The two-sided 95% critical values of the t-distribution, by degrees of freedom */
+    static const double t95[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    static const unsigned int t95_count = sizeof(t95) / sizeof(*t95);
+
+    RepeatSummary summary;
+
+    summary.count = values.size();
+    if (values.empty())
+        return summary;
+
+    double sum = 0.0;
+    for (size_t i = 0; i < values.size(); i++)
+        sum += values[i];
+    summary.mean = sum / values.size();
+
+    std::vector<double> sorted(values);
+    std::sort(sorted.begin(), sorted.end());
+    size_t mid = sorted.size() / 2;
+    if (sorted.size() % 2 == 0)
+        summary.median = (sorted[mid - 1] + sorted[mid]) / 2.0;
+    else
+        summary.median = sorted[mid];
+
+    if (values.size() > 1) {
+        double sq_sum = 0.0;
+        for (size_t i = 0; i < values.size(); i++)
+            sq_sum += (values[i] - summary.mean) * (values[i] - summary.mean);
+
+        unsigned int df = values.size() - 1;
+        double stddev = std::sqrt(sq_sum / df);
+        /* Use the normal distribution for large numbers of runs */
+        double t = df <= t95_count ? t95[df - 1] : 1.96;
+
+        summary.ci95 = t * stddev / std::sqrt(static_cast<double>(values.size()));
+    }
+
+    return summary;
+}
+
+std::vector<BenchmarkSummary>
+BenchmarkSummary::from_results(const std::vector<BenchmarkResult> &results)
+{
+    std::vector<BenchmarkSummary> summaries;
+    std::vector<std::vector<double> > values;
+
+    for (std::vector<BenchmarkResult>::const_iterator iter = results.begin();
+         iter != results.end();
+         iter++)
+    {
+        size_t i = 0;
+        while (i < summaries.size() &&
+               (summaries[i].scene != iter->scene ||
+                summaries[i].options != iter->options ||
+                summaries[i].width != iter->width ||
+                summaries[i].height != iter->height))
+        {
+            i++;
+        }
+
+        if (i == summaries.size()) {
+            BenchmarkSummary summary;
+            summary.scene = iter->scene;
+            summary.options = iter->options;
+            summary.width = iter->width;
+            summary.height = iter->height;
+            summaries.push_back(summary);
+            values.push_back(std::vector<double>());
+        }
+
+        if (iter->status == BenchmarkResult::StatusSuccess)
+            values[i].push_back(iter->fps);
+    }
+
+    for (size_t i = 0; i < summaries.size(); i++)
+        summaries[i].fps = RepeatSummary::from_values(values[i]);
+
+    return summaries;
+}
+
+RepeatSummary
+BenchmarkSummary::score(const std::vector<BenchmarkResult> &results)
+{
+    std::vector<double> sums;
+    std::vector<unsigned int> counts;
+
+    for (std::vector<BenchmarkResult>::const_iterator iter = results.begin();
+         iter != results.end();
+         iter++)
+    {
+        if (iter->status != BenchmarkResult::StatusSuccess)
+            continue;
+
+        if (iter->repetition > sums.size()) {
+            sums.resize(iter->repetition, 0.0);
+            counts.resize(iter->repetition, 0);
+        }
+
+        sums[iter->repetition - 1] += iter->fps;
+        counts[iter->repetition - 1]++;
+    }
+
+    std::vector<double> scores;
+    for (size_t i = 0; i < sums.size(); i++) {
+        if (counts[i] > 0)
+            scores.push_back(sums[i] / counts[i]);
+    }
+
+    return RepeatSummary::from_values(scores);
+}
+
+ResultsFile::Format
+ResultsFile::format_from_filename(const std::string &filename)
+{
+    static const std::string csv_ext(".csv");
+
+    if (filename.size() >= csv_ext.size() &&
+        filename.compare(filename.size() - csv_ext.size(), csv_ext.size(), csv_ext) == 0)
+    {
+        return FormatCSV;
+    }
+
+    return FormatJSON;
+}
+
+bool
+ResultsFile::write(const std::string &filename,
+                   const Canvas::InfoList &canvas_info,
+                   const std::vector<BenchmarkResult> &results,
+                   const std::vector<SoakSample> &soak_samples,
+                   unsigned int score)
+{
+    std::ofstream out(filename.c_str());
+
+    if (!out) {
+        Log::error("Cannot open results file %s\n", filename.c_str());
+        return false;
+    }
+
+    out << std::fixed << std::setprecision(3);
+
+    if (format_from_filename(filename) == FormatCSV)
+        write_csv(out, canvas_info, results);
+    else
+        write_json(out, canvas_info, results, soak_samples, score);
+
+    if (!out) {
+        Log::error("Failed to write results file %s\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool
+ResultsFile::read(const std::string &filename, std::vector<BenchmarkResult> &results)
+{
+    std::ifstream in(filename.c_str());
+
+    if (!in) {
+        Log::error("Cannot open results file %s\n", filename.c_str());
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << in.rdbuf();
+    std::string text(ss.str());
+    JsonReader reader(text);
+    bool found = false;
+    bool valid = reader.expect('{');
+
+    while (valid && !reader.peek('}')) {
+        std::string key;
+
+        valid = reader.read_string(key) && reader.expect(':');
+        if (valid && key == "benchmarks") {
+            found = reader.expect('[');
+            valid = found;
+            while (valid && !reader.expect(']')) {
+                BenchmarkResult result;
+                valid = read_json_result(reader, result);
+                if (valid) {
+                    results.push_back(result);
+                    reader.expect(',');
+                }
+            }
+        }
+        else if (valid) {
+            valid = reader.skip_value();
+        }
+
+        if (valid && !reader.expect(','))
+            break;
+    }
+
+    if (!valid || !found) {
+        Log::error("Failed to read the benchmarks of results file %s, "
+                   "only JSON results files can be read\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void
+ResultsFile::write_json_line(std::ostream &out, const BenchmarkResult &result)
+{
+    std::stringstream ss;
+
+    ss << std::fixed << std::setprecision(3);
+    write_json_benchmark(ss, result);
+
+    write_single_line(out, ss);
+}
+
+bool
+ResultsFile::append_history(const std::string &filename,
+                            const Canvas::InfoList &canvas_info,
+                            const std::vector<BenchmarkResult> &results,
+                            unsigned int score)
+{
+    std::ofstream out(filename.c_str(), std::ios::app);
+
+    if (!out) {
+        Log::error("Cannot open results history file %s\n", filename.c_str());
+        return false;
+    }
+
+    std::stringstream ss;
+
+    ss << std::fixed << std::setprecision(3)
+       << "{" << std::endl
+       << "\"time\": " << static_cast<int64_t>(time(0)) << "," << std::endl
+       << "\"version\": " << json_string(GLMARK_VERSION) << "," << std::endl
+       << "\"canvas\": {";
+    for (Canvas::InfoList::const_iterator iter = canvas_info.begin();
+         iter != canvas_info.end();
+         iter++)
+    {
+        ss << (iter == canvas_info.begin() ? "" : ",") << std::endl
+           << json_string(info_key(iter->first)) << ": " << json_string(iter->second);
+    }
+    ss << std::endl << "}," << std::endl
+       << "\"benchmarks\": [";
+    for (std::vector<BenchmarkResult>::const_iterator iter = results.begin();
+         iter != results.end();
+         iter++)
+    {
+        ss << (iter == results.begin() ? "" : ",") << std::endl;
+        write_json_benchmark(ss, *iter);
+    }
+    ss << std::endl << "]," << std::endl
+       << "\"score\": " << score << std::endl
+       << "}" << std::endl;
+
+    /* A whole line at once, so that an interrupted run leaves one bad line */
+    std::stringstream line;
+    write_single_line(line, ss);
+    out << line.str() << std::flush;
+
+    if (!out) {
+        Log::error("Failed to write results history file %s\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool
+ResultsFile::read_history(const std::string &filename, std::vector<HistoryRun> &runs)
+{
+    std::ifstream in(filename.c_str());
+
+    if (!in) {
+        Log::error("Cannot open results history file %s\n", filename.c_str());
+        return false;
+    }
+
+    std::string line;
+
+    for (unsigned int number = 1; std::getline(in, line); number++) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        JsonReader reader(line);
+        HistoryRun run;
+
+        if (read_history_run(reader, run)) {
+            runs.push_back(run);
+        }
+        else {
+            Log::info("Warning: skipping line %u of results history file %s,"
+                      " which can't be read\n", number, filename.c_str());
+        }
+    }
+
+    return true;
+}
+
+bool
+ResultsFile::write_devices(const std::string &filename,
+                           const std::vector<DeviceResults> &devices)
+{
+    std::ofstream out(filename.c_str());
+
+    if (!out) {
+        Log::error("Cannot open results file %s\n", filename.c_str());
+        return false;
+    }
+
+    out << "{" << std::endl;
+    out << "  \"version\": " << json_string(GLMARK_VERSION) << "," << std::endl;
+    out << "  \"devices\": [";
+    for (std::vector<DeviceResults>::const_iterator iter = devices.begin();
+         iter != devices.end();
+         iter++)
+    {
+        /* The results of each device are nested as they were written */
+        std::string json(iter->json);
+        while (!json.empty() && (json[json.size() - 1] == '\n' || json[json.size() - 1] == ' '))
+            json.erase(json.size() - 1);
+
+        out << (iter == devices.begin() ? "" : ",") << std::endl;
+        out << "    {" << std::endl
+            << "      \"device\": " << json_string(iter->device) << "," << std::endl
+            << "      \"exit_status\": " << iter->exit_status << "," << std::endl
+            << "      \"results\": " << (json.empty() ? "null" : json) << std::endl
+            << "    }";
+    }
+    out << std::endl << "  ]" << std::endl;
+    out << "}" << std::endl;
+
+    if (!out) {
+        Log::error("Failed to write results file %s\n", filename.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void
+ResultsFile::write_json(std::ostream &out,
+                        const Canvas::InfoList &canvas_info,
+                        const std::vector<BenchmarkResult> &results,
+                        const std::vector<SoakSample> &soak_samples,
+                        unsigned int score)
+{
+    out << "{" << std::endl;
+    out << "  \"version\": " << json_string(GLMARK_VERSION) << "," << std::endl;
+
+    out << "  \"canvas\": {";
+    for (Canvas::InfoList::const_iterator iter = canvas_info.begin();
+         iter != canvas_info.end();
+         iter++)
+    {
+        out << (iter == canvas_info.begin() ? "" : ",") << std::endl
+            << "    " << json_string(info_key(iter->first)) << ": "
+            << json_string(iter->second);
+    }
+    out << std::endl << "  }," << std::endl;
+
+    out << "  \"benchmarks\": [";
+    for (std::vector<BenchmarkResult>::const_iterator iter = results.begin();
+         iter != results.end();
+         iter++)
+    {
+        out << (iter == results.begin() ? "" : ",") << std::endl;
+        write_json_benchmark(out, *iter);
+    }
+    out << std::endl << "  ]," << std::endl;
+
+    /* The summaries of the repeated runs, with --repeat */
+    bool repeated = false;
+    for (size_t i = 0; i < results.size(); i++)
+        repeated = repeated || results[i].repetition > 1;
+
+    if (repeated) {
+        std::vector<BenchmarkSummary> summaries(BenchmarkSummary::from_results(results));
+
+        out << "  \"summaries\": [";
+        for (std::vector<BenchmarkSummary>::const_iterator iter = summaries.begin();
+             iter != summaries.end();
+             iter++)
+        {
+            out << (iter == summaries.begin() ? "" : ",") << std::endl;
+            out << "    {" << std::endl
+                << "      \"scene\": " << json_string(iter->scene) << "," << std::endl
+                << "      \"options\": " << json_string(iter->options) << "," << std::endl
+                << "      \"width\": " << iter->width << "," << std::endl
+                << "      \"height\": " << iter->height << "," << std::endl;
+            write_json_repeat_summary(out, "      ", "fps", iter->fps);
+            out << std::endl << "    }";
+        }
+        out << std::endl << "  ]," << std::endl;
+
+        write_json_repeat_summary(out, "  ", "score_summary",
+                                  BenchmarkSummary::score(results));
+        out << "," << std::endl;
+    }
+
+    /* The time series of a soak run, with --soak */
+    if (!soak_samples.empty()) {
+        out << "  \"soak\": [";
+        for (std::vector<SoakSample>::const_iterator iter = soak_samples.begin();
+             iter != soak_samples.end();
+             iter++)
+        {
+            out << (iter == soak_samples.begin() ? "" : ",") << std::endl;
+            out << "    {" << std::endl
+                << "      \"time_s\": " << iter->time << "," << std::endl
+                << "      \"fps\": " << iter->fps << "," << std::endl
+                << "      \"scene\": " << json_string(iter->scene) << "," << std::endl
+                << "      \"options\": " << json_string(iter->options);
+            for (size_t i = 0; i < iter->sensors.size(); i++) {
+                out << "," << std::endl
+                    << "      " << json_string(iter->sensors[i].first) << ": "
+                    << iter->sensors[i].second;
+            }
+            out << std::endl << "    }";
+        }
+        out << std::endl << "  ]," << std::endl;
+    }
+
+    out << "  \"score\": " << score << std::endl;
+    out << "}" << std::endl;
+}
+
+void
+ResultsFile::write_csv(std::ostream &out,
+                       const Canvas::InfoList &canvas_info,
+                       const std::vector<BenchmarkResult> &results)
+{
+    /*
+     * Scene specific measurements get their own columns, which are empty
+     * for the scenes that don't report them.
+     */
+    std::vector<std::string> keys;
+    for (std::vector<BenchmarkResult>::const_iterator iter = results.begin();
+         iter != results.end();
+         iter++)
+    {
+        for (size_t i = 0; i < iter->measurements.size(); i++) {
+            const std::string &key(iter->measurements[i].first);
+            if (std::find(keys.begin(), keys.end(), key) == keys.end())
+                keys.push_back(key);
+        }
+    }
+
+    std::vector<std::string> rate_keys;
+    for (std::vector<BenchmarkResult>::const_iterator iter = results.begin();
+         iter != results.end();
+         iter++)
+    {
+        for (size_t i = 0; i < iter->rates.size(); i++) {
+            const std::string &key(iter->rates[i].first);
+            if (std::find(rate_keys.begin(), rate_keys.end(), key) == rate_keys.end())
+                rate_keys.push_back(key);
+        }
+    }
+
+    out << "scene,options,width,height,repetition,status,frames,elapsed_time_s,fps,pixels_per_second";
+    write_csv_header(out, "frame_time");
+    write_csv_header(out, "gpu_time");
+    for (size_t i = 0; i < keys.size(); i++)
+        write_csv_header(out, keys[i].c_str());
+    for (size_t i = 0; i < rate_keys.size(); i++)
+        out << "," << rate_keys[i];
+
+    /* The canvas information is repeated on each row as extra columns */
+    for (Canvas::InfoList::const_iterator iter = canvas_info.begin();
+         iter != canvas_info.end();
+         iter++)
+    {
+        out << "," << info_key(iter->first);
+    }
+    out << std::endl;
+
+    for (std::vector<BenchmarkResult>::const_iterator iter = results.begin();
+         iter != results.end();
+         iter++)
+    {
+        const BenchmarkResult &r(*iter);
+
+        out << csv_string(r.scene) << ","
+            << csv_string(r.options) << ","
+            << r.width << ","
+            << r.height << ","
+            << r.repetition << ","
+            << status_str(r.status) << ","
+            << r.frames << ","
+            << r.elapsed_time << ","
+            << r.fps << ","
+            << pixels_per_second(r);
+        write_csv_summary(out, r.frame_time);
+        write_csv_summary(out, r.gpu_time);
+        for (size_t i = 0; i < keys.size(); i++)
+            write_csv_summary(out, find_measurement(r, keys[i]));
+        for (size_t i = 0; i < rate_keys.size(); i++)
+            write_csv_rate(out, r, rate_keys[i]);
+
+        for (Canvas::InfoList::const_iterator info_iter = canvas_info.begin();
+             info_iter != canvas_info.end();
+             info_iter++)
+        {
+            out << "," << csv_string(info_iter->second);
+        }
+        out << std::endl;
+    }
+}
@@ -0,0 +1,270 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_RESULTS_FILE_H_
+#define GLMARK2_RESULTS_FILE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "canvas.h"
+#include "frame-stats.h"
+#include "system-monitor.h"
+
+/**
+ * The outcome of a single benchmark run.
+ */
+struct BenchmarkResult
+{
+    enum Status {
+        StatusSuccess,
+        StatusUnsupported,
+        StatusFailure
+    };
+
+    BenchmarkResult() :
+        status(StatusFailure), width(0), height(0), repetition(1), frames(0),
+        elapsed_time(0.0), fps(0) {}
+
+    std::string scene;
+    std::string options;
+    Status status;
+    /* The size of the canvas the benchmark was run at */
+    int width;
+    int height;
+    /* Which of the --repeat runs of the benchmark this is, starting at 1 */
+    unsigned int repetition;
+    unsigned int frames;
+    double elapsed_time;        // seconds
+    unsigned int fps;
+    FrameStats::Summary frame_time;
+    /* Only valid if gpu_time.count > 0 */
+    FrameStats::Summary gpu_time;
+    /* Scene specific measurements, keyed by name (e.g. "compile_time") */
+    std::vector<std::pair<std::string, FrameStats::Summary> > measurements;
+    /* Scene specific rates, keyed by name (e.g. "draws_per_second") */
+    std::vector<std::pair<std::string, double> > rates;
+};
+
+/**
+ * The mean, median and 95% confidence interval of repeated measurements.
+ */
+struct RepeatSummary
+{
+    RepeatSummary() : count(0), mean(0.0), median(0.0), ci95(0.0) {}
+
+    /**
+     * Summarizes a set of values.
+     *
+     * The confidence interval of the mean uses Student's t-distribution,
+     * so it is valid for small numbers of runs of normally distributed
+     * values.
+     */
+    static RepeatSummary from_values(const std::vector<double> &values);
+
+    unsigned int count;
+    double mean;
+    double median;
+    /* The half-width of the confidence interval, 0 for fewer than 2 values */
+    double ci95;
+};
+
+/**
+ * The summary of the repeated runs of a benchmark with the same options and
+ * size.
+ */
+struct BenchmarkSummary
+{
+    BenchmarkSummary() : width(0), height(0) {}
+
+    /**
+     * Summarizes the FPS of the successful runs of each benchmark, in the
+     * order the benchmarks were first run.
+     */
+    static std::vector<BenchmarkSummary> from_results(const std::vector<BenchmarkResult> &results);
+
+    /**
+     * Summarizes the score (the average FPS of the successful runs) of each
+     * repetition.
+     */
+    static RepeatSummary score(const std::vector<BenchmarkResult> &results);
+
+    std::string scene;
+    std::string options;
+    int width;
+    int height;
+    RepeatSummary fps;
+};
+
+/**
+ * A sample of the FPS and system sensors during a soak run (--soak).
+ */
+struct SoakSample
+{
+    SoakSample() : time(0.0), fps(0.0) {}
+
+    /* The end of the sampling interval, in seconds since the start */
+    double time;
+    /* The average FPS over the sampling interval */
+    double fps;
+    /* The benchmark running at the end of the interval */
+    std::string scene;
+    std::string options;
+    SystemMonitor::Readings sensors;
+};
+
+/**
+ * A run recorded in a results history file (--history-file).
+ */
+struct HistoryRun
+{
+    HistoryRun() : time(0), score(0) {}
+
+    /* When the run ended, in seconds since the epoch */
+    int64_t time;
+    std::string version;
+    /* The canvas information, keyed as in the results file (e.g. "gl_renderer") */
+    std::vector<std::pair<std::string, std::string> > canvas;
+    unsigned int score;
+    std::vector<BenchmarkResult> results;
+};
+
+/**
+ * The outcome of running the benchmarks on one device (--all-devices).
+ */
+struct DeviceResults
+{
+    DeviceResults() : exit_status(-1), score(0) {}
+
+    /* The name of the device, as selected with --device */
+    std::string device;
+    /* The exit status of the run, -1 if it didn't exit normally */
+    int exit_status;
+    /* The JSON results file of the run, empty if none was written */
+    std::string json;
+    unsigned int score;
+};
+
+/**
+ * Writes benchmark results in a machine-readable format.
+ */
+class ResultsFile
+{
+public:
+    enum Format {
+        FormatJSON,
+        FormatCSV
+    };
+
+    /**
+     * Gets the output format implied by a file name.
+     *
+     * Files ending in ".csv" are written as CSV, everything else as JSON.
+     */
+    static Format format_from_filename(const std::string &filename);
+
+    /**
+     * Writes the results to a file.
+     *
+     * @param filename the file to write to
+     * @param canvas_info information about the canvas used for the run
+     * @param results the benchmark results
+     * @param soak_samples the soak samples, which are only written in JSON
+     * @param score the overall glmark2 score
+     *
+     * @return whether writing succeeded
+     */
+    static bool write(const std::string &filename,
+                      const Canvas::InfoList &canvas_info,
+                      const std::vector<BenchmarkResult> &results,
+                      const std::vector<SoakSample> &soak_samples,
+                      unsigned int score);
+
+    /**
+     * Reads the benchmark results of a JSON results file, e.g. to compare
+     * a run to a baseline (--compare-to). Only the fields identifying each
+     * run and its FPS are read.
+     *
+     * @param filename the file to read
+     * @param results the results read
+     *
+     * @return whether reading succeeded
+     */
+    static bool read(const std::string &filename, std::vector<BenchmarkResult> &results);
+
+    /**
+     * Writes the JSON object of a benchmark result on a single line, e.g.
+     * to stream the results of a server (--serve).
+     *
+     * @param out the stream to write to
+     * @param result the benchmark result
+     */
+    static void write_json_line(std::ostream &out, const BenchmarkResult &result);
+
+    /**
+     * Appends a run to a results history file, as a JSON object on a single
+     * line, so that the file is never rewritten.
+     *
+     * @param filename the file to append to
+     * @param canvas_info information about the canvas used for the run
+     * @param results the benchmark results
+     * @param score the overall glmark2 score
+     *
+     * @return whether writing succeeded
+     */
+    static bool append_history(const std::string &filename,
+                               const Canvas::InfoList &canvas_info,
+                               const std::vector<BenchmarkResult> &results,
+                               unsigned int score);
+
+    /**
+     * Reads the runs of a results history file, oldest first. As with
+     * read(), only the fields identifying each benchmark run and its FPS
+     * are read. Lines that can't be read, e.g. the last one of a run that
+     * was interrupted while writing, are skipped with a warning.
+     *
+     * @param filename the file to read
+     * @param runs the runs read
+     *
+     * @return whether the file could be opened
+     */
+    static bool read_history(const std::string &filename, std::vector<HistoryRun> &runs);
+
+    /**
+     * Writes the merged JSON results of runs on several devices to a file.
+     *
+     * @param filename the file to write to
+     * @param devices the results of each device
+     *
+     * @return whether writing succeeded
+     */
+    static bool write_devices(const std::string &filename,
+                              const std::vector<DeviceResults> &devices);
+
+private:
+    static void write_json(std::ostream &out,
+                           const Canvas::InfoList &canvas_info,
+                           const std::vector<BenchmarkResult> &results,
+                           const std::vector<SoakSample> &soak_samples,
+                           unsigned int score);
+    static void write_csv(std::ostream &out,
+                          const Canvas::InfoList &canvas_info,
+                          const std::vector<BenchmarkResult> &results);
+};
+
+#endif /* GLMARK2_RESULTS_FILE_H_ */
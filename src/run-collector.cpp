@@ -0,0 +1,741 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "run-collector.h"
+#include "scene.h"
+#include "canvas.h"
+#include "options.h"
+#include "log.h"
+#include "util.h"
+#include "state-tracker.h"
+#include "flush-points.h"
+#include "alloc-counter.h"
+#include "metrics-server.h"
+
+#include <algorithm>
+#include <cmath>
+
+void
+RunCollector::log_measurement(const std::string &name, const FrameStats &stats)
+{
+    static const char *format =
+        "    %s (ms): mean: %.3f p50: %.3f p90: %.3f p99: %.3f max: %.3f\n";
+
+    Log::info(format, name.c_str(),
+              stats.mean_ms(), stats.percentile_ms(50.0),
+              stats.percentile_ms(90.0), stats.percentile_ms(99.0),
+              stats.max_ms());
+}
+
+/*************************
+ * ContextResetCollector *
+ *************************/
+
+void
+ContextResetCollector::reset()
+{
+    time_.reset();
+
+    if (Options::reuse_context)
+        return;
+
+    uint64_t start = Util::get_timestamp_us();
+    canvas_.reset();
+    time_.add(Util::get_timestamp_us() - start);
+}
+
+void
+ContextResetCollector::log(Scene & /* scene */) const
+{
+    if (time_.count() > 0)
+        Log::info("    ContextReset (ms): %.3f\n", time_.mean_ms());
+}
+
+void
+ContextResetCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (time_.count() > 0)
+        result.measurements.push_back(std::make_pair("context_reset", time_.summary()));
+}
+
+/*******************
+ * MemoryCollector *
+ *******************/
+
+/*
+ * The memory before the setup of the scene is taken once its context has
+ * been reset, so the memory retained is the scene's own.
+ */
+void
+MemoryCollector::reset()
+{
+    started_ = false;
+    if (Options::memory_usage)
+        monitor_.begin();
+}
+
+void
+MemoryCollector::start(Scene & /* scene */)
+{
+    started_ = true;
+    if (Options::memory_usage)
+        monitor_.sample(true);
+}
+
+void
+MemoryCollector::end_frame(Scene & /* scene */)
+{
+    if (Options::memory_usage)
+        monitor_.sample();
+}
+
+void
+MemoryCollector::finish()
+{
+    if (Options::memory_usage && started_)
+        monitor_.end();
+}
+
+void
+MemoryCollector::log(Scene & /* scene */) const
+{
+    if (!Options::memory_usage || !monitor_.sampled())
+        return;
+
+    Log::info("    Memory (MiB): rss: %.1f peak: %.1f",
+              monitor_.rss_mib(), monitor_.peak_rss_mib());
+    if (monitor_.gpu_mib() >= 0.0) {
+        Log::info(" gpu: %.1f peak: %.1f source: %s",
+                  monitor_.gpu_mib(), monitor_.peak_gpu_mib(),
+                  monitor_.gpu_source().c_str());
+    }
+    Log::info("\n");
+}
+
+void
+MemoryCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (!Options::memory_usage || !monitor_.sampled())
+        return;
+
+    result.rates.push_back(std::make_pair("rss_mib", monitor_.rss_mib()));
+    result.rates.push_back(std::make_pair("peak_rss_mib", monitor_.peak_rss_mib()));
+    if (monitor_.gpu_mib() >= 0.0) {
+        result.rates.push_back(std::make_pair("gpu_memory_mib", monitor_.gpu_mib()));
+        result.rates.push_back(
+            std::make_pair("peak_gpu_memory_mib", monitor_.peak_gpu_mib()));
+    }
+}
+
+/*
+ * The memory retained after the teardown of a scene, compared to before
+ * its setup, is only known once it has been logged and recorded.
+ */
+void
+MemoryCollector::after_teardown(BenchmarkResult &result)
+{
+    if (!Options::memory_usage || !monitor_.sampled())
+        return;
+
+    monitor_.after_teardown();
+
+    Log::info("    MemoryRetained (MiB): rss: %+.1f", monitor_.retained_rss_mib());
+    result.rates.push_back(
+        std::make_pair("retained_rss_mib", monitor_.retained_rss_mib()));
+
+    if (monitor_.gpu_mib() >= 0.0) {
+        Log::info(" gpu: %+.1f", monitor_.retained_gpu_mib());
+        result.rates.push_back(
+            std::make_pair("retained_gpu_memory_mib", monitor_.retained_gpu_mib()));
+    }
+    Log::info("\n");
+}
+
+/************************
+ * RenderScaleCollector *
+ ************************/
+
+void
+RenderScaleCollector::start(Scene & /* scene */)
+{
+    scale_ = 1.0;
+    scale_sum_ = 0.0;
+    frames_ = 0;
+    over_budget_frames_ = 0;
+    frame_start_ = Util::get_timestamp_us();
+}
+
+/*
+ * Scales the resolution of the next frame so it takes the --dynamic-resolution
+ * frame time. The time of a frame roughly follows its number of pixels, the
+ * square of the scale, but the scale only moves halfway towards the one
+ * that would take the budget, so the noise of the frame times doesn't make
+ * it oscillate.
+ */
+void
+RenderScaleCollector::end_frame(Scene &scene)
+{
+    static const double min_scale = 0.25;
+
+    if (Options::dynamic_resolution <= 0.0)
+        return;
+
+    uint64_t now = Util::get_timestamp_us();
+    double frame_ms = std::max((now - frame_start_) / 1000.0, 0.001);
+    frame_start_ = now;
+
+    if (!scene.warming_up()) {
+        scale_sum_ += scale_;
+        frames_++;
+        if (frame_ms > Options::dynamic_resolution)
+            over_budget_frames_++;
+    }
+
+    scale_ *= std::pow(Options::dynamic_resolution / frame_ms, 0.25);
+    scale_ = std::min(std::max(scale_, min_scale), 1.0);
+    canvas_.render_scale(scale_);
+}
+
+void
+RenderScaleCollector::finish()
+{
+    /* The results are for the size of the canvas */
+    canvas_.render_scale(1.0);
+}
+
+void
+RenderScaleCollector::log(Scene & /* scene */) const
+{
+    if (frames_ == 0)
+        return;
+
+    double scale = scale_sum_ / frames_;
+    Log::info("    DynamicResolution: scale: %.2f (%dx%d) over budget: %.1f%%\n",
+              scale,
+              static_cast<int>(canvas_.width() * scale + 0.5),
+              static_cast<int>(canvas_.height() * scale + 0.5),
+              100.0 * over_budget_frames_ / frames_);
+}
+
+void
+RenderScaleCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (frames_ == 0)
+        return;
+
+    double scale = scale_sum_ / frames_;
+    result.rates.push_back(std::make_pair("render_scale", scale));
+    result.rates.push_back(std::make_pair("render_width", result.width * scale));
+    result.rates.push_back(std::make_pair("render_height", result.height * scale));
+    result.rates.push_back(
+        std::make_pair("over_budget",
+                       static_cast<double>(over_budget_frames_) / frames_));
+}
+
+/*********************
+ * CoRunnerCollector *
+ *********************/
+
+void
+CoRunnerCollector::reset()
+{
+    alone_time_.reset();
+    loaded_time_.reset();
+}
+
+void
+CoRunnerCollector::start(Scene & /* scene */)
+{
+    if (Options::co_runners.empty())
+        return;
+
+    CoRunners::Config config;
+    CoRunners::parse(Options::co_runners, config);
+    co_runners_.start(canvas_, config);
+    frame_start_ = Util::get_timestamp_us();
+    window_start_ = frame_start_;
+}
+
+void
+CoRunnerCollector::end_frame(Scene &scene)
+{
+    static const uint64_t window_us = 250000;
+
+    if (!co_runners_.started())
+        return;
+
+    uint64_t now = Util::get_timestamp_us();
+
+    if (scene.warming_up()) {
+        frame_start_ = now;
+        window_start_ = now;
+        return;
+    }
+
+    FrameStats &stats(co_runners_.loaded() ? loaded_time_ : alone_time_);
+    stats.add(now - frame_start_);
+    frame_start_ = now;
+
+    if (now - window_start_ >= window_us) {
+        co_runners_.load(!co_runners_.loaded());
+        window_start_ = now;
+    }
+}
+
+void
+CoRunnerCollector::log(Scene & /* scene */) const
+{
+    if (alone_time_.count() == 0 || loaded_time_.count() == 0)
+        return;
+
+    log_measurement("FrameTimeAlone", alone_time_);
+    log_measurement("FrameTimeLoaded", loaded_time_);
+    Log::info("    CoRunnerSlowdown: %.1f%%\n",
+              100.0 * (loaded_time_.mean_ms() / alone_time_.mean_ms() - 1.0));
+}
+
+void
+CoRunnerCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (alone_time_.count() == 0 || loaded_time_.count() == 0)
+        return;
+
+    result.measurements.push_back(
+        std::make_pair("frame_time_alone", alone_time_.summary()));
+    result.measurements.push_back(
+        std::make_pair("frame_time_loaded", loaded_time_.summary()));
+    result.rates.push_back(
+        std::make_pair("co_runner_slowdown",
+                       loaded_time_.mean_ms() / alone_time_.mean_ms() - 1.0));
+}
+
+/*******************
+ * GLCallCollector *
+ *******************/
+
+void
+GLCallCollector::reset()
+{
+    calls_.clear();
+    frames_ = 0;
+}
+
+void
+GLCallCollector::begin_scene_frame(Scene &scene)
+{
+    measure_ = CallProfiler::active() && !scene.warming_up();
+    if (measure_)
+        CallProfiler::read(frame_calls_);
+}
+
+void
+GLCallCollector::end_scene_frame(Scene & /* scene */)
+{
+    if (!measure_)
+        return;
+
+    CallProfiler::add_since(frame_calls_, calls_);
+    frames_++;
+}
+
+void
+GLCallCollector::log(Scene & /* scene */) const
+{
+    static const unsigned int max_listed = 5;
+    std::vector<unsigned int> order;
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+
+    if (frames_ == 0)
+        return;
+
+    for (unsigned int i = 0; i < calls_.calls.size(); i++) {
+        calls += calls_.calls[i];
+        nanoseconds += calls_.nanoseconds[i];
+        if (calls_.calls[i] > 0)
+            order.push_back(i);
+    }
+
+    Log::info("    GLCallsPerFrame: %.1f DriverTime (ms/frame): %.3f\n",
+              static_cast<double>(calls) / frames_,
+              nanoseconds / 1e6 / frames_);
+
+    /* List the entry points the most driver time is spent in */
+    std::sort(order.begin(), order.end(),
+              [this](unsigned int a, unsigned int b) {
+                  return calls_.nanoseconds[a] > calls_.nanoseconds[b];
+              });
+    if (order.size() > max_listed)
+        order.resize(max_listed);
+
+    for (auto i : order) {
+        Log::info("      %s: calls: %.1f time (ms): %.3f\n",
+                  CallProfiler::name(i).c_str(),
+                  static_cast<double>(calls_.calls[i]) / frames_,
+                  calls_.nanoseconds[i] / 1e6 / frames_);
+    }
+}
+
+void
+GLCallCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    for (size_t i = 0; frames_ > 0 && i < calls_.calls.size(); i++) {
+        if (calls_.calls[i] == 0)
+            continue;
+        const std::string &name(CallProfiler::name(i));
+        result.rates.push_back(
+            std::make_pair(name + "_calls_per_frame",
+                           static_cast<double>(calls_.calls[i]) / frames_));
+        result.rates.push_back(
+            std::make_pair(name + "_ms_per_frame",
+                           calls_.nanoseconds[i] / 1e6 / frames_));
+    }
+}
+
+/************************
+ * PerfCounterCollector *
+ ************************/
+
+void
+PerfCounterCollector::start(Scene & /* scene */)
+{
+    if (Options::perf_counters || !Options::gpu_counters.empty())
+        counters_.init(Options::perf_counters, Options::gpu_counters);
+}
+
+void
+PerfCounterCollector::begin_scene_frame(Scene &scene)
+{
+    if (!scene.warming_up())
+        counters_.frame();
+}
+
+void
+PerfCounterCollector::log(Scene & /* scene */) const
+{
+    const std::vector<PerfCounters::Value> &values(counters_.values());
+
+    if (values.empty())
+        return;
+
+    Log::info("    PerfCounters:\n");
+    for (size_t i = 0; i < values.size(); i++)
+        Log::info("      %s: %.2f\n", values[i].first.c_str(), values[i].second);
+}
+
+void
+PerfCounterCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    const std::vector<PerfCounters::Value> &values(counters_.values());
+    result.rates.insert(result.rates.end(), values.begin(), values.end());
+}
+
+/*******************
+ * EnergyCollector *
+ *******************/
+
+void
+EnergyCollector::init()
+{
+    available_ = Options::energy && meter_.init();
+    if (Options::energy && !available_)
+        Log::info("Warning: no energy or power sources found, ignoring --energy\n");
+}
+
+void
+EnergyCollector::start(Scene & /* scene */)
+{
+    frames_ = 0;
+    if (available_)
+        meter_.start();
+}
+
+void
+EnergyCollector::end_frame(Scene & /* scene */)
+{
+    if (!available_)
+        return;
+
+    meter_.sample();
+    frames_++;
+}
+
+void
+EnergyCollector::log(Scene & /* scene */) const
+{
+    if (frames_ > 0 && meter_.seconds() > 0.0) {
+        Log::info("    EnergyPerFrame (mJ): %.3f AveragePower (W): %.3f source: %s\n",
+                  1000.0 * meter_.joules() / frames_,
+                  meter_.joules() / meter_.seconds(),
+                  meter_.source().c_str());
+    }
+}
+
+void
+EnergyCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (frames_ > 0 && meter_.seconds() > 0.0) {
+        result.rates.push_back(
+            std::make_pair("energy_mj_per_frame", 1000.0 * meter_.joules() / frames_));
+        result.rates.push_back(
+            std::make_pair("average_power_w", meter_.joules() / meter_.seconds()));
+    }
+}
+
+/**********************
+ * StateCallCollector *
+ **********************/
+
+void
+StateCallCollector::reset()
+{
+    calls_ = 0;
+    redundant_calls_ = 0;
+    frames_ = 0;
+}
+
+void
+StateCallCollector::begin_scene_frame(Scene &scene)
+{
+    measure_ = StateTracker::active() && !scene.warming_up();
+    frame_calls_ = StateTracker::calls();
+    frame_redundant_calls_ = StateTracker::redundant_calls();
+}
+
+void
+StateCallCollector::end_scene_frame(Scene & /* scene */)
+{
+    if (!measure_)
+        return;
+
+    calls_ += StateTracker::calls() - frame_calls_;
+    redundant_calls_ += StateTracker::redundant_calls() - frame_redundant_calls_;
+    frames_++;
+}
+
+void
+StateCallCollector::log(Scene & /* scene */) const
+{
+    if (frames_ > 0) {
+        Log::info("    StateCallsPerFrame: %.1f redundant: %.1f\n",
+                  static_cast<double>(calls_) / frames_,
+                  static_cast<double>(redundant_calls_) / frames_);
+    }
+}
+
+void
+StateCallCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (frames_ == 0)
+        return;
+
+    result.rates.push_back(
+        std::make_pair("state_calls_per_frame",
+                       static_cast<double>(calls_) / frames_));
+    result.rates.push_back(
+        std::make_pair("redundant_state_calls_per_frame",
+                       static_cast<double>(redundant_calls_) / frames_));
+}
+
+/******************
+ * FlushCollector *
+ ******************/
+
+void
+FlushCollector::reset()
+{
+    flushes_ = 0;
+    frames_ = 0;
+}
+
+void
+FlushCollector::begin_scene_frame(Scene &scene)
+{
+    measure_ = FlushPoints::active() && !scene.warming_up();
+    frame_flushes_ = FlushPoints::flushes();
+}
+
+void
+FlushCollector::end_scene_frame(Scene & /* scene */)
+{
+    if (!measure_)
+        return;
+
+    flushes_ += FlushPoints::flushes() - frame_flushes_;
+    frames_++;
+}
+
+void
+FlushCollector::log(Scene & /* scene */) const
+{
+    if (frames_ > 0) {
+        Log::info("    FlushesPerFrame: %.1f\n",
+                  static_cast<double>(flushes_) / frames_);
+    }
+}
+
+void
+FlushCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (frames_ > 0) {
+        result.rates.push_back(
+            std::make_pair("flushes_per_frame",
+                           static_cast<double>(flushes_) / frames_));
+    }
+}
+
+/***********************
+ * AllocationCollector *
+ ***********************/
+
+void
+AllocationCollector::reset()
+{
+    allocations_ = 0;
+    scene_allocations_ = 0;
+    frames_ = 0;
+}
+
+void
+AllocationCollector::begin_frame(Scene &scene)
+{
+    measure_ = AllocCounter::active() && !scene.warming_up();
+    frame_allocations_ = AllocCounter::allocations();
+}
+
+void
+AllocationCollector::end_frame(Scene & /* scene */)
+{
+    if (!measure_)
+        return;
+
+    allocations_ += AllocCounter::allocations() - frame_allocations_;
+    frames_++;
+}
+
+void
+AllocationCollector::begin_scene_frame(Scene & /* scene */)
+{
+    frame_scene_allocations_ = AllocCounter::allocations();
+}
+
+void
+AllocationCollector::end_scene_frame(Scene & /* scene */)
+{
+    if (measure_)
+        scene_allocations_ += AllocCounter::allocations() - frame_scene_allocations_;
+}
+
+void
+AllocationCollector::log(Scene & /* scene */) const
+{
+    if (frames_ > 0) {
+        Log::info("    AllocationsPerFrame: %.1f scene: %.1f\n",
+                  static_cast<double>(allocations_) / frames_,
+                  static_cast<double>(scene_allocations_) / frames_);
+    }
+}
+
+void
+AllocationCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    if (frames_ == 0)
+        return;
+
+    result.rates.push_back(
+        std::make_pair("allocations_per_frame",
+                       static_cast<double>(allocations_) / frames_));
+    result.rates.push_back(
+        std::make_pair("scene_allocations_per_frame",
+                       static_cast<double>(scene_allocations_) / frames_));
+}
+
+/**************************
+ * PipelineStatsCollector *
+ **************************/
+
+void
+PipelineStatsCollector::start(Scene & /* scene */)
+{
+    if (Options::pipeline_stats && !stats_.init())
+        Log::debug("Pipeline statistics are not supported, ignoring --pipeline-stats\n");
+}
+
+void
+PipelineStatsCollector::begin_scene_frame(Scene &scene)
+{
+    measure_ = !scene.warming_up();
+    if (measure_)
+        stats_.begin();
+}
+
+void
+PipelineStatsCollector::end_scene_frame(Scene & /* scene */)
+{
+    if (measure_)
+        stats_.end();
+}
+
+void
+PipelineStatsCollector::log(Scene &scene) const
+{
+    if (stats_.frames() == 0)
+        return;
+
+    /* The rates normalize the FPS by the work, e.g. triangles/s */
+    Log::info("    PipelineStats:\n");
+
+    for (int i = 0; i < PipelineStats::StatisticCount; i++) {
+        PipelineStats::Statistic statistic(static_cast<PipelineStats::Statistic>(i));
+        if (!stats_.counted(statistic))
+            continue;
+        double per_frame = stats_.per_frame(statistic);
+        Log::info("      %s: %.0f per frame, %.4g per second\n",
+                  PipelineStats::name(statistic), per_frame,
+                  per_frame * scene.average_fps());
+    }
+}
+
+void
+PipelineStatsCollector::record(Scene & /* scene */, BenchmarkResult &result) const
+{
+    for (int i = 0; stats_.frames() > 0 && i < PipelineStats::StatisticCount; i++) {
+        PipelineStats::Statistic statistic(static_cast<PipelineStats::Statistic>(i));
+        if (!stats_.counted(statistic))
+            continue;
+        result.rates.push_back(
+            std::make_pair(std::string(PipelineStats::key(statistic)) + "_per_frame",
+                           stats_.per_frame(statistic)));
+    }
+}
+
+/********************
+ * MetricsCollector *
+ ********************/
+
+void
+MetricsCollector::start(Scene &scene)
+{
+    MetricsServer::scene_started(scene.name());
+}
+
+void
+MetricsCollector::end_frame(Scene & /* scene */)
+{
+    MetricsServer::frame_presented();
+}
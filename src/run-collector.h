@@ -0,0 +1,377 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_RUN_COLLECTOR_H_
+#define GLMARK2_RUN_COLLECTOR_H_
+
+#include "frame-stats.h"
+#include "results-file.h"
+#include "co-runners.h"
+#include "pipeline-stats.h"
+#include "call-profiler.h"
+#include "perf-counters.h"
+#include "energy-meter.h"
+#include "memory-monitor.h"
+
+#include <stdint.h>
+#include <string>
+
+class Canvas;
+class Scene;
+
+/**
+ * Collects a measurement over the run of each scene, e.g. the allocations
+ * of its frames, and reports it in the log and in the results.
+ *
+ * The main loop calls the hooks of all its collectors, in the order they
+ * were registered, so adding a measurement only takes a collector and its
+ * registration. The end hooks of the frames are called in the reverse
+ * order, so that the collectors registered last measure the frames with
+ * the least of the work of the others.
+ */
+class RunCollector
+{
+public:
+    virtual ~RunCollector() {}
+
+    /**
+     * Drops what was collected for the previous scene, before the next one
+     * is set up.
+     */
+    virtual void reset() {}
+
+    /**
+     * Starts collecting for a scene that has been set up successfully.
+     */
+    virtual void start(Scene & /* scene */) {}
+
+    /**
+     * Called before and after each frame, which includes its presentation.
+     */
+    virtual void begin_frame(Scene & /* scene */) {}
+    virtual void end_frame(Scene & /* scene */) {}
+
+    /**
+     * Called before and after the scene draws and updates a frame, leaving
+     * out the clear, the decorations and the presentation.
+     */
+    virtual void begin_scene_frame(Scene & /* scene */) {}
+    virtual void end_scene_frame(Scene & /* scene */) {}
+
+    /**
+     * Stops collecting once the scene is done, before the results are
+     * reported.
+     */
+    virtual void finish() {}
+
+    /**
+     * Logs the measurement of a scene that ran successfully.
+     */
+    virtual void log(Scene &scene) const = 0;
+
+    /**
+     * Adds the measurement of a scene that ran successfully to its result.
+     */
+    virtual void record(Scene &scene, BenchmarkResult &result) const = 0;
+
+    /**
+     * Releases the resources of the scene, while its context is still
+     * alive.
+     */
+    virtual void release() {}
+
+    /**
+     * Measures what is only known once the scene has been torn down, and
+     * logs it and adds it to the result of the scene.
+     */
+    virtual void after_teardown(BenchmarkResult & /* result */) {}
+
+    /**
+     * Logs the mean and the percentiles of a measurement, in ms.
+     */
+    static void log_measurement(const std::string &name, const FrameStats &stats);
+};
+
+/**
+ * Destroys and recreates the context before each scene, unless
+ * --reuse-context is used, and measures how long it takes.
+ */
+class ContextResetCollector : public RunCollector
+{
+public:
+    ContextResetCollector(Canvas &canvas) : canvas_(canvas) {}
+
+    void reset();
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    Canvas &canvas_;
+    FrameStats time_;
+};
+
+/**
+ * The memory used by each scene, and retained after its teardown, with
+ * --memory-usage.
+ */
+class MemoryCollector : public RunCollector
+{
+public:
+    MemoryCollector() : started_(false) {}
+
+    void reset();
+    void start(Scene &scene);
+    void end_frame(Scene &scene);
+    void finish();
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+    void after_teardown(BenchmarkResult &result);
+
+private:
+    MemoryMonitor monitor_;
+    bool started_;
+};
+
+/**
+ * Scales the resolution of the frames so they take the --dynamic-resolution
+ * frame time, and measures the mean scale and the frames over the budget.
+ */
+class RenderScaleCollector : public RunCollector
+{
+public:
+    RenderScaleCollector(Canvas &canvas) :
+        canvas_(canvas), scale_(1.0), scale_sum_(0.0), frames_(0),
+        over_budget_frames_(0), frame_start_(0) {}
+
+    void start(Scene &scene);
+    void end_frame(Scene &scene);
+    void finish();
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    Canvas &canvas_;
+    double scale_;
+    double scale_sum_;
+    unsigned int frames_;
+    unsigned int over_budget_frames_;
+    uint64_t frame_start_;
+};
+
+/**
+ * The frame times without and with the background load of --co-runners.
+ *
+ * The load is switched on and off in short windows, so that the frames
+ * without and with it are interleaved through the scene and see the same
+ * thermal and clock state, and each frame is attributed to its window.
+ */
+class CoRunnerCollector : public RunCollector
+{
+public:
+    CoRunnerCollector(Canvas &canvas) :
+        canvas_(canvas), frame_start_(0), window_start_(0) {}
+
+    void reset();
+    void start(Scene &scene);
+    void end_frame(Scene &scene);
+    void finish() { co_runners_.stop(); }
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    Canvas &canvas_;
+    CoRunners co_runners_;
+    FrameStats alone_time_;
+    FrameStats loaded_time_;
+    uint64_t frame_start_;
+    uint64_t window_start_;
+};
+
+/**
+ * The profiled GL calls of the measured frames, with --profile-gl-calls.
+ */
+class GLCallCollector : public RunCollector
+{
+public:
+    GLCallCollector() : measure_(false), frames_(0) {}
+
+    void reset();
+    void begin_scene_frame(Scene &scene);
+    void end_scene_frame(Scene &scene);
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    bool measure_;
+    CallCounters frame_calls_;
+    CallCounters calls_;
+    unsigned int frames_;
+};
+
+/**
+ * The CPU and GPU counters of the measured frames, with --perf-counters and
+ * --gpu-counters.
+ */
+class PerfCounterCollector : public RunCollector
+{
+public:
+    void start(Scene &scene);
+    void begin_scene_frame(Scene &scene);
+    void finish() { counters_.finish(); }
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+    void release() { counters_.release(); }
+
+private:
+    PerfCounters counters_;
+};
+
+/**
+ * The energy used by the frames of each scene, with --energy.
+ */
+class EnergyCollector : public RunCollector
+{
+public:
+    EnergyCollector() : available_(false), frames_(0) {}
+
+    /**
+     * Finds the energy or power sources, once before the benchmarks run.
+     */
+    void init();
+
+    void start(Scene &scene);
+    void end_frame(Scene &scene);
+    void finish() { meter_.stop(); }
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    EnergyMeter meter_;
+    bool available_;
+    unsigned int frames_;
+};
+
+/**
+ * The tracked GL state calls of the measured frames, with --state-tracking.
+ */
+class StateCallCollector : public RunCollector
+{
+public:
+    StateCallCollector() :
+        measure_(false), calls_(0), redundant_calls_(0),
+        frame_calls_(0), frame_redundant_calls_(0), frames_(0) {}
+
+    void reset();
+    void begin_scene_frame(Scene &scene);
+    void end_scene_frame(Scene &scene);
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    bool measure_;
+    uint64_t calls_;
+    uint64_t redundant_calls_;
+    uint64_t frame_calls_;
+    uint64_t frame_redundant_calls_;
+    unsigned int frames_;
+};
+
+/**
+ * The flushes of the measured frames, with --flush-points.
+ */
+class FlushCollector : public RunCollector
+{
+public:
+    FlushCollector() :
+        measure_(false), flushes_(0), frame_flushes_(0), frames_(0) {}
+
+    void reset();
+    void begin_scene_frame(Scene &scene);
+    void end_scene_frame(Scene &scene);
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    bool measure_;
+    uint64_t flushes_;
+    uint64_t frame_flushes_;
+    unsigned int frames_;
+};
+
+/**
+ * The allocations of the measured frames, both of the whole frame and of
+ * the scene alone, with --count-allocations.
+ */
+class AllocationCollector : public RunCollector
+{
+public:
+    AllocationCollector() :
+        measure_(false), allocations_(0), scene_allocations_(0),
+        frame_allocations_(0), frame_scene_allocations_(0), frames_(0) {}
+
+    void reset();
+    void begin_frame(Scene &scene);
+    void end_frame(Scene &scene);
+    void begin_scene_frame(Scene &scene);
+    void end_scene_frame(Scene &scene);
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+
+private:
+    bool measure_;
+    uint64_t allocations_;
+    uint64_t scene_allocations_;
+    uint64_t frame_allocations_;
+    uint64_t frame_scene_allocations_;
+    unsigned int frames_;
+};
+
+/**
+ * The work of the measured frames, with --pipeline-stats.
+ */
+class PipelineStatsCollector : public RunCollector
+{
+public:
+    PipelineStatsCollector() : measure_(false) {}
+
+    void start(Scene &scene);
+    void begin_scene_frame(Scene &scene);
+    void end_scene_frame(Scene &scene);
+    void finish() { stats_.collect(true); }
+    void log(Scene &scene) const;
+    void record(Scene &scene, BenchmarkResult &result) const;
+    void release() { stats_.release(); }
+
+private:
+    bool measure_;
+    PipelineStats stats_;
+};
+
+/**
+ * Feeds the scenes and the presented frames to the --metrics server.
+ */
+class MetricsCollector : public RunCollector
+{
+public:
+    void start(Scene &scene);
+    void end_frame(Scene &scene);
+    void log(Scene & /* scene */) const {}
+    void record(Scene & /* scene */, BenchmarkResult & /* result */) const {}
+};
+
+#endif /* GLMARK2_RUN_COLLECTOR_H_ */
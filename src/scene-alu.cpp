@@ -0,0 +1,234 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <sstream>
+
+struct SceneALUPrivate {
+    SceneALUPrivate() :
+        fma_ops(0), mediump_ops(0), transcendental_ops(0), integer_ops(0),
+        quad_buffer(0) {}
+
+    /* The number of vec4 (or ivec4) operations of each kind per fragment */
+    unsigned int fma_ops;
+    unsigned int mediump_ops;
+    unsigned int transcendental_ops;
+    unsigned int integer_ops;
+
+    Program program;
+    GLuint quad_buffer;
+
+    void release()
+    {
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+
+    /*
+     * The floating point operations per fragment, counting each component
+     * of an FMA as two operations and of a transcendental function as one.
+     */
+    double flops() const
+    {
+        return 8.0 * (fma_ops + mediump_ops) + 4.0 * transcendental_ops;
+    }
+
+    /* The integer operations per fragment, a multiply and an add per component */
+    double int_ops() const
+    {
+        return 8.0 * integer_ops;
+    }
+
+    /* Generates the unrolled chains of operations */
+    std::string operations() const
+    {
+        std::stringstream ss;
+
+        for (unsigned int i = 0; i < fma_ops; i++)
+            ss << "    multiply_add = multiply_add * Scale + Bias;" << std::endl;
+        for (unsigned int i = 0; i < mediump_ops; i++)
+            ss << "    mediump_multiply_add = mediump_multiply_add * MediumpScale + MediumpBias;" << std::endl;
+        for (unsigned int i = 0; i < transcendental_ops; i++) {
+            ss << "    transcendental = " << (i % 2 ? "exp2" : "sin")
+               << "(transcendental);" << std::endl;
+        }
+        for (unsigned int i = 0; i < integer_ops; i++)
+            ss << "    integer = integer * IntScale + IntBias;" << std::endl;
+
+        return ss.str();
+    }
+};
+
+SceneALU::SceneALU(Canvas &pCanvas) :
+    Scene(pCanvas, "alu")
+{
+    priv_ = new SceneALUPrivate();
+    options_["fma-ops"] = Scene::Option("fma-ops", "128",
+                                        "The number of vec4 multiply-adds per fragment, in the fragment-precision");
+    options_["mediump-ops"] = Scene::Option("mediump-ops", "0",
+                                            "The number of mediump vec4 multiply-adds per fragment");
+    options_["transcendental-ops"] = Scene::Option("transcendental-ops", "0",
+                                                   "The number of vec4 sin() and exp2() calls per fragment");
+    options_["integer-ops"] = Scene::Option("integer-ops", "0",
+                                            "The number of ivec4 multiply-adds per fragment");
+}
+
+SceneALU::~SceneALU()
+{
+    delete priv_;
+}
+
+bool
+SceneALU::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneALU::unload()
+{
+}
+
+bool
+SceneALU::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/fillrate.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/alu.frag");
+
+    SceneALUPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.fma_ops = Util::fromString<unsigned int>(options_["fma-ops"].value);
+    p.mediump_ops = Util::fromString<unsigned int>(options_["mediump-ops"].value);
+    p.transcendental_ops = Util::fromString<unsigned int>(options_["transcendental-ops"].value);
+    p.integer_ops = Util::fromString<unsigned int>(options_["integer-ops"].value);
+
+    if (p.flops() == 0.0 && p.int_ops() == 0.0) {
+        Log::error("At least one kind of operation must be used\n");
+        return false;
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    frg_source.replace("$OPERATIONS$", p.operations());
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    /* Create the full-screen quad, drawn as a triangle strip */
+    p.quad_buffer = FullscreenQuad::create();
+
+    /* The chains converge to 1.0 and the integers stay unchanged */
+    p.program.start();
+    p.program["Depth"] = 0.0f;
+    p.program["Scale"] = LibMatrix::vec4(0.999f, 0.999f, 0.999f, 0.999f);
+    p.program["Bias"] = LibMatrix::vec4(0.001f, 0.001f, 0.001f, 0.001f);
+    p.program["MediumpScale"] = LibMatrix::vec4(0.99f, 0.99f, 0.99f, 0.99f);
+    p.program["MediumpBias"] = LibMatrix::vec4(0.01f, 0.01f, 0.01f, 0.01f);
+    glUniform4i(p.program["IntScale"].location(), 1, 1, 1, 1);
+    glUniform4i(p.program["IntBias"].location(), 0, 0, 0, 0);
+
+    glDisable(GL_DEPTH_TEST);
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneALU::teardown()
+{
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneALU::update()
+{
+    Scene::update();
+}
+
+void
+SceneALU::draw()
+{
+    SceneALUPrivate &p(*priv_);
+    GLint position_location = p.program["position"].location();
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneALU::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneALU::rates()
+{
+    std::vector<Rate> rates;
+    double elapsed = elapsed_time();
+    double fragments = static_cast<double>(canvas_.width()) * canvas_.height() *
+                       frame_count();
+
+    if (priv_->flops() > 0.0) {
+        rates.push_back(Rate("GFLOPS", "gflops",
+                             elapsed > 0.0 ? priv_->flops() * fragments / elapsed / 1e9 : 0.0));
+    }
+    if (priv_->int_ops() > 0.0) {
+        rates.push_back(Rate("GIOPS", "giops",
+                             elapsed > 0.0 ? priv_->int_ops() * fragments / elapsed / 1e9 : 0.0));
+    }
+
+    return rates;
+}
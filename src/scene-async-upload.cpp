@@ -0,0 +1,462 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "gl-state.h"
+#include "texture.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/*
+ * The scene streams texture and vertex buffer assets while rendering with
+ * them, like an application loading its assets asynchronously. Each upload
+ * creates new objects which, once complete, replace the ones in use.
+ */
+struct SceneAsyncUploadPrivate {
+    /* A set of objects created by one upload */
+    struct Upload {
+        Upload() : texture(0), buffer(0), fence(0) {}
+        GLuint texture;
+        GLuint buffer;
+        /* Signaled when the upload is complete, if made by another context */
+        GLsync fence;
+    };
+
+    /* A decoded texture file */
+    struct Image {
+        std::vector<unsigned char> pixels;
+        unsigned int width;
+        unsigned int height;
+        GLenum format;
+    };
+
+    SceneAsyncUploadPrivate() :
+        upload_thread(true), max_pending(0), vertex_count(0),
+        upload_index(0), context(0), stop(false), uploads(0),
+        angle_location(-1) {}
+
+    bool upload_thread;
+    unsigned int max_pending;
+    std::vector<Image> images;
+    std::vector<float> vertices;
+    unsigned int vertex_count;
+    /* The index of the next upload, selecting its image */
+    unsigned int upload_index;
+
+    GLWorkerContext *context;
+    std::thread thread;
+    bool stop;
+    std::mutex mutex;
+    std::condition_variable pending_changed;
+    /* The completed uploads of the thread, not used yet */
+    std::deque<Upload> pending;
+
+    Upload current;
+    unsigned int uploads;
+    Program program;
+    GLint angle_location;
+
+    /* The time of each upload, in the context that makes it */
+    FrameStats upload_stats;
+
+    Upload upload();
+    void run();
+
+    static void destroy(const Upload &u)
+    {
+        if (u.fence)
+            GLExtensions::DeleteSync(u.fence);
+        if (u.buffer)
+            glDeleteBuffers(1, &u.buffer);
+        if (u.texture)
+            glDeleteTextures(1, &u.texture);
+    }
+
+    void stop_thread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        pending_changed.notify_all();
+
+        if (thread.joinable())
+            thread.join();
+
+        delete context;
+        context = 0;
+    }
+
+    void release()
+    {
+        stop_thread();
+
+        for (std::deque<Upload>::iterator iter = pending.begin();
+             iter != pending.end();
+             iter++)
+        {
+            destroy(*iter);
+        }
+        pending.clear();
+
+        destroy(current);
+        current = Upload();
+
+        program.stop();
+        program.release();
+        images.clear();
+        vertices.clear();
+    }
+};
+
+/*
+ * Creates the objects of the next upload in the current context.
+ */
+SceneAsyncUploadPrivate::Upload
+SceneAsyncUploadPrivate::upload()
+{
+    const Image &image(images[upload_index++ % images.size()]);
+    uint64_t start = Util::get_timestamp_us();
+    Upload u;
+
+    glGenTextures(1, &u.texture);
+    glBindTexture(GL_TEXTURE_2D, u.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, image.format, image.width, image.height, 0,
+                 image.format, GL_UNSIGNED_BYTE, &image.pixels[0]);
+
+    glGenBuffers(1, &u.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, u.buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
+                 &vertices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    upload_stats.add(Util::get_timestamp_us() - start);
+
+    return u;
+}
+
+/*
+ * Uploads the assets in the context of the thread, keeping at most
+ * max-pending completed uploads that the main thread hasn't used yet.
+ */
+void
+SceneAsyncUploadPrivate::run()
+{
+    if (!context->make_current())
+        return;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            pending_changed.wait(lock, [this] { return stop || pending.size() < max_pending; });
+            if (stop)
+                break;
+        }
+
+        Upload u(upload());
+
+        /* The fence must be flushed for the main context to wait for it */
+        u.fence = GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(u);
+    }
+
+    context->release();
+}
+
+SceneAsyncUpload::SceneAsyncUpload(Canvas &pCanvas) :
+    Scene(pCanvas, "async-upload")
+{
+    priv_ = new SceneAsyncUploadPrivate();
+    options_["textures"] = Scene::Option("textures", "crate-base,nasa1,nasa2,nasa3",
+                                         "The textures that are uploaded in turn, separated by commas");
+    options_["buffer-size"] = Scene::Option("buffer-size", "256",
+                                            "The size in KiB of the vertex buffer uploaded with each texture");
+    options_["upload-thread"] = Scene::Option("upload-thread", "true",
+                                              "Whether the uploads are made by a thread with a shared context, or by the main thread every frame",
+                                              "false,true");
+    options_["max-pending"] = Scene::Option("max-pending", "2",
+                                            "The number of completed uploads the thread can make ahead of the main thread");
+}
+
+SceneAsyncUpload::~SceneAsyncUpload()
+{
+    delete priv_;
+}
+
+bool
+SceneAsyncUpload::supported(bool show_errors)
+{
+    if (options_["upload-thread"].value != "true")
+        return true;
+
+    if (!GLExtensions::FenceSync || !GLExtensions::WaitSync) {
+        if (show_errors) {
+            Log::error("Uploading from a thread requires sync objects, which"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    GLWorkerContext *context = canvas_.create_worker_context(true);
+    if (!context) {
+        if (show_errors) {
+            Log::error("Uploading from a thread requires a shared context, which"
+                       " is not supported by this flavor!\n");
+        }
+        return false;
+    }
+
+    delete context;
+
+    return true;
+}
+
+bool
+SceneAsyncUpload::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneAsyncUpload::unload()
+{
+}
+
+bool
+SceneAsyncUpload::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/multi-context.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/multi-context.frag");
+
+    SceneAsyncUploadPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.upload_thread = options_["upload-thread"].value == "true";
+    p.max_pending = Util::fromString<unsigned int>(options_["max-pending"].value);
+    if (p.max_pending == 0) {
+        Log::error("The number of pending uploads must be at least 1\n");
+        return false;
+    }
+
+    /* Decode the textures up front, so that the uploads are measured alone */
+    std::vector<std::string> names;
+    Util::split(options_["textures"].value, ',', names, Util::SplitModeNormal);
+
+    for (std::vector<std::string>::const_iterator iter = names.begin();
+         iter != names.end();
+         iter++)
+    {
+        SceneAsyncUploadPrivate::Image image;
+
+        if (!Texture::decode(*iter, image.pixels, image.width, image.height, image.format)) {
+            Log::error("Failed to decode texture '%s'\n", iter->c_str());
+            return false;
+        }
+
+        p.images.push_back(image);
+    }
+
+    if (p.images.empty()) {
+        Log::error("At least one texture must be uploaded\n");
+        return false;
+    }
+
+    /*
+     * Fill the vertex buffer with a grid of quads covering the screen,
+     * as many as fit in buffer-size.
+     */
+    unsigned int buffer_size = Util::fromString<unsigned int>(options_["buffer-size"].value) * 1024;
+    unsigned int quads = std::max(buffer_size / static_cast<unsigned int>(6 * 3 * sizeof(float)), 1U);
+    unsigned int side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(quads))));
+    float cell = 2.0f / side;
+
+    for (unsigned int i = 0; i < quads; i++) {
+        float x0 = -1.0f + cell * (i % side);
+        float y0 = -1.0f + cell * (i / side);
+        float x1 = x0 + cell;
+        float y1 = y0 + cell;
+        const float quad[] = {
+            x0, y0, 0.0f, x1, y0, 0.0f, x1, y1, 0.0f,
+            x0, y0, 0.0f, x1, y1, 0.0f, x0, y1, 0.0f
+        };
+
+        p.vertices.insert(p.vertices.end(), quad, quad + 18);
+    }
+    p.vertex_count = p.vertices.size() / 3;
+
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.program.start();
+    p.program["MaterialTexture0"] = 0;
+    p.angle_location = p.program["Angle"].location();
+
+    /* Render with a first upload until the thread makes new ones */
+    p.upload_index = 0;
+    p.uploads = 0;
+    p.current = p.upload();
+    p.upload_stats.reset();
+
+    if (p.upload_thread) {
+        p.stop = false;
+        p.context = canvas_.create_worker_context(true);
+        if (!p.context) {
+            Log::error("Failed to create the context of the upload thread\n");
+            return false;
+        }
+
+        p.thread = std::thread(&SceneAsyncUploadPrivate::run, priv_);
+    }
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneAsyncUpload::teardown()
+{
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneAsyncUpload::update()
+{
+    Scene::update();
+
+    /* Stop uploading at the end, so that the measurements are stable */
+    if (!running_)
+        priv_->stop_thread();
+}
+
+/*
+ * Switches to the latest completed upload, making the main context wait
+ * for the upload on the GPU rather than blocking on the CPU, and draws
+ * with it.
+ */
+void
+SceneAsyncUpload::draw()
+{
+    SceneAsyncUploadPrivate &p(*priv_);
+    SceneAsyncUploadPrivate::Upload next;
+
+    if (p.upload_thread) {
+        std::unique_lock<std::mutex> lock(p.mutex);
+
+        while (!p.pending.empty()) {
+            SceneAsyncUploadPrivate::destroy(next);
+            next = p.pending.front();
+            p.pending.pop_front();
+        }
+
+        lock.unlock();
+        p.pending_changed.notify_all();
+
+        if (next.fence) {
+            GLExtensions::WaitSync(next.fence, 0, GL_TIMEOUT_IGNORED);
+            GLExtensions::DeleteSync(next.fence);
+            next.fence = 0;
+        }
+    }
+    else {
+        next = p.upload();
+    }
+
+    if (next.texture) {
+        SceneAsyncUploadPrivate::destroy(p.current);
+        p.current = next;
+        p.uploads++;
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, p.current.texture);
+    glUniform1f(p.angle_location, 0.001f * currentFrame_);
+
+    GLint position_location = p.program["position"].location();
+    glBindBuffer(GL_ARRAY_BUFFER, p.current.buffer);
+    glVertexAttribPointer(position_location, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(position_location);
+    glDrawArrays(GL_TRIANGLES, 0, p.vertex_count);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneAsyncUpload::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneAsyncUpload::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("UploadTime", "upload_time",
+                                                   priv_->upload_stats));
+}
+
+void
+SceneAsyncUpload::reset_measurements()
+{
+    std::lock_guard<std::mutex> lock(priv_->mutex);
+
+    priv_->upload_stats.reset();
+    priv_->uploads = 0;
+}
+
+std::vector<Scene::Rate>
+SceneAsyncUpload::rates()
+{
+    double elapsed = elapsed_time();
+
+    return std::vector<Rate>(1, Rate("UploadsPerSecond", "uploads_per_second",
+                                     elapsed > 0.0 ? priv_->uploads / elapsed : 0.0));
+}
@@ -0,0 +1,480 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+
+/*
+ * Gets the texture and renderbuffer format for the "src-format" and
+ * "dst-format" options. Sized formats need GLES 3.0 (or desktop GL), so
+ * "default" is the unsized GL_RGBA that GLES 2.0 can use for textures.
+ */
+static void
+color_format(const std::string &name, GLint &internal_format, GLenum &type)
+{
+    internal_format = GL_RGBA;
+    type = GL_UNSIGNED_BYTE;
+
+    if (name == "rgba8") {
+        internal_format = GL_RGBA8;
+    }
+    else if (name == "rgb10a2") {
+        internal_format = GL_RGB10_A2;
+        type = GL_UNSIGNED_INT_2_10_10_10_REV;
+    }
+    else if (name == "rgba16f") {
+        internal_format = GL_RGBA16F;
+        type = GL_HALF_FLOAT;
+    }
+}
+
+struct SceneBlitPrivate {
+    enum Method {
+        MethodBlit,
+        MethodCopyTex,
+        MethodDraw
+    };
+
+    SceneBlitPrivate() :
+        method(MethodBlit), copies(0), filter(GL_NEAREST), samples(0),
+        width(0), height(0), dst_width(0), dst_height(0), quad_buffer(0),
+        src_fbo(0), src_texture(0), src_rb(0), dst_fbo(0), dst_texture(0) {}
+
+    Method method;
+    unsigned int copies;
+    GLenum filter;
+    unsigned int samples;
+    int width;
+    int height;
+    int dst_width;
+    int dst_height;
+
+    Program pattern_program;
+    Program texture_program;
+    GLuint quad_buffer;
+
+    /* The source has a texture, or a renderbuffer with MSAA */
+    GLuint src_fbo;
+    GLuint src_texture;
+    GLuint src_rb;
+    GLuint dst_fbo;
+    GLuint dst_texture;
+
+    void release()
+    {
+        if (src_fbo) {
+            GLExtensions::DeleteFramebuffers(1, &src_fbo);
+            src_fbo = 0;
+        }
+        if (src_texture) {
+            glDeleteTextures(1, &src_texture);
+            src_texture = 0;
+        }
+        if (src_rb) {
+            GLExtensions::DeleteRenderbuffers(1, &src_rb);
+            src_rb = 0;
+        }
+        if (dst_fbo) {
+            GLExtensions::DeleteFramebuffers(1, &dst_fbo);
+            dst_fbo = 0;
+        }
+        if (dst_texture) {
+            glDeleteTextures(1, &dst_texture);
+            dst_texture = 0;
+        }
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        pattern_program.stop();
+        pattern_program.release();
+        texture_program.stop();
+        texture_program.release();
+    }
+
+    /* Creates a texture with a framebuffer around it */
+    static GLenum create_target(const std::string &format, int w, int h,
+                                GLenum filter, GLuint &texture, GLuint &fbo)
+    {
+        GLint internal_format;
+        GLenum type;
+        color_format(format, internal_format, type);
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, w, h, 0, GL_RGBA, type, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        GLExtensions::GenFramebuffers(1, &fbo);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo);
+        GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                           GL_TEXTURE_2D, texture, 0);
+
+        return GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    }
+
+    /* Draws the full-screen quad with a program using desktop.vert */
+    void draw_quad(Program &program)
+    {
+        GLint position_location = program["position"].location();
+        GLint texcoord_location = program["texcoord"].location();
+
+        program.start();
+        glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+        glEnableVertexAttribArray(position_location);
+        glEnableVertexAttribArray(texcoord_location);
+        glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE,
+                              4 * sizeof(GLfloat), 0);
+        glVertexAttribPointer(texcoord_location, 2, GL_FLOAT, GL_FALSE,
+                              4 * sizeof(GLfloat),
+                              reinterpret_cast<const GLvoid *>(2 * sizeof(GLfloat)));
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glDisableVertexAttribArray(texcoord_location);
+        glDisableVertexAttribArray(position_location);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /* Copies the source to the destination once */
+    void copy()
+    {
+        switch (method) {
+        case MethodBlit:
+            GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, src_fbo);
+            GLExtensions::BindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+            GLExtensions::BlitFramebuffer(0, 0, width, height,
+                                          0, 0, dst_width, dst_height,
+                                          GL_COLOR_BUFFER_BIT, filter);
+            break;
+        case MethodCopyTex:
+            /* Copies can't scale, so the destination size is cropped */
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, src_fbo);
+            glBindTexture(GL_TEXTURE_2D, dst_texture);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0,
+                                std::min(width, dst_width),
+                                std::min(height, dst_height));
+            glBindTexture(GL_TEXTURE_2D, 0);
+            break;
+        case MethodDraw:
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+            glViewport(0, 0, dst_width, dst_height);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, src_texture);
+            draw_quad(texture_program);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            break;
+        }
+    }
+};
+
+SceneBlit::SceneBlit(Canvas &pCanvas) :
+    Scene(pCanvas, "blit")
+{
+    priv_ = new SceneBlitPrivate();
+    options_["method"] = Scene::Option("method", "blit",
+                                       "How the source is copied to the destination: glBlitFramebuffer,"
+                                       " glCopyTexSubImage2D or drawing a textured quad",
+                                       "blit,copy-tex,draw");
+    options_["copies"] = Scene::Option("copies", "16",
+                                       "The number of copies made every frame");
+    options_["scale"] = Scene::Option("scale", "1.0",
+                                      "The size of the destination relative to the canvas-sized source"
+                                      " (copy-tex crops instead of scaling)");
+    options_["filter"] = Scene::Option("filter", "nearest",
+                                       "The filter used when scaling",
+                                       "nearest,linear");
+    options_["samples"] = Scene::Option("samples", "0",
+                                        "The number of MSAA samples of the source, resolved by each blit"
+                                        " (0 for no MSAA)");
+    options_["src-format"] = Scene::Option("src-format", "default",
+                                           "The color format of the source",
+                                           "default,rgba8,rgb10a2,rgba16f");
+    options_["dst-format"] = Scene::Option("dst-format", "default",
+                                           "The color format of the destination",
+                                           "default,rgba8,rgb10a2,rgba16f");
+}
+
+SceneBlit::~SceneBlit()
+{
+    delete priv_;
+}
+
+bool
+SceneBlit::supported(bool show_errors)
+{
+    const std::string &method = options_["method"].value;
+    unsigned int samples = Util::fromString<unsigned int>(options_["samples"].value);
+
+    if ((method == "blit" || samples > 0) &&
+        (GLExtensions::BlitFramebuffer == 0 ||
+         (samples > 0 && GLExtensions::RenderbufferStorageMultisample == 0)))
+    {
+        if (show_errors) {
+            Log::error("Requested blits but framebuffer blits or multisampled"
+                       " renderbuffers are not supported!\n");
+        }
+        return false;
+    }
+
+    if (samples > 0 && method != "blit") {
+        if (show_errors)
+            Log::error("An MSAA source can only be copied with method=blit\n");
+        return false;
+    }
+
+#if GLMARK2_USE_GLESv2
+    if ((options_["src-format"].value != "default" ||
+         options_["dst-format"].value != "default") &&
+        !GLExtensions::version_supported(3, 0))
+    {
+        if (show_errors)
+            Log::error("Sized color formats require GLES 3.0\n");
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+bool
+SceneBlit::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneBlit::unload()
+{
+}
+
+bool
+SceneBlit::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/desktop.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/desktop.frag");
+    static const std::string frg_pattern_shader_filename(Options::data_path + "/shaders/blit-pattern.frag");
+
+    SceneBlitPrivate &p(*priv_);
+
+    /* Parse the options */
+    const std::string &method = options_["method"].value;
+    if (method == "copy-tex")
+        p.method = SceneBlitPrivate::MethodCopyTex;
+    else if (method == "draw")
+        p.method = SceneBlitPrivate::MethodDraw;
+    else
+        p.method = SceneBlitPrivate::MethodBlit;
+
+    p.copies = Util::fromString<unsigned int>(options_["copies"].value);
+    p.filter = options_["filter"].value == "linear" ? GL_LINEAR : GL_NEAREST;
+    p.samples = Util::fromString<unsigned int>(options_["samples"].value);
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+
+    float scale = Util::fromString<float>(options_["scale"].value);
+    p.dst_width = static_cast<int>(p.width * scale + 0.5f);
+    p.dst_height = static_cast<int>(p.height * scale + 0.5f);
+
+    if (p.copies == 0 || p.dst_width <= 0 || p.dst_height <= 0) {
+        Log::error("The copies and scale options must be positive\n");
+        return false;
+    }
+
+    /* Resolving the samples can't scale the image, in GLES 3.0 */
+    if (p.samples > 0 && (p.dst_width != p.width || p.dst_height != p.height)) {
+        Log::error("An MSAA source can't be copied with a scale\n");
+        return false;
+    }
+
+    if (p.samples > 0) {
+        GLint max_samples = 0;
+        glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+        if (p.samples > static_cast<unsigned int>(max_samples)) {
+            Log::error("Invalid samples %u (maximum %d)\n", p.samples, max_samples);
+            return false;
+        }
+    }
+
+    /* Load the programs */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+    ShaderSource frg_pattern_source(frg_pattern_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.texture_program, vtx_source.str(),
+                                          frg_source.str()) ||
+        !Scene::load_shaders_from_strings(p.pattern_program, vtx_source.str(),
+                                          frg_pattern_source.str()))
+    {
+        return false;
+    }
+
+    p.texture_program.start();
+    p.texture_program["MaterialTexture0"] = 0;
+    p.texture_program.stop();
+
+    /* Create the full-screen quad, with texture coordinates */
+    p.quad_buffer = FullscreenQuad::create(true);
+
+    /* Create the source and the destination */
+    const std::string &src_format = options_["src-format"].value;
+    const std::string &dst_format = options_["dst-format"].value;
+    GLenum status;
+
+    if (p.samples > 0) {
+        GLint internal_format;
+        GLenum type;
+        color_format(src_format, internal_format, type);
+        if (internal_format == GL_RGBA)
+            internal_format = GL_RGBA8;
+
+        GLExtensions::GenRenderbuffers(1, &p.src_rb);
+        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, p.src_rb);
+        GLExtensions::RenderbufferStorageMultisample(GL_RENDERBUFFER, p.samples,
+                                                     internal_format,
+                                                     p.width, p.height);
+        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        GLExtensions::GenFramebuffers(1, &p.src_fbo);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.src_fbo);
+        GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                              GL_RENDERBUFFER, p.src_rb);
+        status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    }
+    else {
+        status = SceneBlitPrivate::create_target(src_format, p.width, p.height,
+                                                 p.filter, p.src_texture, p.src_fbo);
+    }
+
+    if (status == GL_FRAMEBUFFER_COMPLETE) {
+        status = SceneBlitPrivate::create_target(dst_format, p.dst_width, p.dst_height,
+                                                 GL_NEAREST, p.dst_texture, p.dst_fbo);
+    }
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+        Log::error("Failed to create the %s source with %u samples or the %s"
+                   " destination (status 0x%x)\n", src_format.c_str(), p.samples,
+                   dst_format.c_str(), status);
+        return false;
+    }
+
+    /* Draw the pattern into the source once, it is copied every frame */
+    glDisable(GL_DEPTH_TEST);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.src_fbo);
+    glViewport(0, 0, p.width, p.height);
+    p.draw_quad(p.pattern_program);
+
+    /* Not all the methods can copy between all the formats, check this one */
+    while (glGetError() != GL_NO_ERROR);
+    p.copy();
+    GLenum error = glGetError();
+
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+    glViewport(0, 0, canvas_.width(), canvas_.height());
+
+    if (error != GL_NO_ERROR) {
+        Log::error("Copying from %s to %s with method=%s failed (error 0x%x)\n",
+                   src_format.c_str(), dst_format.c_str(), method.c_str(), error);
+        return false;
+    }
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneBlit::teardown()
+{
+    glEnable(GL_DEPTH_TEST);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneBlit::update()
+{
+    Scene::update();
+}
+
+/*
+ * Makes the copies, then draws the destination on the canvas so that the
+ * result shows. The drawing isn't counted as a copy.
+ */
+void
+SceneBlit::draw()
+{
+    SceneBlitPrivate &p(*priv_);
+
+    for (unsigned int i = 0; i < p.copies; i++)
+        p.copy();
+
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+    glViewport(0, 0, canvas_.width(), canvas_.height());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, p.dst_texture);
+    p.draw_quad(p.texture_program);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Scene::ValidationResult
+SceneBlit::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneBlit::rates()
+{
+    SceneBlitPrivate &p(*priv_);
+    double elapsed = elapsed_time();
+    int width = p.dst_width;
+    int height = p.dst_height;
+
+    if (p.method == SceneBlitPrivate::MethodCopyTex) {
+        width = std::min(p.width, p.dst_width);
+        height = std::min(p.height, p.dst_height);
+    }
+
+    double pixels = static_cast<double>(p.copies) * width * height * frame_count();
+
+    return std::vector<Rate>(1, Rate("GigapixelsPerSecond", "gigapixels_per_second",
+                                     elapsed > 0.0 ? pixels / elapsed / 1e9 : 0.0));
+}
@@ -29,21 +29,129 @@
 #include "util.h"
 #include "gl-headers.h"
 #include <cmath>
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCENE_BUFFER_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SCENE_BUFFER_NEON 1
+#include <arm_neon.h>
+#endif
+
+/*****************************
+ * WaveWorkers implementation *
+ *****************************/
+
+/**
+ * A pool of threads that compute parts of the vertex data of a wave mesh,
+ * along with the thread that updates it.
+ */
+class WaveWorkers
+{
+public:
+    typedef std::function<void(unsigned int)> Job;
+
+    /**
+     * @param count the number of parts to compute at once, including the
+     *              one computed by the calling thread
+     */
+    WaveWorkers(unsigned int count) :
+        count_(count), job_(0), generation_(0), pending_(0), quit_(false)
+    {
+        for (unsigned int i = 1; i < count_; i++)
+            threads_.push_back(std::thread(&WaveWorkers::run, this, i));
+    }
+
+    ~WaveWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        start_cond_.notify_all();
+
+        for (size_t i = 0; i < threads_.size(); i++)
+            threads_[i].join();
+    }
+
+    unsigned int count() const { return count_; }
+
+    /**
+     * Runs a job for each part, part 0 on the calling thread, and returns
+     * once all of them are done.
+     */
+    void run_all(const Job &job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job_ = &job;
+            pending_ = count_ - 1;
+            generation_++;
+        }
+        start_cond_.notify_all();
+
+        job(0);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cond_.wait(lock, [this] { return pending_ == 0; });
+        job_ = 0;
+    }
+
+private:
+    void run(unsigned int part)
+    {
+        unsigned long seen = 0;
+
+        while (true) {
+            const Job *job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                start_cond_.wait(lock, [this, seen] { return quit_ || generation_ != seen; });
+                if (quit_)
+                    return;
+                seen = generation_;
+                job = job_;
+            }
+
+            (*job)(part);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (--pending_ == 0)
+                done_cond_.notify_one();
+        }
+    }
+
+    unsigned int count_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable start_cond_;
+    std::condition_variable done_cond_;
+    const Job *job_;
+    unsigned long generation_;
+    unsigned int pending_;
+    bool quit_;
+};
 
 /***********************
  * Wave implementation *
  ***********************/
 
 /**
- * A callback used to set up the grid by the Wave class.
+ * A callback used to fill the grid by the Wave class.
  * It is called for each "quad" of the grid.
  */
 static void
-wave_grid_conf(Mesh &mesh, int x, int y, int n_x, int n_y,
-               LibMatrix::vec3 &ul,
-               LibMatrix::vec3 &ll,
-               LibMatrix::vec3 &ur,
-               LibMatrix::vec3 &lr)
+wave_grid_fill(Mesh &mesh, float *dest, int x, int y, int n_x, int n_y,
+               const LibMatrix::vec3 &ul,
+               const LibMatrix::vec3 &ll,
+               const LibMatrix::vec3 &ur,
+               const LibMatrix::vec3 &lr)
 {
     // These parameters are unused in this instance of a virtual callback
     // function.
@@ -62,15 +170,15 @@ wave_grid_conf(Mesh &mesh, int x, int y, int n_x, int n_y,
     };
 
     for (int i = 0; i < 6; i++) {
-        mesh.next_vertex();
+        float *vertex = dest + i * mesh.vertex_size();
         /*
          * Set the vertex position and the three vertex positions
          * of the triangle this vertex belongs to.
          */
-        mesh.set_attrib(0, *t[i]);
-        mesh.set_attrib(1, *t[3 * (i / 3)]);
-        mesh.set_attrib(2, *t[3 * (i / 3) + 1]);
-        mesh.set_attrib(3, *t[3 * (i / 3) + 2]);
+        mesh.set_attrib(0, *t[i], vertex);
+        mesh.set_attrib(1, *t[3 * (i / 3)], vertex);
+        mesh.set_attrib(2, *t[3 * (i / 3) + 1], vertex);
+        mesh.set_attrib(3, *t[3 * (i / 3) + 2], vertex);
     }
 }
 
@@ -89,33 +197,37 @@ public:
      * @param nwidth the number of width-wise grid subdivisions
      * @param wavelength the wave length as a proportion of the length
      * @param duty_cycle the duty cycle ()
+     * @param simd whether to fill the vertex data a quad at a time, with
+     *             SIMD if available
+     * @param threads the number of threads filling the vertex data
      */
     WaveMesh(double length, double width, size_t nlength, size_t nwidth,
-             double wavelength, double duty_cycle) :
+             double wavelength, double duty_cycle, bool simd = false,
+             unsigned int threads = 1) :
         length_(length), width_(width), nlength_(nlength), nwidth_(nwidth),
         wave_k_(2 * M_PI / (wavelength * length)),
         wave_period_(2.0 * M_PI / wave_k_),
         wave_full_period_(wave_period_ / duty_cycle),
-        wave_velocity_(0.1 * length), displacement_(nlength + 1)
+        wave_velocity_(0.1 * length), displacement_(nlength + 1),
+        simd_(simd), workers_(threads > 1 ? new WaveWorkers(threads) : 0)
     {
         create_program();
         create_mesh();
     }
 
 
-    ~WaveMesh() { reset(); }
+    ~WaveMesh() { reset(); delete workers_; }
 
     /**
-     * Updates the state of a wave mesh.
+     * Computes the vertex data of a wave mesh, without uploading them.
      *
      * @param elapsed the time elapsed since the beginning of the rendering
      */
-    void update(double elapsed)
+    void prepare(double elapsed)
     {
-        std::vector<std::vector<float> >& vertices(mesh_.vertices());
-
         /* Figure out which length index ranges need update */
-        std::vector<std::pair<size_t, size_t> > ranges;
+        std::vector<std::pair<size_t, size_t> > &ranges(ranges_);
+        ranges.clear();
 
         for (size_t n = 0; n <= nlength_; n++) {
             double d(displacement(n, elapsed));
@@ -134,7 +246,9 @@ public:
             displacement_[n] = d;
         }
 
-        /* Update the vertex data of the changed ranges */
+        /* Turn the length index ranges into vertex ranges */
+        size_t total = 0;
+
         for (std::vector<std::pair<size_t, size_t> >::iterator iter = ranges.begin();
              iter != ranges.end();
              iter++)
@@ -147,20 +261,34 @@ public:
              */
             size_t vend((iter->second + (iter->second < nlength_)) * nwidth_ * 6);
 
-            for (size_t v = vstart; v < vend; v++) {
-                size_t vt = 3 * (v / 3);
-                vertices[v][0 * 3 + 2] = displacement_[vertex_length_index(v)];
-                vertices[v][1 * 3 + 2] = displacement_[vertex_length_index(vt)];
-                vertices[v][2 * 3 + 2] = displacement_[vertex_length_index(vt + 1)];
-                vertices[v][3 * 3 + 2] = displacement_[vertex_length_index(vt + 2)];
-            }
-
             /* Update pair with actual vertex range */
             iter->first = vstart;
             iter->second = vend - 1;
+            total += vend - vstart;
+        }
+
+        /* Update the vertex data of the changed ranges */
+        if (workers_ && total >= min_vertices_per_worker * 2) {
+            unsigned int parts = std::min<size_t>(workers_->count(),
+                                                  total / min_vertices_per_worker);
+            WaveWorkers::Job job([this, total, parts](unsigned int part) {
+                if (part < parts)
+                    fill_part(total * part / parts, total * (part + 1) / parts);
+            });
+            workers_->run_all(job);
         }
+        else {
+            fill_part(0, total);
+        }
+    }
 
-        mesh_.update_vbo(ranges);
+    /**
+     * Uploads the vertex data computed by the last ::prepare().
+     */
+    void update()
+    {
+        mesh_.update_vbo(ranges_);
+        ranges_.clear();
     }
 
     Mesh& mesh() { return mesh_; }
@@ -187,6 +315,155 @@ private:
     double wave_velocity_;
 
     std::vector<double> displacement_;
+    /* The vertex ranges changed by ::prepare(), not uploaded yet */
+    std::vector<std::pair<size_t, size_t> > ranges_;
+    bool simd_;
+    WaveWorkers *workers_;
+
+    /* Below this many vertices per thread, the threads aren't worth it */
+    static const size_t min_vertices_per_worker = 4096;
+
+    /**
+     * Updates the vertex data of a part of the changed vertices.
+     *
+     * @param first the index of the first vertex of the part, counting
+     *              the vertices of all the ranges
+     * @param last the index of the vertex after the part
+     */
+    void fill_part(size_t first, size_t last)
+    {
+        size_t offset = 0;
+
+        for (std::vector<std::pair<size_t, size_t> >::const_iterator iter = ranges_.begin();
+             iter != ranges_.end() && offset < last;
+             iter++)
+        {
+            size_t size(iter->second - iter->first + 1);
+
+            if (offset + size > first) {
+                size_t vstart(iter->first + (first > offset ? first - offset : 0));
+                size_t vend(iter->first + std::min(size, last - offset));
+
+                if (simd_)
+                    fill_quads(vstart, vend);
+                else
+                    fill_vertices(vstart, vend);
+            }
+
+            offset += size;
+        }
+    }
+
+    /**
+     * Updates the displacements of a range of vertices, one at a time.
+     */
+    void fill_vertices(size_t vstart, size_t vend)
+    {
+        for (size_t v = vstart; v < vend; v++) {
+            size_t vt = 3 * (v / 3);
+            float *vertex(mesh_.vertex(v));
+            vertex[0 * 3 + 2] = displacement_[vertex_length_index(v)];
+            vertex[1 * 3 + 2] = displacement_[vertex_length_index(vt)];
+            vertex[2 * 3 + 2] = displacement_[vertex_length_index(vt + 1)];
+            vertex[3 * 3 + 2] = displacement_[vertex_length_index(vt + 2)];
+        }
+    }
+
+    /**
+     * Updates the displacements of a range of vertices a quad at a time.
+     *
+     * The 6 vertices of a quad (12 floats each) are at the length indices
+     * i and i + 1 of its row, so all the quads of a row get the same z
+     * values, which are blended into their 18 vectors of 4 floats.
+     */
+    void fill_quads(size_t vstart, size_t vend)
+    {
+        const size_t row_size(6 * nwidth_);
+        size_t v(vstart);
+
+        while (v < vend) {
+            size_t row(v / row_size);
+            size_t row_end(std::min(vend, (row + 1) * row_size));
+            float d[2] = {
+                static_cast<float>(displacement_[row]),
+                static_cast<float>(displacement_[row + 1])
+            };
+
+            /*
+             * The z of a vertex is at its parity, and those of its triangle
+             * at the parities of the triangle vertices: 0, 1, 0 for the
+             * first triangle of the quad and 1, 0, 1 for the second.
+             */
+            float z[72];
+            for (unsigned int j = 0; j < 6; j++) {
+                unsigned int t = j < 3 ? 0 : 1;
+                z[j * 12 + 2] = d[j % 2];
+                z[j * 12 + 5] = d[t];
+                z[j * 12 + 8] = d[1 - t];
+                z[j * 12 + 11] = d[t];
+            }
+
+            /* Partial quads at the ends of the range */
+            size_t quad_start(std::min(row_end, (v + 5) / 6 * 6));
+            size_t quads((row_end - quad_start) / 6);
+
+            fill_vertices(v, quad_start);
+            fill_whole_quads(mesh_.vertex(quad_start), quads, z);
+            fill_vertices(quad_start + quads * 6, row_end);
+
+            v = row_end;
+        }
+    }
+
+    static void fill_whole_quads(float *dest, size_t quads, const float *z)
+    {
+#if defined(SCENE_BUFFER_SSE2) || defined(SCENE_BUFFER_NEON)
+        /* Only the z of each vertex attribute, every third float, is set */
+        union {
+            uint32_t u[72];
+            float f[72];
+        } mask;
+        float zv[72];
+        for (unsigned int i = 0; i < 72; i++) {
+            mask.u[i] = i % 3 == 2 ? 0xffffffff : 0;
+            zv[i] = i % 3 == 2 ? z[i] : 0.0f;
+        }
+#endif
+
+#if defined(SCENE_BUFFER_SSE2)
+        __m128 m[18];
+        __m128 values[18];
+        for (unsigned int k = 0; k < 18; k++) {
+            m[k] = _mm_loadu_ps(&mask.f[k * 4]);
+            values[k] = _mm_loadu_ps(&zv[k * 4]);
+        }
+
+        for (size_t q = 0; q < quads; q++, dest += 72) {
+            for (unsigned int k = 0; k < 18; k++) {
+                __m128 old = _mm_loadu_ps(dest + k * 4);
+                _mm_storeu_ps(dest + k * 4,
+                              _mm_or_ps(_mm_andnot_ps(m[k], old), values[k]));
+            }
+        }
+#elif defined(SCENE_BUFFER_NEON)
+        uint32x4_t m[18];
+        float32x4_t values[18];
+        for (unsigned int k = 0; k < 18; k++) {
+            m[k] = vld1q_u32(&mask.u[k * 4]);
+            values[k] = vld1q_f32(&zv[k * 4]);
+        }
+
+        for (size_t q = 0; q < quads; q++, dest += 72) {
+            for (unsigned int k = 0; k < 18; k++)
+                vst1q_f32(dest + k * 4, vbslq_f32(m[k], values[k], vld1q_f32(dest + k * 4)));
+        }
+#else
+        for (size_t q = 0; q < quads; q++, dest += 72) {
+            for (unsigned int i = 2; i < 72; i += 3)
+                dest[i] = z[i];
+        }
+#endif
+    }
 
     /**
      * Calculates the length index of a vertex.
@@ -283,7 +560,7 @@ private:
         mesh_.set_attrib_locations(attrib_locations);
 
         mesh_.make_grid(nlength_, nwidth_, length_, width_,
-                        0.0, wave_grid_conf);
+                        0.0, wave_grid_fill);
     }
 
 };
@@ -307,7 +584,7 @@ SceneBuffer::SceneBuffer(Canvas &pCanvas) :
                                            "false,true");
     options_["update-method"] = Scene::Option("update-method", "map",
                                               "Which method to use to update vertex data",
-                                              "map,subdata");
+                                              "map,subdata,map-range,persistent");
     options_["update-fraction"] = Scene::Option("update-fraction", "1.0",
                                                 "The fraction of the mesh length that is updated at every iteration (0.0-1.0)");
     options_["update-dispersion"] = Scene::Option("update-dispersion", "0.0",
@@ -319,6 +596,25 @@ SceneBuffer::SceneBuffer(Canvas &pCanvas) :
     options_["buffer-usage"] = Scene::Option("buffer-usage", "static",
                                              "How the buffer will be used",
                                              "static,stream,dynamic");
+    options_["vertex-format"] = Scene::Option("vertex-format", "float",
+                                              "How to store vertex attributes (compact: half float positions)",
+                                              "float,compact");
+    options_["buffering"] = Scene::Option("buffering", "1",
+                                          "The number of VBO copies to rotate through when updating");
+    options_["orphan"] = Scene::Option("orphan", "false",
+                                       "Whether to orphan the VBO storage before updating it",
+                                       "false,true");
+    options_["generate"] = Scene::Option("generate", "vertex",
+                                         "How to compute the vertex data on the CPU: a vertex"
+                                         " at a time, or a quad at a time with SIMD",
+                                         "vertex,simd");
+    options_["threads"] = Scene::Option("threads", "1",
+                                        "The number of threads computing the vertex data"
+                                        " (0: one per CPU)");
+    options_["coalesce"] = Scene::Option("coalesce", "none",
+                                         "How to merge the updated ranges into fewer uploads"
+                                         " (none, all, or the largest gap in bytes between"
+                                         " ranges to merge)");
 }
 
 SceneBuffer::~SceneBuffer()
@@ -329,7 +625,9 @@ SceneBuffer::~SceneBuffer()
 bool
 SceneBuffer::supported(bool show_errors)
 {
-    if (options_["update-method"].value != "subdata" &&
+    const std::string &method(options_["update-method"].value);
+
+    if (method == "map" &&
         (GLExtensions::MapBuffer == 0 || GLExtensions::UnmapBuffer == 0))
     {
         if (show_errors) {
@@ -339,6 +637,45 @@ SceneBuffer::supported(bool show_errors)
         return false;
     }
 
+    if ((method == "map-range" || method == "persistent") &&
+        (GLExtensions::MapBufferRange == 0 || GLExtensions::UnmapBuffer == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested %s VBO update method but MapBufferRange"
+                       " is not supported!\n", method.c_str());
+        }
+        return false;
+    }
+
+    if (options_["vertex-format"].value == "compact" &&
+        !Mesh::attrib_format_supported(Mesh::AttribFormatHalfFloat))
+    {
+        if (show_errors) {
+            Log::error("Requested compact vertex format but half float"
+                       " vertex attributes are not supported!\n");
+        }
+        return false;
+    }
+
+    if (method == "persistent" && options_["orphan"].value == "true") {
+        if (show_errors) {
+            Log::error("Persistent VBOs have immutable storage and cannot"
+                       " be orphaned!\n");
+        }
+        return false;
+    }
+
+    if (method == "persistent" &&
+        (GLExtensions::BufferStorage == 0 || GLExtensions::FenceSync == 0 ||
+         GLExtensions::DeleteSync == 0 || GLExtensions::ClientWaitSync == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested persistent VBO update method but"
+                       " GL_ARB_buffer_storage is not supported!\n");
+        }
+        return false;
+    }
+
     return true;
 }
 
@@ -370,11 +707,16 @@ SceneBuffer::setup()
     double update_dispersion;
     size_t nlength;
     size_t nwidth;
+    unsigned int buffering;
 
     if (options_["update-method"].value == "map")
         update_method = Mesh::VBOUpdateMethodMap;
     else if (options_["update-method"].value == "subdata")
         update_method = Mesh::VBOUpdateMethodSubData;
+    else if (options_["update-method"].value == "map-range")
+        update_method = Mesh::VBOUpdateMethodMapRange;
+    else if (options_["update-method"].value == "persistent")
+        update_method = Mesh::VBOUpdateMethodPersistent;
     else
         update_method = Mesh::VBOUpdateMethodMap;
 
@@ -389,15 +731,31 @@ SceneBuffer::setup()
     update_dispersion = Util::fromString<double>(options_["update-dispersion"].value);
     nlength = Util::fromString<size_t>(options_["columns"].value);
     nwidth = Util::fromString<size_t>(options_["rows"].value);
+    buffering = Util::fromString<unsigned int>(options_["buffering"].value);
+
 
+    unsigned int threads = Util::fromString<unsigned int>(options_["threads"].value);
+    if (threads == 0)
+        threads = std::max(1U, std::thread::hardware_concurrency());
 
     priv_->wave = new WaveMesh(5.0, 2.0, nlength, nwidth,
                                update_fraction * (1.0 - update_dispersion + 0.0001),
-                               update_fraction);
+                               update_fraction,
+                               options_["generate"].value == "simd", threads);
 
     priv_->wave->mesh().interleave(interleave);
     priv_->wave->mesh().vbo_update_method(update_method);
     priv_->wave->mesh().vbo_usage(usage);
+    priv_->wave->mesh().vbo_buffering(buffering);
+    priv_->wave->mesh().vbo_orphan(options_["orphan"].value == "true");
+    if (options_["coalesce"].value == "all")
+        priv_->wave->mesh().vbo_coalesce(true);
+    else if (options_["coalesce"].value != "none")
+        priv_->wave->mesh().vbo_coalesce(true, Util::fromString<size_t>(options_["coalesce"].value));
+    if (options_["vertex-format"].value == "compact") {
+        std::vector<Mesh::AttribFormat> formats(4, Mesh::AttribFormatHalfFloat);
+        priv_->wave->mesh().set_attrib_formats(formats);
+    }
     priv_->wave->mesh().build_vbo();
 
     priv_->wave->program().start();
@@ -429,9 +787,19 @@ SceneBuffer::update()
 {
     Scene::update();
 
-    double elapsed_time = lastUpdateTime_ - startTime_;
+    /* When pipelined, the vertex data were computed during the last frame */
+    if (!pipelined_)
+        prepare();
 
-    priv_->wave->update(elapsed_time);
+    priv_->wave->update();
+}
+
+void
+SceneBuffer::prepare()
+{
+    double elapsed_time = animation_time();
+
+    priv_->wave->prepare(elapsed_time);
 }
 
 void
@@ -450,6 +818,33 @@ SceneBuffer::draw()
     priv_->wave->mesh().render_vbo();
 }
 
+void
+SceneBuffer::reset_measurements()
+{
+    if (priv_->wave)
+        priv_->wave->mesh().reset_vbo_update_stats();
+}
+
+std::vector<Scene::Rate>
+SceneBuffer::rates()
+{
+    std::vector<Rate> rates;
+    double elapsed = elapsed_time();
+
+    if (!priv_->wave || elapsed <= 0.0)
+        return rates;
+
+    const Mesh &mesh(priv_->wave->mesh());
+
+    /* Fewer calls with coalescing, at the cost of more bytes */
+    rates.push_back(Rate("UploadCallsPerSecond", "upload_calls_per_second",
+                         mesh.vbo_update_calls() / elapsed));
+    rates.push_back(Rate("UploadMBPerSecond", "upload_mb_per_second",
+                         mesh.vbo_update_bytes() / elapsed / 1e6));
+
+    return rates;
+}
+
 Scene::ValidationResult
 SceneBuffer::validate()
 {
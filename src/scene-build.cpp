@@ -30,11 +30,26 @@
 #include "shader-source.h"
 #include "model.h"
 #include "util.h"
+#include "gl-headers.h"
+#include <algorithm>
 #include <cmath>
 
 SceneBuild::SceneBuild(Canvas &pCanvas) :
     Scene(pCanvas, "build"),
-    orientModel_(false)
+    orientModel_(false),
+    triangles_(0),
+    trianglesDrawn_(0.0),
+    instances_(1),
+    columns_(1),
+    spacing_(0.0f),
+    viewRadius_(0.0f),
+    occlusionQuery_(false),
+    queryTarget_(GL_ANY_SAMPLES_PASSED),
+    queryFrames_(2),
+    queryFrame_(0),
+    culledDraws_(0.0),
+    lodScale_(0.0f),
+    lodPixels_(0.0f)
 {
     const ModelMap& modelMap = Model::find_models();
     std::string optionValues;
@@ -54,17 +69,198 @@ SceneBuild::SceneBuild(Canvas &pCanvas) :
     options_["use-vbo"] = Scene::Option("use-vbo", "true",
                                         "Whether to use VBOs for rendering",
                                         "false,true");
+    options_["use-vao"] = Scene::Option("use-vao", "false",
+                                        "Whether to record the vertex attribute state in a VAO (with use-vbo=true)",
+                                        "false,true");
+    options_["vertex-format"] = Scene::Option("vertex-format", "float",
+                                              "How to store vertex attributes (compact: half float positions, 2_10_10_10 normals, with use-vbo=true)",
+                                              "float,compact");
     options_["interleave"] = Scene::Option("interleave", "false",
                                            "Whether to interleave vertex attribute data",
                                            "false,true");
+    options_["use-index"] = Scene::Option("use-index", "false",
+                                          "Whether to merge identical vertices and use indexed rendering",
+                                          "false,true");
+    options_["model-optimize"] = Scene::Option("model-optimize", "none",
+                                               "How to reorder the model geometry for the GPU (vcache: vertex cache, overdraw: vertex cache and overdraw)",
+                                               "none,vcache,overdraw");
     options_["model"] = Scene::Option("model", "horse", "Which model to use",
                                       optionValues);
+    options_["triangles"] = Scene::Option("triangles", "0",
+                                          "The number of triangles of a procedural torus to render instead of the model (0: use the model, sweep: 10k to 10M)");
+    Util::split("10000,100000,1000000,10000000", ',',
+                options_["triangles"].sweep_values, Util::SplitModeNormal);
+    options_["instances"] = Scene::Option("instances", "1",
+                                          "The number of model instances, in layers receding from the viewer");
+    options_["instance-spacing"] = Scene::Option("instance-spacing", "1.0",
+                                                 "The distance between the instances, relative to the model size");
+    options_["lod-levels"] = Scene::Option("lod-levels", "1",
+                                           "The number of levels of detail, simplified from the model (1: only the model)");
+    options_["lod-ratio"] = Scene::Option("lod-ratio", "0.5",
+                                          "The ratio of the triangles of each level of detail to those of the previous one");
+    options_["lod-pixels"] = Scene::Option("lod-pixels", "300",
+                                           "The projected size in pixels under which an instance uses the next level of detail, halving for each further level");
+    options_["occlusion-query"] = Scene::Option("occlusion-query", "false",
+                                                "Whether to skip the instances that occlusion queries found hidden",
+                                                "false,true");
+    options_["query-frames"] = Scene::Option("query-frames", "2",
+                                             "How many frames old the occlusion query results may be (with occlusion-query=true)");
+    DepthConfig::add_options(options_);
 }
 
 SceneBuild::~SceneBuild()
 {
 }
 
+/*
+ * Tessellates a torus around the Z axis into about the given number of
+ * triangles, with twice as many segments around the axis as around the
+ * tube.
+ */
+static void
+create_torus(Mesh &mesh, unsigned int triangles, bool use_index,
+             LibMatrix::vec3 &minVec, LibMatrix::vec3 &maxVec)
+{
+    using LibMatrix::vec3;
+
+    static const float major_radius = 1.0f;
+    static const float minor_radius = 0.4f;
+
+    unsigned int tube = std::max(2u, static_cast<unsigned int>(
+                                     std::sqrt(triangles / 4.0) + 0.5));
+    unsigned int ring = 2 * tube;
+    unsigned int row = tube + 1;
+
+    std::vector<int> vertex_format;
+    vertex_format.push_back(3);
+    vertex_format.push_back(3);
+    mesh.reset();
+    mesh.set_vertex_format(vertex_format);
+
+    std::vector<vec3> positions;
+    std::vector<vec3> normals;
+    for (unsigned int i = 0; i <= ring; i++) {
+        float u = 2.0 * M_PI * i / ring;
+        for (unsigned int j = 0; j <= tube; j++) {
+            float v = 2.0 * M_PI * j / tube;
+            vec3 normal(std::cos(u) * std::cos(v), std::sin(u) * std::cos(v),
+                        std::sin(v));
+            vec3 center(std::cos(u) * major_radius, std::sin(u) * major_radius, 0.0);
+            positions.push_back(center + normal * minor_radius);
+            normals.push_back(normal);
+        }
+    }
+
+    static const unsigned int quad_corners[6][2] = {
+        {0, 0}, {1, 0}, {1, 1}, {0, 0}, {1, 1}, {0, 1}
+    };
+    if (use_index) {
+        for (unsigned int n = 0; n < positions.size(); n++) {
+            mesh.next_vertex();
+            mesh.set_attrib(0, positions[n]);
+            mesh.set_attrib(1, normals[n]);
+        }
+    }
+    for (unsigned int i = 0; i < ring; i++) {
+        for (unsigned int j = 0; j < tube; j++) {
+            for (unsigned int c = 0; c < 6; c++) {
+                unsigned int n = (i + quad_corners[c][0]) * row + j + quad_corners[c][1];
+                if (use_index) {
+                    mesh.add_index(n);
+                }
+                else {
+                    mesh.next_vertex();
+                    mesh.set_attrib(0, positions[n]);
+                    mesh.set_attrib(1, normals[n]);
+                }
+            }
+        }
+    }
+
+    float extent = major_radius + minor_radius;
+    minVec = vec3(-extent, -extent, -minor_radius);
+    maxVec = vec3(extent, extent, minor_radius);
+
+    Log::debug("Procedural torus: %u triangles, %u vertices\n",
+               2 * ring * tube, static_cast<unsigned int>(mesh.vertex_count()));
+}
+
+bool
+SceneBuild::supported(bool show_errors)
+{
+    if (options_["use-vbo"].value == "true" &&
+        options_["vertex-format"].value == "compact" &&
+        (!Mesh::attrib_format_supported(Mesh::AttribFormatHalfFloat) ||
+         !Mesh::attrib_format_supported(Mesh::AttribFormatInt2101010Rev)))
+    {
+        if (show_errors) {
+            Log::error("Requested compact vertex format but half float or"
+                       " 2_10_10_10 vertex attributes are not supported!\n");
+        }
+        return false;
+    }
+
+    if (options_["use-vbo"].value == "true" &&
+        options_["use-vao"].value == "true" &&
+        GLExtensions::GenVertexArrays == 0)
+    {
+        if (show_errors) {
+            Log::error("Requested VAO rendering but vertex array objects"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    if (Util::fromString<int>(options_["instances"].value) < 1 ||
+        Util::fromString<int>(options_["query-frames"].value) < 1)
+    {
+        if (show_errors) {
+            Log::error("The instances and query-frames must be at least 1!\n");
+        }
+        return false;
+    }
+
+    if (Util::fromString<int>(options_["triangles"].value) < 0) {
+        if (show_errors) {
+            Log::error("The number of triangles can't be negative!\n");
+        }
+        return false;
+    }
+
+    if (Util::fromString<float>(options_["instance-spacing"].value) <= 0.0f) {
+        if (show_errors) {
+            Log::error("The instance-spacing must be positive!\n");
+        }
+        return false;
+    }
+
+    if (!DepthConfig::supported(options_, true, show_errors))
+        return false;
+
+    float lod_ratio = Util::fromString<float>(options_["lod-ratio"].value);
+    if (Util::fromString<int>(options_["lod-levels"].value) < 1 ||
+        lod_ratio <= 0.0f || lod_ratio >= 1.0f)
+    {
+        if (show_errors) {
+            Log::error("The lod-levels must be at least 1 and the lod-ratio"
+                       " between 0 and 1!\n");
+        }
+        return false;
+    }
+
+    if (options_["occlusion-query"].value == "true" &&
+        GLExtensions::BeginQuery == 0)
+    {
+        if (show_errors) {
+            Log::error("Requested occlusion queries but queries"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
 bool
 SceneBuild::load()
 {
@@ -81,32 +277,14 @@ SceneBuild::unload()
     mesh_.reset();
 }
 
+/*
+ * Loads the model into the mesh, and gets its orientation and bounds.
+ */
 bool
-SceneBuild::setup()
+SceneBuild::load_model(bool use_index)
 {
     using LibMatrix::vec3;
 
-    if (!Scene::setup())
-        return false;
-
-    /* Set up shaders */
-    static const std::string vtx_shader_filename(Options::data_path + "/shaders/light-basic.vert");
-    static const std::string frg_shader_filename(Options::data_path + "/shaders/light-basic.frag");
-    static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
-    static const LibMatrix::vec4 materialDiffuse(1.0f, 1.0f, 1.0f, 1.0f);
-
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
-
-    vtx_source.add_const("LightSourcePosition", lightPosition);
-    vtx_source.add_const("MaterialDiffuse", materialDiffuse);
-
-    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
-                                          frg_source.str()))
-    {
-        return false;
-    }
-
     Model model;
     const std::string& whichModel(options_["model"].value);
     bool modelLoaded = model.load(whichModel);
@@ -150,7 +328,58 @@ SceneBuild::setup()
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
 
-    model.convert_to_mesh(mesh_, attribs);
+    model.convert_to_mesh(mesh_, attribs, use_index);
+
+    maxVec_ = model.maxVec();
+    minVec_ = model.minVec();
+
+    return true;
+}
+
+bool
+SceneBuild::setup()
+{
+    using LibMatrix::vec3;
+
+    if (!Scene::setup())
+        return false;
+
+    /* Set up shaders */
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/light-basic.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/light-basic.frag");
+    static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
+    static const LibMatrix::vec4 materialDiffuse(1.0f, 1.0f, 1.0f, 1.0f);
+
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    vtx_source.add_const("LightSourcePosition", lightPosition);
+    vtx_source.add_const("MaterialDiffuse", materialDiffuse);
+
+    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    bool useIndex = (options_["use-index"].value == "true");
+    Mesh::OptimizeMode optimize =
+        Mesh::optimize_mode_from_str(options_["model-optimize"].value);
+
+    unsigned int lod_levels = Util::fromString<unsigned int>(options_["lod-levels"].value);
+
+    /* Geometry optimization and levels of detail work on indexed meshes */
+    useIndex = useIndex || optimize != Mesh::OptimizeNone || lod_levels > 1;
+    triangles_ = Util::fromString<unsigned int>(options_["triangles"].value);
+    orientModel_ = false;
+    if (triangles_ > 0)
+        create_torus(mesh_, triangles_, useIndex, minVec_, maxVec_);
+    else if (!load_model(useIndex))
+        return false;
+    mesh_.optimize(optimize);
+    mesh_.generate_lods(lod_levels, Util::fromString<float>(options_["lod-ratio"].value));
+
+    triangles_ = mesh_.lod_triangles(0);
 
     std::vector<GLint> attrib_locations;
     attrib_locations.push_back(program_["position"].location());
@@ -162,26 +391,88 @@ SceneBuild::setup()
 
     mesh_.vbo_update_method(Mesh::VBOUpdateMethodMap);
     mesh_.interleave(interleave);
+    mesh_.vbo_vao(options_["use-vao"].value == "true");
+
+    if (options_["vertex-format"].value == "compact") {
+        std::vector<Mesh::AttribFormat> formats;
+        formats.push_back(Mesh::AttribFormatHalfFloat);
+        formats.push_back(Mesh::AttribFormatInt2101010Rev);
+        mesh_.set_attrib_formats(formats);
+    }
 
     if (useVbo_)
         mesh_.build_vbo();
     else
         mesh_.build_array();
 
-    /* Calculate a projection matrix that is a good fit for the model */
-    vec3 maxVec = model.maxVec();
-    vec3 minVec = model.minVec();
-    vec3 diffVec = maxVec - minVec;
-    centerVec_ = maxVec + minVec;
+    /*
+     * The instances are laid out in square layers of columns_ by columns_,
+     * receding from the viewer, so that the front layers hide parts of the
+     * ones behind.
+     */
+    instances_ = Util::fromString<unsigned int>(options_["instances"].value);
+    columns_ = static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<float>(instances_)) - 0.001f));
+    unsigned int layers = (instances_ + columns_ * columns_ - 1) / (columns_ * columns_);
+
+    /* Calculate a projection matrix that is a good fit for the instances */
+    vec3 diffVec = maxVec_ - minVec_;
+    centerVec_ = maxVec_ + minVec_;
     centerVec_ /= 2.0;
     float diameter = diffVec.length();
     radius_ = diameter / 2;
-    float fovy = 2.0 * atanf(radius_ / (2.0 + radius_));
+    spacing_ = diameter * Util::fromString<float>(options_["instance-spacing"].value);
+    viewRadius_ = std::max(radius_, columns_ * spacing_ / 2);
+    float fovy = 2.0 * atanf(viewRadius_ / (2.0 + viewRadius_));
     fovy /= M_PI;
     fovy *= 180.0;
     float aspect(static_cast<float>(canvas_.width())/static_cast<float>(canvas_.height()));
-    perspective_.setIdentity();
-    perspective_ *= LibMatrix::Mat4::perspective(fovy, aspect, 2.0, 2.0 + diameter);
+    if (!depth_.setup(options_, &canvas_))
+        return false;
+    perspective_ = depth_.perspective(fovy, aspect, 2.0,
+                                      2.0 + viewRadius_ + (layers - 1) * spacing_ + radius_);
+
+    lodScale_ = diameter * canvas_.height() / (2.0 * std::tan(fovy * M_PI / 360.0));
+    lodPixels_ = Util::fromString<float>(options_["lod-pixels"].value);
+
+    /*
+     * Each instance has a ring of queryFrames_ queries, so the result of
+     * a query is needed only when its slot comes round again.
+     */
+    occlusionQuery_ = (options_["occlusion-query"].value == "true");
+    queryFrames_ = Util::fromString<unsigned int>(options_["query-frames"].value);
+    queryFrame_ = 0;
+    instanceVisible_.assign(instances_, true);
+    if (occlusionQuery_) {
+#if GLMARK2_USE_GLESv2
+        queryTarget_ = GL_ANY_SAMPLES_PASSED;
+#else
+        bool any_samples = GLExtensions::version_supported(3, 3) ||
+                           GLExtensions::support("GL_ARB_occlusion_query2");
+        queryTarget_ = any_samples ? GL_ANY_SAMPLES_PASSED : GL_SAMPLES_PASSED;
+#endif
+        queries_.resize(instances_ * queryFrames_);
+        GLExtensions::GenQueries(queries_.size(), &queries_[0]);
+        queryPending_.assign(queries_.size(), false);
+        queryIssueTimes_.assign(queries_.size(), 0);
+
+        /* The bounding boxes only write depth, if anything */
+        static const std::string proxy_vtx_filename(Options::data_path + "/shaders/depth-prepass.vert");
+        static const std::string proxy_frg_filename(Options::data_path + "/shaders/depth-prepass.frag");
+        ShaderSource proxy_vtx_source(proxy_vtx_filename);
+        ShaderSource proxy_frg_source(proxy_frg_filename);
+
+        if (!Scene::load_shaders_from_strings(proxyProgram_, proxy_vtx_source.str(),
+                                              proxy_frg_source.str()))
+        {
+            return false;
+        }
+
+        create_proxy_mesh();
+    }
+    queryLatencyStats_.reset();
+    queryWaitStats_.reset();
+    culledDraws_ = 0.0;
+    trianglesDrawn_ = 0.0;
 
     program_.start();
 
@@ -202,6 +493,14 @@ SceneBuild::teardown()
 
     mesh_.reset();
 
+    if (!queries_.empty()) {
+        GLExtensions::DeleteQueries(queries_.size(), &queries_[0]);
+        queries_.clear();
+    }
+    proxyProgram_.release();
+    proxyMesh_.reset();
+    depth_.teardown();
+
     Scene::teardown();
 }
 
@@ -210,39 +509,166 @@ SceneBuild::update()
 {
     Scene::update();
 
-    double elapsed_time = lastUpdateTime_ - startTime_;
+    double elapsed_time = animation_time();
 
     rotation_ = rotationSpeed_ * elapsed_time;
 }
 
-void
-SceneBuild::draw()
+/*
+ * Gets the model view matrix of an instance. The first instances are in
+ * the front layer.
+ */
+LibMatrix::mat4
+SceneBuild::instance_model_view(unsigned int i)
 {
     LibMatrix::Stack4 model_view;
+    unsigned int layer_size = columns_ * columns_;
+    float x = (static_cast<float>(i % columns_) - (columns_ - 1) / 2.0f) * spacing_;
+    float y = (static_cast<float>(i % layer_size / columns_) - (columns_ - 1) / 2.0f) * spacing_;
+    float z = -static_cast<float>(i / layer_size) * spacing_;
 
-    // Load the ModelViewProjectionMatrix uniform in the shader
-    LibMatrix::mat4 model_view_proj(perspective_);
-    model_view.translate(-centerVec_.x(), -centerVec_.y(), -(centerVec_.z() + 2.0 + radius_));
+    model_view.translate(x - centerVec_.x(), y - centerVec_.y(),
+                         z - (centerVec_.z() + 2.0 + viewRadius_));
     model_view.rotate(rotation_, 0.0f, 1.0f, 0.0f);
     if (orientModel_)
     {
         model_view.rotate(orientationAngle_, orientationVec_.x(), orientationVec_.y(), orientationVec_.z());
     }
-    model_view_proj *= model_view.getCurrent();
 
-    program_["ModelViewProjectionMatrix"] = model_view_proj;
+    return model_view.getCurrent();
+}
 
-    // Load the NormalMatrix uniform in the shader. The NormalMatrix is the
-    // inverse transpose of the model view matrix.
-    LibMatrix::mat4 normal_matrix(model_view.getCurrent());
-    normal_matrix.inverse().transpose();
-    program_["NormalMatrix"] = normal_matrix;
+/*
+ * Selects the level of detail of an instance from its projected size:
+ * the full detail model down to lod-pixels, and the next level every
+ * time the size halves.
+ */
+unsigned int
+SceneBuild::instance_lod(const LibMatrix::mat4 &model_view)
+{
+    LibMatrix::vec3 center(model_view[0][3], model_view[1][3], model_view[2][3]);
+    float projected = lodScale_ / center.length();
+    unsigned int level = 0;
 
-    if (useVbo_) {
-        mesh_.render_vbo();
+    for (float pixels = lodPixels_;
+         projected < pixels && level + 1 < mesh_.lod_count();
+         pixels /= 2.0f)
+    {
+        level++;
     }
-    else {
-        mesh_.render_array();
+
+    return level;
+}
+
+/*
+ * Reads the results of the queries of an instance that are available, from
+ * the oldest one, and waits for the one whose slot is about to be reused.
+ * Returns whether the newest result read found the instance visible.
+ */
+bool
+SceneBuild::read_query_results(unsigned int i, uint64_t &wait)
+{
+    bool visible = instanceVisible_[i];
+
+    for (unsigned int age = 0; age < queryFrames_; age++) {
+        unsigned int index = i * queryFrames_ + (queryFrame_ + age) % queryFrames_;
+        if (!queryPending_[index])
+            continue;
+
+        GLuint available = 0;
+        GLExtensions::GetQueryObjectuiv(queries_[index], GL_QUERY_RESULT_AVAILABLE,
+                                        &available);
+        /* Later queries can't be available before this one */
+        if (!available && age > 0)
+            break;
+
+        uint64_t start = Util::get_timestamp_us();
+        GLuint samples = 0;
+        GLExtensions::GetQueryObjectuiv(queries_[index], GL_QUERY_RESULT, &samples);
+        uint64_t now = Util::get_timestamp_us();
+
+        if (!available)
+            wait += now - start;
+        queryLatencyStats_.add(now - queryIssueTimes_[index]);
+        queryPending_[index] = false;
+        visible = samples != 0;
+    }
+
+    return visible;
+}
+
+void
+SceneBuild::draw()
+{
+    uint64_t wait = 0;
+
+    depth_.begin();
+    for (unsigned int i = 0; i < instances_; i++) {
+        LibMatrix::mat4 model_view(instance_model_view(i));
+
+        // Load the ModelViewProjectionMatrix uniform in the shader
+        LibMatrix::mat4 model_view_proj(perspective_);
+        model_view_proj *= model_view;
+
+        /*
+         * An instance that the last result found hidden only draws its
+         * bounding box, to find out when it comes into view again.
+         */
+        unsigned int query = i * queryFrames_ + queryFrame_;
+        if (occlusionQuery_) {
+            instanceVisible_[i] = read_query_results(i, wait);
+            GLExtensions::BeginQuery(queryTarget_, queries_[query]);
+        }
+
+        if (instanceVisible_[i]) {
+            unsigned int lod = instance_lod(model_view);
+            mesh_.lod(lod);
+            trianglesDrawn_ += mesh_.lod_triangles(lod);
+            program_["ModelViewProjectionMatrix"] = model_view_proj;
+
+            // Load the NormalMatrix uniform in the shader. The NormalMatrix is the
+            // inverse transpose of the model view matrix.
+            LibMatrix::mat4 normal_matrix(model_view);
+            normal_matrix.inverse().transpose();
+            program_["NormalMatrix"] = normal_matrix;
+
+            if (useVbo_) {
+                mesh_.render_vbo();
+            }
+            else {
+                mesh_.render_array();
+            }
+        }
+        else {
+            LibMatrix::vec3 size(maxVec_ - minVec_);
+            model_view_proj *= LibMatrix::Mat4::translate(minVec_.x(), minVec_.y(), minVec_.z());
+            model_view_proj *= LibMatrix::Mat4::scale(size.x(), size.y(), size.z());
+
+            proxyProgram_.start();
+            proxyProgram_["ModelViewProjectionMatrix"] = model_view_proj;
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+            glDepthMask(GL_FALSE);
+            glDisable(GL_CULL_FACE);
+            proxyMesh_.render_vbo();
+            glEnable(GL_CULL_FACE);
+            glDepthMask(GL_TRUE);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            program_.start();
+
+            culledDraws_ += 1.0;
+        }
+
+        if (occlusionQuery_) {
+            GLExtensions::EndQuery(queryTarget_);
+            queryPending_[query] = true;
+            queryIssueTimes_[query] = Util::get_timestamp_us();
+        }
+    }
+    depth_.end();
+
+    if (occlusionQuery_) {
+        queryWaitStats_.add(wait);
+        queryFrame_ = (queryFrame_ + 1) % queryFrames_;
     }
 }
 
@@ -251,7 +677,7 @@ SceneBuild::validate()
 {
     static const double radius_3d(std::sqrt(3.0));
 
-    if (rotation_ != 0)
+    if (rotation_ != 0 || instances_ != 1 || options_["triangles"].value != "0")
         return Scene::ValidationUnknown;
 
     Canvas::Pixel ref(0xa7, 0xa7, 0xa7, 0xff);
@@ -268,3 +694,79 @@ SceneBuild::validate()
         return Scene::ValidationFailure;
     }
 }
+
+std::vector<Scene::Measurement>
+SceneBuild::measurements()
+{
+    std::vector<Measurement> measurements;
+
+    if (occlusionQuery_) {
+        measurements.push_back(Measurement("QueryLatency", "query_latency",
+                                           queryLatencyStats_));
+        measurements.push_back(Measurement("QueryWait", "query_wait",
+                                           queryWaitStats_));
+    }
+
+    return measurements;
+}
+
+void
+SceneBuild::reset_measurements()
+{
+    queryLatencyStats_.reset();
+    queryWaitStats_.reset();
+    culledDraws_ = 0.0;
+    trianglesDrawn_ = 0.0;
+}
+
+std::vector<Scene::Rate>
+SceneBuild::rates()
+{
+    std::vector<Rate> rates;
+    double elapsed = elapsed_time();
+
+    if (elapsed <= 0.0)
+        return rates;
+
+    rates.push_back(Rate("TrianglesPerSecond", "triangles_per_second",
+                         trianglesDrawn_ / elapsed));
+    if (occlusionQuery_) {
+        rates.push_back(Rate("CulledDrawsPerSecond", "culled_draws_per_second",
+                             culledDraws_ / elapsed));
+    }
+
+    return rates;
+}
+
+/*
+ * Creates the unit cube that is scaled to the bounding box of an instance.
+ */
+void
+SceneBuild::create_proxy_mesh()
+{
+    static const unsigned int face_corners[6][4] = {
+        {0, 1, 3, 2}, {4, 6, 7, 5}, {0, 4, 5, 1},
+        {2, 3, 7, 6}, {0, 2, 6, 4}, {1, 5, 7, 3}
+    };
+    static const unsigned int face_vertices[6] = {0, 1, 2, 0, 2, 3};
+
+    std::vector<int> vertex_format;
+    vertex_format.push_back(3);
+    proxyMesh_.set_vertex_format(vertex_format);
+
+    for (unsigned int f = 0; f < 6; f++) {
+        for (unsigned int v = 0; v < 6; v++) {
+            unsigned int corner = face_corners[f][face_vertices[v]];
+            proxyMesh_.next_vertex();
+            proxyMesh_.set_attrib(0, LibMatrix::vec3(corner & 1 ? 1.0f : 0.0f,
+                                                     corner & 2 ? 1.0f : 0.0f,
+                                                     corner & 4 ? 1.0f : 0.0f));
+        }
+    }
+
+    proxyMesh_.build_vbo();
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(proxyProgram_["position"].location());
+    proxyMesh_.set_attrib_locations(attrib_locations);
+}
@@ -29,21 +29,77 @@
 #include "model.h"
 #include "texture.h"
 #include "util.h"
+#include <algorithm>
 #include <cmath>
 
 SceneBump::SceneBump(Canvas &pCanvas) :
     Scene(pCanvas, "bump"),
-    texture_(0), rotation_(0.0f), rotationSpeed_(0.0f)
+    texture_(0), rotation_(0.0f), rotationSpeed_(0.0f), tessellationLevel_(1.0f)
 {
     options_["bump-render"] = Scene::Option("bump-render", "off",
-                                            "How to render bumps",
-                                            "off,normals,normals-tangent,height,high-poly");
+                                            "How to render bumps (displacement: tessellate the"
+                                            " model and displace it by the height map)",
+                                            "off,normals,normals-tangent,height,parallax,high-poly,displacement");
+    options_["parallax-steps"] = Scene::Option("parallax-steps", "16",
+                                               "The number of height map layers the view ray steps"
+                                               " through with bump-render=parallax");
+    options_["tessellation-level"] = Scene::Option("tessellation-level", "8",
+                                                   "The tessellation level of the triangles"
+                                                   " with bump-render=displacement");
+    options_["geometry-shader"] = Scene::Option("geometry-shader", "false",
+                                                "Whether a geometry shader shades the displaced triangles"
+                                                " with their face normals (bump-render=displacement)",
+                                                "false,true");
+    options_["texture-format"] = Scene::Option("texture-format", "rgba",
+                                               "The format of the textures to use (compressed formats need <texture>.<format>.ktx[2] files)",
+                                               Texture::format_option_values);
+    DepthPrepass::add_option(options_);
 }
 
 SceneBump::~SceneBump()
 {
 }
 
+bool
+SceneBump::supported(bool show_errors)
+{
+    if (options_["bump-render"].value != "displacement")
+        return true;
+
+    if (!GLExtensions::PatchParameteri) {
+        if (show_errors) {
+            Log::error("SceneBump bump-render=displacement requires tessellation shader"
+                       " support (GL 4.0, GLES 3.2 or GLES 3.1 with"
+                       " GL_EXT_tessellation_shader)\n");
+        }
+        return false;
+    }
+
+#if GLMARK2_USE_GLESv2
+    if (options_["geometry-shader"].value == "true" &&
+        !GLExtensions::version_supported(3, 2) &&
+        !GLExtensions::support("GL_EXT_geometry_shader"))
+    {
+        if (show_errors) {
+            Log::error("SceneBump geometry-shader=true requires geometry shader"
+                       " support (GLES 3.2 or GL_EXT_geometry_shader)\n");
+        }
+        return false;
+    }
+#endif
+
+    /* The pre-pass program can't draw patches */
+    if (options_["depth-prepass"].value == "true") {
+        if (show_errors) {
+            Log::error("SceneBump bump-render=displacement doesn't support"
+                       " depth-prepass=true\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
 bool
 SceneBump::load()
 {
@@ -59,26 +115,81 @@ SceneBump::unload()
 {
 }
 
+/*
+ * Gets the shader sources of the program for the current options, except
+ * for displacement, whose program has more stages.
+ */
 bool
-SceneBump::setup_model_plain(const std::string &type)
+SceneBump::program_variant(ProgramVariant &variant)
 {
-    static const std::string vtx_shader_filename(Options::data_path + "/shaders/bump-poly.vert");
-    static const std::string frg_shader_filename(Options::data_path + "/shaders/bump-poly.frag");
-    static const std::string low_poly_filename("asteroid-low");
-    static const std::string high_poly_filename("asteroid-high");
     static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
-    Model model;
+    const std::string &bump_render = options_["bump-render"].value;
+    std::string name;
 
-    /* Calculate the half vector */
-    LibMatrix::vec3 halfVector(lightPosition.x(), lightPosition.y(), lightPosition.z());
-    halfVector.normalize();
-    halfVector += LibMatrix::vec3(0.0, 0.0, 1.0);
-    halfVector.normalize();
+    if (bump_render == "off" || bump_render == "high-poly")
+        name = "bump-poly";
+    else if (bump_render == "normals" || bump_render == "normals-tangent" ||
+             bump_render == "height" || bump_render == "parallax")
+        name = "bump-" + bump_render;
+    else
+        return false;
+
+    ShaderSource vtx_source(Options::data_path + "/shaders/" + name + ".vert");
+    ShaderSource frg_source(Options::data_path + "/shaders/" + name + ".frag");
+
+    frg_source.add_const("LightSourcePosition", lightPosition);
+
+    /* With parallax, the half vector depends on the view direction and is per fragment */
+    if (bump_render != "parallax") {
+        LibMatrix::vec3 halfVector(lightPosition.x(), lightPosition.y(), lightPosition.z());
+        halfVector.normalize();
+        halfVector += LibMatrix::vec3(0.0, 0.0, 1.0);
+        halfVector.normalize();
+        frg_source.add_const("LightSourceHalfVector", halfVector);
+    }
+
+    if (bump_render == "height" || bump_render == "parallax") {
+        frg_source.add_const("TextureStepX", 1.0 / 1024.0);
+        frg_source.add_const("TextureStepY", 1.0 / 1024.0);
+    }
 
-    std::string poly_filename = type == "high-poly" ?
-                                high_poly_filename : low_poly_filename;
+    if (bump_render == "parallax") {
+        unsigned int steps = std::max(Util::fromString<unsigned int>(options_["parallax-steps"].value), 1U);
+        frg_source.replace("$PARALLAX_STEPS$", Util::toString(steps));
+    }
+
+    variant = ProgramVariant(vtx_source.str(), frg_source.str());
+
+    return true;
+}
+
+std::vector<Scene::ProgramVariant>
+SceneBump::programs()
+{
+    std::vector<ProgramVariant> variants(1);
+
+    if (!program_variant(variants[0]))
+        variants.clear();
+
+    return variants;
+}
 
-    if(!model.load(poly_filename))
+bool
+SceneBump::load_program()
+{
+    ProgramVariant variant;
+
+    return program_variant(variant) &&
+           Scene::load_shaders_from_strings(program_, variant.vtx_shader,
+                                            variant.frg_shader);
+}
+
+bool
+SceneBump::setup_model_plain(const std::string &type)
+{
+    Model model;
+
+    if(!model.load(type == "high-poly" ? "asteroid-high" : "asteroid-low"))
         return false;
 
     if (model.needNormals())
@@ -91,19 +202,8 @@ SceneBump::setup_model_plain(const std::string &type)
 
     model.convert_to_mesh(mesh_, attribs);
 
-    /* Load shaders */
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
-
-    /* Add constants to shaders */
-    frg_source.add_const("LightSourcePosition", lightPosition);
-    frg_source.add_const("LightSourceHalfVector", halfVector);
-
-    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
-                                          frg_source.str()))
-    {
+    if (!load_program())
         return false;
-    }
 
     std::vector<GLint> attrib_locations;
     attrib_locations.push_back(program_["position"].location());
@@ -116,20 +216,11 @@ SceneBump::setup_model_plain(const std::string &type)
 bool
 SceneBump::setup_model_normals()
 {
-    static const std::string vtx_shader_filename(Options::data_path + "/shaders/bump-normals.vert");
-    static const std::string frg_shader_filename(Options::data_path + "/shaders/bump-normals.frag");
-    static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
     Model model;
 
     if(!model.load("asteroid-low"))
         return false;
 
-    /* Calculate the half vector */
-    LibMatrix::vec3 halfVector(lightPosition.x(), lightPosition.y(), lightPosition.z());
-    halfVector.normalize();
-    halfVector += LibMatrix::vec3(0.0, 0.0, 1.0);
-    halfVector.normalize();
-
     /*
      * We don't care about the vertex normals. We are using a per-fragment
      * normal map (in object space coordinates).
@@ -140,26 +231,55 @@ SceneBump::setup_model_normals()
 
     model.convert_to_mesh(mesh_, attribs);
 
-    /* Load shaders */
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
+    if (!load_program())
+        return false;
 
-    /* Add constants to shaders */
-    frg_source.add_const("LightSourcePosition", lightPosition);
-    frg_source.add_const("LightSourceHalfVector", halfVector);
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(program_["position"].location());
+    attrib_locations.push_back(program_["texcoord"].location());
+    mesh_.set_attrib_locations(attrib_locations);
 
-    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
-                                          frg_source.str()))
+    if (!Texture::load(Texture::format_name("asteroid-normal-map", options_["texture-format"].value),
+                       &texture_,
+                       GL_NEAREST, GL_NEAREST, 0))
     {
         return false;
     }
 
+    return true;
+}
+
+bool
+SceneBump::setup_model_normals_tangent()
+{
+    Model model;
+
+    if(!model.load("asteroid-low"))
+        return false;
+
+    if (model.needNormals())
+        model.calculate_normals();
+
+    std::vector<std::pair<Model::AttribType, int> > attribs;
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeTexcoord, 2));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeTangent, 3));
+
+    model.convert_to_mesh(mesh_, attribs);
+
+    if (!load_program())
+        return false;
+
     std::vector<GLint> attrib_locations;
     attrib_locations.push_back(program_["position"].location());
+    attrib_locations.push_back(program_["normal"].location());
     attrib_locations.push_back(program_["texcoord"].location());
+    attrib_locations.push_back(program_["tangent"].location());
     mesh_.set_attrib_locations(attrib_locations);
 
-    if (!Texture::load("asteroid-normal-map", &texture_,
+    if (!Texture::load(Texture::format_name("asteroid-normal-map-tangent", options_["texture-format"].value),
+                       &texture_,
                        GL_NEAREST, GL_NEAREST, 0))
     {
         return false;
@@ -169,11 +289,8 @@ SceneBump::setup_model_normals()
 }
 
 bool
-SceneBump::setup_model_normals_tangent()
+SceneBump::setup_model_height()
 {
-    static const std::string vtx_shader_filename(Options::data_path + "/shaders/bump-normals-tangent.vert");
-    static const std::string frg_shader_filename(Options::data_path + "/shaders/bump-normals-tangent.frag");
-    static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
     Model model;
 
     if(!model.load("asteroid-low"))
@@ -182,12 +299,6 @@ SceneBump::setup_model_normals_tangent()
     if (model.needNormals())
         model.calculate_normals();
 
-    /* Calculate the half vector */
-    LibMatrix::vec3 halfVector(lightPosition.x(), lightPosition.y(), lightPosition.z());
-    halfVector.normalize();
-    halfVector += LibMatrix::vec3(0.0, 0.0, 1.0);
-    halfVector.normalize();
-
     std::vector<std::pair<Model::AttribType, int> > attribs;
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
@@ -196,20 +307,48 @@ SceneBump::setup_model_normals_tangent()
 
     model.convert_to_mesh(mesh_, attribs);
 
-    /* Load shaders */
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
+    if (!load_program())
+        return false;
 
-    /* Add constants to shaders */
-    frg_source.add_const("LightSourcePosition", lightPosition);
-    frg_source.add_const("LightSourceHalfVector", halfVector);
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(program_["position"].location());
+    attrib_locations.push_back(program_["normal"].location());
+    attrib_locations.push_back(program_["texcoord"].location());
+    attrib_locations.push_back(program_["tangent"].location());
+    mesh_.set_attrib_locations(attrib_locations);
 
-    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
-                                          frg_source.str()))
+    if (!Texture::load(Texture::format_name("asteroid-height-map", options_["texture-format"].value),
+                       &texture_,
+                       GL_NEAREST, GL_NEAREST, 0))
     {
         return false;
     }
 
+    return true;
+}
+
+bool
+SceneBump::setup_model_parallax()
+{
+    Model model;
+
+    if(!model.load("asteroid-low"))
+        return false;
+
+    if (model.needNormals())
+        model.calculate_normals();
+
+    std::vector<std::pair<Model::AttribType, int> > attribs;
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeTexcoord, 2));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeTangent, 3));
+
+    model.convert_to_mesh(mesh_, attribs);
+
+    if (!load_program())
+        return false;
+
     std::vector<GLint> attrib_locations;
     attrib_locations.push_back(program_["position"].location());
     attrib_locations.push_back(program_["normal"].location());
@@ -217,7 +356,8 @@ SceneBump::setup_model_normals_tangent()
     attrib_locations.push_back(program_["tangent"].location());
     mesh_.set_attrib_locations(attrib_locations);
 
-    if (!Texture::load("asteroid-normal-map-tangent", &texture_,
+    if (!Texture::load(Texture::format_name("asteroid-height-map", options_["texture-format"].value),
+                       &texture_,
                        GL_NEAREST, GL_NEAREST, 0))
     {
         return false;
@@ -227,9 +367,12 @@ SceneBump::setup_model_normals_tangent()
 }
 
 bool
-SceneBump::setup_model_height()
+SceneBump::setup_model_displacement()
 {
-    static const std::string vtx_shader_filename(Options::data_path + "/shaders/bump-height.vert");
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/bump-displacement.vert");
+    static const std::string tcs_shader_filename(Options::data_path + "/shaders/bump-displacement.tesc");
+    static const std::string tes_shader_filename(Options::data_path + "/shaders/bump-displacement.tese");
+    static const std::string geo_shader_filename(Options::data_path + "/shaders/bump-displacement.geom");
     static const std::string frg_shader_filename(Options::data_path + "/shaders/bump-height.frag");
     static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
     Model model;
@@ -254,21 +397,63 @@ SceneBump::setup_model_height()
 
     model.convert_to_mesh(mesh_, attribs);
 
+    /* Each triangle of the model is a patch */
+    mesh_.primitive(GL_PATCHES);
+
+    GLint max_level = 64;
+    glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &max_level);
+    tessellationLevel_ = Util::fromString<float>(options_["tessellation-level"].value);
+    tessellationLevel_ = std::min(std::max(tessellationLevel_, 1.0f),
+                                  static_cast<float>(max_level));
+
+    bool use_geometry_shader = options_["geometry-shader"].value == "true";
+    const std::string version(Scene::tessellation_shader_version());
+
     /* Load shaders */
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
+    ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource tcs_source(ShaderSource::ShaderTypeTessControl);
+    ShaderSource tes_source(ShaderSource::ShaderTypeTessEvaluation);
+    ShaderSource geo_source(ShaderSource::ShaderTypeGeometry);
+    ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+    vtx_source.append(version);
+    vtx_source.append_file(vtx_shader_filename);
+    tcs_source.append(version);
+    tcs_source.append_file(tcs_shader_filename);
+    tes_source.append(version);
+    if (use_geometry_shader)
+        tes_source.append("#define GEOMETRY_SHADER\n");
+    tes_source.append_file(tes_shader_filename);
+    geo_source.append(version);
+    geo_source.append_file(geo_shader_filename);
+    /* The fragment shader of bump-render=height shades the displaced model */
+    frg_source.append(version);
+    frg_source.append(Scene::glsl100_fragment_defines());
+    frg_source.append_file(frg_shader_filename);
 
     /* Add constants to shaders */
+    tes_source.add_const("DisplacementScale", 0.05f);
     frg_source.add_const("LightSourcePosition", lightPosition);
     frg_source.add_const("LightSourceHalfVector", halfVector);
     frg_source.add_const("TextureStepX", 1.0 / 1024.0);
     frg_source.add_const("TextureStepY", 1.0 / 1024.0);
 
-    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
-                                          frg_source.str()))
-    {
-        return false;
+    std::vector<Scene::ShaderStage> stages;
+    stages.push_back(Scene::ShaderStage(GL_VERTEX_SHADER, vtx_source.str(),
+                                        vtx_shader_filename));
+    stages.push_back(Scene::ShaderStage(GL_TESS_CONTROL_SHADER, tcs_source.str(),
+                                        tcs_shader_filename));
+    stages.push_back(Scene::ShaderStage(GL_TESS_EVALUATION_SHADER, tes_source.str(),
+                                        tes_shader_filename));
+    if (use_geometry_shader) {
+        stages.push_back(Scene::ShaderStage(GL_GEOMETRY_SHADER, geo_source.str(),
+                                            geo_shader_filename));
     }
+    stages.push_back(Scene::ShaderStage(GL_FRAGMENT_SHADER, frg_source.str(),
+                                        frg_shader_filename));
+
+    if (!Scene::load_shader_stages_from_strings(program_, stages))
+        return false;
 
     std::vector<GLint> attrib_locations;
     attrib_locations.push_back(program_["position"].location());
@@ -277,8 +462,9 @@ SceneBump::setup_model_height()
     attrib_locations.push_back(program_["tangent"].location());
     mesh_.set_attrib_locations(attrib_locations);
 
-    if (!Texture::load("asteroid-height-map", &texture_,
-                       GL_NEAREST, GL_NEAREST, 0))
+    if (!Texture::load(Texture::format_name("asteroid-height-map", options_["texture-format"].value),
+                       &texture_,
+                       GL_LINEAR, GL_LINEAR, 0))
     {
         return false;
     }
@@ -304,6 +490,10 @@ SceneBump::setup()
         setup_succeeded = setup_model_normals_tangent();
     else if (bump_render == "height")
         setup_succeeded = setup_model_height();
+    else if (bump_render == "parallax")
+        setup_succeeded = setup_model_parallax();
+    else if (bump_render == "displacement")
+        setup_succeeded = setup_model_displacement();
     else if (bump_render == "off" || bump_render == "high-poly")
         setup_succeeded = setup_model_plain(bump_render);
 
@@ -312,12 +502,20 @@ SceneBump::setup()
 
     mesh_.build_vbo();
 
+    if (!prepass_.setup(options_))
+        return false;
+
     program_.start();
 
     // Load texture sampler value
     program_["NormalMap"] = 0;
     program_["HeightMap"] = 0;
 
+    if (bump_render == "displacement") {
+        program_["TessLevel"] = tessellationLevel_;
+        GLExtensions::PatchParameteri(GL_PATCH_VERTICES, 3);
+    }
+
     currentFrame_ = 0;
     rotation_ = 0.0;
     running_ = true;
@@ -332,10 +530,12 @@ SceneBump::teardown()
 {
     mesh_.reset();
 
+    prepass_.teardown();
+
     program_.stop();
     program_.release();
 
-    glDeleteTextures(1, &texture_);
+    Texture::release(1, &texture_);
     texture_ = 0;
 
     Scene::teardown();
@@ -346,7 +546,7 @@ SceneBump::update()
 {
     Scene::update();
 
-    double elapsed_time = lastUpdateTime_ - startTime_;
+    double elapsed_time = animation_time();
 
     rotation_ = rotationSpeed_ * elapsed_time;
 }
@@ -364,6 +564,7 @@ SceneBump::draw()
     model_view_proj *= model_view.getCurrent();
 
     program_["ModelViewProjectionMatrix"] = model_view_proj;
+    program_["ModelViewMatrix"] = model_view.getCurrent();
 
     // Load the NormalMatrix uniform in the shader. The NormalMatrix is the
     // inverse transpose of the model view matrix.
@@ -374,7 +575,9 @@ SceneBump::draw()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture_);
 
+    prepass_.begin(mesh_, model_view_proj, program_);
     mesh_.render_vbo();
+    prepass_.end();
 }
 
 Scene::ValidationResult
@@ -402,6 +605,8 @@ SceneBump::validate()
         ref = Canvas::Pixel(0x99, 0x99, 0x99, 0xff);
     else if (bump_render == "height")
         ref = Canvas::Pixel(0x9d, 0x9d, 0x9d, 0xff);
+    else if (bump_render == "parallax" && options_["parallax-steps"].value == "16")
+        ref = Canvas::Pixel(0x84, 0x84, 0x84, 0xff);
     else
         return Scene::ValidationUnknown;
 
@@ -416,3 +621,21 @@ SceneBump::validate()
         return Scene::ValidationFailure;
     }
 }
+
+std::vector<std::string>
+SceneBump::textures()
+{
+    const std::string &bump_render = options_["bump-render"].value;
+    const std::string &format = options_["texture-format"].value;
+    std::vector<std::string> names;
+
+    if (bump_render == "normals")
+        names.push_back(Texture::format_name("asteroid-normal-map", format));
+    else if (bump_render == "normals-tangent")
+        names.push_back(Texture::format_name("asteroid-normal-map-tangent", format));
+    else if (bump_render == "height" || bump_render == "parallax" ||
+             bump_render == "displacement")
+        names.push_back(Texture::format_name("asteroid-height-map", format));
+
+    return names;
+}
@@ -24,58 +24,133 @@
 #define GLMARK2_SCENE_COLLECTION_H_
 
 #include <vector>
+#include <string>
+#include <functional>
 #include "scene.h"
+#include "benchmark.h"
 
 
 class SceneCollection
 {
 public:
-    SceneCollection(Canvas& canvas) 
+    SceneCollection(Canvas& canvas) :
+        canvas_(canvas), registered_(false)
     {
-        add_scenes(canvas);
+        add_scenes();
     }
     ~SceneCollection() { Util::dispose_pointer_vector(scenes_); }
+
+    //
+    // Registers the scenes, so they can be looked up by name.
+    //
+    // Only the factories are registered: a scene is created the first
+    // time a benchmark looks it up, so a run only creates the scenes it
+    // uses.
+    //
     void register_scenes()
     {
-        for (std::vector<Scene*>::const_iterator iter = scenes_.begin();
-             iter != scenes_.end();
-             iter++)
-        {
-            Benchmark::register_scene(**iter);
+        registered_ = true;
+
+        for (size_t i = 0; i < names_.size(); i++) {
+            if (scenes_[i])
+                Benchmark::register_scene(*scenes_[i]);
+            else
+                Benchmark::register_scene_factory(names_[i],
+                                                  [this, i]() { return &create(i); });
         }
     }
-    const std::vector<Scene*>& get() { return scenes_; }
+
+    //
+    // Gets all the available scenes, creating the ones that haven't been
+    // created yet.
+    //
+    const std::vector<Scene*>& get()
+    {
+        for (size_t i = 0; i < names_.size(); i++)
+            create(i);
+        return scenes_;
+    }
 
 private:
+    Canvas& canvas_;
+    bool registered_;
+    std::vector<std::string> names_;
+    std::vector<std::function<Scene*(Canvas&)> > factories_;
     std::vector<Scene*> scenes_;
 
     //
-    // Creates all the available scenes and adds them to the supplied vector.
-    // 
-    // @param scenes the vector to add the scenes to
-    // @param canvas the canvas to create the scenes with
+    // Adds a scene by name, without creating it.
     //
-    void add_scenes(Canvas& canvas)
+    template <typename T> void add_scene(const std::string &name)
     {
-        scenes_.push_back(new SceneDefaultOptions(canvas));
-        scenes_.push_back(new SceneBuild(canvas));
-        scenes_.push_back(new SceneTexture(canvas));
-        scenes_.push_back(new SceneShading(canvas));
-        scenes_.push_back(new SceneConditionals(canvas));
-        scenes_.push_back(new SceneFunction(canvas));
-        scenes_.push_back(new SceneLoop(canvas));
-        scenes_.push_back(new SceneBump(canvas));
-        scenes_.push_back(new SceneEffect2D(canvas));
-        scenes_.push_back(new ScenePulsar(canvas));
-        scenes_.push_back(new SceneDesktop(canvas));
-        scenes_.push_back(new SceneBuffer(canvas));
-        scenes_.push_back(new SceneIdeas(canvas));
-        scenes_.push_back(new SceneTerrain(canvas));
-        scenes_.push_back(new SceneJellyfish(canvas));
-        scenes_.push_back(new SceneShadow(canvas));
-        scenes_.push_back(new SceneRefract(canvas));
-        scenes_.push_back(new SceneClear(canvas));
+        names_.push_back(name);
+        factories_.push_back([](Canvas& canvas) -> Scene* { return new T(canvas); });
+        scenes_.push_back(0);
+    }
 
+    Scene& create(size_t index)
+    {
+        if (!scenes_[index]) {
+            scenes_[index] = factories_[index](canvas_);
+            if (registered_)
+                Benchmark::register_scene(*scenes_[index]);
+        }
+
+        return *scenes_[index];
+    }
+
+    //
+    // Adds all the available scenes.
+    //
+    void add_scenes()
+    {
+        add_scene<SceneDefaultOptions>("");
+        add_scene<SceneBuild>("build");
+        add_scene<SceneTexture>("texture");
+        add_scene<SceneShading>("shading");
+        add_scene<SceneConditionals>("conditionals");
+        add_scene<SceneFunction>("function");
+        add_scene<SceneLoop>("loop");
+        add_scene<SceneShaderCompile>("shader-compile");
+        add_scene<SceneBump>("bump");
+        add_scene<SceneEffect2D>("effect2d");
+        add_scene<ScenePulsar>("pulsar");
+        add_scene<SceneParticles>("particles");
+        add_scene<SceneDesktop>("desktop");
+        add_scene<SceneBuffer>("buffer");
+        add_scene<SceneTransformFeedback>("transform-feedback");
+        add_scene<SceneTextureUpload>("texture-upload");
+        add_scene<SceneDmaBuf>("dma-buf");
+        add_scene<SceneDrawCalls>("drawcalls");
+        add_scene<SceneUniforms>("uniforms");
+        add_scene<SceneMultiDraw>("multidraw");
+        add_scene<SceneTextureBinding>("texture-binding");
+        add_scene<SceneMultiContext>("multi-context");
+        add_scene<SceneSync>("sync");
+        add_scene<SceneLatency>("latency");
+        add_scene<ScenePreemption>("preemption");
+        add_scene<SceneComposite>("composite");
+        add_scene<SceneAsyncUpload>("async-upload");
+        add_scene<SceneComputeParticles>("compute-particles");
+        add_scene<SceneComputeReduction>("compute-reduction");
+        add_scene<SceneFillrate>("fillrate");
+        add_scene<SceneTriangleSize>("triangle-size");
+        add_scene<SceneBlit>("blit");
+        add_scene<ScenePaths>("paths");
+        add_scene<SceneSprites>("sprites");
+        add_scene<SceneOIT>("oit");
+        add_scene<SceneMultiview>("multiview");
+        add_scene<SceneVirtualTexture>("virtual-texture");
+        add_scene<SceneTextureCache>("texture-cache");
+        add_scene<SceneWorkingSet>("working-set");
+        add_scene<SceneALU>("alu");
+        add_scene<SceneDeferred>("deferred");
+        add_scene<SceneIdeas>("ideas");
+        add_scene<SceneTerrain>("terrain");
+        add_scene<SceneJellyfish>("jellyfish");
+        add_scene<SceneShadow>("shadow");
+        add_scene<SceneRefract>("refract");
+        add_scene<SceneClear>("clear");
     }
 };
 #endif // GLMARK2_SCENE_COLLECTION_H_
@@ -0,0 +1,361 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "canvas.h"
+#include "frame-stats.h"
+#include "log.h"
+#include "options.h"
+#include "text-renderer.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cctype>
+#include <sstream>
+
+/*
+ * The GL state the scenes set up once in setup() and rely on in draw(),
+ * which is applied again before each layer is drawn.
+ */
+struct CompositeStateBlock {
+    GLboolean depth_test;
+    GLboolean depth_mask;
+    GLboolean blend;
+    GLboolean cull_face;
+    GLint blend_func[4];
+    GLint depth_func;
+    GLfloat clear_color[4];
+
+    void capture()
+    {
+        depth_test = glIsEnabled(GL_DEPTH_TEST);
+        blend = glIsEnabled(GL_BLEND);
+        cull_face = glIsEnabled(GL_CULL_FACE);
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &blend_func[0]);
+        glGetIntegerv(GL_BLEND_DST_RGB, &blend_func[1]);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend_func[2]);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &blend_func[3]);
+        glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+        glGetFloatv(GL_COLOR_CLEAR_VALUE, clear_color);
+    }
+
+    void apply() const
+    {
+        enable(GL_DEPTH_TEST, depth_test);
+        enable(GL_BLEND, blend);
+        enable(GL_CULL_FACE, cull_face);
+        glDepthMask(depth_mask);
+        glBlendFuncSeparate(blend_func[0], blend_func[1], blend_func[2], blend_func[3]);
+        glDepthFunc(depth_func);
+        glClearColor(clear_color[0], clear_color[1], clear_color[2], clear_color[3]);
+    }
+
+    static void enable(GLenum cap, GLboolean on)
+    {
+        if (on)
+            glEnable(cap);
+        else
+            glDisable(cap);
+    }
+};
+
+/*
+ * A workload drawn over the previous ones in each frame: another scene, or
+ * a text overlay.
+ */
+struct CompositeLayer {
+    CompositeLayer() : scene(0), loaded(false), set_up(false) {}
+
+    std::string name;
+    Scene *scene;
+    bool loaded;
+    bool set_up;
+    CompositeStateBlock state;
+    /* The CPU time of the layer in each measured frame */
+    FrameStats time;
+};
+
+struct SceneCompositePrivate {
+    SceneCompositePrivate() : text(0), text_frame(0), text_id(0) {}
+
+    std::vector<CompositeLayer> layers;
+    /* The text overlay, if one of the layers */
+    TextRenderer *text;
+    unsigned int text_frame;
+    unsigned int text_id;
+
+    static Scene *create_scene(Canvas &canvas, const std::string &name);
+
+    void release()
+    {
+        for (std::vector<CompositeLayer>::reverse_iterator iter = layers.rbegin();
+             iter != layers.rend();
+             iter++)
+        {
+            if (iter->set_up) {
+                iter->state.apply();
+                iter->scene->teardown();
+            }
+            if (iter->loaded)
+                iter->scene->unload();
+            delete iter->scene;
+        }
+        layers.clear();
+
+        delete text;
+        text = 0;
+    }
+};
+
+/*
+ * The scenes that can be layers. Their state is kept between frames by the
+ * scenes themselves, so any scene could be, but only those that draw to the
+ * canvas in a single pass are known to compose well.
+ */
+Scene *
+SceneCompositePrivate::create_scene(Canvas &canvas, const std::string &name)
+{
+    if (name == "desktop")
+        return new SceneDesktop(canvas);
+    else if (name == "jellyfish")
+        return new SceneJellyfish(canvas);
+    else if (name == "shading")
+        return new SceneShading(canvas);
+    else if (name == "build")
+        return new SceneBuild(canvas);
+    else if (name == "texture")
+        return new SceneTexture(canvas);
+    else if (name == "bump")
+        return new SceneBump(canvas);
+    else if (name == "effect2d")
+        return new SceneEffect2D(canvas);
+
+    return 0;
+}
+
+SceneComposite::SceneComposite(Canvas &pCanvas) :
+    Scene(pCanvas, "composite")
+{
+    priv_ = new SceneCompositePrivate();
+    options_["workloads"] = Scene::Option("workloads", "desktop,jellyfish,text",
+                                          "The workloads drawn over each other in each frame, from the"
+                                          " bottom one: a comma separated list of desktop, jellyfish,"
+                                          " shading, build, texture, bump, effect2d and text");
+}
+
+SceneComposite::~SceneComposite()
+{
+    delete priv_;
+}
+
+bool
+SceneComposite::supported(bool show_errors)
+{
+    static_cast<void>(show_errors);
+    return true;
+}
+
+bool
+SceneComposite::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneComposite::unload()
+{
+}
+
+bool
+SceneComposite::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    SceneCompositePrivate &p(*priv_);
+
+    std::vector<std::string> names;
+    Util::split(options_["workloads"].value, ',', names, Util::SplitModeNormal);
+
+    if (names.empty()) {
+        Log::error("The composite scene needs at least one workload\n");
+        return false;
+    }
+
+    p.layers.resize(names.size());
+
+    for (size_t i = 0; i < names.size(); i++) {
+        CompositeLayer &layer(p.layers[i]);
+        layer.name = names[i];
+
+        if (layer.name == "text") {
+            if (!p.text) {
+                p.text = new TextRenderer(canvas_);
+                p.text_id = p.text->add();
+                p.text->position(p.text_id, LibMatrix::vec2(-0.95f, 0.85f));
+                p.text->size(p.text_id, 0.04f);
+                p.text_frame = 0;
+            }
+            layer.state.capture();
+            continue;
+        }
+
+        layer.scene = SceneCompositePrivate::create_scene(canvas_, layer.name);
+        if (!layer.scene) {
+            Log::error("Unknown composite workload '%s'\n", layer.name.c_str());
+            return false;
+        }
+
+        /* The layers run as long as the composite, without their own warm-up */
+        layer.scene->set_option("duration", "1000000");
+        layer.scene->set_option("warmup-duration", "0");
+        layer.scene->set_option("warmup-frames", "0");
+        /* Only the bottom layer draws a background */
+        if (i > 0)
+            layer.scene->set_option("background", "false");
+
+        layer.loaded = layer.scene->load();
+        if (!layer.loaded || !layer.scene->setup()) {
+            Log::error("Failed to set up the composite workload '%s'\n",
+                       layer.name.c_str());
+            return false;
+        }
+        layer.set_up = true;
+
+        /* Keep the state the scene set up, before the next one changes it */
+        layer.state.capture();
+    }
+
+    /*
+     * The shader precisions are global, and the setups of the layers set
+     * them to their own; this also restarts the clock after their loading.
+     */
+    if (!Scene::setup())
+        return false;
+
+    running_ = true;
+
+    return true;
+}
+
+void
+SceneComposite::teardown()
+{
+    priv_->release();
+
+    /* Leave the default state for the next scenes */
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LEQUAL);
+    glDisable(GL_BLEND);
+    glDisable(GL_CULL_FACE);
+    glBlendFunc(GL_ONE, GL_ZERO);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+
+    Scene::teardown();
+}
+
+void
+SceneComposite::update()
+{
+    Scene::update();
+
+    SceneCompositePrivate &p(*priv_);
+
+    for (std::vector<CompositeLayer>::iterator iter = p.layers.begin();
+         iter != p.layers.end();
+         iter++)
+    {
+        if (iter->scene)
+            iter->scene->update();
+    }
+
+    if (p.text) {
+        std::stringstream ss;
+        ss << "composite frame " << p.text_frame++;
+        p.text->text(p.text_id, ss.str());
+    }
+}
+
+/*
+ * Draws the layers from the bottom one, each with its own GL state and a
+ * cleared depth buffer, as an application mixing workloads would.
+ */
+void
+SceneComposite::draw()
+{
+    SceneCompositePrivate &p(*priv_);
+
+    for (size_t i = 0; i < p.layers.size(); i++) {
+        CompositeLayer &layer(p.layers[i]);
+        uint64_t start = Util::get_timestamp_us();
+
+        if (i > 0) {
+            glDepthMask(GL_TRUE);
+            glClear(GL_DEPTH_BUFFER_BIT);
+        }
+
+        layer.state.apply();
+
+        if (layer.scene)
+            layer.scene->draw();
+        else if (p.text)
+            p.text->render();
+
+        if (!warming_up())
+            layer.time.add(Util::get_timestamp_us() - start);
+    }
+}
+
+Scene::ValidationResult
+SceneComposite::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneComposite::measurements()
+{
+    std::vector<Measurement> result;
+
+    for (std::vector<CompositeLayer>::const_iterator iter = priv_->layers.begin();
+         iter != priv_->layers.end();
+         iter++)
+    {
+        /* e.g. "DesktopTime" and "desktop_time" */
+        std::string name(iter->name);
+        name[0] = std::toupper(name[0]);
+        result.push_back(Measurement(name + "Time", iter->name + "_time", iter->time));
+    }
+
+    return result;
+}
+
+void
+SceneComposite::reset_measurements()
+{
+    for (std::vector<CompositeLayer>::iterator iter = priv_->layers.begin();
+         iter != priv_->layers.end();
+         iter++)
+    {
+        iter->time.reset();
+    }
+}
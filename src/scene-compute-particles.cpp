@@ -0,0 +1,294 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+#include <sstream>
+
+struct SceneComputeParticlesPrivate {
+    SceneComputeParticlesPrivate() :
+        particles(0), workgroup_size(0), buffer(0) {}
+
+    unsigned int particles;
+    unsigned int workgroup_size;
+
+    Program update_program;
+    Program render_program;
+    /* The particles, read and written by the compute shader and drawn as points */
+    GLuint buffer;
+};
+
+/* The particle layout in the buffer, matching the std430 struct in the shader */
+struct ComputeParticle {
+    float position[4];
+    float velocity[4];
+};
+
+SceneComputeParticles::SceneComputeParticles(Canvas &pCanvas) :
+    Scene(pCanvas, "compute-particles")
+{
+    priv_ = new SceneComputeParticlesPrivate();
+    options_["particles"] = Scene::Option("particles", "65536",
+                                          "The number of particles");
+    options_["workgroup-size"] = Scene::Option("workgroup-size", "64",
+                                               "The number of particles updated by each compute work group");
+}
+
+SceneComputeParticles::~SceneComputeParticles()
+{
+    delete priv_;
+}
+
+bool
+SceneComputeParticles::supported(bool show_errors)
+{
+    if (GLExtensions::DispatchCompute == 0) {
+        if (show_errors) {
+            Log::error("SceneComputeParticles requires compute shader support"
+                       " (GL 4.3 or GLES 3.1)!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneComputeParticles::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneComputeParticles::unload()
+{
+}
+
+bool
+SceneComputeParticles::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string cmp_shader_filename(Options::data_path + "/shaders/compute-particles.comp");
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/compute-particles.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/compute-particles.frag");
+
+    SceneComputeParticlesPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.particles = Util::fromString<unsigned int>(options_["particles"].value);
+    p.workgroup_size = Util::fromString<unsigned int>(options_["workgroup-size"].value);
+
+    GLint max_invocations = 0;
+    glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &max_invocations);
+
+    if (p.particles == 0) {
+        Log::error("The number of particles must be at least 1\n");
+        return false;
+    }
+
+    if (p.workgroup_size == 0 ||
+        p.workgroup_size > static_cast<unsigned int>(max_invocations))
+    {
+        Log::error("Invalid workgroup-size %u (maximum %d)\n",
+                   p.workgroup_size, max_invocations);
+        return false;
+    }
+
+    /* Load the programs */
+    std::stringstream ss;
+    ss << p.workgroup_size;
+
+    ShaderSource cmp_source;
+    cmp_source.append(Scene::compute_shader_version());
+    cmp_source.append_file(cmp_shader_filename);
+    cmp_source.replace("WORKGROUP_SIZE", ss.str());
+
+    if (!Scene::load_compute_shader_from_string(p.update_program, cmp_source.str(),
+                                                cmp_shader_filename))
+    {
+        return false;
+    }
+
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.render_program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    /*
+     * Create the particles, spread in a sphere and orbiting its center.
+     * A fixed seed keeps the rendered content the same for every run.
+     */
+    std::vector<ComputeParticle> particles(p.particles);
+    unsigned int seed = 1;
+
+    for (unsigned int i = 0; i < p.particles; i++) {
+        float r[3];
+        for (unsigned int c = 0; c < 3; c++) {
+            seed = seed * 1103515245 + 12345;
+            r[c] = ((seed >> 8) & 0xffff) / 65535.0f;
+        }
+
+        float theta = 2.0f * M_PI * r[0];
+        float z = 2.0f * r[1] - 1.0f;
+        float radius = 0.2f + 0.6f * r[2];
+        float xy = std::sqrt(1.0f - z * z);
+
+        ComputeParticle &particle(particles[i]);
+        particle.position[0] = radius * xy * std::cos(theta);
+        particle.position[1] = radius * xy * std::sin(theta);
+        particle.position[2] = radius * z;
+        particle.position[3] = 1.0f;
+        particle.velocity[0] = -0.5f * std::sin(theta);
+        particle.velocity[1] = 0.5f * std::cos(theta);
+        particle.velocity[2] = 0.0f;
+        particle.velocity[3] = 0.0f;
+    }
+
+    glGenBuffers(1, &p.buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, p.buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, particles.size() * sizeof(ComputeParticle),
+                 &particles[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    p.update_program.start();
+    p.update_program["Count"] = static_cast<int>(p.particles);
+    p.update_program.stop();
+
+    /* Draw the particles as blended points */
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+#if !GLMARK2_USE_GLESv2
+    glEnable(GL_PROGRAM_POINT_SIZE);
+#endif
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneComputeParticles::teardown()
+{
+    SceneComputeParticlesPrivate &p(*priv_);
+
+#if !GLMARK2_USE_GLESv2
+    glDisable(GL_PROGRAM_POINT_SIZE);
+#endif
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    glDeleteBuffers(1, &p.buffer);
+    p.buffer = 0;
+
+    p.update_program.release();
+    p.render_program.stop();
+    p.render_program.release();
+
+    Scene::teardown();
+}
+
+void
+SceneComputeParticles::update()
+{
+    Scene::update();
+}
+
+void
+SceneComputeParticles::draw()
+{
+    SceneComputeParticlesPrivate &p(*priv_);
+
+    /*
+     * Use a fixed time step, so that the simulation only depends on the
+     * number of frames and not on the speed of the implementation.
+     */
+    static const float dt = 1.0f / 60.0f;
+    float t = currentFrame_ * dt;
+
+    /* Update the particles */
+    p.update_program.start();
+    p.update_program["DeltaTime"] = dt;
+    p.update_program["Attractor"] = LibMatrix::vec3(0.5f * std::cos(t),
+                                                    0.5f * std::sin(1.3f * t),
+                                                    0.0f);
+
+    GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, p.buffer);
+    GLExtensions::DispatchCompute((p.particles + p.workgroup_size - 1) / p.workgroup_size, 1, 1);
+    GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+
+    /* Make the written particles visible to the vertex fetch */
+    GLExtensions::MemoryBarrierGL(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+
+    /* Draw them, using the same buffer as the vertex source */
+    GLint position_location = p.render_program["position"].location();
+    GLint velocity_location = p.render_program["velocity"].location();
+
+    p.render_program.start();
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 4, GL_FLOAT, GL_FALSE,
+                          sizeof(ComputeParticle), 0);
+    if (velocity_location >= 0) {
+        glEnableVertexAttribArray(velocity_location);
+        glVertexAttribPointer(velocity_location, 4, GL_FLOAT, GL_FALSE,
+                              sizeof(ComputeParticle),
+                              reinterpret_cast<const void *>(4 * sizeof(float)));
+    }
+
+    glDrawArrays(GL_POINTS, 0, p.particles);
+
+    if (velocity_location >= 0)
+        glDisableVertexAttribArray(velocity_location);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneComputeParticles::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneComputeParticles::rates()
+{
+    double elapsed = elapsed_time();
+    double particles = static_cast<double>(priv_->particles) * frame_count();
+
+    return std::vector<Rate>(1, Rate("ParticlesPerSecond", "particles_per_second",
+                                     elapsed > 0.0 ? particles / elapsed : 0.0));
+}
@@ -0,0 +1,277 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+#include <sstream>
+
+struct SceneComputeReductionPrivate {
+    SceneComputeReductionPrivate() :
+        elements(0), workgroup_size(0), input_buffer(0), final_buffer(0),
+        expected_sum(0.0)
+    {
+        result_buffers[0] = result_buffers[1] = 0;
+    }
+
+    unsigned int elements;
+    unsigned int workgroup_size;
+
+    Program program;
+    /* The values to sum, which are never overwritten */
+    GLuint input_buffer;
+    /* The partial sums, written alternately to the two buffers */
+    GLuint result_buffers[2];
+    /* The buffer that holds the final sum at its start */
+    GLuint final_buffer;
+    double expected_sum;
+
+    /* The number of values left after a pass over count values */
+    unsigned int pass_output(unsigned int count) const
+    {
+        return (count + 2 * workgroup_size - 1) / (2 * workgroup_size);
+    }
+};
+
+SceneComputeReduction::SceneComputeReduction(Canvas &pCanvas) :
+    Scene(pCanvas, "compute-reduction")
+{
+    priv_ = new SceneComputeReductionPrivate();
+    options_["elements"] = Scene::Option("elements", "1048576",
+                                         "The number of values summed every frame");
+    options_["workgroup-size"] = Scene::Option("workgroup-size", "256",
+                                               "The size of the compute work groups (a power of two)");
+}
+
+SceneComputeReduction::~SceneComputeReduction()
+{
+    delete priv_;
+}
+
+bool
+SceneComputeReduction::supported(bool show_errors)
+{
+    if (GLExtensions::DispatchCompute == 0) {
+        if (show_errors) {
+            Log::error("SceneComputeReduction requires compute shader support"
+                       " (GL 4.3 or GLES 3.1)!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneComputeReduction::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneComputeReduction::unload()
+{
+}
+
+bool
+SceneComputeReduction::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string cmp_shader_filename(Options::data_path + "/shaders/compute-reduction.comp");
+
+    SceneComputeReductionPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.elements = Util::fromString<unsigned int>(options_["elements"].value);
+    p.workgroup_size = Util::fromString<unsigned int>(options_["workgroup-size"].value);
+
+    GLint max_invocations = 0;
+    glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &max_invocations);
+
+    if (p.elements == 0) {
+        Log::error("The number of elements must be at least 1\n");
+        return false;
+    }
+
+    if (p.workgroup_size == 0 || (p.workgroup_size & (p.workgroup_size - 1)) != 0 ||
+        p.workgroup_size > static_cast<unsigned int>(max_invocations))
+    {
+        Log::error("Invalid workgroup-size %u (a power of two, maximum %d)\n",
+                   p.workgroup_size, max_invocations);
+        return false;
+    }
+
+    /* Load the program */
+    std::stringstream ss;
+    ss << p.workgroup_size;
+
+    ShaderSource cmp_source;
+    cmp_source.append(Scene::compute_shader_version());
+    cmp_source.append_file(cmp_shader_filename);
+    cmp_source.replace("WORKGROUP_SIZE", ss.str());
+
+    if (!Scene::load_compute_shader_from_string(p.program, cmp_source.str(),
+                                                cmp_shader_filename))
+    {
+        return false;
+    }
+
+    /*
+     * Create the values. They are small multiples of 1/64, so that their
+     * sums are exactly representable (up to a few million elements) and
+     * the result doesn't depend on the order of the additions.
+     */
+    std::vector<float> values(p.elements);
+    p.expected_sum = 0.0;
+    for (unsigned int i = 0; i < p.elements; i++) {
+        values[i] = ((i * 7) % 16) / 64.0f;
+        p.expected_sum += values[i];
+    }
+
+    glGenBuffers(1, &p.input_buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, p.input_buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, values.size() * sizeof(float),
+                 &values[0], GL_STATIC_DRAW);
+
+    glGenBuffers(2, p.result_buffers);
+    for (unsigned int i = 0; i < 2; i++) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, p.result_buffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, p.pass_output(p.elements) * sizeof(float),
+                     0, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    p.final_buffer = 0;
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneComputeReduction::teardown()
+{
+    SceneComputeReductionPrivate &p(*priv_);
+
+    glDeleteBuffers(1, &p.input_buffer);
+    p.input_buffer = 0;
+    glDeleteBuffers(2, p.result_buffers);
+    p.result_buffers[0] = p.result_buffers[1] = 0;
+    p.final_buffer = 0;
+
+    p.program.stop();
+    p.program.release();
+
+    Scene::teardown();
+}
+
+void
+SceneComputeReduction::update()
+{
+    Scene::update();
+}
+
+/*
+ * Sums all the values with a sequence of passes, each of which reduces
+ * 2 * workgroup-size values to one per work group, until a single value
+ * is left.
+ */
+void
+SceneComputeReduction::draw()
+{
+    SceneComputeReductionPrivate &p(*priv_);
+
+    p.program.start();
+
+    unsigned int count = p.elements;
+    GLuint input = p.input_buffer;
+    unsigned int output = 0;
+
+    do {
+        unsigned int groups = p.pass_output(count);
+
+        p.program["Count"] = static_cast<int>(count);
+
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, input);
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, p.result_buffers[output]);
+        GLExtensions::DispatchCompute(groups, 1, 1);
+        GLExtensions::MemoryBarrierGL(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        count = groups;
+        input = p.result_buffers[output];
+        output ^= 1;
+    } while (count > 1);
+
+    p.final_buffer = input;
+
+    GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+    GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+}
+
+Scene::ValidationResult
+SceneComputeReduction::validate()
+{
+    SceneComputeReductionPrivate &p(*priv_);
+
+    if (!GLExtensions::MapBufferRange || !GLExtensions::UnmapBuffer || !p.final_buffer)
+        return Scene::ValidationUnknown;
+
+    GLExtensions::MemoryBarrierGL(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, p.final_buffer);
+    const float *result = static_cast<const float *>(
+        GLExtensions::MapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, sizeof(float),
+                                     GL_MAP_READ_BIT));
+    if (!result) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return Scene::ValidationUnknown;
+    }
+
+    double sum = *result;
+    GLExtensions::UnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    /* Allow for rounding errors in the large sums of many elements */
+    if (std::fabs(sum - p.expected_sum) <= 1e-6 * p.expected_sum)
+        return Scene::ValidationSuccess;
+
+    Log::debug("Validation failed! Expected: %f Actual: %f\n",
+               p.expected_sum, sum);
+    return Scene::ValidationFailure;
+}
+
+std::vector<Scene::Rate>
+SceneComputeReduction::rates()
+{
+    double elapsed = elapsed_time();
+    double elements = static_cast<double>(priv_->elements) * frame_count();
+
+    return std::vector<Rate>(1, Rate("ElementsPerSecond", "elements_per_second",
+                                     elapsed > 0.0 ? elements / elapsed : 0.0));
+}
@@ -36,6 +36,7 @@ static const std::string vtx_file(shader_file_base + ".vert");
 static const std::string frg_file(shader_file_base + ".frag");
 static const std::string step_conditional_file(shader_file_base + "-step-conditional.all");
 static const std::string step_simple_file(shader_file_base + "-step-simple.all");
+static const std::string step_divergent_file(shader_file_base + "-step-divergent.all");
 
 SceneConditionals::SceneConditionals(Canvas &pCanvas) :
     SceneGrid(pCanvas, "conditionals")
@@ -44,6 +45,8 @@ SceneConditionals::SceneConditionals(Canvas &pCanvas) :
             "The number of computational steps in the fragment shader");
     options_["fragment-conditionals"] = Scene::Option("fragment-conditionals", "true",
             "Whether each computational step includes an if-else clause", "false,true");
+    options_["fragment-divergence-tile"] = Scene::Option("fragment-divergence-tile", "0",
+            "The size in pixels of the squares of a checkerboard that alternates the branches of the fragment conditionals (0: branch on the computed value)");
     options_["vertex-steps"] = Scene::Option("vertex-steps", "1",
             "The number of computational steps in the vertex shader");
     options_["vertex-conditionals"] = Scene::Option("vertex-conditionals", "true",
@@ -57,6 +60,12 @@ SceneConditionals::~SceneConditionals()
 static std::string
 get_vertex_shader_source(int steps, bool conditionals)
 {
+    /* Large step counts are expensive to generate, so only do it once */
+    const std::string key(vtx_file + ":" + Util::toString(steps) + (conditionals ? ":conditionals" : ""));
+    std::string str;
+    if (ShaderSource::find_generated(key, str))
+        return str;
+
     ShaderSource source(Options::data_path + vtx_file);
     ShaderSource source_main;
 
@@ -69,17 +78,39 @@ get_vertex_shader_source(int steps, bool conditionals)
 
     source.replace("$MAIN$", source_main.str());
 
-    return source.str();
+    str = source.str();
+    ShaderSource::store_generated(key, str);
+
+    return str;
 }
 
 static std::string
-get_fragment_shader_source(int steps, bool conditionals)
+get_fragment_shader_source(int steps, bool conditionals, unsigned int divergence_tile)
 {
+    /* Large step counts are expensive to generate, so only do it once */
+    const std::string key(frg_file + ":" + Util::toString(steps) + (conditionals ? ":conditionals" : "") +
+                          ":" + Util::toString(divergence_tile));
+    std::string str;
+    if (ShaderSource::find_generated(key, str))
+        return str;
+
     ShaderSource source(Options::data_path + frg_file);
     ShaderSource source_main;
 
+    /*
+     * Neighbouring fragments take different branches at the edges of the
+     * checkerboard squares, so smaller squares diverge more often.
+     */
+    if (conditionals && divergence_tile > 0) {
+        source_main.append("    HIGHP_OR_DEFAULT vec2 tile = floor(FragCoord / " +
+                           Util::toString(divergence_tile) + ".0);\n"
+                           "    bool branch = mod(tile.x + tile.y, 2.0) >= 1.0;\n");
+    }
+
     for (int i = 0; i < steps; i++) {
-        if (conditionals)
+        if (conditionals && divergence_tile > 0)
+            source_main.append_file(Options::data_path + step_divergent_file);
+        else if (conditionals)
             source_main.append_file(Options::data_path + step_conditional_file);
         else
             source_main.append_file(Options::data_path + step_simple_file);
@@ -87,7 +118,10 @@ get_fragment_shader_source(int steps, bool conditionals)
 
     source.replace("$MAIN$", source_main.str());
 
-    return source.str();
+    str = source.str();
+    ShaderSource::store_generated(key, str);
+
+    return str;
 }
 
 bool
@@ -101,9 +135,12 @@ SceneConditionals::setup()
     bool frg_conditionals = options_["fragment-conditionals"].value == "true";
     int vtx_steps(Util::fromString<int>(options_["vertex-steps"].value));
     int frg_steps(Util::fromString<int>(options_["fragment-steps"].value));
+    unsigned int divergence_tile(Util::fromString<unsigned int>(options_["fragment-divergence-tile"].value));
     /* Load shaders */
-    std::string vtx_shader(get_vertex_shader_source(vtx_steps, vtx_conditionals));
-    std::string frg_shader(get_fragment_shader_source(frg_steps, frg_conditionals));
+    std::string vtx_shader(prepare_vertex_shader(
+        get_vertex_shader_source(vtx_steps, vtx_conditionals)));
+    std::string frg_shader(get_fragment_shader_source(frg_steps, frg_conditionals,
+                                                      divergence_tile));
 
     if (!Scene::load_shaders_from_strings(program_, vtx_shader, frg_shader))
         return false;
@@ -129,7 +166,7 @@ SceneConditionals::validate()
     bool frg_conditionals = options_["fragment-conditionals"].value == "true";
     int frg_steps(Util::fromString<int>(options_["fragment-steps"].value));
 
-    if (!frg_conditionals)
+    if (!frg_conditionals || options_["fragment-divergence-tile"].value != "0")
         return Scene::ValidationUnknown;
 
     Canvas::Pixel ref;
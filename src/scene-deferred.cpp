@@ -0,0 +1,687 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "mat.h"
+#include "options.h"
+#include "stack.h"
+#include "shader-source.h"
+#include "model.h"
+#include "util.h"
+#include "gl-headers.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using LibMatrix::mat4;
+using LibMatrix::vec3;
+using LibMatrix::vec4;
+
+namespace
+{
+
+/* The number of lights a draw of the light pass can shade */
+const unsigned int lights_per_draw = 8;
+
+/* The side of the floor, with the models in a grid on it */
+const float floor_size = 12.0f;
+const unsigned int model_grid = 3;
+
+}
+
+struct SceneDeferredPrivate {
+    enum LightMethod {
+        LightMethodVolumes,
+        LightMethodTiled
+    };
+
+    /* A light's rectangle on the screen, in pixels */
+    struct LightRect {
+        int x0;
+        int y0;
+        int x1;
+        int y1;
+    };
+
+    SceneDeferredPrivate() :
+        light_method(LightMethodVolumes), nlights(0), tile_size(0),
+        light_radius(0.0f), width(0), height(0), rotation(0.0f),
+        light_program(0), quad_buffer(0), fbo(0), albedo_tex(0), normal_tex(0), depth_tex(0),
+        model_scale(1.0f), light_draws(0) {}
+
+    LightMethod light_method;
+    unsigned int nlights;
+    unsigned int tile_size;
+    float light_radius;
+    int width;
+    int height;
+    float rotation;
+
+    Program gbuffer_program;
+    /*
+     * The programs of the light pass, by the number of lights they shade,
+     * since a loop bound by a uniform is slow on some GPUs. The program
+     * without lights applies the ambient light.
+     */
+    Program light_programs[lights_per_draw + 1];
+    Program *light_program;
+    Mesh model_mesh;
+    Mesh floor_mesh;
+    GLuint quad_buffer;
+
+    /* The G-buffer: albedo and eye space normal targets, and the depth */
+    GLuint fbo;
+    GLuint albedo_tex;
+    GLuint normal_tex;
+    GLuint depth_tex;
+
+    /* The transformation that fits the model in a cell of the grid */
+    vec3 model_center;
+    float model_scale;
+
+    mat4 projection;
+    mat4 view;
+    std::vector<vec4> light_positions;
+    std::vector<vec4> light_colors;
+
+    /* The light pass draws of the current run */
+    uint64_t light_draws;
+
+    void release()
+    {
+        if (fbo) {
+            GLExtensions::DeleteFramebuffers(1, &fbo);
+            fbo = 0;
+        }
+
+        GLuint textures[] = { albedo_tex, normal_tex, depth_tex };
+        for (unsigned int i = 0; i < sizeof(textures) / sizeof(*textures); i++) {
+            if (textures[i])
+                glDeleteTextures(1, &textures[i]);
+        }
+        albedo_tex = 0;
+        normal_tex = 0;
+        depth_tex = 0;
+
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        model_mesh.reset();
+        floor_mesh.reset();
+
+        gbuffer_program.stop();
+        gbuffer_program.release();
+        for (unsigned int i = 0; i <= lights_per_draw; i++) {
+            light_programs[i].stop();
+            light_programs[i].release();
+        }
+        light_program = 0;
+    }
+
+    /* Creates a texture of the G-buffer, of the size of the canvas */
+    GLuint create_texture(GLint internal_format, GLenum format, GLenum type)
+    {
+        GLuint tex;
+
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0,
+                     format, type, 0);
+
+        return tex;
+    }
+
+    /*
+     * Gets the rectangle of the screen that a light can reach, from the
+     * bounding box of its sphere. Returns false if the light is off the
+     * screen.
+     */
+    bool light_rect(const vec4 &light, LightRect &rect) const
+    {
+        static const float near_plane = 1.0f;
+        float x0 = 1.0f;
+        float y0 = 1.0f;
+        float x1 = -1.0f;
+        float y1 = -1.0f;
+
+        /* A light across the near plane may cover the whole screen */
+        if (light.z() + light.w() > -near_plane) {
+            x0 = -1.0f;
+            y0 = -1.0f;
+            x1 = 1.0f;
+            y1 = 1.0f;
+        }
+        else {
+            for (unsigned int corner = 0; corner < 8; corner++) {
+                vec4 p(light.x() + (corner & 1 ? light.w() : -light.w()),
+                       light.y() + (corner & 2 ? light.w() : -light.w()),
+                       light.z() + (corner & 4 ? light.w() : -light.w()),
+                       1.0f);
+                vec4 clip(projection * p);
+                float x = clip.x() / clip.w();
+                float y = clip.y() / clip.w();
+                x0 = std::min(x0, x);
+                y0 = std::min(y0, y);
+                x1 = std::max(x1, x);
+                y1 = std::max(y1, y);
+            }
+        }
+
+        rect.x0 = std::max(0, static_cast<int>(std::floor((x0 * 0.5f + 0.5f) * width)));
+        rect.y0 = std::max(0, static_cast<int>(std::floor((y0 * 0.5f + 0.5f) * height)));
+        rect.x1 = std::min(width, static_cast<int>(std::ceil((x1 * 0.5f + 0.5f) * width)));
+        rect.y1 = std::min(height, static_cast<int>(std::ceil((y1 * 0.5f + 0.5f) * height)));
+
+        return rect.x0 < rect.x1 && rect.y0 < rect.y1;
+    }
+
+    /* Shades a rectangle of the screen, in pixels, with some of the lights */
+    void shade_rect(int x0, int y0, int x1, int y1,
+                    const vec4 *positions, const vec4 *colors, unsigned int count)
+    {
+        Program &program(light_programs[count]);
+
+        if (light_program != &program) {
+            if (light_program)
+                glDisableVertexAttribArray((*light_program)["position"].location());
+
+            program.start();
+            GLint position_location = program["position"].location();
+            glEnableVertexAttribArray(position_location);
+            glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+            light_program = &program;
+        }
+
+        glUniform4f(program["Rect"].location(),
+                    2.0f * x0 / width - 1.0f, 2.0f * y0 / height - 1.0f,
+                    2.0f * x1 / width - 1.0f, 2.0f * y1 / height - 1.0f);
+        if (count > 0) {
+            glUniform4fv(program["LightPosition"].location(), count,
+                         static_cast<const float *>(positions[0]));
+            glUniform4fv(program["LightColor"].location(), count,
+                         static_cast<const float *>(colors[0]));
+        }
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        light_draws++;
+    }
+};
+
+SceneDeferred::SceneDeferred(Canvas &pCanvas) :
+    Scene(pCanvas, "deferred")
+{
+    priv_ = new SceneDeferredPrivate();
+
+    const ModelMap& modelMap = Model::find_models();
+    std::string optionValues;
+    for (ModelMap::const_iterator modelIt = modelMap.begin();
+         modelIt != modelMap.end();
+         modelIt++)
+    {
+        if (!optionValues.empty())
+            optionValues += ",";
+        optionValues += modelIt->first;
+    }
+
+    options_["model"] = Scene::Option("model", "horse", "Which model to use",
+                                      optionValues);
+    options_["lights"] = Scene::Option("lights", "64",
+                                       "The number of point lights");
+    options_["light-method"] = Scene::Option("light-method", "volumes",
+                                             "How the lights are applied (volumes: a draw covering each light, tiled: draws of screen tiles with the lights that reach them)",
+                                             "volumes,tiled");
+    options_["tile-size"] = Scene::Option("tile-size", "32",
+                                          "The size of the screen tiles in pixels (with light-method=tiled)");
+    options_["light-radius"] = Scene::Option("light-radius", "2.5",
+                                             "The distance that each light reaches");
+}
+
+SceneDeferred::~SceneDeferred()
+{
+    delete priv_;
+}
+
+bool
+SceneDeferred::supported(bool show_errors)
+{
+    static const std::string oes_depth_texture("GL_OES_depth_texture");
+    static const std::string arb_depth_texture("GL_ARB_depth_texture");
+
+    if (!GLExtensions::support(oes_depth_texture) &&
+        !GLExtensions::support(arb_depth_texture)) {
+        if (show_errors)
+            Log::error("SceneDeferred requires depth texture support\n");
+        return false;
+    }
+
+    if (!GLExtensions::GenFramebuffers) {
+        if (show_errors)
+            Log::error("SceneDeferred requires GL framebuffer support\n");
+        return false;
+    }
+
+    /* The GLSL ES 1.00 shaders write the targets with GL_EXT_draw_buffers */
+#if GLMARK2_USE_GLESv2
+    bool draw_buffers = GLExtensions::support("GL_EXT_draw_buffers");
+#else
+    bool draw_buffers = true;
+#endif
+    GLint max_draw_buffers = 0;
+    if (draw_buffers && GLExtensions::DrawBuffers)
+        glGetIntegerv(GL_MAX_DRAW_BUFFERS, &max_draw_buffers);
+
+    if (max_draw_buffers < 2) {
+        if (show_errors)
+            Log::error("SceneDeferred requires multiple render targets (GL_EXT_draw_buffers)\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneDeferred::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneDeferred::unload()
+{
+}
+
+bool
+SceneDeferred::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_gbuffer_filename(Options::data_path + "/shaders/light-phong.vert");
+    static const std::string frg_gbuffer_filename(Options::data_path + "/shaders/deferred-gbuffer.frag");
+    static const std::string vtx_light_filename(Options::data_path + "/shaders/deferred-light.vert");
+    static const std::string frg_light_filename(Options::data_path + "/shaders/deferred-light.frag");
+
+    SceneDeferredPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.nlights = Util::fromString<unsigned int>(options_["lights"].value);
+    p.tile_size = Util::fromString<unsigned int>(options_["tile-size"].value);
+    p.light_radius = Util::fromString<float>(options_["light-radius"].value);
+    p.light_method = options_["light-method"].value == "tiled" ?
+                     SceneDeferredPrivate::LightMethodTiled :
+                     SceneDeferredPrivate::LightMethodVolumes;
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+    p.rotation = 0.0f;
+    p.light_draws = 0;
+
+    if (p.tile_size == 0 || p.light_radius <= 0.0f) {
+        Log::error("The tile-size and the light-radius must be positive\n");
+        return false;
+    }
+
+    /* Load the programs */
+    ShaderSource vtx_gbuffer_source(vtx_gbuffer_filename);
+    ShaderSource frg_gbuffer_source(ShaderSource::ShaderTypeFragment);
+#if GLMARK2_USE_GLESv2
+    frg_gbuffer_source.append("#extension GL_EXT_draw_buffers : require\n");
+#endif
+    frg_gbuffer_source.append_file(frg_gbuffer_filename);
+
+    if (!Scene::load_shaders_from_strings(p.gbuffer_program, vtx_gbuffer_source.str(),
+                                          frg_gbuffer_source.str()))
+    {
+        return false;
+    }
+
+    /*
+     * The light volumes only need the programs with no light and one light.
+     * Eye space positions are rebuilt from the depth, which needs highp.
+     */
+    unsigned int max_lights = p.light_method == SceneDeferredPrivate::LightMethodTiled ?
+                              lights_per_draw : 1;
+
+    p.projection = LibMatrix::Mat4::perspective(50.0, static_cast<float>(p.width) / p.height,
+                                                1.0, 40.0);
+    mat4 inverse_projection(p.projection);
+    inverse_projection.inverse();
+
+    for (unsigned int count = 0; count <= max_lights; count++) {
+        ShaderSource vtx_light_source(vtx_light_filename);
+        ShaderSource frg_light_source(frg_light_filename);
+        std::stringstream count_ss;
+        std::stringstream size_ss;
+        count_ss << count;
+        size_ss << std::max(count, 1u);
+        frg_light_source.replace("LIGHT_COUNT", count_ss.str());
+        frg_light_source.replace("LIGHT_ARRAY_SIZE", size_ss.str());
+        frg_light_source.precision(ShaderSource::Precision(",high,,"));
+
+        Program &program(p.light_programs[count]);
+        if (!Scene::load_shaders_from_strings(program, vtx_light_source.str(),
+                                              frg_light_source.str()))
+        {
+            return false;
+        }
+
+        program.start();
+        program["AlbedoTexture"] = 0;
+        program["NormalTexture"] = 1;
+        program["DepthTexture"] = 2;
+        program["InverseProjectionMatrix"] = inverse_projection;
+        program["Ambient"] = count == 0 ? 0.1f : 0.0f;
+        program.stop();
+    }
+
+    /* Load the model, and the floor it stands on */
+    Model model;
+    if (!model.load(options_["model"].value))
+        return false;
+
+    if (model.needNormals())
+        model.calculate_normals();
+
+    std::vector<std::pair<Model::AttribType, int> > attribs;
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
+    model.convert_to_mesh(p.model_mesh, attribs, true);
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(p.gbuffer_program["position"].location());
+    attrib_locations.push_back(p.gbuffer_program["normal"].location());
+    p.model_mesh.set_attrib_locations(attrib_locations);
+    p.model_mesh.build_vbo();
+
+    /* The model stands on the floor, scaled to fit in a cell of the grid */
+    vec3 model_min(model.minVec());
+    vec3 model_max(model.maxVec());
+    p.model_center = (model_min + model_max) / 2.0;
+    p.model_center.y(model_min.y());
+    p.model_scale = 0.8f * floor_size / model_grid / (model_max - model_min).length();
+
+    std::vector<int> vertex_format;
+    vertex_format.push_back(3);
+    vertex_format.push_back(3);
+    p.floor_mesh.set_vertex_format(vertex_format);
+
+    static const float floor_corners[6][2] = {
+        {-1.0f, 1.0f}, {1.0f, 1.0f}, {1.0f, -1.0f},
+        {-1.0f, 1.0f}, {1.0f, -1.0f}, {-1.0f, -1.0f}
+    };
+    for (unsigned int i = 0; i < 6; i++) {
+        p.floor_mesh.next_vertex();
+        p.floor_mesh.set_attrib(0, vec3(floor_corners[i][0], 0.0f, floor_corners[i][1]) *
+                                   (floor_size / 2.0f));
+        p.floor_mesh.set_attrib(1, vec3(0.0f, 1.0f, 0.0f));
+    }
+    p.floor_mesh.set_attrib_locations(attrib_locations);
+    p.floor_mesh.build_vbo();
+
+    /* Create the quad of the light pass, drawn as a triangle strip */
+    p.quad_buffer = FullscreenQuad::create();
+
+    /* Create the G-buffer */
+#if GLMARK2_USE_GLESv2
+    GLint depth_format = GLExtensions::version_supported(3, 0) ?
+                         GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT;
+#else
+    GLint depth_format = GL_DEPTH_COMPONENT24;
+#endif
+    p.albedo_tex = p.create_texture(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
+    p.normal_tex = p.create_texture(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
+    p.depth_tex = p.create_texture(depth_format, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLExtensions::GenFramebuffers(1, &p.fbo);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, p.albedo_tex, 0);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
+                                       GL_TEXTURE_2D, p.normal_tex, 0);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                       GL_TEXTURE_2D, p.depth_tex, 0);
+
+    static const GLenum draw_buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    GLExtensions::DrawBuffers(2, draw_buffers);
+
+    GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::error("Failed to create the G-buffer (status 0x%x)\n", status);
+        return false;
+    }
+
+    /* Give each light a color and an orbit of its own */
+    p.light_colors.clear();
+    for (unsigned int i = 0; i < p.nlights; i++) {
+        float hue = static_cast<float>(i) / std::max(p.nlights, 1u);
+        p.light_colors.push_back(vec4(0.5f + 0.5f * std::cos(6.2832f * hue),
+                                      0.5f + 0.5f * std::cos(6.2832f * (hue + 0.33f)),
+                                      0.5f + 0.5f * std::cos(6.2832f * (hue + 0.67f)),
+                                      1.0f));
+    }
+    p.light_positions.assign(p.nlights, vec4());
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneDeferred::teardown()
+{
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    for (unsigned int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneDeferred::update()
+{
+    Scene::update();
+
+    SceneDeferredPrivate &p(*priv_);
+    double elapsed_time = animation_time();
+
+    p.rotation = 10.0 * elapsed_time;
+
+    LibMatrix::Stack4 view;
+    view.loadIdentity();
+    view *= LibMatrix::Mat4::lookAt(0.0, 7.0, 11.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0);
+    view.rotate(p.rotation, 0.0f, 1.0f, 0.0f);
+    p.view = view.getCurrent();
+
+    /* The lights circle the floor at different radii, heights and speeds */
+    for (unsigned int i = 0; i < p.nlights; i++) {
+        float f = static_cast<float>(i) / std::max(p.nlights, 1u);
+        float radius = (0.15f + 0.8f * std::fmod(f * 7.31f, 1.0f)) * floor_size / 2.0f;
+        float angle = 6.2832f * f + (0.2f + 0.3f * std::fmod(f * 3.17f, 1.0f)) * elapsed_time;
+        float height = 0.3f + 1.5f * std::fmod(f * 5.13f, 1.0f);
+        vec4 position(p.view * vec4(radius * std::cos(angle), height,
+                                    radius * std::sin(angle), 1.0f));
+        position.w(p.light_radius);
+        p.light_positions[i] = position;
+    }
+}
+
+/*
+ * Renders the albedo and the normals of the scene to the G-buffer, then
+ * adds the light of each point light to the pixels it reaches, reading
+ * the G-buffer back.
+ */
+void
+SceneDeferred::draw()
+{
+    SceneDeferredPrivate &p(*priv_);
+
+    /* The geometry pass */
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+    glViewport(0, 0, p.width, p.height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+
+    p.gbuffer_program.start();
+
+    /* The floor, then the models on it */
+    for (unsigned int i = 0; i <= model_grid * model_grid; i++) {
+        mat4 model_view(p.view);
+        Mesh *mesh = &p.floor_mesh;
+        vec4 color(0.7f, 0.7f, 0.7f, 1.0f);
+
+        if (i > 0) {
+            unsigned int n = i - 1;
+            float cell = floor_size / model_grid;
+            float hue = static_cast<float>(n) / (model_grid * model_grid);
+            model_view *= LibMatrix::Mat4::translate(
+                (n % model_grid + 0.5f) * cell - floor_size / 2.0f, 0.0f,
+                (n / model_grid + 0.5f) * cell - floor_size / 2.0f);
+            model_view *= LibMatrix::Mat4::scale(p.model_scale, p.model_scale, p.model_scale);
+            model_view *= LibMatrix::Mat4::translate(-p.model_center.x(), -p.model_center.y(),
+                                                     -p.model_center.z());
+            mesh = &p.model_mesh;
+            color = vec4(0.6f + 0.4f * std::cos(6.2832f * hue),
+                         0.6f + 0.4f * std::cos(6.2832f * (hue + 0.33f)),
+                         0.6f + 0.4f * std::cos(6.2832f * (hue + 0.67f)),
+                         1.0f);
+        }
+
+        mat4 model_view_proj(p.projection);
+        model_view_proj *= model_view;
+        mat4 normal_matrix(model_view);
+        normal_matrix.inverse().transpose();
+
+        p.gbuffer_program["ModelViewProjectionMatrix"] = model_view_proj;
+        p.gbuffer_program["ModelViewMatrix"] = model_view;
+        p.gbuffer_program["NormalMatrix"] = normal_matrix;
+        p.gbuffer_program["MaterialDiffuse"] = color;
+        mesh->render_vbo();
+    }
+
+    /* The light pass, on the canvas */
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+    glDisable(GL_DEPTH_TEST);
+
+    GLuint textures[] = { p.albedo_tex, p.normal_tex, p.depth_tex };
+    for (unsigned int i = 0; i < 3; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+
+    /* The ambient light of the whole screen, then the lights added to it */
+    p.shade_rect(0, 0, p.width, p.height, 0, 0, 0);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    std::vector<SceneDeferredPrivate::LightRect> rects(p.nlights);
+    std::vector<unsigned int> visible;
+    for (unsigned int i = 0; i < p.nlights; i++) {
+        if (p.light_rect(p.light_positions[i], rects[i]))
+            visible.push_back(i);
+    }
+
+    if (p.light_method == SceneDeferredPrivate::LightMethodVolumes) {
+        for (unsigned int i : visible) {
+            const SceneDeferredPrivate::LightRect &r(rects[i]);
+            p.shade_rect(r.x0, r.y0, r.x1, r.y1,
+                         &p.light_positions[i], &p.light_colors[i], 1);
+        }
+    }
+    else {
+        /* Each tile is shaded with the lights that reach it, a few at a time */
+        std::vector<vec4> positions;
+        std::vector<vec4> colors;
+
+        for (int y = 0; y < p.height; y += p.tile_size) {
+            for (int x = 0; x < p.width; x += p.tile_size) {
+                int x1 = std::min(p.width, x + static_cast<int>(p.tile_size));
+                int y1 = std::min(p.height, y + static_cast<int>(p.tile_size));
+
+                positions.clear();
+                colors.clear();
+                for (unsigned int i : visible) {
+                    const SceneDeferredPrivate::LightRect &r(rects[i]);
+                    if (r.x0 < x1 && x < r.x1 && r.y0 < y1 && y < r.y1) {
+                        positions.push_back(p.light_positions[i]);
+                        colors.push_back(p.light_colors[i]);
+                    }
+                }
+
+                for (unsigned int first = 0; first < positions.size(); first += lights_per_draw) {
+                    unsigned int count = std::min<unsigned int>(lights_per_draw,
+                                                                positions.size() - first);
+                    p.shade_rect(x, y, x1, y1, &positions[first], &colors[first], count);
+                }
+            }
+        }
+    }
+
+    glDisable(GL_BLEND);
+    glDisableVertexAttribArray((*p.light_program)["position"].location());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    p.light_program = 0;
+}
+
+Scene::ValidationResult
+SceneDeferred::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+void
+SceneDeferred::reset_measurements()
+{
+    priv_->light_draws = 0;
+}
+
+std::vector<Scene::Rate>
+SceneDeferred::rates()
+{
+    double elapsed = elapsed_time();
+
+    return std::vector<Rate>(1, Rate("LightDrawsPerSecond", "light_draws_per_second",
+                                     elapsed > 0.0 ? priv_->light_draws / elapsed : 0.0));
+}
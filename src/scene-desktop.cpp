@@ -23,6 +23,8 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdlib>
+#include <deque>
+#include <iomanip>
 
 #include "scene.h"
 #include "mat.h"
@@ -34,6 +36,7 @@
 #include "shader-source.h"
 #include "util.h"
 #include "texture.h"
+#include "debug-markers.h"
 
 enum BlurDirection {
     BlurDirectionHorizontal,
@@ -41,25 +44,72 @@ enum BlurDirection {
     BlurDirectionBoth
 };
 
-static void
-create_blur_shaders(ShaderSource& vtx_source, ShaderSource& frg_source,
-                    unsigned int radius, float sigma, BlurDirection direction)
+enum BlurMethod {
+    /* One texture tap per kernel texel */
+    BlurMethodFragment,
+    /* Pairs of kernel texels merged into one bilinear tap */
+    BlurMethodLinear,
+    /* Dual filter (downsample/upsample) blur */
+    BlurMethodKawase,
+    /* Compute shaders with one texture fetch per kernel texel */
+    BlurMethodCompute,
+    /* Compute shaders that share the fetched texels through shared memory */
+    BlurMethodComputeShared
+};
+
+static BlurMethod
+blur_method_from_str(const std::string& str)
 {
-    vtx_source.append_file(Options::data_path + "/shaders/desktop.vert");
-    frg_source.append_file(Options::data_path + "/shaders/desktop-blur.frag");
+    if (str == "linear")
+        return BlurMethodLinear;
+    else if (str == "kawase")
+        return BlurMethodKawase;
+    else if (str == "compute")
+        return BlurMethodCompute;
+    else if (str == "compute-shared")
+        return BlurMethodComputeShared;
+
+    return BlurMethodFragment;
+}
+
+/*
+ * Gets the weight of each texel offset of a gaussian kernel, from offset 0
+ * to radius.
+ */
+static std::vector<float>
+blur_kernel(unsigned int radius, float sigma)
+{
+    std::vector<float> kernel;
 
     /* Don't let the gaussian curve become too narrow */
     if (sigma < 1.0)
         sigma = 1.0;
 
-    unsigned int side = 2 * radius + 1;
-
     for (unsigned int i = 0; i < radius + 1; i++) {
         float s2 = 2.0 * sigma * sigma;
         float k = 1.0 / std::sqrt(M_PI * s2) * std::exp( - (static_cast<float>(i) * i) / s2);
+        kernel.push_back(k);
+    }
+
+    return kernel;
+}
+
+/*
+ * Adds the gaussian kernel constants to a blur shader and replaces its
+ * $CONVOLUTION$ placeholder, sampling Texture0 with texture_func.
+ */
+static void
+add_blur_convolution(ShaderSource& source, unsigned int radius, float sigma,
+                     BlurDirection direction,
+                     const std::string& texture_func = "texture2D")
+{
+    std::vector<float> kernel(blur_kernel(radius, sigma));
+    unsigned int side = 2 * radius + 1;
+
+    for (unsigned int i = 0; i < radius + 1; i++) {
         std::stringstream ss_tmp;
         ss_tmp << "Kernel" << i;
-        frg_source.add_const(ss_tmp.str(), k);
+        source.add_const(ss_tmp.str(), kernel[i]);
     }
 
     std::stringstream ss;
@@ -68,7 +118,7 @@ create_blur_shaders(ShaderSource& vtx_source, ShaderSource& frg_source,
     if (direction == BlurDirectionHorizontal) {
         for (unsigned int i = 0; i < side; i++) {
             int offset = static_cast<int>(i - radius);
-            ss << "texture2D(Texture0, TextureCoord + vec2(" <<
+            ss << texture_func << "(Texture0, TextureCoord + vec2(" <<
                   offset << ".0 * TextureStepX, 0.0)) * Kernel" <<
                   std::abs(offset) << " +" << std::endl;
         }
@@ -77,7 +127,7 @@ create_blur_shaders(ShaderSource& vtx_source, ShaderSource& frg_source,
     else if (direction == BlurDirectionVertical) {
         for (unsigned int i = 0; i < side; i++) {
             int offset = static_cast<int>(i - radius);
-            ss << "texture2D(Texture0, TextureCoord + vec2(0.0, " <<
+            ss << texture_func << "(Texture0, TextureCoord + vec2(0.0, " <<
                   offset << ".0 * TextureStepY)) * Kernel" <<
                   std::abs(offset) << " +" << std::endl;
         }
@@ -88,7 +138,7 @@ create_blur_shaders(ShaderSource& vtx_source, ShaderSource& frg_source,
             int ioffset = static_cast<int>(i - radius);
             for (unsigned int j = 0; j < side; j++) {
                 int joffset = static_cast<int>(j - radius);
-                ss << "texture2D(Texture0, TextureCoord + vec2(" <<
+                ss << texture_func << "(Texture0, TextureCoord + vec2(" <<
                       ioffset << ".0 * TextureStepX, " <<
                       joffset << ".0 * TextureStepY))" <<
                       " * Kernel" << std::abs(ioffset) <<
@@ -98,9 +148,215 @@ create_blur_shaders(ShaderSource& vtx_source, ShaderSource& frg_source,
         ss << " 0.0;" << std::endl;
     }
 
-    frg_source.replace("$CONVOLUTION$", ss.str());
+    source.replace("$CONVOLUTION$", ss.str());
+}
+
+/*
+ * Replaces the $CONVOLUTION$ placeholder of a blur shader with a gaussian
+ * kernel that uses bilinear filtering to merge each pair of neighbouring
+ * texels into a single tap, between them and weighted by their sum. A
+ * radius r kernel needs r / 2 + 1 taps on each axis instead of r + 1.
+ */
+static void
+add_linear_blur_convolution(ShaderSource& source, unsigned int radius, float sigma,
+                            BlurDirection direction)
+{
+    std::vector<float> kernel(blur_kernel(radius, sigma));
+    std::vector<float> offsets;
+    std::vector<float> weights;
+
+    for (unsigned int i = radius; i > 0; ) {
+        if (i >= 2) {
+            float w = kernel[i - 1] + kernel[i];
+            offsets.push_back(-((i - 1) * kernel[i - 1] + i * kernel[i]) / w);
+            weights.push_back(w);
+            i -= 2;
+        }
+        else {
+            offsets.push_back(-1.0);
+            weights.push_back(kernel[1]);
+            i -= 1;
+        }
+    }
+    unsigned int side_taps = offsets.size();
+    offsets.push_back(0.0);
+    weights.push_back(kernel[0]);
+    for (int i = side_taps - 1; i >= 0; i--) {
+        offsets.push_back(-offsets[i]);
+        weights.push_back(weights[i]);
+    }
+
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(6);
+    ss << "result = " << std::endl;
+
+    for (unsigned int i = 0; i < offsets.size(); i++) {
+        if (direction == BlurDirectionHorizontal) {
+            ss << "texture2D(Texture0, TextureCoord + vec2(" <<
+                  offsets[i] << " * TextureStepX, 0.0)) * " <<
+                  weights[i] << " +" << std::endl;
+        }
+        else if (direction == BlurDirectionVertical) {
+            ss << "texture2D(Texture0, TextureCoord + vec2(0.0, " <<
+                  offsets[i] << " * TextureStepY)) * " <<
+                  weights[i] << " +" << std::endl;
+        }
+        else if (direction == BlurDirectionBoth) {
+            for (unsigned int j = 0; j < offsets.size(); j++) {
+                ss << "texture2D(Texture0, TextureCoord + vec2(" <<
+                      offsets[i] << " * TextureStepX, " <<
+                      offsets[j] << " * TextureStepY)) * " <<
+                      weights[i] * weights[j] << " +" << std::endl;
+            }
+        }
+    }
+    ss << "0.0 ;" << std::endl;
+
+    source.replace("$CONVOLUTION$", ss.str());
+}
+
+static void
+create_blur_shaders(ShaderSource& vtx_source, ShaderSource& frg_source,
+                    unsigned int radius, float sigma, BlurDirection direction,
+                    bool linear)
+{
+    vtx_source.append_file(Options::data_path + "/shaders/desktop.vert");
+    frg_source.append_file(Options::data_path + "/shaders/desktop-blur.frag");
+
+    if (linear)
+        add_linear_blur_convolution(frg_source, radius, sigma, direction);
+    else
+        add_blur_convolution(frg_source, radius, sigma, direction);
+}
+
+/*
+ * Creates a compute shader that blurs Texture0 into the Output image.
+ */
+static void
+create_blur_compute_shader(ShaderSource& cmp_source, unsigned int radius,
+                           float sigma, BlurDirection direction)
+{
+    cmp_source.append(Scene::compute_shader_version());
+    cmp_source.append_file(Options::data_path + "/shaders/desktop-blur.comp");
+
+    add_blur_convolution(cmp_source, radius, sigma, direction, "texture");
+}
+
+/*
+ * Creates a compute shader that blurs Texture0 into the Output image along
+ * one axis. Each work group first fetches the texels it needs, including
+ * the radius texels on each side, into shared memory, so each texel is
+ * fetched about once instead of once per kernel tap.
+ */
+static void
+create_blur_shared_compute_shader(ShaderSource& cmp_source, unsigned int radius,
+                                  float sigma, BlurDirection direction)
+{
+    std::vector<float> kernel(blur_kernel(radius, sigma));
+
+    cmp_source.append(Scene::compute_shader_version());
+    cmp_source.append_file(Options::data_path + "/shaders/desktop-blur-shared.comp");
+
+    bool horizontal(direction == BlurDirectionHorizontal);
+    cmp_source.replace("$GROUP_SIZE_X$", horizontal ? "128" : "1");
+    cmp_source.replace("$GROUP_SIZE_Y$", horizontal ? "1" : "128");
+    cmp_source.replace("$DIRECTION$", horizontal ? "ivec2(1, 0)" : "ivec2(0, 1)");
+    cmp_source.replace("$RADIUS$", Util::toString(radius));
+
+    std::stringstream ss;
+    ss << "result = " << std::endl;
+    for (unsigned int i = 0; i < 2 * radius + 1; i++) {
+        int offset = static_cast<int>(i - radius);
+        ss << "Cache[local + " << i << "] * Kernel" << std::abs(offset) <<
+              " +" << std::endl;
+        if (offset >= 0) {
+            std::stringstream ss_tmp;
+            ss_tmp << "Kernel" << offset;
+            cmp_source.add_const(ss_tmp.str(), kernel[offset]);
+        }
+    }
+    ss << "vec4(0.0);" << std::endl;
+
+    cmp_source.replace("$CONVOLUTION$", ss.str());
 }
 
+/**
+ * A rectangle of pixels, from (x0, y0) at the lower left to (x1, y1)
+ * excluded.
+ */
+struct DamageRect
+{
+    DamageRect() : x0(0), y0(0), x1(0), y1(0) {}
+    DamageRect(int ax0, int ay0, int ax1, int ay1) :
+        x0(ax0), y0(ay0), x1(ax1), y1(ay1) {}
+
+    /* The pixels that a rectangle with any coordinates touches */
+    static DamageRect covering(const LibMatrix::vec2& ll, const LibMatrix::vec2& ur)
+    {
+        return DamageRect(std::floor(ll.x()), std::floor(ll.y()),
+                          std::ceil(ur.x()), std::ceil(ur.y()));
+    }
+
+    /* The pixels that a rectangle with any coordinates covers entirely */
+    static DamageRect inside(const LibMatrix::vec2& ll, const LibMatrix::vec2& ur)
+    {
+        return DamageRect(std::ceil(ll.x()), std::ceil(ll.y()),
+                          std::floor(ur.x()), std::floor(ur.y()));
+    }
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+
+    unsigned int area() const { return empty() ? 0 : (x1 - x0) * (y1 - y0); }
+
+    bool intersects(const DamageRect& r) const
+    {
+        return !empty() && !r.empty() &&
+               r.x0 < x1 && x0 < r.x1 && r.y0 < y1 && y0 < r.y1;
+    }
+
+    bool contains(const DamageRect& r) const
+    {
+        return !empty() && !r.empty() &&
+               r.x0 >= x0 && r.x1 <= x1 && r.y0 >= y0 && r.y1 <= y1;
+    }
+
+    DamageRect expanded(int margin) const
+    {
+        return DamageRect(x0 - margin, y0 - margin, x1 + margin, y1 + margin);
+    }
+
+    void unite(const DamageRect& r)
+    {
+        if (r.empty())
+            return;
+
+        if (empty()) {
+            *this = r;
+            return;
+        }
+
+        x0 = std::min(x0, r.x0);
+        y0 = std::min(y0, r.y0);
+        x1 = std::max(x1, r.x1);
+        y1 = std::max(y1, r.y1);
+    }
+
+    void intersect(const DamageRect& r)
+    {
+        x0 = std::max(x0, r.x0);
+        y0 = std::max(y0, r.y0);
+        x1 = std::min(x1, r.x1);
+        y1 = std::min(y1, r.y1);
+        if (empty())
+            *this = DamageRect();
+    }
+
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
 /**
  * A RenderObject represents a source and target of rendering
  * operations.
@@ -190,8 +446,48 @@ public:
     {
         GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
         glViewport(0, 0, size_.x(), size_.y());
+
+        if (RenderObject::use_scissor) {
+            if (scissor_.empty()) {
+                glDisable(GL_SCISSOR_TEST);
+            }
+            else {
+                glEnable(GL_SCISSOR_TEST);
+                glScissor(scissor_.x0, scissor_.y0,
+                          scissor_.x1 - scissor_.x0, scissor_.y1 - scissor_.y0);
+            }
+        }
+    }
+
+    /**
+     * Limits the drawing to this object to a rectangle, if use_scissor is
+     * set. An empty rectangle doesn't limit it.
+     */
+    void scissor(const DamageRect& rect) { scissor_ = rect; }
+
+    /**
+     * Gets the pixels of a target that drawing this object to it changes.
+     */
+    virtual DamageRect bounds()
+    {
+        /* Bilinear filtering may touch the pixels around the object */
+        return DamageRect::covering(pos_, pos_ + size_).expanded(1);
     }
 
+    /**
+     * Gets the pixels of a target that drawing this object to it reads.
+     */
+    virtual DamageRect read_bounds() { return DamageRect(); }
+
+    /**
+     * Gets the pixels of a target that drawing this object to it covers
+     * with opaque contents, hiding what was drawn there before.
+     */
+    virtual DamageRect opaque_bounds() { return DamageRect(); }
+
+    /* Whether the objects are drawn with their scissor rectangles */
+    static bool use_scissor;
+
     void position(const LibMatrix::vec2& pos) { pos_ = pos; }
     const LibMatrix::vec2& position() { return pos_; }
 
@@ -243,41 +539,7 @@ public:
 
     virtual void render_to(RenderObject& target, Program& program)
     {
-        LibMatrix::vec2 anchor(pos_);
-        LibMatrix::vec2 ll(pos_ - anchor);
-        LibMatrix::vec2 ur(pos_ + size_ - anchor);
-
-        /* Calculate new position according to rotation value */
-        GLfloat position[2 * 4] = {
-            rotate_x(ll.x(), ll.y()) + anchor.x(), rotate_y(ll.x(), ll.y()) + anchor.y(),
-            rotate_x(ur.x(), ll.y()) + anchor.x(), rotate_y(ur.x(), ll.y()) + anchor.y(),
-            rotate_x(ll.x(), ur.y()) + anchor.x(), rotate_y(ll.x(), ur.y()) + anchor.y(),
-            rotate_x(ur.x(), ur.y()) + anchor.x(), rotate_y(ur.x(), ur.y()) + anchor.y(),
-        };
-
-        /* Normalize position and write back to array */
-        for (int i = 0; i < 4; i++) {
-            const LibMatrix::vec2& v2(
-                    target.normalize_position(
-                        LibMatrix::vec2(position[2 * i], position[2 * i + 1])
-                        )
-                    );
-            position[2 * i] = v2.x();
-            position[2 * i + 1] = v2.y();
-        }
-
-        static const GLfloat texcoord[2 * 4] = {
-            0.0, 0.0,
-            1.0, 0.0,
-            0.0, 1.0,
-            1.0, 1.0,
-        };
-
-        target.make_current();
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture_);
-        draw_quad_with_program(position, texcoord, program);
+        render_texture_to(target, texture_, program);
     }
 
     virtual void render_from(RenderObject& target, Program& program = main_program)
@@ -326,6 +588,48 @@ public:
     }
 
 protected:
+    /**
+     * Draws a texture at the position and size of this object in target
+     */
+    void render_texture_to(RenderObject& target, GLuint texture, Program& program)
+    {
+        LibMatrix::vec2 anchor(pos_);
+        LibMatrix::vec2 ll(pos_ - anchor);
+        LibMatrix::vec2 ur(pos_ + size_ - anchor);
+
+        /* Calculate new position according to rotation value */
+        GLfloat position[2 * 4] = {
+            rotate_x(ll.x(), ll.y()) + anchor.x(), rotate_y(ll.x(), ll.y()) + anchor.y(),
+            rotate_x(ur.x(), ll.y()) + anchor.x(), rotate_y(ur.x(), ll.y()) + anchor.y(),
+            rotate_x(ll.x(), ur.y()) + anchor.x(), rotate_y(ll.x(), ur.y()) + anchor.y(),
+            rotate_x(ur.x(), ur.y()) + anchor.x(), rotate_y(ur.x(), ur.y()) + anchor.y(),
+        };
+
+        /* Normalize position and write back to array */
+        for (int i = 0; i < 4; i++) {
+            const LibMatrix::vec2& v2(
+                    target.normalize_position(
+                        LibMatrix::vec2(position[2 * i], position[2 * i + 1])
+                        )
+                    );
+            position[2 * i] = v2.x();
+            position[2 * i + 1] = v2.y();
+        }
+
+        static const GLfloat texcoord[2 * 4] = {
+            0.0, 0.0,
+            1.0, 0.0,
+            0.0, 1.0,
+            1.0, 1.0,
+        };
+
+        target.make_current();
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        draw_quad_with_program(position, texcoord, program);
+    }
+
     void draw_quad_with_program(const GLfloat *position, const GLfloat *texcoord,
                                 Program &program)
     {
@@ -370,11 +674,13 @@ private:
 
     float rotation_rad_;
     bool texture_contents_invalid_;
+    DamageRect scissor_;
     static int use_count;
 
 };
 
 int RenderObject::use_count = 0;
+bool RenderObject::use_scissor = false;
 Program RenderObject::main_program;
 
 /**
@@ -417,7 +723,7 @@ public:
 
     virtual void release()
     {
-        glDeleteTextures(1, &background_texture_);
+        Texture::release(1, &background_texture_);
         background_texture_ = 0;
 
         RenderObject::release();
@@ -462,9 +768,13 @@ class RenderWindowBlur : public RenderObject
 {
 public:
     RenderWindowBlur(unsigned int passes, unsigned int radius, bool separable,
-                     bool draw_contents = true) :
+                     bool draw_contents = true,
+                     BlurMethod method = BlurMethodFragment) :
         RenderObject(), passes_(passes), radius_(radius), separable_(separable),
-        draw_contents_(draw_contents) {}
+        draw_contents_(draw_contents), method_(method)
+    {
+        images_[0] = images_[1] = 0;
+    }
 
     virtual void init()
     {
@@ -485,6 +795,17 @@ public:
         if (draw_contents_ && RenderWindowBlur::use_count == 0)
             window_contents_.release();
 
+        if (images_[0] != 0) {
+            glDeleteTextures(2, images_);
+            images_[0] = images_[1] = 0;
+        }
+        compute_program_.release();
+        compute_program_h_.release();
+        compute_program_v_.release();
+        kawase_down_program_.release();
+        kawase_up_program_.release();
+        release_levels();
+
         RenderObject::release();
     }
 
@@ -495,9 +816,25 @@ public:
             window_contents_.size(size);
     }
 
+    virtual DamageRect read_bounds()
+    {
+        /* Each pass reads up to its radius around the window */
+        unsigned int reach(method_ == BlurMethodKawase ? (4U << passes_) :
+                           radius_ * passes_);
+        return bounds().expanded(reach);
+    }
+
     virtual void render_to(RenderObject& target)
     {
-        if (separable_) {
+        DebugMarkers::Group group("window blur");
+
+        if (method_ == BlurMethodCompute || method_ == BlurMethodComputeShared) {
+            render_to_compute(target);
+        }
+        else if (method_ == BlurMethodKawase) {
+            render_to_kawase(target);
+        }
+        else if (separable_) {
             Program& blur_program_h1 = blur_program_h(target.size().x());
             Program& blur_program_v1 = blur_program_v(target.size().y());
 
@@ -538,6 +875,274 @@ public:
     }
 
 private:
+    /*
+     * Blurs the target region under the window with compute shaders that
+     * write to images through image load/store, and draws the result into
+     * the target. Each pass reads the result of the previous one directly,
+     * instead of going through the target and the window texture.
+     */
+    void render_to_compute(RenderObject& target)
+    {
+        if (passes_ == 0)
+            return;
+
+        unsigned int w = RenderObject::size().x();
+        unsigned int h = RenderObject::size().y();
+
+        create_images(w, h);
+
+        LibMatrix::vec2 target_origin(target.normalize_texcoord(position()));
+        LibMatrix::vec2 target_step(1.0 / target.size().x(), 1.0 / target.size().y());
+        LibMatrix::vec2 image_step(1.0 / w, 1.0 / h);
+        GLuint result = 0;
+
+        for (unsigned int i = 0; i < passes_; i++) {
+            GLuint input = (i == 0 ? target.texture() : result);
+            const LibMatrix::vec2& origin(i == 0 ? target_origin : LibMatrix::vec2());
+            const LibMatrix::vec2& step(i == 0 ? target_step : image_step);
+
+            if (method_ == BlurMethodComputeShared) {
+                /* Work groups of 128 texels along the blurred axis */
+                dispatch_blur(blur_shared_compute_program_h(), input, origin, step,
+                              images_[0], (w + 127) / 128, h);
+                dispatch_blur(blur_shared_compute_program_v(), images_[0],
+                              LibMatrix::vec2(), image_step, images_[1],
+                              w, (h + 127) / 128);
+                result = images_[1];
+            }
+            else if (separable_) {
+                dispatch_blur(blur_compute_program_h(), input, origin, step, images_[0]);
+                dispatch_blur(blur_compute_program_v(), images_[0], LibMatrix::vec2(),
+                              image_step, images_[1]);
+                result = images_[1];
+            }
+            else {
+                dispatch_blur(blur_compute_program(), input, origin, step,
+                              images_[i % 2]);
+                result = images_[i % 2];
+            }
+        }
+
+        render_texture_to(target, result, main_program);
+    }
+
+    void dispatch_blur(Program& program, GLuint input,
+                       const LibMatrix::vec2& origin, const LibMatrix::vec2& step,
+                       GLuint output)
+    {
+        dispatch_blur(program, input, origin, step, output,
+                      (images_dim_.x() + 7) / 8, (images_dim_.y() + 7) / 8);
+    }
+
+    void dispatch_blur(Program& program, GLuint input,
+                       const LibMatrix::vec2& origin, const LibMatrix::vec2& step,
+                       GLuint output, unsigned int groups_x, unsigned int groups_y)
+    {
+        program.start();
+        program["TextureOrigin"] = origin;
+        program["TextureStep"] = step;
+        program["OutputWidth"] = static_cast<int>(images_dim_.x());
+        program["OutputHeight"] = static_cast<int>(images_dim_.y());
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, input);
+        GLExtensions::BindImageTexture(0, output, 0, GL_FALSE, 0,
+                                       GL_WRITE_ONLY, GL_RGBA8);
+        GLExtensions::DispatchCompute(groups_x, groups_y, 1);
+        /* Make the image visible to the next pass and the final draw */
+        GLExtensions::MemoryBarrierGL(GL_TEXTURE_FETCH_BARRIER_BIT |
+                                      GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        program.stop();
+    }
+
+    void create_images(unsigned int w, unsigned int h)
+    {
+        if (images_[0] != 0 && images_dim_.x() == w && images_dim_.y() == h)
+            return;
+
+        /* Immutable storage is required for the images used with load/store */
+        if (images_[0] != 0)
+            glDeleteTextures(2, images_);
+
+        glGenTextures(2, images_);
+        for (unsigned int i = 0; i < 2; i++) {
+            glBindTexture(GL_TEXTURE_2D, images_[i]);
+            GLExtensions::TexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, w, h);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+
+        images_dim_.x(w);
+        images_dim_.y(h);
+    }
+
+    /*
+     * The compute programs get the texture steps as uniforms, so unlike
+     * the fragment programs they don't depend on the window size.
+     */
+    Program& load_blur_compute_program(Program& program, BlurDirection direction)
+    {
+        if (!program.ready()) {
+            ShaderSource cmp_source;
+            if (method_ == BlurMethodComputeShared) {
+                create_blur_shared_compute_shader(cmp_source, radius_, radius_ / 3.0,
+                                                  direction);
+            }
+            else {
+                create_blur_compute_shader(cmp_source, radius_, radius_ / 3.0,
+                                           direction);
+            }
+            Scene::load_compute_shader_from_string(program, cmp_source.str());
+
+            program.start();
+            program["Texture0"] = 0;
+            program.stop();
+        }
+
+        return program;
+    }
+
+    Program& blur_compute_program()
+    {
+        return load_blur_compute_program(compute_program_, BlurDirectionBoth);
+    }
+
+    Program& blur_compute_program_h()
+    {
+        return load_blur_compute_program(compute_program_h_, BlurDirectionHorizontal);
+    }
+
+    Program& blur_compute_program_v()
+    {
+        return load_blur_compute_program(compute_program_v_, BlurDirectionVertical);
+    }
+
+    Program& blur_shared_compute_program_h()
+    {
+        return load_blur_compute_program(compute_program_h_, BlurDirectionHorizontal);
+    }
+
+    Program& blur_shared_compute_program_v()
+    {
+        return load_blur_compute_program(compute_program_v_, BlurDirectionVertical);
+    }
+
+    /*
+     * Blurs the target region under the window with the dual filter: the
+     * region is downsampled to half its size passes_ times with a 5 tap
+     * filter, then upsampled back to the window size with an 8 tap filter.
+     * The blur radius grows with the number of passes, the blur-radius
+     * option is not used.
+     */
+    void render_to_kawase(RenderObject& target)
+    {
+        if (passes_ == 0)
+            return;
+
+        create_levels();
+
+        Program& down = kawase_program(kawase_down_program_, "desktop-kawase-down.frag");
+        Program& up = kawase_program(kawase_up_program_, "desktop-kawase-up.frag");
+        static const LibMatrix::vec2 ll_full(0.0, 0.0);
+        static const LibMatrix::vec2 ur_full(1.0, 1.0);
+
+        draw_level(*levels_[0], target.texture(),
+                   target.normalize_texcoord(position()),
+                   target.normalize_texcoord(position() + RenderObject::size()),
+                   down);
+        for (unsigned int i = 1; i < levels_.size(); i++)
+            draw_level(*levels_[i], levels_[i - 1]->texture(), ll_full, ur_full, down);
+
+        for (unsigned int i = levels_.size() - 1; i > 0; i--)
+            draw_level(*levels_[i - 1], levels_[i]->texture(), ll_full, ur_full, up);
+        draw_level(*this, levels_[0]->texture(), ll_full, ur_full, up);
+
+        RenderObject::render_to(target);
+    }
+
+    /*
+     * Draws the [ll, ur] region of a texture over the whole of a level,
+     * with a program that samples around each texel with the HalfPixel
+     * offset, half a texel of the level in the texture coordinates.
+     */
+    void draw_level(RenderObject& level, GLuint texture,
+                    const LibMatrix::vec2& ll, const LibMatrix::vec2& ur,
+                    Program& program)
+    {
+        static const GLfloat position[2 * 4] = {
+            -1.0, -1.0,
+             1.0, -1.0,
+            -1.0,  1.0,
+             1.0,  1.0,
+        };
+        GLfloat texcoord[2 * 4] = {
+            ll.x(), ll.y(),
+            ur.x(), ll.y(),
+            ll.x(), ur.y(),
+            ur.x(), ur.y(),
+        };
+
+        level.make_current();
+        program.start();
+        program["HalfPixel"] = (ur - ll) * 0.5 / level.size();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        draw_quad_with_program(position, texcoord, program);
+    }
+
+    /*
+     * Creates the render targets of the dual filter levels, each half the
+     * size of the previous one, starting from half the window size.
+     */
+    void create_levels()
+    {
+        if (!levels_.empty() && levels_dim_.x() == RenderObject::size().x() &&
+            levels_dim_.y() == RenderObject::size().y())
+            return;
+
+        release_levels();
+
+        LibMatrix::vec2 level_size(RenderObject::size());
+        for (unsigned int i = 0; i < passes_; i++) {
+            level_size.x(std::max(1.0f, std::floor(level_size.x() / 2.0f)));
+            level_size.y(std::max(1.0f, std::floor(level_size.y() / 2.0f)));
+
+            RenderObject* level = new RenderObject();
+            level->init();
+            level->size(level_size);
+            levels_.push_back(level);
+        }
+
+        levels_dim_ = RenderObject::size();
+    }
+
+    void release_levels()
+    {
+        for (std::vector<RenderObject*>::iterator iter = levels_.begin();
+             iter != levels_.end();
+             iter++)
+        {
+            (*iter)->release();
+            delete *iter;
+        }
+        levels_.clear();
+    }
+
+    Program& kawase_program(Program& program, const std::string& frg_file)
+    {
+        if (!program.ready()) {
+            ShaderSource vtx_source(Options::data_path + "/shaders/desktop.vert");
+            ShaderSource frg_source(Options::data_path + "/shaders/" + frg_file);
+            Scene::load_shaders_from_strings(program, vtx_source.str(),
+                                             frg_source.str());
+        }
+
+        return program;
+    }
+
     Program& blur_program(unsigned int w, unsigned int h)
     {
         /*
@@ -555,7 +1160,8 @@ private:
             ShaderSource vtx_source;
             ShaderSource frg_source;
             create_blur_shaders(vtx_source, frg_source, radius_,
-                                radius_ / 3.0, BlurDirectionBoth);
+                                radius_ / 3.0, BlurDirectionBoth,
+                                method_ == BlurMethodLinear);
             frg_source.add_const("TextureStepX", 1.0 / w);
             frg_source.add_const("TextureStepY", 1.0 / h);
             Scene::load_shaders_from_strings(blur_program_, vtx_source.str(),
@@ -581,7 +1187,8 @@ private:
             ShaderSource vtx_source;
             ShaderSource frg_source;
             create_blur_shaders(vtx_source, frg_source, radius_,
-                                radius_ / 3.0, BlurDirectionHorizontal);
+                                radius_ / 3.0, BlurDirectionHorizontal,
+                                method_ == BlurMethodLinear);
             frg_source.add_const("TextureStepX", 1.0 / w);
             Scene::load_shaders_from_strings(blur_program_h_, vtx_source.str(),
                                              frg_source.str());
@@ -606,7 +1213,8 @@ private:
             ShaderSource vtx_source;
             ShaderSource frg_source;
             create_blur_shaders(vtx_source, frg_source, radius_,
-                                radius_ / 3.0, BlurDirectionVertical);
+                                radius_ / 3.0, BlurDirectionVertical,
+                                method_ == BlurMethodLinear);
             frg_source.add_const("TextureStepY", 1.0 / h);
             Scene::load_shaders_from_strings(blur_program_v_, vtx_source.str(),
                                              frg_source.str());
@@ -623,6 +1231,16 @@ private:
     unsigned int radius_;
     bool separable_;
     bool draw_contents_;
+    BlurMethod method_;
+    GLuint images_[2];
+    LibMatrix::uvec2 images_dim_;
+    Program compute_program_;
+    Program compute_program_h_;
+    Program compute_program_v_;
+    std::vector<RenderObject*> levels_;
+    LibMatrix::vec2 levels_dim_;
+    Program kawase_down_program_;
+    Program kawase_up_program_;
 
     static int use_count;
     static RenderClearImage window_contents_;
@@ -691,6 +1309,26 @@ public:
             window_contents_.size(size);
     }
 
+    virtual DamageRect bounds()
+    {
+        /* The shadow is drawn below and on the right of the window */
+        return DamageRect::covering(
+            position() - LibMatrix::vec2(0.0, shadow_size_),
+            position() + size() + LibMatrix::vec2(shadow_size_, 0.0)).expanded(1);
+    }
+
+    virtual DamageRect opaque_bounds()
+    {
+        /*
+         * Like a compositor that gets the opaque region of the windows
+         * from their clients, assume the window contents are opaque.
+         */
+        if (!draw_contents_)
+            return DamageRect();
+
+        return DamageRect::inside(position(), position() + size()).expanded(-1);
+    }
+
     virtual void render_to(RenderObject& target)
     {
         glEnable(GL_BLEND);
@@ -777,12 +1415,96 @@ struct SceneDesktopPrivate
     RenderScreen screen;
     RenderClearImage desktop;
     std::vector<RenderObject *> windows;
+    bool partial_damage;
+    bool occlusion_culling;
+    unsigned int moving_windows;
+    /* The pixels of the desktop that changed since the last frame */
+    DamageRect pending_damage;
+    /* The pixels redrawn in the previous frames, the latest first */
+    std::deque<DamageRect> damage_history;
+    /* The totals since the measurements were reset */
+    uint64_t redrawn_pixels;
+    uint64_t culled_windows;
+    uint64_t frames;
 
     SceneDesktopPrivate(Canvas &canvas) :
-        screen(canvas), desktop("effect-2d") {}
+        screen(canvas), desktop("effect-2d"), partial_damage(false),
+        occlusion_culling(false), moving_windows(0), redrawn_pixels(0),
+        culled_windows(0), frames(0) {}
 
     ~SceneDesktopPrivate() { Util::dispose_pointer_vector(windows); }
 
+    /*
+     * Grows the damage of the desktop to the whole of the windows that read
+     * what is under them (the blurred ones), and what they read.
+     */
+    DamageRect expand_damage(DamageRect damage)
+    {
+        bool expanded(true);
+
+        while (expanded) {
+            expanded = false;
+            for (std::vector<RenderObject *>::const_iterator iter = windows.begin();
+                 iter != windows.end();
+                 iter++)
+            {
+                DamageRect read((*iter)->read_bounds());
+                if (read.empty() || damage.contains(read) ||
+                    !(*iter)->bounds().intersects(damage))
+                {
+                    continue;
+                }
+                damage.unite(read);
+                expanded = true;
+            }
+        }
+
+        return damage;
+    }
+
+    /*
+     * Gets the pixels of the screen buffer that must be redrawn: the damage
+     * of the frames since the buffer was last drawn (its age), or all of
+     * them if its contents are unknown.
+     */
+    DamageRect screen_damage(const DamageRect& damage, unsigned int age,
+                             const DamageRect& full)
+    {
+        static const unsigned int max_history(4);
+        DamageRect screen_damage(damage);
+
+        if (age == 0 || age - 1 > damage_history.size()) {
+            screen_damage = full;
+        }
+        else {
+            for (unsigned int i = 0; i < age - 1; i++)
+                screen_damage.unite(damage_history[i]);
+        }
+
+        damage_history.push_front(damage);
+        if (damage_history.size() > max_history)
+            damage_history.pop_back();
+
+        return screen_damage;
+    }
+
+    /*
+     * Whether a window is hidden by an opaque window above it, without
+     * another window in between reading what is under it.
+     */
+    bool occluded(unsigned int index)
+    {
+        DamageRect bounds(windows[index]->bounds());
+
+        for (unsigned int i = index + 1; i < windows.size(); i++) {
+            if (windows[i]->read_bounds().intersects(bounds))
+                return false;
+            if (windows[i]->opaque_bounds().contains(bounds))
+                return true;
+        }
+
+        return false;
+    }
 };
 
 
@@ -803,8 +1525,26 @@ SceneDesktop::SceneDesktop(Canvas &canvas) :
     options_["separable"] = Scene::Option("separable", "true",
                                           "use separable convolution for the blur effect",
                                           "false,true");
+    options_["blur-method"] = Scene::Option("blur-method", "fragment",
+                                            "how the blur passes are run (linear: bilinear taps, kawase: dual filter"
+                                            " with one downsample level per pass, compute: image load/store,"
+                                            " compute-shared: separable with shared memory)",
+                                            "fragment,linear,kawase,compute,compute-shared");
     options_["shadow-size"] = Scene::Option("shadow-size", "20",
                                             "the size of the shadow (in pixels)");
+    options_["damage"] = Scene::Option("damage", "full",
+                                       "what to redraw each frame (partial: only what changed, scissored,"
+                                       " using the buffer age and swapping with damage when supported)",
+                                       "full,partial");
+    options_["window-size-spread"] = Scene::Option("window-size-spread", "0",
+                                                   "how much larger the top window is than the bottom one,"
+                                                   " relative to window-size (the others are in between)");
+    options_["moving-windows"] = Scene::Option("moving-windows", "0",
+                                               "the number of windows that move, the top ones (0: all)");
+    options_["occlusion-culling"] = Scene::Option("occlusion-culling", "false",
+                                                  "skip the windows hidden by opaque windows above them"
+                                                  " (blurred windows are not opaque)",
+                                                  "false,true");
 }
 
 SceneDesktop::~SceneDesktop()
@@ -815,11 +1555,27 @@ SceneDesktop::~SceneDesktop()
 bool
 SceneDesktop::supported(bool show_errors)
 {
-    if (show_errors && !GLExtensions::GenFramebuffers) {
-        Log::error("SceneDesktop requires GL framebuffer support\n");
+    if (!GLExtensions::GenFramebuffers) {
+        if (show_errors)
+            Log::error("SceneDesktop requires GL framebuffer support\n");
+        return false;
+    }
+
+    BlurMethod method(blur_method_from_str(options_["blur-method"].value));
+
+    if (options_["effect"].value == "blur" &&
+        (method == BlurMethodCompute || method == BlurMethodComputeShared) &&
+        (!GLExtensions::DispatchCompute || !GLExtensions::BindImageTexture ||
+         !GLExtensions::TexStorage2D))
+    {
+        if (show_errors) {
+            Log::error("SceneDesktop compute blur requires compute shader and"
+                       " image load/store support (GL 4.3 or GLES 3.1)\n");
+        }
+        return false;
     }
 
-    return GLExtensions::GenFramebuffers;
+    return true;
 }
 
 bool
@@ -844,14 +1600,20 @@ SceneDesktop::setup()
     unsigned int passes(0);
     unsigned int blur_radius(0);
     float window_size_factor(0.0);
+    float window_size_spread(0.0);
     unsigned int shadow_size(0);
     bool separable(options_["separable"].value == "true");
+    BlurMethod method(blur_method_from_str(options_["blur-method"].value));
 
     windows = Util::fromString<unsigned int>(options_["windows"].value);
     window_size_factor = Util::fromString<float>(options_["window-size"].value);
+    window_size_spread = Util::fromString<float>(options_["window-size-spread"].value);
     passes = Util::fromString<unsigned int>(options_["passes"].value);
     blur_radius = Util::fromString<unsigned int>(options_["blur-radius"].value);
     shadow_size = Util::fromString<unsigned int>(options_["shadow-size"].value);
+    priv_->partial_damage = (options_["damage"].value == "partial");
+    priv_->occlusion_culling = (options_["occlusion-culling"].value == "true");
+    priv_->moving_windows = Util::fromString<unsigned int>(options_["moving-windows"].value);
 
     // Make sure the Texture object knows where to find our images.
     Texture::find_textures();
@@ -870,18 +1632,20 @@ SceneDesktop::setup()
     /* Create the windows */
     const float angular_step(2.0 * M_PI / windows);
     unsigned int min_dimension = std::min(canvas_.width(), canvas_.height());
-    float window_size(min_dimension * window_size_factor);
-    static const LibMatrix::vec2 corner_offset(window_size / 2.0,
-                                               window_size / 2.0);
+    float base_window_size(min_dimension * window_size_factor);
 
     for (unsigned int i = 0; i < windows; i++) {
+        /* The windows grow from the bottom one to the top one */
+        float window_size(base_window_size *
+                          (1.0 + window_size_spread * i / std::max(windows - 1, 1U)));
+        LibMatrix::vec2 corner_offset(window_size / 2.0, window_size / 2.0);
         LibMatrix::vec2 center(canvas_.width() * (0.5 + 0.25 * cos(i * angular_step)),
                                canvas_.height() * (0.5 + 0.25 * sin(i * angular_step)));
         RenderObject* win;
         if (options_["effect"].value == "shadow")
             win = new RenderWindowShadow(shadow_size);
         else
-            win = new RenderWindowBlur(passes, blur_radius, separable);
+            win = new RenderWindowBlur(passes, blur_radius, separable, true, method);
 
         win->init();
         win->position(center - corner_offset);
@@ -906,6 +1670,12 @@ SceneDesktop::setup()
      */
     priv_->screen.make_current();
 
+    /* The first frame is drawn whole */
+    RenderObject::use_scissor = priv_->partial_damage;
+    priv_->pending_damage = DamageRect(0, 0, canvas_.width(), canvas_.height());
+    priv_->damage_history.clear();
+    reset_measurements();
+
     currentFrame_ = 0;
     running_ = true;
     startTime_ = Util::get_timestamp_us() / 1000000.0;
@@ -926,6 +1696,8 @@ SceneDesktop::teardown()
         delete curObj;
     }
     priv_->windows.clear();
+    RenderObject::use_scissor = false;
+    glDisable(GL_SCISSOR_TEST);
     if (supported(false))
         priv_->screen.make_current();
 
@@ -941,23 +1713,26 @@ SceneDesktop::teardown()
 void
 SceneDesktop::update()
 {
-    double current_time = Util::get_timestamp_us() / 1000000.0;
-    double dt = current_time - lastUpdateTime_;
+    double last_time = animation_time();
 
     Scene::update();
 
+    /* The animation time restarts from 0 when the warm-up is over */
+    double dt = std::max(animation_time() - last_time, 0.0);
+
     std::vector<RenderObject *>& windows(priv_->windows);
+    unsigned int first_moving(0);
+
+    if (priv_->moving_windows > 0 && priv_->moving_windows < windows.size())
+        first_moving = windows.size() - priv_->moving_windows;
 
     /*
      * Move the windows around the screen, bouncing them back when
      * they reach the edge.
      */
-    for (std::vector<RenderObject *>::const_iterator iter = windows.begin();
-         iter != windows.end();
-         iter++)
-    {
+    for (unsigned int i = first_moving; i < windows.size(); i++) {
         bool should_update = true;
-        RenderObject *win = *iter;
+        RenderObject *win = windows[i];
         LibMatrix::vec2 new_pos(
                 win->position().x() + win->speed().x() * dt,
                 win->position().y() + win->speed().y() * dt);
@@ -976,8 +1751,11 @@ SceneDesktop::update()
             should_update = false;
         }
 
-        if (should_update)
+        if (should_update) {
+            priv_->pending_damage.unite(win->bounds());
             win->position(new_pos);
+            priv_->pending_damage.unite(win->bounds());
+        }
     }
 }
 
@@ -985,22 +1763,100 @@ void
 SceneDesktop::draw()
 {
     std::vector<RenderObject *>& windows(priv_->windows);
+    DamageRect full(0, 0, canvas_.width(), canvas_.height());
+    DamageRect damage(full);
+    DamageRect screen_damage(full);
 
     /* Ensure we get a transparent clear color for all following operations */
     glClearColor(0.0, 0.0, 0.0, 0.0);
 
-    priv_->desktop.clear();
+    /*
+     * With partial updates, only the pixels of the desktop that changed
+     * since the last frame are redrawn, and only the pixels of the screen
+     * buffer that changed since the buffer was last drawn are copied.
+     */
+    if (priv_->partial_damage) {
+        damage = priv_->expand_damage(priv_->pending_damage);
+        damage.intersect(full);
+        priv_->pending_damage = DamageRect();
+        screen_damage = priv_->screen_damage(damage, canvas_.buffer_age(), full);
+        priv_->desktop.scissor(damage);
+        priv_->screen.scissor(screen_damage);
+    }
 
-    for (std::vector<RenderObject *>::const_iterator iter = windows.begin();
-         iter != windows.end();
-         iter++)
-    {
-        RenderObject *win = *iter;
-        win->render_to(priv_->desktop);
+    if (!damage.empty()) {
+        priv_->desktop.clear();
+
+        for (unsigned int i = 0; i < windows.size(); i++) {
+            RenderObject *win = windows[i];
+
+            if (!win->bounds().intersects(damage))
+                continue;
+
+            if (priv_->occlusion_culling && priv_->occluded(i)) {
+                priv_->culled_windows++;
+                continue;
+            }
+
+            win->render_to(priv_->desktop);
+        }
+    }
+
+    if (!screen_damage.empty())
+        priv_->desktop.render_to(priv_->screen);
+
+    if (priv_->partial_damage) {
+        std::vector<int> rects;
+        if (!damage.empty()) {
+            rects.push_back(damage.x0);
+            rects.push_back(damage.y0);
+            rects.push_back(damage.x1 - damage.x0);
+            rects.push_back(damage.y1 - damage.y0);
+        }
+        canvas_.damage(rects);
+        glDisable(GL_SCISSOR_TEST);
     }
 
-    priv_->desktop.render_to(priv_->screen);
+    priv_->redrawn_pixels += damage.area();
+    priv_->frames++;
+}
 
+bool
+SceneDesktop::needs_clear()
+{
+    return !priv_->partial_damage;
+}
+
+void
+SceneDesktop::reset_measurements()
+{
+    priv_->redrawn_pixels = 0;
+    priv_->culled_windows = 0;
+    priv_->frames = 0;
+}
+
+std::vector<Scene::Rate>
+SceneDesktop::rates()
+{
+    std::vector<Rate> rates;
+    double elapsed = elapsed_time();
+
+    if (priv_->frames == 0 || elapsed <= 0.0)
+        return rates;
+
+    /* The totals per frame, for the frames of the run */
+    double frames = frame_count() / static_cast<double>(priv_->frames);
+
+    if (priv_->partial_damage) {
+        rates.push_back(Rate("RedrawnPixelsPerSecond", "redrawn_pixels_per_second",
+                             priv_->redrawn_pixels * frames / elapsed));
+    }
+    if (priv_->occlusion_culling) {
+        rates.push_back(Rate("CulledWindowsPerSecond", "culled_windows_per_second",
+                             priv_->culled_windows * frames / elapsed));
+    }
+
+    return rates;
 }
 
 Scene::ValidationResult
@@ -1010,6 +1866,9 @@ SceneDesktop::validate()
 
     Canvas::Pixel ref;
 
+    if (Util::fromString<float>(options_["window-size-spread"].value) != 0.0)
+        return Scene::ValidationUnknown;
+
     /* Parse the options */
     unsigned int windows(0);
     unsigned int passes(0);
@@ -1025,6 +1884,10 @@ SceneDesktop::validate()
 
     if (options_["effect"].value == "blur")
     {
+        /* The dual filter blur doesn't use the gaussian kernel */
+        if (options_["blur-method"].value == "kawase")
+            return Scene::ValidationUnknown;
+
         if (windows == 4 && passes == 1 && blur_radius == 5)
             ref = Canvas::Pixel(0x89, 0xa3, 0x53, 0xff);
         else
@@ -1053,3 +1916,19 @@ SceneDesktop::validate()
                 ref.to_le32(), pixel.to_le32(), dist);
     return Scene::ValidationFailure;
 }
+
+std::vector<std::string>
+SceneDesktop::textures()
+{
+    std::vector<std::string> names;
+
+    names.push_back("effect-2d");
+    names.push_back("desktop-window");
+    if (options_["effect"].value == "shadow") {
+        names.push_back("desktop-shadow");
+        names.push_back("desktop-shadow");
+        names.push_back("desktop-shadow-corner");
+    }
+
+    return names;
+}
@@ -0,0 +1,431 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "canvas.h"
+#include "frame-stats.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+struct SceneDmaBufPrivate {
+    enum Method {
+        MethodImport,
+        MethodSample,
+        MethodUpload
+    };
+
+    SceneDmaBufPrivate() :
+        method(MethodSample), nv12(false), width(0), height(0),
+        quad_buffer(0), target(GL_TEXTURE_2D), egl_image(0)
+    {
+        textures[0] = textures[1] = 0;
+    }
+
+    Method method;
+    bool nv12;
+    unsigned int width;
+    unsigned int height;
+
+    Program program;
+    GLuint quad_buffer;
+    GLenum target;
+    /* The image, or the Y and UV planes of uploaded NV12 frames */
+    GLuint textures[2];
+
+    /* The frame, as RGBA pixels or an NV12 Y plane followed by a UV plane */
+    std::vector<unsigned char> pixels;
+    DmaBuf buf;
+    DmaBufImage image;
+    void *egl_image;
+
+    /* The CPU time of the import or upload of each frame, in µs */
+    FrameStats update_stats;
+
+    void release(Canvas &canvas)
+    {
+        release_image(canvas);
+
+        if (buf.fd >= 0)
+            canvas.destroy_dma_buf(buf);
+
+        if (textures[0]) {
+            glDeleteTextures(2, textures);
+            textures[0] = textures[1] = 0;
+        }
+
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+
+        std::vector<unsigned char>().swap(pixels);
+    }
+
+    void release_image(Canvas &canvas)
+    {
+        if (egl_image) {
+            canvas.destroy_dma_buf_image(egl_image);
+            egl_image = 0;
+        }
+    }
+
+    /* Imports the dma-buf and attaches it to the texture, without copies */
+    bool import_image(Canvas &canvas)
+    {
+        egl_image = canvas.create_dma_buf_image(image);
+        if (!egl_image)
+            return false;
+
+        glBindTexture(target, textures[0]);
+        GLExtensions::EGLImageTargetTexture2DOES(target, egl_image);
+
+        return true;
+    }
+
+    /* Copies the frame to the texture(s), like a non zero-copy path would */
+    void upload()
+    {
+        glBindTexture(GL_TEXTURE_2D, textures[0]);
+
+        if (!nv12) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                            GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+            return;
+        }
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                        GL_LUMINANCE, GL_UNSIGNED_BYTE, &pixels[0]);
+        glBindTexture(GL_TEXTURE_2D, textures[1]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width / 2, height / 2,
+                        GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE,
+                        &pixels[static_cast<size_t>(width) * height]);
+    }
+};
+
+SceneDmaBuf::SceneDmaBuf(Canvas &pCanvas) :
+    Scene(pCanvas, "dma-buf")
+{
+    priv_ = new SceneDmaBufPrivate();
+    options_["method"] = Scene::Option("method", "sample",
+                                       "How each frame gets to the texture: imported again from the dma-buf, "
+                                       "imported once and only sampled, or copied with glTexSubImage2D()",
+                                       "import,sample,upload");
+    options_["format"] = Scene::Option("format", "rgba",
+                                       "The format of the frames, NV12 as produced by video decoders",
+                                       "rgba,nv12");
+    options_["texture-size"] = Scene::Option("texture-size", "1920x1080",
+                                             "The size of the frames in WxH format");
+}
+
+SceneDmaBuf::~SceneDmaBuf()
+{
+    delete priv_;
+}
+
+bool
+SceneDmaBuf::supported(bool show_errors)
+{
+    if (options_["method"].value == "upload")
+        return true;
+
+    if (GLExtensions::EGLImageTargetTexture2DOES == 0) {
+        if (show_errors) {
+            Log::error("Requested dma-buf import but GL_OES_EGL_image is not supported!\n");
+        }
+        return false;
+    }
+
+    if (options_["format"].value == "nv12" &&
+        !GLExtensions::support("GL_OES_EGL_image_external"))
+    {
+        if (show_errors) {
+            Log::error("Requested NV12 dma-buf import but GL_OES_EGL_image_external is not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneDmaBuf::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneDmaBuf::unload()
+{
+}
+
+bool
+SceneDmaBuf::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/dma-buf.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/dma-buf.frag");
+
+    SceneDmaBufPrivate &p(*priv_);
+
+    /* Parse the options */
+    const std::string &method(options_["method"].value);
+    p.nv12 = options_["format"].value == "nv12";
+
+    if (method == "import")
+        p.method = SceneDmaBufPrivate::MethodImport;
+    else if (method == "upload")
+        p.method = SceneDmaBufPrivate::MethodUpload;
+    else
+        p.method = SceneDmaBufPrivate::MethodSample;
+
+    std::vector<std::string> size_elems;
+    Util::split(options_["texture-size"].value, 'x', size_elems, Util::SplitModeNormal);
+    if (size_elems.size() != 2) {
+        Log::error("Invalid texture-size '%s', expected WxH\n",
+                   options_["texture-size"].value.c_str());
+        return false;
+    }
+
+    /* The chroma of NV12 is subsampled by 2 in both directions */
+    p.width = Util::fromString<unsigned int>(size_elems[0]) & ~1u;
+    p.height = Util::fromString<unsigned int>(size_elems[1]) & ~1u;
+    if (p.width == 0 || p.height == 0) {
+        Log::error("Invalid texture-size '%s'\n", options_["texture-size"].value.c_str());
+        return false;
+    }
+
+    bool imported = p.method != SceneDmaBufPrivate::MethodUpload;
+    p.target = imported && p.nv12 ? GL_TEXTURE_EXTERNAL_OES : GL_TEXTURE_2D;
+
+    /* Generate the frame: color bars, or their luma and chroma */
+    const size_t npixels = static_cast<size_t>(p.width) * p.height;
+    p.pixels.resize(p.nv12 ? npixels * 3 / 2 : npixels * 4);
+
+    for (unsigned int y = 0; y < p.height; y++) {
+        for (unsigned int x = 0; x < p.width; x++) {
+            unsigned int bar = x * 8 / p.width;
+            unsigned char r = bar & 1 ? 0xff : 0x00;
+            unsigned char g = bar & 2 ? 0xff : 0x00;
+            unsigned char b = bar & 4 ? 0xff : 0x00;
+            size_t i = static_cast<size_t>(y) * p.width + x;
+
+            if (!p.nv12) {
+                p.pixels[i * 4] = r;
+                p.pixels[i * 4 + 1] = g;
+                p.pixels[i * 4 + 2] = b;
+                p.pixels[i * 4 + 3] = 0xff;
+                continue;
+            }
+
+            p.pixels[i] = 16 + (66 * r + 129 * g + 25 * b) / 256;
+            if (x % 2 == 0 && y % 2 == 0) {
+                size_t uv = npixels + static_cast<size_t>(y / 2) * p.width + x;
+                p.pixels[uv] = 128 + (-38 * r - 74 * g + 112 * b) / 256;
+                p.pixels[uv + 1] = 128 + (112 * r - 94 * g - 18 * b) / 256;
+            }
+        }
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source;
+
+    if (p.target == GL_TEXTURE_EXTERNAL_OES)
+        frg_source.append("#extension GL_OES_EGL_image_external : require\n");
+    frg_source.append_file(frg_shader_filename);
+
+    frg_source.replace("SAMPLER", p.target == GL_TEXTURE_EXTERNAL_OES ?
+                                  "samplerExternalOES" : "sampler2D");
+    if (p.nv12 && !imported) {
+        frg_source.replace("SAMPLE", "nv12_to_rgba(texture2D(Texture0, TexCoord).r, "
+                                     "texture2D(Texture1, TexCoord).ra)");
+    }
+    else {
+        /* The GL converts imported NV12 to RGB when sampling */
+        frg_source.replace("SAMPLE", "texture2D(Texture0, TexCoord)");
+    }
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.quad_buffer = FullscreenQuad::create();
+
+    /* Create the textures, whose storage comes from the dma-buf if imported */
+    glGenTextures(2, p.textures);
+    for (unsigned int i = 0; i < 2; i++) {
+        glBindTexture(p.target, p.textures[i]);
+        glTexParameteri(p.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(p.target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(p.target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(p.target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    if (imported) {
+        /* NV12 is laid out in an 8-bit buffer 1.5 times as tall */
+        unsigned int buf_height = p.nv12 ? p.height * 3 / 2 : p.height;
+        if (!canvas_.create_dma_buf(p.width, buf_height, p.nv12 ? 1 : 4,
+                                    &p.pixels[0], p.buf))
+        {
+            Log::error("Failed to allocate a dma-buf, which is only supported by the DRM flavors\n");
+            return false;
+        }
+
+        p.image.fourcc = p.nv12 ? DmaBufFormatNV12 : DmaBufFormatABGR8888;
+        p.image.width = p.width;
+        p.image.height = p.height;
+        p.image.num_planes = p.nv12 ? 2 : 1;
+        for (unsigned int i = 0; i < p.image.num_planes; i++) {
+            p.image.fds[i] = p.buf.fd;
+            p.image.offsets[i] = i * p.buf.stride * p.height;
+            p.image.strides[i] = p.buf.stride;
+        }
+
+        if (!p.import_image(canvas_)) {
+            Log::error("Failed to import the dma-buf with EGL_EXT_image_dma_buf_import\n");
+            return false;
+        }
+    }
+    else if (p.nv12) {
+        glBindTexture(GL_TEXTURE_2D, p.textures[0]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, p.width, p.height, 0,
+                     GL_LUMINANCE, GL_UNSIGNED_BYTE, 0);
+        glBindTexture(GL_TEXTURE_2D, p.textures[1]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, p.width / 2, p.height / 2, 0,
+                     GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, 0);
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, p.textures[0]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, p.width, p.height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    }
+
+    /* Rows of tightly packed NV12 planes may not be 4-byte aligned */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    p.program.start();
+    p.program["Texture0"] = 0;
+    p.program["Texture1"] = 1;
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, p.target == GL_TEXTURE_2D ? p.textures[1] : 0);
+    glActiveTexture(GL_TEXTURE0);
+
+    glDisable(GL_DEPTH_TEST);
+
+    p.update_stats.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneDmaBuf::teardown()
+{
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release(canvas_);
+
+    Scene::teardown();
+}
+
+void
+SceneDmaBuf::update()
+{
+    Scene::update();
+}
+
+/*
+ * Gets the frame to the texture as requested, timing it, and draws it
+ * over the whole canvas, sampling every pixel of the frame once.
+ */
+void
+SceneDmaBuf::draw()
+{
+    SceneDmaBufPrivate &p(*priv_);
+    GLint position_location = p.program["position"].location();
+
+    uint64_t start = Util::get_timestamp_us();
+
+    switch (p.method) {
+        case SceneDmaBufPrivate::MethodImport:
+            /* Drivers may defer some of the import work to the first draw */
+            p.release_image(canvas_);
+            p.import_image(canvas_);
+            p.update_stats.add(Util::get_timestamp_us() - start);
+            break;
+        case SceneDmaBufPrivate::MethodUpload:
+            p.upload();
+            p.update_stats.add(Util::get_timestamp_us() - start);
+            break;
+        case SceneDmaBufPrivate::MethodSample:
+            break;
+    }
+
+    glBindTexture(p.target, p.textures[0]);
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneDmaBuf::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneDmaBuf::measurements()
+{
+    std::vector<Measurement> m;
+
+    if (priv_->method == SceneDmaBufPrivate::MethodImport)
+        m.push_back(Measurement("Import", "import", priv_->update_stats));
+    else if (priv_->method == SceneDmaBufPrivate::MethodUpload)
+        m.push_back(Measurement("Upload", "upload", priv_->update_stats));
+
+    return m;
+}
+
+void
+SceneDmaBuf::reset_measurements()
+{
+    priv_->update_stats.reset();
+}
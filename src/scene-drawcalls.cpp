@@ -0,0 +1,417 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+
+struct SceneDrawCallsPrivate {
+    enum StateChange {
+        StateChangeNone,
+        StateChangeUniform,
+        StateChangeTexture,
+        StateChangeProgram,
+        StateChangeVAO,
+        StateChangeUBO
+    };
+
+    SceneDrawCallsPrivate() :
+        state_change(StateChangeNone), draws(0), objects(0),
+        offset_location(-1), ubo(0), ubo_stride(0) {}
+
+    StateChange state_change;
+    unsigned int draws;
+    unsigned int objects;
+
+    /*
+     * The objects cycled through between draws. Only the kind selected
+     * by state-change has more than one element.
+     */
+    std::vector<Program *> programs;
+    std::vector<Mesh *> meshes;
+    std::vector<GLuint> textures;
+
+    /* The Offset uniform location, looked up once to keep it out of the loop */
+    GLint offset_location;
+    /* The position of each draw on the screen, used by the uniform change */
+    std::vector<float> offsets;
+    /*
+     * The uniform buffer holding the offsets for the UBO change, one
+     * DrawParams block per draw at ubo_stride bytes from each other.
+     */
+    GLuint ubo;
+    GLintptr ubo_stride;
+
+    FrameStats submit_stats;
+
+    void release()
+    {
+        for (std::vector<Program *>::iterator iter = programs.begin();
+             iter != programs.end();
+             iter++)
+        {
+            (*iter)->stop();
+            (*iter)->release();
+            delete *iter;
+        }
+        programs.clear();
+
+        for (std::vector<Mesh *>::iterator iter = meshes.begin();
+             iter != meshes.end();
+             iter++)
+        {
+            delete *iter;
+        }
+        meshes.clear();
+
+        if (!textures.empty()) {
+            glDeleteTextures(textures.size(), &textures[0]);
+            textures.clear();
+        }
+
+        offsets.clear();
+
+        if (ubo) {
+            glDeleteBuffers(1, &ubo);
+            ubo = 0;
+        }
+    }
+};
+
+SceneDrawCalls::SceneDrawCalls(Canvas &pCanvas) :
+    Scene(pCanvas, "drawcalls")
+{
+    priv_ = new SceneDrawCallsPrivate();
+    options_["draws"] = Scene::Option("draws", "10000",
+                                      "The number of draw calls issued every frame");
+    options_["state-change"] = Scene::Option("state-change", "none",
+                                             "The state that is changed between draw calls"
+                                             " (ubo binds a range of a uniform buffer)",
+                                             "none,uniform,texture,program,vao,ubo");
+    options_["objects"] = Scene::Option("objects", "16",
+                                        "The number of textures, programs or VAOs that are cycled through");
+}
+
+SceneDrawCalls::~SceneDrawCalls()
+{
+    delete priv_;
+}
+
+bool
+SceneDrawCalls::supported(bool show_errors)
+{
+    if (options_["state-change"].value == "vao" &&
+        GLExtensions::GenVertexArrays == 0)
+    {
+        if (show_errors) {
+            Log::error("Requested VAO state changes but vertex array objects"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    if (options_["state-change"].value == "ubo" &&
+        (GLExtensions::BindBufferRange == 0 || GLExtensions::UniformBlockBinding == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested UBO state changes but uniform buffer objects"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneDrawCalls::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneDrawCalls::unload()
+{
+}
+
+bool
+SceneDrawCalls::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/drawcalls.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/drawcalls.frag");
+    static const std::string vtx_ubo_shader_filename(Options::data_path + "/shaders/drawcalls-ubo.vert");
+    static const std::string frg_ubo_shader_filename(Options::data_path + "/shaders/drawcalls-ubo.frag");
+
+    SceneDrawCallsPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.draws = Util::fromString<unsigned int>(options_["draws"].value);
+    p.objects = Util::fromString<unsigned int>(options_["objects"].value);
+    if (p.draws == 0 || p.objects == 0) {
+        Log::error("The number of draws and objects must be at least 1\n");
+        return false;
+    }
+
+    const std::string &state_change = options_["state-change"].value;
+    if (state_change == "uniform")
+        p.state_change = SceneDrawCallsPrivate::StateChangeUniform;
+    else if (state_change == "texture")
+        p.state_change = SceneDrawCallsPrivate::StateChangeTexture;
+    else if (state_change == "program")
+        p.state_change = SceneDrawCallsPrivate::StateChangeProgram;
+    else if (state_change == "vao")
+        p.state_change = SceneDrawCallsPrivate::StateChangeVAO;
+    else if (state_change == "ubo")
+        p.state_change = SceneDrawCallsPrivate::StateChangeUBO;
+    else
+        p.state_change = SceneDrawCallsPrivate::StateChangeNone;
+
+    unsigned int nprograms =
+        p.state_change == SceneDrawCallsPrivate::StateChangeProgram ? p.objects : 1;
+    unsigned int nmeshes =
+        p.state_change == SceneDrawCallsPrivate::StateChangeVAO ? p.objects : 1;
+    unsigned int ntextures =
+        p.state_change == SceneDrawCallsPrivate::StateChangeTexture ? p.objects : 1;
+
+    /*
+     * Lay out the draws in a square grid covering the screen. Each draw is
+     * a small quad filling one grid cell.
+     */
+    unsigned int side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(p.draws))));
+    float cell = 2.0f / side;
+
+    p.offsets.reserve(2 * p.draws);
+    for (unsigned int i = 0; i < p.draws; i++) {
+        p.offsets.push_back(-1.0f + cell * (i % side + 0.5f));
+        p.offsets.push_back(1.0f - cell * (i / side + 0.5f));
+    }
+
+    /*
+     * Create the programs. Each one uses a different color so that the
+     * driver can't treat them as the same program.
+     */
+    bool ubo = p.state_change == SceneDrawCallsPrivate::StateChangeUBO;
+
+    for (unsigned int i = 0; i < nprograms; i++) {
+        ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+        ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+        if (ubo) {
+            vtx_source.append(Scene::glsl3_shader_version());
+            vtx_source.append_file(vtx_ubo_shader_filename);
+            frg_source.append(Scene::glsl3_shader_version());
+            frg_source.append_file(frg_ubo_shader_filename);
+        }
+        else {
+            vtx_source.append_file(vtx_shader_filename);
+            frg_source.append_file(frg_shader_filename);
+        }
+
+        float hue = static_cast<float>(i) / nprograms;
+        frg_source.add_const("DrawColor",
+                             LibMatrix::vec4(0.5f + 0.5f * std::cos(6.2832f * hue),
+                                             0.5f + 0.5f * std::cos(6.2832f * (hue + 0.33f)),
+                                             0.5f + 0.5f * std::cos(6.2832f * (hue + 0.67f)),
+                                             1.0f));
+
+        Program *program = new Program();
+        p.programs.push_back(program);
+
+        if (!Scene::load_shaders_from_strings(*program, vtx_source.str(),
+                                              frg_source.str()))
+        {
+            return false;
+        }
+
+        program->start();
+        (*program)["MaterialTexture0"] = 0;
+        if (ubo)
+            program->bindUniformBlock("DrawParams", 0);
+        else
+            (*program)["Offset"] = LibMatrix::vec2(p.offsets[0], p.offsets[1]);
+    }
+
+    if (ubo) {
+        /* Each draw's block must start at a multiple of the offset alignment */
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        GLintptr block_size = 4 * sizeof(float);
+        p.ubo_stride = std::max<GLintptr>(alignment, 1);
+        p.ubo_stride = (block_size + p.ubo_stride - 1) / p.ubo_stride * p.ubo_stride;
+
+        std::vector<unsigned char> data(p.draws * p.ubo_stride);
+        for (unsigned int i = 0; i < p.draws; i++) {
+            float block[4] = { p.offsets[2 * i], p.offsets[2 * i + 1], 0.0f, 0.0f };
+            std::copy(reinterpret_cast<unsigned char *>(block),
+                      reinterpret_cast<unsigned char *>(block) + sizeof(block),
+                      &data[i * p.ubo_stride]);
+        }
+
+        glGenBuffers(1, &p.ubo);
+        glBindBuffer(GL_UNIFORM_BUFFER, p.ubo);
+        glBufferData(GL_UNIFORM_BUFFER, data.size(), &data[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        GLExtensions::BindBufferRange(GL_UNIFORM_BUFFER, 0, p.ubo, 0, block_size);
+    }
+    else {
+        p.offset_location = (*p.programs[0])["Offset"].location();
+    }
+
+    /* Create the meshes, which all share the attribute locations of the first program */
+    std::vector<int> vertex_format;
+    vertex_format.push_back(3);
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back((*p.programs[0])["position"].location());
+
+    for (unsigned int i = 0; i < nmeshes; i++) {
+        Mesh *mesh = new Mesh();
+        p.meshes.push_back(mesh);
+
+        mesh->set_vertex_format(vertex_format);
+        mesh->make_grid(1, 1, cell, cell, 0.0);
+        if (p.state_change == SceneDrawCallsPrivate::StateChangeVAO)
+            mesh->vbo_vao(true);
+        mesh->build_vbo();
+        mesh->set_attrib_locations(attrib_locations);
+    }
+
+    /* Create small textures with different contents */
+    p.textures.resize(ntextures);
+    glGenTextures(ntextures, &p.textures[0]);
+    for (unsigned int i = 0; i < ntextures; i++) {
+        unsigned char texel[4] = {
+            static_cast<unsigned char>(255 - 128 * i / ntextures),
+            static_cast<unsigned char>(128 + 127 * i / ntextures),
+            255, 255
+        };
+
+        glBindTexture(GL_TEXTURE_2D, p.textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, texel);
+    }
+
+    p.programs[0]->start();
+
+    p.submit_stats.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneDrawCalls::teardown()
+{
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneDrawCalls::update()
+{
+    Scene::update();
+}
+
+/*
+ * Issues the draw calls, changing only the selected state between them so
+ * that the cost of the draw call itself and of each kind of state change
+ * can be told apart.
+ */
+void
+SceneDrawCalls::draw()
+{
+    SceneDrawCallsPrivate &p(*priv_);
+    uint64_t start = Util::get_timestamp_us();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, p.textures[0]);
+
+    for (unsigned int i = 0; i < p.draws; i++) {
+        unsigned int obj = i % p.objects;
+
+        switch (p.state_change) {
+            case SceneDrawCallsPrivate::StateChangeUniform:
+                glUniform2f(p.offset_location, p.offsets[2 * i], p.offsets[2 * i + 1]);
+                break;
+            case SceneDrawCallsPrivate::StateChangeTexture:
+                glBindTexture(GL_TEXTURE_2D, p.textures[obj]);
+                break;
+            case SceneDrawCallsPrivate::StateChangeProgram:
+                p.programs[obj]->start();
+                break;
+            case SceneDrawCallsPrivate::StateChangeUBO:
+                GLExtensions::BindBufferRange(GL_UNIFORM_BUFFER, 0, p.ubo,
+                                              i * p.ubo_stride, 4 * sizeof(float));
+                break;
+            case SceneDrawCallsPrivate::StateChangeNone:
+            case SceneDrawCallsPrivate::StateChangeVAO:
+                break;
+        }
+
+        p.meshes[p.meshes.size() > 1 ? obj : 0]->render_vbo();
+    }
+
+    p.submit_stats.add(Util::get_timestamp_us() - start);
+}
+
+Scene::ValidationResult
+SceneDrawCalls::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneDrawCalls::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("SubmitTime", "submit_time",
+                                                   priv_->submit_stats));
+}
+
+void
+SceneDrawCalls::reset_measurements()
+{
+    priv_->submit_stats.reset();
+}
+
+std::vector<Scene::Rate>
+SceneDrawCalls::rates()
+{
+    double elapsed = elapsed_time();
+    double draws = static_cast<double>(priv_->draws) * frame_count();
+
+    return std::vector<Rate>(1, Rate("DrawsPerSecond", "draws_per_second",
+                                     elapsed > 0.0 ? draws / elapsed : 0.0));
+}
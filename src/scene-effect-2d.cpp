@@ -23,6 +23,7 @@
 #include <cmath>
 #include <climits>
 #include <numeric>
+#include <algorithm>
 
 #include "scene.h"
 #include "mat.h"
@@ -36,7 +37,8 @@
 #include "texture.h"
 
 SceneEffect2D::SceneEffect2D(Canvas &pCanvas) :
-    Scene(pCanvas, "effect2d")
+    Scene(pCanvas, "effect2d"), position_location_(0),
+    mesh_position_location_(0), terms_(0)
 {
     options_["kernel"] = Scene::Option("kernel",
         "0,0,0;0,1,0;0,0,0",
@@ -44,6 +46,20 @@ SceneEffect2D::SceneEffect2D(Canvas &pCanvas) :
     options_["normalize"] = Scene::Option("normalize", "true",
         "Whether to normalize the supplied convolution kernel matrix",
         "false,true");
+    options_["separable"] = Scene::Option("separable", "auto",
+        "Whether to convolve with a row and a column pass for each separable"
+        " term of the kernel, through intermediate targets (auto: if the kernel"
+        " has at most separable-terms terms and that takes fewer taps)",
+        "auto,false,true");
+    options_["separable-terms"] = Scene::Option("separable-terms", "1",
+        "The separable terms of the kernel to keep, in the order of its singular"
+        " values; fewer terms than the rank of the kernel approximate it [1-4]");
+
+    for (unsigned int t = 0; t < max_terms; t++) {
+        row_fbos_[t] = 0;
+        row_textures_[t] = 0;
+        row_position_locations_[t] = 0;
+    }
 }
 
 SceneEffect2D::~SceneEffect2D()
@@ -85,7 +101,8 @@ calc_offset(unsigned int i, unsigned int width, unsigned int height)
  * response). This also means that we don't need to perform the (implicit)
  * rotation of the kernel in our convolution implementation.
  *
- * @param canvas the destination Canvas for this shader
+ * @param step the distance between the pixels of the source texture, in
+ *             texture coordinates
  * @param array the array holding the filter coefficients in row-major
  *              order
  * @param width the width of the filter
@@ -93,9 +110,10 @@ calc_offset(unsigned int i, unsigned int width, unsigned int height)
  *
  * @return a string containing the frament source code
  */
-static std::string
-create_convolution_fragment_shader(Canvas &canvas, std::vector<float> &array,
-                                   unsigned int width, unsigned int height)
+std::string
+SceneEffect2D::create_convolution_fragment_shader(const LibMatrix::vec2 &step,
+                                                  const std::vector<float> &array,
+                                                  unsigned int width, unsigned int height)
 {
     static const std::string frg_shader_filename(Options::data_path + "/shaders/effect-2d-convolution.frag");
     ShaderSource source(frg_shader_filename);
@@ -106,8 +124,8 @@ create_convolution_fragment_shader(Canvas &canvas, std::vector<float> &array,
     }
 
     /* Steps are needed to be able to access nearby pixels */
-    source.add_const("TextureStepX", 1.0f/canvas.width());
-    source.add_const("TextureStepY", 1.0f/canvas.height());
+    source.add_const("TextureStepX", step.x());
+    source.add_const("TextureStepY", step.y());
 
     std::stringstream ss_def;
     std::stringstream ss_convolution;
@@ -188,9 +206,9 @@ kernel_printout(const std::vector<float> &kernel,
  *
  * @return whether parsing succeeded
  */
-static bool
-parse_matrix(const std::string &str, std::vector<float> &matrix,
-             unsigned int &width, unsigned int &height)
+bool
+SceneEffect2D::parse_matrix(const std::string &str, std::vector<float> &matrix,
+                            unsigned int &width, unsigned int &height)
 {
     std::vector<std::string> rows;
     unsigned int w = UINT_MAX;
@@ -244,8 +262,8 @@ parse_matrix(const std::string &str, std::vector<float> &matrix,
  *
  * @param filter the filter to normalize
  */
-static void
-normalize(std::vector<float> &kernel)
+void
+SceneEffect2D::normalize(std::vector<float> &kernel)
 {
     float sum = std::accumulate(kernel.begin(), kernel.end(), 0.0);
 
@@ -280,6 +298,262 @@ normalize(std::vector<float> &kernel)
 
 }
 
+unsigned int
+SceneEffect2D::separate(const std::vector<float> &kernel,
+                        unsigned int width, unsigned int height,
+                        unsigned int max_terms,
+                        std::vector<std::vector<float> > &rows,
+                        std::vector<std::vector<float> > &columns,
+                        double &error)
+{
+    const unsigned int n = width;
+
+    /*
+     * The right singular vectors of the kernel K are the eigenvectors of
+     * K^T K, which we find with the cyclic Jacobi method: the kernels are
+     * small, and it is robust with close or repeated eigenvalues.
+     */
+    std::vector<double> m(n * n, 0.0);
+    std::vector<double> v(n * n, 0.0);
+
+    for (unsigned int i = 0; i < n; i++) {
+        for (unsigned int j = 0; j < n; j++) {
+            for (unsigned int r = 0; r < height; r++)
+                m[i * n + j] += kernel[r * width + i] * kernel[r * width + j];
+        }
+        v[i * n + i] = 1.0;
+    }
+
+    for (unsigned int sweep = 0; sweep < 50; sweep++) {
+        double off = 0.0;
+        double total = 0.0;
+        for (unsigned int i = 0; i < n; i++) {
+            for (unsigned int j = 0; j < n; j++) {
+                total += m[i * n + j] * m[i * n + j];
+                if (i != j)
+                    off += m[i * n + j] * m[i * n + j];
+            }
+        }
+        if (off <= 1e-24 * total)
+            break;
+
+        for (unsigned int p = 0; p < n; p++) {
+            for (unsigned int q = p + 1; q < n; q++) {
+                double mpq = m[p * n + q];
+                if (mpq == 0.0)
+                    continue;
+
+                double theta = (m[q * n + q] - m[p * n + p]) / (2.0 * mpq);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) /
+                           (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+
+                for (unsigned int k = 0; k < n; k++) {
+                    double mkp = m[k * n + p];
+                    double mkq = m[k * n + q];
+                    m[k * n + p] = c * mkp - s * mkq;
+                    m[k * n + q] = s * mkp + c * mkq;
+                }
+                for (unsigned int k = 0; k < n; k++) {
+                    double mpk = m[p * n + k];
+                    double mqk = m[q * n + k];
+                    m[p * n + k] = c * mpk - s * mqk;
+                    m[q * n + k] = s * mpk + c * mqk;
+                }
+                for (unsigned int k = 0; k < n; k++) {
+                    double vkp = v[k * n + p];
+                    double vkq = v[k * n + q];
+                    v[k * n + p] = c * vkp - s * vkq;
+                    v[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    /* The singular values, largest first */
+    std::vector<std::pair<double, unsigned int> > sigma;
+    double sum_squares = 0.0;
+    for (unsigned int i = 0; i < n; i++) {
+        double s2 = std::max(m[i * n + i], 0.0);
+        sigma.push_back(std::make_pair(std::sqrt(s2), i));
+        sum_squares += s2;
+    }
+    std::sort(sigma.rbegin(), sigma.rend());
+
+    unsigned int rank = 0;
+    while (rank < n && sigma[rank].first > 1e-5 * sigma[0].first)
+        rank++;
+
+    rows.clear();
+    columns.clear();
+    double kept_squares = 0.0;
+
+    for (unsigned int t = 0; t < std::min(rank, max_terms); t++) {
+        unsigned int e = sigma[t].second;
+        std::vector<float> row(width);
+        std::vector<float> column(height, 0.0f);
+        double abs_sum = 0.0;
+        double sum = 0.0;
+
+        for (unsigned int i = 0; i < width; i++) {
+            abs_sum += std::fabs(v[i * n + e]);
+            sum += v[i * n + e];
+        }
+
+        /* Prefer positive row kernels, which encode better */
+        double scale = (sum < 0.0 ? -1.0 : 1.0) / abs_sum;
+
+        for (unsigned int i = 0; i < width; i++)
+            row[i] = v[i * n + e] * scale;
+
+        /* The column kernel is K v, which is the left singular vector times sigma */
+        for (unsigned int r = 0; r < height; r++) {
+            double c = 0.0;
+            for (unsigned int i = 0; i < width; i++)
+                c += kernel[r * width + i] * v[i * n + e];
+            column[r] = c / scale;
+        }
+
+        rows.push_back(row);
+        columns.push_back(column);
+        kept_squares += sigma[t].first * sigma[t].first;
+    }
+
+    error = sum_squares > 0.0 ?
+            std::sqrt(std::max(sum_squares - kept_squares, 0.0) / sum_squares) : 0.0;
+
+    return rank;
+}
+
+/**
+ * Creates the fragment shader of a row pass, which convolves Texture0 with
+ * a row kernel and encodes the result, which may be negative, into the
+ * [0, 1] range of the target.
+ */
+static std::string
+create_row_fragment_shader(const LibMatrix::vec2 &step,
+                           const std::vector<float> &row)
+{
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/effect-2d-separable.frag");
+    ShaderSource source(frg_shader_filename);
+
+    /* The range of the result, for inputs in [0, 1] */
+    float low = 0.0f;
+    float high = 0.0f;
+    for (std::vector<float>::const_iterator iter = row.begin();
+         iter != row.end();
+         iter++)
+    {
+        if (*iter < 0.0f)
+            low += *iter;
+        else
+            high += *iter;
+    }
+    float range = high > low ? high - low : 1.0f;
+
+    source.add_const("TextureStepX", step.x());
+    source.add_const("EncodeScale", 1.0f / range);
+    source.add_const("EncodeBias", -low / range);
+
+    std::stringstream ss_def;
+    std::stringstream ss_convolution;
+
+    ss_def << std::fixed;
+    ss_def << "uniform sampler2D Texture0;" << std::endl;
+    ss_convolution.precision(1);
+    ss_convolution << std::fixed;
+
+    ss_convolution << "result = (";
+
+    for (unsigned int i = 0; i < row.size(); i++) {
+        ss_def << "const float Kernel" << i << " = " << row[i] << ";" << std::endl;
+
+        LibMatrix::vec2 offset(calc_offset(i, row.size(), 1));
+        ss_convolution << "texture2D(Texture0, TextureCoord + vec2("
+                       << offset.x() << " * TextureStepX, 0.0)) * Kernel" << i;
+        if (i + 1 != row.size())
+            ss_convolution << " +" << std::endl;
+    }
+
+    ss_convolution << ") * EncodeScale + EncodeBias;" << std::endl;
+
+    source.add(ss_def.str());
+    source.replace("$CONVOLUTION$", ss_convolution.str());
+
+    return source.str();
+}
+
+/**
+ * Creates the fragment shader of the column pass, which decodes the targets
+ * of the row passes, convolves each with its column kernel and sums them.
+ */
+static std::string
+create_column_fragment_shader(const LibMatrix::vec2 &step,
+                              const std::vector<std::vector<float> > &rows,
+                              const std::vector<std::vector<float> > &columns)
+{
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/effect-2d-separable.frag");
+    ShaderSource source(frg_shader_filename);
+
+    source.add_const("TextureStepY", step.y());
+
+    std::stringstream ss_def;
+    std::stringstream ss_convolution;
+
+    ss_def << std::fixed;
+    ss_convolution.precision(1);
+    ss_convolution << std::fixed;
+
+    for (unsigned int t = 0; t < columns.size(); t++) {
+        const std::vector<float> &column(columns[t]);
+        float low = 0.0f;
+        float high = 0.0f;
+        float sum = 0.0f;
+
+        for (unsigned int i = 0; i < rows[t].size(); i++) {
+            if (rows[t][i] < 0.0f)
+                low += rows[t][i];
+            else
+                high += rows[t][i];
+        }
+        for (unsigned int r = 0; r < column.size(); r++)
+            sum += column[r];
+
+        /*
+         * The row pass stores (value - low) / range, so the sum of the
+         * decoded values is range * sum(encoded) + low * sum(kernel).
+         */
+        float range = high > low ? high - low : 1.0f;
+
+        ss_def << "uniform sampler2D Term" << t << ";" << std::endl;
+        ss_def << "const float Term" << t << "Scale = " << range << ";" << std::endl;
+        ss_def << "const float Term" << t << "Bias = " << low * sum << ";" << std::endl;
+
+        ss_convolution << "result += (";
+
+        for (unsigned int r = 0; r < column.size(); r++) {
+            ss_def << "const float Term" << t << "Kernel" << r << " = "
+                   << column[r] << ";" << std::endl;
+
+            LibMatrix::vec2 offset(calc_offset(r, 1, column.size()));
+            ss_convolution << "texture2D(Term" << t << ", TextureCoord + vec2(0.0, "
+                           << offset.y() << " * TextureStepY)) * Term" << t
+                           << "Kernel" << r;
+            if (r + 1 != column.size())
+                ss_convolution << " +" << std::endl;
+        }
+
+        ss_convolution << ") * Term" << t << "Scale + Term" << t << "Bias;"
+                       << std::endl;
+    }
+
+    source.add(ss_def.str());
+    source.replace("$CONVOLUTION$", ss_convolution.str());
+
+    return source.str();
+}
+
 bool
 SceneEffect2D::load()
 {
@@ -293,7 +567,7 @@ SceneEffect2D::load()
 void
 SceneEffect2D::unload()
 {
-    glDeleteTextures(1, &texture_);
+    Texture::release(1, &texture_);
 }
 
 bool
@@ -324,21 +598,83 @@ SceneEffect2D::setup()
                    kernel_printout(kernel, kernel_width).c_str());
     }
 
+    /*
+     * Decide whether to convolve in two passes per separable term, which
+     * takes width + height taps per term instead of width * height.
+     */
+    const std::string &separable(options_["separable"].value);
+    unsigned int max = Util::fromString<unsigned int>(options_["separable-terms"].value);
+    std::vector<std::vector<float> > rows;
+    std::vector<std::vector<float> > columns;
+    double error = 0.0;
+
+    if (max < 1 || max > max_terms) {
+        Log::error("effect2d: separable-terms must be between 1 and %u\n", max_terms);
+        return false;
+    }
+
+    if (kernel.size() != kernel_width * kernel_height) {
+        Log::error("Convolution filter size doesn't match supplied dimensions\n");
+        return false;
+    }
+
+    unsigned int rank = separate(kernel, kernel_width, kernel_height, max,
+                                 rows, columns, error);
+
+    terms_ = 0;
+    if (separable == "true" ||
+        (separable == "auto" && rank <= max &&
+         rows.size() * (kernel_width + kernel_height) < kernel.size()))
+    {
+        terms_ = rows.size();
+    }
+
+    /* A zero kernel has no terms, convolve with one of zeros */
+    if (separable == "true" && terms_ == 0) {
+        rows.assign(1, std::vector<float>(kernel_width, 0.0f));
+        columns.assign(1, std::vector<float>(kernel_height, 0.0f));
+        terms_ = 1;
+    }
+
+    if (terms_ > 0) {
+        Log::debug("Kernel of rank %u, convolving %u separable term(s) with %u"
+                   " taps instead of %u (relative error %f)\n",
+                   rank, terms_, terms_ * (kernel_width + kernel_height),
+                   static_cast<unsigned int>(kernel.size()),
+                   terms_ < rank ? error : 0.0);
+    }
+
+    if (terms_ > 0 && !GLExtensions::GenFramebuffers) {
+        Log::error("effect2d: separable kernels require GL framebuffer support\n");
+        return false;
+    }
+
     /* Create and load the shaders */
     ShaderSource vtx_source(vtx_shader_filename);
     ShaderSource frg_source;
-    frg_source.append(create_convolution_fragment_shader(canvas_, kernel,
-                                                         kernel_width,
-                                                         kernel_height));
+    LibMatrix::vec2 step(1.0f / canvas_.width(), 1.0f / canvas_.height());
+    std::vector<ProgramSource> programs;
+
+    if (terms_ > 0) {
+        frg_source.append(create_column_fragment_shader(step, rows, columns));
+        for (unsigned int t = 0; t < terms_; t++) {
+            programs.push_back(ProgramSource(row_programs_[t], vtx_source.str(),
+                                             create_row_fragment_shader(step, rows[t])));
+        }
+    }
+    else {
+        frg_source.append(create_convolution_fragment_shader(step, kernel,
+                                                             kernel_width,
+                                                             kernel_height));
+    }
 
     if (frg_source.str().empty())
         return false;
 
-    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
-                                          frg_source.str()))
-    {
+    programs.push_back(ProgramSource(program_, vtx_source.str(), frg_source.str()));
+
+    if (!Scene::load_programs(programs))
         return false;
-    }
 
     std::vector<int> vertex_format;
     vertex_format.push_back(3);
@@ -347,14 +683,55 @@ SceneEffect2D::setup()
     mesh_.make_grid(1, 1, 2.0, 2.0, 0.0);
     mesh_.build_vbo();
 
+    position_location_ = program_["position"].location();
+    mesh_position_location_ = position_location_;
+
     std::vector<GLint> attrib_locations;
-    attrib_locations.push_back(program_["position"].location());
+    attrib_locations.push_back(position_location_);
     mesh_.set_attrib_locations(attrib_locations);
 
+    /* The intermediate targets of the row passes */
+    for (unsigned int t = 0; t < terms_; t++) {
+        glGenTextures(1, &row_textures_[t]);
+        glBindTexture(GL_TEXTURE_2D, row_textures_[t]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, canvas_.width(), canvas_.height(),
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+        GLExtensions::GenFramebuffers(1, &row_fbos_[t]);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, row_fbos_[t]);
+        GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                           GL_TEXTURE_2D, row_textures_[t], 0);
+
+        GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            Log::error("effect2d: Failed to create the framebuffer of a row pass"
+                       " (status 0x%x)\n", status);
+            terms_ = t + 1;
+            return false;
+        }
+
+        row_programs_[t].start();
+        row_programs_[t]["Texture0"] = 0;
+        row_position_locations_[t] = row_programs_[t]["position"].location();
+        row_programs_[t].stop();
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+
     program_.start();
 
     // Load texture sampler value
-    program_["Texture0"] = 0;
+    if (terms_ > 0) {
+        for (unsigned int t = 0; t < terms_; t++)
+            program_["Term" + Util::toString(t)] = static_cast<int>(t);
+    }
+    else {
+        program_["Texture0"] = 0;
+    }
 
     currentFrame_ = 0;
     running_ = true;
@@ -372,6 +749,17 @@ SceneEffect2D::teardown()
     program_.stop();
     program_.release();
 
+    for (unsigned int t = 0; t < terms_; t++) {
+        row_programs_[t].release();
+        if (row_fbos_[t])
+            GLExtensions::DeleteFramebuffers(1, &row_fbos_[t]);
+        if (row_textures_[t])
+            glDeleteTextures(1, &row_textures_[t]);
+        row_fbos_[t] = 0;
+        row_textures_[t] = 0;
+    }
+    terms_ = 0;
+
     Scene::teardown();
 }
 
@@ -381,13 +769,52 @@ SceneEffect2D::update()
     Scene::update();
 }
 
+/*
+ * Renders the quad with a program, which may have put the position
+ * attribute at another location than the previous one.
+ */
+void
+SceneEffect2D::render_pass(Program &program, GLint position_location)
+{
+    program.start();
+
+    if (position_location != mesh_position_location_) {
+        mesh_.set_attrib_locations(std::vector<GLint>(1, position_location));
+        mesh_position_location_ = position_location;
+    }
+
+    mesh_.render_vbo();
+}
+
 void
 SceneEffect2D::draw()
 {
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture_);
 
-    mesh_.render_vbo();
+    if (terms_ == 0) {
+        mesh_.render_vbo();
+        return;
+    }
+
+    for (unsigned int t = 0; t < terms_; t++) {
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, row_fbos_[t]);
+        render_pass(row_programs_[t], row_position_locations_[t]);
+    }
+
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    for (unsigned int t = 0; t < terms_; t++) {
+        glActiveTexture(GL_TEXTURE0 + t);
+        glBindTexture(GL_TEXTURE_2D, row_textures_[t]);
+    }
+
+    render_pass(program_, position_location_);
+
+    for (unsigned int t = terms_; t-- > 0;) {
+        glActiveTexture(GL_TEXTURE0 + t);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
 }
 
 Scene::ValidationResult
@@ -439,3 +866,9 @@ SceneEffect2D::validate()
                 ref.to_le32(), pixel.to_le32(), dist);
     return Scene::ValidationFailure;
 }
+
+std::vector<std::string>
+SceneEffect2D::textures()
+{
+    return std::vector<std::string>(1, "effect-2d");
+}
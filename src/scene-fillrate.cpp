@@ -0,0 +1,439 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+
+struct SceneFillratePrivate {
+    enum Blend {
+        BlendNone,
+        BlendAlpha,
+        BlendAdditive
+    };
+
+    enum DepthTest {
+        DepthTestNone,
+        DepthTestBackToFront,
+        DepthTestFrontToBack
+    };
+
+    SceneFillratePrivate() :
+        layers(0), blend(BlendNone), depth_test(DepthTestNone), format(0),
+        samples(0), width(0), height(0), quad_buffer(0),
+        fbo(0), color_rb(0), depth_rb(0), resolve_fbo(0), resolve_rb(0) {}
+
+    unsigned int layers;
+    Blend blend;
+    DepthTest depth_test;
+    /* The offscreen color format, or 0 to draw to the canvas directly */
+    GLenum format;
+    unsigned int samples;
+    int width;
+    int height;
+
+    Program program;
+    GLuint quad_buffer;
+
+    /* The offscreen target, used for non-default formats and MSAA */
+    GLuint fbo;
+    GLuint color_rb;
+    GLuint depth_rb;
+    /* The single-sample copy that MSAA targets are resolved into */
+    GLuint resolve_fbo;
+    GLuint resolve_rb;
+
+    bool offscreen() const { return fbo != 0; }
+
+    void release()
+    {
+        if (resolve_fbo) {
+            GLExtensions::DeleteFramebuffers(1, &resolve_fbo);
+            resolve_fbo = 0;
+        }
+        if (resolve_rb) {
+            GLExtensions::DeleteRenderbuffers(1, &resolve_rb);
+            resolve_rb = 0;
+        }
+        if (fbo) {
+            GLExtensions::DeleteFramebuffers(1, &fbo);
+            fbo = 0;
+        }
+        if (color_rb) {
+            GLExtensions::DeleteRenderbuffers(1, &color_rb);
+            color_rb = 0;
+        }
+        if (depth_rb) {
+            GLExtensions::DeleteRenderbuffers(1, &depth_rb);
+            depth_rb = 0;
+        }
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+
+    /* Allocates the storage of the bound renderbuffer */
+    void renderbuffer_storage(GLenum internal_format)
+    {
+        if (samples > 0) {
+            GLExtensions::RenderbufferStorageMultisample(GL_RENDERBUFFER, samples,
+                                                         internal_format,
+                                                         width, height);
+        }
+        else {
+            GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, internal_format,
+                                              width, height);
+        }
+    }
+};
+
+SceneFillrate::SceneFillrate(Canvas &pCanvas) :
+    Scene(pCanvas, "fillrate")
+{
+    priv_ = new SceneFillratePrivate();
+    options_["layers"] = Scene::Option("layers", "16",
+                                       "The number of full-screen layers drawn every frame");
+    options_["blend"] = Scene::Option("blend", "none",
+                                      "The blending of each layer with the ones below it",
+                                      "none,alpha,additive");
+    options_["depth-test"] = Scene::Option("depth-test", "none",
+                                           "Whether to use a depth test, and the order the layers are drawn in",
+                                           "none,back-to-front,front-to-back");
+    options_["format"] = Scene::Option("format", "default",
+                                       "The color format of the render target",
+                                       "default,rgba8,rgb10a2,rgba16f");
+    options_["samples"] = Scene::Option("samples", "0",
+                                        "The number of MSAA samples of the render target (0 for no MSAA)");
+}
+
+SceneFillrate::~SceneFillrate()
+{
+    delete priv_;
+}
+
+bool
+SceneFillrate::supported(bool show_errors)
+{
+    unsigned int samples = Util::fromString<unsigned int>(options_["samples"].value);
+
+    if (samples > 0 &&
+        (GLExtensions::RenderbufferStorageMultisample == 0 ||
+         GLExtensions::BlitFramebuffer == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested MSAA but multisampled renderbuffers or"
+                       " framebuffer blits are not supported!\n");
+        }
+        return false;
+    }
+
+    if (options_["format"].value != "default" && GLExtensions::BlitFramebuffer == 0) {
+        if (show_errors) {
+            Log::error("Requested a color format but framebuffer blits"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneFillrate::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneFillrate::unload()
+{
+}
+
+bool
+SceneFillrate::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/fillrate.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/fillrate.frag");
+
+    SceneFillratePrivate &p(*priv_);
+
+    /* Parse the options */
+    p.layers = Util::fromString<unsigned int>(options_["layers"].value);
+    p.samples = Util::fromString<unsigned int>(options_["samples"].value);
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+
+    if (p.layers == 0) {
+        Log::error("The number of layers must be at least 1\n");
+        return false;
+    }
+
+    if (p.samples > 0) {
+        GLint max_samples = 0;
+        glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+        if (p.samples > static_cast<unsigned int>(max_samples)) {
+            Log::error("Invalid samples %u (maximum %d)\n", p.samples, max_samples);
+            return false;
+        }
+    }
+
+    const std::string &blend = options_["blend"].value;
+    if (blend == "alpha")
+        p.blend = SceneFillratePrivate::BlendAlpha;
+    else if (blend == "additive")
+        p.blend = SceneFillratePrivate::BlendAdditive;
+    else
+        p.blend = SceneFillratePrivate::BlendNone;
+
+    const std::string &depth_test = options_["depth-test"].value;
+    if (depth_test == "back-to-front")
+        p.depth_test = SceneFillratePrivate::DepthTestBackToFront;
+    else if (depth_test == "front-to-back")
+        p.depth_test = SceneFillratePrivate::DepthTestFrontToBack;
+    else
+        p.depth_test = SceneFillratePrivate::DepthTestNone;
+
+    const std::string &format = options_["format"].value;
+    if (format == "rgba8")
+        p.format = GL_RGBA8;
+    else if (format == "rgb10a2")
+        p.format = GL_RGB10_A2;
+    else if (format == "rgba16f")
+        p.format = GL_RGBA16F;
+    else if (p.samples > 0)
+        p.format = GL_RGBA8;
+    else
+        p.format = 0;
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    /* Create the full-screen quad, drawn as a triangle strip */
+    p.quad_buffer = FullscreenQuad::create();
+
+    /* Create the offscreen target, if the canvas can't be drawn to directly */
+    if (p.format != 0) {
+        GLExtensions::GenRenderbuffers(1, &p.color_rb);
+        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, p.color_rb);
+        p.renderbuffer_storage(p.format);
+
+        if (p.depth_test != SceneFillratePrivate::DepthTestNone) {
+            GLExtensions::GenRenderbuffers(1, &p.depth_rb);
+            GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, p.depth_rb);
+            p.renderbuffer_storage(p.samples > 0 ? GL_DEPTH_COMPONENT24 :
+                                                   GL_DEPTH_COMPONENT16);
+        }
+
+        GLExtensions::GenFramebuffers(1, &p.fbo);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+        GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                              GL_RENDERBUFFER, p.color_rb);
+        if (p.depth_rb) {
+            GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                                  GL_RENDERBUFFER, p.depth_rb);
+        }
+
+        GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+
+        if (status == GL_FRAMEBUFFER_COMPLETE && p.samples > 0) {
+            GLExtensions::GenRenderbuffers(1, &p.resolve_rb);
+            GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, p.resolve_rb);
+            GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, p.format,
+                                              p.width, p.height);
+
+            GLExtensions::GenFramebuffers(1, &p.resolve_fbo);
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.resolve_fbo);
+            GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                                  GL_RENDERBUFFER, p.resolve_rb);
+
+            status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+        }
+
+        GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, 0);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            Log::error("Failed to create a %s render target with %u samples"
+                       " (status 0x%x)\n", format.c_str(), p.samples, status);
+            return false;
+        }
+    }
+
+    /* Set up the fixed function state used for every layer */
+    if (p.blend == SceneFillratePrivate::BlendAlpha) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    }
+    else if (p.blend == SceneFillratePrivate::BlendAdditive) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+    }
+    else {
+        glDisable(GL_BLEND);
+    }
+
+    if (p.depth_test != SceneFillratePrivate::DepthTestNone) {
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+    }
+    else {
+        glDisable(GL_DEPTH_TEST);
+    }
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneFillrate::teardown()
+{
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneFillrate::update()
+{
+    Scene::update();
+}
+
+/*
+ * Draws the full-screen layers. With a depth test, each layer has its own
+ * depth, increasing from the first layer drawn for front-to-back and
+ * decreasing for back-to-front, so that the former lets early depth
+ * testing reject every layer but the first.
+ */
+void
+SceneFillrate::draw()
+{
+    SceneFillratePrivate &p(*priv_);
+
+    /* The canvas is cleared by the main loop, the offscreen target isn't */
+    if (p.offscreen()) {
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+        glViewport(0, 0, p.width, p.height);
+
+        if (p.depth_test != SceneFillratePrivate::DepthTestNone)
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        else
+            glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    GLint position_location = p.program["position"].location();
+    GLint depth_location = p.program["Depth"].location();
+    GLint color_location = p.program["LayerColor"].location();
+
+    p.program.start();
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    /* Keep the layers translucent, so that blending shows all of them */
+    float alpha = p.blend == SceneFillratePrivate::BlendNone ? 1.0f : 0.25f;
+    float scale = p.blend == SceneFillratePrivate::BlendAdditive ?
+                  1.0f / p.layers : 1.0f;
+
+    for (unsigned int i = 0; i < p.layers; i++) {
+        unsigned int depth_index =
+            p.depth_test == SceneFillratePrivate::DepthTestFrontToBack ?
+            i + 1 : p.layers - i;
+        float hue = static_cast<float>(i) / p.layers;
+
+        glUniform1f(depth_location, -1.0f + 2.0f * depth_index / (p.layers + 1));
+        glUniform4f(color_location,
+                    scale * (0.5f + 0.5f * std::cos(6.2832f * hue)),
+                    scale * (0.5f + 0.5f * std::cos(6.2832f * (hue + 0.33f))),
+                    scale * (0.5f + 0.5f * std::cos(6.2832f * (hue + 0.67f))),
+                    alpha);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    /* Show the result on the canvas, resolving the samples first with MSAA */
+    if (p.offscreen()) {
+        GLuint source = p.fbo;
+
+        if (p.resolve_fbo) {
+            GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, p.fbo);
+            GLExtensions::BindFramebuffer(GL_DRAW_FRAMEBUFFER, p.resolve_fbo);
+            GLExtensions::BlitFramebuffer(0, 0, p.width, p.height,
+                                          0, 0, p.width, p.height,
+                                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            source = p.resolve_fbo;
+        }
+
+        GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, source);
+        GLExtensions::BindFramebuffer(GL_DRAW_FRAMEBUFFER, canvas_.fbo());
+        GLExtensions::BlitFramebuffer(0, 0, p.width, p.height,
+                                      0, 0, canvas_.width(), canvas_.height(),
+                                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+    }
+}
+
+Scene::ValidationResult
+SceneFillrate::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneFillrate::rates()
+{
+    double elapsed = elapsed_time();
+    double pixels = static_cast<double>(priv_->layers) *
+                    priv_->width * priv_->height * frame_count();
+
+    return std::vector<Rate>(1, Rate("GigapixelsPerSecond", "gigapixels_per_second",
+                                     elapsed > 0.0 ? pixels / elapsed / 1e9 : 0.0));
+}
@@ -62,6 +62,12 @@ SceneFunction::~SceneFunction()
 static std::string
 get_vertex_shader_source(int steps, bool function, std::string &complexity)
 {
+    /* Large step counts are expensive to generate, so only do it once */
+    const std::string key(vtx_file + ":" + Util::toString(steps) + (function ? ":function:" : ":") + complexity);
+    std::string str;
+    if (ShaderSource::find_generated(key, str))
+        return str;
+
     ShaderSource source(Options::data_path + vtx_file);
     ShaderSource source_main;
     std::string step_file;
@@ -85,12 +91,21 @@ get_vertex_shader_source(int steps, bool function, std::string &complexity)
 
     source.replace("$MAIN$", source_main.str());
 
-    return source.str();
+    str = source.str();
+    ShaderSource::store_generated(key, str);
+
+    return str;
 }
 
 static std::string
 get_fragment_shader_source(int steps, bool function, std::string &complexity)
 {
+    /* Large step counts are expensive to generate, so only do it once */
+    const std::string key(frg_file + ":" + Util::toString(steps) + (function ? ":function:" : ":") + complexity);
+    std::string str;
+    if (ShaderSource::find_generated(key, str))
+        return str;
+
     ShaderSource source(Options::data_path + frg_file);
     ShaderSource source_main;
     std::string step_file;
@@ -114,7 +129,10 @@ get_fragment_shader_source(int steps, bool function, std::string &complexity)
 
     source.replace("$MAIN$", source_main.str());
 
-    return source.str();
+    str = source.str();
+    ShaderSource::store_generated(key, str);
+
+    return str;
 }
 
 bool
@@ -132,8 +150,8 @@ SceneFunction::setup()
     int frg_steps = Util::fromString<int>(options_["fragment-steps"].value);
 
     /* Load shaders */
-    std::string vtx_shader(get_vertex_shader_source(vtx_steps, vtx_function,
-                                                    vtx_complexity));
+    std::string vtx_shader(prepare_vertex_shader(
+        get_vertex_shader_source(vtx_steps, vtx_function, vtx_complexity)));
     std::string frg_shader(get_fragment_shader_source(frg_steps, frg_function,
                                                       frg_complexity));
 
@@ -25,20 +25,88 @@
 #include "vec.h"
 #include "log.h"
 #include "util.h"
+#include "gl-headers.h"
 
 SceneGrid::SceneGrid(Canvas &pCanvas, const std::string &name) :
-    Scene(pCanvas, name)
+    Scene(pCanvas, name), instanced_(false), instances_(0), instance_vbo_(0)
 {
     options_["grid-size"] = Scene::Option("grid-size", "32",
             "The number of squares per side of the grid (controls the number of vertices)");
     options_["grid-length"] = Scene::Option("grid-length", "5.0",
             "The length of each side of the grid (normalized) (controls the area drawn to)");
+    options_["instanced"] = Scene::Option("instanced", "false",
+            "Whether to draw each grid square as an instance of a single square mesh",
+            "false,true");
+    options_["topology"] = Scene::Option("topology", "triangles",
+            "How the grid squares are drawn: as 2 triangles of 6 vertices, or from their"
+            " 4 corners as indexed triangles or as strips with primitive restart",
+            "triangles,indexed,strips");
 }
 
 SceneGrid::~SceneGrid()
 {
 }
 
+bool
+SceneGrid::supported(bool show_errors)
+{
+    if (options_["instanced"].value == "true" &&
+        (GLExtensions::DrawArraysInstanced == 0 ||
+         GLExtensions::VertexAttribDivisor == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested instanced rendering but instanced arrays"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    if (options_["topology"].value == "strips" && !Mesh::primitive_restart_supported()) {
+        if (show_errors) {
+            Log::error("Requested grid strips but primitive restart"
+                       " is not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+static void
+replace_all(std::string &str, const std::string &remove, const std::string &insert)
+{
+    std::string::size_type pos = 0;
+
+    while ((pos = str.find(remove, pos)) != std::string::npos) {
+        str.replace(pos, remove.size(), insert);
+        pos += insert.size();
+    }
+}
+
+/*
+ * Adapts a grid vertex shader to instanced rendering.
+ *
+ * The position attribute then holds the vertex position in the single cell
+ * mesh, so it is renamed and the per-instance offset is added to it to get
+ * the vertex position in the full grid the rest of the shader expects.
+ */
+std::string
+SceneGrid::prepare_vertex_shader(const std::string &source)
+{
+    if (!instanced_)
+        return source;
+
+    std::string str(source);
+
+    replace_all(str, "position", "grid_position");
+    replace_all(str, "attribute vec3 grid_position;",
+                "attribute vec3 position;\nattribute vec3 instance_offset;");
+    replace_all(str, "void main(void)\n{",
+                "void main(void)\n{\n    vec3 grid_position = position + instance_offset;\n");
+
+    return str;
+}
+
 bool
 SceneGrid::load()
 {
@@ -73,10 +141,46 @@ SceneGrid::setup()
      */
     double spacing = grid_length * (1 - 4.38 / 5.0) / (grid_size - 1.0);
 
-    mesh_.make_grid(grid_size, grid_size, grid_length, grid_length,
-                    grid_size > 1 ? spacing : 0);
+    if (grid_size <= 1)
+        spacing = 0;
+
+    instanced_ = options_["instanced"].value == "true";
+
+    if (instanced_) {
+        double side = (grid_length - (grid_size - 1) * spacing) / grid_size;
+        double step = side + spacing;
+
+        /* The offsets from a square centered at the origin to each grid square */
+        std::vector<float> offsets;
+        for (int i = 0; i < grid_size; i++) {
+            for (int j = 0; j < grid_size; j++) {
+                offsets.push_back((side - grid_length) / 2 + i * step);
+                offsets.push_back((grid_length - side) / 2 - j * step);
+                offsets.push_back(0.0f);
+            }
+        }
+
+        glGenBuffers(1, &instance_vbo_);
+        glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+        glBufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(float),
+                     &offsets[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        instances_ = grid_size * grid_size;
+        mesh_.make_grid(1, 1, side, side, 0);
+    }
+    else {
+        mesh_.make_grid(grid_size, grid_size, grid_length, grid_length, spacing,
+                        0, Mesh::grid_topology_from_str(options_["topology"].value));
+    }
+
     mesh_.build_vbo();
 
+    Log::debug("%s: %u vertices, %u indices of %u bytes\n", name_.c_str(),
+               static_cast<unsigned int>(mesh_.vertex_count()),
+               static_cast<unsigned int>(mesh_.index_count()),
+               static_cast<unsigned int>(mesh_.index_size()));
+
     currentFrame_ = 0;
     rotation_ = 0.0f;
 
@@ -90,6 +194,11 @@ SceneGrid::teardown()
     program_.release();
     mesh_.reset();
 
+    if (instance_vbo_) {
+        glDeleteBuffers(1, &instance_vbo_);
+        instance_vbo_ = 0;
+    }
+
     Scene::teardown();
 }
 
@@ -98,7 +207,7 @@ SceneGrid::update()
 {
     Scene::update();
 
-    double elapsed_time = lastUpdateTime_ - startTime_;
+    double elapsed_time = animation_time();
 
     rotation_ = rotationSpeed_ * elapsed_time;
 }
@@ -116,7 +225,22 @@ SceneGrid::draw()
 
     program_["ModelViewProjectionMatrix"] = model_view_proj;
 
-    mesh_.render_vbo();
+    if (!instanced_) {
+        mesh_.render_vbo();
+        return;
+    }
+
+    GLint offset_location = program_["instance_offset"].location();
+
+    glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+    glEnableVertexAttribArray(offset_location);
+    glVertexAttribPointer(offset_location, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    GLExtensions::VertexAttribDivisor(offset_location, 1);
+
+    mesh_.render_vbo_instanced(instances_);
+
+    GLExtensions::VertexAttribDivisor(offset_location, 0);
+    glDisableVertexAttribArray(offset_location);
 }
 
 Scene::ValidationResult
@@ -28,7 +28,7 @@
 #include "lamp.h"
 #include "util.h"
 #include "log.h"
-#include <sys/time.h>
+#include "options.h"
 
 using LibMatrix::Stack4;
 using LibMatrix::mat4;
@@ -45,18 +45,19 @@ public:
         valid_(false),
         currentSpeed_(1.0), // Real time.
         currentTime_(START_TIME_),
-        timeOffset_(START_TIME_)
+        timeOffset_(START_TIME_),
+        drawTime_(START_TIME_)
     {
-        startTime_.tv_sec = 0;
-        startTime_.tv_nsec = 0; 
     }
     ~SceneIdeasPrivate()
     {
     }
     void initialize(map<string, Scene::Option>& options);
     void reset_time();
-    void update_time();
+    void update_time(double elapsed);
     void update_projection(const mat4& proj);
+    void prepare();
+    void apply();
     void draw();
     bool valid() { return valid_; }
 
@@ -69,7 +70,6 @@ private:
     float currentSpeed_;
     float currentTime_;
     float timeOffset_;
-    struct timespec startTime_;
     static const float CYCLE_TIME_;
     static const float TIME_;
     static const float START_TIME_;
@@ -83,18 +83,31 @@ private:
     static const vec4 light0_position_;
     static const vec4 light1_position_;
     static const vec4 light2_position_;
-    // Object constants
-    ViewFromSpline viewFromSpline_;
-    ViewToSpline viewToSpline_;
-    LightPositionSpline lightPosSpline_;
-    LogoPositionSpline logoPosSpline_;
-    LogoRotationSpline logoRotSpline_;
+    // Object constants, with the spline coefficients computed once per process
+    static const ViewFromSpline viewFromSpline_;
+    static const ViewToSpline viewToSpline_;
+    static const LightPositionSpline lightPosSpline_;
+    static const LogoPositionSpline logoPosSpline_;
+    static const LogoRotationSpline logoRotSpline_;
     vec3 viewFrom_;
     vec3 viewTo_;
     vec3 lightPos_;
     vec3 logoPos_;
     vec3 logoRot_;
     vec4 lightPositions_[3];
+    // The state computed by prepare(), used once applied
+    struct State
+    {
+        State() : time(0.0) {}
+        float time;
+        vec3 viewFrom;
+        vec3 viewTo;
+        vec3 lightPos;
+        vec3 logoPos;
+        vec3 logoRot;
+    };
+    State next_;
+    float drawTime_;
 };
 
 const float SceneIdeasPrivate::TIME_(15.0);
@@ -103,6 +116,11 @@ const float SceneIdeasPrivate::START_TIME_(0.6);
 const vec4 SceneIdeasPrivate::light0_position_(0.0, 1.0, 0.0, 0.0);
 const vec4 SceneIdeasPrivate::light1_position_(-1.0, 0.0, 0.0, 0.0);
 const vec4 SceneIdeasPrivate::light2_position_(0.0, -1.0, 0.0, 0.0);
+const ViewFromSpline SceneIdeasPrivate::viewFromSpline_;
+const ViewToSpline SceneIdeasPrivate::viewToSpline_;
+const LightPositionSpline SceneIdeasPrivate::lightPosSpline_;
+const LogoPositionSpline SceneIdeasPrivate::logoPosSpline_;
+const LogoRotationSpline SceneIdeasPrivate::logoRotSpline_;
 
 void
 SceneIdeasPrivate::initLights()
@@ -117,9 +135,11 @@ void
 SceneIdeasPrivate::initialize(map<string, Scene::Option>& options)
 {
     // Initialize the positions for the lights we'll use.
+    modelview_.loadIdentity();
     initLights();
 
-    // Tell the objects in the scene to initialize themselves.
+    // Tell the objects in the scene to initialize themselves. They are
+    // only initialized once, so this is cheap when they are reused.
     table_.init();
     if (!table_.valid())
     {
@@ -163,18 +183,13 @@ void
 SceneIdeasPrivate::reset_time()
 {
     timeOffset_ = START_TIME_;
-    clock_gettime(CLOCK_MONOTONIC, &startTime_);
 }
 
 void
-SceneIdeasPrivate::update_time()
+SceneIdeasPrivate::update_time(double elapsed)
 {
     // Compute new time
-    struct timespec current = {0, 0};
-    clock_gettime(CLOCK_MONOTONIC, &current);
-    float timediff = (current.tv_sec - startTime_.tv_sec) + 
-        static_cast<double>(current.tv_nsec - startTime_.tv_nsec) / 1000000000.0;
-    float sceneTime = timediff * currentSpeed_ + timeOffset_;
+    float sceneTime = elapsed * currentSpeed_ + timeOffset_;
 
     // Keep the current time in [START_TIME_..CYCLE_TIME_)
     // Every other cycle starting with 0 start at the beginning and goes
@@ -230,12 +245,17 @@ SceneIdeas::setup()
     if (!Scene::setup())
         return false;
 
-    priv_ = new SceneIdeasPrivate();
+    // The objects kept by the last teardown() still have their programs,
+    // buffers and textures
+    if (!priv_)
+        priv_ = new SceneIdeasPrivate();
     priv_->initialize(options_);
     if (!priv_->valid())
         return false;
 
     priv_->update_projection(canvas_.projection());
+    priv_->prepare();
+    priv_->apply();
 
     // Core Scene state
     currentFrame_ = 0;
@@ -250,19 +270,49 @@ void
 SceneIdeas::update()
 {
     Scene::update();
-    priv_->update_time();
+    priv_->update_time(animation_time());
     priv_->update_projection(canvas_.projection());
+    // When pipelined, the splines were evaluated during the last frame
+    if (!pipelined_)
+        priv_->prepare();
+    priv_->apply();
 }
 
 void
-SceneIdeasPrivate::draw()
+SceneIdeas::prepare()
 {
-    viewFromSpline_.getCurrentVec(currentTime_, viewFrom_);
-    viewToSpline_.getCurrentVec(currentTime_, viewTo_);
-    lightPosSpline_.getCurrentVec(currentTime_, lightPos_);
-    logoPosSpline_.getCurrentVec(currentTime_, logoPos_);
-    logoRotSpline_.getCurrentVec(currentTime_, logoRot_);
+    priv_->prepare();
+}
 
+//
+// Evaluates the splines at the current time. This only touches next_, so
+// that it can run while the previous state is drawn.
+//
+void
+SceneIdeasPrivate::prepare()
+{
+    next_.time = currentTime_;
+    viewFromSpline_.getCurrentVec(currentTime_, next_.viewFrom);
+    viewToSpline_.getCurrentVec(currentTime_, next_.viewTo);
+    lightPosSpline_.getCurrentVec(currentTime_, next_.lightPos);
+    logoPosSpline_.getCurrentVec(currentTime_, next_.logoPos);
+    logoRotSpline_.getCurrentVec(currentTime_, next_.logoRot);
+}
+
+void
+SceneIdeasPrivate::apply()
+{
+    drawTime_ = next_.time;
+    viewFrom_ = next_.viewFrom;
+    viewTo_ = next_.viewTo;
+    lightPos_ = next_.lightPos;
+    logoPos_ = next_.logoPos;
+    logoRot_ = next_.logoRot;
+}
+
+void
+SceneIdeasPrivate::draw()
+{
     // Tell the logo its new position
     logo_.setPosition(logoPos_);
 
@@ -279,7 +329,7 @@ SceneIdeasPrivate::draw()
     float pca(0.0);
     if (viewFrom_.y() > 0.0)
     {
-        table_.draw(modelview_, projection_, lightPos_, logoPos_, currentTime_, pca);
+        table_.draw(modelview_, projection_, lightPos_, logoPos_, drawTime_, pca);
     }
 
     glEnable(GL_CULL_FACE); 
@@ -408,7 +458,11 @@ SceneIdeas::validate()
 void
 SceneIdeas::teardown()
 {
-    delete priv_;
-    priv_ = 0;
+    // With --reuse-context, the GL resources of the objects stay valid for
+    // later runs, so keep them instead of rebuilding them on every setup
+    if (priv_ && (!Options::reuse_context || !priv_->valid())) {
+        delete priv_;
+        priv_ = 0;
+    }
     Scene::teardown();
 }
@@ -175,22 +175,24 @@ Lamp::init()
     string lit_frg_filename(Options::data_path + "/shaders/ideas-lamp-lit.frag");
     ShaderSource lit_vtx_source(lit_vtx_filename);
     ShaderSource lit_frg_source(lit_frg_filename);
-    if (!Scene::load_shaders_from_strings(litProgram_, lit_vtx_source.str(),
-                                          lit_frg_source.str()))
-    {
-        Log::error("No valid program for lit lamp rendering\n");
-        return;
-    }
 
     // The simple program with no lighting...
     string unlit_vtx_filename(Options::data_path + "/shaders/ideas-lamp-unlit.vert");
     string unlit_frg_filename(Options::data_path + "/shaders/ideas-lamp-unlit.frag");
     ShaderSource unlit_vtx_source(unlit_vtx_filename);
     ShaderSource unlit_frg_source(unlit_frg_filename);
-    if (!Scene::load_shaders_from_strings(unlitProgram_, unlit_vtx_source.str(),
-                                          unlit_frg_source.str()))
+
+    // Build both programs at once, so they can be compiled in parallel.
+    std::vector<Scene::ProgramSource> programs;
+    programs.push_back(Scene::ProgramSource(litProgram_, lit_vtx_source.str(),
+                                            lit_frg_source.str(),
+                                            lit_vtx_filename, lit_frg_filename));
+    programs.push_back(Scene::ProgramSource(unlitProgram_, unlit_vtx_source.str(),
+                                            unlit_frg_source.str(),
+                                            unlit_vtx_filename, unlit_frg_filename));
+    if (!Scene::load_programs(programs))
     {
-        Log::error("No valid program for unlit lamp rendering.\n");
+        Log::error("No valid programs for lamp rendering.\n");
         return;
     }
 
@@ -391,18 +391,6 @@ SGILogo::SGILogo(void) :
         }
     }
 
-    // Initialize the stipple pattern
-    static const unsigned int patterns[] = { 0xaaaaaaaa, 0x55555555 };
-    for (unsigned int i = 0; i < textureResolution_; i++)
-    {
-        for (unsigned int j = 0; j < textureResolution_; j++)
-        {
-            // Alternate the pattern every other line.
-            unsigned int curMask(1 << j);
-            unsigned int curPattern(patterns[i % 2]);
-            textureImage_[i][j] = ((curPattern & curMask) >> j) * 255;
-        }
-    }
 }
 
 SGILogo::~SGILogo()
@@ -410,9 +398,36 @@ SGILogo::~SGILogo()
     if (valid_)
     {
         glDeleteBuffers(2, &bufferObjects_[0]);
+        glDeleteTextures(1, &textureName_);
     }
 }
 
+// The stipple pattern of the shadow, generated once per process.
+const GLubyte*
+SGILogo::stippleImage()
+{
+    static GLubyte image[32][32];
+    static bool generated(false);
+
+    if (!generated)
+    {
+        static const unsigned int patterns[] = { 0xaaaaaaaa, 0x55555555 };
+        for (unsigned int i = 0; i < textureResolution_; i++)
+        {
+            for (unsigned int j = 0; j < textureResolution_; j++)
+            {
+                // Alternate the pattern every other line.
+                unsigned int curMask(1 << j);
+                unsigned int curPattern(patterns[i % 2]);
+                image[i][j] = ((curPattern & curMask) >> j) * 255;
+            }
+        }
+        generated = true;
+    }
+
+    return &image[0][0];
+}
+
 void
 SGILogo::init()
 {
@@ -428,39 +443,38 @@ SGILogo::init()
     string logo_frg_filename(Options::data_path + "/shaders/ideas-logo.frag");
     ShaderSource logo_vtx_source(logo_vtx_filename);
     ShaderSource logo_frg_source(logo_frg_filename);
-    if (!Scene::load_shaders_from_strings(normalProgram_, logo_vtx_source.str(),
-                                          logo_frg_source.str()))
-    {
-        Log::error("No valid program for normal logo rendering\n");
-        return;
-    }
-    normalVertexIndex_ = normalProgram_[vertexAttribName_].location();
-    normalNormalIndex_ = normalProgram_[normalAttribName_].location();
 
     // The program for handling the flat object...
     string logo_flat_vtx_filename(Options::data_path + "/shaders/ideas-logo-flat.vert");
     string logo_flat_frg_filename(Options::data_path + "/shaders/ideas-logo-flat.frag");
     ShaderSource logo_flat_vtx_source(logo_flat_vtx_filename);
     ShaderSource logo_flat_frg_source(logo_flat_frg_filename);
-    if (!Scene::load_shaders_from_strings(flatProgram_, logo_flat_vtx_source.str(),
-                                          logo_flat_frg_source.str()))
-    {
-        Log::error("No valid program for flat logo rendering\n");
-        return;
-    }
-    flatVertexIndex_ = flatProgram_[vertexAttribName_].location();
 
     // The program for handling the shadow object with texturing...
     string logo_shadow_vtx_filename(Options::data_path + "/shaders/ideas-logo-shadow.vert");
     string logo_shadow_frg_filename(Options::data_path + "/shaders/ideas-logo-shadow.frag");
     ShaderSource logo_shadow_vtx_source(logo_shadow_vtx_filename);
     ShaderSource logo_shadow_frg_source(logo_shadow_frg_filename);
-    if (!Scene::load_shaders_from_strings(shadowProgram_, logo_shadow_vtx_source.str(),
-                                          logo_shadow_frg_source.str()))
+
+    // Build all of the programs at once, so they can be compiled in parallel.
+    std::vector<Scene::ProgramSource> programs;
+    programs.push_back(Scene::ProgramSource(normalProgram_, logo_vtx_source.str(),
+                                            logo_frg_source.str(),
+                                            logo_vtx_filename, logo_frg_filename));
+    programs.push_back(Scene::ProgramSource(flatProgram_, logo_flat_vtx_source.str(),
+                                            logo_flat_frg_source.str(),
+                                            logo_flat_vtx_filename, logo_flat_frg_filename));
+    programs.push_back(Scene::ProgramSource(shadowProgram_, logo_shadow_vtx_source.str(),
+                                            logo_shadow_frg_source.str(),
+                                            logo_shadow_vtx_filename, logo_shadow_frg_filename));
+    if (!Scene::load_programs(programs))
     {
-        Log::error("No valid program for shadow logo rendering\n");
+        Log::error("No valid programs for logo rendering\n");
         return;
     }
+    normalVertexIndex_ = normalProgram_[vertexAttribName_].location();
+    normalNormalIndex_ = normalProgram_[normalAttribName_].location();
+    flatVertexIndex_ = flatProgram_[vertexAttribName_].location();
     shadowVertexIndex_ = shadowProgram_[vertexAttribName_].location();
 
     // We need 2 buffers for our work here.  One for the vertex data.
@@ -500,7 +514,7 @@ SGILogo::init()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA,
                  textureResolution_, textureResolution_,
-                 0, GL_ALPHA, GL_UNSIGNED_BYTE, textureImage_);
+                 0, GL_ALPHA, GL_UNSIGNED_BYTE, stippleImage());
 
     // We're ready to go.
     valid_ = true;
@@ -115,8 +115,8 @@ private:
     static const std::string normalAttribName_;
     static const std::string normalMatrixName_;
     // "Shadow" state
+    static const GLubyte* stippleImage();
     GLuint textureName_;
-    GLubyte textureImage_[32][32];
     // This is the size in each direction of our texture image
     static const unsigned int textureResolution_;
     bool valid_;
@@ -79,20 +79,12 @@ Spline::calcParams()
 void
 Spline::getCurrentVec(float currentTime, vec3& v) const
 {
+    // The segment coefficients are a lookup table, so evaluating a point
+    // is only a Horner step per component.
     unsigned int integerTime(static_cast<unsigned int>(currentTime));
     float t(currentTime - static_cast<float>(integerTime));
-    v.x(paramData_[integerTime][3].x() +
-	paramData_[integerTime][2].x() * t +
-	paramData_[integerTime][1].x() * t * t +
-	paramData_[integerTime][0].x() * t * t * t);
-    v.y(paramData_[integerTime][3].y() +
-	paramData_[integerTime][2].y() * t +
-	paramData_[integerTime][1].y() * t * t +
-	paramData_[integerTime][0].y() * t * t * t);
-    v.z(paramData_[integerTime][3].z() +
-	paramData_[integerTime][2].z() * t +
-	paramData_[integerTime][1].z() * t * t +
-	paramData_[integerTime][0].z() * t * t * t);
+    const param& p(paramData_[integerTime]);
+    v = p[3] + (p[2] + (p[1] + p[0] * t) * t) * t;
 }
 
 ViewFromSpline::ViewFromSpline()
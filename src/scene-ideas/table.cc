@@ -106,51 +106,47 @@ Table::init(void)
     string table_frg_filename(Options::data_path + "/shaders/ideas-table.frag");
     ShaderSource table_vtx_source(table_vtx_filename);
     ShaderSource table_frg_source(table_frg_filename);
-    if (!Scene::load_shaders_from_strings(tableProgram_, table_vtx_source.str(),
-                                          table_frg_source.str()))
-    {
-        Log::error("No valid program for table rendering.\n");
-        return;
-    }
-    tableVertexIndex_ = tableProgram_[vertexAttribName_].location();
 
     // Program to render the paper with lighting and a time-based fade...
     string paper_vtx_filename(Options::data_path + "/shaders/ideas-paper.vert");
     string paper_frg_filename(Options::data_path + "/shaders/ideas-paper.frag");
     ShaderSource paper_vtx_source(paper_vtx_filename);
     ShaderSource paper_frg_source(paper_frg_filename);
-    if (!Scene::load_shaders_from_strings(paperProgram_, paper_vtx_source.str(),
-                                          paper_frg_source.str()))
-    {
-        Log::error("No valid program for paper rendering.\n");
-        return;
-    }
-    paperVertexIndex_ = paperProgram_[vertexAttribName_].location();
 
     // Program to handle the text (time-based color fade)...
     string text_vtx_filename(Options::data_path + "/shaders/ideas-text.vert");
     string text_frg_filename(Options::data_path + "/shaders/ideas-text.frag");
     ShaderSource text_vtx_source(text_vtx_filename);
     ShaderSource text_frg_source(text_frg_filename);
-    if (!Scene::load_shaders_from_strings(textProgram_, text_vtx_source.str(),
-                                          text_frg_source.str()))
-    {
-        Log::error("No valid program for text rendering.\n");
-        return;
-    }
-    textVertexIndex_ = textProgram_[vertexAttribName_].location();
 
     // Program for the drawUnder functionality (just paint it black)...
     string under_table_vtx_filename(Options::data_path + "/shaders/ideas-under-table.vert");
     string under_table_frg_filename(Options::data_path + "/shaders/ideas-under-table.frag");
     ShaderSource under_table_vtx_source(under_table_vtx_filename);
     ShaderSource under_table_frg_source(under_table_frg_filename);
-    if (!Scene::load_shaders_from_strings(underProgram_, under_table_vtx_source.str(),
-                                          under_table_frg_source.str()))
+
+    // Build all of the programs at once, so they can be compiled in parallel.
+    std::vector<Scene::ProgramSource> programs;
+    programs.push_back(Scene::ProgramSource(tableProgram_, table_vtx_source.str(),
+                                            table_frg_source.str(),
+                                            table_vtx_filename, table_frg_filename));
+    programs.push_back(Scene::ProgramSource(paperProgram_, paper_vtx_source.str(),
+                                            paper_frg_source.str(),
+                                            paper_vtx_filename, paper_frg_filename));
+    programs.push_back(Scene::ProgramSource(textProgram_, text_vtx_source.str(),
+                                            text_frg_source.str(),
+                                            text_vtx_filename, text_frg_filename));
+    programs.push_back(Scene::ProgramSource(underProgram_, under_table_vtx_source.str(),
+                                            under_table_frg_source.str(),
+                                            under_table_vtx_filename, under_table_frg_filename));
+    if (!Scene::load_programs(programs))
     {
-        Log::error("No valid program for under table rendering.\n");
+        Log::error("No valid programs for table rendering.\n");
         return;
     }
+    tableVertexIndex_ = tableProgram_[vertexAttribName_].location();
+    paperVertexIndex_ = paperProgram_[vertexAttribName_].location();
+    textVertexIndex_ = textProgram_[vertexAttribName_].location();
     underVertexIndex_ = underProgram_[vertexAttribName_].location();
 
     // Tell all of the characters to initialize themselves...
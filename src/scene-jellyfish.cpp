@@ -24,6 +24,9 @@
 #include <fstream>
 #include <memory>
 #include <iomanip>
+#include <thread>
+#include <cmath>
+#include <algorithm>
 #include "options.h"
 #include "scene.h"
 #include "scene-jellyfish.h"
@@ -35,7 +38,17 @@
 SceneJellyfish::SceneJellyfish(Canvas& canvas) :
     Scene(canvas, "jellyfish"), priv_(0)
 {
-
+    options_["caustics"] = Scene::Option("caustics", "textures",
+                                         "How the caustic animation frames are stored: "
+                                         "a texture for each frame, or the layers of an array texture",
+                                         "textures,array");
+    options_["count"] = Scene::Option("count", "1",
+                                      "The number of jellyfish, drawn with a single instanced draw call"
+                                      " if more than one");
+    options_["background"] = Scene::Option("background", "true",
+                                           "Whether to draw the background gradient, or the jellyfish"
+                                           " over what is already drawn",
+                                           "false,true");
 }
 
 SceneJellyfish::~SceneJellyfish()
@@ -43,6 +56,32 @@ SceneJellyfish::~SceneJellyfish()
     delete priv_;
 }
 
+bool
+SceneJellyfish::supported(bool show_errors)
+{
+    if (options_["caustics"].value == "array" &&
+        (!GLExtensions::TexImage3D || !GLExtensions::TexSubImage3D))
+    {
+        if (show_errors) {
+            Log::error("SceneJellyfish caustics=array requires array texture"
+                       " support (GL 3.0 or GLES 3.0)\n");
+        }
+        return false;
+    }
+
+    if (Util::fromString<unsigned int>(options_["count"].value) > 1 &&
+        (!GLExtensions::DrawElementsInstanced || !GLExtensions::VertexAttribDivisor))
+    {
+        if (show_errors) {
+            Log::error("SceneJellyfish count > 1 requires instanced arrays"
+                       " support\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
 bool
 SceneJellyfish::load()
 {
@@ -63,7 +102,9 @@ SceneJellyfish::setup()
 
     // Set up our private object that does all of the lifting
     priv_ = new JellyfishPrivate();
-    if (!priv_->initialize())
+    unsigned int count = std::max(Util::fromString<unsigned int>(options_["count"].value), 1U);
+    if (!priv_->initialize(options_["caustics"].value == "array", count,
+                           options_["background"].value == "true"))
         return false;
 
     // Set core scene timing after actual initialization so we don't measure
@@ -87,7 +128,7 @@ SceneJellyfish::update()
 {
     Scene::update();
     priv_->update_viewport(LibMatrix::vec2(canvas_.width(), canvas_.height()));
-    priv_->update_time();
+    priv_->update_time(animation_time());
 }
 
 void
@@ -102,6 +143,21 @@ SceneJellyfish::validate()
     return Scene::ValidationUnknown;
 }
 
+std::vector<std::string>
+SceneJellyfish::textures()
+{
+    std::vector<std::string> names;
+
+    names.push_back("jellyfish256");
+    for (unsigned int i = 1; i < 33; i++) {
+        std::stringstream ss;
+        ss << "jellyfish-caustics-" << std::setw(2) << std::setfill('0') << i;
+        names.push_back(ss.str());
+    }
+
+    return names;
+}
+
 
 //
 // JellyfishPrivate implementation
@@ -342,10 +398,17 @@ JellyfishPrivate::load_obj(const std::string &filename)
 }
 
 JellyfishPrivate::JellyfishPrivate() :
+    background_(true),
+    count_(1),
+    instanceBuffer_(0),
+    crowdScale_(1.0),
+    causticsArray_(false),
+    causticsTexture_(0),
     positionLocation_(0),
     normalLocation_(0),
     colorLocation_(0),
     texcoordLocation_(0),
+    instanceLocation_(-1),
     viewport_(512.0, 512.0),
     lightPosition_(10.0, 40.0, -60.0),
     lightColor_(0.8, 1.3, 1.1, 1.0),
@@ -355,7 +418,6 @@ JellyfishPrivate::JellyfishPrivate() :
     fresnelPower_(1.0),
     rotation_(0.0),
     currentTime_(0.0),
-    lastUpdateTime_(0.0),
     cullFace_(0),
     depthTest_(0),
     blend_(0),
@@ -373,9 +435,69 @@ JellyfishPrivate::~JellyfishPrivate()
     indices_.clear();
 }
 
+// Loads the 32 caustics into the layers of an array texture, so that the
+// animation only changes a uniform. The images are decoded in parallel.
+bool
+JellyfishPrivate::load_caustics_array()
+{
+    static const unsigned int ncaustics = 32;
+    std::vector<unsigned char> pixels[ncaustics];
+    unsigned int widths[ncaustics];
+    unsigned int heights[ncaustics];
+    GLenum formats[ncaustics];
+    bool decoded[ncaustics];
+
+    unsigned int nthreads =
+        std::min(std::max(std::thread::hardware_concurrency(), 1U), 8U);
+    std::vector<std::thread> threads;
+
+    for (unsigned int t = 0; t < nthreads; t++) {
+        threads.push_back(std::thread([&, t]() {
+            for (unsigned int i = t; i < ncaustics; i += nthreads) {
+                std::stringstream ss;
+                ss << "jellyfish-caustics-" << std::setw(2) << std::setfill('0') << i + 1;
+                decoded[i] = Texture::decode(ss.str(), pixels[i], widths[i],
+                                             heights[i], formats[i]);
+            }
+        }));
+    }
+
+    for (std::vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); iter++)
+        iter->join();
+
+    for (unsigned int i = 0; i < ncaustics; i++) {
+        if (!decoded[i] || widths[i] != widths[0] || heights[i] != heights[0] ||
+            formats[i] != formats[0])
+        {
+            Log::error("Caustics texture[%u] set up failed!!!\n", i + 1);
+            return false;
+        }
+    }
+
+    glGenTextures(1, &causticsTexture_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, causticsTexture_);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    GLExtensions::TexImage3D(GL_TEXTURE_2D_ARRAY, 0, formats[0], widths[0], heights[0],
+                             ncaustics, 0, formats[0], GL_UNSIGNED_BYTE, 0);
+    for (unsigned int i = 0; i < ncaustics; i++) {
+        GLExtensions::TexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, widths[i], heights[i],
+                                    1, formats[i], GL_UNSIGNED_BYTE, &pixels[i].front());
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return true;
+}
+
 bool
-JellyfishPrivate::initialize()
+JellyfishPrivate::initialize(bool causticsArray, unsigned int count, bool background)
 {
+    background_ = background;
+
     static const string modelFilename(Options::data_path + "/models/jellyfish.jobj");
     if (!load_obj(modelFilename))
     {
@@ -398,9 +520,8 @@ JellyfishPrivate::initialize()
     dataMap_.texcoordSize = texcoords_.size() * sv3;
     dataMap_.totalSize += dataMap_.texcoordSize;
 
-    lastUpdateTime_ = Util::get_timestamp_us() / 1000.0;
-    currentTime_ = static_cast<uint64_t>(lastUpdateTime_) % 100000000 / 1000.0;
-    whichCaustic_ = static_cast<uint64_t>(currentTime_ * 30) % 32 + 1;
+    currentTime_ = 0.0;
+    whichCaustic_ = 1;
     rotation_ = 0.0;
 
     if (!gradient_.init())
@@ -413,13 +534,41 @@ JellyfishPrivate::initialize()
     using std::string;
     static const string vtx_shader_filename(Options::data_path + "/shaders/jellyfish.vert");
     static const string frg_shader_filename(Options::data_path + "/shaders/jellyfish.frag");
+    static const string vtx_array_shader_filename(Options::data_path + "/shaders/jellyfish-array.vert");
+    static const string frg_array_shader_filename(Options::data_path + "/shaders/jellyfish-array.frag");
 
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
+    causticsArray_ = causticsArray;
+
+    ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+    if (causticsArray_) {
+        vtx_source.append(Scene::glsl3_shader_version());
+        vtx_source.append_file(vtx_array_shader_filename);
+        frg_source.append(Scene::glsl3_shader_version());
+        frg_source.append_file(frg_array_shader_filename);
+    }
+    else {
+        vtx_source.append_file(vtx_shader_filename);
+        frg_source.append_file(frg_shader_filename);
+    }
 
     // Use high float precision, if available, in the jellyfish fragment shader
     frg_source.precision(std::string(",high,,"));
 
+    // Each instance of a crowd is offset and has its own animation phase
+    count_ = count;
+    if (count_ > 1)
+    {
+        vtx_source.replace("vec3 aTextureCoord;\n",
+                           "vec3 aTextureCoord;\n" +
+                           string(causticsArray_ ? "in" : "attribute") + " vec4 aInstance;\n");
+        vtx_source.replace("float speed = uCurrentTime / 15.0;",
+                           "float speed = (uCurrentTime + aInstance.w) / 15.0;");
+        vtx_source.replace("vec4 pos4 = vec4(pos, 1.0);",
+                           "vec4 pos4 = vec4(pos + aInstance.xyz, 1.0);");
+    }
+
     if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
         frg_source.str()))
     {
@@ -431,6 +580,10 @@ JellyfishPrivate::initialize()
     normalLocation_ = program_["aVertexNormal"].location();
     colorLocation_ = program_["aVertexColor"].location();
     texcoordLocation_ = program_["aTextureCoord"].location();
+    if (count_ > 1)
+    {
+        instanceLocation_ = program_["aInstance"].location();
+    }
 
     // We need 2 buffers for our work here.  One for the vertex data.
     // and one for the index data.
@@ -454,6 +607,35 @@ JellyfishPrivate::initialize()
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned short),
                  &indices_.front(), GL_STATIC_DRAW);
 
+    // A crowd is laid out on a grid in model space, in cells a bit larger
+    // than the jellyfish (about 5 units wide and 11 units high, centered
+    // 3.85 units below the origin), scaled down and centered to fit the
+    // 40 units high view at the jellyfish depth.
+    if (count_ > 1)
+    {
+        unsigned int columns = static_cast<unsigned int>(std::ceil(std::sqrt(2.0 * count_)));
+        unsigned int rows = (count_ + columns - 1) / columns;
+        static const float cellWidth(6.0);
+        static const float cellHeight(12.0);
+        crowdScale_ = 0.65 / std::max(static_cast<float>(rows), columns / 2.0f);
+        float centerY = 3.85 - 1.0 / crowdScale_;
+        vector<float> instances;
+        instances.reserve(count_ * 4);
+        for (unsigned int i = 0; i < count_; i++)
+        {
+            instances.push_back((i % columns - (columns - 1) / 2.0) * cellWidth);
+            instances.push_back(centerY + ((rows - 1) / 2.0 - i / columns) * cellHeight);
+            instances.push_back(0.0);
+            // Spread the phases so that the crowd doesn't move in lockstep
+            instances.push_back(std::fmod(i * 2.39996, 6.28318));
+        }
+
+        glGenBuffers(1, &instanceBuffer_);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+        glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(float),
+                     &instances.front(), GL_STATIC_DRAW);
+    }
+
     // "Unbind" our buffer objects to make sure the state is consistent.
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -471,7 +653,11 @@ JellyfishPrivate::initialize()
     glBindTexture(GL_TEXTURE_2D, 0);
     // Then, the caustics textures
     static const string baseName("jellyfish-caustics-");
-    for (unsigned int i = 1; i < 33; i++)
+    if (causticsArray_ && !load_caustics_array())
+    {
+        return false;
+    }
+    for (unsigned int i = 1; i < 33 && !causticsArray_; i++)
     {
         std::stringstream ss;
         ss << std::setw(2) << std::setfill('0') << i;
@@ -517,14 +703,11 @@ JellyfishPrivate::update_viewport(const vec2& vp)
 }
 
 void
-JellyfishPrivate::update_time()
+JellyfishPrivate::update_time(double elapsed)
 {
-    double now = Util::get_timestamp_us() / 1000.0;
-    double elapsedTime = now - lastUpdateTime_;
-    rotation_ += (2.0 * elapsedTime) / 1000.0;
-    currentTime_ = static_cast<uint64_t>(now) % 100000000 / 1000.0;
+    rotation_ = 2.0 * elapsed;
+    currentTime_ = std::fmod(elapsed, 100000.0);
     whichCaustic_ = static_cast<uint64_t>(currentTime_ * 30) % 32 + 1;
-    lastUpdateTime_ = now;
 }
 
 void
@@ -551,8 +734,21 @@ JellyfishPrivate::cleanup()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-    glDeleteTextures(33, &textureObjects_[0]);
+    if (causticsArray_)
+    {
+        Texture::release(1, &textureObjects_[0]);
+        glDeleteTextures(1, &causticsTexture_);
+    }
+    else
+    {
+        Texture::release(33, &textureObjects_[0]);
+    }
     glDeleteBuffers(2, &bufferObjects_[0]);
+    if (instanceBuffer_)
+    {
+        glDeleteBuffers(1, &instanceBuffer_);
+        instanceBuffer_ = 0;
+    }
 
     gradient_.cleanup();
 }
@@ -561,7 +757,8 @@ void
 JellyfishPrivate::draw()
 {
     // "Clear" the background to the desired gradient.
-    gradient_.draw();
+    if (background_)
+        gradient_.draw();
 
     // We need "world", "world view projection", and "world inverse transpose"
     // matrix uniforms for the current shader.
@@ -575,7 +772,7 @@ JellyfishPrivate::draw()
     world_.translate(0.0, 5.0, -75.0);
     world_.rotate(sin(rotation_ / 10.0) * 30.0, 0.0, 1.0, 0.0);
     world_.rotate(sin(rotation_ / 20.0) * 30.0, 1.0, 0.0, 0.0);
-    world_.scale(5.0, 5.0, 5.0);
+    world_.scale(5.0 * crowdScale_, 5.0 * crowdScale_, 5.0 * crowdScale_);
     world_.translate(0.0, sin(rotation_ / 10.0) * 2.5, 0.0);
     mat4 worldViewProjection(projection_.getCurrent());
     worldViewProjection *= world_.getCurrent();;
@@ -601,8 +798,17 @@ JellyfishPrivate::draw()
     glBindTexture(GL_TEXTURE_2D, textureObjects_[0]);
     program_["uSampler"] = 0;
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, textureObjects_[whichCaustic_]);
-    program_["uSampler1"] = 1;
+    if (causticsArray_)
+    {
+        glBindTexture(GL_TEXTURE_2D_ARRAY, causticsTexture_);
+        program_["uCaustics"] = 1;
+        program_["uCausticLayer"] = static_cast<float>(whichCaustic_ - 1);
+    }
+    else
+    {
+        glBindTexture(GL_TEXTURE_2D, textureObjects_[whichCaustic_]);
+        program_["uSampler1"] = 1;
+    }
 
     glBindBuffer(GL_ARRAY_BUFFER, bufferObjects_[0]);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferObjects_[1]);
@@ -620,7 +826,23 @@ JellyfishPrivate::draw()
     glVertexAttribPointer(texcoordLocation_ , 3, GL_FLOAT, GL_FALSE, 0,
         reinterpret_cast<const GLvoid*>(dataMap_.texcoordOffset));
 
-    glDrawElements(GL_TRIANGLES, indices_.size(), GL_UNSIGNED_SHORT, 0);
+    if (count_ > 1)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+        glEnableVertexAttribArray(instanceLocation_);
+        glVertexAttribPointer(instanceLocation_, 4, GL_FLOAT, GL_FALSE, 0, 0);
+        GLExtensions::VertexAttribDivisor(instanceLocation_, 1);
+
+        GLExtensions::DrawElementsInstanced(GL_TRIANGLES, indices_.size(),
+                                            GL_UNSIGNED_SHORT, 0, count_);
+
+        GLExtensions::VertexAttribDivisor(instanceLocation_, 0);
+        glDisableVertexAttribArray(instanceLocation_);
+    }
+    else
+    {
+        glDrawElements(GL_TRIANGLES, indices_.size(), GL_UNSIGNED_SHORT, 0);
+    }
 
     glDisableVertexAttribArray(positionLocation_);
     glDisableVertexAttribArray(normalLocation_);
@@ -56,9 +56,12 @@ public:
 class JellyfishPrivate
 {
     bool load_obj(const std::string& filename);
+    bool load_caustics_array();
 
-    // For the background gradient.
+    // For the background gradient, which is left out when the jellyfish are
+    // drawn over something else.
     GradientRenderer gradient_;
+    bool background_;
 
     // Vertex data.
     std::vector<LibMatrix::vec3> positions_;
@@ -82,7 +85,16 @@ class JellyfishPrivate
     } dataMap_;
     // Object handles
     unsigned int bufferObjects_[2];
+    // With count > 1, the jellyfish are drawn instanced, with a per-instance
+    // model space offset (xyz) and animation phase (w) from this buffer.
+    unsigned int count_;
+    unsigned int instanceBuffer_;
+    float crowdScale_;
     unsigned int textureObjects_[33];
+    // With caustics=array, the caustics are the layers of one array texture
+    // instead of textureObjects_[1..32].
+    bool causticsArray_;
+    unsigned int causticsTexture_;
     unsigned int whichCaustic_;
     std::map<std::string, unsigned int> causticMap_;
 
@@ -92,6 +104,7 @@ class JellyfishPrivate
     int normalLocation_;
     int colorLocation_;
     int texcoordLocation_;
+    int instanceLocation_;
     LibMatrix::vec2 viewport_;
     LibMatrix::Stack4 world_;
     LibMatrix::Stack4 projection_;
@@ -103,7 +116,6 @@ class JellyfishPrivate
     float fresnelPower_;
     float rotation_;
     float currentTime_;
-    double lastUpdateTime_;
     // GL state we plan to override, so we can restore it cleanly.
     unsigned int cullFace_;
     unsigned int depthTest_;
@@ -114,9 +126,9 @@ class JellyfishPrivate
 public:
     JellyfishPrivate();
     ~JellyfishPrivate();
-    bool initialize();
+    bool initialize(bool causticsArray, unsigned int count, bool background);
     void update_viewport(const LibMatrix::vec2& viewport);
-    void update_time();
+    void update_time(double elapsed);
     void cleanup();
     void draw();
 };
@@ -0,0 +1,235 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "canvas.h"
+#include "frame-stats.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+#include <deque>
+
+struct SceneLatencyPrivate {
+    SceneLatencyPrivate() :
+        quad_buffer(0), speed(1.0f) {}
+
+    Program program;
+    GLuint quad_buffer;
+    /* The revolutions per second of the marker */
+    float speed;
+    /* The input times of the frames drawn but not presented yet */
+    std::deque<uint64_t> inputs;
+    /* The time from the input to the start of the scanout, in µs */
+    FrameStats input_to_scanout;
+
+    void release()
+    {
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+
+        inputs.clear();
+    }
+};
+
+SceneLatency::SceneLatency(Canvas &pCanvas) :
+    Scene(pCanvas, "latency")
+{
+    priv_ = new SceneLatencyPrivate();
+    options_["size"] = Scene::Option("size", "64",
+                                     "The size of the marker in pixels");
+    options_["speed"] = Scene::Option("speed", "1",
+                                      "The revolutions per second of the marker around the center");
+}
+
+SceneLatency::~SceneLatency()
+{
+    delete priv_;
+}
+
+bool
+SceneLatency::supported(bool show_errors)
+{
+    static_cast<void>(show_errors);
+    return true;
+}
+
+bool
+SceneLatency::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneLatency::unload()
+{
+}
+
+bool
+SceneLatency::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/latency.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/latency.frag");
+
+    SceneLatencyPrivate &p(*priv_);
+
+    /* Parse the options */
+    float size = Util::fromString<float>(options_["size"].value);
+    p.speed = Util::fromString<float>(options_["speed"].value);
+
+    if (!Options::present_timing) {
+        Log::info("Warning: The latency scene needs --present-timing to measure "
+                  "the time to scanout\n");
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.quad_buffer = FullscreenQuad::create();
+
+    p.program.start();
+    p.program["Scale"] = LibMatrix::vec2(size / canvas_.width(),
+                                         size / canvas_.height());
+
+    glDisable(GL_DEPTH_TEST);
+
+    p.inputs.clear();
+    p.input_to_scanout.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneLatency::teardown()
+{
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneLatency::update()
+{
+    Scene::update();
+}
+
+/*
+ * Samples a synthetic input as late as possible before the swap and draws
+ * the marker where that input puts it.
+ */
+void
+SceneLatency::draw()
+{
+    SceneLatencyPrivate &p(*priv_);
+    GLint position_location = p.program["position"].location();
+
+    uint64_t input = Util::get_timestamp_us();
+    double angle = 2.0 * M_PI * p.speed * (input / 1000000.0 - startTime_);
+
+    p.program["Center"] = LibMatrix::vec2(0.5 * std::cos(angle),
+                                          0.5 * std::sin(angle));
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    /* Frames that are never presented must not pile up */
+    static const size_t max_inputs = 256;
+    if (p.inputs.size() == max_inputs)
+        p.inputs.pop_front();
+    p.inputs.push_back(input);
+}
+
+/*
+ * Matches the presented frame with the last input sampled before it was
+ * submitted, dropping the inputs of the frames that were skipped.
+ */
+void
+SceneLatency::presented(const Presentation &presentation)
+{
+    SceneLatencyPrivate &p(*priv_);
+
+    if (presentation.submit_time == 0 || presentation.present_time == 0)
+        return;
+
+    bool matched = false;
+    uint64_t input = 0;
+
+    while (!p.inputs.empty() && p.inputs.front() <= presentation.submit_time) {
+        input = p.inputs.front();
+        matched = true;
+        p.inputs.pop_front();
+    }
+
+    if (matched && presentation.present_time > input)
+        p.input_to_scanout.add(presentation.present_time - input);
+}
+
+Scene::ValidationResult
+SceneLatency::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneLatency::measurements()
+{
+    /* Nothing is measured without presentation feedback */
+    if (priv_->input_to_scanout.count() == 0)
+        return std::vector<Measurement>();
+
+    return std::vector<Measurement>(1, Measurement("InputToScanout", "input_to_scanout",
+                                                   priv_->input_to_scanout));
+}
+
+void
+SceneLatency::reset_measurements()
+{
+    priv_->input_to_scanout.reset();
+}
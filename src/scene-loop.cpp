@@ -36,6 +36,7 @@ static const std::string vtx_file(shader_file_base + ".vert");
 static const std::string frg_file(shader_file_base + ".frag");
 static const std::string step_simple_file(shader_file_base + "-step-simple.all");
 static const std::string step_loop_file(shader_file_base + "-step-loop.all");
+static const std::string step_divergent_file(shader_file_base + "-step-divergent.all");
 
 SceneLoop::SceneLoop(Canvas &pCanvas) :
     SceneGrid(pCanvas, "loop")
@@ -54,6 +55,8 @@ SceneLoop::SceneLoop(Canvas &pCanvas) :
     options_["fragment-uniform"] = Scene::Option("fragment-uniform", "true",
             "Whether to use a uniform in the fragment shader for the number of loop iterations to perform (i.e. fragment-steps)",
             "false,true");
+    options_["fragment-divergence-tile"] = Scene::Option("fragment-divergence-tile", "0",
+            "The size in pixels of the squares with the same number of fragment loop iterations, which varies between 0 and twice fragment-steps (0: all fragments perform fragment-steps iterations)");
 }
 
 SceneLoop::~SceneLoop()
@@ -61,12 +64,37 @@ SceneLoop::~SceneLoop()
 }
 
 static std::string
-get_fragment_shader_source(int steps, bool loop, bool uniform)
+get_fragment_shader_source(int steps, bool loop, bool uniform, unsigned int divergence_tile)
 {
+    /* Large step counts are expensive to generate, so only do it once */
+    const std::string key(frg_file + ":" + Util::toString(steps) + (loop ? ":loop" : "") + (uniform ? ":uniform" : "") +
+                          ":" + Util::toString(divergence_tile));
+    std::string str;
+    if (ShaderSource::find_generated(key, str))
+        return str;
+
     ShaderSource source(Options::data_path + frg_file);
     ShaderSource source_main;
 
-    if (loop) {
+    if (loop && divergence_tile > 0) {
+        /*
+         * Each square gets a pseudo-random trip count between 0 and twice
+         * the steps, and the loop breaks out after it. The bound of the
+         * loop stays uniform, as GLSL ES 1.00 requires.
+         */
+        source_main.append("    HIGHP_OR_DEFAULT vec2 tile = floor(FragCoord / " +
+                           Util::toString(divergence_tile) + ".0);\n"
+                           "    HIGHP_OR_DEFAULT float hash = fract(sin(dot(tile, vec2(12.9898, 78.233))) * 43758.5453);\n"
+                           "    int trips = int(hash * float($NLOOPS$ + 1));\n");
+        source_main.append_file(Options::data_path + step_divergent_file);
+        if (uniform) {
+            source_main.replace("$NLOOPS$", "2 * FragmentLoops");
+        }
+        else {
+            source_main.replace("$NLOOPS$", Util::toString(2 * steps));
+        }
+    }
+    else if (loop) {
         source_main.append_file(Options::data_path + step_loop_file);
         if (uniform) {
             source_main.replace("$NLOOPS$", "FragmentLoops");
@@ -82,12 +110,21 @@ get_fragment_shader_source(int steps, bool loop, bool uniform)
 
     source.replace("$MAIN$", source_main.str());
 
-    return source.str();
+    str = source.str();
+    ShaderSource::store_generated(key, str);
+
+    return str;
 }
 
 static std::string
 get_vertex_shader_source(int steps, bool loop, bool uniform)
 {
+    /* Large step counts are expensive to generate, so only do it once */
+    const std::string key(vtx_file + ":" + Util::toString(steps) + (loop ? ":loop" : "") + (uniform ? ":uniform" : ""));
+    std::string str;
+    if (ShaderSource::find_generated(key, str))
+        return str;
+
     ShaderSource source(Options::data_path + vtx_file);
     ShaderSource source_main;
 
@@ -107,7 +144,10 @@ get_vertex_shader_source(int steps, bool loop, bool uniform)
 
     source.replace("$MAIN$", source_main.str());
 
-    return source.str();
+    str = source.str();
+    ShaderSource::store_generated(key, str);
+
+    return str;
 }
 
 
@@ -124,12 +164,18 @@ SceneLoop::setup()
     bool frg_uniform = options_["fragment-uniform"].value == "true";
     int vtx_steps = Util::fromString<int>(options_["vertex-steps"].value);
     int frg_steps = Util::fromString<int>(options_["fragment-steps"].value);
+    unsigned int divergence_tile = Util::fromString<unsigned int>(options_["fragment-divergence-tile"].value);
+
+    if (divergence_tile > 0 && !frg_loop) {
+        Log::error("fragment-divergence-tile requires fragment-loop=true\n");
+        return false;
+    }
 
     /* Load shaders */
-    std::string vtx_shader(get_vertex_shader_source(vtx_steps, vtx_loop,
-                                                    vtx_uniform));
+    std::string vtx_shader(prepare_vertex_shader(
+        get_vertex_shader_source(vtx_steps, vtx_loop, vtx_uniform)));
     std::string frg_shader(get_fragment_shader_source(frg_steps, frg_loop,
-                                                      frg_uniform));
+                                                      frg_uniform, divergence_tile));
 
     if (!Scene::load_shaders_from_strings(program_, vtx_shader, frg_shader))
         return false;
@@ -159,6 +205,9 @@ SceneLoop::validate()
 
     Canvas::Pixel ref;
 
+    if (options_["fragment-divergence-tile"].value != "0")
+        return Scene::ValidationUnknown;
+
     if (frg_steps == 5)
         ref = Canvas::Pixel(0x5e, 0x5e, 0x5e, 0xff);
     else
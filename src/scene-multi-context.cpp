@@ -0,0 +1,442 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "gl-state.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <atomic>
+#include <sstream>
+#include <thread>
+
+/*
+ * The scene runs its workload on worker threads, each with its own context
+ * and FBO. The workloads are self-contained, since the texture and program
+ * caches used by the other scenes can't be shared between threads.
+ */
+struct SceneMultiContextPrivate {
+    enum Workload {
+        WorkloadGeometry,
+        WorkloadTexture
+    };
+
+    struct Worker {
+        Worker() : context(0), frames(0), failed(false),
+                   start_frames(0), end_frames(0) {}
+
+        GLWorkerContext *context;
+        std::thread thread;
+        std::atomic<unsigned int> frames;
+        std::atomic<bool> failed;
+        /* The frames at the start and end of the measured run */
+        unsigned int start_frames;
+        unsigned int end_frames;
+    };
+
+    SceneMultiContextPrivate() :
+        workload(WorkloadGeometry), shared(false), width(0), height(0),
+        shared_texture(0), stop(false), stopped(false) {}
+
+    Workload workload;
+    bool shared;
+    int width;
+    int height;
+    std::string vtx_shader;
+    std::string frg_shader;
+
+    /* The texture of the main context, used by all shared contexts */
+    GLuint shared_texture;
+
+    std::vector<Worker *> workers;
+    std::atomic<bool> stop;
+    /* Whether the frames of the run have been counted */
+    bool stopped;
+
+    static GLuint create_texture(Workload workload);
+    static void run(SceneMultiContextPrivate *priv, Worker *worker);
+
+    void release()
+    {
+        stop = true;
+
+        for (std::vector<Worker *>::iterator iter = workers.begin();
+             iter != workers.end();
+             iter++)
+        {
+            if ((*iter)->thread.joinable())
+                (*iter)->thread.join();
+            delete (*iter)->context;
+            delete *iter;
+        }
+        workers.clear();
+
+        if (shared_texture) {
+            glDeleteTextures(1, &shared_texture);
+            shared_texture = 0;
+        }
+    }
+};
+
+/*
+ * Creates the texture sampled by the workload: a large checkerboard for the
+ * texture workload and a single texel for the geometry workload.
+ */
+GLuint
+SceneMultiContextPrivate::create_texture(Workload workload)
+{
+    unsigned int size = workload == WorkloadTexture ? 512 : 1;
+    std::vector<unsigned char> texels(size * size * 4);
+
+    for (unsigned int y = 0; y < size; y++) {
+        for (unsigned int x = 0; x < size; x++) {
+            unsigned char *texel = &texels[(y * size + x) * 4];
+            bool odd = ((x / 32) + (y / 32)) % 2;
+
+            texel[0] = odd ? 64 : 255;
+            texel[1] = static_cast<unsigned char>(255 * x / size);
+            texel[2] = static_cast<unsigned char>(255 * y / size);
+            texel[3] = 255;
+        }
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, &texels[0]);
+
+    return texture;
+}
+
+/*
+ * Renders the workload into the FBO of the worker until the scene stops.
+ * Every frame is finished, so that the counted frames have been rendered.
+ */
+void
+SceneMultiContextPrivate::run(SceneMultiContextPrivate *priv, Worker *worker)
+{
+    if (!worker->context->make_current()) {
+        worker->failed = true;
+        return;
+    }
+
+    GLuint color_texture;
+    GLuint fbo;
+
+    glGenTextures(1, &color_texture);
+    glBindTexture(GL_TEXTURE_2D, color_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, priv->width, priv->height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+    GLExtensions::GenFramebuffers(1, &fbo);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, color_texture, 0);
+
+    Program program;
+    program.init();
+    program.addShader(GL_VERTEX_SHADER, priv->vtx_shader);
+    program.addShader(GL_FRAGMENT_SHADER, priv->frg_shader);
+    program.build();
+
+    GLuint texture = priv->shared ? priv->shared_texture :
+                                    create_texture(priv->workload);
+
+    if (GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE ||
+        !program.ready())
+    {
+        Log::error("Failed to set up the worker context: %s\n",
+                   program.errorMessage().c_str());
+        worker->failed = true;
+    }
+    else {
+        /* The geometry workload draws many small triangles, the texture one a few large ones */
+        int cells = priv->workload == WorkloadGeometry ? 128 : 4;
+
+        Mesh mesh;
+        std::vector<int> vertex_format;
+        vertex_format.push_back(3);
+        mesh.set_vertex_format(vertex_format);
+        mesh.make_grid(cells, cells, 2.0, 2.0, 0.0);
+        mesh.build_vbo();
+
+        std::vector<GLint> attrib_locations;
+        attrib_locations.push_back(program["position"].location());
+        mesh.set_attrib_locations(attrib_locations);
+
+        program.start();
+        program["MaterialTexture0"] = 0;
+
+        glViewport(0, 0, priv->width, priv->height);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture);
+
+        float angle = 0.0f;
+
+        while (!priv->stop) {
+            glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            program["Angle"] = angle;
+            mesh.render_vbo();
+            glFinish();
+
+            angle += 0.01f;
+            worker->frames++;
+        }
+
+        program.stop();
+    }
+
+    program.release();
+    if (!priv->shared)
+        glDeleteTextures(1, &texture);
+    GLExtensions::DeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &color_texture);
+
+    worker->context->release();
+}
+
+SceneMultiContext::SceneMultiContext(Canvas &pCanvas) :
+    Scene(pCanvas, "multi-context")
+{
+    priv_ = new SceneMultiContextPrivate();
+    options_["threads"] = Scene::Option("threads", "4",
+                                        "The number of threads rendering concurrently, each with its own context");
+    options_["contexts"] = Scene::Option("contexts", "shared",
+                                         "Whether the contexts share their objects with the main context",
+                                         "shared,independent");
+    options_["workload"] = Scene::Option("workload", "geometry",
+                                         "The workload each thread renders into its own FBO",
+                                         "geometry,texture");
+}
+
+SceneMultiContext::~SceneMultiContext()
+{
+    delete priv_;
+}
+
+bool
+SceneMultiContext::supported(bool show_errors)
+{
+    GLWorkerContext *context = canvas_.create_worker_context(false);
+
+    if (!context) {
+        if (show_errors) {
+            Log::error("Rendering from multiple contexts is not supported"
+                       " by this flavor!\n");
+        }
+        return false;
+    }
+
+    delete context;
+
+    return true;
+}
+
+bool
+SceneMultiContext::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneMultiContext::unload()
+{
+}
+
+bool
+SceneMultiContext::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/multi-context.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/multi-context.frag");
+
+    SceneMultiContextPrivate &p(*priv_);
+
+    /* Parse the options */
+    unsigned int threads = Util::fromString<unsigned int>(options_["threads"].value);
+    if (threads == 0) {
+        Log::error("The number of threads must be at least 1\n");
+        return false;
+    }
+
+    p.shared = options_["contexts"].value == "shared";
+    p.workload = options_["workload"].value == "texture" ?
+                 SceneMultiContextPrivate::WorkloadTexture :
+                 SceneMultiContextPrivate::WorkloadGeometry;
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+    p.vtx_shader = vtx_source.str();
+    p.frg_shader = frg_source.str();
+
+    /* The objects of the main context must be complete before they are shared */
+    if (p.shared) {
+        p.shared_texture = SceneMultiContextPrivate::create_texture(p.workload);
+        glFinish();
+    }
+
+    /* Create all the contexts before any thread starts rendering */
+    p.stop = false;
+    p.stopped = false;
+
+    for (unsigned int i = 0; i < threads; i++) {
+        SceneMultiContextPrivate::Worker *worker = new SceneMultiContextPrivate::Worker();
+        p.workers.push_back(worker);
+
+        worker->context = canvas_.create_worker_context(p.shared);
+        if (!worker->context) {
+            Log::error("Failed to create the context of thread %u\n", i);
+            return false;
+        }
+    }
+
+    for (std::vector<SceneMultiContextPrivate::Worker *>::iterator iter = p.workers.begin();
+         iter != p.workers.end();
+         iter++)
+    {
+        (*iter)->thread = std::thread(SceneMultiContextPrivate::run, priv_, *iter);
+    }
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneMultiContext::teardown()
+{
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneMultiContext::update()
+{
+    Scene::update();
+
+    SceneMultiContextPrivate &p(*priv_);
+
+    bool failed = false;
+
+    for (std::vector<SceneMultiContextPrivate::Worker *>::iterator iter = p.workers.begin();
+         iter != p.workers.end();
+         iter++)
+    {
+        failed = failed || (*iter)->failed;
+    }
+
+    if (failed)
+        running_ = false;
+
+    /* Count the frames rendered by the threads while the scene was running */
+    if (!running_ && !p.stopped) {
+        for (std::vector<SceneMultiContextPrivate::Worker *>::iterator iter = p.workers.begin();
+             iter != p.workers.end();
+             iter++)
+        {
+            (*iter)->end_frames = (*iter)->frames;
+        }
+        p.stopped = true;
+    }
+}
+
+/*
+ * The main context draws nothing, the work is done by the threads.
+ */
+void
+SceneMultiContext::draw()
+{
+}
+
+Scene::ValidationResult
+SceneMultiContext::validate()
+{
+    for (std::vector<SceneMultiContextPrivate::Worker *>::iterator iter = priv_->workers.begin();
+         iter != priv_->workers.end();
+         iter++)
+    {
+        if ((*iter)->failed)
+            return Scene::ValidationFailure;
+    }
+
+    return Scene::ValidationUnknown;
+}
+
+void
+SceneMultiContext::reset_measurements()
+{
+    for (std::vector<SceneMultiContextPrivate::Worker *>::iterator iter = priv_->workers.begin();
+         iter != priv_->workers.end();
+         iter++)
+    {
+        (*iter)->start_frames = (*iter)->frames;
+    }
+}
+
+std::vector<Scene::Rate>
+SceneMultiContext::rates()
+{
+    std::vector<Rate> result;
+    double elapsed = elapsed_time();
+    double total = 0.0;
+    std::vector<Rate> thread_rates;
+
+    for (std::vector<SceneMultiContextPrivate::Worker *>::iterator iter = priv_->workers.begin();
+         iter != priv_->workers.end();
+         iter++)
+    {
+        unsigned int end_frames = priv_->stopped ? (*iter)->end_frames :
+                                                   static_cast<unsigned int>((*iter)->frames);
+        double fps = elapsed > 0.0 ? (end_frames - (*iter)->start_frames) / elapsed : 0.0;
+        unsigned int index = iter - priv_->workers.begin();
+        std::stringstream name;
+        std::stringstream key;
+
+        name << "Thread" << index << "FPS";
+        key << "thread" << index << "_fps";
+        thread_rates.push_back(Rate(name.str(), key.str(), fps));
+        total += fps;
+    }
+
+    result.push_back(Rate("WorkerFPS", "worker_fps", total));
+    result.insert(result.end(), thread_rates.begin(), thread_rates.end());
+
+    return result;
+}
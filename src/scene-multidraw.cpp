@@ -0,0 +1,513 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+
+struct SceneMultiDrawPrivate {
+    enum SubmitMethod {
+        SubmitMethodLoop,
+        SubmitMethodIndirect,
+        SubmitMethodMultiIndirect
+    };
+
+    SceneMultiDrawPrivate() :
+        submit_method(SubmitMethodLoop), indexed(false), compute(false),
+        cull(false), draws(0), side(0), stride(0), position_location(-1),
+        vbo(0), ibo(0), vao(0), command_buffer(0), texture(0) {}
+
+    SubmitMethod submit_method;
+    bool indexed;
+    bool compute;
+    bool cull;
+    unsigned int draws;
+    /* The number of quads in each row of the grid */
+    unsigned int side;
+    /* The size of each draw command in GLuints */
+    unsigned int stride;
+
+    Program program;
+    Program compute_program;
+    GLint position_location;
+    GLuint vbo;
+    GLuint ibo;
+    GLuint vao;
+    GLuint command_buffer;
+    GLuint texture;
+
+    /* The draw commands, as written by the CPU */
+    std::vector<GLuint> commands;
+
+    FrameStats submit_stats;
+
+    /*
+     * Whether a quad is drawn, which hides every fourth row of quads,
+     * moving down every frame, when culling. This must match the rule in
+     * the command generating compute shader.
+     */
+    bool visible(unsigned int i, unsigned int frame) const
+    {
+        return !cull || (i / side + frame) % 4 != 0;
+    }
+
+    void bind_vertex_state() const
+    {
+        if (vao) {
+            GLExtensions::BindVertexArray(vao);
+            return;
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glEnableVertexAttribArray(position_location);
+        glVertexAttribPointer(position_location, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        if (indexed)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    }
+
+    void unbind_vertex_state() const
+    {
+        if (vao) {
+            GLExtensions::BindVertexArray(0);
+            return;
+        }
+
+        glDisableVertexAttribArray(position_location);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (indexed)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+};
+
+SceneMultiDraw::SceneMultiDraw(Canvas &pCanvas) :
+    Scene(pCanvas, "multidraw")
+{
+    priv_ = new SceneMultiDrawPrivate();
+    options_["draws"] = Scene::Option("draws", "10000",
+                                      "The number of draws issued every frame");
+    options_["submit-method"] = Scene::Option("submit-method", "multi-indirect",
+                                              "How the draws are submitted",
+                                              "loop,indirect,multi-indirect");
+    options_["command-source"] = Scene::Option("command-source", "cpu",
+                                               "Who writes the indirect draw commands",
+                                               "cpu,compute");
+    options_["indexed"] = Scene::Option("indexed", "false",
+                                        "Whether to use indexed draws",
+                                        "false,true");
+    options_["cull"] = Scene::Option("cull", "false",
+                                     "Whether to skip a changing subset of the draws every frame",
+                                     "false,true");
+}
+
+SceneMultiDraw::~SceneMultiDraw()
+{
+    delete priv_;
+}
+
+bool
+SceneMultiDraw::supported(bool show_errors)
+{
+    const std::string &method = options_["submit-method"].value;
+    bool compute = options_["command-source"].value == "compute";
+
+    if (method == "indirect" &&
+        (GLExtensions::DrawArraysIndirect == 0 || GLExtensions::GenVertexArrays == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested indirect submit method but"
+                       " indirect drawing is not supported!\n");
+        }
+        return false;
+    }
+
+    if (method == "multi-indirect" &&
+        (GLExtensions::MultiDrawArraysIndirect == 0 || GLExtensions::GenVertexArrays == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested multi-indirect submit method but"
+                       " GL_ARB_multi_draw_indirect/GL_EXT_multi_draw_indirect is not supported!\n");
+        }
+        return false;
+    }
+
+    if (compute && method == "loop") {
+        if (show_errors) {
+            Log::error("Draw commands written by a compute shader require"
+                       " an indirect submit method!\n");
+        }
+        return false;
+    }
+
+#if GLMARK2_USE_GLESv2
+    if (options_["indexed"].value == "true" &&
+        !GLExtensions::version_supported(3, 0) &&
+        !GLExtensions::support("GL_OES_element_index_uint"))
+    {
+        if (show_errors) {
+            Log::error("Requested indexed draws but"
+                       " GL_OES_element_index_uint is not supported!\n");
+        }
+        return false;
+    }
+#endif
+
+    if (compute && GLExtensions::DispatchCompute == 0) {
+        if (show_errors) {
+            Log::error("Requested compute command source but"
+                       " compute shaders are not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneMultiDraw::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneMultiDraw::unload()
+{
+}
+
+bool
+SceneMultiDraw::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/drawcalls.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/drawcalls.frag");
+    static const std::string cmp_shader_filename(Options::data_path + "/shaders/multidraw-commands.comp");
+
+    SceneMultiDrawPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.draws = Util::fromString<unsigned int>(options_["draws"].value);
+    if (p.draws == 0) {
+        Log::error("The number of draws must be at least 1\n");
+        return false;
+    }
+
+    const std::string &method = options_["submit-method"].value;
+    if (method == "indirect")
+        p.submit_method = SceneMultiDrawPrivate::SubmitMethodIndirect;
+    else if (method == "multi-indirect")
+        p.submit_method = SceneMultiDrawPrivate::SubmitMethodMultiIndirect;
+    else
+        p.submit_method = SceneMultiDrawPrivate::SubmitMethodLoop;
+
+    p.indexed = options_["indexed"].value == "true";
+    p.compute = options_["command-source"].value == "compute";
+    p.cull = options_["cull"].value == "true";
+
+    /* DrawArraysIndirectCommand has 4 fields, DrawElementsIndirectCommand 5 */
+    p.stride = p.indexed ? 5 : 4;
+
+    /* Set up the program, reusing the drawcalls shaders */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+    frg_source.add_const("DrawColor", LibMatrix::vec4(0.4f, 0.7f, 1.0f, 1.0f));
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.program.start();
+    p.program["MaterialTexture0"] = 0;
+    p.program["Offset"] = LibMatrix::vec2(0.0f, 0.0f);
+    p.position_location = p.program["position"].location();
+
+    /*
+     * Create the geometry, a grid of small quads covering the screen, all
+     * stored in a single vertex buffer so that each draw only differs in
+     * the range of vertices or indices it uses.
+     */
+    p.side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(p.draws))));
+    float cell = 2.0f / p.side;
+
+    std::vector<float> vertices;
+    std::vector<GLuint> indices;
+
+    for (unsigned int i = 0; i < p.draws; i++) {
+        float x0 = -1.0f + cell * (i % p.side);
+        float y0 = 1.0f - cell * (i / p.side);
+        float corners[4][3] = {
+            {x0, y0, 0.0f},
+            {x0, y0 - cell, 0.0f},
+            {x0 + cell, y0, 0.0f},
+            {x0 + cell, y0 - cell, 0.0f}
+        };
+        /* ul, ll, ur, ll, lr, ur */
+        static const unsigned int quad[6] = {0, 1, 2, 1, 3, 2};
+
+        if (p.indexed) {
+            for (unsigned int v = 0; v < 4; v++)
+                vertices.insert(vertices.end(), corners[v], corners[v] + 3);
+            for (unsigned int v = 0; v < 6; v++)
+                indices.push_back(4 * i + quad[v]);
+        }
+        else {
+            for (unsigned int v = 0; v < 6; v++)
+                vertices.insert(vertices.end(), corners[quad[v]], corners[quad[v]] + 3);
+        }
+    }
+
+    glGenBuffers(1, &p.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, p.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
+                 &vertices[0], GL_STATIC_DRAW);
+
+    if (p.indexed) {
+        glGenBuffers(1, &p.ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+                     &indices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    /* Indirect draws need a vertex array object with GLES 3.1 */
+    if (GLExtensions::GenVertexArrays) {
+        GLExtensions::GenVertexArrays(1, &p.vao);
+        GLExtensions::BindVertexArray(p.vao);
+        glEnableVertexAttribArray(p.position_location);
+        glVertexAttribPointer(p.position_location, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        if (p.indexed)
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p.ibo);
+        GLExtensions::BindVertexArray(0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    /* Write the draw commands */
+    p.commands.resize(p.draws * p.stride, 0);
+    for (unsigned int i = 0; i < p.draws; i++) {
+        GLuint *cmd = &p.commands[i * p.stride];
+        cmd[0] = 6;
+        cmd[1] = p.visible(i, 0) ? 1 : 0;
+        cmd[2] = 6 * i;
+    }
+
+    if (p.submit_method != SceneMultiDrawPrivate::SubmitMethodLoop) {
+        glGenBuffers(1, &p.command_buffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, p.command_buffer);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, p.commands.size() * sizeof(GLuint),
+                     &p.commands[0], p.cull ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    /* Set up the compute shader that writes the draw commands on the GPU */
+    if (p.compute) {
+        ShaderSource cmp_source;
+        cmp_source.append(Scene::compute_shader_version());
+        cmp_source.append_file(cmp_shader_filename);
+
+        if (!Scene::load_compute_shader_from_string(p.compute_program,
+                                                    cmp_source.str(),
+                                                    cmp_shader_filename))
+        {
+            return false;
+        }
+
+        p.compute_program.start();
+        p.compute_program["Draws"] = static_cast<int>(p.draws);
+        p.compute_program["Side"] = static_cast<int>(p.side);
+        p.compute_program["Cull"] = p.cull ? 1 : 0;
+        p.compute_program["Stride"] = static_cast<int>(p.stride);
+        p.compute_program.stop();
+    }
+
+    /* Create a white texture for the fragment shader to sample */
+    static const unsigned char white[4] = {255, 255, 255, 255};
+    glGenTextures(1, &p.texture);
+    glBindTexture(GL_TEXTURE_2D, p.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, white);
+
+    p.submit_stats.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneMultiDraw::teardown()
+{
+    SceneMultiDrawPrivate &p(*priv_);
+
+    if (p.vao) {
+        GLExtensions::DeleteVertexArrays(1, &p.vao);
+        p.vao = 0;
+    }
+
+    glDeleteBuffers(1, &p.vbo);
+    p.vbo = 0;
+    if (p.ibo) {
+        glDeleteBuffers(1, &p.ibo);
+        p.ibo = 0;
+    }
+    if (p.command_buffer) {
+        glDeleteBuffers(1, &p.command_buffer);
+        p.command_buffer = 0;
+    }
+
+    glDeleteTextures(1, &p.texture);
+    p.texture = 0;
+
+    p.commands.clear();
+
+    p.program.stop();
+    p.program.release();
+    p.compute_program.release();
+
+    Scene::teardown();
+}
+
+void
+SceneMultiDraw::update()
+{
+    Scene::update();
+}
+
+/*
+ * Submits the draws. All submit methods draw exactly the same quads, so
+ * the CPU time they take can be compared directly.
+ */
+void
+SceneMultiDraw::draw()
+{
+    SceneMultiDrawPrivate &p(*priv_);
+    uint64_t start = Util::get_timestamp_us();
+    const GLenum index_type = GL_UNSIGNED_INT;
+
+    /* Update the draw commands for this frame */
+    if (p.compute) {
+        p.compute_program.start();
+        p.compute_program["Frame"] = static_cast<int>(currentFrame_);
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, p.command_buffer);
+        GLExtensions::DispatchCompute((p.draws + 63) / 64, 1, 1);
+        GLExtensions::MemoryBarrierGL(GL_COMMAND_BARRIER_BIT);
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+        p.program.start();
+    }
+    else if (p.cull && p.submit_method != SceneMultiDrawPrivate::SubmitMethodLoop) {
+        for (unsigned int i = 0; i < p.draws; i++)
+            p.commands[i * p.stride + 1] = p.visible(i, currentFrame_) ? 1 : 0;
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, p.command_buffer);
+        glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+                        p.commands.size() * sizeof(GLuint), &p.commands[0]);
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, p.texture);
+
+    p.bind_vertex_state();
+
+    if (p.submit_method == SceneMultiDrawPrivate::SubmitMethodLoop) {
+        for (unsigned int i = 0; i < p.draws; i++) {
+            if (!p.visible(i, currentFrame_))
+                continue;
+
+            if (p.indexed) {
+                glDrawElements(GL_TRIANGLES, 6, index_type,
+                               reinterpret_cast<const void *>(6 * i * sizeof(GLuint)));
+            }
+            else {
+                glDrawArrays(GL_TRIANGLES, 6 * i, 6);
+            }
+        }
+    }
+    else {
+        const GLsizei stride = p.stride * sizeof(GLuint);
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, p.command_buffer);
+
+        if (p.submit_method == SceneMultiDrawPrivate::SubmitMethodMultiIndirect) {
+            if (p.indexed) {
+                GLExtensions::MultiDrawElementsIndirect(GL_TRIANGLES, index_type, 0,
+                                                        p.draws, stride);
+            }
+            else {
+                GLExtensions::MultiDrawArraysIndirect(GL_TRIANGLES, 0, p.draws, stride);
+            }
+        }
+        else {
+            for (unsigned int i = 0; i < p.draws; i++) {
+                const void *offset = reinterpret_cast<const void *>(i * stride);
+                if (p.indexed)
+                    GLExtensions::DrawElementsIndirect(GL_TRIANGLES, index_type, offset);
+                else
+                    GLExtensions::DrawArraysIndirect(GL_TRIANGLES, offset);
+            }
+        }
+
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+
+    p.unbind_vertex_state();
+
+    p.submit_stats.add(Util::get_timestamp_us() - start);
+}
+
+Scene::ValidationResult
+SceneMultiDraw::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneMultiDraw::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("SubmitTime", "submit_time",
+                                                   priv_->submit_stats));
+}
+
+void
+SceneMultiDraw::reset_measurements()
+{
+    priv_->submit_stats.reset();
+}
+
+std::vector<Scene::Rate>
+SceneMultiDraw::rates()
+{
+    double elapsed = elapsed_time();
+    double draws = static_cast<double>(priv_->draws) * frame_count();
+
+    return std::vector<Rate>(1, Rate("DrawsPerSecond", "draws_per_second",
+                                     elapsed > 0.0 ? draws / elapsed : 0.0));
+}
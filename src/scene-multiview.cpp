@@ -0,0 +1,443 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "mat.h"
+#include "options.h"
+#include "shader-source.h"
+#include "model.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+
+using LibMatrix::mat4;
+using LibMatrix::vec3;
+using LibMatrix::vec4;
+
+struct SceneMultiviewPrivate {
+    /* The views of a stereo pair, one per eye */
+    static const unsigned int views = 2;
+
+    SceneMultiviewPrivate() :
+        multiview(false), ninstances(0), width(0), height(0),
+        model_scale(1.0f), quad_buffer(0), color_tex(0), depth_tex(0)
+    {
+        for (unsigned int i = 0; i < views; i++)
+            fbos[i] = 0;
+    }
+
+    bool multiview;
+    unsigned int ninstances;
+    /* The size of a view */
+    int width;
+    int height;
+
+    Program program;
+    Program composite_program;
+    Mesh mesh;
+    vec3 model_center;
+    float model_scale;
+    GLuint quad_buffer;
+
+    /*
+     * The views are the layers of the color and depth array textures. With
+     * multiview the first framebuffer has all the layers attached,
+     * otherwise each framebuffer has the layer of a view.
+     */
+    GLuint color_tex;
+    GLuint depth_tex;
+    GLuint fbos[views];
+
+    std::vector<vec4> colors;
+    std::vector<mat4> models;
+
+    void release()
+    {
+        for (unsigned int i = 0; i < views; i++) {
+            if (fbos[i]) {
+                GLExtensions::DeleteFramebuffers(1, &fbos[i]);
+                fbos[i] = 0;
+            }
+        }
+
+        GLuint textures[] = { color_tex, depth_tex };
+        for (unsigned int i = 0; i < sizeof(textures) / sizeof(*textures); i++) {
+            if (textures[i])
+                glDeleteTextures(1, &textures[i]);
+        }
+        color_tex = 0;
+        depth_tex = 0;
+
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        mesh.reset();
+
+        program.stop();
+        program.release();
+        composite_program.stop();
+        composite_program.release();
+    }
+
+    /* Creates an array texture with a layer per view */
+    GLuint create_texture(GLint internal_format, GLenum format, GLenum type)
+    {
+        GLuint tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        GLExtensions::TexImage3D(GL_TEXTURE_2D_ARRAY, 0, internal_format, width, height,
+                                 views, 0, format, type, 0);
+        return tex;
+    }
+
+    /* Draws the instances, to all the views or to the view in ViewIndex */
+    void draw_instances()
+    {
+        for (unsigned int i = 0; i < ninstances; i++) {
+            mat4 normal_matrix(models[i]);
+            normal_matrix.inverse().transpose();
+
+            program["ModelMatrix"] = models[i];
+            program["NormalMatrix"] = normal_matrix;
+            program["MaterialColor"] = colors[i];
+            mesh.render_vbo();
+        }
+    }
+};
+
+SceneMultiview::SceneMultiview(Canvas &pCanvas) :
+    Scene(pCanvas, "multiview")
+{
+    priv_ = new SceneMultiviewPrivate();
+
+    const ModelMap& modelMap = Model::find_models();
+    std::string optionValues;
+    for (ModelMap::const_iterator modelIt = modelMap.begin();
+         modelIt != modelMap.end();
+         modelIt++)
+    {
+        if (!optionValues.empty())
+            optionValues += ",";
+        optionValues += modelIt->first;
+    }
+
+    options_["model"] = Scene::Option("model", "horse", "Which model to use",
+                                      optionValues);
+    options_["instances"] = Scene::Option("instances", "16",
+                                          "The number of instances of the model, each drawn with a draw call of its own");
+    options_["mode"] = Scene::Option("mode", "multiview",
+                                     "How the stereo views are rendered to the layers of an array texture"
+                                     " (multiview: both in a single pass with GL_OVR_multiview,"
+                                     " two-pass: each in a pass of its own)",
+                                     "multiview,two-pass");
+}
+
+SceneMultiview::~SceneMultiview()
+{
+    delete priv_;
+}
+
+bool
+SceneMultiview::supported(bool show_errors)
+{
+    if (!GLExtensions::GenFramebuffers || !GLExtensions::TexImage3D ||
+        !GLExtensions::FramebufferTextureLayer)
+    {
+        if (show_errors) {
+            Log::error("SceneMultiview requires rendering to array textures"
+                       " (GL 3.0 or GLES 3.0)\n");
+        }
+        return false;
+    }
+
+    if (options_["mode"].value == "multiview") {
+        GLint max_views = 0;
+        if (GLExtensions::FramebufferTextureMultiviewOVR)
+            glGetIntegerv(GL_MAX_VIEWS_OVR, &max_views);
+
+        if (max_views < static_cast<GLint>(SceneMultiviewPrivate::views)) {
+            if (show_errors) {
+                Log::error("SceneMultiview mode=multiview requires GL_OVR_multiview"
+                           " with at least %u views\n", SceneMultiviewPrivate::views);
+            }
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+SceneMultiview::load()
+{
+    running_ = false;
+    return true;
+}
+
+void
+SceneMultiview::unload()
+{
+}
+
+bool
+SceneMultiview::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/multiview.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/multiview.frag");
+    static const std::string vtx_composite_filename(Options::data_path + "/shaders/multiview-composite.vert");
+    static const std::string frg_composite_filename(Options::data_path + "/shaders/multiview-composite.frag");
+
+    SceneMultiviewPrivate &p(*priv_);
+
+    /* Parse the options, each view gets half of the canvas */
+    p.ninstances = Util::fromString<unsigned int>(options_["instances"].value);
+    p.multiview = options_["mode"].value == "multiview";
+    p.width = std::max(canvas_.width() / 2, 1);
+    p.height = canvas_.height();
+
+    if (p.ninstances == 0) {
+        Log::error("The instances option must be at least 1\n");
+        return false;
+    }
+
+    /* Load the programs */
+    ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+    ShaderSource vtx_composite_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_composite_source(ShaderSource::ShaderTypeFragment);
+
+    vtx_source.append(Scene::glsl3_shader_version());
+    if (p.multiview) {
+        vtx_source.append("#extension GL_OVR_multiview : require\n");
+        vtx_source.append("#define MULTIVIEW\n");
+    }
+    vtx_source.append_file(vtx_shader_filename);
+    frg_source.append(Scene::glsl3_shader_version());
+    frg_source.append_file(frg_shader_filename);
+    vtx_composite_source.append(Scene::glsl3_shader_version());
+    vtx_composite_source.append_file(vtx_composite_filename);
+    frg_composite_source.append(Scene::glsl3_shader_version());
+    frg_composite_source.append_file(frg_composite_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()) ||
+        !Scene::load_shaders_from_strings(p.composite_program,
+                                          vtx_composite_source.str(),
+                                          frg_composite_source.str()))
+    {
+        return false;
+    }
+
+    p.composite_program.start();
+    p.composite_program["Views"] = 0;
+    p.composite_program.stop();
+
+    /* Load the model */
+    Model model;
+    if (!model.load(options_["model"].value))
+        return false;
+
+    if (model.needNormals())
+        model.calculate_normals();
+
+    std::vector<std::pair<Model::AttribType, int> > attribs;
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
+    model.convert_to_mesh(p.mesh, attribs, true);
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(p.program["position"].location());
+    attrib_locations.push_back(p.program["normal"].location());
+    p.mesh.set_attrib_locations(attrib_locations);
+    p.mesh.build_vbo();
+
+    vec3 model_min(model.minVec());
+    vec3 model_max(model.maxVec());
+    p.model_center = (model_min + model_max) / 2.0;
+    p.model_scale = 1.0f / (model_max - model_min).length();
+
+    p.colors.resize(p.ninstances);
+    for (unsigned int i = 0; i < p.ninstances; i++) {
+        float hue = static_cast<float>(i) / p.ninstances;
+        p.colors[i] = vec4(0.5f + 0.5f * std::cos(6.2832f * hue),
+                           0.5f + 0.5f * std::cos(6.2832f * (hue + 0.33f)),
+                           0.5f + 0.5f * std::cos(6.2832f * (hue + 0.67f)),
+                           1.0f);
+    }
+    p.models.assign(p.ninstances, mat4());
+
+    /* Create the full-screen quad, drawn as a triangle strip */
+    p.quad_buffer = FullscreenQuad::create();
+
+    /* Create the views and their framebuffers */
+    p.color_tex = p.create_texture(GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    p.depth_tex = p.create_texture(GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT,
+                                   GL_UNSIGNED_INT);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    unsigned int nfbos = p.multiview ? 1 : SceneMultiviewPrivate::views;
+    GLExtensions::GenFramebuffers(nfbos, p.fbos);
+
+    for (unsigned int i = 0; i < nfbos; i++) {
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbos[i]);
+
+        if (p.multiview) {
+            GLExtensions::FramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                                         p.color_tex, 0, 0,
+                                                         SceneMultiviewPrivate::views);
+            GLExtensions::FramebufferTextureMultiviewOVR(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                                         p.depth_tex, 0, 0,
+                                                         SceneMultiviewPrivate::views);
+        }
+        else {
+            GLExtensions::FramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                                  p.color_tex, 0, i);
+            GLExtensions::FramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                                                  p.depth_tex, 0, i);
+        }
+
+        GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+            Log::error("Failed to create the framebuffer of the views (status 0x%x)\n",
+                       status);
+            return false;
+        }
+    }
+
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneMultiview::teardown()
+{
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+    glViewport(0, 0, canvas_.width(), canvas_.height());
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneMultiview::update()
+{
+    Scene::update();
+
+    SceneMultiviewPrivate &p(*priv_);
+    double elapsed_time = animation_time();
+
+    /* The instances are in a grid, each spinning on its own */
+    unsigned int columns = static_cast<unsigned int>(std::ceil(std::sqrt(p.ninstances)));
+    unsigned int rows = (p.ninstances + columns - 1) / columns;
+    float spacing = 3.0f / columns;
+    float scale = p.model_scale * spacing * 1.2f;
+
+    for (unsigned int i = 0; i < p.ninstances; i++) {
+        float x = (i % columns - (columns - 1) / 2.0f) * spacing;
+        float y = (i / columns - (rows - 1) / 2.0f) * spacing;
+
+        mat4 model(LibMatrix::Mat4::translate(x, y, 0.0f));
+        model *= LibMatrix::Mat4::rotate(30.0 * elapsed_time + 20.0 * i, 0.0f, 1.0f, 0.0f);
+        model *= LibMatrix::Mat4::scale(scale, scale, scale);
+        model *= LibMatrix::Mat4::translate(-p.model_center.x(), -p.model_center.y(),
+                                            -p.model_center.z());
+        p.models[i] = model;
+    }
+}
+
+void
+SceneMultiview::draw()
+{
+    SceneMultiviewPrivate &p(*priv_);
+    static const float eye_separation = 0.3f;
+
+    /* The views of the eyes, side by side, looking straight ahead */
+    mat4 projection(LibMatrix::Mat4::perspective(50.0, static_cast<float>(p.width) / p.height,
+                                                 2.0, 30.0));
+
+    p.program.start();
+    for (unsigned int i = 0; i < SceneMultiviewPrivate::views; i++) {
+        float eye_x = (i == 0 ? -0.5f : 0.5f) * eye_separation;
+        mat4 view_projection(projection);
+        view_projection *= LibMatrix::Mat4::lookAt(eye_x, 0.0, 6.0, eye_x, 0.0, 0.0,
+                                                   0.0, 1.0, 0.0);
+        p.program[std::string("ViewProjectionMatrix[") + Util::toString(i) + "]"] =
+            view_projection;
+    }
+
+    glViewport(0, 0, p.width, p.height);
+    glClearColor(0.1f, 0.1f, 0.15f, 1.0f);
+
+    if (p.multiview) {
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbos[0]);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        p.draw_instances();
+    }
+    else {
+        for (unsigned int i = 0; i < SceneMultiviewPrivate::views; i++) {
+            GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbos[i]);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            p.program["ViewIndex"] = static_cast<int>(i);
+            p.draw_instances();
+        }
+    }
+
+    /* Show the views side by side, as a headset compositor would */
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+    glViewport(0, 0, canvas_.width(), canvas_.height());
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, p.color_tex);
+    p.composite_program.start();
+
+    GLint position_location = p.composite_program["position"].location();
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glDisable(GL_DEPTH_TEST);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glEnable(GL_DEPTH_TEST);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneMultiview::validate()
+{
+    return Scene::ValidationUnknown;
+}
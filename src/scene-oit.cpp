@@ -0,0 +1,719 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "mat.h"
+#include "options.h"
+#include "shader-source.h"
+#include "model.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <stdint.h>
+
+using LibMatrix::mat4;
+using LibMatrix::vec3;
+using LibMatrix::vec4;
+
+struct SceneOITPrivate {
+    enum Mode {
+        ModeSorted,
+        ModeUnsorted,
+        ModeWeighted,
+        ModeLinkedList
+    };
+
+    struct Instance {
+        vec3 position;
+        vec3 axis;
+        float phase;
+        float speed;
+        vec4 color;
+    };
+
+    /* The view depth of an instance, to sort the instances by */
+    struct DepthIndex {
+        float depth;
+        unsigned int index;
+    };
+
+    SceneOITPrivate() :
+        mode(ModeSorted), ninstances(0), list_nodes(0), max_fragments(0),
+        width(0), height(0), model_scale(1.0f), quad_buffer(0), fbo(0),
+        accum_tex(0), weight_tex(0), heads_buffer(0), nodes_buffer(0),
+        max_nodes(0), sort_time(0), sorts(0) {}
+
+    Mode mode;
+    unsigned int ninstances;
+    unsigned int list_nodes;
+    unsigned int max_fragments;
+    int width;
+    int height;
+
+    Program program;
+    Program resolve_program;
+    Mesh mesh;
+    vec3 model_center;
+    float model_scale;
+    GLuint quad_buffer;
+
+    /* The accumulation targets of weighted blended OIT */
+    GLuint fbo;
+    GLuint accum_tex;
+    GLuint weight_tex;
+
+    /* The per-pixel lists: the heads and node count, and the nodes */
+    GLuint heads_buffer;
+    GLuint nodes_buffer;
+    unsigned int max_nodes;
+
+    std::vector<Instance> instances;
+    std::vector<mat4> model_views;
+    std::vector<DepthIndex> order;
+    mat4 projection;
+
+    /* The time spent sorting on the CPU, in microseconds */
+    uint64_t sort_time;
+    uint64_t sorts;
+
+    void release()
+    {
+        if (fbo) {
+            GLExtensions::DeleteFramebuffers(1, &fbo);
+            fbo = 0;
+        }
+
+        GLuint textures[] = { accum_tex, weight_tex };
+        for (unsigned int i = 0; i < sizeof(textures) / sizeof(*textures); i++) {
+            if (textures[i])
+                glDeleteTextures(1, &textures[i]);
+        }
+        accum_tex = 0;
+        weight_tex = 0;
+
+        GLuint buffers[] = { quad_buffer, heads_buffer, nodes_buffer };
+        for (unsigned int i = 0; i < sizeof(buffers) / sizeof(*buffers); i++) {
+            if (buffers[i])
+                glDeleteBuffers(1, &buffers[i]);
+        }
+        quad_buffer = 0;
+        heads_buffer = 0;
+        nodes_buffer = 0;
+
+        mesh.reset();
+
+        program.stop();
+        program.release();
+        resolve_program.stop();
+        resolve_program.release();
+    }
+
+    /* Creates an accumulation target, of the size of the canvas */
+    GLuint create_texture()
+    {
+        GLuint tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0,
+                     GL_RGBA, GL_HALF_FLOAT, 0);
+        return tex;
+    }
+
+    /* Draws the full-screen quad with a program */
+    void draw_quad(Program &quad_program)
+    {
+        GLint position_location = quad_program["position"].location();
+
+        glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+        glEnableVertexAttribArray(position_location);
+        glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glDisableVertexAttribArray(position_location);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    /* Draws the instances, in the order they have been sorted in */
+    void draw_instances()
+    {
+        program.start();
+
+        for (unsigned int i = 0; i < ninstances; i++) {
+            unsigned int n = order[i].index;
+            const mat4 &model_view(model_views[n]);
+            mat4 model_view_proj(projection);
+            model_view_proj *= model_view;
+            mat4 normal_matrix(model_view);
+            normal_matrix.inverse().transpose();
+
+            program["ModelViewProjectionMatrix"] = model_view_proj;
+            program["ModelViewMatrix"] = model_view;
+            program["NormalMatrix"] = normal_matrix;
+            program["InstanceColor"] = instances[n].color;
+            mesh.render_vbo();
+        }
+    }
+
+    static bool farther(const DepthIndex &a, const DepthIndex &b)
+    {
+        return a.depth > b.depth;
+    }
+};
+
+SceneOIT::SceneOIT(Canvas &pCanvas) :
+    Scene(pCanvas, "oit")
+{
+    priv_ = new SceneOITPrivate();
+
+    const ModelMap& modelMap = Model::find_models();
+    std::string optionValues;
+    for (ModelMap::const_iterator modelIt = modelMap.begin();
+         modelIt != modelMap.end();
+         modelIt++)
+    {
+        if (!optionValues.empty())
+            optionValues += ",";
+        optionValues += modelIt->first;
+    }
+
+    options_["model"] = Scene::Option("model", "horse", "Which model to use",
+                                      optionValues);
+    options_["instances"] = Scene::Option("instances", "64",
+                                          "The number of overlapping translucent instances of the model");
+    options_["mode"] = Scene::Option("mode", "sorted",
+                                     "How the transparency is resolved (sorted: instances sorted back to front on the CPU,"
+                                     " unsorted: blended in a fixed order, weighted: weighted blended OIT with two targets,"
+                                     " linked-list: per-pixel fragment lists sorted in a resolve pass)",
+                                     "sorted,unsorted,weighted,linked-list");
+    options_["alpha"] = Scene::Option("alpha", "0.3",
+                                      "The opacity of the instances");
+    options_["list-nodes"] = Scene::Option("list-nodes", "8",
+                                           "The average number of fragments per pixel the lists can store (with mode=linked-list)");
+    options_["max-fragments"] = Scene::Option("max-fragments", "16",
+                                              "The number of fragments of a pixel that are sorted and blended (with mode=linked-list)");
+}
+
+SceneOIT::~SceneOIT()
+{
+    delete priv_;
+}
+
+bool
+SceneOIT::supported(bool show_errors)
+{
+    const std::string &mode = options_["mode"].value;
+
+    if (mode == "weighted") {
+#if GLMARK2_USE_GLESv2
+        /* The GLSL ES 1.00 shaders write the targets with GL_EXT_draw_buffers */
+        bool float_targets = GLExtensions::version_supported(3, 0) &&
+                             (GLExtensions::support("GL_EXT_color_buffer_float") ||
+                              GLExtensions::support("GL_EXT_color_buffer_half_float"));
+        bool draw_buffers = GLExtensions::support("GL_EXT_draw_buffers");
+#else
+        bool float_targets = GLExtensions::version_supported(3, 0);
+        bool draw_buffers = true;
+#endif
+        GLint max_draw_buffers = 0;
+        if (draw_buffers && GLExtensions::DrawBuffers && GLExtensions::GenFramebuffers)
+            glGetIntegerv(GL_MAX_DRAW_BUFFERS, &max_draw_buffers);
+
+        if (!float_targets || max_draw_buffers < 2) {
+            if (show_errors) {
+                Log::error("SceneOIT mode=weighted requires multiple half float render targets"
+                           " (GLES 3.0 with GL_EXT_color_buffer_half_float and GL_EXT_draw_buffers,"
+                           " or GL 3.0)\n");
+            }
+            return false;
+        }
+    }
+    else if (mode == "linked-list") {
+        GLint max_blocks = 0;
+        if (GLExtensions::BindBufferBase && GLExtensions::MemoryBarrierGL)
+            glGetIntegerv(GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS, &max_blocks);
+
+        if (max_blocks < 2) {
+            if (show_errors) {
+                Log::error("SceneOIT mode=linked-list requires shader storage buffers"
+                           " in fragment shaders (GL 4.3 or GLES 3.1)\n");
+            }
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+SceneOIT::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneOIT::unload()
+{
+}
+
+bool
+SceneOIT::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/oit.vert");
+    static const std::string frg_blend_filename(Options::data_path + "/shaders/oit-blend.frag");
+    static const std::string frg_weighted_filename(Options::data_path + "/shaders/oit-weighted.frag");
+    static const std::string vtx_composite_filename(Options::data_path + "/shaders/effect-2d.vert");
+    static const std::string frg_composite_filename(Options::data_path + "/shaders/oit-weighted-composite.frag");
+    static const std::string vtx_list_filename(Options::data_path + "/shaders/oit-list.vert");
+    static const std::string frg_list_filename(Options::data_path + "/shaders/oit-list-build.frag");
+    static const std::string vtx_resolve_filename(Options::data_path + "/shaders/oit-list-resolve.vert");
+    static const std::string frg_resolve_filename(Options::data_path + "/shaders/oit-list-resolve.frag");
+
+    SceneOITPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.ninstances = Util::fromString<unsigned int>(options_["instances"].value);
+    p.list_nodes = Util::fromString<unsigned int>(options_["list-nodes"].value);
+    p.max_fragments = Util::fromString<unsigned int>(options_["max-fragments"].value);
+    float alpha = Util::fromString<float>(options_["alpha"].value);
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+    p.sort_time = 0;
+    p.sorts = 0;
+
+    if (p.ninstances == 0 || p.list_nodes == 0 || p.max_fragments == 0) {
+        Log::error("The instances, list-nodes and max-fragments options must be at least 1\n");
+        return false;
+    }
+
+    if (alpha <= 0.0f || alpha > 1.0f) {
+        Log::error("The alpha must be in (0, 1]\n");
+        return false;
+    }
+
+    const std::string &mode = options_["mode"].value;
+    if (mode == "unsorted")
+        p.mode = SceneOITPrivate::ModeUnsorted;
+    else if (mode == "weighted")
+        p.mode = SceneOITPrivate::ModeWeighted;
+    else if (mode == "linked-list")
+        p.mode = SceneOITPrivate::ModeLinkedList;
+    else
+        p.mode = SceneOITPrivate::ModeSorted;
+
+    /* Load the programs */
+    if (p.mode == SceneOITPrivate::ModeLinkedList) {
+        std::stringstream ss;
+        ss << p.max_fragments;
+
+        ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+        ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+        ShaderSource vtx_resolve_source(ShaderSource::ShaderTypeVertex);
+        ShaderSource frg_resolve_source(ShaderSource::ShaderTypeFragment);
+
+        vtx_source.append(Scene::compute_shader_version());
+        vtx_source.append_file(vtx_list_filename);
+        frg_source.append(Scene::compute_shader_version());
+        frg_source.append_file(frg_list_filename);
+        frg_source.precision(ShaderSource::Precision("high,high,,"));
+        vtx_resolve_source.append(Scene::compute_shader_version());
+        vtx_resolve_source.append_file(vtx_resolve_filename);
+        frg_resolve_source.append(Scene::compute_shader_version());
+        frg_resolve_source.append_file(frg_resolve_filename);
+        frg_resolve_source.replace("MAX_FRAGMENTS", ss.str());
+        frg_resolve_source.precision(ShaderSource::Precision("high,high,,"));
+
+        if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                              frg_source.str()) ||
+            !Scene::load_shaders_from_strings(p.resolve_program, vtx_resolve_source.str(),
+                                              frg_resolve_source.str()))
+        {
+            return false;
+        }
+    }
+    else {
+        ShaderSource vtx_source(vtx_shader_filename);
+        ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+        if (p.mode == SceneOITPrivate::ModeWeighted) {
+#if GLMARK2_USE_GLESv2
+            frg_source.append("#extension GL_EXT_draw_buffers : require\n");
+#endif
+            frg_source.append_file(frg_weighted_filename);
+        }
+        else {
+            frg_source.append_file(frg_blend_filename);
+        }
+
+        if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                              frg_source.str()))
+        {
+            return false;
+        }
+
+        if (p.mode == SceneOITPrivate::ModeWeighted) {
+            ShaderSource vtx_composite_source(vtx_composite_filename);
+            ShaderSource frg_composite_source(frg_composite_filename);
+
+            if (!Scene::load_shaders_from_strings(p.resolve_program,
+                                                  vtx_composite_source.str(),
+                                                  frg_composite_source.str()))
+            {
+                return false;
+            }
+
+            p.resolve_program.start();
+            p.resolve_program["AccumTexture"] = 0;
+            p.resolve_program["WeightTexture"] = 1;
+            p.resolve_program.stop();
+        }
+    }
+
+    /* Load the model */
+    Model model;
+    if (!model.load(options_["model"].value))
+        return false;
+
+    if (model.needNormals())
+        model.calculate_normals();
+
+    std::vector<std::pair<Model::AttribType, int> > attribs;
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
+    model.convert_to_mesh(p.mesh, attribs, true);
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(p.program["position"].location());
+    attrib_locations.push_back(p.program["normal"].location());
+    p.mesh.set_attrib_locations(attrib_locations);
+    p.mesh.build_vbo();
+
+    vec3 model_min(model.minVec());
+    vec3 model_max(model.maxVec());
+    p.model_center = (model_min + model_max) / 2.0;
+    p.model_scale = 3.0f / (model_max - model_min).length();
+
+    /*
+     * Scatter the instances in a sphere, each spinning around an axis of
+     * its own, so that they overlap in an order that keeps changing. A
+     * fixed seed keeps the rendered content the same for every run.
+     */
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    float radius = 2.5f;
+
+    p.instances.resize(p.ninstances);
+    for (unsigned int i = 0; i < p.ninstances; i++) {
+        SceneOITPrivate::Instance &instance(p.instances[i]);
+        vec3 position;
+        do {
+            position = vec3(unit(random), unit(random), unit(random));
+        } while (position.length() > 1.0f);
+
+        vec3 axis;
+        do {
+            axis = vec3(unit(random), unit(random), unit(random));
+        } while (axis.length() < 0.1f || axis.length() > 1.0f);
+        axis.normalize();
+
+        float hue = static_cast<float>(i) / p.ninstances;
+        instance.position = position * radius;
+        instance.axis = axis;
+        instance.phase = 180.0f * unit(random);
+        instance.speed = 20.0f + 10.0f * unit(random);
+        instance.color = vec4(0.5f + 0.5f * std::cos(6.2832f * hue),
+                              0.5f + 0.5f * std::cos(6.2832f * (hue + 0.33f)),
+                              0.5f + 0.5f * std::cos(6.2832f * (hue + 0.67f)),
+                              alpha);
+    }
+
+    p.model_views.assign(p.ninstances, mat4());
+    p.order.resize(p.ninstances);
+    for (unsigned int i = 0; i < p.ninstances; i++) {
+        p.order[i].depth = 0.0f;
+        p.order[i].index = i;
+    }
+
+    p.projection = LibMatrix::Mat4::perspective(50.0, static_cast<float>(p.width) / p.height,
+                                                2.0, 30.0);
+
+    /* Create the full-screen quad, drawn as a triangle strip */
+    if (p.mode == SceneOITPrivate::ModeWeighted ||
+        p.mode == SceneOITPrivate::ModeLinkedList)
+    {
+        p.quad_buffer = FullscreenQuad::create();
+    }
+
+    /* Create the accumulation targets */
+    if (p.mode == SceneOITPrivate::ModeWeighted) {
+        p.accum_tex = p.create_texture();
+        p.weight_tex = p.create_texture();
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        GLExtensions::GenFramebuffers(1, &p.fbo);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+        GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                           GL_TEXTURE_2D, p.accum_tex, 0);
+        GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1,
+                                           GL_TEXTURE_2D, p.weight_tex, 0);
+
+        static const GLenum draw_buffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+        GLExtensions::DrawBuffers(2, draw_buffers);
+
+        GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+        if (status != GL_FRAMEBUFFER_COMPLETE) {
+            Log::error("Failed to create the accumulation targets (status 0x%x)\n", status);
+            return false;
+        }
+    }
+
+    /*
+     * Create the per-pixel lists. The heads start empty, and the resolve
+     * pass empties them again as it reads them. The nodes are limited by
+     * the largest shader storage block.
+     */
+    if (p.mode == SceneOITPrivate::ModeLinkedList) {
+        size_t pixels = static_cast<size_t>(p.width) * p.height;
+        GLint max_block_size = 0;
+        glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &max_block_size);
+
+        uint64_t max_nodes = static_cast<uint64_t>(pixels) * p.list_nodes;
+        if (max_block_size > 0)
+            max_nodes = std::min<uint64_t>(max_nodes, static_cast<uint64_t>(max_block_size) / 16);
+        p.max_nodes = static_cast<unsigned int>(max_nodes);
+
+        Log::debug("SceneOIT: %u list nodes (%.1f MiB)\n", p.max_nodes,
+                   p.max_nodes * 16.0 / (1024.0 * 1024.0));
+
+        std::vector<GLuint> heads(pixels + 1, 0);
+        glGenBuffers(1, &p.heads_buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, p.heads_buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, heads.size() * sizeof(GLuint),
+                     &heads[0], GL_DYNAMIC_DRAW);
+
+        glGenBuffers(1, &p.nodes_buffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, p.nodes_buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<size_t>(p.max_nodes) * 16,
+                     0, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        p.program.start();
+        p.program["Width"] = p.width;
+        p.program["MaxNodes"] = static_cast<int>(p.max_nodes);
+        p.resolve_program.start();
+        p.resolve_program["Width"] = p.width;
+        p.resolve_program.stop();
+    }
+
+    /* Translucent surfaces don't hide each other */
+    glDisable(GL_DEPTH_TEST);
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneOIT::teardown()
+{
+    SceneOITPrivate &p(*priv_);
+
+    if (p.sorts > 0) {
+        Log::debug("SceneOIT: %.1f us sorting per frame\n",
+                   static_cast<double>(p.sort_time) / p.sorts);
+    }
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    for (unsigned int i = 0; i < 2; i++) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    if (GLExtensions::BindBufferBase) {
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, 0);
+    }
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneOIT::update()
+{
+    Scene::update();
+
+    SceneOITPrivate &p(*priv_);
+    double elapsed_time = animation_time();
+
+    mat4 view(LibMatrix::Mat4::lookAt(0.0, 0.0, 11.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0));
+    view *= LibMatrix::Mat4::rotate(10.0 * elapsed_time, 0.0f, 1.0f, 0.0f);
+
+    for (unsigned int i = 0; i < p.ninstances; i++) {
+        const SceneOITPrivate::Instance &instance(p.instances[i]);
+        mat4 model_view(view);
+        model_view *= LibMatrix::Mat4::translate(instance.position.x(),
+                                                 instance.position.y(),
+                                                 instance.position.z());
+        model_view *= LibMatrix::Mat4::rotate(instance.phase + instance.speed * elapsed_time,
+                                              instance.axis.x(), instance.axis.y(),
+                                              instance.axis.z());
+        model_view *= LibMatrix::Mat4::scale(p.model_scale, p.model_scale, p.model_scale);
+        model_view *= LibMatrix::Mat4::translate(-p.model_center.x(), -p.model_center.y(),
+                                                 -p.model_center.z());
+        p.model_views[i] = model_view;
+    }
+
+    /*
+     * Sort the instances back to front by the depth of their centers.
+     * This gets the order of the instances right, but not the order of
+     * the surfaces of an instance, nor of instances that intersect.
+     */
+    if (p.mode == SceneOITPrivate::ModeSorted) {
+        uint64_t start = Util::get_timestamp_us();
+
+        for (unsigned int i = 0; i < p.ninstances; i++) {
+            const vec3 &position(p.instances[i].position);
+            vec4 center(view * vec4(position.x(), position.y(), position.z(), 1.0f));
+            p.order[i].depth = -center.z();
+            p.order[i].index = i;
+        }
+        std::sort(p.order.begin(), p.order.end(), SceneOITPrivate::farther);
+
+        p.sort_time += Util::get_timestamp_us() - start;
+        p.sorts++;
+    }
+}
+
+void
+SceneOIT::draw()
+{
+    SceneOITPrivate &p(*priv_);
+
+    if (p.mode == SceneOITPrivate::ModeSorted ||
+        p.mode == SceneOITPrivate::ModeUnsorted)
+    {
+        /* The canvas keeps its alpha, so that captures stay opaque */
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+        p.draw_instances();
+    }
+    else if (p.mode == SceneOITPrivate::ModeWeighted) {
+        /*
+         * Accumulate the weighted colors and the weights, and multiply
+         * the revealage in the alpha of the first target, since blend
+         * functions can't be set per target in GLES 3.0.
+         */
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+        glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+        p.draw_instances();
+
+        /* Composite the average color over the canvas */
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, p.accum_tex);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, p.weight_tex);
+        glActiveTexture(GL_TEXTURE0);
+
+        p.resolve_program.start();
+        p.draw_quad(p.resolve_program);
+    }
+    else {
+        /* Store the fragments in the lists, without writing the canvas */
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, p.heads_buffer);
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, p.nodes_buffer);
+
+        glDisable(GL_BLEND);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        p.draw_instances();
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+        GLExtensions::MemoryBarrierGL(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        /* Blend the sorted fragments of each pixel over the canvas */
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_SRC_ALPHA, GL_ZERO, GL_ONE);
+        p.resolve_program.start();
+        p.draw_quad(p.resolve_program);
+
+        GLExtensions::MemoryBarrierGL(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+
+    glDisable(GL_BLEND);
+}
+
+Scene::ValidationResult
+SceneOIT::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+void
+SceneOIT::reset_measurements()
+{
+    priv_->sort_time = 0;
+    priv_->sorts = 0;
+}
+
+std::vector<Scene::Rate>
+SceneOIT::rates()
+{
+    SceneOITPrivate &p(*priv_);
+    double elapsed = elapsed_time();
+    double instances = static_cast<double>(p.ninstances) * frame_count();
+    std::vector<Rate> rates;
+
+    rates.push_back(Rate("InstancesPerSecond", "instances_per_second",
+                         elapsed > 0.0 ? instances / elapsed : 0.0));
+    if (p.mode == SceneOITPrivate::ModeSorted) {
+        rates.push_back(Rate("SortMicrosecondsPerFrame", "sort_us_per_frame",
+                             p.sorts > 0 ? static_cast<double>(p.sort_time) / p.sorts : 0.0));
+    }
+
+    return rates;
+}
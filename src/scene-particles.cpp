@@ -0,0 +1,385 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+
+/* The gravity applied to the particles, matching the vertex shader */
+static const float particle_gravity = -1.5f;
+
+/* The particle layout in the static buffer: origin, emission time, velocity */
+struct Particle {
+    float particle[4];
+    float velocity[3];
+};
+
+struct SceneParticlesPrivate {
+    SceneParticlesPrivate() :
+        particles(0), size(0.0f), lifetime(0.0f), gpu_update(false),
+        instanced(false), particle_buffer(0), state_buffer(0),
+        corner_buffer(0) {}
+
+    unsigned int particles;
+    float size;
+    float lifetime;
+    bool gpu_update;
+    bool instanced;
+
+    Program program;
+    /* The emitted particles, read by the GPU update or the CPU one */
+    std::vector<Particle> emitted;
+    GLuint particle_buffer;
+    /* The positions and ages written by the CPU update each frame */
+    std::vector<float> state;
+    GLuint state_buffer;
+    /* The corners of the instanced quads */
+    GLuint corner_buffer;
+
+    void release()
+    {
+        GLuint buffers[] = { particle_buffer, state_buffer, corner_buffer };
+
+        for (unsigned int i = 0; i < sizeof(buffers) / sizeof(*buffers); i++) {
+            if (buffers[i])
+                glDeleteBuffers(1, &buffers[i]);
+        }
+        particle_buffer = 0;
+        state_buffer = 0;
+        corner_buffer = 0;
+
+        std::vector<Particle>().swap(emitted);
+        std::vector<float>().swap(state);
+
+        program.stop();
+        program.release();
+    }
+
+    /* Evaluates the particles on the CPU, as update() in the vertex shader */
+    void update_cpu(float time)
+    {
+        for (unsigned int i = 0; i < particles; i++) {
+            const Particle &p(emitted[i]);
+            float age = std::fmod(time - p.particle[3], lifetime);
+            float *s = &state[4 * i];
+
+            s[0] = p.particle[0] + p.velocity[0] * age;
+            s[1] = p.particle[1] + p.velocity[1] * age + 0.5f * particle_gravity * age * age;
+            s[2] = p.particle[2] + p.velocity[2] * age;
+            s[3] = age;
+        }
+    }
+};
+
+SceneParticles::SceneParticles(Canvas &pCanvas) :
+    Scene(pCanvas, "particles")
+{
+    priv_ = new SceneParticlesPrivate();
+    options_["particles"] = Scene::Option("particles", "100000",
+                                          "The number of particles (sweep: 10k to 10M)");
+    Util::split("10000,100000,1000000,10000000", ',',
+                options_["particles"].sweep_values, Util::SplitModeNormal);
+    options_["update"] = Scene::Option("update", "gpu",
+                                       "Where the particles are updated: in the vertex shader, or on the CPU and uploaded each frame",
+                                       "gpu,cpu");
+    options_["sprite"] = Scene::Option("sprite", "point",
+                                       "How the particles are drawn: as point sprites, or as instanced quads",
+                                       "point,quad");
+    options_["size"] = Scene::Option("size", "8",
+                                     "The size of the particles, in pixels");
+    options_["lifetime"] = Scene::Option("lifetime", "2",
+                                         "The lifetime of the particles, in seconds");
+}
+
+SceneParticles::~SceneParticles()
+{
+    delete priv_;
+}
+
+bool
+SceneParticles::supported(bool show_errors)
+{
+    if (options_["sprite"].value == "quad" &&
+        (GLExtensions::DrawArraysInstanced == 0 ||
+         GLExtensions::VertexAttribDivisor == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested instanced quads but instanced arrays"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneParticles::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneParticles::unload()
+{
+}
+
+bool
+SceneParticles::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/particles.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/particles.frag");
+
+    SceneParticlesPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.particles = Util::fromString<unsigned int>(options_["particles"].value);
+    p.size = Util::fromString<float>(options_["size"].value);
+    p.lifetime = Util::fromString<float>(options_["lifetime"].value);
+    p.gpu_update = options_["update"].value != "cpu";
+    p.instanced = options_["sprite"].value == "quad";
+
+    if (p.particles == 0 || p.size <= 0.0f || p.lifetime <= 0.0f) {
+        Log::error("The particles, size and lifetime options must be positive\n");
+        return false;
+    }
+
+    if (!p.instanced) {
+        GLfloat range[2] = { 0.0f, 0.0f };
+        glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, range);
+        if (p.size > range[1]) {
+            Log::info("Warning: Clamping the point size %.1f to the maximum %.1f,"
+                      " use sprite=quad for larger particles\n", p.size, range[1]);
+            p.size = range[1];
+        }
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source;
+
+#if !GLMARK2_USE_GLESv2
+    /* gl_PointCoord is only available since GLSL 1.20 */
+    if (!p.instanced)
+        frg_source.append("#version 120\n");
+#endif
+    frg_source.append_file(frg_shader_filename);
+
+    vtx_source.replace("UPDATE", p.gpu_update ? "update(particle, velocity)" : "particle");
+    vtx_source.replace("CORNER", p.instanced ? "corner" : "vec2(0.0)");
+    frg_source.replace("SPRITE_COORD", p.instanced ? "SpriteCoord" : "gl_PointCoord");
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    /*
+     * Emit the particles from a fountain at the bottom of the view, spread
+     * over a lifetime so the stream is steady from the first frame. A fixed
+     * seed keeps the rendered content the same for every run.
+     */
+    p.emitted.resize(p.particles);
+    unsigned int seed = 1;
+
+    for (unsigned int i = 0; i < p.particles; i++) {
+        float r[4];
+        for (unsigned int c = 0; c < 4; c++) {
+            seed = seed * 1103515245 + 12345;
+            r[c] = ((seed >> 8) & 0xffff) / 65535.0f;
+        }
+
+        float angle = 0.35f * (2.0f * r[0] - 1.0f);
+        float speed = 1.6f + 0.4f * r[1];
+
+        Particle &particle(p.emitted[i]);
+        particle.particle[0] = 0.05f * (2.0f * r[2] - 1.0f);
+        particle.particle[1] = -0.9f;
+        particle.particle[2] = 0.0f;
+        particle.particle[3] = -p.lifetime * r[3];
+        particle.velocity[0] = speed * std::sin(angle);
+        particle.velocity[1] = speed * std::cos(angle);
+        particle.velocity[2] = 0.0f;
+    }
+
+    if (p.gpu_update) {
+        glGenBuffers(1, &p.particle_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, p.particle_buffer);
+        glBufferData(GL_ARRAY_BUFFER, p.emitted.size() * sizeof(Particle),
+                     &p.emitted[0], GL_STATIC_DRAW);
+
+        /* The CPU copy is only needed by the CPU update */
+        std::vector<Particle>().swap(p.emitted);
+    }
+    else {
+        p.state.resize(4 * p.particles);
+        glGenBuffers(1, &p.state_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, p.state_buffer);
+        glBufferData(GL_ARRAY_BUFFER, p.state.size() * sizeof(float), 0, GL_STREAM_DRAW);
+    }
+
+    if (p.instanced) {
+        static const GLfloat corners[] = {
+            -1.0f, -1.0f,
+             1.0f, -1.0f,
+            -1.0f,  1.0f,
+             1.0f,  1.0f
+        };
+
+        glGenBuffers(1, &p.corner_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, p.corner_buffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    p.program.start();
+    p.program["Lifetime"] = p.lifetime;
+    p.program["PointSize"] = p.size;
+    p.program["SpriteSize"] = LibMatrix::vec2(p.size / canvas_.width(),
+                                              p.size / canvas_.height());
+
+    /* Draw the particles with additive blending, in any order */
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+#if !GLMARK2_USE_GLESv2
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glEnable(GL_POINT_SPRITE);
+#endif
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneParticles::teardown()
+{
+#if !GLMARK2_USE_GLESv2
+    glDisable(GL_POINT_SPRITE);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+#endif
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneParticles::update()
+{
+    Scene::update();
+}
+
+void
+SceneParticles::draw()
+{
+    SceneParticlesPrivate &p(*priv_);
+
+    /*
+     * Use a fixed time step, so that the simulation only depends on the
+     * number of frames and not on the speed of the implementation.
+     */
+    static const float dt = 1.0f / 60.0f;
+    float t = currentFrame_ * dt;
+
+    GLint particle_location = p.program["particle"].location();
+    GLint velocity_location = p.program["velocity"].location();
+    GLint corner_location = p.program["corner"].location();
+
+    if (p.gpu_update) {
+        p.program["Time"] = t;
+
+        glBindBuffer(GL_ARRAY_BUFFER, p.particle_buffer);
+        glEnableVertexAttribArray(particle_location);
+        glVertexAttribPointer(particle_location, 4, GL_FLOAT, GL_FALSE,
+                              sizeof(Particle), 0);
+        glEnableVertexAttribArray(velocity_location);
+        glVertexAttribPointer(velocity_location, 3, GL_FLOAT, GL_FALSE,
+                              sizeof(Particle),
+                              reinterpret_cast<const void *>(4 * sizeof(float)));
+    }
+    else {
+        p.update_cpu(t);
+
+        /* Orphan the last frame's data instead of waiting for its draw */
+        glBindBuffer(GL_ARRAY_BUFFER, p.state_buffer);
+        glBufferData(GL_ARRAY_BUFFER, p.state.size() * sizeof(float),
+                     &p.state[0], GL_STREAM_DRAW);
+        glEnableVertexAttribArray(particle_location);
+        glVertexAttribPointer(particle_location, 4, GL_FLOAT, GL_FALSE, 0, 0);
+    }
+
+    if (p.instanced) {
+        GLExtensions::VertexAttribDivisor(particle_location, 1);
+        if (p.gpu_update)
+            GLExtensions::VertexAttribDivisor(velocity_location, 1);
+
+        glBindBuffer(GL_ARRAY_BUFFER, p.corner_buffer);
+        glEnableVertexAttribArray(corner_location);
+        glVertexAttribPointer(corner_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+        GLExtensions::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, p.particles);
+
+        glDisableVertexAttribArray(corner_location);
+        GLExtensions::VertexAttribDivisor(particle_location, 0);
+        if (p.gpu_update)
+            GLExtensions::VertexAttribDivisor(velocity_location, 0);
+    }
+    else {
+        glDrawArrays(GL_POINTS, 0, p.particles);
+    }
+
+    if (p.gpu_update)
+        glDisableVertexAttribArray(velocity_location);
+    glDisableVertexAttribArray(particle_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneParticles::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneParticles::rates()
+{
+    double elapsed = elapsed_time();
+    double particles = static_cast<double>(priv_->particles) * frame_count();
+
+    return std::vector<Rate>(1, Rate("ParticlesPerSecond", "particles_per_second",
+                                     elapsed > 0.0 ? particles / elapsed : 0.0));
+}
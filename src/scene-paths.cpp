@@ -0,0 +1,421 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+#include <random>
+
+/*
+ * Renders filled vector paths with "stencil, then cover": the triangle fan
+ * of each path is drawn into the stencil buffer only, so that the stencil
+ * value of each pixel tells whether the path covers it (by the parity or
+ * the winding number of the triangles over it). Then a quad covering the
+ * whole path is drawn with the stencil test, which also resets the stencil
+ * for the next path.
+ *
+ * The canvas is created without a stencil buffer by default, so the paths
+ * are rendered offscreen and then drawn on the canvas.
+ */
+struct ScenePathsPrivate {
+    struct Path {
+        /* The first vertex of the fan, followed by the cover quad */
+        GLint first;
+        GLsizei count;
+        LibMatrix::vec2 center;
+        float scale;
+        float rotation_speed;
+        LibMatrix::vec4 color;
+    };
+
+    ScenePathsPrivate() :
+        nonzero(false), clear_stencil(false), rotation(0.0f), width(0), height(0),
+        buffer(0), quad_buffer(0), fbo(0), color_texture(0), stencil_rb(0) {}
+
+    std::vector<Path> paths;
+    bool nonzero;
+    bool clear_stencil;
+    float rotation;
+    int width;
+    int height;
+
+    Program program;
+    Program texture_program;
+    GLuint buffer;
+    GLuint quad_buffer;
+    GLuint fbo;
+    GLuint color_texture;
+    GLuint stencil_rb;
+
+    void release()
+    {
+        if (fbo) {
+            GLExtensions::DeleteFramebuffers(1, &fbo);
+            fbo = 0;
+        }
+        if (color_texture) {
+            glDeleteTextures(1, &color_texture);
+            color_texture = 0;
+        }
+        if (stencil_rb) {
+            GLExtensions::DeleteRenderbuffers(1, &stencil_rb);
+            stencil_rb = 0;
+        }
+        if (buffer) {
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+        texture_program.stop();
+        texture_program.release();
+    }
+
+    /*
+     * Creates the paths: star-like polygons around random centers, whose
+     * vertices have random radii, so that their edges cross each other
+     * and the fill rules make a difference.
+     */
+    void create_paths(unsigned int count, unsigned int vertices, std::vector<float> &data)
+    {
+        std::mt19937 random(1);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        paths.clear();
+
+        for (unsigned int i = 0; i < count; i++) {
+            Path path;
+
+            path.first = data.size() / 2;
+            path.count = vertices;
+            path.center = LibMatrix::vec2(unit(random) * 1.6f - 0.8f,
+                                          unit(random) * 1.6f - 0.8f);
+            path.scale = 0.1f + 0.2f * unit(random);
+            path.rotation_speed = 60.0f * unit(random) - 30.0f;
+            path.color = LibMatrix::vec4(unit(random), unit(random), unit(random), 1.0f);
+
+            for (unsigned int v = 0; v < vertices; v++) {
+                /* Go around twice, so that the outline crosses itself */
+                float angle = 4.0f * M_PI * v / vertices;
+                float radius = 0.3f + 0.7f * unit(random);
+                data.push_back(radius * std::cos(angle));
+                data.push_back(radius * std::sin(angle));
+            }
+
+            /* The cover quad, drawn as a triangle strip */
+            static const float quad[] = {
+                -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f
+            };
+            data.insert(data.end(), quad, quad + 8);
+
+            paths.push_back(path);
+        }
+    }
+};
+
+ScenePaths::ScenePaths(Canvas &pCanvas) :
+    Scene(pCanvas, "paths")
+{
+    priv_ = new ScenePathsPrivate();
+    options_["paths"] = Scene::Option("paths", "64",
+                                      "The number of paths drawn every frame");
+    options_["vertices"] = Scene::Option("vertices", "32",
+                                         "The number of vertices of the outline of each path");
+    options_["fill-rule"] = Scene::Option("fill-rule", "evenodd",
+                                          "The fill rule of the paths",
+                                          "evenodd,nonzero");
+    options_["stencil-reset"] = Scene::Option("stencil-reset", "cover",
+                                              "How the stencil is reset after each path: by the cover"
+                                              " pass, or by clearing the bounds of the path",
+                                              "cover,clear");
+}
+
+ScenePaths::~ScenePaths()
+{
+    delete priv_;
+}
+
+bool
+ScenePaths::supported(bool show_errors)
+{
+    if (!GLExtensions::GenFramebuffers) {
+        if (show_errors)
+            Log::error("ScenePaths requires GL framebuffer support\n");
+        return false;
+    }
+
+    return true;
+}
+
+bool
+ScenePaths::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+ScenePaths::unload()
+{
+}
+
+bool
+ScenePaths::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/paths.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/paths.frag");
+    static const std::string vtx_texture_shader_filename(Options::data_path + "/shaders/desktop.vert");
+    static const std::string frg_texture_shader_filename(Options::data_path + "/shaders/desktop.frag");
+
+    ScenePathsPrivate &p(*priv_);
+
+    /* Parse the options */
+    unsigned int count = Util::fromString<unsigned int>(options_["paths"].value);
+    unsigned int vertices = Util::fromString<unsigned int>(options_["vertices"].value);
+    p.nonzero = options_["fill-rule"].value == "nonzero";
+    p.clear_stencil = options_["stencil-reset"].value == "clear";
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+
+    if (count == 0 || vertices < 3) {
+        Log::error("There must be at least 1 path and 3 vertices\n");
+        return false;
+    }
+
+    /* Load the programs */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+    ShaderSource vtx_texture_source(vtx_texture_shader_filename);
+    ShaderSource frg_texture_source(frg_texture_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()) ||
+        !Scene::load_shaders_from_strings(p.texture_program, vtx_texture_source.str(),
+                                          frg_texture_source.str()))
+    {
+        return false;
+    }
+
+    p.texture_program.start();
+    p.texture_program["MaterialTexture0"] = 0;
+    p.texture_program.stop();
+
+    /* Create the paths */
+    std::vector<float> data;
+    p.create_paths(count, vertices, data);
+
+    glGenBuffers(1, &p.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, p.buffer);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0],
+                 GL_STATIC_DRAW);
+
+    /* Create the full-screen quad that shows the result on the canvas */
+    p.quad_buffer = FullscreenQuad::create(true);
+
+    /* Create the offscreen target, with an 8-bit stencil */
+    glGenTextures(1, &p.color_texture);
+    glBindTexture(GL_TEXTURE_2D, p.color_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, p.width, p.height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    GLExtensions::GenRenderbuffers(1, &p.stencil_rb);
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, p.stencil_rb);
+    GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8,
+                                      p.width, p.height);
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLExtensions::GenFramebuffers(1, &p.fbo);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, p.color_texture, 0);
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT,
+                                          GL_RENDERBUFFER, p.stencil_rb);
+    GLenum status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::error("Failed to create the stencil render target (status 0x%x)\n", status);
+        return false;
+    }
+
+    glDisable(GL_DEPTH_TEST);
+
+    p.rotation = 0.0f;
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+ScenePaths::teardown()
+{
+    glDisable(GL_STENCIL_TEST);
+    glEnable(GL_DEPTH_TEST);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+ScenePaths::update()
+{
+    Scene::update();
+
+    priv_->rotation = animation_time();
+}
+
+void
+ScenePaths::draw()
+{
+    ScenePathsPrivate &p(*priv_);
+    float aspect = static_cast<float>(p.width) / p.height;
+
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, p.fbo);
+    glViewport(0, 0, p.width, p.height);
+    glClearStencil(0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    GLint position_location = p.program["position"].location();
+    GLint mvp_location = p.program["ModelViewProjectionMatrix"].location();
+    GLint color_location = p.program["PathColor"].location();
+
+    p.program.start();
+    glBindBuffer(GL_ARRAY_BUFFER, p.buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glEnable(GL_STENCIL_TEST);
+    glStencilMask(0xff);
+
+    for (std::vector<ScenePathsPrivate::Path>::const_iterator iter = p.paths.begin();
+         iter != p.paths.end();
+         iter++)
+    {
+        const ScenePathsPrivate::Path &path(*iter);
+
+        LibMatrix::mat4 mvp(LibMatrix::Mat4::scale(1.0f / aspect, 1.0f, 1.0f));
+        mvp *= LibMatrix::Mat4::translate(path.center.x() * aspect, path.center.y(), 0.0f);
+        mvp *= LibMatrix::Mat4::rotate(path.rotation_speed * p.rotation, 0.0f, 0.0f, 1.0f);
+        mvp *= LibMatrix::Mat4::scale(path.scale, path.scale, 1.0f);
+        glUniformMatrix4fv(mvp_location, 1, GL_FALSE, mvp);
+
+        /*
+         * Stencil: count the triangles of the fan over each pixel, by their
+         * parity or their winding.
+         */
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glStencilFunc(GL_ALWAYS, 0, 0xff);
+        if (p.nonzero) {
+            glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
+            glStencilOpSeparate(GL_BACK, GL_KEEP, GL_KEEP, GL_DECR_WRAP);
+        }
+        else {
+            glStencilOp(GL_KEEP, GL_KEEP, GL_INVERT);
+        }
+        glDrawArrays(GL_TRIANGLE_FAN, path.first, path.count);
+
+        /* Cover: fill the pixels with a non-zero stencil */
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glStencilFunc(GL_NOTEQUAL, 0, p.nonzero ? 0xff : 0x01);
+        glStencilOp(GL_KEEP, GL_KEEP, p.clear_stencil ? GL_KEEP : GL_ZERO);
+        glUniform4fv(color_location, 1, path.color);
+        glDrawArrays(GL_TRIANGLE_STRIP, path.first + path.count, 4);
+
+        /* Or clear the stencil in the bounds of the path */
+        if (p.clear_stencil) {
+            float radius = path.scale * std::sqrt(2.0f);
+            int x0 = static_cast<int>(((path.center.x() - radius / aspect) * 0.5f + 0.5f) * p.width);
+            int y0 = static_cast<int>(((path.center.y() - radius) * 0.5f + 0.5f) * p.height);
+            int x1 = static_cast<int>(((path.center.x() + radius / aspect) * 0.5f + 0.5f) * p.width) + 1;
+            int y1 = static_cast<int>(((path.center.y() + radius) * 0.5f + 0.5f) * p.height) + 1;
+
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(x0, y0, x1 - x0, y1 - y0);
+            glClear(GL_STENCIL_BUFFER_BIT);
+            glDisable(GL_SCISSOR_TEST);
+        }
+    }
+
+    glDisable(GL_STENCIL_TEST);
+    glDisableVertexAttribArray(position_location);
+
+    /* Show the result on the canvas */
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
+    glViewport(0, 0, canvas_.width(), canvas_.height());
+
+    position_location = p.texture_program["position"].location();
+    GLint texcoord_location = p.texture_program["texcoord"].location();
+
+    p.texture_program.start();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, p.color_texture);
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glEnableVertexAttribArray(texcoord_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE,
+                          4 * sizeof(GLfloat), 0);
+    glVertexAttribPointer(texcoord_location, 2, GL_FLOAT, GL_FALSE,
+                          4 * sizeof(GLfloat),
+                          reinterpret_cast<const GLvoid *>(2 * sizeof(GLfloat)));
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(texcoord_location);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Scene::ValidationResult
+ScenePaths::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+ScenePaths::rates()
+{
+    double elapsed = elapsed_time();
+    double paths = static_cast<double>(priv_->paths.size()) * frame_count();
+
+    return std::vector<Rate>(1, Rate("PathsPerSecond", "paths_per_second",
+                                     elapsed > 0.0 ? paths / elapsed : 0.0));
+}
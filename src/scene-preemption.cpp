@@ -0,0 +1,405 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "canvas.h"
+#include "frame-stats.h"
+#include "gl-state.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+/*
+ * The main context renders a light frame at a fixed rate, like a
+ * compositor, while a worker context renders long draws in the background,
+ * like a game. The time the light frames take to complete shows how soon
+ * the GPU switches to them, given the priorities of the two contexts.
+ */
+struct ScenePreemptionPrivate {
+    ScenePreemptionPrivate() :
+        quad_buffer(0), interval(0), next_frame(0), context(0),
+        priority(Options::ContextPriorityLow), width(0), height(0),
+        stop(false), failed(false), frames(0), start_frames(0),
+        end_frames(0), stopped(false) {}
+
+    /* The foreground frames, on the main context */
+    Program program;
+    GLuint quad_buffer;
+    /* The interval of the foreground frames, and when the next one starts, in µs */
+    uint64_t interval;
+    uint64_t next_frame;
+    /* The time from the submission of a foreground frame to its completion */
+    FrameStats latency;
+
+    /* The background draws, on the worker context */
+    GLWorkerContext *context;
+    Options::ContextPriority priority;
+    int width;
+    int height;
+    std::string vtx_shader;
+    std::string frg_shader;
+    std::thread thread;
+    std::atomic<bool> stop;
+    std::atomic<bool> failed;
+    std::atomic<unsigned int> frames;
+    /* The background frames at the start and end of the measured run */
+    unsigned int start_frames;
+    unsigned int end_frames;
+    bool stopped;
+
+    static void run(ScenePreemptionPrivate *priv);
+
+    void release()
+    {
+        stop = true;
+        if (thread.joinable())
+            thread.join();
+
+        delete context;
+        context = 0;
+
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+};
+
+/*
+ * Renders the background draws into the FBO of the worker until the scene
+ * stops. Every draw is finished, so that the counted frames have been
+ * rendered.
+ */
+void
+ScenePreemptionPrivate::run(ScenePreemptionPrivate *priv)
+{
+    if (!priv->context->make_current()) {
+        priv->failed = true;
+        return;
+    }
+
+    GLuint color_texture;
+    GLuint fbo;
+
+    glGenTextures(1, &color_texture);
+    glBindTexture(GL_TEXTURE_2D, color_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, priv->width, priv->height, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+    GLExtensions::GenFramebuffers(1, &fbo);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_2D, color_texture, 0);
+
+    Program program;
+    program.init();
+    program.addShader(GL_VERTEX_SHADER, priv->vtx_shader);
+    program.addShader(GL_FRAGMENT_SHADER, priv->frg_shader);
+    program.build();
+
+    if (GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE ||
+        !program.ready())
+    {
+        Log::error("Failed to set up the background context: %s\n",
+                   program.errorMessage().c_str());
+        priv->failed = true;
+    }
+    else {
+        GLuint buffer = FullscreenQuad::create();
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+        GLint position_location = program["position"].location();
+
+        program.start();
+        glViewport(0, 0, priv->width, priv->height);
+        glDisable(GL_DEPTH_TEST);
+        glEnableVertexAttribArray(position_location);
+        glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+        float time = 0.0f;
+
+        while (!priv->stop) {
+            program["Time"] = time;
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            glFinish();
+
+            time += 0.01f;
+            priv->frames++;
+        }
+
+        glDisableVertexAttribArray(position_location);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+        program.stop();
+    }
+
+    program.release();
+    GLExtensions::DeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &color_texture);
+
+    priv->context->release();
+}
+
+ScenePreemption::ScenePreemption(Canvas &pCanvas) :
+    Scene(pCanvas, "preemption")
+{
+    priv_ = new ScenePreemptionPrivate();
+    options_["steps"] = Scene::Option("steps", "256",
+                                      "The iterations of the background shader per fragment, which set the length of its draws");
+    options_["rate"] = Scene::Option("rate", "60",
+                                     "The frames per second of the foreground");
+    options_["background-priority"] = Scene::Option("background-priority", "low",
+                                                    "The priority of the background context (see --context-priority for the foreground one)",
+                                                    "default,low,medium,high");
+}
+
+ScenePreemption::~ScenePreemption()
+{
+    delete priv_;
+}
+
+bool
+ScenePreemption::supported(bool show_errors)
+{
+    GLWorkerContext *context = canvas_.create_worker_context(false);
+
+    if (!context) {
+        if (show_errors) {
+            Log::error("Rendering from multiple contexts is not supported"
+                       " by this flavor!\n");
+        }
+        return false;
+    }
+
+    delete context;
+
+    return true;
+}
+
+bool
+ScenePreemption::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+ScenePreemption::unload()
+{
+}
+
+bool
+ScenePreemption::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/latency.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/latency.frag");
+    static const std::string bg_vtx_shader_filename(Options::data_path + "/shaders/preemption.vert");
+    static const std::string bg_frg_shader_filename(Options::data_path + "/shaders/preemption.frag");
+
+    ScenePreemptionPrivate &p(*priv_);
+
+    /* Parse the options */
+    unsigned int steps = Util::fromString<unsigned int>(options_["steps"].value);
+    double rate = Util::fromString<double>(options_["rate"].value);
+    const std::string &priority(options_["background-priority"].value);
+
+    if (steps == 0 || rate <= 0.0) {
+        Log::error("The preemption scene needs at least one step and a positive rate\n");
+        return false;
+    }
+
+    if (priority == "low")
+        p.priority = Options::ContextPriorityLow;
+    else if (priority == "medium")
+        p.priority = Options::ContextPriorityMedium;
+    else if (priority == "high")
+        p.priority = Options::ContextPriorityHigh;
+    else
+        p.priority = Options::ContextPriorityDefault;
+
+    if (Options::context_priority == Options::ContextPriorityDefault) {
+        Log::info("Warning: The foreground runs at the default priority, use"
+                  " --context-priority=high to give it precedence\n");
+    }
+
+    /* Load the foreground program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.quad_buffer = FullscreenQuad::create();
+
+    p.program.start();
+    p.program["Scale"] = LibMatrix::vec2(64.0f / canvas_.width(),
+                                         64.0f / canvas_.height());
+
+    glDisable(GL_DEPTH_TEST);
+
+    /* Start the background */
+    ShaderSource bg_vtx_source(bg_vtx_shader_filename);
+    ShaderSource bg_frg_source(bg_frg_shader_filename);
+    bg_frg_source.replace("$STEPS$", Util::toString(steps));
+
+    p.vtx_shader = bg_vtx_source.str();
+    p.frg_shader = bg_frg_source.str();
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+    p.stop = false;
+    p.failed = false;
+    p.frames = 0;
+    p.start_frames = 0;
+    p.end_frames = 0;
+    p.stopped = false;
+
+    p.context = canvas_.create_worker_context(false, p.priority);
+    if (!p.context) {
+        Log::error("Failed to create the background context\n");
+        return false;
+    }
+
+    p.thread = std::thread(ScenePreemptionPrivate::run, priv_);
+
+    p.interval = static_cast<uint64_t>(1000000.0 / rate);
+    p.next_frame = Util::get_timestamp_us();
+    p.latency.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+ScenePreemption::teardown()
+{
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+ScenePreemption::update()
+{
+    Scene::update();
+
+    ScenePreemptionPrivate &p(*priv_);
+
+    if (p.failed)
+        running_ = false;
+
+    /* Count the background frames rendered while the scene was running */
+    if (!running_ && !p.stopped) {
+        p.end_frames = p.frames;
+        p.stopped = true;
+    }
+}
+
+/*
+ * Waits for the next frame of the fixed rate, as a compositor waits for the
+ * vblank, then draws a small marker and waits for it to be rendered.
+ */
+void
+ScenePreemption::draw()
+{
+    ScenePreemptionPrivate &p(*priv_);
+    GLint position_location = p.program["position"].location();
+
+    uint64_t now = Util::get_timestamp_us();
+    if (now < p.next_frame)
+        std::this_thread::sleep_for(std::chrono::microseconds(p.next_frame - now));
+
+    /* Frames that are late don't make the next ones early */
+    p.next_frame = std::max(p.next_frame + p.interval, now);
+
+    uint64_t submit = Util::get_timestamp_us();
+    double angle = 2.0 * M_PI * (submit / 1000000.0 - startTime_);
+
+    p.program["Center"] = LibMatrix::vec2(0.5 * std::cos(angle),
+                                          0.5 * std::sin(angle));
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glFinish();
+    p.latency.add(Util::get_timestamp_us() - submit);
+}
+
+Scene::ValidationResult
+ScenePreemption::validate()
+{
+    return priv_->failed ? Scene::ValidationFailure : Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+ScenePreemption::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("ForegroundLatency", "foreground_latency",
+                                                   priv_->latency));
+}
+
+void
+ScenePreemption::reset_measurements()
+{
+    priv_->latency.reset();
+    priv_->start_frames = priv_->frames;
+}
+
+std::vector<Scene::Rate>
+ScenePreemption::rates()
+{
+    ScenePreemptionPrivate &p(*priv_);
+    unsigned int end_frames = p.stopped ? p.end_frames : p.frames.load();
+    double elapsed = elapsed_time();
+
+    if (elapsed <= 0.0)
+        return std::vector<Rate>();
+
+    return std::vector<Rate>(1, Rate("BackgroundFPS", "background_fps",
+                                     (end_frames - p.start_frames) / elapsed));
+}
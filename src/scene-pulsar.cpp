@@ -44,7 +44,11 @@ using LibMatrix::Stack4;
 ScenePulsar::ScenePulsar(Canvas &pCanvas) :
     Scene(pCanvas, "pulsar"),
     numQuads_(0),
-    texture_(0)
+    texture_(0),
+    instanced_(false),
+    instanceBuffer_(0),
+    cull_(false),
+    culled_(0.0)
 {
     options_["quads"] = Scene::Option("quads", "5", "Number of quads to render");
     options_["texture"] = Scene::Option("texture", "false", "Enable texturing",
@@ -53,12 +57,43 @@ ScenePulsar::ScenePulsar(Canvas &pCanvas) :
                                       "false,true");
     options_["random"] = Scene::Option("random", "false", "Enable random rotation speeds",
                                        "false,true");
+    options_["instanced"] = Scene::Option("instanced", "false",
+                                          "Draw all quads with a single instanced draw call",
+                                          "false,true");
+    options_["spread"] = Scene::Option("spread", "0",
+                                       "Scatter the quads up to this distance from the center");
+    options_["cull"] = Scene::Option("cull", "false",
+                                     "Skip the quads outside the view, using a bounding volume hierarchy",
+                                     "false,true");
 }
 
 ScenePulsar::~ScenePulsar()
 {
 }
 
+bool
+ScenePulsar::supported(bool show_errors)
+{
+    if (options_["instanced"].value == "true" &&
+        (GLExtensions::DrawArraysInstanced == 0 ||
+         GLExtensions::VertexAttribDivisor == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested instanced rendering but instanced arrays"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    if (Util::fromString<float>(options_["spread"].value) < 0.0f) {
+        if (show_errors)
+            Log::error("The spread of the quads can't be negative!\n");
+        return false;
+    }
+
+    return true;
+}
+
 bool
 ScenePulsar::load()
 {
@@ -108,6 +143,37 @@ ScenePulsar::setup()
         }
     }
 
+    // Scatter the quads with a fixed sequence, so that runs are comparable
+    float spread = Util::fromString<float>(options_["spread"].value);
+    unsigned int seed = 1;
+    for (int i = 0; i < numQuads_; i++) {
+        vec3 offset;
+        if (spread > 0.0f) {
+            for (int c = 0; c < 2; c++) {
+                seed = seed * 1103515245u + 12345u;
+                float value = ((seed >> 8) & 0xffff) / 32768.0f - 1.0f;
+                if (c == 0)
+                    offset.x(value * spread);
+                else
+                    offset.y(value * spread);
+            }
+        }
+        offsets_.push_back(offset);
+    }
+
+    // A rotating quad stays in the sphere around its corners
+    static const float quad_radius = std::sqrt(2.0f);
+    const vec3 extent(quad_radius, quad_radius, quad_radius);
+    cull_ = options_["cull"].value == "true";
+    for (int i = 0; cull_ && i < numQuads_; i++)
+        bvh_.add(offsets_[i] - extent, offsets_[i] + extent);
+    bvh_.build();
+
+    for (int i = 0; i < numQuads_; i++)
+        visible_.push_back(i);
+    cull_stats_.reset();
+    culled_ = 0.0;
+
     // Load shaders
     std::string vtx_shader_filename;
     std::string frg_shader_filename;
@@ -135,6 +201,16 @@ ScenePulsar::setup()
         vtx_source.add_const("LightSourcePosition", lightPosition);
     }
 
+    // With instancing the per-quad matrices become per-instance attributes
+    instanced_ = options_["instanced"].value == "true";
+    if (instanced_) {
+        vtx_source.replace("uniform mat4 ModelViewProjectionMatrix;",
+                           "attribute mat4 ModelViewProjectionMatrix;");
+        vtx_source.replace("uniform mat4 NormalMatrix;",
+                           "attribute mat4 NormalMatrix;");
+        glGenBuffers(1, &instanceBuffer_);
+    }
+
     if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
                                           frg_source.str()))
     {
@@ -161,7 +237,7 @@ ScenePulsar::teardown()
     program_.release();
 
     if (options_["texture"].value == "true") {
-        glDeleteTextures(1, &texture_);
+        Texture::release(1, &texture_);
         texture_ = 0;
     }
 
@@ -172,6 +248,17 @@ ScenePulsar::teardown()
 
     mesh_.reset();
 
+    rotations_.clear();
+    rotationSpeeds_.clear();
+    offsets_.clear();
+    bvh_.clear();
+    visible_.clear();
+
+    if (instanceBuffer_) {
+        glDeleteBuffers(1, &instanceBuffer_);
+        instanceBuffer_ = 0;
+    }
+
     Scene::teardown();
 }
 
@@ -180,7 +267,7 @@ ScenePulsar::update()
 {
     Scene::update();
 
-    double elapsed_time = lastUpdateTime_ - startTime_;
+    double elapsed_time = animation_time();
 
     for (int i = 0; i < numQuads_; i++) {
         rotations_[i] = rotationSpeeds_[i] * (elapsed_time * 60);
@@ -197,30 +284,135 @@ ScenePulsar::draw()
         glBindTexture(GL_TEXTURE_2D, texture_);
     }
 
-    for (int i = 0; i < numQuads_; i++) {
+    if (cull_)
+        cull_quads();
+
+    if (instanced_) {
+        draw_instanced();
+        return;
+    }
+
+    for (unsigned int i : visible_) {
+        mat4 model_view_proj;
+        mat4 normal_matrix;
+
+        quad_matrices(i, model_view_proj, normal_matrix);
+
         // Load the ModelViewProjectionMatrix uniform in the shader
-        Stack4 model_view;
-        mat4 model_view_proj(canvas_.projection());
-        model_view.scale(scale_.x(), scale_.y(), scale_.z());
-        model_view.translate(0.0f, 0.0f, -10.0f);
-        model_view.rotate(rotations_[i].x(), 1.0f, 0.0f, 0.0f);
-        model_view.rotate(rotations_[i].y(), 0.0f, 1.0f, 0.0f);
-        model_view.rotate(rotations_[i].z(), 0.0f, 0.0f, 1.0f);
-        model_view_proj *= model_view.getCurrent();
         program_["ModelViewProjectionMatrix"] = model_view_proj;
 
-        if (options_["light"].value == "true") {
-            // Load the NormalMatrix uniform in the shader. The NormalMatrix is the
-            // inverse transpose of the model view matrix.
-            mat4 normal_matrix(model_view.getCurrent());
-            normal_matrix.inverse().transpose();
+        if (options_["light"].value == "true")
             program_["NormalMatrix"] = normal_matrix;
-        }
 
         mesh_.render_vbo();
     }
 }
 
+/*
+ * Calculates the ModelViewProjectionMatrix and NormalMatrix of a quad.
+ * The NormalMatrix is the inverse transpose of the model view matrix.
+ */
+void
+ScenePulsar::quad_matrices(int i, mat4 &model_view_proj, mat4 &normal_matrix)
+{
+    Stack4 model_view;
+    model_view_proj = canvas_.projection();
+    model_view.scale(scale_.x(), scale_.y(), scale_.z());
+    model_view.translate(0.0f, 0.0f, -10.0f);
+    model_view.translate(offsets_[i].x(), offsets_[i].y(), offsets_[i].z());
+    model_view.rotate(rotations_[i].x(), 1.0f, 0.0f, 0.0f);
+    model_view.rotate(rotations_[i].y(), 0.0f, 1.0f, 0.0f);
+    model_view.rotate(rotations_[i].z(), 0.0f, 0.0f, 1.0f);
+    model_view_proj *= model_view.getCurrent();
+
+    normal_matrix = model_view.getCurrent();
+    normal_matrix.inverse().transpose();
+}
+
+/*
+ * Finds the quads that may be in view. The boxes of the quads are in the
+ * space before their offsets, so the hierarchy is built only once.
+ */
+void
+ScenePulsar::cull_quads()
+{
+    uint64_t start = Util::get_timestamp_us();
+
+    Stack4 view;
+    view.scale(scale_.x(), scale_.y(), scale_.z());
+    view.translate(0.0f, 0.0f, -10.0f);
+    mat4 view_proj(canvas_.projection());
+    view_proj *= view.getCurrent();
+
+    visible_.clear();
+    bvh_.cull(LibMatrix::Frustum(view_proj), visible_);
+
+    cull_stats_.add(Util::get_timestamp_us() - start);
+    culled_ += numQuads_ - visible_.size();
+}
+
+/*
+ * Draws all quads with a single draw call, streaming the per-quad matrices
+ * as per-instance attributes. A mat4 attribute takes four consecutive
+ * locations, one for each column.
+ */
+void
+ScenePulsar::draw_instanced()
+{
+    bool light = options_["light"].value == "true";
+    unsigned int nmatrices = light ? 2 : 1;
+    GLsizei stride = nmatrices * 16 * sizeof(float);
+
+    instanceData_.clear();
+    instanceData_.reserve(visible_.size() * nmatrices * 16);
+
+    for (unsigned int i : visible_) {
+        mat4 model_view_proj;
+        mat4 normal_matrix;
+
+        quad_matrices(i, model_view_proj, normal_matrix);
+
+        const float *m = model_view_proj;
+        instanceData_.insert(instanceData_.end(), m, m + 16);
+        if (light) {
+            const float *n = normal_matrix;
+            instanceData_.insert(instanceData_.end(), n, n + 16);
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_);
+    glBufferData(GL_ARRAY_BUFFER, instanceData_.size() * sizeof(float),
+                 instanceData_.empty() ? 0 : &instanceData_[0], GL_STREAM_DRAW);
+
+    GLint locations[2] = {
+        program_["ModelViewProjectionMatrix"].location(),
+        light ? program_["NormalMatrix"].location() : -1
+    };
+
+    for (unsigned int m = 0; m < nmatrices; m++) {
+        if (locations[m] < 0)
+            continue;
+        for (int c = 0; c < 4; c++) {
+            const char *offset = reinterpret_cast<const char *>((m * 16 + c * 4) * sizeof(float));
+            glEnableVertexAttribArray(locations[m] + c);
+            glVertexAttribPointer(locations[m] + c, 4, GL_FLOAT, GL_FALSE,
+                                  stride, offset);
+            GLExtensions::VertexAttribDivisor(locations[m] + c, 1);
+        }
+    }
+
+    mesh_.render_vbo_instanced(visible_.size());
+
+    for (unsigned int m = 0; m < nmatrices; m++) {
+        if (locations[m] < 0)
+            continue;
+        for (int c = 0; c < 4; c++) {
+            GLExtensions::VertexAttribDivisor(locations[m] + c, 0);
+            glDisableVertexAttribArray(locations[m] + c);
+        }
+    }
+}
+
 Scene::ValidationResult
 ScenePulsar::validate()
 {
@@ -230,6 +422,7 @@ ScenePulsar::validate()
 
     if (options_["texture"].value != "false" ||
         options_["light"].value != "false" ||
+        options_["spread"].value != "0" ||
         quads != 5)
     {
         return Scene::ValidationUnknown;
@@ -247,6 +440,50 @@ ScenePulsar::validate()
     return Scene::ValidationFailure;
 }
 
+std::vector<Scene::Measurement>
+ScenePulsar::measurements()
+{
+    std::vector<Measurement> measurements;
+
+    if (cull_)
+        measurements.push_back(Measurement("CullTime", "cull_time", cull_stats_));
+
+    return measurements;
+}
+
+void
+ScenePulsar::reset_measurements()
+{
+    cull_stats_.reset();
+    culled_ = 0.0;
+}
+
+std::vector<Scene::Rate>
+ScenePulsar::rates()
+{
+    std::vector<Rate> rates;
+    double elapsed = elapsed_time();
+
+    if (!cull_ || elapsed <= 0.0)
+        return rates;
+
+    rates.push_back(Rate("CulledQuadsPerSecond", "culled_quads_per_second",
+                         culled_ / elapsed));
+
+    return rates;
+}
+
+std::vector<std::string>
+ScenePulsar::textures()
+{
+    std::vector<std::string> names;
+
+    if (options_["texture"].value == "true")
+        names.push_back("crate-base");
+
+    return names;
+}
+
 void
 ScenePulsar::create_and_setup_mesh()
 {
@@ -26,6 +26,7 @@
 #include "util.h"
 #include "log.h"
 #include "shader-source.h"
+#include <algorithm>
 
 using std::string;
 using std::vector;
@@ -59,6 +60,9 @@ SceneRefract::SceneRefract(Canvas& canvas) :
         optionValues += curName;
         doSeparator = true;
     }
+    options_["model-optimize"] = Scene::Option("model-optimize", "none",
+                                               "How to reorder the model geometry for the GPU (vcache: vertex cache, overdraw: vertex cache and overdraw)",
+                                               "none,vcache,overdraw");
     options_["model"] = Scene::Option("model", "bunny", "Which model to use",
                                       optionValues);
     optionValues = "";
@@ -86,6 +90,18 @@ SceneRefract::SceneRefract(Canvas& canvas) :
     options_["interleave"] = Scene::Option("interleave", "false",
                                            "Whether to interleave vertex attribute data",
                                            "false,true");
+    options_["distance-scale"] = Scene::Option("distance-scale", "1",
+                                               "The resolution of the back-face distance pass, relative to the default (twice the canvas size), upscaled bilinearly",
+                                               "1,0.5,0.25");
+    options_["environment"] = Scene::Option("environment", "image",
+                                            "What the object refracts: the texture, or a cubemap of moving objects around it with the texture as backdrop, rendered at run time and also reflected",
+                                            "image,cubemap");
+    options_["cubemap-size"] = Scene::Option("cubemap-size", "256",
+                                             "The width and height of the faces of the environment cubemap");
+    options_["cubemap-update"] = Scene::Option("cubemap-update", "1",
+                                               "Render the environment cubemap every N frames, 0 to render it only once");
+    DepthPrepass::add_option(options_);
+    DepthConfig::add_options(options_);
 }
 
 bool
@@ -111,6 +127,9 @@ SceneRefract::supported(bool show_errors)
         ret = false;
     }
 
+    if (!DepthConfig::supported(options_, false, show_errors))
+        ret = false;
+
     return ret;
 }
 
@@ -167,7 +186,7 @@ SceneRefract::update()
 {
     Scene::update();
     // Add scene-specific update here
-    priv_->update(lastUpdateTime_ - startTime_);
+    priv_->update(animation_time());
 }
 
 void
@@ -179,7 +198,49 @@ SceneRefract::draw()
 Scene::ValidationResult
 SceneRefract::validate()
 {
-    return Scene::ValidationUnknown;
+    static const unsigned int samples(32);
+    // The mean RGB distance from the full resolution frame that is accepted
+    static const double max_mean_distance(4.0);
+
+    // Only the quality loss of a reduced resolution distance pass is known
+    if (priv_->distance_scale() == 1.0)
+        return Scene::ValidationUnknown;
+
+    vector<Canvas::Pixel> pixels;
+    for (unsigned int y = 0; y < samples; y++) {
+        for (unsigned int x = 0; x < samples; x++) {
+            pixels.push_back(canvas_.read_pixel((2 * x + 1) * canvas_.width() / (2 * samples),
+                                                (2 * y + 1) * canvas_.height() / (2 * samples)));
+        }
+    }
+
+    canvas_.clear();
+    if (!priv_->draw_reference())
+        return Scene::ValidationUnknown;
+
+    double total(0.0);
+    double max(0.0);
+    for (unsigned int y = 0; y < samples; y++) {
+        for (unsigned int x = 0; x < samples; x++) {
+            Canvas::Pixel ref = canvas_.read_pixel((2 * x + 1) * canvas_.width() / (2 * samples),
+                                                   (2 * y + 1) * canvas_.height() / (2 * samples));
+            double dist = pixels[y * samples + x].distance_rgb(ref);
+            total += dist;
+            max = std::max(max, dist);
+        }
+    }
+
+    double mean = total / (samples * samples);
+    Log::debug("Distance scale %s: mean distance from the full resolution frame: %f (max %f)\n",
+               options_["distance-scale"].value.c_str(), mean, max);
+
+    return mean < max_mean_distance ? Scene::ValidationSuccess : Scene::ValidationFailure;
+}
+
+vector<string>
+SceneRefract::textures()
+{
+    return vector<string>(1, options_["texture"].value);
 }
 
 //
@@ -187,7 +248,8 @@ SceneRefract::validate()
 //
 
 bool
-DistanceRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigned int height)
+DistanceRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigned int height,
+                            float scale, const DepthConfig& depth)
 {
     static const string vtx_shader_filename(Options::data_path + "/shaders/depth.vert");
     static const string frg_shader_filename(Options::data_path + "/shaders/depth.frag");
@@ -201,8 +263,8 @@ DistanceRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigne
 
     canvas_width_ = width;
     canvas_height_ = height;
-    width_ = canvas_width_ * 2;
-    height_ = canvas_height_ * 2;
+    width_ = std::max(1U, static_cast<unsigned int>(canvas_width_ * 2 * scale));
+    height_ = std::max(1U, static_cast<unsigned int>(canvas_height_ * 2 * scale));
     canvas_fbo_ = canvas_fbo;
 
     // If the texture will be too large for the implemnetation, we need to
@@ -218,14 +280,22 @@ DistanceRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigne
             canvas_width_ * 2, canvas_height_ * 2, width_, height_);
     }
 
+    // A reduced resolution distance map is upscaled bilinearly when sampled
+    GLint depth_filter(scale < 1.0 ? GL_LINEAR : GL_NEAREST);
+
     glGenTextures(2, &tex_[0]);
     glBindTexture(GL_TEXTURE_2D, tex_[DEPTH]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, depth_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, depth_filter);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width_, height_, 0,
-                 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 0);
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+    depth.texture_format(internalFormat, format, type);
+    attachment_ = depth.attachment();
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width_, height_, 0,
+                 format, type, 0);
     glBindTexture(GL_TEXTURE_2D, tex_[COLOR]);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -239,7 +309,7 @@ DistanceRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigne
 
     GLExtensions::GenFramebuffers(1, &fbo_);
     GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
-    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, attachment_, GL_TEXTURE_2D,
                            tex_[DEPTH], 0);
     GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
                            tex_[COLOR], 0);
@@ -274,11 +344,16 @@ DistanceRenderTarget::enable(const mat4& mvp)
     program_.start();
     program_["ModelViewProjectionMatrix"] = mvp;
     GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
-    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, attachment_, GL_TEXTURE_2D,
                            tex_[DEPTH], 0);
     GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
                            tex_[COLOR], 0);
     glViewport(0, 0, width_, height_);
+    // The contents of the previous frame aren't needed, so they needn't be
+    // loaded. Both attachments are sampled by the refraction pass, so they
+    // can't be invalidated at the end of this pass.
+    const GLenum attachments[] = { attachment_, GL_COLOR_ATTACHMENT0 };
+    Scene::invalidate_framebuffer(attachments, 2);
     glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
     glCullFace(GL_FRONT);
 }
@@ -290,6 +365,113 @@ void DistanceRenderTarget::disable()
     glCullFace(GL_BACK);
 }
 
+bool
+CubemapRenderTarget::setup(unsigned int canvas_fbo, unsigned int size,
+                           const DepthConfig& depth)
+{
+    GLint max_size(0);
+    glGetIntegerv(GL_MAX_CUBE_MAP_TEXTURE_SIZE, &max_size);
+    if (size == 0 || size > static_cast<unsigned int>(max_size)) {
+        Log::error("CubemapRenderTarget::setup: face size %u is not in [1, %d]\n",
+                   size, max_size);
+        return false;
+    }
+
+    size_ = size;
+    canvas_fbo_ = canvas_fbo;
+
+    glGenTextures(1, &tex_);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, tex_);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    for (unsigned int face = 0; face < 6; face++) {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA, size_, size_, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+    GLExtensions::GenRenderbuffers(1, &depth_);
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, depth_);
+    GLExtensions::RenderbufferStorage(GL_RENDERBUFFER,
+                                      depth.renderbuffer_format(GL_DEPTH_COMPONENT16),
+                                      size_, size_);
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLExtensions::GenFramebuffers(1, &fbo_);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_CUBE_MAP_POSITIVE_X, tex_, 0);
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, depth.attachment(),
+                                          GL_RENDERBUFFER, depth_);
+    unsigned int status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_fbo_);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::error("CubemapRenderTarget::setup: glCheckFramebufferStatus failed (0x%x)\n", status);
+        return false;
+    }
+
+    return true;
+}
+
+void
+CubemapRenderTarget::teardown()
+{
+    if (tex_) {
+        glDeleteTextures(1, &tex_);
+        tex_ = 0;
+    }
+    if (depth_) {
+        GLExtensions::DeleteRenderbuffers(1, &depth_);
+        depth_ = 0;
+    }
+    if (fbo_) {
+        GLExtensions::DeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+}
+
+void
+CubemapRenderTarget::enable(unsigned int face)
+{
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                       GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, tex_, 0);
+    glViewport(0, 0, size_, size_);
+    // The backdrop covers the whole face, so only the depth is cleared
+    static const GLenum attachments[] = { GL_DEPTH_ATTACHMENT, GL_COLOR_ATTACHMENT0 };
+    Scene::invalidate_framebuffer(attachments, 2);
+    glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void
+CubemapRenderTarget::disable(unsigned int canvas_width, unsigned int canvas_height)
+{
+    // The depth isn't needed once the face is rendered
+    static const GLenum attachments[] = { GL_DEPTH_ATTACHMENT };
+    Scene::invalidate_framebuffer(attachments, 1);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_fbo_);
+    glViewport(0, 0, canvas_width, canvas_height);
+}
+
+mat4
+CubemapRenderTarget::faceView(unsigned int face)
+{
+    // The directions and up vectors of the faces in the cubemap convention
+    static const float views[6][6] = {
+        {  1.0,  0.0,  0.0,   0.0, -1.0,  0.0 },
+        { -1.0,  0.0,  0.0,   0.0, -1.0,  0.0 },
+        {  0.0,  1.0,  0.0,   0.0,  0.0,  1.0 },
+        {  0.0, -1.0,  0.0,   0.0,  0.0, -1.0 },
+        {  0.0,  0.0,  1.0,   0.0, -1.0,  0.0 },
+        {  0.0,  0.0, -1.0,   0.0, -1.0,  0.0 },
+    };
+    const float* v(views[face]);
+
+    return LibMatrix::Mat4::lookAt(0.0, 0.0, 0.0, v[0], v[1], v[2], v[3], v[4], v[5]);
+}
+
 bool
 RefractPrivate::setup(map<string, Scene::Option>& options)
 {
@@ -298,13 +480,19 @@ RefractPrivate::setup(map<string, Scene::Option>& options)
     static const string frg_shader_filename(Options::data_path + "/shaders/light-refract.frag");
     static const vec4 lightColor(0.4, 0.4, 0.4, 1.0);
 
+    static const string frg_cubemap_shader_filename(Options::data_path + "/shaders/light-refract-cubemap.frag");
+
+    useCubemap_ = (options["environment"].value == "cubemap");
+    depth_.setup(options);
+
     ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
+    ShaderSource frg_source(useCubemap_ ? frg_cubemap_shader_filename : frg_shader_filename);
 
     frg_source.add_const("LightColor", lightColor);
     frg_source.add_const("LightSourcePosition", lightPosition);
     float refractive_index(Util::fromString<float>(options["index"].value));
     frg_source.add_const("RefractiveIndex", refractive_index);
+    depth_.add_sample_consts(frg_source);
 
     if (!Scene::load_shaders_from_strings(program_, vtx_source.str(), frg_source.str())) {
         return false;
@@ -357,7 +545,10 @@ RefractPrivate::setup(map<string, Scene::Option>& options)
     vector<std::pair<Model::AttribType, int> > attribs;
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
-    model.convert_to_mesh(mesh_, attribs);
+    Mesh::OptimizeMode optimize =
+        Mesh::optimize_mode_from_str(options["model-optimize"].value);
+    model.convert_to_mesh(mesh_, attribs, optimize != Mesh::OptimizeNone);
+    mesh_.optimize(optimize);
 
     useVbo_ = (options["use-vbo"].value == "true");
     bool interleave = (options["interleave"].value == "true");
@@ -384,6 +575,7 @@ RefractPrivate::setup(map<string, Scene::Option>& options)
     fovy *= 180.0;
     float aspect(static_cast<float>(canvas_.width())/static_cast<float>(canvas_.height()));
     projection_.perspective(fovy, aspect, 2.0, 2.0 + diameter);
+    lightProjection_ = depth_.perspective(fovy, aspect, 2.0, 2.0 + diameter);
 
     // Set up the light matrix with a bias that will convert values
     // in the range of [-1, 1] to [0, 1)], then add in the projection
@@ -395,20 +587,95 @@ RefractPrivate::setup(map<string, Scene::Option>& options)
                                       0.0, 0.0, 0.0,
                                       0.0, 1.0, 0.0);
 
-    if (!depthTarget_.setup(canvas_.fbo(), canvas_.width(), canvas_.height())) {
+    distanceScale_ = Util::fromString<float>(options["distance-scale"].value);
+    if (!depthTarget_.setup(canvas_.fbo(), canvas_.width(), canvas_.height(),
+                            distanceScale_, depth_))
+    {
         Log::error("Failed to set up the render target for the depth pass\n");
         return false;
     }
 
+    if (useCubemap_ && !setupEnvironment(options))
+        return false;
+
+    return prepass_.setup(options);
+}
+
+bool
+RefractPrivate::setupEnvironment(map<string, Scene::Option>& options)
+{
+    static const string env_vtx_filename(Options::data_path + "/shaders/refract-environment.vert");
+    static const string env_frg_filename(Options::data_path + "/shaders/refract-environment.frag");
+    static const string backdrop_vtx_filename(Options::data_path + "/shaders/refract-environment-backdrop.vert");
+    static const string backdrop_frg_filename(Options::data_path + "/shaders/refract-environment-backdrop.frag");
+
+    ShaderSource env_vtx_source(env_vtx_filename);
+    ShaderSource env_frg_source(env_frg_filename);
+    ShaderSource backdrop_vtx_source(backdrop_vtx_filename);
+    ShaderSource backdrop_frg_source(backdrop_frg_filename);
+
+    env_vtx_source.add_const("LightSourcePosition", lightPosition);
+
+    vector<Scene::ProgramSource> programs;
+    programs.push_back(Scene::ProgramSource(environmentProgram_, env_vtx_source.str(),
+                                            env_frg_source.str(),
+                                            env_vtx_filename, env_frg_filename));
+    programs.push_back(Scene::ProgramSource(backdropProgram_, backdrop_vtx_source.str(),
+                                            backdrop_frg_source.str(),
+                                            backdrop_vtx_filename, backdrop_frg_filename));
+    if (!Scene::load_programs(programs))
+        return false;
+
+    cubemapUpdate_ = Util::fromString<unsigned int>(options["cubemap-update"].value);
+    unsigned int size(Util::fromString<unsigned int>(options["cubemap-size"].value));
+    if (!cubemapTarget_.setup(canvas_.fbo(), size, depth_)) {
+        Log::error("Failed to set up the render target for the environment\n");
+        return false;
+    }
+
+    // The objects moving around the refracting one are cubes, scaled to
+    // a fraction of its size
+    Model model;
+    if (!model.load("cube"))
+        return false;
+    if (model.needNormals())
+        model.calculate_normals();
+
+    vector<std::pair<Model::AttribType, int> > attribs;
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
+    attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
+    model.convert_to_mesh(environmentMesh_, attribs);
+    environmentMesh_.build_vbo();
+
+    vec3 cubeSize(model.maxVec() - model.minVec());
+    environmentScale_ = 0.5 * radius_ / std::max(cubeSize.length(), 0.001f);
+
+    vector<int> vertex_format;
+    vertex_format.push_back(3);
+    backdropMesh_.set_vertex_format(vertex_format);
+    backdropMesh_.make_grid(1, 1, 2.0, 2.0, 0.0);
+    backdropMesh_.build_vbo();
+
+    frames_ = 0;
+
     return true;
 }
 void
 RefractPrivate::teardown()
 {
     depthTarget_.teardown();
+    cubemapTarget_.teardown();
+    environmentProgram_.release();
+    backdropProgram_.release();
+    environmentMesh_.reset();
+    backdropMesh_.reset();
+    prepass_.teardown();
+    depth_.teardown();
     program_.stop();
     program_.release();
     mesh_.reset();
+    Texture::release(1, &texture_);
+    texture_ = 0;
 }
 
 void
@@ -419,6 +686,105 @@ RefractPrivate::update(double elapsedTime)
 
 void
 RefractPrivate::draw()
+{
+    if (useCubemap_ &&
+        (frames_ == 0 || (cubemapUpdate_ > 0 && frames_ % cubemapUpdate_ == 0)))
+    {
+        drawEnvironment();
+    }
+    frames_++;
+
+    draw(depthTarget_);
+}
+
+//
+// Renders the six faces of the environment cubemap, as seen from the center
+// of the object: the texture as a backdrop, and cubes orbiting the object.
+// The environment has the axes of the eye space of the main view.
+//
+void
+RefractPrivate::drawEnvironment()
+{
+    static const unsigned int numObjects(8);
+    static const vec4 colors[numObjects] = {
+        vec4(0.9, 0.2, 0.2, 1.0), vec4(0.2, 0.9, 0.2, 1.0),
+        vec4(0.2, 0.2, 0.9, 1.0), vec4(0.9, 0.9, 0.2, 1.0),
+        vec4(0.9, 0.2, 0.9, 1.0), vec4(0.2, 0.9, 0.9, 1.0),
+        vec4(0.9, 0.6, 0.2, 1.0), vec4(0.9, 0.9, 0.9, 1.0),
+    };
+
+    mat4 projection(depth_.perspective(90.0, 1.0, 0.1 * radius_, 8.0 * radius_));
+
+    // The objects orbit at different speeds and heights
+    mat4 models[numObjects];
+    for (unsigned int i = 0; i < numObjects; i++) {
+        float angle(360.0 * i / numObjects + rotation_ * (1.0 + 0.25 * (i % 3)));
+        float height(0.8 * radius_ * sinf((angle * 2.0 + 45.0 * i) * M_PI / 180.0));
+        models[i] = LibMatrix::Mat4::rotate(angle, 0.0, 1.0, 0.0);
+        models[i] *= LibMatrix::Mat4::translate(2.5 * radius_, height, 0.0);
+        models[i] *= LibMatrix::Mat4::rotate(2.0 * rotation_, 1.0, 1.0, 0.0);
+        models[i] *= LibMatrix::Mat4::scale(environmentScale_, environmentScale_,
+                                            environmentScale_);
+    }
+
+    depth_.begin();
+    for (unsigned int face = 0; face < 6; face++) {
+        mat4 view(CubemapRenderTarget::faceView(face));
+        cubemapTarget_.enable(face);
+
+        glDisable(GL_DEPTH_TEST);
+        backdropProgram_.start();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        backdropProgram_["ImageMap"] = 0;
+        mat4 face_matrix(view);
+        backdropProgram_["FaceMatrix"] = face_matrix.transpose();
+        attribLocations_.assign(1, backdropProgram_["position"].location());
+        backdropMesh_.set_attrib_locations(attribLocations_);
+        backdropMesh_.render_vbo();
+        glEnable(GL_DEPTH_TEST);
+
+        environmentProgram_.start();
+        attribLocations_.clear();
+        attribLocations_.push_back(environmentProgram_["position"].location());
+        attribLocations_.push_back(environmentProgram_["normal"].location());
+        environmentMesh_.set_attrib_locations(attribLocations_);
+        for (unsigned int i = 0; i < numObjects; i++) {
+            mat4 mvp(projection);
+            mvp *= view;
+            mvp *= models[i];
+            mat4 normal_matrix(models[i]);
+            normal_matrix.inverse().transpose();
+            environmentProgram_["ModelViewProjectionMatrix"] = mvp;
+            environmentProgram_["NormalMatrix"] = normal_matrix;
+            environmentProgram_["MaterialDiffuse"] = colors[i];
+            environmentMesh_.render_vbo();
+        }
+
+        cubemapTarget_.disable(canvas_.width(), canvas_.height());
+    }
+    depth_.end();
+}
+
+bool
+RefractPrivate::draw_reference()
+{
+    DistanceRenderTarget target;
+
+    if (!target.setup(canvas_.fbo(), canvas_.width(), canvas_.height(), 1.0, depth_)) {
+        Log::error("Failed to set up the full resolution render target\n");
+        target.teardown();
+        return false;
+    }
+
+    draw(target);
+    target.teardown();
+
+    return true;
+}
+
+void
+RefractPrivate::draw(DistanceRenderTarget& target)
 {
     // To perform the depth pass, set up the model-view transformation so
     // that we're looking at the horse from the light position.  That will
@@ -433,26 +799,28 @@ RefractPrivate::draw()
     {
         modelview_.rotate(orientationAngle_, orientationVec_.x(), orientationVec_.y(), orientationVec_.z());
     }
-    mat4 mvp(projection_.getCurrent());
+    mat4 mvp(lightProjection_);
     mvp *= modelview_.getCurrent();
     modelview_.pop();
 
     // Enable the depth render target with our transformation and render.
-    depthTarget_.enable(mvp);
-    vector<GLint> attrib_locations;
-    attrib_locations.push_back(depthTarget_.program()["position"].location());
-    attrib_locations.push_back(depthTarget_.program()["normal"].location());
-    mesh_.set_attrib_locations(attrib_locations);
+    depth_.begin();
+    target.enable(mvp);
+    attribLocations_.clear();
+    attribLocations_.push_back(target.program()["position"].location());
+    attribLocations_.push_back(target.program()["normal"].location());
+    mesh_.set_attrib_locations(attribLocations_);
     if (useVbo_) {
         mesh_.render_vbo();
     }
     else {
         mesh_.render_array();
     }
-    depthTarget_.disable();
+    target.disable();
+    depth_.end();
 
     // Generate mipmap for the "normal" view of the horse
-    glBindTexture(GL_TEXTURE_2D, depthTarget_.colorTexture());
+    glBindTexture(GL_TEXTURE_2D, target.colorTexture());
     if (GLExtensions::GenerateMipmap)
         GLExtensions::GenerateMipmap(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -470,14 +838,20 @@ RefractPrivate::draw()
 
     program_.start();
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, depthTarget_.depthTexture());
+    glBindTexture(GL_TEXTURE_2D, target.depthTexture());
     program_["DistanceMap"] = 0;
     glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, depthTarget_.colorTexture());
+    glBindTexture(GL_TEXTURE_2D, target.colorTexture());
     program_["NormalMap"] = 1;
     glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, texture_);
-    program_["ImageMap"] = 2;
+    if (useCubemap_) {
+        glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTarget_.texture());
+        program_["EnvironmentMap"] = 2;
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        program_["ImageMap"] = 2;
+    }
     // Load both the modelview*projection as well as the modelview matrix itself
     program_["ModelViewProjectionMatrix"] = mvp;
     program_["ModelViewMatrix"] = modelview_.getCurrent();
@@ -487,16 +861,18 @@ RefractPrivate::draw()
     normal_matrix.inverse().transpose();
     program_["NormalMatrix"] = normal_matrix;
     program_["LightMatrix"] = light_;
-    attrib_locations.clear();
-    attrib_locations.push_back(program_["position"].location());
-    attrib_locations.push_back(program_["normal"].location());
-    mesh_.set_attrib_locations(attrib_locations);
+    attribLocations_.clear();
+    attribLocations_.push_back(program_["position"].location());
+    attribLocations_.push_back(program_["normal"].location());
+    mesh_.set_attrib_locations(attribLocations_);
+    prepass_.begin(mesh_, mvp, program_, useVbo_);
     if (useVbo_) {
         mesh_.render_vbo();
     }
     else {
         mesh_.render_array();
     }
+    prepass_.end();
 
     // Per-frame cleanup
     modelview_.pop();
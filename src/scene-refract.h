@@ -47,18 +47,21 @@ class DistanceRenderTarget
     unsigned int tex_[2];
     unsigned int fbo_;
     unsigned int canvas_fbo_;
+    GLenum attachment_;
 public:
     DistanceRenderTarget() :
         canvas_width_(0),
         canvas_height_(0),
         width_(0),
         height_(0),
-        fbo_(0)
+        fbo_(0),
+        attachment_(GL_DEPTH_ATTACHMENT)
     {
         tex_[DEPTH] = tex_[COLOR] = 0;
     }
     ~DistanceRenderTarget() {}
-    bool setup(unsigned int canvas_fbo, unsigned int width, unsigned int height);
+    bool setup(unsigned int canvas_fbo, unsigned int width, unsigned int height,
+               float scale, const DepthConfig& depth);
     void teardown();
     void enable(const LibMatrix::mat4& mvp);
     void disable();
@@ -67,6 +70,36 @@ public:
     Program& program() { return program_; }
 };
 
+//
+// The environment refracted and reflected by the object with
+// environment=cubemap. Each face is rendered in its own pass, into a
+// cubemap texture with a shared depth renderbuffer.
+//
+class CubemapRenderTarget
+{
+    unsigned int size_;
+    unsigned int tex_;
+    unsigned int depth_;
+    unsigned int fbo_;
+    unsigned int canvas_fbo_;
+public:
+    CubemapRenderTarget() :
+        size_(0),
+        tex_(0),
+        depth_(0),
+        fbo_(0),
+        canvas_fbo_(0) {}
+    ~CubemapRenderTarget() {}
+    bool setup(unsigned int canvas_fbo, unsigned int size, const DepthConfig& depth);
+    void teardown();
+    // Renders to a face, in the GL_TEXTURE_CUBE_MAP_POSITIVE_X.. order
+    void enable(unsigned int face);
+    void disable(unsigned int canvas_width, unsigned int canvas_height);
+    unsigned int texture() { return tex_; }
+    // The view rotation of a face, looking from the center of the cubemap
+    static LibMatrix::mat4 faceView(unsigned int face);
+};
+
 class RefractPrivate
 {
     Canvas& canvas_;
@@ -74,6 +107,8 @@ class RefractPrivate
     Program program_;
     LibMatrix::Stack4 modelview_;
     LibMatrix::Stack4 projection_;
+    // The projection of the distance pass, into the depth range of depth_
+    LibMatrix::mat4 lightProjection_;
     LibMatrix::mat4 light_;
     Mesh mesh_;
     LibMatrix::vec3 centerVec_;
@@ -85,7 +120,25 @@ class RefractPrivate
     float rotationSpeed_;
     unsigned int texture_;
     bool useVbo_;
-    
+    float distanceScale_;
+    DepthPrepass prepass_;
+    DepthConfig depth_;
+    // The dynamic environment
+    bool useCubemap_;
+    unsigned int cubemapUpdate_;
+    unsigned int frames_;
+    CubemapRenderTarget cubemapTarget_;
+    Program environmentProgram_;
+    Program backdropProgram_;
+    Mesh environmentMesh_;
+    Mesh backdropMesh_;
+    float environmentScale_;
+    // Kept so that setting the attribute locations doesn't allocate
+    std::vector<GLint> attribLocations_;
+    bool setupEnvironment(std::map<std::string, Scene::Option>& options);
+    void draw(DistanceRenderTarget& target);
+    void drawEnvironment();
+
 public:
     RefractPrivate(Canvas& canvas) :
         canvas_(canvas),
@@ -95,13 +148,24 @@ public:
         rotation_(0.0),
         rotationSpeed_(36.0),
         texture_(0),
-        useVbo_(true) {}
+        useVbo_(true),
+        distanceScale_(1.0),
+        useCubemap_(false),
+        cubemapUpdate_(1),
+        frames_(0),
+        environmentScale_(1.0) {}
     ~RefractPrivate() {}
 
     bool setup(std::map<std::string, Scene::Option>& options);
     void teardown();
     void update(double elapsedTime);
     void draw();
+    float distance_scale() const { return distanceScale_; }
+    /*
+     * Draws the frame again with a full resolution distance pass, for
+     * comparison with a frame drawn with a reduced distance-scale.
+     */
+    bool draw_reference();
 };
 
 #endif // SCENE_REFRACT_
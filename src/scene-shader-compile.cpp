@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "options.h"
+#include "log.h"
+#include "shader-source.h"
+#include "util.h"
+
+static const std::string shader_dir("/shaders/");
+
+SceneShaderCompile::SceneShaderCompile(Canvas &pCanvas) :
+    SceneGrid(pCanvas, "shader-compile"), unique_(true)
+{
+    options_["generator"] = Scene::Option("generator", "conditionals",
+            "The kind of computational steps to generate the shaders from",
+            "conditionals,function,loop");
+    options_["fragment-steps"] = Scene::Option("fragment-steps", "10",
+            "The number of computational steps in the fragment shader");
+    options_["vertex-steps"] = Scene::Option("vertex-steps", "10",
+            "The number of computational steps in the vertex shader");
+    options_["unique"] = Scene::Option("unique", "true",
+            "Whether to make each program unique, to defeat driver shader caches",
+            "false,true");
+}
+
+SceneShaderCompile::~SceneShaderCompile()
+{
+}
+
+/*
+ * Generates shader sources using the same building blocks as the
+ * conditionals, function and loop scenes.
+ */
+static std::string
+get_shader_source(const std::string &generator, const std::string &file, int steps)
+{
+    ShaderSource source(Options::data_path + shader_dir + generator + file);
+    ShaderSource source_main;
+
+    if (generator == "function") {
+        std::string step_file(Options::data_path + shader_dir + "function-step-medium.all");
+        for (int i = 0; i < steps; i++)
+            source_main.append_file(Options::data_path + shader_dir + "function-call.all");
+        source.replace_with_file("$PROCESS$", step_file);
+    }
+    else if (generator == "loop") {
+        source_main.append_file(Options::data_path + shader_dir + "loop-step-loop.all");
+        source_main.replace("$NLOOPS$", Util::toString(steps));
+    }
+    else {
+        for (int i = 0; i < steps; i++)
+            source_main.append_file(Options::data_path + shader_dir + "conditionals-step-conditional.all");
+    }
+
+    source.replace("$MAIN$", source_main.str());
+
+    return source.str();
+}
+
+bool
+SceneShaderCompile::setup()
+{
+    if (!SceneGrid::setup())
+        return false;
+
+    const std::string &generator(options_["generator"].value);
+    int vtx_steps(Util::fromString<int>(options_["vertex-steps"].value));
+    int frg_steps(Util::fromString<int>(options_["fragment-steps"].value));
+
+    unique_ = options_["unique"].value == "true";
+    vtx_template_ = prepare_vertex_shader(get_shader_source(generator, ".vert", vtx_steps));
+    frg_template_ = get_shader_source(generator, ".frag", frg_steps);
+    compile_stats_.reset();
+    link_stats_.reset();
+
+    /* Make sure the shaders are usable before starting to measure */
+    if (!Scene::load_shaders_from_strings(program_, vtx_template_, frg_template_))
+        return false;
+
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+/*
+ * Compiles and links a new program, timing each step. The program cache is
+ * deliberately not used here, as compiling is what we want to measure.
+ */
+bool
+SceneShaderCompile::build_program()
+{
+    std::string vtx_shader(vtx_template_);
+    std::string frg_shader(frg_template_);
+
+    if (unique_) {
+        std::string variant("\n// variant " + Util::toString(currentFrame_) + "\n");
+        vtx_shader += variant;
+        frg_shader += variant;
+    }
+
+    program_.stop();
+    program_.release();
+
+    uint64_t compile_start = Util::get_timestamp_us();
+
+    program_.init();
+    program_.addShader(GL_VERTEX_SHADER, vtx_shader);
+    program_.addShader(GL_FRAGMENT_SHADER, frg_shader);
+
+    uint64_t link_start = Util::get_timestamp_us();
+
+    program_.build();
+
+    uint64_t link_end = Util::get_timestamp_us();
+
+    if (!program_.ready()) {
+        Log::error("Failed to build program: %s\n", program_.errorMessage().c_str());
+        return false;
+    }
+
+    compile_stats_.add(link_start - compile_start);
+    link_stats_.add(link_end - link_start);
+
+    return true;
+}
+
+void
+SceneShaderCompile::draw()
+{
+    if (!build_program()) {
+        running_ = false;
+        return;
+    }
+
+    /*
+     * Draw with the new program, since some implementations defer part of
+     * the compilation until the program is first used.
+     */
+    program_.start();
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(program_["position"].location());
+    mesh_.set_attrib_locations(attrib_locations);
+
+    SceneGrid::draw();
+}
+
+std::vector<Scene::Measurement>
+SceneShaderCompile::measurements()
+{
+    std::vector<Measurement> m;
+
+    m.push_back(Measurement("CompileTime", "compile_time", compile_stats_));
+    m.push_back(Measurement("LinkTime", "link_time", link_stats_));
+
+    return m;
+}
+
+void
+SceneShaderCompile::reset_measurements()
+{
+    compile_stats_.reset();
+    link_stats_.reset();
+}
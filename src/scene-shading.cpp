@@ -63,14 +63,39 @@ SceneShading::SceneShading(Canvas &pCanvas) :
                                         "gouraud,blinn-phong-inf,phong,cel");
     options_["num-lights"] = Scene::Option("num-lights", "1",
             "The number of lights applied to the scene (phong only)");
+    options_["model-optimize"] = Scene::Option("model-optimize", "none",
+                                               "How to reorder the model geometry for the GPU (vcache: vertex cache, overdraw: vertex cache and overdraw)",
+                                               "none,vcache,overdraw");
+    options_["vertex-format"] = Scene::Option("vertex-format", "float",
+                                              "How to store vertex attributes (compact: half float positions, 2_10_10_10 normals)",
+                                              "float,compact");
     options_["model"] = Scene::Option("model", "cat", "Which model to use",
                                       optionValues);
+    DepthPrepass::add_option(options_);
+    DepthConfig::add_options(options_);
 }
 
 SceneShading::~SceneShading()
 {
 }
 
+bool
+SceneShading::supported(bool show_errors)
+{
+    if (options_["vertex-format"].value == "compact" &&
+        (!Mesh::attrib_format_supported(Mesh::AttribFormatHalfFloat) ||
+         !Mesh::attrib_format_supported(Mesh::AttribFormatInt2101010Rev)))
+    {
+        if (show_errors) {
+            Log::error("Requested compact vertex format but half float or"
+                       " 2_10_10_10 vertex attributes are not supported!\n");
+        }
+        return false;
+    }
+
+    return DepthConfig::supported(options_, true, show_errors);
+}
+
 bool
 SceneShading::load()
 {
@@ -133,12 +158,12 @@ get_fragment_shader_source(const string& frg_file, unsigned int lights)
     return source.str();
 }
 
-bool
-SceneShading::setup()
+/*
+ * Gets the shader sources of the program for the current options.
+ */
+Scene::ProgramVariant
+SceneShading::program_variant()
 {
-    if (!Scene::setup())
-        return false;
-
     static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
     static const LibMatrix::vec4 materialDiffuse(0.0f, 0.0f, 1.0f, 1.0f);
 
@@ -186,8 +211,25 @@ SceneShading::setup()
         frg_source.append_file(frg_shader_filename);
     }
 
-    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
-                                          frg_source.str()))
+    return ProgramVariant(vtx_source.str(), frg_source.str());
+}
+
+std::vector<Scene::ProgramVariant>
+SceneShading::programs()
+{
+    return std::vector<ProgramVariant>(1, program_variant());
+}
+
+bool
+SceneShading::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    ProgramVariant variant(program_variant());
+
+    if (!Scene::load_shaders_from_strings(program_, variant.vtx_shader,
+                                          variant.frg_shader))
     {
         return false;
     }
@@ -235,7 +277,17 @@ SceneShading::setup()
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypePosition, 3));
     attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeNormal, 3));
 
-    model.convert_to_mesh(mesh_, attribs);
+    Mesh::OptimizeMode optimize =
+        Mesh::optimize_mode_from_str(options_["model-optimize"].value);
+    model.convert_to_mesh(mesh_, attribs, optimize != Mesh::OptimizeNone);
+    mesh_.optimize(optimize);
+
+    if (options_["vertex-format"].value == "compact") {
+        std::vector<Mesh::AttribFormat> formats;
+        formats.push_back(Mesh::AttribFormatHalfFloat);
+        formats.push_back(Mesh::AttribFormatInt2101010Rev);
+        mesh_.set_attrib_formats(formats);
+    }
 
     mesh_.build_vbo();
 
@@ -251,8 +303,12 @@ SceneShading::setup()
     fovy /= M_PI;
     fovy *= 180.0;
     float aspect(static_cast<float>(canvas_.width())/static_cast<float>(canvas_.height()));
-    perspective_.setIdentity();
-    perspective_ *= LibMatrix::Mat4::perspective(fovy, aspect, 2.0, 2.0 + diameter);
+    if (!depth_.setup(options_, &canvas_))
+        return false;
+    perspective_ = depth_.perspective(fovy, aspect, 2.0, 2.0 + diameter);
+
+    if (!prepass_.setup(options_))
+        return false;
 
     program_.start();
 
@@ -273,6 +329,9 @@ SceneShading::setup()
 void
 SceneShading::teardown()
 {
+    prepass_.teardown();
+    depth_.teardown();
+
     program_.stop();
     program_.release();
 
@@ -284,7 +343,7 @@ SceneShading::update()
 {
     Scene::update();
 
-    double elapsed_time = lastUpdateTime_ - startTime_;
+    double elapsed_time = animation_time();
 
     rotation_ = rotationSpeed_ * elapsed_time;
 }
@@ -314,7 +373,11 @@ SceneShading::draw()
     // Load the modelview matrix itself
     program_["ModelViewMatrix"] = model_view.getCurrent();
 
+    depth_.begin();
+    prepass_.begin(mesh_, model_view_proj, program_);
     mesh_.render_vbo();
+    prepass_.end(depth_.depth_func());
+    depth_.end();
 }
 
 Scene::ValidationResult
@@ -26,6 +26,8 @@
 #include "log.h"
 #include "shader-source.h"
 #include "stack.h"
+#include "debug-markers.h"
+#include <algorithm>
 
 using std::string;
 using std::vector;
@@ -38,6 +40,30 @@ using LibMatrix::vec2;
 
 static const vec4 lightPosition(0.0f, 3.0f, 2.0f, 1.0f);
 
+//
+// With several lights, they are spread evenly around the Y axis, the first
+// one at lightPosition.
+//
+static vec4
+light_position(unsigned int light, unsigned int lights)
+{
+    float angle = 2.0 * M_PI * light / lights;
+    return vec4(lightPosition.z() * sinf(angle), lightPosition.y(),
+                lightPosition.z() * cosf(angle), 1.0f);
+}
+
+//
+// Sets a uniform array of matrices, which Program::Symbol can't do.
+//
+static void
+set_matrix_array(Program& program, const char* name, const vector<mat4>& matrices)
+{
+    // A vector of matrices has the layout of the uniform array
+    static_assert(sizeof(mat4) == 16 * sizeof(float), "mat4 holds just its elements");
+    const float* values(matrices[0]);
+    glUniformMatrix4fv(program[name].location(), matrices.size(), GL_FALSE, values);
+}
+
 //
 // To create a shadow map, we need a framebuffer object set up for a 
 // depth-only pass.  The render target can then be bound as a texture,
@@ -45,6 +71,11 @@ static const vec4 lightPosition(0.0f, 3.0f, 2.0f, 1.0f);
 // distance-from-light computations when rendering the shadow on the
 // ground below the rendered object.
 //
+// With several cascades, their depth maps are side by side in the texture,
+// each width_ x height_. With several lights, the cascades of each light
+// are in a row of their own, stacked in the texture: a 2D texture array
+// would need GLSL ES 3.00, which the shaders of the scene don't assume.
+//
 class DepthRenderTarget
 {
     Program program_;
@@ -52,28 +83,45 @@ class DepthRenderTarget
     unsigned int canvas_height_;
     unsigned int width_;
     unsigned int height_;
+    unsigned int cascades_;
+    unsigned int lights_;
     unsigned int tex_;
     unsigned int fbo_;
     unsigned int canvas_fbo_;
+    GLenum attachment_;
 public:
     DepthRenderTarget() :
         canvas_width_(0),
         canvas_height_(0),
         width_(0),
         height_(0),
+        cascades_(1),
+        lights_(1),
         tex_(0),
-        fbo_(0) {}
+        fbo_(0),
+        attachment_(GL_DEPTH_ATTACHMENT) {}
     ~DepthRenderTarget() {}
-    bool setup(unsigned int canvas_fbo, unsigned int width, unsigned int height);
+    bool setup(unsigned int canvas_fbo, unsigned int width, unsigned int height,
+               unsigned int size, const DepthConfig& depth, unsigned int cascades,
+               unsigned int lights);
     void teardown();
-    void enable(const mat4& mvp);
+    void enable(const mat4& mvp, unsigned int cascade, unsigned int light);
     void disable();
     unsigned int texture() { return tex_; }
+    unsigned int width() { return width_; }
+    unsigned int height() { return height_; }
     Program& program() { return program_; }
 };
 
+//
+// The size is the width of the depth map of each cascade, the height
+// follows the aspect ratio of the canvas. A size of 0 uses twice the
+// canvas size.
+//
 bool
-DepthRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigned int height)
+DepthRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigned int height,
+                         unsigned int size, const DepthConfig& depth, unsigned int cascades,
+                         unsigned int lights)
 {
     static const string vtx_shader_filename(Options::data_path + "/shaders/depth.vert");
     static const string frg_shader_filename(Options::data_path + "/shaders/depth.frag");
@@ -88,35 +136,53 @@ DepthRenderTarget::setup(unsigned int canvas_fbo, unsigned int width, unsigned i
     canvas_width_ = width;
     canvas_height_ = height;
     canvas_fbo_ = canvas_fbo;
-    width_ = canvas_width_ * 2;
-    height_ = canvas_height_ * 2;
+    cascades_ = cascades;
+    lights_ = lights;
+    float aspect = static_cast<float>(width) / static_cast<float>(height);
+    if (size) {
+        width_ = size;
+        height_ = width_ / aspect;
+    }
+    else {
+        width_ = canvas_width_ * 2;
+        height_ = canvas_height_ * 2;
+    }
 
     // If the texture will be too large for the implemnetation, we need to
     // clamp the dimensions but maintain the aspect ratio.
     GLint tex_size(0);
     glGetIntegerv(GL_MAX_TEXTURE_SIZE, &tex_size);
     unsigned int max_size = static_cast<unsigned int>(tex_size);
-    if (max_size < width_ || max_size < height_) {
-        float aspect = static_cast<float>(width) / static_cast<float>(height);
-        width_ = max_size;
+    if (max_size < width_ * cascades_ || max_size < height_ * lights_) {
+        unsigned int requested_width(width_);
+        unsigned int requested_height(height_);
+        width_ = std::min(max_size / cascades_,
+                          static_cast<unsigned int>(max_size / lights_ * aspect));
         height_ = width_ / aspect;
         Log::debug("DepthRenderTarget::setup: original texture size (%u x %u), clamped to (%u x %u)\n",
-            canvas_width_ * 2, canvas_height_ * 2, width_, height_);
+            requested_width * cascades_, requested_height * lights_,
+            width_ * cascades_, height_ * lights_);
     }
 
+    GLint internalFormat;
+    GLenum format;
+    GLenum type;
+    depth.texture_format(internalFormat, format, type);
+    attachment_ = depth.attachment();
+
     glGenTextures(1, &tex_);
     glBindTexture(GL_TEXTURE_2D, tex_);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, width_, height_, 0,
-                 GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width_ * cascades_, height_ * lights_, 0,
+                 format, type, 0);
     glBindTexture(GL_TEXTURE_2D, 0);
 
     GLExtensions::GenFramebuffers(1, &fbo_);
     GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
-    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, attachment_, GL_TEXTURE_2D,
                                        tex_, 0);
     unsigned int status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
     if (status != GL_FRAMEBUFFER_COMPLETE) {
@@ -144,16 +210,26 @@ DepthRenderTarget::teardown()
 }
 
 void
-DepthRenderTarget::enable(const mat4& mvp)
+DepthRenderTarget::enable(const mat4& mvp, unsigned int cascade, unsigned int light)
 {
     program_.start();
     program_["ModelViewProjectionMatrix"] = mvp;
-    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
-    GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                           tex_, 0);
-    glViewport(0, 0, width_, height_);
-    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-    glClear(GL_DEPTH_BUFFER_BIT);
+
+    // The cascades of all the lights are rendered one after the other into
+    // the same target
+    if (cascade == 0 && light == 0) {
+        DebugMarkers::push("shadow depth");
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        GLExtensions::FramebufferTexture2D(GL_FRAMEBUFFER, attachment_, GL_TEXTURE_2D,
+                               tex_, 0);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        // The depth of the previous frame isn't needed, so it needn't be loaded.
+        // The new depth is sampled by the ground pass, so it can't be invalidated
+        // at the end of this pass.
+        Scene::invalidate_framebuffer(&attachment_, 1);
+        glClear(GL_DEPTH_BUFFER_BIT);
+    }
+    glViewport(cascade * width_, light * height_, width_, height_);
 }
 
 void DepthRenderTarget::disable()
@@ -161,6 +237,7 @@ void DepthRenderTarget::disable()
     GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_fbo_);
     glViewport(0, 0, canvas_width_, canvas_height_);
     glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    DebugMarkers::pop();
 }
 
 //
@@ -173,11 +250,12 @@ void DepthRenderTarget::disable()
 // (effectively the distance from the light to the object at that point)
 // is less than the Z component of that coordinate (effectively the distance
 // from the light to the ground at that point) then that location is in shadow.
+// With several lights, each of them has its own light matrix and depth maps.
 //
 class GroundRenderer
 {
     Program program_;
-    mat4 light_;
+    vector<mat4> lights_;
     Stack4 modelview_;
     mat4 projection_;
     int positionLocation_;
@@ -191,13 +269,17 @@ public:
         positionLocation_(0),
         bufferObject_(0) {}
     ~GroundRenderer() {}
-    bool setup(const mat4& projection, unsigned int texture);
+    bool setup(const mat4& projection, unsigned int texture, unsigned int cascades,
+               unsigned int pcfRadius, const vec2& cascadeTexelSize, unsigned int lights,
+               const DepthConfig& depth);
     void teardown();
     void draw();
 };
 
 bool
-GroundRenderer::setup(const mat4& projection, unsigned int texture)
+GroundRenderer::setup(const mat4& projection, unsigned int texture, unsigned int cascades,
+                      unsigned int pcfRadius, const vec2& cascadeTexelSize, unsigned int lights,
+                      const DepthConfig& depth)
 {
     projection_ = projection;
     texture_ = texture;
@@ -206,15 +288,40 @@ GroundRenderer::setup(const mat4& projection, unsigned int texture)
     static const vec4 materialDiffuse(0.3f, 0.3f, 0.3f, 1.0f);
     static const string vtx_shader_filename(Options::data_path + "/shaders/shadow.vert");
     static const string frg_shader_filename(Options::data_path + "/shaders/shadow.frag");
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
+    static const string frg_cascades_shader_filename(Options::data_path + "/shaders/shadow-cascades.frag");
+    static const string vtx_lights_shader_filename(Options::data_path + "/shaders/shadow-lights.vert");
+    static const string frg_lights_shader_filename(Options::data_path + "/shaders/shadow-lights.frag");
+    bool multiLight(lights > 1);
+    bool filtered(cascades > 1 || pcfRadius > 0 || multiLight);
+    ShaderSource vtx_source(multiLight ? vtx_lights_shader_filename : vtx_shader_filename);
+    ShaderSource frg_source(multiLight ? frg_lights_shader_filename :
+                            filtered ? frg_cascades_shader_filename : frg_shader_filename);
 
     vtx_source.add_const("MaterialDiffuse", materialDiffuse);
+    depth.add_sample_consts(frg_source);
+    if (multiLight) {
+        vtx_source.replace("$LIGHTS$", Util::toString(lights));
+        frg_source.replace("$LIGHTS$", Util::toString(lights));
+    }
+    if (filtered) {
+        frg_source.replace("$CASCADES$", Util::toString(cascades));
+        frg_source.replace("$PCF_RADIUS$", Util::toString(pcfRadius));
+    }
 
     if (!Scene::load_shaders_from_strings(program_, vtx_source.str(), frg_source.str())) {
         return false;
     }
     positionLocation_ = program_["position"].location();
+    if (filtered) {
+        program_.start();
+        program_["CascadeTexelSize"] = cascadeTexelSize;
+        if (multiLight) {
+            // The ground is only darkened by the shadows
+            program_["DiffuseLighting"] = 0.0f;
+            program_["DepthBias"] = 0.1505f;
+        }
+        program_.stop();
+    }
 
     // Set up the position data for our "quad".
     vertices_.push_back(vec2(-1.0, -1.0));
@@ -229,15 +336,21 @@ GroundRenderer::setup(const mat4& projection, unsigned int texture)
                  &vertices_.front(), GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // Set up the light matrix with a bias that will convert values
+    // Set up the light matrices with a bias that will convert values
     // in the range of [-1, 1] to [0, 1)], then add in the projection
     // and the "look at" matrix from the light position.
-    light_ *= LibMatrix::Mat4::translate(0.5, 0.5, 0.5);
-    light_ *= LibMatrix::Mat4::scale(0.5, 0.5, 0.5);
-    light_ *= projection_;
-    light_ *= LibMatrix::Mat4::lookAt(lightPosition.x(), lightPosition.y(), lightPosition.z(),
-                                      0.0, 0.0, 0.0,
-                                      0.0, 1.0, 0.0);
+    lights_.clear();
+    for (unsigned int l = 0; l < lights; l++) {
+        vec4 position(light_position(l, lights));
+        mat4 light;
+        light *= LibMatrix::Mat4::translate(0.5, 0.5, 0.5);
+        light *= LibMatrix::Mat4::scale(0.5, 0.5, 0.5);
+        light *= projection_;
+        light *= LibMatrix::Mat4::lookAt(position.x(), position.y(), position.z(),
+                                         0.0, 0.0, 0.0,
+                                         0.0, 1.0, 0.0);
+        lights_.push_back(light);
+    }
 
     return true;
 }
@@ -271,7 +384,10 @@ GroundRenderer::draw()
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture_);
     program_["ShadowMap"] = 0;
-    program_["LightMatrix"] = light_;
+    if (lights_.size() > 1)
+        set_matrix_array(program_, "LightMatrix", lights_);
+    else
+        program_["LightMatrix"] = lights_[0];
     program_["ModelViewProjectionMatrix"] = mvp;
 
     glEnableVertexAttribArray(positionLocation_);
@@ -291,20 +407,33 @@ class ShadowPrivate
     Program program_;
     Stack4 modelview_;
     Stack4 projection_;
+    // The projection of the depth passes, into the depth range of depth_
+    mat4 lightProjection_;
     Mesh mesh_;
     vec3 centerVec_;
     float radius_;
     float rotation_;
     float rotationSpeed_;
     bool useVbo_;
-    
+    unsigned int cascades_;
+    unsigned int lights_;
+    DepthPrepass prepass_;
+    DepthConfig depth_;
+    // Per-frame storage, kept so that drawing doesn't allocate
+    vector<mat4> lightMvps_;
+    vector<mat4> lightViews_;
+    vector<mat4> lightMatrices_;
+    vector<GLint> attribLocations_;
+
 public:
     ShadowPrivate(Canvas& canvas) :
         canvas_(canvas),
         radius_(0.0),
         rotation_(0.0),
         rotationSpeed_(36.0),
-        useVbo_(true) {}
+        useVbo_(true),
+        cascades_(1),
+        lights_(1) {}
     ~ShadowPrivate() {}
 
     bool setup(map<string, Scene::Option>& options);
@@ -319,13 +448,31 @@ ShadowPrivate::setup(map<string, Scene::Option>& options)
     // Program object setup
     static const string vtx_shader_filename(Options::data_path + "/shaders/light-basic.vert");
     static const string frg_shader_filename(Options::data_path + "/shaders/light-basic.frag");
+    static const string vtx_lights_shader_filename(Options::data_path + "/shaders/shadow-lights-model.vert");
+    static const string frg_lights_shader_filename(Options::data_path + "/shaders/shadow-lights.frag");
     static const vec4 materialDiffuse(1.0f, 1.0f, 1.0f, 1.0f);
 
-    ShaderSource vtx_source(vtx_shader_filename);
-    ShaderSource frg_source(frg_shader_filename);
+    cascades_ = std::max(Util::fromString<unsigned int>(options["cascades"].value), 1U);
+    unsigned int pcfKernel = std::max(Util::fromString<unsigned int>(options["pcf"].value), 1U);
+    lights_ = std::min(std::max(Util::fromString<unsigned int>(options["lights"].value), 1U), 6U);
+    depth_.setup(options);
+
+    // With several lights, the model is shaded with their shadow maps too
+    bool multiLight(lights_ > 1);
+    ShaderSource vtx_source(multiLight ? vtx_lights_shader_filename : vtx_shader_filename);
+    ShaderSource frg_source(multiLight ? frg_lights_shader_filename : frg_shader_filename);
 
-    vtx_source.add_const("LightSourcePosition", lightPosition);
     vtx_source.add_const("MaterialDiffuse", materialDiffuse);
+    if (multiLight) {
+        depth_.add_sample_consts(frg_source);
+        vtx_source.replace("$LIGHTS$", Util::toString(lights_));
+        frg_source.replace("$LIGHTS$", Util::toString(lights_));
+        frg_source.replace("$CASCADES$", Util::toString(cascades_));
+        frg_source.replace("$PCF_RADIUS$", Util::toString((pcfKernel - 1) / 2));
+    }
+    else {
+        vtx_source.add_const("LightSourcePosition", lightPosition);
+    }
 
     if (!Scene::load_shaders_from_strings(program_, vtx_source.str(), frg_source.str())) {
         return false;
@@ -374,18 +521,45 @@ ShadowPrivate::setup(map<string, Scene::Option>& options)
     fovy *= 180.0;
     float aspect(static_cast<float>(canvas_.width())/static_cast<float>(canvas_.height()));
     projection_.perspective(fovy, aspect, 2.0, 50.0);
+    lightProjection_ = depth_.perspective(fovy, aspect, 2.0, 50.0);
 
-    if (!depthTarget_.setup(canvas_.fbo(), canvas_.width(), canvas_.height())) {
+    if (!depthTarget_.setup(canvas_.fbo(), canvas_.width(), canvas_.height(),
+                            Util::fromString<unsigned int>(options["map-size"].value),
+                            depth_, cascades_, lights_))
+    {
         Log::error("Failed to set up the render target for the depth pass\n");
         return false;
     }
 
-    if (!ground_.setup(projection_.getCurrent(), depthTarget_.texture())) {
+    vec2 cascadeTexelSize(1.0 / depthTarget_.width(), 1.0 / depthTarget_.height());
+    if (!ground_.setup(projection_.getCurrent(), depthTarget_.texture(),
+                       cascades_, (pcfKernel - 1) / 2, cascadeTexelSize, lights_, depth_))
+    {
         Log::error("Failed to set up the ground renderer\n");
         return false;
     }
 
-    return true;
+    if (multiLight) {
+        // The light directions are in eye coordinates, like the
+        // LightSourcePosition of light-basic.vert
+        vector<float> directions;
+        for (unsigned int l = 0; l < lights_; l++) {
+            vec4 position(light_position(l, lights_));
+            vec3 direction(position.x(), position.y(), position.z());
+            direction.normalize();
+            directions.push_back(direction.x());
+            directions.push_back(direction.y());
+            directions.push_back(direction.z());
+        }
+        program_.start();
+        glUniform3fv(program_["LightDirection"].location(), lights_, &directions[0]);
+        program_["DiffuseLighting"] = 1.0f;
+        program_["DepthBias"] = 0.005f;
+        program_["CascadeTexelSize"] = cascadeTexelSize;
+        program_.stop();
+    }
+
+    return prepass_.setup(options);
 }
 
 
@@ -394,6 +568,8 @@ ShadowPrivate::teardown()
 {
     depthTarget_.teardown();
     ground_.teardown();
+    prepass_.teardown();
+    depth_.teardown();
     program_.stop();
     program_.release();
     mesh_.reset();
@@ -411,38 +587,59 @@ ShadowPrivate::draw()
     // To perform the depth pass, set up the model-view transformation so
     // that we're looking at the horse from the light position.  That will
     // give us the appropriate view for the shadow.
-    modelview_.push();
-    modelview_.loadIdentity();
-    modelview_.lookAt(lightPosition.x(), lightPosition.y(), lightPosition.z(),
-                      0.0, 0.0, 0.0,
-                      0.0, 1.0, 0.0);
-    modelview_.rotate(rotation_, 0.0f, 1.0f, 0.0f);
-    mat4 mvp(projection_.getCurrent());
-    mvp *= modelview_.getCurrent();
-    modelview_.pop();
-
-    // Enable the depth render target with our transformation and render.
-    depthTarget_.enable(mvp);
-    vector<GLint> attrib_locations;
-    attrib_locations.push_back(depthTarget_.program()["position"].location());
-    attrib_locations.push_back(depthTarget_.program()["normal"].location());
-    mesh_.set_attrib_locations(attrib_locations);
-    if (useVbo_) {
-        mesh_.render_vbo();
+    lightMvps_.clear();
+    lightViews_.clear();
+    for (unsigned int l = 0; l < lights_; l++) {
+        vec4 position(light_position(l, lights_));
+        modelview_.push();
+        modelview_.loadIdentity();
+        modelview_.lookAt(position.x(), position.y(), position.z(),
+                          0.0, 0.0, 0.0,
+                          0.0, 1.0, 0.0);
+        modelview_.rotate(rotation_, 0.0f, 1.0f, 0.0f);
+        mat4 lightMvp(lightProjection_);
+        lightMvp *= modelview_.getCurrent();
+        lightMvps_.push_back(lightMvp);
+        lightViews_.push_back(modelview_.getCurrent());
+        modelview_.pop();
     }
-    else {
-        mesh_.render_array();
+
+    // Enable the depth render target with our transformation and render,
+    // once for each cascade of each light. Cascade c zooms in on the center
+    // of the light view 2^(cascades - 1 - c) times, the last one is the
+    // whole view.
+    attribLocations_.clear();
+    attribLocations_.push_back(depthTarget_.program()["position"].location());
+    attribLocations_.push_back(depthTarget_.program()["normal"].location());
+    mesh_.set_attrib_locations(attribLocations_);
+    depth_.begin();
+    for (unsigned int l = 0; l < lights_; l++) {
+        for (unsigned int c = 0; c < cascades_; c++) {
+            float zoom = static_cast<float>(1U << (cascades_ - 1 - c));
+            mat4 mvp(LibMatrix::Mat4::scale(zoom, zoom, 1.0));
+            mvp *= lightMvps_[l];
+            depthTarget_.enable(mvp, c, l);
+            if (useVbo_) {
+                mesh_.render_vbo();
+            }
+            else {
+                mesh_.render_array();
+            }
+        }
     }
     depthTarget_.disable();
+    depth_.end();
 
     // Ground rendering using the above generated texture...
+    DebugMarkers::push("ground");
     ground_.draw();
+    DebugMarkers::pop();
 
     // Draw the "normal" view of the horse
     modelview_.push();
     modelview_.translate(-centerVec_.x(), -centerVec_.y(), -(centerVec_.z() + 2.0 + radius_));
     modelview_.rotate(rotation_, 0.0f, 1.0f, 0.0f);
-    mvp = projection_.getCurrent();
+    mat4 mvp(projection_.getCurrent());
     mvp *= modelview_.getCurrent();
 
     program_.start();
@@ -453,16 +650,36 @@ ShadowPrivate::draw()
     LibMatrix::mat4 normal_matrix(modelview_.getCurrent());
     normal_matrix.inverse().transpose();
     program_["NormalMatrix"] = normal_matrix;
-    attrib_locations.clear();
-    attrib_locations.push_back(program_["position"].location());
-    attrib_locations.push_back(program_["normal"].location());
-    mesh_.set_attrib_locations(attrib_locations);
+    if (lights_ > 1) {
+        // The shadow coordinates of the model, with the same bias as the
+        // ground's, in the standard depth range
+        lightMatrices_.clear();
+        for (unsigned int l = 0; l < lights_; l++) {
+            mat4 light(LibMatrix::Mat4::translate(0.5, 0.5, 0.5));
+            light *= LibMatrix::Mat4::scale(0.5, 0.5, 0.5);
+            light *= projection_.getCurrent();
+            light *= lightViews_[l];
+            lightMatrices_.push_back(light);
+        }
+        set_matrix_array(program_, "LightMatrix", lightMatrices_);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, depthTarget_.texture());
+        program_["ShadowMap"] = 0;
+    }
+    attribLocations_.clear();
+    attribLocations_.push_back(program_["position"].location());
+    attribLocations_.push_back(program_["normal"].location());
+    mesh_.set_attrib_locations(attribLocations_);
+    prepass_.begin(mesh_, mvp, program_, useVbo_);
     if (useVbo_) {
         mesh_.render_vbo();
     }
     else {
         mesh_.render_array();
     }
+    prepass_.end();
+    if (lights_ > 1)
+        glBindTexture(GL_TEXTURE_2D, 0);
 
     // Per-frame cleanup
     modelview_.pop();
@@ -478,6 +695,20 @@ SceneShadow::SceneShadow(Canvas& canvas) :
     options_["interleave"] = Scene::Option("interleave", "false",
                                            "Whether to interleave vertex attribute data",
                                            "false,true");
+    options_["map-size"] = Scene::Option("map-size", "0",
+                                         "The width of the shadow map of each cascade, its height follows"
+                                         " the aspect ratio (0 for twice the canvas size)");
+    options_["cascades"] = Scene::Option("cascades", "1",
+                                         "The number of shadow map cascades, each covering twice"
+                                         " the area of the previous one at the same resolution");
+    options_["pcf"] = Scene::Option("pcf", "1",
+                                    "The size of the percentage-closer filtering kernel, in texels"
+                                    " on each side (1 for a single depth test)");
+    options_["lights"] = Scene::Option("lights", "1",
+                                       "The number of lights around the model, each with its own"
+                                       " shadow maps that shade both the ground and the model (1-6)");
+    DepthPrepass::add_option(options_);
+    DepthConfig::add_options(options_);
 }
 
 bool
@@ -502,6 +733,9 @@ SceneShadow::supported(bool show_errors)
         ret = false;
     }
 
+    if (!DepthConfig::supported(options_, false, show_errors))
+        ret = false;
+
     return ret;
 }
 
@@ -556,7 +790,7 @@ SceneShadow::update()
 {
     Scene::update();
     // Add scene-specific update here
-    priv_->update(lastUpdateTime_ - startTime_);
+    priv_->update(animation_time());
 }
 
 void
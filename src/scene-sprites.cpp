@@ -0,0 +1,511 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "texture.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+/* The textures used as atlas pages, each divided into atlas_cells x atlas_cells sprites */
+static const char *atlas_pages[] = {
+    "crate-base", "effect-2d", "desktop-window", "jellyfish256"
+};
+static const unsigned int max_atlas_pages = sizeof(atlas_pages) / sizeof(*atlas_pages);
+static const unsigned int atlas_cells = 4;
+
+struct SceneSpritesPrivate {
+    enum Mode {
+        ModePerSprite,
+        ModeBatched,
+        ModeInstanced
+    };
+
+    struct Sprite {
+        /* The position at time 0 and the velocity, in pixels */
+        float x, y;
+        float vx, vy;
+        unsigned int page;
+        unsigned int cell;
+    };
+
+    SceneSpritesPrivate() :
+        mode(ModeBatched), size(0), width(0), height(0), time(0.0),
+        draws(0), corner_buffer(0), stream_buffer(0) {}
+
+    Mode mode;
+    std::vector<Sprite> sprites;
+    float size;
+    int width;
+    int height;
+    double time;
+    /* The draws of the last frame */
+    unsigned int draws;
+
+    Program program;
+    std::vector<GLuint> pages;
+    GLuint corner_buffer;
+    GLuint stream_buffer;
+    /* The vertices (batched) or the instances (instanced) of a frame */
+    std::vector<float> stream;
+
+    void release()
+    {
+        if (!pages.empty()) {
+            Texture::release(pages.size(), &pages[0]);
+            pages.clear();
+        }
+        if (corner_buffer) {
+            glDeleteBuffers(1, &corner_buffer);
+            corner_buffer = 0;
+        }
+        if (stream_buffer) {
+            glDeleteBuffers(1, &stream_buffer);
+            stream_buffer = 0;
+        }
+        std::vector<float>().swap(stream);
+
+        program.stop();
+        program.release();
+    }
+
+    /*
+     * Gets the rectangle of a sprite in clip coordinates and in its atlas
+     * page, as (x, y, width, height). The sprites move across the screen,
+     * wrapping around its edges.
+     */
+    void rects(const Sprite &sprite, float rect[4], float uv_rect[4]) const
+    {
+        float range_x = width + size;
+        float range_y = height + size;
+        float x = std::fmod(sprite.x + sprite.vx * time, range_x);
+        float y = std::fmod(sprite.y + sprite.vy * time, range_y);
+
+        if (x < 0.0f)
+            x += range_x;
+        if (y < 0.0f)
+            y += range_y;
+
+        rect[0] = 2.0f * (x - size) / width - 1.0f;
+        rect[1] = 2.0f * (y - size) / height - 1.0f;
+        rect[2] = 2.0f * size / width;
+        rect[3] = 2.0f * size / height;
+
+        uv_rect[0] = static_cast<float>(sprite.cell % atlas_cells) / atlas_cells;
+        uv_rect[1] = static_cast<float>(sprite.cell / atlas_cells) / atlas_cells;
+        uv_rect[2] = 1.0f / atlas_cells;
+        uv_rect[3] = 1.0f / atlas_cells;
+    }
+
+    static bool page_less(const Sprite &a, const Sprite &b)
+    {
+        return a.page < b.page;
+    }
+
+    void draw_per_sprite();
+    void draw_batched();
+    void draw_instanced();
+};
+
+/*
+ * Draws each sprite on its own, like a UI drawing its widgets one by one,
+ * binding the page of a sprite only when it changes.
+ */
+void
+SceneSpritesPrivate::draw_per_sprite()
+{
+    GLint corner_location = program["corner"].location();
+    GLint rect_location = program["rect"].location();
+    GLint uv_rect_location = program["uv_rect"].location();
+    unsigned int bound_page = max_atlas_pages;
+
+    glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+    glEnableVertexAttribArray(corner_location);
+    glVertexAttribPointer(corner_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    for (std::vector<Sprite>::const_iterator iter = sprites.begin();
+         iter != sprites.end();
+         iter++)
+    {
+        float rect[4];
+        float uv_rect[4];
+        rects(*iter, rect, uv_rect);
+
+        if (iter->page != bound_page) {
+            glBindTexture(GL_TEXTURE_2D, pages[iter->page]);
+            bound_page = iter->page;
+        }
+
+        glUniform4fv(rect_location, 1, rect);
+        glUniform4fv(uv_rect_location, 1, uv_rect);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        draws++;
+    }
+
+    glDisableVertexAttribArray(corner_location);
+}
+
+/*
+ * Writes the vertices of all the sprites into a streaming buffer, and draws
+ * each run of sprites with the same page at once.
+ */
+void
+SceneSpritesPrivate::draw_batched()
+{
+    static const float corners[6][2] = {
+        {0.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 1.0f},
+        {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}
+    };
+    GLint position_location = program["position"].location();
+    GLint texcoord_location = program["texcoord"].location();
+
+    stream.clear();
+    for (std::vector<Sprite>::const_iterator iter = sprites.begin();
+         iter != sprites.end();
+         iter++)
+    {
+        float rect[4];
+        float uv_rect[4];
+        rects(*iter, rect, uv_rect);
+
+        for (unsigned int i = 0; i < 6; i++) {
+            stream.push_back(rect[0] + corners[i][0] * rect[2]);
+            stream.push_back(rect[1] + corners[i][1] * rect[3]);
+            stream.push_back(uv_rect[0] + corners[i][0] * uv_rect[2]);
+            stream.push_back(uv_rect[1] + corners[i][1] * uv_rect[3]);
+        }
+    }
+
+    /* Orphan the last frame's data instead of waiting for its draws */
+    glBindBuffer(GL_ARRAY_BUFFER, stream_buffer);
+    glBufferData(GL_ARRAY_BUFFER, stream.size() * sizeof(float), &stream[0],
+                 GL_STREAM_DRAW);
+    glEnableVertexAttribArray(position_location);
+    glEnableVertexAttribArray(texcoord_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE,
+                          4 * sizeof(float), 0);
+    glVertexAttribPointer(texcoord_location, 2, GL_FLOAT, GL_FALSE,
+                          4 * sizeof(float),
+                          reinterpret_cast<const void *>(2 * sizeof(float)));
+
+    size_t first = 0;
+    while (first < sprites.size()) {
+        size_t last = first + 1;
+        while (last < sprites.size() && sprites[last].page == sprites[first].page)
+            last++;
+
+        glBindTexture(GL_TEXTURE_2D, pages[sprites[first].page]);
+        glDrawArrays(GL_TRIANGLES, first * 6, (last - first) * 6);
+        draws++;
+        first = last;
+    }
+
+    glDisableVertexAttribArray(texcoord_location);
+    glDisableVertexAttribArray(position_location);
+}
+
+/*
+ * Writes the rectangles of all the sprites into a streaming buffer, and
+ * draws each run of sprites with the same page as instances of a quad.
+ */
+void
+SceneSpritesPrivate::draw_instanced()
+{
+    GLint corner_location = program["corner"].location();
+    GLint rect_location = program["rect"].location();
+    GLint uv_rect_location = program["uv_rect"].location();
+
+    stream.resize(sprites.size() * 8);
+    for (size_t i = 0; i < sprites.size(); i++)
+        rects(sprites[i], &stream[i * 8], &stream[i * 8 + 4]);
+
+    glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+    glEnableVertexAttribArray(corner_location);
+    glVertexAttribPointer(corner_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    /* Orphan the last frame's data instead of waiting for its draws */
+    glBindBuffer(GL_ARRAY_BUFFER, stream_buffer);
+    glBufferData(GL_ARRAY_BUFFER, stream.size() * sizeof(float), &stream[0],
+                 GL_STREAM_DRAW);
+    glEnableVertexAttribArray(rect_location);
+    glEnableVertexAttribArray(uv_rect_location);
+    GLExtensions::VertexAttribDivisor(rect_location, 1);
+    GLExtensions::VertexAttribDivisor(uv_rect_location, 1);
+
+    /* There is no base instance in GLES, so each run offsets the attributes */
+    size_t first = 0;
+    while (first < sprites.size()) {
+        size_t last = first + 1;
+        while (last < sprites.size() && sprites[last].page == sprites[first].page)
+            last++;
+
+        glVertexAttribPointer(rect_location, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+                              reinterpret_cast<const void *>(first * 8 * sizeof(float)));
+        glVertexAttribPointer(uv_rect_location, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float),
+                              reinterpret_cast<const void *>((first * 8 + 4) * sizeof(float)));
+        glBindTexture(GL_TEXTURE_2D, pages[sprites[first].page]);
+        GLExtensions::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, last - first);
+        draws++;
+        first = last;
+    }
+
+    GLExtensions::VertexAttribDivisor(uv_rect_location, 0);
+    GLExtensions::VertexAttribDivisor(rect_location, 0);
+    glDisableVertexAttribArray(uv_rect_location);
+    glDisableVertexAttribArray(rect_location);
+    glDisableVertexAttribArray(corner_location);
+}
+
+SceneSprites::SceneSprites(Canvas &pCanvas) :
+    Scene(pCanvas, "sprites")
+{
+    priv_ = new SceneSpritesPrivate();
+    options_["sprites"] = Scene::Option("sprites", "4000",
+                                        "The number of sprites drawn every frame");
+    options_["mode"] = Scene::Option("mode", "batched",
+                                     "How the sprites are drawn: one draw per sprite, batched into"
+                                     " a streaming vertex buffer, or instanced",
+                                     "per-sprite,batched,instanced");
+    options_["pages"] = Scene::Option("pages", "2",
+                                      "The number of textures the sprites come from (1-4)");
+    options_["sort"] = Scene::Option("sort", "false",
+                                     "Whether to sort the sprites by texture, so that they need"
+                                     " fewer texture changes and draws",
+                                     "false,true");
+    options_["sprite-size"] = Scene::Option("sprite-size", "32",
+                                            "The size of the sprites, in pixels");
+}
+
+SceneSprites::~SceneSprites()
+{
+    delete priv_;
+}
+
+bool
+SceneSprites::supported(bool show_errors)
+{
+    if (options_["mode"].value == "instanced" &&
+        (GLExtensions::DrawArraysInstanced == 0 ||
+         GLExtensions::VertexAttribDivisor == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested instanced sprites but instanced arrays"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneSprites::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneSprites::unload()
+{
+}
+
+bool
+SceneSprites::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/sprites.vert");
+    static const std::string vtx_batched_shader_filename(Options::data_path + "/shaders/desktop.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/desktop.frag");
+
+    SceneSpritesPrivate &p(*priv_);
+
+    /* Parse the options */
+    const std::string &mode = options_["mode"].value;
+    if (mode == "per-sprite")
+        p.mode = SceneSpritesPrivate::ModePerSprite;
+    else if (mode == "instanced")
+        p.mode = SceneSpritesPrivate::ModeInstanced;
+    else
+        p.mode = SceneSpritesPrivate::ModeBatched;
+
+    unsigned int count = Util::fromString<unsigned int>(options_["sprites"].value);
+    unsigned int pages = std::min(Util::fromString<unsigned int>(options_["pages"].value),
+                                  max_atlas_pages);
+    p.size = Util::fromString<float>(options_["sprite-size"].value);
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+
+    if (count == 0 || pages == 0 || p.size <= 0.0f) {
+        Log::error("The sprites, pages and sprite-size options must be positive\n");
+        return false;
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(p.mode == SceneSpritesPrivate::ModeBatched ?
+                            vtx_batched_shader_filename : vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    vtx_source.replace("SPRITE_STORAGE",
+                       p.mode == SceneSpritesPrivate::ModePerSprite ? "uniform" : "attribute");
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    /* Load the atlas pages */
+    Texture::find_textures();
+    p.pages.resize(pages, 0);
+    for (unsigned int i = 0; i < pages; i++) {
+        if (!Texture::load(atlas_pages[i], &p.pages[i], GL_LINEAR, GL_LINEAR, 0))
+            return false;
+    }
+
+    /* Create the sprites, in a random order of their pages unless sorted */
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    p.sprites.clear();
+    for (unsigned int i = 0; i < count; i++) {
+        SceneSpritesPrivate::Sprite sprite;
+        float angle = 2.0f * M_PI * unit(random);
+        float speed = 20.0f + 80.0f * unit(random);
+
+        sprite.x = unit(random) * (p.width + p.size);
+        sprite.y = unit(random) * (p.height + p.size);
+        sprite.vx = speed * std::cos(angle);
+        sprite.vy = speed * std::sin(angle);
+        sprite.page = std::min(static_cast<unsigned int>(unit(random) * pages), pages - 1);
+        sprite.cell = std::min(static_cast<unsigned int>(unit(random) * atlas_cells * atlas_cells),
+                               atlas_cells * atlas_cells - 1);
+        p.sprites.push_back(sprite);
+    }
+
+    if (options_["sort"].value == "true") {
+        std::stable_sort(p.sprites.begin(), p.sprites.end(),
+                         SceneSpritesPrivate::page_less);
+    }
+
+    /* Create the buffers */
+    static const GLfloat corners[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        0.0f, 1.0f,
+        1.0f, 1.0f
+    };
+
+    glGenBuffers(1, &p.corner_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, p.corner_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glGenBuffers(1, &p.stream_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    p.program.start();
+    p.program["MaterialTexture0"] = 0;
+
+    /* Draw the sprites over each other in order, like a UI */
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    p.time = 0.0;
+    p.draws = 0;
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneSprites::teardown()
+{
+    Log::debug("SceneSprites: %u draws per frame\n", priv_->draws);
+
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneSprites::update()
+{
+    Scene::update();
+
+    priv_->time = animation_time();
+}
+
+void
+SceneSprites::draw()
+{
+    SceneSpritesPrivate &p(*priv_);
+
+    p.draws = 0;
+    p.program.start();
+    glActiveTexture(GL_TEXTURE0);
+
+    if (p.mode == SceneSpritesPrivate::ModePerSprite)
+        p.draw_per_sprite();
+    else if (p.mode == SceneSpritesPrivate::ModeInstanced)
+        p.draw_instanced();
+    else
+        p.draw_batched();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Scene::ValidationResult
+SceneSprites::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneSprites::rates()
+{
+    double elapsed = elapsed_time();
+    double sprites = static_cast<double>(priv_->sprites.size()) * frame_count();
+
+    return std::vector<Rate>(1, Rate("SpritesPerSecond", "sprites_per_second",
+                                     elapsed > 0.0 ? sprites / elapsed : 0.0));
+}
+
+std::vector<std::string>
+SceneSprites::textures()
+{
+    unsigned int pages = std::min(Util::fromString<unsigned int>(options_["pages"].value),
+                                  max_atlas_pages);
+
+    return std::vector<std::string>(atlas_pages, atlas_pages + pages);
+}
@@ -0,0 +1,281 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "canvas.h"
+#include "frame-stats.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#if !defined(WIN32)
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+struct SceneSyncPrivate {
+    enum Method {
+        MethodFence,
+        MethodFinish,
+        MethodFlush,
+        MethodNativeFence
+    };
+
+    SceneSyncPrivate() :
+        method(MethodFence), quad_buffer(0) {}
+
+    Method method;
+
+    Program program;
+    GLuint quad_buffer;
+    /* The time from after the draw to the completion of the sync, in µs */
+    FrameStats round_trip;
+
+    void release()
+    {
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+
+    void fence()
+    {
+        static const GLuint64 timeout_ns = 1000000000;
+        GLsync sync = GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GLenum status;
+
+        do {
+            status = GLExtensions::ClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                                  timeout_ns);
+        } while (status == GL_TIMEOUT_EXPIRED);
+
+        GLExtensions::DeleteSync(sync);
+    }
+
+    void native_fence(Canvas &canvas)
+    {
+        int fence_fd = canvas.create_native_fence();
+
+#if !defined(WIN32)
+        if (fence_fd < 0)
+            return;
+
+        /* The fd becomes readable once the fence has signalled */
+        struct pollfd pfd = { fence_fd, POLLIN, 0 };
+        while (poll(&pfd, 1, 1000) == 0);
+
+        close(fence_fd);
+#else
+        static_cast<void>(fence_fd);
+#endif
+    }
+};
+
+SceneSync::SceneSync(Canvas &pCanvas) :
+    Scene(pCanvas, "sync")
+{
+    priv_ = new SceneSyncPrivate();
+    options_["method"] = Scene::Option("method", "fence",
+                                       "How to wait for the GPU after each draw: a fence sync, glFinish(), glFlush() (which doesn't wait) or a native fence fd",
+                                       "fence,finish,flush,native-fence");
+    options_["workload"] = Scene::Option("workload", "trivial",
+                                         "What each frame draws before waiting: a few pixels, or a full-screen quad running a long shader",
+                                         "trivial,heavy");
+    options_["iterations"] = Scene::Option("iterations", "256",
+                                           "The number of loop iterations per pixel of the heavy workload");
+}
+
+SceneSync::~SceneSync()
+{
+    delete priv_;
+}
+
+bool
+SceneSync::supported(bool show_errors)
+{
+    if (options_["method"].value == "fence" &&
+        (GLExtensions::FenceSync == 0 || GLExtensions::ClientWaitSync == 0 ||
+         GLExtensions::DeleteSync == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested fence syncs but sync objects are not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneSync::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneSync::unload()
+{
+}
+
+bool
+SceneSync::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/sync.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/sync.frag");
+
+    SceneSyncPrivate &p(*priv_);
+
+    /* Parse the options */
+    const std::string &method(options_["method"].value);
+    bool heavy = options_["workload"].value == "heavy";
+    unsigned int iterations = Util::fromString<unsigned int>(options_["iterations"].value);
+
+    if (method == "finish")
+        p.method = SceneSyncPrivate::MethodFinish;
+    else if (method == "flush")
+        p.method = SceneSyncPrivate::MethodFlush;
+    else if (method == "native-fence")
+        p.method = SceneSyncPrivate::MethodNativeFence;
+    else
+        p.method = SceneSyncPrivate::MethodFence;
+
+    /* Whether native fences are supported is only known by the canvas */
+    if (p.method == SceneSyncPrivate::MethodNativeFence) {
+        int fence_fd = canvas_.create_native_fence();
+        if (fence_fd < 0) {
+            Log::error("Requested native fences but they are not supported!\n");
+            return false;
+        }
+#if !defined(WIN32)
+        close(fence_fd);
+#endif
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    frg_source.replace("ITERATIONS", Util::toString(heavy ? iterations : 1));
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.quad_buffer = FullscreenQuad::create();
+
+    /* The trivial workload only covers a few pixels */
+    p.program.start();
+    p.program["Scale"] = heavy ? 1.0f : 4.0f / canvas_.width();
+
+    glDisable(GL_DEPTH_TEST);
+
+    p.round_trip.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneSync::teardown()
+{
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneSync::update()
+{
+    Scene::update();
+}
+
+/*
+ * Draws the workload and times how long the requested method takes to
+ * return, which for all but glFlush() is the round trip to the GPU.
+ */
+void
+SceneSync::draw()
+{
+    SceneSyncPrivate &p(*priv_);
+    GLint position_location = p.program["position"].location();
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    uint64_t start = Util::get_timestamp_us();
+
+    switch (p.method) {
+        case SceneSyncPrivate::MethodFence:
+            p.fence();
+            break;
+        case SceneSyncPrivate::MethodFinish:
+            glFinish();
+            break;
+        case SceneSyncPrivate::MethodFlush:
+            glFlush();
+            break;
+        case SceneSyncPrivate::MethodNativeFence:
+            p.native_fence(canvas_);
+            break;
+    }
+
+    p.round_trip.add(Util::get_timestamp_us() - start);
+}
+
+Scene::ValidationResult
+SceneSync::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneSync::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("RoundTrip", "round_trip",
+                                                   priv_->round_trip));
+}
+
+void
+SceneSync::reset_measurements()
+{
+    priv_->round_trip.reset();
+}
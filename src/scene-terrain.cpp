@@ -24,12 +24,15 @@
 #include "stack.h"
 #include "vec.h"
 #include "log.h"
+#include "options.h"
 #include "mesh.h"
 #include "util.h"
 #include "texture.h"
 #include "shader-source.h"
 #include "renderer.h"
 
+#include <cmath>
+
 using LibMatrix::vec2;
 using LibMatrix::vec3;
 using LibMatrix::vec4;
@@ -39,14 +42,25 @@ class SceneTerrainPrivate
 {
 public:
     SceneTerrainPrivate(Canvas &canvas, const LibMatrix::vec2 &repeat_overlay,
-                        bool use_bloom, bool use_tilt_shift) :
+                        bool use_bloom, bool use_tilt_shift,
+                        const std::string &texture_format, bool use_compute,
+                        bool invalidate_targets, unsigned int world_tiles,
+                        unsigned int lod_levels, unsigned int tile_uploads,
+                        unsigned int tessellation_level,
+                        Mesh::GridTopology topology) :
         canvas(canvas), repeat_overlay(repeat_overlay),
+        texture_format(texture_format),
         use_bloom(use_bloom), use_tilt_shift(use_tilt_shift),
+        use_compute(use_compute), invalidate_targets(invalidate_targets),
+        world_tiles(world_tiles), lod_levels(lod_levels),
+        tile_uploads(tile_uploads), tessellation_level(tessellation_level),
+        topology(topology),
+        tiles_drawn(0), tiles_culled(0),
+        tile_uploads_done(0), vertices(0), tile_renderer(0),
         terrain_renderer(0), bloom_v_renderer(0), bloom_h_renderer(0),
         overlay_renderer(0), tilt_v_renderer(0), tilt_h_renderer(0),
         copy_renderer(0), height_map_renderer(0), normal_map_renderer(0),
-        specular_map_renderer(0),
-        height_normal_chain(0), bloom_chain(0), tilt_chain(0), terrain_chain(0)
+        specular_map_renderer(0)
     {
         init_renderers();
     }
@@ -60,26 +74,61 @@ public:
     {
         /* Create and set up renderers */
         const vec2 map_res(256.0f, 256.0f);
+        const vec2 world_map_res(1024.0f, 1024.0f);
         const vec2 screen_res(canvas.width(), canvas.height());
         const vec2 bloom_res(256.0f, 256.0f);
         const vec2 grass_res(512.0f, 512.0f);
 
-        height_map_renderer = new SimplexNoiseRenderer();
-        height_map_renderer->setup_offscreen(map_res, false);
+        /*
+         * With use_compute the offscreen noise, normal map and blur stages
+         * are compute dispatches. The onscreen stages always use fragment
+         * shaders.
+         */
+        height_map_renderer = new SimplexNoiseRenderer(use_compute);
+        normal_map_renderer = new NormalFromHeightRenderer(use_compute);
 
-        normal_map_renderer = new NormalFromHeightRenderer();
-        normal_map_renderer->setup_offscreen(map_res, false);
+        /*
+         * The maps of a large world don't scroll, so they are only rendered
+         * once, and aren't in the graph.
+         */
+        if (world_tiles) {
+            height_map_renderer->setup_offscreen(world_map_res, false);
+            normal_map_renderer->setup_offscreen(world_map_res, false);
+            normal_map_renderer->input_texture(height_map_renderer->texture());
+        }
+        else {
+            graph.add_target(*height_map_renderer, map_res, false);
+            graph.add_target(*normal_map_renderer, map_res, false);
+        }
 
+        /* The specular map is only rendered once, so it isn't in the graph */
         specular_map_renderer = new LuminanceRenderer();
         specular_map_renderer->setup_offscreen(grass_res, false);
         specular_map_renderer->setup_texture(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
                                              GL_REPEAT, GL_REPEAT);
 
-        terrain_renderer = new TerrainRenderer(repeat_overlay);
+        if (world_tiles) {
+            /* The large world keeps the scale of the single one */
+            float scale = world_tiles * world_tile_size / single_world_size;
+            tile_renderer = new TerrainTileRenderer(repeat_overlay * scale,
+                                                    texture_format, world_tiles,
+                                                    world_tile_size, lod_levels,
+                                                    tile_uploads);
+            terrain_renderer = tile_renderer;
+
+            height_map_renderer->program().start();
+            height_map_renderer->program()["uvScale"] =
+                height_map_renderer->uv_scale() * scale;
+            height_map_renderer->program().stop();
+        }
+        else {
+            terrain_renderer = new TerrainRenderer(repeat_overlay, texture_format,
+                                                   tessellation_level, topology);
+        }
         if (!use_bloom && !use_tilt_shift)
             terrain_renderer->setup_onscreen(canvas);
         else
-            terrain_renderer->setup_offscreen(screen_res, true);
+            graph.add_target(*terrain_renderer, screen_res, true);
         terrain_renderer->setup_texture(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
                                         GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 
@@ -88,16 +137,16 @@ public:
             bloom_h_renderer = new BlurRenderer(2, 4.0,
                                                 BlurRenderer::BlurDirectionHorizontal,
                                                 vec2(1.0, 1.0) / screen_res,
-                                                0.0);
-            bloom_h_renderer->setup_offscreen(bloom_res, false);
+                                                0.0, use_compute);
+            graph.add_target(*bloom_h_renderer, bloom_res, false);
             bloom_h_renderer->setup_texture(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
                                             GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 
             bloom_v_renderer = new BlurRenderer(2, 4.0,
                                                 BlurRenderer::BlurDirectionVertical,
                                                 vec2(1.0, 1.0) / bloom_res,
-                                                0.0);
-            bloom_v_renderer->setup_offscreen(bloom_res, false);
+                                                0.0, use_compute);
+            graph.add_target(*bloom_v_renderer, bloom_res, false);
             bloom_v_renderer->setup_texture(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
                                             GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
             overlay_renderer = new OverlayRenderer(*terrain_renderer, 0.6);
@@ -108,8 +157,8 @@ public:
             tilt_h_renderer = new BlurRenderer(4, 2.7,
                                                BlurRenderer::BlurDirectionHorizontal,
                                                vec2(1.0, 1.0) / screen_res,
-                                               0.5);
-            tilt_h_renderer->setup_offscreen(screen_res, false);
+                                               0.5, use_compute);
+            graph.add_target(*tilt_h_renderer, screen_res, false);
             tilt_h_renderer->setup_texture(GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR,
                                            GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
 
@@ -126,41 +175,42 @@ public:
             copy_renderer->setup_onscreen(canvas);
         }
 
-        /* Height normal chain */
-        height_normal_chain = new RendererChain();
-        height_normal_chain->append(*height_map_renderer);
-        height_normal_chain->append(*normal_map_renderer);
+        /* The height and normal maps used by the terrain */
+        if (world_tiles) {
+            graph.add_pass(*terrain_renderer);
+        }
+        else {
+            graph.add_pass(*height_map_renderer);
+            graph.add_pass(*normal_map_renderer, {height_map_renderer});
+
+            /* The terrain plus any post-processing effects */
+            graph.add_pass(*terrain_renderer, {height_map_renderer, normal_map_renderer});
+        }
 
-        /* Bloom effect chain */
         if (use_bloom) {
-            bloom_chain = new RendererChain();
-            bloom_chain->append(*bloom_h_renderer);
-            bloom_chain->append(*bloom_v_renderer);
-            bloom_chain->append(*overlay_renderer);
+            graph.add_pass(*bloom_h_renderer, {terrain_renderer});
+            graph.add_pass(*bloom_v_renderer, {bloom_h_renderer});
+            graph.add_pass(*overlay_renderer, {bloom_v_renderer}, terrain_renderer);
         }
 
-        /* Tilt-shift effect chain */
         if (use_tilt_shift) {
-            tilt_chain = new RendererChain();
-            tilt_chain->append(*tilt_h_renderer);
-            tilt_chain->append(*tilt_v_renderer);
+            graph.add_pass(*tilt_h_renderer, {terrain_renderer});
+            graph.add_pass(*tilt_v_renderer, {tilt_h_renderer});
         }
 
-        /* Terrain chain */
-        terrain_chain = new RendererChain();
-        terrain_chain->append(*terrain_renderer);
-        if (use_bloom)
-            terrain_chain->append(*bloom_chain);
-        if (use_tilt_shift)
-            terrain_chain->append(*tilt_chain);
-
         /*
          * If are just using bloom, the terrain is rendered to a texture and
          * bloom applied on that texture. We need to "copy" that texture's
          * contents to the screen to make the scene visible.
          */
         if (use_bloom && !use_tilt_shift)
-            terrain_chain->append(*copy_renderer);
+            graph.add_pass(*copy_renderer, {terrain_renderer});
+
+        graph.invalidate(invalidate_targets || Options::invalidate);
+        graph.compile();
+
+        Log::debug("SceneTerrain: %u offscreen targets use %u textures\n",
+                   graph.target_count(), graph.texture_count());
 
         /*
          * Set up renderer textures.
@@ -174,11 +224,6 @@ public:
 
     void release_renderers()
     {
-        delete terrain_chain;
-        delete bloom_chain;
-        delete tilt_chain;
-        delete height_normal_chain;
-
         delete height_map_renderer;
         delete normal_map_renderer;
         delete specular_map_renderer;
@@ -193,10 +238,31 @@ public:
 
     Canvas &canvas;
     LibMatrix::vec2 repeat_overlay;
+    std::string texture_format;
     bool use_bloom;
     bool use_tilt_shift;
+    bool use_compute;
+    bool invalidate_targets;
+    /* The tiles per side of the large world, 0 for the single grid */
+    unsigned int world_tiles;
+    unsigned int lod_levels;
+    unsigned int tile_uploads;
+    /* The tessellation level of the single grid, 0 to draw it untessellated */
+    unsigned int tessellation_level;
+    /* How the single grid is drawn */
+    Mesh::GridTopology topology;
+    /* The size of the single grid, and of a tile of the large world */
+    static constexpr float single_world_size = 6000.0f;
+    static constexpr float world_tile_size = 750.0f;
+
+    /* The totals of the large world since the measurements were reset */
+    uint64_t tiles_drawn;
+    uint64_t tiles_culled;
+    uint64_t tile_uploads_done;
+    uint64_t vertices;
 
     /* Renderers */
+    TerrainTileRenderer *tile_renderer;
     TerrainRenderer *terrain_renderer;
     BlurRenderer *bloom_v_renderer;
     BlurRenderer *bloom_h_renderer;
@@ -209,11 +275,8 @@ public:
     NormalFromHeightRenderer *normal_map_renderer;
     LuminanceRenderer *specular_map_renderer;
 
-    /* Chains */
-    RendererChain *height_normal_chain;
-    RendererChain *bloom_chain;
-    RendererChain *tilt_chain;
-    RendererChain *terrain_chain;
+    /* The passes rendered every frame */
+    RenderGraph graph;
 };
 
 SceneTerrain::SceneTerrain(Canvas &pCanvas) :
@@ -227,6 +290,34 @@ SceneTerrain::SceneTerrain(Canvas &pCanvas) :
     options_["tilt-shift"] = Scene::Option("tilt-shift", "true",
                                            "Use tilt-shift post-processing effect",
                                            "false,true");
+    options_["texture-format"] = Scene::Option("texture-format", "rgba",
+                                               "The format of the textures to use (compressed formats need <texture>.<format>.ktx[2] files)",
+                                               Texture::format_option_values);
+    options_["stage-method"] = Scene::Option("stage-method", "fragment",
+                                             "How the offscreen noise, normal map and blur stages are run",
+                                             "fragment,compute");
+    options_["invalidate"] = Scene::Option("invalidate", "false",
+                                           "Invalidate the offscreen targets after their last use in each frame",
+                                           "false,true");
+    options_["world"] = Scene::Option("world", "single",
+                                      "The terrain to fly over (large: a quadtree of tiles with LOD,"
+                                      " culled on the CPU and streamed as the camera moves)",
+                                      "single,large");
+    options_["world-tiles"] = Scene::Option("world-tiles", "32",
+                                            "The tiles per side of the large world (a power of 2)");
+    options_["lod-levels"] = Scene::Option("lod-levels", "4",
+                                           "The levels of detail of the tiles of the large world,"
+                                           " the first with 64x64 cells");
+    options_["tile-uploads"] = Scene::Option("tile-uploads", "8",
+                                             "The maximum number of tiles streamed per frame in the large world");
+    options_["tessellation-level"] = Scene::Option("tessellation-level", "0",
+                                                   "Tessellate the single grid, with as many times fewer"
+                                                   " cells per side, at this level (0: no tessellation)");
+    options_["topology"] = Scene::Option("topology", "triangles",
+                                         "How the single grid is drawn: as triangles of their own"
+                                         " vertices, or from shared vertices as indexed triangles or"
+                                         " as strips with primitive restart",
+                                         "triangles,indexed,strips");
 }
 
 SceneTerrain::~SceneTerrain()
@@ -249,8 +340,56 @@ SceneTerrain::supported(bool show_errors)
     if (show_errors && !GLExtensions::GenFramebuffers) {
         Log::error("SceneTerrain requires GL framebuffer support\n");
     }
-    
-    return vertex_textures > 0 && GLExtensions::GenFramebuffers;
+
+    bool compute_supported = options_["stage-method"].value != "compute" ||
+                             (GLExtensions::DispatchCompute &&
+                              GLExtensions::BindImageTexture &&
+                              GLExtensions::TexStorage2D);
+
+    if (show_errors && !compute_supported) {
+        Log::error("SceneTerrain compute stages require compute shader and"
+                   " image load/store support (GL 4.3 or GLES 3.1)\n");
+    }
+
+    bool world_supported = true;
+    if (options_["world"].value == "large") {
+        unsigned int tiles = Util::fromString<unsigned int>(options_["world-tiles"].value);
+        unsigned int lod_levels = Util::fromString<unsigned int>(options_["lod-levels"].value);
+
+        world_supported = tiles > 0 && (tiles & (tiles - 1)) == 0 &&
+                          lod_levels > 0 && lod_levels <= 7;
+
+        if (show_errors && !world_supported) {
+            Log::error("SceneTerrain world-tiles must be a power of 2 and"
+                       " lod-levels between 1 and 7\n");
+        }
+    }
+
+    bool tessellation_supported = true;
+    if (Util::fromString<unsigned int>(options_["tessellation-level"].value) > 0) {
+        tessellation_supported = GLExtensions::PatchParameteri &&
+                                 options_["world"].value == "single";
+
+        if (show_errors && !tessellation_supported) {
+            Log::error("SceneTerrain tessellation requires tessellation shader support"
+                       " (GL 4.0, GLES 3.2 or GLES 3.1 with GL_EXT_tessellation_shader)"
+                       " and world=single\n");
+        }
+    }
+
+    bool topology_supported = true;
+    if (options_["topology"].value == "strips") {
+        topology_supported = Mesh::primitive_restart_supported() &&
+                             Util::fromString<unsigned int>(options_["tessellation-level"].value) == 0;
+
+        if (show_errors && !topology_supported) {
+            Log::error("SceneTerrain strips require primitive restart support"
+                       " (GL 4.3, GL_ARB_ES3_compatibility or GLES 3.0) and no tessellation\n");
+        }
+    }
+
+    return vertex_textures > 0 && GLExtensions::GenFramebuffers && compute_supported &&
+           world_supported && tessellation_supported && topology_supported;
 }
 
 bool
@@ -280,9 +419,21 @@ SceneTerrain::setup()
     LibMatrix::vec2 repeat_overlay(repeat, repeat);
     bool use_bloom = options_["bloom"].value == "true";
     bool use_tilt_shift = options_["tilt-shift"].value == "true";
+    unsigned int world_tiles = 0;
+
+    if (options_["world"].value == "large")
+        world_tiles = Util::fromString<unsigned int>(options_["world-tiles"].value);
 
     priv_ = new SceneTerrainPrivate(canvas_, repeat_overlay,
-                                    use_bloom, use_tilt_shift);
+                                    use_bloom, use_tilt_shift,
+                                    options_["texture-format"].value,
+                                    options_["stage-method"].value == "compute",
+                                    options_["invalidate"].value == "true",
+                                    world_tiles,
+                                    Util::fromString<unsigned int>(options_["lod-levels"].value),
+                                    Util::fromString<unsigned int>(options_["tile-uploads"].value),
+                                    Util::fromString<unsigned int>(options_["tessellation-level"].value),
+                                    Mesh::grid_topology_from_str(options_["topology"].value));
 
     /* Set up terrain rendering program */
     LibMatrix::Stack4 model;
@@ -290,6 +441,7 @@ SceneTerrain::setup()
     LibMatrix::mat4 projection = LibMatrix::Mat4::perspective(
             40.0, canvas_.width() / static_cast<float>(canvas_.height()),
             2.0, 4000.0);
+    projection_ = projection;
 
     /* Place camera */
     camera.lookAt(-1200.0f, 800.0f, 1200.0f,
@@ -318,6 +470,14 @@ SceneTerrain::setup()
     /* Create the specular map */
     priv_->specular_map_renderer->render();
 
+    /* Create the maps of the large world, and place its camera */
+    if (priv_->tile_renderer) {
+        priv_->height_map_renderer->render();
+        priv_->normal_map_renderer->render();
+        update_world_camera(0.0f);
+    }
+    reset_measurements();
+
     GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_.fbo());
     glViewport(0, 0, canvas_.width(), canvas_.height());
 
@@ -341,11 +501,16 @@ SceneTerrain::update()
 {
     Scene::update();
 
-    double now = Util::get_timestamp_us() / 1000000.0;
-    float diff = now - startTime_;
+    float diff = animation_time();
     float scale = priv_->terrain_renderer->repeat_overlay().x() /
                   priv_->height_map_renderer->uv_scale().x();
 
+    /* The camera flies over the large world, which doesn't scroll */
+    if (priv_->tile_renderer) {
+        update_world_camera(diff);
+        return;
+    }
+
     /* Update height map */
     priv_->height_map_renderer->program().start();
     priv_->height_map_renderer->program()["uvOffset"] = vec2(diff * 0.05f, 0.0f);
@@ -356,11 +521,91 @@ SceneTerrain::update()
 void
 SceneTerrain::draw()
 {
-    /* Render the height and normal maps used by the terrain */
-    priv_->height_normal_chain->render();
+    /* Render the height and normal maps, the terrain and any effects */
+    priv_->graph.render();
+
+    if (priv_->tile_renderer) {
+        const TerrainTileRenderer::Stats &stats(priv_->tile_renderer->stats());
+        priv_->tiles_drawn += stats.tiles_drawn;
+        priv_->tiles_culled += stats.tiles_culled;
+        priv_->tile_uploads_done += stats.tile_uploads;
+        priv_->vertices += stats.vertices;
+    }
+}
+
+/*
+ * Places the camera of the large world on a circle around its center, a
+ * little above the hills, looking ahead and down.
+ */
+void
+SceneTerrain::update_world_camera(float time)
+{
+    static const float speed = 400.0f;
+    static const float height = 1200.0f;
+    static const float look_ahead = 3000.0f;
+
+    float radius = priv_->tile_renderer->world_size() * 0.3f;
+    float angle = time * speed / radius;
+    vec3 eye(radius * std::cos(angle), radius * std::sin(angle), height);
+    vec3 target(eye.x() - look_ahead * std::sin(angle),
+                eye.y() + look_ahead * std::cos(angle), 0.0f);
+
+    /* The plane of the terrain is the XZ plane, lowered as in setup() */
+    LibMatrix::Stack4 model;
+    LibMatrix::Stack4 camera;
+
+    model.translate(0.0f, -125.0f, 0.0f);
+    model.rotate(-90.0, 1.0f, 0.0f, 0.0f);
+    camera.lookAt(eye.x(), eye.z() - 125.0f, -eye.y(),
+                  target.x(), target.z() - 125.0f, -target.y(),
+                  0.0, 1.0, 0.0);
 
-    /* Render the terrain plus any post-processing effects */
-    priv_->terrain_chain->render();
+    LibMatrix::mat4 view_matrix(camera.getCurrent());
+    LibMatrix::mat4 model_view_matrix(view_matrix * model.getCurrent());
+    LibMatrix::mat4 normal_matrix(model_view_matrix);
+    normal_matrix.inverse().transpose();
+
+    Program &program(priv_->terrain_renderer->program());
+    program.start();
+    program["viewMatrix"] = view_matrix;
+    program["modelViewMatrix"] = model_view_matrix;
+    program["normalMatrix"] = normal_matrix;
+    program.stop();
+
+    priv_->tile_renderer->camera(projection_ * model_view_matrix, eye);
+}
+
+void
+SceneTerrain::reset_measurements()
+{
+    if (!priv_)
+        return;
+
+    priv_->tiles_drawn = 0;
+    priv_->tiles_culled = 0;
+    priv_->tile_uploads_done = 0;
+    priv_->vertices = 0;
+}
+
+std::vector<Scene::Rate>
+SceneTerrain::rates()
+{
+    std::vector<Rate> rates;
+    double elapsed = elapsed_time();
+
+    if (!priv_ || !priv_->tile_renderer || elapsed <= 0.0)
+        return rates;
+
+    rates.push_back(Rate("TilesDrawnPerSecond", "tiles_drawn_per_second",
+                         priv_->tiles_drawn / elapsed));
+    rates.push_back(Rate("TilesCulledPerSecond", "tiles_culled_per_second",
+                         priv_->tiles_culled / elapsed));
+    rates.push_back(Rate("TileUploadsPerSecond", "tile_uploads_per_second",
+                         priv_->tile_uploads_done / elapsed));
+    rates.push_back(Rate("VerticesPerSecond", "vertices_per_second",
+                         priv_->vertices / elapsed));
+
+    return rates;
 }
 
 Scene::ValidationResult
@@ -368,3 +613,16 @@ SceneTerrain::validate()
 {
     return Scene::ValidationUnknown;
 }
+
+std::vector<std::string>
+SceneTerrain::textures()
+{
+    const std::string &format = options_["texture-format"].value;
+    std::vector<std::string> names;
+
+    names.push_back(Texture::format_name("terrain-grasslight-512", format));
+    names.push_back(Texture::format_name("terrain-backgrounddetailed6", format));
+    names.push_back(Texture::format_name("terrain-grasslight-512-nm", format));
+
+    return names;
+}
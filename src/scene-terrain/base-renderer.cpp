@@ -21,19 +21,20 @@
  */
 #include "renderer.h"
 
+#include <algorithm>
+
 BaseRenderer::BaseRenderer() :
     texture_(0), input_texture_(0), fbo_(0), depth_renderbuffer_(0),
     owns_fbo_(false), min_filter_(GL_LINEAR), mag_filter_(GL_LINEAR),
-    wrap_s_(GL_CLAMP_TO_EDGE), wrap_t_(GL_CLAMP_TO_EDGE)
+    wrap_s_(GL_CLAMP_TO_EDGE), wrap_t_(GL_CLAMP_TO_EDGE),
+    immutable_texture_(false), texture_format_(GL_RGBA8),
+    depth_format_(GL_DEPTH_COMPONENT16), target_owner_(0), shared_target_(false)
 {
 }
 
 BaseRenderer::~BaseRenderer()
 {
-    glDeleteTextures(1, &texture_);
-    GLExtensions::DeleteRenderbuffers(1, &depth_renderbuffer_);
-    if (owns_fbo_)
-        GLExtensions::DeleteFramebuffers(1, &fbo_);
+    release_target();
 }
 
 void
@@ -50,6 +51,16 @@ BaseRenderer::setup_offscreen(const LibMatrix::vec2 &size, bool has_depth)
     recreate(nullptr, has_depth);
 }
 
+void
+BaseRenderer::setup_framebuffer(GLuint fbo, const LibMatrix::vec2 &size)
+{
+    release_target();
+
+    size_ = size;
+    fbo_ = fbo;
+    owns_fbo_ = false;
+}
+
 void
 BaseRenderer::setup_texture(GLint min_filter, GLint mag_filter,
                             GLint wrap_s, GLint wrap_t)
@@ -87,22 +98,55 @@ BaseRenderer::update_mipmap()
 }
 
 void
-BaseRenderer::recreate(Canvas* canvas, bool has_depth)
+BaseRenderer::apply_texture_parameters()
 {
     if (texture_) {
-        glDeleteTextures(1, &texture_);
-        texture_ = 0;
+        glBindTexture(GL_TEXTURE_2D, texture_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t_);
+        if (!GLExtensions::GenerateMipmap) {
+            glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP,
+                            (min_filter_ != GL_NEAREST && min_filter_ != GL_LINEAR) ?
+                                GL_TRUE : GL_FALSE);
+        }
     }
-    if (owns_fbo_ && fbo_) {
-        GLExtensions::DeleteRenderbuffers(1, &depth_renderbuffer_);
-        depth_renderbuffer_ = 0;
-        GLExtensions::DeleteFramebuffers(1, &fbo_);
-        fbo_ = 0;
+}
+
+void
+BaseRenderer::release_target()
+{
+    /* A shared target is released by its owner */
+    if (!shared_target_) {
+        if (texture_)
+            glDeleteTextures(1, &texture_);
+        if (depth_renderbuffer_)
+            GLExtensions::DeleteRenderbuffers(1, &depth_renderbuffer_);
+        if (owns_fbo_ && fbo_)
+            GLExtensions::DeleteFramebuffers(1, &fbo_);
     }
 
+    texture_ = 0;
+    depth_renderbuffer_ = 0;
+    fbo_ = 0;
+    shared_target_ = false;
+}
+
+void
+BaseRenderer::recreate(Canvas* canvas, bool has_depth)
+{
+    release_target();
+
     if (canvas) {
         fbo_ = canvas->fbo();
         owns_fbo_ = false;
+    } else if (target_owner_) {
+        texture_ = target_owner_->texture_;
+        fbo_ = target_owner_->fbo_;
+        depth_renderbuffer_ = target_owner_->depth_renderbuffer_;
+        owns_fbo_ = true;
+        shared_target_ = true;
     } else {
         create_texture();
         create_fbo(has_depth);
@@ -115,26 +159,48 @@ BaseRenderer::create_texture()
 {
     glGenTextures(1, &texture_);
     glBindTexture(GL_TEXTURE_2D, texture_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size_.x(), size_.y(), 0,
-            GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    if (immutable_texture_) {
+        /*
+         * Allocate the whole mipmap chain, since the filters, and so
+         * whether mipmaps are used, may be set later.
+         */
+        GLsizei levels = 1;
+        for (unsigned int s = std::max(size_.x(), size_.y()); s > 1; s /= 2)
+            levels++;
+        GLExtensions::TexStorage2D(GL_TEXTURE_2D, levels, texture_format_,
+                                   size_.x(), size_.y());
+    }
+    else {
+        /* GLES2 only takes unsized internal formats */
+        GLint internal_format = GL_RGBA;
+        GLenum format = GL_RGBA;
+        GLenum type = GL_UNSIGNED_BYTE;
+#if GLMARK2_USE_GLESv2
+        bool sized = GLExtensions::version_supported(3, 0);
+#else
+        bool sized = true;
+#endif
+
+        if (texture_format_ == GL_RGBA16F) {
+            internal_format = sized ? GL_RGBA16F : GL_RGBA;
+            type = sized ? GL_HALF_FLOAT : GL_HALF_FLOAT_OES;
+        }
+        else if (texture_format_ == GL_R11F_G11F_B10F) {
+            internal_format = GL_R11F_G11F_B10F;
+            format = GL_RGB;
+            type = GL_UNSIGNED_INT_10F_11F_11F_REV;
+        }
+
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, size_.x(), size_.y(), 0,
+                format, type, 0);
+    }
     update_texture_parameters();
 }
 
 void
 BaseRenderer::update_texture_parameters()
 {
-    if (texture_) {
-        glBindTexture(GL_TEXTURE_2D, texture_);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter_);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter_);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_s_);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_t_);
-        if (!GLExtensions::GenerateMipmap) {
-            glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP,
-                            (min_filter_ != GL_NEAREST && min_filter_ != GL_LINEAR) ?
-                                GL_TRUE : GL_FALSE);
-        }
-    }
+    apply_texture_parameters();
     update_mipmap();
 }
 
@@ -145,7 +211,7 @@ BaseRenderer::create_fbo(bool has_depth)
         /* Create a renderbuffer for depth storage */
         GLExtensions::GenRenderbuffers(1, &depth_renderbuffer_);
         GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_);
-        GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
+        GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, depth_format_,
                 size_.x(), size_.y());
     }
 
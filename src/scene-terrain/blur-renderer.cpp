@@ -32,16 +32,18 @@ create_blur_shaders(ShaderSource& vtx_source, ShaderSource& frg_source,
                     float tilt_shift);
 
 BlurRenderer::BlurRenderer(int radius, float sigma,
-                           BlurDirection dir, const LibMatrix::vec2 &step, float tilt_shift) :
-        TextureRenderer(*blur_program(true, radius, sigma, dir, step, tilt_shift))
+                           BlurDirection dir, const LibMatrix::vec2 &step, float tilt_shift,
+                           bool compute) :
+        TextureRenderer(*blur_program(true, radius, sigma, dir, step, tilt_shift, compute),
+                        compute)
 {
-    blur_program_ = blur_program(false, radius, sigma, dir, step, tilt_shift);
+    blur_program_ = blur_program(false, radius, sigma, dir, step, tilt_shift, compute);
 }
 
 Program *
 BlurRenderer::blur_program(bool create_new, int radius, float sigma,
                            BlurDirection dir, const LibMatrix::vec2 &step,
-                           float tilt_shift)
+                           float tilt_shift, bool compute)
 {
     static Program *blur_program(0);
     if (create_new)
@@ -51,6 +53,8 @@ BlurRenderer::blur_program(bool create_new, int radius, float sigma,
         blur_program = new Program();
         ShaderSource blur_vtx_shader;
         ShaderSource blur_frg_shader;
+        if (compute)
+            TextureRenderer::compute_shader_header(blur_frg_shader);
         create_blur_shaders(blur_vtx_shader, blur_frg_shader, radius,
                             sigma, dir, tilt_shift);
 
@@ -59,9 +63,16 @@ BlurRenderer::blur_program(bool create_new, int radius, float sigma,
         if (dir == BlurDirectionVertical || dir == BlurDirectionBoth)
             blur_frg_shader.add_const("TextureStepY", step.y());
 
-        Scene::load_shaders_from_strings(*blur_program,
-                blur_vtx_shader.str(),
-                blur_frg_shader.str());
+        if (compute) {
+            TextureRenderer::compute_shader_footer(blur_frg_shader);
+            Scene::load_compute_shader_from_string(*blur_program,
+                    blur_frg_shader.str());
+        }
+        else {
+            Scene::load_shaders_from_strings(*blur_program,
+                    blur_vtx_shader.str(),
+                    blur_frg_shader.str());
+        }
         blur_program->start();
         (*blur_program)["Texture0"] = 0;
         (*blur_program)["uvOffset"] = LibMatrix::vec2(0.0f, 0.0f);
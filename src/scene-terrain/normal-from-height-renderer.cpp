@@ -24,10 +24,10 @@
 #include "renderer.h"
 #include "shader-source.h"
 
-NormalFromHeightRenderer::NormalFromHeightRenderer() :
-    TextureRenderer(*normal_from_height_program(true))
+NormalFromHeightRenderer::NormalFromHeightRenderer(bool compute) :
+    TextureRenderer(*normal_from_height_program(true, compute), compute)
 {
-    normal_from_height_program_ = normal_from_height_program(false);
+    normal_from_height_program_ = normal_from_height_program(false, compute);
 }
 
 void
@@ -52,7 +52,7 @@ NormalFromHeightRenderer::setup_offscreen(const LibMatrix::vec2 &size, bool has_
 }
 
 Program *
-NormalFromHeightRenderer::normal_from_height_program(bool create_new)
+NormalFromHeightRenderer::normal_from_height_program(bool create_new, bool compute)
 {
     static Program *normal_from_height_program(0);
     if (create_new)
@@ -60,11 +60,23 @@ NormalFromHeightRenderer::normal_from_height_program(bool create_new)
 
     if (!normal_from_height_program) {
         normal_from_height_program = new Program();
-        ShaderSource vtx_shader(Options::data_path + "/shaders/terrain-texture.vert");
-        ShaderSource frg_shader(Options::data_path + "/shaders/terrain-normalmap.frag");
 
-        Scene::load_shaders_from_strings(*normal_from_height_program,
-                                         vtx_shader.str(), frg_shader.str());
+        if (compute) {
+            ShaderSource cmp_shader;
+            TextureRenderer::compute_shader_header(cmp_shader);
+            cmp_shader.append_file(Options::data_path + "/shaders/terrain-normalmap.frag");
+            TextureRenderer::compute_shader_footer(cmp_shader);
+
+            Scene::load_compute_shader_from_string(*normal_from_height_program,
+                                                   cmp_shader.str());
+        }
+        else {
+            ShaderSource vtx_shader(Options::data_path + "/shaders/terrain-texture.vert");
+            ShaderSource frg_shader(Options::data_path + "/shaders/terrain-normalmap.frag");
+
+            Scene::load_shaders_from_strings(*normal_from_height_program,
+                                             vtx_shader.str(), frg_shader.str());
+        }
 
         normal_from_height_program->start();
         (*normal_from_height_program)["heightMap"] = 0;
@@ -0,0 +1,301 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "renderer.h"
+#include "debug-markers.h"
+#include "util.h"
+
+#include <algorithm>
+
+namespace
+{
+
+struct FirstUseCompare
+{
+    FirstUseCompare(const std::vector<int> &first_use) : first_use(first_use) {}
+
+    bool operator()(int a, int b) const { return first_use[a] < first_use[b]; }
+
+    const std::vector<int> &first_use;
+};
+
+}
+
+void
+RenderGraph::add_target(BaseRenderer &renderer, const LibMatrix::vec2 &size,
+                        bool has_depth)
+{
+    Target target;
+
+    target.renderer = &renderer;
+    target.size = size;
+    target.has_depth = has_depth;
+    target.kept = false;
+    target.first_use = -1;
+    target.last_use = -1;
+    target.last_write = -1;
+    target.owner = -1;
+    target.shared = false;
+
+    targets_.push_back(target);
+    compiled_ = false;
+}
+
+void
+RenderGraph::add_pass(IRenderer &renderer, const std::vector<IRenderer *> &inputs,
+                      IRenderer *target)
+{
+    Pass pass;
+
+    pass.renderer = &renderer;
+    for (std::vector<IRenderer *>::const_iterator iter = inputs.begin();
+         iter != inputs.end();
+         iter++)
+    {
+        pass.inputs.push_back(find_target(*iter));
+    }
+    pass.target = find_target(target ? target : &renderer);
+
+    passes_.push_back(pass);
+    compiled_ = false;
+}
+
+void
+RenderGraph::keep(IRenderer &renderer)
+{
+    int t = find_target(&renderer);
+
+    if (t >= 0)
+        targets_[t].kept = true;
+}
+
+void
+RenderGraph::compile()
+{
+    int npasses = passes_.size();
+
+    /* Work out the span of passes in which each target is used */
+    std::vector<int> first_write(targets_.size(), -1);
+
+    for (int p = 0; p < npasses; p++) {
+        Pass &pass(passes_[p]);
+
+        for (std::vector<int>::iterator iter = pass.inputs.begin();
+             iter != pass.inputs.end();
+             iter++)
+        {
+            if (*iter < 0)
+                continue;
+            Target &t(targets_[*iter]);
+            if (t.first_use < 0)
+                t.first_use = p;
+            t.last_use = p;
+        }
+
+        if (pass.target >= 0) {
+            Target &t(targets_[pass.target]);
+            if (t.first_use < 0)
+                t.first_use = p;
+            if (first_write[pass.target] < 0)
+                first_write[pass.target] = p;
+            t.last_use = p;
+            t.last_write = p;
+        }
+    }
+
+    std::vector<int> first_use(targets_.size());
+    for (size_t i = 0; i < targets_.size(); i++) {
+        Target &t(targets_[i]);
+
+        /*
+         * A target read before it is written in a frame needs the contents
+         * of the previous frame, so it must live for the whole frame, like
+         * the targets that are kept.
+         */
+        if (t.first_use >= 0 && t.first_use != first_write[i]) {
+            t.first_use = 0;
+            t.kept = true;
+        }
+        if (t.kept)
+            t.last_use = npasses;
+
+        /* Unused targets don't share, but still get set up */
+        first_use[i] = t.first_use < 0 ? npasses : t.first_use;
+        t.owner = -1;
+        t.shared = false;
+    }
+
+    /* Assign targets to textures, reusing the ones that are no longer used */
+    std::vector<int> order(targets_.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), FirstUseCompare(first_use));
+
+    std::vector<int> owners;
+    std::vector<int> busy_until;
+
+    for (std::vector<int>::iterator iter = order.begin(); iter != order.end(); iter++) {
+        Target &t(targets_[*iter]);
+
+        for (size_t j = 0; t.first_use >= 0 && j < owners.size(); j++) {
+            Target &o(targets_[owners[j]]);
+
+            if (busy_until[j] < t.first_use &&
+                o.size.x() == t.size.x() && o.size.y() == t.size.y() &&
+                o.has_depth == t.has_depth &&
+                o.renderer->immutable_texture() == t.renderer->immutable_texture() &&
+                o.renderer->texture_format() == t.renderer->texture_format() &&
+                (!t.has_depth || o.renderer->depth_format() == t.renderer->depth_format()))
+            {
+                t.owner = owners[j];
+                busy_until[j] = t.last_use;
+                o.shared = t.shared = true;
+                break;
+            }
+        }
+
+        if (t.owner < 0) {
+            t.owner = *iter;
+            owners.push_back(*iter);
+            busy_until.push_back(t.first_use < 0 ? npasses : t.last_use);
+        }
+    }
+
+    /* Set up the owners first, so that the other targets can use their objects */
+    for (size_t i = 0; i < targets_.size(); i++) {
+        Target &t(targets_[i]);
+        if (t.owner == static_cast<int>(i))
+            t.renderer->setup_offscreen(t.size, t.has_depth);
+    }
+
+    for (size_t i = 0; i < targets_.size(); i++) {
+        Target &t(targets_[i]);
+        if (t.owner != static_cast<int>(i)) {
+            t.renderer->share_target(*targets_[t.owner].renderer);
+            t.renderer->setup_offscreen(t.size, t.has_depth);
+        }
+    }
+
+    /* Connect the passes to their inputs */
+    for (std::vector<Pass>::iterator iter = passes_.begin();
+         iter != passes_.end();
+         iter++)
+    {
+        if (!iter->inputs.empty() && iter->inputs[0] >= 0)
+            iter->renderer->input_texture(targets_[iter->inputs[0]].renderer->texture());
+        iter->invalidations.clear();
+    }
+
+    /*
+     * Invalidate the depth buffers after the last pass that writes them and
+     * the color buffers after the last pass that uses them.
+     */
+    if (invalidate_ && GLExtensions::InvalidateFramebuffer) {
+        for (std::vector<Target>::iterator iter = targets_.begin();
+             iter != targets_.end();
+             iter++)
+        {
+            if (iter->kept)
+                continue;
+
+            GLuint fbo = iter->renderer->fbo();
+
+            if (iter->has_depth && iter->last_write >= 0 && iter->last_write < npasses &&
+                iter->last_write < iter->last_use)
+            {
+                passes_[iter->last_write].invalidations.push_back(
+                    std::make_pair(fbo, static_cast<GLenum>(GL_DEPTH_ATTACHMENT)));
+            }
+
+            if (iter->last_use >= 0 && iter->last_use < npasses) {
+                passes_[iter->last_use].invalidations.push_back(
+                    std::make_pair(fbo, static_cast<GLenum>(GL_COLOR_ATTACHMENT0)));
+                if (iter->has_depth && iter->last_write == iter->last_use) {
+                    passes_[iter->last_use].invalidations.push_back(
+                        std::make_pair(fbo, static_cast<GLenum>(GL_DEPTH_ATTACHMENT)));
+                }
+            }
+        }
+    }
+
+    compiled_ = true;
+}
+
+void
+RenderGraph::render()
+{
+    if (!compiled_)
+        compile();
+
+    for (size_t p = 0; p < passes_.size(); p++) {
+        Pass &pass(passes_[p]);
+
+        /*
+         * Targets sharing a texture may use different texture parameters,
+         * so set them when a target starts being used.
+         */
+        if (pass.target >= 0) {
+            Target &t(targets_[pass.target]);
+            if (t.shared && t.first_use == static_cast<int>(p))
+                t.renderer->apply_texture_parameters();
+        }
+
+        {
+            DebugMarkers::Group group(DebugMarkers::active() ?
+                                      "pass " + Util::toString(p) : std::string());
+            pass.renderer->render();
+        }
+
+        if (!pass.invalidations.empty()) {
+            for (std::vector<std::pair<GLuint, GLenum> >::iterator iter = pass.invalidations.begin();
+                 iter != pass.invalidations.end();
+                 iter++)
+            {
+                GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, iter->first);
+                GLExtensions::InvalidateFramebuffer(GL_FRAMEBUFFER, 1, &iter->second);
+            }
+
+            /* Restore the target of the pass */
+            pass.renderer->make_current();
+        }
+    }
+}
+
+unsigned int
+RenderGraph::texture_count()
+{
+    unsigned int count = 0;
+
+    for (size_t i = 0; i < targets_.size(); i++) {
+        if (targets_[i].owner == static_cast<int>(i))
+            count++;
+    }
+
+    return count;
+}
+
+int
+RenderGraph::find_target(IRenderer *renderer)
+{
+    for (size_t i = 0; i < targets_.size(); i++) {
+        if (targets_[i].renderer == renderer)
+            return i;
+    }
+
+    return -1;
+}
@@ -20,6 +20,9 @@
  *  Alexandros Frantzis
  */
 #include <stdint.h>
+#include <map>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "canvas.h"
@@ -28,6 +31,8 @@
 #include "program.h"
 #include "gl-headers.h"
 
+class ShaderSource;
+
 /** 
  * Renderer interface.
  */
@@ -73,38 +78,6 @@ protected:
     virtual ~IRenderer() {}
 };
 
-/** 
- * A chain of renderers, which implements IRenderer
- */
-class RendererChain : public IRenderer
-{
-public:
-    RendererChain() {}
-    virtual ~RendererChain() {}
-
-    /* IRenderer methods */
-    void setup_onscreen(Canvas& canvas);
-    void setup_offscreen(const LibMatrix::vec2 &size, bool has_depth);
-    void setup_texture(GLint min_filter, GLint mag_filter,
-                       GLint wrap_s, GLint wrap_t);
-    void input_texture(GLuint t);
-    GLuint texture();
-    LibMatrix::vec2 size();
-    void make_current();
-    void update_mipmap();
-    void render();
-
-    /** 
-     * Appends a renderer to the chain.
-     * 
-     * @param renderer the renderer to append
-     */
-    void append(IRenderer &renderer);
-
-private:
-    std::vector<IRenderer *> renderers_;
-};
-
 /** 
  * A base implementation of the IRenderer interface.
  */
@@ -126,8 +99,42 @@ public:
     virtual void update_mipmap();
     virtual void render() = 0;
 
+    /**
+     * Sets up the renderer to render to a framebuffer that it doesn't own,
+     * like setup_onscreen() does with the FBO of the canvas.
+     */
+    void setup_framebuffer(GLuint fbo, const LibMatrix::vec2 &size);
+    /**
+     * Makes the next setup_offscreen() use the target (texture, FBO and
+     * depth buffer) of owner, instead of creating a new one.
+     */
+    void share_target(BaseRenderer &owner) { target_owner_ = &owner; }
+    /**
+     * Applies the texture parameters of this renderer to its target
+     * texture, which matters if the texture is shared.
+     */
+    void apply_texture_parameters();
+    /**
+     * Whether the target texture has immutable storage.
+     */
+    bool immutable_texture() { return immutable_texture_; }
+    /**
+     * Sets the sized internal formats of the target texture and depth
+     * buffer created by the next setup_offscreen() (default: GL_RGBA8 and
+     * GL_DEPTH_COMPONENT16).
+     */
+    void texture_format(GLenum format) { texture_format_ = format; }
+    void depth_format(GLenum format) { depth_format_ = format; }
+    GLenum texture_format() { return texture_format_; }
+    GLenum depth_format() { return depth_format_; }
+    /**
+     * Gets the FBO of the renderer's target.
+     */
+    GLuint fbo() { return fbo_; }
+
 protected:
     void recreate(Canvas* canvas, bool has_depth);
+    void release_target();
     void create_texture();
     void update_texture_parameters();
     void create_fbo(bool has_depth);
@@ -142,16 +149,119 @@ protected:
     GLint mag_filter_;
     GLint wrap_s_;
     GLint wrap_t_;
+    /* Whether the texture has immutable storage, as needed for image writes */
+    bool immutable_texture_;
+    GLenum texture_format_;
+    GLenum depth_format_;
+    BaseRenderer *target_owner_;
+    /* Whether the target belongs to target_owner_ */
+    bool shared_target_;
+};
+
+/**
+ * A graph of render passes over offscreen render targets.
+ *
+ * The graph works out, for each frame, the span of passes in which each
+ * target is used, and lets targets with matching size and storage whose
+ * spans don't overlap share the same texture and FBO. It can also
+ * invalidate the attachments of targets after their last use, so that
+ * tiled GPUs don't write them back to memory.
+ */
+class RenderGraph
+{
+public:
+    RenderGraph() : invalidate_(false), compiled_(false) {}
+
+    /**
+     * Adds an offscreen target, backing renderer, to be set up by compile().
+     * This replaces renderer.setup_offscreen().
+     */
+    void add_target(BaseRenderer &renderer, const LibMatrix::vec2 &size,
+                    bool has_depth);
+    /**
+     * Adds a pass rendering with renderer. Passes run in the order added.
+     *
+     * @param renderer the renderer of the pass
+     * @param inputs the renderers whose targets the pass reads; the first
+     *        one's texture becomes the renderer's input texture
+     * @param target the renderer whose target the pass writes, if it doesn't
+     *        write its own (e.g. an overlay)
+     */
+    void add_pass(IRenderer &renderer,
+                  const std::vector<IRenderer *> &inputs = std::vector<IRenderer *>(),
+                  IRenderer *target = 0);
+    /**
+     * Keeps the contents of the target of renderer after the last pass,
+     * so they can be used outside the graph.
+     */
+    void keep(IRenderer &renderer);
+    /**
+     * Whether to invalidate the attachments of targets that are no longer used.
+     */
+    void invalidate(bool enable) { invalidate_ = enable; }
+
+    /**
+     * Assigns the targets to shared textures and FBOs, and sets up the
+     * renderers and their input textures.
+     */
+    void compile();
+    /**
+     * Renders all the passes.
+     */
+    void render();
+
+    /**
+     * Gets the number of targets and of the textures that back them.
+     */
+    unsigned int target_count() { return targets_.size(); }
+    unsigned int texture_count();
+
+private:
+    struct Target {
+        BaseRenderer *renderer;
+        LibMatrix::vec2 size;
+        bool has_depth;
+        bool kept;
+        /* The first and last passes that use the target */
+        int first_use;
+        int last_use;
+        /* The last pass that writes the target */
+        int last_write;
+        /* The target whose texture and FBO are used */
+        int owner;
+        /* Whether other targets use the same texture and FBO */
+        bool shared;
+    };
+
+    struct Pass {
+        IRenderer *renderer;
+        std::vector<int> inputs;
+        int target;
+        /* The FBO attachments to invalidate after the pass */
+        std::vector<std::pair<GLuint, GLenum> > invalidations;
+    };
+
+    int find_target(IRenderer *renderer);
+
+    std::vector<Target> targets_;
+    std::vector<Pass> passes_;
+    bool invalidate_;
+    bool compiled_;
 };
 
 /** 
  * A renderer that renders its input texture to its target,
  * according to the supplied GL Program.
+ *
+ * If compute is true the program is a compute program, created from a
+ * fragment shader with compute_shader_header() and compute_shader_footer(),
+ * that writes the target texture as an image. Only offscreen targets
+ * can be used in that case.
  */
 class TextureRenderer : public BaseRenderer
 {
 public:
-    TextureRenderer(Program &program);
+    TextureRenderer(Program &program, bool compute = false);
     virtual ~TextureRenderer() { }
 
     /* IRenderer/BaseRenderer methods */
@@ -162,11 +272,22 @@ public:
      */
     Program &program() { return program_; }
 
+    /**
+     * Starts the source of a compute shader that runs a terrain texture
+     * fragment shader, which should be appended to it next.
+     */
+    static void compute_shader_header(ShaderSource &source);
+    /**
+     * Completes a compute shader started with compute_shader_header().
+     */
+    static void compute_shader_footer(ShaderSource &source);
+
 private:
     void create_mesh();
 
     Mesh mesh_;
     Program &program_;
+    bool compute_;
 };
 
 /** 
@@ -191,12 +312,12 @@ private:
 class SimplexNoiseRenderer : public TextureRenderer
 {
 public:
-    SimplexNoiseRenderer();
+    SimplexNoiseRenderer(bool compute = false);
     virtual ~SimplexNoiseRenderer() { delete noise_program_; }
 
     LibMatrix::vec2 uv_scale() { return uv_scale_; }
 private:
-    static Program *noise_program(bool create_new);
+    static Program *noise_program(bool create_new, bool compute);
     static LibMatrix::vec2 uv_scale_;
 
     Program *noise_program_;
@@ -209,14 +330,14 @@ private:
 class NormalFromHeightRenderer : public TextureRenderer
 {
 public:
-    NormalFromHeightRenderer();
+    NormalFromHeightRenderer(bool compute = false);
     virtual ~NormalFromHeightRenderer() { delete normal_from_height_program_; }
 
     virtual void setup_onscreen(Canvas& canvas);
     virtual void setup_offscreen(const LibMatrix::vec2 &size, bool has_depth);
 
 private:
-    static Program *normal_from_height_program(bool create_new);
+    static Program *normal_from_height_program(bool create_new, bool compute);
 
     Program *normal_from_height_program_;
 };
@@ -250,13 +371,14 @@ public:
     };
 
     BlurRenderer(int radius, float sigma, BlurDirection dir,
-                 const LibMatrix::vec2 &step, float tilt_shift);
+                 const LibMatrix::vec2 &step, float tilt_shift,
+                 bool compute = false);
     virtual ~BlurRenderer() { delete blur_program_; }
 
 private:
     static Program *blur_program(bool create_new, int radius, float sigma,
                                  BlurDirection dir, const LibMatrix::vec2 &step,
-                                 float tilt_shift);
+                                 float tilt_shift, bool compute);
 
     Program *blur_program_;
 };
@@ -301,7 +423,17 @@ private:
 class TerrainRenderer : public BaseRenderer
 {
 public:
-    TerrainRenderer(const LibMatrix::vec2 &repeat_overlay);
+    /**
+     * Creates the renderer. With a tessellation level, the grid has as many
+     * times fewer cells per side, and each of its triangles is a patch
+     * tessellated at that level, which restores the detail of the grid.
+     * The grid is drawn with the topology, which can't be strips when
+     * tessellated.
+     */
+    TerrainRenderer(const LibMatrix::vec2 &repeat_overlay,
+                    const std::string &texture_format,
+                    unsigned int tessellation_level = 0,
+                    Mesh::GridTopology topology = Mesh::GridTriangles);
     virtual ~TerrainRenderer();
 
     /* IRenderable Methods */
@@ -329,11 +461,26 @@ public:
     GLuint diffuse1_texture() { return diffuse1_tex_; }
     LibMatrix::vec2 repeat_overlay() { return repeat_overlay_; }
 
+    /* The height of the terrain where the height map is 1 */
+    static const float displacement_scale;
+
+protected:
+    /**
+     * Creates the renderer, without its grid mesh for a large terrain whose
+     * subclass draws its own geometry with the terrain program.
+     */
+    TerrainRenderer(const LibMatrix::vec2 &repeat_overlay,
+                    const std::string &texture_format, bool large,
+                    unsigned int tessellation_level = 0,
+                    Mesh::GridTopology topology = Mesh::GridTriangles);
+
+    void bind_textures();
+
 private:
     void create_mesh();
-    void init_textures();
-    void init_program();
-    void bind_textures();
+    void init_textures(const std::string &texture_format);
+    void init_program(bool large);
+    bool init_tessellation_program();
     void deinit_textures();
 
     LibMatrix::vec3 color_to_vec3(uint32_t c)
@@ -353,4 +500,99 @@ private:
     GLuint diffuse2_tex_;
     GLuint detail_tex_;
     LibMatrix::vec2 repeat_overlay_;
+    unsigned int tessellation_level_;
+    Mesh::GridTopology topology_;
+};
+
+/**
+ * Renders a large terrain as a quadtree of tiles.
+ *
+ * Each frame, the quadtree is culled against the view frustum on the CPU
+ * and the visible tiles get a level of detail from their distance to the
+ * camera. The geometry of a tile at its level of detail is streamed to a
+ * buffer the first time it is needed, with a limit on the uploads per
+ * frame. Until then, the tile is drawn with the geometry it already has,
+ * if any.
+ */
+class TerrainTileRenderer : public TerrainRenderer
+{
+public:
+    /**
+     * The counts of a frame.
+     */
+    struct Stats {
+        Stats() : tiles_drawn(0), tiles_culled(0), tile_uploads(0), vertices(0) {}
+        unsigned int tiles_drawn;
+        /* The tiles skipped by the culling of the quadtree nodes */
+        unsigned int tiles_culled;
+        unsigned int tile_uploads;
+        unsigned int vertices;
+    };
+
+    /**
+     * @param tiles the number of tiles per side of the terrain, a power of 2
+     * @param tile_size the size of a tile in the plane of the terrain
+     * @param lod_levels the number of levels of detail, the first one with
+     *        64x64 cells per tile and each next one with half as many per side
+     * @param max_uploads the maximum number of tiles uploaded per frame
+     */
+    TerrainTileRenderer(const LibMatrix::vec2 &repeat_overlay,
+                        const std::string &texture_format,
+                        unsigned int tiles, float tile_size,
+                        unsigned int lod_levels, unsigned int max_uploads);
+    virtual ~TerrainTileRenderer();
+
+    /* IRenderable Methods */
+    virtual void render();
+
+    /**
+     * Sets the camera of the next frames.
+     *
+     * @param model_view_projection the transformation from the plane of
+     *        the terrain to clip space
+     * @param eye the position of the camera, in the plane of the terrain
+     */
+    void camera(const LibMatrix::mat4 &model_view_projection,
+                const LibMatrix::vec3 &eye);
+    /**
+     * Gets the size of the terrain, per side.
+     */
+    float world_size() { return tiles_ * tile_size_; }
+    /**
+     * Gets the counts of the last frame.
+     */
+    const Stats &stats() { return stats_; }
+
+private:
+    struct Tile {
+        Tile() : lod(-1), buffer(0), last_used(0) {}
+        /* The level of detail of the geometry in the buffer, -1 if none */
+        int lod;
+        GLuint buffer;
+        uint64_t last_used;
+    };
+
+    void create_index_buffers();
+    void visit(unsigned int x, unsigned int y, unsigned int size);
+    bool visible(unsigned int x, unsigned int y, unsigned int size);
+    int lod(unsigned int x, unsigned int y);
+    void upload(Tile &tile, unsigned int x, unsigned int y, int lod);
+    void evict();
+    void draw(const Tile &tile);
+
+    unsigned int tiles_;
+    float tile_size_;
+    unsigned int lod_levels_;
+    unsigned int max_uploads_;
+    LibMatrix::vec4 planes_[6];
+    LibMatrix::vec3 eye_;
+    uint64_t frame_;
+    /* The tiles with geometry, by position */
+    std::map<std::pair<unsigned int, unsigned int>, Tile> resident_;
+    /* The buffers of evicted tiles, for reuse */
+    std::vector<GLuint> free_buffers_;
+    /* The index buffer and index count of each level of detail */
+    std::vector<GLuint> index_buffers_;
+    std::vector<GLsizei> index_counts_;
+    Stats stats_;
 };
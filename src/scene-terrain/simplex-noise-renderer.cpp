@@ -26,14 +26,14 @@
 
 LibMatrix::vec2 SimplexNoiseRenderer::uv_scale_(1.5f, 1.5);
 
-SimplexNoiseRenderer::SimplexNoiseRenderer() :
-    TextureRenderer(*noise_program(true))
+SimplexNoiseRenderer::SimplexNoiseRenderer(bool compute) :
+    TextureRenderer(*noise_program(true, compute), compute)
 {
-    noise_program_ = noise_program(false);
+    noise_program_ = noise_program(false, compute);
 }
 
 Program *
-SimplexNoiseRenderer::noise_program(bool create_new)
+SimplexNoiseRenderer::noise_program(bool create_new, bool compute)
 {
     static Program *noise_program(0);
     if (create_new)
@@ -41,10 +41,21 @@ SimplexNoiseRenderer::noise_program(bool create_new)
 
     if (!noise_program) {
         noise_program = new Program();
-        ShaderSource vtx_shader(Options::data_path + "/shaders/terrain-texture.vert");
-        ShaderSource frg_shader(Options::data_path + "/shaders/terrain-noise.frag");
 
-        Scene::load_shaders_from_strings(*noise_program, vtx_shader.str(), frg_shader.str());
+        if (compute) {
+            ShaderSource cmp_shader;
+            TextureRenderer::compute_shader_header(cmp_shader);
+            cmp_shader.append_file(Options::data_path + "/shaders/terrain-noise.frag");
+            TextureRenderer::compute_shader_footer(cmp_shader);
+
+            Scene::load_compute_shader_from_string(*noise_program, cmp_shader.str());
+        }
+        else {
+            ShaderSource vtx_shader(Options::data_path + "/shaders/terrain-texture.vert");
+            ShaderSource frg_shader(Options::data_path + "/shaders/terrain-noise.frag");
+
+            Scene::load_shaders_from_strings(*noise_program, vtx_shader.str(), frg_shader.str());
+        }
 
         noise_program->start();
         (*noise_program)["time"] = 1.0f;
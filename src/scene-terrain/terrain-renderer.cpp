@@ -24,14 +24,38 @@
 #include "renderer.h"
 #include "texture.h"
 #include "shader-source.h"
+#include "log.h"
+#include <algorithm>
 
-TerrainRenderer::TerrainRenderer(const LibMatrix::vec2 &repeat_overlay) :
+const float TerrainRenderer::displacement_scale = 375.0f;
+
+TerrainRenderer::TerrainRenderer(const LibMatrix::vec2 &repeat_overlay,
+                                 const std::string &texture_format,
+                                 unsigned int tessellation_level,
+                                 Mesh::GridTopology topology) :
+    TerrainRenderer(repeat_overlay, texture_format, false, tessellation_level, topology)
+{
+}
+
+TerrainRenderer::TerrainRenderer(const LibMatrix::vec2 &repeat_overlay,
+                                 const std::string &texture_format,
+                                 bool large, unsigned int tessellation_level,
+                                 Mesh::GridTopology topology) :
     BaseRenderer(), height_map_tex_(0), normal_map_tex_(0),
-    specular_map_tex_(0), repeat_overlay_(repeat_overlay)
+    specular_map_tex_(0), repeat_overlay_(repeat_overlay),
+    tessellation_level_(tessellation_level), topology_(topology)
 {
-    create_mesh();
-    init_textures();
-    init_program();
+    if (tessellation_level_ > 0) {
+        GLint max_level = 64;
+        glGetIntegerv(GL_MAX_TESS_GEN_LEVEL, &max_level);
+        tessellation_level_ = std::min(tessellation_level_,
+                                       static_cast<unsigned int>(max_level));
+    }
+
+    if (!large)
+        create_mesh();
+    init_textures(texture_format);
+    init_program(large);
 }
 
 TerrainRenderer::~TerrainRenderer()
@@ -49,6 +73,8 @@ TerrainRenderer::render()
     program_.start();
 
     bind_textures();
+    if (tessellation_level_ > 0)
+        GLExtensions::PatchParameteri(GL_PATCH_VERTICES, 3);
     mesh_.render_vbo();
 
     program_.stop();
@@ -56,16 +82,31 @@ TerrainRenderer::render()
     update_mipmap();
 }
 
+/*
+ * Loads a texture in the requested format. The renderer can't fail, so fall
+ * back to the original texture if the requested format is not available.
+ */
+static void
+load_texture(const std::string &name, const std::string &format, GLuint *tex)
+{
+    if (Texture::load(Texture::format_name(name, format), tex,
+                      GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 0))
+    {
+        return;
+    }
+
+    Log::error("Cannot load texture %s in format %s, using the original\n",
+               name.c_str(), format.c_str());
+    Texture::load(name, tex, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 0);
+}
+
 void
-TerrainRenderer::init_textures()
+TerrainRenderer::init_textures(const std::string &texture_format)
 {
     /* Create textures */
-    Texture::load("terrain-grasslight-512", &diffuse1_tex_,
-            GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 0);
-    Texture::load("terrain-backgrounddetailed6", &diffuse2_tex_,
-            GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 0);
-    Texture::load("terrain-grasslight-512-nm", &detail_tex_,
-            GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 0);
+    load_texture("terrain-grasslight-512", texture_format, &diffuse1_tex_);
+    load_texture("terrain-backgrounddetailed6", texture_format, &diffuse2_tex_);
+    load_texture("terrain-grasslight-512-nm", texture_format, &detail_tex_);
 
     /* Set REPEAT wrap mode */
     glBindTexture(GL_TEXTURE_2D, diffuse1_tex_);
@@ -83,13 +124,22 @@ TerrainRenderer::init_textures()
 
 
 void
-TerrainRenderer::init_program()
+TerrainRenderer::init_program(bool large)
 {
     ShaderSource vtx_shader(Options::data_path + "/shaders/terrain.vert");
     ShaderSource frg_shader(Options::data_path + "/shaders/terrain.frag");
 
-    if (!Scene::load_shaders_from_strings(program_, vtx_shader.str(), frg_shader.str()))
+    /* Medium precision can't address the texels of a large overlay */
+    if (large)
+        frg_shader.precision(std::string(",high,,"));
+
+    if (tessellation_level_ > 0) {
+        if (!init_tessellation_program())
+            return;
+    }
+    else if (!Scene::load_shaders_from_strings(program_, vtx_shader.str(), frg_shader.str())) {
         return;
+    }
 
     program_.start();
     /* Fog */
@@ -116,7 +166,7 @@ TerrainRenderer::init_program()
     program_["uNormalScale"] = 3.5f;
 
     program_["uDisplacementBias"] = 0.0f;
-    program_["uDisplacementScale"] = 375.0f;
+    program_["uDisplacementScale"] = displacement_scale;
 
     program_["uDiffuseColor"] = color_to_vec3(0xffffff);
     program_["uSpecularColor"] = color_to_vec3(0xffffff);
@@ -128,16 +178,63 @@ TerrainRenderer::init_program()
 
     program_["uOffset"] = LibMatrix::vec2(0.0, 0.0);
 
-    std::vector<GLint> attrib_locations;
-    attrib_locations.push_back(program_["position"].location());
-    attrib_locations.push_back(program_["normal"].location());
-    attrib_locations.push_back(program_["tangent"].location());
-    attrib_locations.push_back(program_["uv"].location());
-    mesh_.set_attrib_locations(attrib_locations);
+    if (tessellation_level_ > 0)
+        program_["uTessLevel"] = static_cast<float>(tessellation_level_);
+
+    if (!large) {
+        std::vector<GLint> attrib_locations;
+        attrib_locations.push_back(program_["position"].location());
+        attrib_locations.push_back(program_["normal"].location());
+        attrib_locations.push_back(program_["tangent"].location());
+        attrib_locations.push_back(program_["uv"].location());
+        mesh_.set_attrib_locations(attrib_locations);
+    }
 
     program_.stop();
 }
 
+/*
+ * Loads the terrain program that tessellates the triangles of the grid, and
+ * displaces the vertices in the tessellation evaluation shader instead of
+ * the vertex shader.
+ */
+bool
+TerrainRenderer::init_tessellation_program()
+{
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/terrain-tess.vert");
+    static const std::string tcs_shader_filename(Options::data_path + "/shaders/terrain.tesc");
+    static const std::string tes_shader_filename(Options::data_path + "/shaders/terrain.tese");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/terrain.frag");
+    const std::string version(Scene::tessellation_shader_version());
+
+    ShaderSource vtx_shader(ShaderSource::ShaderTypeVertex);
+    ShaderSource tcs_shader(ShaderSource::ShaderTypeTessControl);
+    ShaderSource tes_shader(ShaderSource::ShaderTypeTessEvaluation);
+    ShaderSource frg_shader(ShaderSource::ShaderTypeFragment);
+
+    vtx_shader.append(version);
+    vtx_shader.append_file(vtx_shader_filename);
+    tcs_shader.append(version);
+    tcs_shader.append_file(tcs_shader_filename);
+    tes_shader.append(version);
+    tes_shader.append_file(tes_shader_filename);
+    frg_shader.append(version);
+    frg_shader.append(Scene::glsl100_fragment_defines());
+    frg_shader.append_file(frg_shader_filename);
+
+    std::vector<Scene::ShaderStage> stages;
+    stages.push_back(Scene::ShaderStage(GL_VERTEX_SHADER, vtx_shader.str(),
+                                        vtx_shader_filename));
+    stages.push_back(Scene::ShaderStage(GL_TESS_CONTROL_SHADER, tcs_shader.str(),
+                                        tcs_shader_filename));
+    stages.push_back(Scene::ShaderStage(GL_TESS_EVALUATION_SHADER, tes_shader.str(),
+                                        tes_shader_filename));
+    stages.push_back(Scene::ShaderStage(GL_FRAGMENT_SHADER, frg_shader.str(),
+                                        frg_shader_filename));
+
+    return Scene::load_shader_stages_from_strings(program_, stages);
+}
+
 void
 TerrainRenderer::bind_textures()
 {
@@ -163,17 +260,22 @@ TerrainRenderer::bind_textures()
 void
 TerrainRenderer::deinit_textures()
 {
-    glDeleteTextures(1, &diffuse1_tex_);
-    glDeleteTextures(1, &diffuse2_tex_);
-    glDeleteTextures(1, &detail_tex_);
+    Texture::release(1, &diffuse1_tex_);
+    Texture::release(1, &diffuse2_tex_);
+    Texture::release(1, &detail_tex_);
 }
 
+/*
+ * Fills the vertices of a grid cell, each one of its corners ll, lr, ur and
+ * ul picked by order. A corner gets the same attributes in all its cells.
+ */
 static void
-grid_conf(Mesh &mesh, int x, int y, int n_x, int n_y,
-          LibMatrix::vec3 &ul,
-          LibMatrix::vec3 &ll,
-          LibMatrix::vec3 &ur,
-          LibMatrix::vec3 &lr)
+fill_cell(Mesh &mesh, float *dest, int x, int y, int n_x, int n_y,
+          const LibMatrix::vec3 &ul,
+          const LibMatrix::vec3 &ll,
+          const LibMatrix::vec3 &ur,
+          const LibMatrix::vec3 &lr,
+          const unsigned int *order, size_t count)
 {
     struct PlaneMeshVertex {
         LibMatrix::vec3 position;
@@ -217,19 +319,40 @@ grid_conf(Mesh &mesh, int x, int y, int n_x, int n_y,
         }
     };
 
-    unsigned int vertex_index[] = {0, 1, 2, 0, 2, 3};
-
-    for (size_t i = 0; i < sizeof(vertex_index) / sizeof(*vertex_index); i++) {
-        PlaneMeshVertex& vertex = cell_vertices[vertex_index[i]];
+    for (size_t i = 0; i < count; i++) {
+        PlaneMeshVertex& vertex = cell_vertices[order[i]];
+        float *dest_vertex = dest + i * mesh.vertex_size();
 
-        mesh.next_vertex();
-        mesh.set_attrib(0, vertex.position);
-        mesh.set_attrib(1, vertex.normal);
-        mesh.set_attrib(2, vertex.tangent);
-        mesh.set_attrib(3, vertex.texcoord);
+        mesh.set_attrib(0, vertex.position, dest_vertex);
+        mesh.set_attrib(1, vertex.normal, dest_vertex);
+        mesh.set_attrib(2, vertex.tangent, dest_vertex);
+        mesh.set_attrib(3, vertex.texcoord, dest_vertex);
     }
 }
 
+static void
+grid_fill(Mesh &mesh, float *dest, int x, int y, int n_x, int n_y,
+          const LibMatrix::vec3 &ul,
+          const LibMatrix::vec3 &ll,
+          const LibMatrix::vec3 &ur,
+          const LibMatrix::vec3 &lr)
+{
+    static const unsigned int order[] = {0, 1, 2, 0, 2, 3};
+    fill_cell(mesh, dest, x, y, n_x, n_y, ul, ll, ur, lr, order, 6);
+}
+
+/* Fills the corners of the cells of an indexed grid, ul, ll, ur and lr */
+static void
+grid_corners_fill(Mesh &mesh, float *dest, int x, int y, int n_x, int n_y,
+                  const LibMatrix::vec3 &ul,
+                  const LibMatrix::vec3 &ll,
+                  const LibMatrix::vec3 &ur,
+                  const LibMatrix::vec3 &lr)
+{
+    static const unsigned int order[] = {3, 0, 2, 1};
+    fill_cell(mesh, dest, x, y, n_x, n_y, ul, ll, ur, lr, order, 4);
+}
+
 void
 TerrainRenderer::create_mesh()
 {
@@ -240,7 +363,22 @@ TerrainRenderer::create_mesh()
     vertex_format.push_back(2);
     mesh_.set_vertex_format(vertex_format);
 
-    mesh_.make_grid(256, 256, 6000, 6000, 0, grid_conf);
+    /* Each triangle of the coarser grid of a tessellated terrain is a patch */
+    unsigned int cells = 256;
+    if (tessellation_level_ > 0) {
+        cells = std::max(cells / tessellation_level_, 1U);
+        mesh_.primitive(GL_PATCHES);
+    }
+
+    if (topology_ == Mesh::GridTriangles)
+        mesh_.make_grid(cells, cells, 6000, 6000, 0, grid_fill);
+    else
+        mesh_.make_grid(cells, cells, 6000, 6000, 0, grid_corners_fill, topology_);
     mesh_.build_vbo();
+
+    Log::debug("TerrainRenderer: %u vertices, %u indices of %u bytes\n",
+               static_cast<unsigned int>(mesh_.vertex_count()),
+               static_cast<unsigned int>(mesh_.index_count()),
+               static_cast<unsigned int>(mesh_.index_size()));
 }
 
@@ -0,0 +1,381 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "renderer.h"
+
+#include <algorithm>
+#include <cmath>
+
+/* The cells per side of a tile at the finest level of detail */
+static const unsigned int max_tile_cells = 64;
+
+/* The floats of a vertex: position, normal, tangent and uv */
+static const unsigned int vertex_floats = 11;
+
+/* How far the skirts hiding the cracks between levels of detail hang down */
+static const float skirt_depth = 50.0f;
+
+/*
+ * Gets the indices of the vertices on the edge of a grid of cells, going
+ * around it. The skirt of a tile has a vertex below each of them.
+ */
+static void
+grid_perimeter(unsigned int cells, std::vector<unsigned int> &perimeter)
+{
+    unsigned int row = cells + 1;
+
+    for (unsigned int i = 0; i < cells; i++)
+        perimeter.push_back(i);
+    for (unsigned int j = 0; j < cells; j++)
+        perimeter.push_back(j * row + cells);
+    for (unsigned int i = cells; i > 0; i--)
+        perimeter.push_back(cells * row + i);
+    for (unsigned int j = cells; j > 0; j--)
+        perimeter.push_back(j * row);
+}
+
+TerrainTileRenderer::TerrainTileRenderer(const LibMatrix::vec2 &repeat_overlay,
+                                         const std::string &texture_format,
+                                         unsigned int tiles, float tile_size,
+                                         unsigned int lod_levels,
+                                         unsigned int max_uploads) :
+    TerrainRenderer(repeat_overlay, texture_format, true),
+    tiles_(tiles), tile_size_(tile_size), lod_levels_(lod_levels),
+    max_uploads_(max_uploads), frame_(0)
+{
+    create_index_buffers();
+}
+
+TerrainTileRenderer::~TerrainTileRenderer()
+{
+    for (std::map<std::pair<unsigned int, unsigned int>, Tile>::iterator iter = resident_.begin();
+         iter != resident_.end();
+         iter++)
+    {
+        free_buffers_.push_back(iter->second.buffer);
+    }
+
+    if (!free_buffers_.empty())
+        glDeleteBuffers(free_buffers_.size(), &free_buffers_[0]);
+    if (!index_buffers_.empty())
+        glDeleteBuffers(index_buffers_.size(), &index_buffers_[0]);
+}
+
+void
+TerrainTileRenderer::create_index_buffers()
+{
+    index_buffers_.resize(lod_levels_);
+    index_counts_.resize(lod_levels_);
+    glGenBuffers(lod_levels_, &index_buffers_[0]);
+
+    for (unsigned int l = 0; l < lod_levels_; l++) {
+        unsigned int cells = std::max(max_tile_cells >> l, 1U);
+        std::vector<GLushort> indices;
+
+        for (unsigned int j = 0; j < cells; j++) {
+            for (unsigned int i = 0; i < cells; i++) {
+                GLushort ll = j * (cells + 1) + i;
+                GLushort ul = ll + cells + 1;
+
+                indices.push_back(ll);
+                indices.push_back(ll + 1);
+                indices.push_back(ul + 1);
+                indices.push_back(ll);
+                indices.push_back(ul + 1);
+                indices.push_back(ul);
+            }
+        }
+
+        /* The skirt vertices follow the grid ones */
+        std::vector<unsigned int> perimeter;
+        grid_perimeter(cells, perimeter);
+        GLushort skirt = (cells + 1) * (cells + 1);
+
+        for (unsigned int k = 0; k < perimeter.size(); k++) {
+            unsigned int next = (k + 1) % perimeter.size();
+
+            indices.push_back(perimeter[k]);
+            indices.push_back(skirt + k);
+            indices.push_back(perimeter[next]);
+            indices.push_back(perimeter[next]);
+            indices.push_back(skirt + k);
+            indices.push_back(skirt + next);
+        }
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers_[l]);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort),
+                     &indices[0], GL_STATIC_DRAW);
+        index_counts_[l] = indices.size();
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void
+TerrainTileRenderer::camera(const LibMatrix::mat4 &model_view_projection,
+                            const LibMatrix::vec3 &eye)
+{
+    LibMatrix::vec4 rows[4];
+
+    for (unsigned int r = 0; r < 4; r++) {
+        rows[r] = LibMatrix::vec4(model_view_projection[r][0],
+                                  model_view_projection[r][1],
+                                  model_view_projection[r][2],
+                                  model_view_projection[r][3]);
+    }
+
+    /* The planes of the frustum, with the inside on the positive side */
+    for (unsigned int i = 0; i < 3; i++) {
+        planes_[2 * i] = rows[3] + rows[i];
+        planes_[2 * i + 1] = rows[3] - rows[i];
+    }
+
+    eye_ = eye;
+}
+
+void
+TerrainTileRenderer::render()
+{
+    make_current();
+    glClearColor(0.825f, 0.7425f, 0.61875f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT|GL_DEPTH_BUFFER_BIT);
+
+    program().start();
+    bind_textures();
+
+    GLint locations[] = {
+        program()["position"].location(),
+        program()["normal"].location(),
+        program()["tangent"].location(),
+        program()["uv"].location()
+    };
+    for (unsigned int i = 0; i < sizeof(locations) / sizeof(*locations); i++) {
+        if (locations[i] >= 0)
+            glEnableVertexAttribArray(locations[i]);
+    }
+
+    frame_++;
+    stats_ = Stats();
+    visit(0, 0, tiles_);
+
+    for (unsigned int i = 0; i < sizeof(locations) / sizeof(*locations); i++) {
+        if (locations[i] >= 0)
+            glDisableVertexAttribArray(locations[i]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    program().stop();
+
+    update_mipmap();
+    evict();
+}
+
+/*
+ * Visits the node of the quadtree with the tiles from (x, y) to
+ * (x + size, y + size), skipping it whole if it is outside the frustum.
+ */
+void
+TerrainTileRenderer::visit(unsigned int x, unsigned int y, unsigned int size)
+{
+    if (!visible(x, y, size)) {
+        stats_.tiles_culled += size * size;
+        return;
+    }
+
+    if (size > 1) {
+        unsigned int half = size / 2;
+        visit(x, y, half);
+        visit(x + half, y, half);
+        visit(x, y + half, half);
+        visit(x + half, y + half, half);
+        return;
+    }
+
+    std::pair<unsigned int, unsigned int> key(x, y);
+    int wanted_lod = lod(x, y);
+    std::map<std::pair<unsigned int, unsigned int>, Tile>::iterator iter = resident_.find(key);
+
+    if ((iter == resident_.end() || iter->second.lod != wanted_lod) &&
+        stats_.tile_uploads < max_uploads_)
+    {
+        if (iter == resident_.end())
+            iter = resident_.insert(std::make_pair(key, Tile())).first;
+        upload(iter->second, x, y, wanted_lod);
+    }
+
+    /* Tiles that haven't been streamed in yet are missing */
+    if (iter != resident_.end()) {
+        iter->second.last_used = frame_;
+        draw(iter->second);
+    }
+}
+
+bool
+TerrainTileRenderer::visible(unsigned int x, unsigned int y, unsigned int size)
+{
+    float origin = -world_size() / 2.0f;
+    LibMatrix::vec3 min(origin + x * tile_size_, origin + y * tile_size_, -skirt_depth);
+    LibMatrix::vec3 max(min.x() + size * tile_size_, min.y() + size * tile_size_,
+                        displacement_scale);
+
+    /* The box is outside if its corner furthest along a plane is outside */
+    for (unsigned int i = 0; i < 6; i++) {
+        const LibMatrix::vec4 &p(planes_[i]);
+        float d = p.x() * (p.x() > 0.0f ? max.x() : min.x()) +
+                  p.y() * (p.y() > 0.0f ? max.y() : min.y()) +
+                  p.z() * (p.z() > 0.0f ? max.z() : min.z()) +
+                  p.w();
+        if (d < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * Gets the level of detail of a tile, one coarser level each time its
+ * distance to the camera doubles.
+ */
+int
+TerrainTileRenderer::lod(unsigned int x, unsigned int y)
+{
+    float origin = -world_size() / 2.0f;
+    float x0 = origin + x * tile_size_;
+    float y0 = origin + y * tile_size_;
+    float dx = eye_.x() - std::min(std::max(eye_.x(), x0), x0 + tile_size_);
+    float dy = eye_.y() - std::min(std::max(eye_.y(), y0), y0 + tile_size_);
+    float dz = eye_.z() - std::min(std::max(eye_.z(), 0.0f), displacement_scale);
+    float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+    if (distance < tile_size_)
+        return 0;
+
+    int level = 1 + static_cast<int>(std::log2(distance / tile_size_));
+    return std::min(level, static_cast<int>(lod_levels_) - 1);
+}
+
+void
+TerrainTileRenderer::upload(Tile &tile, unsigned int x, unsigned int y, int lod)
+{
+    unsigned int cells = std::max(max_tile_cells >> lod, 1U);
+    float size = world_size();
+    float origin = -size / 2.0f;
+    float step = tile_size_ / cells;
+    std::vector<float> vertices;
+
+    vertices.reserve(((cells + 1) * (cells + 1) + 4 * cells) * vertex_floats);
+
+    for (unsigned int j = 0; j <= cells; j++) {
+        for (unsigned int i = 0; i <= cells; i++) {
+            float px = origin + x * tile_size_ + i * step;
+            float py = origin + y * tile_size_ + j * step;
+            float vertex[vertex_floats] = {
+                px, py, 0.0f,
+                0.0f, 0.0f, 1.0f,
+                1.0f, 0.0f, 0.0f,
+                (px - origin) / size, (py - origin) / size
+            };
+            vertices.insert(vertices.end(), vertex, vertex + vertex_floats);
+        }
+    }
+
+    /* The skirt copies the edge vertices, lowered */
+    std::vector<unsigned int> perimeter;
+    grid_perimeter(cells, perimeter);
+
+    for (unsigned int k = 0; k < perimeter.size(); k++) {
+        std::vector<float>::const_iterator edge =
+            vertices.begin() + perimeter[k] * vertex_floats;
+        vertices.insert(vertices.end(), edge, edge + vertex_floats);
+        vertices[vertices.size() - vertex_floats + 2] = -skirt_depth;
+    }
+
+    if (!tile.buffer) {
+        if (free_buffers_.empty()) {
+            glGenBuffers(1, &tile.buffer);
+        }
+        else {
+            tile.buffer = free_buffers_.back();
+            free_buffers_.pop_back();
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, tile.buffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float),
+                 &vertices[0], GL_DYNAMIC_DRAW);
+
+    tile.lod = lod;
+    stats_.tile_uploads++;
+}
+
+void
+TerrainTileRenderer::draw(const Tile &tile)
+{
+    static const GLsizei stride = vertex_floats * sizeof(float);
+    static const unsigned int offsets[] = { 0, 3, 6, 9 };
+    static const GLint sizes[] = { 3, 3, 3, 2 };
+    static const char *names[] = { "position", "normal", "tangent", "uv" };
+    unsigned int cells = std::max(max_tile_cells >> tile.lod, 1U);
+
+    glBindBuffer(GL_ARRAY_BUFFER, tile.buffer);
+    for (unsigned int i = 0; i < 4; i++) {
+        GLint location = program()[names[i]].location();
+        if (location < 0)
+            continue;
+        glVertexAttribPointer(location, sizes[i], GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const GLvoid *>(offsets[i] * sizeof(float)));
+    }
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffers_[tile.lod]);
+    glDrawElements(GL_TRIANGLES, index_counts_[tile.lod], GL_UNSIGNED_SHORT, 0);
+
+    stats_.tiles_drawn++;
+    stats_.vertices += (cells + 1) * (cells + 1) + 4 * cells;
+}
+
+/*
+ * Keeps the geometry of about twice as many tiles as are visible, dropping
+ * the ones unused for the longest time beyond that.
+ */
+void
+TerrainTileRenderer::evict()
+{
+    size_t capacity = 2 * stats_.tiles_drawn + max_uploads_;
+
+    if (resident_.size() <= capacity)
+        return;
+
+    std::vector<std::pair<uint64_t, std::pair<unsigned int, unsigned int> > > unused;
+    for (std::map<std::pair<unsigned int, unsigned int>, Tile>::const_iterator iter = resident_.begin();
+         iter != resident_.end();
+         iter++)
+    {
+        if (iter->second.last_used < frame_)
+            unused.push_back(std::make_pair(iter->second.last_used, iter->first));
+    }
+
+    std::sort(unused.begin(), unused.end());
+
+    for (size_t i = 0; i < unused.size() && resident_.size() > capacity; i++) {
+        std::map<std::pair<unsigned int, unsigned int>, Tile>::iterator iter =
+            resident_.find(unused[i].second);
+        free_buffers_.push_back(iter->second.buffer);
+        resident_.erase(iter);
+    }
+}
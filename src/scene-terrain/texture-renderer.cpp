@@ -19,13 +19,44 @@
  * Authors:
  *  Alexandros Frantzis
  */
+#include "options.h"
+#include "scene.h"
 #include "renderer.h"
+#include "shader-source.h"
 
-TextureRenderer::TextureRenderer(Program &program) :
-    BaseRenderer(), program_(program)
+TextureRenderer::TextureRenderer(Program &program, bool compute) :
+    BaseRenderer(), program_(program), compute_(compute)
 {
     /* Create the mesh (quad) used for rendering */
-    create_mesh();
+    if (!compute_)
+        create_mesh();
+
+    immutable_texture_ = compute_;
+}
+
+void
+TextureRenderer::compute_shader_header(ShaderSource &source)
+{
+    source.append(Scene::compute_shader_version());
+    source.append_file(Options::data_path + "/shaders/terrain-compute-header.comp");
+}
+
+void
+TextureRenderer::compute_shader_footer(ShaderSource &source)
+{
+    /*
+     * Turn the fragment shader into a function called by the compute
+     * shader main(), with its input and output replaced by the globals
+     * declared in the header. The header already declares uvScale for
+     * the main(), so drop the fragment shader declaration of it.
+     */
+    source.replace("varying vec2 vUv;", "");
+    source.replace("uniform MEDIUMP_OR_DEFAULT vec2 uvScale;", "");
+    source.replace("gl_FragColor", "FragColor");
+    source.replace("texture2D(", "texture(");
+    source.replace("void main(", "void fragment_main(");
+
+    source.append_file(Options::data_path + "/shaders/terrain-compute-main.comp");
 }
 
 void
@@ -52,6 +83,27 @@ TextureRenderer::create_mesh()
 void
 TextureRenderer::render()
 {
+    if (compute_) {
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, input_texture_);
+
+        program_.start();
+
+        GLExtensions::BindImageTexture(0, texture_, 0, GL_FALSE, 0,
+                                       GL_WRITE_ONLY, GL_RGBA8);
+        GLExtensions::DispatchCompute((static_cast<GLuint>(size_.x()) + 7) / 8,
+                                      (static_cast<GLuint>(size_.y()) + 7) / 8, 1);
+        /* Make the image writes visible to the next stages */
+        GLExtensions::MemoryBarrierGL(GL_TEXTURE_FETCH_BARRIER_BIT |
+                                      GL_SHADER_IMAGE_ACCESS_BARRIER_BIT |
+                                      GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+        program_.stop();
+
+        update_mipmap();
+        return;
+    }
+
     make_current();
 
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
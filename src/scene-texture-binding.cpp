@@ -0,0 +1,425 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+
+struct SceneTextureBindingPrivate {
+    enum Binding {
+        BindingBind,
+        BindingArray,
+        BindingBindless
+    };
+
+    /* The size of each texture, small enough to keep the upload out of the way */
+    static const int texture_size = 16;
+
+    SceneTextureBindingPrivate() :
+        binding(BindingBind), draws(0), ntextures(0),
+        offset_location(-1), layer_location(-1), texture_location(-1),
+        array_texture(0) {}
+
+    Binding binding;
+    unsigned int draws;
+    unsigned int ntextures;
+
+    Program program;
+    Mesh mesh;
+
+    /* The uniform locations, looked up once to keep them out of the loop */
+    GLint offset_location;
+    GLint layer_location;
+    GLint texture_location;
+    /* The position of each draw on the screen */
+    std::vector<float> offsets;
+
+    /*
+     * The textures drawn with, either one texture per object (with a
+     * bindless handle for each when binding=bindless) or one array
+     * texture with a layer per object.
+     */
+    std::vector<GLuint> textures;
+    std::vector<GLuint64> handles;
+    GLuint array_texture;
+
+    FrameStats submit_stats;
+
+    void release()
+    {
+        for (std::vector<GLuint64>::iterator iter = handles.begin();
+             iter != handles.end();
+             iter++)
+        {
+            GLExtensions::MakeTextureHandleNonResident(*iter);
+        }
+        handles.clear();
+
+        if (!textures.empty()) {
+            glDeleteTextures(textures.size(), &textures[0]);
+            textures.clear();
+        }
+
+        if (array_texture) {
+            glDeleteTextures(1, &array_texture);
+            array_texture = 0;
+        }
+
+        offsets.clear();
+        mesh.reset();
+
+        program.stop();
+        program.release();
+    }
+
+    /* Creates the contents of a texture, a checkerboard of its own color */
+    std::vector<unsigned char> texels(unsigned int index)
+    {
+        std::vector<unsigned char> data(4 * texture_size * texture_size);
+        float hue = static_cast<float>(index) / ntextures;
+        unsigned char color[3] = {
+            static_cast<unsigned char>(127.5f + 127.5f * std::cos(6.2832f * hue)),
+            static_cast<unsigned char>(127.5f + 127.5f * std::cos(6.2832f * (hue + 0.33f))),
+            static_cast<unsigned char>(127.5f + 127.5f * std::cos(6.2832f * (hue + 0.67f)))
+        };
+
+        for (int y = 0; y < texture_size; y++) {
+            for (int x = 0; x < texture_size; x++) {
+                unsigned char *texel = &data[4 * (y * texture_size + x)];
+                bool dark = ((x / 4) + (y / 4)) % 2;
+                for (int c = 0; c < 3; c++)
+                    texel[c] = dark ? color[c] / 2 : color[c];
+                texel[3] = 255;
+            }
+        }
+
+        return data;
+    }
+};
+
+SceneTextureBinding::SceneTextureBinding(Canvas &pCanvas) :
+    Scene(pCanvas, "texture-binding")
+{
+    priv_ = new SceneTextureBindingPrivate();
+    options_["draws"] = Scene::Option("draws", "10000",
+                                      "The number of draw calls issued every frame");
+    options_["textures"] = Scene::Option("textures", "64",
+                                         "The number of different textures cycled through between draw calls");
+    options_["binding"] = Scene::Option("binding", "bind",
+                                        "How the texture of each draw call is selected"
+                                        " (bind: glBindTexture, array: a layer of an array texture,"
+                                        " bindless: a bindless texture handle)",
+                                        "bind,array,bindless");
+}
+
+SceneTextureBinding::~SceneTextureBinding()
+{
+    delete priv_;
+}
+
+bool
+SceneTextureBinding::supported(bool show_errors)
+{
+    if (options_["binding"].value == "array" && GLExtensions::TexImage3D == 0) {
+        if (show_errors) {
+            Log::error("Requested array texture binding but array textures"
+                       " are not supported!\n");
+        }
+        return false;
+    }
+
+    if (options_["binding"].value == "bindless" && GLExtensions::GetTextureHandle == 0) {
+        if (show_errors) {
+            Log::error("Requested bindless texture binding but GL_ARB_bindless_texture"
+                       " or GL_NV_bindless_texture is not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneTextureBinding::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneTextureBinding::unload()
+{
+}
+
+bool
+SceneTextureBinding::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/texture-binding.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/texture-binding.frag");
+
+    SceneTextureBindingPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.draws = Util::fromString<unsigned int>(options_["draws"].value);
+    p.ntextures = Util::fromString<unsigned int>(options_["textures"].value);
+    if (p.draws == 0 || p.ntextures == 0) {
+        Log::error("The number of draws and textures must be at least 1\n");
+        return false;
+    }
+
+    const std::string &binding = options_["binding"].value;
+    if (binding == "array")
+        p.binding = SceneTextureBindingPrivate::BindingArray;
+    else if (binding == "bindless")
+        p.binding = SceneTextureBindingPrivate::BindingBindless;
+    else
+        p.binding = SceneTextureBindingPrivate::BindingBind;
+
+    if (p.binding == SceneTextureBindingPrivate::BindingArray) {
+        GLint max_layers = 0;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+        if (p.ntextures > static_cast<unsigned int>(max_layers)) {
+            Log::error("The number of textures exceeds the maximum number of"
+                       " array texture layers (%d)\n", max_layers);
+            return false;
+        }
+    }
+
+    /* Lay out the draws in a square grid covering the screen, as in drawcalls */
+    unsigned int side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(p.draws))));
+    float cell = 2.0f / side;
+
+    p.offsets.reserve(2 * p.draws);
+    for (unsigned int i = 0; i < p.draws; i++) {
+        p.offsets.push_back(-1.0f + cell * (i % side + 0.5f));
+        p.offsets.push_back(1.0f - cell * (i / side + 0.5f));
+    }
+
+    /* Load the program for the selected binding */
+    ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+    vtx_source.append(Scene::glsl3_shader_version());
+    vtx_source.append_file(vtx_shader_filename);
+    vtx_source.add_const("CellSize", cell);
+
+    if (p.binding == SceneTextureBindingPrivate::BindingBindless) {
+        /* Bindless textures need GLSL 4.00 on desktop GL */
+        if (GLExtensions::support("GL_ARB_bindless_texture")) {
+#if GLMARK2_USE_GLESv2
+            frg_source.append(Scene::glsl3_shader_version());
+#else
+            frg_source.append("#version 400\n");
+#endif
+            frg_source.append("#extension GL_ARB_bindless_texture : require\n");
+        }
+        else {
+            frg_source.append(Scene::glsl3_shader_version());
+            frg_source.append("#extension GL_NV_bindless_texture : require\n");
+        }
+        frg_source.append("#define BINDLESS\n");
+    }
+    else {
+        frg_source.append(Scene::glsl3_shader_version());
+        if (p.binding == SceneTextureBindingPrivate::BindingArray)
+            frg_source.append("#define TEXTURE_ARRAY\n");
+    }
+    frg_source.append_file(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.program.start();
+    p.offset_location = p.program["Offset"].location();
+    if (p.binding == SceneTextureBindingPrivate::BindingArray) {
+        p.program["Textures"] = 0;
+        p.layer_location = p.program["Layer"].location();
+    }
+    else if (p.binding == SceneTextureBindingPrivate::BindingBindless) {
+        p.texture_location = p.program["Texture"].location();
+    }
+    else {
+        p.program["Texture"] = 0;
+    }
+
+    /* Create the quad drawn by every draw call */
+    std::vector<int> vertex_format;
+    vertex_format.push_back(3);
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(p.program["position"].location());
+
+    p.mesh.set_vertex_format(vertex_format);
+    p.mesh.make_grid(1, 1, cell, cell, 0.0);
+    p.mesh.build_vbo();
+    p.mesh.set_attrib_locations(attrib_locations);
+
+    /* Create the textures, all with the same size and format */
+    if (p.binding == SceneTextureBindingPrivate::BindingArray) {
+        glGenTextures(1, &p.array_texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, p.array_texture);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLExtensions::TexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8,
+                                 SceneTextureBindingPrivate::texture_size,
+                                 SceneTextureBindingPrivate::texture_size,
+                                 p.ntextures, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+
+        for (unsigned int i = 0; i < p.ntextures; i++) {
+            std::vector<unsigned char> data(p.texels(i));
+            GLExtensions::TexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i,
+                                        SceneTextureBindingPrivate::texture_size,
+                                        SceneTextureBindingPrivate::texture_size,
+                                        1, GL_RGBA, GL_UNSIGNED_BYTE, &data[0]);
+        }
+    }
+    else {
+        p.textures.resize(p.ntextures);
+        glGenTextures(p.ntextures, &p.textures[0]);
+
+        for (unsigned int i = 0; i < p.ntextures; i++) {
+            std::vector<unsigned char> data(p.texels(i));
+
+            glBindTexture(GL_TEXTURE_2D, p.textures[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, SceneTextureBindingPrivate::texture_size,
+                         SceneTextureBindingPrivate::texture_size, 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, &data[0]);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        /* The handles freeze the texture state, so they are taken last */
+        if (p.binding == SceneTextureBindingPrivate::BindingBindless) {
+            for (unsigned int i = 0; i < p.ntextures; i++) {
+                GLuint64 handle = GLExtensions::GetTextureHandle(p.textures[i]);
+                if (handle == 0) {
+                    Log::error("Failed to get the bindless handle of a texture\n");
+                    return false;
+                }
+                GLExtensions::MakeTextureHandleResident(handle);
+                p.handles.push_back(handle);
+            }
+        }
+    }
+
+    p.submit_stats.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneTextureBinding::teardown()
+{
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneTextureBinding::update()
+{
+    Scene::update();
+}
+
+/*
+ * Issues the draw calls, selecting a different texture for each one with
+ * the chosen binding, so that only the cost of the selection differs
+ * between the bindings.
+ */
+void
+SceneTextureBinding::draw()
+{
+    SceneTextureBindingPrivate &p(*priv_);
+    uint64_t start = Util::get_timestamp_us();
+
+    glActiveTexture(GL_TEXTURE0);
+    if (p.binding == SceneTextureBindingPrivate::BindingArray)
+        glBindTexture(GL_TEXTURE_2D_ARRAY, p.array_texture);
+
+    for (unsigned int i = 0; i < p.draws; i++) {
+        unsigned int tex = i % p.ntextures;
+
+        glUniform2f(p.offset_location, p.offsets[2 * i], p.offsets[2 * i + 1]);
+
+        switch (p.binding) {
+            case SceneTextureBindingPrivate::BindingBind:
+                glBindTexture(GL_TEXTURE_2D, p.textures[tex]);
+                break;
+            case SceneTextureBindingPrivate::BindingArray:
+                glUniform1i(p.layer_location, tex);
+                break;
+            case SceneTextureBindingPrivate::BindingBindless:
+                GLExtensions::UniformHandleui64(p.texture_location, p.handles[tex]);
+                break;
+        }
+
+        p.mesh.render_vbo();
+    }
+
+    p.submit_stats.add(Util::get_timestamp_us() - start);
+}
+
+Scene::ValidationResult
+SceneTextureBinding::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneTextureBinding::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("SubmitTime", "submit_time",
+                                                   priv_->submit_stats));
+}
+
+void
+SceneTextureBinding::reset_measurements()
+{
+    priv_->submit_stats.reset();
+}
+
+std::vector<Scene::Rate>
+SceneTextureBinding::rates()
+{
+    double elapsed = elapsed_time();
+    double draws = static_cast<double>(priv_->draws) * frame_count();
+
+    return std::vector<Rate>(1, Rate("DrawsPerSecond", "draws_per_second",
+                                     elapsed > 0.0 ? draws / elapsed : 0.0));
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <random>
+
+struct SceneTextureCachePrivate {
+    enum Pattern {
+        PatternLinear,
+        PatternTiled,
+        PatternRandom
+    };
+
+    SceneTextureCachePrivate() :
+        pattern(PatternLinear), size(0), samples(0), texture(0),
+        quad_buffer(0) {}
+
+    Pattern pattern;
+    unsigned int size;
+    unsigned int samples;
+
+    Program program;
+    GLuint texture;
+    GLuint quad_buffer;
+
+    void release()
+    {
+        if (texture) {
+            glDeleteTextures(1, &texture);
+            texture = 0;
+        }
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+
+    /* Gets the texel at a position of the access order of the pattern */
+    void texel_at(unsigned int index, const std::vector<unsigned int> &order,
+                  unsigned int &x, unsigned int &y) const
+    {
+        if (pattern == PatternTiled) {
+            /* De-interleave the bits of the Morton (Z-order) index */
+            x = 0;
+            y = 0;
+            for (unsigned int bit = 0; (1U << bit) < size; bit++) {
+                x |= ((index >> (2 * bit)) & 1) << bit;
+                y |= ((index >> (2 * bit + 1)) & 1) << bit;
+            }
+        }
+        else {
+            if (pattern == PatternRandom)
+                index = order[index];
+            x = index % size;
+            y = index / size;
+        }
+    }
+
+    /*
+     * Fills the texture with a single chain through all its texels, each
+     * texel holding the coordinates of the next one in the access order
+     * of the pattern.
+     */
+    void create_texture()
+    {
+        const unsigned int count = size * size;
+        std::vector<unsigned int> order;
+        std::vector<unsigned char> pixels(static_cast<size_t>(count) * 4);
+
+        /* A shuffled order is a single cycle through all the texels */
+        if (pattern == PatternRandom) {
+            order.resize(count);
+            for (unsigned int i = 0; i < count; i++)
+                order[i] = i;
+            std::shuffle(order.begin(), order.end(), std::mt19937(1));
+        }
+
+        unsigned int x = 0;
+        unsigned int y = 0;
+        texel_at(0, order, x, y);
+
+        for (unsigned int i = 0; i < count; i++) {
+            unsigned int next_x = 0;
+            unsigned int next_y = 0;
+            texel_at((i + 1) % count, order, next_x, next_y);
+
+            unsigned char *texel = &pixels[(static_cast<size_t>(y) * size + x) * 4];
+            texel[0] = next_x >> 8;
+            texel[1] = next_x & 0xff;
+            texel[2] = next_y >> 8;
+            texel[3] = next_y & 0xff;
+
+            x = next_x;
+            y = next_y;
+        }
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+    }
+};
+
+SceneTextureCache::SceneTextureCache(Canvas &pCanvas) :
+    Scene(pCanvas, "texture-cache")
+{
+    priv_ = new SceneTextureCachePrivate();
+    options_["pattern"] = Scene::Option("pattern", "linear",
+                                        "The order the texels are read in: row by row, along a Morton curve, or shuffled",
+                                        "linear,tiled,random");
+    options_["texture-size"] = Scene::Option("texture-size", "2048",
+                                             "The width and height of the RGBA8 texture (a power of two for pattern=tiled)");
+    options_["samples"] = Scene::Option("samples", "16",
+                                        "The number of dependent texture reads per fragment");
+}
+
+SceneTextureCache::~SceneTextureCache()
+{
+    delete priv_;
+}
+
+bool
+SceneTextureCache::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneTextureCache::unload()
+{
+}
+
+bool
+SceneTextureCache::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/fillrate.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/texture-cache.frag");
+
+    SceneTextureCachePrivate &p(*priv_);
+
+    /* Parse the options */
+    p.size = Util::fromString<unsigned int>(options_["texture-size"].value);
+    p.samples = Util::fromString<unsigned int>(options_["samples"].value);
+
+    const std::string &pattern = options_["pattern"].value;
+    if (pattern == "tiled")
+        p.pattern = SceneTextureCachePrivate::PatternTiled;
+    else if (pattern == "random")
+        p.pattern = SceneTextureCachePrivate::PatternRandom;
+    else
+        p.pattern = SceneTextureCachePrivate::PatternLinear;
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+    /* The coordinates are stored as 16-bit values */
+    if (p.size == 0 || p.size > static_cast<unsigned int>(max_size) || p.size > 65536) {
+        Log::error("Invalid texture-size %u (maximum %d)\n", p.size,
+                   std::min(max_size, 65536));
+        return false;
+    }
+
+    if (p.pattern == SceneTextureCachePrivate::PatternTiled && (p.size & (p.size - 1))) {
+        Log::error("The texture-size must be a power of two with pattern=tiled\n");
+        return false;
+    }
+
+    if (p.samples == 0) {
+        Log::error("The number of samples must be at least 1\n");
+        return false;
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    frg_source.replace("$SAMPLES$", Util::toString(p.samples));
+    frg_source.add_const("TextureSize", static_cast<float>(p.size));
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    /* Create the full-screen quad, drawn as a triangle strip */
+    p.quad_buffer = FullscreenQuad::create();
+
+    p.create_texture();
+
+    p.program.start();
+    p.program["Texture0"] = 0;
+    p.program["Depth"] = 0.0f;
+
+    glDisable(GL_DEPTH_TEST);
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneTextureCache::teardown()
+{
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneTextureCache::update()
+{
+    Scene::update();
+}
+
+/*
+ * Draws a full-screen quad, each fragment of which follows the chain of
+ * the texture from the texel under it. The reads of neighbouring fragments
+ * stay close together with pattern=linear and tiled, and scatter across
+ * the whole texture with pattern=random.
+ */
+void
+SceneTextureCache::draw()
+{
+    SceneTextureCachePrivate &p(*priv_);
+    GLint position_location = p.program["position"].location();
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, p.texture);
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneTextureCache::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneTextureCache::rates()
+{
+    double elapsed = elapsed_time();
+    double texels = static_cast<double>(priv_->samples) *
+                    canvas_.width() * canvas_.height() * frame_count();
+
+    return std::vector<Rate>(1, Rate("MegatexelsPerSecond", "megatexels_per_second",
+                                     elapsed > 0.0 ? texels / elapsed / 1e6 : 0.0));
+}
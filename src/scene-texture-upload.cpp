@@ -0,0 +1,516 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * A band of texture rows that is updated in a single glTexSubImage2D call.
+ */
+struct UploadBand {
+    UploadBand(unsigned int y, unsigned int rows) : y(y), rows(rows) {}
+    unsigned int y;
+    unsigned int rows;
+};
+
+struct SceneTextureUploadPrivate {
+    enum UpdateMethod {
+        UpdateMethodClient,
+        UpdateMethodPBO,
+        UpdateMethodPersistent
+    };
+
+    SceneTextureUploadPrivate() :
+        texture(0), width(0), height(0), format(GL_RGBA), bpp(4),
+        update_method(UpdateMethodClient), update_rows(0), nbands(1),
+        row_offset(0), ring_size(0), ring_index(0), persistent_buffer(0),
+        persistent_data(0) {}
+
+    Program program;
+    Mesh mesh;
+    GLuint texture;
+    unsigned int width;
+    unsigned int height;
+    GLenum format;
+    unsigned int bpp;
+    UpdateMethod update_method;
+    /* The number of rows updated every frame, split into nbands bands */
+    unsigned int update_rows;
+    unsigned int nbands;
+    /* Where the first band starts, moving down the texture every frame */
+    unsigned int row_offset;
+
+    /* Client memory source */
+    std::vector<unsigned char> client_data;
+
+    /* PBO ring, or segments of a persistently mapped buffer */
+    unsigned int ring_size;
+    unsigned int ring_index;
+    std::vector<GLuint> pbos;
+    GLuint persistent_buffer;
+    unsigned char *persistent_data;
+    std::vector<GLsync> fences;
+
+    FrameStats upload_stats;
+
+    size_t update_size() const { return static_cast<size_t>(update_rows) * width * bpp; }
+
+    /*
+     * Gets the bands to update this frame. With update-dispersion=0 the rows
+     * form a single band, with update-dispersion=1 each row is its own band,
+     * and the bands are spread evenly over the texture.
+     */
+    void bands(std::vector<UploadBand> &out) const
+    {
+        out.clear();
+
+        for (unsigned int i = 0; i < nbands; i++) {
+            unsigned int rows = update_rows * (i + 1) / nbands - update_rows * i / nbands;
+            unsigned int y = (row_offset + height * i / nbands) % height;
+
+            if (rows == 0)
+                continue;
+
+            out.push_back(UploadBand(std::min(y, height - rows), rows));
+        }
+    }
+
+    /*
+     * Writes the new contents of the updated rows, like a producer of
+     * video frames or UI content would.
+     */
+    void fill(unsigned char *dst, const std::vector<UploadBand> &b,
+              unsigned int frame) const
+    {
+        const size_t stride = static_cast<size_t>(width) * bpp;
+
+        for (std::vector<UploadBand>::const_iterator iter = b.begin();
+             iter != b.end();
+             iter++)
+        {
+            for (unsigned int r = 0; r < iter->rows; r++) {
+                std::memset(dst, ((iter->y + r) * 3 + frame * 7) & 0xff, stride);
+                dst += stride;
+            }
+        }
+    }
+
+    /*
+     * Uploads the bands, whose data are stored consecutively starting at
+     * data (or at that offset in the bound pixel unpack buffer).
+     */
+    void upload(const unsigned char *data, const std::vector<UploadBand> &b) const
+    {
+        const size_t stride = static_cast<size_t>(width) * bpp;
+
+        for (std::vector<UploadBand>::const_iterator iter = b.begin();
+             iter != b.end();
+             iter++)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, iter->y, width, iter->rows,
+                            format, GL_UNSIGNED_BYTE, data);
+            data += stride * iter->rows;
+        }
+    }
+
+    void release_buffers()
+    {
+        for (std::vector<GLsync>::iterator iter = fences.begin();
+             iter != fences.end();
+             iter++)
+        {
+            if (*iter)
+                GLExtensions::DeleteSync(*iter);
+        }
+        fences.clear();
+
+        if (!pbos.empty()) {
+            glDeleteBuffers(pbos.size(), &pbos[0]);
+            pbos.clear();
+        }
+
+        if (persistent_buffer) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, persistent_buffer);
+            GLExtensions::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &persistent_buffer);
+            persistent_buffer = 0;
+            persistent_data = 0;
+        }
+
+        client_data.clear();
+    }
+};
+
+SceneTextureUpload::SceneTextureUpload(Canvas &pCanvas) :
+    Scene(pCanvas, "texture-upload")
+{
+    priv_ = new SceneTextureUploadPrivate();
+    options_["update-method"] = Scene::Option("update-method", "client",
+                                              "Where the texture data are uploaded from",
+                                              "client,pbo,persistent");
+    options_["update-fraction"] = Scene::Option("update-fraction", "1.0",
+                                                "The fraction of the texture rows that is updated at every iteration (0.0-1.0)");
+    options_["update-dispersion"] = Scene::Option("update-dispersion", "0.0",
+                                                  "How dispersed the updates are [0.0 - 1.0]");
+    options_["texture-size"] = Scene::Option("texture-size", "1024x1024",
+                                             "The size of the texture in WxH format");
+    options_["texture-format"] = Scene::Option("texture-format", "rgba",
+                                               "The format of the texture data",
+                                               "rgba,rgb,bgra");
+    options_["ring-size"] = Scene::Option("ring-size", "3",
+                                          "The number of buffers used by the pbo and persistent methods");
+}
+
+SceneTextureUpload::~SceneTextureUpload()
+{
+    delete priv_;
+}
+
+bool
+SceneTextureUpload::supported(bool show_errors)
+{
+    const std::string &method = options_["update-method"].value;
+
+#if GLMARK2_USE_GLESv2
+    /* Pixel unpack buffers are only available in GLES 3.0 */
+    bool unpack_buffers = GLExtensions::version_supported(3, 0);
+#else
+    bool unpack_buffers = true;
+#endif
+    bool pbo = unpack_buffers &&
+               GLExtensions::MapBufferRange && GLExtensions::UnmapBuffer;
+    bool persistent = pbo && GLExtensions::BufferStorage &&
+                      GLExtensions::FenceSync && GLExtensions::DeleteSync &&
+                      GLExtensions::ClientWaitSync;
+
+    if (method == "pbo" && !pbo) {
+        if (show_errors) {
+            Log::error("Requested pbo update method but pixel unpack buffers"
+                       " with glMapBufferRange are not supported!\n");
+        }
+        return false;
+    }
+
+    if (method == "persistent" && !persistent) {
+        if (show_errors) {
+            Log::error("Requested persistent update method but"
+                       " GL_ARB_buffer_storage/GL_EXT_buffer_storage is not supported!\n");
+        }
+        return false;
+    }
+
+#if GLMARK2_USE_GLESv2
+    if (options_["texture-format"].value == "bgra" &&
+        !GLExtensions::support("GL_EXT_texture_format_BGRA8888"))
+    {
+        if (show_errors) {
+            Log::error("Requested bgra texture format but"
+                       " GL_EXT_texture_format_BGRA8888 is not supported!\n");
+        }
+        return false;
+    }
+#endif
+
+    return true;
+}
+
+bool
+SceneTextureUpload::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneTextureUpload::unload()
+{
+}
+
+bool
+SceneTextureUpload::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/effect-2d.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/desktop.frag");
+
+    SceneTextureUploadPrivate &p(*priv_);
+
+    /* Parse the options */
+    std::vector<std::string> size_elems;
+    Util::split(options_["texture-size"].value, 'x', size_elems, Util::SplitModeNormal);
+    if (size_elems.size() != 2) {
+        Log::error("Invalid texture-size '%s', expected WxH\n",
+                   options_["texture-size"].value.c_str());
+        return false;
+    }
+
+    p.width = Util::fromString<unsigned int>(size_elems[0]);
+    p.height = Util::fromString<unsigned int>(size_elems[1]);
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    if (p.width == 0 || p.height == 0 ||
+        p.width > static_cast<unsigned int>(max_size) ||
+        p.height > static_cast<unsigned int>(max_size))
+    {
+        Log::error("Invalid texture-size %ux%u (maximum %d)\n",
+                   p.width, p.height, max_size);
+        return false;
+    }
+
+    const std::string &format = options_["texture-format"].value;
+    GLenum internal_format = GL_RGBA;
+    if (format == "rgb") {
+        p.format = GL_RGB;
+        p.bpp = 3;
+        internal_format = GL_RGB;
+    }
+    else if (format == "bgra") {
+        p.format = GL_BGRA;
+        p.bpp = 4;
+#if GLMARK2_USE_GLESv2
+        /* GL_EXT_texture_format_BGRA8888 requires a BGRA internal format */
+        internal_format = GL_BGRA;
+#endif
+    }
+    else {
+        p.format = GL_RGBA;
+        p.bpp = 4;
+    }
+
+    double update_fraction = Util::fromString<double>(options_["update-fraction"].value);
+    double update_dispersion = Util::fromString<double>(options_["update-dispersion"].value);
+    update_fraction = std::min(std::max(update_fraction, 0.0), 1.0);
+    update_dispersion = std::min(std::max(update_dispersion, 0.0), 1.0);
+
+    p.update_rows = std::max(static_cast<unsigned int>(std::round(update_fraction * p.height)), 1U);
+    p.nbands = std::max(static_cast<unsigned int>(std::round(update_dispersion * p.update_rows)), 1U);
+    p.row_offset = 0;
+
+    const std::string &method = options_["update-method"].value;
+    if (method == "pbo")
+        p.update_method = SceneTextureUploadPrivate::UpdateMethodPBO;
+    else if (method == "persistent")
+        p.update_method = SceneTextureUploadPrivate::UpdateMethodPersistent;
+    else
+        p.update_method = SceneTextureUploadPrivate::UpdateMethodClient;
+
+    p.ring_size = std::max(Util::fromString<unsigned int>(options_["ring-size"].value), 1U);
+    p.ring_index = 0;
+
+    /* Create the texture */
+    glGenTextures(1, &p.texture);
+    glBindTexture(GL_TEXTURE_2D, p.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, p.width, p.height, 0,
+                 p.format, GL_UNSIGNED_BYTE, 0);
+
+    /* Rows of RGB data are not 4-byte aligned */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    /* Create the upload sources */
+    const size_t update_size = p.update_size();
+
+    if (p.update_method == SceneTextureUploadPrivate::UpdateMethodClient) {
+        p.client_data.resize(update_size);
+    }
+    else if (p.update_method == SceneTextureUploadPrivate::UpdateMethodPBO) {
+        p.pbos.resize(p.ring_size);
+        glGenBuffers(p.ring_size, &p.pbos[0]);
+        for (unsigned int i = 0; i < p.ring_size; i++) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, p.pbos[i]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, update_size, 0, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else {
+        static const GLbitfield flags =
+            GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &p.persistent_buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, p.persistent_buffer);
+        GLExtensions::BufferStorage(GL_PIXEL_UNPACK_BUFFER, update_size * p.ring_size,
+                                    0, flags);
+        p.persistent_data = static_cast<unsigned char *>(
+            GLExtensions::MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                         update_size * p.ring_size, flags));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (!p.persistent_data) {
+            Log::error("Failed to map the persistent pixel unpack buffer\n");
+            return false;
+        }
+
+        p.fences.resize(p.ring_size, 0);
+    }
+
+    /* Set up the program and the full screen quad that shows the texture */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    std::vector<int> vertex_format;
+    vertex_format.push_back(3);
+    p.mesh.set_vertex_format(vertex_format);
+
+    p.mesh.make_grid(1, 1, 2.0, 2.0, 0.0);
+    p.mesh.build_vbo();
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(p.program["position"].location());
+    p.mesh.set_attrib_locations(attrib_locations);
+
+    p.program.start();
+    p.program["MaterialTexture0"] = 0;
+
+    p.upload_stats.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneTextureUpload::teardown()
+{
+    SceneTextureUploadPrivate &p(*priv_);
+
+    p.release_buffers();
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glDeleteTextures(1, &p.texture);
+    p.texture = 0;
+
+    p.mesh.reset();
+
+    p.program.stop();
+    p.program.release();
+
+    Scene::teardown();
+}
+
+void
+SceneTextureUpload::update()
+{
+    Scene::update();
+
+    if (!running_)
+        return;
+
+    SceneTextureUploadPrivate &p(*priv_);
+    std::vector<UploadBand> bands;
+    p.bands(bands);
+
+    const size_t update_size = p.update_size();
+    uint64_t start = Util::get_timestamp_us();
+
+    glBindTexture(GL_TEXTURE_2D, p.texture);
+
+    if (p.update_method == SceneTextureUploadPrivate::UpdateMethodClient) {
+        p.fill(&p.client_data[0], bands, currentFrame_);
+        p.upload(&p.client_data[0], bands);
+    }
+    else if (p.update_method == SceneTextureUploadPrivate::UpdateMethodPBO) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, p.pbos[p.ring_index]);
+        void *data = GLExtensions::MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, update_size,
+                                                  GL_MAP_WRITE_BIT |
+                                                  GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (data) {
+            p.fill(static_cast<unsigned char *>(data), bands, currentFrame_);
+            GLExtensions::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            p.upload(0, bands);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else {
+        /* Wait until the GPU is done with the segment we are going to overwrite */
+        GLsync &fence(p.fences[p.ring_index]);
+        if (fence) {
+            GLExtensions::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                         1000000000);
+            GLExtensions::DeleteSync(fence);
+            fence = 0;
+        }
+
+        size_t offset = update_size * p.ring_index;
+        p.fill(p.persistent_data + offset, bands, currentFrame_);
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, p.persistent_buffer);
+        p.upload(reinterpret_cast<const unsigned char *>(offset), bands);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        fence = GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    p.upload_stats.add(Util::get_timestamp_us() - start);
+
+    p.ring_index = (p.ring_index + 1) % p.ring_size;
+    p.row_offset = (p.row_offset + p.update_rows) % p.height;
+}
+
+void
+SceneTextureUpload::draw()
+{
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, priv_->texture);
+
+    priv_->mesh.render_vbo();
+}
+
+Scene::ValidationResult
+SceneTextureUpload::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneTextureUpload::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("UploadTime", "upload_time",
+                                                   priv_->upload_stats));
+}
+
+void
+SceneTextureUpload::reset_measurements()
+{
+    priv_->upload_stats.reset();
+}
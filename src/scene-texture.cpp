@@ -33,14 +33,18 @@
 #include "texture.h"
 #include "model.h"
 #include "util.h"
+#include <algorithm>
 #include <cmath>
+#include <sstream>
 
 using LibMatrix::vec3;
 using std::string;
 
 SceneTexture::SceneTexture(Canvas &pCanvas) :
     Scene(pCanvas, "texture"), radius_(0.0),
-    orientModel_(false), orientationAngle_(0.0)
+    orientModel_(false), orientationAngle_(0.0),
+    anisotropic_(false), swizzled_(false), texture_target_(GL_TEXTURE_2D),
+    yuv_image_(0)
 {
     const ModelMap& modelMap = Model::find_models();
     string optionValues;
@@ -79,15 +83,159 @@ SceneTexture::SceneTexture(Canvas &pCanvas) :
     }
     options_["texture"] = Scene::Option("texture", "crate-base", "Which texture to use",
                                         optionValues);
+    options_["texture-format"] = Scene::Option("texture-format", "rgba",
+                                               "The format of the textures to use (compressed formats need <texture>.<format>.ktx[2] files)",
+                                               Texture::format_option_values);
+    options_["mipmap"] = Scene::Option("mipmap", "gpu",
+                                       "Where to generate the mipmaps with texture-filter=mipmap (compressed textures use the levels in the file)",
+                                       "gpu,cpu");
     options_["texgen"] = Scene::Option("texgen", "false",
                                        "Whether to generate texcoords in the shader",
                                        "false,true");
+    options_["vertex-format"] = Scene::Option("vertex-format", "float",
+                                              "How to store vertex attributes (compact: half float positions, 2_10_10_10 normals, 16-bit normalized texcoords)",
+                                              "float,compact");
+    options_["internal-format"] = Scene::Option("internal-format", "default",
+                                                "The internal format to convert the texture to (default: the format of the texture file)",
+                                                "default,rgba8,srgb8,rgba16f,r8");
+    options_["texture-size"] = Scene::Option("texture-size", "0",
+                                             "The width and height to resize the texture to (0: the size of the texture file)");
+    options_["anisotropy"] = Scene::Option("anisotropy", "1",
+                                           "The maximum anisotropy of the texture filter (needs GL_EXT_texture_filter_anisotropic if above 1)");
+    options_["lod-bias"] = Scene::Option("lod-bias", "0.0",
+                                         "The bias added to the level of detail of the texture samples, in the shader");
+    options_["swizzle"] = Scene::Option("swizzle", "rgba",
+                                        "The texture swizzle, four of r, g, b, a, 0 and 1 (e.g. bgra, rrr1)");
+    options_["texture-units"] = Scene::Option("texture-units", "1",
+                                              "The number of texture units sampled per fragment, each with its own copy of the texture");
+    options_["yuv"] = Scene::Option("yuv", "none",
+                                    "Sample the texture as a YUV frame, with two (nv12) or three (i420) planes",
+                                    "none,nv12,i420");
+    options_["yuv-conversion"] = Scene::Option("yuv-conversion", "shader",
+                                               "Where YUV is converted to RGB: in the shader, or by sampling a dma-buf as an external texture",
+                                               "shader,external");
 }
 
 SceneTexture::~SceneTexture()
 {
 }
 
+/*
+ * Parses a texture swizzle, e.g. "bgra", into the GL_TEXTURE_SWIZZLE_*
+ * parameters.
+ */
+static bool
+parse_swizzle(const std::string &str, GLint swizzle[4])
+{
+    static const std::string components("rgba01");
+    static const GLint values[] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA, GL_ZERO, GL_ONE };
+
+    if (str.size() != 4)
+        return false;
+
+    for (unsigned int i = 0; i < 4; i++) {
+        size_t index = components.find(str[i]);
+        if (index == std::string::npos)
+            return false;
+        swizzle[i] = values[index];
+    }
+
+    return true;
+}
+
+bool
+SceneTexture::supported(bool show_errors)
+{
+    const std::string &internal_format = options_["internal-format"].value;
+    bool converted = internal_format != "default" ||
+                     Util::fromString<unsigned int>(options_["texture-size"].value) != 0 ||
+                     Util::fromString<unsigned int>(options_["texture-units"].value) > 1;
+
+    if (converted && options_["texture-format"].value != "rgba") {
+        if (show_errors)
+            Log::error("SceneTexture can only convert, resize or copy texture-format=rgba textures\n");
+        return false;
+    }
+
+    if (internal_format != "default" && internal_format != "rgba8" &&
+        !GLExtensions::version_supported(3, 0))
+    {
+        if (show_errors)
+            Log::error("SceneTexture internal-format=%s requires GL(ES) 3.0\n",
+                       internal_format.c_str());
+        return false;
+    }
+
+    if (options_["swizzle"].value != "rgba") {
+#if GLMARK2_USE_GLESv2
+        bool swizzle = GLExtensions::version_supported(3, 0);
+#else
+        bool swizzle = GLExtensions::version_supported(3, 3) ||
+                       GLExtensions::support("GL_ARB_texture_swizzle") ||
+                       GLExtensions::support("GL_EXT_texture_swizzle");
+#endif
+        if (!swizzle) {
+            if (show_errors)
+                Log::error("SceneTexture swizzle requires texture swizzle support\n");
+            return false;
+        }
+    }
+
+    if (options_["vertex-format"].value == "compact" &&
+        (!Mesh::attrib_format_supported(Mesh::AttribFormatHalfFloat) ||
+         !Mesh::attrib_format_supported(Mesh::AttribFormatInt2101010Rev)))
+    {
+        if (show_errors) {
+            Log::error("Requested compact vertex format but half float or"
+                       " 2_10_10_10 vertex attributes are not supported!\n");
+        }
+        return false;
+    }
+
+    if (Util::fromString<float>(options_["anisotropy"].value) > 1.0f &&
+        !GLExtensions::support("GL_EXT_texture_filter_anisotropic") &&
+        !GLExtensions::support("GL_ARB_texture_filter_anisotropic"))
+    {
+        if (show_errors)
+            Log::error("SceneTexture anisotropy requires GL_EXT_texture_filter_anisotropic\n");
+        return false;
+    }
+
+    GLint max_units = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &max_units);
+    if (Util::fromString<GLint>(options_["texture-units"].value) > max_units) {
+        if (show_errors)
+            Log::error("SceneTexture texture-units is above the %d texture units of the fragment shader\n",
+                       max_units);
+        return false;
+    }
+
+    if (options_["yuv"].value != "none") {
+        const std::string &filter = options_["texture-filter"].value;
+
+        if (converted || options_["texture-format"].value != "rgba" ||
+            (filter != "nearest" && filter != "linear") ||
+            options_["anisotropy"].value != "1" || options_["lod-bias"].value != "0.0" ||
+            options_["swizzle"].value != "rgba")
+        {
+            if (show_errors)
+                Log::error("SceneTexture yuv can only be combined with texture-filter=nearest or linear\n");
+            return false;
+        }
+
+        if (options_["yuv-conversion"].value == "external" &&
+            (GLExtensions::EGLImageTargetTexture2DOES == 0 ||
+             !GLExtensions::support("GL_OES_EGL_image_external")))
+        {
+            if (show_errors)
+                Log::error("SceneTexture yuv-conversion=external requires GL_OES_EGL_image_external\n");
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool
 SceneTexture::load()
 {
@@ -114,6 +262,8 @@ SceneTexture::setup()
     static const std::string vtx_shader_texgen_filename(Options::data_path + "/shaders/light-basic-texgen.vert");
     static const std::string frg_shader_filename(Options::data_path + "/shaders/light-basic-tex.frag");
     static const std::string frg_shader_bilinear_filename(Options::data_path + "/shaders/light-basic-tex-bilinear.frag");
+    static const std::string frg_shader_units_filename(Options::data_path + "/shaders/light-basic-tex-units.frag");
+    static const std::string frg_shader_yuv_filename(Options::data_path + "/shaders/light-basic-tex-yuv.frag");
     static const LibMatrix::vec4 lightPosition(20.0f, 20.0f, 10.0f, 1.0f);
     static const LibMatrix::vec4 materialDiffuse(1.0f, 1.0f, 1.0f, 1.0f);
 
@@ -139,9 +289,84 @@ SceneTexture::setup()
         mag_filter = GL_LINEAR;
     }
 
-    const string& whichTexture(options_["texture"].value);
-    if (!Texture::load(whichTexture, &texture_, min_filter, mag_filter, 0))
+    const string whichTexture(Texture::format_name(options_["texture"].value,
+                                                   options_["texture-format"].value));
+    Texture::MipmapMode mipmap_mode(options_["mipmap"].value == "cpu" ?
+                                    Texture::MipmapCPU : Texture::MipmapGPU);
+
+    const std::string &internal_format_name = options_["internal-format"].value;
+    unsigned int texture_size = Util::fromString<unsigned int>(options_["texture-size"].value);
+    unsigned int texture_units = Util::fromString<unsigned int>(options_["texture-units"].value);
+    float anisotropy = Util::fromString<float>(options_["anisotropy"].value);
+    float lod_bias = Util::fromString<float>(options_["lod-bias"].value);
+    GLint swizzle[4] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
+    const std::string &yuv = options_["yuv"].value;
+    bool yuv_external = yuv != "none" && options_["yuv-conversion"].value == "external";
+
+    if (texture_units == 0) {
+        Log::error("SceneTexture texture-units must be at least 1\n");
+        return false;
+    }
+    if (!parse_swizzle(options_["swizzle"].value, swizzle)) {
+        Log::error("Invalid SceneTexture swizzle '%s'\n", options_["swizzle"].value.c_str());
+        return false;
+    }
+    if (filter == "linear-shader" && (texture_units > 1 || lod_bias != 0.0f)) {
+        Log::error("SceneTexture texture-filter=linear-shader can't be combined with texture-units or lod-bias\n");
+        return false;
+    }
+
+    GLenum internal_format = GL_RGBA8;
+    if (internal_format_name == "srgb8")
+        internal_format = GL_SRGB8_ALPHA8;
+    else if (internal_format_name == "rgba16f")
+        internal_format = GL_RGBA16F;
+    else if (internal_format_name == "r8")
+        internal_format = GL_R8;
+
+    // Each texture unit samples its own copy of the texture, so that they
+    // don't share the texture cache
+    bool converted = internal_format_name != "default" || texture_size != 0 ||
+                     texture_units > 1;
+    textures_.assign(texture_units, 0);
+
+    // Time the upload, including the mipmap generation and the wait for
+    // the GPU to finish it, but not the decode of the image
+    upload_stats_.reset();
+    glFinish();
+    Texture::take_upload_time_us();
+    uint64_t upload_us = 0;
+    for (unsigned int i = 0; i < texture_units && yuv == "none"; i++) {
+        bool loaded = converted ?
+            Texture::create(whichTexture, &textures_[i], min_filter, mag_filter,
+                            internal_format, texture_size) :
+            Texture::load(whichTexture, &textures_[i], min_filter, mag_filter, mipmap_mode);
+        if (!loaded)
+            return false;
+    }
+    if (yuv != "none" &&
+        !create_yuv_textures(whichTexture, min_filter, mag_filter, yuv == "nv12",
+                             yuv_external, upload_us))
+    {
         return false;
+    }
+    uint64_t finish_start = Util::get_timestamp_us();
+    glFinish();
+    upload_us += Texture::take_upload_time_us() + Util::get_timestamp_us() - finish_start;
+    upload_stats_.add(upload_us);
+
+    if (anisotropy > 1.0f) {
+        GLfloat max_anisotropy = 1.0f;
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+        if (anisotropy > max_anisotropy) {
+            Log::debug("Clamping the SceneTexture anisotropy to %.1f\n", max_anisotropy);
+            anisotropy = max_anisotropy;
+        }
+    }
+
+    anisotropic_ = anisotropy > 1.0f;
+    swizzled_ = options_["swizzle"].value != "rgba";
+    set_sampling_state(anisotropy, swizzle);
 
     // Load shaders
     bool doTexGen(options_["texgen"].value == "true");
@@ -154,10 +379,48 @@ SceneTexture::setup()
         vtx_source.append_file(vtx_shader_filename);
     }
     ShaderSource frg_source;
-    if (filter == "linear-shader") {
+    if (yuv_external) {
+        // The sampler converts the frame
+        frg_source.append("#extension GL_OES_EGL_image_external : require\n");
+        frg_source.append_file(frg_shader_filename);
+        frg_source.replace("sampler2D", "samplerExternalOES");
+    }
+    else if (yuv != "none") {
+        // The shader converts the frame, sampling each plane
+        std::stringstream ss_samplers;
+
+        for (unsigned int i = 0; i < textures_.size(); i++)
+            ss_samplers << "uniform sampler2D MaterialTexture" << i << ";" << std::endl;
+
+        frg_source.append_file(frg_shader_yuv_filename);
+        frg_source.replace("$SAMPLERS$", ss_samplers.str());
+        frg_source.replace("$CHROMA$", yuv == "nv12" ?
+                           "texture2D(MaterialTexture1, TextureCoord).ra" :
+                           "vec2(texture2D(MaterialTexture1, TextureCoord).r, "
+                           "texture2D(MaterialTexture2, TextureCoord).r)");
+    }
+    else if (filter == "linear-shader") {
         frg_source.append_file(frg_shader_bilinear_filename);
-        LibMatrix::vec2 texture_size(512, 512);
-        frg_source.add_const("TextureSize", texture_size);
+        float size = texture_size ? texture_size : 512;
+        frg_source.add_const("TextureSize", LibMatrix::vec2(size, size));
+    }
+    else if (texture_units > 1 || lod_bias != 0.0f) {
+        // Average the samples of all the units, with the bias added to the
+        // level of detail of each one
+        std::stringstream ss_samplers;
+        std::stringstream ss_samples;
+
+        for (unsigned int i = 0; i < texture_units; i++) {
+            ss_samplers << "uniform sampler2D MaterialTexture" << i << ";" << std::endl;
+            ss_samples << "    texel += texture2D(MaterialTexture" << i
+                       << ", TextureCoord, LodBias);" << std::endl;
+        }
+        ss_samples << "    texel /= " << texture_units << ".0;" << std::endl;
+
+        frg_source.append_file(frg_shader_units_filename);
+        frg_source.replace("$SAMPLERS$", ss_samplers.str());
+        frg_source.replace("$SAMPLES$", ss_samples.str());
+        frg_source.add_const("LodBias", lod_bias);
     }
     else {
         frg_source.append_file(frg_shader_filename);
@@ -220,6 +483,17 @@ SceneTexture::setup()
         attribs.push_back(std::pair<Model::AttribType, int>(Model::AttribTypeTexcoord, 2));
     }
     model.convert_to_mesh(mesh_, attribs);
+
+    // The texcoords of the models, or the ones calculated for them, are in
+    // [0, 1], so they keep their precision as normalized shorts
+    if (options_["vertex-format"].value == "compact") {
+        std::vector<Mesh::AttribFormat> formats;
+        formats.push_back(Mesh::AttribFormatHalfFloat);
+        formats.push_back(Mesh::AttribFormatInt2101010Rev);
+        formats.push_back(Mesh::AttribFormatUnsignedShortNorm);
+        mesh_.set_attrib_formats(formats);
+    }
+
     mesh_.build_vbo();
 
     // Calculate a projection matrix that is a good fit for the model
@@ -250,6 +524,11 @@ SceneTexture::setup()
     }
     mesh_.set_attrib_locations(attrib_locations);
 
+    if (textures_.size() > 1 || lod_bias != 0.0f) {
+        for (unsigned int i = 0; i < textures_.size(); i++)
+            program_["MaterialTexture" + Util::toString(i)] = static_cast<int>(i);
+    }
+
     currentFrame_ = 0;
     rotation_ = LibMatrix::vec3();
     running_ = true;
@@ -259,13 +538,212 @@ SceneTexture::setup()
     return true;
 }
 
+/*
+ * Creates the texture of a plane of a YUV frame, which is 1 or 2 (UV)
+ * bytes per pixel.
+ */
+static void
+create_plane_texture(GLuint texture, GLenum format, unsigned int width,
+                     unsigned int height, const std::vector<unsigned char> &plane,
+                     GLint min_filter, GLint mag_filter)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format,
+                 GL_UNSIGNED_BYTE, &plane[0]);
+}
+
+/*
+ * Creates the textures of a YUV frame converted (BT.601 limited range) from
+ * the image of a texture: a Y plane, and interleaved UV (NV12) or separate U
+ * and V (I420) planes subsampled by 2 in both directions. For the shader to
+ * convert the frame, each plane gets its own texture. For the sampler to
+ * convert it, the planes are laid out in a dma-buf, imported as a single
+ * external texture.
+ */
+bool
+SceneTexture::create_yuv_textures(const std::string &name, GLint min_filter,
+                                  GLint mag_filter, bool interleaved, bool external,
+                                  uint64_t &upload_us)
+{
+    std::vector<unsigned char> pixels;
+    unsigned int src_width = 0;
+    unsigned int src_height = 0;
+    GLenum format = GL_RGBA;
+
+    if (!Texture::decode(name, pixels, src_width, src_height, format)) {
+        Log::error("SceneTexture yuv can only convert PNG and JPEG textures\n");
+        return false;
+    }
+
+    const unsigned int bpp = format == GL_RGB ? 3 : 4;
+    const unsigned int width = src_width & ~1u;
+    const unsigned int height = src_height & ~1u;
+    const unsigned int chroma_width = width / 2;
+    const unsigned int chroma_height = height / 2;
+
+    std::vector<unsigned char> y(static_cast<size_t>(width) * height);
+    std::vector<unsigned char> u(static_cast<size_t>(chroma_width) * chroma_height);
+    std::vector<unsigned char> v(u.size());
+
+    for (unsigned int row = 0; row < height; row++) {
+        const unsigned char *src = &pixels[static_cast<size_t>(row) * src_width * bpp];
+        for (unsigned int col = 0; col < width; col++, src += bpp) {
+            int r = src[0];
+            int g = src[1];
+            int b = src[2];
+
+            y[static_cast<size_t>(row) * width + col] = 16 + (66 * r + 129 * g + 25 * b) / 256;
+            if (row % 2 == 0 && col % 2 == 0) {
+                size_t i = static_cast<size_t>(row / 2) * chroma_width + col / 2;
+                u[i] = 128 + (-38 * r - 74 * g + 112 * b) / 256;
+                v[i] = 128 + (112 * r - 94 * g - 18 * b) / 256;
+            }
+        }
+    }
+
+    if (external) {
+        // An 8-bit buffer with the chroma rows after the luma rows, each
+        // padded to the width
+        unsigned int buf_height = height + (interleaved ? 1 : 2) * chroma_height;
+        std::vector<unsigned char> data(static_cast<size_t>(width) * buf_height);
+
+        std::copy(y.begin(), y.end(), data.begin());
+        for (unsigned int row = 0; row < chroma_height; row++) {
+            unsigned char *dst = &data[static_cast<size_t>(height + row) * width];
+            for (unsigned int col = 0; col < chroma_width; col++) {
+                size_t i = static_cast<size_t>(row) * chroma_width + col;
+                if (interleaved) {
+                    dst[2 * col] = u[i];
+                    dst[2 * col + 1] = v[i];
+                }
+                else {
+                    dst[col] = u[i];
+                    dst[static_cast<size_t>(chroma_height) * width + col] = v[i];
+                }
+            }
+        }
+
+        uint64_t start = Util::get_timestamp_us();
+
+        if (!canvas_.create_dma_buf(width, buf_height, 1, &data[0], yuv_buf_)) {
+            Log::error("SceneTexture yuv-conversion=external failed to allocate a dma-buf, "
+                       "which is only supported by the DRM flavors\n");
+            return false;
+        }
+
+        DmaBufImage image;
+        image.fourcc = interleaved ? DmaBufFormatNV12 : DmaBufFormatYUV420;
+        image.width = width;
+        image.height = height;
+        image.num_planes = interleaved ? 2 : 3;
+        for (unsigned int i = 0; i < image.num_planes; i++) {
+            image.fds[i] = yuv_buf_.fd;
+            image.strides[i] = yuv_buf_.stride;
+        }
+        image.offsets[1] = yuv_buf_.stride * height;
+        image.offsets[2] = yuv_buf_.stride * (height + chroma_height);
+
+        yuv_image_ = canvas_.create_dma_buf_image(image);
+        if (!yuv_image_) {
+            Log::error("SceneTexture yuv-conversion=external failed to import the dma-buf\n");
+            return false;
+        }
+
+        texture_target_ = GL_TEXTURE_EXTERNAL_OES;
+        textures_.assign(1, 0);
+        glGenTextures(1, &textures_[0]);
+        glBindTexture(GL_TEXTURE_EXTERNAL_OES, textures_[0]);
+        glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, min_filter);
+        glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, mag_filter);
+        GLExtensions::EGLImageTargetTexture2DOES(GL_TEXTURE_EXTERNAL_OES, yuv_image_);
+        upload_us += Util::get_timestamp_us() - start;
+
+        return true;
+    }
+
+    uint64_t start = Util::get_timestamp_us();
+
+    // The rows of the chroma planes may not be 4-byte aligned
+    textures_.assign(interleaved ? 2 : 3, 0);
+    glGenTextures(textures_.size(), &textures_[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    create_plane_texture(textures_[0], GL_LUMINANCE, width, height, y,
+                         min_filter, mag_filter);
+
+    if (interleaved) {
+        std::vector<unsigned char> uv(u.size() * 2);
+        for (size_t i = 0; i < u.size(); i++) {
+            uv[2 * i] = u[i];
+            uv[2 * i + 1] = v[i];
+        }
+        create_plane_texture(textures_[1], GL_LUMINANCE_ALPHA, chroma_width,
+                             chroma_height, uv, min_filter, mag_filter);
+    }
+    else {
+        create_plane_texture(textures_[1], GL_LUMINANCE, chroma_width,
+                             chroma_height, u, min_filter, mag_filter);
+        create_plane_texture(textures_[2], GL_LUMINANCE, chroma_width,
+                             chroma_height, v, min_filter, mag_filter);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    upload_us += Util::get_timestamp_us() - start;
+
+    return true;
+}
+
+/*
+ * Sets the anisotropy and the swizzle of the textures, if they aren't the
+ * default ones.
+ */
+void
+SceneTexture::set_sampling_state(float anisotropy, const GLint swizzle[4])
+{
+    for (std::vector<GLuint>::const_iterator iter = textures_.begin();
+         iter != textures_.end();
+         iter++)
+    {
+        glBindTexture(texture_target_, *iter);
+        if (anisotropic_)
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+        if (swizzled_) {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_R, swizzle[0]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, swizzle[1]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, swizzle[2]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_A, swizzle[3]);
+        }
+    }
+}
+
 void
 SceneTexture::teardown()
 {
+    static const GLint default_swizzle[4] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
+
     program_.stop();
     program_.release();
 
-    glDeleteTextures(1, &texture_);
+    // Loaded textures may be reused by later benchmarks with --reuse-context
+    set_sampling_state(1.0f, default_swizzle);
+    anisotropic_ = false;
+    swizzled_ = false;
+
+    if (!textures_.empty())
+        Texture::release(textures_.size(), &textures_[0]);
+    textures_.clear();
+
+    if (yuv_image_) {
+        canvas_.destroy_dma_buf_image(yuv_image_);
+        yuv_image_ = 0;
+    }
+    if (yuv_buf_.fd >= 0)
+        canvas_.destroy_dma_buf(yuv_buf_);
+    texture_target_ = GL_TEXTURE_2D;
 
     Scene::teardown();
 }
@@ -275,7 +753,7 @@ SceneTexture::update()
 {
     Scene::update();
 
-    double elapsed_time = lastUpdateTime_ - startTime_;
+    double elapsed_time = animation_time();
 
     rotation_ = rotationSpeed_ * elapsed_time;
 }
@@ -304,8 +782,10 @@ SceneTexture::draw()
     normal_matrix.inverse().transpose();
     program_["NormalMatrix"] = normal_matrix;
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture_);
+    for (unsigned int i = textures_.size(); i-- > 0;) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(texture_target_, textures_[i]);
+    }
 
     mesh_.render_vbo();
 }
@@ -325,6 +805,19 @@ SceneTexture::validate()
 
     const std::string &filter = options_["texture-filter"].value;
 
+    // The references are for the unconverted texture, with its default
+    // sampling state
+    if (options_["internal-format"].value != "default" ||
+        options_["texture-size"].value != "0" ||
+        options_["texture-units"].value != "1" ||
+        options_["anisotropy"].value != "1" ||
+        options_["lod-bias"].value != "0.0" ||
+        options_["swizzle"].value != "rgba" ||
+        options_["yuv"].value != "none")
+    {
+        return Scene::ValidationUnknown;
+    }
+
     if (filter == "nearest")
         ref = Canvas::Pixel(0x2b, 0x2a, 0x28, 0xff);
     else if (filter == "linear")
@@ -347,3 +840,18 @@ SceneTexture::validate()
         return Scene::ValidationFailure;
     }
 }
+
+std::vector<Scene::Measurement>
+SceneTexture::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("UploadTime", "upload_time",
+                                                   upload_stats_));
+}
+
+std::vector<std::string>
+SceneTexture::textures()
+{
+    return std::vector<std::string>(1,
+        Texture::format_name(options_["texture"].value,
+                             options_["texture-format"].value));
+}
@@ -0,0 +1,376 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "mat.h"
+#include "options.h"
+#include "stack.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+
+/* The captured vertex layout, matching the varyings of the capture shader */
+struct CapturedVertex {
+    float position[3];
+    float normal[3];
+};
+
+struct SceneTransformFeedbackPrivate {
+    SceneTransformFeedbackPrivate() :
+        columns(0), rows(0), vertices(0), indices(0), ping_pong(false),
+        rasterizer_discard(false), grid_buffer(0), index_buffer(0), current(0)
+    {
+        captured[0] = captured[1] = 0;
+    }
+
+    unsigned int columns;
+    unsigned int rows;
+    unsigned int vertices;
+    unsigned int indices;
+    bool ping_pong;
+    bool rasterizer_discard;
+
+    /* Computes the displaced vertices, captured with transform feedback */
+    Program capture_program;
+    /* Draws the grid from the captured vertices */
+    Program render_program;
+    /* The flat grid, the input of the capture pass without ping-pong */
+    GLuint grid_buffer;
+    GLuint index_buffer;
+    /* The captured vertices, alternating between the two with ping-pong */
+    GLuint captured[2];
+    unsigned int current;
+
+    void release()
+    {
+        GLuint buffers[] = { grid_buffer, index_buffer, captured[0], captured[1] };
+
+        for (unsigned int i = 0; i < sizeof(buffers) / sizeof(*buffers); i++) {
+            if (buffers[i])
+                glDeleteBuffers(1, &buffers[i]);
+        }
+        grid_buffer = 0;
+        index_buffer = 0;
+        captured[0] = captured[1] = 0;
+
+        capture_program.stop();
+        capture_program.release();
+        render_program.stop();
+        render_program.release();
+    }
+};
+
+SceneTransformFeedback::SceneTransformFeedback(Canvas &pCanvas) :
+    Scene(pCanvas, "transform-feedback")
+{
+    priv_ = new SceneTransformFeedbackPrivate();
+    options_["columns"] = Scene::Option("columns", "1000",
+                                        "The number of mesh subdivisions length-wise");
+    options_["rows"] = Scene::Option("rows", "200",
+                                     "The number of mesh subdivisions width-wise");
+    options_["ping-pong"] = Scene::Option("ping-pong", "false",
+                                          "Whether each frame captures from the vertices captured by the last one, alternating between two buffers",
+                                          "false,true");
+    options_["rasterizer-discard"] = Scene::Option("rasterizer-discard", "true",
+                                                   "Whether to discard the primitives of the capture pass, instead of also drawing them as points",
+                                                   "false,true");
+}
+
+SceneTransformFeedback::~SceneTransformFeedback()
+{
+    delete priv_;
+}
+
+bool
+SceneTransformFeedback::supported(bool show_errors)
+{
+    if (GLExtensions::TransformFeedbackVaryings == 0 ||
+        GLExtensions::BeginTransformFeedback == 0 ||
+        GLExtensions::EndTransformFeedback == 0 ||
+        GLExtensions::BindBufferBase == 0)
+    {
+        if (show_errors) {
+            Log::error("SceneTransformFeedback requires transform feedback support"
+                       " (GL 3.0 or GLES 3.0)!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneTransformFeedback::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneTransformFeedback::unload()
+{
+}
+
+bool
+SceneTransformFeedback::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_capture_shader_filename(Options::data_path + "/shaders/transform-feedback-capture.vert");
+    static const std::string frg_capture_shader_filename(Options::data_path + "/shaders/transform-feedback-capture.frag");
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/transform-feedback.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/transform-feedback.frag");
+
+    SceneTransformFeedbackPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.columns = Util::fromString<unsigned int>(options_["columns"].value);
+    p.rows = Util::fromString<unsigned int>(options_["rows"].value);
+    p.ping_pong = options_["ping-pong"].value == "true";
+    p.rasterizer_discard = options_["rasterizer-discard"].value == "true";
+
+    if (p.columns == 0 || p.rows == 0) {
+        Log::error("The columns and rows options must be at least 1\n");
+        return false;
+    }
+
+    p.vertices = (p.columns + 1) * (p.rows + 1);
+    p.indices = p.columns * p.rows * 6;
+
+    /* Load the programs */
+    ShaderSource vtx_capture_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_capture_source(ShaderSource::ShaderTypeFragment);
+    ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+    vtx_capture_source.append(Scene::glsl3_shader_version());
+    vtx_capture_source.append_file(vtx_capture_shader_filename);
+    frg_capture_source.append(Scene::glsl3_shader_version());
+    frg_capture_source.append_file(frg_capture_shader_filename);
+    vtx_source.append(Scene::glsl3_shader_version());
+    vtx_source.append_file(vtx_shader_filename);
+    frg_source.append(Scene::glsl3_shader_version());
+    frg_source.append_file(frg_shader_filename);
+
+    std::vector<std::string> varyings;
+    varyings.push_back("Position");
+    varyings.push_back("Normal");
+
+    if (!Scene::load_transform_feedback_shaders_from_strings(p.capture_program,
+                                                             vtx_capture_source.str(),
+                                                             frg_capture_source.str(),
+                                                             varyings,
+                                                             vtx_capture_shader_filename) ||
+        !Scene::load_shaders_from_strings(p.render_program, vtx_source.str(),
+                                          frg_source.str(),
+                                          vtx_shader_filename, frg_shader_filename))
+    {
+        return false;
+    }
+
+    /*
+     * Create the flat grid, of the same size as the mesh of the buffer
+     * scene, and the indices of its triangles.
+     */
+    static const float length = 5.0f;
+    static const float width = 2.0f;
+    std::vector<CapturedVertex> grid(p.vertices);
+    std::vector<GLuint> indices;
+    indices.reserve(p.indices);
+
+    for (unsigned int r = 0; r <= p.rows; r++) {
+        for (unsigned int c = 0; c <= p.columns; c++) {
+            CapturedVertex &v(grid[r * (p.columns + 1) + c]);
+            v.position[0] = length * c / p.columns - length / 2.0f;
+            v.position[1] = width * r / p.rows - width / 2.0f;
+            v.position[2] = 0.0f;
+            v.normal[0] = 0.0f;
+            v.normal[1] = 0.0f;
+            v.normal[2] = 1.0f;
+        }
+    }
+
+    for (unsigned int r = 0; r < p.rows; r++) {
+        for (unsigned int c = 0; c < p.columns; c++) {
+            GLuint ll = r * (p.columns + 1) + c;
+            GLuint ul = ll + p.columns + 1;
+
+            indices.push_back(ll);
+            indices.push_back(ll + 1);
+            indices.push_back(ul);
+            indices.push_back(ul);
+            indices.push_back(ll + 1);
+            indices.push_back(ul + 1);
+        }
+    }
+
+    /* With ping-pong, the first frame captures from the flat grid too */
+    glGenBuffers(2, p.captured);
+    for (unsigned int i = 0; i < 2; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, p.captured[i]);
+        glBufferData(GL_ARRAY_BUFFER, grid.size() * sizeof(CapturedVertex),
+                     p.ping_pong ? &grid[0] : 0, GL_DYNAMIC_DRAW);
+    }
+
+    if (!p.ping_pong) {
+        glGenBuffers(1, &p.grid_buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, p.grid_buffer);
+        glBufferData(GL_ARRAY_BUFFER, grid.size() * sizeof(CapturedVertex),
+                     &grid[0], GL_STATIC_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glGenBuffers(1, &p.index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p.index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+                 &indices[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    p.capture_program.start();
+    p.capture_program["WaveNumber"] = static_cast<float>(2.0 * M_PI / length);
+    p.capture_program["WaveVelocity"] = 0.1f * length;
+    p.current = 0;
+
+    glDisable(GL_CULL_FACE);
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneTransformFeedback::teardown()
+{
+    glEnable(GL_CULL_FACE);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneTransformFeedback::update()
+{
+    Scene::update();
+}
+
+/*
+ * Displaces the grid in a first pass whose vertices are captured with
+ * transform feedback, then draws the captured vertices. Unlike the buffer
+ * scene, the vertex data never leave the GPU.
+ */
+void
+SceneTransformFeedback::draw()
+{
+    SceneTransformFeedbackPrivate &p(*priv_);
+    LibMatrix::Stack4 model_view;
+
+    LibMatrix::mat4 model_view_proj(canvas_.projection());
+    model_view.translate(0.0, 0.0, -4.0);
+    model_view.rotate(45.0, -1.0, 0.0, 0.0);
+    model_view_proj *= model_view.getCurrent();
+
+    /* With ping-pong, capture from the vertices of the last frame */
+    GLuint source = p.ping_pong ? p.captured[p.current] : p.grid_buffer;
+    GLuint target = p.captured[p.ping_pong ? 1 - p.current : 0];
+
+    /* Capture */
+    p.capture_program.start();
+    p.capture_program["ModelViewProjectionMatrix"] = model_view_proj;
+    p.capture_program["Time"] = static_cast<float>(animation_time());
+
+    GLint capture_location = p.capture_program["position"].location();
+
+    glBindBuffer(GL_ARRAY_BUFFER, source);
+    glEnableVertexAttribArray(capture_location);
+    glVertexAttribPointer(capture_location, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(CapturedVertex), 0);
+
+    if (p.rasterizer_discard)
+        glEnable(GL_RASTERIZER_DISCARD);
+
+    GLExtensions::BindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, target);
+    GLExtensions::BeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, p.vertices);
+    GLExtensions::EndTransformFeedback();
+    GLExtensions::BindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+
+    if (p.rasterizer_discard)
+        glDisable(GL_RASTERIZER_DISCARD);
+
+    glDisableVertexAttribArray(capture_location);
+
+    /* Draw */
+    p.render_program.start();
+    p.render_program["ModelViewProjectionMatrix"] = model_view_proj;
+
+    GLint position_location = p.render_program["position"].location();
+    GLint normal_location = p.render_program["normal"].location();
+
+    glBindBuffer(GL_ARRAY_BUFFER, target);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(CapturedVertex), 0);
+    glEnableVertexAttribArray(normal_location);
+    glVertexAttribPointer(normal_location, 3, GL_FLOAT, GL_FALSE,
+                          sizeof(CapturedVertex),
+                          reinterpret_cast<const void *>(3 * sizeof(float)));
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, p.index_buffer);
+    glDrawElements(GL_TRIANGLES, p.indices, GL_UNSIGNED_INT, 0);
+
+    glDisableVertexAttribArray(normal_location);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (p.ping_pong)
+        p.current = 1 - p.current;
+}
+
+Scene::ValidationResult
+SceneTransformFeedback::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneTransformFeedback::rates()
+{
+    double elapsed = elapsed_time();
+    double vertices = static_cast<double>(priv_->vertices) * frame_count();
+    std::vector<Rate> rates;
+
+    rates.push_back(Rate("VerticesPerSecond", "vertices_per_second",
+                         elapsed > 0.0 ? vertices / elapsed : 0.0));
+    rates.push_back(Rate("CapturedMiBPerSecond", "captured_mib_per_second",
+                         elapsed > 0.0 ?
+                         vertices * sizeof(CapturedVertex) / (1024.0 * 1024.0) / elapsed :
+                         0.0));
+
+    return rates;
+}
@@ -0,0 +1,342 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <cmath>
+#include <stdint.h>
+
+struct SceneTriangleSizePrivate {
+    enum Primitive {
+        PrimitiveTriangles,
+        PrimitiveLines,
+        PrimitivePoints
+    };
+
+    SceneTriangleSizePrivate() :
+        primitive(PrimitiveTriangles), size(0), layers(0), width(0), height(0),
+        vertices(0), primitives(0), buffer(0) {}
+
+    Primitive primitive;
+    unsigned int size;
+    unsigned int layers;
+    int width;
+    int height;
+
+    Program program;
+    GLsizei vertices;
+    /* The primitives drawn for each layer */
+    uint64_t primitives;
+    GLuint buffer;
+
+    void release()
+    {
+        if (buffer) {
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+
+    GLenum mode() const
+    {
+        if (primitive == PrimitiveLines)
+            return GL_LINES;
+        if (primitive == PrimitivePoints)
+            return GL_POINTS;
+        return GL_TRIANGLES;
+    }
+
+    /* The color of a layer, so that consecutive layers are told apart */
+    static void layer_color(unsigned int layer, unsigned int layers, float color[4])
+    {
+        float hue = static_cast<float>(layer) / layers;
+
+        color[0] = 0.5f + 0.5f * std::cos(6.2832f * hue);
+        color[1] = 0.5f + 0.5f * std::cos(6.2832f * (hue + 0.33f));
+        color[2] = 0.5f + 0.5f * std::cos(6.2832f * (hue + 0.67f));
+        color[3] = 1.0f;
+    }
+};
+
+SceneTriangleSize::SceneTriangleSize(Canvas &pCanvas) :
+    Scene(pCanvas, "triangle-size")
+{
+    priv_ = new SceneTriangleSizePrivate();
+    options_["size"] = Scene::Option("size", "8",
+                                     "The size of the cells the screen is divided into, in pixels:"
+                                     " two triangles, one line per pixel row or one point per cell"
+                                     " (the canvas size or more for full-screen triangles)");
+    options_["primitive"] = Scene::Option("primitive", "triangles",
+                                          "The primitives that cover the screen",
+                                          "triangles,lines,points");
+    options_["layers"] = Scene::Option("layers", "1",
+                                       "The number of times the screen is covered every frame");
+}
+
+SceneTriangleSize::~SceneTriangleSize()
+{
+    delete priv_;
+}
+
+bool
+SceneTriangleSize::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneTriangleSize::unload()
+{
+}
+
+bool
+SceneTriangleSize::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/triangle-size.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/triangle-size.frag");
+
+    SceneTriangleSizePrivate &p(*priv_);
+
+    /* Parse the options */
+    p.size = Util::fromString<unsigned int>(options_["size"].value);
+    p.layers = Util::fromString<unsigned int>(options_["layers"].value);
+    p.width = canvas_.width();
+    p.height = canvas_.height();
+
+    if (p.size == 0 || p.layers == 0) {
+        Log::error("The size and layers options must be at least 1\n");
+        return false;
+    }
+
+    const std::string &primitive = options_["primitive"].value;
+    if (primitive == "lines")
+        p.primitive = SceneTriangleSizePrivate::PrimitiveLines;
+    else if (primitive == "points")
+        p.primitive = SceneTriangleSizePrivate::PrimitivePoints;
+    else
+        p.primitive = SceneTriangleSizePrivate::PrimitiveTriangles;
+
+    if (p.primitive == SceneTriangleSizePrivate::PrimitivePoints) {
+        GLfloat range[2] = { 0.0f, 0.0f };
+        glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, range);
+        if (p.size > range[1]) {
+            Log::error("The point size %u is larger than the maximum %.1f\n",
+                       p.size, range[1]);
+            return false;
+        }
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    /*
+     * Divide the screen into size x size cells, in pixels, and cover each
+     * cell with its primitives. Lines are one pixel wide, so a cell needs
+     * one line along the center of each of its pixel rows. The cells at
+     * the edges extend past the screen, where they are clipped.
+     */
+    unsigned int cols = (p.width + p.size - 1) / p.size;
+    unsigned int rows = (p.height + p.size - 1) / p.size;
+    float sx = 2.0f / p.width;
+    float sy = 2.0f / p.height;
+    float size = static_cast<float>(p.size);
+    std::vector<float> data;
+
+    if (p.primitive == SceneTriangleSizePrivate::PrimitiveTriangles)
+        data.reserve(static_cast<size_t>(cols) * rows * 12);
+    else if (p.primitive == SceneTriangleSizePrivate::PrimitiveLines)
+        data.reserve(static_cast<size_t>(cols) * rows * p.size * 4);
+    else
+        data.reserve(static_cast<size_t>(cols) * rows * 2);
+
+    for (unsigned int r = 0; r < rows; r++) {
+        float y0 = r * size * sy - 1.0f;
+        float y1 = (r + 1) * size * sy - 1.0f;
+
+        for (unsigned int c = 0; c < cols; c++) {
+            float x0 = c * size * sx - 1.0f;
+            float x1 = (c + 1) * size * sx - 1.0f;
+
+            if (p.primitive == SceneTriangleSizePrivate::PrimitiveTriangles) {
+                const float cell[] = {
+                    x0, y0, x1, y0, x0, y1,
+                    x1, y0, x1, y1, x0, y1
+                };
+                data.insert(data.end(), cell, cell + 12);
+            }
+            else if (p.primitive == SceneTriangleSizePrivate::PrimitiveLines) {
+                for (unsigned int i = 0; i < p.size; i++) {
+                    float y = (r * size + i + 0.5f) * sy - 1.0f;
+                    const float line[] = { x0, y, x1, y };
+                    data.insert(data.end(), line, line + 4);
+                }
+            }
+            else {
+                data.push_back((x0 + x1) / 2.0f);
+                data.push_back((y0 + y1) / 2.0f);
+            }
+        }
+    }
+
+    p.vertices = data.size() / 2;
+    if (p.primitive == SceneTriangleSizePrivate::PrimitiveTriangles)
+        p.primitives = p.vertices / 3;
+    else if (p.primitive == SceneTriangleSizePrivate::PrimitiveLines)
+        p.primitives = p.vertices / 2;
+    else
+        p.primitives = p.vertices;
+
+    Log::debug("SceneTriangleSize: %u x %u cells, %llu primitives per layer\n",
+               cols, rows, static_cast<unsigned long long>(p.primitives));
+
+    glGenBuffers(1, &p.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, p.buffer);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(float), &data[0],
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    p.program.start();
+    p.program["PointSize"] = size;
+
+    /* Every layer covers the screen, without depth test or blending */
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+#if !GLMARK2_USE_GLESv2
+    glEnable(GL_PROGRAM_POINT_SIZE);
+#endif
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneTriangleSize::teardown()
+{
+#if !GLMARK2_USE_GLESv2
+    glDisable(GL_PROGRAM_POINT_SIZE);
+#endif
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneTriangleSize::update()
+{
+    Scene::update();
+}
+
+void
+SceneTriangleSize::draw()
+{
+    SceneTriangleSizePrivate &p(*priv_);
+
+    GLint position_location = p.program["position"].location();
+    GLint color_location = p.program["LayerColor"].location();
+
+    p.program.start();
+
+    glBindBuffer(GL_ARRAY_BUFFER, p.buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    for (unsigned int i = 0; i < p.layers; i++) {
+        float color[4];
+        SceneTriangleSizePrivate::layer_color(i, p.layers, color);
+        glUniform4fv(color_location, 1, color);
+        glDrawArrays(p.mode(), 0, p.vertices);
+    }
+
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/*
+ * Triangles sharing an edge neither leave gaps nor overlap, so the whole
+ * screen has the color of the last layer. Lines and points have no such
+ * guarantee.
+ */
+Scene::ValidationResult
+SceneTriangleSize::validate()
+{
+    static const double radius_3d(std::sqrt(3.0));
+    SceneTriangleSizePrivate &p(*priv_);
+
+    if (p.primitive != SceneTriangleSizePrivate::PrimitiveTriangles)
+        return Scene::ValidationUnknown;
+
+    float color[4];
+    SceneTriangleSizePrivate::layer_color(p.layers - 1, p.layers, color);
+    Canvas::Pixel ref(static_cast<uint8_t>(color[0] * 255.0f + 0.5f),
+                      static_cast<uint8_t>(color[1] * 255.0f + 0.5f),
+                      static_cast<uint8_t>(color[2] * 255.0f + 0.5f),
+                      0xff);
+
+    /* Check a pixel at the corner of a cell, where most triangles meet */
+    unsigned int x = (canvas_.width() / 2) / p.size * p.size;
+    unsigned int y = (canvas_.height() / 2) / p.size * p.size;
+    Canvas::Pixel pixel = canvas_.read_pixel(x, y);
+
+    double dist = pixel.distance_rgb(ref);
+
+    if (dist < radius_3d + 0.01) {
+        return Scene::ValidationSuccess;
+    }
+    else {
+        Log::debug("Validation failed! Expected: 0x%x Actual: 0x%x Distance: %f\n",
+                    ref.to_le32(), pixel.to_le32(), dist);
+        return Scene::ValidationFailure;
+    }
+}
+
+std::vector<Scene::Rate>
+SceneTriangleSize::rates()
+{
+    double elapsed = elapsed_time();
+    double primitives = static_cast<double>(priv_->layers) *
+                        priv_->primitives * frame_count();
+
+    return std::vector<Rate>(1, Rate("PrimitivesPerSecond", "primitives_per_second",
+                                     elapsed > 0.0 ? primitives / elapsed : 0.0));
+}
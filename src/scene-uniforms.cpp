@@ -0,0 +1,570 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+struct SceneUniformsPrivate {
+    /*
+     * The parameters of an object, laid out like the ObjectParams of the
+     * shaders in both std140 and std430.
+     */
+    struct ObjectParams {
+        /* Column-major */
+        float transform[16];
+        float material_color[4];
+        float material_params[4];
+    };
+
+    enum Method {
+        MethodUniform,
+        MethodUBORange,
+        MethodUBOInstanced,
+        MethodSSBOInstanced,
+        MethodUBORing
+    };
+
+    /* The size of the parameters of an object */
+    static const GLsizeiptr block_size = sizeof(ObjectParams);
+    /* The frames in flight of the ring buffer */
+    static const unsigned int ring_segments = 3;
+
+    SceneUniformsPrivate() :
+        method(MethodUniform), objects(0), side(0), transform_location(-1),
+        material_color_location(-1), material_params_location(-1), buffer(0),
+        stride(0), chunk(0), ring(0), ring_segment(0)
+    {
+        for (unsigned int i = 0; i < ring_segments; i++)
+            ring_fences[i] = 0;
+    }
+
+    Method method;
+    unsigned int objects;
+    /* The objects are laid out in a side x side grid */
+    unsigned int side;
+
+    Program program;
+    Mesh mesh;
+
+    /* The parameters of the objects, updated every frame */
+    std::vector<ObjectParams> params;
+
+    /* The uniform locations, for the uniform method */
+    GLint transform_location;
+    GLint material_color_location;
+    GLint material_params_location;
+
+    /*
+     * The buffer holding the parameters, one block every stride bytes for
+     * the UBO methods, and chunk blocks per instanced draw for ubo-instanced.
+     */
+    GLuint buffer;
+    GLintptr stride;
+    unsigned int chunk;
+    /* The staging copy of the buffer contents */
+    std::vector<unsigned char> staging;
+
+    /* The persistent mapping of the buffer, for the ring method */
+    unsigned char *ring;
+    unsigned int ring_segment;
+    GLsync ring_fences[ring_segments];
+
+    FrameStats submit_stats;
+
+    void release()
+    {
+        for (unsigned int i = 0; i < ring_segments; i++) {
+            if (ring_fences[i]) {
+                GLExtensions::DeleteSync(ring_fences[i]);
+                ring_fences[i] = 0;
+            }
+        }
+
+        if (ring) {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            GLExtensions::UnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            ring = 0;
+        }
+
+        if (buffer) {
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+        mesh.reset();
+        params.clear();
+        staging.clear();
+    }
+
+    /* The size of the uniform blocks of the methods that bind a block per draw */
+    GLintptr block_stride(GLenum alignment_pname)
+    {
+        GLint alignment = 0;
+        glGetIntegerv(alignment_pname, &alignment);
+        GLintptr a = std::max<GLint>(alignment, 1);
+
+        return (block_size + a - 1) / a * a;
+    }
+
+    /* Copies the parameters into a buffer with the blocks stride bytes apart */
+    void copy_params(unsigned char *dst)
+    {
+        for (unsigned int i = 0; i < objects; i++)
+            std::memcpy(dst + i * stride, &params[i], block_size);
+    }
+};
+
+SceneUniforms::SceneUniforms(Canvas &pCanvas) :
+    Scene(pCanvas, "uniforms")
+{
+    priv_ = new SceneUniformsPrivate();
+    options_["objects"] = Scene::Option("objects", "4096",
+                                        "The number of objects, each with its own transform and material");
+    options_["method"] = Scene::Option("method", "uniform",
+                                       "How the parameters of the objects are uploaded: glUniform* calls per draw,"
+                                       " a uniform buffer with a range bound per draw, a uniform buffer or shader"
+                                       " storage buffer indexed by instance in instanced draws, or a ring of"
+                                       " persistently mapped uniform buffers with a range bound per draw",
+                                       "uniform,ubo-range,ubo-instanced,ssbo-instanced,ubo-ring");
+}
+
+SceneUniforms::~SceneUniforms()
+{
+    delete priv_;
+}
+
+bool
+SceneUniforms::supported(bool show_errors)
+{
+    const std::string &method = options_["method"].value;
+
+    if (method != "uniform" && method != "ssbo-instanced" &&
+        (GLExtensions::BindBufferRange == 0 || GLExtensions::UniformBlockBinding == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested %s method but uniform buffer objects"
+                       " are not supported!\n", method.c_str());
+        }
+        return false;
+    }
+
+    if ((method == "ubo-instanced" || method == "ssbo-instanced") &&
+        (GLExtensions::DrawArraysInstanced == 0 || GLExtensions::DrawElementsInstanced == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested %s method but instanced draws"
+                       " are not supported!\n", method.c_str());
+        }
+        return false;
+    }
+
+    if (method == "ssbo-instanced") {
+        GLint max_blocks = 0;
+        if (GLExtensions::BindBufferBase && GLExtensions::DispatchCompute)
+            glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &max_blocks);
+
+        if (max_blocks < 1) {
+            if (show_errors) {
+                Log::error("Requested ssbo-instanced method but shader storage buffers"
+                           " in vertex shaders are not supported (GL 4.3 or GLES 3.1)!\n");
+            }
+            return false;
+        }
+    }
+
+    if (method == "ubo-ring" &&
+        (GLExtensions::BufferStorage == 0 || GLExtensions::MapBufferRange == 0 ||
+         GLExtensions::UnmapBuffer == 0 || GLExtensions::FenceSync == 0 ||
+         GLExtensions::DeleteSync == 0 || GLExtensions::ClientWaitSync == 0))
+    {
+        if (show_errors) {
+            Log::error("Requested ubo-ring method but GL_ARB_buffer_storage"
+                       " is not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneUniforms::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneUniforms::unload()
+{
+}
+
+bool
+SceneUniforms::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/uniforms.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/uniforms.frag");
+
+    SceneUniformsPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.objects = Util::fromString<unsigned int>(options_["objects"].value);
+    if (p.objects == 0) {
+        Log::error("The number of objects must be at least 1\n");
+        return false;
+    }
+
+    const std::string &method = options_["method"].value;
+    if (method == "ubo-range")
+        p.method = SceneUniformsPrivate::MethodUBORange;
+    else if (method == "ubo-instanced")
+        p.method = SceneUniformsPrivate::MethodUBOInstanced;
+    else if (method == "ssbo-instanced")
+        p.method = SceneUniformsPrivate::MethodSSBOInstanced;
+    else if (method == "ubo-ring")
+        p.method = SceneUniformsPrivate::MethodUBORing;
+    else
+        p.method = SceneUniformsPrivate::MethodUniform;
+
+    p.side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(p.objects))));
+    p.params.resize(p.objects);
+
+    /*
+     * The instanced draws of ubo-instanced each read a range of as many
+     * blocks as fit in a uniform block, starting at an aligned offset.
+     */
+    if (p.method == SceneUniformsPrivate::MethodUBOInstanced) {
+        GLint max_block_size = 0;
+        GLint alignment = 0;
+        glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &max_block_size);
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        alignment = std::max(alignment, 1);
+
+        p.chunk = std::min<unsigned int>(p.objects, max_block_size / SceneUniformsPrivate::block_size);
+        while (p.chunk > 1 && (p.chunk * SceneUniformsPrivate::block_size) % alignment != 0)
+            p.chunk--;
+        if (p.chunk == 0) {
+            Log::error("The uniform blocks are too small for the parameters of an object\n");
+            return false;
+        }
+    }
+
+    /* Create the program */
+    ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+    std::string version(p.method == SceneUniformsPrivate::MethodSSBOInstanced ?
+                        Scene::compute_shader_version() : Scene::glsl3_shader_version());
+    vtx_source.append(version);
+    frg_source.append(version);
+
+    switch (p.method) {
+        case SceneUniformsPrivate::MethodUBORange:
+        case SceneUniformsPrivate::MethodUBORing:
+            vtx_source.append("#define UBO\n");
+            break;
+        case SceneUniformsPrivate::MethodUBOInstanced:
+            vtx_source.append("#define INSTANCED_UBO\n");
+            vtx_source.append("#define ObjectCount " + Util::toString(p.chunk) + "\n");
+            break;
+        case SceneUniformsPrivate::MethodSSBOInstanced:
+            vtx_source.append("#define INSTANCED_SSBO\n");
+            break;
+        case SceneUniformsPrivate::MethodUniform:
+            break;
+    }
+
+    vtx_source.append_file(vtx_shader_filename);
+    frg_source.append_file(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.program.start();
+
+    switch (p.method) {
+        case SceneUniformsPrivate::MethodUniform:
+            p.transform_location = p.program["Transform"].location();
+            p.material_color_location = p.program["MaterialColor"].location();
+            p.material_params_location = p.program["MaterialParams"].location();
+            break;
+        case SceneUniformsPrivate::MethodUBORange:
+        case SceneUniformsPrivate::MethodUBORing:
+            p.program.bindUniformBlock("ObjectParams", 0);
+            break;
+        case SceneUniformsPrivate::MethodUBOInstanced:
+            p.program.bindUniformBlock("Objects", 0);
+            break;
+        case SceneUniformsPrivate::MethodSSBOInstanced:
+            break;
+    }
+
+    /* Create the buffer holding the parameters */
+    GLenum target = p.method == SceneUniformsPrivate::MethodSSBOInstanced ?
+                    GL_SHADER_STORAGE_BUFFER : GL_UNIFORM_BUFFER;
+
+    if (p.method == SceneUniformsPrivate::MethodUBORange ||
+        p.method == SceneUniformsPrivate::MethodUBORing)
+    {
+        p.stride = p.block_stride(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT);
+    }
+    else {
+        p.stride = SceneUniformsPrivate::block_size;
+    }
+
+    if (p.method != SceneUniformsPrivate::MethodUniform) {
+        /* The last instanced draw of ubo-instanced binds a full chunk too */
+        size_t size = p.objects * p.stride;
+        if (p.method == SceneUniformsPrivate::MethodUBOInstanced)
+            size = (p.objects + p.chunk - 1) / p.chunk * p.chunk * p.stride;
+
+        glGenBuffers(1, &p.buffer);
+        glBindBuffer(target, p.buffer);
+
+        if (p.method == SceneUniformsPrivate::MethodUBORing) {
+            static const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                                            GL_MAP_COHERENT_BIT;
+            size_t ring_size = size * SceneUniformsPrivate::ring_segments;
+
+            GLExtensions::BufferStorage(target, ring_size, 0, flags);
+            p.ring = static_cast<unsigned char *>(
+                GLExtensions::MapBufferRange(target, 0, ring_size, flags));
+            if (!p.ring) {
+                Log::error("Failed to map persistent uniform buffer\n");
+                glBindBuffer(target, 0);
+                return false;
+            }
+        }
+        else {
+            p.staging.resize(size);
+            glBufferData(target, size, 0, GL_DYNAMIC_DRAW);
+        }
+
+        glBindBuffer(target, 0);
+    }
+
+    if (p.method == SceneUniformsPrivate::MethodSSBOInstanced)
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, p.buffer);
+
+    /* Create the quad drawn for each object */
+    std::vector<int> vertex_format;
+    vertex_format.push_back(3);
+
+    std::vector<GLint> attrib_locations;
+    attrib_locations.push_back(p.program["position"].location());
+
+    p.mesh.set_vertex_format(vertex_format);
+    p.mesh.make_grid(1, 1, 2.0, 2.0, 0.0);
+    p.mesh.build_vbo();
+    p.mesh.set_attrib_locations(attrib_locations);
+
+    p.submit_stats.reset();
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneUniforms::teardown()
+{
+    if (priv_->method == SceneUniformsPrivate::MethodSSBOInstanced)
+        GLExtensions::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, 0);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+/*
+ * Spins each object in its grid cell and pulses its material, so that all
+ * the parameters change every frame, like the transforms and materials of
+ * the objects of a game.
+ */
+void
+SceneUniforms::update()
+{
+    Scene::update();
+
+    SceneUniformsPrivate &p(*priv_);
+    float t = static_cast<float>(animation_time());
+    float cell = 2.0f / p.side;
+
+    for (unsigned int i = 0; i < p.objects; i++) {
+        SceneUniformsPrivate::ObjectParams &o(p.params[i]);
+        float phase = static_cast<float>(i) / p.objects;
+        float angle = t * (1.0f + phase) + 6.2832f * phase;
+        float scale = 0.35f * cell;
+        float c = scale * std::cos(angle);
+        float s = scale * std::sin(angle);
+
+        std::fill(o.transform, o.transform + 16, 0.0f);
+        o.transform[0] = c;
+        o.transform[1] = s;
+        o.transform[4] = -s;
+        o.transform[5] = c;
+        o.transform[10] = 1.0f;
+        o.transform[12] = -1.0f + cell * (i % p.side + 0.5f);
+        o.transform[13] = 1.0f - cell * (i / p.side + 0.5f);
+        o.transform[15] = 1.0f;
+
+        o.material_color[0] = 0.5f + 0.5f * std::cos(6.2832f * phase);
+        o.material_color[1] = 0.5f + 0.5f * std::cos(6.2832f * (phase + 0.33f));
+        o.material_color[2] = 0.5f + 0.5f * std::cos(6.2832f * (phase + 0.67f));
+        o.material_color[3] = 1.0f;
+
+        o.material_params[0] = 0.75f + 0.25f * std::sin(2.0f * t + 6.2832f * phase);
+        o.material_params[1] = 0.4f;
+        o.material_params[2] = 0.0f;
+        o.material_params[3] = 0.0f;
+    }
+}
+
+/*
+ * Uploads the parameters of the objects and draws them with the selected
+ * method. Only the upload and the draws are timed, not the update of the
+ * parameters, which is the same for all the methods.
+ */
+void
+SceneUniforms::draw()
+{
+    SceneUniformsPrivate &p(*priv_);
+    uint64_t start = Util::get_timestamp_us();
+
+    switch (p.method) {
+        case SceneUniformsPrivate::MethodUniform:
+            for (unsigned int i = 0; i < p.objects; i++) {
+                const SceneUniformsPrivate::ObjectParams &o(p.params[i]);
+                glUniformMatrix4fv(p.transform_location, 1, GL_FALSE, o.transform);
+                glUniform4fv(p.material_color_location, 1, o.material_color);
+                glUniform4fv(p.material_params_location, 1, o.material_params);
+                p.mesh.render_vbo();
+            }
+            break;
+
+        case SceneUniformsPrivate::MethodUBORange:
+            p.copy_params(&p.staging[0]);
+            glBindBuffer(GL_UNIFORM_BUFFER, p.buffer);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, p.staging.size(), &p.staging[0]);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+            for (unsigned int i = 0; i < p.objects; i++) {
+                GLExtensions::BindBufferRange(GL_UNIFORM_BUFFER, 0, p.buffer,
+                                              i * p.stride, SceneUniformsPrivate::block_size);
+                p.mesh.render_vbo();
+            }
+            break;
+
+        case SceneUniformsPrivate::MethodUBOInstanced:
+            p.copy_params(&p.staging[0]);
+            glBindBuffer(GL_UNIFORM_BUFFER, p.buffer);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, p.objects * p.stride, &p.staging[0]);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+            for (unsigned int first = 0; first < p.objects; first += p.chunk) {
+                GLExtensions::BindBufferRange(GL_UNIFORM_BUFFER, 0, p.buffer,
+                                              first * p.stride, p.chunk * p.stride);
+                p.mesh.render_vbo_instanced(std::min(p.chunk, p.objects - first));
+            }
+            break;
+
+        case SceneUniformsPrivate::MethodSSBOInstanced:
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, p.buffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, p.objects * p.stride, &p.params[0]);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            p.mesh.render_vbo_instanced(p.objects);
+            break;
+
+        case SceneUniformsPrivate::MethodUBORing: {
+            /* Write to the next segment, once the GPU is done with its last frame */
+            p.ring_segment = (p.ring_segment + 1) % SceneUniformsPrivate::ring_segments;
+
+            GLsync &fence(p.ring_fences[p.ring_segment]);
+            if (fence) {
+                GLExtensions::ClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+                GLExtensions::DeleteSync(fence);
+                fence = 0;
+            }
+
+            GLintptr base = p.ring_segment * p.objects * p.stride;
+
+            for (unsigned int i = 0; i < p.objects; i++) {
+                GLintptr offset = base + i * p.stride;
+                std::memcpy(p.ring + offset, &p.params[i], SceneUniformsPrivate::block_size);
+                GLExtensions::BindBufferRange(GL_UNIFORM_BUFFER, 0, p.buffer,
+                                              offset, SceneUniformsPrivate::block_size);
+                p.mesh.render_vbo();
+            }
+
+            fence = GLExtensions::FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            break;
+        }
+    }
+
+    p.submit_stats.add(Util::get_timestamp_us() - start);
+}
+
+Scene::ValidationResult
+SceneUniforms::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneUniforms::measurements()
+{
+    return std::vector<Measurement>(1, Measurement("SubmitTime", "submit_time",
+                                                   priv_->submit_stats));
+}
+
+void
+SceneUniforms::reset_measurements()
+{
+    priv_->submit_stats.reset();
+}
+
+std::vector<Scene::Rate>
+SceneUniforms::rates()
+{
+    double elapsed = elapsed_time();
+    double objects = static_cast<double>(priv_->objects) * frame_count();
+
+    return std::vector<Rate>(1, Rate("ObjectsPerSecond", "objects_per_second",
+                                     elapsed > 0.0 ? objects / elapsed : 0.0));
+}
@@ -0,0 +1,724 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using LibMatrix::vec2;
+
+/*
+ * The scene pans over a virtual texture far larger than the memory given
+ * to it, like a map streaming its imagery. The tiles coming into view are
+ * decoded by a thread and made resident, evicting the least recently
+ * used ones, either as the pages of a sparse texture or as the slots of
+ * a tile cache found through a page table.
+ */
+struct SceneVirtualTexturePrivate {
+    enum TileState {
+        TileAbsent,
+        TileRequested,
+        TileResident
+    };
+
+    struct Tile {
+        Tile() : state(TileAbsent), slot(0), last_used(0) {}
+        TileState state;
+        /* The cache slot of a resident tile */
+        unsigned int slot;
+        /* The last frame in which the tile was in view */
+        unsigned int last_used;
+    };
+
+    /* A tile requested from, and then decoded by, the decode thread */
+    struct TileData {
+        TileData() : index(0), request_time(0) {}
+        unsigned int index;
+        uint64_t request_time;
+        std::vector<unsigned char> pixels;
+    };
+
+    SceneVirtualTexturePrivate() :
+        sparse(false), tile_width(0), tile_height(0), tiles_x(0), tiles_y(0),
+        cache_tiles(0), cache_side(0), uploads_per_frame(0), pan_speed(0.0),
+        frame(0), quad_buffer(0), page_table(0), tile_texture(0),
+        stop(false), uploads(0) {}
+
+    bool sparse;
+    unsigned int tile_width;
+    unsigned int tile_height;
+    /* The size of the virtual texture in tiles, which is the page table size */
+    unsigned int tiles_x;
+    unsigned int tiles_y;
+    unsigned int cache_tiles;
+    /* The number of slots on each side of the tile cache texture */
+    unsigned int cache_side;
+    unsigned int uploads_per_frame;
+    double pan_speed;
+
+    std::vector<Tile> tiles;
+    std::vector<unsigned int> free_slots;
+    unsigned int frame;
+
+    Program program;
+    GLuint quad_buffer;
+    GLuint page_table;
+    /* The sparse virtual texture, or the tile cache */
+    GLuint tile_texture;
+    /* The visible part of the virtual texture, in texels */
+    vec2 view_origin;
+
+    std::thread thread;
+    bool stop;
+    std::mutex mutex;
+    std::condition_variable requests_changed;
+    std::deque<TileData> requests;
+    std::deque<TileData> decoded;
+
+    FrameStats commit_stats;
+    FrameStats decommit_stats;
+    FrameStats latency_stats;
+    unsigned int uploads;
+
+    void decode(TileData &data) const;
+    void run();
+    void make_resident(const TileData &data, unsigned int slot);
+    void evict(unsigned int index);
+    bool find_slot(unsigned int &slot);
+
+    void stop_thread()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        requests_changed.notify_all();
+
+        if (thread.joinable())
+            thread.join();
+    }
+
+    void release()
+    {
+        stop_thread();
+
+        requests.clear();
+        decoded.clear();
+
+        if (sparse && tile_texture) {
+            for (unsigned int i = 0; i < tiles.size(); i++) {
+                if (tiles[i].state == TileResident)
+                    evict(i);
+            }
+        }
+        tiles.clear();
+        free_slots.clear();
+
+        GLuint textures[] = { page_table, tile_texture };
+        for (unsigned int i = 0; i < sizeof(textures) / sizeof(*textures); i++) {
+            if (textures[i])
+                glDeleteTextures(1, &textures[i]);
+        }
+        page_table = 0;
+        tile_texture = 0;
+
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+};
+
+/*
+ * Creates the texels of a tile, standing in for decoding compressed
+ * imagery. The texels follow a pattern continuous across the tiles, with
+ * the tile edges darkened to show the tiles as they stream in.
+ */
+void
+SceneVirtualTexturePrivate::decode(TileData &data) const
+{
+    unsigned int tx = data.index % tiles_x;
+    unsigned int ty = data.index / tiles_x;
+
+    data.pixels.resize(4 * tile_width * tile_height);
+
+    for (unsigned int y = 0; y < tile_height; y++) {
+        for (unsigned int x = 0; x < tile_width; x++) {
+            float fx = (tx * tile_width + x) / 300.0f;
+            float fy = (ty * tile_height + y) / 300.0f;
+            float h = 0.5f + 0.25f * (std::sin(1.7f * fx + std::sin(0.9f * fy)) +
+                                      std::sin(1.3f * fy + std::sin(0.7f * fx)));
+            float shade = (x == 0 || y == 0) ? 0.6f : 1.0f;
+            unsigned char *texel = &data.pixels[4 * (y * tile_width + x)];
+
+            /* Water below the middle height, land above it */
+            if (h < 0.5f) {
+                texel[0] = static_cast<unsigned char>(shade * 40.0f);
+                texel[1] = static_cast<unsigned char>(shade * (60.0f + 120.0f * h));
+                texel[2] = static_cast<unsigned char>(shade * (120.0f + 200.0f * h));
+            }
+            else {
+                texel[0] = static_cast<unsigned char>(shade * (250.0f * h - 60.0f));
+                texel[1] = static_cast<unsigned char>(shade * (200.0f - 80.0f * h));
+                texel[2] = static_cast<unsigned char>(shade * (120.0f * h - 40.0f));
+            }
+            texel[3] = 255;
+        }
+    }
+}
+
+/*
+ * Decodes the requested tiles in order, until asked to stop.
+ */
+void
+SceneVirtualTexturePrivate::run()
+{
+    while (true) {
+        TileData data;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            requests_changed.wait(lock, [this] { return stop || !requests.empty(); });
+            if (stop)
+                break;
+
+            data = requests.front();
+            requests.pop_front();
+        }
+
+        decode(data);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        decoded.push_back(data);
+    }
+}
+
+/*
+ * Makes a decoded tile resident in a cache slot: commits its pages of the
+ * sparse texture, or takes the slot of the tile cache, and points its
+ * page table entry at it.
+ */
+void
+SceneVirtualTexturePrivate::make_resident(const TileData &data, unsigned int slot)
+{
+    unsigned int tx = data.index % tiles_x;
+    unsigned int ty = data.index / tiles_x;
+    unsigned char entry[4] = { 0, 0, 0, 255 };
+    uint64_t start = Util::get_timestamp_us();
+
+    glBindTexture(GL_TEXTURE_2D, tile_texture);
+
+    if (sparse) {
+        GLExtensions::TexPageCommitment(GL_TEXTURE_2D, 0, tx * tile_width, ty * tile_height, 0,
+                                        tile_width, tile_height, 1, GL_TRUE);
+    }
+    else {
+        entry[0] = slot % cache_side;
+        entry[1] = slot / cache_side;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, page_table);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, tx, ty, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, entry);
+
+    commit_stats.add(Util::get_timestamp_us() - start);
+
+    glBindTexture(GL_TEXTURE_2D, tile_texture);
+    if (sparse) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, tx * tile_width, ty * tile_height,
+                        tile_width, tile_height, GL_RGBA, GL_UNSIGNED_BYTE, &data.pixels[0]);
+    }
+    else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, (slot % cache_side) * tile_width,
+                        (slot / cache_side) * tile_height, tile_width, tile_height,
+                        GL_RGBA, GL_UNSIGNED_BYTE, &data.pixels[0]);
+    }
+
+    latency_stats.add(Util::get_timestamp_us() - data.request_time);
+    uploads++;
+
+    Tile &tile(tiles[data.index]);
+    tile.state = TileResident;
+    tile.slot = slot;
+}
+
+/*
+ * Evicts a resident tile, decommitting its pages of the sparse texture
+ * and clearing its page table entry.
+ */
+void
+SceneVirtualTexturePrivate::evict(unsigned int index)
+{
+    unsigned int tx = index % tiles_x;
+    unsigned int ty = index / tiles_x;
+    unsigned char entry[4] = { 0, 0, 0, 0 };
+    uint64_t start = Util::get_timestamp_us();
+
+    if (sparse) {
+        glBindTexture(GL_TEXTURE_2D, tile_texture);
+        GLExtensions::TexPageCommitment(GL_TEXTURE_2D, 0, tx * tile_width, ty * tile_height, 0,
+                                        tile_width, tile_height, 1, GL_FALSE);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, page_table);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, tx, ty, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, entry);
+
+    decommit_stats.add(Util::get_timestamp_us() - start);
+
+    Tile &tile(tiles[index]);
+    tile.state = TileAbsent;
+    free_slots.push_back(tile.slot);
+}
+
+/*
+ * Finds a free cache slot, evicting the least recently used tile out of
+ * view if the cache is full.
+ */
+bool
+SceneVirtualTexturePrivate::find_slot(unsigned int &slot)
+{
+    if (free_slots.empty()) {
+        unsigned int lru = tiles.size();
+
+        for (unsigned int i = 0; i < tiles.size(); i++) {
+            if (tiles[i].state == TileResident && tiles[i].last_used != frame &&
+                (lru == tiles.size() || tiles[i].last_used < tiles[lru].last_used))
+            {
+                lru = i;
+            }
+        }
+
+        if (lru == tiles.size())
+            return false;
+
+        evict(lru);
+    }
+
+    slot = free_slots.back();
+    free_slots.pop_back();
+
+    return true;
+}
+
+SceneVirtualTexture::SceneVirtualTexture(Canvas &pCanvas) :
+    Scene(pCanvas, "virtual-texture")
+{
+    priv_ = new SceneVirtualTexturePrivate();
+    options_["mode"] = Scene::Option("mode", "auto",
+                                     "How the tiles are made resident"
+                                     " (sparse: committing the pages of a sparse texture,"
+                                     " page-table: copying them to a tile cache found through a page table,"
+                                     " auto: sparse where supported)",
+                                     "auto,sparse,page-table");
+    options_["virtual-size"] = Scene::Option("virtual-size", "16384",
+                                             "The width and height of the virtual texture in texels");
+    options_["tile-size"] = Scene::Option("tile-size", "128",
+                                          "The width and height of the tiles in texels (the page size is used with sparse textures)");
+    options_["cache-tiles"] = Scene::Option("cache-tiles", "256",
+                                            "The number of tiles that can be resident at once");
+    options_["uploads-per-frame"] = Scene::Option("uploads-per-frame", "8",
+                                                  "The maximum number of decoded tiles made resident every frame");
+    options_["pan-speed"] = Scene::Option("pan-speed", "1024",
+                                          "The speed of the view over the virtual texture in texels per second");
+}
+
+SceneVirtualTexture::~SceneVirtualTexture()
+{
+    delete priv_;
+}
+
+bool
+SceneVirtualTexture::supported(bool show_errors)
+{
+    if (options_["mode"].value == "sparse" && !GLExtensions::TexPageCommitment) {
+        if (show_errors) {
+            Log::error("Requested sparse textures but GL_ARB_sparse_texture or"
+                       " GL_EXT_sparse_texture is not supported!\n");
+        }
+        return false;
+    }
+
+    return true;
+}
+
+bool
+SceneVirtualTexture::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneVirtualTexture::unload()
+{
+}
+
+bool
+SceneVirtualTexture::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/virtual-texture.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/virtual-texture.frag");
+
+    SceneVirtualTexturePrivate &p(*priv_);
+
+    /* Parse the options */
+    const std::string &mode = options_["mode"].value;
+    p.sparse = mode == "sparse" || (mode == "auto" && GLExtensions::TexPageCommitment);
+
+    unsigned int virtual_size = Util::fromString<unsigned int>(options_["virtual-size"].value);
+    unsigned int tile_size = Util::fromString<unsigned int>(options_["tile-size"].value);
+    p.cache_tiles = Util::fromString<unsigned int>(options_["cache-tiles"].value);
+    p.uploads_per_frame = Util::fromString<unsigned int>(options_["uploads-per-frame"].value);
+    p.pan_speed = Util::fromString<double>(options_["pan-speed"].value);
+
+    if (tile_size == 0 || p.uploads_per_frame == 0) {
+        Log::error("The tile size and the uploads per frame must be at least 1\n");
+        return false;
+    }
+
+    p.tile_width = tile_size;
+    p.tile_height = tile_size;
+
+    /* The tiles of a sparse texture are its pages */
+    if (p.sparse) {
+        GLint page_sizes = 0;
+        GLExtensions::GetInternalformativ(GL_TEXTURE_2D, GL_RGBA8,
+                                          GL_NUM_VIRTUAL_PAGE_SIZES_ARB, 1, &page_sizes);
+        if (page_sizes < 1) {
+            Log::error("Sparse textures are not supported for the RGBA8 format\n");
+            return false;
+        }
+
+        GLint page_width = 0;
+        GLint page_height = 0;
+        GLExtensions::GetInternalformativ(GL_TEXTURE_2D, GL_RGBA8,
+                                          GL_VIRTUAL_PAGE_SIZE_X_ARB, 1, &page_width);
+        GLExtensions::GetInternalformativ(GL_TEXTURE_2D, GL_RGBA8,
+                                          GL_VIRTUAL_PAGE_SIZE_Y_ARB, 1, &page_height);
+        p.tile_width = std::max(page_width, 1);
+        p.tile_height = std::max(page_height, 1);
+
+        GLint max_size = 0;
+        glGetIntegerv(GL_MAX_SPARSE_TEXTURE_SIZE_ARB, &max_size);
+        virtual_size = std::min(virtual_size, static_cast<unsigned int>(max_size));
+    }
+
+    p.tiles_x = virtual_size / p.tile_width;
+    p.tiles_y = virtual_size / p.tile_height;
+
+    /*
+     * The cache must hold the tiles in view, with a margin of a tile on
+     * every side that is prefetched.
+     */
+    unsigned int view_tiles_x = (canvas_.width() + p.tile_width - 1) / p.tile_width + 3;
+    unsigned int view_tiles_y = (canvas_.height() + p.tile_height - 1) / p.tile_height + 3;
+
+    if (p.tiles_x < view_tiles_x || p.tiles_y < view_tiles_y) {
+        Log::error("The virtual texture must be larger than the view\n");
+        return false;
+    }
+
+    if (p.cache_tiles < view_tiles_x * view_tiles_y) {
+        Log::error("The cache must hold at least the %u tiles in view\n",
+                   view_tiles_x * view_tiles_y);
+        return false;
+    }
+
+    p.cache_side = static_cast<unsigned int>(std::ceil(std::sqrt(static_cast<double>(p.cache_tiles))));
+
+    GLint max_texture_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+
+    if (!p.sparse &&
+        (p.cache_side > 256 ||
+         p.cache_side * p.tile_width > static_cast<unsigned int>(max_texture_size) ||
+         p.cache_side * p.tile_height > static_cast<unsigned int>(max_texture_size)))
+    {
+        Log::error("The tile cache is too large for a single texture\n");
+        return false;
+    }
+
+    /* Load the program */
+    ShaderSource vtx_source(ShaderSource::ShaderTypeVertex);
+    ShaderSource frg_source(ShaderSource::ShaderTypeFragment);
+
+    vtx_source.append(Scene::glsl3_shader_version());
+    vtx_source.append_file(vtx_shader_filename);
+    frg_source.append(Scene::glsl3_shader_version());
+    if (p.sparse)
+        frg_source.append("#define SPARSE\n");
+    frg_source.append_file(frg_shader_filename);
+    frg_source.add_const("PageTableSize", vec2(p.tiles_x, p.tiles_y));
+    frg_source.add_const("CacheSize", vec2(p.cache_side, p.cache_side));
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    p.program.start();
+    p.program["PageTable"] = 0;
+    p.program["Tiles"] = 1;
+    p.program["ViewSize"] = vec2(static_cast<float>(canvas_.width()) / (p.tiles_x * p.tile_width),
+                                 static_cast<float>(canvas_.height()) / (p.tiles_y * p.tile_height));
+
+    /* Create the full-screen quad, drawn as a triangle strip */
+    p.quad_buffer = FullscreenQuad::create();
+
+    /* Create the page table, with no tile resident */
+    std::vector<unsigned char> entries(4 * p.tiles_x * p.tiles_y, 0);
+
+    glGenTextures(1, &p.page_table);
+    glBindTexture(GL_TEXTURE_2D, p.page_table);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, p.tiles_x, p.tiles_y, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, &entries[0]);
+
+    /* Create the sparse texture, or the tile cache */
+    glGenTextures(1, &p.tile_texture);
+    glBindTexture(GL_TEXTURE_2D, p.tile_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    if (p.sparse) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SPARSE_ARB, GL_TRUE);
+        GLExtensions::TexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8,
+                                   p.tiles_x * p.tile_width, p.tiles_y * p.tile_height);
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, p.cache_side * p.tile_width,
+                     p.cache_side * p.tile_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    p.tiles.assign(p.tiles_x * p.tiles_y, SceneVirtualTexturePrivate::Tile());
+    p.free_slots.clear();
+    for (unsigned int i = p.cache_tiles; i > 0; i--)
+        p.free_slots.push_back(i - 1);
+    p.frame = 0;
+
+    p.commit_stats.reset();
+    p.decommit_stats.reset();
+    p.latency_stats.reset();
+    p.uploads = 0;
+
+    p.stop = false;
+    p.thread = std::thread(&SceneVirtualTexturePrivate::run, priv_);
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneVirtualTexture::teardown()
+{
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+/*
+ * Moves the view around a circle over the virtual texture, at pan-speed
+ * texels per second.
+ */
+void
+SceneVirtualTexture::update()
+{
+    Scene::update();
+
+    SceneVirtualTexturePrivate &p(*priv_);
+    double width = p.tiles_x * p.tile_width;
+    double height = p.tiles_y * p.tile_height;
+    double radius = 0.35 * std::min(width - canvas_.width(), height - canvas_.height());
+    double angle = radius > 0.0 ? p.pan_speed * animation_time() / radius : 0.0;
+
+    p.view_origin = vec2((width - canvas_.width()) / 2.0 + radius * std::cos(angle),
+                         (height - canvas_.height()) / 2.0 + radius * std::sin(angle));
+}
+
+/*
+ * Requests the tiles in view that are not resident, makes the decoded
+ * tiles resident, and draws the view.
+ */
+void
+SceneVirtualTexture::draw()
+{
+    SceneVirtualTexturePrivate &p(*priv_);
+    uint64_t now = Util::get_timestamp_us();
+
+    p.frame++;
+
+    /* Find the tiles in view, with a margin of a tile on every side */
+    int x0 = static_cast<int>(p.view_origin.x()) / static_cast<int>(p.tile_width) - 1;
+    int y0 = static_cast<int>(p.view_origin.y()) / static_cast<int>(p.tile_height) - 1;
+    int x1 = static_cast<int>(p.view_origin.x() + canvas_.width()) / static_cast<int>(p.tile_width) + 1;
+    int y1 = static_cast<int>(p.view_origin.y() + canvas_.height()) / static_cast<int>(p.tile_height) + 1;
+
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, static_cast<int>(p.tiles_x) - 1);
+    y1 = std::min(y1, static_cast<int>(p.tiles_y) - 1);
+
+    std::vector<SceneVirtualTexturePrivate::TileData> decoded;
+
+    {
+        std::lock_guard<std::mutex> lock(p.mutex);
+
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                unsigned int index = y * p.tiles_x + x;
+                SceneVirtualTexturePrivate::Tile &tile(p.tiles[index]);
+
+                tile.last_used = p.frame;
+
+                if (tile.state == SceneVirtualTexturePrivate::TileAbsent) {
+                    SceneVirtualTexturePrivate::TileData request;
+                    request.index = index;
+                    request.request_time = now;
+                    p.requests.push_back(request);
+                    tile.state = SceneVirtualTexturePrivate::TileRequested;
+                }
+            }
+        }
+
+        /* Drop the requests of the tiles that went out of view before being decoded */
+        for (std::deque<SceneVirtualTexturePrivate::TileData>::iterator iter = p.requests.begin();
+             iter != p.requests.end();)
+        {
+            SceneVirtualTexturePrivate::Tile &tile(p.tiles[iter->index]);
+
+            if (tile.last_used != p.frame) {
+                tile.state = SceneVirtualTexturePrivate::TileAbsent;
+                iter = p.requests.erase(iter);
+            }
+            else {
+                iter++;
+            }
+        }
+
+        while (!p.decoded.empty() && decoded.size() < p.uploads_per_frame) {
+            decoded.push_back(p.decoded.front());
+            p.decoded.pop_front();
+        }
+    }
+
+    p.requests_changed.notify_all();
+
+    /* Make the decoded tiles still in view resident */
+    for (std::vector<SceneVirtualTexturePrivate::TileData>::iterator iter = decoded.begin();
+         iter != decoded.end();
+         iter++)
+    {
+        SceneVirtualTexturePrivate::Tile &tile(p.tiles[iter->index]);
+        unsigned int slot;
+
+        if (tile.last_used != p.frame || !p.find_slot(slot)) {
+            tile.state = SceneVirtualTexturePrivate::TileAbsent;
+            continue;
+        }
+
+        p.make_resident(*iter, slot);
+    }
+
+    /* Draw the view */
+    p.program["ViewOrigin"] = vec2(p.view_origin.x() / (p.tiles_x * p.tile_width),
+                                   p.view_origin.y() / (p.tiles_y * p.tile_height));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, p.page_table);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, p.tile_texture);
+    glActiveTexture(GL_TEXTURE0);
+
+    GLint position_location = p.program["position"].location();
+    glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+    glEnableVertexAttribArray(position_location);
+    glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneVirtualTexture::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Measurement>
+SceneVirtualTexture::measurements()
+{
+    std::vector<Measurement> m;
+
+    m.push_back(Measurement("CommitTime", "commit_time", priv_->commit_stats));
+    m.push_back(Measurement("DecommitTime", "decommit_time", priv_->decommit_stats));
+    m.push_back(Measurement("UploadLatency", "upload_latency", priv_->latency_stats));
+
+    return m;
+}
+
+void
+SceneVirtualTexture::reset_measurements()
+{
+    priv_->commit_stats.reset();
+    priv_->decommit_stats.reset();
+    priv_->latency_stats.reset();
+    priv_->uploads = 0;
+}
+
+std::vector<Scene::Rate>
+SceneVirtualTexture::rates()
+{
+    double elapsed = elapsed_time();
+
+    return std::vector<Rate>(1, Rate("TilesPerSecond", "tiles_per_second",
+                                     elapsed > 0.0 ? priv_->uploads / elapsed : 0.0));
+}
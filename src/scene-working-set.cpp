@@ -0,0 +1,378 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "scene.h"
+#include "fullscreen-quad.h"
+#include "log.h"
+#include "options.h"
+#include "shader-source.h"
+#include "util.h"
+#include "gl-headers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+struct SceneWorkingSetPrivate {
+    enum Resource {
+        ResourceTexture,
+        ResourceBuffer
+    };
+
+    /* The vertices of a quad, repeated to fill the buffers */
+    static const unsigned int quad_vertices = 4;
+
+    SceneWorkingSetPrivate() :
+        resource(ResourceTexture), working_set_mib(0), resource_size(0),
+        touched(0), texture_size(0), quad_buffer(0), buffer_texture(0),
+        random(1) {}
+
+    Resource resource;
+    unsigned int working_set_mib;
+    /* The size of each texture or buffer, in bytes */
+    size_t resource_size;
+    unsigned int touched;
+    unsigned int texture_size;
+
+    Program program;
+    std::vector<GLuint> textures;
+    std::vector<GLuint> buffers;
+    GLuint quad_buffer;
+    /* The texture drawn with resource=buffer */
+    GLuint buffer_texture;
+
+    /* The resources drawn in the current frame, the first touched ones */
+    std::vector<unsigned int> order;
+    std::mt19937 random;
+
+    unsigned int count() const
+    {
+        return resource == ResourceTexture ? textures.size() : buffers.size();
+    }
+
+    void release()
+    {
+        if (!textures.empty()) {
+            glDeleteTextures(textures.size(), &textures[0]);
+            textures.clear();
+        }
+        if (!buffers.empty()) {
+            glDeleteBuffers(buffers.size(), &buffers[0]);
+            buffers.clear();
+        }
+        if (quad_buffer) {
+            glDeleteBuffers(1, &quad_buffer);
+            quad_buffer = 0;
+        }
+        if (buffer_texture) {
+            glDeleteTextures(1, &buffer_texture);
+            buffer_texture = 0;
+        }
+
+        program.stop();
+        program.release();
+    }
+
+    GLuint create_texture(unsigned int size, const std::vector<unsigned char> &pixels)
+    {
+        GLuint texture;
+
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+
+        return texture;
+    }
+
+    /*
+     * Allocates the working set, stopping early if the GL runs out of
+     * memory, so the working set that could be allocated is reported.
+     */
+    bool create_resources()
+    {
+        unsigned int wanted = std::max<unsigned int>(
+            1, std::ceil(working_set_mib * 1024.0 * 1024.0 / resource_size));
+        std::vector<unsigned char> data(resource_size);
+
+        /* Random contents, so they can't be compressed */
+        std::mt19937 data_random(2);
+        for (size_t i = 0; i < data.size(); i++)
+            data[i] = data_random();
+
+        while (glGetError() != GL_NO_ERROR);
+
+        if (resource == ResourceBuffer) {
+            /* Each buffer is filled with quads, one of which is drawn */
+            GLfloat *vertices = reinterpret_cast<GLfloat *>(&data[0]);
+            for (size_t i = 0; i + 8 <= resource_size / sizeof(GLfloat); i += 8) {
+                std::copy(FullscreenQuad::positions, FullscreenQuad::positions + 8,
+                          vertices + i);
+            }
+
+            std::vector<unsigned char> white(4, 0xff);
+            buffer_texture = create_texture(1, white);
+        }
+
+        for (unsigned int i = 0; i < wanted; i++) {
+            if (resource == ResourceTexture) {
+                textures.push_back(create_texture(texture_size, data));
+            }
+            else {
+                GLuint buffer;
+                glGenBuffers(1, &buffer);
+                glBindBuffer(GL_ARRAY_BUFFER, buffer);
+                glBufferData(GL_ARRAY_BUFFER, resource_size, &data[0], GL_STATIC_DRAW);
+                buffers.push_back(buffer);
+            }
+
+            if (glGetError() == GL_OUT_OF_MEMORY) {
+                Log::info("Warning: out of memory after allocating %.0f MiB of %u MiB\n",
+                          i * resource_size / (1024.0 * 1024.0), working_set_mib);
+                if (resource == ResourceTexture) {
+                    glDeleteTextures(1, &textures.back());
+                    textures.pop_back();
+                }
+                else {
+                    glDeleteBuffers(1, &buffers.back());
+                    buffers.pop_back();
+                }
+                break;
+            }
+        }
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        order.resize(count());
+        for (unsigned int i = 0; i < order.size(); i++)
+            order[i] = i;
+
+        return count() > 0;
+    }
+
+    /* Picks the resources of the next frame, a random subset of touched ones */
+    void pick()
+    {
+        unsigned int n = std::min<unsigned int>(touched, order.size());
+
+        for (unsigned int i = 0; i < n; i++) {
+            std::uniform_int_distribution<unsigned int> dist(i, order.size() - 1);
+            std::swap(order[i], order[dist(random)]);
+        }
+    }
+};
+
+SceneWorkingSet::SceneWorkingSet(Canvas &pCanvas) :
+    Scene(pCanvas, "working-set")
+{
+    priv_ = new SceneWorkingSetPrivate();
+    options_["working-set"] = Scene::Option("working-set", "64",
+                                            "The total size of the textures or buffers, in MiB (sweep: 16 MiB to 4 GiB)");
+    Util::split("16,64,256,1024,2048,4096", ',',
+                options_["working-set"].sweep_values, Util::SplitModeNormal);
+    options_["resource"] = Scene::Option("resource", "texture",
+                                         "What the working set is made of: RGBA8 textures, or vertex buffers",
+                                         "texture,buffer");
+    options_["texture-size"] = Scene::Option("texture-size", "1024",
+                                             "The width and height of each texture (4 MiB at 1024), also setting the size of each buffer");
+    options_["touched"] = Scene::Option("touched", "8",
+                                        "The number of textures or buffers, picked at random, drawn each frame");
+}
+
+SceneWorkingSet::~SceneWorkingSet()
+{
+    delete priv_;
+}
+
+bool
+SceneWorkingSet::load()
+{
+    running_ = false;
+
+    return true;
+}
+
+void
+SceneWorkingSet::unload()
+{
+}
+
+bool
+SceneWorkingSet::setup()
+{
+    if (!Scene::setup())
+        return false;
+
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/working-set.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/working-set.frag");
+
+    SceneWorkingSetPrivate &p(*priv_);
+
+    /* Parse the options */
+    p.working_set_mib = Util::fromString<unsigned int>(options_["working-set"].value);
+    p.texture_size = Util::fromString<unsigned int>(options_["texture-size"].value);
+    p.touched = Util::fromString<unsigned int>(options_["touched"].value);
+    p.resource = options_["resource"].value == "buffer" ?
+                 SceneWorkingSetPrivate::ResourceBuffer :
+                 SceneWorkingSetPrivate::ResourceTexture;
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+    if (p.texture_size == 0 || p.texture_size > static_cast<unsigned int>(max_size)) {
+        Log::error("Invalid texture-size %u (maximum %d)\n", p.texture_size, max_size);
+        return false;
+    }
+
+    if (p.working_set_mib == 0 || p.touched == 0) {
+        Log::error("The working-set and touched options must be at least 1\n");
+        return false;
+    }
+
+    p.resource_size = static_cast<size_t>(p.texture_size) * p.texture_size * 4;
+
+    /* Load the program */
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(p.program, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        return false;
+    }
+
+    if (p.resource == SceneWorkingSetPrivate::ResourceTexture) {
+        p.quad_buffer = FullscreenQuad::create();
+    }
+
+    if (!p.create_resources()) {
+        Log::error("Could not allocate any of the working set\n");
+        return false;
+    }
+
+    p.program.start();
+    p.program["Texture0"] = 0;
+
+    glDisable(GL_DEPTH_TEST);
+
+    currentFrame_ = 0;
+    running_ = true;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+
+    return true;
+}
+
+void
+SceneWorkingSet::teardown()
+{
+    glEnable(GL_DEPTH_TEST);
+
+    priv_->release();
+
+    Scene::teardown();
+}
+
+void
+SceneWorkingSet::update()
+{
+    Scene::update();
+}
+
+/*
+ * Draws the resources picked for the frame, each to its own cell of a
+ * grid covering the screen, so the fill cost doesn't depend on how many
+ * are touched. Once the working set doesn't fit in the GPU memory, the
+ * driver has to page the picked resources back in, and the FPS drops.
+ */
+void
+SceneWorkingSet::draw()
+{
+    SceneWorkingSetPrivate &p(*priv_);
+    GLint position_location = p.program["position"].location();
+    unsigned int n = std::min<unsigned int>(p.touched, p.count());
+    unsigned int columns = std::ceil(std::sqrt(static_cast<double>(n)));
+    unsigned int rows = (n + columns - 1) / columns;
+
+    p.pick();
+
+    glActiveTexture(GL_TEXTURE0);
+    glEnableVertexAttribArray(position_location);
+    p.program["Scale"] = LibMatrix::vec2(1.0f / columns, 1.0f / rows);
+
+    if (p.resource == SceneWorkingSetPrivate::ResourceTexture) {
+        glBindBuffer(GL_ARRAY_BUFFER, p.quad_buffer);
+        glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, p.buffer_texture);
+    }
+
+    unsigned int quads = p.resource_size / (SceneWorkingSetPrivate::quad_vertices * 2 * sizeof(GLfloat));
+
+    for (unsigned int i = 0; i < n; i++) {
+        unsigned int column = i % columns;
+        unsigned int row = i / columns;
+
+        p.program["Offset"] = LibMatrix::vec2((2.0f * column + 1.0f) / columns - 1.0f,
+                                              (2.0f * row + 1.0f) / rows - 1.0f);
+
+        if (p.resource == SceneWorkingSetPrivate::ResourceTexture) {
+            glBindTexture(GL_TEXTURE_2D, p.textures[p.order[i]]);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, SceneWorkingSetPrivate::quad_vertices);
+        }
+        else {
+            /* A quad from anywhere in the buffer */
+            std::uniform_int_distribution<unsigned int> dist(0, quads - 1);
+            glBindBuffer(GL_ARRAY_BUFFER, p.buffers[p.order[i]]);
+            glVertexAttribPointer(position_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+            glDrawArrays(GL_TRIANGLE_STRIP, dist(p.random) * SceneWorkingSetPrivate::quad_vertices,
+                         SceneWorkingSetPrivate::quad_vertices);
+        }
+    }
+
+    glDisableVertexAttribArray(position_location);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+Scene::ValidationResult
+SceneWorkingSet::validate()
+{
+    return Scene::ValidationUnknown;
+}
+
+std::vector<Scene::Rate>
+SceneWorkingSet::rates()
+{
+    SceneWorkingSetPrivate &p(*priv_);
+    double elapsed = elapsed_time();
+    double mib = p.resource_size / (1024.0 * 1024.0);
+    double touched = static_cast<double>(std::min<unsigned int>(p.touched, p.count())) *
+                     mib * frame_count();
+    std::vector<Rate> rates;
+
+    rates.push_back(Rate("WorkingSetMiB", "working_set_mib", p.count() * mib));
+    rates.push_back(Rate("TouchedMiBPerSecond", "touched_mib_per_second",
+                         elapsed > 0.0 ? touched / elapsed : 0.0));
+
+    return rates;
+}
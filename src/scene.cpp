@@ -25,9 +25,16 @@
 #include "log.h"
 #include "shader-source.h"
 #include "options.h"
+#include "program-cache.h"
 #include "util.h"
+#include "startup-report.h"
+#include "trace.h"
+#include "debug-markers.h"
 #include <sstream>
 #include <algorithm>
+#include <cmath>
+#include <set>
+#include <thread>
 
 using std::stringstream;
 using std::string;
@@ -43,12 +50,28 @@ name(nam), value(val), default_value(val), description(desc), set(false)
 Scene::Scene(Canvas &pCanvas, const string &name) :
     canvas_(pCanvas), name_(name),
     startTime_(0), lastUpdateTime_(0), currentFrame_(0),
-    running_(0), duration_(0), nframes_(0)
+    running_(0), duration_(0), nframes_(0),
+    warming_up_(false), warmup_duration_(0), warmup_frames_(0),
+    damage_fraction_(1.0), pipelined_(false),
+    convergence_(0.0), min_duration_(0.0),
+    batchStartTime_(0), batchFrames_(0), batches_(0), batchMean_(0), batchM2_(0)
 {
     options_["duration"] = Scene::Option("duration", "10.0",
                                          "The duration of each benchmark in seconds");
     options_["nframes"] = Scene::Option("nframes", "",
                                          "The number of frames to render");
+    options_["convergence"] = Scene::Option("convergence", "0.0",
+                                            "Stop once the 95% confidence interval of the mean frame time is"
+                                            " within this fraction of it, e.g. 0.01 (0: run for the whole duration)");
+    options_["min-duration"] = Scene::Option("min-duration", "1.0",
+                                             "The minimum duration in seconds of a run with convergence");
+    options_["warmup-duration"] = Scene::Option("warmup-duration", "0.0",
+                                                "The time in seconds to render before measuring");
+    options_["warmup-frames"] = Scene::Option("warmup-frames", "0",
+                                              "The number of frames to render before measuring");
+    options_["damage-fraction"] = Scene::Option("damage-fraction", "1.0",
+                                                "The fraction of the frame, in the center, that is redrawn"
+                                                " and reported as damaged each frame");
     options_["vertex-precision"] = Scene::Option("vertex-precision",
                                                  "default,default,default,default",
                                                  "The precision values for the vertex shader (\"int,float,sampler2d,samplercube\")");
@@ -63,6 +86,14 @@ Scene::Scene(Canvas &pCanvas, const string &name) :
                                          "The position on screen where to show FPS");
     options_["fps-size"] = Scene::Option("fps-size", "0.03",
                                          "The width of each glyph for the FPS");
+    /* Frame graph options */
+    options_["show-graph"] = Scene::Option("show-graph", "false",
+                                           "Show a live graph of the frame and GPU times of the last 300 frames",
+                                           "false,true");
+    options_["graph-pos"] = Scene::Option("graph-pos", "-0.98,0.55",
+                                          "The position on screen of the lower left corner of the graph");
+    options_["graph-size"] = Scene::Option("graph-size", "0.6,0.4",
+                                           "The size of the graph, whose middle is the frame budget");
     /* Title options */
     options_["title"] = Scene::Option("title", "",
                                       "The scene title to show");
@@ -70,6 +101,12 @@ Scene::Scene(Canvas &pCanvas, const string &name) :
                                       "The position on screen where to show the title");
     options_["title-size"] = Scene::Option("title-size", "0.03",
                                            "The width of each glyph in the title");
+    /* Score options */
+    options_["score-weight"] = Scene::Option("score-weight", "1.0",
+                                             "The weight of the benchmark in the score");
+    options_["score-category"] = Scene::Option("score-category", "",
+                                               "The category of the benchmark in the score"
+                                               " (default: the category of the scene)");
 }
 
 Scene::~Scene()
@@ -99,7 +136,36 @@ Scene::setup()
 {
     duration_ = Util::fromString<double>(options_["duration"].value);
     nframes_ = Util::fromString<unsigned>(options_["nframes"].value);
+    warmup_duration_ = Util::fromString<double>(options_["warmup-duration"].value);
+    warmup_frames_ = Util::fromString<unsigned>(options_["warmup-frames"].value);
+    warming_up_ = warmup_duration_ > 0.0 || warmup_frames_ > 0;
+    damage_fraction_ = Util::fromString<double>(options_["damage-fraction"].value);
+    convergence_ = Util::fromString<double>(options_["convergence"].value);
+    min_duration_ = Util::fromString<double>(options_["min-duration"].value);
 
+    if (damage_fraction_ <= 0.0 || damage_fraction_ > 1.0) {
+        Log::error("The damage-fraction must be greater than 0 and at most 1\n");
+        return false;
+    }
+
+    set_default_precisions();
+
+    currentFrame_ = 0;
+    running_ = false;
+    startTime_ = Util::get_timestamp_us() / 1000000.0;
+    lastUpdateTime_ = startTime_;
+    frame_stats_.reset();
+    batchFrames_ = 0;
+    batches_ = 0;
+    batchMean_ = 0.0;
+    batchM2_ = 0.0;
+
+    return supported(true);
+}
+
+void
+Scene::set_default_precisions()
+{
     ShaderSource::default_precision(
             ShaderSource::Precision(options_["vertex-precision"].value),
             ShaderSource::ShaderTypeVertex
@@ -109,13 +175,6 @@ Scene::setup()
             ShaderSource::Precision(options_["fragment-precision"].value),
             ShaderSource::ShaderTypeFragment
             );
-
-    currentFrame_ = 0;
-    running_ = false;
-    startTime_ = Util::get_timestamp_us() / 1000000.0;
-    lastUpdateTime_ = startTime_;
-
-    return supported(true);
 }
 
 void
@@ -131,11 +190,44 @@ Scene::update()
 
     currentFrame_++;
 
+    /*
+     * Warm-up frames let lazy driver work (e.g. shader recompiles on first
+     * draw and first texture uses) happen before measuring. Once both the
+     * warm-up frames and duration are over, the run starts from scratch.
+     */
+    if (warming_up_) {
+        lastUpdateTime_ = current_time;
+
+        if (currentFrame_ >= warmup_frames_ && elapsed_time >= warmup_duration_) {
+            warming_up_ = false;
+            currentFrame_ = 0;
+            startTime_ = current_time;
+            frame_stats_.reset();
+            reset_measurements();
+            batchFrames_ = 0;
+            batches_ = 0;
+            batchMean_ = 0.0;
+            batchM2_ = 0.0;
+        }
+
+        return;
+    }
+
+    frame_stats_.add(static_cast<uint64_t>((current_time - lastUpdateTime_) * 1000000.0));
+
+    bool converged = convergence_ > 0.0 && update_convergence(current_time);
+
     lastUpdateTime_ = current_time;
 
     if (elapsed_time >= duration_)
         running_ = false;
 
+    if (converged && elapsed_time >= min_duration_) {
+        Log::debug("%s converged after %.2f s and %u frames\n",
+                   name_.c_str(), elapsed_time, currentFrame_);
+        running_ = false;
+    }
+
     if (nframes_ > 0 && currentFrame_ >= nframes_)
         running_ = false;
 }
@@ -145,6 +237,41 @@ Scene::draw()
 {
 }
 
+/*
+ * Consecutive frame times are correlated (e.g. by the driver queuing frames
+ * or the GPU clocks ramping), so the confidence interval of their mean is
+ * estimated from the means of batches of frames ("batch means"), which are
+ * close to independent. Returns whether the interval is narrow enough.
+ */
+bool
+Scene::update_convergence(double current_time)
+{
+    static const double batch_duration = 0.05;
+    static const unsigned int min_batches = 20;
+
+    if (batchFrames_++ == 0)
+        batchStartTime_ = lastUpdateTime_;
+
+    if (current_time - batchStartTime_ < batch_duration)
+        return false;
+
+    /* Welford's running mean and variance of the batch means */
+    double batch_mean = (current_time - batchStartTime_) / batchFrames_;
+    double delta = batch_mean - batchMean_;
+
+    batches_++;
+    batchMean_ += delta / batches_;
+    batchM2_ += delta * (batch_mean - batchMean_);
+    batchFrames_ = 0;
+
+    if (batches_ < min_batches)
+        return false;
+
+    double half_width = 1.96 * std::sqrt(batchM2_ / (batches_ - 1) / batches_);
+
+    return half_width <= convergence_ * batchMean_;
+}
+
 string
 Scene::info_string(const string &title)
 {
@@ -162,6 +289,23 @@ Scene::average_fps()
     return currentFrame_ / elapsed_time;
 }
 
+void
+Scene::skip_time(double seconds)
+{
+    startTime_ += seconds;
+    lastUpdateTime_ += seconds;
+    batchStartTime_ += seconds;
+}
+
+double
+Scene::animation_time()
+{
+    if (Options::fixed_timestep > 0.0)
+        return currentFrame_ * Options::fixed_timestep;
+
+    return lastUpdateTime_ - startTime_;
+}
+
 bool
 Scene::set_option(const string &opt, const string &val)
 {
@@ -252,38 +396,261 @@ Scene::load_shaders_from_strings(Program &program,
                                  const std::string &frg_shader,
                                  const std::string &vtx_shader_filename,
                                  const std::string &frg_shader_filename)
+{
+    std::vector<ProgramSource> programs;
+
+    programs.push_back(ProgramSource(program, vtx_shader, frg_shader,
+                                     vtx_shader_filename, frg_shader_filename));
+
+    return load_programs(programs);
+}
+
+bool
+Scene::load_programs(const std::vector<ProgramSource> &programs)
+{
+    StartupReport::Phase phase("shader-build");
+    Trace::Scope trace("shader-build");
+    bool success = true;
+    uint64_t build_start = Util::get_timestamp_us();
+
+    if (GLExtensions::MaxShaderCompilerThreads)
+        GLExtensions::MaxShaderCompilerThreads(0xFFFFFFFF);
+
+    /* Start all the builds without waiting for them, so they can overlap */
+    for (std::vector<ProgramSource>::const_iterator iter = programs.begin();
+         iter != programs.end();
+         iter++)
+    {
+        Program &program(*iter->program);
+
+        program.init();
+
+        if (ProgramCache::load(program, iter->vtx_shader, iter->frg_shader))
+            continue;
+
+        Log::debug("Loading vertex shader from file %s:\n%s",
+                   iter->vtx_shader_filename.c_str(), iter->vtx_shader.c_str());
+
+        program.addShader(GL_VERTEX_SHADER, iter->vtx_shader, false);
+        if (!program.valid()) {
+            Log::error("Failed to add vertex shader from file %s:\n  %s\n",
+                       iter->vtx_shader_filename.c_str(),
+                       program.errorMessage().c_str());
+            program.release();
+            success = false;
+            continue;
+        }
+
+        Log::debug("Loading fragment shader from file %s:\n%s",
+                   iter->frg_shader_filename.c_str(), iter->frg_shader.c_str());
+
+        program.addShader(GL_FRAGMENT_SHADER, iter->frg_shader, false);
+        if (!program.valid()) {
+            Log::error("Failed to add fragment shader from file %s:\n  %s\n",
+                       iter->frg_shader_filename.c_str(),
+                       program.errorMessage().c_str());
+            program.release();
+            success = false;
+            continue;
+        }
+
+        program.build(false);
+    }
+
+    /*
+     * Finish the builds in the order they complete. Without
+     * GL_KHR_parallel_shader_compile all builds are reported as complete
+     * and are finished in order.
+     */
+    bool pending = true;
+
+    while (pending) {
+        pending = false;
+
+        for (std::vector<ProgramSource>::const_iterator iter = programs.begin();
+             iter != programs.end();
+             iter++)
+        {
+            Program &program(*iter->program);
+
+            if (!program.pending())
+                continue;
+
+            if (!program.complete()) {
+                pending = true;
+                continue;
+            }
+
+            program.finish();
+
+            if (!program.ready()) {
+                Log::error("Failed to build program created from files %s and %s:  %s\n",
+                           iter->vtx_shader_filename.c_str(),
+                           iter->frg_shader_filename.c_str(),
+                           program.errorMessage().c_str());
+                program.release();
+                success = false;
+                continue;
+            }
+
+            ProgramCache::store(program, iter->vtx_shader, iter->frg_shader);
+        }
+
+        if (pending)
+            std::this_thread::yield();
+    }
+
+    /* Name the programs after their shaders in GPU debuggers */
+    for (std::vector<ProgramSource>::const_iterator iter = programs.begin();
+         DebugMarkers::active() && iter != programs.end();
+         iter++)
+    {
+        if (iter->program->ready()) {
+            DebugMarkers::label(GL_PROGRAM, iter->program->handle(),
+                                iter->vtx_shader_filename + " " + iter->frg_shader_filename);
+        }
+    }
+
+    Log::debug("Built %u program(s) in %.3f ms\n",
+               static_cast<unsigned int>(programs.size()),
+               (Util::get_timestamp_us() - build_start) / 1000.0);
+
+    return success;
+}
+
+void
+Scene::precompile_programs(const std::vector<ProgramVariant> &variants)
+{
+    Trace::Scope trace("shader-precompile");
+    std::set<std::pair<std::string, std::string> > unique;
+
+    for (std::vector<ProgramVariant>::const_iterator iter = variants.begin();
+         iter != variants.end();
+         iter++)
+    {
+        unique.insert(std::make_pair(iter->vtx_shader, iter->frg_shader));
+    }
+
+    if (unique.empty())
+        return;
+
+    /* The programs are only built to keep their binaries, and released here */
+    std::vector<Program> programs(unique.size());
+    std::vector<ProgramSource> sources;
+
+    for (std::set<std::pair<std::string, std::string> >::const_iterator iter = unique.begin();
+         iter != unique.end();
+         iter++)
+    {
+        sources.push_back(ProgramSource(programs[sources.size()], iter->first, iter->second,
+                                        "<precompiled>", "<precompiled>"));
+    }
+
+    Log::debug("Precompiling %u program(s)\n", static_cast<unsigned int>(sources.size()));
+
+    load_programs(sources);
+}
+
+bool
+Scene::load_compute_shader_from_string(Program &program,
+                                       const std::string &cmp_shader,
+                                       const std::string &cmp_shader_filename)
 {
     program.init();
 
-    Log::debug("Loading vertex shader from file %s:\n%s",
+    Log::debug("Loading compute shader from file %s:\n%s",
+               cmp_shader_filename.c_str(), cmp_shader.c_str());
+
+    program.addShader(GL_COMPUTE_SHADER, cmp_shader);
+    if (!program.valid()) {
+        Log::error("Failed to add compute shader from file %s:\n  %s\n",
+                   cmp_shader_filename.c_str(),
+                   program.errorMessage().c_str());
+        program.release();
+        return false;
+    }
+
+    program.build();
+    if (!program.ready()) {
+        Log::error("Failed to build program created from file %s:  %s\n",
+                   cmp_shader_filename.c_str(),
+                   program.errorMessage().c_str());
+        program.release();
+        return false;
+    }
+
+    return true;
+}
+
+bool
+Scene::load_transform_feedback_shaders_from_strings(Program &program,
+                                                    const std::string &vtx_shader,
+                                                    const std::string &frg_shader,
+                                                    const std::vector<std::string> &varyings,
+                                                    const std::string &vtx_shader_filename)
+{
+    program.init();
+
+    Log::debug("Loading transform feedback vertex shader from file %s:\n%s",
                vtx_shader_filename.c_str(), vtx_shader.c_str());
 
     program.addShader(GL_VERTEX_SHADER, vtx_shader);
+    if (program.valid())
+        program.addShader(GL_FRAGMENT_SHADER, frg_shader);
     if (!program.valid()) {
-        Log::error("Failed to add vertex shader from file %s:\n  %s\n",
+        Log::error("Failed to add shader from file %s:\n  %s\n",
                    vtx_shader_filename.c_str(),
                    program.errorMessage().c_str());
         program.release();
         return false;
     }
 
-    Log::debug("Loading fragment shader from file %s:\n%s",
-               frg_shader_filename.c_str(), frg_shader.c_str());
+    std::vector<const GLchar *> names;
+    for (size_t i = 0; i < varyings.size(); i++)
+        names.push_back(varyings[i].c_str());
 
-    program.addShader(GL_FRAGMENT_SHADER, frg_shader);
-    if (!program.valid()) {
-        Log::error("Failed to add fragment shader from file %s:\n  %s\n",
-                   frg_shader_filename.c_str(),
+    GLExtensions::TransformFeedbackVaryings(program.handle(), names.size(), names.data(),
+                                            GL_INTERLEAVED_ATTRIBS);
+
+    program.build();
+    if (!program.ready()) {
+        Log::error("Failed to build program created from file %s:  %s\n",
+                   vtx_shader_filename.c_str(),
                    program.errorMessage().c_str());
         program.release();
         return false;
     }
 
+    return true;
+}
+
+bool
+Scene::load_shader_stages_from_strings(Program &program,
+                                       const std::vector<ShaderStage> &stages)
+{
+    program.init();
+
+    for (std::vector<ShaderStage>::const_iterator iter = stages.begin();
+         iter != stages.end();
+         iter++)
+    {
+        Log::debug("Loading shader from file %s:\n%s",
+                   iter->shader_filename.c_str(), iter->source.c_str());
+
+        program.addShader(iter->type, iter->source);
+        if (!program.valid()) {
+            Log::error("Failed to add shader from file %s:\n  %s\n",
+                       iter->shader_filename.c_str(),
+                       program.errorMessage().c_str());
+            program.release();
+            return false;
+        }
+    }
+
     program.build();
     if (!program.ready()) {
-        Log::error("Failed to link program created from files %s and %s:  %s\n",
-                   vtx_shader_filename.c_str(),
-                   frg_shader_filename.c_str(),
+        Log::error("Failed to build program created from file %s:  %s\n",
+                   stages.empty() ? "None" : stages.front().shader_filename.c_str(),
                    program.errorMessage().c_str());
         program.release();
         return false;
@@ -291,3 +658,375 @@ Scene::load_shaders_from_strings(Program &program,
 
     return true;
 }
+
+std::string
+Scene::compute_shader_version()
+{
+#if GLMARK2_USE_GLESv2
+    return "#version 310 es\n";
+#else
+    return "#version 430\n";
+#endif
+}
+
+std::string
+Scene::tessellation_shader_version()
+{
+#if GLMARK2_USE_GLESv2
+    if (GLExtensions::version_supported(3, 2))
+        return "#version 320 es\n";
+
+    return "#version 310 es\n"
+           "#extension GL_EXT_tessellation_shader : enable\n"
+           "#extension GL_EXT_geometry_shader : enable\n";
+#else
+    return "#version 400\n";
+#endif
+}
+
+std::string
+Scene::glsl100_fragment_defines()
+{
+    return "#define varying in\n"
+           "#define texture2D texture\n"
+           "#define gl_FragColor FragColor\n"
+           "out vec4 FragColor;\n";
+}
+
+std::string
+Scene::glsl3_shader_version()
+{
+#if GLMARK2_USE_GLESv2
+    return "#version 300 es\n";
+#else
+    return "#version 140\n";
+#endif
+}
+
+void
+Scene::invalidate_framebuffer(const GLenum *attachments, unsigned int count)
+{
+    if (Options::invalidate && GLExtensions::InvalidateFramebuffer)
+        GLExtensions::InvalidateFramebuffer(GL_FRAMEBUFFER, count, attachments);
+}
+
+void
+DepthPrepass::add_option(std::map<std::string, Scene::Option> &options)
+{
+    options["depth-prepass"] = Scene::Option("depth-prepass", "false",
+                                             "Whether to lay down the depth with a depth-only pass before shading",
+                                             "false,true");
+}
+
+bool
+DepthPrepass::setup(std::map<std::string, Scene::Option> &options)
+{
+    static const std::string vtx_shader_filename(Options::data_path + "/shaders/depth-prepass.vert");
+    static const std::string frg_shader_filename(Options::data_path + "/shaders/depth-prepass.frag");
+
+    enabled_ = (options["depth-prepass"].value == "true");
+    if (!enabled_)
+        return true;
+
+    ShaderSource vtx_source(vtx_shader_filename);
+    ShaderSource frg_source(frg_shader_filename);
+
+    if (!Scene::load_shaders_from_strings(program_, vtx_source.str(),
+                                          frg_source.str()))
+    {
+        Log::error("Failed to set up the depth pre-pass program\n");
+        enabled_ = false;
+        return false;
+    }
+
+    return true;
+}
+
+void
+DepthPrepass::teardown()
+{
+    if (enabled_) {
+        program_.stop();
+        program_.release();
+    }
+    enabled_ = false;
+}
+
+void
+DepthPrepass::begin(Mesh &mesh, const LibMatrix::mat4 &mvp, Program &program,
+                    bool use_vbo)
+{
+    if (!enabled_)
+        return;
+
+    /* The pre-pass only feeds the position, the first attribute */
+    std::vector<int> shading_locations(mesh.attrib_locations());
+    std::vector<int> locations(shading_locations.size(), -1);
+
+    program_.start();
+    program_["ModelViewProjectionMatrix"] = mvp;
+    locations[0] = program_["position"].location();
+    mesh.set_attrib_locations(locations);
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    if (use_vbo)
+        mesh.render_vbo();
+    else
+        mesh.render_array();
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+    /* Shade only the fragments that made it into the depth buffer */
+    glDepthFunc(GL_EQUAL);
+    glDepthMask(GL_FALSE);
+
+    program.start();
+    mesh.set_attrib_locations(shading_locations);
+}
+
+void
+DepthPrepass::end(GLenum depth_func)
+{
+    if (!enabled_)
+        return;
+
+    glDepthFunc(depth_func);
+    glDepthMask(GL_TRUE);
+}
+
+void
+DepthConfig::add_options(std::map<std::string, Scene::Option> &options)
+{
+    options["depth-format"] = Scene::Option("depth-format", "default",
+                                            "The format of the depth buffers of the scene",
+                                            "default,16,24,32f,24s8,32fs8");
+    options["reversed-z"] = Scene::Option("reversed-z", "false",
+                                          "Whether to map the near plane to depth 1.0 and the far plane to 0.0,"
+                                          " in a [0, 1] clip space depth range where glClipControl is available",
+                                          "false,true");
+}
+
+bool
+DepthConfig::supported(std::map<std::string, Scene::Option> &options,
+                       bool target, bool show_errors)
+{
+    const std::string &format(options["depth-format"].value);
+    bool reversed(options["reversed-z"].value == "true");
+    bool ret = true;
+
+#if GLMARK2_USE_GLESv2
+    bool depth_float = GLExtensions::version_supported(3, 0);
+#else
+    bool depth_float = GLExtensions::version_supported(3, 0) ||
+                       GLExtensions::support("GL_ARB_depth_buffer_float");
+#endif
+    /* The packed formats are attached with GL_DEPTH_STENCIL_ATTACHMENT */
+    bool packed = GLExtensions::version_supported(3, 0);
+
+    if ((format == "32f" && !depth_float) ||
+        ((format == "24s8" || format == "32fs8") && !packed))
+    {
+        if (show_errors)
+            Log::error("depth-format=%s requires GL 3.0 or GLES 3.0\n", format.c_str());
+        ret = false;
+    }
+
+    if (target && (format != "default" || reversed) && !GLExtensions::BlitFramebuffer) {
+        if (show_errors)
+            Log::error("depth-format and reversed-z require framebuffer blits (GL 3.0 or GLES 3.0)\n");
+        ret = false;
+    }
+
+    return ret;
+}
+
+bool
+DepthConfig::setup(std::map<std::string, Scene::Option> &options, Canvas *canvas)
+{
+    format_ = options["depth-format"].value;
+    reversed_ = (options["reversed-z"].value == "true");
+    canvas_ = canvas;
+
+    if (reversed_ && !GLExtensions::ClipControl)
+        Log::debug("glClipControl is not available, reversed-z uses the [-1, 1] depth range\n");
+
+    if (!canvas_ || (format_ == "default" && !reversed_))
+        return true;
+
+    GLExtensions::GenRenderbuffers(2, rb_);
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, rb_[0]);
+    GLExtensions::RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8,
+                                      canvas_->width(), canvas_->height());
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, rb_[1]);
+    GLExtensions::RenderbufferStorage(GL_RENDERBUFFER,
+                                      renderbuffer_format(GL_DEPTH_COMPONENT24),
+                                      canvas_->width(), canvas_->height());
+    GLExtensions::BindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    GLExtensions::GenFramebuffers(1, &fbo_);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                                          GL_RENDERBUFFER, rb_[0]);
+    GLExtensions::FramebufferRenderbuffer(GL_FRAMEBUFFER, attachment(),
+                                          GL_RENDERBUFFER, rb_[1]);
+    unsigned int status = GLExtensions::CheckFramebufferStatus(GL_FRAMEBUFFER);
+    GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_->fbo());
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        Log::error("DepthConfig::setup: glCheckFramebufferStatus failed (0x%x)\n", status);
+        return false;
+    }
+
+    return true;
+}
+
+void
+DepthConfig::teardown()
+{
+    if (fbo_) {
+        GLExtensions::DeleteFramebuffers(1, &fbo_);
+        fbo_ = 0;
+    }
+    if (rb_[0]) {
+        GLExtensions::DeleteRenderbuffers(2, rb_);
+        rb_[0] = rb_[1] = 0;
+    }
+    canvas_ = 0;
+}
+
+GLenum
+DepthConfig::attachment() const
+{
+    if (format_ == "24s8" || format_ == "32fs8")
+        return GL_DEPTH_STENCIL_ATTACHMENT;
+    return GL_DEPTH_ATTACHMENT;
+}
+
+//
+// Sized formats need GLES 3.0 (or desktop GL), so GLES 2.0 uses the unsized
+// GL_DEPTH_COMPONENT with the type that has the requested precision.
+//
+void
+DepthConfig::texture_format(GLint &internalFormat, GLenum &format, GLenum &type) const
+{
+#if GLMARK2_USE_GLESv2
+    bool sized = GLExtensions::version_supported(3, 0);
+#else
+    bool sized = true;
+#endif
+
+    internalFormat = GL_DEPTH_COMPONENT;
+    format = GL_DEPTH_COMPONENT;
+    type = GL_UNSIGNED_INT;
+
+    if (format_ == "16") {
+        internalFormat = sized ? GL_DEPTH_COMPONENT16 : GL_DEPTH_COMPONENT;
+        type = GL_UNSIGNED_SHORT;
+    }
+    else if (format_ == "24") {
+        internalFormat = sized ? GL_DEPTH_COMPONENT24 : GL_DEPTH_COMPONENT;
+    }
+    else if (format_ == "32f") {
+        internalFormat = GL_DEPTH_COMPONENT32F;
+        type = GL_FLOAT;
+    }
+    else if (format_ == "24s8") {
+        internalFormat = GL_DEPTH24_STENCIL8;
+        format = GL_DEPTH_STENCIL;
+        type = GL_UNSIGNED_INT_24_8;
+    }
+    else if (format_ == "32fs8") {
+        internalFormat = GL_DEPTH32F_STENCIL8;
+        format = GL_DEPTH_STENCIL;
+        type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV;
+    }
+}
+
+GLenum
+DepthConfig::renderbuffer_format(GLenum fallback) const
+{
+    if (format_ == "16")
+        return GL_DEPTH_COMPONENT16;
+    else if (format_ == "24")
+        return GL_DEPTH_COMPONENT24;
+    else if (format_ == "32f")
+        return GL_DEPTH_COMPONENT32F;
+    else if (format_ == "24s8")
+        return GL_DEPTH24_STENCIL8;
+    else if (format_ == "32fs8")
+        return GL_DEPTH32F_STENCIL8;
+    return fallback;
+}
+
+LibMatrix::mat4
+DepthConfig::perspective(float fovy, float aspect, float zNear, float zFar) const
+{
+    LibMatrix::mat4 m(LibMatrix::Mat4::perspective(fovy, aspect, zNear, zFar));
+
+    if (reversed_ && GLExtensions::ClipControl) {
+        /* Near at 1.0 and far at 0.0 in the [0, 1] range */
+        m[2][2] = zNear / (zFar - zNear);
+        m[2][3] = zFar * zNear / (zFar - zNear);
+    }
+    else if (reversed_) {
+        /* Near at 1.0 and far at -1.0 in the [-1, 1] range */
+        m[2][2] = -m[2][2];
+        m[2][3] = -m[2][3];
+    }
+
+    return m;
+}
+
+void
+DepthConfig::add_sample_consts(ShaderSource &source) const
+{
+    source.add_const("DepthSampleOffset", reversed_ ? 1.0f : 0.0f);
+    source.add_const("DepthSampleScale", reversed_ ? -1.0f : 1.0f);
+}
+
+void
+DepthConfig::begin()
+{
+    if (fbo_)
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, fbo_);
+
+    if (reversed_) {
+        if (GLExtensions::ClipControl)
+            GLExtensions::ClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+#if GLMARK2_USE_GL
+        glClearDepth(0.0f);
+#elif GLMARK2_USE_GLESv2
+        glClearDepthf(0.0f);
+#endif
+        glDepthFunc(GL_GEQUAL);
+    }
+
+    if (fbo_)
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void
+DepthConfig::end()
+{
+    if (fbo_) {
+        /* The depth isn't needed once the frame is rendered */
+        const GLenum attachments[] = { attachment() };
+        Scene::invalidate_framebuffer(attachments, 1);
+        GLExtensions::BindFramebuffer(GL_READ_FRAMEBUFFER, fbo_);
+        GLExtensions::BindFramebuffer(GL_DRAW_FRAMEBUFFER, canvas_->fbo());
+        GLExtensions::BlitFramebuffer(0, 0, canvas_->width(), canvas_->height(),
+                                      0, 0, canvas_->width(), canvas_->height(),
+                                      GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        GLExtensions::BindFramebuffer(GL_FRAMEBUFFER, canvas_->fbo());
+    }
+
+    if (reversed_) {
+        if (GLExtensions::ClipControl)
+            GLExtensions::ClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+        /* The canvas defaults */
+#if GLMARK2_USE_GL
+        glClearDepth(1.0f);
+#elif GLMARK2_USE_GLESv2
+        glClearDepthf(1.0f);
+#endif
+        glDepthFunc(GL_LEQUAL);
+    }
+}
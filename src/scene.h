@@ -30,7 +30,9 @@
 
 #include "mesh.h"
 #include "vec.h"
+#include "bvh.h"
 #include "program.h"
+#include "frame-stats.h"
 
 #include <math.h>
 
@@ -40,6 +42,8 @@
 #include <vector>
 #include "canvas.h"
 
+class ShaderSource;
+
 /**
  * A configurable scene used for creating benchmarks.
  */
@@ -61,9 +65,39 @@ public:
         std::string default_value;
         std::string description;
         std::vector<std::string> acceptable_values;
+        /* The values a benchmark runs with when given the value "sweep" */
+        std::vector<std::string> sweep_values;
         bool set;
     };
 
+    /**
+     * An additional measurement reported by a scene, besides the frame times.
+     */
+    struct Measurement {
+        Measurement(const std::string &n, const std::string &k, const FrameStats &s) :
+            name(n), key(k), stats(&s) {}
+
+        /* The name used in the log (e.g. "CompileTime") */
+        std::string name;
+        /* The name used in results files (e.g. "compile_time") */
+        std::string key;
+        const FrameStats *stats;
+    };
+
+    /**
+     * An additional rate reported by a scene, besides the FPS.
+     */
+    struct Rate {
+        Rate(const std::string &n, const std::string &k, double v) :
+            name(n), key(k), value(v) {}
+
+        /* The name used in the log (e.g. "DrawsPerSecond") */
+        std::string name;
+        /* The name used in results files (e.g. "draws_per_second") */
+        std::string key;
+        double value;
+    };
+
     /**
      * The result of a validation check.
      */
@@ -130,6 +164,38 @@ public:
      */
     virtual void draw();
 
+    /**
+     * Gets whether the scene can prepare its frames with ::prepare().
+     *
+     * @return true if the scene supports the pipelined main loop
+     */
+    virtual bool supports_pipelining() { return false; }
+
+    /**
+     * Gets whether the main loop clears the canvas before each frame.
+     *
+     * Scenes that only redraw the parts of the previous frames that changed
+     * return false, and clear the canvas themselves.
+     *
+     * @return true if the canvas is cleared before each frame
+     */
+    virtual bool needs_clear() { return true; }
+
+    /**
+     * Computes the next scene state on the CPU, without using GL.
+     *
+     * With the pipelined main loop (--pipelined), this runs on a worker
+     * thread while the current frame is submitted, starting after each
+     * ::update(), which then applies the state prepared the frame before.
+     * Otherwise scenes call it from ::update() themselves.
+     */
+    virtual void prepare() {}
+
+    /**
+     * Sets whether the main loop calls ::prepare() on a worker thread.
+     */
+    void pipelined(bool p) { pipelined_ = p; }
+
     /**
      * Gets an informational string describing the scene.
      *
@@ -156,6 +222,96 @@ public:
      */
     virtual ValidationResult validate() { return ValidationUnknown; }
 
+    /**
+     * Gets the additional measurements of the current run.
+     *
+     * @return the measurements, which are valid until the next ::setup()
+     */
+    virtual std::vector<Measurement> measurements()
+    {
+        return std::vector<Measurement>();
+    }
+
+    /**
+     * Resets the additional measurements of the current run.
+     *
+     * This is called when the warm-up frames are over, so that per-frame
+     * measurements don't include them.
+     */
+    virtual void reset_measurements() {}
+
+    /**
+     * Notifies the scene of the presentation of one of its frames.
+     *
+     * This is only called with --present-timing, after the warm-up, and
+     * a few frames after the frame was drawn.
+     *
+     * @param presentation the submit and present times of the frame
+     */
+    virtual void presented(const Presentation &presentation)
+    {
+        static_cast<void>(presentation);
+    }
+
+    /**
+     * Gets the additional rates of the current run.
+     *
+     * @return the rates, per second of the run
+     */
+    virtual std::vector<Rate> rates()
+    {
+        return std::vector<Rate>();
+    }
+
+    /**
+     * Gets the textures this scene loads with its current option values.
+     *
+     * This is used to decode the textures in the background before the
+     * scene is set up (see Texture::prefetch()). A texture that is loaded
+     * more than once should be listed once for each load.
+     *
+     * @return the texture names
+     */
+    virtual std::vector<std::string> textures()
+    {
+        return std::vector<std::string>();
+    }
+
+    /**
+     * The shader sources of a program variant, see ::programs().
+     */
+    struct ProgramVariant {
+        ProgramVariant() {}
+        ProgramVariant(const std::string &vtx, const std::string &frg) :
+            vtx_shader(vtx), frg_shader(frg) {}
+
+        std::string vtx_shader;
+        std::string frg_shader;
+    };
+
+    /**
+     * Gets the programs this scene builds with its current option values,
+     * with the default precisions of its options applied (see
+     * ::set_default_precisions()).
+     *
+     * This is used to build them before the benchmarks run, with
+     * --precompile-shaders (see ::precompile_programs()), so that the
+     * setup of the scene only loads their binaries. The sources must be
+     * those the setup builds, or the programs are just built twice.
+     *
+     * @return the program variants
+     */
+    virtual std::vector<ProgramVariant> programs()
+    {
+        return std::vector<ProgramVariant>();
+    }
+
+    /**
+     * Sets the default shader precisions to those of the scene options,
+     * as the setup of the scene does.
+     */
+    void set_default_precisions();
+
     /**
      * Gets whether this scene is running.
      *
@@ -177,6 +333,62 @@ public:
      */
     unsigned average_fps();
 
+    /**
+     * Gets the number of frames rendered in the current run.
+     *
+     * @return the number of frames
+     */
+    unsigned frame_count() { return currentFrame_; }
+
+    /**
+     * Gets the time elapsed in the current run.
+     *
+     * @return the elapsed time in seconds
+     */
+    double elapsed_time() { return lastUpdateTime_ - startTime_; }
+
+    /**
+     * Leaves a stretch of time out of the current run, e.g. an idle period
+     * between bursts, so that it counts neither towards the duration nor
+     * towards the frame times, and the animation carries on where it was.
+     *
+     * @param seconds the time to leave out
+     */
+    void skip_time(double seconds);
+
+    /**
+     * Gets the time to animate the current frame for, which is the elapsed
+     * time, or the number of frames times the --fixed-timestep, so that
+     * each frame draws the same thing in every run.
+     *
+     * @return the animation time in seconds
+     */
+    double animation_time();
+
+    /**
+     * Gets the per-frame timing statistics for the current run.
+     *
+     * @return the frame time statistics
+     */
+    const FrameStats &frame_stats() { return frame_stats_; }
+
+    /**
+     * Gets whether this scene is rendering warm-up frames, which are not
+     * included in the measurements.
+     *
+     * @return true if warming up, false otherwise
+     */
+    bool warming_up() { return warming_up_; }
+
+    /**
+     * Gets the fraction of the frame area that is redrawn each frame, the
+     * rest being kept from the previous frames (see the damage-fraction
+     * option).
+     *
+     * @return the fraction, 1.0 for the whole frame
+     */
+    double damage_fraction() { return damage_fraction_; }
+
     /**
      * Gets the name of the scene.
      * @return the name of the scene
@@ -222,6 +434,132 @@ public:
                                           const std::string &vtx_shader_filename = "None",
                                           const std::string &frg_shader_filename = "None");
 
+    /**
+     * The sources of a program to load with ::load_programs().
+     */
+    struct ProgramSource {
+        ProgramSource(Program &p, const std::string &vtx, const std::string &frg,
+                      const std::string &vtx_filename = "None",
+                      const std::string &frg_filename = "None") :
+            program(&p), vtx_shader(vtx), frg_shader(frg),
+            vtx_shader_filename(vtx_filename), frg_shader_filename(frg_filename) {}
+
+        Program *program;
+        std::string vtx_shader;
+        std::string frg_shader;
+        std::string vtx_shader_filename;
+        std::string frg_shader_filename;
+    };
+
+    /**
+     * Loads several shader programs at once.
+     *
+     * All the compiles and links are issued before waiting for any of them,
+     * so that implementations supporting GL_KHR_parallel_shader_compile can
+     * build the programs in parallel.
+     *
+     * @return whether all the programs were loaded successfully
+     */
+    static bool load_programs(const std::vector<ProgramSource> &programs);
+
+    /**
+     * Builds program variants ahead of the scenes that need them, keeping
+     * their binaries in the program cache (see ProgramCache) for the
+     * scenes to load. Variants listed more than once are built once.
+     */
+    static void precompile_programs(const std::vector<ProgramVariant> &variants);
+
+    /**
+     * Loads a compute shader program from a compute shader string.
+     *
+     * The source must start with a #version directive that supports
+     * compute shaders (e.g. "#version 310 es" or "#version 430"), see
+     * ::compute_shader_version().
+     *
+     * @return whether the operation succeeded
+     */
+    static bool load_compute_shader_from_string(Program &program,
+                                                const std::string &cmp_shader,
+                                                const std::string &cmp_shader_filename = "None");
+
+    /**
+     * Loads a shader program whose vertex shader outputs are captured
+     * with transform feedback, interleaved in the order of the varyings.
+     *
+     * The varyings are set before the program is linked, so it isn't
+     * taken from or stored in the program cache.
+     *
+     * @return whether the operation succeeded
+     */
+    static bool load_transform_feedback_shaders_from_strings(Program &program,
+                                                             const std::string &vtx_shader,
+                                                             const std::string &frg_shader,
+                                                             const std::vector<std::string> &varyings,
+                                                             const std::string &vtx_shader_filename = "None");
+
+    /**
+     * A shader of a program with more stages than a vertex and a fragment
+     * shader, see ::load_shader_stages_from_strings().
+     */
+    struct ShaderStage {
+        ShaderStage(unsigned int t, const std::string &src,
+                    const std::string &filename = "None") :
+            type(t), source(src), shader_filename(filename) {}
+
+        unsigned int type;
+        std::string source;
+        std::string shader_filename;
+    };
+
+    /**
+     * Loads a shader program from the shaders of its stages, e.g. with
+     * tessellation or geometry shaders between the vertex and the fragment
+     * shader.
+     *
+     * Such programs aren't taken from or stored in the program cache.
+     *
+     * @return whether the operation succeeded
+     */
+    static bool load_shader_stages_from_strings(Program &program,
+                                                const std::vector<ShaderStage> &stages);
+
+    /**
+     * Gets the #version directive to use for compute shaders.
+     */
+    static std::string compute_shader_version();
+
+    /**
+     * Gets the #version directive to use for programs with tessellation or
+     * geometry shaders (GLSL ES 3.20 or GLSL 4.00), with the #extension
+     * directives that GLES 3.1 needs for them. All the stages of such
+     * programs use in/out variables.
+     */
+    static std::string tessellation_shader_version();
+
+    /**
+     * Gets the definitions that let the body of a GLSL ES 1.00 fragment
+     * shader build with a later #version directive, e.g. to reuse it after
+     * a tessellation or geometry shader.
+     */
+    static std::string glsl100_fragment_defines();
+
+    /**
+     * Gets the #version directive to use for shaders with uniform blocks or
+     * array textures (GLSL ES 3.00 or GLSL 1.40), which use in/out
+     * variables and declare their fragment outputs.
+     */
+    static std::string glsl3_shader_version();
+
+    /**
+     * Invalidates attachments of the bound framebuffer, signalling that
+     * their contents are no longer needed, if --invalidate is used and
+     * framebuffer invalidation is supported.
+     *
+     * @param attachments the attachments to invalidate
+     * @param count the number of attachments
+     */
+    static void invalidate_framebuffer(const GLenum *attachments, unsigned int count);
+
 protected:
     Scene(Canvas &pCanvas, const std::string &name);
     std::string construct_title(const std::string &title);
@@ -235,6 +573,203 @@ protected:
     bool running_;
     double duration_;      // Duration of run in seconds
     unsigned nframes_;
+    bool warming_up_;
+    double warmup_duration_;    // Duration of the warm-up in seconds
+    unsigned warmup_frames_;
+    double damage_fraction_;
+    FrameStats frame_stats_;
+    /* Whether ::prepare() is called by the main loop, see ::pipelined() */
+    bool pipelined_;
+    double convergence_;        // Target relative half-width of the 95% CI
+    double min_duration_;       // Minimum duration of a converging run
+
+private:
+    bool update_convergence(double current_time);
+
+    /* The mean frame times of the batches of frames, see update_convergence() */
+    double batchStartTime_;
+    unsigned batchFrames_;
+    unsigned batches_;
+    double batchMean_;
+    double batchM2_;
+};
+
+/**
+ * A depth-only pre-pass for scenes that draw opaque geometry.
+ *
+ * The depth of a mesh is first laid down with a trivial program and color
+ * writes disabled, then the mesh is shaded with GL_EQUAL depth testing and
+ * depth writes disabled, so that each pixel is shaded at most once (early
+ * Z). Scenes that support it add the "depth-prepass" option, and the gain
+ * (or loss) is the difference between the FPS of the scene with and
+ * without the option.
+ *
+ * The pre-pass computes gl_Position as ModelViewProjectionMatrix *
+ * vec4(position, 1.0), which the vertex shaders of the scenes use, so that
+ * both passes produce the same depth values.
+ */
+class DepthPrepass
+{
+public:
+    DepthPrepass() : enabled_(false) {}
+
+    /**
+     * Adds the "depth-prepass" option to the options of a scene.
+     */
+    static void add_option(std::map<std::string, Scene::Option> &options);
+
+    /**
+     * Loads the pre-pass program, if the "depth-prepass" option is set.
+     *
+     * @return whether the setup succeeded
+     */
+    bool setup(std::map<std::string, Scene::Option> &options);
+
+    void teardown();
+
+    /**
+     * Whether the pre-pass is enabled for the current run.
+     */
+    bool enabled() const { return enabled_; }
+
+    /**
+     * Lays down the depth of a mesh and prepares the depth state for
+     * shading it: once done, the shading program is started again with the
+     * attribute locations the mesh had, and depth testing is GL_EQUAL.
+     * Does nothing if the pre-pass is not enabled.
+     *
+     * @param mesh the mesh to draw
+     * @param mvp the ModelViewProjectionMatrix the mesh is shaded with
+     * @param program the program the mesh is shaded with
+     * @param use_vbo whether to draw the mesh from its VBOs
+     */
+    void begin(Mesh &mesh, const LibMatrix::mat4 &mvp, Program &program,
+               bool use_vbo = true);
+
+    /**
+     * Restores the depth state after shading the mesh.
+     *
+     * @param depth_func the depth test to restore, GL_LEQUAL by default as
+     *        on the canvas
+     */
+    void end(GLenum depth_func = GL_LEQUAL);
+
+private:
+    bool enabled_;
+    Program program_;
+};
+
+/**
+ * The depth buffer configuration of a scene: the format of the depth
+ * buffers it renders to, and whether their depth range is reversed.
+ *
+ * Scenes that support it add the "depth-format" and "reversed-z" options.
+ * The formats are "default" (what the scene uses otherwise), "16", "24",
+ * "32f" and the packed depth-stencil formats "24s8" and "32fs8".
+ *
+ * With reversed Z, the near plane is at depth 1.0 and the far plane at
+ * depth 0.0, the depth is cleared to 0.0 and tested with GL_GEQUAL. Where
+ * glClipControl is available, the clip space depth range is [0, 1] while
+ * rendering, so that a floating point depth buffer keeps its precision in
+ * the distance; elsewhere the projection only flips the [-1, 1] range.
+ * Either way, the standard depth of a reversed depth value d is 1.0 - d,
+ * which is how the scenes sample reversed depth textures.
+ *
+ * Scenes that render to the canvas, whose depth buffer follows the visual
+ * config, render to a target of the canvas size with the configured depth
+ * buffer instead, unless the configuration is the default one, and blit
+ * its color to the canvas at the end of the frame.
+ */
+class DepthConfig
+{
+public:
+    DepthConfig() :
+        format_("default"), reversed_(false), canvas_(0), fbo_(0) { rb_[0] = rb_[1] = 0; }
+
+    /**
+     * Adds the "depth-format" and "reversed-z" options to the options of
+     * a scene.
+     */
+    static void add_options(std::map<std::string, Scene::Option> &options);
+
+    /**
+     * Whether the configuration in the options is supported.
+     *
+     * @param target whether the scene renders to the canvas, so needs a
+     *        target of its own for a configuration other than the default
+     */
+    static bool supported(std::map<std::string, Scene::Option> &options,
+                          bool target, bool show_errors);
+
+    /**
+     * Reads the configuration from the options and, for a scene that
+     * renders to the canvas, sets up its target if needed.
+     *
+     * @param canvas the canvas the scene renders to, or 0 if the scene
+     *        only applies the configuration to its own targets
+     *
+     * @return whether the setup succeeded
+     */
+    bool setup(std::map<std::string, Scene::Option> &options, Canvas *canvas = 0);
+
+    void teardown();
+
+    bool reversed() const { return reversed_; }
+
+    /**
+     * The attachment point of the depth buffer in a framebuffer.
+     */
+    GLenum attachment() const;
+
+    /**
+     * Gets the format of a depth texture. The default format is the
+     * unsized GL_DEPTH_COMPONENT.
+     */
+    void texture_format(GLint &internalFormat, GLenum &format, GLenum &type) const;
+
+    /**
+     * Gets the format of a depth renderbuffer.
+     *
+     * @param fallback the format for the default configuration
+     */
+    GLenum renderbuffer_format(GLenum fallback) const;
+
+    /**
+     * A perspective projection into the configured depth range.
+     */
+    LibMatrix::mat4 perspective(float fovy, float aspect, float zNear, float zFar) const;
+
+    /**
+     * Adds the DepthSampleOffset and DepthSampleScale constants to a shader
+     * that samples a depth texture of the configuration: the standard depth
+     * of a sampled value d is DepthSampleOffset + DepthSampleScale * d.
+     */
+    void add_sample_consts(ShaderSource &source) const;
+
+    /**
+     * The depth test of the configuration.
+     */
+    GLenum depth_func() const { return reversed_ ? GL_GEQUAL : GL_LEQUAL; }
+
+    /**
+     * Prepares the depth state for rendering with the configuration, before
+     * the depth buffer is cleared. For a scene that renders to the canvas,
+     * also binds its target, if any, and clears it.
+     */
+    void begin();
+
+    /**
+     * Restores the default depth state. For a scene that renders to the
+     * canvas, also blits its target, if any, to the canvas.
+     */
+    void end();
+
+private:
+    std::string format_;
+    bool reversed_;
+    Canvas *canvas_;
+    GLuint fbo_;
+    GLuint rb_[2];
 };
 
 /*
@@ -255,6 +790,7 @@ class SceneBuild : public Scene
 {
 public:
     SceneBuild(Canvas &pCanvas);
+    bool supported(bool show_errors);
     bool load();
     void unload();
     bool setup();
@@ -262,6 +798,9 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
 
     ~SceneBuild();
 
@@ -277,12 +816,45 @@ protected:
     float rotation_;
     float rotationSpeed_;
     bool useVbo_;
+    unsigned int triangles_;
+    double trianglesDrawn_;
+    unsigned int instances_;
+    unsigned int columns_;
+    float spacing_;
+    float viewRadius_;
+    LibMatrix::vec3 minVec_;
+    LibMatrix::vec3 maxVec_;
+    bool occlusionQuery_;
+    GLenum queryTarget_;
+    unsigned int queryFrames_;
+    unsigned int queryFrame_;
+    Program proxyProgram_;
+    Mesh proxyMesh_;
+    std::vector<GLuint> queries_;
+    std::vector<bool> queryPending_;
+    std::vector<uint64_t> queryIssueTimes_;
+    std::vector<bool> instanceVisible_;
+    FrameStats queryLatencyStats_;
+    FrameStats queryWaitStats_;
+    double culledDraws_;
+    // The projected diameter in pixels of an instance at a distance of 1
+    float lodScale_;
+    float lodPixels_;
+    DepthConfig depth_;
+
+private:
+    bool load_model(bool use_index);
+    LibMatrix::mat4 instance_model_view(unsigned int i);
+    unsigned int instance_lod(const LibMatrix::mat4 &model_view);
+    bool read_query_results(unsigned int i, uint64_t &wait);
+    void create_proxy_mesh();
 };
 
 class SceneTexture : public Scene
 {
 public:
     SceneTexture(Canvas &pCanvas);
+    bool supported(bool show_errors);
     bool load();
     void unload();
     bool setup();
@@ -290,13 +862,22 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<std::string> textures();
+    std::vector<Measurement> measurements();
 
     ~SceneTexture();
 
+private:
+    void set_sampling_state(float anisotropy, const GLint swizzle[4]);
+    bool create_yuv_textures(const std::string &name, GLint min_filter,
+                             GLint mag_filter, bool interleaved, bool external,
+                             uint64_t &upload_us);
+
 protected:
     Program program_;
     Mesh mesh_;
-    GLuint texture_;
+    /* The textures sampled by each fragment, one for each texture unit */
+    std::vector<GLuint> textures_;
     float radius_;
     bool orientModel_;
     float orientationAngle_;
@@ -305,12 +886,22 @@ protected:
     LibMatrix::vec3 centerVec_;
     LibMatrix::vec3 rotation_;
     LibMatrix::vec3 rotationSpeed_;
+    FrameStats upload_stats_;
+    /* Whether the textures have a non-default anisotropy and swizzle */
+    bool anisotropic_;
+    bool swizzled_;
+    /* GL_TEXTURE_EXTERNAL_OES for YUV frames converted by the sampler */
+    GLenum texture_target_;
+    /* The YUV frame imported with yuv-conversion=external */
+    DmaBuf yuv_buf_;
+    void *yuv_image_;
 };
 
 class SceneShading : public Scene
 {
 public:
     SceneShading(Canvas &pCanvas);
+    bool supported(bool show_errors);
     bool load();
     void unload();
     bool setup();
@@ -318,10 +909,13 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<ProgramVariant> programs();
 
     ~SceneShading();
 
 protected:
+    ProgramVariant program_variant();
+
     Program program_;
     float radius_;
     bool orientModel_;
@@ -332,12 +926,15 @@ protected:
     Mesh mesh_;
     float rotation_;
     float rotationSpeed_;
+    DepthPrepass prepass_;
+    DepthConfig depth_;
 };
 
 class SceneGrid : public Scene
 {
 public:
     SceneGrid(Canvas &pCanvas, const std::string &name);
+    virtual bool supported(bool show_errors);
     virtual bool load();
     virtual void unload();
     virtual bool setup();
@@ -349,10 +946,17 @@ public:
     ~SceneGrid();
 
 protected:
+    std::string prepare_vertex_shader(const std::string &source);
+
     Program program_;
     Mesh mesh_;
     float rotation_;
     float rotationSpeed_;
+
+    /* With instanced=true the mesh is a single cell drawn once per cell */
+    bool instanced_;
+    unsigned int instances_;
+    GLuint instance_vbo_;
 };
 
 class SceneConditionals : public SceneGrid
@@ -385,19 +989,43 @@ public:
     ~SceneLoop();
 };
 
-class SceneBump : public Scene
+class SceneShaderCompile : public SceneGrid
 {
 public:
-    SceneBump(Canvas &pCanvas);
-    bool load();
-    void unload();
+    SceneShaderCompile(Canvas &pCanvas);
     bool setup();
-    void teardown();
-    void update();
     void draw();
-    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
 
-    ~SceneBump();
+    ~SceneShaderCompile();
+
+private:
+    bool build_program();
+
+    std::string vtx_template_;
+    std::string frg_template_;
+    bool unique_;
+    FrameStats compile_stats_;
+    FrameStats link_stats_;
+};
+
+class SceneBump : public Scene
+{
+public:
+    SceneBump(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<std::string> textures();
+    std::vector<ProgramVariant> programs();
+
+    ~SceneBump();
 
 protected:
     Program program_;
@@ -405,11 +1033,17 @@ protected:
     GLuint texture_;
     float rotation_;
     float rotationSpeed_;
+    DepthPrepass prepass_;
+    float tessellationLevel_;
 private:
+    bool program_variant(ProgramVariant &variant);
+    bool load_program();
     bool setup_model_plain(const std::string &type);
     bool setup_model_normals();
     bool setup_model_normals_tangent();
     bool setup_model_height();
+    bool setup_model_parallax();
+    bool setup_model_displacement();
 };
 
 class SceneEffect2D : public Scene
@@ -423,11 +1057,66 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<std::string> textures();
 
     ~SceneEffect2D();
 
+    /**
+     * Parses a convolution kernel matrix, e.g. "0,1,0;1,-4,1;0,1,0", into
+     * its coefficients in row-major order.
+     */
+    static bool parse_matrix(const std::string &str, std::vector<float> &matrix,
+                             unsigned int &width, unsigned int &height);
+    /**
+     * Normalizes a convolution kernel matrix.
+     */
+    static void normalize(std::vector<float> &kernel);
+    /**
+     * Creates a fragment shader convolving Texture0 with a kernel matrix.
+     */
+    static std::string create_convolution_fragment_shader(const LibMatrix::vec2 &step,
+                                                          const std::vector<float> &array,
+                                                          unsigned int width,
+                                                          unsigned int height);
+    /**
+     * Decomposes a kernel matrix into a sum of separable terms, each the
+     * product of a column kernel and a row kernel, from its singular value
+     * decomposition. The terms are in decreasing order of importance and
+     * each row kernel has an absolute sum of 1.
+     *
+     * @param kernel the coefficients in row-major order
+     * @param width the width of the kernel
+     * @param height the height of the kernel
+     * @param max_terms the number of terms to return at most
+     * @param[out] rows the row kernels of the terms
+     * @param[out] columns the column kernels of the terms
+     * @param[out] error the relative error of the returned terms
+     *
+     * @return the numerical rank of the kernel
+     */
+    static unsigned int separate(const std::vector<float> &kernel,
+                                 unsigned int width, unsigned int height,
+                                 unsigned int max_terms,
+                                 std::vector<std::vector<float> > &rows,
+                                 std::vector<std::vector<float> > &columns,
+                                 double &error);
+
 protected:
+    void render_pass(Program &program, GLint position_location);
+
+    /* The most separable terms, each convolved into its own target */
+    static const unsigned int max_terms = 4;
+
     Program program_;
+    /* With a separable kernel, program_ runs the column pass */
+    Program row_programs_[max_terms];
+    GLuint row_fbos_[max_terms];
+    GLuint row_textures_[max_terms];
+    GLint position_location_;
+    GLint row_position_locations_[max_terms];
+    GLint mesh_position_location_;
+    /* The number of separable terms, 0 for a single 2D pass */
+    unsigned int terms_;
 
     Mesh mesh_;
     GLuint texture_;
@@ -437,6 +1126,7 @@ class ScenePulsar : public Scene
 {
 public:
     ScenePulsar(Canvas &pCanvas);
+    bool supported(bool show_errors);
     bool load();
     void unload();
     bool setup();
@@ -444,6 +1134,10 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<std::string> textures();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
 
     ~ScenePulsar();
 
@@ -455,9 +1149,45 @@ protected:
     std::vector<LibMatrix::vec3> rotations_;
     std::vector<LibMatrix::vec3> rotationSpeeds_;
     GLuint texture_;
+    bool instanced_;
+    GLuint instanceBuffer_;
+    // The per-instance matrices, kept so that streaming them doesn't allocate
+    std::vector<float> instanceData_;
+    std::vector<LibMatrix::vec3> offsets_;
+    bool cull_;
+    LibMatrix::BVH bvh_;
+    std::vector<unsigned int> visible_;
+    FrameStats cull_stats_;
+    double culled_;
 
 private:
     void create_and_setup_mesh();
+    void quad_matrices(int i, LibMatrix::mat4 &model_view_proj,
+                       LibMatrix::mat4 &normal_matrix);
+    void cull_quads();
+    void draw_instanced();
+};
+
+struct SceneParticlesPrivate;
+
+class SceneParticles : public Scene
+{
+public:
+    SceneParticles(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneParticles();
+
+private:
+    SceneParticlesPrivate *priv_;
 };
 
 struct SceneDesktopPrivate;
@@ -473,7 +1203,11 @@ public:
     void teardown();
     void update();
     void draw();
+    bool needs_clear();
     ValidationResult validate();
+    std::vector<std::string> textures();
+    void reset_measurements();
+    std::vector<Rate> rates();
 
     ~SceneDesktop();
 
@@ -494,7 +1228,11 @@ public:
     void teardown();
     void update();
     void draw();
+    bool supports_pipelining() { return true; }
+    void prepare();
     ValidationResult validate();
+    void reset_measurements();
+    std::vector<Rate> rates();
 
     ~SceneBuffer();
 
@@ -502,6 +1240,619 @@ private:
     SceneBufferPrivate *priv_;
 };
 
+struct SceneTextureUploadPrivate;
+
+class SceneTextureUpload : public Scene
+{
+public:
+    SceneTextureUpload(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+
+    ~SceneTextureUpload();
+
+private:
+    SceneTextureUploadPrivate *priv_;
+};
+
+struct SceneDrawCallsPrivate;
+
+class SceneDrawCalls : public Scene
+{
+public:
+    SceneDrawCalls(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneDrawCalls();
+
+private:
+    SceneDrawCallsPrivate *priv_;
+};
+
+struct SceneUniformsPrivate;
+
+class SceneUniforms : public Scene
+{
+public:
+    SceneUniforms(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneUniforms();
+
+private:
+    SceneUniformsPrivate *priv_;
+};
+
+struct SceneAsyncUploadPrivate;
+
+class SceneAsyncUpload : public Scene
+{
+public:
+    SceneAsyncUpload(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneAsyncUpload();
+
+private:
+    SceneAsyncUploadPrivate *priv_;
+};
+
+struct SceneMultiContextPrivate;
+
+class SceneMultiContext : public Scene
+{
+public:
+    SceneMultiContext(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneMultiContext();
+
+private:
+    SceneMultiContextPrivate *priv_;
+};
+
+struct SceneSyncPrivate;
+
+class SceneSync : public Scene
+{
+public:
+    SceneSync(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+
+    ~SceneSync();
+
+private:
+    SceneSyncPrivate *priv_;
+};
+
+struct SceneLatencyPrivate;
+
+class SceneLatency : public Scene
+{
+public:
+    SceneLatency(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    void presented(const Presentation &presentation);
+
+    ~SceneLatency();
+
+private:
+    SceneLatencyPrivate *priv_;
+};
+
+struct ScenePreemptionPrivate;
+
+class ScenePreemption : public Scene
+{
+public:
+    ScenePreemption(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~ScenePreemption();
+
+private:
+    ScenePreemptionPrivate *priv_;
+};
+
+struct SceneCompositePrivate;
+
+class SceneComposite : public Scene
+{
+public:
+    SceneComposite(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+
+    ~SceneComposite();
+
+private:
+    SceneCompositePrivate *priv_;
+};
+
+struct SceneMultiDrawPrivate;
+
+class SceneMultiDraw : public Scene
+{
+public:
+    SceneMultiDraw(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneMultiDraw();
+
+private:
+    SceneMultiDrawPrivate *priv_;
+};
+
+struct SceneTextureBindingPrivate;
+
+class SceneTextureBinding : public Scene
+{
+public:
+    SceneTextureBinding(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneTextureBinding();
+
+private:
+    SceneTextureBindingPrivate *priv_;
+};
+
+struct SceneDmaBufPrivate;
+
+class SceneDmaBuf : public Scene
+{
+public:
+    SceneDmaBuf(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+
+    ~SceneDmaBuf();
+
+private:
+    SceneDmaBufPrivate *priv_;
+};
+
+struct SceneTransformFeedbackPrivate;
+
+class SceneTransformFeedback : public Scene
+{
+public:
+    SceneTransformFeedback(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneTransformFeedback();
+
+private:
+    SceneTransformFeedbackPrivate *priv_;
+};
+
+struct SceneComputeParticlesPrivate;
+
+class SceneComputeParticles : public Scene
+{
+public:
+    SceneComputeParticles(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneComputeParticles();
+
+private:
+    SceneComputeParticlesPrivate *priv_;
+};
+
+struct SceneComputeReductionPrivate;
+
+class SceneComputeReduction : public Scene
+{
+public:
+    SceneComputeReduction(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneComputeReduction();
+
+private:
+    SceneComputeReductionPrivate *priv_;
+};
+
+struct SceneFillratePrivate;
+
+class SceneFillrate : public Scene
+{
+public:
+    SceneFillrate(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneFillrate();
+
+private:
+    SceneFillratePrivate *priv_;
+};
+
+struct SceneBlitPrivate;
+
+class SceneBlit : public Scene
+{
+public:
+    SceneBlit(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneBlit();
+
+private:
+    SceneBlitPrivate *priv_;
+};
+
+struct ScenePathsPrivate;
+
+class ScenePaths : public Scene
+{
+public:
+    ScenePaths(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~ScenePaths();
+
+private:
+    ScenePathsPrivate *priv_;
+};
+
+struct SceneSpritesPrivate;
+
+class SceneSprites : public Scene
+{
+public:
+    SceneSprites(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+    std::vector<std::string> textures();
+
+    ~SceneSprites();
+
+private:
+    SceneSpritesPrivate *priv_;
+};
+
+struct SceneOITPrivate;
+
+class SceneOIT : public Scene
+{
+public:
+    SceneOIT(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneOIT();
+
+private:
+    SceneOITPrivate *priv_;
+};
+
+struct SceneMultiviewPrivate;
+
+class SceneMultiview : public Scene
+{
+public:
+    SceneMultiview(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+
+    ~SceneMultiview();
+
+private:
+    SceneMultiviewPrivate *priv_;
+};
+
+struct SceneVirtualTexturePrivate;
+
+class SceneVirtualTexture : public Scene
+{
+public:
+    SceneVirtualTexture(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Measurement> measurements();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneVirtualTexture();
+
+private:
+    SceneVirtualTexturePrivate *priv_;
+};
+
+struct SceneTriangleSizePrivate;
+
+class SceneTriangleSize : public Scene
+{
+public:
+    SceneTriangleSize(Canvas &pCanvas);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneTriangleSize();
+
+private:
+    SceneTriangleSizePrivate *priv_;
+};
+
+struct SceneALUPrivate;
+
+class SceneALU : public Scene
+{
+public:
+    SceneALU(Canvas &pCanvas);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneALU();
+
+private:
+    SceneALUPrivate *priv_;
+};
+
+struct SceneTextureCachePrivate;
+
+class SceneTextureCache : public Scene
+{
+public:
+    SceneTextureCache(Canvas &pCanvas);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneTextureCache();
+
+private:
+    SceneTextureCachePrivate *priv_;
+};
+
+struct SceneWorkingSetPrivate;
+
+class SceneWorkingSet : public Scene
+{
+public:
+    SceneWorkingSet(Canvas &pCanvas);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    std::vector<Rate> rates();
+
+    ~SceneWorkingSet();
+
+private:
+    SceneWorkingSetPrivate *priv_;
+};
+
+struct SceneDeferredPrivate;
+
+class SceneDeferred : public Scene
+{
+public:
+    SceneDeferred(Canvas &pCanvas);
+    bool supported(bool show_errors);
+    bool load();
+    void unload();
+    bool setup();
+    void teardown();
+    void update();
+    void draw();
+    ValidationResult validate();
+    void reset_measurements();
+    std::vector<Rate> rates();
+
+    ~SceneDeferred();
+
+private:
+    SceneDeferredPrivate *priv_;
+};
+
 class SceneIdeasPrivate;
 
 class SceneIdeas : public Scene
@@ -514,6 +1865,8 @@ public:
     void teardown();
     void update();
     void draw();
+    bool supports_pipelining() { return true; }
+    void prepare();
     ValidationResult validate();
 
     ~SceneIdeas();
@@ -536,11 +1889,17 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<std::string> textures();
+    void reset_measurements();
+    std::vector<Rate> rates();
 
     ~SceneTerrain();
 
 private:
+    void update_world_camera(float time);
+
     SceneTerrainPrivate* priv_;
+    LibMatrix::mat4 projection_;
 };
 
 class JellyfishPrivate;
@@ -550,6 +1909,7 @@ class SceneJellyfish : public Scene
 public:
     SceneJellyfish(Canvas &pCanvas);
     ~SceneJellyfish();
+    bool supported(bool show_errors);
     bool load();
     void unload();
     bool setup();
@@ -557,6 +1917,7 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<std::string> textures();
 };
 
 class ShadowPrivate;
@@ -589,6 +1950,7 @@ public:
     void update();
     void draw();
     ValidationResult validate();
+    std::vector<std::string> textures();
 };
 
 class SceneClear : public Scene
@@ -0,0 +1,275 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "score.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace
+{
+
+/* The categories in the order their sub-scores are shown, and their names */
+const char *category_names[][2] = {
+    { "vertex", "Vertex" },
+    { "fragment", "Fragment ALU" },
+    { "texture", "Texture" },
+    { "bandwidth", "Bandwidth" },
+    { "cpu", "CPU/Driver" },
+    { "present", "Present" },
+    { "compute", "Compute" },
+};
+
+/*
+ * The benchmarks of less than 1 FPS are counted as 1 FPS, so that they
+ * don't zero the means of the logarithms and reciprocals.
+ */
+double
+clamped_fps(const Score::Entry &entry)
+{
+    return std::max(entry.fps, 1.0);
+}
+
+double
+geometric_mean(const std::vector<Score::Entry> &entries)
+{
+    double sum = 0.0;
+    double weights = 0.0;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        sum += entries[i].weight * std::log(clamped_fps(entries[i]));
+        weights += entries[i].weight;
+    }
+
+    return weights > 0.0 ? std::exp(sum / weights) : 0.0;
+}
+
+}
+
+double
+Score::compute(const std::vector<Entry> &entries, Options::ScoreModel model)
+{
+    double sum = 0.0;
+    double weights = 0.0;
+
+    switch (model) {
+        case Options::ScoreModelGeometric:
+            return geometric_mean(entries);
+
+        case Options::ScoreModelFrameTime:
+            /* The FPS of the mean frame time */
+            for (size_t i = 0; i < entries.size(); i++) {
+                sum += entries[i].weight / clamped_fps(entries[i]);
+                weights += entries[i].weight;
+            }
+            return sum > 0.0 ? weights / sum : 0.0;
+
+        case Options::ScoreModelCategory: {
+            /*
+             * Each category counts the same, however many benchmarks
+             * it has.
+             */
+            std::map<std::string, std::vector<Entry> > categories;
+            for (size_t i = 0; i < entries.size(); i++)
+                categories[entries[i].category].push_back(entries[i]);
+
+            std::vector<Entry> means;
+            for (std::map<std::string, std::vector<Entry> >::const_iterator iter = categories.begin();
+                 iter != categories.end();
+                 iter++)
+            {
+                Entry mean;
+                mean.category = iter->first;
+                mean.fps = geometric_mean(iter->second);
+                if (mean.fps > 0.0)
+                    means.push_back(mean);
+            }
+            return geometric_mean(means);
+        }
+
+        case Options::ScoreModelArithmetic:
+        default:
+            for (size_t i = 0; i < entries.size(); i++) {
+                sum += entries[i].weight * entries[i].fps;
+                weights += entries[i].weight;
+            }
+            return weights > 0.0 ? sum / weights : 0.0;
+    }
+}
+
+/*
+ * Categorizes the benchmarks by what mostly limits them, which for some
+ * scenes depends on their options: the first entry of the scene whose
+ * option, if any, the benchmark has applies. The default benchmarks are
+ * all covered.
+ */
+std::string
+Score::default_category(const std::string &scene, const std::string &options)
+{
+    static const char *categories[][3] = {
+        { "build", "", "vertex" },
+        { "jellyfish", "", "vertex" },
+        { "shadow", "", "vertex" },
+        { "transform-feedback", "", "vertex" },
+        { "triangle-size", "", "vertex" },
+        { "multiview", "", "vertex" },
+        { "bump", "bump-render=high-poly", "vertex" },
+        { "conditionals", "fragment-steps=0", "vertex" },
+        { "shading", "", "fragment" },
+        { "pulsar", "", "fragment" },
+        { "particles", "", "fragment" },
+        { "conditionals", "", "fragment" },
+        { "function", "", "fragment" },
+        { "loop", "", "fragment" },
+        { "alu", "", "fragment" },
+        { "deferred", "", "fragment" },
+        { "terrain", "", "fragment" },
+        { "refract", "", "fragment" },
+        { "oit", "", "fragment" },
+        { "paths", "", "fragment" },
+        { "sprites", "", "fragment" },
+        { "texture", "", "texture" },
+        { "texture-cache", "", "texture" },
+        { "virtual-texture", "", "texture" },
+        { "bump", "", "texture" },
+        { "effect2d", "", "texture" },
+        { "desktop", "effect=blur", "texture" },
+        { "desktop", "", "bandwidth" },
+        { "working-set", "", "bandwidth" },
+        { "texture-upload", "", "bandwidth" },
+        { "dma-buf", "", "bandwidth" },
+        { "async-upload", "", "bandwidth" },
+        { "buffer", "", "bandwidth" },
+        { "fillrate", "", "bandwidth" },
+        { "blit", "", "bandwidth" },
+        { "clear", "", "bandwidth" },
+        { "ideas", "", "cpu" },
+        { "drawcalls", "", "cpu" },
+        { "multidraw", "", "cpu" },
+        { "multi-context", "", "cpu" },
+        { "texture-binding", "", "cpu" },
+        { "sync", "", "cpu" },
+        { "preemption", "", "cpu" },
+        { "composite", "", "cpu" },
+        { "shader-compile", "", "cpu" },
+        { "latency", "", "present" },
+        { "compute-particles", "", "compute" },
+        { "compute-reduction", "", "compute" },
+    };
+
+    std::vector<std::string> elems;
+    Util::split(options, ':', elems, Util::SplitModeNormal);
+
+    for (size_t i = 0; i < sizeof(categories) / sizeof(*categories); i++) {
+        if (scene != categories[i][0])
+            continue;
+        if (*categories[i][1] == '\0' ||
+            std::find(elems.begin(), elems.end(), categories[i][1]) != elems.end())
+        {
+            return categories[i][2];
+        }
+    }
+
+    return "other";
+}
+
+std::string
+Score::category_name(const std::string &category)
+{
+    for (size_t i = 0; i < sizeof(category_names) / sizeof(*category_names); i++) {
+        if (category == category_names[i][0])
+            return category_names[i][1];
+    }
+
+    return category;
+}
+
+std::vector<Score::SubScore>
+Score::subscores(const std::vector<Entry> &entries,
+                 const std::vector<BenchmarkResult> &reference)
+{
+    std::map<std::string, std::vector<Entry> > categories;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        Entry entry(entries[i]);
+
+        if (!reference.empty()) {
+            double reference_fps = 0.0;
+            for (size_t j = 0; j < reference.size() && reference_fps <= 0.0; j++) {
+                const BenchmarkResult &r(reference[j]);
+                if (r.status == BenchmarkResult::StatusSuccess &&
+                    r.scene == entry.scene && r.options == entry.options)
+                {
+                    reference_fps = r.fps;
+                }
+            }
+            if (reference_fps <= 0.0)
+                continue;
+            /* Scaled so that the ratios stay clear of the clamping to 1 */
+            entry.fps = 1000.0 * entry.fps / reference_fps;
+        }
+
+        categories[entry.category].push_back(entry);
+    }
+
+    std::vector<SubScore> result;
+
+    /* The known categories first, in their order, then the others */
+    for (size_t i = 0; i < sizeof(category_names) / sizeof(*category_names); i++) {
+        std::map<std::string, std::vector<Entry> >::iterator iter =
+            categories.find(category_names[i][0]);
+        if (iter == categories.end())
+            continue;
+
+        SubScore subscore;
+        subscore.category = iter->first;
+        subscore.score = geometric_mean(iter->second);
+        subscore.benchmarks = iter->second.size();
+        result.push_back(subscore);
+        categories.erase(iter);
+    }
+
+    for (std::map<std::string, std::vector<Entry> >::const_iterator iter = categories.begin();
+         iter != categories.end();
+         iter++)
+    {
+        SubScore subscore;
+        subscore.category = iter->first;
+        subscore.score = geometric_mean(iter->second);
+        subscore.benchmarks = iter->second.size();
+        result.push_back(subscore);
+    }
+
+    return result;
+}
+
+double
+Score::combine(const std::vector<SubScore> &subscores)
+{
+    std::vector<Entry> means;
+
+    for (size_t i = 0; i < subscores.size(); i++) {
+        Entry mean;
+        mean.fps = subscores[i].score;
+        means.push_back(mean);
+    }
+
+    return geometric_mean(means);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_SCORE_H_
+#define GLMARK2_SCORE_H_
+
+#include "options.h"
+#include "results-file.h"
+
+#include <string>
+#include <vector>
+
+/**
+ * Combines the FPS of the benchmarks into the glmark2 score, using the
+ * model selected with --score-model.
+ *
+ * Each benchmark has a weight and a category (vertex, fragment, texture,
+ * bandwidth, cpu, present or compute), which can be set with the
+ * score-weight and score-category options of its description, e.g. in a
+ * benchmark file. The benchmarks of each category are also combined into a
+ * sub-score, normalized against the results of a reference device with
+ * --score-reference, to show where a device is weak.
+ */
+class Score
+{
+public:
+    struct Entry
+    {
+        Entry() : weight(1.0), fps(0.0) {}
+
+        std::string scene;
+        std::string options;
+        std::string category;
+        double weight;
+        double fps;
+    };
+
+    /**
+     * Computes the score of the benchmarks.
+     *
+     * @param entries the benchmarks that were run successfully
+     * @param model how to combine their FPS
+     *
+     * @return the score, 0 if no benchmark was run
+     */
+    static double compute(const std::vector<Entry> &entries, Options::ScoreModel model);
+
+    /**
+     * The combined benchmarks of a category.
+     */
+    struct SubScore
+    {
+        SubScore() : score(0.0), benchmarks(0) {}
+
+        std::string category;
+        /* The geometric mean FPS, or 1000 times that relative to the reference */
+        double score;
+        unsigned int benchmarks;
+    };
+
+    /**
+     * Computes the sub-score of each category, in the order of the
+     * categories. With reference results, each benchmark counts as its FPS
+     * relative to that of the same benchmark on the reference device, so
+     * the reference device scores 1000 in every category, and the
+     * benchmarks it didn't run are left out.
+     *
+     * @param entries the benchmarks that were run successfully
+     * @param reference the results of the reference device, if any
+     *
+     * @return the sub-scores of the categories with benchmarks
+     */
+    static std::vector<SubScore> subscores(const std::vector<Entry> &entries,
+                                           const std::vector<BenchmarkResult> &reference);
+
+    /**
+     * Computes the geometric mean of sub-scores, so that every category
+     * counts the same.
+     */
+    static double combine(const std::vector<SubScore> &subscores);
+
+    /**
+     * Gets the category of a benchmark, when its score-category option
+     * isn't set.
+     *
+     * @param scene the name of the scene of the benchmark
+     * @param options the options of the benchmark, e.g. "use-vbo=false"
+     */
+    static std::string default_category(const std::string &scene,
+                                         const std::string &options);
+
+    /**
+     * Gets the name of a category to show, e.g. "Fragment ALU".
+     */
+    static std::string category_name(const std::string &category);
+};
+
+#endif
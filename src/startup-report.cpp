@@ -0,0 +1,150 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "startup-report.h"
+#include "log.h"
+#include "util.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+struct PhaseRecord
+{
+    PhaseRecord(const std::string &n, unsigned int d) :
+        name(n), depth(d), count(0), total(0) {}
+
+    std::string name;
+    /* How many phases enclosed the phase when it first ran */
+    unsigned int depth;
+    unsigned int count;
+    uint64_t total;
+};
+
+std::mutex mutex;
+bool enabled = false;
+bool finished = false;
+uint64_t start_time = 0;
+uint64_t first_frame_time = 0;
+std::vector<PhaseRecord> records;
+/* Phases can also run in the threads started by the scenes */
+thread_local unsigned int depth = 0;
+
+}
+
+StartupReport::Phase::Phase(const char *name) :
+    index_(-1), start_(0)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!enabled || finished)
+        return;
+
+    for (size_t i = 0; i < records.size(); i++) {
+        if (records[i].name == name) {
+            index_ = i;
+            break;
+        }
+    }
+
+    if (index_ < 0) {
+        records.push_back(PhaseRecord(name, depth));
+        index_ = records.size() - 1;
+    }
+
+    depth++;
+    start_ = Util::get_timestamp_us();
+}
+
+StartupReport::Phase::~Phase()
+{
+    if (index_ < 0)
+        return;
+
+    uint64_t end = Util::get_timestamp_us();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    depth--;
+
+    /* A phase that ends after the first frame still counts */
+    records[index_].count++;
+    records[index_].total += end - start_;
+}
+
+void
+StartupReport::start(bool enable)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    enabled = enable;
+    start_time = Util::get_timestamp_us();
+}
+
+void
+StartupReport::frame_presented()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!enabled || finished)
+        return;
+
+    finished = true;
+    first_frame_time = Util::get_timestamp_us();
+}
+
+void
+StartupReport::print()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!enabled)
+        return;
+
+    Log::info("=======================================================\n");
+    Log::info("    Startup Report\n");
+    Log::info("=======================================================\n");
+
+    for (std::vector<PhaseRecord>::const_iterator iter = records.begin();
+         iter != records.end();
+         iter++)
+    {
+        std::string indent(4 + 2 * iter->depth, ' ');
+
+        if (iter->count > 1) {
+            Log::info("%s%s (ms): %.3f (%u times)\n", indent.c_str(),
+                      iter->name.c_str(), iter->total / 1000.0, iter->count);
+        }
+        else {
+            Log::info("%s%s (ms): %.3f\n", indent.c_str(),
+                      iter->name.c_str(), iter->total / 1000.0);
+        }
+    }
+
+    if (finished) {
+        Log::info("    TimeToFirstFrame (ms): %.3f\n",
+                  (first_frame_time - start_time) / 1000.0);
+    }
+    else {
+        Log::info("    TimeToFirstFrame (ms): no frame was presented\n");
+    }
+
+    Log::info("=======================================================\n");
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_STARTUP_REPORT_H_
+#define GLMARK2_STARTUP_REPORT_H_
+
+#include <stdint.h>
+
+/**
+ * Measures the phases glmark2 goes through until it presents its first
+ * frame (display and context creation, config selection, scene setup,
+ * shader builds...), like an application does when it launches
+ * (--startup-report).
+ *
+ * A phase that runs more than once before the first frame is reported
+ * once, with its total time. Phases after the first frame are ignored.
+ */
+class StartupReport
+{
+public:
+    /**
+     * Times a named phase, for the lifetime of the object.
+     */
+    class Phase
+    {
+    public:
+        Phase(const char *name);
+        ~Phase();
+
+    private:
+        int index_;
+        uint64_t start_;
+    };
+
+    /**
+     * Starts measuring, if enabled. Must be called first thing in main().
+     */
+    static void start(bool enable);
+
+    /**
+     * Records that a frame has been presented. Only the first one counts.
+     */
+    static void frame_presented();
+
+    /**
+     * Prints the phases and the time to the first presented frame.
+     */
+    static void print();
+};
+
+#endif
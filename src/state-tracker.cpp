@@ -0,0 +1,316 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "state-tracker.h"
+#include "gl-headers.h"
+
+namespace
+{
+
+/* A name or value that is not known yet */
+const GLuint unknown = ~0U;
+
+const unsigned int max_texture_units = 32;
+
+/* The capabilities that glEnable/glDisable track */
+enum Capability {
+    CapabilityBlend,
+    CapabilityCullFace,
+    CapabilityDepthTest,
+    CapabilityDither,
+    CapabilityPolygonOffsetFill,
+    CapabilitySampleAlphaToCoverage,
+    CapabilitySampleCoverage,
+    CapabilityScissorTest,
+    CapabilityStencilTest,
+    CapabilityCount
+};
+
+struct ShadowState
+{
+    ShadowState() : calls(0), redundant_calls(0) { reset(); }
+
+    void reset()
+    {
+        program = unknown;
+        active_texture = unknown;
+        for (unsigned int i = 0; i < max_texture_units; i++) {
+            texture_2d[i] = unknown;
+            texture_cube_map[i] = unknown;
+        }
+        array_buffer = unknown;
+        draw_framebuffer = unknown;
+        read_framebuffer = unknown;
+        for (unsigned int i = 0; i < CapabilityCount; i++)
+            capabilities[i] = unknown;
+    }
+
+    GLuint program;
+    /* The index of the active texture unit */
+    GLuint active_texture;
+    GLuint texture_2d[max_texture_units];
+    GLuint texture_cube_map[max_texture_units];
+    GLuint array_buffer;
+    GLuint draw_framebuffer;
+    GLuint read_framebuffer;
+    GLuint capabilities[CapabilityCount];
+
+    uint64_t calls;
+    uint64_t redundant_calls;
+};
+
+/* Contexts are current on a single thread, so each thread has its state */
+thread_local ShadowState state = ShadowState();
+
+StateTracker::Mode tracker_mode = StateTracker::ModeOff;
+
+PFNGLUSEPROGRAMPROC real_UseProgram;
+PFNGLACTIVETEXTUREPROC real_ActiveTexture;
+PFNGLBINDTEXTUREPROC real_BindTexture;
+PFNGLDELETETEXTURESPROC real_DeleteTextures;
+PFNGLBINDBUFFERPROC real_BindBuffer;
+PFNGLDELETEBUFFERSPROC real_DeleteBuffers;
+PFNGLENABLEPROC real_Enable;
+PFNGLDISABLEPROC real_Disable;
+void (GLAD_API_PTR *real_BindFramebuffer)(GLenum target, GLuint framebuffer);
+void (GLAD_API_PTR *real_DeleteFramebuffers)(GLsizei n, const GLuint *framebuffers);
+
+/*
+ * Records a call that sets the shadowed value to a new value, and returns
+ * whether the call must be issued.
+ */
+bool
+update(GLuint &shadowed, GLuint value)
+{
+    state.calls++;
+
+    if (shadowed == value) {
+        state.redundant_calls++;
+        return tracker_mode != StateTracker::ModeFilter;
+    }
+
+    shadowed = value;
+    return true;
+}
+
+/* The shadowed texture binding of a target in the active unit, if tracked */
+GLuint *
+texture_binding(GLenum target)
+{
+    if (state.active_texture >= max_texture_units)
+        return 0;
+
+    if (target == GL_TEXTURE_2D)
+        return &state.texture_2d[state.active_texture];
+    else if (target == GL_TEXTURE_CUBE_MAP)
+        return &state.texture_cube_map[state.active_texture];
+
+    return 0;
+}
+
+GLuint *
+capability(GLenum cap)
+{
+    switch (cap) {
+        case GL_BLEND: return &state.capabilities[CapabilityBlend];
+        case GL_CULL_FACE: return &state.capabilities[CapabilityCullFace];
+        case GL_DEPTH_TEST: return &state.capabilities[CapabilityDepthTest];
+        case GL_DITHER: return &state.capabilities[CapabilityDither];
+        case GL_POLYGON_OFFSET_FILL: return &state.capabilities[CapabilityPolygonOffsetFill];
+        case GL_SAMPLE_ALPHA_TO_COVERAGE: return &state.capabilities[CapabilitySampleAlphaToCoverage];
+        case GL_SAMPLE_COVERAGE: return &state.capabilities[CapabilitySampleCoverage];
+        case GL_SCISSOR_TEST: return &state.capabilities[CapabilityScissorTest];
+        case GL_STENCIL_TEST: return &state.capabilities[CapabilityStencilTest];
+        default: return 0;
+    }
+}
+
+/* Deleting a bound object binds 0 in its place */
+void
+unbind_deleted(GLuint &shadowed, GLsizei n, const GLuint *names)
+{
+    for (GLsizei i = 0; i < n; i++) {
+        if (names[i] != 0 && shadowed == names[i])
+            shadowed = 0;
+    }
+}
+
+void GLAD_API_PTR
+tracked_UseProgram(GLuint program)
+{
+    if (update(state.program, program))
+        real_UseProgram(program);
+}
+
+void GLAD_API_PTR
+tracked_ActiveTexture(GLenum texture)
+{
+    if (update(state.active_texture, texture - GL_TEXTURE0))
+        real_ActiveTexture(texture);
+}
+
+void GLAD_API_PTR
+tracked_BindTexture(GLenum target, GLuint texture)
+{
+    GLuint *binding = texture_binding(target);
+
+    if (!binding || update(*binding, texture))
+        real_BindTexture(target, texture);
+}
+
+void GLAD_API_PTR
+tracked_DeleteTextures(GLsizei n, const GLuint *textures)
+{
+    /* Only the bindings of the other units are kept */
+    for (unsigned int i = 0; i < max_texture_units; i++) {
+        unbind_deleted(state.texture_2d[i], n, textures);
+        unbind_deleted(state.texture_cube_map[i], n, textures);
+    }
+
+    real_DeleteTextures(n, textures);
+}
+
+void GLAD_API_PTR
+tracked_BindBuffer(GLenum target, GLuint buffer)
+{
+    if (target != GL_ARRAY_BUFFER || update(state.array_buffer, buffer))
+        real_BindBuffer(target, buffer);
+}
+
+void GLAD_API_PTR
+tracked_DeleteBuffers(GLsizei n, const GLuint *buffers)
+{
+    unbind_deleted(state.array_buffer, n, buffers);
+    real_DeleteBuffers(n, buffers);
+}
+
+void GLAD_API_PTR
+tracked_Enable(GLenum cap)
+{
+    GLuint *enabled = capability(cap);
+
+    if (!enabled || update(*enabled, GL_TRUE))
+        real_Enable(cap);
+}
+
+void GLAD_API_PTR
+tracked_Disable(GLenum cap)
+{
+    GLuint *enabled = capability(cap);
+
+    if (!enabled || update(*enabled, GL_FALSE))
+        real_Disable(cap);
+}
+
+void GLAD_API_PTR
+tracked_BindFramebuffer(GLenum target, GLuint framebuffer)
+{
+    bool issue;
+
+    if (target == GL_DRAW_FRAMEBUFFER) {
+        issue = update(state.draw_framebuffer, framebuffer);
+    }
+    else if (target == GL_READ_FRAMEBUFFER) {
+        issue = update(state.read_framebuffer, framebuffer);
+    }
+    else if (target == GL_FRAMEBUFFER) {
+        /* Binds both the draw and the read framebuffers */
+        state.calls++;
+        issue = state.draw_framebuffer != framebuffer ||
+                state.read_framebuffer != framebuffer;
+        if (!issue) {
+            state.redundant_calls++;
+            issue = tracker_mode != StateTracker::ModeFilter;
+        }
+        state.draw_framebuffer = framebuffer;
+        state.read_framebuffer = framebuffer;
+    }
+    else {
+        issue = true;
+    }
+
+    if (issue)
+        real_BindFramebuffer(target, framebuffer);
+}
+
+void GLAD_API_PTR
+tracked_DeleteFramebuffers(GLsizei n, const GLuint *framebuffers)
+{
+    unbind_deleted(state.draw_framebuffer, n, framebuffers);
+    unbind_deleted(state.read_framebuffer, n, framebuffers);
+    real_DeleteFramebuffers(n, framebuffers);
+}
+
+/* Replaces an entry point by its tracked version, unless already done */
+template <typename T> void
+wrap(T &entry_point, T &real, T tracked)
+{
+    if (entry_point && entry_point != tracked) {
+        real = entry_point;
+        entry_point = tracked;
+    }
+}
+
+}
+
+void
+StateTracker::install(Mode mode)
+{
+    tracker_mode = mode;
+    if (mode == ModeOff)
+        return;
+
+    wrap(glad_glUseProgram, real_UseProgram, tracked_UseProgram);
+    wrap(glad_glActiveTexture, real_ActiveTexture, tracked_ActiveTexture);
+    wrap(glad_glBindTexture, real_BindTexture, tracked_BindTexture);
+    wrap(glad_glDeleteTextures, real_DeleteTextures, tracked_DeleteTextures);
+    wrap(glad_glBindBuffer, real_BindBuffer, tracked_BindBuffer);
+    wrap(glad_glDeleteBuffers, real_DeleteBuffers, tracked_DeleteBuffers);
+    wrap(glad_glEnable, real_Enable, tracked_Enable);
+    wrap(glad_glDisable, real_Disable, tracked_Disable);
+    wrap(GLExtensions::BindFramebuffer, real_BindFramebuffer, tracked_BindFramebuffer);
+    wrap(GLExtensions::DeleteFramebuffers, real_DeleteFramebuffers,
+         tracked_DeleteFramebuffers);
+
+    /* The entry points are loaded for a new context */
+    invalidate();
+}
+
+void
+StateTracker::invalidate()
+{
+    state.reset();
+}
+
+bool
+StateTracker::active()
+{
+    return tracker_mode != ModeOff;
+}
+
+uint64_t
+StateTracker::calls()
+{
+    return state.calls;
+}
+
+uint64_t
+StateTracker::redundant_calls()
+{
+    return state.redundant_calls;
+}
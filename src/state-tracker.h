@@ -0,0 +1,78 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_STATE_TRACKER_H_
+#define GLMARK2_STATE_TRACKER_H_
+
+#include <stdint.h>
+
+/**
+ * Shadows the GL state that the scenes change most often, to find the GL
+ * calls that don't change the state and optionally skip them.
+ *
+ * The tracker wraps the loaded GL entry points, so the calls of Mesh,
+ * Program, the scenes and the renderers are all tracked without changing
+ * them. The tracked calls are glUseProgram, glActiveTexture, glBindTexture
+ * (2D and cube map textures), glBindBuffer (array buffers),
+ * glBindFramebuffer and glEnable/glDisable of the common capabilities.
+ *
+ * The shadowed state is per thread, since each thread renders with its own
+ * context. It starts unknown, so the first call of each kind is always
+ * issued.
+ */
+class StateTracker
+{
+public:
+    enum Mode {
+        ModeOff,
+        /* Count the redundant calls, but still issue them */
+        ModeCount,
+        /* Skip the redundant calls */
+        ModeFilter
+    };
+
+    /**
+     * Wraps the loaded GL entry points, if the mode is not ModeOff. Must be
+     * called each time the entry points are loaded.
+     */
+    static void install(Mode mode);
+
+    /**
+     * Forgets the shadowed state of the current thread. Must be called when
+     * another context is made current on the thread.
+     */
+    static void invalidate();
+
+    /**
+     * Whether the tracker is installed.
+     */
+    static bool active();
+
+    /**
+     * The number of tracked calls made by the current thread.
+     */
+    static uint64_t calls();
+
+    /**
+     * The number of tracked calls made by the current thread that didn't
+     * change the state, which are skipped in ModeFilter.
+     */
+    static uint64_t redundant_calls();
+};
+
+#endif /* GLMARK2_STATE_TRACKER_H_ */
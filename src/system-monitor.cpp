@@ -0,0 +1,179 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "system-monitor.h"
+#include "log.h"
+#include "util.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+#ifdef __linux__
+
+bool
+file_exists(const std::string &path)
+{
+    std::ifstream file(path.c_str());
+    return file.good();
+}
+
+#endif
+
+/* Converts a sensor name to a key made of lowercase letters, digits and '_' */
+std::string
+sensor_key(const std::string &name)
+{
+    std::string key;
+
+    for (std::string::const_iterator iter = name.begin(); iter != name.end(); iter++) {
+        char c = *iter;
+        if (c >= 'A' && c <= 'Z')
+            key += c - 'A' + 'a';
+        else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))
+            key += c;
+        else
+            key += '_';
+    }
+
+    return key;
+}
+
+}
+
+void
+SystemMonitor::init()
+{
+    sensors_.clear();
+
+#ifdef __linux__
+    static const std::string thermal_dir("/sys/class/thermal");
+    static const std::string hwmon_dir("/sys/class/hwmon");
+    static const std::string cpufreq_dir("/sys/devices/system/cpu/cpufreq");
+    static const std::string devfreq_dir("/sys/class/devfreq");
+
+    /* Thermal zones, in millidegrees Celsius */
+    std::vector<std::string> zones(Util::list_dir(thermal_dir, "thermal_zone"));
+    for (size_t i = 0; i < zones.size(); i++) {
+        std::string path(thermal_dir + "/" + zones[i]);
+        std::string type(Util::read_first_line(path + "/type"));
+
+        add_sensor("temp_" + (type.empty() ? zones[i] : type), path + "/temp", 0.001);
+    }
+
+    /* Hardware monitor temperature inputs, in millidegrees Celsius */
+    std::vector<std::string> hwmons(Util::list_dir(hwmon_dir, "hwmon"));
+    for (size_t i = 0; i < hwmons.size(); i++) {
+        std::string path(hwmon_dir + "/" + hwmons[i]);
+        std::string name(Util::read_first_line(path + "/name"));
+        std::vector<std::string> inputs(Util::list_dir(path, "temp"));
+
+        for (size_t j = 0; j < inputs.size(); j++) {
+            const std::string &input(inputs[j]);
+            static const std::string suffix("_input");
+
+            if (input.size() <= suffix.size() ||
+                input.compare(input.size() - suffix.size(), suffix.size(), suffix) != 0)
+            {
+                continue;
+            }
+
+            std::string id(input.substr(0, input.size() - suffix.size()));
+            std::string label(Util::read_first_line(path + "/" + id + "_label"));
+
+            add_sensor("temp_" + (name.empty() ? hwmons[i] : name) + "_" +
+                       (label.empty() ? id : label),
+                       path + "/" + input, 0.001);
+        }
+    }
+
+    /* CPU frequency policies, in kHz */
+    std::vector<std::string> policies(Util::list_dir(cpufreq_dir, "policy"));
+    for (size_t i = 0; i < policies.size(); i++) {
+        add_sensor("cpufreq_" + policies[i] + "_mhz",
+                   cpufreq_dir + "/" + policies[i] + "/scaling_cur_freq", 0.001);
+    }
+
+    /* Device frequencies (e.g. GPUs), in Hz */
+    std::vector<std::string> devices(Util::list_dir(devfreq_dir, ""));
+    for (size_t i = 0; i < devices.size(); i++) {
+        add_sensor("devfreq_" + devices[i] + "_mhz",
+                   devfreq_dir + "/" + devices[i] + "/cur_freq", 0.000001);
+    }
+#endif
+
+    Log::debug("SystemMonitor: Found %u sensors\n",
+               static_cast<unsigned int>(sensors_.size()));
+}
+
+SystemMonitor::Readings
+SystemMonitor::read() const
+{
+    Readings readings;
+
+    for (std::vector<Sensor>::const_iterator iter = sensors_.begin();
+         iter != sensors_.end();
+         iter++)
+    {
+        std::ifstream file(iter->path.c_str());
+        double value;
+
+        if (file >> value)
+            readings.push_back(std::make_pair(iter->name, value * iter->scale));
+    }
+
+    return readings;
+}
+
+void
+SystemMonitor::add_sensor(const std::string &name, const std::string &path,
+                          double scale)
+{
+#ifdef __linux__
+    if (!file_exists(path))
+        return;
+#endif
+
+    std::string key(sensor_key(name));
+
+    /* Keep the keys unique, e.g. for hwmon devices with the same name */
+    std::string unique_key(key);
+    for (unsigned int n = 2; has_sensor(unique_key); n++) {
+        std::stringstream ss;
+        ss << key << "_" << n;
+        unique_key = ss.str();
+    }
+
+    sensors_.push_back(Sensor(unique_key, path, scale));
+}
+
+bool
+SystemMonitor::has_sensor(const std::string &name) const
+{
+    for (std::vector<Sensor>::const_iterator iter = sensors_.begin();
+         iter != sensors_.end();
+         iter++)
+    {
+        if (iter->name == name)
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_SYSTEM_MONITOR_H_
+#define GLMARK2_SYSTEM_MONITOR_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Reads the temperatures and clock frequencies of the system.
+ *
+ * On Linux, the sensors are discovered in sysfs: the thermal zones and
+ * hwmon temperature inputs (in degrees Celsius), and the cpufreq policies
+ * and devfreq devices (e.g. GPUs and memory controllers, in MHz). On other
+ * systems there are no sensors.
+ */
+class SystemMonitor
+{
+public:
+    typedef std::vector<std::pair<std::string, double> > Readings;
+
+    /**
+     * Discovers the available sensors.
+     */
+    void init();
+
+    /**
+     * Reads the current values of the sensors.
+     *
+     * @return the values, keyed by sensor name (e.g. "temp_gpu_thermal" or
+     *         "devfreq_fb000000_gpu_mhz")
+     */
+    Readings read() const;
+
+    /**
+     * Gets the number of discovered sensors.
+     */
+    size_t sensor_count() const { return sensors_.size(); }
+
+private:
+    struct Sensor {
+        Sensor(const std::string &n, const std::string &p, double s) :
+            name(n), path(p), scale(s) {}
+
+        std::string name;
+        std::string path;
+        /* The factor converting the raw sysfs value to the reported unit */
+        double scale;
+    };
+
+    void add_sensor(const std::string &name, const std::string &path, double scale);
+    bool has_sensor(const std::string &name) const;
+
+    std::vector<Sensor> sensors_;
+};
+
+#endif /* GLMARK2_SYSTEM_MONITOR_H_ */
@@ -27,6 +27,10 @@
 #include "vec.h"
 #include "mat.h"
 #include "texture.h"
+#include "debug-markers.h"
+
+#include <algorithm>
+#include <cstddef>
 
 using LibMatrix::vec2;
 using LibMatrix::mat4;
@@ -36,6 +40,13 @@ static const unsigned int texture_size(512);
 static const vec2 glyph_size_pixels(29.0, 57.0);
 static const vec2 glyph_size(glyph_size_pixels/texture_size);
 
+/* The corners of a glyph quad, as a triangle strip and as two triangles */
+static const float quad_strip[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+static const float quad_triangles[] = {
+    0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+    0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 1.0f
+};
+
 /******************
  * Public methods *
  ******************/
@@ -44,12 +55,20 @@ static const vec2 glyph_size(glyph_size_pixels/texture_size);
  * TextRenderer default constructor.
  */
 TextRenderer::TextRenderer(Canvas& canvas) :
-    canvas_(canvas), dirty_(false), position_(-1.0, -1.0),
+    canvas_(canvas), dirty_(false), instanced_(false), capacity_(0),
     texture_(0)
 {
-    size(0.03);
+    instanced_ = GLExtensions::DrawArraysInstanced != 0 &&
+                 GLExtensions::VertexAttribDivisor != 0;
 
     glGenBuffers(2, vbo_);
+
+    GLint prev_array_buffer = 0;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prev_array_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_[0]);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad_strip), quad_strip, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, prev_array_buffer);
+
     ShaderSource vtx_source(Options::data_path + "/shaders/text-renderer.vert");
     ShaderSource frg_source(Options::data_path + "/shaders/text-renderer.frag");
 
@@ -64,6 +83,7 @@ TextRenderer::TextRenderer(Canvas& canvas) :
 
     program_.start();
     program_["Texture0"] = 0;
+    program_["GlyphSize"] = glyph_size;
 
     glUseProgram(prev_program);
 
@@ -76,19 +96,38 @@ TextRenderer::TextRenderer(Canvas& canvas) :
 TextRenderer::~TextRenderer()
 {
     glDeleteBuffers(2, vbo_);
-    glDeleteTextures(1, &texture_);
+    Texture::release(1, &texture_);
+}
+
+/**
+ * Adds a string to render.
+ *
+ * @return the id of the string
+ */
+unsigned int
+TextRenderer::add()
+{
+    String str;
+    str.position = vec2(-1.0, -1.0);
+    strings_.push_back(str);
+
+    unsigned int id = strings_.size() - 1;
+    size(id, 0.03);
+
+    return id;
 }
 
 /**
  * Sets the text string to render.
  *
+ * @param id the id of the string
  * @param t the text string
  */
 void
-TextRenderer::text(const std::string& t)
+TextRenderer::text(unsigned int id, const std::string& t)
 {
-    if (text_ != t) {
-        text_ = t;
+    if (strings_[id].text != t) {
+        strings_[id].text = t;
         dirty_ = true;
     }
 }
@@ -96,13 +135,14 @@ TextRenderer::text(const std::string& t)
 /**
  * Sets the screen position to render at.
  *
+ * @param id the id of the string
  * @param t the position
  */
 void
-TextRenderer::position(const LibMatrix::vec2& p)
+TextRenderer::position(unsigned int id, const LibMatrix::vec2& p)
 {
-    if (position_ != p) {
-        position_ = p;
+    if (strings_[id].position != p) {
+        strings_[id].position = p;
         dirty_ = true;
     }
 }
@@ -113,31 +153,33 @@ TextRenderer::position(const LibMatrix::vec2& p)
  * The size corresponds to the width of each glyph
  * in normalized screen coordinates.
  *
+ * @param id the id of the string
  * @param s the size of each glyph
  */
 void
-TextRenderer::size(float s)
+TextRenderer::size(unsigned int id, float s)
 {
-    if (size_.x() != s) {
+    if (strings_[id].size.x() != s) {
         /* Take into account the glyph and canvas aspect ratio */
         double canvas_aspect =
             static_cast<double>(canvas_.width()) / canvas_.height();
         double glyph_aspect_rev = glyph_size.y() / glyph_size.x();
-        size_ = vec2(s, s * canvas_aspect * glyph_aspect_rev);
+        strings_[id].size = vec2(s, s * canvas_aspect * glyph_aspect_rev);
         dirty_ = true;
     }
 }
 
 /**
- * Renders the text.
+ * Renders all the strings.
  */
 void
 TextRenderer::render()
 {
+    DebugMarkers::Group group("text");
+
     /* Save state */
     GLint prev_program = 0;
     GLint prev_array_buffer = 0;
-    GLint prev_elem_array_buffer = 0;
     GLint prev_blend_src_rgb = 0;
     GLint prev_blend_dst_rgb = 0;
     GLint prev_blend_src_alpha = 0;
@@ -146,7 +188,6 @@ TextRenderer::render()
     GLboolean prev_depth_test = GL_FALSE;
     glGetIntegerv(GL_CURRENT_PROGRAM, &prev_program);
     glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prev_array_buffer);
-    glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &prev_elem_array_buffer);
     glGetIntegerv(GL_BLEND_SRC_RGB, &prev_blend_src_rgb);
     glGetIntegerv(GL_BLEND_DST_RGB, &prev_blend_dst_rgb);
     glGetIntegerv(GL_BLEND_SRC_ALPHA, &prev_blend_src_alpha);
@@ -157,32 +198,58 @@ TextRenderer::render()
     /* Set new state */
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, texture_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_[0]);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbo_[1]);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     glDisable(GL_DEPTH_TEST);
 
     if (dirty_) {
         create_geometry();
+        upload_geometry();
         dirty_ = false;
     }
 
     program_.start();
-    GLint position_loc = program_["position"].location();
+    GLint corner_loc = program_["corner"].location();
+    GLint rect_loc = program_["rect"].location();
     GLint texcoord_loc = program_["texcoord"].location();
 
-    /* Render */
-    glEnableVertexAttribArray(position_loc);
+    glEnableVertexAttribArray(corner_loc);
+    glEnableVertexAttribArray(rect_loc);
     glEnableVertexAttribArray(texcoord_loc);
-    glVertexAttribPointer(position_loc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    glVertexAttribPointer(texcoord_loc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float),
-                          reinterpret_cast<const GLvoid *>(2 * sizeof(float)));
 
-    glDrawElements(GL_TRIANGLES, 6 * text_.length(), GL_UNSIGNED_SHORT, 0);
+    /* Render all the glyphs at once */
+    if (instanced_) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_[0]);
+        glVertexAttribPointer(corner_loc, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_[1]);
+        glVertexAttribPointer(rect_loc, 4, GL_FLOAT, GL_FALSE, sizeof(Glyph),
+                              reinterpret_cast<const GLvoid *>(offsetof(Glyph, rect)));
+        glVertexAttribPointer(texcoord_loc, 2, GL_FLOAT, GL_FALSE, sizeof(Glyph),
+                              reinterpret_cast<const GLvoid *>(offsetof(Glyph, texcoord)));
+        GLExtensions::VertexAttribDivisor(rect_loc, 1);
+        GLExtensions::VertexAttribDivisor(texcoord_loc, 1);
+
+        GLExtensions::DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, glyphs_.size());
+
+        GLExtensions::VertexAttribDivisor(texcoord_loc, 0);
+        GLExtensions::VertexAttribDivisor(rect_loc, 0);
+    }
+    else {
+        static const GLsizei stride = 8 * sizeof(float);
+
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_[1]);
+        glVertexAttribPointer(corner_loc, 2, GL_FLOAT, GL_FALSE, stride, 0);
+        glVertexAttribPointer(rect_loc, 4, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const GLvoid *>(2 * sizeof(float)));
+        glVertexAttribPointer(texcoord_loc, 2, GL_FLOAT, GL_FALSE, stride,
+                              reinterpret_cast<const GLvoid *>(6 * sizeof(float)));
+
+        glDrawArrays(GL_TRIANGLES, 0, 6 * glyphs_.size());
+    }
 
     glDisableVertexAttribArray(texcoord_loc);
-    glDisableVertexAttribArray(position_loc);
+    glDisableVertexAttribArray(rect_loc);
+    glDisableVertexAttribArray(corner_loc);
 
     /* Restore state */
     if (prev_depth_test == GL_TRUE)
@@ -192,7 +259,6 @@ TextRenderer::render()
     glBlendFuncSeparate(prev_blend_src_rgb, prev_blend_dst_rgb,
                         prev_blend_src_alpha, prev_blend_dst_alpha);
     glBindBuffer(GL_ARRAY_BUFFER, prev_array_buffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, prev_elem_array_buffer);
     glUseProgram(prev_program);
 }
 
@@ -201,71 +267,81 @@ TextRenderer::render()
  *******************/
 
 /**
- * Creates the geometry needed to render the text.
- *
- * This method assumes that the text VBOs are properly bound.
+ * Creates the glyphs of all the strings.
  */
 void
 TextRenderer::create_geometry()
 {
-    std::vector<float> array;
-    std::vector<GLushort> elem_array;
-    vec2 pos(position_);
-
-    for (size_t i = 0; i < text_.size(); i++) {
-        vec2 texcoord = get_glyph_coords(text_[i]);
-
-        /* Emit the elements for this glyph quad */
-        /* Lower left */
-        array.push_back(pos.x());
-        array.push_back(pos.y());
-        array.push_back(texcoord.x());
-        array.push_back(texcoord.y());
-
-        /* Lower right */
-        pos.x(pos.x() + size_.x());
-        texcoord.x(texcoord.x() + glyph_size.x());
-        array.push_back(pos.x());
-        array.push_back(pos.y());
-        array.push_back(texcoord.x());
-        array.push_back(texcoord.y());
-
-        /* Upper left */
-        pos.x(pos.x() - size_.x());
-        pos.y(pos.y() + size_.y());
-        texcoord.x(texcoord.x() - glyph_size.x());
-        texcoord.y(texcoord.y() + glyph_size.y());
-        array.push_back(pos.x());
-        array.push_back(pos.y());
-        array.push_back(texcoord.x());
-        array.push_back(texcoord.y());
-
-        /* Upper right */
-        pos.x(pos.x() + size_.x());
-        texcoord.x(texcoord.x() + glyph_size.x());
-        array.push_back(pos.x());
-        array.push_back(pos.y());
-        array.push_back(texcoord.x());
-        array.push_back(texcoord.y());
-
-        /* Prepare for the next glyph */
-        pos.y(pos.y() - size_.y());
-
-        /* Emit the element indices for this glyph quad */
-        elem_array.push_back(4 * i);
-        elem_array.push_back(4 * i + 1);
-        elem_array.push_back(4 * i + 2);
-        elem_array.push_back(4 * i + 2);
-        elem_array.push_back(4 * i + 1);
-        elem_array.push_back(4 * i + 3);
+    glyphs_.clear();
+
+    for (std::vector<String>::const_iterator iter = strings_.begin();
+         iter != strings_.end();
+         iter++)
+    {
+        vec2 pos(iter->position);
+
+        for (size_t i = 0; i < iter->text.size(); i++) {
+            vec2 texcoord = get_glyph_coords(iter->text[i]);
+            Glyph glyph = {
+                { pos.x(), pos.y(), iter->size.x(), iter->size.y() },
+                { texcoord.x(), texcoord.y() }
+            };
+
+            glyphs_.push_back(glyph);
+            pos.x(pos.x() + iter->size.x());
+        }
+    }
+
+    if (instanced_)
+        return;
+
+    /* Without instancing, each glyph is expanded to two triangles */
+    vertices_.clear();
+
+    for (std::vector<Glyph>::const_iterator iter = glyphs_.begin();
+         iter != glyphs_.end();
+         iter++)
+    {
+        for (unsigned int v = 0; v < 6; v++) {
+            vertices_.insert(vertices_.end(), quad_triangles + 2 * v,
+                             quad_triangles + 2 * v + 2);
+            vertices_.insert(vertices_.end(), iter->rect, iter->rect + 4);
+            vertices_.insert(vertices_.end(), iter->texcoord, iter->texcoord + 2);
+        }
+    }
+}
+
+/**
+ * Updates the glyph buffer, which is only reallocated when it grows.
+ *
+ * This method assumes that no other array buffer needs to stay bound.
+ */
+void
+TextRenderer::upload_geometry()
+{
+    const void *data;
+    size_t size;
+
+    if (instanced_) {
+        data = glyphs_.empty() ? 0 : &glyphs_[0];
+        size = glyphs_.size() * sizeof(Glyph);
     }
+    else {
+        data = vertices_.empty() ? 0 : &vertices_[0];
+        size = vertices_.size() * sizeof(float);
+    }
+
+    if (size == 0)
+        return;
 
-    /* Load the data into the corresponding VBOs */
-    glBufferData(GL_ARRAY_BUFFER, array.size() * sizeof(float),
-                 &array[0], GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_[1]);
+
+    if (size > capacity_) {
+        capacity_ = std::max(size, 2 * capacity_);
+        glBufferData(GL_ARRAY_BUFFER, capacity_, 0, GL_DYNAMIC_DRAW);
+    }
 
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, elem_array.size() * sizeof(GLushort),
-                 &elem_array[0], GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
 }
 
 /**
@@ -23,6 +23,7 @@
 #define GLMARK2_TEXT_RENDERER_H_
 
 #include <string>
+#include <vector>
 #include "gl-headers.h"
 #include "vec.h"
 #include "program.h"
@@ -30,6 +31,11 @@
 
 /**
  * Renders text using OpenGL textures.
+ *
+ * All the strings of a renderer are drawn with a single draw call, one
+ * instanced quad per glyph when instancing is supported. The glyphs are
+ * kept in a persistent vertex buffer that is only updated when a string
+ * changes.
  */
 class TextRenderer
 {
@@ -37,23 +43,50 @@ public:
     TextRenderer(Canvas& canvas);
     ~TextRenderer();
 
-    void text(const std::string& t);
-    void position(const LibMatrix::vec2& p);
-    void size(float s);
+    /**
+     * Adds a string to render, initially empty.
+     *
+     * @return the id of the string, for the setters below
+     */
+    unsigned int add();
+
+    void text(unsigned int id, const std::string& t);
+    void position(unsigned int id, const LibMatrix::vec2& p);
+    void size(unsigned int id, float s);
 
     void render();
 
 private:
+    struct String {
+        std::string text;
+        LibMatrix::vec2 position;
+        LibMatrix::vec2 size;
+    };
+
+    /* The instance data of a glyph */
+    struct Glyph {
+        /* The lower left corner and the size, in normalized screen coordinates */
+        float rect[4];
+        /* The lower left corner in the glyph atlas */
+        float texcoord[2];
+    };
+
     void create_geometry();
+    void upload_geometry();
     LibMatrix::vec2 get_glyph_coords(char c);
 
     Canvas& canvas_;
     bool dirty_;
-    std::string text_;
-    LibMatrix::vec2 position_;
-    LibMatrix::vec2 size_;
+    bool instanced_;
+    std::vector<String> strings_;
+    /* Reused across updates, to avoid reallocating */
+    std::vector<Glyph> glyphs_;
+    std::vector<float> vertices_;
     Program program_;
+    /* The quad corners, and the glyphs */
     GLuint vbo_[2];
+    /* The number of bytes allocated in vbo_[1] */
+    size_t capacity_;
     GLuint texture_;
 };
 
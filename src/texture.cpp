@@ -25,10 +25,19 @@
 #include "log.h"
 #include "options.h"
 #include "util.h"
+#include "trace.h"
+#include "debug-markers.h"
+#include "isolation.h"
 #include "image-reader.h"
 
 #include <algorithm>
+#include <condition_variable>
 #include <cstdarg>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <vector>
 
 class ImageData {
@@ -74,11 +83,117 @@ ImageData::load(ImageReader &reader)
     return !reader.error();
 }
 
+/*
+ * Downsamples rows [row_start, row_end) of the next mipmap level with a 2x2
+ * box filter. Odd source dimensions repeat the last row/column. The inner
+ * loop works on plain bytes so that the compiler can vectorize it.
+ */
 static void
-setup_texture(GLuint *tex, ImageData &image, GLint min_filter, GLint mag_filter)
+downsample_rows(const unsigned char *src, unsigned int width, unsigned int height,
+                unsigned int bpp, unsigned char *dst, unsigned int dst_width,
+                unsigned int row_start, unsigned int row_end)
+{
+    const size_t src_stride = static_cast<size_t>(width) * bpp;
+    const size_t dst_stride = static_cast<size_t>(dst_width) * bpp;
+    const unsigned int next_col = width > 1 ? bpp : 0;
+
+    for (unsigned int y = row_start; y < row_end; y++) {
+        const unsigned char *row0 = src + 2 * y * src_stride;
+        const unsigned char *row1 = 2 * y + 1 < height ? row0 + src_stride : row0;
+        unsigned char *out = dst + y * dst_stride;
+
+        for (unsigned int x = 0; x < dst_width; x++) {
+            const unsigned int o0 = 2 * x * bpp;
+            const unsigned int o1 = 2 * x + 1 < width ? o0 + next_col : o0;
+
+            for (unsigned int c = 0; c < bpp; c++) {
+                out[x * bpp + c] =
+                    (row0[o0 + c] + row0[o1 + c] + row1[o0 + c] + row1[o1 + c] + 2) >> 2;
+            }
+        }
+    }
+}
+
+/*
+ * Computes the next mipmap level, splitting large levels between threads.
+ */
+static void
+downsample(const unsigned char *src, unsigned int width, unsigned int height,
+           unsigned int bpp, unsigned char *dst, unsigned int dst_width,
+           unsigned int dst_height)
+{
+    static const unsigned int min_pixels_per_thread = 128 * 128;
+    unsigned int nthreads =
+        std::min(std::max(std::thread::hardware_concurrency(), 1U), 8U);
+
+    nthreads = std::min(nthreads, std::max(dst_width * dst_height / min_pixels_per_thread, 1U));
+
+    if (nthreads == 1) {
+        downsample_rows(src, width, height, bpp, dst, dst_width, 0, dst_height);
+        return;
+    }
+
+    std::vector<std::thread> threads;
+
+    for (unsigned int i = 0; i < nthreads; i++) {
+        unsigned int start = dst_height * i / nthreads;
+        unsigned int end = dst_height * (i + 1) / nthreads;
+        threads.push_back(std::thread(downsample_rows, src, width, height, bpp,
+                                      dst, dst_width, start, end));
+    }
+
+    for (std::vector<std::thread>::iterator iter = threads.begin(); iter != threads.end(); iter++)
+        iter->join();
+}
+
+/* The time spent uploading textures, see Texture::take_upload_time_us() */
+static thread_local uint64_t upload_time_us = 0;
+
+/*
+ * Uploads all the mipmap levels of an image, computing them on the CPU.
+ */
+static void
+upload_cpu_mipmaps(ImageData &image, GLenum format)
+{
+    std::vector<unsigned char> levels[2];
+    const unsigned char *src = image.pixels;
+    unsigned int width = image.width;
+    unsigned int height = image.height;
+    GLint level = 0;
+
+    /* Smaller levels don't have 4-byte aligned rows */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    glTexImage2D(GL_TEXTURE_2D, level, format, width, height, 0,
+                 format, GL_UNSIGNED_BYTE, src);
+
+    while (width > 1 || height > 1) {
+        unsigned int dst_width = std::max(width / 2, 1U);
+        unsigned int dst_height = std::max(height / 2, 1U);
+        std::vector<unsigned char> &dst = levels[++level % 2];
+
+        dst.resize(static_cast<size_t>(dst_width) * dst_height * image.bpp);
+        downsample(src, width, height, image.bpp, &dst[0], dst_width, dst_height);
+
+        glTexImage2D(GL_TEXTURE_2D, level, format, dst_width, dst_height, 0,
+                     format, GL_UNSIGNED_BYTE, &dst[0]);
+
+        src = &dst[0];
+        width = dst_width;
+        height = dst_height;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+static void
+setup_texture(GLuint *tex, ImageData &image, GLint min_filter, GLint mag_filter,
+              Texture::MipmapMode mipmap_mode)
 {
     GLenum format = image.bpp == 3 ? GL_RGB : GL_RGBA;
     bool needs_mipmap = min_filter != GL_NEAREST && min_filter != GL_LINEAR;
+    bool gpu_mipmap = needs_mipmap && mipmap_mode == Texture::MipmapGPU;
+    uint64_t start = Util::get_timestamp_us();
 
     glGenTextures(1, tex);
     glBindTexture(GL_TEXTURE_2D, *tex);
@@ -86,23 +201,484 @@ setup_texture(GLuint *tex, ImageData &image, GLint min_filter, GLint mag_filter)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    if (needs_mipmap && !GLExtensions::GenerateMipmap)
+
+    if (needs_mipmap && !gpu_mipmap) {
+        upload_cpu_mipmaps(image, format);
+        upload_time_us += Util::get_timestamp_us() - start;
+        return;
+    }
+
+    /* Images decoded at a reduced scale may not have 4-byte aligned rows */
+    bool aligned = (image.width * image.bpp) % 4 == 0;
+
+    if (!aligned)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (gpu_mipmap && !GLExtensions::GenerateMipmap)
         glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
     glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0,
                  format, GL_UNSIGNED_BYTE, image.pixels);
+    if (!aligned)
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
-    if (needs_mipmap && GLExtensions::GenerateMipmap)
+    if (gpu_mipmap && GLExtensions::GenerateMipmap)
         GLExtensions::GenerateMipmap(GL_TEXTURE_2D);
+
+    upload_time_us += Util::get_timestamp_us() - start;
+}
+
+/*
+ * Whether images can be decoded straight into a mapped pixel unpack buffer.
+ */
+static bool
+unpack_buffer_supported()
+{
+#if GLMARK2_USE_GLESv2
+    /* Pixel unpack buffers are only available in GLES 3.0 */
+    if (!GLExtensions::version_supported(3, 0))
+        return false;
+#endif
+
+    return GLExtensions::MapBufferRange && GLExtensions::UnmapBuffer;
+}
+
+enum DirectUpload {
+    DirectUploadUnavailable,
+    DirectUploadDone,
+    DirectUploadFailed
+};
+
+/*
+ * Decodes an image straight into a mapped pixel unpack buffer and creates
+ * the texture from it, saving the copy through a heap buffer. The image
+ * isn't read if the buffer can't be mapped, so that the caller can still
+ * decode it into memory.
+ */
+static DirectUpload
+setup_texture_direct(GLuint *tex, ImageReader &reader, GLint min_filter,
+                     GLint mag_filter, Texture::MipmapMode mipmap_mode)
+{
+    if (reader.error())
+        return DirectUploadFailed;
+
+    ImageData image;
+    image.width = reader.width();
+    image.height = reader.height();
+    image.bpp = reader.pixelBytes();
+
+    const size_t stride = static_cast<size_t>(image.width) * image.bpp;
+    const size_t size = stride * image.height;
+    GLuint pbo = 0;
+
+    glGenBuffers(1, &pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_STREAM_DRAW);
+
+    unsigned char *dest = static_cast<unsigned char *>(
+        GLExtensions::MapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                     GL_MAP_WRITE_BIT |
+                                     GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!dest) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glDeleteBuffers(1, &pbo);
+        return DirectUploadUnavailable;
+    }
+
+    Log::debug("    Height: %d Width: %d Bpp: %d (direct)\n",
+               image.width, image.height, image.bpp);
+
+    /* Rows in reverse Y order, like ImageData::load() */
+    unsigned char *ptr = dest + stride * (image.height - 1);
+    unsigned int rows = 0;
+
+    while (rows < image.height && reader.nextRow(ptr)) {
+        ptr -= stride;
+        rows++;
+    }
+
+    bool ok = rows == image.height && !reader.error();
+
+    /* The buffer contents are undefined if unmapping fails */
+    if (!GLExtensions::UnmapBuffer(GL_PIXEL_UNPACK_BUFFER))
+        ok = false;
+
+    /* With the unpack buffer bound, the null pixels are offset 0 in it */
+    if (ok)
+        setup_texture(tex, image, min_filter, mag_filter, mipmap_mode);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    glDeleteBuffers(1, &pbo);
+
+    return ok ? DirectUploadDone : DirectUploadFailed;
+}
+
+/*
+ * Whether a compressed texture format can be used.
+ *
+ * Implementations don't have to list all the formats they support in
+ * GL_COMPRESSED_TEXTURE_FORMATS, so check the relevant extensions too.
+ */
+static bool
+compressed_format_supported(GLenum format)
+{
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &num_formats);
+
+    if (num_formats > 0) {
+        std::vector<GLint> formats(num_formats);
+        glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, &formats[0]);
+        if (std::find(formats.begin(), formats.end(), static_cast<GLint>(format)) !=
+            formats.end())
+        {
+            return true;
+        }
+    }
+
+    /* ETC2/EAC */
+    if (format >= 0x9270 && format <= 0x9279) {
+#if GLMARK2_USE_GLESv2
+        return GLExtensions::version_supported(3, 0);
+#else
+        return GLExtensions::version_supported(4, 3) ||
+               GLExtensions::support("GL_ARB_ES3_compatibility");
+#endif
+    }
+    /* ASTC LDR */
+    if ((format >= 0x93B0 && format <= 0x93BD) || (format >= 0x93D0 && format <= 0x93DD))
+        return GLExtensions::support("GL_KHR_texture_compression_astc_ldr");
+    /* BPTC (BC7) */
+    if (format >= 0x8E8C && format <= 0x8E8F) {
+        return GLExtensions::support("GL_ARB_texture_compression_bptc") ||
+               GLExtensions::support("GL_EXT_texture_compression_bptc");
+    }
+    /* S3TC (BC1-3) */
+    if (format >= 0x83F0 && format <= 0x83F3)
+        return GLExtensions::support("GL_EXT_texture_compression_s3tc");
+    if (format >= 0x8C4C && format <= 0x8C4F)
+        return GLExtensions::support("GL_EXT_texture_compression_s3tc_srgb");
+    /* ETC1 */
+    if (format == 0x8D64)
+        return GLExtensions::support("GL_OES_compressed_ETC1_RGB8_texture");
+
+    return false;
+}
+
+/*
+ * Creates a texture from compressed data, using the mipmap levels stored
+ * in the file. Compressed data can't be used to generate mipmaps, so a
+ * mipmapped minification filter falls back to GL_LINEAR when the file
+ * contains a single level.
+ */
+static bool
+setup_compressed_texture(GLuint *tex, KTXReader &reader, GLint min_filter, GLint mag_filter)
+{
+    bool needs_mipmap = min_filter != GL_NEAREST && min_filter != GL_LINEAR;
+
+    if (needs_mipmap && reader.levels() == 1) {
+        Log::debug("Compressed texture has no mipmaps, using GL_LINEAR filtering\n");
+        min_filter = GL_LINEAR;
+        needs_mipmap = false;
+    }
+
+    uint64_t start = Util::get_timestamp_us();
+
+    glGenTextures(1, tex);
+    glBindTexture(GL_TEXTURE_2D, *tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    unsigned int levels = needs_mipmap ? reader.levels() : 1;
+
+    /* Files don't have to contain the full mipmap chain */
+#if GLMARK2_USE_GLESv2
+    if (GLExtensions::version_supported(3, 0))
+#endif
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+    for (unsigned int i = 0; i < levels; i++) {
+        GLsizei width = std::max(reader.width() >> i, 1U);
+        GLsizei height = std::max(reader.height() >> i, 1U);
+
+        glCompressedTexImage2D(GL_TEXTURE_2D, i, reader.internalFormat(),
+                               width, height, 0, reader.levelSize(i),
+                               reader.levelData(i));
+    }
+
+    upload_time_us += Util::get_timestamp_us() - start;
+
+    GLenum err = glGetError();
+    if (err != GL_NO_ERROR) {
+        Log::error("Failed to upload compressed texture (GL error 0x%x)\n", err);
+        return false;
+    }
+
+    return true;
 }
 
 namespace TexturePrivate
 {
 TextureMap textureMap;
+
+/*
+ * An image decoded in the background by Texture::prefetch(). It is kept
+ * until it has been loaded as many times as it was requested.
+ */
+struct PrefetchedImage
+{
+    PrefetchedImage(const std::string &pathname, TextureDescriptor::FileType filetype) :
+        pathname(pathname), filetype(filetype), ready(false), ok(false),
+        discarded(false), uses(0) {}
+
+    std::string pathname;
+    TextureDescriptor::FileType filetype;
+    ImageData image;
+    bool ready;
+    bool ok;
+    /* No longer needed, to be deleted by the worker decoding it */
+    bool discarded;
+    unsigned int uses;
+};
+
+class Prefetcher
+{
+public:
+    Prefetcher() : quit_(false) {}
+
+    ~Prefetcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        cond_.notify_all();
+
+        for (std::vector<std::thread>::iterator iter = workers_.begin();
+             iter != workers_.end();
+             iter++)
+        {
+            iter->join();
+        }
+
+        for (std::map<std::string, PrefetchedImage *>::iterator iter = images_.begin();
+             iter != images_.end();
+             iter++)
+        {
+            delete iter->second;
+        }
+
+        for (std::deque<PrefetchedImage *>::iterator iter = queue_.begin();
+             iter != queue_.end();
+             iter++)
+        {
+            if ((*iter)->discarded)
+                delete *iter;
+        }
+    }
+
+    void add(const std::string &name, const TextureDescriptor &desc)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::map<std::string, PrefetchedImage *>::iterator iter = images_.find(name);
+        if (iter == images_.end()) {
+            PrefetchedImage *prefetched = new PrefetchedImage(desc.pathname(), desc.filetype());
+            iter = images_.insert(std::make_pair(name, prefetched)).first;
+            queue_.push_back(prefetched);
+        }
+
+        iter->second->uses++;
+    }
+
+    void start()
+    {
+        unsigned int nthreads = std::min(std::max(std::thread::hardware_concurrency(), 1U), 4U);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        nthreads = std::min(nthreads, static_cast<unsigned int>(queue_.size()));
+        while (workers_.size() < nthreads)
+            workers_.push_back(std::thread(&Prefetcher::run, this));
+
+        cond_.notify_all();
+    }
+
+    /*
+     * Gets a prefetched image, waiting for it to be decoded if needed. The
+     * image must be released with ::release() after it has been used.
+     */
+    PrefetchedImage *acquire(const std::string &name)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        std::map<std::string, PrefetchedImage *>::iterator iter = images_.find(name);
+        if (iter == images_.end())
+            return 0;
+
+        PrefetchedImage *prefetched = iter->second;
+        cond_.wait(lock, [prefetched]() { return prefetched->ready; });
+
+        return prefetched;
+    }
+
+    /* Waits for all the queued images to be decoded */
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        cond_.wait(lock, [this]() {
+            for (std::map<std::string, PrefetchedImage *>::const_iterator iter = images_.begin();
+                 iter != images_.end();
+                 iter++)
+            {
+                if (!iter->second->ready)
+                    return false;
+            }
+            return true;
+        });
+    }
+
+    void release(const std::string &name)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::map<std::string, PrefetchedImage *>::iterator iter = images_.find(name);
+        if (iter != images_.end() && --iter->second->uses == 0) {
+            if (iter->second->ready)
+                delete iter->second;
+            else
+                iter->second->discarded = true;
+            images_.erase(iter);
+        }
+    }
+
+private:
+    void run()
+    {
+        Isolation::worker_thread();
+
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (true) {
+            cond_.wait(lock, [this]() { return quit_ || !queue_.empty(); });
+            if (quit_)
+                break;
+
+            PrefetchedImage *prefetched = queue_.front();
+            queue_.pop_front();
+
+            if (prefetched->discarded) {
+                delete prefetched;
+                continue;
+            }
+
+            /* Entries are only deleted once ready, so this is safe unlocked */
+            lock.unlock();
+
+            bool ok = false;
+            {
+                Trace::Scope trace("texture-decode", prefetched->pathname);
+
+                if (prefetched->filetype == TextureDescriptor::FileTypePNG) {
+                    PNGReader reader(prefetched->pathname);
+                    ok = prefetched->image.load(reader);
+                }
+                else if (prefetched->filetype == TextureDescriptor::FileTypeJPEG) {
+                    JPEGReader reader(prefetched->pathname);
+                    ok = prefetched->image.load(reader);
+                }
+            }
+
+            lock.lock();
+            prefetched->ok = ok;
+            prefetched->ready = true;
+            if (prefetched->discarded)
+                delete prefetched;
+            cond_.notify_all();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::map<std::string, PrefetchedImage *> images_;
+    std::deque<PrefetchedImage *> queue_;
+    std::vector<std::thread> workers_;
+    bool quit_;
+};
+
+Prefetcher prefetcher;
+
+/*
+ * The textures created by Texture::load(), kept around for later benchmarks
+ * when the GL context is reused. Textures stay cached after their last
+ * user has released them, until the process exits.
+ */
+class Cache
+{
+public:
+    bool acquire(const std::string &pathname, GLint min_filter, GLint mag_filter,
+                 Texture::MipmapMode mipmap_mode, unsigned int size, GLuint *tex)
+    {
+        std::map<Key, GLuint>::iterator iter =
+            textures_.find(make_key(pathname, min_filter, mag_filter, mipmap_mode, size));
+        if (iter == textures_.end())
+            return false;
+
+        *tex = iter->second;
+
+        /* Scenes may have changed the wrap mode, restore the default */
+        glBindTexture(GL_TEXTURE_2D, *tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        return true;
+    }
+
+    void add(const std::string &pathname, GLint min_filter, GLint mag_filter,
+             Texture::MipmapMode mipmap_mode, unsigned int size, GLuint tex)
+    {
+        if (!Options::reuse_context)
+            return;
+
+        textures_[make_key(pathname, min_filter, mag_filter, mipmap_mode, size)] = tex;
+        cached_.insert(tex);
+    }
+
+    /* Cached textures are kept when their users release them */
+    bool contains(GLuint tex) const
+    {
+        return cached_.find(tex) != cached_.end();
+    }
+
+private:
+    typedef std::pair<std::string, std::vector<GLint> > Key;
+
+    static Key make_key(const std::string &pathname, GLint min_filter,
+                        GLint mag_filter, Texture::MipmapMode mipmap_mode,
+                        unsigned int size)
+    {
+        std::vector<GLint> params;
+        params.push_back(min_filter);
+        params.push_back(mag_filter);
+        params.push_back(mipmap_mode);
+        params.push_back(size);
+        return Key(pathname, params);
+    }
+
+    std::map<Key, GLuint> textures_;
+    std::set<GLuint> cached_;
+};
+
+Cache cache;
 }
 
-bool
-Texture::load(const std::string &textureName, GLuint *pTexture, ...)
+static bool
+load_texture(const std::string &textureName, GLuint *pTexture,
+             const std::vector<std::pair<GLint, GLint> > &filters,
+             Texture::MipmapMode mipmap_mode, unsigned int size)
 {
+    Trace::Scope trace("texture-load", textureName);
+
     // Make sure the named texture is in the map.
     TextureMap::const_iterator textureIt = TexturePrivate::textureMap.find(textureName);
     if (textureIt == TexturePrivate::textureMap.end())
@@ -113,34 +689,274 @@ Texture::load(const std::string &textureName, GLuint *pTexture, ...)
     // Pull the pathname out of the descriptor and use it for the PNG load.
     TextureDescriptor* desc = textureIt->second;
     const std::string& filename = desc->pathname();
+
+    // Reuse the textures created by earlier benchmarks, if possible
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < filters.size(); i++) {
+        if (!TexturePrivate::cache.acquire(filename, filters[i].first,
+                                           filters[i].second, mipmap_mode, size,
+                                           &pTexture[i]))
+        {
+            missing.push_back(i);
+        }
+    }
+
+    if (missing.empty()) {
+        TexturePrivate::prefetcher.release(textureName);
+        return true;
+    }
+
+    if (desc->filetype() == TextureDescriptor::FileTypeKTX) {
+        KTXReader reader(filename);
+        if (reader.error())
+            return false;
+
+        if (!compressed_format_supported(reader.internalFormat())) {
+            Log::error("Compressed format 0x%x of texture '%s' is not supported\n",
+                       reader.internalFormat(), textureName.c_str());
+            return false;
+        }
+
+        for (size_t i = 0; i < missing.size(); i++) {
+            const std::pair<GLint, GLint> &f(filters[missing[i]]);
+            if (!setup_compressed_texture(&pTexture[missing[i]], reader, f.first, f.second))
+                return false;
+            DebugMarkers::label(GL_TEXTURE, pTexture[missing[i]], textureName);
+            TexturePrivate::cache.add(filename, f.first, f.second, mipmap_mode, size,
+                                      pTexture[missing[i]]);
+        }
+
+        return true;
+    }
+
+    // Use the image decoded in the background, if it has been prefetched.
+    // Prefetched images have their full size, so JPEG images that can be
+    // decoded at a reduced scale are decoded again instead.
+    bool scaled = size > 0 && desc->filetype() == TextureDescriptor::FileTypeJPEG;
+    TexturePrivate::PrefetchedImage *prefetched = 0;
     ImageData image;
+    ImageData *imagePtr = &image;
 
-    if (desc->filetype() == TextureDescriptor::FileTypePNG) {
-        PNGReader reader(filename);
-        if (!image.load(reader))
+    if (scaled)
+        TexturePrivate::prefetcher.release(textureName);
+    else
+        prefetched = TexturePrivate::prefetcher.acquire(textureName);
+
+    if (prefetched) {
+        if (!prefetched->ok) {
+            TexturePrivate::prefetcher.release(textureName);
             return false;
+        }
+        imagePtr = &prefetched->image;
     }
-    else if (desc->filetype() == TextureDescriptor::FileTypeJPEG) {
-        JPEGReader reader(filename);
-        if (!image.load(reader))
+    else {
+        std::unique_ptr<ImageReader> reader;
+        if (desc->filetype() == TextureDescriptor::FileTypePNG)
+            reader.reset(new PNGReader(filename));
+        else if (desc->filetype() == TextureDescriptor::FileTypeJPEG)
+            reader.reset(new JPEGReader(filename, size));
+        else
+            return false;
+
+        // A single texture whose mipmaps, if any, are generated on the GPU
+        // can be decoded straight into the buffer it is uploaded from
+        const std::pair<GLint, GLint> &f(filters[missing[0]]);
+        bool cpu_mipmap = f.first != GL_NEAREST && f.first != GL_LINEAR &&
+                          mipmap_mode == Texture::MipmapCPU;
+        DirectUpload direct = DirectUploadUnavailable;
+
+        if (missing.size() == 1 && !cpu_mipmap && unpack_buffer_supported()) {
+            direct = setup_texture_direct(&pTexture[missing[0]], *reader,
+                                          f.first, f.second, mipmap_mode);
+        }
+
+        if (direct == DirectUploadFailed)
+            return false;
+
+        if (direct == DirectUploadDone) {
+            DebugMarkers::label(GL_TEXTURE, pTexture[missing[0]], textureName);
+            TexturePrivate::cache.add(filename, f.first, f.second, mipmap_mode, size,
+                                      pTexture[missing[0]]);
+            return true;
+        }
+
+        if (!image.load(*reader))
             return false;
     }
 
+    for (size_t i = 0; i < missing.size(); i++) {
+        const std::pair<GLint, GLint> &f(filters[missing[i]]);
+        setup_texture(&pTexture[missing[i]], *imagePtr, f.first, f.second, mipmap_mode);
+        DebugMarkers::label(GL_TEXTURE, pTexture[missing[i]], textureName);
+        TexturePrivate::cache.add(filename, f.first, f.second, mipmap_mode, size,
+                                  pTexture[missing[i]]);
+    }
+
+    if (prefetched)
+        TexturePrivate::prefetcher.release(textureName);
+
+    return true;
+}
+
+bool
+Texture::load(const std::string &textureName, GLuint *pTexture, ...)
+{
+    std::vector<std::pair<GLint, GLint> > filters;
     va_list ap;
     va_start(ap, pTexture);
     GLint arg;
 
     while ((arg = va_arg(ap, GLint)) != 0) {
         GLint arg2 = va_arg(ap, GLint);
-        setup_texture(pTexture, image, arg, arg2);
-        pTexture++;
+        filters.push_back(std::make_pair(arg, arg2));
     }
 
     va_end(ap);
 
+    return load_texture(textureName, pTexture, filters, MipmapGPU, 0);
+}
+
+bool
+Texture::load(const std::string &textureName, GLuint *pTexture,
+              GLint min_filter, GLint mag_filter, MipmapMode mipmap_mode,
+              unsigned int size)
+{
+    std::vector<std::pair<GLint, GLint> > filters(1, std::make_pair(min_filter, mag_filter));
+
+    return load_texture(textureName, pTexture, filters, mipmap_mode, size);
+}
+
+/*
+ * Uploads a level of a texture created by Texture::create(), converting
+ * its RGBA pixels to the internal format.
+ */
+static void
+upload_converted_level(GLint level, GLenum internal_format, unsigned int width,
+                       unsigned int height, const unsigned char *rgba)
+{
+    const size_t npixels = static_cast<size_t>(width) * height;
+
+    if (internal_format == GL_RGBA16F) {
+        std::vector<float> pixels(npixels * 4);
+        for (size_t i = 0; i < pixels.size(); i++)
+            pixels[i] = rgba[i] / 255.0f;
+        glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA16F, width, height, 0,
+                     GL_RGBA, GL_FLOAT, &pixels[0]);
+    }
+    else if (internal_format == GL_R8) {
+        std::vector<unsigned char> pixels(npixels);
+        for (size_t i = 0; i < npixels; i++) {
+            const unsigned char *p = &rgba[i * 4];
+            pixels[i] = (54 * p[0] + 183 * p[1] + 19 * p[2] + 128) >> 8;
+        }
+        glTexImage2D(GL_TEXTURE_2D, level, GL_R8, width, height, 0,
+                     GL_RED, GL_UNSIGNED_BYTE, &pixels[0]);
+    }
+    else {
+        /* Sized internal formats need GLES 3.0 */
+        GLenum gl_internal_format = internal_format;
+#if GLMARK2_USE_GLESv2
+        if (internal_format == GL_RGBA8 && !GLExtensions::version_supported(3, 0))
+            gl_internal_format = GL_RGBA;
+#endif
+        glTexImage2D(GL_TEXTURE_2D, level, gl_internal_format, width, height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    }
+}
+
+bool
+Texture::create(const std::string &textureName, GLuint *pTexture,
+                GLint min_filter, GLint mag_filter,
+                GLenum internal_format, unsigned int size)
+{
+    Trace::Scope trace("texture-load", textureName);
+    std::vector<unsigned char> pixels;
+    unsigned int width = 0;
+    unsigned int height = 0;
+    GLenum format = GL_RGBA;
+
+    if (!decode(textureName, pixels, width, height, format, size)) {
+        Log::error("Texture '%s' can't be converted, only PNG and JPEG textures can\n",
+                   textureName.c_str());
+        return false;
+    }
+
+    /* Resize the image to RGBA pixels, sampling the nearest pixel */
+    const unsigned int bpp = format == GL_RGB ? 3 : 4;
+    const unsigned int dst_width = size ? size : width;
+    const unsigned int dst_height = size ? size : height;
+    std::vector<unsigned char> levels[2];
+    std::vector<unsigned char> &rgba = levels[0];
+
+    rgba.resize(static_cast<size_t>(dst_width) * dst_height * 4);
+    for (unsigned int y = 0; y < dst_height; y++) {
+        const unsigned int src_y = static_cast<uint64_t>(y) * height / dst_height;
+        for (unsigned int x = 0; x < dst_width; x++) {
+            const unsigned int src_x = static_cast<uint64_t>(x) * width / dst_width;
+            const unsigned char *src = &pixels[(static_cast<size_t>(src_y) * width + src_x) * bpp];
+            unsigned char *dst = &rgba[(static_cast<size_t>(y) * dst_width + x) * 4];
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            dst[3] = bpp == 4 ? src[3] : 0xff;
+        }
+    }
+
+    uint64_t start = Util::get_timestamp_us();
+
+    glGenTextures(1, pTexture);
+    glBindTexture(GL_TEXTURE_2D, *pTexture);
+    DebugMarkers::label(GL_TEXTURE, *pTexture, textureName);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, min_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, mag_filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    /* R8 rows and smaller levels aren't 4-byte aligned */
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    /*
+     * The levels are always computed on the CPU, since glGenerateMipmap
+     * needs the format to be color-renderable, which RGBA16F isn't in GLES.
+     */
+    bool needs_mipmap = min_filter != GL_NEAREST && min_filter != GL_LINEAR;
+    const unsigned char *src = &rgba[0];
+    unsigned int level_width = dst_width;
+    unsigned int level_height = dst_height;
+    GLint level = 0;
+
+    upload_converted_level(level, internal_format, level_width, level_height, src);
+
+    while (needs_mipmap && (level_width > 1 || level_height > 1)) {
+        unsigned int next_width = std::max(level_width / 2, 1U);
+        unsigned int next_height = std::max(level_height / 2, 1U);
+        std::vector<unsigned char> &dst = levels[++level % 2];
+
+        dst.resize(static_cast<size_t>(next_width) * next_height * 4);
+        downsample(src, level_width, level_height, 4, &dst[0], next_width, next_height);
+        upload_converted_level(level, internal_format, next_width, next_height, &dst[0]);
+
+        src = &dst[0];
+        level_width = next_width;
+        level_height = next_height;
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    upload_time_us += Util::get_timestamp_us() - start;
+
     return true;
 }
 
+void
+Texture::release(unsigned int count, const GLuint *pTexture)
+{
+    for (unsigned int i = 0; i < count; i++) {
+        if (pTexture[i] != 0 && !TexturePrivate::cache.contains(pTexture[i]))
+            glDeleteTextures(1, &pTexture[i]);
+    }
+}
+
 const TextureMap&
 Texture::find_textures()
 {
@@ -169,6 +985,31 @@ Texture::find_textures()
             namePos = slashPos + 1;
         }
 
+        // KTX files contain compressed variants of the textures, named
+        // <texture>.<format>.ktx or <texture>.<format>.ktx2
+        static const string ktxExt(".ktx");
+        static const string ktx2Ext(".ktx2");
+        string::size_type ktxExtPos(string::npos);
+        if (curPath.size() > ktxExt.size() &&
+            curPath.compare(curPath.size() - ktxExt.size(), ktxExt.size(), ktxExt) == 0)
+        {
+            ktxExtPos = curPath.size() - ktxExt.size();
+        }
+        else if (curPath.size() > ktx2Ext.size() &&
+                 curPath.compare(curPath.size() - ktx2Ext.size(), ktx2Ext.size(), ktx2Ext) == 0)
+        {
+            ktxExtPos = curPath.size() - ktx2Ext.size();
+        }
+
+        if (ktxExtPos != string::npos)
+        {
+            string name(curPath, namePos, ktxExtPos - namePos);
+            TextureDescriptor* desc =
+                new TextureDescriptor(name, curPath, TextureDescriptor::FileTypeKTX);
+            TexturePrivate::textureMap.insert(std::make_pair(name, desc));
+            continue;
+        }
+
         // Find the position of the extension
         string::size_type pngExtPos = curPath.rfind(".png");
         string::size_type jpgExtPos = curPath.rfind(".jpg");
@@ -212,3 +1053,109 @@ Texture::find_textures()
 
     return TexturePrivate::textureMap;
 }
+
+void
+Texture::prefetch(const std::vector<std::string> &names)
+{
+    const TextureMap &textureMap = find_textures();
+
+    for (std::vector<std::string>::const_iterator iter = names.begin();
+         iter != names.end();
+         iter++)
+    {
+        TextureMap::const_iterator textureIt = textureMap.find(*iter);
+        if (textureIt == textureMap.end())
+            continue;
+
+        // Compressed textures are uploaded as stored, there is nothing to decode
+        const TextureDescriptor *desc = textureIt->second;
+        if (desc->filetype() == TextureDescriptor::FileTypePNG ||
+            desc->filetype() == TextureDescriptor::FileTypeJPEG)
+        {
+            TexturePrivate::prefetcher.add(*iter, *desc);
+        }
+    }
+
+    TexturePrivate::prefetcher.start();
+}
+
+void
+Texture::wait_for_prefetch()
+{
+    TexturePrivate::prefetcher.wait();
+}
+
+uint64_t
+Texture::take_upload_time_us()
+{
+    uint64_t time_us = upload_time_us;
+    upload_time_us = 0;
+    return time_us;
+}
+
+const char *Texture::format_option_values = "rgba,etc2,astc,bc7";
+
+bool
+Texture::decode(const std::string &name, std::vector<unsigned char> &pixels,
+                unsigned int &width, unsigned int &height, GLenum &format,
+                unsigned int size)
+{
+    TextureMap::const_iterator textureIt = TexturePrivate::textureMap.find(name);
+    if (textureIt == TexturePrivate::textureMap.end())
+        return false;
+
+    const TextureDescriptor *desc = textureIt->second;
+
+    // Use the image decoded in the background, if it has been prefetched,
+    // unless a JPEG image can be decoded at a reduced scale
+    bool scaled = size > 0 && desc->filetype() == TextureDescriptor::FileTypeJPEG;
+    TexturePrivate::PrefetchedImage *prefetched = 0;
+    ImageData image;
+    ImageData *imagePtr = &image;
+
+    if (scaled)
+        TexturePrivate::prefetcher.release(name);
+    else
+        prefetched = TexturePrivate::prefetcher.acquire(name);
+
+    if (prefetched) {
+        if (!prefetched->ok) {
+            TexturePrivate::prefetcher.release(name);
+            return false;
+        }
+        imagePtr = &prefetched->image;
+    }
+    else if (desc->filetype() == TextureDescriptor::FileTypePNG) {
+        PNGReader reader(desc->pathname());
+        if (!image.load(reader))
+            return false;
+    }
+    else if (desc->filetype() == TextureDescriptor::FileTypeJPEG) {
+        JPEGReader reader(desc->pathname(), size);
+        if (!image.load(reader))
+            return false;
+    }
+    else {
+        return false;
+    }
+
+    pixels.assign(imagePtr->pixels,
+                  imagePtr->pixels + imagePtr->width * imagePtr->height * imagePtr->bpp);
+    width = imagePtr->width;
+    height = imagePtr->height;
+    format = imagePtr->bpp == 3 ? GL_RGB : GL_RGBA;
+
+    if (prefetched)
+        TexturePrivate::prefetcher.release(name);
+
+    return true;
+}
+
+std::string
+Texture::format_name(const std::string &name, const std::string &format)
+{
+    if (format.empty() || format == "rgba")
+        return name;
+
+    return name + "." + format;
+}
@@ -26,8 +26,10 @@
 
 #include "gl-headers.h"
 
+#include <stdint.h>
 #include <string>
 #include <map>
+#include <vector>
 
 /**
  * A descriptor for a texture file.
@@ -39,6 +41,7 @@ public:
         FileTypeUnknown,
         FileTypePNG,
         FileTypeJPEG,
+        FileTypeKTX,
     };
 
     TextureDescriptor(const std::string& name, const std::string& pathname,
@@ -61,6 +64,15 @@ typedef std::map<std::string, TextureDescriptor*> TextureMap;
 class Texture
 {
 public:
+    /**
+     * Where the mipmap levels of uncompressed textures are generated.
+     * Compressed textures always use the levels stored in their file.
+     */
+    enum MipmapMode {
+        MipmapGPU,
+        MipmapCPU
+    };
+
     /**
      * Load a texture by name.
      *
@@ -72,6 +84,55 @@ public:
      * @return:      true if the operation succeeded, false otherwise
      */
     static bool load(const std::string &name, GLuint *pTexture, ...);
+    /**
+     * Load a texture by name, choosing how its mipmaps are generated.
+     *
+     * @name:        the texture name
+     * @min_filter:  the minification filter
+     * @mag_filter:  the magnification filter
+     * @mipmap_mode: whether glGenerateMipmap or a CPU box filter generates
+     *               the mipmap levels, if the min filter needs them
+     * @size:        the width and height the texture needs at least, 0 for
+     *               the size of the image. JPEG images are decoded at 1/2,
+     *               1/4 or 1/8 of their size when that is enough.
+     *
+     * @return:      true if the operation succeeded, false otherwise
+     */
+    static bool load(const std::string &name, GLuint *pTexture,
+                     GLint min_filter, GLint mag_filter, MipmapMode mipmap_mode,
+                     unsigned int size = 0);
+    /**
+     * Create a texture from the image of a texture, resized and converted
+     * to an internal format.
+     *
+     * The mipmap levels are computed on the CPU, if the min filter needs
+     * them. Unlike Texture::load(), each call creates a new texture and
+     * only PNG and JPEG textures can be converted.
+     *
+     * @name:            the texture name
+     * @min_filter:      the minification filter
+     * @mag_filter:      the magnification filter
+     * @internal_format: GL_RGBA8, GL_SRGB8_ALPHA8, GL_RGBA16F or GL_R8,
+     *                   which gets the luminance of the image
+     * @size:            the width and height of the texture, 0 to keep
+     *                   the size of the image
+     *
+     * @return:          true if the operation succeeded, false otherwise
+     */
+    static bool create(const std::string &name, GLuint *pTexture,
+                       GLint min_filter, GLint mag_filter,
+                       GLenum internal_format, unsigned int size);
+    /**
+     * Release textures created by Texture::load() or Texture::create().
+     *
+     * With --reuse-context, the textures are kept for later benchmarks
+     * that load the same texture file with the same filters. Otherwise
+     * they are deleted.
+     *
+     * @count:       the number of textures
+     * @pTexture:    the textures to release
+     */
+    static void release(unsigned int count, const GLuint *pTexture);
     /**
      * Locate all available textures.
      *
@@ -82,6 +143,70 @@ public:
      * @return:     a map containing information about the located textures
      */
     static const TextureMap& find_textures();
+    /**
+     * Decode textures in the background.
+     *
+     * Image decoding doesn't need a GL context, so it is done by worker
+     * threads while earlier benchmarks run. Texture::load() then only
+     * uploads the decoded image, waiting for it first if needed.
+     *
+     * @names:      the textures to decode, listed once for each time they
+     *              will be loaded
+     */
+    static void prefetch(const std::vector<std::string> &names);
+    /**
+     * Wait for the textures passed to prefetch() to be decoded, e.g. so
+     * that the processes forked with --fork-benchmarks inherit them.
+     */
+    static void wait_for_prefetch();
+    /**
+     * Gets the time the calling thread has spent creating textures with
+     * Texture::load() and Texture::create() since the last call, without
+     * the decode and conversion of their images. It includes the mipmap
+     * generation, but not the work the GPU has yet to finish.
+     *
+     * @return:     the time in microseconds
+     */
+    static uint64_t take_upload_time_us();
+    /**
+     * Decode a texture into memory.
+     *
+     * Unlike Texture::load(), this doesn't use the GL context or the
+     * texture cache, so the image can be uploaded from any context or
+     * thread, and it can be called from several threads at once. Only PNG
+     * and JPEG textures can be decoded.
+     *
+     * @name:       the texture name
+     * @pixels:     the decoded rows, from the bottom one
+     * @width:      the width of the image
+     * @height:     the height of the image
+     * @format:     the format of the pixels, GL_RGB or GL_RGBA
+     * @size:       the width and height the image needs at least, 0 for
+     *              its full size, like for Texture::load()
+     *
+     * @return:     true if the operation succeeded, false otherwise
+     */
+    static bool decode(const std::string &name, std::vector<unsigned char> &pixels,
+                       unsigned int &width, unsigned int &height, GLenum &format,
+                       unsigned int size = 0);
+    /**
+     * Gets the name of a texture in a specific format.
+     *
+     * Compressed variants of a texture are stored as KTX or KTX2 files
+     * named after the format, e.g. "crate-base.etc2.ktx" for the "etc2"
+     * variant of "crate-base".
+     *
+     * @name:       the texture name
+     * @format:     the texture format, "rgba" for the original image
+     *
+     * @return:     the name of the texture variant
+     */
+    static std::string format_name(const std::string &name,
+                                   const std::string &format);
+    /**
+     * The accepted values of the "texture-format" scene option.
+     */
+    static const char *format_option_values;
 };
 
 #endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "trace.h"
+#include "log.h"
+#include "util.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+struct Event
+{
+    Event(const char *n, const std::string &d, uint64_t s, uint64_t dur,
+          unsigned int t) :
+        name(n), detail(d), start(s), duration(dur), tid(t) {}
+
+    const char *name;
+    std::string detail;
+    uint64_t start;
+    uint64_t duration;
+    unsigned int tid;
+};
+
+/* The events of a long run are dropped rather than using up the memory */
+const size_t max_events = 1 << 22;
+/* The track of the GPU frames */
+const unsigned int gpu_tid = 0;
+
+std::mutex mutex;
+bool enabled = false;
+std::string filename;
+uint64_t start_time = 0;
+std::vector<Event> events;
+size_t dropped_events = 0;
+std::atomic<unsigned int> next_tid(1);
+unsigned int max_tid = 0;
+thread_local unsigned int tid = 0;
+
+unsigned int
+thread_id()
+{
+    if (!tid)
+        tid = next_tid++;
+    return tid;
+}
+
+void
+add_event(const char *name, const std::string &detail, uint64_t start,
+          uint64_t duration, unsigned int event_tid)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (events.size() >= max_events) {
+        dropped_events++;
+        return;
+    }
+
+    events.push_back(Event(name, detail, start, duration, event_tid));
+    if (event_tid > max_tid)
+        max_tid = event_tid;
+}
+
+std::string
+escape(const std::string &str)
+{
+    std::string escaped;
+
+    for (std::string::const_iterator iter = str.begin();
+         iter != str.end();
+         iter++)
+    {
+        if (*iter == '"' || *iter == '\\')
+            escaped += '\\';
+        if (static_cast<unsigned char>(*iter) >= 0x20)
+            escaped += *iter;
+    }
+
+    return escaped;
+}
+
+}
+
+Trace::Scope::Scope(const char *name) :
+    name_(name), start_(enabled ? Util::get_timestamp_us() : 0)
+{
+}
+
+Trace::Scope::Scope(const char *name, const std::string &detail) :
+    name_(name), start_(0)
+{
+    if (enabled) {
+        detail_ = detail;
+        start_ = Util::get_timestamp_us();
+    }
+}
+
+Trace::Scope::~Scope()
+{
+    if (!enabled)
+        return;
+
+    add_event(name_, detail_, start_, Util::get_timestamp_us() - start_,
+              thread_id());
+}
+
+void
+Trace::start(const std::string &file)
+{
+    if (file.empty())
+        return;
+
+    filename = file;
+    start_time = Util::get_timestamp_us();
+    enabled = true;
+
+    /* The thread starting the trace is the main one */
+    thread_id();
+}
+
+bool
+Trace::active()
+{
+    return enabled;
+}
+
+void
+Trace::gpu_frame(uint64_t start, uint64_t duration)
+{
+    if (!enabled)
+        return;
+
+    add_event("gpu-frame", std::string(), start, duration, gpu_tid);
+}
+
+bool
+Trace::write()
+{
+    if (!enabled)
+        return true;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    FILE *file = fopen(filename.c_str(), "w");
+    if (!file) {
+        Log::error("Failed to open trace file '%s'\n", filename.c_str());
+        return false;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    /* Name the tracks */
+    fprintf(file, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"tid\":%u,"
+                  "\"args\":{\"name\":\"glmark2\"}}",
+            gpu_tid);
+    fprintf(file, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,"
+                  "\"args\":{\"name\":\"GPU\"}}",
+            gpu_tid);
+    for (unsigned int i = 1; i <= max_tid; i++) {
+        std::string name(i == 1 ? "main" : "thread " + Util::toString(i));
+        fprintf(file, ",\n{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%u,"
+                      "\"args\":{\"name\":\"%s\"}}",
+                i, name.c_str());
+    }
+
+    for (std::vector<Event>::const_iterator iter = events.begin();
+         iter != events.end();
+         iter++)
+    {
+        fprintf(file, ",\n{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%u,"
+                      "\"ts\":%llu,\"dur\":%llu",
+                iter->name, iter->tid,
+                static_cast<unsigned long long>(iter->start - start_time),
+                static_cast<unsigned long long>(iter->duration));
+        if (!iter->detail.empty())
+            fprintf(file, ",\"args\":{\"detail\":\"%s\"}", escape(iter->detail).c_str());
+        fprintf(file, "}");
+    }
+
+    fprintf(file, "\n]}\n");
+
+    bool ok = !ferror(file);
+    if (fclose(file) != 0)
+        ok = false;
+
+    if (!ok)
+        Log::error("Failed to write trace file '%s'\n", filename.c_str());
+    else if (dropped_events > 0)
+        Log::info("Dropped %zu trace events over the limit of %zu\n",
+                  dropped_events, max_events);
+
+    return ok;
+}
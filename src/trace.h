@@ -0,0 +1,80 @@
+/*
+ * Copyright © 2026 glmark2 contributors
+ *
+ * This file is part of the glmark2 OpenGL (ES) 2.0 benchmark.
+ *
+ * glmark2 is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * glmark2 is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * glmark2.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef GLMARK2_TRACE_H_
+#define GLMARK2_TRACE_H_
+
+#include <stdint.h>
+#include <string>
+
+/**
+ * Records a timeline of what each thread does (main loop steps, scene
+ * updates, draws, frame ends, page flip waits, resource loads...) and
+ * writes it in the Chrome Trace Event format (--trace), which can be
+ * opened in chrome://tracing or the Perfetto UI.
+ *
+ * With --gpu-timing, the GPU time of each frame is shown on a separate
+ * track, starting when the frame was submitted.
+ */
+class Trace
+{
+public:
+    /**
+     * Records an event for the lifetime of the object.
+     */
+    class Scope
+    {
+    public:
+        Scope(const char *name);
+        Scope(const char *name, const std::string &detail);
+        ~Scope();
+
+    private:
+        const char *name_;
+        std::string detail_;
+        uint64_t start_;
+    };
+
+    /**
+     * Starts recording, if a file name is given. Must be called before
+     * any other thread is started.
+     */
+    static void start(const std::string &filename);
+
+    /**
+     * Whether events are recorded.
+     */
+    static bool active();
+
+    /**
+     * Records the GPU time of a frame.
+     *
+     * @param start the time the frame was submitted, in microseconds
+     * @param duration the GPU time of the frame, in microseconds
+     */
+    static void gpu_frame(uint64_t start, uint64_t duration);
+
+    /**
+     * Writes the recorded events to the file given to start().
+     *
+     * @return whether the file was written
+     */
+    static bool write();
+};
+
+#endif